@@ -55,6 +55,24 @@
 #define APT_DECLARE(type) type
 #endif
 
+/** Lib export/import defines of data (win32) */
+#if defined(WIN32) && !defined(APT_STATIC_LIB)
+#ifdef APT_LIB_EXPORT
+#define APT_DECLARE_DATA    __declspec(dllexport)
+#else
+#define APT_DECLARE_DATA    __declspec(dllimport)
+#endif
+#else
+#define APT_DECLARE_DATA
+#endif
+
+/** Thread local storage specifier (not defined, if unsupported by the compiler) */
+#if defined(_MSC_VER)
+#define APT_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define APT_THREAD_LOCAL __thread
+#endif
+
 /** Boolean value */
 typedef int apt_bool_t;
 
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#ifndef APT_CLOCK_H
+#define APT_CLOCK_H
+
+/**
+ * @file apt_clock.h
+ * @brief Pluggable Clock of Timers and Media Scheduler
+ */
+
+#include <apr_time.h>
+#include "apt.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Declaration of clock */
+typedef struct apt_clock_t apt_clock_t;
+/** Declaration of clock vtable */
+typedef struct apt_clock_vtable_t apt_clock_vtable_t;
+
+/** Clock vtable */
+struct apt_clock_vtable_t {
+	/** Get the current time */
+	apr_time_t (*now)(apt_clock_t *clock);
+	/** Sleep for the interval of the clock */
+	void (*sleep)(apt_clock_t *clock, apr_interval_time_t interval);
+	/** Convert the timeout of the clock to the (wall-clock) timeout of a blocking wait */
+	apr_interval_time_t (*wait_timeout_get)(apt_clock_t *clock, apr_interval_time_t timeout);
+};
+
+/** Clock, which timers of tasks and the media scheduler run on */
+struct apt_clock_t {
+	/** Table of virtual methods */
+	const apt_clock_vtable_t *vtable;
+	/** External object associated with the clock */
+	void                     *obj;
+};
+
+/**
+ * Set the process-wide clock.
+ * @param clock the clock to set, NULL - restore the wall clock
+ * @remark Set it before tasks and media engines are started, the clock
+ *         is read by apt_poller_task, apt_consumer_task and mpf_scheduler.
+ */
+APT_DECLARE(void) apt_clock_set(apt_clock_t *clock);
+
+/** Get the process-wide clock (NULL - wall clock) */
+APT_DECLARE(apt_clock_t*) apt_clock_get(void);
+
+/** Get the current time of the process-wide clock */
+APT_DECLARE(apr_time_t) apt_clock_now(void);
+
+/** Sleep for the interval of the process-wide clock */
+APT_DECLARE(void) apt_clock_sleep(apr_interval_time_t interval);
+
+/** Convert the timeout of the process-wide clock to the timeout of a blocking wait */
+APT_DECLARE(apr_interval_time_t) apt_clock_wait_timeout_get(apr_interval_time_t timeout);
+
+/**
+ * Create simulated clock.
+ * @param rate the number of times the clock runs faster than real time,
+ *        0 - the clock stands still, unless advanced by apt_sim_clock_advance()
+ * @param pool the pool to allocate memory from
+ * @remark The clock starts at the current wall-clock time.
+ */
+APT_DECLARE(apt_clock_t*) apt_sim_clock_create(apr_uint32_t rate, apr_pool_t *pool);
+
+/**
+ * Advance simulated clock, standing still (rate 0).
+ * @param clock the clock to advance
+ * @param interval the interval to advance the clock by
+ * @remark Threads sleeping on the clock are woken up, once their time comes.
+ */
+APT_DECLARE(apt_bool_t) apt_sim_clock_advance(apt_clock_t *clock, apr_interval_time_t interval);
+
+/** Destroy simulated clock */
+APT_DECLARE(void) apt_sim_clock_destroy(apt_clock_t *clock);
+
+APT_END_EXTERN_C
+
+#endif /* APT_CLOCK_H */
@@ -32,6 +32,13 @@ APT_BEGIN_EXTERN_C
 /** Opaque consumer task declaration */
 typedef struct apt_consumer_task_t apt_consumer_task_t;
 
+/**
+ * Get affinity key of the message.
+ * Messages of the same non-zero key are processed by the same worker in order,
+ * messages of zero key are processed by the task thread itself.
+ */
+typedef apr_size_t (*apt_consumer_task_affinity_f)(apt_consumer_task_t *task, const apt_task_msg_t *msg);
+
 /**
  * Create consumer task.
  * @param obj the external object to associate with the task
@@ -74,6 +81,27 @@ APT_DECLARE(apt_timer_t*) apt_consumer_task_timer_create(
 								void *obj,
 								apr_pool_t *pool);
 
+/**
+ * Set the number of worker threads messages are distributed among.
+ * @param task the consumer task to set workers for
+ * @param count the total number of workers including the task thread itself
+ * @param handler the handler to get affinity key of messages by
+ * @remark Must be called before the task is started. Core messages and timers
+ *         are always processed by the task thread.
+ */
+APT_DECLARE(apt_bool_t) apt_consumer_task_workers_set(
+								apt_consumer_task_t *task,
+								apr_size_t count,
+								apt_consumer_task_affinity_f handler);
+
+/**
+ * Get the number of messages waiting to be processed.
+ * @param task the consumer task to get the queue depth of
+ * @return the depth of the longest queue, if there are several workers
+ * @remark Can be called from any thread, the value is approximate.
+ */
+APT_DECLARE(apr_size_t) apt_consumer_task_queue_depth_get(const apt_consumer_task_t *task);
+
 APT_END_EXTERN_C
 
 #endif /* APT_CONSUMER_TASK_H */
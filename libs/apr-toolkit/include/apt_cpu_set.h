@@ -0,0 +1,86 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef APT_CPU_SET_H
+#define APT_CPU_SET_H
+
+/**
+ * @file apt_cpu_set.h
+ * @brief Set of CPUs to Bind Threads to
+ */ 
+
+#include "apt.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Max number of CPUs in set */
+#define APT_CPU_SET_MAX_SIZE 256
+
+/** CPU set declaration */
+typedef struct apt_cpu_set_t apt_cpu_set_t;
+
+/** Set of CPUs (bitmask) */
+struct apt_cpu_set_t {
+	apr_uint32_t bits[APT_CPU_SET_MAX_SIZE / 32];
+};
+
+/**
+ * Clear CPU set.
+ * @param set the set to clear
+ */
+APT_DECLARE(void) apt_cpu_set_clear(apt_cpu_set_t *set);
+
+/**
+ * Add CPU to the set.
+ * @param set the set to add CPU to
+ * @param cpu the CPU to add
+ */
+APT_DECLARE(apt_bool_t) apt_cpu_set_add(apt_cpu_set_t *set, int cpu);
+
+/**
+ * Check whether the set contains CPU.
+ * @param set the set to check
+ * @param cpu the CPU to check
+ */
+APT_DECLARE(apt_bool_t) apt_cpu_set_contains(const apt_cpu_set_t *set, int cpu);
+
+/**
+ * Get the number of CPUs in the set.
+ * @param set the set to get the number of CPUs of
+ */
+APT_DECLARE(apr_size_t) apt_cpu_set_count_get(const apt_cpu_set_t *set);
+
+/**
+ * Parse CPU set.
+ * @param set the set to parse to
+ * @param str the list of CPUs and ranges (e.g. "0-3,8"), or the NUMA node (e.g. "node:1")
+ * @param pool the pool to use (the CPU list of NUMA node is read from sysfs on Linux)
+ */
+APT_DECLARE(apt_bool_t) apt_cpu_set_parse(apt_cpu_set_t *set, const char *str, apr_pool_t *pool);
+
+/**
+ * Bind the calling thread to the set of CPUs.
+ * @param set the set to bind to
+ * @remark On Linux, memory the thread allocates after the binding (including memory
+ *         of the pools it creates) is placed on the local NUMA node by the first-touch policy.
+ */
+APT_DECLARE(apt_bool_t) apt_cpu_set_thread_bind(const apt_cpu_set_t *set);
+
+APT_END_EXTERN_C
+
+#endif /* APT_CPU_SET_H */
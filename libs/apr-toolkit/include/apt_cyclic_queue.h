@@ -34,13 +34,27 @@ APT_BEGIN_EXTERN_C
 /** Opaque cyclic queue declaration */
 typedef struct apt_cyclic_queue_t apt_cyclic_queue_t;
 
+/** Status of non-blocking push */
+typedef enum {
+	CYCLIC_QUEUE_PUSH_OK,   /**< object is pushed */
+	CYCLIC_QUEUE_PUSH_HIGH, /**< object is pushed, but the queue is more than 3/4 full */
+	CYCLIC_QUEUE_PUSH_FULL  /**< object is not pushed, the queue is full (overload) */
+} apt_cyclic_queue_push_status_e;
+
 /**
- * Create cyclic queue.
- * @param size the initial size of the queue
+ * Create cyclic queue, which grows when full.
+ * @param size the initial size of the queue (rounded up to the power of two)
  * @return the created queue
  */
 APT_DECLARE(apt_cyclic_queue_t*) apt_cyclic_queue_create(apr_size_t size);
 
+/**
+ * Create cyclic queue of fixed size, which is never resized.
+ * @param size the size of the queue (rounded up to the power of two)
+ * @return the created queue
+ */
+APT_DECLARE(apt_cyclic_queue_t*) apt_cyclic_queue_create_fixed(apr_size_t size);
+
 /**
  * Destroy cyclic queue.
  * @param queue the queue to destroy
@@ -51,9 +65,18 @@ APT_DECLARE(void) apt_cyclic_queue_destroy(apt_cyclic_queue_t *queue);
  * Push object to the queue.
  * @param queue the queue to push object to
  * @param obj the object to push
+ * @return FALSE if the queue is fixed and full, otherwise TRUE
  */
 APT_DECLARE(apt_bool_t) apt_cyclic_queue_push(apt_cyclic_queue_t *queue, void *obj);
 
+/**
+ * Push object to the queue without resizing it.
+ * @param queue the queue to push object to
+ * @param obj the object to push
+ * @return the status which tells the caller to back off, when the queue is (nearly) full
+ */
+APT_DECLARE(apt_cyclic_queue_push_status_e) apt_cyclic_queue_try_push(apt_cyclic_queue_t *queue, void *obj);
+
 /**
  * Pop object from the queue.
  * @param queue the queue to pop message from
@@ -73,6 +96,24 @@ APT_DECLARE(void) apt_cyclic_queue_clear(apt_cyclic_queue_t *queue);
  */
 APT_DECLARE(apt_bool_t) apt_cyclic_queue_is_empty(const apt_cyclic_queue_t *queue);
 
+/**
+ * Get the number of elements in the queue.
+ * @param queue the queue to get the number of elements of
+ */
+APT_DECLARE(apr_size_t) apt_cyclic_queue_size_get(const apt_cyclic_queue_t *queue);
+
+/**
+ * Get the max number of elements the queue can hold without resizing.
+ * @param queue the queue to get the capacity of
+ */
+APT_DECLARE(apr_size_t) apt_cyclic_queue_capacity_get(const apt_cyclic_queue_t *queue);
+
+/**
+ * Get the number of objects, which could not be pushed, since the queue was full.
+ * @param queue the queue to get the overload count of
+ */
+APT_DECLARE(apr_size_t) apt_cyclic_queue_overload_count_get(const apt_cyclic_queue_t *queue);
+
 
 APT_END_EXTERN_C
 
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+
+#ifndef APT_EXECUTOR_H
+#define APT_EXECUTOR_H
+
+/**
+ * @file apt_executor.h
+ * @brief Shared Work-Stealing Executor of Jobs
+ */ 
+
+#include "apt.h"
+#include "apt_cpu_set.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Default number of threads of executor */
+#define EXECUTOR_DEFAULT_THREAD_COUNT 2
+/** Default max number of pending jobs of strand */
+#define EXECUTOR_STRAND_DEFAULT_SIZE  64
+
+/** Opaque executor declaration */
+typedef struct apt_executor_t apt_executor_t;
+/** Opaque strand declaration */
+typedef struct apt_executor_strand_t apt_executor_strand_t;
+
+/** Prototype of job handler */
+typedef void (*apt_executor_job_f)(void *obj, void *arg);
+
+/**
+ * Create executor.
+ * @param thread_count the number of threads to run jobs by
+ * @param pool the pool to allocate memory from
+ * @remark Jobs are submitted to strands. Jobs of a strand run one at a time in
+ *         the order they are submitted, while different strands run in parallel.
+ *         Each thread serves its own queue of ready strands and steals from
+ *         the queues of other threads, when its own one is empty.
+ */
+APT_DECLARE(apt_executor_t*) apt_executor_create(apr_size_t thread_count, apr_pool_t *pool);
+
+/**
+ * Set the number of threads.
+ * @param executor the executor to set the number of threads for
+ * @param thread_count the number of threads
+ * @remark Must be called before the executor is started.
+ */
+APT_DECLARE(apt_bool_t) apt_executor_thread_count_set(apt_executor_t *executor, apr_size_t thread_count);
+
+/**
+ * Bind the threads to the set of CPUs.
+ * @param executor the executor to bind
+ * @param cpu_set the set of CPUs to copy (NULL - no binding)
+ * @remark Must be called before the executor is started.
+ */
+APT_DECLARE(apt_bool_t) apt_executor_cpu_set_set(apt_executor_t *executor, const apt_cpu_set_t *cpu_set);
+
+/**
+ * Start executor.
+ * @param executor the executor to start
+ */
+APT_DECLARE(apt_bool_t) apt_executor_start(apt_executor_t *executor);
+
+/**
+ * Stop executor. Jobs submitted before are run to completion.
+ * @param executor the executor to stop
+ */
+APT_DECLARE(apt_bool_t) apt_executor_stop(apt_executor_t *executor);
+
+/**
+ * Destroy executor.
+ * @param executor the executor to destroy
+ */
+APT_DECLARE(void) apt_executor_destroy(apt_executor_t *executor);
+
+/**
+ * Create strand.
+ * @param executor the executor to run jobs of the strand by
+ * @param size the max number of pending jobs
+ * @param pool the pool to allocate memory from
+ */
+APT_DECLARE(apt_executor_strand_t*) apt_executor_strand_create(apt_executor_t *executor, apr_size_t size, apr_pool_t *pool);
+
+/**
+ * Destroy strand, wait for its pending jobs to complete.
+ * @param strand the strand to destroy
+ * @remark Must not be called from a job of the strand itself.
+ */
+APT_DECLARE(void) apt_executor_strand_destroy(apt_executor_strand_t *strand);
+
+/**
+ * Submit job.
+ * @param strand the strand to submit job to
+ * @param handler the job handler
+ * @param obj the object to pass to the handler
+ * @param arg the argument to pass to the handler
+ * @return FALSE if the strand is full, otherwise TRUE
+ * @remark Can be called from any thread.
+ */
+APT_DECLARE(apt_bool_t) apt_executor_job_submit(apt_executor_strand_t *strand, apt_executor_job_f handler, void *obj, void *arg);
+
+APT_END_EXTERN_C
+
+#endif /* APT_EXECUTOR_H */
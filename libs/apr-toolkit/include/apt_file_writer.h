@@ -0,0 +1,128 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef APT_FILE_WRITER_H
+#define APT_FILE_WRITER_H
+
+/**
+ * @file apt_file_writer.h
+ * @brief Asynchronous File Writer
+ */
+
+#include <apr_file_io.h>
+#include "apt_executor.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Default size of a block of the writer */
+#define APT_FILE_WRITER_DEFAULT_BLOCK_SIZE  (64 * 1024)
+/** Default number of blocks of the writer */
+#define APT_FILE_WRITER_DEFAULT_BLOCK_COUNT 8
+
+/** Opaque file writer declaration */
+typedef struct apt_file_writer_t apt_file_writer_t;
+
+/** Declaration of file encoder */
+typedef struct apt_file_encoder_t apt_file_encoder_t;
+/** Declaration of file encoder vtable */
+typedef struct apt_file_encoder_vtable_t apt_file_encoder_vtable_t;
+
+/**
+ * File encoder vtable.
+ * @remark Methods are called from the context of the writer (the executor),
+ *         except open, which is called by apt_file_writer_open().
+ */
+struct apt_file_encoder_vtable_t {
+	/** Write the header, once the file is opened */
+	apt_bool_t (*open)(apt_file_encoder_t *encoder, apr_file_t *file);
+	/** Encode a block of data and write the result */
+	apt_bool_t (*write)(apt_file_encoder_t *encoder, apr_file_t *file, const char *data, apr_size_t size);
+	/** Write the trailer and destroy the encoder (file is NULL, if it failed to open) */
+	void (*close)(apt_file_encoder_t *encoder, apr_file_t *file);
+};
+
+/** File encoder, transforms data on its way to disk */
+struct apt_file_encoder_t {
+	/** Virtual methods */
+	const apt_file_encoder_vtable_t *vtable;
+	/** External object */
+	void                            *obj;
+};
+
+/**
+ * Create file writer.
+ * @param executor the executor to write blocks by (synchronous writes if NULL)
+ * @param block_size the size of a block (rounded up to the page size)
+ * @param block_count the number of blocks
+ * @param direct whether to bypass the page cache (O_DIRECT), where supported
+ * @param pool the pool to allocate memory from
+ * @remark Data is appended to page aligned blocks by a single producer
+ *         (media processing) with no locks. Complete blocks are passed through
+ *         a single-producer/single-consumer ring to a strand of the executor,
+ *         which writes them to disk, so that the producer never blocks on I/O.
+ */
+APT_DECLARE(apt_file_writer_t*) apt_file_writer_create(
+									apt_executor_t *executor,
+									apr_size_t block_size,
+									apr_size_t block_count,
+									apt_bool_t direct,
+									apr_pool_t *pool);
+
+/**
+ * Destroy file writer, wait for pending writes to complete.
+ * @param writer the writer to destroy
+ */
+APT_DECLARE(void) apt_file_writer_destroy(apt_file_writer_t *writer);
+
+/**
+ * Open (create or truncate) the file to write to.
+ * @param writer the writer to open the file by
+ * @param file_path the path of the file
+ * @param encoder the encoder to write data through (NULL to write data as is)
+ * @remark Called outside of media processing, waits for the previous file to be closed.
+ *         The writer takes the ownership of the encoder, even if the file fails to open.
+ *         Encoded files are never written with O_DIRECT.
+ */
+APT_DECLARE(apt_bool_t) apt_file_writer_open(apt_file_writer_t *writer, const char *file_path, apt_file_encoder_t *encoder);
+
+/**
+ * Append data to the file.
+ * @param writer the writer to append by
+ * @param data the data to append
+ * @param size the size of the data
+ * @return FALSE if the file is not open or the ring is full (data is dropped then)
+ * @remark Never blocks, intended to be called from the context of media processing.
+ */
+APT_DECLARE(apt_bool_t) apt_file_writer_write(apt_file_writer_t *writer, const void *data, apr_size_t size);
+
+/**
+ * Close the file, once all the appended data is written.
+ * @param writer the writer to close the file of
+ * @remark Never blocks, intended to be called from the context of media processing.
+ */
+APT_DECLARE(apt_bool_t) apt_file_writer_close(apt_file_writer_t *writer);
+
+/**
+ * Check whether the file is open.
+ * @param writer the writer to check
+ */
+APT_DECLARE(apt_bool_t) apt_file_writer_is_open(const apt_file_writer_t *writer);
+
+APT_END_EXTERN_C
+
+#endif /* APT_FILE_WRITER_H */
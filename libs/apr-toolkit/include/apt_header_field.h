@@ -32,6 +32,9 @@
 
 APT_BEGIN_EXTERN_C
 
+/** Number of header fields stored inline in header section */
+#define APT_HEADER_SECTION_INLINE_FIELD_COUNT 8
+
 /** Header field declaration */
 typedef struct apt_header_field_t apt_header_field_t;
 /** Header section declaration */
@@ -56,14 +59,30 @@ struct apt_header_field_t {
  * @remark The header section is a collection of header fields. 
  * The header fields are stored in both a ring and an array.
  * The goal is to ensure efficient access and manipulation on the header fields.
+ * For the common case of a few header fields, the fields set by numeric identifiers
+ * are kept in a small inline array, and the array indexed by identifiers is only
+ * built once there are more of them. The header fields themselves may be allocated
+ * inline too, see apt_header_section_field_alloc().
  */
 struct apt_header_section_t {
 	/** List of header fields (name-value pairs) */
 	APR_RING_HEAD(apt_head_t, apt_header_field_t) ring;
-	/** Array of pointers to header fields */
+	/** Array of pointers to header fields indexed by identifiers (NULL until built) */
 	apt_header_field_t **arr;
 	/** Max number of header fields */
 	apr_size_t           arr_size;
+	/** Pool to build the array from */
+	apr_pool_t          *pool;
+
+	/** Header fields set by identifiers, while the array is not built */
+	apt_header_field_t  *set_fields[APT_HEADER_SECTION_INLINE_FIELD_COUNT];
+	/** Number of header fields set by identifiers */
+	apr_size_t           set_count;
+
+	/** Header fields allocated along with the section */
+	apt_header_field_t   inline_fields[APT_HEADER_SECTION_INLINE_FIELD_COUNT];
+	/** Number of inline header fields in use */
+	apr_size_t           inline_count;
 };
 
 
@@ -118,6 +137,15 @@ APT_DECLARE(void) apt_header_section_init(apt_header_section_t *header);
  */
 APT_DECLARE(apt_bool_t) apt_header_section_array_alloc(apt_header_section_t *header, apr_size_t max_field_count, apr_pool_t *pool);
 
+/**
+ * Allocate an empty header field from inline storage of header section, or from the pool
+ * once the inline storage is used up.
+ * @param header the header section to allocate field for
+ * @param pool the pool to allocate memory from
+ * @remark The header field is supposed to be added to the same header section.
+ */
+APT_DECLARE(apt_header_field_t*) apt_header_section_field_alloc(apt_header_section_t *header, apr_pool_t *pool);
+
 /**
  * Add (append) header field to header section.
  * @param header the header section to add field to
@@ -140,6 +168,13 @@ APT_DECLARE(apt_bool_t) apt_header_section_field_insert(apt_header_section_t *he
  */
 APT_DECLARE(apt_bool_t) apt_header_section_field_set(apt_header_section_t *header, apt_header_field_t *header_field);
 
+/**
+ * Unset header field in the array of header fields, while keeping it in the header section.
+ * @param header the header section to unset field for
+ * @param header_field the header field to unset
+ */
+APT_DECLARE(apt_bool_t) apt_header_section_field_unset(apt_header_section_t *header, apt_header_field_t *header_field);
+
 /**
  * Remove header field from header section.
  * @param header the header section to remove field from
@@ -148,29 +183,35 @@ APT_DECLARE(apt_bool_t) apt_header_section_field_set(apt_header_section_t *heade
 APT_DECLARE(apt_bool_t) apt_header_section_field_remove(apt_header_section_t *header, apt_header_field_t *header_field);
 
 /**
- * Check whether specified header field is set.
+ * Get header field by specified identifier.
  * @param header the header section to use
- * @param id the identifier associated with the header_field to check
+ * @param id the identifier associated with the header_field
  */
-static APR_INLINE apt_bool_t apt_header_section_field_check(const apt_header_section_t *header, apr_size_t id)
+static APR_INLINE apt_header_field_t* apt_header_section_field_get(const apt_header_section_t *header, apr_size_t id)
 {
-	if(id < header->arr_size) {
-		return header->arr[id] ? TRUE : FALSE;
+	apr_size_t i;
+	if(id >= header->arr_size) {
+		return NULL;
 	}
-	return FALSE;
+	if(header->arr) {
+		return header->arr[id];
+	}
+	for(i=0; i<header->set_count; i++) {
+		if(header->set_fields[i]->id == id) {
+			return header->set_fields[i];
+		}
+	}
+	return NULL;
 }
 
 /**
- * Get header field by specified identifier.
+ * Check whether specified header field is set.
  * @param header the header section to use
- * @param id the identifier associated with the header_field
+ * @param id the identifier associated with the header_field to check
  */
-static APR_INLINE apt_header_field_t* apt_header_section_field_get(const apt_header_section_t *header, apr_size_t id)
+static APR_INLINE apt_bool_t apt_header_section_field_check(const apt_header_section_t *header, apr_size_t id)
 {
-	if(id < header->arr_size) {
-		return header->arr[id];
-	}
-	return NULL;
+	return apt_header_section_field_get(header,id) ? TRUE : FALSE;
 }
 
 APT_END_EXTERN_C
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef APT_HTTP_EXPORTER_H
+#define APT_HTTP_EXPORTER_H
+
+/**
+ * @file apt_http_exporter.h
+ * @brief Minimal HTTP Exporter of Text Documents (e.g. Metrics)
+ */
+
+#include "apt.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Opaque HTTP exporter declaration */
+typedef struct apt_http_exporter_t apt_http_exporter_t;
+
+/**
+ * Handler to render the document requested by path.
+ * @param obj the external object
+ * @param path the path of the request (e.g. "/metrics")
+ * @param pool the pool of the request to allocate the document from
+ * @return the document, or NULL if not found
+ */
+typedef const char* (*apt_http_exporter_render_f)(void *obj, const char *path, apr_pool_t *pool);
+
+/**
+ * Create HTTP exporter.
+ * @param ip the local IP address to listen on
+ * @param port the local port to listen on
+ * @param content_type the content type of the documents
+ * @param render the handler to render the documents by
+ * @param obj the external object passed to the handler
+ * @param pool the pool to allocate memory from
+ * @remark Requests are served one by one (HTTP/1.0, GET only, connection is closed
+ *         after the response) by a thread of the exporter, so the handler is called
+ *         out of the context of any other task.
+ */
+APT_DECLARE(apt_http_exporter_t*) apt_http_exporter_create(
+									const char *ip,
+									apr_port_t port,
+									const char *content_type,
+									apt_http_exporter_render_f render,
+									void *obj,
+									apr_pool_t *pool);
+
+/**
+ * Start listening and serving requests.
+ * @param exporter the exporter to start
+ */
+APT_DECLARE(apt_bool_t) apt_http_exporter_start(apt_http_exporter_t *exporter);
+
+/**
+ * Stop serving requests and close the listening socket.
+ * @param exporter the exporter to stop
+ * @remark Waits for the request in progress, if any.
+ */
+APT_DECLARE(apt_bool_t) apt_http_exporter_stop(apt_http_exporter_t *exporter);
+
+APT_END_EXTERN_C
+
+#endif /* APT_HTTP_EXPORTER_H */
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef APT_HUGE_REGION_H
+#define APT_HUGE_REGION_H
+
+/**
+ * @file apt_huge_region.h
+ * @brief Region of Memory Backed by Huge Pages
+ *
+ * Hot data of many objects (e.g. frames of jitter buffers of thousands of streams)
+ * packed together in 2 MB pages takes far fewer TLB entries than the same data
+ * spread among 4 KB pages of many pools.
+ */ 
+
+#include "apt.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Size of huge page the region is rounded up and aligned to */
+#define APT_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/** Opaque huge page region declaration */
+typedef struct apt_huge_region_t apt_huge_region_t;
+
+/** Pages the region is backed by */
+typedef enum {
+	APT_HUGE_REGION_HUGETLB,     /**< reserved huge pages (MAP_HUGETLB) */
+	APT_HUGE_REGION_TRANSPARENT, /**< transparent huge pages (madvise MADV_HUGEPAGE) */
+	APT_HUGE_REGION_NORMAL       /**< normal pages, huge pages are not available */
+} apt_huge_region_backing_e;
+
+/**
+ * Create region of memory.
+ * @param size the size of the region in bytes (rounded up to APT_HUGE_PAGE_SIZE)
+ * @param pool the pool to allocate the region object from
+ * @remark Reserved huge pages are tried first, then transparent huge pages,
+ *         then normal pages. The memory is touched at once, so that page faults
+ *         are not taken later, e.g. by media processing.
+ */
+APT_DECLARE(apt_huge_region_t*) apt_huge_region_create(apr_size_t size, apr_pool_t *pool);
+
+/**
+ * Destroy region, the memory allocated from it is unmapped.
+ * @param region the region to destroy
+ */
+APT_DECLARE(void) apt_huge_region_destroy(apt_huge_region_t *region);
+
+/**
+ * Allocate memory from region.
+ * @param region the region to allocate from
+ * @param size the size of memory (rounded up to the cache line)
+ * @return the memory aligned to the cache line or NULL if the region is exhausted
+ * @remark The memory is given back by destroying the region only, so callers keep
+ *         their own free lists. The region is not thread-safe.
+ */
+APT_DECLARE(void*) apt_huge_region_alloc(apt_huge_region_t *region, apr_size_t size);
+
+/**
+ * Get the pages the region is backed by.
+ * @param region the region to get the backing of
+ */
+APT_DECLARE(apt_huge_region_backing_e) apt_huge_region_backing_get(const apt_huge_region_t *region);
+
+/**
+ * Get the usage of region.
+ * @param region the region to get the usage of
+ * @param size the size of the region in bytes
+ * @param used the size of memory allocated from the region in bytes
+ */
+APT_DECLARE(void) apt_huge_region_stat_get(const apt_huge_region_t *region, apr_size_t *size, apr_size_t *used);
+
+APT_END_EXTERN_C
+
+#endif /* APT_HUGE_REGION_H */
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#ifndef APT_LISTENER_H
+#define APT_LISTENER_H
+
+/**
+ * @file apt_listener.h
+ * @brief Listening Sockets Inherited from and Handed off to Another Process
+ */ 
+
+#include <apr_network_io.h>
+#include "apt.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Environment variable listing the descriptors of the listening sockets handed off ("fd,fd,...") */
+#define APT_LISTEN_FDS_ENV "UNIMRCP_LISTEN_FDS"
+
+/** Max number of listening sockets inherited or handed off */
+#define APT_LISTENER_MAX_COUNT 64
+
+/**
+ * Take the listening socket inherited from the parent process, which is bound to the address.
+ * @param sockaddr the address the socket should be bound to
+ * @param type the type of the socket (SOCK_STREAM)
+ * @param pool the pool to allocate the socket from
+ * @return the socket listening already, or NULL if none is inherited
+ * @remark The sockets are passed by systemd socket activation (LISTEN_FDS, LISTEN_PID)
+ *         or by the process handing off its listeners (APT_LISTEN_FDS_ENV).
+ *         Each inherited socket is taken once.
+ */
+APT_DECLARE(apr_socket_t*) apt_listener_inherit(const apr_sockaddr_t *sockaddr, int type, apr_pool_t *pool);
+
+/**
+ * Register listening socket to hand off.
+ * @param sock the socket listening
+ */
+APT_DECLARE(void) apt_listener_register(apr_socket_t *sock);
+
+/**
+ * Unregister listening socket, before it is closed.
+ * @param sock the socket to unregister
+ */
+APT_DECLARE(void) apt_listener_unregister(apr_socket_t *sock);
+
+/**
+ * Hand off the registered listening sockets to the processes created next.
+ * @remark The sockets are made inheritable and listed in APT_LISTEN_FDS_ENV.
+ *         Once the process is created, the agents stop accepting by the sockets
+ *         on the next connection (see apt_listeners_are_handed_off()), so that
+ *         the connections pending are accepted by the new process.
+ */
+APT_DECLARE(apt_bool_t) apt_listeners_hand_off(void);
+
+/**
+ * Check whether the listening sockets have been handed off.
+ */
+APT_DECLARE(apt_bool_t) apt_listeners_are_handed_off(void);
+
+APT_END_EXTERN_C
+
+#endif /* APT_LISTENER_H */
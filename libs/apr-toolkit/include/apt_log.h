@@ -38,6 +38,14 @@ APT_BEGIN_EXTERN_C
 /** File:line mark */
 #define APT_LOG_MARK   __FILE__,__LINE__
 
+/**
+ * Log entries less important than the priority are compiled out
+ * (see --with-log-priority), their arguments are never evaluated.
+ */
+#ifndef APT_LOG_COMPILED_PRIORITY
+#define APT_LOG_COMPILED_PRIORITY APT_PRIO_DEBUG
+#endif
+
 /*
  * Definition of common formats used with apt_log().
  *
@@ -94,9 +102,29 @@ typedef enum {
 typedef enum {
 	APT_LOG_OUTPUT_NONE     = 0x00, /**< disable logging */
 	APT_LOG_OUTPUT_CONSOLE  = 0x01, /**< enable console output */
-	APT_LOG_OUTPUT_FILE     = 0x02  /**< enable log file output */
+	APT_LOG_OUTPUT_FILE     = 0x02, /**< enable log file output */
+	APT_LOG_OUTPUT_BINARY   = 0x04  /**< enable binary log file output (replaces text file output) */
 } apt_log_output_e;
 
+/**
+ * Binary log file output.
+ *
+ * The file (*.blog) is a sequence of records in host byte order, each starting with
+ * [u16 record size][u8 record type], the size includes these 3 bytes.
+ *
+ * Template record (type 1), written once per message template (format string)
+ * before its first entry and again at the beginning of each rotated file:
+ * [u32 template id][u32 line][u16 length][file][u16 length][format]
+ *
+ * Entry record (type 2):
+ * [u64 time (usec since epoch)][u64 thread][u8 priority][u64 object][u32 template id]
+ * [u8 argument count] followed by typed arguments in format order, including
+ * '*' width and precision: 'i' s64, 'u' u64, 'f' double, 'p' u64 pointer, 's' [u16 length][chars].
+ *
+ * Template id 0 is used when the template table is full, its template record
+ * then precedes every such entry.
+ */
+
 /** Masking mode of private data */
 typedef enum {
 	APT_LOG_MASKING_NONE,      /**< log everything as is */
@@ -107,6 +135,16 @@ typedef enum {
 /** Opaque logger declaration */
 typedef struct apt_logger_t apt_logger_t;
 
+/**
+ * The least important priority enabled either globally or for any module,
+ * cached to check log entries before their arguments are evaluated.
+ */
+APT_DECLARE_DATA extern volatile int apt_log_enabled_priority;
+
+/** Check whether log entries of the priority may be output */
+#define APT_LOG_PRIORITY_CHECK(priority) \
+	((int)(priority) <= (int)APT_LOG_COMPILED_PRIORITY && (int)(priority) <= apt_log_enabled_priority)
+
 /** Prototype of extended log handler function */
 typedef apt_bool_t (*apt_log_ext_handler_f)(const char *file, int line,
 											const char *obj, apt_log_priority_e priority,
@@ -164,6 +202,28 @@ APT_DECLARE(apt_bool_t) apt_log_file_open(
  */
 APT_DECLARE(apt_bool_t) apt_log_file_close(void);
 
+/**
+ * Enable asynchronous output mode.
+ * @param ring_size the size of per-thread ring in bytes (0 - default)
+ * @remark log entries are formatted on the calling thread and queued into
+ *         the lock-free ring of that thread, a dedicated writer thread drains
+ *         the rings and writes collected entries out at once; an entry is
+ *         dropped (and counted) rather than the caller blocked, if the ring is full.
+ *         Entries of different threads are not strictly ordered in the output.
+ */
+APT_DECLARE(apt_bool_t) apt_log_async_enable(apr_size_t ring_size);
+
+/**
+ * Disable asynchronous output mode, writing out all the queued entries.
+ * @remark should be called once the other threads have stopped logging
+ */
+APT_DECLARE(apt_bool_t) apt_log_async_disable(void);
+
+/**
+ * Get the number of log entries dropped so far in asynchronous output mode.
+ */
+APT_DECLARE(apr_size_t) apt_log_async_dropped_get(void);
+
 /**
  * Set the logging output mode.
  * @param mode the mode to set
@@ -188,6 +248,17 @@ APT_DECLARE(int) apt_log_output_mode_translate(char *str);
  */
 APT_DECLARE(apt_bool_t) apt_log_priority_set(apt_log_priority_e priority);
 
+/**
+ * Set the logging priority (log level) of the module.
+ * @param name the name of the module: apr-toolkit, mpf, mrcp, mrcp-signaling,
+ *        mrcpv2-transport, mrcp-engine, mrcp-server, mrcp-client, uni-rtsp,
+ *        sofia, unirtsp, or the name of the directory of a plugin (e.g. demo-recog)
+ * @param priority the priority to set
+ * @remark The module of a log entry is told by the path of its source file,
+ *         entries of other modules are output by the global priority.
+ */
+APT_DECLARE(apt_bool_t) apt_log_module_priority_set(const char *name, apt_log_priority_e priority);
+
 /**
  * Translate the priority (log level) string to enum.
  * @param str the string to translate
@@ -269,6 +340,24 @@ APT_DECLARE(apt_bool_t) apt_obj_log(const char *file, int line, apt_log_priority
  */
 APT_DECLARE(apt_bool_t) apt_va_log(const char *file, int line, apt_log_priority_e priority, const char *format, va_list arg_ptr);
 
+#ifndef APT_LOG_NO_MACROS
+/*
+ * apt_log() and apt_obj_log() calls skip the call itself and the evaluation
+ * of the arguments, if the priority is disabled. The extra expansion makes
+ * APT_LOG_MARK split into the file and the line (also with MSVC).
+ */
+/** Expand arguments (helper) */
+#define APT_LOG_EXPAND(x) x
+/** Call the log function, if the priority is enabled (helper) */
+#define APT_LOG_CHECKED_CALL(func,file,line,priority,...) \
+	(APT_LOG_PRIORITY_CHECK(priority) ? func(file,line,priority,__VA_ARGS__) : TRUE)
+
+/** Do logging, if the priority is enabled */
+#define apt_log(...) APT_LOG_EXPAND(APT_LOG_CHECKED_CALL(apt_log,__VA_ARGS__))
+/** Do logging with the associated object, if the priority is enabled */
+#define apt_obj_log(...) APT_LOG_EXPAND(APT_LOG_CHECKED_CALL(apt_obj_log,__VA_ARGS__))
+#endif
+
 APT_END_EXTERN_C
 
 #endif /* APT_LOG_H */
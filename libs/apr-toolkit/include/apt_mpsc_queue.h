@@ -0,0 +1,87 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+#ifndef APT_MPSC_QUEUE_H
+#define APT_MPSC_QUEUE_H
+
+/**
+ * @file apt_mpsc_queue.h
+ * @brief Bounded Lock-Free Multi-Producer Single-Consumer FIFO Queue of Opaque void* Objects
+ */ 
+
+#include "apt.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Default size (number of elements) of MPSC queue */
+#define MPSC_QUEUE_DEFAULT_SIZE	1024
+
+/** Opaque MPSC queue declaration */
+typedef struct apt_mpsc_queue_t apt_mpsc_queue_t;
+
+/**
+ * Create MPSC queue.
+ * @param size the max number of elements in the queue (rounded up to the power of two)
+ * @return the created queue
+ */
+APT_DECLARE(apt_mpsc_queue_t*) apt_mpsc_queue_create(apr_size_t size);
+
+/**
+ * Destroy MPSC queue.
+ * @param queue the queue to destroy
+ */
+APT_DECLARE(void) apt_mpsc_queue_destroy(apt_mpsc_queue_t *queue);
+
+/**
+ * Push object to the queue.
+ * @param queue the queue to push object to
+ * @param obj the object to push (must not be NULL)
+ * @return FALSE if the queue is full, otherwise TRUE
+ * @remark Can be called from any number of threads simultaneously.
+ */
+APT_DECLARE(apt_bool_t) apt_mpsc_queue_push(apt_mpsc_queue_t *queue, void *obj);
+
+/**
+ * Pop object from the queue.
+ * @param queue the queue to pop object from
+ * @return the popped object or NULL if the queue is empty
+ * @remark Must be called from the single consumer thread only.
+ */
+APT_DECLARE(void*) apt_mpsc_queue_pop(apt_mpsc_queue_t *queue);
+
+/**
+ * Pop up to the specified number of objects from the queue in one batch.
+ * @param queue the queue to pop objects from
+ * @param objs the array to store popped objects in
+ * @param max_count the max number of objects to pop
+ * @return the number of popped objects
+ * @remark Must be called from the single consumer thread only.
+ */
+APT_DECLARE(apr_size_t) apt_mpsc_queue_drain(apt_mpsc_queue_t *queue, void **objs, apr_size_t max_count);
+
+/**
+ * Query whether the queue is empty.
+ * @param queue the queue to query
+ * @return TRUE if empty, otherwise FALSE
+ */
+APT_DECLARE(apt_bool_t) apt_mpsc_queue_is_empty(const apt_mpsc_queue_t *queue);
+
+
+APT_END_EXTERN_C
+
+#endif /* APT_MPSC_QUEUE_H */
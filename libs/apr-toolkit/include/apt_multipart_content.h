@@ -49,6 +49,24 @@ struct apt_content_part_t {
 	apt_str_t           *length;
 };
 
+/** Content part declaration, referring to the multipart content the part is scanned from */
+typedef struct apt_content_span_t apt_content_span_t;
+
+/** Content part scanned with no copies made (the strings are slices of the multipart body) */
+struct apt_content_span_t {
+	/** Header section as is */
+	apt_str_t header;
+	/** Body */
+	apt_str_t body;
+
+	/** Value of content-type header field (empty if not present) */
+	apt_str_t type;
+	/** Value of content-id header field (empty if not present) */
+	apt_str_t id;
+	/** Value of content-length header field (empty if not present) */
+	apt_str_t length;
+};
+
 /**
  * Create an empty multipart content
  * @param max_content_size the max size of the content (body)
@@ -76,13 +94,36 @@ APT_DECLARE(apt_bool_t) apt_multipart_content_add(apt_multipart_content_t *multi
  */
 APT_DECLARE(apt_bool_t) apt_multipart_content_add2(apt_multipart_content_t *multipart_content, const apt_str_t *content_type, const apt_str_t *content_id, const apt_str_t *body);
 
+/** 
+ * Add content part to multipart content referring to the body rather than copying it
+ * @param multipart_content the multipart content to add content part to
+ * @param content_type the type of content part
+ * @param content_id the identifier of content part
+ * @param body the body of content part to be valid until the content is sent
+ * @return TRUE on success
+ * @remark Only the boundaries and header fields are written into the content buffer,
+ *         see apt_multipart_content_vec_finalize() to get the content as vector of segments.
+ */
+APT_DECLARE(apt_bool_t) apt_multipart_content_ref_add(apt_multipart_content_t *multipart_content, const apt_str_t *content_type, const apt_str_t *content_id, const apt_str_t *body);
+
 /** 
  * Finalize multipart content generation 
  * @param multipart_content the multipart content to finalize
  * @return generated multipart content
+ * @remark The bodies of the parts added by reference are copied into a new buffer.
  */
 APT_DECLARE(apt_str_t*) apt_multipart_content_finalize(apt_multipart_content_t *multipart_content);
 
+/** 
+ * Finalize multipart content generation into vector of segments (scatter/gather)
+ * @param multipart_content the multipart content to finalize
+ * @param vec the segments of generated content to return (valid as long as the pool)
+ * @param count the number of segments to return
+ * @param length the total length of the content to return
+ * @return TRUE on success
+ */
+APT_DECLARE(apt_bool_t) apt_multipart_content_vec_finalize(apt_multipart_content_t *multipart_content, const struct iovec **vec, apr_size_t *count, apr_size_t *length);
+
 
 /** 
  * Assign body to multipart content to get (parse) each content part from
@@ -102,6 +143,16 @@ APT_DECLARE(apt_multipart_content_t*) apt_multipart_content_assign(const apt_str
  */
 APT_DECLARE(apt_bool_t) apt_multipart_content_get(apt_multipart_content_t *multipart_content, apt_content_part_t *content_part, apt_bool_t *is_final);
 
+/** 
+ * Get the next content part with no copies made
+ * @param multipart_content the multipart content to get the next content part from
+ * @param content_span the scanned content part referring to the body of multipart content
+ * @param is_final indicates the final boundary is reached
+ * @return TRUE on success
+ * @remark The body is delimited by content-length, if present, otherwise by the next boundary.
+ */
+APT_DECLARE(apt_bool_t) apt_multipart_content_span_get(apt_multipart_content_t *multipart_content, apt_content_span_t *content_span, apt_bool_t *is_final);
+
 
 APT_END_EXTERN_C
 
@@ -29,6 +29,7 @@
 
 #include <apr_xml.h>
 #include "apt.h"
+#include "apt_string.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -205,6 +206,76 @@ APT_DECLARE(const char*) nlsml_input_timestamp_start_get(const nlsml_input_t *in
  */
 APT_DECLARE(const char*) nlsml_input_timestamp_end_get(const nlsml_input_t *input);
 
+/*
+ * Streaming (DOM-less) scan of the NLSML result.
+ * Interpretations are reported one by one as they are scanned, their attributes
+ * and the content of <instance> and <input> elements are the slices of the original
+ * data, with no XML tree built and nothing allocated.
+ */
+
+/** Max number of instances per interpretation reported by the scan */
+#define NLSML_SCAN_MAX_INSTANCE_COUNT 4
+
+/** Declaration of interpretation scanned */
+typedef struct nlsml_interpretation_span_t nlsml_interpretation_span_t;
+
+/** Interpretation scanned, the strings point to the scanned data as is (entities are not decoded) */
+struct nlsml_interpretation_span_t {
+	/** Confidence attribute [default: 1.0] */
+	float       confidence;
+	/** Grammar attribute (empty if not specified) */
+	apt_str_t   grammar;
+	/** Inner content of the <instance> elements */
+	apt_str_t   instances[NLSML_SCAN_MAX_INSTANCE_COUNT];
+	/** Number of the <instance> elements (may exceed the number of slices reported) */
+	apr_size_t  instance_count;
+	/** Whether the <input> element is present */
+	apt_bool_t  input_present;
+	/** Inner content of the <input> element */
+	apt_str_t   input;
+	/** Input mode attribute [default: "speech"] */
+	apt_str_t   input_mode;
+	/** Input confidence attribute [default: 1.0] */
+	float       input_confidence;
+	/** Timestamp-start attribute of the input */
+	apt_str_t   input_timestamp_start;
+	/** Timestamp-end attribute of the input */
+	apt_str_t   input_timestamp_end;
+};
+
+/**
+ * Handler of the interpretation scanned.
+ * @param obj the object passed to the scan
+ * @param interpretation the interpretation valid within the call only
+ * @return FALSE to stop the scan (e.g. once the best interpretation is taken)
+ */
+typedef apt_bool_t (*nlsml_interpretation_span_handler_f)(void *obj, const nlsml_interpretation_span_t *interpretation);
+
+/**
+ * Scan NLSML result without building the document.
+ * @param data the data to scan
+ * @param length the length of the data
+ * @param grammar the grammar attribute of the <result> to return (optional)
+ * @param handler the handler of interpretations
+ * @param obj the object to pass to the handler
+ * @return FALSE if the data is not a well formed NLSML result
+ * @remark Elements and attributes are matched by the local name, ignoring namespace prefixes.
+ */
+APT_DECLARE(apt_bool_t) nlsml_result_scan(
+							const char *data, 
+							apr_size_t length, 
+							apt_str_t *grammar, 
+							nlsml_interpretation_span_handler_f handler, 
+							void *obj);
+
+/**
+ * Generate a plain text of the scanned content (decode entities and CDATA sections).
+ * @param span the content scanned
+ * @param pool the memory pool to use
+ * @remark Nested markup is copied as is.
+ */
+APT_DECLARE(const char*) nlsml_span_text_generate(const apt_str_t *span, apr_pool_t *pool);
+
 APT_END_EXTERN_C
 
 #endif /* APT_NLSML_DOC_H */
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef APT_NLSML_WRITER_H
+#define APT_NLSML_WRITER_H
+
+/**
+ * @file apt_nlsml_writer.h
+ * @brief NLSML Result Generation
+ * @remark The result is described by plain structures and generated in two passes:
+ *         the exact length of the escaped document is calculated first, then the
+ *         document is written into the buffer allocated once from the pool.
+ */
+
+#include "apt.h"
+#include "apt_string.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Omitted confidence or score */
+#define NLSML_CONFIDENCE_NONE -1.0f
+
+/** Declaration of interpretation to generate */
+typedef struct nlsml_interpretation_spec_t nlsml_interpretation_spec_t;
+/** Declaration of voiceprint verification to generate */
+typedef struct nlsml_voiceprint_spec_t nlsml_voiceprint_spec_t;
+/** Declaration of verification scores to generate */
+typedef struct nlsml_verification_spec_t nlsml_verification_spec_t;
+
+/** Interpretation to generate (the string members are optional, NULL to omit) */
+struct nlsml_interpretation_spec_t {
+	/** Grammar attribute */
+	const char *grammar;
+	/** Confidence attribute [0.0 - 1.0] or NLSML_CONFIDENCE_NONE */
+	float       confidence;
+	/** Text of the <instance> element, escaped on generation */
+	const char *instance;
+	/** Pre-escaped XML content of the <instance> element, copied as is (takes precedence over the text) */
+	const char *instance_xml;
+	/** Text of the <input> element, escaped on generation */
+	const char *input;
+	/** Mode attribute of the <input> element ("speech" or "dtmf") */
+	const char *input_mode;
+	/** Confidence attribute of the <input> element or NLSML_CONFIDENCE_NONE */
+	float       input_confidence;
+};
+
+/** Verification scores to generate (the string members are optional, NULL to omit) */
+struct nlsml_verification_spec_t {
+	/** Length of the utterance (msec, 0 to omit) */
+	apr_size_t  utterance_length;
+	/** Device of the speaker (e.g. "cellular-phone") */
+	const char *device;
+	/** Gender of the speaker ("male", "female" or "unknown") */
+	const char *gender;
+	/** Decision ("accepted", "rejected" or "undecided") */
+	const char *decision;
+	/** Verification score or NLSML_CONFIDENCE_NONE */
+	float       verification_score;
+};
+
+/** Voiceprint verification to generate */
+struct nlsml_voiceprint_spec_t {
+	/** Id of the voiceprint */
+	const char                      *id;
+	/** Incremental scores (NULL to omit) */
+	const nlsml_verification_spec_t *incremental;
+	/** Cumulative scores (NULL to omit) */
+	const nlsml_verification_spec_t *cumulative;
+};
+
+/**
+ * Generate NLSML result with interpretations (body of RECOGNITION-COMPLETE, INTERPRETATION-COMPLETE).
+ * @param grammar the grammar attribute of the <result> (NULL to omit)
+ * @param interpretations the interpretations ordered by confidence (N-best list)
+ * @param count the number of interpretations
+ * @param body the generated document to return
+ * @param pool the memory pool to allocate the document from (single allocation)
+ */
+APT_DECLARE(apt_bool_t) nlsml_recognition_result_generate(
+							const char *grammar,
+							const nlsml_interpretation_spec_t *interpretations,
+							apr_size_t count,
+							apt_str_t *body,
+							apr_pool_t *pool);
+
+/**
+ * Generate NLSML result with verification result (body of VERIFICATION-COMPLETE).
+ * @param grammar the grammar attribute of the <result> (NULL to omit)
+ * @param voiceprints the voiceprints verified
+ * @param count the number of voiceprints
+ * @param body the generated document to return
+ * @param pool the memory pool to allocate the document from (single allocation)
+ */
+APT_DECLARE(apt_bool_t) nlsml_verification_result_generate(
+							const char *grammar,
+							const nlsml_voiceprint_spec_t *voiceprints,
+							apr_size_t count,
+							apt_str_t *body,
+							apr_pool_t *pool);
+
+APT_END_EXTERN_C
+
+#endif /* APT_NLSML_WRITER_H */
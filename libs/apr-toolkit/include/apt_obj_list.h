@@ -51,7 +51,8 @@ APT_DECLARE(void) apt_list_destroy(apt_obj_list_t *list);
  * Push object to the list as first in, first out.
  * @param list the list to push object to
  * @param obj the object to push
- * @param pool the pool to allocate list element from
+ * @param pool the pool to allocate list element from, or NULL to use
+ *             an element owned by the list (see apt_list_elem_remove())
  * @return the inserted element
  */
 APT_DECLARE(apt_list_elem_t*) apt_list_push_back(apt_obj_list_t *list, void *obj, apr_pool_t *pool);
@@ -107,7 +108,8 @@ APT_DECLARE(apt_list_elem_t*) apt_list_prev_elem_get(const apt_obj_list_t *list,
  * @param list the list to insert element to
  * @param elem the element to insert before
  * @param obj the object to insert
- * @param pool the pool to allocate list element from
+ * @param pool the pool to allocate list element from, or NULL to use
+ *             an element owned by the list (see apt_list_elem_remove())
  * @return the inserted element
  */
 APT_DECLARE(apt_list_elem_t*) apt_list_elem_insert(apt_obj_list_t *list, apt_list_elem_t *elem, void *obj, apr_pool_t *pool);
@@ -117,6 +119,9 @@ APT_DECLARE(apt_list_elem_t*) apt_list_elem_insert(apt_obj_list_t *list, apt_lis
  * @param list the list to remove element from
  * @param elem the element to remove
  * @return the next element (if any)
+ * @remark Elements owned by the list are kept for reuse, so that a list
+ *         pushed to and popped from over its lifetime allocates no more
+ *         elements than it holds at once. A removed element is not valid anymore.
  */
 APT_DECLARE(apt_list_elem_t*) apt_list_elem_remove(apt_obj_list_t *list, apt_list_elem_t *elem);
 
@@ -30,6 +30,9 @@
  * apt_pollset_t is an extension of apr_pollset_t and provides
  * pollset wakeup capabilities the similar way as it's implemented
  * in APR-1.4 trunk
+ *
+ * If APT_HAVE_EPOLL is defined, the pollset is implemented natively
+ * on top of epoll with eventfd based wakeup instead.
  */
 
 #include <apr_poll.h>
@@ -37,6 +40,13 @@
 
 APT_BEGIN_EXTERN_C
 
+/**
+ * Request edge-triggered notification of the descriptor (set in reqevents).
+ * The descriptor must then be read or written until EAGAIN. Honored by
+ * the native epoll backend only, others are level-triggered regardless.
+ */
+#define APT_POLLET 0x4000
+
 /** Opaque pollset declaration */
 typedef struct apt_pollset_t apt_pollset_t;
 
@@ -33,17 +33,130 @@
 
 APT_BEGIN_EXTERN_C
 
+/** Default max number of idle allocators root pools are created on */
+#define APT_POOL_DEFAULT_CACHE_SIZE 64
+/** Default max size of free memory retained by an idle allocator (bytes) */
+#define APT_POOL_DEFAULT_MAX_FREE   (128 * 1024)
+
+/**
+ * Set the policy of the cache of allocators.
+ * @param cache_size the max number of idle allocators to keep process-wide
+ * @param max_free the max size of free memory each allocator retains
+ * @remark Each root pool is created on its own allocator, which is taken back to
+ *         the cache on the pool destruction along with its free memory blocks.
+ *         A few allocators are cached per thread in addition, which can be taken
+ *         without any lock.
+ */
+APT_DECLARE(void) apt_pool_allocator_cache_set(apr_size_t cache_size, apr_size_t max_free);
+
 /**
  * Create APR pool
+ * @remark The pool is created on an allocator taken from the cache, it must be
+ *         destroyed or cleared by apt_pool_clear() rather than by apr_pool_clear().
  */
 APT_DECLARE(apr_pool_t*) apt_pool_create(void);
 
+/**
+ * Clear APR pool created by apt_pool_create() for reuse.
+ * @param pool the pool to clear
+ * @remark The cleanups are run and the memory is freed to the allocator of the pool,
+ *         which, unlike on the destruction, is kept by the pool along with its free blocks.
+ */
+APT_DECLARE(void) apt_pool_clear(apr_pool_t *pool);
+
 /**
  * Create APR subpool pool
  * @param parent the parent pool
  */
 APT_DECLARE(apr_pool_t*) apt_subpool_create(apr_pool_t *parent);
 
+/** Statistics of pools declaration */
+typedef struct apt_pool_stat_t apt_pool_stat_t;
+
+/** Statistics of root pools created by apt_pool_create() */
+struct apt_pool_stat_t {
+	/** Number of root pools in use */
+	apr_size_t pool_count;
+	/** Number of idle allocators kept in the process-wide cache */
+	apr_size_t cached_allocator_count;
+};
+
+/**
+ * Get statistics of root pools.
+ * @param stat the statistics to fill
+ * @remark Can be called from any thread, the values are approximate.
+ */
+APT_DECLARE(void) apt_pool_stat_get(apt_pool_stat_t *stat);
+
+/** Owners of pools memory is accounted by */
+typedef enum {
+	APT_POOL_OWNER_SESSION,    /**< pool of session, channels and MRCPv1 messages are allocated from */
+	APT_POOL_OWNER_CHANNEL,    /**< own pool of engine channel */
+	APT_POOL_OWNER_CONNECTION, /**< pool of MRCPv2 connection, received messages are parsed into */
+
+	APT_POOL_OWNER_COUNT
+} apt_pool_owner_e;
+
+/** Statistics of memory accounting declaration */
+typedef struct apt_pool_account_stat_t apt_pool_account_stat_t;
+
+/** Statistics of memory held by the pools of an owner */
+struct apt_pool_account_stat_t {
+	/** Number of accounted pools in use */
+	apr_size_t pool_count;
+	/** Size of memory held by the pools as of their last update (bytes) */
+	apr_size_t bytes;
+	/** Max size of memory ever held by the pools at once (bytes) */
+	apr_size_t peak_bytes;
+};
+
+/**
+ * Enable/disable memory accounting of pools tagged by apt_pool_owner_set().
+ * @param enable whether to enable accounting (disabled by default)
+ * @remark Must be set before any pool is tagged.
+ */
+APT_DECLARE(void) apt_pool_accounting_set(apt_bool_t enable);
+
+/** Check whether memory accounting is enabled */
+APT_DECLARE(apt_bool_t) apt_pool_accounting_get(void);
+
+/**
+ * Tag the pool by its owner to account the memory it holds.
+ * @param pool the pool to tag
+ * @param owner the owner of the pool
+ * @remark No-op, unless accounting is enabled. The memory is measured on
+ *         apt_pool_account_update() and reclaimed, once the pool is destroyed or cleared.
+ */
+APT_DECLARE(void) apt_pool_owner_set(apr_pool_t *pool, apt_pool_owner_e owner);
+
+/**
+ * Measure the memory held by the tagged pool and update the statistics of its owner.
+ * @param pool the pool to update
+ * @return the size of memory held by the pool, 0 if the pool isn't tagged
+ * @remark Must be called by the thread the pool is allocated from.
+ */
+APT_DECLARE(apr_size_t) apt_pool_account_update(apr_pool_t *pool);
+
+/**
+ * Get the size of memory blocks held by the pool, excluding its subpools.
+ * @param pool the pool to measure
+ * @remark Must be called by the thread the pool is allocated from.
+ */
+APT_DECLARE(apr_size_t) apt_pool_bytes_get(apr_pool_t *pool);
+
+/**
+ * Get statistics of memory held by the pools of an owner.
+ * @param owner the owner to get statistics of
+ * @param stat the statistics to fill
+ */
+APT_DECLARE(void) apt_pool_account_stat_get(apt_pool_owner_e owner, apt_pool_account_stat_t *stat);
+
+/**
+ * Get the name of an owner of pools.
+ * @param owner the owner to get the name of
+ */
+APT_DECLARE(const char*) apt_pool_owner_name_get(apt_pool_owner_e owner);
+
 APT_END_EXTERN_C
 
 #endif /* APT_POOL_H */
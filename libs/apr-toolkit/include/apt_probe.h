@@ -0,0 +1,64 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef APT_PROBE_H
+#define APT_PROBE_H
+
+/**
+ * @file apt_probe.h
+ * @brief Static Tracepoints (USDT)
+ * @remark The probes are compiled out unless built with --enable-usdt,
+ *         then they are placed into the "unimrcp" provider and can be
+ *         attached by SystemTap, bpftrace or perf on a running process.
+ *         Disabled probes cost a single nop instruction.
+ */
+
+#include "apt.h"
+
+#ifdef APT_HAVE_USDT
+#include <sys/sdt.h>
+
+/** Fire probe without arguments */
+#define APT_PROBE0(name) \
+	DTRACE_PROBE(unimrcp,name)
+/** Fire probe with one argument */
+#define APT_PROBE1(name,a1) \
+	DTRACE_PROBE1(unimrcp,name,a1)
+/** Fire probe with two arguments */
+#define APT_PROBE2(name,a1,a2) \
+	DTRACE_PROBE2(unimrcp,name,a1,a2)
+/** Fire probe with three arguments */
+#define APT_PROBE3(name,a1,a2,a3) \
+	DTRACE_PROBE3(unimrcp,name,a1,a2,a3)
+/** Fire probe with four arguments */
+#define APT_PROBE4(name,a1,a2,a3,a4) \
+	DTRACE_PROBE4(unimrcp,name,a1,a2,a3,a4)
+#else
+/** Fire probe without arguments */
+#define APT_PROBE0(name)
+/** Fire probe with one argument */
+#define APT_PROBE1(name,a1)
+/** Fire probe with two arguments */
+#define APT_PROBE2(name,a1,a2)
+/** Fire probe with three arguments */
+#define APT_PROBE3(name,a1,a2,a3)
+/** Fire probe with four arguments */
+#define APT_PROBE4(name,a1,a2,a3,a4)
+#endif
+
+#endif /* APT_PROBE_H */
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef APT_SHARD_TABLE_H
+#define APT_SHARD_TABLE_H
+
+/**
+ * @file apt_shard_table.h
+ * @brief Sharded Concurrent Table of Opaque void* Objects Keyed by String
+ */ 
+
+#include "apt.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Default number of shards of table */
+#define APT_SHARD_TABLE_DEFAULT_SHARD_COUNT  16
+/** Max length of key (session ids and the like fit) */
+#define APT_SHARD_TABLE_MAX_KEY_LENGTH       64
+
+/** Opaque shard table declaration */
+typedef struct apt_shard_table_t apt_shard_table_t;
+
+/**
+ * Create sharded table.
+ * @param shard_count the number of shards (rounded up to the power of two)
+ * @param bucket_count the number of buckets per shard (rounded up to the power of two)
+ * @param pool the pool to allocate memory from
+ * @remark Each shard is modified under its own lock, while lookups take no lock at all:
+ *         entries are never freed, but recycled within their shard, and a reader
+ *         retries, if the shard has been modified meanwhile (sequence lock).
+ */
+APT_DECLARE(apt_shard_table_t*) apt_shard_table_create(apr_size_t shard_count, apr_size_t bucket_count, apr_pool_t *pool);
+
+/**
+ * Destroy sharded table.
+ * @param table the table to destroy
+ */
+APT_DECLARE(void) apt_shard_table_destroy(apt_shard_table_t *table);
+
+/**
+ * Set (add, replace or remove) object by key.
+ * @param table the table to set object in
+ * @param key the key to set object by
+ * @param length the length of the key
+ * @param obj the object to set (NULL to remove)
+ * @return FALSE if the key is longer than APT_SHARD_TABLE_MAX_KEY_LENGTH
+ */
+APT_DECLARE(apt_bool_t) apt_shard_table_set(apt_shard_table_t *table, const char *key, apr_size_t length, void *obj);
+
+/**
+ * Get object by key without locking.
+ * @param table the table to get object from
+ * @param key the key to get object by
+ * @param length the length of the key
+ */
+APT_DECLARE(void*) apt_shard_table_get(apt_shard_table_t *table, const char *key, apr_size_t length);
+
+/**
+ * Get the number of objects in the table.
+ * @param table the table to get the number of objects of
+ */
+APT_DECLARE(apr_size_t) apt_shard_table_count_get(const apt_shard_table_t *table);
+
+/**
+ * Get the number of shards of the table.
+ * @param table the table to get the number of shards of
+ */
+APT_DECLARE(apr_size_t) apt_shard_table_shard_count_get(const apt_shard_table_t *table);
+
+APT_END_EXTERN_C
+
+#endif /* APT_SHARD_TABLE_H */
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#ifndef APT_SHM_RING_H
+#define APT_SHM_RING_H
+
+/**
+ * @file apt_shm_ring.h
+ * @brief Single-Producer Single-Consumer Ring of Records in Shared Memory
+ *
+ * The ring and the doorbell keep no pointers in the memory they are placed in,
+ * so that both can be shared by processes, given the memory is mapped at the
+ * same address (e.g. anonymous apr_shm_t created before apr_proc_fork()).
+ */ 
+
+#include "apt.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Opaque ring declaration */
+typedef struct apt_shm_ring_t apt_shm_ring_t;
+
+/** Opaque doorbell declaration */
+typedef struct apt_doorbell_t apt_doorbell_t;
+
+/**
+ * Get the size of memory the ring takes.
+ * @param capacity the number of bytes of records (rounded up to the power of two)
+ */
+APT_DECLARE(apr_size_t) apt_shm_ring_size_get(apr_size_t capacity);
+
+/**
+ * Create ring in memory.
+ * @param mem the memory of apt_shm_ring_size_get() bytes (8-byte aligned, at best to a cache line)
+ * @param capacity the number of bytes of records (the same as passed to apt_shm_ring_size_get())
+ * @return the ring, located at mem
+ */
+APT_DECLARE(apt_shm_ring_t*) apt_shm_ring_create(void *mem, apr_size_t capacity);
+
+/**
+ * Reserve space for a record to write in place.
+ * @param ring the ring to reserve the record in
+ * @param size the max size of the record
+ * @return the space of the record (8-byte aligned) or NULL if the ring is full
+ * @remark Must be called by the single producer only and followed by apt_shm_ring_commit().
+ */
+APT_DECLARE(void*) apt_shm_ring_reserve(apt_shm_ring_t *ring, apr_size_t size);
+
+/**
+ * Commit the reserved record, making it visible to the consumer.
+ * @param ring the ring to commit the record to
+ * @param size the actual size of the record, not more than reserved
+ */
+APT_DECLARE(void) apt_shm_ring_commit(apt_shm_ring_t *ring, apr_size_t size);
+
+/**
+ * Write a record composed of two parts (header and body).
+ * @return FALSE if the ring is full
+ */
+APT_DECLARE(apt_bool_t) apt_shm_ring_write(apt_shm_ring_t *ring, const void *head, apr_size_t head_size, const void *body, apr_size_t body_size);
+
+/**
+ * Get the oldest record to read in place.
+ * @param ring the ring to get the record from
+ * @param size the size of the record
+ * @return the record or NULL if the ring is empty
+ * @remark Must be called by the single consumer only. The record stays in the ring,
+ *         until released by apt_shm_ring_release().
+ */
+APT_DECLARE(const void*) apt_shm_ring_peek(apt_shm_ring_t *ring, apr_size_t *size);
+
+/**
+ * Release the record got by apt_shm_ring_peek().
+ * @param ring the ring to release the record in
+ */
+APT_DECLARE(void) apt_shm_ring_release(apt_shm_ring_t *ring);
+
+/**
+ * Discard all the records.
+ * @remark Must be called by the consumer only.
+ */
+APT_DECLARE(void) apt_shm_ring_discard(apt_shm_ring_t *ring);
+
+/** Get the number of records in the ring */
+APT_DECLARE(apr_size_t) apt_shm_ring_count_get(const apt_shm_ring_t *ring);
+
+
+/** Get the size of memory the doorbell takes */
+APT_DECLARE(apr_size_t) apt_doorbell_size_get(void);
+
+/**
+ * Create doorbell in memory.
+ * @param mem the memory of apt_doorbell_size_get() bytes
+ * @return the doorbell (located at mem) or NULL if descriptors cannot be created
+ * @remark The doorbell is based on eventfd on Linux and on a pipe otherwise.
+ *         The descriptors are inherited by processes forked afterwards.
+ *         Not available, where fork is not (APR_HAS_FORK).
+ */
+APT_DECLARE(apt_doorbell_t*) apt_doorbell_create(void *mem);
+
+/** Destroy doorbell (close descriptors in the calling process) */
+APT_DECLARE(void) apt_doorbell_destroy(apt_doorbell_t *doorbell);
+
+/**
+ * Signal the waiter, if it is about to sleep.
+ * @remark Costs an atomic read only, if the waiter is busy. Call after records are committed.
+ */
+APT_DECLARE(apt_bool_t) apt_doorbell_ring(apt_doorbell_t *doorbell);
+
+/**
+ * Announce the waiter is about to sleep.
+ * @remark Check the rings again after the call and go to apt_doorbell_wait() only,
+ *         if they are still empty, so that no signal gets lost.
+ */
+APT_DECLARE(void) apt_doorbell_arm(apt_doorbell_t *doorbell);
+
+/**
+ * Wait for the signal or timeout.
+ * @param doorbell the doorbell to wait for
+ * @param timeout the time to wait (usec, negative to wait forever)
+ * @return TRUE if signalled, FALSE on timeout
+ */
+APT_DECLARE(apt_bool_t) apt_doorbell_wait(apt_doorbell_t *doorbell, apr_interval_time_t timeout);
+
+APT_END_EXTERN_C
+
+#endif /* APT_SHM_RING_H */
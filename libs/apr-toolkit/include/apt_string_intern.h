@@ -0,0 +1,129 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef APT_STRING_INTERN_H
+#define APT_STRING_INTERN_H
+
+/**
+ * @file apt_string_intern.h
+ * @brief Interned Constant Strings
+ * @remark Well-known values (content types, resource names) are kept once per process
+ * in read-only memory. Parsers replace the parsed values by the interned ones, which
+ * are neither copied to pools nor compared character by character afterwards.
+ */ 
+
+#include "apt_string.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Identifiers of interned strings */
+typedef enum {
+	APT_INTERN_SPEECHSYNTH,                /**< speechsynth */
+	APT_INTERN_SPEECHRECOG,                /**< speechrecog */
+	APT_INTERN_RECORDER,                   /**< recorder */
+	APT_INTERN_SPEAKVERIFY,                /**< speakverify */
+	APT_INTERN_APPLICATION_SRGS_XML,       /**< application/srgs+xml */
+	APT_INTERN_APPLICATION_SRGS,           /**< application/srgs */
+	APT_INTERN_APPLICATION_NLSML_XML,      /**< application/nlsml+xml */
+	APT_INTERN_APPLICATION_X_NLSML,        /**< application/x-nlsml */
+	APT_INTERN_APPLICATION_SSML_XML,       /**< application/ssml+xml */
+	APT_INTERN_APPLICATION_SYNTHESIS_SSML, /**< application/synthesis+ssml */
+	APT_INTERN_APPLICATION_PLS_XML,        /**< application/pls+xml */
+	APT_INTERN_TEXT_URI_LIST,              /**< text/uri-list */
+	APT_INTERN_TEXT_GRAMMAR_REF_LIST,      /**< text/grammar-ref-list */
+	APT_INTERN_TEXT_PLAIN,                 /**< text/plain */
+	APT_INTERN_MULTIPART_MIXED,            /**< multipart/mixed */
+	APT_INTERN_VALUE_TRUE,                 /**< true */
+	APT_INTERN_VALUE_FALSE,                /**< false */
+
+	APT_INTERN_COUNT
+} apt_intern_id_e;
+
+/**
+ * Get interned string by identifier.
+ * @param id the identifier of the string
+ * @return the interned string, or NULL if the id is invalid
+ */
+APT_DECLARE(const apt_str_t*) apt_string_intern_get(apt_intern_id_e id);
+
+/**
+ * Find interned string equal to a given one (case-sensitive).
+ * @param value the string to find
+ * @return the interned string, or NULL if the value is not a well-known one
+ */
+APT_DECLARE(const apt_str_t*) apt_string_intern_find(const apt_str_t *value);
+
+/**
+ * Check whether the string refers to an interned one.
+ * @param str the string to check
+ */
+APT_DECLARE(apt_bool_t) apt_string_is_interned(const apt_str_t *str);
+
+/**
+ * Replace the buffer of the string by interned one, if the value is a well-known one.
+ * @param str the string to intern
+ * @return TRUE if the string is interned
+ * @remark The interned buffer is read-only.
+ */
+static APR_INLINE apt_bool_t apt_string_intern(apt_str_t *str)
+{
+	const apt_str_t *interned = apt_string_intern_find(str);
+	if(!interned) {
+		return FALSE;
+	}
+	*str = *interned;
+	return TRUE;
+}
+
+/**
+ * Copy the string, or refer to the interned one with no copy made.
+ * @param str the destination string
+ * @param src_str the source string
+ * @param pool the pool to allocate memory from
+ */
+static APR_INLINE void apt_string_intern_copy(apt_str_t *str, const apt_str_t *src_str, apr_pool_t *pool)
+{
+	const apt_str_t *interned = apt_string_is_interned(src_str) == TRUE ? src_str : apt_string_intern_find(src_str);
+	if(interned) {
+		*str = *interned;
+		return;
+	}
+	apt_string_copy(str,src_str,pool);
+}
+
+/**
+ * Compare two strings (case insensitive), by identity if both are interned.
+ * @param str1 the string to compare
+ * @param str2 the string to compare
+ * @return TRUE if equal, FALSE otherwise
+ */
+static APR_INLINE apt_bool_t apt_string_intern_compare(const apt_str_t *str1, const apt_str_t *str2)
+{
+	if(str1->buf == str2->buf) {
+		return str1->length == str2->length ? TRUE : FALSE;
+	}
+	if(apt_string_is_interned(str1) == TRUE && apt_string_is_interned(str2) == TRUE) {
+		/* interned strings are unique even regardless of case */
+		return FALSE;
+	}
+	return apt_string_compare(str1,str2);
+}
+
+APT_END_EXTERN_C
+
+#endif /* APT_STRING_INTERN_H */
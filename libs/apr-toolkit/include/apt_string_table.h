@@ -40,6 +40,23 @@ struct apt_str_table_item_t {
 	apr_size_t key;
 };
 
+/** String table hash declaration */
+typedef struct apt_str_table_hash_t apt_str_table_hash_t;
+
+/** 
+ * Case-insensitive perfect hash of string table.
+ * Hashes are generated offline along with key characters (see strtablegen),
+ * the seed is chosen so that no two strings of the table hash to the same slot.
+ */
+struct apt_str_table_hash_t {
+	/** Seed of the hash function */
+	apr_uint32_t      seed;
+	/** Number of slots minus one (slots are power of two) */
+	apr_size_t        mask;
+	/** Slots holding the id of the string hashed to the slot plus one, or 0 */
+	const apr_byte_t *slots;
+};
+
 
 /**
  * Get the string by a given id.
@@ -59,6 +76,23 @@ APT_DECLARE(const apt_str_t*) apt_string_table_str_get(const apt_str_table_item_
  */
 APT_DECLARE(apr_size_t) apt_string_table_id_find(const apt_str_table_item_t table[], apr_size_t size, const apt_str_t *value);
 
+/**
+ * Find the id associated with a given string using perfect hash of the table.
+ * @param table the table to search for the id
+ * @param size the size of the table
+ * @param hash the hash of the table, or NULL to search the table item by item
+ * @param value the string to search for
+ * @return the id associated with the string, or invalid id if string cannot be matched
+ */
+APT_DECLARE(apr_size_t) apt_string_table_id_hash_find(const apt_str_table_item_t table[], apr_size_t size, const apt_str_table_hash_t *hash, const apt_str_t *value);
+
+/**
+ * Calculate case-insensitive hash of a given string.
+ * @param seed the seed of the hash function
+ * @param value the string to calculate the hash of
+ */
+APT_DECLARE(apr_uint32_t) apt_string_table_hash(apr_uint32_t seed, const apt_str_t *value);
+
 
 APT_END_EXTERN_C
 
@@ -26,6 +26,7 @@
 
 #include "apt.h"
 #include "apt_task_msg.h"
+#include "apt_cpu_set.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -37,6 +38,33 @@ typedef struct apt_task_vtable_t apt_task_vtable_t;
 typedef apt_bool_t (*apt_task_method_f)(apt_task_t *task);
 /** Opaque task event declaration */
 typedef void (*apt_task_event_f)(apt_task_t *task);
+/** Handler of a task visited by apt_task_walk() */
+typedef void (*apt_task_visitor_f)(apt_task_t *task, void *obj);
+
+/** Number of buckets in the histograms of message wait and processing time */
+#define APT_TASK_HISTOGRAM_SIZE 12
+
+/** Task statistics declaration */
+typedef struct apt_task_stat_t apt_task_stat_t;
+
+/** Statistics of messages signalled to the task */
+struct apt_task_stat_t {
+	/** Number of processed messages */
+	apr_uint32_t msg_count;
+	/** Number of messages signalled, but not processed yet */
+	apr_uint32_t queue_depth;
+	/** Max number of messages signalled, but not processed yet */
+	apr_uint32_t max_queue_depth;
+	/** Max time a message waits to be processed (usec) */
+	apr_uint32_t max_wait_time;
+	/** Max time a message is processed within (usec) */
+	apr_uint32_t max_process_time;
+	/** Histogram of time from a message is signalled to it is processed,
+	where the bucket N counts the messages within (64 << N) usec and the last bucket counts the rest */
+	apr_uint32_t wait_histogram[APT_TASK_HISTOGRAM_SIZE];
+	/** Histogram of processing time, bucketed the same way */
+	apr_uint32_t process_histogram[APT_TASK_HISTOGRAM_SIZE];
+};
 
 
 /**
@@ -115,6 +143,16 @@ APT_DECLARE(apt_bool_t) apt_task_msg_signal(apt_task_t *task, apt_task_msg_t *ms
  */
 APT_DECLARE(apt_bool_t) apt_task_msg_parent_signal(apt_task_t *task, apt_task_msg_t *msg);
 
+/**
+ * Forward message signaled to the task to another task.
+ * @param task the task the message is signaled to
+ * @param target the task to forward the message to
+ * @param msg the message to forward
+ * @remark To be called by the signal_msg method of the task, which should return TRUE then.
+ *         The message is accounted by the target rather than by the task.
+ */
+APT_DECLARE(apt_bool_t) apt_task_msg_forward(apt_task_t *task, apt_task_t *target, apt_task_msg_t *msg);
+
 /**
  * Process message signaled to the task.
  * @param task the task to process message
@@ -172,6 +210,39 @@ APT_DECLARE(void) apt_task_name_set(apt_task_t *task, const char *name);
  */
 APT_DECLARE(const char*) apt_task_name_get(const apt_task_t *task);
 
+/**
+ * Get statistics of messages signalled to the task.
+ * @param task the task to get statistics of
+ * @param stat the statistics to fill
+ * @remark The statistics is updated by the threads signalling and processing
+ *         messages and can be read from any thread.
+ */
+APT_DECLARE(void) apt_task_stat_get(const apt_task_t *task, apt_task_stat_t *stat);
+
+/**
+ * Visit the task and all its descendants.
+ * @param task the task to start from
+ * @param visitor the handler to invoke for each task
+ * @param obj the external object to pass to the handler
+ */
+APT_DECLARE(void) apt_task_walk(apt_task_t *task, apt_task_visitor_f visitor, void *obj);
+
+/**
+ * Bind the thread of the task to the set of CPUs.
+ * @param task the task to bind
+ * @param cpu_set the set of CPUs to copy (NULL - no binding)
+ * @remark Must be set before the task is started. Helper threads of the task
+ *         (e.g. workers of consumer task) are bound to the same set.
+ */
+APT_DECLARE(void) apt_task_cpu_set_set(apt_task_t *task, const apt_cpu_set_t *cpu_set);
+
+/**
+ * Get the set of CPUs the thread of the task is bound to.
+ * @param task the task to get the set of CPUs of
+ * @return NULL if the thread is not bound
+ */
+APT_DECLARE(const apt_cpu_set_t*) apt_task_cpu_set_get(const apt_task_t *task);
+
 /**
  * Enable/disable auto ready mode.
  * @param task the task to set mode for
@@ -24,6 +24,7 @@
  * @brief Task Message Base Definition
  */ 
 
+#include <apr_time.h>
 #include "apt.h"
 
 APT_BEGIN_EXTERN_C
@@ -59,6 +60,8 @@ struct apt_task_msg_t {
 	int                  type;
 	/** Task msg sub type */
 	int                  sub_type;
+	/** Time the message is signalled at (0 if processed without being signalled) */
+	apr_time_t           signal_time;
 	/** Context specific data */
 	char                 data[1];
 };
@@ -67,7 +70,15 @@ struct apt_task_msg_t {
 /** Create pool of task messages with dynamic allocation of messages (no actual pool is created) */
 APT_DECLARE(apt_task_msg_pool_t*) apt_task_msg_pool_create_dynamic(apr_size_t msg_size, apr_pool_t *pool);
 
-/** Create pool of task messages with static allocation of messages */
+/**
+ * Create pool of task messages with static allocation of messages.
+ * @param msg_size the size of context specific data of a message
+ * @param msg_pool_size the number of messages to preallocate [1..65534]
+ * @param pool the pool to allocate the messages from
+ * @remark Messages are taken from a lock-free free list, released ones are kept,
+ *         in a small cache of the releasing thread first. Messages are allocated
+ *         dynamically, while all the preallocated ones are in use.
+ */
 APT_DECLARE(apt_task_msg_pool_t*) apt_task_msg_pool_create_static(apr_size_t msg_size, apr_size_t msg_pool_size, apr_pool_t *pool);
 
 /** Destroy pool of task messages */
@@ -24,6 +24,7 @@
  * @brief Test Suite and Framework Definitions
  */ 
 
+#include <apr_file_io.h>
 #include "apt_string.h"
 
 APT_BEGIN_EXTERN_C
@@ -45,6 +46,8 @@ struct apt_test_suite_t {
 	void       *obj;
 	/** Test function to execute */
 	apt_test_f  tester;
+	/** File to write the results to (NULL if not requested) */
+	apr_file_t *result_file;
 };
 
 /**
@@ -57,6 +60,19 @@ struct apt_test_suite_t {
 APT_DECLARE(apt_test_suite_t*) apt_test_suite_create(apr_pool_t *pool, const char *name, 
                                                      void *obj, apt_test_f tester);
 
+/**
+ * Add result of test suite, such as throughput or latency of benchmark.
+ * @param suite the test suite the result is of
+ * @param name the name of the measured operation
+ * @param metric the name of the metric (e.g. "throughput", "p99")
+ * @param value the measured value
+ * @param unit the unit of the value, values of units ending in "/s" are the higher the better,
+ *             the others are the lower the better
+ * @remark The results are written, if the framework is run with "--results <file>",
+ *         as a line of tab separated suite, name, metric, value and unit per result.
+ */
+APT_DECLARE(void) apt_test_result_add(apt_test_suite_t *suite, const char *name, const char *metric, double value, const char *unit);
+
 
 
 
@@ -87,6 +103,8 @@ APT_DECLARE(apt_bool_t) apt_test_framework_suite_add(apt_test_framework_t *frame
  * @param framework the test framework
  * @param argc the number of arguments
  * @param argv the array of arguments
+ * @remark The arguments are [--results <file>] [suite [suite arguments]],
+ *         the results of the suites and their status are appended to the file.
  */
 APT_DECLARE(apt_bool_t) apt_test_framework_run(apt_test_framework_t *framework, int argc, const char * const *argv);
 
@@ -62,6 +62,25 @@ APT_DECLARE(void*) apt_message_parser_object_get(apt_message_parser_t *parser);
 /** Set verbose mode for the parser */
 APT_DECLARE(void) apt_message_parser_verbose_set(apt_message_parser_t *parser, apt_bool_t verbose);
 
+/**
+ * Set zero-copy mode for the parser.
+ * @param parser the parser to set the mode for
+ * @param zero_copy whether to reference parsed data in the stream or not
+ * @remark Names and values of header fields as well as bodies, which are entirely
+ * available in the stream, are referenced rather than copied. They are terminated
+ * in place, therefore the data of the stream must be followed by '\0'.
+ * Once parsed messages reference the stream (see apt_message_parser_stream_pinned()),
+ * the buffer of the stream must not be overwritten while the messages are in use.
+ */
+APT_DECLARE(void) apt_message_parser_zero_copy_set(apt_message_parser_t *parser, apt_bool_t zero_copy);
+
+/**
+ * Check whether messages parsed since the last check reference the buffer of the stream.
+ * @param parser the parser to check
+ * @return TRUE if the buffer is referenced and must not be scrolled (see apt_text_stream_relocate())
+ */
+APT_DECLARE(apt_bool_t) apt_message_parser_stream_pinned(apt_message_parser_t *parser);
+
 
 /** Create message generator */
 APT_DECLARE(apt_message_generator_t*) apt_message_generator_create(void *obj, const apt_message_generator_vtable_t *vtable, apr_pool_t *pool);
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef APT_TEXT_SCAN_H
+#define APT_TEXT_SCAN_H
+
+/**
+ * @file apt_text_scan.h
+ * @brief Vectorized Delimiter Scanners of Text Stream
+ */
+
+#include "apt.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Instruction set text scanners are implemented with */
+typedef enum {
+	APT_TEXT_SCANNER_SCALAR, /**< portable byte by byte search */
+	APT_TEXT_SCANNER_SSE2,   /**< x86 SSE2 */
+	APT_TEXT_SCANNER_AVX2,   /**< x86 AVX2 */
+	APT_TEXT_SCANNER_NEON,   /**< ARM NEON */
+
+	APT_TEXT_SCANNER_COUNT
+} apt_text_scanner_e;
+
+/**
+ * Find the first occurrence of any of three chars (memchr-style).
+ * @param pos the position to start the search from
+ * @param end the end of the data (not inspected)
+ * @return the position of the first matching char or end, if there is none
+ */
+typedef const char* (*apt_text_chr3_find_f)(const char *pos, const char *end, char c1, char c2, char c3);
+
+/** Declaration of text scanner */
+typedef struct apt_text_scanner_t apt_text_scanner_t;
+
+/** Text scanner (results are identical across all scanners) */
+struct apt_text_scanner_t {
+	/** Instruction set */
+	apt_text_scanner_e   type;
+	/** Name used in logs and benchmarks */
+	const char          *name;
+	/** Delimiter set search */
+	apt_text_chr3_find_f chr3_find;
+};
+
+/**
+ * Get the scanner of the specified instruction set.
+ * @param type the instruction set
+ * @return NULL if the scanner is not compiled in or not supported by the CPU
+ */
+APT_DECLARE(const apt_text_scanner_t*) apt_text_scanner_get(apt_text_scanner_e type);
+
+/**
+ * Get the fastest scanner supported by the CPU (detected once).
+ */
+APT_DECLARE(const apt_text_scanner_t*) apt_text_scanner_best_get(void);
+
+/**
+ * Get the scanner used by the line and header readers of text stream.
+ */
+APT_DECLARE(const apt_text_scanner_t*) apt_text_scanner_active_get(void);
+
+/**
+ * Select the scanner used by the line and header readers of text stream.
+ * @param scanner the scanner to use or NULL for the fastest one
+ * @remark Intended for benchmarks and tests, to be called before any parsing starts.
+ */
+APT_DECLARE(void) apt_text_scanner_select(const apt_text_scanner_t *scanner);
+
+APT_END_EXTERN_C
+
+#endif /* APT_TEXT_SCAN_H */
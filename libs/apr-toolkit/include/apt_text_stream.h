@@ -102,6 +102,31 @@ APT_DECLARE(apt_bool_t) apt_boolean_value_parse(const apt_str_t *str, apt_bool_t
 /** Generate apr_size_t value from pool (buffer is allocated from pool) */
 APT_DECLARE(apt_bool_t) apt_boolean_value_generate(apt_bool_t value, apt_str_t *str, apr_pool_t *pool);
 
+/** Max number of characters apt_uint64_value_format() writes */
+#define APT_UINT64_VALUE_MAX_LENGTH 20
+/** Max number of characters apt_float_value_format() writes */
+#define APT_FLOAT_VALUE_MAX_LENGTH  48
+
+/**
+ * Parse unsigned decimal value, bounded by the length of the string.
+ * @param str the string to parse
+ */
+APT_DECLARE(apr_uint64_t) apt_uint64_value_parse(const apt_str_t *str);
+/**
+ * Format unsigned decimal value.
+ * @param value the value to format
+ * @param buf the buffer of at least APT_UINT64_VALUE_MAX_LENGTH characters to write to
+ * @return the number of characters written (not null-terminated)
+ */
+APT_DECLARE(apr_size_t) apt_uint64_value_format(apr_uint64_t value, char *buf);
+/**
+ * Format float value with 6 digits of precision, trailing zeros removed (e.g. "0.5").
+ * @param value the value to format
+ * @param buf the buffer of at least APT_FLOAT_VALUE_MAX_LENGTH characters to write to
+ * @return the number of characters written (not null-terminated)
+ */
+APT_DECLARE(apr_size_t) apt_float_value_format(float value, char *buf);
+
 /** Parse apr_size_t value */
 APT_DECLARE(apr_size_t) apt_size_value_parse(const apt_str_t *str);
 /** Generate apr_size_t value from pool (buffer is allocated from pool) */
@@ -216,6 +241,15 @@ static APR_INLINE apt_bool_t apt_text_is_eos(const apt_text_stream_t *stream)
 /** Scroll text stream */
 APT_DECLARE(apt_bool_t) apt_text_stream_scroll(apt_text_stream_t *stream);
 
+/**
+ * Move the remaining data of text stream to another buffer, leaving the current one intact.
+ * @param stream the stream to relocate
+ * @param buffer the buffer to move the remaining data to (size + 1 bytes)
+ * @param size the size of the buffer
+ * @remark Used instead of scrolling, while the current buffer is referenced by parsed data.
+ */
+APT_DECLARE(apt_bool_t) apt_text_stream_relocate(apt_text_stream_t *stream, char *buffer, apr_size_t size);
+
 /** Parse id at resource string */
 APT_DECLARE(apt_bool_t) apt_id_resource_parse(const apt_str_t *str, char separator, apt_str_t *id, apt_str_t *resource, apr_pool_t *pool);
 /** Generate id at resource string */
@@ -232,6 +266,8 @@ APT_DECLARE(apt_bool_t) apt_completion_cause_generate(const apt_str_table_item_t
  * @param id the id to generate
  * @param length the length of hex string to generate
  * @param pool the pool to allocate memory from
+ * @remark The generator is seeded by a UUID once per thread; identifiers
+ *         are then made of a counter mixed with the seed, without locking.
  */
 APT_DECLARE(apt_bool_t) apt_unique_id_generate(apt_str_t *id, apr_size_t length, apr_pool_t *pool);
 
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#ifndef APT_TOKEN_BUCKET_H
+#define APT_TOKEN_BUCKET_H
+
+/**
+ * @file apt_token_bucket.h
+ * @brief Token Bucket Rate Limiter
+ */
+
+#include "apt.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Opaque token bucket declaration */
+typedef struct apt_token_bucket_t apt_token_bucket_t;
+
+/**
+ * Create token bucket.
+ * @param rate the number of tokens the bucket is refilled with per second
+ * @param burst the max number of tokens the bucket holds (0 - as many as the rate)
+ * @param pool the pool to allocate memory from
+ * @remark The bucket is created full and runs on the process-wide clock.
+ *         Tokens may be taken by several threads.
+ */
+APT_DECLARE(apt_token_bucket_t*) apt_token_bucket_create(apr_size_t rate, apr_size_t burst, apr_pool_t *pool);
+
+/**
+ * Take a token from the bucket.
+ * @param bucket the bucket to take a token from
+ * @return FALSE if the bucket is empty, that is the rate is exceeded
+ */
+APT_DECLARE(apt_bool_t) apt_token_bucket_take(apt_token_bucket_t *bucket);
+
+/** Get the number of whole tokens left in the bucket */
+APT_DECLARE(apr_size_t) apt_token_bucket_level_get(apt_token_bucket_t *bucket);
+
+/** Destroy token bucket */
+APT_DECLARE(void) apt_token_bucket_destroy(apt_token_bucket_t *bucket);
+
+APT_END_EXTERN_C
+
+#endif /* APT_TOKEN_BUCKET_H */
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#include "apt_clock.h"
+
+/** Real time a blocking wait lasts at most for, while the simulated clock stands still (usec) */
+#define SIM_CLOCK_WAIT_SLICE 1000
+
+/** Process-wide clock, NULL - wall clock */
+static apt_clock_t *active_clock = NULL;
+
+typedef struct apt_sim_clock_t apt_sim_clock_t;
+
+/** Simulated clock */
+struct apt_sim_clock_t {
+	apt_clock_t          base;
+	apr_uint32_t         rate;
+	/** Wall-clock time the clock is started at */
+	apr_time_t           start_time;
+	/** Current time, while the clock stands still */
+	apr_time_t           cur_time;
+	apr_thread_mutex_t  *mutex;
+	apr_thread_cond_t   *cond;
+};
+
+APT_DECLARE(void) apt_clock_set(apt_clock_t *clock)
+{
+	active_clock = clock;
+}
+
+APT_DECLARE(apt_clock_t*) apt_clock_get(void)
+{
+	return active_clock;
+}
+
+APT_DECLARE(apr_time_t) apt_clock_now(void)
+{
+	apt_clock_t *clock = active_clock;
+	if(!clock) {
+		return apr_time_now();
+	}
+	return clock->vtable->now(clock);
+}
+
+APT_DECLARE(void) apt_clock_sleep(apr_interval_time_t interval)
+{
+	apt_clock_t *clock = active_clock;
+	if(!clock) {
+		apr_sleep(interval);
+		return;
+	}
+	clock->vtable->sleep(clock,interval);
+}
+
+APT_DECLARE(apr_interval_time_t) apt_clock_wait_timeout_get(apr_interval_time_t timeout)
+{
+	apt_clock_t *clock = active_clock;
+	if(!clock || timeout < 0) {
+		return timeout;
+	}
+	return clock->vtable->wait_timeout_get(clock,timeout);
+}
+
+static apr_time_t apt_sim_clock_now(apt_clock_t *base)
+{
+	apt_sim_clock_t *clock = base->obj;
+	apr_time_t time_now;
+	if(clock->rate) {
+		return clock->start_time + (apr_time_now() - clock->start_time) * clock->rate;
+	}
+
+	apr_thread_mutex_lock(clock->mutex);
+	time_now = clock->cur_time;
+	apr_thread_mutex_unlock(clock->mutex);
+	return time_now;
+}
+
+static void apt_sim_clock_sleep(apt_clock_t *base, apr_interval_time_t interval)
+{
+	apt_sim_clock_t *clock = base->obj;
+	apr_time_t deadline;
+	if(clock->rate) {
+		apr_sleep(interval / clock->rate);
+		return;
+	}
+
+	apr_thread_mutex_lock(clock->mutex);
+	deadline = clock->cur_time + interval;
+	while(clock->cur_time < deadline) {
+		apr_thread_cond_wait(clock->cond,clock->mutex);
+	}
+	apr_thread_mutex_unlock(clock->mutex);
+}
+
+static apr_interval_time_t apt_sim_clock_wait_timeout_get(apt_clock_t *base, apr_interval_time_t timeout)
+{
+	apt_sim_clock_t *clock = base->obj;
+	if(clock->rate) {
+		return timeout / clock->rate;
+	}
+	/* the clock is advanced by another thread, which a wait cannot be woken up by,
+	so wait for a short slice and check the timers again */
+	return timeout < SIM_CLOCK_WAIT_SLICE ? timeout : SIM_CLOCK_WAIT_SLICE;
+}
+
+static const apt_clock_vtable_t sim_clock_vtable = {
+	apt_sim_clock_now,
+	apt_sim_clock_sleep,
+	apt_sim_clock_wait_timeout_get
+};
+
+APT_DECLARE(apt_clock_t*) apt_sim_clock_create(apr_uint32_t rate, apr_pool_t *pool)
+{
+	apt_sim_clock_t *clock = apr_palloc(pool,sizeof(apt_sim_clock_t));
+	clock->base.vtable = &sim_clock_vtable;
+	clock->base.obj = clock;
+	clock->rate = rate;
+	clock->start_time = apr_time_now();
+	clock->cur_time = clock->start_time;
+	clock->mutex = NULL;
+	clock->cond = NULL;
+	if(apr_thread_mutex_create(&clock->mutex,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	if(apr_thread_cond_create(&clock->cond,pool) != APR_SUCCESS) {
+		apr_thread_mutex_destroy(clock->mutex);
+		return NULL;
+	}
+	return &clock->base;
+}
+
+APT_DECLARE(apt_bool_t) apt_sim_clock_advance(apt_clock_t *base, apr_interval_time_t interval)
+{
+	apt_sim_clock_t *clock;
+	if(!base || base->vtable != &sim_clock_vtable || interval < 0) {
+		return FALSE;
+	}
+	clock = base->obj;
+	if(clock->rate) {
+		return FALSE;
+	}
+
+	apr_thread_mutex_lock(clock->mutex);
+	clock->cur_time += interval;
+	apr_thread_cond_broadcast(clock->cond);
+	apr_thread_mutex_unlock(clock->mutex);
+	return TRUE;
+}
+
+APT_DECLARE(void) apt_sim_clock_destroy(apt_clock_t *base)
+{
+	apt_sim_clock_t *clock;
+	if(!base || base->vtable != &sim_clock_vtable) {
+		return;
+	}
+	clock = base->obj;
+	if(active_clock == base) {
+		active_clock = NULL;
+	}
+	apr_thread_cond_destroy(clock->cond);
+	apr_thread_mutex_destroy(clock->mutex);
+}
@@ -18,9 +18,23 @@
 
 #include <apr_time.h>
 #include <apr_queue.h>
+#include <apr_thread_proc.h>
 #include "apt_consumer_task.h"
+#include "apt_clock.h"
 #include "apt_log.h"
 
+#define CONSUMER_QUEUE_SIZE 1024
+
+typedef struct apt_consumer_worker_t apt_consumer_worker_t;
+
+/** Additional worker, which processes messages of its own queue */
+struct apt_consumer_worker_t {
+	apt_consumer_task_t *consumer_task;
+	apr_queue_t         *msg_queue;
+	apr_thread_t        *thread;
+	apr_size_t           id;
+};
+
 struct apt_consumer_task_t {
 	void              *obj;
 	apt_task_t        *base;
@@ -28,6 +42,14 @@ struct apt_consumer_task_t {
 #if APR_HAS_QUEUE_TIMEOUT
 	apt_timer_queue_t *timer_queue;
 #endif
+
+	/** Total number of workers including the task thread itself */
+	apr_size_t                   worker_count;
+	/** Additional workers [worker_count - 1] */
+	apt_consumer_worker_t       *workers;
+	/** Handler of message affinity */
+	apt_consumer_task_affinity_f affinity_handler;
+	apr_pool_t                  *pool;
 };
 
 static apt_bool_t apt_consumer_task_msg_signal(apt_task_t *task, apt_task_msg_t *msg);
@@ -42,7 +64,11 @@ APT_DECLARE(apt_consumer_task_t*) apt_consumer_task_create(
 	apt_consumer_task_t *consumer_task = apr_palloc(pool,sizeof(apt_consumer_task_t));
 	consumer_task->obj = obj;
 	consumer_task->msg_queue = NULL;
-	if(apr_queue_create(&consumer_task->msg_queue,1024,pool) != APR_SUCCESS) {
+	consumer_task->worker_count = 1;
+	consumer_task->workers = NULL;
+	consumer_task->affinity_handler = NULL;
+	consumer_task->pool = pool;
+	if(apr_queue_create(&consumer_task->msg_queue,CONSUMER_QUEUE_SIZE,pool) != APR_SUCCESS) {
 		return NULL;
 	}
 	
@@ -92,10 +118,147 @@ APT_DECLARE(apt_timer_t*) apt_consumer_task_timer_create(
 #endif
 }
 
+APT_DECLARE(apt_bool_t) apt_consumer_task_workers_set(
+									apt_consumer_task_t *task,
+									apr_size_t count,
+									apt_consumer_task_affinity_f handler)
+{
+	apr_size_t i;
+	apt_consumer_worker_t *worker;
+	if(task->workers || !count || (count > 1 && !handler)) {
+		return FALSE;
+	}
+	if(count == 1) {
+		return TRUE;
+	}
+
+	task->workers = apr_palloc(task->pool,sizeof(apt_consumer_worker_t) * (count - 1));
+	for(i=0; i<count-1; i++) {
+		worker = &task->workers[i];
+		worker->consumer_task = task;
+		worker->thread = NULL;
+		worker->id = i + 1;
+		worker->msg_queue = NULL;
+		if(apr_queue_create(&worker->msg_queue,CONSUMER_QUEUE_SIZE,task->pool) != APR_SUCCESS) {
+			task->workers = NULL;
+			return FALSE;
+		}
+	}
+	task->worker_count = count;
+	task->affinity_handler = handler;
+	return TRUE;
+}
+
+APT_DECLARE(apr_size_t) apt_consumer_task_queue_depth_get(const apt_consumer_task_t *task)
+{
+	apr_size_t i;
+	apr_size_t depth;
+	apr_size_t max_depth = apr_queue_size(task->msg_queue);
+	for(i=0; i<task->worker_count-1; i++) {
+		depth = apr_queue_size(task->workers[i].msg_queue);
+		if(depth > max_depth) {
+			max_depth = depth;
+		}
+	}
+	return max_depth;
+}
+
+static APR_INLINE apr_queue_t* apt_consumer_task_queue_select(apt_consumer_task_t *consumer_task, apt_task_msg_t *msg)
+{
+	apr_size_t key;
+	apr_uint32_t hash;
+	if(consumer_task->worker_count == 1 || msg->type == TASK_MSG_CORE) {
+		return consumer_task->msg_queue;
+	}
+
+	key = consumer_task->affinity_handler(consumer_task,msg);
+	if(!key) {
+		return consumer_task->msg_queue;
+	}
+
+	/* keys are mostly aligned pointers, mix the bits before taking the modulo */
+	hash = (apr_uint32_t)(key >> 3) * 0x9E3779B1;
+	hash = (hash >> 16) % consumer_task->worker_count;
+	if(!hash) {
+		return consumer_task->msg_queue;
+	}
+	return consumer_task->workers[hash - 1].msg_queue;
+}
+
 static apt_bool_t apt_consumer_task_msg_signal(apt_task_t *task, apt_task_msg_t *msg)
 {
 	apt_consumer_task_t *consumer_task = apt_task_object_get(task);
-	return (apr_queue_push(consumer_task->msg_queue,msg) == APR_SUCCESS) ? TRUE : FALSE;
+	apr_queue_t *msg_queue = apt_consumer_task_queue_select(consumer_task,msg);
+	return (apr_queue_push(msg_queue,msg) == APR_SUCCESS) ? TRUE : FALSE;
+}
+
+static void* APR_THREAD_FUNC apt_consumer_worker_run(apr_thread_t *thread, void *data)
+{
+	apr_status_t rv;
+	void *msg;
+	apt_consumer_worker_t *worker = data;
+	apt_consumer_task_t *consumer_task = worker->consumer_task;
+	const char *task_name = apt_task_name_get(consumer_task->base);
+	const apt_cpu_set_t *cpu_set = apt_task_cpu_set_get(consumer_task->base);
+
+	if(cpu_set) {
+		apt_cpu_set_thread_bind(cpu_set);
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Run Worker [%s] [%"APR_SIZE_T_FMT"]",task_name,worker->id);
+	for(;;) {
+		rv = apr_queue_pop(worker->msg_queue,&msg);
+		if(rv == APR_SUCCESS) {
+			if(!msg) {
+				/* stop marker, all the messages signalled before have been processed */
+				break;
+			}
+			apt_task_msg_process(consumer_task->base,msg);
+		}
+		else if(rv == APR_EOF) {
+			break;
+		}
+		else if(rv != APR_EINTR) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Pop Message [%s] [%"APR_SIZE_T_FMT"] status: %d",
+				task_name,worker->id,rv);
+		}
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Exit Worker [%s] [%"APR_SIZE_T_FMT"]",task_name,worker->id);
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+static void apt_consumer_workers_start(apt_consumer_task_t *consumer_task)
+{
+	apr_size_t i;
+	apt_consumer_worker_t *worker;
+	for(i=0; i<consumer_task->worker_count-1; i++) {
+		worker = &consumer_task->workers[i];
+		if(apr_thread_create(&worker->thread,NULL,apt_consumer_worker_run,worker,consumer_task->pool) != APR_SUCCESS) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Worker [%s] [%"APR_SIZE_T_FMT"]",
+				apt_task_name_get(consumer_task->base),worker->id);
+			worker->thread = NULL;
+		}
+	}
+}
+
+static void apt_consumer_workers_stop(apt_consumer_task_t *consumer_task)
+{
+	apr_size_t i;
+	apr_status_t rv;
+	apt_consumer_worker_t *worker;
+	for(i=0; i<consumer_task->worker_count-1; i++) {
+		worker = &consumer_task->workers[i];
+		if(!worker->thread) {
+			continue;
+		}
+		/* let the worker drain its queue first */
+		if(apr_queue_push(worker->msg_queue,NULL) != APR_SUCCESS) {
+			apr_queue_term(worker->msg_queue);
+		}
+		apr_thread_join(&rv,worker->thread);
+		worker->thread = NULL;
+	}
 }
 
 static apt_bool_t apt_consumer_task_run(apt_task_t *task)
@@ -122,11 +285,12 @@ static apt_bool_t apt_consumer_task_run(apt_task_t *task)
 		return FALSE;
 	}
 
+	apt_consumer_workers_start(consumer_task);
 	while(*running) {
 #if APR_HAS_QUEUE_TIMEOUT
 		if(apt_timer_queue_timeout_get(consumer_task->timer_queue,&queue_timeout) == TRUE) {
-			timeout = (apr_interval_time_t)queue_timeout * 1000;
-			time_last = apr_time_now();
+			timeout = apt_clock_wait_timeout_get((apr_interval_time_t)queue_timeout * 1000);
+			time_last = apt_clock_now();
 			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Wait for Messages [%s] timeout [%u]",
 				task_name, queue_timeout);
 			rv = apr_queue_timedpop(consumer_task->msg_queue,timeout,&msg);
@@ -153,12 +317,13 @@ static apt_bool_t apt_consumer_task_run(apt_task_t *task)
 
 #if APR_HAS_QUEUE_TIMEOUT
 		if(timeout != -1) {
-			time_now = apr_time_now();
+			time_now = apt_clock_now();
 			if(time_now > time_last) {
 				apt_timer_queue_advance(consumer_task->timer_queue,(apr_uint32_t)((time_now - time_last)/1000));
 			}
 		}
 #endif
 	}
+	apt_consumer_workers_stop(consumer_task);
 	return TRUE;
 }
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+/* required for CPU affinity macros */
+#define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <apr_file_io.h>
+#include <apr_strings.h>
+#include "apt_cpu_set.h"
+#include "apt_log.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#elif defined(WIN32)
+#include <windows.h>
+#endif
+
+/** Prefix of NUMA node */
+#define CPU_SET_NODE_PREFIX "node:"
+
+APT_DECLARE(void) apt_cpu_set_clear(apt_cpu_set_t *set)
+{
+	memset(set->bits,0,sizeof(set->bits));
+}
+
+APT_DECLARE(apt_bool_t) apt_cpu_set_add(apt_cpu_set_t *set, int cpu)
+{
+	if(cpu < 0 || cpu >= APT_CPU_SET_MAX_SIZE) {
+		return FALSE;
+	}
+	set->bits[cpu / 32] |= (apr_uint32_t)1 << (cpu % 32);
+	return TRUE;
+}
+
+APT_DECLARE(apt_bool_t) apt_cpu_set_contains(const apt_cpu_set_t *set, int cpu)
+{
+	if(cpu < 0 || cpu >= APT_CPU_SET_MAX_SIZE) {
+		return FALSE;
+	}
+	return (set->bits[cpu / 32] & ((apr_uint32_t)1 << (cpu % 32))) ? TRUE : FALSE;
+}
+
+APT_DECLARE(apr_size_t) apt_cpu_set_count_get(const apt_cpu_set_t *set)
+{
+	apr_size_t count = 0;
+	int cpu;
+	for(cpu=0; cpu<APT_CPU_SET_MAX_SIZE; cpu++) {
+		if(apt_cpu_set_contains(set,cpu) == TRUE) {
+			count++;
+		}
+	}
+	return count;
+}
+
+/** Parse the list of CPUs and ranges (e.g. "0-3,8"), as also used by sysfs */
+static apt_bool_t apt_cpu_set_list_parse(apt_cpu_set_t *set, const char *str)
+{
+	const char *pos = str;
+	char *end;
+	long first;
+	long last;
+	apt_bool_t status = FALSE;
+
+	while(*pos) {
+		while(*pos == ' ' || *pos == ',' || *pos == '\n' || *pos == '\r') {
+			pos++;
+		}
+		if(*pos == '\0') {
+			break;
+		}
+		first = strtol(pos,&end,10);
+		if(end == pos) {
+			return FALSE;
+		}
+		last = first;
+		pos = end;
+		if(*pos == '-') {
+			pos++;
+			last = strtol(pos,&end,10);
+			if(end == pos || last < first) {
+				return FALSE;
+			}
+			pos = end;
+		}
+		for(; first <= last; first++) {
+			if(apt_cpu_set_add(set,(int)first) == FALSE) {
+				return FALSE;
+			}
+		}
+		status = TRUE;
+	}
+	return status;
+}
+
+/** Load the CPUs of NUMA node */
+static apt_bool_t apt_cpu_set_node_load(apt_cpu_set_t *set, int node, apr_pool_t *pool)
+{
+#ifdef __linux__
+	char buf[1024];
+	apr_file_t *file;
+	const char *file_path = apr_psprintf(pool,"/sys/devices/system/node/node%d/cpulist",node);
+	apt_bool_t status = FALSE;
+	if(apr_file_open(&file,file_path,APR_FOPEN_READ,APR_OS_DEFAULT,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open CPU List of NUMA Node [%s]",file_path);
+		return FALSE;
+	}
+	if(apr_file_gets(buf,sizeof(buf),file) == APR_SUCCESS) {
+		status = apt_cpu_set_list_parse(set,buf);
+	}
+	apr_file_close(file);
+	return status;
+#else
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"NUMA Node is not Supported [%d]",node);
+	return FALSE;
+#endif
+}
+
+APT_DECLARE(apt_bool_t) apt_cpu_set_parse(apt_cpu_set_t *set, const char *str, apr_pool_t *pool)
+{
+	apt_cpu_set_clear(set);
+	if(!str) {
+		return FALSE;
+	}
+	if(strncasecmp(str,CPU_SET_NODE_PREFIX,sizeof(CPU_SET_NODE_PREFIX) - 1) == 0) {
+		const char *node = str + sizeof(CPU_SET_NODE_PREFIX) - 1;
+		if(*node < '0' || *node > '9') {
+			return FALSE;
+		}
+		return apt_cpu_set_node_load(set,atoi(node),pool);
+	}
+	return apt_cpu_set_list_parse(set,str);
+}
+
+APT_DECLARE(apt_bool_t) apt_cpu_set_thread_bind(const apt_cpu_set_t *set)
+{
+#ifdef __linux__
+	cpu_set_t cpu_set;
+	int cpu;
+	CPU_ZERO(&cpu_set);
+	for(cpu=0; cpu<APT_CPU_SET_MAX_SIZE && cpu<CPU_SETSIZE; cpu++) {
+		if(apt_cpu_set_contains(set,cpu) == TRUE) {
+			CPU_SET(cpu,&cpu_set);
+		}
+	}
+	if(pthread_setaffinity_np(pthread_self(),sizeof(cpu_set),&cpu_set) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Bind Thread to [%"APR_SIZE_T_FMT"] CPUs",apt_cpu_set_count_get(set));
+		return FALSE;
+	}
+	return TRUE;
+#elif defined(WIN32)
+	DWORD_PTR mask = 0;
+	int cpu;
+	for(cpu=0; cpu<(int)sizeof(mask)*8; cpu++) {
+		if(apt_cpu_set_contains(set,cpu) == TRUE) {
+			mask |= (DWORD_PTR)1 << cpu;
+		}
+	}
+	if(!mask || SetThreadAffinityMask(GetCurrentThread(),mask) == 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Bind Thread to [%"APR_SIZE_T_FMT"] CPUs",apt_cpu_set_count_get(set));
+		return FALSE;
+	}
+	return TRUE;
+#else
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"CPU Affinity is not Supported");
+	return FALSE;
+#endif
+}
@@ -17,29 +17,54 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include "apt_cyclic_queue.h"
 
+/** 
+ * The capacity of the queue is always a power of two, so that positions
+ * wrap around by masking. A fixed queue is never resized, while a growable
+ * one doubles its capacity, when full.
+ */
 struct apt_cyclic_queue_t {
 	void       **data;
 	apr_size_t   max_size;
+	apr_size_t   mask;
 	apr_size_t   actual_size;
 	apr_size_t   head;
 	apr_size_t   tail;
+	apt_bool_t   fixed;
+	apr_size_t   overload_count;
 };
 
 static apt_bool_t apt_cyclic_queue_resize(apt_cyclic_queue_t *queue);
 
-
-APT_DECLARE(apt_cyclic_queue_t*) apt_cyclic_queue_create(apr_size_t size)
+static apt_cyclic_queue_t* apt_cyclic_queue_create_internal(apr_size_t size, apt_bool_t fixed)
 {
+	apr_size_t capacity = 2;
 	apt_cyclic_queue_t *queue = malloc(sizeof(apt_cyclic_queue_t));
-	queue->max_size = size;
+	while(capacity < size) {
+		capacity <<= 1;
+	}
+	queue->max_size = capacity;
+	queue->mask = capacity - 1;
 	queue->actual_size = 0;
 	queue->data = malloc(sizeof(void*) * queue->max_size);
 	queue->head = queue->tail = 0;
+	queue->fixed = fixed;
+	queue->overload_count = 0;
 	return queue;
 }
 
+APT_DECLARE(apt_cyclic_queue_t*) apt_cyclic_queue_create(apr_size_t size)
+{
+	return apt_cyclic_queue_create_internal(size,FALSE);
+}
+
+APT_DECLARE(apt_cyclic_queue_t*) apt_cyclic_queue_create_fixed(apr_size_t size)
+{
+	return apt_cyclic_queue_create_internal(size,TRUE);
+}
+
 APT_DECLARE(void) apt_cyclic_queue_destroy(apt_cyclic_queue_t *queue)
 {
 	if(queue->data) {
@@ -49,18 +74,31 @@ APT_DECLARE(void) apt_cyclic_queue_destroy(apt_cyclic_queue_t *queue)
 	free(queue);
 }
 
+APT_DECLARE(apt_cyclic_queue_push_status_e) apt_cyclic_queue_try_push(apt_cyclic_queue_t *queue, void *obj)
+{
+	if(queue->actual_size == queue->max_size) {
+		queue->overload_count++;
+		return CYCLIC_QUEUE_PUSH_FULL;
+	}
+
+	queue->data[queue->head] = obj;
+	queue->head = (queue->head + 1) & queue->mask;
+	queue->actual_size++;
+	if(queue->actual_size > queue->max_size - (queue->max_size >> 2)) {
+		return CYCLIC_QUEUE_PUSH_HIGH;
+	}
+	return CYCLIC_QUEUE_PUSH_OK;
+}
+
 APT_DECLARE(apt_bool_t) apt_cyclic_queue_push(apt_cyclic_queue_t *queue, void *obj)
 {
-	if(queue->actual_size >= queue->max_size) {
+	if(queue->actual_size >= queue->max_size && queue->fixed == FALSE) {
 		if(apt_cyclic_queue_resize(queue) != TRUE) {
 			return FALSE;
 		}
 	}
 	
-	queue->data[queue->head] = obj;
-	queue->head = (queue->head + 1) % queue->max_size;
-	queue->actual_size++;
-	return TRUE;
+	return (apt_cyclic_queue_try_push(queue,obj) != CYCLIC_QUEUE_PUSH_FULL) ? TRUE : FALSE;
 }
 
 APT_DECLARE(void*) apt_cyclic_queue_pop(apt_cyclic_queue_t *queue)
@@ -68,7 +106,7 @@ APT_DECLARE(void*) apt_cyclic_queue_pop(apt_cyclic_queue_t *queue)
 	void *obj = NULL;
 	if(queue->actual_size) {
 		obj = queue->data[queue->tail];
-		queue->tail = (queue->tail + 1) % queue->max_size;
+		queue->tail = (queue->tail + 1) & queue->mask;
 		queue->actual_size--;
 	}
 	return obj;
@@ -82,24 +120,44 @@ APT_DECLARE(void) apt_cyclic_queue_clear(apt_cyclic_queue_t *queue)
 
 APT_DECLARE(apt_bool_t) apt_cyclic_queue_is_empty(const apt_cyclic_queue_t *queue)
 {
-	return queue->actual_size ? TRUE : FALSE;
+	return queue->actual_size ? FALSE : TRUE;
+}
+
+APT_DECLARE(apr_size_t) apt_cyclic_queue_size_get(const apt_cyclic_queue_t *queue)
+{
+	return queue->actual_size;
+}
+
+APT_DECLARE(apr_size_t) apt_cyclic_queue_capacity_get(const apt_cyclic_queue_t *queue)
+{
+	return queue->max_size;
+}
+
+APT_DECLARE(apr_size_t) apt_cyclic_queue_overload_count_get(const apt_cyclic_queue_t *queue)
+{
+	return queue->overload_count;
 }
 
 static apt_bool_t apt_cyclic_queue_resize(apt_cyclic_queue_t *queue)
 {
-	apr_size_t new_size = queue->max_size + queue->max_size/2;
+	apr_size_t new_size = queue->max_size << 1;
 	void **new_data = malloc(sizeof(void*) * new_size);
 	apr_size_t offset;
+	if(!new_data) {
+		return FALSE;
+	}
 
-	offset = queue->max_size - queue->head;
-	memcpy(new_data, queue->data + queue->head, sizeof(void*) * offset);
-	if(queue->head) {
-		memcpy(new_data + offset, queue->data, sizeof(void*) * queue->head);
+	/* the queue is full, elements start at the tail and wrap around to it */
+	offset = queue->max_size - queue->tail;
+	memcpy(new_data, queue->data + queue->tail, sizeof(void*) * offset);
+	if(queue->tail) {
+		memcpy(new_data + offset, queue->data, sizeof(void*) * queue->tail);
 	}
 
 	queue->tail = 0;
 	queue->head = queue->max_size;
 	queue->max_size = new_size;
+	queue->mask = new_size - 1;
 	free(queue->data);
 	queue->data = new_data;
 	return TRUE;
@@ -0,0 +1,448 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+
+#include <apr_ring.h>
+#include <apr_atomic.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#include "apt_executor.h"
+#include "apt_log.h"
+
+/** Max number of jobs a strand runs at once before it yields to other strands */
+#define EXECUTOR_STRAND_BATCH 16
+
+typedef struct apt_executor_job_t apt_executor_job_t;
+typedef struct apt_executor_worker_t apt_executor_worker_t;
+
+/** Job submitted to strand */
+struct apt_executor_job_t {
+	apt_executor_job_f handler;
+	void              *obj;
+	void              *arg;
+};
+
+/** Strand, serial queue of jobs */
+struct apt_executor_strand_t {
+	/** Ring entry, while the strand is ready to run */
+	APR_RING_ENTRY(apt_executor_strand_t) link;
+
+	apt_executor_t      *executor;
+	apr_thread_mutex_t  *guard;
+	/** Condition signalled when the strand runs out of jobs */
+	apr_thread_cond_t   *idle_cond;
+
+	/** Cyclic array of pending jobs */
+	apt_executor_job_t  *jobs;
+	apr_size_t           size;
+	apr_size_t           head;
+	apr_size_t           count;
+
+	/** Is the strand either queued to or being run by a worker */
+	apt_bool_t           scheduled;
+};
+
+/** Worker thread with its own queue of ready strands */
+struct apt_executor_worker_t {
+	apt_executor_t      *executor;
+	apr_thread_mutex_t  *guard;
+	APR_RING_HEAD(apt_executor_strand_head_t, apt_executor_strand_t) ready;
+	apr_thread_t        *thread;
+	apr_size_t           id;
+};
+
+struct apt_executor_t {
+	apt_executor_worker_t *workers;
+	apr_size_t             thread_count;
+	/** Worker to queue strands scheduled out of executor threads to (round robin) */
+	volatile apr_uint32_t  next;
+	/** Number of queued ready strands */
+	volatile apr_uint32_t  pending;
+	/** Number of workers waiting for ready strands */
+	volatile apr_uint32_t  idle_count;
+	apr_thread_mutex_t    *idle_guard;
+	apr_thread_cond_t     *idle_cond;
+	apt_bool_t             running;
+	apt_bool_t             started;
+	/** Set of CPUs to bind the threads to (NULL if not bound) */
+	apt_cpu_set_t         *cpu_set;
+	apr_pool_t            *pool;
+};
+
+#ifdef APT_THREAD_LOCAL
+/** Worker the current thread belongs to */
+static APT_THREAD_LOCAL apt_executor_worker_t *current_worker = NULL;
+#endif
+
+/** Load with full barrier */
+static APR_INLINE apr_uint32_t apt_executor_load(volatile apr_uint32_t *mem)
+{
+	return apr_atomic_add32(mem,0);
+}
+
+static apt_bool_t apt_executor_workers_create(apt_executor_t *executor, apr_size_t thread_count)
+{
+	apr_size_t i;
+	apt_executor_worker_t *worker;
+	if(!thread_count) {
+		return FALSE;
+	}
+
+	executor->workers = apr_palloc(executor->pool,sizeof(apt_executor_worker_t) * thread_count);
+	for(i=0; i<thread_count; i++) {
+		worker = &executor->workers[i];
+		worker->executor = executor;
+		worker->guard = NULL;
+		worker->thread = NULL;
+		worker->id = i;
+		APR_RING_INIT(&worker->ready, apt_executor_strand_t, link);
+		if(apr_thread_mutex_create(&worker->guard,APR_THREAD_MUTEX_UNNESTED,executor->pool) != APR_SUCCESS) {
+			return FALSE;
+		}
+	}
+	executor->thread_count = thread_count;
+	return TRUE;
+}
+
+APT_DECLARE(apt_executor_t*) apt_executor_create(apr_size_t thread_count, apr_pool_t *pool)
+{
+	apt_executor_t *executor = apr_palloc(pool,sizeof(apt_executor_t));
+	executor->workers = NULL;
+	executor->thread_count = 0;
+	executor->next = 0;
+	executor->pending = 0;
+	executor->idle_count = 0;
+	executor->idle_guard = NULL;
+	executor->idle_cond = NULL;
+	executor->running = FALSE;
+	executor->started = FALSE;
+	executor->cpu_set = NULL;
+	executor->pool = pool;
+
+	if(apr_thread_mutex_create(&executor->idle_guard,APR_THREAD_MUTEX_UNNESTED,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	if(apr_thread_cond_create(&executor->idle_cond,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	if(apt_executor_workers_create(executor,thread_count) == FALSE) {
+		return NULL;
+	}
+	return executor;
+}
+
+APT_DECLARE(apt_bool_t) apt_executor_thread_count_set(apt_executor_t *executor, apr_size_t thread_count)
+{
+	apr_size_t i;
+	if(executor->started == TRUE || !thread_count) {
+		return FALSE;
+	}
+	for(i=0; i<executor->thread_count; i++) {
+		if(!APR_RING_EMPTY(&executor->workers[i].ready, apt_executor_strand_t, link)) {
+			/* strands have already been scheduled */
+			return FALSE;
+		}
+	}
+	if(thread_count == executor->thread_count) {
+		return TRUE;
+	}
+	for(i=0; i<executor->thread_count; i++) {
+		apr_thread_mutex_destroy(executor->workers[i].guard);
+	}
+	return apt_executor_workers_create(executor,thread_count);
+}
+
+APT_DECLARE(apt_bool_t) apt_executor_cpu_set_set(apt_executor_t *executor, const apt_cpu_set_t *cpu_set)
+{
+	if(executor->started == TRUE) {
+		return FALSE;
+	}
+	if(!cpu_set) {
+		executor->cpu_set = NULL;
+		return TRUE;
+	}
+	if(!executor->cpu_set) {
+		executor->cpu_set = apr_palloc(executor->pool,sizeof(apt_cpu_set_t));
+	}
+	*executor->cpu_set = *cpu_set;
+	return TRUE;
+}
+
+/** Queue ready strand to a worker */
+static void apt_executor_strand_schedule(apt_executor_t *executor, apt_executor_strand_t *strand)
+{
+	apt_executor_worker_t *worker = NULL;
+#ifdef APT_THREAD_LOCAL
+	/* keep the strand on the current thread, if possible, other workers steal it when idle */
+	if(current_worker && current_worker->executor == executor) {
+		worker = current_worker;
+	}
+#endif
+	if(!worker) {
+		worker = &executor->workers[apr_atomic_inc32(&executor->next) % executor->thread_count];
+	}
+
+	apr_atomic_inc32(&executor->pending);
+	apr_thread_mutex_lock(worker->guard);
+	APR_RING_INSERT_TAIL(&worker->ready, strand, apt_executor_strand_t, link);
+	apr_thread_mutex_unlock(worker->guard);
+
+	/* idle_count is incremented by a worker before it checks pending, so either side sees the other */
+	if(apt_executor_load(&executor->idle_count)) {
+		apr_thread_mutex_lock(executor->idle_guard);
+		apr_thread_cond_signal(executor->idle_cond);
+		apr_thread_mutex_unlock(executor->idle_guard);
+	}
+}
+
+/** Take ready strand from the own queue or steal one from the others */
+static apt_executor_strand_t* apt_executor_strand_take(apt_executor_worker_t *worker)
+{
+	apr_size_t i;
+	apt_executor_worker_t *victim;
+	apt_executor_strand_t *strand = NULL;
+	apt_executor_t *executor = worker->executor;
+
+	apr_thread_mutex_lock(worker->guard);
+	if(!APR_RING_EMPTY(&worker->ready, apt_executor_strand_t, link)) {
+		strand = APR_RING_FIRST(&worker->ready);
+		APR_RING_REMOVE(strand,link);
+	}
+	apr_thread_mutex_unlock(worker->guard);
+
+	for(i=1; !strand && i<executor->thread_count; i++) {
+		victim = &executor->workers[(worker->id + i) % executor->thread_count];
+		apr_thread_mutex_lock(victim->guard);
+		if(!APR_RING_EMPTY(&victim->ready, apt_executor_strand_t, link)) {
+			/* steal from the opposite end the owner takes strands from */
+			strand = APR_RING_LAST(&victim->ready);
+			APR_RING_REMOVE(strand,link);
+		}
+		apr_thread_mutex_unlock(victim->guard);
+	}
+
+	if(strand) {
+		apr_atomic_dec32(&executor->pending);
+	}
+	return strand;
+}
+
+/** Run a batch of jobs of the strand */
+static void apt_executor_strand_run(apt_executor_strand_t *strand)
+{
+	apr_size_t i;
+	apt_executor_job_t job;
+	apt_bool_t requeue = FALSE;
+
+	for(i=0; i<EXECUTOR_STRAND_BATCH; i++) {
+		apr_thread_mutex_lock(strand->guard);
+		if(!strand->count) {
+			strand->scheduled = FALSE;
+			apr_thread_cond_broadcast(strand->idle_cond);
+			apr_thread_mutex_unlock(strand->guard);
+			return;
+		}
+		job = strand->jobs[strand->head];
+		strand->head = (strand->head + 1) % strand->size;
+		strand->count--;
+		apr_thread_mutex_unlock(strand->guard);
+
+		job.handler(job.obj,job.arg);
+	}
+
+	apr_thread_mutex_lock(strand->guard);
+	if(strand->count) {
+		requeue = TRUE;
+	}
+	else {
+		strand->scheduled = FALSE;
+		apr_thread_cond_broadcast(strand->idle_cond);
+	}
+	apr_thread_mutex_unlock(strand->guard);
+
+	if(requeue == TRUE) {
+		/* let other strands run, the strand remains scheduled */
+		apt_executor_strand_schedule(strand->executor,strand);
+	}
+}
+
+static void* APR_THREAD_FUNC apt_executor_worker_run(apr_thread_t *thread, void *data)
+{
+	apt_executor_worker_t *worker = data;
+	apt_executor_t *executor = worker->executor;
+	apt_executor_strand_t *strand;
+	apt_bool_t stop;
+
+#ifdef APT_THREAD_LOCAL
+	current_worker = worker;
+#endif
+	if(executor->cpu_set) {
+		apt_cpu_set_thread_bind(executor->cpu_set);
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Run Executor Worker [%"APR_SIZE_T_FMT"]",worker->id);
+	for(;;) {
+		strand = apt_executor_strand_take(worker);
+		if(strand) {
+			apt_executor_strand_run(strand);
+			continue;
+		}
+
+		apr_thread_mutex_lock(executor->idle_guard);
+		apr_atomic_inc32(&executor->idle_count);
+		if(!apt_executor_load(&executor->pending) && executor->running == TRUE) {
+			apr_thread_cond_wait(executor->idle_cond,executor->idle_guard);
+		}
+		apr_atomic_dec32(&executor->idle_count);
+		stop = (executor->running == FALSE && !apt_executor_load(&executor->pending)) ? TRUE : FALSE;
+		apr_thread_mutex_unlock(executor->idle_guard);
+		if(stop == TRUE) {
+			break;
+		}
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Exit Executor Worker [%"APR_SIZE_T_FMT"]",worker->id);
+#ifdef APT_THREAD_LOCAL
+	current_worker = NULL;
+#endif
+
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+APT_DECLARE(apt_bool_t) apt_executor_start(apt_executor_t *executor)
+{
+	apr_size_t i;
+	apt_executor_worker_t *worker;
+	if(executor->started == TRUE) {
+		return FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Start Executor [%"APR_SIZE_T_FMT" threads]",executor->thread_count);
+	executor->running = TRUE;
+	executor->started = TRUE;
+	for(i=0; i<executor->thread_count; i++) {
+		worker = &executor->workers[i];
+		if(apr_thread_create(&worker->thread,NULL,apt_executor_worker_run,worker,executor->pool) != APR_SUCCESS) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Executor Worker [%"APR_SIZE_T_FMT"]",i);
+			worker->thread = NULL;
+		}
+	}
+	return TRUE;
+}
+
+APT_DECLARE(apt_bool_t) apt_executor_stop(apt_executor_t *executor)
+{
+	apr_size_t i;
+	apr_status_t rv;
+	apt_executor_worker_t *worker;
+	if(executor->started == FALSE) {
+		return FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Stop Executor");
+	apr_thread_mutex_lock(executor->idle_guard);
+	executor->running = FALSE;
+	apr_thread_cond_broadcast(executor->idle_cond);
+	apr_thread_mutex_unlock(executor->idle_guard);
+
+	for(i=0; i<executor->thread_count; i++) {
+		worker = &executor->workers[i];
+		if(worker->thread) {
+			apr_thread_join(&rv,worker->thread);
+			worker->thread = NULL;
+		}
+	}
+	executor->started = FALSE;
+	return TRUE;
+}
+
+APT_DECLARE(void) apt_executor_destroy(apt_executor_t *executor)
+{
+	apr_size_t i;
+	if(executor->started == TRUE) {
+		apt_executor_stop(executor);
+	}
+	for(i=0; i<executor->thread_count; i++) {
+		apr_thread_mutex_destroy(executor->workers[i].guard);
+	}
+	apr_thread_cond_destroy(executor->idle_cond);
+	apr_thread_mutex_destroy(executor->idle_guard);
+}
+
+APT_DECLARE(apt_executor_strand_t*) apt_executor_strand_create(apt_executor_t *executor, apr_size_t size, apr_pool_t *pool)
+{
+	apt_executor_strand_t *strand = apr_palloc(pool,sizeof(apt_executor_strand_t));
+	APR_RING_ELEM_INIT(strand,link);
+	strand->executor = executor;
+	strand->guard = NULL;
+	strand->idle_cond = NULL;
+	strand->size = size ? size : EXECUTOR_STRAND_DEFAULT_SIZE;
+	strand->jobs = apr_palloc(pool,sizeof(apt_executor_job_t) * strand->size);
+	strand->head = 0;
+	strand->count = 0;
+	strand->scheduled = FALSE;
+
+	if(apr_thread_mutex_create(&strand->guard,APR_THREAD_MUTEX_UNNESTED,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	if(apr_thread_cond_create(&strand->idle_cond,pool) != APR_SUCCESS) {
+		apr_thread_mutex_destroy(strand->guard);
+		return NULL;
+	}
+	return strand;
+}
+
+APT_DECLARE(void) apt_executor_strand_destroy(apt_executor_strand_t *strand)
+{
+	apr_thread_mutex_lock(strand->guard);
+	while(strand->scheduled == TRUE) {
+		apr_thread_cond_wait(strand->idle_cond,strand->guard);
+	}
+	apr_thread_mutex_unlock(strand->guard);
+
+	apr_thread_cond_destroy(strand->idle_cond);
+	apr_thread_mutex_destroy(strand->guard);
+}
+
+APT_DECLARE(apt_bool_t) apt_executor_job_submit(apt_executor_strand_t *strand, apt_executor_job_f handler, void *obj, void *arg)
+{
+	apt_executor_job_t *job;
+	apt_bool_t schedule = FALSE;
+
+	apr_thread_mutex_lock(strand->guard);
+	if(strand->count == strand->size) {
+		apr_thread_mutex_unlock(strand->guard);
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Submit Job: strand is full [%"APR_SIZE_T_FMT"]",strand->size);
+		return FALSE;
+	}
+	job = &strand->jobs[(strand->head + strand->count) % strand->size];
+	job->handler = handler;
+	job->obj = obj;
+	job->arg = arg;
+	strand->count++;
+	if(strand->scheduled == FALSE) {
+		strand->scheduled = TRUE;
+		schedule = TRUE;
+	}
+	apr_thread_mutex_unlock(strand->guard);
+
+	if(schedule == TRUE) {
+		apt_executor_strand_schedule(strand->executor,strand);
+	}
+	return TRUE;
+}
@@ -0,0 +1,407 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+/* O_DIRECT */
+#define _GNU_SOURCE
+#endif
+
+#include <apr_file_io.h>
+#include <apr_atomic.h>
+#include <apr_portable.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#include "apt_file_writer.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/** Alignment of blocks and of their sizes */
+#define APT_FILE_WRITER_ALIGNMENT 4096
+/** Max number of pending jobs (a flush and a close) */
+#define APT_FILE_WRITER_STRAND_SIZE 4
+
+/** File writer */
+struct apt_file_writer_t {
+	/** Strand to write blocks by (NULL for synchronous writes) */
+	apt_executor_strand_t *strand;
+	/** Page aligned blocks */
+	char                  *blocks;
+	/** Filled size of each published block */
+	apr_size_t            *sizes;
+	/** Size of a block */
+	apr_size_t             block_size;
+	/** Number of blocks */
+	apr_uint32_t           block_count;
+	/** Whether to bypass the page cache */
+	apt_bool_t             direct;
+
+	/** File to write to */
+	apr_file_t            *file;
+	/** Pool of the file, created on open and destroyed on close */
+	apr_pool_t            *file_pool;
+	/** Whether the file is still opened with O_DIRECT */
+	apt_bool_t             file_direct;
+	/** Encoder of the file (NULL to write data as is) */
+	apt_file_encoder_t    *encoder;
+
+	/** Filled size of the current block (producer) */
+	apr_size_t             fill;
+	/** Is file open (producer) */
+	apt_bool_t             is_open;
+
+	/** Separate producer and consumer positions to avoid false sharing */
+	char                   pad1[64];
+	/** Number of published blocks (advanced by producer) */
+	volatile apr_uint32_t  produced;
+	char                   pad2[64];
+	/** Number of written blocks (advanced by consumer) */
+	volatile apr_uint32_t  consumed;
+	/** Whether a flush job is pending */
+	volatile apr_uint32_t  flush_pending;
+	/** Whether a close job is pending */
+	volatile apr_uint32_t  closing;
+	/** Size of data dropped, as the ring was full */
+	volatile apr_uint32_t  dropped;
+
+	/** Guard of closing */
+	apr_thread_mutex_t    *guard;
+	/** Signaled, when the file is closed */
+	apr_thread_cond_t     *closed_cond;
+};
+
+/** Load with full barrier (acquire semantics) */
+static APR_INLINE apr_uint32_t apt_file_writer_load(volatile apr_uint32_t *mem)
+{
+	return apr_atomic_add32(mem,0);
+}
+
+static APR_INLINE char* apt_file_writer_block_get(apt_file_writer_t *writer, apr_uint32_t index)
+{
+	return writer->blocks + (apr_size_t)(index % writer->block_count) * writer->block_size;
+}
+
+/** Write block to disk (consumer) */
+static void apt_file_writer_block_write(apt_file_writer_t *writer, const char *data, apr_size_t size)
+{
+	if(!writer->file) {
+		return;
+	}
+#if defined(O_DIRECT)
+	if(writer->file_direct == TRUE && (size % APT_FILE_WRITER_ALIGNMENT)) {
+		/* the tail is not aligned, write it through the page cache */
+		apr_os_file_t fd;
+		if(apr_os_file_get(&fd,writer->file) == APR_SUCCESS) {
+			fcntl(fd,F_SETFL,fcntl(fd,F_GETFL) & ~O_DIRECT);
+		}
+		writer->file_direct = FALSE;
+	}
+#endif
+	if(writer->encoder) {
+		if(writer->encoder->vtable->write(writer->encoder,writer->file,data,size) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Encode %"APR_SIZE_T_FMT" bytes to File",size);
+		}
+		return;
+	}
+	if(apr_file_write_full(writer->file,data,size,NULL) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Write %"APR_SIZE_T_FMT" bytes to File",size);
+	}
+}
+
+/** Write all the published blocks (consumer) */
+static void apt_file_writer_drain(apt_file_writer_t *writer)
+{
+	apr_uint32_t consumed = writer->consumed;
+	apr_uint32_t produced = apt_file_writer_load(&writer->produced);
+	while(consumed != produced) {
+		apt_file_writer_block_write(
+			writer,
+			apt_file_writer_block_get(writer,consumed),
+			writer->sizes[consumed % writer->block_count]);
+		apr_atomic_inc32(&writer->consumed);
+		consumed++;
+		if(consumed == produced) {
+			produced = apt_file_writer_load(&writer->produced);
+		}
+	}
+}
+
+/** Close the file (consumer) */
+static void apt_file_writer_file_close(apt_file_writer_t *writer)
+{
+	apr_uint32_t dropped;
+	apt_file_writer_drain(writer);
+	dropped = apr_atomic_xchg32(&writer->dropped,0);
+	if(dropped) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Dropped %u bytes, as Disk Writes Lagged Behind",dropped);
+	}
+	if(writer->encoder) {
+		writer->encoder->vtable->close(writer->encoder,writer->file);
+		writer->encoder = NULL;
+	}
+	if(writer->file) {
+		apr_file_close(writer->file);
+		writer->file = NULL;
+	}
+	if(writer->file_pool) {
+		apr_pool_destroy(writer->file_pool);
+		writer->file_pool = NULL;
+	}
+}
+
+static void apt_file_writer_flush_job(void *obj, void *arg)
+{
+	apt_file_writer_t *writer = obj;
+	/* reset before draining, so that blocks published meanwhile get a new job */
+	apr_atomic_set32(&writer->flush_pending,0);
+	apt_file_writer_drain(writer);
+}
+
+static void apt_file_writer_close_job(void *obj, void *arg)
+{
+	apt_file_writer_t *writer = obj;
+	apt_file_writer_file_close(writer);
+
+	apr_thread_mutex_lock(writer->guard);
+	apr_atomic_set32(&writer->closing,0);
+	apr_thread_cond_signal(writer->closed_cond);
+	apr_thread_mutex_unlock(writer->guard);
+}
+
+/** Publish the current block (producer) */
+static void apt_file_writer_publish(apt_file_writer_t *writer)
+{
+	writer->sizes[writer->produced % writer->block_count] = writer->fill;
+	writer->fill = 0;
+	apr_atomic_inc32(&writer->produced);
+
+	if(!writer->strand) {
+		apt_file_writer_drain(writer);
+		return;
+	}
+	if(apr_atomic_cas32(&writer->flush_pending,1,0) == 0) {
+		if(apt_executor_job_submit(writer->strand,apt_file_writer_flush_job,writer,NULL) == FALSE) {
+			/* the block is written by the next job */
+			apr_atomic_set32(&writer->flush_pending,0);
+		}
+	}
+}
+
+/** Create file writer */
+APT_DECLARE(apt_file_writer_t*) apt_file_writer_create(
+									apt_executor_t *executor,
+									apr_size_t block_size,
+									apr_size_t block_count,
+									apt_bool_t direct,
+									apr_pool_t *pool)
+{
+	apt_file_writer_t *writer = apr_palloc(pool,sizeof(apt_file_writer_t));
+	char *blocks;
+	if(!block_size) {
+		block_size = APT_FILE_WRITER_DEFAULT_BLOCK_SIZE;
+	}
+	if(block_count < 2) {
+		block_count = APT_FILE_WRITER_DEFAULT_BLOCK_COUNT;
+	}
+	block_size = (block_size + APT_FILE_WRITER_ALIGNMENT - 1) & ~((apr_size_t)APT_FILE_WRITER_ALIGNMENT - 1);
+
+	writer->strand = NULL;
+	if(executor) {
+		writer->strand = apt_executor_strand_create(executor,APT_FILE_WRITER_STRAND_SIZE,pool);
+		if(!writer->strand) {
+			return NULL;
+		}
+	}
+	blocks = apr_palloc(pool,block_size * block_count + APT_FILE_WRITER_ALIGNMENT);
+	writer->blocks = (char*)(((apr_uintptr_t)blocks + APT_FILE_WRITER_ALIGNMENT - 1) & ~((apr_uintptr_t)APT_FILE_WRITER_ALIGNMENT - 1));
+	writer->sizes = apr_pcalloc(pool,sizeof(apr_size_t) * block_count);
+	writer->block_size = block_size;
+	writer->block_count = (apr_uint32_t)block_count;
+	writer->direct = direct;
+	writer->file = NULL;
+	writer->file_pool = NULL;
+	writer->file_direct = FALSE;
+	writer->encoder = NULL;
+	writer->fill = 0;
+	writer->is_open = FALSE;
+	writer->produced = 0;
+	writer->consumed = 0;
+	writer->flush_pending = 0;
+	writer->closing = 0;
+	writer->dropped = 0;
+	writer->guard = NULL;
+	writer->closed_cond = NULL;
+	if(apr_thread_mutex_create(&writer->guard,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	if(apr_thread_cond_create(&writer->closed_cond,pool) != APR_SUCCESS) {
+		apr_thread_mutex_destroy(writer->guard);
+		return NULL;
+	}
+	return writer;
+}
+
+/** Destroy file writer */
+APT_DECLARE(void) apt_file_writer_destroy(apt_file_writer_t *writer)
+{
+	if(writer->strand) {
+		/* wait for pending jobs */
+		apt_executor_strand_destroy(writer->strand);
+		writer->strand = NULL;
+	}
+	if(writer->is_open == TRUE) {
+		if(writer->fill) {
+			apt_file_writer_publish(writer);
+		}
+		writer->is_open = FALSE;
+	}
+	apt_file_writer_file_close(writer);
+	apr_thread_cond_destroy(writer->closed_cond);
+	apr_thread_mutex_destroy(writer->guard);
+}
+
+/** Open the file to write to */
+APT_DECLARE(apt_bool_t) apt_file_writer_open(apt_file_writer_t *writer, const char *file_path, apt_file_encoder_t *encoder)
+{
+	apr_pool_t *pool;
+	if(writer->is_open == TRUE) {
+		apt_file_writer_close(writer);
+	}
+
+	/* wait for the previous file to be flushed and closed */
+	apr_thread_mutex_lock(writer->guard);
+	while(apt_file_writer_load(&writer->closing)) {
+		apr_thread_cond_wait(writer->closed_cond,writer->guard);
+	}
+	apr_thread_mutex_unlock(writer->guard);
+
+	pool = apt_pool_create();
+	if(!pool) {
+		if(encoder) {
+			encoder->vtable->close(encoder,NULL);
+		}
+		return FALSE;
+	}
+	writer->file = NULL;
+	writer->file_direct = FALSE;
+#if defined(O_DIRECT)
+	/* encoders write output of arbitrary size and may seek */
+	if(writer->direct == TRUE && !encoder) {
+		apr_os_file_t fd = open(file_path,O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT,0644);
+		if(fd >= 0) {
+			if(apr_os_file_put(&writer->file,&fd,APR_FOPEN_WRITE,pool) == APR_SUCCESS) {
+				writer->file_direct = TRUE;
+			}
+			else {
+				close(fd);
+			}
+		}
+	}
+#endif
+	if(!writer->file) {
+		if(apr_file_open(
+				&writer->file,
+				file_path,
+				APR_FOPEN_WRITE | APR_FOPEN_CREATE | APR_FOPEN_TRUNCATE | APR_FOPEN_BINARY,
+				APR_OS_DEFAULT,
+				pool) != APR_SUCCESS) {
+			writer->file = NULL;
+			apr_pool_destroy(pool);
+			if(encoder) {
+				encoder->vtable->close(encoder,NULL);
+			}
+			return FALSE;
+		}
+	}
+	writer->file_pool = pool;
+	if(encoder) {
+		writer->encoder = encoder;
+		if(encoder->vtable->open(encoder,writer->file) == FALSE) {
+			apt_file_writer_file_close(writer);
+			return FALSE;
+		}
+	}
+	writer->fill = 0;
+	apr_atomic_set32(&writer->dropped,0);
+	writer->is_open = TRUE;
+	return TRUE;
+}
+
+/** Append data to the file */
+APT_DECLARE(apt_bool_t) apt_file_writer_write(apt_file_writer_t *writer, const void *data, apr_size_t size)
+{
+	const char *pos = data;
+	if(writer->is_open == FALSE) {
+		return FALSE;
+	}
+
+	while(size) {
+		apr_size_t chunk_size;
+		if(!writer->fill &&
+			writer->produced - apt_file_writer_load(&writer->consumed) >= writer->block_count) {
+			/* all the blocks are waiting to be written, never wait for the disk */
+			apr_atomic_add32(&writer->dropped,(apr_uint32_t)size);
+			return FALSE;
+		}
+		chunk_size = writer->block_size - writer->fill;
+		if(chunk_size > size) {
+			chunk_size = size;
+		}
+		memcpy(apt_file_writer_block_get(writer,writer->produced) + writer->fill,pos,chunk_size);
+		writer->fill += chunk_size;
+		pos += chunk_size;
+		size -= chunk_size;
+		if(writer->fill == writer->block_size) {
+			apt_file_writer_publish(writer);
+		}
+	}
+	return TRUE;
+}
+
+/** Close the file, once all the appended data is written */
+APT_DECLARE(apt_bool_t) apt_file_writer_close(apt_file_writer_t *writer)
+{
+	if(writer->is_open == FALSE) {
+		return FALSE;
+	}
+	writer->is_open = FALSE;
+	if(writer->fill) {
+		apt_file_writer_publish(writer);
+	}
+
+	if(writer->strand) {
+		apr_atomic_set32(&writer->closing,1);
+		if(apt_executor_job_submit(writer->strand,apt_file_writer_close_job,writer,NULL) == TRUE) {
+			return TRUE;
+		}
+		apr_atomic_set32(&writer->closing,0);
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Submit File Close Job, Close Synchronously");
+	}
+	apt_file_writer_file_close(writer);
+	return TRUE;
+}
+
+/** Check whether the file is open */
+APT_DECLARE(apt_bool_t) apt_file_writer_is_open(const apt_file_writer_t *writer)
+{
+	return writer->is_open;
+}
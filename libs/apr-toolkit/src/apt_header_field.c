@@ -112,6 +112,9 @@ APT_DECLARE(void) apt_header_section_init(apt_header_section_t *header)
 	APR_RING_INIT(&header->ring, apt_header_field_t, link);
 	header->arr = NULL;
 	header->arr_size = 0;
+	header->pool = NULL;
+	header->set_count = 0;
+	header->inline_count = 0;
 }
 
 /** Allocate header section to set/get header fields by numeric identifiers */
@@ -121,19 +124,78 @@ APT_DECLARE(apt_bool_t) apt_header_section_array_alloc(apt_header_section_t *hea
 		return FALSE;
 	}
 
-	header->arr = (apt_header_field_t**)apr_pcalloc(pool,sizeof(apt_header_field_t*) * max_field_count);
+	/* the array is built on demand, see apt_header_section_index_set() */
+	header->arr = NULL;
 	header->arr_size = max_field_count;
+	header->pool = pool;
+	header->set_count = 0;
+	return TRUE;
+}
+
+/** Allocate an empty header field from inline storage of header section */
+APT_DECLARE(apt_header_field_t*) apt_header_section_field_alloc(apt_header_section_t *header, apr_pool_t *pool)
+{
+	apt_header_field_t *header_field;
+	if(header->inline_count >= APT_HEADER_SECTION_INLINE_FIELD_COUNT) {
+		return apt_header_field_alloc(pool);
+	}
+
+	header_field = &header->inline_fields[header->inline_count++];
+	apt_string_reset(&header_field->name);
+	apt_string_reset(&header_field->value);
+	header_field->id = UNKNOWN_HEADER_FIELD_ID;
+	APR_RING_ELEM_INIT(header_field,link);
+	return header_field;
+}
+
+/** Set header field by numeric identifier, building the array once the inline one is full */
+static apt_bool_t apt_header_section_index_set(apt_header_section_t *header, apt_header_field_t *header_field)
+{
+	apr_size_t i;
+	if(apt_header_section_field_get(header,header_field->id)) {
+		return FALSE;
+	}
+
+	if(!header->arr) {
+		if(header->set_count < APT_HEADER_SECTION_INLINE_FIELD_COUNT) {
+			header->set_fields[header->set_count++] = header_field;
+			return TRUE;
+		}
+
+		header->arr = (apt_header_field_t**)apr_pcalloc(header->pool,sizeof(apt_header_field_t*) * header->arr_size);
+		for(i=0; i<header->set_count; i++) {
+			header->arr[header->set_fields[i]->id] = header->set_fields[i];
+		}
+		header->set_count = 0;
+	}
+	header->arr[header_field->id] = header_field;
 	return TRUE;
 }
 
+/** Unset header field by numeric identifier */
+static void apt_header_section_index_unset(apt_header_section_t *header, const apt_header_field_t *header_field)
+{
+	apr_size_t i;
+	if(header->arr) {
+		header->arr[header_field->id] = NULL;
+		return;
+	}
+
+	for(i=0; i<header->set_count; i++) {
+		if(header->set_fields[i]->id == header_field->id) {
+			header->set_fields[i] = header->set_fields[--header->set_count];
+			return;
+		}
+	}
+}
+
 /** Add (append) header field to header section */
 APT_DECLARE(apt_bool_t) apt_header_section_field_add(apt_header_section_t *header, apt_header_field_t *header_field)
 {
 	if(header_field->id < header->arr_size) {
-		if(header->arr[header_field->id]) {
+		if(apt_header_section_index_set(header,header_field) == FALSE) {
 			return FALSE;
 		}
-		header->arr[header_field->id] = header_field;
 	}
 	APR_RING_INSERT_TAIL(&header->ring,header_field,apt_header_field_t,link);
 	return TRUE;
@@ -144,10 +206,9 @@ APT_DECLARE(apt_bool_t) apt_header_section_field_insert(apt_header_section_t *he
 {
 	apt_header_field_t *it;
 	if(header_field->id < header->arr_size) {
-		if(header->arr[header_field->id]) {
+		if(apt_header_section_index_set(header,header_field) == FALSE) {
 			return FALSE;
 		}
-		header->arr[header_field->id] = header_field;
 
 		for(it = APR_RING_FIRST(&header->ring);
 				it != APR_RING_SENTINEL(&header->ring, apt_header_field_t, link);
@@ -169,10 +230,16 @@ APT_DECLARE(apt_bool_t) apt_header_section_field_set(apt_header_section_t *heade
 	if(header_field->id >= header->arr_size) {
 		return FALSE;
 	}
-	if(header->arr[header_field->id]) {
+	return apt_header_section_index_set(header,header_field);
+}
+
+/** Unset header field in the array of header fields */
+APT_DECLARE(apt_bool_t) apt_header_section_field_unset(apt_header_section_t *header, apt_header_field_t *header_field)
+{
+	if(header_field->id >= header->arr_size) {
 		return FALSE;
 	}
-	header->arr[header_field->id] = header_field;
+	apt_header_section_index_unset(header,header_field);
 	return TRUE;
 }
 
@@ -180,7 +247,7 @@ APT_DECLARE(apt_bool_t) apt_header_section_field_set(apt_header_section_t *heade
 APT_DECLARE(apt_bool_t) apt_header_section_field_remove(apt_header_section_t *header, apt_header_field_t *header_field)
 {
 	if(header_field->id < header->arr_size) {
-		header->arr[header_field->id] = NULL;
+		apt_header_section_index_unset(header,header_field);
 	}
 	APR_RING_REMOVE(header_field,link);
 	return TRUE;
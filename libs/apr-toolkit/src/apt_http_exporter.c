@@ -0,0 +1,237 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <string.h>
+#include <apr_network_io.h>
+#include <apr_thread_proc.h>
+#include <apr_atomic.h>
+#include <apr_strings.h>
+#include "apt_http_exporter.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+
+/** Interval to check whether to stop at, while waiting for connections (usec) */
+#define APT_HTTP_EXPORTER_ACCEPT_TIMEOUT  (200 * 1000)
+/** Time to receive the request and to send the response within (usec) */
+#define APT_HTTP_EXPORTER_REQUEST_TIMEOUT (2 * 1000 * 1000)
+/** Max size of the request line and headers */
+#define APT_HTTP_EXPORTER_REQUEST_SIZE    2048
+
+/** HTTP exporter */
+struct apt_http_exporter_t {
+	/** Local IP address */
+	const char                 *ip;
+	/** Local port */
+	apr_port_t                  port;
+	/** Content type of the documents */
+	const char                 *content_type;
+	/** Handler to render the documents by */
+	apt_http_exporter_render_f  render;
+	/** External object */
+	void                       *obj;
+
+	/** Listening socket */
+	apr_socket_t               *listen_sock;
+	/** Thread requests are served by */
+	apr_thread_t               *thread;
+	/** Whether the thread is running */
+	volatile apr_uint32_t       running;
+	/** Pool to allocate memory from */
+	apr_pool_t                 *pool;
+};
+
+APT_DECLARE(apt_http_exporter_t*) apt_http_exporter_create(
+									const char *ip,
+									apr_port_t port,
+									const char *content_type,
+									apt_http_exporter_render_f render,
+									void *obj,
+									apr_pool_t *pool)
+{
+	apt_http_exporter_t *exporter;
+	if(!ip || !port || !render) {
+		return NULL;
+	}
+	exporter = apr_palloc(pool,sizeof(apt_http_exporter_t));
+	exporter->ip = apr_pstrdup(pool,ip);
+	exporter->port = port;
+	exporter->content_type = apr_pstrdup(pool,content_type ? content_type : "text/plain");
+	exporter->render = render;
+	exporter->obj = obj;
+	exporter->listen_sock = NULL;
+	exporter->thread = NULL;
+	exporter->running = 0;
+	exporter->pool = pool;
+	return exporter;
+}
+
+static apt_bool_t apt_http_exporter_send(apr_socket_t *sock, const char *data, apr_size_t size)
+{
+	apr_size_t length;
+	while(size) {
+		length = size;
+		if(apr_socket_send(sock,data,&length) != APR_SUCCESS) {
+			return FALSE;
+		}
+		data += length;
+		size -= length;
+	}
+	return TRUE;
+}
+
+static void apt_http_exporter_respond(apr_socket_t *sock, const char *status, const char *content_type, const char *body, apr_pool_t *pool)
+{
+	apr_size_t body_size = body ? strlen(body) : 0;
+	const char *head = apr_psprintf(pool,
+		"HTTP/1.0 %s\r\n"
+		"Content-Type: %s\r\n"
+		"Content-Length: %"APR_SIZE_T_FMT"\r\n"
+		"Connection: close\r\n"
+		"\r\n",
+		status,
+		content_type,
+		body_size);
+	if(apt_http_exporter_send(sock,head,strlen(head)) == TRUE && body_size) {
+		apt_http_exporter_send(sock,body,body_size);
+	}
+}
+
+/** Receive the request line and the headers, which are ignored, and respond */
+static void apt_http_exporter_serve(apt_http_exporter_t *exporter, apr_socket_t *sock, apr_pool_t *pool)
+{
+	char buf[APT_HTTP_EXPORTER_REQUEST_SIZE];
+	apr_size_t received = 0;
+	apr_size_t length;
+	char *method;
+	char *path;
+	char *query;
+	char *state;
+	const char *body;
+
+	apr_socket_timeout_set(sock,APT_HTTP_EXPORTER_REQUEST_TIMEOUT);
+	do {
+		length = sizeof(buf) - 1 - received;
+		if(!length || apr_socket_recv(sock,buf + received,&length) != APR_SUCCESS) {
+			apt_http_exporter_respond(sock,"400 Bad Request","text/plain",NULL,pool);
+			return;
+		}
+		received += length;
+		buf[received] = '\0';
+	}
+	while(!strstr(buf,"\r\n\r\n") && !strstr(buf,"\n\n"));
+
+	method = apr_strtok(buf," \r\n",&state);
+	path = method ? apr_strtok(NULL," \r\n",&state) : NULL;
+	if(!method || !path) {
+		apt_http_exporter_respond(sock,"400 Bad Request","text/plain",NULL,pool);
+		return;
+	}
+	if(strcmp(method,"GET") != 0) {
+		apt_http_exporter_respond(sock,"405 Method Not Allowed","text/plain",NULL,pool);
+		return;
+	}
+	query = strchr(path,'?');
+	if(query) {
+		*query = '\0';
+	}
+
+	body = exporter->render(exporter->obj,path,pool);
+	if(!body) {
+		apt_http_exporter_respond(sock,"404 Not Found","text/plain",NULL,pool);
+		return;
+	}
+	apt_http_exporter_respond(sock,"200 OK",exporter->content_type,body,pool);
+}
+
+static void* APR_THREAD_FUNC apt_http_exporter_run(apr_thread_t *thread, void *data)
+{
+	apt_http_exporter_t *exporter = data;
+	apr_socket_t *sock;
+	apr_status_t status;
+	apr_pool_t *pool = apt_pool_create();
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run HTTP Exporter %s:%hu",exporter->ip,exporter->port);
+	while(apr_atomic_read32(&exporter->running)) {
+		status = apr_socket_accept(&sock,exporter->listen_sock,pool);
+		if(status == APR_SUCCESS) {
+			apt_http_exporter_serve(exporter,sock,pool);
+			apr_socket_close(sock);
+			apt_pool_clear(pool);
+		}
+		else if(!APR_STATUS_IS_TIMEUP(status) && !APR_STATUS_IS_EAGAIN(status) && !APR_STATUS_IS_EINTR(status)) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Accept HTTP Connection %s:%hu [%d]",
+				exporter->ip,exporter->port,status);
+			apr_sleep(APT_HTTP_EXPORTER_ACCEPT_TIMEOUT);
+		}
+	}
+	apr_pool_destroy(pool);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Stop HTTP Exporter %s:%hu",exporter->ip,exporter->port);
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+APT_DECLARE(apt_bool_t) apt_http_exporter_start(apt_http_exporter_t *exporter)
+{
+	apr_sockaddr_t *sockaddr = NULL;
+	if(!exporter || exporter->thread) {
+		return FALSE;
+	}
+
+	if(apr_sockaddr_info_get(&sockaddr,exporter->ip,APR_INET,exporter->port,0,exporter->pool) != APR_SUCCESS ||
+		apr_socket_create(&exporter->listen_sock,sockaddr->family,SOCK_STREAM,APR_PROTO_TCP,exporter->pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create HTTP Exporter Socket %s:%hu",exporter->ip,exporter->port);
+		exporter->listen_sock = NULL;
+		return FALSE;
+	}
+
+	apr_socket_opt_set(exporter->listen_sock,APR_SO_REUSEADDR,1);
+	if(apr_socket_bind(exporter->listen_sock,sockaddr) != APR_SUCCESS ||
+		apr_socket_listen(exporter->listen_sock,SOMAXCONN) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Listen on HTTP Exporter Socket %s:%hu",exporter->ip,exporter->port);
+		apr_socket_close(exporter->listen_sock);
+		exporter->listen_sock = NULL;
+		return FALSE;
+	}
+	/* accept returns periodically, so that the thread can check whether to stop */
+	apr_socket_timeout_set(exporter->listen_sock,APT_HTTP_EXPORTER_ACCEPT_TIMEOUT);
+
+	apr_atomic_set32(&exporter->running,1);
+	if(apr_thread_create(&exporter->thread,NULL,apt_http_exporter_run,exporter,exporter->pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create HTTP Exporter Thread");
+		apr_atomic_set32(&exporter->running,0);
+		exporter->thread = NULL;
+		apr_socket_close(exporter->listen_sock);
+		exporter->listen_sock = NULL;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+APT_DECLARE(apt_bool_t) apt_http_exporter_stop(apt_http_exporter_t *exporter)
+{
+	apr_status_t status;
+	if(!exporter || !exporter->thread) {
+		return FALSE;
+	}
+	apr_atomic_set32(&exporter->running,0);
+	apr_thread_join(&status,exporter->thread);
+	exporter->thread = NULL;
+	apr_socket_close(exporter->listen_sock);
+	exporter->listen_sock = NULL;
+	return TRUE;
+}
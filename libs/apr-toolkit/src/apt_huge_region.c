@@ -0,0 +1,175 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include "apt_huge_region.h"
+#include "apt_log.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#define APT_HUGE_REGION_MMAP
+#endif
+
+/** Alignment of allocations, so that objects do not share cache lines */
+#define APT_HUGE_REGION_ALIGNMENT 64
+
+/** Huge page region */
+struct apt_huge_region_t {
+	/** Memory of the region, aligned to the huge page */
+	char                      *base;
+	/** Size of the region */
+	apr_size_t                 size;
+	/** Size of memory allocated */
+	apr_size_t                 used;
+	/** Pages the region is backed by */
+	apt_huge_region_backing_e  backing;
+	/** Address of the mapping (of the heap block) to unmap (to free) */
+	void                      *mapping;
+	/** Size of the mapping */
+	apr_size_t                 mapping_size;
+};
+
+#ifdef APT_HUGE_REGION_MMAP
+/** Map memory of normal pages aligned to the huge page and advise the kernel to back it by huge pages */
+static apt_bool_t apt_huge_region_transparent_map(apt_huge_region_t *region)
+{
+	apr_size_t mapping_size = region->size + APT_HUGE_PAGE_SIZE;
+	char *mapping = mmap(NULL,mapping_size,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+	char *base;
+	apr_size_t head;
+	if(mapping == MAP_FAILED) {
+		return FALSE;
+	}
+	/* unmap the unaligned head and tail */
+	base = (char*)(((apr_uintptr_t)mapping + APT_HUGE_PAGE_SIZE - 1) & ~((apr_uintptr_t)APT_HUGE_PAGE_SIZE - 1));
+	head = base - mapping;
+	if(head) {
+		munmap(mapping,head);
+	}
+	if(APT_HUGE_PAGE_SIZE - head) {
+		munmap(base + region->size,APT_HUGE_PAGE_SIZE - head);
+	}
+	region->base = base;
+	region->mapping = base;
+	region->mapping_size = region->size;
+	region->backing = APT_HUGE_REGION_NORMAL;
+#ifdef MADV_HUGEPAGE
+	if(madvise(base,region->size,MADV_HUGEPAGE) == 0) {
+		region->backing = APT_HUGE_REGION_TRANSPARENT;
+	}
+#endif
+	return TRUE;
+}
+#endif
+
+/** Create region of memory */
+APT_DECLARE(apt_huge_region_t*) apt_huge_region_create(apr_size_t size, apr_pool_t *pool)
+{
+	apt_huge_region_t *region;
+	if(!size) {
+		return NULL;
+	}
+
+	region = apr_palloc(pool,sizeof(apt_huge_region_t));
+	region->size = (size + APT_HUGE_PAGE_SIZE - 1) & ~((apr_size_t)APT_HUGE_PAGE_SIZE - 1);
+	region->used = 0;
+	region->base = NULL;
+	region->mapping = NULL;
+	region->mapping_size = 0;
+	region->backing = APT_HUGE_REGION_NORMAL;
+
+#ifdef APT_HUGE_REGION_MMAP
+#ifdef MAP_HUGETLB
+	region->mapping = mmap(NULL,region->size,PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE,-1,0);
+	if(region->mapping != MAP_FAILED) {
+		region->base = region->mapping;
+		region->mapping_size = region->size;
+		region->backing = APT_HUGE_REGION_HUGETLB;
+	}
+	else {
+		/* no huge pages are reserved (vm.nr_hugepages) */
+		region->mapping = NULL;
+	}
+#endif
+	if(!region->base && apt_huge_region_transparent_map(region) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Map Huge Page Region [%"APR_SIZE_T_FMT" bytes]",region->size);
+		return NULL;
+	}
+#else
+	region->mapping = malloc(region->size + APT_HUGE_REGION_ALIGNMENT);
+	if(!region->mapping) {
+		return NULL;
+	}
+	region->base = (char*)(((apr_uintptr_t)region->mapping + APT_HUGE_REGION_ALIGNMENT - 1) &
+		~((apr_uintptr_t)APT_HUGE_REGION_ALIGNMENT - 1));
+	region->mapping_size = region->size + APT_HUGE_REGION_ALIGNMENT;
+#endif
+
+	if(region->backing != APT_HUGE_REGION_HUGETLB) {
+		/* fault the pages in now rather than on first use */
+		memset(region->base,0,region->size);
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Create %s Page Region [%"APR_SIZE_T_FMT" bytes]",
+		region->backing == APT_HUGE_REGION_HUGETLB ? "Huge" :
+		region->backing == APT_HUGE_REGION_TRANSPARENT ? "Transparent Huge" : "Normal",
+		region->size);
+	return region;
+}
+
+/** Destroy region */
+APT_DECLARE(void) apt_huge_region_destroy(apt_huge_region_t *region)
+{
+	if(!region->mapping) {
+		return;
+	}
+#ifdef APT_HUGE_REGION_MMAP
+	munmap(region->mapping,region->mapping_size);
+#else
+	free(region->mapping);
+#endif
+	region->mapping = NULL;
+	region->base = NULL;
+	region->used = region->size;
+}
+
+/** Allocate memory from region */
+APT_DECLARE(void*) apt_huge_region_alloc(apt_huge_region_t *region, apr_size_t size)
+{
+	void *mem;
+	size = (size + APT_HUGE_REGION_ALIGNMENT - 1) & ~((apr_size_t)APT_HUGE_REGION_ALIGNMENT - 1);
+	if(!size || size > region->size - region->used) {
+		return NULL;
+	}
+	mem = region->base + region->used;
+	region->used += size;
+	return mem;
+}
+
+/** Get the pages the region is backed by */
+APT_DECLARE(apt_huge_region_backing_e) apt_huge_region_backing_get(const apt_huge_region_t *region)
+{
+	return region->backing;
+}
+
+/** Get the usage of region */
+APT_DECLARE(void) apt_huge_region_stat_get(const apt_huge_region_t *region, apr_size_t *size, apr_size_t *used)
+{
+	*size = region->size;
+	*used = region->used;
+}
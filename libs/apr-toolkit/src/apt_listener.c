@@ -0,0 +1,252 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <apr_portable.h>
+#include <apr_strings.h>
+#include "apt_listener.h"
+#include "apt_log.h"
+
+#ifndef WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#ifdef APR_UNIX
+#include <sys/un.h>
+#endif
+
+/** First descriptor passed by systemd socket activation */
+#define SD_LISTEN_FDS_START 3
+
+/** Descriptors inherited, not taken yet (-1 once taken) */
+static int inherited_fds[APT_LISTENER_MAX_COUNT];
+static apr_size_t inherited_count = 0;
+static apt_bool_t inherited_loaded = FALSE;
+
+/** Sockets registered to hand off */
+static apr_socket_t *registered_socks[APT_LISTENER_MAX_COUNT];
+static volatile apt_bool_t handed_off = FALSE;
+
+/** Add the descriptor inherited, once loaded from the environment */
+static void apt_listener_fd_add(int fd)
+{
+	if(fd >= 0 && inherited_count < APT_LISTENER_MAX_COUNT) {
+		inherited_fds[inherited_count++] = fd;
+	}
+}
+
+/** Load the descriptors inherited from the environment, which is cleared then for the processes created next */
+static void apt_listener_fds_load(void)
+{
+	const char *value;
+	inherited_loaded = TRUE;
+
+	value = getenv("LISTEN_PID");
+	if(value && atol(value) == (long)getpid()) {
+		int i;
+		int count = 0;
+		value = getenv("LISTEN_FDS");
+		if(value) {
+			count = atoi(value);
+		}
+		for(i=0; i<count; i++) {
+			apt_listener_fd_add(SD_LISTEN_FDS_START + i);
+		}
+		unsetenv("LISTEN_PID");
+		unsetenv("LISTEN_FDS");
+	}
+
+	value = getenv(APT_LISTEN_FDS_ENV);
+	if(value) {
+		char *end;
+		while(*value != '\0') {
+			long fd = strtol(value,&end,10);
+			if(end == value) {
+				break;
+			}
+			apt_listener_fd_add((int)fd);
+			value = (*end == ',') ? end + 1 : end;
+		}
+		unsetenv(APT_LISTEN_FDS_ENV);
+	}
+	if(inherited_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Inherit Listening Sockets [%"APR_SIZE_T_FMT"]",inherited_count);
+	}
+}
+
+/** Check whether the descriptor is a socket of the type bound to the address */
+static apt_bool_t apt_listener_fd_match(int fd, const apr_sockaddr_t *sockaddr, int type)
+{
+	struct sockaddr_storage addr;
+	socklen_t addr_len = sizeof(addr);
+	int sock_type = 0;
+	socklen_t type_len = sizeof(sock_type);
+
+	if(getsockopt(fd,SOL_SOCKET,SO_TYPE,(void*)&sock_type,&type_len) != 0 || sock_type != type) {
+		return FALSE;
+	}
+	if(getsockname(fd,(struct sockaddr*)&addr,&addr_len) != 0 || addr.ss_family != sockaddr->family) {
+		return FALSE;
+	}
+	switch(addr.ss_family) {
+		case AF_INET:
+		{
+			const struct sockaddr_in *in = (const struct sockaddr_in*)&addr;
+			return (ntohs(in->sin_port) == sockaddr->port && sockaddr->ipaddr_len == sizeof(in->sin_addr) &&
+				memcmp(&in->sin_addr,sockaddr->ipaddr_ptr,sizeof(in->sin_addr)) == 0) ? TRUE : FALSE;
+		}
+#if APR_HAVE_IPV6
+		case AF_INET6:
+		{
+			const struct sockaddr_in6 *in6 = (const struct sockaddr_in6*)&addr;
+			return (ntohs(in6->sin6_port) == sockaddr->port && sockaddr->ipaddr_len == sizeof(in6->sin6_addr) &&
+				memcmp(&in6->sin6_addr,sockaddr->ipaddr_ptr,sizeof(in6->sin6_addr)) == 0) ? TRUE : FALSE;
+		}
+#endif
+#ifdef APR_UNIX
+		case AF_UNIX:
+		{
+			const struct sockaddr_un *un = (const struct sockaddr_un*)&addr;
+			/* the path is kept as the hostname of the address */
+			return (sockaddr->hostname && strcmp(un->sun_path,sockaddr->hostname) == 0) ? TRUE : FALSE;
+		}
+#endif
+		default:
+			break;
+	}
+	return FALSE;
+}
+
+APT_DECLARE(apr_socket_t*) apt_listener_inherit(const apr_sockaddr_t *sockaddr, int type, apr_pool_t *pool)
+{
+	apr_socket_t *sock = NULL;
+	apr_os_sock_t os_sock;
+	apr_size_t i;
+
+	if(inherited_loaded == FALSE) {
+		apt_listener_fds_load();
+	}
+	if(!sockaddr) {
+		return NULL;
+	}
+
+	for(i=0; i<inherited_count; i++) {
+		if(inherited_fds[i] < 0 || apt_listener_fd_match(inherited_fds[i],sockaddr,type) == FALSE) {
+			continue;
+		}
+
+		os_sock = inherited_fds[i];
+		if(apr_os_sock_put(&sock,&os_sock,pool) != APR_SUCCESS || !sock) {
+			return NULL;
+		}
+		/* not to be inherited any further, unless handed off */
+		fcntl(os_sock,F_SETFD,fcntl(os_sock,F_GETFD) | FD_CLOEXEC);
+		inherited_fds[i] = -1;
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Take Inherited Listening Socket [%d]",os_sock);
+		return sock;
+	}
+	return NULL;
+}
+
+APT_DECLARE(void) apt_listener_register(apr_socket_t *sock)
+{
+	apr_size_t i;
+	for(i=0; i<APT_LISTENER_MAX_COUNT; i++) {
+		if(!registered_socks[i]) {
+			registered_socks[i] = sock;
+			return;
+		}
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Register Listening Socket: max count [%d] reached",APT_LISTENER_MAX_COUNT);
+}
+
+APT_DECLARE(void) apt_listener_unregister(apr_socket_t *sock)
+{
+	apr_size_t i;
+	for(i=0; i<APT_LISTENER_MAX_COUNT; i++) {
+		if(registered_socks[i] == sock) {
+			registered_socks[i] = NULL;
+			return;
+		}
+	}
+}
+
+APT_DECLARE(apt_bool_t) apt_listeners_hand_off(void)
+{
+	char value[APT_LISTENER_MAX_COUNT * 12];
+	apr_size_t length = 0;
+	apr_os_sock_t fd;
+	apr_size_t i;
+
+	value[0] = '\0';
+	for(i=0; i<APT_LISTENER_MAX_COUNT; i++) {
+		if(!registered_socks[i] || apr_os_sock_get(&fd,registered_socks[i]) != APR_SUCCESS) {
+			continue;
+		}
+		/* the descriptor survives exec of the new process */
+		fcntl(fd,F_SETFD,fcntl(fd,F_GETFD) & ~FD_CLOEXEC);
+		length += apr_snprintf(value + length,sizeof(value) - length,length ? ",%d" : "%d",fd);
+	}
+	if(!length) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Hand off Listening Sockets: none registered");
+		return FALSE;
+	}
+	if(setenv(APT_LISTEN_FDS_ENV,value,1) != 0) {
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Hand off Listening Sockets [%s]",value);
+	handed_off = TRUE;
+	return TRUE;
+}
+
+APT_DECLARE(apt_bool_t) apt_listeners_are_handed_off(void)
+{
+	return handed_off;
+}
+
+#else
+
+APT_DECLARE(apr_socket_t*) apt_listener_inherit(const apr_sockaddr_t *sockaddr, int type, apr_pool_t *pool)
+{
+	/* not supported */
+	return NULL;
+}
+
+APT_DECLARE(void) apt_listener_register(apr_socket_t *sock)
+{
+}
+
+APT_DECLARE(void) apt_listener_unregister(apr_socket_t *sock)
+{
+}
+
+APT_DECLARE(apt_bool_t) apt_listeners_hand_off(void)
+{
+	return FALSE;
+}
+
+APT_DECLARE(apt_bool_t) apt_listeners_are_handed_off(void)
+{
+	return FALSE;
+}
+
+#endif
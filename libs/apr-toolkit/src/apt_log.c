@@ -16,15 +16,45 @@
  * $Id$
  */
 
+#include <stdlib.h>
 #include <apr_time.h>
 #include <apr_file_io.h>
 #include <apr_portable.h>
 #include <apr_xml.h>
+#include <apr_lib.h>
+#include <apr_atomic.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
 #include "apt_log.h"
 
+/* the functions are defined here, not the checking macros */
+#undef apt_log
+#undef apt_obj_log
+
 #define MAX_LOG_ENTRY_SIZE 4096
 #define MAX_PRIORITY_NAME_LENGTH 9
 
+/** Default size of per-thread ring of async mode */
+#define ASYNC_RING_SIZE_DEFAULT  (64 * 1024)
+/** Size of the buffer log entries are collected in and written out at once by async writer */
+#define ASYNC_WRITE_BUFFER_SIZE  (64 * 1024)
+/** Time the async writer sleeps for, when all the rings are empty (usec) */
+#define ASYNC_IDLE_TIMEOUT       10000
+/** Flag of binary record queued in async ring (set in record length) */
+#define ASYNC_BINARY_FLAG        0x80000000
+
+/** Binary record types */
+#define BINARY_RECORD_TEMPLATE   1
+#define BINARY_RECORD_ENTRY      2
+/** Max number of message templates (distinct format strings) assigned an id */
+#define BINARY_TEMPLATE_COUNT    4096
+/** Max number of slots probed to find or assign a template id */
+#define BINARY_TEMPLATE_PROBES   32
+
+#ifndef va_copy
+#define va_copy(dst,src) ((dst) = (src))
+#endif
+
 static const char priority_snames[APT_PRIO_COUNT][MAX_PRIORITY_NAME_LENGTH+1] =
 {
 	"[EMERG]  ",
@@ -52,34 +82,183 @@ struct apt_log_file_data_t {
 	apr_pool_t           *pool;
 };
 
+typedef struct apt_log_ring_t apt_log_ring_t;
+
+/** Single producer single consumer ring of [length][entry] records */
+struct apt_log_ring_t {
+	apt_log_ring_t        *next;
+	char                  *buffer;
+	apr_uint32_t           mask;
+	/** Write position, advanced by the owner thread only */
+	volatile apr_uint32_t  head;
+	/** Read position, advanced by the writer thread only */
+	volatile apr_uint32_t  tail;
+	/** Number of entries dropped while the ring was full */
+	volatile apr_uint32_t  dropped;
+	/** Owner thread has exited, the ring can be adopted by another thread */
+	volatile apr_uint32_t  orphan;
+};
+
+typedef struct apt_log_async_t apt_log_async_t;
+
+struct apt_log_async_t {
+	apr_size_t            ring_size;
+	apr_threadkey_t      *key;
+	/** Guards the list of rings */
+	apr_thread_mutex_t   *guard;
+	apt_log_ring_t       *rings;
+	apr_thread_t         *thread;
+	volatile apr_uint32_t running;
+	apr_uint32_t          dropped_reported;
+	char                  buffer[ASYNC_WRITE_BUFFER_SIZE];
+	apr_size_t            size;
+	char                  bin_buffer[ASYNC_WRITE_BUFFER_SIZE];
+	apr_size_t            bin_size;
+};
+
+typedef struct apt_log_template_t apt_log_template_t;
+
+/** Message template of binary output */
+struct apt_log_template_t {
+	void * volatile       format;
+	const char           *file;
+	int                   line;
+	/** File and line are set */
+	volatile apr_uint32_t ready;
+};
+
+/** Max number of modules with own priority */
+#define MAX_LOG_MODULE_COUNT 32
+
+typedef struct apt_log_module_t apt_log_module_t;
+
+/** Module with own priority, told by the path of source files */
+struct apt_log_module_t {
+	/** Fragment of the path of source files of the module */
+	const char           *path;
+	apt_log_priority_e    priority;
+};
+
+/** Module names and paths, other names are taken for plugins */
+static const char *const log_module_paths[][2] = {
+	{"apr-toolkit",      "libs/apr-toolkit/"},
+	{"mpf",              "libs/mpf/"},
+	{"mrcp",             "libs/mrcp/"},
+	{"mrcp-signaling",   "libs/mrcp-signaling/"},
+	{"mrcpv2-transport", "libs/mrcpv2-transport/"},
+	{"mrcp-engine",      "libs/mrcp-engine/"},
+	{"mrcp-server",      "libs/mrcp-server/"},
+	{"mrcp-client",      "libs/mrcp-client/"},
+	{"uni-rtsp",         "libs/uni-rtsp/"},
+	{"sofia",            "modules/mrcp-sofiasip/"},
+	{"unirtsp",          "modules/mrcp-unirtsp/"}
+};
+
 struct apt_logger_t {
 	apt_log_output_e      mode;
 	apt_log_priority_e    priority;
+	apt_log_module_t      modules[MAX_LOG_MODULE_COUNT];
+	apr_size_t            module_count;
 	int                   header;
 	apt_log_ext_handler_f ext_handler;
 	apt_log_file_data_t  *file_data;
 	apt_log_masking_e     masking;
+	apt_log_async_t      *async;
+	apr_pool_t           *pool;
 };
 
 static apt_logger_t *apt_logger = NULL;
 
-static apt_bool_t apt_do_log(const char *file, int line, apt_log_priority_e priority, const char *format, va_list arg_ptr);
+/** Log entries are passed on to the logger until it is created */
+APT_DECLARE_DATA volatile int apt_log_enabled_priority = APT_PRIO_DEBUG;
+
+static apt_log_template_t log_templates[BINARY_TEMPLATE_COUNT];
+
+#ifdef APT_THREAD_LOCAL
+typedef struct apt_log_time_cache_t apt_log_time_cache_t;
+
+/** Date and time header formatted once per second (per thread) */
+struct apt_log_time_cache_t {
+	apr_time_t            sec;
+	int                   header;
+	apr_size_t            length;
+	char                  prefix[32];
+};
+
+static APT_THREAD_LOCAL apt_log_time_cache_t time_cache = {-1, 0, 0, {0}};
+#endif
+
+static apt_bool_t apt_do_log(const char *file, int line, apt_log_priority_e priority, void *obj, const char *format, va_list arg_ptr);
+static apt_bool_t apt_log_binary_entry(const char *file, int line, apt_log_priority_e priority, void *obj, const char *format, va_list arg_ptr);
+static apr_size_t apt_log_binary_entry_printf(char *record, apr_size_t max_size, const char *file, int line,
+											apt_log_priority_e priority, const char *format, ...);
+static void apt_log_binary_templates_dump(FILE *file);
 
 static const char* apt_log_file_path_make(apt_log_file_data_t *file_data);
 static apt_bool_t apt_log_file_dump(apt_log_file_data_t *file_data, const char *log_entry, apr_size_t size);
 static apr_xml_doc* apt_log_doc_parse(const char *file_path, apr_pool_t *pool);
 static apr_size_t apt_log_file_get_size(apt_log_file_data_t *file_data);
 static apr_byte_t apt_log_file_exist(apt_log_file_data_t *file_data);
+static apt_bool_t apt_log_async_push(apt_log_async_t *async, const char *log_entry, apr_size_t size, apt_bool_t binary);
+
+/** Update the cached least important priority enabled globally or for any module */
+static void apt_log_enabled_priority_update(const apt_logger_t *logger)
+{
+	apr_size_t i;
+	int priority = logger->priority;
+	for(i=0; i<logger->module_count; i++) {
+		if((int)logger->modules[i].priority > priority) {
+			priority = logger->modules[i].priority;
+		}
+	}
+	apt_log_enabled_priority = priority;
+}
+
+/** Check whether the path of the source file contains the path of a module ('/' matches '\\' too) */
+static apt_bool_t apt_log_path_match(const char *file, const char *path)
+{
+	const char *pos;
+	const char *p;
+	for(; *file != '\0'; file++) {
+		for(pos = file, p = path; *p != '\0' && *pos != '\0'; pos++, p++) {
+			if(*pos != *p && !(*p == '/' && *pos == '\\')) {
+				break;
+			}
+		}
+		if(*p == '\0') {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/** Check the priority against the one of the module of the source file, or the global one */
+static APR_INLINE apt_bool_t apt_log_priority_is_enabled(const apt_logger_t *logger, const char *file, apt_log_priority_e priority)
+{
+	apr_size_t i;
+	apr_size_t count = logger->module_count;
+	if(count && file) {
+		for(i=0; i<count; i++) {
+			if(apt_log_path_match(file,logger->modules[i].path) == TRUE) {
+				return priority <= logger->modules[i].priority ? TRUE : FALSE;
+			}
+		}
+	}
+	return priority <= logger->priority ? TRUE : FALSE;
+}
 
 static apt_logger_t* apt_log_instance_alloc(apr_pool_t *pool)
 {
 	apt_logger_t *logger = apr_palloc(pool,sizeof(apt_logger_t));
 	logger->mode = APT_LOG_OUTPUT_CONSOLE;
 	logger->priority = APT_PRIO_INFO;
+	logger->module_count = 0;
 	logger->header = APT_LOG_HEADER_DEFAULT;
 	logger->ext_handler = NULL;
 	logger->file_data = NULL;
 	logger->masking = APT_LOG_MASKING_NONE;
+	logger->async = NULL;
+	logger->pool = pool;
 	return logger;
 }
 
@@ -91,6 +270,7 @@ APT_DECLARE(apt_bool_t) apt_log_instance_create(apt_log_output_e mode, apt_log_p
 	apt_logger = apt_log_instance_alloc(pool);
 	apt_logger->mode = mode;
 	apt_logger->priority = priority;
+	apt_log_enabled_priority_update(apt_logger);
 	return TRUE;
 }
 
@@ -140,10 +320,25 @@ APT_DECLARE(apt_bool_t) apt_log_instance_load(const char *config_file, apr_pool_
 		else if(strcasecmp(elem->name,"masking") == 0) {
 			apt_logger->masking = apt_log_masking_translate(text);
 		}
+		else if(strcasecmp(elem->name,"module") == 0) {
+			const apr_xml_attr *attr;
+			for(attr = elem->attr; attr; attr = attr->next) {
+				if(strcasecmp(attr->name,"name") == 0) {
+					apt_log_module_priority_set(attr->value,apt_log_priority_translate(text));
+				}
+			}
+		}
+		else if(strcasecmp(elem->name,"async") == 0) {
+			apr_size_t ring_size = atol(text);
+			if(ring_size) {
+				apt_log_async_enable(ring_size * 1024);
+			}
+		}
 		else {
 			/* Unknown element */
 		}
 	}
+	apt_log_enabled_priority_update(apt_logger);
 	return TRUE;
 }
 
@@ -153,10 +348,14 @@ APT_DECLARE(apt_bool_t) apt_log_instance_destroy()
 		return FALSE;
 	}
 
+	if(apt_logger->async) {
+		apt_log_async_disable();
+	}
 	if(apt_logger->file_data) {
 		apt_log_file_close();
 	}
 	apt_logger = NULL;
+	apt_log_enabled_priority = APT_PRIO_DEBUG;
 	return TRUE;
 }
 
@@ -171,6 +370,9 @@ APT_DECLARE(apt_bool_t) apt_log_instance_set(apt_logger_t *logger)
 		return FALSE;
 	}
 	apt_logger = logger;
+	if(logger) {
+		apt_log_enabled_priority_update(logger);
+	}
 	return TRUE;
 }
 
@@ -298,6 +500,8 @@ APT_DECLARE(int) apt_log_output_mode_translate(char *str)
 			mode |=  APT_LOG_OUTPUT_CONSOLE;
 		else if(strcasecmp(name, "FILE") == 0)
 			mode |=  APT_LOG_OUTPUT_FILE;
+		else if(strcasecmp(name, "BINARY") == 0)
+			mode |=  APT_LOG_OUTPUT_BINARY;
 		
 		name = apr_strtok(NULL, ",", &last);
 	}
@@ -310,6 +514,46 @@ APT_DECLARE(apt_bool_t) apt_log_priority_set(apt_log_priority_e priority)
 		return FALSE;
 	}
 	apt_logger->priority = priority;
+	apt_log_enabled_priority_update(apt_logger);
+	return TRUE;
+}
+
+APT_DECLARE(apt_bool_t) apt_log_module_priority_set(const char *name, apt_log_priority_e priority)
+{
+	const char *path = NULL;
+	apr_size_t i;
+	if(!apt_logger || !name || *name == '\0' || priority >= APT_PRIO_COUNT) {
+		return FALSE;
+	}
+
+	for(i=0; i<sizeof(log_module_paths)/sizeof(log_module_paths[0]); i++) {
+		if(strcasecmp(name,log_module_paths[i][0]) == 0) {
+			path = log_module_paths[i][1];
+			break;
+		}
+	}
+	if(!path) {
+		path = apr_psprintf(apt_logger->pool,"plugins/%s/",name);
+	}
+
+	for(i=0; i<apt_logger->module_count; i++) {
+		if(strcmp(apt_logger->modules[i].path,path) == 0) {
+			break;
+		}
+	}
+	if(i == apt_logger->module_count) {
+		if(apt_logger->module_count >= MAX_LOG_MODULE_COUNT) {
+			return FALSE;
+		}
+		apt_logger->modules[i].path = path;
+		apt_logger->modules[i].priority = priority;
+		/* the entry is complete, once it is counted in */
+		apt_logger->module_count++;
+	}
+	else {
+		apt_logger->modules[i].priority = priority;
+	}
+	apt_log_enabled_priority_update(apt_logger);
 	return TRUE;
 }
 
@@ -422,14 +666,14 @@ APT_DECLARE(apt_bool_t) apt_log(const char *file, int line, apt_log_priority_e p
 	if(!apt_logger) {
 		return FALSE;
 	}
-	if(priority <= apt_logger->priority) {
+	if(apt_log_priority_is_enabled(apt_logger,file,priority) == TRUE) {
 		va_list arg_ptr;
 		va_start(arg_ptr, format);
 		if(apt_logger->ext_handler) {
 			status = apt_logger->ext_handler(file,line,NULL,priority,format,arg_ptr);
 		}
 		else {
-			status = apt_do_log(file,line,priority,format,arg_ptr);
+			status = apt_do_log(file,line,priority,NULL,format,arg_ptr);
 		}
 		va_end(arg_ptr); 
 	}
@@ -442,14 +686,14 @@ APT_DECLARE(apt_bool_t) apt_obj_log(const char *file, int line, apt_log_priority
 	if(!apt_logger) {
 		return FALSE;
 	}
-	if(priority <= apt_logger->priority) {
+	if(apt_log_priority_is_enabled(apt_logger,file,priority) == TRUE) {
 		va_list arg_ptr;
 		va_start(arg_ptr, format);
 		if(apt_logger->ext_handler) {
 			status = apt_logger->ext_handler(file,line,obj,priority,format,arg_ptr);
 		}
 		else {
-			status = apt_do_log(file,line,priority,format,arg_ptr);
+			status = apt_do_log(file,line,priority,obj,format,arg_ptr);
 		}
 		va_end(arg_ptr); 
 	}
@@ -462,12 +706,12 @@ APT_DECLARE(apt_bool_t) apt_va_log(const char *file, int line, apt_log_priority_
 	if(!apt_logger) {
 		return FALSE;
 	}
-	if(priority <= apt_logger->priority) {
+	if(apt_log_priority_is_enabled(apt_logger,file,priority) == TRUE) {
 		if(apt_logger->ext_handler) {
 			status = apt_logger->ext_handler(file,line,NULL,priority,format,arg_ptr);
 		}
 		else {
-			status = apt_do_log(file,line,priority,format,arg_ptr);
+			status = apt_do_log(file,line,priority,NULL,format,arg_ptr);
 		}
 	}
 	return status;
@@ -482,27 +726,81 @@ static APR_INLINE unsigned long apt_thread_id_get(void)
 #endif
 }
 
-static apt_bool_t apt_do_log(const char *file, int line, apt_log_priority_e priority, const char *format, va_list arg_ptr)
+/** Format date and time header up to seconds, return the length */
+static apr_size_t apt_log_time_prefix_make(char *prefix, apr_size_t max_size, apr_time_t now, int header)
 {
-	char log_entry[MAX_LOG_ENTRY_SIZE];
-	apr_size_t max_size = MAX_LOG_ENTRY_SIZE - 2;
 	apr_size_t offset = 0;
 	apr_time_exp_t result;
-	apr_time_t now = apr_time_now();
 	apr_time_exp_lt(&result,now);
 
-	if(apt_logger->header & APT_LOG_HEADER_DATE) {
-		offset += apr_snprintf(log_entry+offset,max_size-offset,"%4d-%02d-%02d ",
+	if(header & APT_LOG_HEADER_DATE) {
+		offset += apr_snprintf(prefix+offset,max_size-offset,"%4d-%02d-%02d ",
 							result.tm_year+1900,
 							result.tm_mon+1,
 							result.tm_mday);
 	}
-	if(apt_logger->header & APT_LOG_HEADER_TIME) {
-		offset += apr_snprintf(log_entry+offset,max_size-offset,"%02d:%02d:%02d:%06d ",
+	if(header & APT_LOG_HEADER_TIME) {
+		offset += apr_snprintf(prefix+offset,max_size-offset,"%02d:%02d:%02d:",
 							result.tm_hour,
 							result.tm_min,
-							result.tm_sec,
-							result.tm_usec);
+							result.tm_sec);
+	}
+	return offset;
+}
+
+/** Make date and time header, localtime conversion is done only once a second */
+static apr_size_t apt_log_time_header_make(char *buf, int header)
+{
+	apr_size_t offset;
+	apr_time_t now = apr_time_now();
+#ifdef APT_THREAD_LOCAL
+	apr_time_t sec = apr_time_sec(now);
+	if(time_cache.sec != sec || time_cache.header != header) {
+		time_cache.length = apt_log_time_prefix_make(time_cache.prefix,sizeof(time_cache.prefix),now,header);
+		time_cache.sec = sec;
+		time_cache.header = header;
+	}
+	memcpy(buf,time_cache.prefix,time_cache.length);
+	offset = time_cache.length;
+#else
+	char prefix[32];
+	offset = apt_log_time_prefix_make(prefix,sizeof(prefix),now,header);
+	memcpy(buf,prefix,offset);
+#endif
+
+	if(header & APT_LOG_HEADER_TIME) {
+		/* append the microseconds as %06d */
+		int i;
+		int usec = (int)apr_time_usec(now);
+		for(i=5; i>=0; i--) {
+			buf[offset+i] = (char)('0' + usec % 10);
+			usec /= 10;
+		}
+		offset += 6;
+		buf[offset++] = ' ';
+	}
+	return offset;
+}
+
+static apt_bool_t apt_do_log(const char *file, int line, apt_log_priority_e priority, void *obj, const char *format, va_list arg_ptr)
+{
+	char log_entry[MAX_LOG_ENTRY_SIZE];
+	apr_size_t max_size = MAX_LOG_ENTRY_SIZE - 2;
+	apr_size_t offset = 0;
+
+	if((apt_logger->mode & APT_LOG_OUTPUT_BINARY) == APT_LOG_OUTPUT_BINARY && apt_logger->file_data) {
+		va_list arg_copy;
+		if((apt_logger->mode & APT_LOG_OUTPUT_CONSOLE) != APT_LOG_OUTPUT_CONSOLE) {
+			/* no text output at all */
+			return apt_log_binary_entry(file,line,priority,obj,format,arg_ptr);
+		}
+		va_copy(arg_copy,arg_ptr);
+		apt_log_binary_entry(file,line,priority,obj,format,arg_copy);
+		va_end(arg_copy);
+	}
+
+	if(apt_logger->header & (APT_LOG_HEADER_DATE | APT_LOG_HEADER_TIME)) {
+		offset += apt_log_time_header_make(log_entry,apt_logger->header);
 	}
 	if(apt_logger->header & APT_LOG_HEADER_MARK) {
 		offset += apr_snprintf(log_entry+offset,max_size-offset,"%s:%03d ",file,line);
@@ -518,11 +816,15 @@ static apt_bool_t apt_do_log(const char *file, int line, apt_log_priority_e prio
 	offset += apr_vsnprintf(log_entry+offset,max_size-offset,format,arg_ptr);
 	log_entry[offset++] = '\n';
 	log_entry[offset] = '\0';
+	if(apt_logger->async) {
+		return apt_log_async_push(apt_logger->async,log_entry,offset,FALSE);
+	}
+
 	if((apt_logger->mode & APT_LOG_OUTPUT_CONSOLE) == APT_LOG_OUTPUT_CONSOLE) {
 		fwrite(log_entry,offset,1,stdout);
 	}
 	
-	if((apt_logger->mode & APT_LOG_OUTPUT_FILE) == APT_LOG_OUTPUT_FILE && apt_logger->file_data) {
+	if((apt_logger->mode & (APT_LOG_OUTPUT_FILE | APT_LOG_OUTPUT_BINARY)) == APT_LOG_OUTPUT_FILE && apt_logger->file_data) {
 		apt_log_file_dump(apt_logger->file_data,log_entry,offset);
 	}
 	return TRUE;
@@ -531,9 +833,10 @@ static apt_bool_t apt_do_log(const char *file, int line, apt_log_priority_e prio
 static const char* apt_log_file_path_make(apt_log_file_data_t *file_data)
 {
 	char *log_file_path = NULL;
-	const char *log_file_name = apr_psprintf(file_data->pool,"%s-%.2"APR_SIZE_T_FMT".log",
+	const char *log_file_name = apr_psprintf(file_data->pool,"%s-%.2"APR_SIZE_T_FMT".%s",
 									file_data->log_file_name,
-									file_data->cur_file_index);
+									file_data->cur_file_index,
+									(apt_logger->mode & APT_LOG_OUTPUT_BINARY) ? "blog" : "log");
 	apr_filepath_merge(&log_file_path,
 		file_data->log_dir_path,
 		log_file_name,
@@ -592,10 +895,15 @@ static apt_bool_t apt_log_file_dump(apt_log_file_data_t *file_data, const char *
 		log_file_path = apt_log_file_path_make(file_data);
 		file_data->file = fopen(log_file_path,"wb");
 		if(!file_data->file) {
+			apr_thread_mutex_unlock(file_data->mutex);
 			return FALSE;
 		}
 
 		file_data->cur_size = size;
+		if(apt_logger->mode & APT_LOG_OUTPUT_BINARY) {
+			/* each file must be decodable on its own */
+			apt_log_binary_templates_dump(file_data->file);
+		}
 	}
 	/* write to log file */
 	fwrite(log_entry,1,size,file_data->file);
@@ -625,3 +933,542 @@ static apr_xml_doc* apt_log_doc_parse(const char *file_path, apr_pool_t *pool)
 	apr_file_close(fd);
 	return xml_doc;
 }
+
+static APR_INLINE void apt_log_ring_write(apt_log_ring_t *ring, apr_uint32_t pos, const void *data, apr_size_t size)
+{
+	apr_size_t offset = pos & ring->mask;
+	apr_size_t first = ring->mask + 1 - offset;
+	if(first > size) {
+		first = size;
+	}
+	memcpy(ring->buffer + offset,data,first);
+	memcpy(ring->buffer,(const char*)data + first,size - first);
+}
+
+static APR_INLINE void apt_log_ring_read(const apt_log_ring_t *ring, apr_uint32_t pos, void *data, apr_size_t size)
+{
+	apr_size_t offset = pos & ring->mask;
+	apr_size_t first = ring->mask + 1 - offset;
+	if(first > size) {
+		first = size;
+	}
+	memcpy(data,ring->buffer + offset,first);
+	memcpy((char*)data + first,ring->buffer,size - first);
+}
+
+static void apt_log_ring_orphan(void *data)
+{
+	apt_log_ring_t *ring = data;
+	apr_atomic_set32(&ring->orphan,1);
+}
+
+static apt_log_ring_t* apt_log_ring_get(apt_log_async_t *async)
+{
+	void *data = NULL;
+	apt_log_ring_t *ring;
+	apr_threadkey_private_get(&data,async->key);
+	if(data) {
+		return data;
+	}
+
+	/* first entry of the calling thread: adopt a drained ring of an exited thread or create a new one */
+	apr_thread_mutex_lock(async->guard);
+	for(ring = async->rings; ring; ring = ring->next) {
+		if(apr_atomic_read32(&ring->orphan) && apr_atomic_read32(&ring->tail) == ring->head) {
+			apr_atomic_set32(&ring->orphan,0);
+			break;
+		}
+	}
+	if(!ring) {
+		ring = malloc(sizeof(apt_log_ring_t));
+		if(ring) {
+			ring->buffer = malloc(async->ring_size);
+			if(ring->buffer) {
+				ring->mask = (apr_uint32_t)async->ring_size - 1;
+				ring->head = 0;
+				ring->tail = 0;
+				ring->dropped = 0;
+				ring->orphan = 0;
+				ring->next = async->rings;
+				async->rings = ring;
+			}
+			else {
+				free(ring);
+				ring = NULL;
+			}
+		}
+	}
+	apr_thread_mutex_unlock(async->guard);
+
+	if(ring) {
+		apr_threadkey_private_set(ring,async->key);
+	}
+	return ring;
+}
+
+static apt_bool_t apt_log_async_push(apt_log_async_t *async, const char *log_entry, apr_size_t size, apt_bool_t binary)
+{
+	apr_uint32_t length = (apr_uint32_t)size;
+	apr_uint32_t tag = binary == TRUE ? length | ASYNC_BINARY_FLAG : length;
+	apr_uint32_t head;
+	apt_log_ring_t *ring = apt_log_ring_get(async);
+	if(!ring) {
+		return FALSE;
+	}
+
+	head = ring->head;
+	if(sizeof(length) + size > ring->mask + 1 - (head - apr_atomic_read32(&ring->tail))) {
+		/* never block the caller, count the entry as dropped instead */
+		apr_atomic_inc32(&ring->dropped);
+		return FALSE;
+	}
+
+	apt_log_ring_write(ring,head,&tag,sizeof(tag));
+	apt_log_ring_write(ring,head + sizeof(length),log_entry,size);
+	/* publish the entry to the writer */
+	apr_atomic_set32(&ring->head,head + (apr_uint32_t)sizeof(length) + length);
+	return TRUE;
+}
+
+static void apt_log_async_flush(apt_log_async_t *async)
+{
+	if(async->size) {
+		if((apt_logger->mode & APT_LOG_OUTPUT_CONSOLE) == APT_LOG_OUTPUT_CONSOLE) {
+			fwrite(async->buffer,async->size,1,stdout);
+			fflush(stdout);
+		}
+
+		if((apt_logger->mode & (APT_LOG_OUTPUT_FILE | APT_LOG_OUTPUT_BINARY)) == APT_LOG_OUTPUT_FILE && apt_logger->file_data) {
+			apt_log_file_dump(apt_logger->file_data,async->buffer,async->size);
+		}
+		async->size = 0;
+	}
+
+	if(async->bin_size) {
+		if(apt_logger->file_data) {
+			apt_log_file_dump(apt_logger->file_data,async->bin_buffer,async->bin_size);
+		}
+		async->bin_size = 0;
+	}
+}
+
+static apt_bool_t apt_log_async_drain(apt_log_async_t *async)
+{
+	apt_bool_t status = FALSE;
+	apt_log_ring_t *ring;
+	apt_log_ring_t *rings;
+	apr_uint32_t dropped = 0;
+
+	apr_thread_mutex_lock(async->guard);
+	rings = async->rings;
+	apr_thread_mutex_unlock(async->guard);
+
+	/* rings are only prepended to the list, the snapshot stays valid */
+	for(ring = rings; ring; ring = ring->next) {
+		apr_uint32_t tag;
+		apr_uint32_t length;
+		apr_uint32_t tail = ring->tail;
+		apr_uint32_t head = apr_atomic_read32(&ring->head);
+		while(tail != head) {
+			char *buffer;
+			apr_size_t *size;
+			apt_log_ring_read(ring,tail,&tag,sizeof(tag));
+			length = tag & ~ASYNC_BINARY_FLAG;
+			if(tag & ASYNC_BINARY_FLAG) {
+				buffer = async->bin_buffer;
+				size = &async->bin_size;
+			}
+			else {
+				buffer = async->buffer;
+				size = &async->size;
+			}
+			if(*size + length > ASYNC_WRITE_BUFFER_SIZE) {
+				apt_log_async_flush(async);
+			}
+			apt_log_ring_read(ring,tail + sizeof(tag),buffer + *size,length);
+			*size += length;
+			tail += (apr_uint32_t)sizeof(tag) + length;
+			apr_atomic_set32(&ring->tail,tail);
+			status = TRUE;
+		}
+		dropped += apr_atomic_read32(&ring->dropped);
+	}
+
+	if(dropped != async->dropped_reported) {
+		if(async->size + MAX_LOG_ENTRY_SIZE > ASYNC_WRITE_BUFFER_SIZE ||
+			async->bin_size + MAX_LOG_ENTRY_SIZE > ASYNC_WRITE_BUFFER_SIZE) {
+			apt_log_async_flush(async);
+		}
+		if((apt_logger->mode & APT_LOG_OUTPUT_BINARY) == APT_LOG_OUTPUT_BINARY && apt_logger->file_data) {
+			async->bin_size += apt_log_binary_entry_printf(async->bin_buffer + async->bin_size,MAX_LOG_ENTRY_SIZE,
+									APT_LOG_MARK,APT_PRIO_WARNING,"Dropped [%u] Log Entries",
+									dropped - async->dropped_reported);
+		}
+		async->size += apr_snprintf(async->buffer + async->size,MAX_LOG_ENTRY_SIZE,"%sDropped [%u] Log Entries\n",
+								priority_snames[APT_PRIO_WARNING],
+								dropped - async->dropped_reported);
+		async->dropped_reported = dropped;
+		status = TRUE;
+	}
+
+	apt_log_async_flush(async);
+	return status;
+}
+
+static void* APR_THREAD_FUNC apt_log_async_run(apr_thread_t *thread, void *data)
+{
+	apt_log_async_t *async = data;
+	while(apr_atomic_read32(&async->running)) {
+		if(apt_log_async_drain(async) == FALSE) {
+			apr_sleep(ASYNC_IDLE_TIMEOUT);
+		}
+	}
+	/* write out what is left */
+	apt_log_async_drain(async);
+
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+APT_DECLARE(apt_bool_t) apt_log_async_enable(apr_size_t ring_size)
+{
+	apt_log_async_t *async;
+	apr_size_t size;
+	if(!apt_logger || apt_logger->async) {
+		return FALSE;
+	}
+
+	if(!ring_size) {
+		ring_size = ASYNC_RING_SIZE_DEFAULT;
+	}
+	/* round up to a power of two, which fits at least one max sized entry */
+	size = MAX_LOG_ENTRY_SIZE * 2;
+	while(size < ring_size) {
+		size <<= 1;
+	}
+
+	async = apr_palloc(apt_logger->pool,sizeof(apt_log_async_t));
+	async->ring_size = size;
+	async->rings = NULL;
+	async->dropped_reported = 0;
+	async->size = 0;
+	async->bin_size = 0;
+	async->running = 1;
+	if(apr_threadkey_private_create(&async->key,apt_log_ring_orphan,apt_logger->pool) != APR_SUCCESS) {
+		return FALSE;
+	}
+	if(apr_thread_mutex_create(&async->guard,APR_THREAD_MUTEX_DEFAULT,apt_logger->pool) != APR_SUCCESS) {
+		apr_threadkey_private_delete(async->key);
+		return FALSE;
+	}
+	if(apr_thread_create(&async->thread,NULL,apt_log_async_run,async,apt_logger->pool) != APR_SUCCESS) {
+		apr_thread_mutex_destroy(async->guard);
+		apr_threadkey_private_delete(async->key);
+		return FALSE;
+	}
+
+	apt_logger->async = async;
+	return TRUE;
+}
+
+APT_DECLARE(apt_bool_t) apt_log_async_disable(void)
+{
+	apr_status_t rv;
+	apt_log_async_t *async;
+	apt_log_ring_t *ring;
+	if(!apt_logger || !apt_logger->async) {
+		return FALSE;
+	}
+
+	async = apt_logger->async;
+	/* further entries are written synchronously */
+	apt_logger->async = NULL;
+
+	apr_atomic_set32(&async->running,0);
+	apr_thread_join(&rv,async->thread);
+
+	while(async->rings) {
+		ring = async->rings;
+		async->rings = ring->next;
+		free(ring->buffer);
+		free(ring);
+	}
+	apr_thread_mutex_destroy(async->guard);
+	apr_threadkey_private_delete(async->key);
+	return TRUE;
+}
+
+APT_DECLARE(apr_size_t) apt_log_async_dropped_get(void)
+{
+	apr_size_t dropped = 0;
+	apt_log_async_t *async;
+	apt_log_ring_t *ring;
+	if(!apt_logger || !apt_logger->async) {
+		return 0;
+	}
+
+	async = apt_logger->async;
+	apr_thread_mutex_lock(async->guard);
+	for(ring = async->rings; ring; ring = ring->next) {
+		dropped += apr_atomic_read32(&ring->dropped);
+	}
+	apr_thread_mutex_unlock(async->guard);
+	return dropped;
+}
+
+static APR_INLINE char* apt_log_binary_put(char *pos, const void *value, apr_size_t size)
+{
+	memcpy(pos,value,size);
+	return pos + size;
+}
+
+static APR_INLINE char* apt_log_binary_string_put(char *pos, const char *end, const char *str, apr_size_t length)
+{
+	apr_uint16_t length16;
+	if(length > (apr_size_t)(end - pos) - sizeof(length16)) {
+		length = (apr_size_t)(end - pos) - sizeof(length16);
+	}
+	length16 = (apr_uint16_t)length;
+	pos = apt_log_binary_put(pos,&length16,sizeof(length16));
+	return apt_log_binary_put(pos,str,length);
+}
+
+static APR_INLINE void apt_log_binary_size_set(char *record, char *end)
+{
+	apr_uint16_t size = (apr_uint16_t)(end - record);
+	memcpy(record,&size,sizeof(size));
+}
+
+static apr_size_t apt_log_binary_template_make(char *record, apr_size_t max_size, apr_uint32_t id, const char *file, int line, const char *format)
+{
+	char *pos = record + sizeof(apr_uint16_t);
+	char *end = record + max_size;
+	apr_uint32_t line32 = (apr_uint32_t)line;
+	*pos++ = BINARY_RECORD_TEMPLATE;
+	pos = apt_log_binary_put(pos,&id,sizeof(id));
+	pos = apt_log_binary_put(pos,&line32,sizeof(line32));
+	pos = apt_log_binary_string_put(pos,end - sizeof(apr_uint16_t),file,strlen(file));
+	pos = apt_log_binary_string_put(pos,end,format,strlen(format));
+	apt_log_binary_size_set(record,pos);
+	return pos - record;
+}
+
+/** Find or assign the id of message template, the template record is written on assignment */
+static apr_uint32_t apt_log_binary_template_get(const char *file, int line, const char *format)
+{
+	char record[MAX_LOG_ENTRY_SIZE];
+	apr_size_t i;
+	apr_size_t index = ((apr_size_t)format >> 3) % BINARY_TEMPLATE_COUNT;
+	for(i=0; i<BINARY_TEMPLATE_PROBES; i++, index = (index + 1) % BINARY_TEMPLATE_COUNT) {
+		apt_log_template_t *tmpl = &log_templates[index];
+		void *cur = tmpl->format;
+		if(!cur) {
+			cur = apr_atomic_casptr((volatile void**)&tmpl->format,(void*)format,NULL);
+			if(!cur) {
+				tmpl->file = file;
+				tmpl->line = line;
+				apr_atomic_set32(&tmpl->ready,1);
+				/* written out synchronously (even in async mode), which guarantees
+				the template precedes the entries referring to it and is never dropped */
+				apt_log_file_dump(apt_logger->file_data,record,
+					apt_log_binary_template_make(record,sizeof(record),(apr_uint32_t)index + 1,file,line,format));
+				return (apr_uint32_t)index + 1;
+			}
+		}
+		if(cur == format) {
+			return (apr_uint32_t)index + 1;
+		}
+	}
+
+	/* table is full, define the template for this entry only */
+	apt_log_file_dump(apt_logger->file_data,record,apt_log_binary_template_make(record,sizeof(record),0,file,line,format));
+	return 0;
+}
+
+static void apt_log_binary_templates_dump(FILE *file)
+{
+	char record[MAX_LOG_ENTRY_SIZE];
+	apr_size_t i;
+	for(i=0; i<BINARY_TEMPLATE_COUNT; i++) {
+		apt_log_template_t *tmpl = &log_templates[i];
+		if(apr_atomic_read32(&tmpl->ready)) {
+			apr_size_t size = apt_log_binary_template_make(record,sizeof(record),(apr_uint32_t)i + 1,
+								tmpl->file,tmpl->line,tmpl->format);
+			fwrite(record,1,size,file);
+		}
+	}
+}
+
+/** Serialize the arguments following the conversions of format */
+static char* apt_log_binary_args_put(char *pos, const char *end, const char *format, va_list arg_ptr, apr_byte_t *count)
+{
+	const char *p = format;
+	while((p = strchr(p,'%')) != NULL) {
+		int lmod = 0; /* 0 - int, 1 - long, 2 - 64-bit, 3 - size */
+		long precision = -1;
+		char type;
+		apr_int64_t ivalue = 0;
+		apr_uint64_t uvalue = 0;
+		double fvalue = 0;
+		const char *str = NULL;
+
+		p++;
+		if(*p == '%') {
+			p++;
+			continue;
+		}
+		/* 9 bytes of a numeric argument at most, strings are truncated */
+		if(end - pos < 16) {
+			break;
+		}
+
+		while(*p && strchr("-+ #0",*p)) p++;
+		if(*p == '*') {
+			apr_int64_t width = va_arg(arg_ptr,int);
+			*pos++ = 'i';
+			pos = apt_log_binary_put(pos,&width,sizeof(width));
+			(*count)++;
+			p++;
+		}
+		else {
+			while(apr_isdigit(*p)) p++;
+		}
+		if(*p == '.') {
+			p++;
+			if(*p == '*') {
+				apr_int64_t value = va_arg(arg_ptr,int);
+				precision = (long)value;
+				*pos++ = 'i';
+				pos = apt_log_binary_put(pos,&value,sizeof(value));
+				(*count)++;
+				p++;
+			}
+			else {
+				precision = 0;
+				while(apr_isdigit(*p)) {
+					precision = precision * 10 + (*p - '0');
+					p++;
+				}
+			}
+		}
+		for(;;) {
+			if(*p == 'h') p++;
+			else if(*p == 'l') { lmod++; p++; }
+			else if(*p == 'q' || *p == 'j' || *p == 'L') { lmod = 2; p++; }
+			else if(*p == 'z' || *p == 't') { lmod = 3; p++; }
+			else if(*p == 'I' && p[1] == '6' && p[2] == '4') { lmod = 2; p += 3; }
+			else break;
+		}
+
+		switch(*p) {
+			case 'd':
+			case 'i':
+				type = 'i';
+				if(lmod == 1) ivalue = va_arg(arg_ptr,long);
+				else if(lmod == 2) ivalue = va_arg(arg_ptr,apr_int64_t);
+				else if(lmod == 3) ivalue = va_arg(arg_ptr,apr_ssize_t);
+				else ivalue = va_arg(arg_ptr,int);
+				break;
+			case 'u':
+			case 'x':
+			case 'X':
+			case 'o':
+			case 'c':
+				type = 'u';
+				if(lmod == 1) uvalue = va_arg(arg_ptr,unsigned long);
+				else if(lmod == 2) uvalue = va_arg(arg_ptr,apr_uint64_t);
+				else if(lmod == 3) uvalue = va_arg(arg_ptr,apr_size_t);
+				else uvalue = va_arg(arg_ptr,unsigned int);
+				break;
+			case 'f':
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+				type = 'f';
+				fvalue = va_arg(arg_ptr,double);
+				break;
+			case 's':
+				type = 's';
+				str = va_arg(arg_ptr,const char*);
+				break;
+			case 'p':
+				type = 'p';
+				uvalue = (apr_uint64_t)(apr_size_t)va_arg(arg_ptr,void*);
+				break;
+			default:
+				/* unknown conversion, the type of the rest of arguments is unknown too */
+				return pos;
+		}
+		p++;
+
+		*pos++ = type;
+		if(type == 'i') {
+			pos = apt_log_binary_put(pos,&ivalue,sizeof(ivalue));
+		}
+		else if(type == 'f') {
+			pos = apt_log_binary_put(pos,&fvalue,sizeof(fvalue));
+		}
+		else if(type == 's') {
+			apr_size_t length = 0;
+			if(!str) {
+				str = "(null)";
+			}
+			/* precision bounds strings which are not null terminated */
+			while((precision < 0 || length < (apr_size_t)precision) && str[length]) {
+				length++;
+			}
+			pos = apt_log_binary_string_put(pos,end,str,length);
+		}
+		else {
+			pos = apt_log_binary_put(pos,&uvalue,sizeof(uvalue));
+		}
+		(*count)++;
+	}
+	return pos;
+}
+
+static apr_size_t apt_log_binary_entry_make(char *record, apr_size_t max_size, const char *file, int line,
+											apt_log_priority_e priority, void *obj, const char *format, va_list arg_ptr)
+{
+	char *pos = record + sizeof(apr_uint16_t);
+	char *end = record + max_size;
+	apr_uint64_t now = apr_time_now();
+	apr_uint64_t thread = apt_thread_id_get();
+	apr_uint64_t object = (apr_uint64_t)(apr_size_t)obj;
+	apr_uint32_t id = apt_log_binary_template_get(file,line,format);
+	apr_byte_t *count;
+
+	*pos++ = BINARY_RECORD_ENTRY;
+	pos = apt_log_binary_put(pos,&now,sizeof(now));
+	pos = apt_log_binary_put(pos,&thread,sizeof(thread));
+	*pos++ = (char)priority;
+	pos = apt_log_binary_put(pos,&object,sizeof(object));
+	pos = apt_log_binary_put(pos,&id,sizeof(id));
+	count = (apr_byte_t*)pos++;
+	*count = 0;
+	pos = apt_log_binary_args_put(pos,end,format,arg_ptr,count);
+	apt_log_binary_size_set(record,pos);
+	return pos - record;
+}
+
+static apr_size_t apt_log_binary_entry_printf(char *record, apr_size_t max_size, const char *file, int line,
+											apt_log_priority_e priority, const char *format, ...)
+{
+	apr_size_t size;
+	va_list arg_ptr;
+	va_start(arg_ptr,format);
+	size = apt_log_binary_entry_make(record,max_size,file,line,priority,NULL,format,arg_ptr);
+	va_end(arg_ptr);
+	return size;
+}
+
+static apt_bool_t apt_log_binary_entry(const char *file, int line, apt_log_priority_e priority, void *obj, const char *format, va_list arg_ptr)
+{
+	char record[MAX_LOG_ENTRY_SIZE];
+	apr_size_t size = apt_log_binary_entry_make(record,sizeof(record),file,line,priority,obj,format,arg_ptr);
+	if(apt_logger->async) {
+		return apt_log_async_push(apt_logger->async,record,size,TRUE);
+	}
+	return apt_log_file_dump(apt_logger->file_data,record,size);
+}
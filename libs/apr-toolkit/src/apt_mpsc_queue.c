@@ -0,0 +1,153 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <apr_atomic.h>
+#include "apt_mpsc_queue.h"
+
+/** Cell of the queue */
+typedef struct apt_mpsc_cell_t apt_mpsc_cell_t;
+
+struct apt_mpsc_cell_t {
+	volatile apr_uint32_t sequence;
+	void                 *data;
+};
+
+/** 
+ * The queue is based on the array of cells, each holding a sequence number,
+ * which tells whether the cell is ready to be written by a producer or read by the consumer.
+ * Producers reserve cells by advancing the enqueue position with CAS and
+ * the consumer advances the dequeue position without any atomic RMW on it.
+ */
+struct apt_mpsc_queue_t {
+	apt_mpsc_cell_t      *cells;
+	apr_uint32_t          mask;
+	/* separate producer and consumer positions to avoid false sharing */
+	char                  pad1[64];
+	volatile apr_uint32_t enqueue_pos;
+	char                  pad2[64];
+	apr_uint32_t          dequeue_pos;
+};
+
+/** Load with full barrier (acquire semantics) */
+static APR_INLINE apr_uint32_t apt_mpsc_load(volatile apr_uint32_t *mem)
+{
+	return apr_atomic_add32(mem,0);
+}
+
+APT_DECLARE(apt_mpsc_queue_t*) apt_mpsc_queue_create(apr_size_t size)
+{
+	apr_uint32_t i;
+	apr_uint32_t capacity = 2;
+	apt_mpsc_queue_t *queue = malloc(sizeof(apt_mpsc_queue_t));
+	while(capacity < size && capacity < 0x40000000) {
+		capacity <<= 1;
+	}
+
+	queue->cells = malloc(sizeof(apt_mpsc_cell_t) * capacity);
+	queue->mask = capacity - 1;
+	for(i=0; i<capacity; i++) {
+		queue->cells[i].sequence = i;
+		queue->cells[i].data = NULL;
+	}
+	queue->enqueue_pos = 0;
+	queue->dequeue_pos = 0;
+	return queue;
+}
+
+APT_DECLARE(void) apt_mpsc_queue_destroy(apt_mpsc_queue_t *queue)
+{
+	if(queue->cells) {
+		free(queue->cells);
+		queue->cells = NULL;
+	}
+	free(queue);
+}
+
+APT_DECLARE(apt_bool_t) apt_mpsc_queue_push(apt_mpsc_queue_t *queue, void *obj)
+{
+	apt_mpsc_cell_t *cell;
+	apr_uint32_t sequence;
+	apr_int32_t diff;
+	apr_uint32_t pos = apr_atomic_read32(&queue->enqueue_pos);
+	for(;;) {
+		cell = &queue->cells[pos & queue->mask];
+		sequence = apr_atomic_read32(&cell->sequence);
+		diff = (apr_int32_t)(sequence - pos);
+		if(diff == 0) {
+			/* the cell is free, try to reserve it */
+			apr_uint32_t prev = apr_atomic_cas32(&queue->enqueue_pos,pos + 1,pos);
+			if(prev == pos) {
+				break;
+			}
+			pos = prev;
+		}
+		else if(diff < 0) {
+			/* the queue is full */
+			return FALSE;
+		}
+		else {
+			/* another producer has reserved the cell, retry */
+			pos = apr_atomic_read32(&queue->enqueue_pos);
+		}
+	}
+
+	cell->data = obj;
+	/* publish the cell to the consumer */
+	apr_atomic_xchg32(&cell->sequence,pos + 1);
+	return TRUE;
+}
+
+APT_DECLARE(void*) apt_mpsc_queue_pop(apt_mpsc_queue_t *queue)
+{
+	void *obj;
+	apr_uint32_t pos = queue->dequeue_pos;
+	apt_mpsc_cell_t *cell = &queue->cells[pos & queue->mask];
+	apr_int32_t diff = (apr_int32_t)(apt_mpsc_load(&cell->sequence) - (pos + 1));
+	if(diff < 0) {
+		/* the queue is empty (or the cell is reserved but not published yet) */
+		return NULL;
+	}
+
+	obj = cell->data;
+	cell->data = NULL;
+	/* release the cell to producers for the next lap */
+	apr_atomic_xchg32(&cell->sequence,pos + queue->mask + 1);
+	queue->dequeue_pos = pos + 1;
+	return obj;
+}
+
+APT_DECLARE(apr_size_t) apt_mpsc_queue_drain(apt_mpsc_queue_t *queue, void **objs, apr_size_t max_count)
+{
+	apr_size_t count = 0;
+	void *obj;
+	while(count < max_count) {
+		obj = apt_mpsc_queue_pop(queue);
+		if(!obj) {
+			break;
+		}
+		objs[count++] = obj;
+	}
+	return count;
+}
+
+APT_DECLARE(apt_bool_t) apt_mpsc_queue_is_empty(const apt_mpsc_queue_t *queue)
+{
+	const apt_mpsc_cell_t *cell = &queue->cells[queue->dequeue_pos & queue->mask];
+	return (apr_int32_t)(cell->sequence - (queue->dequeue_pos + 1)) < 0 ? TRUE : FALSE;
+}
@@ -17,6 +17,7 @@
  */
 
 #include <stdlib.h>
+#include <apr_tables.h>
 #include "apt_multipart_content.h"
 #include "apt_text_stream.h"
 #include "apt_text_message.h"
@@ -37,6 +38,11 @@ struct apt_multipart_content_t {
 
 	apt_str_t         boundary;
 	apt_str_t         hyphens;
+
+	/** Segments of the content generated by reference (struct iovec), NULL if none */
+	apr_array_header_t *segments;
+	/** Beginning of the content buffer not added to the segments yet */
+	char               *segment_begin;
 };
 
 /** Create an empty multipart content */
@@ -63,9 +69,34 @@ APT_DECLARE(apt_multipart_content_t*) apt_multipart_content_create(apr_size_t ma
 
 	buffer = apr_palloc(pool,max_content_size+1);
 	apt_text_stream_init(&multipart_content->stream,buffer,max_content_size);
+	multipart_content->segments = NULL;
+	multipart_content->segment_begin = buffer;
 	return multipart_content;
 }
 
+/** Add segment of the content */
+static void apt_multipart_content_segment_add(apt_multipart_content_t *multipart_content, const char *buf, apr_size_t length)
+{
+	struct iovec *vec;
+	if(!length) {
+		return;
+	}
+	if(!multipart_content->segments) {
+		multipart_content->segments = apr_array_make(multipart_content->pool,8,sizeof(struct iovec));
+	}
+	vec = apr_array_push(multipart_content->segments);
+	vec->iov_base = (void*)buf;
+	vec->iov_len = length;
+}
+
+/** Add the content buffer written so far to the segments */
+static void apt_multipart_content_segment_flush(apt_multipart_content_t *multipart_content)
+{
+	apt_text_stream_t *stream = &multipart_content->stream;
+	apt_multipart_content_segment_add(multipart_content,multipart_content->segment_begin,stream->pos - multipart_content->segment_begin);
+	multipart_content->segment_begin = stream->pos;
+}
+
 /** Initialize content part generation */
 static apt_bool_t apt_multipart_content_initialize(apt_multipart_content_t *multipart_content)
 {
@@ -105,8 +136,8 @@ APT_DECLARE(apt_bool_t) apt_multipart_content_add(apt_multipart_content_t *multi
 	return apt_text_string_insert(&multipart_content->stream,&content_part->body);
 }
 
-/** Add content part to multipart content by specified header fields and body */
-APT_DECLARE(apt_bool_t) apt_multipart_content_add2(apt_multipart_content_t *multipart_content, const apt_str_t *content_type, const apt_str_t *content_id, const apt_str_t *body)
+/** Insert boundary and header fields of content part */
+static apt_bool_t apt_multipart_content_part_header_insert(apt_multipart_content_t *multipart_content, const apt_str_t *content_type, const apt_str_t *content_id, const apt_str_t *body)
 {
 	/* insert preceding eol, hyppens and boudnary */
 	if(apt_multipart_content_initialize(multipart_content) == FALSE) {
@@ -144,7 +175,13 @@ APT_DECLARE(apt_bool_t) apt_multipart_content_add2(apt_multipart_content_t *mult
 	}
 
 	/* insert empty line */
-	if(apt_text_eol_insert(&multipart_content->stream) == FALSE) {
+	return apt_text_eol_insert(&multipart_content->stream);
+}
+
+/** Add content part to multipart content by specified header fields and body */
+APT_DECLARE(apt_bool_t) apt_multipart_content_add2(apt_multipart_content_t *multipart_content, const apt_str_t *content_type, const apt_str_t *content_id, const apt_str_t *body)
+{
+	if(apt_multipart_content_part_header_insert(multipart_content,content_type,content_id,body) == FALSE) {
 		return FALSE;
 	}
 
@@ -157,35 +194,96 @@ APT_DECLARE(apt_bool_t) apt_multipart_content_add2(apt_multipart_content_t *mult
 	return TRUE;
 }
 
-/** Finalize multipart content generation */
-APT_DECLARE(apt_str_t*) apt_multipart_content_finalize(apt_multipart_content_t *multipart_content)
+/** Add content part to multipart content referring to the body rather than copying it */
+APT_DECLARE(apt_bool_t) apt_multipart_content_ref_add(apt_multipart_content_t *multipart_content, const apt_str_t *content_type, const apt_str_t *content_id, const apt_str_t *body)
+{
+	if(apt_multipart_content_part_header_insert(multipart_content,content_type,content_id,body) == FALSE) {
+		return FALSE;
+	}
+
+	/* the body follows the header fields written so far */
+	apt_multipart_content_segment_flush(multipart_content);
+	if(body) {
+		apt_multipart_content_segment_add(multipart_content,body->buf,body->length);
+	}
+	return TRUE;
+}
+
+/** Insert final boundary */
+static apt_bool_t apt_multipart_content_final_insert(apt_multipart_content_t *multipart_content)
 {
-	apt_text_stream_t *stream = &multipart_content->stream;
 	/* insert preceding end-of-line */
 	if(apt_text_eol_insert(&multipart_content->stream) == FALSE) {
-		return NULL;
+		return FALSE;
 	}
 	/* insert hyphens */
 	if(apt_text_string_insert(&multipart_content->stream,&multipart_content->hyphens) == FALSE) {
-		return NULL;
+		return FALSE;
 	}
 	/* insert boundary */
 	if(apt_text_string_insert(&multipart_content->stream,&multipart_content->boundary) == FALSE) {
-		return NULL;
+		return FALSE;
 	}
 	/* insert final hyphens */
 	if(apt_text_string_insert(&multipart_content->stream,&multipart_content->hyphens) == FALSE) {
-		return NULL;
+		return FALSE;
 	}
-	if(apt_text_eol_insert(&multipart_content->stream) == FALSE) {
+	return apt_text_eol_insert(&multipart_content->stream);
+}
+
+/** Finalize multipart content generation */
+APT_DECLARE(apt_str_t*) apt_multipart_content_finalize(apt_multipart_content_t *multipart_content)
+{
+	apt_text_stream_t *stream = &multipart_content->stream;
+	if(apt_multipart_content_final_insert(multipart_content) == FALSE) {
 		return NULL;
 	}
 
+	if(multipart_content->segments) {
+		/* gather the parts added by reference */
+		const struct iovec *vec;
+		apr_size_t length = 0;
+		char *buffer;
+		int i;
+		apt_multipart_content_segment_flush(multipart_content);
+		vec = (const struct iovec*)multipart_content->segments->elts;
+		for(i=0; i<multipart_content->segments->nelts; i++) {
+			length += vec[i].iov_len;
+		}
+		buffer = apr_palloc(multipart_content->pool,length+1);
+		stream->text.buf = buffer;
+		stream->text.length = length;
+		for(i=0; i<multipart_content->segments->nelts; i++) {
+			memcpy(buffer,vec[i].iov_base,vec[i].iov_len);
+			buffer += vec[i].iov_len;
+		}
+		*buffer = '\0';
+		return &stream->text;
+	}
+
 	stream->text.length = stream->pos - stream->text.buf;
 	stream->text.buf[stream->text.length] = '\0';
 	return &stream->text;
 }
 
+/** Finalize multipart content generation into vector of segments */
+APT_DECLARE(apt_bool_t) apt_multipart_content_vec_finalize(apt_multipart_content_t *multipart_content, const struct iovec **vec, apr_size_t *count, apr_size_t *length)
+{
+	int i;
+	if(apt_multipart_content_final_insert(multipart_content) == FALSE) {
+		return FALSE;
+	}
+	apt_multipart_content_segment_flush(multipart_content);
+
+	*vec = (const struct iovec*)multipart_content->segments->elts;
+	*count = multipart_content->segments->nelts;
+	*length = 0;
+	for(i=0; i<multipart_content->segments->nelts; i++) {
+		*length += (*vec)[i].iov_len;
+	}
+	return TRUE;
+}
+
 
 /** Assign body to multipart content to get (parse) each content part from */
 APT_DECLARE(apt_multipart_content_t*) apt_multipart_content_assign(const apt_str_t *body, const apt_str_t *boundary, apr_pool_t *pool)
@@ -206,6 +304,8 @@ APT_DECLARE(apt_multipart_content_t*) apt_multipart_content_assign(const apt_str
 
 	apt_string_reset(&multipart_content->hyphens);
 	apt_text_stream_init(&multipart_content->stream,body->buf,body->length);
+	multipart_content->segments = NULL;
+	multipart_content->segment_begin = body->buf;
 	return multipart_content;
 }
 
@@ -218,18 +318,12 @@ static APR_INLINE void apt_content_part_reset(apt_content_part_t *content_part)
 	content_part->length = NULL;
 }
 
-/** Get the next content part */
-APT_DECLARE(apt_bool_t) apt_multipart_content_get(apt_multipart_content_t *multipart_content, apt_content_part_t *content_part, apt_bool_t *is_final)
+/** Read the boundary preceding the next content part */
+static apt_bool_t apt_multipart_content_boundary_read(apt_multipart_content_t *multipart_content, apt_bool_t *is_final)
 {
 	apt_str_t boundary;
-	apt_header_field_t *header_field;
 	apt_text_stream_t *stream = &multipart_content->stream;
-
-	if(!content_part || !is_final) {
-		return FALSE;
-	}
 	*is_final = FALSE;
-	apt_content_part_reset(content_part);
 
 	/* skip preamble */
 	apt_text_skip_to_char(stream,'-');
@@ -273,6 +367,24 @@ APT_DECLARE(apt_bool_t) apt_multipart_content_get(apt_multipart_content_t *multi
 		}
 	}
 
+	return TRUE;
+}
+
+/** Get the next content part */
+APT_DECLARE(apt_bool_t) apt_multipart_content_get(apt_multipart_content_t *multipart_content, apt_content_part_t *content_part, apt_bool_t *is_final)
+{
+	apt_header_field_t *header_field;
+	apt_text_stream_t *stream = &multipart_content->stream;
+
+	if(!content_part || !is_final) {
+		return FALSE;
+	}
+	apt_content_part_reset(content_part);
+
+	if(apt_multipart_content_boundary_read(multipart_content,is_final) == FALSE) {
+		return FALSE;
+	}
+
 	if(*is_final == TRUE) {
 		/* final boundary => return TRUE, content remains empty */
 		return TRUE;
@@ -310,3 +422,82 @@ APT_DECLARE(apt_bool_t) apt_multipart_content_get(apt_multipart_content_t *multi
 
 	return TRUE;
 }
+
+/** Find the delimiter of the next boundary (CRLF, hyphens and boundary) */
+static const char* apt_multipart_content_delimiter_find(const apt_multipart_content_t *multipart_content, const char *pos, const char *end)
+{
+	const apt_str_t *boundary = &multipart_content->boundary;
+	for(; pos + 4 + boundary->length <= end; pos++) {
+		pos = memchr(pos,APT_TOKEN_CR,end - pos);
+		if(!pos || pos + 4 + boundary->length > end) {
+			break;
+		}
+		if(pos[1] == APT_TOKEN_LF && pos[2] == '-' && pos[3] == '-' &&
+			memcmp(pos + 4,boundary->buf,boundary->length) == 0) {
+			return pos;
+		}
+	}
+	return end;
+}
+
+static APR_INLINE apt_bool_t apt_content_span_name_is(const apt_str_t *name, const char *value, apr_size_t length)
+{
+	return (name->length == length && strncasecmp(name->buf,value,length) == 0) ? TRUE : FALSE;
+}
+
+/** Get the next content part with no copies made */
+APT_DECLARE(apt_bool_t) apt_multipart_content_span_get(apt_multipart_content_t *multipart_content, apt_content_span_t *content_span, apt_bool_t *is_final)
+{
+	apt_text_stream_t *stream = &multipart_content->stream;
+	apt_pair_t pair;
+
+	if(!content_span || !is_final) {
+		return FALSE;
+	}
+	apt_string_reset(&content_span->header);
+	apt_string_reset(&content_span->body);
+	apt_string_reset(&content_span->type);
+	apt_string_reset(&content_span->id);
+	apt_string_reset(&content_span->length);
+
+	if(apt_multipart_content_boundary_read(multipart_content,is_final) == FALSE) {
+		return FALSE;
+	}
+	if(*is_final == TRUE) {
+		/* final boundary => return TRUE, content remains empty */
+		return TRUE;
+	}
+
+	/* read header fields up to the empty line */
+	content_span->header.buf = stream->pos;
+	do {
+		if(apt_text_header_read(stream,&pair) == FALSE) {
+			return FALSE;
+		}
+		if(apt_content_span_name_is(&pair.name,CONTENT_LENGTH_HEADER,sizeof(CONTENT_LENGTH_HEADER)-1) == TRUE) {
+			content_span->length = pair.value;
+		}
+		else if(apt_content_span_name_is(&pair.name,CONTENT_TYPE_HEADER,sizeof(CONTENT_TYPE_HEADER)-1) == TRUE) {
+			content_span->type = pair.value;
+		}
+		else if(apt_content_span_name_is(&pair.name,CONTENT_ID_HEADER,sizeof(CONTENT_ID_HEADER)-1) == TRUE) {
+			content_span->id = pair.value;
+		}
+	}
+	while(pair.name.length);
+	content_span->header.length = stream->pos - content_span->header.buf;
+
+	content_span->body.buf = stream->pos;
+	if(apt_string_is_empty(&content_span->length) == FALSE) {
+		apr_size_t length = apt_size_value_parse(&content_span->length);
+		if(length > (apr_size_t)(stream->end - stream->pos)) {
+			return FALSE;
+		}
+		content_span->body.length = length;
+	}
+	else {
+		content_span->body.length = apt_multipart_content_delimiter_find(multipart_content,stream->pos,stream->end) - stream->pos;
+	}
+	stream->pos += content_span->body.length;
+	return TRUE;
+}
@@ -567,3 +567,428 @@ APT_DECLARE(const char*) nlsml_input_timestamp_end_get(const nlsml_input_t *inpu
 {
 	return input->timestamp_end;
 }
+
+/** Position of the streaming scan */
+typedef struct {
+	const char *pos;
+	const char *end;
+	/** Set if the data is not well formed */
+	apt_bool_t  error;
+} nlsml_scanner_t;
+
+/** Tag scanned */
+typedef struct {
+	/** Local name of the element */
+	apt_str_t   name;
+	/** Whether the tag is the end tag </name> */
+	apt_bool_t  is_end;
+	/** Whether the element is empty <name/> */
+	apt_bool_t  is_empty;
+	/** Beginning of the tag ('<') */
+	const char *begin;
+	/** Attributes of the start tag */
+	const char *attrs;
+	const char *attrs_end;
+} nlsml_tag_t;
+
+static APR_INLINE apt_bool_t nlsml_char_is_wsp(char ch)
+{
+	return (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') ? TRUE : FALSE;
+}
+
+/** Match the local name case-insensitively, as the document based parser does */
+static APR_INLINE apt_bool_t nlsml_name_is(const apt_str_t *name, const char *value, apr_size_t length)
+{
+	return (name->length == length && strncasecmp(name->buf,value,length) == 0) ? TRUE : FALSE;
+}
+
+/** Strip the namespace prefix */
+static void nlsml_local_name_set(apt_str_t *name, const char *begin, const char *end)
+{
+	const char *pos = end;
+	while(pos > begin && *(pos - 1) != ':') pos--;
+	name->buf = (char*)pos;
+	name->length = end - pos;
+}
+
+/** Find the string of the specified length */
+static const char* nlsml_str_find(const char *pos, const char *end, const char *str, apr_size_t length)
+{
+	while(pos + length <= end) {
+		pos = memchr(pos,*str,end - pos - length + 1);
+		if(!pos) {
+			break;
+		}
+		if(memcmp(pos,str,length) == 0) {
+			return pos;
+		}
+		pos++;
+	}
+	return NULL;
+}
+
+/** Scan the next tag, skipping text, comments, CDATA sections, processing instructions and declarations */
+static apt_bool_t nlsml_tag_next(nlsml_scanner_t *scanner, nlsml_tag_t *tag)
+{
+	const char *pos = scanner->pos;
+	const char *end = scanner->end;
+	const char *name;
+	char quote = 0;
+
+	while(pos < end) {
+		pos = memchr(pos,'<',end - pos);
+		if(!pos || pos + 1 >= end) {
+			break;
+		}
+		tag->begin = pos;
+		if(pos[1] == '?' || pos[1] == '!') {
+			const char *close;
+			if(end - pos >= 4 && memcmp(pos,"<!--",4) == 0) {
+				close = nlsml_str_find(pos + 4,end,"-->",3);
+				pos = close ? close + 3 : NULL;
+			}
+			else if(end - pos >= 9 && memcmp(pos,"<![CDATA[",9) == 0) {
+				close = nlsml_str_find(pos + 9,end,"]]>",3);
+				pos = close ? close + 3 : NULL;
+			}
+			else {
+				close = memchr(pos,'>',end - pos);
+				pos = close ? close + 1 : NULL;
+			}
+			if(!pos) {
+				scanner->error = TRUE;
+				return FALSE;
+			}
+			continue;
+		}
+
+		pos++;
+		tag->is_end = FALSE;
+		tag->is_empty = FALSE;
+		if(*pos == '/') {
+			tag->is_end = TRUE;
+			pos++;
+		}
+		name = pos;
+		while(pos < end && *pos != '>' && *pos != '/' && nlsml_char_is_wsp(*pos) == FALSE) pos++;
+		if(pos == name || pos >= end) {
+			scanner->error = TRUE;
+			return FALSE;
+		}
+		nlsml_local_name_set(&tag->name,name,pos);
+
+		/* attributes may contain '>' within quotes */
+		tag->attrs = pos;
+		for(; pos < end; pos++) {
+			if(quote) {
+				if(*pos == quote) {
+					quote = 0;
+				}
+			}
+			else if(*pos == '"' || *pos == '\'') {
+				quote = *pos;
+			}
+			else if(*pos == '>') {
+				break;
+			}
+		}
+		if(pos >= end) {
+			scanner->error = TRUE;
+			return FALSE;
+		}
+		tag->attrs_end = pos;
+		if(pos > tag->attrs && *(pos - 1) == '/') {
+			tag->is_empty = TRUE;
+			tag->attrs_end--;
+		}
+		scanner->pos = pos + 1;
+		return TRUE;
+	}
+	scanner->pos = end;
+	return FALSE;
+}
+
+/** Scan the next attribute of the tag */
+static apt_bool_t nlsml_attr_next(const char **attrs, const char *end, apt_str_t *name, apt_str_t *value)
+{
+	const char *pos = *attrs;
+	const char *begin;
+	char quote;
+
+	while(pos < end && nlsml_char_is_wsp(*pos) == TRUE) pos++;
+	begin = pos;
+	while(pos < end && *pos != '=' && nlsml_char_is_wsp(*pos) == FALSE) pos++;
+	if(pos == begin) {
+		return FALSE;
+	}
+	nlsml_local_name_set(name,begin,pos);
+	while(pos < end && nlsml_char_is_wsp(*pos) == TRUE) pos++;
+	if(pos >= end || *pos != '=') {
+		return FALSE;
+	}
+	pos++;
+	while(pos < end && nlsml_char_is_wsp(*pos) == TRUE) pos++;
+	if(pos >= end || (*pos != '"' && *pos != '\'')) {
+		return FALSE;
+	}
+	quote = *pos++;
+	begin = pos;
+	pos = memchr(pos,quote,end - pos);
+	if(!pos) {
+		return FALSE;
+	}
+	value->buf = (char*)begin;
+	value->length = pos - begin;
+	*attrs = pos + 1;
+	return TRUE;
+}
+
+/** Parse confidence value of the scanned attribute */
+static float nlsml_confidence_span_parse(const apt_str_t *value)
+{
+	char buf[32];
+	apr_size_t length = value->length < sizeof(buf) - 1 ? value->length : sizeof(buf) - 1;
+	memcpy(buf,value->buf,length);
+	buf[length] = '\0';
+	return nlsml_confidence_parse(buf);
+}
+
+/** Scan the attributes of <interpretation> */
+static void nlsml_interpretation_attrs_scan(nlsml_interpretation_span_t *interpretation, const nlsml_tag_t *tag)
+{
+	const char *pos = tag->attrs;
+	apt_str_t name;
+	apt_str_t value;
+	while(nlsml_attr_next(&pos,tag->attrs_end,&name,&value) == TRUE) {
+		if(nlsml_name_is(&name,"grammar",7) == TRUE) {
+			interpretation->grammar = value;
+		}
+		else if(nlsml_name_is(&name,"confidence",10) == TRUE) {
+			interpretation->confidence = nlsml_confidence_span_parse(&value);
+		}
+	}
+}
+
+/** Scan the attributes of <input> */
+static void nlsml_input_attrs_scan(nlsml_interpretation_span_t *interpretation, const nlsml_tag_t *tag)
+{
+	const char *pos = tag->attrs;
+	apt_str_t name;
+	apt_str_t value;
+	while(nlsml_attr_next(&pos,tag->attrs_end,&name,&value) == TRUE) {
+		if(nlsml_name_is(&name,"mode",4) == TRUE) {
+			interpretation->input_mode = value;
+		}
+		else if(nlsml_name_is(&name,"confidence",10) == TRUE) {
+			interpretation->input_confidence = nlsml_confidence_span_parse(&value);
+		}
+		else if(nlsml_name_is(&name,"timestamp-start",15) == TRUE) {
+			interpretation->input_timestamp_start = value;
+		}
+		else if(nlsml_name_is(&name,"timestamp-end",13) == TRUE) {
+			interpretation->input_timestamp_end = value;
+		}
+	}
+}
+
+static void nlsml_interpretation_span_init(nlsml_interpretation_span_t *interpretation)
+{
+	interpretation->confidence = 1.0;
+	apt_string_reset(&interpretation->grammar);
+	interpretation->instance_count = 0;
+	interpretation->input_present = FALSE;
+	apt_string_reset(&interpretation->input);
+	apt_string_set(&interpretation->input_mode,"speech");
+	interpretation->input_confidence = 1.0;
+	apt_string_reset(&interpretation->input_timestamp_start);
+	apt_string_reset(&interpretation->input_timestamp_end);
+}
+
+/** Scan NLSML result without building the document */
+APT_DECLARE(apt_bool_t) nlsml_result_scan(
+							const char *data, 
+							apr_size_t length, 
+							apt_str_t *grammar, 
+							nlsml_interpretation_span_handler_f handler, 
+							void *obj)
+{
+	nlsml_scanner_t scanner;
+	nlsml_tag_t tag;
+	nlsml_interpretation_span_t interpretation;
+	/* depth of the element, the root <result> is at 1 */
+	apr_size_t depth = 0;
+	/* beginning of the content of <instance> or <input> being scanned */
+	const char *content = NULL;
+	apt_str_t *content_span = NULL;
+	apt_bool_t in_interpretation = FALSE;
+
+	if(grammar) {
+		apt_string_reset(grammar);
+	}
+	if(!data || !length) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No NLSML data available");
+		return FALSE;
+	}
+
+	scanner.pos = data;
+	scanner.end = data + length;
+	scanner.error = FALSE;
+	while(nlsml_tag_next(&scanner,&tag) == TRUE) {
+		if(tag.is_end == TRUE) {
+			if(!depth) {
+				scanner.error = TRUE;
+				break;
+			}
+			depth--;
+			if(depth == 2 && content_span) {
+				/* end of <instance> or <input> */
+				content_span->buf = (char*)content;
+				content_span->length = tag.begin - content;
+				content_span = NULL;
+			}
+			else if(depth == 1 && in_interpretation == TRUE) {
+				in_interpretation = FALSE;
+				if(handler && handler(obj,&interpretation) == FALSE) {
+					return TRUE;
+				}
+			}
+			else if(depth == 0) {
+				/* end of <result>, the rest is ignored */
+				return TRUE;
+			}
+			continue;
+		}
+
+		if(depth == 0) {
+			/* NLSML validity check: root element must be <result> */
+			if(nlsml_name_is(&tag.name,"result",6) == FALSE) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected NLSML root element <%.*s>",(int)tag.name.length,tag.name.buf);
+				return FALSE;
+			}
+			if(grammar) {
+				const char *pos = tag.attrs;
+				apt_str_t name;
+				apt_str_t value;
+				while(nlsml_attr_next(&pos,tag.attrs_end,&name,&value) == TRUE) {
+					if(nlsml_name_is(&name,"grammar",7) == TRUE) {
+						*grammar = value;
+					}
+				}
+			}
+		}
+		else if(depth == 1) {
+			if(nlsml_name_is(&tag.name,"interpretation",14) == TRUE) {
+				nlsml_interpretation_span_init(&interpretation);
+				nlsml_interpretation_attrs_scan(&interpretation,&tag);
+				in_interpretation = TRUE;
+				if(tag.is_empty == TRUE) {
+					in_interpretation = FALSE;
+					if(handler && handler(obj,&interpretation) == FALSE) {
+						return TRUE;
+					}
+				}
+			}
+		}
+		else if(depth == 2 && in_interpretation == TRUE) {
+			content_span = NULL;
+			if(nlsml_name_is(&tag.name,"instance",8) == TRUE) {
+				if(interpretation.instance_count < NLSML_SCAN_MAX_INSTANCE_COUNT) {
+					content_span = &interpretation.instances[interpretation.instance_count];
+					apt_string_reset(content_span);
+				}
+				interpretation.instance_count++;
+			}
+			else if(nlsml_name_is(&tag.name,"input",5) == TRUE) {
+				interpretation.input_present = TRUE;
+				apt_string_reset(&interpretation.input);
+				nlsml_input_attrs_scan(&interpretation,&tag);
+				content_span = &interpretation.input;
+			}
+			content = scanner.pos;
+			if(tag.is_empty == TRUE) {
+				content_span = NULL;
+			}
+		}
+
+		if(tag.is_empty == FALSE) {
+			depth++;
+		}
+	}
+
+	if(scanner.error == TRUE || depth) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to scan NLSML data");
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No NLSML root element");
+	return FALSE;
+}
+
+/** Generate a plain text of the scanned content */
+APT_DECLARE(const char*) nlsml_span_text_generate(const apt_str_t *span, apr_pool_t *pool)
+{
+	const char *pos = span->buf;
+	const char *end = span->buf + span->length;
+	char *text = apr_palloc(pool,span->length + 1);
+	char *out = text;
+
+	while(pos < end) {
+		if(*pos == '&') {
+			const char *semicolon = memchr(pos,';',end - pos);
+			apr_size_t length = semicolon ? semicolon - pos - 1 : 0;
+			const char *entity = pos + 1;
+			unsigned long code = 0;
+			if(length > 1 && length < 8 && *entity == '#') {
+				char buf[8];
+				memcpy(buf,entity + 1,length - 1);
+				buf[length - 1] = '\0';
+				code = (buf[0] == 'x' || buf[0] == 'X') ? strtoul(buf + 1,NULL,16) : strtoul(buf,NULL,10);
+			}
+			if(length == 2 && strncmp(entity,"lt",2) == 0) *out++ = '<';
+			else if(length == 2 && strncmp(entity,"gt",2) == 0) *out++ = '>';
+			else if(length == 3 && strncmp(entity,"amp",3) == 0) *out++ = '&';
+			else if(length == 4 && strncmp(entity,"quot",4) == 0) *out++ = '"';
+			else if(length == 4 && strncmp(entity,"apos",4) == 0) *out++ = '\'';
+			else if(code) {
+				/* UTF-8 takes no more bytes than the reference itself */
+				if(code < 0x80) {
+					*out++ = (char)code;
+				}
+				else if(code < 0x800) {
+					*out++ = (char)(0xC0 | (code >> 6));
+					*out++ = (char)(0x80 | (code & 0x3F));
+				}
+				else if(code < 0x10000) {
+					*out++ = (char)(0xE0 | (code >> 12));
+					*out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+					*out++ = (char)(0x80 | (code & 0x3F));
+				}
+				else {
+					*out++ = (char)(0xF0 | (code >> 18));
+					*out++ = (char)(0x80 | ((code >> 12) & 0x3F));
+					*out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+					*out++ = (char)(0x80 | (code & 0x3F));
+				}
+			}
+			else {
+				/* not a known entity, copied as is */
+				*out++ = *pos++;
+				continue;
+			}
+			pos = semicolon + 1;
+		}
+		else if(*pos == '<' && end - pos >= 12 && memcmp(pos,"<![CDATA[",9) == 0) {
+			const char *close = nlsml_str_find(pos + 9,end,"]]>",3);
+			if(!close) {
+				close = end;
+			}
+			memcpy(out,pos + 9,close - pos - 9);
+			out += close - pos - 9;
+			pos = close + 3 < end ? close + 3 : end;
+		}
+		else {
+			*out++ = *pos++;
+		}
+	}
+	*out = '\0';
+	return text;
+}
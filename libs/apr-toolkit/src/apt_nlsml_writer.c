@@ -0,0 +1,268 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <string.h>
+#include <apr_strings.h>
+#include "apt_nlsml_writer.h"
+#include "apt_text_scan.h"
+
+/** Literal of the pre-escaped template */
+#define NLSML_LITERAL(writer,str) nlsml_writer_literal(writer,str,sizeof(str) - 1)
+
+/** Writer of either pass: counts the length if no buffer is set yet */
+typedef struct {
+	/** Buffer to write to (NULL on the counting pass) */
+	char             *pos;
+	/** Length of the document */
+	apr_size_t        length;
+	/** Scanner of the characters to escape */
+	const apt_text_scanner_t *scanner;
+} nlsml_writer_t;
+
+static APR_INLINE void nlsml_writer_literal(nlsml_writer_t *writer, const char *str, apr_size_t length)
+{
+	if(writer->pos) {
+		memcpy(writer->pos,str,length);
+		writer->pos += length;
+	}
+	writer->length += length;
+}
+
+static APR_INLINE void nlsml_writer_str(nlsml_writer_t *writer, const char *str)
+{
+	nlsml_writer_literal(writer,str,strlen(str));
+}
+
+/** Write the text escaping markup, in attribute values quotes are escaped instead of '>' */
+static void nlsml_writer_escaped(nlsml_writer_t *writer, const char *text, apt_bool_t attribute)
+{
+	const char *pos = text;
+	const char *end = text + strlen(text);
+	const char *special;
+	while(pos < end) {
+		/* runs of plain characters are skipped by vector compare */
+		special = writer->scanner->chr3_find(pos,end,'<','&',attribute == TRUE ? '"' : '>');
+		nlsml_writer_literal(writer,pos,special - pos);
+		if(special == end) {
+			break;
+		}
+		switch(*special) {
+			case '<': NLSML_LITERAL(writer,"&lt;"); break;
+			case '&': NLSML_LITERAL(writer,"&amp;"); break;
+			case '>': NLSML_LITERAL(writer,"&gt;"); break;
+			default:  NLSML_LITERAL(writer,"&quot;"); break;
+		}
+		pos = special + 1;
+	}
+}
+
+static void nlsml_writer_float(nlsml_writer_t *writer, float value)
+{
+	char buf[32];
+	int length = apr_snprintf(buf,sizeof(buf),"%.2f",value);
+	if(length > 0) {
+		nlsml_writer_literal(writer,buf,length);
+	}
+}
+
+static void nlsml_writer_attr(nlsml_writer_t *writer, const char *name, apr_size_t length, const char *value)
+{
+	if(value) {
+		nlsml_writer_literal(writer,name,length);
+		nlsml_writer_escaped(writer,value,TRUE);
+		NLSML_LITERAL(writer,"\"");
+	}
+}
+
+static void nlsml_writer_result_begin(nlsml_writer_t *writer, const char *grammar)
+{
+	NLSML_LITERAL(writer,"<?xml version=\"1.0\"?>\r\n<result");
+	nlsml_writer_attr(writer," grammar=\"",10,grammar);
+	NLSML_LITERAL(writer,">\r\n");
+}
+
+static void nlsml_writer_interpretation(nlsml_writer_t *writer, const nlsml_interpretation_spec_t *interpretation)
+{
+	NLSML_LITERAL(writer,"  <interpretation");
+	nlsml_writer_attr(writer," grammar=\"",10,interpretation->grammar);
+	if(interpretation->confidence >= 0) {
+		NLSML_LITERAL(writer," confidence=\"");
+		nlsml_writer_float(writer,interpretation->confidence);
+		NLSML_LITERAL(writer,"\"");
+	}
+	NLSML_LITERAL(writer,">\r\n");
+
+	if(interpretation->instance_xml) {
+		NLSML_LITERAL(writer,"    <instance>");
+		nlsml_writer_str(writer,interpretation->instance_xml);
+		NLSML_LITERAL(writer,"</instance>\r\n");
+	}
+	else if(interpretation->instance) {
+		NLSML_LITERAL(writer,"    <instance>");
+		nlsml_writer_escaped(writer,interpretation->instance,FALSE);
+		NLSML_LITERAL(writer,"</instance>\r\n");
+	}
+
+	if(interpretation->input) {
+		NLSML_LITERAL(writer,"    <input");
+		nlsml_writer_attr(writer," mode=\"",7,interpretation->input_mode);
+		if(interpretation->input_confidence >= 0) {
+			NLSML_LITERAL(writer," confidence=\"");
+			nlsml_writer_float(writer,interpretation->input_confidence);
+			NLSML_LITERAL(writer,"\"");
+		}
+		NLSML_LITERAL(writer,">");
+		nlsml_writer_escaped(writer,interpretation->input,FALSE);
+		NLSML_LITERAL(writer,"</input>\r\n");
+	}
+	NLSML_LITERAL(writer,"  </interpretation>\r\n");
+}
+
+static void nlsml_writer_element(nlsml_writer_t *writer, const char *name, const char *value)
+{
+	if(value) {
+		NLSML_LITERAL(writer,"        <");
+		nlsml_writer_str(writer,name);
+		NLSML_LITERAL(writer,">");
+		nlsml_writer_escaped(writer,value,FALSE);
+		NLSML_LITERAL(writer,"</");
+		nlsml_writer_str(writer,name);
+		NLSML_LITERAL(writer,">\r\n");
+	}
+}
+
+static void nlsml_writer_verification(nlsml_writer_t *writer, const char *name, const nlsml_verification_spec_t *verification)
+{
+	if(!verification) {
+		return;
+	}
+	NLSML_LITERAL(writer,"      <");
+	nlsml_writer_str(writer,name);
+	NLSML_LITERAL(writer,">\r\n");
+	if(verification->utterance_length) {
+		char buf[32];
+		apr_snprintf(buf,sizeof(buf),"%"APR_SIZE_T_FMT,verification->utterance_length);
+		nlsml_writer_element(writer,"utterance-length",buf);
+	}
+	nlsml_writer_element(writer,"device",verification->device);
+	nlsml_writer_element(writer,"gender",verification->gender);
+	nlsml_writer_element(writer,"decision",verification->decision);
+	if(verification->verification_score >= 0) {
+		NLSML_LITERAL(writer,"        <verification-score>");
+		nlsml_writer_float(writer,verification->verification_score);
+		NLSML_LITERAL(writer,"</verification-score>\r\n");
+	}
+	NLSML_LITERAL(writer,"      </");
+	nlsml_writer_str(writer,name);
+	NLSML_LITERAL(writer,">\r\n");
+}
+
+static void nlsml_recognition_result_write(
+				nlsml_writer_t *writer,
+				const char *grammar,
+				const nlsml_interpretation_spec_t *interpretations,
+				apr_size_t count)
+{
+	apr_size_t i;
+	nlsml_writer_result_begin(writer,grammar);
+	for(i=0; i<count; i++) {
+		nlsml_writer_interpretation(writer,&interpretations[i]);
+	}
+	NLSML_LITERAL(writer,"</result>\r\n");
+}
+
+static void nlsml_verification_result_write(
+				nlsml_writer_t *writer,
+				const char *grammar,
+				const nlsml_voiceprint_spec_t *voiceprints,
+				apr_size_t count)
+{
+	apr_size_t i;
+	nlsml_writer_result_begin(writer,grammar);
+	NLSML_LITERAL(writer,"  <verification-result>\r\n");
+	for(i=0; i<count; i++) {
+		NLSML_LITERAL(writer,"    <voiceprint");
+		nlsml_writer_attr(writer," id=\"",5,voiceprints[i].id);
+		NLSML_LITERAL(writer,">\r\n");
+		nlsml_writer_verification(writer,"incremental",voiceprints[i].incremental);
+		nlsml_writer_verification(writer,"cumulative",voiceprints[i].cumulative);
+		NLSML_LITERAL(writer,"    </voiceprint>\r\n");
+	}
+	NLSML_LITERAL(writer,"  </verification-result>\r\n");
+	NLSML_LITERAL(writer,"</result>\r\n");
+}
+
+static void nlsml_writer_init(nlsml_writer_t *writer)
+{
+	writer->pos = NULL;
+	writer->length = 0;
+	writer->scanner = apt_text_scanner_active_get();
+}
+
+/** Allocate the buffer of the counted length and start the writing pass */
+static char* nlsml_writer_buffer_alloc(nlsml_writer_t *writer, apt_str_t *body, apr_pool_t *pool)
+{
+	body->buf = apr_palloc(pool,writer->length + 1);
+	body->length = writer->length;
+	writer->pos = body->buf;
+	writer->length = 0;
+	return body->buf;
+}
+
+/** Generate NLSML result with interpretations */
+APT_DECLARE(apt_bool_t) nlsml_recognition_result_generate(
+							const char *grammar,
+							const nlsml_interpretation_spec_t *interpretations,
+							apr_size_t count,
+							apt_str_t *body,
+							apr_pool_t *pool)
+{
+	nlsml_writer_t writer;
+	if(!interpretations || !count) {
+		/* at least one interpretation MUST be specified */
+		return FALSE;
+	}
+
+	nlsml_writer_init(&writer);
+	nlsml_recognition_result_write(&writer,grammar,interpretations,count);
+	nlsml_writer_buffer_alloc(&writer,body,pool);
+	nlsml_recognition_result_write(&writer,grammar,interpretations,count);
+	*writer.pos = '\0';
+	return TRUE;
+}
+
+/** Generate NLSML result with verification result */
+APT_DECLARE(apt_bool_t) nlsml_verification_result_generate(
+							const char *grammar,
+							const nlsml_voiceprint_spec_t *voiceprints,
+							apr_size_t count,
+							apt_str_t *body,
+							apr_pool_t *pool)
+{
+	nlsml_writer_t writer;
+	if(!voiceprints || !count) {
+		return FALSE;
+	}
+
+	nlsml_writer_init(&writer);
+	nlsml_verification_result_write(&writer,grammar,voiceprints,count);
+	nlsml_writer_buffer_alloc(&writer,body,pool);
+	nlsml_verification_result_write(&writer,grammar,voiceprints,count);
+	*writer.pos = '\0';
+	return TRUE;
+}
@@ -25,13 +25,46 @@
 struct apt_list_elem_t {
 	APR_RING_ENTRY(apt_list_elem_t) link;
 	void                           *obj;
+	/** Whether the element is owned by the list and recycled once removed */
+	apt_bool_t                      owned;
 };
 
 struct apt_obj_list_t {
 	APR_RING_HEAD(apt_list_head_t, apt_list_elem_t) head;
+	/** Removed elements owned by the list, reused by the next insertions */
+	APR_RING_HEAD(apt_list_free_t, apt_list_elem_t) free_head;
 	apr_pool_t                                     *pool;
 };
 
+/** Allocate element either from the pool or from the free list of the list */
+static apt_list_elem_t* apt_list_elem_alloc(apt_obj_list_t *list, void *obj, apr_pool_t *pool)
+{
+	apt_list_elem_t *elem;
+	if(pool) {
+		elem = apr_palloc(pool,sizeof(apt_list_elem_t));
+		elem->owned = FALSE;
+	}
+	else if(!APR_RING_EMPTY(&list->free_head,apt_list_elem_t,link)) {
+		elem = APR_RING_FIRST(&list->free_head);
+		APR_RING_REMOVE(elem,link);
+	}
+	else {
+		elem = apr_palloc(list->pool,sizeof(apt_list_elem_t));
+		elem->owned = TRUE;
+	}
+	elem->obj = obj;
+	return elem;
+}
+
+/** Return element to the free list, if owned by the list */
+static APR_INLINE void apt_list_elem_release(apt_obj_list_t *list, apt_list_elem_t *elem)
+{
+	if(elem->owned == TRUE) {
+		elem->obj = NULL;
+		APR_RING_INSERT_HEAD(&list->free_head,elem,apt_list_elem_t,link);
+	}
+}
+
 
 
 APT_DECLARE(apt_obj_list_t*) apt_list_create(apr_pool_t *pool)
@@ -39,6 +72,7 @@ APT_DECLARE(apt_obj_list_t*) apt_list_create(apr_pool_t *pool)
 	apt_obj_list_t *list = apr_palloc(pool, sizeof(apt_obj_list_t));
 	list->pool = pool;
 	APR_RING_INIT(&list->head, apt_list_elem_t, link);
+	APR_RING_INIT(&list->free_head, apt_list_elem_t, link);
 	return list;
 }
 
@@ -49,9 +83,7 @@ APT_DECLARE(void) apt_list_destroy(apt_obj_list_t *list)
 
 APT_DECLARE(apt_list_elem_t*) apt_list_push_back(apt_obj_list_t *list, void *obj, apr_pool_t *pool)
 {
-	apt_list_elem_t *elem = apr_palloc(pool,sizeof(apt_list_elem_t));
-	elem->obj = obj;
-
+	apt_list_elem_t *elem = apt_list_elem_alloc(list,obj,pool);
 	APR_RING_INSERT_TAIL(&list->head,elem,apt_list_elem_t,link);
 	return elem;
 }
@@ -59,12 +91,15 @@ APT_DECLARE(apt_list_elem_t*) apt_list_push_back(apt_obj_list_t *list, void *obj
 APT_DECLARE(void*) apt_list_pop_front(apt_obj_list_t *list)
 {
 	apt_list_elem_t *elem;
+	void *obj;
 	if(APR_RING_EMPTY(&list->head,apt_list_elem_t,link)) {
 		return NULL;
 	}
 	elem = APR_RING_FIRST(&list->head);
 	APR_RING_REMOVE(elem,link);
-	return elem->obj;
+	obj = elem->obj;
+	apt_list_elem_release(list,elem);
+	return obj;
 }
 
 APT_DECLARE(void*) apt_list_head(const apt_obj_list_t *list)
@@ -123,8 +158,7 @@ APT_DECLARE(apt_list_elem_t*) apt_list_prev_elem_get(const apt_obj_list_t *list,
 
 APT_DECLARE(apt_list_elem_t*) apt_list_elem_insert(apt_obj_list_t *list, apt_list_elem_t *elem, void *obj, apr_pool_t *pool)
 {
-	apt_list_elem_t *new_elem = apr_palloc(pool,sizeof(apt_list_elem_t));
-	new_elem->obj = obj;
+	apt_list_elem_t *new_elem = apt_list_elem_alloc(list,obj,pool);
 	APR_RING_INSERT_BEFORE(elem,new_elem,link);
 	return new_elem;
 }
@@ -133,6 +167,7 @@ APT_DECLARE(apt_list_elem_t*) apt_list_elem_remove(apt_obj_list_t *list, apt_lis
 {
 	apt_list_elem_t *next_elem = APR_RING_NEXT(elem,link);
 	APR_RING_REMOVE(elem,link);
+	apt_list_elem_release(list,elem);
 	if(next_elem == APR_RING_SENTINEL(&list->head,apt_list_elem_t,link)) {
 		next_elem = NULL;
 	}
@@ -20,8 +20,12 @@
 #include "apt_task.h"
 #include "apt_pool.h"
 #include "apt_cyclic_queue.h"
+#include "apt_clock.h"
 #include "apt_log.h"
 
+/** Max number of control messages pending for poller task */
+#define POLLER_TASK_QUEUE_SIZE 1024
+
 
 /** Poller task */
 struct apt_poller_task_t {
@@ -88,7 +92,7 @@ APT_DECLARE(apt_poller_task_t*) apt_poller_task_create(
 	}
 	apt_task_auto_ready_set(task->base,FALSE);
 
-	task->msg_queue = apt_cyclic_queue_create(CYCLIC_QUEUE_DEFAULT_SIZE);
+	task->msg_queue = apt_cyclic_queue_create_fixed(POLLER_TASK_QUEUE_SIZE);
 	apr_thread_mutex_create(&task->guard,APR_THREAD_MUTEX_UNNESTED,pool);
 
 	task->timer_queue = apt_timer_queue_create(pool);
@@ -241,24 +245,25 @@ static apt_bool_t apt_poller_task_run(apt_task_t *base)
 
 	while(*running) {
 		if(apt_timer_queue_timeout_get(task->timer_queue,&queue_timeout) == TRUE) {
-			timeout = (apr_interval_time_t)queue_timeout * 1000;
-			time_last = apr_time_now();
-			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Wait for Messages [%s] timeout [%u]",
-				task_name, queue_timeout);
+			timeout = apt_clock_wait_timeout_get((apr_interval_time_t)queue_timeout * 1000);
+			time_last = apt_clock_now();
 		}
 		else {
 			timeout = -1;
-			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Wait for Messages [%s]",task_name);
 		}
 		status = apt_pollset_poll(task->pollset, timeout, &task->desc_count, (const apr_pollfd_t **) &task->desc_arr);
 		if(status != APR_SUCCESS && status != APR_TIMEUP) {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Poll [%s] status: %d",task_name,status);
 			continue;
 		}
+		if(task->desc_count) {
+			/* a single log entry per batch of signalled descriptors */
+			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Process [%d] Signalled Descriptors [%s]",
+				task->desc_count, task_name);
+		}
 		for(task->desc_index = 0; task->desc_index < task->desc_count; task->desc_index++) {
 			const apr_pollfd_t *descriptor = &task->desc_arr[task->desc_index];
 			if(apt_pollset_is_wakeup(task->pollset,descriptor)) {
-				apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Process Poller Wakeup [%s]",task_name);
 				apt_poller_task_wakeup_process(task);
 				if(*running == FALSE) {
 					break;
@@ -266,12 +271,11 @@ static apt_bool_t apt_poller_task_run(apt_task_t *base)
 				continue;
 			}
 
-			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Process Signalled Descriptor [%s]",task_name);
 			task->signal_handler(task->obj,descriptor);
 		}
 
 		if(timeout != -1) {
-			time_now = apr_time_now();
+			time_now = apt_clock_now();
 			if(time_now > time_last) {
 				apt_timer_queue_advance(task->timer_queue,(apr_uint32_t)((time_now - time_last)/1000));
 			}
@@ -283,11 +287,21 @@ static apt_bool_t apt_poller_task_run(apt_task_t *base)
 
 static apt_bool_t apt_poller_task_msg_signal(apt_task_t *base, apt_task_msg_t *msg)
 {
-	apt_bool_t status;
+	apt_bool_t status = TRUE;
+	apt_cyclic_queue_push_status_e push_status;
+	apr_size_t overload_count = 0;
 	apt_poller_task_t *task = apt_task_object_get(base);
 	apr_thread_mutex_lock(task->guard);
-	status = apt_cyclic_queue_push(task->msg_queue,msg);
+	push_status = apt_cyclic_queue_try_push(task->msg_queue,msg);
+	if(push_status == CYCLIC_QUEUE_PUSH_FULL) {
+		overload_count = apt_cyclic_queue_overload_count_get(task->msg_queue);
+	}
 	apr_thread_mutex_unlock(task->guard);
+	if(push_status == CYCLIC_QUEUE_PUSH_FULL) {
+		/* the message is not queued, still wake the task up to drain the queue */
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Control Message Queue Overloaded [%"APR_SIZE_T_FMT"]",overload_count);
+		status = FALSE;
+	}
 	if(apt_pollset_wakeup(task->pollset) != TRUE) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Signal Control Message");
 		status = FALSE;
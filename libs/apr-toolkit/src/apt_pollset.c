@@ -20,6 +20,274 @@
 #include "apt_pollset.h"
 #include "apt_log.h"
 
+#ifdef APT_HAVE_EPOLL
+/*
+ * Native epoll backend: eventfd based wakeup, optional edge-triggered
+ * descriptors and batched retrieval of signalled descriptors.
+ */
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <apr_hash.h>
+#include <apr_ring.h>
+#include <apr_atomic.h>
+#include <apr_portable.h>
+
+/** Max number of descriptors retrieved by a single poll */
+#define EPOLL_BATCH_SIZE 512
+
+typedef struct apt_pollfd_elem_t apt_pollfd_elem_t;
+
+/** Descriptor added to pollset */
+struct apt_pollfd_elem_t {
+	APR_RING_ENTRY(apt_pollfd_elem_t) link;
+	apr_pollfd_t  pfd;
+};
+
+struct apt_pollset_t {
+	/** Epoll descriptor */
+	int                 epoll_fd;
+	/** Event descriptor used for wakeup */
+	int                 wakeup_fd;
+	/** Wakeup is signalled, but not processed yet */
+	volatile apr_uint32_t wakeup_pending;
+	/** Builtin wakeup poll descriptor */
+	apr_pollfd_t        wakeup_pfd;
+
+	/** Table of added descriptors (apr socket/file -> element) */
+	apr_hash_t         *elems;
+	/** Elements available for reuse */
+	APR_RING_HEAD(apt_pollfd_elem_head_t, apt_pollfd_elem_t) free_elems;
+
+	/** Retrieved events */
+	struct epoll_event *events;
+	/** Signalled descriptors */
+	apr_pollfd_t       *results;
+	/** Max number of descriptors retrieved by a single poll */
+	apr_uint32_t        batch_size;
+
+	/** Pool to allocate memory from */
+	apr_pool_t         *pool;
+};
+
+static int apt_pollset_native_get(const apr_pollfd_t *descriptor)
+{
+	apr_os_sock_t fd = -1;
+	if(descriptor->desc_type == APR_POLL_SOCKET) {
+		apr_os_sock_get(&fd,descriptor->desc.s);
+	}
+	else if(descriptor->desc_type == APR_POLL_FILE) {
+		apr_os_file_t file = -1;
+		apr_os_file_get(&file,descriptor->desc.f);
+		fd = file;
+	}
+	return fd;
+}
+
+static APR_INLINE apr_uint32_t apt_pollset_events_to_epoll(apr_int16_t reqevents)
+{
+	apr_uint32_t events = 0;
+	if(reqevents & APR_POLLIN)  events |= EPOLLIN;
+	if(reqevents & APR_POLLPRI) events |= EPOLLPRI;
+	if(reqevents & APR_POLLOUT) events |= EPOLLOUT;
+	if(reqevents & APT_POLLET)  events |= EPOLLET;
+	return events;
+}
+
+static APR_INLINE apr_int16_t apt_pollset_events_from_epoll(apr_uint32_t events)
+{
+	apr_int16_t rtnevents = 0;
+	if(events & EPOLLIN)  rtnevents |= APR_POLLIN;
+	if(events & EPOLLPRI) rtnevents |= APR_POLLPRI;
+	if(events & EPOLLOUT) rtnevents |= APR_POLLOUT;
+	if(events & EPOLLERR) rtnevents |= APR_POLLERR;
+	if(events & EPOLLHUP) rtnevents |= APR_POLLHUP;
+	return rtnevents;
+}
+
+/** Create interruptable pollset */
+APT_DECLARE(apt_pollset_t*) apt_pollset_create(apr_uint32_t size, apr_pool_t *pool)
+{
+	struct epoll_event event;
+	apt_pollset_t *pollset = apr_palloc(pool,sizeof(apt_pollset_t));
+	pollset->pool = pool;
+	pollset->wakeup_pending = 0;
+	memset(&pollset->wakeup_pfd,0,sizeof(pollset->wakeup_pfd));
+	pollset->wakeup_pfd.desc_type = APR_NO_DESC;
+	pollset->wakeup_pfd.reqevents = APR_POLLIN;
+	pollset->wakeup_pfd.rtnevents = APR_POLLIN;
+	pollset->wakeup_pfd.client_data = pollset;
+
+	pollset->batch_size = size + 1;
+	if(pollset->batch_size > EPOLL_BATCH_SIZE) {
+		pollset->batch_size = EPOLL_BATCH_SIZE;
+	}
+	pollset->events = apr_palloc(pool,sizeof(struct epoll_event) * pollset->batch_size);
+	pollset->results = apr_palloc(pool,sizeof(apr_pollfd_t) * pollset->batch_size);
+	pollset->elems = apr_hash_make(pool);
+	APR_RING_INIT(&pollset->free_elems, apt_pollfd_elem_t, link);
+
+	pollset->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(pollset->epoll_fd < 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Epoll [%d]",errno);
+		return NULL;
+	}
+
+	/* create wakeup event descriptor */
+	pollset->wakeup_fd = eventfd(0,EFD_NONBLOCK | EFD_CLOEXEC);
+	if(pollset->wakeup_fd < 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Wakeup Event [%d]",errno);
+		close(pollset->epoll_fd);
+		return NULL;
+	}
+
+	/* add wakeup event descriptor to pollset, identified by NULL element */
+	memset(&event,0,sizeof(event));
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;
+	if(epoll_ctl(pollset->epoll_fd,EPOLL_CTL_ADD,pollset->wakeup_fd,&event) != 0) {
+		close(pollset->wakeup_fd);
+		close(pollset->epoll_fd);
+		return NULL;
+	}
+	return pollset;
+}
+
+/** Destroy pollset */
+APT_DECLARE(apt_bool_t) apt_pollset_destroy(apt_pollset_t *pollset)
+{
+	close(pollset->wakeup_fd);
+	close(pollset->epoll_fd);
+	return TRUE;
+}
+
+/** Add pollset descriptor to a pollset */
+APT_DECLARE(apt_bool_t) apt_pollset_add(apt_pollset_t *pollset, const apr_pollfd_t *descriptor)
+{
+	struct epoll_event event;
+	apt_pollfd_elem_t *elem;
+	int fd = apt_pollset_native_get(descriptor);
+	if(fd < 0) {
+		return FALSE;
+	}
+
+	if(!APR_RING_EMPTY(&pollset->free_elems, apt_pollfd_elem_t, link)) {
+		elem = APR_RING_FIRST(&pollset->free_elems);
+		APR_RING_REMOVE(elem,link);
+	}
+	else {
+		elem = apr_palloc(pollset->pool,sizeof(apt_pollfd_elem_t));
+		APR_RING_ELEM_INIT(elem,link);
+	}
+	elem->pfd = *descriptor;
+
+	memset(&event,0,sizeof(event));
+	event.events = apt_pollset_events_to_epoll(descriptor->reqevents);
+	event.data.ptr = elem;
+	if(epoll_ctl(pollset->epoll_fd,EPOLL_CTL_ADD,fd,&event) != 0) {
+		APR_RING_INSERT_TAIL(&pollset->free_elems,elem,apt_pollfd_elem_t,link);
+		return FALSE;
+	}
+
+	apr_hash_set(pollset->elems,&elem->pfd.desc,sizeof(elem->pfd.desc),elem);
+	return TRUE;
+}
+
+/** Remove pollset descriptor from a pollset */
+APT_DECLARE(apt_bool_t) apt_pollset_remove(apt_pollset_t *pollset, const apr_pollfd_t *descriptor)
+{
+	struct epoll_event event;
+	apt_pollfd_elem_t *elem;
+	int fd;
+
+	elem = apr_hash_get(pollset->elems,&descriptor->desc,sizeof(descriptor->desc));
+	if(!elem) {
+		return FALSE;
+	}
+	apr_hash_set(pollset->elems,&elem->pfd.desc,sizeof(elem->pfd.desc),NULL);
+
+	fd = apt_pollset_native_get(descriptor);
+	memset(&event,0,sizeof(event));
+	if(fd >= 0) {
+		epoll_ctl(pollset->epoll_fd,EPOLL_CTL_DEL,fd,&event);
+	}
+
+	/* signalled descriptors are copies, the element can be reused right away */
+	APR_RING_INSERT_TAIL(&pollset->free_elems,elem,apt_pollfd_elem_t,link);
+	return TRUE;
+}
+
+/** Block for activity on the descriptor(s) in a pollset */
+APT_DECLARE(apr_status_t) apt_pollset_poll(
+								apt_pollset_t *pollset,
+								apr_interval_time_t timeout,
+								apr_int32_t *num,
+								const apr_pollfd_t **descriptors)
+{
+	int i;
+	int count;
+	/* round up to msec, otherwise sub-msec timeouts spin */
+	int msec = timeout < 0 ? -1 : (int)((timeout + 999) / 1000);
+
+	*num = 0;
+	count = epoll_wait(pollset->epoll_fd,pollset->events,(int)pollset->batch_size,msec);
+	if(count < 0) {
+		return apr_get_netos_error();
+	}
+	if(count == 0) {
+		return APR_TIMEUP;
+	}
+
+	for(i=0; i<count; i++) {
+		apt_pollfd_elem_t *elem = pollset->events[i].data.ptr;
+		apr_pollfd_t *result = &pollset->results[i];
+		if(elem) {
+			*result = elem->pfd;
+			result->rtnevents = apt_pollset_events_from_epoll(pollset->events[i].events);
+		}
+		else {
+			*result = pollset->wakeup_pfd;
+		}
+	}
+	*num = count;
+	*descriptors = pollset->results;
+	return APR_SUCCESS;
+}
+
+/** Interrupt the blocked poll call */
+APT_DECLARE(apt_bool_t) apt_pollset_wakeup(apt_pollset_t *pollset)
+{
+	apr_uint64_t value = 1;
+	if(apr_atomic_cas32(&pollset->wakeup_pending,1,0) != 0) {
+		/* already signalled, the poller is to process all the pending messages */
+		return TRUE;
+	}
+	if(write(pollset->wakeup_fd,&value,sizeof(value)) != sizeof(value) && errno != EAGAIN) {
+		apr_atomic_set32(&pollset->wakeup_pending,0);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Match against builtin wake up descriptor in a pollset */
+APT_DECLARE(apt_bool_t) apt_pollset_is_wakeup(apt_pollset_t *pollset, const apr_pollfd_t *descriptor)
+{
+	apr_uint64_t value;
+	if(descriptor->desc_type != APR_NO_DESC || descriptor->client_data != pollset) {
+		return FALSE;
+	}
+
+	/* reset the flag first, so that a wakeup signalled from now on is not missed */
+	apr_atomic_set32(&pollset->wakeup_pending,0);
+	if(read(pollset->wakeup_fd,&value,sizeof(value)) < 0) {
+		/* nothing to read out */
+	}
+	return TRUE;
+}
+
+#else
+
 struct apt_pollset_t {
 	/** APR pollset */
 	apr_pollset_t *base;
@@ -83,7 +351,10 @@ APT_DECLARE(apt_bool_t) apt_pollset_destroy(apt_pollset_t *pollset)
 /** Add pollset descriptor to a pollset */
 APT_DECLARE(apt_bool_t) apt_pollset_add(apt_pollset_t *pollset, const apr_pollfd_t *descriptor)
 {
-	return (apr_pollset_add(pollset->base,descriptor) == APR_SUCCESS) ? TRUE : FALSE;
+	apr_pollfd_t pfd = *descriptor;
+	/* level-triggered only */
+	pfd.reqevents &= ~APT_POLLET;
+	return (apr_pollset_add(pollset->base,&pfd) == APR_SUCCESS) ? TRUE : FALSE;
 }
 
 /** Remove pollset descriptor from a pollset */
@@ -323,3 +594,5 @@ static apt_bool_t apt_wakeup_pipe_destroy(apt_pollset_t *pollset)
 }
 
 #endif
+
+#endif /* APT_HAVE_EPOLL */
@@ -16,6 +16,9 @@
  * $Id$
  */
 
+#include <apr_atomic.h>
+#include <apr_allocator.h>
+#include <apr_thread_mutex.h>
 #include "apt_pool.h"
 #include "apt_log.h"
 
@@ -27,20 +30,210 @@ static int apt_abort_fn(int retcode)
 	return 0;
 }
 
+#ifdef OWN_ALLOCATOR_PER_POOL
+/** Max number of idle allocators cached per thread */
+#define ALLOCATOR_THREAD_CACHE_SIZE 4
+
+typedef struct apt_pool_allocator_t apt_pool_allocator_t;
+
+/** 
+ * Allocator of a root pool. Allocators are not destroyed along with their pools,
+ * but kept idle with the free memory blocks they retain (binned by size by APR),
+ * so that the next pool takes the blocks over without going to the system heap.
+ */
+struct apt_pool_allocator_t {
+	apr_allocator_t      *allocator;
+	apr_thread_mutex_t   *mutex;
+	/** Unmanaged pool the entry and the mutex are allocated from */
+	apr_pool_t           *pool;
+	/** Root pool the allocator is currently used by */
+	apr_pool_t           *owner;
+	apt_pool_allocator_t *next;
+};
+
+/** Process-wide cache of idle allocators */
+static volatile apr_uint32_t  allocator_cache_state = 0;
+static apr_thread_mutex_t    *allocator_cache_guard = NULL;
+static apt_pool_allocator_t  *allocator_cache_head = NULL;
+static apr_size_t             allocator_cache_count = 0;
+static apr_size_t             allocator_cache_size = APT_POOL_DEFAULT_CACHE_SIZE;
+static apr_size_t             allocator_max_free = APT_POOL_DEFAULT_MAX_FREE;
+/** Number of root pools in use */
+static volatile apr_uint32_t  pool_count = 0;
+
+#ifdef APT_THREAD_LOCAL
+/** Per-thread cache of idle allocators, accessed without any lock */
+static APT_THREAD_LOCAL apt_pool_allocator_t *thread_cache[ALLOCATOR_THREAD_CACHE_SIZE];
+static APT_THREAD_LOCAL apr_size_t thread_cache_count = 0;
+#endif
+
+static apt_bool_t apt_pool_allocator_cache_init(void)
+{
+	apr_uint32_t state = apr_atomic_cas32(&allocator_cache_state,1,0);
+	if(state == 0) {
+		apr_pool_t *pool = NULL;
+		/* the cache outlives all the managed pools, including the ones destroyed by apr_terminate() */
+		if(apr_pool_create_unmanaged_ex(&pool,apt_abort_fn,NULL) == APR_SUCCESS) {
+			apr_thread_mutex_create(&allocator_cache_guard,APR_THREAD_MUTEX_UNNESTED,pool);
+		}
+		apr_atomic_set32(&allocator_cache_state,2);
+	}
+	else {
+		while(apr_atomic_read32(&allocator_cache_state) != 2) {
+			/* the cache is being initialized by another thread */
+		}
+	}
+	return allocator_cache_guard ? TRUE : FALSE;
+}
+
+static apt_pool_allocator_t* apt_pool_allocator_create(void)
+{
+	apt_pool_allocator_t *entry;
+	apr_allocator_t *allocator = NULL;
+	apr_pool_t *pool = NULL;
+
+	if(apr_allocator_create(&allocator) != APR_SUCCESS) {
+		return NULL;
+	}
+	if(apr_pool_create_unmanaged_ex(&pool,apt_abort_fn,allocator) != APR_SUCCESS) {
+		apr_allocator_destroy(allocator);
+		return NULL;
+	}
+
+	entry = apr_palloc(pool,sizeof(apt_pool_allocator_t));
+	entry->allocator = allocator;
+	entry->mutex = NULL;
+	entry->pool = pool;
+	entry->owner = NULL;
+	entry->next = NULL;
+	apr_thread_mutex_create(&entry->mutex,APR_THREAD_MUTEX_NESTED,pool);
+	apr_allocator_mutex_set(allocator,entry->mutex);
+	return entry;
+}
+
+static apt_pool_allocator_t* apt_pool_allocator_get(void)
+{
+	apt_pool_allocator_t *entry = NULL;
+#ifdef APT_THREAD_LOCAL
+	if(thread_cache_count) {
+		entry = thread_cache[--thread_cache_count];
+	}
+#endif
+	if(!entry && apt_pool_allocator_cache_init() == TRUE) {
+		apr_thread_mutex_lock(allocator_cache_guard);
+		entry = allocator_cache_head;
+		if(entry) {
+			allocator_cache_head = entry->next;
+			allocator_cache_count--;
+		}
+		apr_thread_mutex_unlock(allocator_cache_guard);
+	}
+	if(!entry) {
+		entry = apt_pool_allocator_create();
+		if(!entry) {
+			return NULL;
+		}
+	}
+	entry->next = NULL;
+	apr_allocator_max_free_set(entry->allocator,allocator_max_free);
+	return entry;
+}
+
+/** Take the allocator, no pool uses anymore, back to the process-wide cache */
+static void apt_pool_allocator_release(apt_pool_allocator_t *entry)
+{
+	apr_allocator_t *allocator = entry->allocator;
+	if(apt_pool_allocator_cache_init() == TRUE) {
+		apr_thread_mutex_lock(allocator_cache_guard);
+		if(allocator_cache_count < allocator_cache_size) {
+			entry->next = allocator_cache_head;
+			allocator_cache_head = entry;
+			allocator_cache_count++;
+			apr_thread_mutex_unlock(allocator_cache_guard);
+			return;
+		}
+		apr_thread_mutex_unlock(allocator_cache_guard);
+	}
+
+	/* the cache is full */
+	apr_allocator_mutex_set(allocator,NULL);
+	apr_pool_destroy(entry->pool);
+	apr_allocator_destroy(allocator);
+}
+
+/** Pool cleanup, which takes the allocator back to the cache */
+static apr_status_t apt_pool_allocator_recycle(void *data)
+{
+	apt_pool_allocator_t *entry = data;
+#ifdef APT_THREAD_LOCAL
+	apr_size_t i;
+	apr_atomic_dec32(&pool_count);
+	entry->owner = NULL;
+	/* 
+	 * The pool still frees its own blocks to the allocator after the cleanup,
+	 * so the allocator is kept by the current thread first and is passed on
+	 * to the other threads only on a later recycle, when the pool is gone.
+	 * Allocators left in the cache of an exited thread are not reclaimed.
+	 */
+	if(thread_cache_count == ALLOCATOR_THREAD_CACHE_SIZE) {
+		apt_pool_allocator_release(thread_cache[0]);
+		for(i=1; i<ALLOCATOR_THREAD_CACHE_SIZE; i++) {
+			thread_cache[i-1] = thread_cache[i];
+		}
+		thread_cache_count--;
+	}
+	thread_cache[thread_cache_count++] = entry;
+#else
+	apr_allocator_t *allocator = entry->allocator;
+	apr_pool_t *owner = entry->owner;
+	apr_atomic_dec32(&pool_count);
+	entry->owner = NULL;
+	/* no thread cache, let the pool being destroyed take the allocator down with it */
+	apr_allocator_mutex_set(allocator,NULL);
+	apr_pool_destroy(entry->pool);
+	apr_allocator_owner_set(allocator,owner);
+#endif
+	return APR_SUCCESS;
+}
+
+/** Key of the allocator entry in the userdata of the pool */
+#define APT_POOL_ALLOCATOR_KEY "apt_pool_allocator"
+
+static void apt_pool_allocator_attach(apr_pool_t *pool, apt_pool_allocator_t *entry)
+{
+	/* registered first, so that it is run last */
+	apr_pool_cleanup_register(pool,entry,apt_pool_allocator_recycle,apr_pool_cleanup_null);
+	apr_pool_userdata_setn(entry,APT_POOL_ALLOCATOR_KEY,NULL,pool);
+}
+
+APT_DECLARE(void) apt_pool_allocator_cache_set(apr_size_t cache_size, apr_size_t max_free)
+{
+	allocator_cache_size = cache_size;
+	allocator_max_free = max_free;
+}
+#else
+APT_DECLARE(void) apt_pool_allocator_cache_set(apr_size_t cache_size, apr_size_t max_free)
+{
+}
+#endif
+
 APT_DECLARE(apr_pool_t*) apt_pool_create()
 {
 	apr_pool_t *pool = NULL;
 
 #ifdef OWN_ALLOCATOR_PER_POOL
-	apr_allocator_t *allocator = NULL;
-	apr_thread_mutex_t *mutex = NULL;
-
-	if(apr_allocator_create(&allocator) == APR_SUCCESS) {
-		if(apr_pool_create_ex(&pool,NULL,apt_abort_fn,allocator) == APR_SUCCESS) {
-			apr_allocator_owner_set(allocator,pool);
-			apr_thread_mutex_create(&mutex,APR_THREAD_MUTEX_NESTED,pool);
-			apr_allocator_mutex_set(allocator,mutex);
-			apr_pool_mutex_set(pool,mutex); 
+	apt_pool_allocator_t *entry = apt_pool_allocator_get();
+	if(entry) {
+		if(apr_pool_create_ex(&pool,NULL,apt_abort_fn,entry->allocator) == APR_SUCCESS) {
+			entry->owner = pool;
+			apr_pool_mutex_set(pool,entry->mutex);
+			apt_pool_allocator_attach(pool,entry);
+			apr_atomic_inc32(&pool_count);
+		}
+		else {
+			apr_allocator_mutex_set(entry->allocator,NULL);
+			apr_pool_destroy(entry->pool);
+			apr_allocator_destroy(entry->allocator);
 		}
 	}
 #else
@@ -49,9 +242,185 @@ APT_DECLARE(apr_pool_t*) apt_pool_create()
 	return pool;
 }
 
+APT_DECLARE(void) apt_pool_clear(apr_pool_t *pool)
+{
+#ifdef OWN_ALLOCATOR_PER_POOL
+	void *entry = NULL;
+	apr_pool_userdata_get(&entry,APT_POOL_ALLOCATOR_KEY,pool);
+	if(entry) {
+		/* the pool goes on using its allocator, don't take it back to the cache */
+		apr_pool_cleanup_kill(pool,entry,apt_pool_allocator_recycle);
+		apr_pool_clear(pool);
+		apt_pool_allocator_attach(pool,entry);
+		return;
+	}
+#endif
+	apr_pool_clear(pool);
+}
+
 APT_DECLARE(apr_pool_t*) apt_subpool_create(apr_pool_t *parent)
 {
 	apr_pool_t *pool = NULL;
+	if(!parent) {
+		return apt_pool_create();
+	}
+	/* subpools share the allocator of the parent and return their blocks to its free lists */
 	apr_pool_create(&pool,parent);
 	return pool;
 }
+
+APT_DECLARE(void) apt_pool_stat_get(apt_pool_stat_t *stat)
+{
+#ifdef OWN_ALLOCATOR_PER_POOL
+	stat->pool_count = apr_atomic_read32(&pool_count);
+	/* read without lock, the value is approximate anyway */
+	stat->cached_allocator_count = allocator_cache_count;
+#else
+	stat->pool_count = 0;
+	stat->cached_allocator_count = 0;
+#endif
+}
+
+/** Accounted memory of pools of an owner */
+typedef struct {
+	volatile apr_uint32_t pool_count;
+	volatile apr_uint32_t bytes;
+	volatile apr_uint32_t peak_bytes;
+} apt_pool_account_entry_t;
+
+/** Accounting record kept in the userdata of a tagged pool */
+typedef struct {
+	apt_pool_owner_e owner;
+	apr_uint32_t     bytes;
+} apt_pool_account_t;
+
+/** Key of the accounting record in the userdata of the pool */
+#define APT_POOL_ACCOUNT_KEY "apt_pool_account"
+
+static volatile apr_uint32_t     accounting_enabled = 0;
+static apt_pool_account_entry_t  account_entries[APT_POOL_OWNER_COUNT];
+
+static const char *owner_names[APT_POOL_OWNER_COUNT] = {
+	"session",
+	"channel",
+	"connection"
+};
+
+static void apt_pool_account_add(apt_pool_account_entry_t *entry, apr_uint32_t delta)
+{
+	/* delta wraps around on decrease */
+	apr_uint32_t bytes = apr_atomic_add32(&entry->bytes,delta) + delta;
+	apr_uint32_t peak_bytes = apr_atomic_read32(&entry->peak_bytes);
+	while(bytes > peak_bytes && (apr_int32_t)delta > 0) {
+		if(apr_atomic_cas32(&entry->peak_bytes,bytes,peak_bytes) == peak_bytes) {
+			break;
+		}
+		peak_bytes = apr_atomic_read32(&entry->peak_bytes);
+	}
+}
+
+/** Pool cleanup, which reclaims the accounted memory of the pool */
+static apr_status_t apt_pool_account_cleanup(void *data)
+{
+	apt_pool_account_t *account = data;
+	apt_pool_account_entry_t *entry = &account_entries[account->owner];
+	apt_pool_account_add(entry,(apr_uint32_t)0 - account->bytes);
+	apr_atomic_dec32(&entry->pool_count);
+	return APR_SUCCESS;
+}
+
+APT_DECLARE(void) apt_pool_accounting_set(apt_bool_t enable)
+{
+	apr_atomic_set32(&accounting_enabled,enable == TRUE ? 1 : 0);
+}
+
+APT_DECLARE(apt_bool_t) apt_pool_accounting_get(void)
+{
+	return apr_atomic_read32(&accounting_enabled) ? TRUE : FALSE;
+}
+
+APT_DECLARE(void) apt_pool_owner_set(apr_pool_t *pool, apt_pool_owner_e owner)
+{
+	apt_pool_account_t *account = NULL;
+	if(!pool || owner >= APT_POOL_OWNER_COUNT || !apr_atomic_read32(&accounting_enabled)) {
+		return;
+	}
+	apr_pool_userdata_get((void**)&account,APT_POOL_ACCOUNT_KEY,pool);
+	if(account) {
+		/* already tagged */
+		return;
+	}
+
+	account = apr_palloc(pool,sizeof(apt_pool_account_t));
+	account->owner = owner;
+	account->bytes = 0;
+	apr_atomic_inc32(&account_entries[owner].pool_count);
+	apr_pool_cleanup_register(pool,account,apt_pool_account_cleanup,apr_pool_cleanup_null);
+	apr_pool_userdata_setn(account,APT_POOL_ACCOUNT_KEY,NULL,pool);
+	apt_pool_account_update(pool);
+}
+
+APT_DECLARE(apr_size_t) apt_pool_account_update(apr_pool_t *pool)
+{
+	apt_pool_account_t *account = NULL;
+	apr_uint32_t bytes;
+	if(!apr_atomic_read32(&accounting_enabled)) {
+		return 0;
+	}
+	apr_pool_userdata_get((void**)&account,APT_POOL_ACCOUNT_KEY,pool);
+	if(!account) {
+		return 0;
+	}
+
+	bytes = (apr_uint32_t)apt_pool_bytes_get(pool);
+	if(bytes != account->bytes) {
+		apt_pool_account_add(&account_entries[account->owner],bytes - account->bytes);
+		account->bytes = bytes;
+	}
+	return bytes;
+}
+
+APT_DECLARE(apr_size_t) apt_pool_bytes_get(apr_pool_t *pool)
+{
+#if APR_POOL_DEBUG
+	return apr_pool_num_bytes(pool,0);
+#else
+	/*
+	 * APR places the pool in its first memory block right after the node header,
+	 * and links all the blocks of the pool into a ring, so the blocks are walked
+	 * without the accounting of every allocation APR doesn't provide.
+	 */
+	const apr_memnode_t *first = (const apr_memnode_t*)((const char*)pool - APR_MEMNODE_T_SIZE);
+	const apr_memnode_t *node = first;
+	apr_size_t size = 0;
+	do {
+		size += node->endp - (const char*)node;
+		node = node->next;
+	}
+	while(node && node != first);
+	return size;
+#endif
+}
+
+APT_DECLARE(void) apt_pool_account_stat_get(apt_pool_owner_e owner, apt_pool_account_stat_t *stat)
+{
+	apt_pool_account_entry_t *entry;
+	if(owner >= APT_POOL_OWNER_COUNT) {
+		stat->pool_count = 0;
+		stat->bytes = 0;
+		stat->peak_bytes = 0;
+		return;
+	}
+	entry = &account_entries[owner];
+	stat->pool_count = apr_atomic_read32(&entry->pool_count);
+	stat->bytes = apr_atomic_read32(&entry->bytes);
+	stat->peak_bytes = apr_atomic_read32(&entry->peak_bytes);
+}
+
+APT_DECLARE(const char*) apt_pool_owner_name_get(apt_pool_owner_e owner)
+{
+	if(owner >= APT_POOL_OWNER_COUNT) {
+		return "unknown";
+	}
+	return owner_names[owner];
+}
@@ -0,0 +1,275 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <string.h>
+#include <apr_atomic.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_proc.h>
+#include "apt_shard_table.h"
+#include "apt_pool.h"
+
+typedef struct apt_shard_entry_t apt_shard_entry_t;
+typedef struct apt_shard_t apt_shard_t;
+
+/** Entry of shard, recycled rather than freed (type-stable memory) */
+struct apt_shard_entry_t {
+	/** Next entry in the bucket (or in the list of free entries) */
+	apt_shard_entry_t * volatile next;
+	/** Object the entry refers to */
+	void * volatile              obj;
+	/** Hash of the key */
+	apr_uint32_t                 hash;
+	/** Length of the key */
+	apr_size_t                   length;
+	/** Copy of the key */
+	char                         key[APT_SHARD_TABLE_MAX_KEY_LENGTH];
+};
+
+/** Shard of table */
+struct apt_shard_t {
+	/** Sequence, odd while the shard is being modified */
+	volatile apr_uint32_t        seq;
+	/** Number of objects in the shard */
+	volatile apr_uint32_t        count;
+	/** Number of entries ever allocated by the shard (bounds the walk of readers) */
+	volatile apr_uint32_t        capacity;
+	/** Buckets of entries */
+	apt_shard_entry_t * volatile *buckets;
+	/** List of free entries */
+	apt_shard_entry_t           *free_list;
+	/** Guard of modifications */
+	apr_thread_mutex_t          *guard;
+	/** Pool of the shard, entries are allocated from under the guard */
+	apr_pool_t                  *pool;
+	/** Separate shards to avoid false sharing */
+	char                         pad[64];
+};
+
+/** Sharded table */
+struct apt_shard_table_t {
+	apt_shard_t  *shards;
+	apr_uint32_t  shard_mask;
+	apr_uint32_t  shard_bits;
+	apr_uint32_t  bucket_mask;
+};
+
+/** Load with full barrier (acquire semantics) */
+static APR_INLINE apr_uint32_t apt_shard_table_load(volatile apr_uint32_t *mem)
+{
+	return apr_atomic_add32(mem,0);
+}
+
+static APR_INLINE apr_uint32_t apt_shard_table_hash(const char *key, apr_size_t length)
+{
+	/* 32-bit FNV-1a */
+	apr_uint32_t hash = 2166136261U;
+	apr_size_t i;
+	for(i=0; i<length; i++) {
+		hash ^= (apr_byte_t)key[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static apr_uint32_t apt_power_of_two_get(apr_size_t size, apr_uint32_t *bits)
+{
+	apr_uint32_t value = 1;
+	apr_uint32_t n = 0;
+	while(value < size && n < 16) {
+		value <<= 1;
+		n++;
+	}
+	if(bits) {
+		*bits = n;
+	}
+	return value;
+}
+
+static APR_INLINE apt_shard_t* apt_shard_get(apt_shard_table_t *table, apr_uint32_t hash)
+{
+	return &table->shards[hash & table->shard_mask];
+}
+
+static APR_INLINE apr_uint32_t apt_shard_bucket_get(const apt_shard_table_t *table, apr_uint32_t hash)
+{
+	return (hash >> table->shard_bits) & table->bucket_mask;
+}
+
+/** Create sharded table */
+APT_DECLARE(apt_shard_table_t*) apt_shard_table_create(apr_size_t shard_count, apr_size_t bucket_count, apr_pool_t *pool)
+{
+	apr_uint32_t i;
+	apr_uint32_t shards;
+	apr_uint32_t buckets;
+	apt_shard_table_t *table = apr_palloc(pool,sizeof(apt_shard_table_t));
+	shards = apt_power_of_two_get(shard_count ? shard_count : APT_SHARD_TABLE_DEFAULT_SHARD_COUNT,&table->shard_bits);
+	buckets = apt_power_of_two_get(bucket_count ? bucket_count : 1,NULL);
+	table->shard_mask = shards - 1;
+	table->bucket_mask = buckets - 1;
+	table->shards = apr_pcalloc(pool,sizeof(apt_shard_t) * shards);
+	for(i=0; i<shards; i++) {
+		apt_shard_t *shard = &table->shards[i];
+		shard->buckets = apr_pcalloc(pool,sizeof(apt_shard_entry_t*) * buckets);
+		shard->free_list = NULL;
+		shard->guard = NULL;
+		/* own pool, as shards allocate entries concurrently */
+		shard->pool = apt_pool_create();
+		if(!shard->pool || apr_thread_mutex_create(&shard->guard,APR_THREAD_MUTEX_DEFAULT,shard->pool) != APR_SUCCESS) {
+			apt_shard_table_destroy(table);
+			return NULL;
+		}
+	}
+	return table;
+}
+
+/** Destroy sharded table */
+APT_DECLARE(void) apt_shard_table_destroy(apt_shard_table_t *table)
+{
+	apr_uint32_t i;
+	for(i=0; i<=table->shard_mask; i++) {
+		apt_shard_t *shard = &table->shards[i];
+		if(shard->guard) {
+			apr_thread_mutex_destroy(shard->guard);
+			shard->guard = NULL;
+		}
+		if(shard->pool) {
+			apr_pool_destroy(shard->pool);
+			shard->pool = NULL;
+		}
+	}
+}
+
+/** Set (add, replace or remove) object by key */
+APT_DECLARE(apt_bool_t) apt_shard_table_set(apt_shard_table_t *table, const char *key, apr_size_t length, void *obj)
+{
+	apt_shard_t *shard;
+	apt_shard_entry_t *entry;
+	apt_shard_entry_t * volatile *link;
+	apr_uint32_t hash;
+
+	if(length > APT_SHARD_TABLE_MAX_KEY_LENGTH) {
+		return FALSE;
+	}
+	hash = apt_shard_table_hash(key,length);
+	shard = apt_shard_get(table,hash);
+
+	apr_thread_mutex_lock(shard->guard);
+	link = &shard->buckets[apt_shard_bucket_get(table,hash)];
+	for(entry = *link; entry; link = &entry->next, entry = entry->next) {
+		if(entry->hash == hash && entry->length == length && memcmp(entry->key,key,length) == 0) {
+			break;
+		}
+	}
+
+	if(entry) {
+		if(obj) {
+			/* replacement of a pointer is atomic, no need to bump the sequence */
+			entry->obj = obj;
+		}
+		else {
+			apr_atomic_inc32(&shard->seq);
+			*link = entry->next;
+			entry->obj = NULL;
+			apr_atomic_inc32(&shard->seq);
+
+			entry->next = shard->free_list;
+			shard->free_list = entry;
+			shard->count--;
+		}
+	}
+	else if(obj) {
+		entry = shard->free_list;
+		if(entry) {
+			/* iterated by no reader, as the sequence of the shard has changed since */
+			apr_atomic_inc32(&shard->seq);
+			shard->free_list = entry->next;
+		}
+		else {
+			entry = apr_palloc(shard->pool,sizeof(apt_shard_entry_t));
+			apr_atomic_inc32(&shard->capacity);
+			apr_atomic_inc32(&shard->seq);
+		}
+		entry->hash = hash;
+		entry->length = length;
+		memcpy(entry->key,key,length);
+		entry->obj = obj;
+		entry->next = *link;
+		*link = entry;
+		apr_atomic_inc32(&shard->seq);
+		shard->count++;
+	}
+	apr_thread_mutex_unlock(shard->guard);
+	return TRUE;
+}
+
+/** Get object by key without locking */
+APT_DECLARE(void*) apt_shard_table_get(apt_shard_table_t *table, const char *key, apr_size_t length)
+{
+	apt_shard_t *shard;
+	apt_shard_entry_t *entry;
+	apr_uint32_t hash;
+	apr_uint32_t bucket;
+	apr_uint32_t seq;
+	apr_uint32_t steps;
+	void *obj;
+
+	if(length > APT_SHARD_TABLE_MAX_KEY_LENGTH) {
+		return NULL;
+	}
+	hash = apt_shard_table_hash(key,length);
+	shard = apt_shard_get(table,hash);
+	bucket = apt_shard_bucket_get(table,hash);
+	for(;;) {
+		seq = apt_shard_table_load(&shard->seq);
+		if(seq & 1) {
+			/* the shard is being modified */
+			apr_thread_yield();
+			continue;
+		}
+		obj = NULL;
+		steps = apt_shard_table_load(&shard->capacity);
+		for(entry = shard->buckets[bucket]; entry && steps; entry = entry->next, steps--) {
+			if(entry->hash == hash && entry->length == length && memcmp(entry->key,key,length) == 0) {
+				obj = entry->obj;
+				break;
+			}
+		}
+		/* retry, if an entry seen may have been recycled meanwhile */
+		if(apt_shard_table_load(&shard->seq) == seq) {
+			break;
+		}
+	}
+	return obj;
+}
+
+/** Get the number of objects in the table */
+APT_DECLARE(apr_size_t) apt_shard_table_count_get(const apt_shard_table_t *table)
+{
+	apr_size_t count = 0;
+	apr_uint32_t i;
+	for(i=0; i<=table->shard_mask; i++) {
+		count += table->shards[i].count;
+	}
+	return count;
+}
+
+/** Get the number of shards of the table */
+APT_DECLARE(apr_size_t) apt_shard_table_shard_count_get(const apt_shard_table_t *table)
+{
+	return table->shard_mask + 1;
+}
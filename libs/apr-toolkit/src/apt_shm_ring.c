@@ -0,0 +1,328 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include <string.h>
+#include <apr_atomic.h>
+#include "apt_shm_ring.h"
+#include "apt_log.h"
+
+#if APR_HAS_FORK
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#ifdef APT_HAVE_EPOLL
+#include <sys/eventfd.h>
+#endif
+#endif
+
+/** Alignment of records */
+#define SHM_RING_ALIGN(size) (((size) + 7) & ~((apr_size_t)7))
+/** Size of record header */
+#define SHM_RING_HEADER_SIZE 8
+/** Size of header telling the rest of the memory up to the end is skipped */
+#define SHM_RING_PADDING     0xFFFFFFFF
+
+/** 
+ * Records are laid out contiguously, each one preceded by the header holding its size.
+ * A record, which does not fit before the end of the memory, starts over from the beginning,
+ * the rest is skipped by the consumer. Positions run freely and wrap around by the mask.
+ */
+struct apt_shm_ring_t {
+	apr_uint32_t          mask;
+	/** Size reserved by the producer */
+	apr_uint32_t          reserved;
+	/** Consumer position as of the last check of the producer */
+	apr_uint32_t          head_cache;
+	/* separate producer and consumer positions to avoid false sharing */
+	char                  pad1[52];
+	volatile apr_uint32_t tail;
+	volatile apr_uint32_t written;
+	char                  pad2[56];
+	volatile apr_uint32_t head;
+	volatile apr_uint32_t read;
+	char                  pad3[56];
+};
+
+/** Load with full barrier (acquire semantics) */
+static APR_INLINE apr_uint32_t apt_shm_ring_load(volatile apr_uint32_t *mem)
+{
+	return apr_atomic_add32(mem,0);
+}
+
+static APR_INLINE char* apt_shm_ring_data(const apt_shm_ring_t *ring)
+{
+	return (char*)ring + sizeof(apt_shm_ring_t);
+}
+
+static APR_INLINE apr_uint32_t apt_shm_ring_capacity_round(apr_size_t capacity)
+{
+	apr_uint32_t size = 64;
+	while(size < capacity && size < 0x40000000) {
+		size <<= 1;
+	}
+	return size;
+}
+
+APT_DECLARE(apr_size_t) apt_shm_ring_size_get(apr_size_t capacity)
+{
+	return sizeof(apt_shm_ring_t) + apt_shm_ring_capacity_round(capacity);
+}
+
+APT_DECLARE(apt_shm_ring_t*) apt_shm_ring_create(void *mem, apr_size_t capacity)
+{
+	apt_shm_ring_t *ring = mem;
+	if(!ring) {
+		return NULL;
+	}
+	memset(ring,0,sizeof(apt_shm_ring_t));
+	ring->mask = apt_shm_ring_capacity_round(capacity) - 1;
+	return ring;
+}
+
+APT_DECLARE(void*) apt_shm_ring_reserve(apt_shm_ring_t *ring, apr_size_t size)
+{
+	apr_uint32_t tail = ring->tail;
+	apr_uint32_t capacity = ring->mask + 1;
+	apr_uint32_t offset = tail & ring->mask;
+	apr_uint32_t contiguous = capacity - offset;
+	apr_uint32_t total;
+	apr_uint32_t required;
+	if(size > capacity / 2) {
+		return NULL;
+	}
+	total = (apr_uint32_t)SHM_RING_ALIGN(SHM_RING_HEADER_SIZE + size);
+	/* the record goes to the beginning, if it does not fit before the end */
+	required = total <= contiguous ? total : contiguous + total;
+	if(tail - ring->head_cache + required > capacity) {
+		ring->head_cache = apt_shm_ring_load(&ring->head);
+		if(tail - ring->head_cache + required > capacity) {
+			return NULL;
+		}
+	}
+
+	if(total > contiguous) {
+		*(apr_uint32_t*)(apt_shm_ring_data(ring) + offset) = SHM_RING_PADDING;
+		tail += contiguous;
+		apr_atomic_xchg32(&ring->tail,tail);
+		offset = 0;
+	}
+	ring->reserved = total;
+	return apt_shm_ring_data(ring) + offset + SHM_RING_HEADER_SIZE;
+}
+
+APT_DECLARE(void) apt_shm_ring_commit(apt_shm_ring_t *ring, apr_size_t size)
+{
+	apr_uint32_t tail = ring->tail;
+	apr_uint32_t total = (apr_uint32_t)SHM_RING_ALIGN(SHM_RING_HEADER_SIZE + size);
+	if(total > ring->reserved) {
+		return;
+	}
+	*(apr_uint32_t*)(apt_shm_ring_data(ring) + (tail & ring->mask)) = (apr_uint32_t)size;
+	ring->reserved = 0;
+	/* the record is written before it is published */
+	apr_atomic_xchg32(&ring->tail,tail + total);
+	apr_atomic_inc32(&ring->written);
+}
+
+APT_DECLARE(apt_bool_t) apt_shm_ring_write(apt_shm_ring_t *ring, const void *head, apr_size_t head_size, const void *body, apr_size_t body_size)
+{
+	char *record = apt_shm_ring_reserve(ring,head_size + body_size);
+	if(!record) {
+		return FALSE;
+	}
+	if(head_size) {
+		memcpy(record,head,head_size);
+	}
+	if(body_size) {
+		memcpy(record + head_size,body,body_size);
+	}
+	apt_shm_ring_commit(ring,head_size + body_size);
+	return TRUE;
+}
+
+APT_DECLARE(const void*) apt_shm_ring_peek(apt_shm_ring_t *ring, apr_size_t *size)
+{
+	apr_uint32_t head = ring->head;
+	apr_uint32_t tail = apt_shm_ring_load(&ring->tail);
+	apr_uint32_t offset;
+	apr_uint32_t header;
+	while(head != tail) {
+		offset = head & ring->mask;
+		header = *(const apr_uint32_t*)(apt_shm_ring_data(ring) + offset);
+		if(header != SHM_RING_PADDING) {
+			*size = header;
+			return apt_shm_ring_data(ring) + offset + SHM_RING_HEADER_SIZE;
+		}
+		/* skip the rest up to the end */
+		head += ring->mask + 1 - offset;
+		apr_atomic_xchg32(&ring->head,head);
+	}
+	return NULL;
+}
+
+APT_DECLARE(void) apt_shm_ring_release(apt_shm_ring_t *ring)
+{
+	apr_uint32_t head = ring->head;
+	apr_uint32_t header = *(const apr_uint32_t*)(apt_shm_ring_data(ring) + (head & ring->mask));
+	/* the record is read before its space is given back */
+	apr_atomic_xchg32(&ring->head,head + (apr_uint32_t)SHM_RING_ALIGN(SHM_RING_HEADER_SIZE + header));
+	apr_atomic_inc32(&ring->read);
+}
+
+APT_DECLARE(void) apt_shm_ring_discard(apt_shm_ring_t *ring)
+{
+	apr_size_t size;
+	while(apt_shm_ring_peek(ring,&size)) {
+		apt_shm_ring_release(ring);
+	}
+}
+
+APT_DECLARE(apr_size_t) apt_shm_ring_count_get(const apt_shm_ring_t *ring)
+{
+	apt_shm_ring_t *r = (apt_shm_ring_t*)ring;
+	apr_uint32_t read = apt_shm_ring_load(&r->read);
+	return apt_shm_ring_load(&r->written) - read;
+}
+
+
+/** Doorbell located in shared memory */
+struct apt_doorbell_t {
+	/** Non-zero while the waiter is about to sleep or sleeping */
+	volatile apr_uint32_t waiting;
+	/** Non-zero once signalled, till the waiter wakes up */
+	volatile apr_uint32_t signalled;
+	/** Descriptors to read and write (the same eventfd or the ends of a pipe) */
+	int                   fd[2];
+};
+
+APT_DECLARE(apr_size_t) apt_doorbell_size_get(void)
+{
+	return sizeof(apt_doorbell_t);
+}
+
+#if APR_HAS_FORK
+APT_DECLARE(apt_doorbell_t*) apt_doorbell_create(void *mem)
+{
+	apt_doorbell_t *doorbell = mem;
+	if(!doorbell) {
+		return NULL;
+	}
+	doorbell->waiting = 0;
+	doorbell->signalled = 0;
+#ifdef APT_HAVE_EPOLL
+	doorbell->fd[0] = eventfd(0,EFD_NONBLOCK);
+	if(doorbell->fd[0] < 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Doorbell Event [%d]",errno);
+		return NULL;
+	}
+	doorbell->fd[1] = doorbell->fd[0];
+#else
+	if(pipe(doorbell->fd) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Doorbell Pipe [%d]",errno);
+		return NULL;
+	}
+	fcntl(doorbell->fd[0],F_SETFL,fcntl(doorbell->fd[0],F_GETFL) | O_NONBLOCK);
+	fcntl(doorbell->fd[1],F_SETFL,fcntl(doorbell->fd[1],F_GETFL) | O_NONBLOCK);
+#endif
+	return doorbell;
+}
+
+APT_DECLARE(void) apt_doorbell_destroy(apt_doorbell_t *doorbell)
+{
+	if(doorbell->fd[1] != doorbell->fd[0]) {
+		close(doorbell->fd[1]);
+	}
+	close(doorbell->fd[0]);
+}
+
+APT_DECLARE(apt_bool_t) apt_doorbell_ring(apt_doorbell_t *doorbell)
+{
+#ifdef APT_HAVE_EPOLL
+	apr_uint64_t value = 1;
+#else
+	char value = 1;
+#endif
+	if(!apr_atomic_add32(&doorbell->waiting,0)) {
+		/* the waiter is busy and checks the rings before it sleeps */
+		return TRUE;
+	}
+	if(apr_atomic_cas32(&doorbell->signalled,1,0) != 0) {
+		/* already signalled */
+		return TRUE;
+	}
+	if(write(doorbell->fd[1],&value,sizeof(value)) != sizeof(value) && errno != EAGAIN) {
+		return FALSE;
+	}
+	return TRUE;
+}
+
+APT_DECLARE(void) apt_doorbell_arm(apt_doorbell_t *doorbell)
+{
+	/* full barrier, the rings are checked again after the flag is seen by producers */
+	apr_atomic_xchg32(&doorbell->waiting,1);
+}
+
+APT_DECLARE(apt_bool_t) apt_doorbell_wait(apt_doorbell_t *doorbell, apr_interval_time_t timeout)
+{
+	struct pollfd pfd;
+	char buf[64];
+	int rv;
+	pfd.fd = doorbell->fd[0];
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	do {
+		rv = poll(&pfd,1,timeout < 0 ? -1 : (int)(timeout / 1000));
+	}
+	while(rv < 0 && errno == EINTR);
+
+	apr_atomic_set32(&doorbell->waiting,0);
+	if(rv <= 0) {
+		return FALSE;
+	}
+	/* drain first, a signal from the reset on is left to the next wait */
+	while(read(doorbell->fd[0],buf,sizeof(buf)) > 0);
+	apr_atomic_set32(&doorbell->signalled,0);
+	return TRUE;
+}
+#else
+APT_DECLARE(apt_doorbell_t*) apt_doorbell_create(void *mem)
+{
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Doorbell is not supported");
+	return NULL;
+}
+
+APT_DECLARE(void) apt_doorbell_destroy(apt_doorbell_t *doorbell)
+{
+}
+
+APT_DECLARE(apt_bool_t) apt_doorbell_ring(apt_doorbell_t *doorbell)
+{
+	return FALSE;
+}
+
+APT_DECLARE(void) apt_doorbell_arm(apt_doorbell_t *doorbell)
+{
+}
+
+APT_DECLARE(apt_bool_t) apt_doorbell_wait(apt_doorbell_t *doorbell, apr_interval_time_t timeout)
+{
+	return FALSE;
+}
+#endif
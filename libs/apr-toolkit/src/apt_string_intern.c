@@ -0,0 +1,95 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <string.h>
+#include "apt_string_intern.h"
+
+/** Interned strings (in the order of apt_intern_id_e) */
+#define APT_INTERN_LIST(X) \
+	X(SPEECHSYNTH,                "speechsynth") \
+	X(SPEECHRECOG,                "speechrecog") \
+	X(RECORDER,                   "recorder") \
+	X(SPEAKVERIFY,                "speakverify") \
+	X(APPLICATION_SRGS_XML,       "application/srgs+xml") \
+	X(APPLICATION_SRGS,           "application/srgs") \
+	X(APPLICATION_NLSML_XML,      "application/nlsml+xml") \
+	X(APPLICATION_X_NLSML,        "application/x-nlsml") \
+	X(APPLICATION_SSML_XML,       "application/ssml+xml") \
+	X(APPLICATION_SYNTHESIS_SSML, "application/synthesis+ssml") \
+	X(APPLICATION_PLS_XML,        "application/pls+xml") \
+	X(TEXT_URI_LIST,              "text/uri-list") \
+	X(TEXT_GRAMMAR_REF_LIST,      "text/grammar-ref-list") \
+	X(TEXT_PLAIN,                 "text/plain") \
+	X(MULTIPART_MIXED,            "multipart/mixed") \
+	X(VALUE_TRUE,                 "true") \
+	X(VALUE_FALSE,                "false")
+
+/** Characters of interned strings, kept together to tell interned buffers by address */
+#define APT_INTERN_CHARS(id,value) char s_##id[sizeof(value)];
+static const struct {
+	APT_INTERN_LIST(APT_INTERN_CHARS)
+} apt_intern_chars = {
+#define APT_INTERN_VALUE(id,value) value,
+	APT_INTERN_LIST(APT_INTERN_VALUE)
+};
+
+/** Table of interned strings */
+#define APT_INTERN_ITEM(id,value) {(char*)apt_intern_chars.s_##id, sizeof(value) - 1},
+static const apt_str_t apt_intern_table[APT_INTERN_COUNT] = {
+	APT_INTERN_LIST(APT_INTERN_ITEM)
+};
+
+/** Get interned string by identifier */
+APT_DECLARE(const apt_str_t*) apt_string_intern_get(apt_intern_id_e id)
+{
+	if(id >= APT_INTERN_COUNT) {
+		return NULL;
+	}
+	return &apt_intern_table[id];
+}
+
+/** Find interned string equal to a given one */
+APT_DECLARE(const apt_str_t*) apt_string_intern_find(const apt_str_t *value)
+{
+	const apt_str_t *item;
+	apr_size_t i;
+	if(!value->buf || !value->length) {
+		return NULL;
+	}
+	if(apt_string_is_interned(value) == TRUE) {
+		return value;
+	}
+
+	for(i=0; i<APT_INTERN_COUNT; i++) {
+		item = &apt_intern_table[i];
+		/* lengths and the last characters differ mostly, check them first */
+		if(item->length == value->length &&
+			item->buf[item->length-1] == value->buf[value->length-1] &&
+			memcmp(item->buf,value->buf,value->length) == 0) {
+			return item;
+		}
+	}
+	return NULL;
+}
+
+/** Check whether the string refers to an interned one */
+APT_DECLARE(apt_bool_t) apt_string_is_interned(const apt_str_t *str)
+{
+	const char *begin = (const char*)&apt_intern_chars;
+	return (str->buf >= begin && str->buf < begin + sizeof(apt_intern_chars)) ? TRUE : FALSE;
+}
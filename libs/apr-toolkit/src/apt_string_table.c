@@ -66,3 +66,35 @@ APT_DECLARE(apr_size_t) apt_string_table_id_find(const apt_str_table_item_t tabl
 	/* no match found, return invalid id */
 	return size;
 }
+
+/* Calculate case-insensitive hash of a given string */
+APT_DECLARE(apr_uint32_t) apt_string_table_hash(apr_uint32_t seed, const apt_str_t *value)
+{
+	/* FNV-1a over the characters folded to lower case; folding by bit 0x20
+	is coarser than tolower(), which is fine since whole strings are compared anyway */
+	apr_uint32_t hash = seed ^ (apr_uint32_t)value->length;
+	apr_size_t i;
+	for(i=0; i<value->length; i++) {
+		hash = (hash ^ ((unsigned char)value->buf[i] | 0x20)) * 16777619;
+	}
+	hash ^= hash >> 15;
+	return hash;
+}
+
+/* Find the id associated with a given string using perfect hash of the table */
+APT_DECLARE(apr_size_t) apt_string_table_id_hash_find(const apt_str_table_item_t table[], apr_size_t size, const apt_str_table_hash_t *hash, const apt_str_t *value)
+{
+	apr_size_t id;
+	if(!hash) {
+		return apt_string_table_id_find(table,size,value);
+	}
+
+	/* a string may only match the one item hashed to the same slot */
+	id = hash->slots[apt_string_table_hash(hash->seed,value) & hash->mask];
+	if(id && --id < size && apt_string_compare(&table[id].value,value) == TRUE) {
+		return id;
+	}
+
+	/* no match found, return invalid id */
+	return size;
+}
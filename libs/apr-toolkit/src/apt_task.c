@@ -19,12 +19,15 @@
 #ifdef WIN32
 #pragma warning(disable: 4127)
 #endif
+#include <string.h>
 #include <apr_ring.h> 
 #include <apr_thread_proc.h>
 #include <apr_thread_cond.h>
 #include <apr_portable.h>
+#include <apr_atomic.h>
 #include "apt_task.h"
 #include "apt_log.h"
+#include "apt_probe.h"
 
 /** Internal states of the task */
 typedef enum {
@@ -53,6 +56,8 @@ struct apt_task_t {
 	apr_size_t           pending_on;    /* number of pending bringing-online requests */
 	apt_bool_t           running;       /* task is running (TRUE if even terminate has already been requested) */
 	apt_bool_t           auto_ready;    /* if TRUE, task is implicitly ready to process messages */
+	apt_cpu_set_t       *cpu_set;       /* set of CPUs to bind the thread to (NULL if not bound) */
+	apt_task_stat_t      stat;          /* statistics of signalled messages */
 };
 
 static void* APR_THREAD_FUNC apt_task_run(apr_thread_t *thread_handle, void *data);
@@ -111,6 +116,8 @@ APT_DECLARE(apt_task_t*) apt_task_create(
 	task->pending_off = 0;
 	task->pending_on = 0;
 	task->auto_ready = TRUE;
+	task->cpu_set = NULL;
+	memset(&task->stat,0,sizeof(apt_task_stat_t));
 	task->name = "Task";
 	return task;
 }
@@ -126,6 +133,14 @@ APT_DECLARE(apt_bool_t) apt_task_destroy(apt_task_t *task)
 		apt_task_wait_till_complete(task);
 	}
 
+	if(task->stat.msg_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Task Statistics [%s] messages [%u] max queue depth [%u] max wait [%u usec] max process [%u usec]",
+			task->name,
+			task->stat.msg_count,
+			task->stat.max_queue_depth,
+			task->stat.max_wait_time,
+			task->stat.max_process_time);
+	}
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Destroy Task [%s]",task->name);
 	if(task->vtable.destroy) {
 		task->vtable.destroy(task);
@@ -252,6 +267,47 @@ APT_DECLARE(const char*) apt_task_name_get(const apt_task_t *task)
 	return task->name;
 }
 
+APT_DECLARE(void) apt_task_stat_get(const apt_task_t *task, apt_task_stat_t *stat)
+{
+	apr_size_t i;
+	apt_task_stat_t *src_stat = (apt_task_stat_t*)&task->stat;
+	stat->msg_count = apr_atomic_read32(&src_stat->msg_count);
+	stat->queue_depth = apr_atomic_read32(&src_stat->queue_depth);
+	stat->max_queue_depth = apr_atomic_read32(&src_stat->max_queue_depth);
+	stat->max_wait_time = apr_atomic_read32(&src_stat->max_wait_time);
+	stat->max_process_time = apr_atomic_read32(&src_stat->max_process_time);
+	for(i=0; i<APT_TASK_HISTOGRAM_SIZE; i++) {
+		stat->wait_histogram[i] = apr_atomic_read32(&src_stat->wait_histogram[i]);
+		stat->process_histogram[i] = apr_atomic_read32(&src_stat->process_histogram[i]);
+	}
+}
+
+APT_DECLARE(void) apt_task_walk(apt_task_t *task, apt_task_visitor_f visitor, void *obj)
+{
+	apt_task_t *child_task;
+	visitor(task,obj);
+	APR_RING_FOREACH(child_task, &task->head, apt_task_t, link) {
+		apt_task_walk(child_task,visitor,obj);
+	}
+}
+
+APT_DECLARE(void) apt_task_cpu_set_set(apt_task_t *task, const apt_cpu_set_t *cpu_set)
+{
+	if(!cpu_set) {
+		task->cpu_set = NULL;
+		return;
+	}
+	if(!task->cpu_set) {
+		task->cpu_set = apr_palloc(task->pool,sizeof(apt_cpu_set_t));
+	}
+	*task->cpu_set = *cpu_set;
+}
+
+APT_DECLARE(const apt_cpu_set_t*) apt_task_cpu_set_get(const apt_task_t *task)
+{
+	return task->cpu_set;
+}
+
 APT_DECLARE(apt_task_msg_t*) apt_task_msg_get(apt_task_t *task)
 {
 	if(task->msg_pool) {
@@ -262,12 +318,20 @@ APT_DECLARE(apt_task_msg_t*) apt_task_msg_get(apt_task_t *task)
 
 APT_DECLARE(apt_bool_t) apt_task_msg_signal(apt_task_t *task, apt_task_msg_t *msg)
 {
+	APT_PROBE4(task_msg_signal,task->name,msg,msg->type,msg->sub_type);
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Signal Message to [%s] ["APT_PTR_FMT";%d;%d]",
 		task->name, msg, msg->type, msg->sub_type);
 	if(task->vtable.signal_msg) {
+		/* account the message before it's visible to the processing thread */
+		apr_uint32_t depth = apr_atomic_inc32(&task->stat.queue_depth) + 1;
+		if(depth > apr_atomic_read32(&task->stat.max_queue_depth)) {
+			apr_atomic_set32(&task->stat.max_queue_depth,depth);
+		}
+		msg->signal_time = apr_time_now();
 		if(task->vtable.signal_msg(task,msg) == TRUE) {
 			return TRUE;
 		}
+		apr_atomic_dec32(&task->stat.queue_depth);
 	}
 
 	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Signal Task Message [%s] [0x%x;%d;%d]",
@@ -276,6 +340,13 @@ APT_DECLARE(apt_bool_t) apt_task_msg_signal(apt_task_t *task, apt_task_msg_t *ms
 	return FALSE;
 }
 
+APT_DECLARE(apt_bool_t) apt_task_msg_forward(apt_task_t *task, apt_task_t *target, apt_task_msg_t *msg)
+{
+	/* the message is accounted again, once signaled to the target, and released on failure */
+	apr_atomic_dec32(&task->stat.queue_depth);
+	return apt_task_msg_signal(target,msg);
+}
+
 APT_DECLARE(apt_bool_t) apt_task_msg_parent_signal(apt_task_t *task, apt_task_msg_t *msg)
 {
 	apt_task_t *parent_task = task->parent_task;
@@ -331,11 +402,30 @@ static apt_bool_t apt_core_task_msg_process(apt_task_t *task, apt_task_msg_t *ms
 	return TRUE;
 }
 
+static APR_INLINE void apt_task_time_record(apr_uint32_t *histogram, apr_uint32_t *max_time, apr_uint32_t elapsed)
+{
+	apr_size_t bucket = 0;
+	while(bucket < APT_TASK_HISTOGRAM_SIZE - 1 && elapsed >= ((apr_uint32_t)64 << bucket)) {
+		bucket++;
+	}
+	apr_atomic_inc32(&histogram[bucket]);
+	if(elapsed > apr_atomic_read32(max_time)) {
+		apr_atomic_set32(max_time,elapsed);
+	}
+}
+
 APT_DECLARE(apt_bool_t) apt_task_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 {
 	apt_bool_t status = FALSE;
+	apr_time_t start_time = apr_time_now();
+	if(msg->signal_time) {
+		apr_atomic_dec32(&task->stat.queue_depth);
+		apt_task_time_record(task->stat.wait_histogram,&task->stat.max_wait_time,
+			start_time > msg->signal_time ? (apr_uint32_t)(start_time - msg->signal_time) : 0);
+	}
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Process Message [%s] ["APT_PTR_FMT";%d;%d]",
 		task->name, msg, msg->type, msg->sub_type);
+	APT_PROBE4(task_msg_process_start,task->name,msg,msg->type,msg->sub_type);
 	if(msg->type == TASK_MSG_CORE) {
 		status = apt_core_task_msg_process(task,msg);
 	}
@@ -344,7 +434,11 @@ APT_DECLARE(apt_bool_t) apt_task_msg_process(apt_task_t *task, apt_task_msg_t *m
 			status = task->vtable.process_msg(task,msg);
 		}
 	}
-	
+
+	APT_PROBE2(task_msg_process_end,task->name,msg);
+	apt_task_time_record(task->stat.process_histogram,&task->stat.max_process_time,
+		(apr_uint32_t)(apr_time_now() - start_time));
+	apr_atomic_inc32(&task->stat.msg_count);
 	apt_task_msg_release(msg);
 	return status;
 }
@@ -570,6 +664,13 @@ static void* APR_THREAD_FUNC apt_task_run(apr_thread_t *thread_handle, void *dat
 #if APR_HAS_SETTHREADNAME
 	apr_thread_name_set(task->name);
 #endif
+	if(task->cpu_set) {
+		/* bind before the pre-run event, so that memory touched by the task is node-local */
+		if(apt_cpu_set_thread_bind(task->cpu_set) == TRUE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Bind Task [%s] to [%"APR_SIZE_T_FMT"] CPUs",
+				task->name,apt_cpu_set_count_get(task->cpu_set));
+		}
+	}
 	/* raise pre-run event */
 	if(task->vtable.on_pre_run) {
 		task->vtable.on_pre_run(task);
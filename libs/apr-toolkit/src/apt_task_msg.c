@@ -17,6 +17,7 @@
  */
 
 #include <stdlib.h>
+#include <apr_atomic.h>
 #include "apt_task_msg.h"
 
 /** Abstract pool of task messages to allocate task messages from */
@@ -45,6 +46,7 @@ static apt_task_msg_t* dynamic_pool_acquire_msg(apt_task_msg_pool_t *task_msg_po
 	task_msg->msg_pool = task_msg_pool;
 	task_msg->type = TASK_MSG_USER;
 	task_msg->sub_type = 0;
+	task_msg->signal_time = 0;
 	return task_msg;
 }
 
@@ -75,12 +77,198 @@ APT_DECLARE(apt_task_msg_pool_t*) apt_task_msg_pool_create_dynamic(apr_size_t ms
 }
 
 
-/** Static allocation of messages from message pool (not implemented yet) */
-APT_DECLARE(apt_task_msg_pool_t*) apt_task_msg_pool_create_static(apr_size_t msg_size, apr_size_t pool_size, apr_pool_t *pool)
+/** Static allocation of messages from a preallocated slab */
+typedef struct apt_msg_pool_static_t apt_msg_pool_static_t;
+
+/** Index of no slot (end of free list) */
+#define STATIC_POOL_NIL         0xFFFF
+/** Max number of messages in a static pool (indexes are 16-bit) */
+#define STATIC_POOL_MAX_SIZE    0xFFFE
+/** Number of pools a thread keeps local free slots of */
+#define MSG_CACHE_POOL_COUNT    4
+/** Max number of local free slots per pool */
+#define MSG_CACHE_SIZE          16
+
+struct apt_msg_pool_static_t {
+	/** Unique id of the pool (thread local caches refer to it) */
+	apr_uint32_t        id;
+	/** Size of slot */
+	apr_size_t          size;
+	/** Number of slots */
+	apr_size_t          count;
+	/** Preallocated slots */
+	char               *slab;
+	/** Next free slot of each slot */
+	apr_uint16_t       *next;
+	/** Head of free list: top slot in low 16 bits, ABA tag in high 16 bits */
+	volatile apr_uint32_t head;
+	/** Messages are allocated dynamically, when the slab is exhausted */
+	apt_task_msg_pool_t *overflow_pool;
+};
+
+#ifdef APT_THREAD_LOCAL
+/** Free slots cached by the current thread, to skip the shared list when the same thread acquires and releases */
+typedef struct {
+	/** Id of the pool slots belong to, 0 if not used */
+	apr_uint32_t pool_id;
+	/** Number of slots */
+	apr_size_t   count;
+	/** Cached slots */
+	apr_uint16_t slots[MSG_CACHE_SIZE];
+} apt_msg_cache_t;
+
+static APT_THREAD_LOCAL apt_msg_cache_t msg_caches[MSG_CACHE_POOL_COUNT];
+#endif
+
+static volatile apr_uint32_t static_pool_counter = 0;
+
+static APR_INLINE apt_task_msg_t* static_pool_slot_get(apt_msg_pool_static_t *static_pool, apr_uint16_t slot)
+{
+	return (apt_task_msg_t*)(static_pool->slab + slot * static_pool->size);
+}
+
+static apr_uint16_t static_pool_pop(apt_msg_pool_static_t *static_pool)
+{
+	apr_uint32_t head;
+	apr_uint32_t prev;
+	apr_uint16_t slot;
+	head = apr_atomic_read32(&static_pool->head);
+	for(;;) {
+		slot = (apr_uint16_t)(head & 0xFFFF);
+		if(slot == STATIC_POOL_NIL) {
+			return STATIC_POOL_NIL;
+		}
+		/* the next slot may be stale if the slot is taken meanwhile, the tag makes the swap fail then */
+		prev = apr_atomic_cas32(&static_pool->head,((head + 0x10000) & 0xFFFF0000) | static_pool->next[slot],head);
+		if(prev == head) {
+			return slot;
+		}
+		head = prev;
+	}
+}
+
+static void static_pool_push(apt_msg_pool_static_t *static_pool, apr_uint16_t slot)
 {
-	return NULL;
+	apr_uint32_t head;
+	apr_uint32_t prev;
+	head = apr_atomic_read32(&static_pool->head);
+	for(;;) {
+		static_pool->next[slot] = (apr_uint16_t)(head & 0xFFFF);
+		prev = apr_atomic_cas32(&static_pool->head,((head + 0x10000) & 0xFFFF0000) | slot,head);
+		if(prev == head) {
+			return;
+		}
+		head = prev;
+	}
 }
 
+#ifdef APT_THREAD_LOCAL
+static apt_msg_cache_t* static_pool_cache_get(apt_msg_pool_static_t *static_pool)
+{
+	int i;
+	apt_msg_cache_t *unused = NULL;
+	for(i=0; i<MSG_CACHE_POOL_COUNT; i++) {
+		if(msg_caches[i].pool_id == static_pool->id) {
+			return &msg_caches[i];
+		}
+		if(!unused && (msg_caches[i].pool_id == 0 || msg_caches[i].count == 0)) {
+			unused = &msg_caches[i];
+		}
+	}
+	if(unused) {
+		/* take over an unused (or emptied) cache */
+		unused->pool_id = static_pool->id;
+		unused->count = 0;
+	}
+	return unused;
+}
+#endif
+
+static apt_task_msg_t* static_pool_acquire_msg(apt_task_msg_pool_t *task_msg_pool)
+{
+	apt_msg_pool_static_t *static_pool = task_msg_pool->obj;
+	apt_task_msg_t *task_msg;
+	apr_uint16_t slot = STATIC_POOL_NIL;
+#ifdef APT_THREAD_LOCAL
+	apt_msg_cache_t *cache = static_pool_cache_get(static_pool);
+	if(cache && cache->count) {
+		slot = cache->slots[--cache->count];
+	}
+#endif
+	if(slot == STATIC_POOL_NIL) {
+		slot = static_pool_pop(static_pool);
+	}
+	if(slot == STATIC_POOL_NIL) {
+		/* the slab is exhausted */
+		return apt_task_msg_acquire(static_pool->overflow_pool);
+	}
+
+	task_msg = static_pool_slot_get(static_pool,slot);
+	task_msg->msg_pool = task_msg_pool;
+	task_msg->type = TASK_MSG_USER;
+	task_msg->sub_type = 0;
+	task_msg->signal_time = 0;
+	return task_msg;
+}
+
+static void static_pool_release_msg(apt_task_msg_t *task_msg)
+{
+	apt_msg_pool_static_t *static_pool;
+	apr_uint16_t slot;
+#ifdef APT_THREAD_LOCAL
+	apt_msg_cache_t *cache;
+#endif
+	if(!task_msg) {
+		return;
+	}
+
+	static_pool = task_msg->msg_pool->obj;
+	slot = (apr_uint16_t)(((char*)task_msg - static_pool->slab) / static_pool->size);
+#ifdef APT_THREAD_LOCAL
+	cache = static_pool_cache_get(static_pool);
+	if(cache && cache->count < MSG_CACHE_SIZE) {
+		cache->slots[cache->count++] = slot;
+		return;
+	}
+#endif
+	static_pool_push(static_pool,slot);
+}
+
+static void static_pool_destroy(apt_task_msg_pool_t *task_msg_pool)
+{
+	/* the slab is allocated from the memory pool */
+}
+
+/** Create pool of task messages with static allocation of messages */
+APT_DECLARE(apt_task_msg_pool_t*) apt_task_msg_pool_create_static(apr_size_t msg_size, apr_size_t pool_size, apr_pool_t *pool)
+{
+	apr_size_t i;
+	apt_task_msg_pool_t *task_msg_pool;
+	apt_msg_pool_static_t *static_pool;
+	if(!pool_size || pool_size > STATIC_POOL_MAX_SIZE) {
+		return NULL;
+	}
+
+	task_msg_pool = apr_palloc(pool,sizeof(apt_task_msg_pool_t));
+	static_pool = apr_palloc(pool,sizeof(apt_msg_pool_static_t));
+	static_pool->id = apr_atomic_inc32(&static_pool_counter) + 1;
+	static_pool->size = APR_ALIGN_DEFAULT(msg_size + sizeof(apt_task_msg_t) - 1);
+	static_pool->count = pool_size;
+	static_pool->slab = apr_palloc(pool,static_pool->size * pool_size);
+	static_pool->next = apr_palloc(pool,sizeof(apr_uint16_t) * pool_size);
+	for(i=0; i<pool_size; i++) {
+		static_pool->next[i] = (apr_uint16_t)((i + 1 < pool_size) ? i + 1 : STATIC_POOL_NIL);
+	}
+	static_pool->head = 0;
+	static_pool->overflow_pool = apt_task_msg_pool_create_dynamic(msg_size,pool);
+
+	task_msg_pool->pool = pool;
+	task_msg_pool->obj = static_pool;
+	task_msg_pool->acquire_msg = static_pool_acquire_msg;
+	task_msg_pool->release_msg = static_pool_release_msg;
+	task_msg_pool->destroy = static_pool_destroy;
+	return task_msg_pool;
+}
 
 
 APT_DECLARE(void) apt_task_msg_pool_destroy(apt_task_msg_pool_t *msg_pool)
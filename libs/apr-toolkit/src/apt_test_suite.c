@@ -16,6 +16,7 @@
  * $Id$
  */
 
+#include <string.h>
 #include "apt_pool.h"
 #include "apt_obj_list.h"
 #include "apt_test_suite.h"
@@ -24,6 +25,7 @@
 struct apt_test_framework_t{
 	apr_pool_t     *pool;
 	apt_obj_list_t *suites;
+	apr_file_t     *result_file;
 };
 
 APT_DECLARE(apt_test_suite_t*) apt_test_suite_create(apr_pool_t *pool, const char *name, 
@@ -34,9 +36,23 @@ APT_DECLARE(apt_test_suite_t*) apt_test_suite_create(apr_pool_t *pool, const cha
 	apt_string_assign(&suite->name,name,pool);
 	suite->obj = obj;
 	suite->tester = tester;
+	suite->result_file = NULL;
 	return suite;
 }
 
+APT_DECLARE(void) apt_test_result_add(apt_test_suite_t *suite, const char *name, const char *metric, double value, const char *unit)
+{
+	if(!suite->result_file) {
+		return;
+	}
+	apr_file_printf(suite->result_file,"%s\t%s\t%s\t%.3f\t%s\n",
+		suite->name.buf,
+		name,
+		metric,
+		value,
+		unit);
+}
+
 APT_DECLARE(apt_test_framework_t*) apt_test_framework_create()
 {
 	apt_test_framework_t *framework;
@@ -44,6 +60,7 @@ APT_DECLARE(apt_test_framework_t*) apt_test_framework_create()
 	framework = apr_palloc(pool,sizeof(apt_test_framework_t));
 	framework->pool = pool;
 	framework->suites = apt_list_create(pool);
+	framework->result_file = NULL;
 
 	apt_log_instance_create(APT_LOG_OUTPUT_CONSOLE,APT_PRIO_INFO,pool);
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Create Test Framework");
@@ -73,9 +90,12 @@ static apt_bool_t apt_test_framework_suite_run(apt_test_framework_t *framework,
 {
 	apt_bool_t status = FALSE;
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"----- Run Test Suite [%s] -----",suite->name.buf);
+	suite->result_file = framework->result_file;
 	if(suite->tester) {
 		status = suite->tester(suite,argc,argv);
 	}
+	apt_test_result_add(suite,"suite","status",status == TRUE ? 1 : 0,"bool");
+	suite->result_file = NULL;
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"---- Status [%s] ----\n",(status == TRUE) ? "OK" : "Failure");
 	return status;
 }
@@ -84,6 +104,17 @@ APT_DECLARE(apt_bool_t) apt_test_framework_run(apt_test_framework_t *framework,
 {
 	apt_test_suite_t *suite = NULL;
 	apt_list_elem_t *elem = apt_list_first_elem_get(framework->suites);
+	if(argc > 2 && strcmp(argv[1],"--results") == 0) {
+		if(apr_file_open(&framework->result_file,argv[2],
+				APR_FOPEN_WRITE | APR_FOPEN_CREATE | APR_FOPEN_APPEND | APR_FOPEN_BUFFERED,
+				APR_OS_DEFAULT,framework->pool) != APR_SUCCESS) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open Results File [%s]",argv[2]);
+			return FALSE;
+		}
+		/* skip the option, the suite name and its arguments follow as usual (argv[0] is not used) */
+		argc -= 2;
+		argv += 2;
+	}
 	if(argc == 1) {
 		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Run All Test Suites");
 		/* walk through the list of test suites and run all of them */
@@ -117,5 +148,9 @@ APT_DECLARE(apt_bool_t) apt_test_framework_run(apt_test_framework_t *framework,
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Such Test Suite [%s] to Run", argv[1]);
 		}
 	}
+	if(framework->result_file) {
+		apr_file_close(framework->result_file);
+		framework->result_file = NULL;
+	}
 	return TRUE;
 }
@@ -37,6 +37,8 @@ struct apt_message_parser_t {
 	apt_message_stage_e                stage;
 	apt_bool_t                         skip_lf;
 	apt_bool_t                         verbose;
+	apt_bool_t                         zero_copy;
+	apt_bool_t                         pinned;
 };
 
 /** Text message generator */
@@ -50,8 +52,44 @@ struct apt_message_generator_t {
 	apt_bool_t                            verbose;
 };
 
-/** Parse individual header field (name-value pair) */
-APT_DECLARE(apt_header_field_t*) apt_header_field_parse(apt_text_stream_t *stream, apr_pool_t *pool)
+/** Allocate header field from inline storage of header section (if any) */
+static APR_INLINE apt_header_field_t* apt_header_field_new(apt_header_section_t *header, apr_pool_t *pool)
+{
+	if(header) {
+		return apt_header_section_field_alloc(header,pool);
+	}
+	return apt_header_field_alloc(pool);
+}
+
+/** Reference parsed name-value pair in the stream, terminating the name and the value in place */
+static apt_header_field_t* apt_header_field_reference(apt_header_section_t *header, apt_text_stream_t *stream, const apt_pair_t *pair, apr_pool_t *pool)
+{
+	apt_header_field_t *header_field;
+	char *name_end;
+	char *value_end;
+	if(!pair->name.length) {
+		return NULL;
+	}
+
+	/* the name is followed by ':', the value by white spaces or <CR><LF>, which are already consumed;
+	<CR> at the end of the stream is still looked at to detect segmentation between <CR> and <LF> */
+	name_end = pair->name.buf + pair->name.length;
+	value_end = pair->value.buf ? pair->value.buf + pair->value.length : name_end;
+	if(name_end >= stream->pos || value_end + 1 >= stream->pos) {
+		return NULL;
+	}
+
+	*name_end = '\0';
+	*value_end = '\0';
+	header_field = apt_header_field_new(header,pool);
+	header_field->name = pair->name;
+	header_field->value.buf = pair->value.buf ? pair->value.buf : name_end;
+	header_field->value.length = pair->value.length;
+	return header_field;
+}
+
+/** Parse individual header field (name-value pair), referencing the stream if zero_copy is set */
+static apt_header_field_t* apt_header_field_parse_internal(apt_header_section_t *header, apt_text_stream_t *stream, apt_bool_t zero_copy, apt_bool_t *referenced, apr_pool_t *pool)
 {
 	apr_size_t folding_length = 0;
 	apr_array_header_t *folded_lines = NULL;
@@ -85,7 +123,15 @@ APT_DECLARE(apt_header_field_t*) apt_header_field_parse(apt_text_stream_t *strea
 		}
 	};
 
-	header_field = apt_header_field_alloc(pool);
+	if(zero_copy == TRUE && !folding_length) {
+		header_field = apt_header_field_reference(header,stream,&pair,pool);
+		if(header_field) {
+			*referenced = TRUE;
+			return header_field;
+		}
+	}
+
+	header_field = apt_header_field_new(header,pool);
 	/* copy parsed name of the header field */
 	header_field->name.length = pair.name.length;
 	header_field->name.buf = apr_palloc(pool, pair.name.length + 1);
@@ -117,27 +163,36 @@ APT_DECLARE(apt_header_field_t*) apt_header_field_parse(apt_text_stream_t *strea
 	return header_field;
 }
 
+/** Parse individual header field (name-value pair) */
+APT_DECLARE(apt_header_field_t*) apt_header_field_parse(apt_text_stream_t *stream, apr_pool_t *pool)
+{
+	return apt_header_field_parse_internal(NULL,stream,FALSE,NULL,pool);
+}
+
 /** Generate individual header field (name-value pair) */
 APT_DECLARE(apt_bool_t) apt_header_field_generate(const apt_header_field_t *header_field, apt_text_stream_t *stream)
 {
 	return apt_text_name_value_insert(stream,&header_field->name,&header_field->value);
 }
 
-/** Parse header section */
-APT_DECLARE(apt_bool_t) apt_header_section_parse(apt_header_section_t *header, apt_text_stream_t *stream, apr_pool_t *pool)
+/** Parse header section, referencing the stream if zero_copy is set */
+static apt_bool_t apt_header_section_parse_internal(apt_header_section_t *header, apt_text_stream_t *stream, apt_bool_t zero_copy, apt_bool_t *referenced, apr_pool_t *pool)
 {
 	apt_header_field_t *header_field;
 	apt_bool_t result = FALSE;
 
 	do {
-		header_field = apt_header_field_parse(stream,pool);
+		header_field = apt_header_field_parse_internal(header,stream,zero_copy,referenced,pool);
 		if(header_field) {
 			if(apt_string_is_empty(&header_field->name) == FALSE) {
 				/* normal header */
 				apt_header_section_field_add(header,header_field);
 			}
 			else {
-				/* empty header => exit */
+				/* empty header => exit, giving the inline field back (if any) */
+				if(header->inline_count && header_field == &header->inline_fields[header->inline_count-1]) {
+					header->inline_count--;
+				}
 				result = TRUE;
 				break;
 			}
@@ -151,6 +206,12 @@ APT_DECLARE(apt_bool_t) apt_header_section_parse(apt_header_section_t *header, a
 	return result;
 }
 
+/** Parse header section */
+APT_DECLARE(apt_bool_t) apt_header_section_parse(apt_header_section_t *header, apt_text_stream_t *stream, apr_pool_t *pool)
+{
+	return apt_header_section_parse_internal(header,stream,FALSE,NULL,pool);
+}
+
 /** Generate header section */
 APT_DECLARE(apt_bool_t) apt_header_section_generate(const apt_header_section_t *header, apt_text_stream_t *stream)
 {
@@ -238,6 +299,8 @@ APT_DECLARE(apt_message_parser_t*) apt_message_parser_create(void *obj, const ap
 	parser->stage = APT_MESSAGE_STAGE_START_LINE;
 	parser->skip_lf = FALSE;
 	parser->verbose = FALSE;
+	parser->zero_copy = FALSE;
+	parser->pinned = FALSE;
 	return parser;
 }
 
@@ -281,7 +344,12 @@ APT_DECLARE(apt_message_status_e) apt_message_parser_run(apt_message_parser_t *p
 
 		if(parser->stage == APT_MESSAGE_STAGE_HEADER) {
 			/* read header section */
-			apt_bool_t res = apt_header_section_parse(parser->context.header,stream,parser->pool);
+			apt_bool_t res = apt_header_section_parse_internal(
+								parser->context.header,
+								stream,
+								parser->zero_copy,
+								&parser->pinned,
+								parser->pool);
 			if(parser->verbose == TRUE) {
 				apr_size_t length = stream->pos - pos;
 				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Parsed Message Header [%"APR_SIZE_T_FMT" bytes]\n%.*s",
@@ -304,6 +372,27 @@ APT_DECLARE(apt_message_status_e) apt_message_parser_run(apt_message_parser_t *p
 			if(parser->context.body && parser->context.body->length) {
 				apt_str_t *body = parser->context.body;
 				parser->content_length = body->length;
+				if(parser->zero_copy == TRUE && stream->pos + body->length == stream->end && *stream->end == '\0') {
+					/* the entire body is available and terminates the stream, reference it */
+					body->buf = stream->pos;
+					stream->pos += body->length;
+					parser->pinned = TRUE;
+					if(parser->verbose == TRUE) {
+						apr_size_t length = body->length;
+						const char *masked_data = apt_log_data_mask(body->buf,&length,parser->pool);
+						apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Parsed Message Body [%"APR_SIZE_T_FMT" bytes]\n%.*s",
+								body->length, length, masked_data);
+					}
+					if(parser->vtable->on_body_complete) {
+						parser->vtable->on_body_complete(parser,&parser->context);
+					}
+					status = APT_MESSAGE_STATUS_COMPLETE;
+					if(message) {
+						*message = parser->context.message;
+					}
+					parser->stage = APT_MESSAGE_STAGE_START_LINE;
+					break;
+				}
 				body->buf = apr_palloc(parser->pool,parser->content_length+1);
 				body->buf[parser->content_length] = '\0';
 				body->length = 0;
@@ -352,6 +441,20 @@ APT_DECLARE(void) apt_message_parser_verbose_set(apt_message_parser_t *parser, a
 	parser->verbose = verbose;
 }
 
+/** Set zero-copy mode for the parser */
+APT_DECLARE(void) apt_message_parser_zero_copy_set(apt_message_parser_t *parser, apt_bool_t zero_copy)
+{
+	parser->zero_copy = zero_copy;
+}
+
+/** Check whether parsed messages reference the stream since the last check */
+APT_DECLARE(apt_bool_t) apt_message_parser_stream_pinned(apt_message_parser_t *parser)
+{
+	apt_bool_t pinned = parser->pinned;
+	parser->pinned = FALSE;
+	return pinned;
+}
+
 
 /** Create message generator */
 APT_DECLARE(apt_message_generator_t*) apt_message_generator_create(void *obj, const apt_message_generator_vtable_t *vtable, apr_pool_t *pool)
@@ -0,0 +1,265 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include "apt_text_scan.h"
+#include "apt_log.h"
+
+/*
+ * The vector scanners compare a block of the stream (16 or 32 bytes)
+ * against each delimiter at once, merge the comparison results into
+ * a bit mask and take the position of the lowest set bit. Loads never
+ * cross the end of the data; the tail shorter than a block is searched
+ * by the scalar routine.
+ */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define APT_TEXT_SCAN_X86
+#define APT_TEXT_SCAN_SSE2
+#define APT_TEXT_SCAN_AVX2
+#define APT_TEXT_SCAN_TARGET(isa) __attribute__((target(isa)))
+#define APT_TEXT_SCAN_CTZ(mask) __builtin_ctz(mask)
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define APT_TEXT_SCAN_X86
+#define APT_TEXT_SCAN_SSE2
+#if _MSC_VER >= 1700
+#define APT_TEXT_SCAN_AVX2
+#endif
+#define APT_TEXT_SCAN_TARGET(isa)
+#include <intrin.h>
+#include <immintrin.h>
+static APR_INLINE unsigned int apt_text_scan_ctz(unsigned int mask)
+{
+	unsigned long index;
+	_BitScanForward(&index,mask);
+	return index;
+}
+#define APT_TEXT_SCAN_CTZ(mask) apt_text_scan_ctz(mask)
+#endif
+
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__GNUC__)
+#define APT_TEXT_SCAN_NEON
+#define APT_TEXT_SCAN_CTZ64(mask) __builtin_ctzll(mask)
+#include <arm_neon.h>
+#elif defined(_M_ARM64)
+#define APT_TEXT_SCAN_NEON
+#include <intrin.h>
+#include <arm_neon.h>
+static APR_INLINE unsigned int apt_text_scan_ctz64(unsigned __int64 mask)
+{
+	unsigned long index;
+	_BitScanForward64(&index,mask);
+	return index;
+}
+#define APT_TEXT_SCAN_CTZ64(mask) apt_text_scan_ctz64(mask)
+#endif
+
+static const char* scalar_chr3_find(const char *pos, const char *end, char c1, char c2, char c3)
+{
+	for(; pos < end; pos++) {
+		if(*pos == c1 || *pos == c2 || *pos == c3) {
+			break;
+		}
+	}
+	return pos;
+}
+
+static const apt_text_scanner_t scalar_scanner = {
+	APT_TEXT_SCANNER_SCALAR,
+	"scalar",
+	scalar_chr3_find
+};
+
+#ifdef APT_TEXT_SCAN_SSE2
+APT_TEXT_SCAN_TARGET("sse2")
+static const char* sse2_chr3_find(const char *pos, const char *end, char c1, char c2, char c3)
+{
+	const __m128i v1 = _mm_set1_epi8(c1);
+	const __m128i v2 = _mm_set1_epi8(c2);
+	const __m128i v3 = _mm_set1_epi8(c3);
+	for(; end - pos >= 16; pos += 16) {
+		__m128i x = _mm_loadu_si128((const __m128i*)pos);
+		__m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x,v1),_mm_cmpeq_epi8(x,v2)),_mm_cmpeq_epi8(x,v3));
+		unsigned int mask = (unsigned int)_mm_movemask_epi8(m);
+		if(mask) {
+			return pos + APT_TEXT_SCAN_CTZ(mask);
+		}
+	}
+	return scalar_chr3_find(pos,end,c1,c2,c3);
+}
+
+static const apt_text_scanner_t sse2_scanner = {
+	APT_TEXT_SCANNER_SSE2,
+	"sse2",
+	sse2_chr3_find
+};
+#endif
+
+#ifdef APT_TEXT_SCAN_AVX2
+APT_TEXT_SCAN_TARGET("avx2")
+static const char* avx2_chr3_find(const char *pos, const char *end, char c1, char c2, char c3)
+{
+	const __m256i v1 = _mm256_set1_epi8(c1);
+	const __m256i v2 = _mm256_set1_epi8(c2);
+	const __m256i v3 = _mm256_set1_epi8(c3);
+	for(; end - pos >= 32; pos += 32) {
+		__m256i x = _mm256_loadu_si256((const __m256i*)pos);
+		__m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x,v1),_mm256_cmpeq_epi8(x,v2)),_mm256_cmpeq_epi8(x,v3));
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(m);
+		if(mask) {
+			return pos + APT_TEXT_SCAN_CTZ(mask);
+		}
+	}
+	/* header lines are mostly short, the tail is worth a 16 byte step */
+	if(end - pos >= 16) {
+		__m128i x = _mm_loadu_si128((const __m128i*)pos);
+		__m128i m = _mm_or_si128(_mm_or_si128(
+						_mm_cmpeq_epi8(x,_mm256_castsi256_si128(v1)),
+						_mm_cmpeq_epi8(x,_mm256_castsi256_si128(v2))),
+						_mm_cmpeq_epi8(x,_mm256_castsi256_si128(v3)));
+		unsigned int mask = (unsigned int)_mm_movemask_epi8(m);
+		if(mask) {
+			return pos + APT_TEXT_SCAN_CTZ(mask);
+		}
+		pos += 16;
+	}
+	return scalar_chr3_find(pos,end,c1,c2,c3);
+}
+
+static const apt_text_scanner_t avx2_scanner = {
+	APT_TEXT_SCANNER_AVX2,
+	"avx2",
+	avx2_chr3_find
+};
+#endif
+
+#ifdef APT_TEXT_SCAN_NEON
+static const char* neon_chr3_find(const char *pos, const char *end, char c1, char c2, char c3)
+{
+	const uint8x16_t v1 = vdupq_n_u8((apr_byte_t)c1);
+	const uint8x16_t v2 = vdupq_n_u8((apr_byte_t)c2);
+	const uint8x16_t v3 = vdupq_n_u8((apr_byte_t)c3);
+	for(; end - pos >= 16; pos += 16) {
+		uint8x16_t x = vld1q_u8((const apr_byte_t*)pos);
+		uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(x,v1),vceqq_u8(x,v2)),vceqq_u8(x,v3));
+		/* there is no movemask, narrow each byte of the mask to a nibble instead */
+		apr_uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m),4)),0);
+		if(mask) {
+			return pos + (APT_TEXT_SCAN_CTZ64(mask) >> 2);
+		}
+	}
+	return scalar_chr3_find(pos,end,c1,c2,c3);
+}
+
+static const apt_text_scanner_t neon_scanner = {
+	APT_TEXT_SCANNER_NEON,
+	"neon",
+	neon_chr3_find
+};
+#endif
+
+#ifdef APT_TEXT_SCAN_X86
+static apt_bool_t apt_text_scan_cpu_supports(apt_text_scanner_e type)
+{
+#if defined(__GNUC__)
+	__builtin_cpu_init();
+	if(type == APT_TEXT_SCANNER_SSE2) {
+		return __builtin_cpu_supports("sse2") ? TRUE : FALSE;
+	}
+	if(type == APT_TEXT_SCANNER_AVX2) {
+		return __builtin_cpu_supports("avx2") ? TRUE : FALSE;
+	}
+#else
+	int info[4];
+	__cpuid(info,1);
+	if(type == APT_TEXT_SCANNER_SSE2) {
+		return (info[3] & (1 << 26)) ? TRUE : FALSE;
+	}
+#ifdef APT_TEXT_SCAN_AVX2
+	if(type == APT_TEXT_SCANNER_AVX2) {
+		/* OS must save YMM state (OSXSAVE + XCR0) besides CPU support */
+		if(!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 0x06) != 0x06) {
+			return FALSE;
+		}
+		__cpuidex(info,7,0);
+		return (info[1] & (1 << 5)) ? TRUE : FALSE;
+	}
+#endif
+#endif
+	return FALSE;
+}
+#endif
+
+/** Scanner used by the readers of text stream (NULL until the first use) */
+static const apt_text_scanner_t *active_scanner = NULL;
+
+/** Get the scanner of the specified instruction set */
+APT_DECLARE(const apt_text_scanner_t*) apt_text_scanner_get(apt_text_scanner_e type)
+{
+	switch(type) {
+		case APT_TEXT_SCANNER_SCALAR:
+			return &scalar_scanner;
+#ifdef APT_TEXT_SCAN_SSE2
+		case APT_TEXT_SCANNER_SSE2:
+			return apt_text_scan_cpu_supports(type) == TRUE ? &sse2_scanner : NULL;
+#endif
+#ifdef APT_TEXT_SCAN_AVX2
+		case APT_TEXT_SCANNER_AVX2:
+			return apt_text_scan_cpu_supports(type) == TRUE ? &avx2_scanner : NULL;
+#endif
+#ifdef APT_TEXT_SCAN_NEON
+		case APT_TEXT_SCANNER_NEON:
+			return &neon_scanner;
+#endif
+		default:
+			break;
+	}
+	return NULL;
+}
+
+/** Get the fastest scanner supported by the CPU */
+APT_DECLARE(const apt_text_scanner_t*) apt_text_scanner_best_get(void)
+{
+	static const apt_text_scanner_t *best_scanner = NULL;
+	if(!best_scanner) {
+		/* detection is idempotent, a concurrent first call is harmless */
+		const apt_text_scanner_t *scanner = NULL;
+		int type;
+		for(type = APT_TEXT_SCANNER_COUNT - 1; type >= 0 && !scanner; type--) {
+			scanner = apt_text_scanner_get((apt_text_scanner_e)type);
+		}
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Select Text Scanner [%s]",scanner->name);
+		best_scanner = scanner;
+	}
+	return best_scanner;
+}
+
+/** Get the scanner used by the readers of text stream */
+APT_DECLARE(const apt_text_scanner_t*) apt_text_scanner_active_get(void)
+{
+	if(!active_scanner) {
+		active_scanner = apt_text_scanner_best_get();
+	}
+	return active_scanner;
+}
+
+/** Select the scanner used by the readers of text stream */
+APT_DECLARE(void) apt_text_scanner_select(const apt_text_scanner_t *scanner)
+{
+	active_scanner = scanner ? scanner : apt_text_scanner_best_get();
+}
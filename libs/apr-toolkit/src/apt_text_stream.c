@@ -18,42 +18,88 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <apr_uuid.h>
 #include "apt_text_stream.h"
+#include "apt_text_scan.h"
+#include "apt_string_intern.h"
 
 #define TOKEN_TRUE  "true"
 #define TOKEN_FALSE "false"
 #define TOKEN_TRUE_LENGTH  (sizeof(TOKEN_TRUE)-1)
 #define TOKEN_FALSE_LENGTH (sizeof(TOKEN_FALSE)-1)
 
+/** Number of hex digits generated out of a 64-bit value */
+#define UNIQUE_ID_WORD_DIGITS 16
+/** Odd increment of the Weyl sequence the counter is stepped by */
+#define UNIQUE_ID_INCREMENT   APR_UINT64_C(0x9E3779B97F4A7C15)
+
+/** State of the generator of unique identifiers */
+typedef struct {
+	/** Random seed, zero until the generator is seeded */
+	apr_uint64_t seed;
+	/** Counter of generated words */
+	apr_uint64_t counter;
+} apt_unique_id_state_t;
+
+#ifdef APT_THREAD_LOCAL
+/** Per-thread state, no locking and no shared cache lines on call storms */
+static APT_THREAD_LOCAL apt_unique_id_state_t unique_id_state;
+#endif
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/** Decimal digits of the numbers 00 through 99 */
+static const char digit_pairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+/** Digits of the fraction of generated float values, as "%f" has */
+#define FLOAT_FRACTION_DIGITS 6
+#define FLOAT_FRACTION_SCALE  1000000
+/** Max magnitude of float values generated in fixed-point */
+#define FLOAT_FIXED_MAX       1e12
+/** Max number of significant digits parsed exactly */
+#define FLOAT_PARSE_MAX_DIGITS 18
+
+/** Powers of ten to scale parsed fractions by */
+static const double float_scales[FLOAT_PARSE_MAX_DIGITS + 1] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+	1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+};
+
 
 /** Navigate through the lines of the text stream (message) */
 APT_DECLARE(apt_bool_t) apt_text_line_read(apt_text_stream_t *stream, apt_str_t *line)
 {
+	const apt_text_scanner_t *scanner = apt_text_scanner_active_get();
 	char *pos = stream->pos;
 	apt_bool_t status = FALSE;
 	line->length = 0;
 	line->buf = pos;
-	/* while not end of stream */
-	while(pos < stream->end) {
+	/* find end of line */
+	pos = (char*)scanner->chr3_find(pos,stream->end,APT_TOKEN_CR,APT_TOKEN_LF,APT_TOKEN_LF);
+	if(pos < stream->end) {
+		/* end of line detected */
+		line->length = pos - line->buf;
 		if(*pos == APT_TOKEN_CR) {
-			/* end of line detected */
-			line->length = pos - line->buf;
 			pos++;
 			if(pos < stream->end && *pos == APT_TOKEN_LF) {
 				pos++;
 			}
-			status = TRUE;
-			break;
 		}
-		else if(*pos == APT_TOKEN_LF) {
-			/* end of line detected */
-			line->length = pos - line->buf;
+		else {
 			pos++;
-			status = TRUE;
-			break;
 		}
-		pos++;
+		status = TRUE;
 	}
 
 	if(status == TRUE) {
@@ -82,52 +128,54 @@ APT_DECLARE(apt_bool_t) apt_text_line_read(apt_text_stream_t *stream, apt_str_t
 */
 APT_DECLARE(apt_bool_t) apt_text_header_read(apt_text_stream_t *stream, apt_pair_t *pair)
 {
+	const apt_text_scanner_t *scanner = apt_text_scanner_active_get();
 	char *pos = stream->pos;
+	const char *end = stream->end;
 	apt_bool_t status = FALSE;
 	apt_string_reset(&pair->name);
 	apt_string_reset(&pair->value);
-	/* while not end of stream */
-	while(pos < stream->end) {
-		if(*pos == APT_TOKEN_CR) {
-			/* end of line detected */
-			if(pair->value.buf) {
-				/* set length of the value */
-				pair->value.length = pos - pair->value.buf;
+
+	/* skip preceding white spaces (SHOULD NOT be any WSP, though) and read name */
+	while(pos < end && apt_text_is_wsp(*pos) == TRUE) pos++;
+	if(pos < end && *pos != APT_TOKEN_CR && *pos != APT_TOKEN_LF) {
+		pair->name.buf = pos;
+		do {
+			pos = (char*)scanner->chr3_find(pos,end,':',APT_TOKEN_CR,APT_TOKEN_LF);
+			if(pos == end || *pos != ':') {
+				break;
 			}
+			/* set length of the name */
+			pair->name.length = pos - pair->name.buf;
 			pos++;
-			if(pos < stream->end && *pos == APT_TOKEN_LF) {
-				pos++;
-			}
-			status = TRUE;
-			break;
 		}
-		else if(*pos == APT_TOKEN_LF) {
-			/* end of line detected */
-			if(pair->value.buf) {
-				/* set length of the value */
-				pair->value.length = pos - pair->value.buf;
-			}
-			pos++;
-			status = TRUE;
-			break;
+		while(!pair->name.length);
+	}
+
+	if(pair->name.length) {
+		/* skip preceding white spaces and read value */
+		while(pos < end && apt_text_is_wsp(*pos) == TRUE) pos++;
+		if(pos < end && *pos != APT_TOKEN_CR && *pos != APT_TOKEN_LF) {
+			pair->value.buf = pos;
+			pos = (char*)scanner->chr3_find(pos,end,APT_TOKEN_CR,APT_TOKEN_LF,APT_TOKEN_LF);
 		}
-		else if(!pair->name.length) {
-			/* skip preceding white spaces (SHOULD NOT be any WSP, though) and read name */
-			if(!pair->name.buf && apt_text_is_wsp(*pos) == FALSE) {
-				pair->name.buf = pos;
-			}
-			if(*pos == ':') {
-				/* set length of the name */
-				pair->name.length = pos - pair->name.buf;
-			}
+	}
+
+	if(pos < end) {
+		/* end of line detected */
+		if(pair->value.buf) {
+			/* set length of the value */
+			pair->value.length = pos - pair->value.buf;
 		}
-		else if(!pair->value.length) {
-			/* skip preceding white spaces and read value */
-			if(!pair->value.buf && apt_text_is_wsp(*pos) == FALSE) {
-				pair->value.buf = pos;
+		if(*pos == APT_TOKEN_CR) {
+			pos++;
+			if(pos < end && *pos == APT_TOKEN_LF) {
+				pos++;
 			}
 		}
-		pos++;
+		else {
+			pos++;
+		}
+		status = TRUE;
 	}
 
 	if(status == TRUE) {
@@ -158,7 +206,13 @@ APT_DECLARE(apt_bool_t) apt_text_field_read(apt_text_stream_t *stream, char sepa
 
 	field->buf = pos;
 	field->length = 0;
-	while(pos < stream->end && *pos != separator) pos++;
+	if(pos < stream->end) {
+		/* memchr is vectorized by the C library */
+		pos = memchr(pos,separator,stream->end - pos);
+		if(!pos) {
+			pos = (char*)stream->end;
+		}
+	}
 
 	field->length = pos - field->buf;
 	if(pos < stream->end) {
@@ -190,6 +244,28 @@ APT_DECLARE(apt_bool_t) apt_text_stream_scroll(apt_text_stream_t *stream)
 	return TRUE;
 }
 
+/** Move the remaining data of text stream to another buffer */
+APT_DECLARE(apt_bool_t) apt_text_stream_relocate(apt_text_stream_t *stream, char *buffer, apr_size_t size)
+{
+	apr_size_t remaining_length = 0;
+	if(stream->pos < stream->end) {
+		remaining_length = stream->text.buf + stream->text.length - stream->pos;
+	}
+	if(remaining_length > size) {
+		return FALSE;
+	}
+
+	if(remaining_length) {
+		memcpy(buffer,stream->pos,remaining_length);
+	}
+	stream->text.buf = buffer;
+	stream->text.length = remaining_length;
+	stream->pos = buffer + remaining_length;
+	stream->end = buffer + size;
+	*stream->pos = '\0';
+	return TRUE;
+}
+
 /** Parse id@resource string */
 APT_DECLARE(apt_bool_t) apt_id_resource_parse(const apt_str_t *str, char separator, apt_str_t *id, apt_str_t *resource, apr_pool_t *pool)
 {
@@ -206,7 +282,8 @@ APT_DECLARE(apt_bool_t) apt_id_resource_parse(const apt_str_t *str, char separat
 	apt_string_copy(id,&field,pool);
 	field.buf += field.length + 1;
 	field.length = str->length - (field.length + 1);
-	apt_string_copy(resource,&field,pool);
+	/* well-known resource names are not copied */
+	apt_string_intern_copy(resource,&field,pool);
 	return TRUE;
 }
 
@@ -386,27 +463,127 @@ APT_DECLARE(apt_bool_t) apt_boolean_value_generate(apt_bool_t value, apt_str_t *
 }
 
 
+/** Parse unsigned decimal value */
+APT_DECLARE(apr_uint64_t) apt_uint64_value_parse(const apt_str_t *str)
+{
+	const char *pos;
+	const char *end;
+	apr_uint64_t value = 0;
+	apt_bool_t negative = FALSE;
+	if(!str->buf) {
+		return 0;
+	}
+
+	pos = str->buf;
+	end = pos + str->length;
+	while(pos < end && (*pos == APT_TOKEN_SP || *pos == APT_TOKEN_HTAB)) pos++;
+	if(pos < end && (*pos == '+' || *pos == '-')) {
+		negative = *pos == '-' ? TRUE : FALSE;
+		pos++;
+	}
+	for(; pos < end && *pos >= '0' && *pos <= '9'; pos++) {
+		value = value * 10 + (*pos - '0');
+	}
+	/* negative values wrap around, as atol() cast to unsigned does */
+	return negative == TRUE ? (apr_uint64_t)0 - value : value;
+}
+
+/** Format unsigned decimal value */
+APT_DECLARE(apr_size_t) apt_uint64_value_format(apr_uint64_t value, char *buf)
+{
+	char digits[APT_UINT64_VALUE_MAX_LENGTH];
+	char *pos = digits + sizeof(digits);
+	apr_size_t length;
+
+	/* two digits at a time, backwards */
+	while(value >= 100) {
+		const char *pair = digit_pairs + (value % 100) * 2;
+		value /= 100;
+		*--pos = pair[1];
+		*--pos = pair[0];
+	}
+	if(value >= 10) {
+		const char *pair = digit_pairs + value * 2;
+		*--pos = pair[1];
+		*--pos = pair[0];
+	}
+	else {
+		*--pos = (char)('0' + value);
+	}
+
+	length = digits + sizeof(digits) - pos;
+	memcpy(buf,pos,length);
+	return length;
+}
+
+/** Format float value */
+APT_DECLARE(apr_size_t) apt_float_value_format(float value, char *buf)
+{
+	double d = value;
+	apr_uint64_t scaled;
+	apr_uint32_t fraction;
+	char *pos = buf;
+	int i;
+
+	if(d != d || d > FLOAT_FIXED_MAX || d < -FLOAT_FIXED_MAX) {
+		/* NaN, infinity and large values are out of the fixed-point range */
+		int length = apr_snprintf(buf,APT_FLOAT_VALUE_MAX_LENGTH,"%f",value);
+		if(length <= 0) {
+			return 0;
+		}
+		pos = buf + length;
+	}
+	else {
+		if(d < 0) {
+			*pos++ = '-';
+			d = -d;
+		}
+		scaled = (apr_uint64_t)(d * FLOAT_FRACTION_SCALE + 0.5);
+		pos += apt_uint64_value_format(scaled / FLOAT_FRACTION_SCALE,pos);
+		*pos++ = '.';
+		fraction = (apr_uint32_t)(scaled % FLOAT_FRACTION_SCALE);
+		for(i=FLOAT_FRACTION_DIGITS-1; i>=0; i--) {
+			pos[i] = (char)('0' + fraction % 10);
+			fraction /= 10;
+		}
+		pos += FLOAT_FRACTION_DIGITS;
+	}
+
+	/* remove trailing 0s (if any), keeping a digit after the point */
+	while(pos - buf > 2 && *(pos - 1) == '0' && *(pos - 2) != '.') pos--;
+	return pos - buf;
+}
+
 /** Parse size_t value */
 APT_DECLARE(apr_size_t) apt_size_value_parse(const apt_str_t *str)
 {
-	return str->buf ? atol(str->buf) : 0;
+	return (apr_size_t)apt_uint64_value_parse(str);
 }
 
 /** Generate apr_size_t value (buffer is allocated from pool) */
 APT_DECLARE(apt_bool_t) apt_size_value_generate(apr_size_t value, apt_str_t *str, apr_pool_t *pool)
 {
-	str->buf = apr_psprintf(pool, "%"APR_SIZE_T_FMT, value);
-	str->length = strlen(str->buf);
+	str->buf = apr_palloc(pool,APT_UINT64_VALUE_MAX_LENGTH + 1);
+	str->length = apt_uint64_value_format(value,str->buf);
+	str->buf[str->length] = '\0';
 	return TRUE;
 }
 
 /** Insert apr_size_t value */
 APT_DECLARE(apt_bool_t) apt_text_size_value_insert(apt_text_stream_t *stream, apr_size_t value)
 {
-	int length = apr_snprintf(stream->pos, stream->end - stream->pos, "%"APR_SIZE_T_FMT, value);
-	if(length <= 0) {
+	char buf[APT_UINT64_VALUE_MAX_LENGTH];
+	apr_size_t length;
+	if(stream->pos + APT_UINT64_VALUE_MAX_LENGTH < stream->end) {
+		/* enough room to format in place */
+		stream->pos += apt_uint64_value_format(value,stream->pos);
+		return TRUE;
+	}
+	length = apt_uint64_value_format(value,buf);
+	if(stream->pos + length >= stream->end) {
 		return FALSE;
 	}
+	memcpy(stream->pos,buf,length);
 	stream->pos += length;
 	return TRUE;
 }
@@ -415,38 +592,79 @@ APT_DECLARE(apt_bool_t) apt_text_size_value_insert(apt_text_stream_t *stream, ap
 /** Parse float value */
 APT_DECLARE(float) apt_float_value_parse(const apt_str_t *str)
 {
-	return str->buf ? (float)atof(str->buf) : 0;
+	const char *pos;
+	const char *end;
+	apr_uint64_t mantissa = 0;
+	apr_size_t digit_count = 0;
+	apr_size_t fraction_count = 0;
+	apt_bool_t point = FALSE;
+	apt_bool_t negative = FALSE;
+	double value;
+	if(!str->buf) {
+		return 0;
+	}
+
+	pos = str->buf;
+	end = pos + str->length;
+	while(pos < end && (*pos == APT_TOKEN_SP || *pos == APT_TOKEN_HTAB)) pos++;
+	if(pos < end && (*pos == '+' || *pos == '-')) {
+		negative = *pos == '-' ? TRUE : FALSE;
+		pos++;
+	}
+	for(; pos < end; pos++) {
+		if(*pos >= '0' && *pos <= '9') {
+			if(++digit_count > FLOAT_PARSE_MAX_DIGITS) {
+				/* too many digits to be exact */
+				return (float)atof(str->buf);
+			}
+			mantissa = mantissa * 10 + (*pos - '0');
+			if(point == TRUE) {
+				fraction_count++;
+			}
+		}
+		else if(*pos == '.' && point == FALSE) {
+			point = TRUE;
+		}
+		else if(*pos == 'e' || *pos == 'E') {
+			/* exponent notation, rare in header values */
+			return (float)atof(str->buf);
+		}
+		else {
+			break;
+		}
+	}
+
+	/* both operands are exact, so is the quotient up to rounding */
+	value = (double)mantissa / float_scales[fraction_count];
+	return (float)(negative == TRUE ? -value : value);
 }
 
 /** Generate float value (buffer is allocated from pool) */
 APT_DECLARE(apt_bool_t) apt_float_value_generate(float value, apt_str_t *str, apr_pool_t *pool)
 {
-	char *end;
-	str->buf = apr_psprintf(pool,"%f",value);
-	str->length = strlen(str->buf);
-
-	/* remove trailing 0s (if any) */
-	end = str->buf + str->length - 1;
-	while(*end == 0x30 && end != str->buf && *(end - 1) != '.') end--;
-
-	str->length = end - str->buf + 1;
-	return TRUE;
+	str->buf = apr_palloc(pool,APT_FLOAT_VALUE_MAX_LENGTH + 1);
+	str->length = apt_float_value_format(value,str->buf);
+	str->buf[str->length] = '\0';
+	return str->length ? TRUE : FALSE;
 }
 
 /** Generate float value */
 APT_DECLARE(apt_bool_t) apt_text_float_value_insert(apt_text_stream_t *stream, float value)
 {
-	char *end;
-	int length = apr_snprintf(stream->pos, stream->end - stream->pos, "%f", value);
-	if(length <= 0) {
+	char buf[APT_FLOAT_VALUE_MAX_LENGTH];
+	apr_size_t length;
+	if(stream->pos + APT_FLOAT_VALUE_MAX_LENGTH < stream->end) {
+		/* enough room to format in place */
+		length = apt_float_value_format(value,stream->pos);
+		stream->pos += length;
+		return length ? TRUE : FALSE;
+	}
+	length = apt_float_value_format(value,buf);
+	if(!length || stream->pos + length >= stream->end) {
 		return FALSE;
 	}
-
-	/* remove trailing 0s (if any) */
-	end = stream->pos + length - 1;
-	while(*end == 0x30 && end != stream->pos && *(end - 1) != '.') end--;
-
-	stream->pos = end + 1;
+	memcpy(stream->pos,buf,length);
+	stream->pos += length;
 	return TRUE;
 }
 
@@ -470,7 +688,6 @@ APT_DECLARE(apt_bool_t) apt_var_length_value_generate(apr_size_t *value, apr_siz
 	apr_size_t temp;
 	apr_size_t count; /* M */
 	apr_size_t bounds; /* 10^M */
-	int length;
 
 	/* calculate count */
 	temp = *value;
@@ -491,12 +708,8 @@ APT_DECLARE(apt_bool_t) apt_var_length_value_generate(apr_size_t *value, apr_siz
 		return FALSE;
 	}
 
-	str->length = 0;
-	length = sprintf(str->buf, "%"APR_SIZE_T_FMT, *value);
-	if(length <= 0) {
-		return FALSE;
-	}
-	str->length = length;
+	str->length = apt_uint64_value_format(*value,str->buf);
+	str->buf[str->length] = '\0';
 	return TRUE;
 }
 
@@ -504,7 +717,7 @@ APT_DECLARE(apt_bool_t) apt_var_length_value_generate(apr_size_t *value, apr_siz
 APT_DECLARE(apt_bool_t) apt_completion_cause_generate(const apt_str_table_item_t table[], apr_size_t size, apr_size_t cause, apt_str_t *str, apr_pool_t *pool)
 {
 	const apt_str_t *name = apt_string_table_str_get(table,size,cause);
-	if(!name) {
+	if(!name || cause > 999) {
 		return FALSE;
 	}
 
@@ -512,9 +725,10 @@ APT_DECLARE(apt_bool_t) apt_completion_cause_generate(const apt_str_table_item_t
 	str->length = 4 + name->length;
 	str->buf = apr_palloc(pool,str->length + 1);
 
-	if(sprintf(str->buf,"%03"APR_SIZE_T_FMT" ",cause) != 4) {
-		return FALSE;
-	}
+	str->buf[0] = (char)('0' + cause / 100);
+	str->buf[1] = (char)('0' + cause / 10 % 10);
+	str->buf[2] = (char)('0' + cause % 10);
+	str->buf[3] = APT_TOKEN_SP;
 
 	memcpy(str->buf+4,name->buf,name->length);
 	str->buf[str->length] = '\0';
@@ -523,22 +737,51 @@ APT_DECLARE(apt_bool_t) apt_completion_cause_generate(const apt_str_table_item_t
 
 
 /** Generate unique identifier (hex string) */
+/** Seed the generator by a UUID, which is unique across threads and processes */
+static void apt_unique_id_seed(apt_unique_id_state_t *state)
+{
+	apr_uuid_t uuid;
+	apr_uuid_get(&uuid);
+	memcpy(&state->seed,uuid.data,sizeof(state->seed));
+	memcpy(&state->counter,uuid.data + sizeof(state->seed),sizeof(state->counter));
+	/* zero stands for the generator not seeded yet */
+	state->seed |= 1;
+}
+
+/** Mix the bits of a value (the finalizer of splitmix64, a bijection) */
+static APR_INLINE apr_uint64_t apt_unique_id_mix(apr_uint64_t value)
+{
+	value = (value ^ (value >> 30)) * APR_UINT64_C(0xBF58476D1CE4E5B9);
+	value = (value ^ (value >> 27)) * APR_UINT64_C(0x94D049BB133111EB);
+	return value ^ (value >> 31);
+}
+
 APT_DECLARE(apt_bool_t) apt_unique_id_generate(apt_str_t *id, apr_size_t length, apr_pool_t *pool)
 {
 	char *hex_str;
 	apr_size_t i;
-	apr_size_t count;
-	apr_uuid_t uuid;
-	apr_uuid_get(&uuid);
-	
+	apr_size_t j;
+	apr_uint64_t value;
+#ifdef APT_THREAD_LOCAL
+	apt_unique_id_state_t *state = &unique_id_state;
+	if(!state->seed) {
+		apt_unique_id_seed(state);
+	}
+#else
+	apt_unique_id_state_t local_state;
+	apt_unique_id_state_t *state = &local_state;
+	apt_unique_id_seed(state);
+#endif
+
 	hex_str = apr_palloc(pool,length+1);
-	
-	count = length / 2;
-	if(count > sizeof(uuid)) {
-		count = sizeof(uuid);
-	}
-	for(i=0; i<count; i++) {
-		sprintf(hex_str+i*2,"%02x",uuid.data[i]);
+
+	/* distinct counters give distinct words, distinct seeds keep threads apart */
+	for(i=0; i<length; ) {
+		value = apt_unique_id_mix(state->seed + state->counter++ * UNIQUE_ID_INCREMENT);
+		for(j=0; j<UNIQUE_ID_WORD_DIGITS && i<length; j++, i++) {
+			hex_str[i] = hex_digits[value & 0x0F];
+			value >>= 4;
+		}
 	}
 	hex_str[length] = '\0';
 
@@ -23,10 +23,35 @@
 #include "apt_timer_queue.h"
 #include "apt_log.h"
 
+/*
+ * Timers are kept in a hierarchical timing wheel of 1 msec resolution.
+ * A timer is placed into the level, which covers the time it is to elapse in,
+ * and is cascaded down to the lower levels as the time advances, so that set
+ * and kill are O(1) and advance is amortized O(1).
+ */
+
+/** Number of bits of time per level */
+#define TIMER_WHEEL_BITS        8
+/** Number of slots per level */
+#define TIMER_WHEEL_SLOTS       (1 << TIMER_WHEEL_BITS)
+/** Mask of slot index */
+#define TIMER_WHEEL_MASK        (TIMER_WHEEL_SLOTS - 1)
+/** Number of levels (covering 32-bit time) */
+#define TIMER_WHEEL_LEVELS      4
+/** Number of 32-bit words in bitmap of occupied slots per level */
+#define TIMER_WHEEL_WORDS       (TIMER_WHEEL_SLOTS / 32)
+
+/** Slot of timing wheel */
+APR_RING_HEAD(apt_timer_head_t, apt_timer_t);
+
 /** Timer queue */
 struct apt_timer_queue_t {
-	/** Ring head */
-	APR_RING_HEAD(apt_timer_head_t, apt_timer_t) head;
+	/** Slots of all the levels */
+	struct apt_timer_head_t slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+	/** Bitmaps of occupied slots */
+	apr_uint32_t  bitmap[TIMER_WHEEL_LEVELS][TIMER_WHEEL_WORDS];
+	/** Number of timers set */
+	apr_size_t    count;
 
 	/** Elapsed time */
 	apr_uint32_t  elapsed_time;
@@ -41,6 +66,11 @@ struct apt_timer_t {
 	apt_timer_queue_t   *queue;
 	/** Time next report is scheduled at */
 	apr_uint32_t         scheduled_time;
+	/** Whether the timer is set */
+	apt_bool_t           scheduled;
+	/** Level and slot the timer is placed in */
+	apr_size_t           level;
+	apr_size_t           slot;
 
 	/** Timer proc */
 	apt_timer_proc_f     proc;
@@ -48,15 +78,24 @@ struct apt_timer_t {
 	void                *obj;
 };
 
-static apt_bool_t apt_timer_insert(apt_timer_queue_t *timer_queue, apt_timer_t *timer);
-static apt_bool_t apt_timer_remove(apt_timer_queue_t *timer_queue, apt_timer_t *timer);
-static void apt_timers_reschedule(apt_timer_queue_t *timer_queue);
+static void apt_timer_insert(apt_timer_queue_t *timer_queue, apt_timer_t *timer);
+static void apt_timer_remove(apt_timer_queue_t *timer_queue, apt_timer_t *timer);
+static apr_uint32_t apt_timer_queue_next_get(const apt_timer_queue_t *timer_queue);
+static void apt_timer_queue_tick(apt_timer_queue_t *timer_queue);
 
 /** Create timer queue */
 APT_DECLARE(apt_timer_queue_t*) apt_timer_queue_create(apr_pool_t *pool)
 {
+	apr_size_t level;
+	apr_size_t slot;
 	apt_timer_queue_t *timer_queue = apr_palloc(pool,sizeof(apt_timer_queue_t));
-	APR_RING_INIT(&timer_queue->head, apt_timer_t, link);
+	for(level=0; level<TIMER_WHEEL_LEVELS; level++) {
+		for(slot=0; slot<TIMER_WHEEL_SLOTS; slot++) {
+			APR_RING_INIT(&timer_queue->slots[level][slot], apt_timer_t, link);
+		}
+	}
+	memset(timer_queue->bitmap,0,sizeof(timer_queue->bitmap));
+	timer_queue->count = 0;
 	timer_queue->elapsed_time = 0;
 	return timer_queue;
 }
@@ -70,66 +109,43 @@ APT_DECLARE(void) apt_timer_queue_destroy(apt_timer_queue_t *timer_queue)
 /** Advance scheduled timers */
 APT_DECLARE(void) apt_timer_queue_advance(apt_timer_queue_t *timer_queue, apr_uint32_t elapsed_time)
 {
-	apt_timer_t *timer;
-
-	if(APR_RING_EMPTY(&timer_queue->head, apt_timer_t, link)) {
-		/* just return, nothing to do */
-		return;
-	}
-
-	/* increment elapsed time */
-	timer_queue->elapsed_time += elapsed_time;
-	if(timer_queue->elapsed_time >= 0xFFFF) {
-#ifdef APT_TIMER_DEBUG
-		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Reschedule Timers [%u]",timer_queue->elapsed_time);
-#endif
-		apt_timers_reschedule(timer_queue);
-	}
-
-	/* process timers */
-	do {
-		/* get first node (timer) */
-		timer = APR_RING_FIRST(&timer_queue->head);
-
-		if(timer->scheduled_time > timer_queue->elapsed_time) {
-			/* scheduled time is not elapsed yet */
-			break;
+	apr_uint32_t next;
+	while(elapsed_time) {
+		if(!timer_queue->count) {
+			/* just advance the time, nothing to do */
+			timer_queue->elapsed_time += elapsed_time;
+			return;
 		}
 
-#ifdef APT_TIMER_DEBUG
-		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Timer Elapsed 0x%x [%u]",timer,timer->scheduled_time);
-#endif
-		/* remove the elapsed timer from the list */
-		APR_RING_REMOVE(timer, link);
-		timer->scheduled_time = 0;
-		/* process the elapsed timer */
-		timer->proc(timer,timer->obj);
+		/* skip the ticks, which have neither timers to elapse nor timers to cascade */
+		next = apt_timer_queue_next_get(timer_queue);
+		if(next > elapsed_time) {
+			timer_queue->elapsed_time += elapsed_time;
+			return;
+		}
+		timer_queue->elapsed_time += next - 1;
+		elapsed_time -= next;
+		apt_timer_queue_tick(timer_queue);
 	}
-	while(!APR_RING_EMPTY(&timer_queue->head, apt_timer_t, link));
 }
 
 /** Is timer queue empty */
 APT_DECLARE(apt_bool_t) apt_timer_queue_is_empty(const apt_timer_queue_t *timer_queue)
 {
-	return APR_RING_EMPTY(&timer_queue->head, apt_timer_t, link) ? TRUE : FALSE;
+	return timer_queue->count ? FALSE : TRUE;
 }
 
 /** Get current timeout */
 APT_DECLARE(apt_bool_t) apt_timer_queue_timeout_get(const apt_timer_queue_t *timer_queue, apr_uint32_t *timeout)
 {
-	apt_timer_t *timer;
 	/* is queue empty */
-	if(APR_RING_EMPTY(&timer_queue->head, apt_timer_t, link)) {
+	if(!timer_queue->count) {
 		return FALSE;
 	}
 
-	/* get first node (timer) */
-	timer = APR_RING_FIRST(&timer_queue->head);
-	if(!timer) {
-		return FALSE;
-	}
-
-	*timeout = timer->scheduled_time - timer_queue->elapsed_time;
+	/* exact, if the nearest timer is in the lowest level, or the time of
+	the next cascade otherwise, the timeout is then requested again */
+	*timeout = apt_timer_queue_next_get(timer_queue);
 	return TRUE;
 }
 
@@ -140,6 +156,9 @@ APT_DECLARE(apt_timer_t*) apt_timer_create(apt_timer_queue_t *timer_queue, apt_t
 	APR_RING_ELEM_INIT(timer,link);
 	timer->queue = timer_queue;
 	timer->scheduled_time = 0;
+	timer->scheduled = FALSE;
+	timer->level = 0;
+	timer->slot = 0;
 	timer->proc = proc;
 	timer->obj = obj;
 	return timer;
@@ -154,7 +173,7 @@ APT_DECLARE(apt_bool_t) apt_timer_set(apt_timer_t *timer, apr_uint32_t timeout)
 		return FALSE;
 	}
 
-	if(timer->scheduled_time) {
+	if(timer->scheduled == TRUE) {
 		/* remove timer first */
 		apt_timer_remove(queue,timer);
 	}
@@ -164,65 +183,142 @@ APT_DECLARE(apt_bool_t) apt_timer_set(apt_timer_t *timer, apr_uint32_t timeout)
 #ifdef APT_TIMER_DEBUG
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Set Timer 0x%x [%u]",timer,timer->scheduled_time);
 #endif
-	if(APR_RING_EMPTY(&queue->head, apt_timer_t, link)) {
-		APR_RING_INSERT_TAIL(&queue->head,timer,apt_timer_t,link);
-		return TRUE;
-	}
-
-	/* insert new node (timer) to sorted by scheduled time list */
-	return apt_timer_insert(queue,timer);
+	apt_timer_insert(queue,timer);
+	return TRUE;
 }
 
 /** Kill timer */
 APT_DECLARE(apt_bool_t) apt_timer_kill(apt_timer_t *timer)
 {
-	if(!timer->scheduled_time) {
+	if(timer->scheduled == FALSE) {
 		return FALSE;
 	}
 
 #ifdef APT_TIMER_DEBUG
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Kill Timer 0x%x [%u]",timer,timer->scheduled_time);
 #endif
-	return apt_timer_remove(timer->queue,timer);
+	apt_timer_remove(timer->queue,timer);
+	return TRUE;
 }
 
-static apt_bool_t apt_timer_insert(apt_timer_queue_t *timer_queue, apt_timer_t *timer)
+static void apt_timer_insert(apt_timer_queue_t *timer_queue, apt_timer_t *timer)
 {
-	apt_timer_t *it;
-	for(it = APR_RING_LAST(&timer_queue->head);
-			it != APR_RING_SENTINEL(&timer_queue->head, apt_timer_t, link);
-				it = APR_RING_PREV(it, link)) {
-		
-		if(it->scheduled_time <= timer->scheduled_time) {
-			APR_RING_INSERT_AFTER(it,timer,link);
-			return TRUE;
-		}
+	apr_uint32_t delta = timer->scheduled_time - timer_queue->elapsed_time;
+	apr_size_t level = 0;
+	/* find the level covering the time to elapse */
+	while(level < TIMER_WHEEL_LEVELS - 1 && (delta >> (TIMER_WHEEL_BITS * (level + 1))) != 0) {
+		level++;
 	}
-	APR_RING_INSERT_HEAD(&timer_queue->head,timer,apt_timer_t,link);
-	return TRUE;
+
+	timer->level = level;
+	timer->slot = (timer->scheduled_time >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+	timer->scheduled = TRUE;
+	APR_RING_INSERT_TAIL(&timer_queue->slots[level][timer->slot],timer,apt_timer_t,link);
+	timer_queue->bitmap[level][timer->slot >> 5] |= (apr_uint32_t)1 << (timer->slot & 31);
+	timer_queue->count++;
 }
 
-static apt_bool_t apt_timer_remove(apt_timer_queue_t *timer_queue, apt_timer_t *timer)
+static void apt_timer_remove(apt_timer_queue_t *timer_queue, apt_timer_t *timer)
 {
-	/* remove node (timer) from the list */
+	/* remove node (timer) from the slot */
 	APR_RING_REMOVE(timer,link);
-	timer->scheduled_time = 0;
+	timer->scheduled = FALSE;
+	if(APR_RING_EMPTY(&timer_queue->slots[timer->level][timer->slot], apt_timer_t, link)) {
+		timer_queue->bitmap[timer->level][timer->slot >> 5] &= ~((apr_uint32_t)1 << (timer->slot & 31));
+	}
+	timer_queue->count--;
+}
+
+/** Find the distance [1..TIMER_WHEEL_SLOTS] from the current slot to the next occupied one (0 if none) */
+static apr_size_t apt_timer_slot_distance_get(const apr_uint32_t *bitmap, apr_size_t current)
+{
+	apr_size_t distance;
+	apr_size_t slot;
+	for(distance = 1; distance <= TIMER_WHEEL_SLOTS; ) {
+		slot = (current + distance) & TIMER_WHEEL_MASK;
+		if(!(slot & 31) && !bitmap[slot >> 5] && distance + 32 <= TIMER_WHEEL_SLOTS + 1) {
+			/* skip the empty word at once */
+			distance += 32;
+			continue;
+		}
+		if(bitmap[slot >> 5] & ((apr_uint32_t)1 << (slot & 31))) {
+			return distance;
+		}
+		distance++;
+	}
+	return 0;
+}
 
-	if(APR_RING_EMPTY(&timer_queue->head, apt_timer_t, link)) {
-		/* reset elapsed time if no timers set */
-		timer_queue->elapsed_time = 0;
+/** Get the number of ticks to the next one, which elapses or cascades timers */
+static apr_uint32_t apt_timer_queue_next_get(const apt_timer_queue_t *timer_queue)
+{
+	apr_uint64_t next = 0xFFFFFFFF;
+	apr_uint64_t ticks;
+	apr_size_t level;
+	apr_size_t distance;
+	apr_uint32_t now = timer_queue->elapsed_time;
+	for(level=0; level<TIMER_WHEEL_LEVELS; level++) {
+		apr_size_t shift = TIMER_WHEEL_BITS * level;
+		distance = apt_timer_slot_distance_get(timer_queue->bitmap[level],(now >> shift) & TIMER_WHEEL_MASK);
+		if(!distance) {
+			continue;
+		}
+		/* the slot is processed, as the time reaches its beginning */
+		ticks = ((apr_uint64_t)distance << shift) - (now & (((apr_uint64_t)1 << shift) - 1));
+		if(ticks < next) {
+			next = ticks;
+		}
+		if(level == 0) {
+			/* timers of upper levels don't elapse earlier than the next cascade */
+			if(next <= (apr_uint64_t)TIMER_WHEEL_SLOTS - (now & TIMER_WHEEL_MASK)) {
+				break;
+			}
+		}
 	}
-	return TRUE;
+	return (apr_uint32_t)next;
 }
 
-static void apt_timers_reschedule(apt_timer_queue_t *timer_queue)
+/** Move the timers of the slot to the lower levels */
+static void apt_timer_slot_cascade(apt_timer_queue_t *timer_queue, apr_size_t level, apr_size_t slot)
 {
-	apt_timer_t *it;
-	for(it = APR_RING_LAST(&timer_queue->head);
-			it != APR_RING_SENTINEL(&timer_queue->head, apt_timer_t, link);
-				it = APR_RING_PREV(it, link)) {
+	apt_timer_t *timer;
+	struct apt_timer_head_t *head = &timer_queue->slots[level][slot];
+	while(!APR_RING_EMPTY(head, apt_timer_t, link)) {
+		timer = APR_RING_FIRST(head);
+		apt_timer_remove(timer_queue,timer);
+		apt_timer_insert(timer_queue,timer);
+	}
+}
 
-		it->scheduled_time -= timer_queue->elapsed_time;
+/** Advance the time by one tick and process the elapsed timers */
+static void apt_timer_queue_tick(apt_timer_queue_t *timer_queue)
+{
+	apt_timer_t *timer;
+	struct apt_timer_head_t *head;
+	apr_size_t level;
+	apr_size_t slot;
+	apr_uint32_t now = ++timer_queue->elapsed_time;
+
+	/* cascade the upper level slots, the beginning of which is reached */
+	for(level=1; level<TIMER_WHEEL_LEVELS; level++) {
+		if(now & (((apr_uint32_t)1 << (TIMER_WHEEL_BITS * level)) - 1)) {
+			break;
+		}
+		slot = (now >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+		apt_timer_slot_cascade(timer_queue,level,slot);
+	}
+
+	/* process the elapsed timers */
+	head = &timer_queue->slots[0][now & TIMER_WHEEL_MASK];
+	while(!APR_RING_EMPTY(head, apt_timer_t, link)) {
+		/* get first node (timer) */
+		timer = APR_RING_FIRST(head);
+#ifdef APT_TIMER_DEBUG
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Timer Elapsed 0x%x [%u]",timer,timer->scheduled_time);
+#endif
+		/* remove the elapsed timer from the slot */
+		apt_timer_remove(timer_queue,timer);
+		/* process the elapsed timer */
+		timer->proc(timer,timer->obj);
 	}
-	timer_queue->elapsed_time = 0;
 }
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include <apr_thread_mutex.h>
+#include "apt_token_bucket.h"
+#include "apt_clock.h"
+
+/** 
+ * The level is kept in millionths of a token, so that the bucket is refilled
+ * by rate tokens per second exactly by the integer usec elapsed.
+ */
+struct apt_token_bucket_t {
+	apr_thread_mutex_t *guard;
+	apr_uint64_t        rate;
+	apr_uint64_t        capacity;
+	apr_uint64_t        level;
+	apr_time_t          refill_time;
+};
+
+APT_DECLARE(apt_token_bucket_t*) apt_token_bucket_create(apr_size_t rate, apr_size_t burst, apr_pool_t *pool)
+{
+	apt_token_bucket_t *bucket;
+	if(!rate) {
+		return NULL;
+	}
+	bucket = apr_palloc(pool,sizeof(apt_token_bucket_t));
+	if(apr_thread_mutex_create(&bucket->guard,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	bucket->rate = rate;
+	bucket->capacity = (apr_uint64_t)(burst ? burst : rate) * APR_USEC_PER_SEC;
+	bucket->level = bucket->capacity;
+	bucket->refill_time = apt_clock_now();
+	return bucket;
+}
+
+/** Refill the bucket by the time elapsed since the last refill */
+static void apt_token_bucket_refill(apt_token_bucket_t *bucket)
+{
+	apr_time_t now = apt_clock_now();
+	if(now > bucket->refill_time) {
+		apr_uint64_t elapsed = (apr_uint64_t)(now - bucket->refill_time);
+		if(elapsed >= bucket->capacity / bucket->rate) {
+			bucket->level = bucket->capacity;
+		}
+		else {
+			bucket->level += elapsed * bucket->rate;
+			if(bucket->level > bucket->capacity) {
+				bucket->level = bucket->capacity;
+			}
+		}
+	}
+	bucket->refill_time = now;
+}
+
+APT_DECLARE(apt_bool_t) apt_token_bucket_take(apt_token_bucket_t *bucket)
+{
+	apt_bool_t status = FALSE;
+	apr_thread_mutex_lock(bucket->guard);
+	apt_token_bucket_refill(bucket);
+	if(bucket->level >= APR_USEC_PER_SEC) {
+		bucket->level -= APR_USEC_PER_SEC;
+		status = TRUE;
+	}
+	apr_thread_mutex_unlock(bucket->guard);
+	return status;
+}
+
+APT_DECLARE(apr_size_t) apt_token_bucket_level_get(apt_token_bucket_t *bucket)
+{
+	apr_size_t level;
+	apr_thread_mutex_lock(bucket->guard);
+	apt_token_bucket_refill(bucket);
+	level = (apr_size_t)(bucket->level / APR_USEC_PER_SEC);
+	apr_thread_mutex_unlock(bucket->guard);
+	return level;
+}
+
+APT_DECLARE(void) apt_token_bucket_destroy(apt_token_bucket_t *bucket)
+{
+	apr_thread_mutex_destroy(bucket->guard);
+}
@@ -0,0 +1,354 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <string.h>
+#include "g722.h"
+
+/* The block numbers in the comments refer to the ITU-T G.722 recommendation */
+
+/* QMF coefficients (h0..h11 of the 24 tap filter, which is symmetric) */
+static const int qmf_coeffs[12] = {
+	3, -11, 12, 32, -210, 951, 3876, -805, 362, -156, 53, -11
+};
+
+/* lower sub-band quantizer decision levels */
+static const int q6[32] = {
+	   0,   35,   72,  110,  150,  190,  233,  276,
+	 323,  370,  422,  473,  530,  587,  650,  714,
+	 786,  858,  940, 1023, 1121, 1219, 1339, 1458,
+	1612, 1765, 1980, 2195, 2557, 2919,    0,    0
+};
+
+/* lower sub-band codewords of negative and positive intervals */
+static const int iln[32] = {
+	 0, 63, 62, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19,
+	18, 17, 16, 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  0
+};
+static const int ilp[32] = {
+	 0, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49, 48, 47,
+	46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 32,  0
+};
+
+/* lower sub-band 6 bit inverse quantizer outputs */
+static const int qm6[64] = {
+	  -136,   -136,   -136,   -136, -24808, -21904, -19008, -16704,
+	-14984, -13512, -12280, -11192, -10232,  -9360,  -8576,  -7856,
+	 -7192,  -6576,  -6000,  -5456,  -4944,  -4464,  -4008,  -3576,
+	 -3168,  -2776,  -2400,  -2032,  -1688,  -1360,  -1040,   -728,
+	 24808,  21904,  19008,  16704,  14984,  13512,  12280,  11192,
+	 10232,   9360,   8576,   7856,   7192,   6576,   6000,   5456,
+	  4944,   4464,   4008,   3576,   3168,   2776,   2400,   2032,
+	  1688,   1360,   1040,    728,    432,    136,   -432,   -136
+};
+
+/* lower sub-band 4 bit inverse quantizer outputs (feedback path) */
+static const int qm4[16] = {
+	     0, -20456, -12896, -8968, -6288, -4240, -2584, -1200,
+	 20456,  12896,   8968,  6288,  4240,  2584,  1200,     0
+};
+
+/* lower sub-band logarithmic scale factor adaptation */
+static const int rl42[16] = {
+	0, 7, 6, 5, 4, 3, 2, 1, 7, 6, 5, 4, 3, 2, 1, 0
+};
+static const int wl[8] = {
+	-60, -30, 58, 172, 334, 538, 1198, 3042
+};
+
+/* inverse logarithmic scale factor table */
+static const int ilb[32] = {
+	2048, 2093, 2139, 2186, 2233, 2282, 2332, 2383,
+	2435, 2489, 2543, 2599, 2656, 2714, 2774, 2834,
+	2896, 2960, 3025, 3091, 3158, 3228, 3298, 3371,
+	3444, 3520, 3597, 3676, 3756, 3838, 3922, 4008
+};
+
+/* higher sub-band quantizer and inverse quantizer */
+static const int ihn[3] = {0, 1, 0};
+static const int ihp[3] = {0, 3, 2};
+static const int qm2[4] = {-7408, -1616, 7408, 1616};
+static const int rh2[4] = {2, 1, 2, 1};
+static const int wh[3] = {0, -214, 798};
+
+
+static APR_INLINE int saturate(int amp)
+{
+	if(amp > 32767) {
+		return 32767;
+	}
+	if(amp < -32768) {
+		return -32768;
+	}
+	return amp;
+}
+
+/* Block 3L/3H, SCALEL/SCALEH */
+static APR_INLINE int g722_scale(int nb, int shift)
+{
+	int wd1 = (nb >> 6) & 31;
+	int wd2 = shift - (nb >> 11);
+	int wd3 = (wd2 < 0) ? (ilb[wd1] << -wd2) : (ilb[wd1] >> wd2);
+	return wd3 << 2;
+}
+
+/* Block 3L, LOGSCL and SCALEL */
+static APR_INLINE void g722_low_scale_update(g722_band_t *band, int ril)
+{
+	int nb = ((band->nb * 127) >> 7) + wl[rl42[ril]];
+	if(nb < 0) {
+		nb = 0;
+	}
+	else if(nb > 18432) {
+		nb = 18432;
+	}
+	band->nb = nb;
+	band->det = g722_scale(nb,8);
+}
+
+/* Block 3H, LOGSCH and SCALEH */
+static APR_INLINE void g722_high_scale_update(g722_band_t *band, int ihigh)
+{
+	int nb = ((band->nb * 127) >> 7) + wh[rh2[ihigh]];
+	if(nb < 0) {
+		nb = 0;
+	}
+	else if(nb > 22528) {
+		nb = 22528;
+	}
+	band->nb = nb;
+	band->det = g722_scale(nb,10);
+}
+
+/* Block 4, adaptive predictor update by quantized difference signal d */
+static void g722_predictor_update(g722_band_t *band, int d)
+{
+	int wd1;
+	int wd2;
+	int wd3;
+	int i;
+
+	/* RECONS */
+	band->d[0] = d;
+	band->r[0] = saturate(band->s + d);
+
+	/* PARREC */
+	band->p[0] = saturate(band->sz + d);
+
+	/* UPPOL2 */
+	for(i=0; i<3; i++) {
+		band->sg[i] = band->p[i] >> 15;
+	}
+	wd1 = saturate(band->a[1] << 2);
+	wd2 = (band->sg[0] == band->sg[1]) ? -wd1 : wd1;
+	if(wd2 > 32767) {
+		wd2 = 32767;
+	}
+	wd3 = (wd2 >> 7) + ((band->sg[0] == band->sg[2]) ? 128 : -128);
+	wd3 += (band->a[2] * 32512) >> 15;
+	if(wd3 > 12288) {
+		wd3 = 12288;
+	}
+	else if(wd3 < -12288) {
+		wd3 = -12288;
+	}
+	band->ap[2] = wd3;
+
+	/* UPPOL1 */
+	band->sg[0] = band->p[0] >> 15;
+	band->sg[1] = band->p[1] >> 15;
+	wd1 = (band->sg[0] == band->sg[1]) ? 192 : -192;
+	wd2 = (band->a[1] * 32640) >> 15;
+	band->ap[1] = saturate(wd1 + wd2);
+	wd3 = saturate(15360 - band->ap[2]);
+	if(band->ap[1] > wd3) {
+		band->ap[1] = wd3;
+	}
+	else if(band->ap[1] < -wd3) {
+		band->ap[1] = -wd3;
+	}
+
+	/* UPZERO */
+	wd1 = (d == 0) ? 0 : 128;
+	band->sg[0] = d >> 15;
+	for(i=1; i<7; i++) {
+		band->sg[i] = band->d[i] >> 15;
+		wd2 = (band->sg[i] == band->sg[0]) ? wd1 : -wd1;
+		wd3 = (band->b[i] * 32640) >> 15;
+		band->bp[i] = saturate(wd2 + wd3);
+	}
+
+	/* DELAYA */
+	for(i=6; i>0; i--) {
+		band->d[i] = band->d[i-1];
+		band->b[i] = band->bp[i];
+	}
+	for(i=2; i>0; i--) {
+		band->r[i] = band->r[i-1];
+		band->p[i] = band->p[i-1];
+		band->a[i] = band->ap[i];
+	}
+
+	/* FILTEP */
+	wd1 = saturate(band->r[1] + band->r[1]);
+	wd1 = (band->a[1] * wd1) >> 15;
+	wd2 = saturate(band->r[2] + band->r[2]);
+	wd2 = (band->a[2] * wd2) >> 15;
+	band->sp = saturate(wd1 + wd2);
+
+	/* FILTEZ */
+	band->sz = 0;
+	for(i=6; i>0; i--) {
+		wd1 = saturate(band->d[i] + band->d[i]);
+		band->sz += (band->b[i] * wd1) >> 15;
+	}
+	band->sz = saturate(band->sz);
+
+	/* PREDIC */
+	band->s = saturate(band->sp + band->sz);
+}
+
+void g722_state_init(g722_state_t *state)
+{
+	memset(state,0,sizeof(g722_state_t));
+	state->band[0].det = 32;
+	state->band[1].det = 8;
+}
+
+apr_size_t g722_encode(g722_state_t *state, const apr_int16_t *linear, apr_size_t count, apr_byte_t *code)
+{
+	g722_band_t *low = &state->band[0];
+	g722_band_t *high = &state->band[1];
+	apr_size_t n;
+	int sumeven;
+	int sumodd;
+	int xlow;
+	int xhigh;
+	int el;
+	int eh;
+	int wd;
+	int ilow;
+	int ihigh;
+	int i;
+
+	for(n=0; n+1 < count; n+=2) {
+		/* transmit QMF */
+		memmove(state->x,state->x + 2,22 * sizeof(int));
+		state->x[22] = linear[n];
+		state->x[23] = linear[n+1];
+		sumeven = 0;
+		sumodd = 0;
+		for(i=0; i<12; i++) {
+			sumodd += state->x[2*i] * qmf_coeffs[i];
+			sumeven += state->x[2*i+1] * qmf_coeffs[11-i];
+		}
+		xlow = (sumeven + sumodd) >> 14;
+		xhigh = (sumeven - sumodd) >> 14;
+
+		/* Block 1L, SUBTRA and QUANTL */
+		el = saturate(xlow - low->s);
+		wd = (el >= 0) ? el : -(el + 1);
+		for(i=1; i<30; i++) {
+			if(wd < ((q6[i] * low->det) >> 12)) {
+				break;
+			}
+		}
+		ilow = (el < 0) ? iln[i] : ilp[i];
+
+		/* Block 2L, INVQAL, then Block 3L and Block 4L */
+		wd = (low->det * qm4[ilow >> 2]) >> 15;
+		g722_low_scale_update(low,ilow >> 2);
+		g722_predictor_update(low,wd);
+
+		/* Block 1H, SUBTRA and QUANTH */
+		eh = saturate(xhigh - high->s);
+		wd = (eh >= 0) ? eh : -(eh + 1);
+		i = (wd >= ((564 * high->det) >> 12)) ? 2 : 1;
+		ihigh = (eh < 0) ? ihn[i] : ihp[i];
+
+		/* Block 2H, INVQAH, then Block 3H and Block 4H */
+		wd = (high->det * qm2[ihigh]) >> 15;
+		g722_high_scale_update(high,ihigh);
+		g722_predictor_update(high,wd);
+
+		*code++ = (apr_byte_t)((ihigh << 6) | ilow);
+	}
+	return n / 2;
+}
+
+apr_size_t g722_decode(g722_state_t *state, const apr_byte_t *code, apr_size_t count, apr_int16_t *linear)
+{
+	g722_band_t *low = &state->band[0];
+	g722_band_t *high = &state->band[1];
+	apr_size_t n;
+	int ilow;
+	int ihigh;
+	int rlow;
+	int rhigh;
+	int dlow;
+	int dhigh;
+	int xout1;
+	int xout2;
+	int i;
+
+	for(n=0; n<count; n++) {
+		ilow = code[n] & 0x3F;
+		ihigh = (code[n] >> 6) & 0x03;
+
+		/* Block 5L, INVQBL, RECONS and LIMIT */
+		rlow = low->s + ((low->det * qm6[ilow]) >> 15);
+		if(rlow > 16383) {
+			rlow = 16383;
+		}
+		else if(rlow < -16384) {
+			rlow = -16384;
+		}
+
+		/* Block 2L, INVQAL, then Block 3L and Block 4L */
+		dlow = (low->det * qm4[ilow >> 2]) >> 15;
+		g722_low_scale_update(low,ilow >> 2);
+		g722_predictor_update(low,dlow);
+
+		/* Block 2H, INVQAH, Block 5H, RECONS and LIMIT */
+		dhigh = (high->det * qm2[ihigh]) >> 15;
+		rhigh = dhigh + high->s;
+		if(rhigh > 16383) {
+			rhigh = 16383;
+		}
+		else if(rhigh < -16384) {
+			rhigh = -16384;
+		}
+
+		/* Block 3H and Block 4H */
+		g722_high_scale_update(high,ihigh);
+		g722_predictor_update(high,dhigh);
+
+		/* receive QMF */
+		memmove(state->x,state->x + 2,22 * sizeof(int));
+		state->x[22] = rlow + rhigh;
+		state->x[23] = rlow - rhigh;
+		xout1 = 0;
+		xout2 = 0;
+		for(i=0; i<12; i++) {
+			xout2 += state->x[2*i] * qmf_coeffs[i];
+			xout1 += state->x[2*i+1] * qmf_coeffs[11-i];
+		}
+		*linear++ = (apr_int16_t)saturate(xout1 >> 11);
+		*linear++ = (apr_int16_t)saturate(xout2 >> 11);
+	}
+	return count * 2;
+}
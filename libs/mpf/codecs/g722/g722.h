@@ -0,0 +1,86 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MPF_G722_H
+#define MPF_G722_H
+
+/**
+ * @file g722.h
+ * @brief ITU-T G.722 Sub-Band ADPCM (64 kbit/s mode)
+ */ 
+
+#include "mpf.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Adaptive predictor and quantizer state of a sub-band */
+typedef struct g722_band_t g722_band_t;
+/** G.722 encoder/decoder state */
+typedef struct g722_state_t g722_state_t;
+
+/** Sub-band state (block 3 and block 4 variables of the recommendation) */
+struct g722_band_t {
+	int s;
+	int sp;
+	int sz;
+	int r[3];
+	int a[3];
+	int ap[3];
+	int p[3];
+	int d[7];
+	int b[7];
+	int bp[7];
+	int sg[7];
+	int nb;
+	int det;
+};
+
+/** Encoder or decoder state */
+struct g722_state_t {
+	/** QMF delay line */
+	int         x[24];
+	/** Lower and higher sub-bands */
+	g722_band_t band[2];
+};
+
+/** Reset encoder or decoder state */
+void g722_state_init(g722_state_t *state);
+
+/**
+ * Encode 16 kHz linear samples into 64 kbit/s G.722 codewords.
+ * @param state the encoder state
+ * @param linear the samples to encode
+ * @param count the number of samples (even)
+ * @param code the output, one codeword per pair of samples
+ * @return the number of codewords
+ */
+apr_size_t g722_encode(g722_state_t *state, const apr_int16_t *linear, apr_size_t count, apr_byte_t *code);
+
+/**
+ * Decode 64 kbit/s G.722 codewords into 16 kHz linear samples.
+ * @param state the decoder state
+ * @param code the codewords to decode
+ * @param count the number of codewords
+ * @param linear the output, two samples per codeword
+ * @return the number of samples
+ */
+apr_size_t g722_decode(g722_state_t *state, const apr_byte_t *code, apr_size_t count, apr_int16_t *linear);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_G722_H */
@@ -25,12 +25,17 @@
  */ 
 
 #include "mpf_frame.h"
+#include "mpf_frame_features.h"
 #include "mpf_codec_descriptor.h"
 
 APT_BEGIN_EXTERN_C
 
 /** Opaque (voice) activity detector */
 typedef struct mpf_activity_detector_t mpf_activity_detector_t;
+/** Declaration of activity classifier */
+typedef struct mpf_activity_classifier_t mpf_activity_classifier_t;
+/** Declaration of activity classifier virtual table */
+typedef struct mpf_activity_classifier_vtable_t mpf_activity_classifier_vtable_t;
 
 /** Events of activity detector */
 typedef enum {
@@ -40,6 +45,24 @@ typedef enum {
 	MPF_DETECTOR_EVENT_NOINPUT     /**< noinput event occurred */
 } mpf_detector_event_e;
 
+/** Table of activity classifier virtual methods */
+struct mpf_activity_classifier_vtable_t {
+	/** Virtual reset method (restart adaptation) */
+	void       (*reset)(mpf_activity_classifier_t *classifier);
+	/** Virtual classify method (TRUE if the frame carries voice) */
+	apt_bool_t (*classify)(mpf_activity_classifier_t *classifier, const mpf_frame_t *frame);
+	/** Virtual classify method by features of the frame calculated in advance (optional) */
+	apt_bool_t (*classify_features)(mpf_activity_classifier_t *classifier, const mpf_frame_features_t *features);
+};
+
+/** Activity classifier (pluggable backend which tells voice frames from silence and noise) */
+struct mpf_activity_classifier_t {
+	/** External object */
+	void                                   *obj;
+	/** Table of virtual methods */
+	const mpf_activity_classifier_vtable_t *vtable;
+};
+
 
 /** Create activity detector */
 MPF_DECLARE(mpf_activity_detector_t*) mpf_activity_detector_create(apr_pool_t *pool);
@@ -59,9 +82,44 @@ MPF_DECLARE(void) mpf_activity_detector_speech_timeout_set(mpf_activity_detector
 /** Set timeout required to trigger silence (transition from active to inactive state) */
 MPF_DECLARE(void) mpf_activity_detector_silence_timeout_set(mpf_activity_detector_t *detector, apr_size_t silence_timeout);
 
+/** Get timeout required to trigger silence (transition from active to inactive state) */
+MPF_DECLARE(apr_size_t) mpf_activity_detector_silence_timeout_get(const mpf_activity_detector_t *detector);
+
+/**
+ * Set activity classifier.
+ * @param detector the detector to set classifier for
+ * @param classifier the classifier to use, NULL restores the default level threshold based one
+ */
+MPF_DECLARE(void) mpf_activity_detector_classifier_set(mpf_activity_detector_t *detector, mpf_activity_classifier_t *classifier);
+
+/**
+ * Create built-in energy classifier.
+ * @param pool the pool to allocate memory from
+ * @remark Frame energy is compared against an adaptive noise floor,
+ *         zero-crossing rate keeps broadband noise bursts out of speech.
+ */
+MPF_DECLARE(mpf_activity_classifier_t*) mpf_energy_classifier_create(apr_pool_t *pool);
+
+/**
+ * Create built-in activity classifier by name.
+ * @param name the name of the classifier ("level" or "energy")
+ * @param pool the pool to allocate memory from
+ * @return NULL for the default level threshold based classifier or unknown name
+ */
+MPF_DECLARE(mpf_activity_classifier_t*) mpf_activity_classifier_create(const char *name, apr_pool_t *pool);
+
 /** Process current frame, return detected event if any */
 MPF_DECLARE(mpf_detector_event_e) mpf_activity_detector_process(mpf_activity_detector_t *detector, const mpf_frame_t *frame);
 
+/**
+ * Process current frame, the features of which are already calculated.
+ * @param detector the detector to process the frame by
+ * @param frame the frame to process
+ * @param features the features of the frame shared with other detectors (NULL to calculate on demand)
+ * @return detected event if any
+ */
+MPF_DECLARE(mpf_detector_event_e) mpf_activity_detector_features_process(mpf_activity_detector_t *detector, const mpf_frame_t *frame, const mpf_frame_features_t *features);
+
 
 APT_END_EXTERN_C
 
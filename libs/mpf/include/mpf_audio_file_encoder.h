@@ -0,0 +1,91 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MPF_AUDIO_FILE_ENCODER_H
+#define MPF_AUDIO_FILE_ENCODER_H
+
+/**
+ * @file mpf_audio_file_encoder.h
+ * @brief MPF Audio File Formats and Encoders
+ */
+
+#include "mpf.h"
+#include "apt_string.h"
+#include "apt_file_writer.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Audio file formats */
+typedef enum {
+	MPF_AUDIO_FILE_FORMAT_PCM,  /**< raw linear PCM (16-bit, host byte order) */
+	MPF_AUDIO_FILE_FORMAT_WAV,  /**< linear PCM in RIFF/WAVE */
+	MPF_AUDIO_FILE_FORMAT_ULAW, /**< G.711 u-law in RIFF/WAVE */
+	MPF_AUDIO_FILE_FORMAT_OPUS, /**< Opus in Ogg (available with libopus only) */
+
+	MPF_AUDIO_FILE_FORMAT_COUNT,
+	MPF_AUDIO_FILE_FORMAT_UNKNOWN = MPF_AUDIO_FILE_FORMAT_COUNT
+} mpf_audio_file_format_e;
+
+/**
+ * Find audio file format by name ("pcm", "wav", "ulaw", "opus").
+ * @param name the name of the format
+ * @return MPF_AUDIO_FILE_FORMAT_UNKNOWN if not found
+ */
+MPF_DECLARE(mpf_audio_file_format_e) mpf_audio_file_format_find(const char *name);
+
+/**
+ * Find audio file format by media type (e.g. "audio/x-wav", "audio/basic", "audio/ogg").
+ * @param media_type the media type to find the format by
+ * @return MPF_AUDIO_FILE_FORMAT_UNKNOWN if not found
+ */
+MPF_DECLARE(mpf_audio_file_format_e) mpf_audio_file_format_by_media_type(const apt_str_t *media_type);
+
+/**
+ * Get the file name extension of audio file format.
+ * @param format the format to get the extension of
+ */
+MPF_DECLARE(const char*) mpf_audio_file_format_ext_get(mpf_audio_file_format_e format);
+
+/**
+ * Check whether audio file format is supported (compiled in).
+ * @param format the format to check
+ */
+MPF_DECLARE(apt_bool_t) mpf_audio_file_format_is_supported(mpf_audio_file_format_e format);
+
+/**
+ * Create encoder of linear PCM (16-bit, mono) to audio file format.
+ * @param format the format to encode to
+ * @param sampling_rate the sampling rate of the audio
+ * @return NULL for MPF_AUDIO_FILE_FORMAT_PCM (written as is) or unsupported formats
+ * @remark The encoder is passed to apt_file_writer_open(), so encoding runs
+ *         in the context of the writer rather than of media processing.
+ *         It has its own pool and is destroyed, once the file is closed.
+ */
+MPF_DECLARE(apt_file_encoder_t*) mpf_audio_file_encoder_create(mpf_audio_file_format_e format, apr_uint16_t sampling_rate);
+
+/**
+ * Create writer of G.711 u-law, received encoded, to RIFF/WAVE (MPF_AUDIO_FILE_FORMAT_ULAW).
+ * @param sampling_rate the sampling rate of the audio
+ * @remark The payloads are written as is, only the header is composed,
+ *         so that a stream bridged with no decoder is recorded with no DSP.
+ */
+MPF_DECLARE(apt_file_encoder_t*) mpf_audio_file_ulaw_passthrough_create(apr_uint16_t sampling_rate);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_AUDIO_FILE_ENCODER_H */
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MPF_AUDIO_FILE_SOURCE_H
+#define MPF_AUDIO_FILE_SOURCE_H
+
+/**
+ * @file mpf_audio_file_source.h
+ * @brief MPF Memory-Mapped Audio File and Buffer Source
+ */
+
+#include "mpf.h"
+#include "mpf_frame.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Opaque audio file source declaration */
+typedef struct mpf_audio_file_source_t mpf_audio_file_source_t;
+
+/**
+ * Open audio file source.
+ * @param file_path the path of the file to read audio from
+ * @remark The file is mapped into memory (or read ahead entirely, if mapping
+ *         is not available), so that frames are got with no disk I/O from
+ *         the context of media processing. Call it outside of media processing.
+ */
+MPF_DECLARE(mpf_audio_file_source_t*) mpf_audio_file_source_open(const char *file_path);
+
+/**
+ * Create audio source of contiguous buffer supplied by the application.
+ * @param data the audio data (linear PCM or the payload of the codec in use)
+ * @param size the size of the data
+ * @remark The data is neither copied nor owned by the source,
+ *         it must stay unchanged until the source is closed.
+ */
+MPF_DECLARE(mpf_audio_file_source_t*) mpf_audio_file_source_create(const void *data, apr_size_t size);
+
+/**
+ * Close audio file source.
+ * @param source the source to close
+ */
+MPF_DECLARE(void) mpf_audio_file_source_close(mpf_audio_file_source_t *source);
+
+/**
+ * Get the next frame.
+ * @param source the source to get the frame from
+ * @param size the size of the frame
+ * @return the pointer to the frame in the mapping or NULL at the end of file
+ */
+MPF_DECLARE(const char*) mpf_audio_file_source_frame_get(mpf_audio_file_source_t *source, apr_size_t size);
+
+/**
+ * Read the next frame.
+ * @param source the source to read the frame from
+ * @param buffer the buffer to copy the frame to
+ * @param size the size of the frame
+ * @return FALSE at the end of file
+ */
+MPF_DECLARE(apt_bool_t) mpf_audio_file_source_frame_read(mpf_audio_file_source_t *source, void *buffer, apr_size_t size);
+
+/**
+ * Lend the next frame, pointing the buffer of the frame to the source.
+ * @param source the source to lend the frame of
+ * @param frame the frame to point to the source
+ * @return FALSE at the end of file, the frame is left untouched then
+ * @remark No audio is copied. The lent buffer is read only, this holds for
+ *         audio frames read from a stream, which are never written to in place.
+ *         The caller must give the frame its own buffer back on every read,
+ *         before the frame is either lent again or filled otherwise
+ *         (e.g. with silence), and before the source is closed.
+ */
+MPF_DECLARE(apt_bool_t) mpf_audio_file_source_frame_lend(mpf_audio_file_source_t *source, mpf_frame_t *frame);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_AUDIO_FILE_SOURCE_H */
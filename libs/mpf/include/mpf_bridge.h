@@ -25,6 +25,7 @@
  */ 
 
 #include "mpf_object.h"
+#include "mpf_frame_pool.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -34,6 +35,7 @@ APT_BEGIN_EXTERN_C
  * @param sink the sink audio stream
  * @param codec_manager the codec manager
  * @param name the informative name used for debugging
+ * @param frame_pool the pool to borrow frame buffers from (may be NULL)
  * @param pool the pool to allocate memory from
  */
 MPF_DECLARE(mpf_object_t*) mpf_bridge_create(
@@ -41,6 +43,7 @@ MPF_DECLARE(mpf_object_t*) mpf_bridge_create(
 								mpf_audio_stream_t *sink, 
 								const mpf_codec_manager_t *codec_manager,
 								const char *name,
+								mpf_frame_pool_t *frame_pool,
 								apr_pool_t *pool);
 
 
@@ -31,10 +31,28 @@ APT_BEGIN_EXTERN_C
 /** Opaque media buffer declaration */
 typedef struct mpf_buffer_t mpf_buffer_t;
 
+/**
+ * Prototype of handler to request more audio from the producer by.
+ * @remark Called from the context of the reader (media processing) with no lock held,
+ *         so the handler must not block (e.g. signal the thread of the engine).
+ */
+typedef void (*mpf_buffer_watermark_f)(mpf_buffer_t *buffer, void *obj);
+
 
 /** Create buffer */
 mpf_buffer_t* mpf_buffer_create(apr_pool_t *pool);
 
+/**
+ * Create bounded buffer.
+ * @param capacity the max size of buffered audio in bytes (rounded up to a power of two)
+ * @param pool the pool to allocate memory from
+ * @remark Audio is kept in a ring of fixed capacity, so memory is constant however long
+ *         the stream is. Single producer (writer) and single consumer (reader) access it
+ *         with no lock. A write which doesn't fit in the free space fails as a whole,
+ *         the producer should write again, once requested by the watermark handler.
+ */
+mpf_buffer_t* mpf_buffer_bounded_create(apr_size_t capacity, apr_pool_t *pool);
+
 /** Destroy buffer */
 void mpf_buffer_destroy(mpf_buffer_t *buffer);
 
@@ -53,6 +71,22 @@ apt_bool_t mpf_buffer_frame_read(mpf_buffer_t *buffer, mpf_frame_t *media_frame)
 /** Get size of buffer **/
 apr_size_t mpf_buffer_get_size(const mpf_buffer_t *buffer);
 
+/** Get free space of bounded buffer (unlimited buffer returns (apr_size_t)-1) **/
+apr_size_t mpf_buffer_space_get(const mpf_buffer_t *buffer);
+
+/**
+ * Set low watermark of buffer.
+ * @param buffer the buffer to set the watermark of
+ * @param size the size of buffered audio in bytes to keep ahead of the playout point
+ *             (e.g. 200 msec of the codec in use)
+ * @param handler the handler to call, once the buffered audio drops below the watermark
+ * @param obj the external object to pass to the handler
+ * @remark The handler is called once per write, so the producer (engine) can write audio
+ *         chunk by chunk, as soon as each one is synthesized, and stay exactly the given
+ *         size ahead instead of rendering the whole text before the audio starts.
+ */
+apt_bool_t mpf_buffer_watermark_set(mpf_buffer_t *buffer, apr_size_t size, mpf_buffer_watermark_f handler, void *obj);
+
 APT_END_EXTERN_C
 
 #endif /* MPF_BUFFER_H */
@@ -41,6 +41,10 @@ struct mpf_codec_t {
 	const mpf_codec_attribs_t    *attribs;
 	/** Optional static codec descriptor (pt < 96) */
 	const mpf_codec_descriptor_t *static_descriptor;
+	/** Codec dependent state, set by stateful codecs on open */
+	void                         *obj;
+	/** Pool to allocate codec dependent state from */
+	apr_pool_t                   *pool;
 };
 
 /** Table of codec virtual methods */
@@ -60,6 +64,9 @@ struct mpf_codec_vtable_t {
 
 	/** Virtual initialize method */
 	apt_bool_t (*initialize)(mpf_codec_t *codec, mpf_codec_frame_t *frame_out);
+
+	/** Virtual conceal method (native packet loss concealment, optional) */
+	apt_bool_t (*conceal)(mpf_codec_t *codec, mpf_codec_frame_t *frame_out);
 };
 
 /**
@@ -79,6 +86,8 @@ static APR_INLINE mpf_codec_t* mpf_codec_create(
 	codec->vtable = vtable;
 	codec->attribs = attribs;
 	codec->static_descriptor = descriptor;
+	codec->obj = NULL;
+	codec->pool = pool;
 	return codec;
 }
 
@@ -93,6 +102,8 @@ static APR_INLINE mpf_codec_t* mpf_codec_clone(mpf_codec_t *src_codec, apr_pool_
 	codec->vtable = src_codec->vtable;
 	codec->attribs = src_codec->attribs;
 	codec->static_descriptor = src_codec->static_descriptor;
+	codec->obj = NULL;
+	codec->pool = pool;
 	return codec;
 }
 
@@ -141,7 +152,7 @@ static APR_INLINE apt_bool_t mpf_codec_dissect(mpf_codec_t *codec, void **buffer
 {
 	apt_bool_t rv = TRUE;
 	if(codec->vtable->dissect) {
-		/* custom dissector for codecs like G.729, G.723 */
+		/* custom dissector for codecs like G.729, G.723, Opus */
 		rv = codec->vtable->dissect(codec,buffer,size,frame);
 	}
 	else {
@@ -172,6 +183,15 @@ static APR_INLINE apt_bool_t mpf_codec_initialize(mpf_codec_t *codec, mpf_codec_
 	return rv;
 }
 
+/** Generate decoded frame in place of a lost one by native packet loss concealment of the codec */
+static APR_INLINE apt_bool_t mpf_codec_conceal(mpf_codec_t *codec, mpf_codec_frame_t *frame_out)
+{
+	if(codec->vtable->conceal) {
+		return codec->vtable->conceal(codec,frame_out);
+	}
+	return FALSE;
+}
+
 APT_END_EXTERN_C
 
 #endif /* MPF_CODEC_H */
@@ -30,8 +30,12 @@
 
 APT_BEGIN_EXTERN_C
 
-/** Codec frame time base in msec */
-#define CODEC_FRAME_TIME_BASE 10
+/** Default codec frame time base in msec */
+#define CODEC_FRAME_TIME_DEFAULT 10
+/** Max codec frame time base in msec */
+#define CODEC_FRAME_TIME_MAX 40
+/** Codec frame time base in msec (processing cycle of media engines) */
+#define CODEC_FRAME_TIME_BASE mpf_codec_frame_time_base_get()
 /** Bytes per sample for linear pcm */
 #define BYTES_PER_SAMPLE 2
 /** Bits per sample for linear pcm */
@@ -49,6 +53,17 @@ typedef enum {
 								MPF_SAMPLE_RATE_32000 | MPF_SAMPLE_RATE_48000
 } mpf_sample_rates_e;
 
+/**
+ * Set codec frame time base.
+ * @param frame_time the frame time in msec (multiple of CODEC_FRAME_TIME_DEFAULT up to CODEC_FRAME_TIME_MAX)
+ * @remark The frame time is process wide and should be set before any media engine is created.
+ *         It should evenly divide the ptime negotiated for RTP streams.
+ */
+MPF_DECLARE(apt_bool_t) mpf_codec_frame_time_base_set(apr_uint16_t frame_time);
+
+/** Get codec frame time base in msec */
+MPF_DECLARE(apr_uint16_t) mpf_codec_frame_time_base_get(void);
+
 /** Codec descriptor declaration */
 typedef struct mpf_codec_descriptor_t mpf_codec_descriptor_t;
 /** Codec attributes declaration */
@@ -85,6 +100,8 @@ struct mpf_codec_list_t {
 	mpf_codec_descriptor_t *primary_descriptor;
 	/** Preffered named event (telephone-event) descriptor from descriptor_arr */
 	mpf_codec_descriptor_t *event_descriptor;
+	/** Preffered comfort noise (CN) descriptor from descriptor_arr */
+	mpf_codec_descriptor_t *cn_descriptor;
 };
 
 /** Codec attributes */
@@ -114,6 +131,26 @@ struct mpf_codec_frame_t {
 };
 
 
+/**
+ * Get RTP clock rate of the codec.
+ * @remark The clock rate differs from the sampling rate for G.722 (8000) and Opus (48000).
+ */
+MPF_DECLARE(apr_uint32_t) mpf_codec_rtp_clock_rate_get(const mpf_codec_descriptor_t *descriptor);
+
+/** Get channel count to signal in rtpmap (Opus is always signaled as stereo) */
+MPF_DECLARE(apr_byte_t) mpf_codec_rtp_channel_count_get(const mpf_codec_descriptor_t *descriptor);
+
+/**
+ * Set sampling rate and channel count by the clock rate and channel count of rtpmap.
+ * @param descriptor the descriptor to set, the name should be set first
+ * @param clock_rate the RTP clock rate
+ * @param channel_count the channel count (0 if not signaled)
+ */
+MPF_DECLARE(void) mpf_codec_rtpmap_apply(mpf_codec_descriptor_t *descriptor, apr_uint32_t clock_rate, apr_byte_t channel_count);
+
+/** Get max number of codec frames an RTP packet may carry (0 if not limited) */
+MPF_DECLARE(apr_size_t) mpf_codec_packet_frames_max_get(const mpf_codec_descriptor_t *descriptor);
+
 /** Initialize codec descriptor */
 static APR_INLINE void mpf_codec_descriptor_init(mpf_codec_descriptor_t *descriptor)
 {
@@ -143,7 +180,7 @@ static APR_INLINE apr_size_t mpf_codec_frame_size_calculate(const mpf_codec_desc
 /** Calculate samples of the frame (ts) */
 static APR_INLINE apr_size_t mpf_codec_frame_samples_calculate(const mpf_codec_descriptor_t *descriptor)
 {
-	return (size_t) descriptor->channel_count * CODEC_FRAME_TIME_BASE * descriptor->sampling_rate / 1000;
+	return (size_t) descriptor->channel_count * CODEC_FRAME_TIME_BASE * mpf_codec_rtp_clock_rate_get(descriptor) / 1000;
 }
 
 /** Calculate linear frame size in bytes */
@@ -160,6 +197,7 @@ static APR_INLINE void mpf_codec_list_reset(mpf_codec_list_t *codec_list)
 	codec_list->descriptor_arr = NULL;
 	codec_list->primary_descriptor = NULL;
 	codec_list->event_descriptor = NULL;
+	codec_list->cn_descriptor = NULL;
 }
 
 /** Initialize list of codec descriptors */
@@ -168,6 +206,7 @@ static APR_INLINE void mpf_codec_list_init(mpf_codec_list_t *codec_list, apr_siz
 	codec_list->descriptor_arr = apr_array_make(pool,(int)initial_count, sizeof(mpf_codec_descriptor_t));
 	codec_list->primary_descriptor = NULL;
 	codec_list->event_descriptor = NULL;
+	codec_list->cn_descriptor = NULL;
 }
 
 /** Copy list of codec descriptors */
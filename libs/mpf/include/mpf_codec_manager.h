@@ -50,6 +50,15 @@ MPF_DECLARE(apt_bool_t) mpf_codec_manager_codec_list_load(const mpf_codec_manage
 /** Find codec by name  */
 MPF_DECLARE(const mpf_codec_t*) mpf_codec_manager_codec_find(const mpf_codec_manager_t *codec_manager, const apt_str_t *codec_name);
 
+/**
+ * Intersect two codec lists, reusing the result of a previous negotiation of the same lists.
+ * @param codec_manager the codec manager holding the negotiation cache
+ * @param codec_list1 the preferred list
+ * @param codec_list2 the other list
+ * @see mpf_codec_lists_intersect()
+ */
+MPF_DECLARE(apt_bool_t) mpf_codec_manager_codec_lists_intersect(const mpf_codec_manager_t *codec_manager, mpf_codec_list_t *codec_list1, mpf_codec_list_t *codec_list2);
+
 APT_END_EXTERN_C
 
 #endif /* MPF_CODEC_MANAGER_H */
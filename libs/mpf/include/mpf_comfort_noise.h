@@ -0,0 +1,79 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MPF_COMFORT_NOISE_H
+#define MPF_COMFORT_NOISE_H
+
+/**
+ * @file mpf_comfort_noise.h
+ * @brief MPF Comfort Noise (RFC 3389)
+ */
+
+#include "mpf_codec_descriptor.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Noise level (-dBov) at and below which a frame is considered silent */
+#define MPF_CN_SILENCE_LEVEL     60
+/** Number of silent frames to pass before a silence period starts (hangover) */
+#define MPF_CN_HANGOVER_FRAMES   5
+/** Max interval between CN packets sent in a silence period (msec) */
+#define MPF_CN_UPDATE_INTERVAL   200
+/** Change of noise level (dB), which causes a CN update be sent immediately */
+#define MPF_CN_LEVEL_DELTA       3
+
+/** Comfort noise generator declaration */
+typedef struct mpf_cn_generator_t mpf_cn_generator_t;
+
+/** Comfort noise generator */
+struct mpf_cn_generator_t {
+	/** State of pseudo random sequence */
+	apr_uint32_t seed;
+	/** Current amplitude of the noise */
+	float        amplitude;
+};
+
+/** Create CN descriptor */
+MPF_DECLARE(mpf_codec_descriptor_t*) mpf_cn_descriptor_create(apr_uint16_t sampling_rate, apr_pool_t *pool);
+
+/** Check whether the specified descriptor is CN one */
+MPF_DECLARE(apt_bool_t) mpf_cn_descriptor_check(const mpf_codec_descriptor_t *descriptor);
+
+/**
+ * Calculate noise level of linear samples.
+ * @param samples the samples to calculate the level of
+ * @param count the number of samples
+ * @return the level in -dBov [0..127] as carried in CN payload
+ */
+MPF_DECLARE(apr_byte_t) mpf_cn_level_calculate(const apr_int16_t *samples, apr_size_t count);
+
+/** Initialize comfort noise generator */
+MPF_DECLARE(void) mpf_cn_generator_init(mpf_cn_generator_t *generator);
+
+/**
+ * Generate comfort noise.
+ * @param generator the generator
+ * @param level the noise level in -dBov
+ * @param samples the samples to generate
+ * @param count the number of samples
+ */
+MPF_DECLARE(void) mpf_cn_generate(mpf_cn_generator_t *generator, apr_byte_t level, apr_int16_t *samples, apr_size_t count);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_COMFORT_NOISE_H */
@@ -30,6 +30,55 @@ APT_BEGIN_EXTERN_C
 
 /** Opaque factory of media contexts */
 typedef struct mpf_context_factory_t mpf_context_factory_t;
+
+/** Size of the names in statistics of contexts, including the terminating null */
+#define MPF_CONTEXT_STAT_NAME_SIZE 64
+
+/** Max number of groups processing time of contexts is accounted in per factory */
+#define MPF_CONTEXT_MAX_GROUP_COUNT 32
+
+/** Statistics of processing time of media context */
+typedef struct mpf_context_stat_t mpf_context_stat_t;
+/** Statistics of processing time of a group of media contexts */
+typedef struct mpf_context_group_stat_t mpf_context_group_stat_t;
+
+/** Statistics of processing time of media context */
+struct mpf_context_stat_t {
+	/** Informative name of the context (e.g. the session it belongs to) */
+	char         name[MPF_CONTEXT_STAT_NAME_SIZE];
+	/** Name of the group the context belongs to (empty if none) */
+	char         group[MPF_CONTEXT_STAT_NAME_SIZE];
+	/** Number of terminations in the context */
+	apr_size_t   termination_count;
+	/** Number of media processing objects (bridges, multipliers, mixers) */
+	apr_size_t   object_count;
+	/** Number of ticks the context has been processed in */
+	apr_uint32_t tick_count;
+	/** Smoothed processing time of a tick in nsec */
+	apr_uint32_t avg_time;
+	/** Max processing time of a tick in nsec */
+	apr_uint32_t max_time;
+	/** Total processing time in nsec */
+	apr_uint64_t total_time;
+};
+
+/** Statistics of processing time of a group of media contexts (e.g. the profile of sessions) */
+struct mpf_context_group_stat_t {
+	/** Name of the group */
+	char         name[MPF_CONTEXT_STAT_NAME_SIZE];
+	/** Number of contexts of the group in the factory */
+	apr_size_t   context_count;
+	/** Sum of smoothed processing time of a tick of the contexts in nsec */
+	apr_uint32_t avg_time;
+	/** Total processing time of the current and the past contexts of the group in nsec */
+	apr_uint64_t total_time;
+};
+
+/** Layout of media processing objects walked by the factory on every tick */
+typedef enum {
+	MPF_CONTEXT_LAYOUT_DEFAULT, /**< walk the objects of each context through the context */
+	MPF_CONTEXT_LAYOUT_FLAT     /**< scan contiguous array of the objects of all the contexts */
+} mpf_context_layout_e;
  
 /**
  * Create factory of media contexts.
@@ -41,11 +90,80 @@ MPF_DECLARE(mpf_context_factory_t*) mpf_context_factory_create(apr_pool_t *pool)
  */
 MPF_DECLARE(void) mpf_context_factory_destroy(mpf_context_factory_t *factory); 
 
+/**
+ * Get the number of contexts created and not destroyed yet.
+ * @param factory the factory of media contexts
+ * @remark Can be called from any thread.
+ */
+MPF_DECLARE(apr_size_t) mpf_context_factory_context_count_get(const mpf_context_factory_t *factory);
+
+/**
+ * Set layout of media processing objects.
+ * @param factory the factory of media contexts
+ * @param layout the layout to use
+ * @remark The flat array is rebuilt on the next tick after any topology change.
+ */
+MPF_DECLARE(void) mpf_context_factory_layout_set(mpf_context_factory_t *factory, mpf_context_layout_e layout);
+
+/**
+ * Get layout of media processing objects.
+ * @param factory the factory of media contexts
+ */
+MPF_DECLARE(mpf_context_layout_e) mpf_context_factory_layout_get(const mpf_context_factory_t *factory);
+
+/**
+ * Enable accounting of processing time of each context.
+ * @param factory the factory of media contexts
+ * @param enable whether to enable accounting
+ * @remark The contexts are walked one by one, rather than by the flat array, while accounting is enabled.
+ */
+MPF_DECLARE(void) mpf_context_factory_accounting_set(mpf_context_factory_t *factory, apt_bool_t enable);
+
+/**
+ * Get statistics of the contexts taking the most of processing time.
+ * @param factory the factory of media contexts
+ * @param stats the array of statistics to fill, ordered by smoothed processing time
+ * @param max_count the max number of statistics to fill
+ * @return the number of statistics filled
+ * @remark Must be called in the context of the thread processing the factory.
+ */
+MPF_DECLARE(apr_size_t) mpf_context_factory_top_get(mpf_context_factory_t *factory, mpf_context_stat_t *stats, apr_size_t max_count);
+
+/**
+ * Get statistics of the groups of contexts.
+ * @param factory the factory of media contexts
+ * @param stats the array of statistics to fill
+ * @param max_count the max number of statistics to fill
+ * @return the number of statistics filled
+ * @remark Must be called in the context of the thread processing the factory.
+ */
+MPF_DECLARE(apr_size_t) mpf_context_factory_group_stat_get(mpf_context_factory_t *factory, mpf_context_group_stat_t *stats, apr_size_t max_count);
+
 /**
  * Process factory of media contexts.
  */
 MPF_DECLARE(apt_bool_t) mpf_context_factory_process(mpf_context_factory_t *factory);
 
+/**
+ * Process factory of media contexts within the deadline of the tick.
+ * @param factory the factory of media contexts
+ * @param deadline the time the processing is to be complete by
+ * @return the number of objects deferred to the next tick
+ * @remark The objects writing to the network are processed first and never deferred,
+ *         the objects reading from the network next and the rest last. Past the deadline,
+ *         the remaining objects only take the pending packets into the jitter buffers
+ *         and read the frames on the next tick, starting from the first deferred one.
+ *         The contexts are walked one by one with no deadline while accounting is enabled.
+ */
+MPF_DECLARE(apr_size_t) mpf_context_factory_deadline_process(mpf_context_factory_t *factory, apr_time_t deadline);
+
+/**
+ * Apply topology of the contexts marked by mpf_context_topology_invalidate().
+ * @param factory the factory of media contexts
+ * @return the number of contexts the topology has been applied for
+ */
+MPF_DECLARE(apr_size_t) mpf_context_factory_topology_apply(mpf_context_factory_t *factory);
+
 /**
  * Create MPF context.
  * @param factory the factory context belongs to
@@ -73,6 +191,20 @@ MPF_DECLARE(apt_bool_t) mpf_context_destroy(mpf_context_t *context);
  */
 MPF_DECLARE(void*) mpf_context_object_get(const mpf_context_t *context);
 
+/**
+ * Set the group processing time of the context is accounted in.
+ * @param context the context to set the group for
+ * @param group the name of the group (e.g. the profile of the session)
+ * @remark Must be set before the first termination is added to the context.
+ */
+MPF_DECLARE(apt_bool_t) mpf_context_group_set(mpf_context_t *context, const char *group);
+
+/**
+ * Get factory the context belongs to.
+ * @param context the context to get factory of
+ */
+MPF_DECLARE(mpf_context_factory_t*) mpf_context_factory_get(const mpf_context_t *context);
+
 /**
  * Add termination to context.
  * @param context the context to add termination to
@@ -115,6 +247,14 @@ MPF_DECLARE(apt_bool_t) mpf_context_associations_reset(mpf_context_t *context);
  */
 MPF_DECLARE(apt_bool_t) mpf_context_topology_apply(mpf_context_t *context);
 
+/**
+ * Mark topology for deferred apply.
+ * @param context the context to apply topology for
+ * @remark Subsequent calls are coalesced, the topology is applied once
+ *         by mpf_context_factory_topology_apply().
+ */
+MPF_DECLARE(apt_bool_t) mpf_context_topology_invalidate(mpf_context_t *context);
+
 /**
  * Destroy topology.
  * @param context the context to destroy topology for
@@ -30,6 +30,7 @@
 #include "apr_pools.h"
 #include "apt.h"
 #include "mpf_frame.h"
+#include "mpf_frame_features.h"
 #include "mpf_stream.h"
 
 APT_BEGIN_EXTERN_C
@@ -55,7 +56,8 @@ typedef struct mpf_dtmf_detector_t mpf_dtmf_detector_t;
  *   - MPF_DTMF_DETECTOR_INBAND: detect audible tones only
  *   - MPF_DTMF_DETECTOR_OUTBAND: detect out-of-band named-events only
  *   - MPF_DTMF_DETECTOR_BOTH: detect digits in both bands if supported by
- *     stream. When out-of-band digit arrives, in-band detection is turned off.
+ *     stream. When out-of-band digit arrives or named events (RFC 4733)
+ *     are negotiated for the stream, in-band detection is turned off.
  * @param pool        Memory pool to allocate DTMF detector from.
  * @return The object or NULL on error.
  * @see mpf_dtmf_detector_create
@@ -106,12 +108,24 @@ MPF_DECLARE(void) mpf_dtmf_detector_reset(struct mpf_dtmf_detector_t *detector);
 /**
  * Detect DTMF digits in the frame.
  * @param detector  The detector.
- * @param frame     Frame object passed in stream_write().
+ * @param frame     Frame object passed in stream_write() or write_event().
  */
 MPF_DECLARE(void) mpf_dtmf_detector_get_frame(
 								struct mpf_dtmf_detector_t *detector,
 								const struct mpf_frame_t *frame);
 
+/**
+ * Detect DTMF digits in the frame, the features of which are already calculated.
+ * @param detector  The detector.
+ * @param frame     Frame object passed in stream_write().
+ * @param features  Features of the frame shared with other detectors (NULL if not calculated).
+ * @remark Windows of digital silence (zero peak) are skipped with no filtering.
+ */
+MPF_DECLARE(void) mpf_dtmf_detector_features_get_frame(
+								struct mpf_dtmf_detector_t *detector,
+								const struct mpf_frame_t *frame,
+								const mpf_frame_features_t *features);
+
 /**
  * Free all resources associated with the detector.
  * @param detector  The detector.
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MPF_ENCODED_SOURCE_H
+#define MPF_ENCODED_SOURCE_H
+
+/**
+ * @file mpf_encoded_source.h
+ * @brief MPF Source of Pre-Encoded Timestamped Frames
+ */
+
+#include "mpf_stream.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Opaque encoded source declaration */
+typedef struct mpf_encoded_source_t mpf_encoded_source_t;
+
+/** Statistics of encoded source */
+typedef struct mpf_encoded_source_stat_t mpf_encoded_source_stat_t;
+
+/** Statistics of encoded source, reset on get */
+struct mpf_encoded_source_stat_t {
+	/** Number of frames played out */
+	apr_uint32_t played;
+	/** Number of frames dropped, as they arrived behind the play-out timestamp */
+	apr_uint32_t late;
+	/** Number of frames dropped, as the ring was full */
+	apr_uint32_t overruns;
+	/** Number of frame times no frame was written for (silence is sent) */
+	apr_uint32_t gaps;
+	/** Number of times the play-out is resynchronized to the written timestamps */
+	apr_uint32_t resyncs;
+	/** Number of frames dropped, as the size differs from the frame of the negotiated codec */
+	apr_uint32_t invalid;
+};
+
+/**
+ * Create audio stream of pre-encoded frames.
+ * @param codec_descriptor the codec the frames are encoded with (payload of RTP as is)
+ * @param depth the number of frames the ring holds (jitter the writer may have)
+ * @param pool the pool to allocate memory from
+ * @remark The stream is a source with the only codec of the descriptor, so that it is
+ *         bridged to the RTP stream of the same codec with no decoder and encoder,
+ *         and the frames are just packetized. The frames are handed over by a lock-free
+ *         ring of a single writer (application) and a single reader (media processing).
+ */
+MPF_DECLARE(mpf_audio_stream_t*) mpf_encoded_source_create(
+									const mpf_codec_descriptor_t *codec_descriptor,
+									apr_size_t depth,
+									apr_pool_t *pool);
+
+/**
+ * Get the encoded source of the audio stream.
+ * @param stream the stream created by mpf_encoded_source_create()
+ */
+MPF_DECLARE(mpf_encoded_source_t*) mpf_encoded_source_get(const mpf_audio_stream_t *stream);
+
+/**
+ * Write encoded frame.
+ * @param source the source to write to
+ * @param data the payload of a frame (CODEC_FRAME_TIME_BASE msec of audio of the codec)
+ * @param size the size of the payload
+ * @param timestamp the timestamp of the frame in units of the RTP clock rate of the codec
+ * @return FALSE if the frame is dropped (too large or the ring is full)
+ * @remark The frames are played out in order of the timestamps, one per frame time.
+ *         The frames behind the play-out timestamp are dropped, silence is sent
+ *         for the missing ones, and the play-out jumps to the next frame,
+ *         once it is more than the depth ahead (e.g. a new talk spurt).
+ */
+MPF_DECLARE(apt_bool_t) mpf_encoded_source_write(
+									mpf_encoded_source_t *source,
+									const void *data,
+									apr_size_t size,
+									apr_uint32_t timestamp);
+
+/**
+ * Get and reset statistics.
+ * @param source the source to get the statistics of
+ * @param stat the statistics to fill
+ */
+MPF_DECLARE(void) mpf_encoded_source_stat_get(mpf_encoded_source_t *source, mpf_encoded_source_stat_t *stat);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_ENCODED_SOURCE_H */
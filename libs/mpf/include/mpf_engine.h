@@ -26,12 +26,49 @@
 
 #include "apt_task.h"
 #include "mpf_message.h"
+#include "mpf_scheduler.h"
+#include "mpf_context.h"
+#include "mpf_rtp_stat.h"
 
 APT_BEGIN_EXTERN_C
 
+/** Max number of media processing workers (scheduler threads) per engine */
+#define MPF_MAX_WORKER_COUNT 64
+
+/** Number of buckets in the histogram of tick processing time */
+#define MPF_TICK_HISTOGRAM_SIZE 12
+
+/** Max number of the most expensive contexts in the snapshot taken by each worker */
+#define MPF_ENGINE_CONTEXT_TOP_SIZE 16
+
 /** MPF task message definition */
 typedef apt_task_msg_t mpf_task_msg_t;
 
+/** Handler to fill snapshot of statistics of RTP stream registered with the engine */
+typedef void (*mpf_rtp_stat_handler_f)(void *obj, mpf_rtp_stream_stat_t *stat);
+
+/** MPF engine tick statistics declaration */
+typedef struct mpf_engine_tick_stat_t mpf_engine_tick_stat_t;
+
+/** Statistics of processing time of media ticks */
+struct mpf_engine_tick_stat_t {
+	/** Number of processed ticks */
+	apr_uint32_t tick_count;
+	/** Number of ticks which took longer than the tick interval */
+	apr_uint32_t overrun_count;
+	/** Max processing time of a tick (usec) */
+	apr_uint32_t max_time;
+	/** Smoothed average processing time of a tick (usec), the max across the workers */
+	apr_uint32_t avg_time;
+	/** Histogram of processing time, where the bucket N counts the ticks 
+	processed within (64 << N) usec and the last bucket counts the rest */
+	apr_uint32_t histogram[MPF_TICK_HISTOGRAM_SIZE];
+	/** Number of ticks which deferred objects past the deadline */
+	apr_uint32_t deferral_count;
+	/** Current overload level (mpf_overload_level_e), the max across the workers */
+	apr_uint32_t overload_level;
+};
+
 /**
  * Create MPF engine.
  * @param id the identifier of the engine
@@ -153,6 +190,187 @@ MPF_DECLARE(apt_bool_t) mpf_engine_message_send(mpf_engine_t *engine, mpf_task_m
  */
 MPF_DECLARE(apt_bool_t) mpf_engine_scheduler_rate_set(mpf_engine_t *engine, unsigned long rate);
 
+/**
+ * Set scheduler clock source.
+ * @param engine the engine to set clock source for
+ * @param clock the clock source to drive the scheduler(s) by
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_scheduler_clock_set(mpf_engine_t *engine, mpf_scheduler_clock_e clock);
+
+/**
+ * Set real-time (SCHED_FIFO) priority of the scheduler thread(s).
+ * @param engine the engine to set priority for
+ * @param priority the priority to set (0 - use the default policy)
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_scheduler_priority_set(mpf_engine_t *engine, int priority);
+
+/**
+ * Bind the scheduler thread(s) to CPU(s).
+ * @param engine the engine to set CPU affinity for
+ * @param cpu the CPU to bind the first worker to (-1 - no binding)
+ * @remark The rest of the workers, if any, are bound to the consecutive CPUs.
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_scheduler_affinity_set(mpf_engine_t *engine, int cpu);
+
+/**
+ * Bind the scheduler thread(s) to the set of CPUs (e.g. of a NUMA node).
+ * @param engine the engine to set CPU affinity for
+ * @param cpu_set the set of CPUs to bind all the workers to (NULL - no binding)
+ * @remark The CPU set by mpf_engine_scheduler_affinity_set(), if any, takes precedence.
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_scheduler_cpu_set_set(mpf_engine_t *engine, const apt_cpu_set_t *cpu_set);
+
+/**
+ * Set layout of media processing objects walked on every tick.
+ * @param engine the engine to set layout for
+ * @param layout the layout to use
+ * @remark Should be set before the engine is started.
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_context_layout_set(mpf_engine_t *engine, mpf_context_layout_e layout);
+
+/**
+ * Enable io_uring backend of RTP socket I/O (one ring per worker).
+ * @param engine the engine to enable io_uring for
+ * @param enable whether to enable or disable io_uring
+ * @return FALSE if io_uring is not available, the default APR path is used then
+ * @remark Should be set before the engine is started.
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_io_uring_set(mpf_engine_t *engine, apt_bool_t enable);
+
+/**
+ * Offload periodic RTCP processing of all the workers to a dedicated thread.
+ * @param engine the engine to offload RTCP of
+ * @param enable whether to offload RTCP or process it on the media tick
+ * @remark Should be set before the engine is started.
+ *         RTCP of SRTP sessions and RTCP BYE are processed on the media tick anyway.
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_rtcp_offload_set(mpf_engine_t *engine, apt_bool_t enable);
+
+/**
+ * Allocate the frames of jitter buffers of each worker from a region of huge pages.
+ * @param engine the engine to set the region size for
+ * @param size the size of the region per worker in bytes (0 - normal pages of pools)
+ * @return FALSE if the region of any worker cannot be mapped, its frames are allocated as before then
+ * @remark Should be set before the engine is started. Reserved huge pages (vm.nr_hugepages)
+ *         are used, if available, transparent huge pages or normal pages otherwise.
+ *         The pool of a worker is used, once its region is exhausted.
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_huge_pages_set(mpf_engine_t *engine, apr_size_t size);
+
+/**
+ * Enable accounting of processing time of each media context.
+ * @param engine the engine to enable accounting for
+ * @param enable whether to enable accounting
+ * @remark Should be set before the engine is started. Each worker takes a snapshot of
+ *         the most expensive contexts and of the groups of contexts once per second,
+ *         which is then got by mpf_engine_context_top_get() and mpf_engine_context_group_stat_get().
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_cpu_accounting_set(mpf_engine_t *engine, apt_bool_t enable);
+
+/**
+ * Set the deadline media ticks are to be complete by.
+ * @param engine the engine to set the deadline for
+ * @param percent the deadline in percents of the tick interval (0 - no deadline)
+ * @remark Should be set before the engine is started. The objects writing to the network
+ *         (synthesizer audio to RTP) are processed first, the objects reading from the network
+ *         next and the rest last. Past the deadline, the remaining objects only take RTP packets
+ *         into the jitter buffers and pass the frames on the next tick. As the ticks keep running
+ *         close to or past the deadline, each worker rises its overload level (mpf_overload_level_e),
+ *         which suspends RTCP and then in-band DTMF detection, until it recovers.
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_tick_deadline_set(mpf_engine_t *engine, apr_size_t percent);
+
+/**
+ * Set the number of media processing workers.
+ * @param engine the engine to set the number of workers for
+ * @param worker_count the number of workers (scheduler threads)
+ * @remark Each worker is driven by its own scheduler and processes its own shard of contexts.
+ *         Contexts are pinned to workers in round-robin fashion on creation.
+ *         The number of workers can only be increased and should be set before the engine is started.
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_worker_count_set(mpf_engine_t *engine, apr_size_t worker_count);
+
+/**
+ * Get the number of media processing workers.
+ * @param engine the engine to get the number of workers of
+ */
+MPF_DECLARE(apr_size_t) mpf_engine_worker_count_get(const mpf_engine_t *engine);
+
+/**
+ * Get tick statistics accumulated across all the workers of the engine.
+ * @param engine the engine to get statistics of
+ * @param stat the statistics to fill
+ * @remark Can be called from any thread.
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_tick_stat_get(const mpf_engine_t *engine, mpf_engine_tick_stat_t *stat);
+
+/**
+ * Get the number of live contexts (created and not destroyed yet) of the engine.
+ * @param engine the engine to get the number of contexts of
+ * @remark Can be called from any thread.
+ */
+MPF_DECLARE(apr_size_t) mpf_engine_context_count_get(const mpf_engine_t *engine);
+
+/**
+ * Get the load of the engine.
+ * @param engine the engine to get the load of
+ * @return the smoothed average processing time of a tick of the busiest worker
+ *         in percents of the tick interval
+ * @remark Can be called from any thread.
+ */
+MPF_DECLARE(apr_uint32_t) mpf_engine_load_get(const mpf_engine_t *engine);
+
+/**
+ * Register RTP stream to take snapshots of statistics of.
+ * @param engine the engine to register stream with
+ * @param worker_id the worker the stream is processed by
+ * @param obj the stream
+ * @param handler the handler to fill the snapshot with
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_rtp_stat_register(mpf_engine_t *engine, apr_size_t worker_id, void *obj, mpf_rtp_stat_handler_f handler);
+
+/**
+ * Unregister RTP stream.
+ * @param engine the engine to unregister stream from
+ * @param worker_id the worker the stream is processed by
+ * @param obj the stream
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_rtp_stat_unregister(mpf_engine_t *engine, apr_size_t worker_id, void *obj);
+
+/**
+ * Get snapshot of live statistics of RTP streams.
+ * @param engine the engine to get statistics of
+ * @param stats the array of snapshots to fill (may be NULL)
+ * @param max_count the max number of snapshots to fill
+ * @param total the statistics aggregated across all the streams to fill (may be NULL)
+ * @return the number of snapshots filled
+ * @remark Can be called from any thread. Media processing is not blocked, each worker is locked 
+ *         only for the time of copying, and the values of a stream are read without synchronization
+ *         with its processing, thus they can be slightly inconsistent with each other.
+ */
+MPF_DECLARE(apr_size_t) mpf_engine_rtp_stat_get(const mpf_engine_t *engine, mpf_rtp_stream_stat_t *stats, apr_size_t max_count, mpf_rtp_engine_stat_t *total);
+
+/**
+ * Get statistics of the contexts taking the most of processing time across all the workers.
+ * @param engine the engine to get statistics of
+ * @param stats the array of statistics to fill, ordered by smoothed processing time of a tick
+ * @param max_count the max number of statistics to fill
+ * @return the number of statistics filled
+ * @remark Can be called from any thread. The statistics is as of the last snapshot taken
+ *         by each worker, up to MPF_ENGINE_CONTEXT_TOP_SIZE contexts per worker.
+ */
+MPF_DECLARE(apr_size_t) mpf_engine_context_top_get(const mpf_engine_t *engine, mpf_context_stat_t *stats, apr_size_t max_count);
+
+/**
+ * Get statistics of a group of contexts accumulated across all the workers.
+ * @param engine the engine to get statistics of
+ * @param group the name of the group set by mpf_context_group_set()
+ * @param stat the statistics to fill
+ * @return FALSE if no context of the group has been processed yet
+ * @remark Can be called from any thread. The statistics is as of the last snapshot taken by each worker.
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_context_group_stat_get(const mpf_engine_t *engine, const char *group, mpf_context_group_stat_t *stat);
+
 /**
  * Get the identifier of the engine .
  * @param engine the engine to get name of
@@ -28,6 +28,15 @@
 
 APT_BEGIN_EXTERN_C
 
+/** Policy of media engine selection */
+typedef enum {
+	MPF_ENGINE_SELECT_ROUND_ROBIN,  /**< select engines in turn */
+	MPF_ENGINE_SELECT_LEAST_LOADED  /**< select the engine with the least live contexts, skipping overloaded engines */
+} mpf_engine_select_policy_e;
+
+/** Load (tick time in percents of the tick interval) above which an engine is considered overloaded */
+#define MPF_ENGINE_OVERLOAD_THRESHOLD 80
+
 /** Create factory of media engines. */
 MPF_DECLARE(mpf_engine_factory_t*) mpf_engine_factory_create(apr_pool_t *pool);
 
@@ -37,7 +46,13 @@ MPF_DECLARE(apt_bool_t) mpf_engine_factory_engine_add(mpf_engine_factory_t *mpf_
 /** Determine whether factory is empty. */
 MPF_DECLARE(apt_bool_t) mpf_engine_factory_is_empty(const mpf_engine_factory_t *mpf_factory);
 
-/** Select next available media engine. */
+/** Set policy of media engine selection. */
+MPF_DECLARE(void) mpf_engine_factory_policy_set(mpf_engine_factory_t *mpf_factory, mpf_engine_select_policy_e policy);
+
+/** Get the number of media engines in factory. */
+MPF_DECLARE(apr_size_t) mpf_engine_factory_engine_count_get(const mpf_engine_factory_t *mpf_factory);
+
+/** Select next available media engine according to the policy. */
 MPF_DECLARE(mpf_engine_t*) mpf_engine_factory_engine_select(mpf_engine_factory_t *mpf_factory);
 
 /** Associate media engines with RTP termination factory. */
@@ -34,7 +34,9 @@ typedef enum {
 	MEDIA_FRAME_TYPE_NONE  = 0x0, /**< none */
 	MEDIA_FRAME_TYPE_AUDIO = 0x1, /**< audio frame */
 	MEDIA_FRAME_TYPE_VIDEO = 0x2, /**< video frame */
-	MEDIA_FRAME_TYPE_EVENT = 0x4  /**< named event frame (RFC4733/RFC2833) */
+	MEDIA_FRAME_TYPE_EVENT = 0x4, /**< named event frame (RFC4733/RFC2833) */
+	MEDIA_FRAME_TYPE_LOST  = 0x8, /**< lost audio frame to be concealed by the decoder */
+	MEDIA_FRAME_TYPE_CN    = 0x10 /**< comfort noise frame (RFC 3389), first byte of codec frame is the noise level */
 } mpf_frame_type_e;
 
 /** Media frame marker */
@@ -25,6 +25,7 @@
  */ 
 
 #include "mpf_frame.h"
+#include "apt_executor.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -32,13 +33,17 @@ APT_BEGIN_EXTERN_C
 typedef struct mpf_frame_buffer_t mpf_frame_buffer_t;
 
 
-/** Create frame buffer */
+/**
+ * Create frame buffer.
+ * @remark The buffer is a lock-free ring of a single producer (write)
+ *         and a single consumer (read), neither of them ever waits for the other.
+ */
 mpf_frame_buffer_t* mpf_frame_buffer_create(apr_size_t frame_size, apr_size_t frame_count, apr_pool_t *pool);
 
 /** Destroy frame buffer */
 void mpf_frame_buffer_destroy(mpf_frame_buffer_t *buffer);
 
-/** Restart frame buffer */
+/** Restart frame buffer, the written frames are skipped by the next read */
 apt_bool_t mpf_frame_buffer_restart(mpf_frame_buffer_t *buffer);
 
 /** Write frame to buffer */
@@ -47,8 +52,15 @@ apt_bool_t mpf_frame_buffer_write(mpf_frame_buffer_t *buffer, const mpf_frame_t
 /** Read frame from buffer */
 apt_bool_t mpf_frame_buffer_read(mpf_frame_buffer_t *buffer, mpf_frame_t *frame);
 
+/** Get and reset the number of frames dropped, as the buffer was full */
+apr_size_t mpf_frame_buffer_overruns_get(mpf_frame_buffer_t *buffer);
+
+/** Get and reset the number of reads, the buffer was empty at */
+apr_size_t mpf_frame_buffer_underruns_get(mpf_frame_buffer_t *buffer);
+
 #ifdef MPF_FRAME_BUFFER_DEBUG
-apt_bool_t mpf_frame_buffer_file_open(mpf_frame_buffer_t *buffer, const char *utt_file_in, const char *utt_file_out);
+/** Dump written and read frames to files (asynchronously written by executor, if not NULL) */
+apt_bool_t mpf_frame_buffer_file_open(mpf_frame_buffer_t *buffer, const char *utt_file_in, const char *utt_file_out, apt_executor_t *executor);
 #endif
 
 APT_END_EXTERN_C
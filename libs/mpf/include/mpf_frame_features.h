@@ -0,0 +1,68 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#ifndef MPF_FRAME_FEATURES_H
+#define MPF_FRAME_FEATURES_H
+
+/**
+ * @file mpf_frame_features.h
+ * @brief MPF Audio Features of Frame
+ */ 
+
+#include "mpf_frame.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Audio features of frame declaration */
+typedef struct mpf_frame_features_t mpf_frame_features_t;
+
+/** Audio features of linear frame, calculated in a single pass over the samples */
+struct mpf_frame_features_t {
+	/** Number of samples (0 if the frame carries no audio) */
+	apr_size_t   count;
+	/** Sum of absolute values of samples */
+	apr_uint64_t magnitude;
+	/** Sum of squares of samples */
+	apr_uint64_t energy;
+	/** Max absolute value of samples */
+	apr_uint32_t peak;
+	/** Number of sign changes between adjacent samples */
+	apr_size_t   crossings;
+};
+
+/**
+ * Calculate audio features of linear frame.
+ * @param features the features to calculate
+ * @param frame the frame of 16-bit linear samples
+ * @return FALSE if the frame carries no audio (features are zeroed then)
+ * @remark The features are calculated once per frame and passed on to every
+ *         detector processing the same frame within the tick, instead of each
+ *         detector iterating the samples over again.
+ */
+MPF_DECLARE(apt_bool_t) mpf_frame_features_calculate(mpf_frame_features_t *features, const mpf_frame_t *frame);
+
+/** Get mean absolute value of samples */
+static APR_INLINE apr_size_t mpf_frame_features_level_get(const mpf_frame_features_t *features)
+{
+	return features->count ? (apr_size_t)(features->magnitude / features->count) : 0;
+}
+
+APT_END_EXTERN_C
+
+#endif /* MPF_FRAME_FEATURES_H */
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#ifndef MPF_FRAME_POOL_H
+#define MPF_FRAME_POOL_H
+
+/**
+ * @file mpf_frame_pool.h
+ * @brief MPF Pool of Codec Frame Buffers
+ */ 
+
+#include "mpf_types.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Alignment of frame buffers (cache line) */
+#define MPF_FRAME_POOL_ALIGNMENT 64
+
+/** Pool of frame buffers declaration */
+typedef struct mpf_frame_pool_t mpf_frame_pool_t;
+
+/**
+ * Create pool of frame buffers.
+ * @param pool the pool to allocate memory from
+ * @remark The buffers are kept in free lists by size class (powers of 2 from 64 bytes
+ *         up to 64 KB) and reused across media processing objects, which borrow them
+ *         on topology apply and return them on destroy. The pool is not thread-safe,
+ *         it is used in the context of one media processing thread.
+ */
+MPF_DECLARE(mpf_frame_pool_t*) mpf_frame_pool_create(apr_pool_t *pool);
+
+/**
+ * Borrow frame buffer.
+ * @param frame_pool the pool of frame buffers (may be NULL)
+ * @param size the size of the buffer
+ * @param pool the pool to allocate from, if frame_pool is NULL or size exceeds the largest class
+ * @return the buffer aligned to MPF_FRAME_POOL_ALIGNMENT (content undefined)
+ */
+MPF_DECLARE(void*) mpf_frame_pool_buffer_get(mpf_frame_pool_t *frame_pool, apr_size_t size, apr_pool_t *pool);
+
+/**
+ * Return frame buffer.
+ * @param frame_pool the pool of frame buffers the buffer has been borrowed with (may be NULL)
+ * @param buffer the buffer to return (may be NULL)
+ */
+MPF_DECLARE(void) mpf_frame_pool_buffer_release(mpf_frame_pool_t *frame_pool, void *buffer);
+
+/**
+ * Get number of buffers allocated by the pool (in use or free).
+ * @param frame_pool the pool of frame buffers
+ */
+MPF_DECLARE(apr_size_t) mpf_frame_pool_buffer_count_get(const mpf_frame_pool_t *frame_pool);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_FRAME_POOL_H */
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MPF_G711_KERNEL_H
+#define MPF_G711_KERNEL_H
+
+/**
+ * @file mpf_g711_kernel.h
+ * @brief MPF G.711 Whole-Frame Encode/Decode Kernels
+ */
+
+#include "mpf_types.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Instruction set G.711 kernels are implemented with */
+typedef enum {
+	MPF_G711_KERNEL_SCALAR, /**< portable per sample conversion */
+	MPF_G711_KERNEL_SSE41,  /**< x86 SSE4.1 */
+	MPF_G711_KERNEL_AVX2,   /**< x86 AVX2 */
+	MPF_G711_KERNEL_NEON,   /**< ARM NEON */
+
+	MPF_G711_KERNEL_COUNT
+} mpf_g711_kernel_e;
+
+/** Encode count linear samples */
+typedef void (*mpf_g711_encode_f)(const apr_int16_t *linear, apr_byte_t *code, apr_size_t count);
+/** Decode count G.711 codes */
+typedef void (*mpf_g711_decode_f)(const apr_byte_t *code, apr_int16_t *linear, apr_size_t count);
+
+/** Declaration of G.711 kernel set */
+typedef struct mpf_g711_kernel_t mpf_g711_kernel_t;
+
+/** G.711 kernel set (output is bit-exact across all kernels) */
+struct mpf_g711_kernel_t {
+	/** Instruction set */
+	mpf_g711_kernel_e type;
+	/** Name used in logs and benchmarks */
+	const char       *name;
+	/** Linear to u-law */
+	mpf_g711_encode_f ulaw_encode;
+	/** U-law to linear */
+	mpf_g711_decode_f ulaw_decode;
+	/** Linear to A-law */
+	mpf_g711_encode_f alaw_encode;
+	/** A-law to linear */
+	mpf_g711_decode_f alaw_decode;
+};
+
+/**
+ * Get the kernel set of the specified instruction set.
+ * @param type the instruction set
+ * @return NULL if the kernels are not compiled in or not supported by the CPU
+ */
+MPF_DECLARE(const mpf_g711_kernel_t*) mpf_g711_kernel_get(mpf_g711_kernel_e type);
+
+/**
+ * Get the fastest kernel set supported by the CPU (detected once).
+ */
+MPF_DECLARE(const mpf_g711_kernel_t*) mpf_g711_kernel_best_get(void);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_G711_KERNEL_H */
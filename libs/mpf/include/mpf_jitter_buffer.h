@@ -27,6 +27,7 @@
 #include "mpf_frame.h"
 #include "mpf_codec.h"
 #include "mpf_rtp_descriptor.h"
+#include "apt_huge_region.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -41,9 +42,50 @@ typedef enum {
 /** Opaque jitter buffer declaration */
 typedef struct mpf_jitter_buffer_t mpf_jitter_buffer_t;
 
+/** Opaque slab of jitter buffer frames declaration */
+typedef struct mpf_jb_slab_t mpf_jb_slab_t;
 
-/** Create jitter buffer */
-mpf_jitter_buffer_t* mpf_jitter_buffer_create(mpf_jb_config_t *jb_config, mpf_codec_descriptor_t *descriptor, mpf_codec_t *codec, apr_pool_t *pool);
+
+/**
+ * Create slab the frames of jitter buffers are taken from on demand.
+ * @param pool the pool to allocate the slab from (NULL - create a pool of its own)
+ * @remark The slab is shared by the jitter buffers of a media worker and is not thread-safe.
+ *         The blocks released by a jitter buffer are reused by the others, but never
+ *         given back to the pool, so the slab is as large as the peak of the windows in use.
+ */
+mpf_jb_slab_t* mpf_jb_slab_create(apr_pool_t *pool);
+
+/** Destroy slab, created with a pool of its own */
+void mpf_jb_slab_destroy(mpf_jb_slab_t *slab);
+
+/**
+ * Set region the blocks of slab are allocated from, rather than from the pool.
+ * @param slab the slab to set the region of
+ * @param region the region (NULL - the pool), must outlive the slab
+ * @remark The pool is used, once the region is exhausted.
+ */
+void mpf_jb_slab_region_set(mpf_jb_slab_t *slab, apt_huge_region_t *region);
+
+/**
+ * Get the storage of slab.
+ * @param slab the slab to get the storage of
+ * @param allocated the size of the blocks allocated in bytes
+ * @param used the size of the blocks held by jitter buffers in bytes
+ */
+void mpf_jb_slab_stat_get(const mpf_jb_slab_t *slab, apr_size_t *allocated, apr_size_t *used);
+
+/**
+ * Create jitter buffer.
+ * @param jb_config the config of the jitter buffer
+ * @param descriptor the codec descriptor of the stream
+ * @param codec the codec to dissect payloads by
+ * @param slab the slab to take the frames from (NULL - a slab of the jitter buffer's own)
+ * @param pool the pool to allocate memory from
+ * @remark The frames are taken from the slab in blocks, as the window between the read
+ *         and the write pos grows, and given back, once read, so that the storage follows
+ *         the playout delay actually in effect rather than the max one.
+ */
+mpf_jitter_buffer_t* mpf_jitter_buffer_create(mpf_jb_config_t *jb_config, mpf_codec_descriptor_t *descriptor, mpf_codec_t *codec, mpf_jb_slab_t *slab, apr_pool_t *pool);
 
 /** Destroy jitter buffer */
 void mpf_jitter_buffer_destroy(mpf_jitter_buffer_t *jb);
@@ -51,15 +93,52 @@ void mpf_jitter_buffer_destroy(mpf_jitter_buffer_t *jb);
 /** Restart jitter buffer */
 apt_bool_t mpf_jitter_buffer_restart(mpf_jitter_buffer_t *jb);
 
+/** Check whether no frame is buffered yet to be read */
+apt_bool_t mpf_jitter_buffer_is_empty(const mpf_jitter_buffer_t *jb);
+
 /** Write audio data to jitter buffer */
 jb_result_t mpf_jitter_buffer_write(mpf_jitter_buffer_t *jb, void *buffer, apr_size_t size, apr_uint32_t ts, apr_byte_t marker);
 
+/**
+ * Get the free slots the next in-order audio payload is expected to be written to.
+ * @param jb the jitter buffer
+ * @param size the size of the contiguous slots in bytes
+ * @return the buffer to receive the payload into, or NULL if the payload must be written by copy
+ */
+void* mpf_jitter_buffer_slots_get(mpf_jitter_buffer_t *jb, apr_size_t *size);
+
+/**
+ * Check whether the audio payload received into the slots is to be written in place.
+ * @param jb the jitter buffer
+ * @param buffer the payload received into the slots returned by mpf_jitter_buffer_slots_get()
+ * @param ts the timestamp of the payload
+ * @param marker the marker of the payload
+ * @return TRUE if mpf_jitter_buffer_write() will take the payload without copying,
+ *         FALSE if the payload must be moved out of the slots first
+ */
+apt_bool_t mpf_jitter_buffer_slots_match(const mpf_jitter_buffer_t *jb, const void *buffer, apr_uint32_t ts, apr_byte_t marker);
+
 /** Write named event to jitter buffer */
 jb_result_t mpf_jitter_buffer_event_write(mpf_jitter_buffer_t *jb, const mpf_named_event_frame_t *named_event, apr_uint32_t ts, apr_byte_t marker);
 
 /** Read media frame from jitter buffer */
 apt_bool_t mpf_jitter_buffer_read(mpf_jitter_buffer_t *jb, mpf_frame_t *media_frame);
 
+/**
+ * Mark missing frames as lost (MEDIA_FRAME_TYPE_LOST) instead of repeating the last frame.
+ * @param jb the jitter buffer
+ * @param enable whether the lost frames are to be concealed in the decoder path
+ */
+void mpf_jitter_buffer_loss_mark_set(mpf_jitter_buffer_t *jb, apt_bool_t enable);
+
+/**
+ * Get audio buffered in excess of the playout delay.
+ * @param jb the jitter buffer
+ * @return the excess (usec), negative if less than the playout delay is buffered
+ * @remark The excess grows, if the sender clock runs faster than the local one, and falls otherwise.
+ */
+apr_int32_t mpf_jitter_buffer_excess_get(const mpf_jitter_buffer_t *jb);
+
 /** Get current playout delay */
 apr_uint32_t mpf_jitter_buffer_playout_delay_get(const mpf_jitter_buffer_t *jb);
 
@@ -28,8 +28,12 @@
 
 APT_BEGIN_EXTERN_C
 
-/** Max number of messages grouped in a container */
-#define MAX_MPF_MESSAGE_COUNT 5
+/**
+ * Max number of messages grouped in a container.
+ * The whole offer of a session (reset, terminations, associations, topology)
+ * is expected to fit in a single container, making one round-trip to MPF.
+ */
+#define MAX_MPF_MESSAGE_COUNT 16
 
 /** Enumeration of MPF message types */
 typedef enum {
@@ -21,10 +21,11 @@
 
 /**
  * @file mpf_mixer.h
- * @brief MPF Stream Mixer (n-sources, 1-sink)
+ * @brief MPF Stream Mixer (n-sources, 1-sink) and N-1 Mixer (n-sources, n-sinks)
  */ 
 
 #include "mpf_object.h"
+#include "mpf_frame_pool.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -35,6 +36,7 @@ APT_BEGIN_EXTERN_C
  * @param sink the audio sink
  * @param codec_manager the codec manager
  * @param name the informative name used for debugging
+ * @param frame_pool the pool to borrow frame buffers from (may be NULL)
  * @param pool the pool to allocate memory from
  */
 MPF_DECLARE(mpf_object_t*) mpf_mixer_create(
@@ -43,6 +45,28 @@ MPF_DECLARE(mpf_object_t*) mpf_mixer_create(
 								mpf_audio_stream_t *sink, 
 								const mpf_codec_manager_t *codec_manager,
 								const char *name,
+								mpf_frame_pool_t *frame_pool,
+								apr_pool_t *pool);
+
+/**
+ * Create N-1 mixer of audio streams, each participant hears the others.
+ * @param stream_arr the array of audio streams, both sources and sinks
+ * @param stream_count the number of audio streams
+ * @param codec_manager the codec manager
+ * @param name the informative name used for debugging
+ * @param frame_pool the pool to borrow frame buffers from (may be NULL)
+ * @param pool the pool to allocate memory from
+ * @return NULL if the streams are not of the same sampling rate and channel count
+ * @remark Each source is read once per tick, the full mix is summed once, and the
+ *         output of each participant is derived by subtracting its own frame,
+ *         which replaces one mixer per sink re-mixing all the sources (O(N) vs O(N^2)).
+ */
+MPF_DECLARE(mpf_object_t*) mpf_mixer_n1_create(
+								mpf_audio_stream_t **stream_arr,
+								apr_size_t stream_count,
+								const mpf_codec_manager_t *codec_manager,
+								const char *name,
+								mpf_frame_pool_t *frame_pool,
 								apr_pool_t *pool);
 
 
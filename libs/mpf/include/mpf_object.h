@@ -31,6 +31,15 @@ APT_BEGIN_EXTERN_C
 /** MPF object declaration */
 typedef struct mpf_object_t mpf_object_t;
 
+/** Priority of media processing objects within the tick */
+typedef enum {
+	MPF_OBJECT_PRIORITY_TX,    /**< writes to the network (e.g. synthesizer audio to RTP) */
+	MPF_OBJECT_PRIORITY_RX,    /**< reads from the network (e.g. RTP to recognizer) */
+	MPF_OBJECT_PRIORITY_LOCAL, /**< neither reads from nor writes to the network */
+
+	MPF_OBJECT_PRIORITY_COUNT
+} mpf_object_priority_e;
+
 /** Media processing objects base */
 struct mpf_object_t {
 	/** Informative name used for debugging */
@@ -41,6 +50,10 @@ struct mpf_object_t {
 	apt_bool_t (*process)(mpf_object_t *object);
 	/** Virtual trace of media path */
 	void (*trace)(mpf_object_t *object);
+	/** Virtual defer (optional), called instead of process past the deadline of the tick */
+	apt_bool_t (*defer)(mpf_object_t *object);
+	/** Priority the object is processed by within the tick */
+	mpf_object_priority_e priority;
 };
 
 /** Initialize object */
@@ -50,6 +63,8 @@ static APR_INLINE void mpf_object_init(mpf_object_t *object, const char *name)
 	object->destroy = NULL;
 	object->process = NULL;
 	object->trace = NULL;
+	object->defer = NULL;
+	object->priority = MPF_OBJECT_PRIORITY_LOCAL;
 }
 
 /** Destroy object */
@@ -66,6 +81,13 @@ static APR_INLINE void mpf_object_process(mpf_object_t *object)
 		object->process(object);
 }
 
+/** Defer processing of object to the next tick */
+static APR_INLINE void mpf_object_defer(mpf_object_t *object)
+{
+	if(object->defer)
+		object->defer(object);
+}
+
 /** Trace media path */
 static APR_INLINE void mpf_object_trace(mpf_object_t *object)
 {
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MPF_PLC_H
+#define MPF_PLC_H
+
+/**
+ * @file mpf_plc.h
+ * @brief MPF Packet Loss Concealment (Waveform Substitution)
+ */ 
+
+#include "mpf_types.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Opaque packet loss concealment declaration */
+typedef struct mpf_plc_t mpf_plc_t;
+
+/**
+ * Create packet loss concealment of mono linear PCM.
+ * @param sampling_rate the sampling rate
+ * @param pool the pool to allocate memory from
+ */
+MPF_DECLARE(mpf_plc_t*) mpf_plc_create(apr_uint16_t sampling_rate, apr_pool_t *pool);
+
+/**
+ * Pass a received (decoded) frame through.
+ * @param plc the packet loss concealment
+ * @param samples the samples, smoothed in place after a concealed loss
+ * @param count the number of samples
+ */
+MPF_DECLARE(void) mpf_plc_receive(mpf_plc_t *plc, apr_int16_t *samples, apr_size_t count);
+
+/**
+ * Substitute a lost frame by repeating the last pitch period with fading.
+ * @param plc the packet loss concealment
+ * @param samples the samples to generate
+ * @param count the number of samples
+ * @return FALSE if the loss cannot be concealed (no history yet or faded out)
+ */
+MPF_DECLARE(apt_bool_t) mpf_plc_conceal(mpf_plc_t *plc, apr_int16_t *samples, apr_size_t count);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_PLC_H */
@@ -29,13 +29,22 @@
 APT_BEGIN_EXTERN_C
 
 /**
- * Create audio stream resampler.
- * @param source the source stream to resample
+ * Create audio stream resampler to be read from instead of the source.
+ * @param source the source stream (linear PCM) to resample
  * @param sink the sink stream to resample to
  * @param pool the pool to allocate memory from
+ * @remark The sampling rates 8, 16, 32 and 48 kHz of mono streams are supported.
  */
 MPF_DECLARE(mpf_audio_stream_t*) mpf_resampler_create(mpf_audio_stream_t *source, mpf_audio_stream_t *sink, apr_pool_t *pool);
 
+/**
+ * Create audio stream resampler to be written to instead of the sink.
+ * @param source the source stream to resample from
+ * @param sink the sink stream (linear PCM) to write resampled frames to
+ * @param pool the pool to allocate memory from
+ */
+MPF_DECLARE(mpf_audio_stream_t*) mpf_sink_resampler_create(mpf_audio_stream_t *source, mpf_audio_stream_t *sink, apr_pool_t *pool);
+
 
 APT_END_EXTERN_C
 
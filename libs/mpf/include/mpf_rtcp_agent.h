@@ -0,0 +1,95 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#ifndef MPF_RTCP_AGENT_H
+#define MPF_RTCP_AGENT_H
+
+/**
+ * @file mpf_rtcp_agent.h
+ * @brief MPF RTCP Agent (RTCP Processing off the Media Thread)
+ */ 
+
+#include "mpf_types.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Resolution the entries of RTCP agent are checked at (msec) */
+#define MPF_RTCP_AGENT_RESOLUTION 10
+
+/** Opaque RTCP agent declaration */
+typedef struct mpf_rtcp_agent_t mpf_rtcp_agent_t;
+/** Opaque RTCP agent entry declaration */
+typedef struct mpf_rtcp_agent_entry_t mpf_rtcp_agent_entry_t;
+
+/**
+ * Prototype of RTCP agent handler, called from the thread of the agent.
+ * @param obj the object of the entry
+ * @return TRUE if done (called again after the interval), FALSE to be called again at the next check
+ */
+typedef apt_bool_t (*mpf_rtcp_agent_proc_f)(void *obj);
+
+/**
+ * Create RTCP agent.
+ * @param pool the pool to allocate memory from
+ * @remark The agent runs a thread of its own at a priority lower than the media one,
+ *         so that generation, parsing and socket I/O of RTCP never delay audio.
+ */
+MPF_DECLARE(mpf_rtcp_agent_t*) mpf_rtcp_agent_create(apr_pool_t *pool);
+
+/** Destroy RTCP agent */
+MPF_DECLARE(void) mpf_rtcp_agent_destroy(mpf_rtcp_agent_t *agent);
+
+/** Start the thread of RTCP agent */
+MPF_DECLARE(apt_bool_t) mpf_rtcp_agent_start(mpf_rtcp_agent_t *agent);
+
+/** Stop the thread of RTCP agent and wait for it to finish */
+MPF_DECLARE(apt_bool_t) mpf_rtcp_agent_stop(mpf_rtcp_agent_t *agent);
+
+/**
+ * Add entry to RTCP agent.
+ * @param agent the agent to add the entry to
+ * @param obj the object to pass to the handlers
+ * @param tx_proc the handler of transmission (NULL - none)
+ * @param tx_interval the interval of transmission (msec)
+ * @param rx_proc the handler of reception (NULL - none)
+ * @param rx_interval the interval of reception (msec)
+ */
+MPF_DECLARE(mpf_rtcp_agent_entry_t*) mpf_rtcp_agent_entry_add(
+								mpf_rtcp_agent_t *agent,
+								void *obj,
+								mpf_rtcp_agent_proc_f tx_proc,
+								apr_uint32_t tx_interval,
+								mpf_rtcp_agent_proc_f rx_proc,
+								apr_uint32_t rx_interval);
+
+/**
+ * Remove entry from RTCP agent.
+ * @param agent the agent to remove the entry from
+ * @param entry the entry to remove
+ * @remark Waits for a handler of the entry in progress (if any) to complete,
+ *         no handler of the entry is called once the function returns.
+ */
+MPF_DECLARE(void) mpf_rtcp_agent_entry_remove(mpf_rtcp_agent_t *agent, mpf_rtcp_agent_entry_t *entry);
+
+/** Get the number of entries of RTCP agent */
+MPF_DECLARE(apr_size_t) mpf_rtcp_agent_entry_count_get(const mpf_rtcp_agent_t *agent);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_RTCP_AGENT_H */
@@ -35,9 +35,15 @@ typedef enum {
 	RTCP_RR   = 201,
 	RTCP_SDES = 202,
 	RTCP_BYE  = 203,
-	RTCP_APP  = 204
+	RTCP_APP  = 204,
+	RTCP_XR   = 207
 } rtcp_type_e;
 
+/** RTCP XR report block types */
+typedef enum {
+	RTCP_XR_VOIP_METRICS = 7
+} rtcp_xr_block_type_e;
+
 /** RTCP SDES types */
 typedef enum {
 	RTCP_SDES_END   = 0,
@@ -57,6 +63,8 @@ typedef struct rtcp_header_t rtcp_header_t;
 typedef struct rtcp_packet_t rtcp_packet_t;
 /** SDES item declaration*/
 typedef struct rtcp_sdes_item_t rtcp_sdes_item_t;
+/** XR VoIP metrics report block declaration */
+typedef struct rtcp_xr_voip_metrics_t rtcp_xr_voip_metrics_t;
 
 
 /** RTCP header */
@@ -95,6 +103,60 @@ struct rtcp_sdes_item_t {
 	char       data[1];
 };
 
+/** XR VoIP metrics report block (RFC 3611) */
+struct rtcp_xr_voip_metrics_t {
+	/** block type (RTCP_XR_VOIP_METRICS) */
+	apr_byte_t   bt;
+	/** reserved */
+	apr_byte_t   reserved;
+	/** block length in words, w/o the first one */
+	apr_uint16_t length;
+	/** source identifier of RTP stream being reported */
+	apr_uint32_t ssrc;
+	/** fraction of packets lost (1/256) */
+	apr_byte_t   loss_rate;
+	/** fraction of packets discarded (1/256) */
+	apr_byte_t   discard_rate;
+	/** fraction of packets lost/discarded within bursts (1/256) */
+	apr_byte_t   burst_density;
+	/** fraction of packets lost/discarded within gaps (1/256) */
+	apr_byte_t   gap_density;
+	/** mean duration of bursts (msec) */
+	apr_uint16_t burst_duration;
+	/** mean duration of gaps (msec) */
+	apr_uint16_t gap_duration;
+	/** round trip delay (msec) */
+	apr_uint16_t round_trip_delay;
+	/** end system delay (msec) */
+	apr_uint16_t end_system_delay;
+	/** signal level (dBm, 127 - unavailable) */
+	apr_byte_t   signal_level;
+	/** noise level (dBm, 127 - unavailable) */
+	apr_byte_t   noise_level;
+	/** residual echo return loss (dB, 127 - unavailable) */
+	apr_byte_t   rerl;
+	/** gap threshold */
+	apr_byte_t   gmin;
+	/** R factor (127 - unavailable) */
+	apr_byte_t   r_factor;
+	/** external R factor (127 - unavailable) */
+	apr_byte_t   ext_r_factor;
+	/** MOS listening quality (x10, 127 - unavailable) */
+	apr_byte_t   mos_lq;
+	/** MOS conversational quality (x10, 127 - unavailable) */
+	apr_byte_t   mos_cq;
+	/** receiver configuration (PLC, jitter buffer adaptive, jitter buffer rate) */
+	apr_byte_t   rx_config;
+	/** reserved */
+	apr_byte_t   reserved2;
+	/** nominal jitter buffer delay (msec) */
+	apr_uint16_t jb_nominal;
+	/** max jitter buffer delay (msec) */
+	apr_uint16_t jb_maximum;
+	/** absolute max jitter buffer delay (msec) */
+	apr_uint16_t jb_abs_max;
+};
+
 /** RTCP packet */
 struct rtcp_packet_t {
 	/** common header */
@@ -134,6 +196,14 @@ struct rtcp_packet_t {
 			/* optional reason string, not null-terminated */
 			char         data[1];
 		} bye;
+
+		/** extended report (XR) */
+		struct {
+			/** source generating this report */
+			apr_uint32_t           ssrc;
+			/** VoIP metrics report block */
+			rtcp_xr_voip_metrics_t voip_metrics;
+		} xr;
 	} r;
 };
 
@@ -185,6 +255,19 @@ static APR_INLINE void rtcp_rr_hton(rtcp_rr_stat_t *rr_stat)
 #endif
 }
 
+static APR_INLINE void rtcp_xr_voip_metrics_hton(rtcp_xr_voip_metrics_t *voip_metrics)
+{
+	voip_metrics->length = htons(voip_metrics->length);
+	voip_metrics->ssrc = htonl(voip_metrics->ssrc);
+	voip_metrics->burst_duration = htons(voip_metrics->burst_duration);
+	voip_metrics->gap_duration = htons(voip_metrics->gap_duration);
+	voip_metrics->round_trip_delay = htons(voip_metrics->round_trip_delay);
+	voip_metrics->end_system_delay = htons(voip_metrics->end_system_delay);
+	voip_metrics->jb_nominal = htons(voip_metrics->jb_nominal);
+	voip_metrics->jb_maximum = htons(voip_metrics->jb_maximum);
+	voip_metrics->jb_abs_max = htons(voip_metrics->jb_abs_max);
+}
+
 static APR_INLINE void rtcp_rr_ntoh(rtcp_rr_stat_t *rr_stat)
 {
 	rr_stat->ssrc = ntohl(rr_stat->ssrc);
@@ -36,6 +36,8 @@ typedef enum {
 	RTP_ATTRIB_SENDRECV,
 	RTP_ATTRIB_MID,
 	RTP_ATTRIB_PTIME,
+	RTP_ATTRIB_RTCP_MUX,
+	RTP_ATTRIB_CRYPTO,
 
 	RTP_ATTRIB_COUNT,
 	RTP_ATTRIB_UNKNOWN = RTP_ATTRIB_COUNT
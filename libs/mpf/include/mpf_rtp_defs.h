@@ -115,6 +115,13 @@ struct rtp_receiver_t {
 	rtp_rx_history_t          history;
 	/** RTP periodic history */
 	rtp_rx_periodic_history_t periodic_history;
+	/** Loss/discard bursts used in RTCP XR */
+	rtcp_xr_burst_stat_t      burst_stat;
+
+	/** Indicate silence period signaled by CN packet */
+	apt_bool_t                cn;
+	/** Noise level (-dBov) of the last CN packet received */
+	apr_byte_t                cn_level;
 };
 
 
@@ -132,6 +139,10 @@ struct rtp_transmitter_t {
 
 	/** Indicate silence period among the talkspurts */
 	apr_byte_t      inactivity;
+	/** Noise level (-dBov) of the last CN packet sent */
+	apr_byte_t      cn_level;
+	/** Timestamp of the last CN packet sent */
+	apr_uint32_t    cn_timestamp;
 	/** Last seq number sent */
 	apr_uint16_t    last_seq_num;
 	/** Current timestamp (samples processed) */
@@ -153,11 +164,14 @@ struct rtp_transmitter_t {
 static APR_INLINE void rtp_receiver_init(rtp_receiver_t *receiver)
 {
 	receiver->jb = NULL;
+	receiver->cn = FALSE;
+	receiver->cn_level = 0;
 
 	mpf_rtcp_rr_stat_reset(&receiver->rr_stat);
 	mpf_rtp_rx_stat_reset(&receiver->stat);
 	mpf_rtp_rx_history_reset(&receiver->history);
 	mpf_rtp_rx_periodic_history_reset(&receiver->periodic_history);
+	mpf_rtcp_xr_burst_stat_reset(&receiver->burst_stat);
 }
 
 /** Initialize RTP transmitter */
@@ -170,6 +184,8 @@ static APR_INLINE void rtp_transmitter_init(rtp_transmitter_t *transmitter)
 	transmitter->samples_per_frame = 0;
 
 	transmitter->inactivity = 0;
+	transmitter->cn_level = 0;
+	transmitter->cn_timestamp = 0;
 	transmitter->last_seq_num = 0;
 	transmitter->timestamp = 0;
 	transmitter->timestamp_base = 0;
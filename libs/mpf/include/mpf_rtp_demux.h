@@ -0,0 +1,103 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+#ifndef MPF_RTP_DEMUX_H
+#define MPF_RTP_DEMUX_H
+
+/**
+ * @file mpf_rtp_demux.h
+ * @brief MPF RTP Demultiplexer (RTP/RTCP Sockets Shared by Streams)
+ */ 
+
+#include <apr_network_io.h>
+#include "mpf_types.h"
+#include "apt_string.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Opaque RTP demultiplexer */
+typedef struct mpf_rtp_demux_t mpf_rtp_demux_t;
+
+/**
+ * Prototype of packet handler.
+ * @param obj the object the route is registered for
+ * @param buffer the received packet
+ * @param size the size of packet
+ * @param rtcp whether the packet is RTCP or RTP
+ */
+typedef void (*mpf_rtp_demux_handler_f)(void *obj, char *buffer, apr_size_t size, apt_bool_t rtcp);
+
+/**
+ * Create RTP demultiplexer bound to the specified address.
+ * @param ip the local IP address to bind to
+ * @param port the local RTP port (RTCP socket, if any, is bound to port+1)
+ * @param rtcp whether to create RTCP socket for the peers not supporting rtcp-mux
+ * @param pool the pool to allocate memory from
+ */
+MPF_DECLARE(mpf_rtp_demux_t*) mpf_rtp_demux_create(const apt_str_t *ip, apr_port_t port, apt_bool_t rtcp, apr_pool_t *pool);
+
+/**
+ * Destroy RTP demultiplexer.
+ * @param demux the demultiplexer to destroy
+ */
+MPF_DECLARE(void) mpf_rtp_demux_destroy(mpf_rtp_demux_t *demux);
+
+/** Get shared RTP socket */
+MPF_DECLARE(apr_socket_t*) mpf_rtp_demux_rtp_socket_get(const mpf_rtp_demux_t *demux);
+
+/** Get local address of shared RTP socket */
+MPF_DECLARE(apr_sockaddr_t*) mpf_rtp_demux_rtp_sockaddr_get(const mpf_rtp_demux_t *demux);
+
+/** Get shared RTCP socket (NULL if not created) */
+MPF_DECLARE(apr_socket_t*) mpf_rtp_demux_rtcp_socket_get(const mpf_rtp_demux_t *demux);
+
+/** Get local address of shared RTCP socket (NULL if not created) */
+MPF_DECLARE(apr_sockaddr_t*) mpf_rtp_demux_rtcp_sockaddr_get(const mpf_rtp_demux_t *demux);
+
+/**
+ * Add or update the route of incoming packets.
+ * @param demux the demultiplexer
+ * @param obj the object to route packets to (the key of the route)
+ * @param handler the packet handler
+ * @param remote_sockaddr the remote RTP address packets are expected from
+ */
+MPF_DECLARE(apt_bool_t) mpf_rtp_demux_route_set(
+							mpf_rtp_demux_t *demux,
+							void *obj,
+							mpf_rtp_demux_handler_f handler,
+							const apr_sockaddr_t *remote_sockaddr);
+
+/**
+ * Remove the route of incoming packets.
+ * @param demux the demultiplexer
+ * @param obj the object the route is registered for
+ */
+MPF_DECLARE(apt_bool_t) mpf_rtp_demux_route_remove(mpf_rtp_demux_t *demux, void *obj);
+
+/**
+ * Drain shared sockets and dispatch packets to the routes.
+ * @param demux the demultiplexer
+ * @return the number of packets dispatched
+ * @remark Can be called by every stream on every tick, the sockets are
+ * drained at most once per half of the frame time.
+ */
+MPF_DECLARE(apr_size_t) mpf_rtp_demux_process(mpf_rtp_demux_t *demux);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_RTP_DEMUX_H */
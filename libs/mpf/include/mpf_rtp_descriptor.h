@@ -27,6 +27,8 @@
 #include <apr_network_io.h>
 #include "apt_string.h"
 #include "mpf_stream_descriptor.h"
+#include "mpf_srtp.h"
+#include "mpf_rtp_socket_pool.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -69,6 +71,10 @@ struct mpf_rtp_media_descriptor_t {
 	apr_size_t             mid;
 	/** Position, order in SDP message (0,1,...) */
 	apr_size_t             id;
+	/** RTCP multiplexed with RTP on the same port (RFC 5761) */
+	apt_bool_t             rtcp_mux;
+	/** SDES crypto attribute of SRTP (RFC 4568), NULL for RTP/AVP */
+	mpf_srtp_crypto_t     *crypto;
 };
 
 /** RTP stream descriptor */
@@ -91,6 +97,10 @@ struct mpf_rtp_termination_descriptor_t {
 	mpf_rtp_stream_descriptor_t video;
 };
 
+/** Value of time skew detection, which compensates the skew by resampling decoded audio
+    by fractions of a sample per frame, instead of dropping and inserting whole frames */
+#define MPF_TIME_SKEW_RESAMPLE 2
+
 /** Jitter buffer configuration */
 struct mpf_jb_config_t {
 	/** Min playout delay in msec */
@@ -101,8 +111,10 @@ struct mpf_jb_config_t {
 	apr_uint32_t max_playout_delay;
 	/** Mode of operation of the jitter buffer: static - 0, adaptive - 1 */
 	apr_byte_t adaptive;
-	/** Enable/disable time skew detection */
+	/** Enable/disable time skew detection, MPF_TIME_SKEW_RESAMPLE compensates the skew by resampling */
 	apr_byte_t time_skew_detection;
+	/** Bypass mode: frames are played out as they arrive, reordered within one packet only */
+	apr_byte_t bypass;
 };
 
 /** RTCP BYE transmission policy */
@@ -122,8 +134,20 @@ struct mpf_rtp_config_t {
 	apr_port_t        rtp_port_min;
 	/** Max RTP port */
 	apr_port_t        rtp_port_max;
-	/** Current RTP port */
-	apr_port_t        rtp_port_cur;
+	/** Time in msec a released RTP port is not reused for */
+	apr_uint32_t      rtp_port_quarantine;
+	/** Allocator of RTP ports from the range */
+	mpf_rtp_port_allocator_t *port_allocator;
+	/** Number of socket pairs created and bound in advance (0 - disabled) */
+	apr_size_t        socket_pool_size;
+	/** Pool of pre-bound socket pairs */
+	mpf_rtp_socket_pool_t *socket_pool;
+	/** Share one RTP port per media worker among all the streams instead of a port pair per stream */
+	apt_bool_t        shared_ports;
+	/** Offer and accept RTCP multiplexed with RTP (RFC 5761) */
+	apt_bool_t        rtcp_mux;
+	/** Crypto suite to offer SRTP with, SRTP is disabled if unknown */
+	mpf_srtp_crypto_suite_e srtp_suite;
 };
 
 /** RTP settings */
@@ -142,8 +166,16 @@ struct mpf_rtp_settings_t {
 	apr_uint16_t      rtcp_tx_interval;
 	/** RTCP rx resolution (timeout to check for a new RTCP message) */
 	apr_uint16_t      rtcp_rx_resolution;
+	/** Append RTCP XR VoIP metrics (RFC 3611) to RTCP reports */
+	apt_bool_t        rtcp_xr;
+	/** Conceal lost packets in the decoder path */
+	apt_bool_t        plc;
 	/** Jitter buffer config */
 	mpf_jb_config_t   jb_config;
+	/** Whether the receivers open with the preceding settings follow these ones at safe points */
+	apt_bool_t        live_update;
+	/** Settings replacing these ones at runtime (NULL if none), set atomically */
+	mpf_rtp_settings_t *successor;
 };
 
 /** Initialize RTP media descriptor */
@@ -158,6 +190,8 @@ static APR_INLINE void mpf_rtp_media_descriptor_init(mpf_rtp_media_descriptor_t
 	mpf_codec_list_reset(&media->codec_list);
 	media->mid = 0;
 	media->id = 0;
+	media->rtcp_mux = FALSE;
+	media->crypto = NULL;
 }
 
 /** Initialize RTP stream descriptor */
@@ -184,6 +218,7 @@ static APR_INLINE void mpf_jb_config_init(mpf_jb_config_t *jb_config)
 	jb_config->min_playout_delay = 0;
 	jb_config->max_playout_delay = 0;
 	jb_config->time_skew_detection = 1;
+	jb_config->bypass = 0;
 }
 
 /** Allocate RTP config */
@@ -192,9 +227,15 @@ static APR_INLINE mpf_rtp_config_t* mpf_rtp_config_alloc(apr_pool_t *pool)
 	mpf_rtp_config_t *rtp_config = (mpf_rtp_config_t*)apr_palloc(pool,sizeof(mpf_rtp_config_t));
 	apt_string_reset(&rtp_config->ip);
 	apt_string_reset(&rtp_config->ext_ip);
-	rtp_config->rtp_port_cur = 0;
 	rtp_config->rtp_port_min = 0;
 	rtp_config->rtp_port_max = 0;
+	rtp_config->rtp_port_quarantine = 2000;
+	rtp_config->port_allocator = NULL;
+	rtp_config->socket_pool_size = 0;
+	rtp_config->socket_pool = NULL;
+	rtp_config->shared_ports = FALSE;
+	rtp_config->rtcp_mux = FALSE;
+	rtp_config->srtp_suite = SRTP_CRYPTO_UNKNOWN;
 	return rtp_config;
 }
 
@@ -209,7 +250,11 @@ static APR_INLINE mpf_rtp_settings_t* mpf_rtp_settings_alloc(apr_pool_t *pool)
 	rtp_settings->rtcp_bye_policy = RTCP_BYE_DISABLE;
 	rtp_settings->rtcp_tx_interval = 0;
 	rtp_settings->rtcp_rx_resolution = 0;
+	rtp_settings->rtcp_xr = FALSE;
+	rtp_settings->plc = FALSE;
 	mpf_jb_config_init(&rtp_settings->jb_config);
+	rtp_settings->live_update = FALSE;
+	rtp_settings->successor = NULL;
 	return rtp_settings;
 }
 
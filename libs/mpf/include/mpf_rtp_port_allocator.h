@@ -0,0 +1,71 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MPF_RTP_PORT_ALLOCATOR_H
+#define MPF_RTP_PORT_ALLOCATOR_H
+
+/**
+ * @file mpf_rtp_port_allocator.h
+ * @brief MPF RTP Port Allocator
+ */ 
+
+#include <apr_network_io.h>
+#include "mpf_types.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Opaque RTP port allocator */
+typedef struct mpf_rtp_port_allocator_t mpf_rtp_port_allocator_t;
+
+/**
+ * Create RTP port allocator.
+ * @param port_min the min RTP port of the range
+ * @param port_max the max RTP port of the range (exclusive)
+ * @param quarantine the time in msec a released port is not reused for
+ * @param pool the pool to allocate memory from
+ * @remark The range is split into even RTP/RTCP port pairs. The allocator is
+ * thread-safe, ports are also allocated by the refill thread of socket pool.
+ */
+MPF_DECLARE(mpf_rtp_port_allocator_t*) mpf_rtp_port_allocator_create(
+											apr_port_t port_min,
+											apr_port_t port_max,
+											apr_uint32_t quarantine,
+											apr_pool_t *pool);
+
+/**
+ * Allocate RTP port.
+ * @param allocator the allocator to allocate from
+ * @return the RTP port (the RTCP one is next to it), 0 if the range is exhausted
+ * @remark The port released earliest is taken. It is taken even if it is still
+ * in quarantine, when all the free ports have been released recently.
+ */
+MPF_DECLARE(apr_port_t) mpf_rtp_port_allocator_allocate(mpf_rtp_port_allocator_t *allocator);
+
+/**
+ * Release RTP port.
+ * @param allocator the allocator the port was allocated from
+ * @param port the RTP port to release
+ */
+MPF_DECLARE(apt_bool_t) mpf_rtp_port_allocator_release(mpf_rtp_port_allocator_t *allocator, apr_port_t port);
+
+/** Get the number of free ports (including the ones in quarantine) */
+MPF_DECLARE(apr_size_t) mpf_rtp_port_allocator_free_count_get(const mpf_rtp_port_allocator_t *allocator);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_RTP_PORT_ALLOCATOR_H */
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MPF_RTP_SOCKET_POOL_H
+#define MPF_RTP_SOCKET_POOL_H
+
+/**
+ * @file mpf_rtp_socket_pool.h
+ * @brief MPF Pool of Pre-bound RTP/RTCP Socket Pairs
+ */ 
+
+#include <apr_network_io.h>
+#include "mpf_types.h"
+#include "mpf_rtp_port_allocator.h"
+#include "apt_string.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Opaque pool of socket pairs */
+typedef struct mpf_rtp_socket_pool_t mpf_rtp_socket_pool_t;
+/** Socket pair declaration */
+typedef struct mpf_rtp_socket_pair_t mpf_rtp_socket_pair_t;
+
+/** RTP/RTCP socket pair bound to a port taken from port allocator */
+struct mpf_rtp_socket_pair_t {
+	/** RTP socket */
+	apr_socket_t          *rtp_socket;
+	/** Local address of RTP socket */
+	apr_sockaddr_t        *rtp_sockaddr;
+	/** RTCP socket (NULL if port+1 could not be bound) */
+	apr_socket_t          *rtcp_socket;
+	/** Local address of RTCP socket */
+	apr_sockaddr_t        *rtcp_sockaddr;
+	/** RTP port */
+	apr_port_t             port;
+
+	/** Pool the sockets are allocated from */
+	apr_pool_t            *pool;
+	/** Next pair in the list */
+	mpf_rtp_socket_pair_t *next;
+};
+
+/**
+ * Create pool of socket pairs.
+ * @param ip the local IP address to bind to
+ * @param port_allocator the allocator to take ports from
+ * @param size the number of pairs kept ready
+ * @param pool the pool to allocate memory from
+ * @remark The socket pairs are created, bound and closed by a background
+ * thread, which is started on the first demand and stopped along with the pool.
+ */
+MPF_DECLARE(mpf_rtp_socket_pool_t*) mpf_rtp_socket_pool_create(
+										const apt_str_t *ip,
+										mpf_rtp_port_allocator_t *port_allocator,
+										apr_size_t size,
+										apr_pool_t *pool);
+
+/**
+ * Get ready socket pair.
+ * @param socket_pool the pool to get from
+ * @return NULL if no pair is ready, then sockets should be created in place
+ */
+MPF_DECLARE(mpf_rtp_socket_pair_t*) mpf_rtp_socket_pool_get(mpf_rtp_socket_pool_t *socket_pool);
+
+/**
+ * Put socket pair back to be closed and its port released in background.
+ * @param socket_pool the pool the pair was taken from
+ * @param pair the pair to put
+ */
+MPF_DECLARE(void) mpf_rtp_socket_pool_put(mpf_rtp_socket_pool_t *socket_pool, mpf_rtp_socket_pair_t *pair);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_RTP_SOCKET_POOL_H */
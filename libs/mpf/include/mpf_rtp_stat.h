@@ -35,6 +35,13 @@ typedef struct rtp_rx_stat_t rtp_rx_stat_t;
 typedef struct rtcp_sr_stat_t rtcp_sr_stat_t;
 /** RTCP statistics used in Receiver Report (RR) */
 typedef struct rtcp_rr_stat_t rtcp_rr_stat_t;
+/** Statistics of loss/discard bursts used in RTCP XR VoIP metrics */
+typedef struct rtcp_xr_burst_stat_t rtcp_xr_burst_stat_t;
+
+/** Snapshot of live statistics of RTP stream */
+typedef struct mpf_rtp_stream_stat_t mpf_rtp_stream_stat_t;
+/** Statistics of RTP streams aggregated per media engine */
+typedef struct mpf_rtp_engine_stat_t mpf_rtp_engine_stat_t;
 
 
 /** RTP receiver statistics */
@@ -90,6 +97,66 @@ struct rtcp_rr_stat_t {
 	apr_uint32_t dlsr;
 };
 
+/** Statistics of loss/discard bursts used in RTCP XR VoIP metrics (RFC 3611 Appendix A.2) */
+struct rtcp_xr_burst_stat_t {
+	/** number of packets received since the last lost or discarded one */
+	apr_uint32_t pkt;
+	/** number of packets lost or discarded within the current burst */
+	apr_uint32_t lost;
+	/** transition counts of the Markov model */
+	apr_uint32_t c11;
+	apr_uint32_t c13;
+	apr_uint32_t c14;
+	apr_uint32_t c22;
+	apr_uint32_t c23;
+	apr_uint32_t c33;
+};
+
+/** Snapshot of live statistics of RTP stream */
+struct mpf_rtp_stream_stat_t {
+	/** local RTP port */
+	apr_uint16_t local_port;
+	/** remote RTP port */
+	apr_uint16_t remote_port;
+	/** source identifier of RTP stream being received */
+	apr_uint32_t rx_ssrc;
+	/** source identifier of RTP stream being sent */
+	apr_uint32_t tx_ssrc;
+	/** receiver statistics (lost packets are calculated at the time of snapshot) */
+	rtp_rx_stat_t rx_stat;
+	/** interarrival jitter (msec) */
+	apr_uint32_t jitter;
+	/** current playout delay (msec) */
+	apr_uint32_t playout_delay;
+	/** packets sent */
+	apr_uint32_t sent_packets;
+	/** octets (bytes) sent */
+	apr_uint32_t sent_octets;
+};
+
+/** Statistics of RTP streams aggregated per media engine */
+struct mpf_rtp_engine_stat_t {
+	/** number of RTP streams */
+	apr_uint32_t stream_count;
+	/** number of valid RTP packets received */
+	apr_uint32_t received_packets;
+	/** number of lost in network packets */
+	apr_uint32_t lost_packets;
+	/** number of discarded in jitter buffer packets */
+	apr_uint32_t discarded_packets;
+	/** number of invalid RTP packets received */
+	apr_uint32_t invalid_packets;
+	/** packets sent */
+	apr_uint32_t sent_packets;
+	/** max interarrival jitter across the streams (msec) */
+	apr_uint32_t max_jitter;
+	/** average interarrival jitter across the streams (msec) */
+	apr_uint32_t avg_jitter;
+	/** max playout delay across the streams (msec) */
+	apr_uint32_t max_playout_delay;
+	/** average playout delay across the streams (msec) */
+	apr_uint32_t avg_playout_delay;
+};
 
 
 /** Reset RTCP SR statistics */
@@ -104,6 +171,12 @@ static APR_INLINE void mpf_rtcp_rr_stat_reset(rtcp_rr_stat_t *rr_stat)
 	memset(rr_stat,0,sizeof(rtcp_rr_stat_t));
 }
 
+/** Reset RTCP XR burst statistics */
+static APR_INLINE void mpf_rtcp_xr_burst_stat_reset(rtcp_xr_burst_stat_t *burst_stat)
+{
+	memset(burst_stat,0,sizeof(rtcp_xr_burst_stat_t));
+}
+
 /** Reset RTP receiver statistics */
 static APR_INLINE void mpf_rtp_rx_stat_reset(rtp_rx_stat_t *rx_stat)
 {
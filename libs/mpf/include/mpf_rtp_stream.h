@@ -26,6 +26,7 @@
 
 #include "mpf_stream.h"
 #include "mpf_rtp_descriptor.h"
+#include "mpf_rtp_demux.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -38,6 +39,14 @@ APT_BEGIN_EXTERN_C
  */
 MPF_DECLARE(mpf_audio_stream_t*) mpf_rtp_stream_create(mpf_termination_t *termination, mpf_rtp_config_t *config, mpf_rtp_settings_t *settings, apr_pool_t *pool);
 
+/**
+ * Use the sockets of RTP demultiplexer instead of allocating a port pair.
+ * @param stream RTP stream to set demultiplexer for
+ * @param demux the demultiplexer shared by the streams of the media worker
+ * @remark Should be called before the local media is created.
+ */
+MPF_DECLARE(apt_bool_t) mpf_rtp_stream_demux_set(mpf_audio_stream_t *stream, mpf_rtp_demux_t *demux);
+
 /**
  * Add/enable RTP stream.
  * @param stream RTP stream to add
@@ -25,9 +25,17 @@
  */ 
 
 #include "mpf_types.h"
+#include "apt_cpu_set.h"
 
 APT_BEGIN_EXTERN_C
 
+/** Enumeration of scheduler clock sources */
+typedef enum {
+	MPF_SCHEDULER_CLOCK_DEFAULT,   /**< default clock (multimedia timers on Windows, apr_sleep() with drift compensation elsewhere) */
+	MPF_SCHEDULER_CLOCK_MONOTONIC, /**< absolute deadlines on CLOCK_MONOTONIC via clock_nanosleep() (POSIX only) */
+	MPF_SCHEDULER_CLOCK_FREEWHEEL  /**< no sleeping, media clock runs as fast as processing permits (offline use, not on Windows) */
+} mpf_scheduler_clock_e;
+
 /** Prototype of scheduler callback */
 typedef void (*mpf_scheduler_proc_f)(mpf_scheduler_t *scheduler, void *obj);
 
@@ -56,6 +64,47 @@ MPF_DECLARE(apt_bool_t) mpf_scheduler_rate_set(
 								mpf_scheduler_t *scheduler,
 								unsigned long rate);
 
+/**
+ * Set clock source the scheduler is driven by.
+ * @param scheduler the scheduler to set clock source for
+ * @param clock the clock source to set
+ * @remark Should be set before the scheduler is started.
+ */
+MPF_DECLARE(apt_bool_t) mpf_scheduler_clock_source_set(
+								mpf_scheduler_t *scheduler,
+								mpf_scheduler_clock_e clock);
+
+/**
+ * Set real-time (SCHED_FIFO) priority of the scheduler thread.
+ * @param scheduler the scheduler to set priority for
+ * @param priority the priority to set (0 - use the default policy)
+ * @remark Should be set before the scheduler is started.
+ */
+MPF_DECLARE(apt_bool_t) mpf_scheduler_thread_priority_set(
+								mpf_scheduler_t *scheduler,
+								int priority);
+
+/**
+ * Bind the scheduler thread to the specified CPU.
+ * @param scheduler the scheduler to set CPU affinity for
+ * @param cpu the CPU to bind thread to (-1 - no binding)
+ * @remark Should be set before the scheduler is started.
+ */
+MPF_DECLARE(apt_bool_t) mpf_scheduler_thread_affinity_set(
+								mpf_scheduler_t *scheduler,
+								int cpu);
+
+/**
+ * Bind the scheduler thread to the set of CPUs (e.g. of a NUMA node).
+ * @param scheduler the scheduler to set CPU affinity for
+ * @param cpu_set the set of CPUs to bind thread to (NULL - no binding)
+ * @remark Should be set before the scheduler is started. The CPU set by
+ *         mpf_scheduler_thread_affinity_set(), if any, takes precedence.
+ */
+MPF_DECLARE(apt_bool_t) mpf_scheduler_thread_cpu_set_set(
+								mpf_scheduler_t *scheduler,
+								const apt_cpu_set_t *cpu_set);
+
 /** Start scheduler */
 MPF_DECLARE(apt_bool_t) mpf_scheduler_start(mpf_scheduler_t *scheduler);
 
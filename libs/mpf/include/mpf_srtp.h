@@ -0,0 +1,140 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MPF_SRTP_H
+#define MPF_SRTP_H
+
+/**
+ * @file mpf_srtp.h
+ * @brief MPF SRTP/SRTCP Protection (SDES Keyed)
+ */
+
+#include "mpf_types.h"
+#include "apt_string.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Max size of master key and salt (AES-256 key + 112-bit salt) */
+#define MPF_SRTP_MAX_KEY_SIZE     46
+/** Max size of data appended to an RTP/RTCP packet by protection (SRTCP index + GCM tag) */
+#define MPF_SRTP_MAX_TRAILER_SIZE 20
+
+/** SRTP crypto suites (RFC 4568, RFC 6188, RFC 7714) */
+typedef enum {
+	SRTP_CRYPTO_AES_CM_128_HMAC_SHA1_80,
+	SRTP_CRYPTO_AES_CM_128_HMAC_SHA1_32,
+	SRTP_CRYPTO_AES_256_CM_HMAC_SHA1_80,
+	SRTP_CRYPTO_AEAD_AES_128_GCM,
+	SRTP_CRYPTO_AEAD_AES_256_GCM,
+
+	SRTP_CRYPTO_COUNT,
+	SRTP_CRYPTO_UNKNOWN = SRTP_CRYPTO_COUNT
+} mpf_srtp_crypto_suite_e;
+
+/** Crypto attribute declaration */
+typedef struct mpf_srtp_crypto_t mpf_srtp_crypto_t;
+/** Opaque SRTP session */
+typedef struct mpf_srtp_t mpf_srtp_t;
+
+/** Crypto attribute (a=crypto) */
+struct mpf_srtp_crypto_t {
+	/** Tag of the attribute */
+	apr_size_t              tag;
+	/** Crypto suite */
+	mpf_srtp_crypto_suite_e suite;
+	/** Master key followed by master salt */
+	apr_byte_t              key[MPF_SRTP_MAX_KEY_SIZE];
+	/** Size of master key and salt */
+	apr_size_t              key_size;
+};
+
+/**
+ * Initialize SRTP library, should be called once before any session is created.
+ */
+MPF_DECLARE(apt_bool_t) mpf_srtp_init(void);
+
+/**
+ * Check whether SRTP is compiled in (configure --enable-srtp).
+ */
+MPF_DECLARE(apt_bool_t) mpf_srtp_is_available(void);
+
+/** Get crypto suite name by identifier */
+MPF_DECLARE(const apt_str_t*) mpf_srtp_crypto_suite_str_get(mpf_srtp_crypto_suite_e suite);
+
+/** Find crypto suite identifier by name */
+MPF_DECLARE(mpf_srtp_crypto_suite_e) mpf_srtp_crypto_suite_find(const apt_str_t *name);
+
+/** Check whether crypto suite is supported by the underlying SRTP library */
+MPF_DECLARE(apt_bool_t) mpf_srtp_crypto_suite_supported(mpf_srtp_crypto_suite_e suite);
+
+/**
+ * Create crypto attribute with a random master key.
+ * @param suite the crypto suite
+ * @param tag the tag of the attribute
+ * @param pool the pool to allocate memory from
+ */
+MPF_DECLARE(mpf_srtp_crypto_t*) mpf_srtp_crypto_create(mpf_srtp_crypto_suite_e suite, apr_size_t tag, apr_pool_t *pool);
+
+/**
+ * Parse the value of crypto attribute.
+ * @param value the value of a=crypto ("tag suite inline:key[|lifetime]")
+ * @param pool the pool to allocate memory from
+ * @return NULL if the attribute is malformed or uses unsupported parameters
+ */
+MPF_DECLARE(mpf_srtp_crypto_t*) mpf_srtp_crypto_parse(const char *value, apr_pool_t *pool);
+
+/**
+ * Generate the value of crypto attribute.
+ * @param crypto the crypto attribute
+ * @param buffer the buffer to generate the value into
+ * @param size the size of the buffer
+ */
+MPF_DECLARE(apr_size_t) mpf_srtp_crypto_generate(const mpf_srtp_crypto_t *crypto, char *buffer, apr_size_t size);
+
+/**
+ * Create SRTP session.
+ * @param tx_crypto the local crypto attribute used to protect outbound packets
+ * @param rx_crypto the remote crypto attribute used to unprotect inbound packets
+ * @param pool the pool to allocate memory from
+ */
+MPF_DECLARE(mpf_srtp_t*) mpf_srtp_create(const mpf_srtp_crypto_t *tx_crypto, const mpf_srtp_crypto_t *rx_crypto, apr_pool_t *pool);
+
+/** Destroy SRTP session */
+MPF_DECLARE(void) mpf_srtp_destroy(mpf_srtp_t *srtp);
+
+/**
+ * Protect RTP packet in place.
+ * @param srtp the SRTP session
+ * @param packet the packet to encrypt and authenticate
+ * @param size the size of the packet in and out
+ * @remark The buffer should have MPF_SRTP_MAX_TRAILER_SIZE bytes of room past the packet.
+ */
+MPF_DECLARE(apt_bool_t) mpf_srtp_protect(mpf_srtp_t *srtp, void *packet, apr_size_t *size);
+
+/** Unprotect (authenticate and decrypt) SRTP packet in place */
+MPF_DECLARE(apt_bool_t) mpf_srtp_unprotect(mpf_srtp_t *srtp, void *packet, apr_size_t *size);
+
+/** Protect compound RTCP packet in place, see mpf_srtp_protect() */
+MPF_DECLARE(apt_bool_t) mpf_srtcp_protect(mpf_srtp_t *srtp, void *packet, apr_size_t *size);
+
+/** Unprotect compound SRTCP packet in place */
+MPF_DECLARE(apt_bool_t) mpf_srtcp_unprotect(mpf_srtp_t *srtp, void *packet, apr_size_t *size);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_SRTP_H */
@@ -24,6 +24,7 @@
  * @brief MPF Bidirectional Stream
  */ 
 
+#include <apr_atomic.h>
 #include "mpf_types.h"
 #include "mpf_frame.h"
 #include "mpf_stream_descriptor.h"
@@ -53,10 +54,26 @@ struct mpf_audio_stream_t {
 	mpf_codec_descriptor_t          *rx_descriptor;
 	/** Rx event descriptor */
 	mpf_codec_descriptor_t          *rx_event_descriptor;
+	/** Rx comfort noise descriptor */
+	mpf_codec_descriptor_t          *rx_cn_descriptor;
 	/** Tx codec descriptor */
 	mpf_codec_descriptor_t          *tx_descriptor;
 	/** Tx event descriptor */
 	mpf_codec_descriptor_t          *tx_event_descriptor;
+	/** Tx comfort noise descriptor */
+	mpf_codec_descriptor_t          *tx_cn_descriptor;
+	/** Non-zero while the transmitter (sink) is not consuming frames (see mpf_audio_stream_tx_active_set()) */
+	volatile apr_uint32_t            tx_inactive;
+	/** Whether the receiver (source) writes named events to rx_event_sink on arrival */
+	apt_bool_t                       rx_event_direct;
+	/** Sink the named events are written to on arrival, ahead of playout (set by bridge, NULL if none) */
+	mpf_audio_stream_t              *rx_event_sink;
+	/** Whether the receiver (source) reports rx_skew to be compensated by resampling */
+	apt_bool_t                       rx_skew_compensation;
+	/** Audio buffered by the receiver (source) in excess of its playout delay (usec) */
+	apr_int32_t                      rx_skew;
+	/** Whether the stream is carried over the network (RTP), processed ahead of local streams */
+	apt_bool_t                       network;
 };
 
 /** Video stream */
@@ -88,6 +105,14 @@ struct mpf_audio_stream_vtable_t {
 
 	/** Virtual trace method */
 	void (*trace)(mpf_audio_stream_t *stream, mpf_stream_direction_e direction, apt_text_stream_t *output);
+
+	/** Virtual write event method (optional), named events are written on arrival
+	    with no playout delay and no longer come with the frames then */
+	apt_bool_t (*write_event)(mpf_audio_stream_t *stream, const mpf_frame_t *frame);
+
+	/** Virtual receive method (optional), takes the pending packets into
+	    the jitter buffer with no frame read, while the reading is deferred */
+	apt_bool_t (*receive)(mpf_audio_stream_t *stream);
 };
 
 /** Create audio stream */
@@ -115,6 +140,14 @@ static APR_INLINE apt_bool_t mpf_audio_stream_destroy(mpf_audio_stream_t *stream
 	return TRUE;
 }
 
+/** Take the pending packets of audio stream receiver with no frame read */
+static APR_INLINE apt_bool_t mpf_audio_stream_receive(mpf_audio_stream_t *stream)
+{
+	if(stream->vtable->receive)
+		return stream->vtable->receive(stream);
+	return TRUE;
+}
+
 /** Open audio stream receiver */
 static APR_INLINE apt_bool_t mpf_audio_stream_rx_open(mpf_audio_stream_t *stream, mpf_codec_t *codec)
 {
@@ -163,6 +196,25 @@ static APR_INLINE apt_bool_t mpf_audio_stream_frame_write(mpf_audio_stream_t *st
 	return TRUE;
 }
 
+/**
+ * Set whether the transmitter (sink) consumes frames.
+ * @param stream the sink stream
+ * @param active FALSE, while frames are neither needed nor looked at (e.g. a recognizer
+ *               between requests), so that the bridge skips decoding and other DSP for it
+ * @remark May be called from any thread. An inactive sink is still written a frame every tick,
+ *         of type MEDIA_FRAME_TYPE_NONE (or MEDIA_FRAME_TYPE_EVENT), with no samples.
+ */
+static APR_INLINE void mpf_audio_stream_tx_active_set(mpf_audio_stream_t *stream, apt_bool_t active)
+{
+	apr_atomic_set32(&stream->tx_inactive,active == TRUE ? 0 : 1);
+}
+
+/** Check whether the transmitter (sink) consumes frames */
+static APR_INLINE apt_bool_t mpf_audio_stream_tx_is_active(mpf_audio_stream_t *stream)
+{
+	return apr_atomic_read32(&stream->tx_inactive) ? FALSE : TRUE;
+}
+
 /** Trace media path */
 MPF_DECLARE(void) mpf_audio_stream_trace(mpf_audio_stream_t *stream, mpf_stream_direction_e direction, apt_text_stream_t *output);
 
@@ -26,6 +26,7 @@
 
 #include "mpf_types.h"
 #include "apt_timer_queue.h"
+#include "mpf_tx_batch.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -65,6 +66,18 @@ struct mpf_termination_t {
 	const mpf_codec_manager_t      *codec_manager;
 	/** Timer queue */
 	apt_timer_queue_t              *timer_queue;
+	/** Batch of outgoing datagrams flushed at the end of the media tick */
+	mpf_tx_batch_t                 *tx_batch;
+	/** io_uring instance of media worker (NULL if not enabled) */
+	mpf_uring_t                    *uring;
+	/** Slab of jitter buffer frames of media worker */
+	struct mpf_jb_slab_t           *jb_slab;
+	/** Agent RTCP is offloaded to (NULL if processed on the media tick) */
+	struct mpf_rtcp_agent_t        *rtcp_agent;
+	/** Index of media worker the termination is processed by */
+	apr_size_t                      worker_id;
+	/** Overload level of media worker (NULL if not assigned) */
+	const mpf_overload_level_e     *overload_level;
 	/** Termination factory entire termination created by */
 	mpf_termination_factory_t      *termination_factory;
 	/** Table of virtual methods */
@@ -78,6 +91,14 @@ struct mpf_termination_t {
 	mpf_video_stream_t             *video_stream;
 };
 
+/** Get overload level of media worker the termination is processed by */
+static APR_INLINE mpf_overload_level_e mpf_termination_overload_level_get(const mpf_termination_t *termination)
+{
+	if(!termination || !termination->overload_level)
+		return MPF_OVERLOAD_NONE;
+	return *termination->overload_level;
+}
+
 /**
  * Create MPF termination base.
  * @param termination_factory the termination factory
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+#ifndef MPF_TX_BATCH_H
+#define MPF_TX_BATCH_H
+
+/**
+ * @file mpf_tx_batch.h
+ * @brief MPF Batch of Outgoing Datagrams
+ */ 
+
+#include <apr_network_io.h>
+#include "mpf_types.h"
+#include "mpf_uring.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Max size of datagram which can be queued */
+#define MPF_TX_BATCH_PACKET_SIZE 1500
+/** Default number of datagrams queued before the batch is flushed */
+#define MPF_TX_BATCH_DEFAULT_SIZE 64
+
+/** Opaque batch of outgoing datagrams */
+typedef struct mpf_tx_batch_t mpf_tx_batch_t;
+
+/**
+ * Create batch of outgoing datagrams.
+ * @param max_count the max number of datagrams queued before the batch is flushed
+ * @param pool the pool to allocate memory from
+ */
+MPF_DECLARE(mpf_tx_batch_t*) mpf_tx_batch_create(apr_size_t max_count, apr_pool_t *pool);
+
+/**
+ * Destroy batch of outgoing datagrams.
+ * @param batch the batch to destroy
+ */
+MPF_DECLARE(void) mpf_tx_batch_destroy(mpf_tx_batch_t *batch);
+
+/**
+ * Send the batch through io_uring instead of sendmmsg()/sendto().
+ * @param batch the batch to set io_uring instance for
+ * @param uring the io_uring instance (NULL to use the default backend)
+ */
+MPF_DECLARE(void) mpf_tx_batch_uring_set(mpf_tx_batch_t *batch, mpf_uring_t *uring);
+
+/**
+ * Queue datagram to be sent on the next flush.
+ * @param batch the batch to queue datagram to
+ * @param socket the socket to send datagram on
+ * @param sockaddr the destination address
+ * @param data the datagram to send (copied)
+ * @param size the size of datagram
+ * @remark The batch is flushed in place if it is full.
+ */
+MPF_DECLARE(apt_bool_t) mpf_tx_batch_add(
+							mpf_tx_batch_t *batch,
+							apr_socket_t *socket,
+							apr_sockaddr_t *sockaddr,
+							const void *data,
+							apr_size_t size);
+
+/**
+ * Send all the queued datagrams.
+ * @param batch the batch to flush
+ * @return the number of datagrams failed to send
+ */
+MPF_DECLARE(apr_size_t) mpf_tx_batch_flush(mpf_tx_batch_t *batch);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_TX_BATCH_H */
@@ -55,6 +55,13 @@ typedef struct mpf_audio_stream_t mpf_audio_stream_t;
 /** Opaque MPF video stream declaration */
 typedef struct mpf_video_stream_t mpf_video_stream_t;
 
+/** Overload levels of media worker, optional work is reduced at */
+typedef enum {
+	MPF_OVERLOAD_NONE,     /**< ticks complete within the deadline */
+	MPF_OVERLOAD_ELEVATED, /**< ticks run close to the deadline: RTCP is suspended */
+	MPF_OVERLOAD_SEVERE    /**< ticks keep missing the deadline: in-band DTMF detection is suspended too */
+} mpf_overload_level_e;
+
 
 APT_END_EXTERN_C
 
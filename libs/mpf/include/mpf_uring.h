@@ -0,0 +1,118 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+#ifndef MPF_URING_H
+#define MPF_URING_H
+
+/**
+ * @file mpf_uring.h
+ * @brief MPF io_uring Backend of RTP Socket I/O
+ */ 
+
+#include <apr_network_io.h>
+#include "mpf_types.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Default number of submission queue entries */
+#define MPF_URING_DEFAULT_DEPTH 1024
+
+/** Opaque io_uring instance */
+typedef struct mpf_uring_t mpf_uring_t;
+
+/**
+ * Prototype of datagram handler.
+ * @param obj the object the socket is registered for
+ * @param buffer the received datagram
+ * @param size the size of datagram
+ */
+typedef void (*mpf_uring_recv_handler_f)(void *obj, char *buffer, apr_size_t size);
+
+/**
+ * Check whether the backend is compiled in (configure --enable-io-uring).
+ */
+MPF_DECLARE(apt_bool_t) mpf_uring_is_available(void);
+
+/**
+ * Create io_uring instance.
+ * @param depth the number of submission queue entries
+ * @param pool the pool to allocate memory from
+ * @return NULL if the backend is not available at build or run time
+ */
+MPF_DECLARE(mpf_uring_t*) mpf_uring_create(apr_size_t depth, apr_pool_t *pool);
+
+/**
+ * Destroy io_uring instance.
+ * @param uring the instance to destroy
+ */
+MPF_DECLARE(void) mpf_uring_destroy(mpf_uring_t *uring);
+
+/**
+ * Arm multishot receive on the socket.
+ * @param uring the io_uring instance
+ * @param socket the socket to receive datagrams from
+ * @param handler the datagram handler
+ * @param obj the object to pass to the handler (the key of registration)
+ */
+MPF_DECLARE(apt_bool_t) mpf_uring_recv_register(
+							mpf_uring_t *uring,
+							apr_socket_t *socket,
+							mpf_uring_recv_handler_f handler,
+							void *obj);
+
+/**
+ * Cancel multishot receive, the handler is not called afterwards.
+ * @param uring the io_uring instance
+ * @param obj the object the socket is registered for
+ * @remark Should be called before the socket is closed.
+ */
+MPF_DECLARE(apt_bool_t) mpf_uring_recv_unregister(mpf_uring_t *uring, void *obj);
+
+/**
+ * Queue datagram to send.
+ * @param uring the io_uring instance
+ * @param socket the socket to send datagram on
+ * @param sockaddr the destination address
+ * @param data the datagram to send (should remain valid until flushed)
+ * @param size the size of datagram
+ */
+MPF_DECLARE(apt_bool_t) mpf_uring_send(
+							mpf_uring_t *uring,
+							apr_socket_t *socket,
+							apr_sockaddr_t *sockaddr,
+							const void *data,
+							apr_size_t size);
+
+/**
+ * Submit queued datagrams and wait for them to complete.
+ * @param uring the io_uring instance
+ * @return the number of datagrams failed to send
+ */
+MPF_DECLARE(apr_size_t) mpf_uring_send_flush(mpf_uring_t *uring);
+
+/**
+ * Submit pending requests and dispatch received datagrams.
+ * @param uring the io_uring instance
+ * @return the number of datagrams dispatched
+ * @remark No syscall is made if there is nothing to submit.
+ */
+MPF_DECLARE(apr_size_t) mpf_uring_process(mpf_uring_t *uring);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_URING_H */
@@ -19,6 +19,23 @@
 #include "mpf_activity_detector.h"
 #include "apt_log.h"
 
+/** Energy (mean square) of the lowest noise floor, amplitude 16 */
+#define ENERGY_NOISE_FLOOR_MIN     256.f
+/** Energy of the initial noise floor, amplitude 100 */
+#define ENERGY_NOISE_FLOOR_INIT    10000.f
+/** Energy ratio to noise floor of voice frames (9 dB) */
+#define ENERGY_VOICE_RATIO         8.f
+/** Energy ratio to noise floor of voice frames regardless of zero-crossing rate (18 dB) */
+#define ENERGY_STRONG_VOICE_RATIO  64.f
+/** Max zero-crossing rate of voice frames of moderate energy */
+#define ENERGY_VOICE_ZCR_MAX       0.35f
+/** Adaptation step of noise floor going down (fast) */
+#define ENERGY_FLOOR_FALL_STEP     0.25f
+/** Adaptation step of noise floor tracking noise frames */
+#define ENERGY_FLOOR_TRACK_STEP    0.05f
+/** Creep factor of noise floor during voice, recovers from a raised noise level (~1.3 dB/s) */
+#define ENERGY_FLOOR_CREEP         1.003f
+
 /** Detector states */
 typedef enum {
 	DETECTOR_STATE_INACTIVITY,           /**< inactivity detected */
@@ -43,6 +60,21 @@ struct mpf_activity_detector_t {
 	mpf_detector_state_e state;
 	/* duration spent in current state  */
 	apr_size_t           duration;
+
+	/* optional classifier, level threshold is used if not set */
+	mpf_activity_classifier_t *classifier;
+};
+
+/** Energy classifier */
+typedef struct mpf_energy_classifier_t mpf_energy_classifier_t;
+
+struct mpf_energy_classifier_t {
+	/* base */
+	mpf_activity_classifier_t base;
+	/* adaptive noise floor (mean square) */
+	float                     noise_floor;
+	/* whether the noise floor is initialized */
+	apt_bool_t                initialized;
 };
 
 /** Create activity detector */
@@ -55,6 +87,7 @@ MPF_DECLARE(mpf_activity_detector_t*) mpf_activity_detector_create(apr_pool_t *p
 	detector->noinput_timeout = 5000; /* 5 s */
 	detector->duration = 0;
 	detector->state = DETECTOR_STATE_INACTIVITY;
+	detector->classifier = NULL;
 	return detector;
 }
 
@@ -63,6 +96,15 @@ MPF_DECLARE(void) mpf_activity_detector_reset(mpf_activity_detector_t *detector)
 {
 	detector->duration = 0;
 	detector->state = DETECTOR_STATE_INACTIVITY;
+	if(detector->classifier && detector->classifier->vtable->reset) {
+		detector->classifier->vtable->reset(detector->classifier);
+	}
+}
+
+/** Set activity classifier */
+MPF_DECLARE(void) mpf_activity_detector_classifier_set(mpf_activity_detector_t *detector, mpf_activity_classifier_t *classifier)
+{
+	detector->classifier = classifier;
 }
 
 /** Set threshold of voice activity (silence) level */
@@ -89,6 +131,12 @@ MPF_DECLARE(void) mpf_activity_detector_silence_timeout_set(mpf_activity_detecto
 	detector->silence_timeout = silence_timeout;
 }
 
+/** Get timeout required to trigger silence (transition from active to inactive state) */
+MPF_DECLARE(apr_size_t) mpf_activity_detector_silence_timeout_get(const mpf_activity_detector_t *detector)
+{
+	return detector->silence_timeout;
+}
+
 
 static APR_INLINE void mpf_activity_detector_state_change(mpf_activity_detector_t *detector, mpf_detector_state_e state)
 {
@@ -96,40 +144,131 @@ static APR_INLINE void mpf_activity_detector_state_change(mpf_activity_detector_
 	detector->state = state;
 }
 
-static apr_size_t mpf_activity_detector_level_calculate(const mpf_frame_t *frame)
+static void mpf_energy_classifier_reset(mpf_activity_classifier_t *classifier)
 {
-	apr_size_t sum = 0;
-	apr_size_t count = frame->codec_frame.size/2;
-	const apr_int16_t *cur = frame->codec_frame.buffer;
-	const apr_int16_t *end = cur + count;
+	mpf_energy_classifier_t *energy_classifier = classifier->obj;
+	energy_classifier->noise_floor = ENERGY_NOISE_FLOOR_INIT;
+	energy_classifier->initialized = FALSE;
+}
 
-	for(; cur < end; cur++) {
-		if(*cur < 0) {
-			sum -= *cur;
-		}
-		else {
-			sum += *cur;
+static apt_bool_t mpf_energy_classifier_features_classify(mpf_activity_classifier_t *classifier, const mpf_frame_features_t *features)
+{
+	mpf_energy_classifier_t *energy_classifier = classifier->obj;
+	float energy;
+	float zcr;
+	float floor;
+	apt_bool_t voice = FALSE;
+
+	if(!features->count) {
+		return FALSE;
+	}
+	energy = (float)features->energy / features->count;
+	zcr = (float)features->crossings / features->count;
+
+	if(energy_classifier->initialized == FALSE) {
+		/* start from the first frame, unless it is louder than the initial floor */
+		if(energy < energy_classifier->noise_floor) {
+			energy_classifier->noise_floor = energy;
 		}
+		energy_classifier->initialized = TRUE;
 	}
 
-	return sum / count;
+	floor = energy_classifier->noise_floor;
+	if(floor < ENERGY_NOISE_FLOOR_MIN) {
+		floor = ENERGY_NOISE_FLOOR_MIN;
+	}
+	if(energy >= floor * ENERGY_STRONG_VOICE_RATIO) {
+		voice = TRUE;
+	}
+	else if(energy >= floor * ENERGY_VOICE_RATIO && zcr <= ENERGY_VOICE_ZCR_MAX) {
+		voice = TRUE;
+	}
+
+	if(energy < energy_classifier->noise_floor) {
+		energy_classifier->noise_floor += ENERGY_FLOOR_FALL_STEP * (energy - energy_classifier->noise_floor);
+	}
+	else if(voice == FALSE) {
+		energy_classifier->noise_floor += ENERGY_FLOOR_TRACK_STEP * (energy - energy_classifier->noise_floor);
+	}
+	else {
+		energy_classifier->noise_floor *= ENERGY_FLOOR_CREEP;
+	}
+#if 0
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Energy Classifier [%.0f/%.0f zcr %.2f] %d",energy,floor,zcr,voice);
+#endif
+	return voice;
+}
+
+static apt_bool_t mpf_energy_classifier_classify(mpf_activity_classifier_t *classifier, const mpf_frame_t *frame)
+{
+	mpf_frame_features_t features;
+	mpf_frame_features_calculate(&features,frame);
+	return mpf_energy_classifier_features_classify(classifier,&features);
+}
+
+static const mpf_activity_classifier_vtable_t energy_classifier_vtable = {
+	mpf_energy_classifier_reset,
+	mpf_energy_classifier_classify,
+	mpf_energy_classifier_features_classify
+};
+
+/** Create built-in energy classifier */
+MPF_DECLARE(mpf_activity_classifier_t*) mpf_energy_classifier_create(apr_pool_t *pool)
+{
+	mpf_energy_classifier_t *energy_classifier = apr_palloc(pool,sizeof(mpf_energy_classifier_t));
+	energy_classifier->base.obj = energy_classifier;
+	energy_classifier->base.vtable = &energy_classifier_vtable;
+	mpf_energy_classifier_reset(&energy_classifier->base);
+	return &energy_classifier->base;
+}
+
+/** Create built-in activity classifier by name */
+MPF_DECLARE(mpf_activity_classifier_t*) mpf_activity_classifier_create(const char *name, apr_pool_t *pool)
+{
+	if(name && strcasecmp(name,"energy") == 0) {
+		return mpf_energy_classifier_create(pool);
+	}
+	return NULL;
 }
 
 /** Process current frame */
 MPF_DECLARE(mpf_detector_event_e) mpf_activity_detector_process(mpf_activity_detector_t *detector, const mpf_frame_t *frame)
+{
+	return mpf_activity_detector_features_process(detector,frame,NULL);
+}
+
+/** Process current frame, the features of which are already calculated */
+MPF_DECLARE(mpf_detector_event_e) mpf_activity_detector_features_process(mpf_activity_detector_t *detector, const mpf_frame_t *frame, const mpf_frame_features_t *features)
 {
 	mpf_detector_event_e det_event = MPF_DETECTOR_EVENT_NONE;
-	apr_size_t level = 0;
+	apt_bool_t active = FALSE;
 	if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO) {
-		/* first, calculate current activity level of processed frame */
-		level = mpf_activity_detector_level_calculate(frame);
+		mpf_frame_features_t frame_features;
+		mpf_activity_classifier_t *classifier = detector->classifier;
+		if(classifier && (!features || !classifier->vtable->classify_features)) {
+			active = classifier->vtable->classify(classifier,frame);
+		}
+		else {
+			if(!features) {
+				mpf_frame_features_calculate(&frame_features,frame);
+				features = &frame_features;
+			}
+			if(classifier) {
+				active = classifier->vtable->classify_features(classifier,features);
+			}
+			else {
+				/* first, calculate current activity level of processed frame */
+				apr_size_t level = mpf_frame_features_level_get(features);
 #if 0
-		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Activity Detector [%"APR_SIZE_T_FMT"]",level);
+				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Activity Detector [%"APR_SIZE_T_FMT"]",level);
 #endif
+				active = level >= detector->level_threshold ? TRUE : FALSE;
+			}
+		}
 	}
 
 	if(detector->state == DETECTOR_STATE_INACTIVITY) {
-		if(level >= detector->level_threshold) {
+		if(active == TRUE) {
 			/* start to detect activity */
 			mpf_activity_detector_state_change(detector,DETECTOR_STATE_ACTIVITY_TRANSITION);
 		}
@@ -142,7 +281,7 @@ MPF_DECLARE(mpf_detector_event_e) mpf_activity_detector_process(mpf_activity_det
 		}
 	}
 	else if(detector->state == DETECTOR_STATE_ACTIVITY_TRANSITION) {
-		if(level >= detector->level_threshold) {
+		if(active == TRUE) {
 			detector->duration += CODEC_FRAME_TIME_BASE;
 			if(detector->duration >= detector->speech_timeout) {
 				/* finally detected activity */
@@ -156,7 +295,7 @@ MPF_DECLARE(mpf_detector_event_e) mpf_activity_detector_process(mpf_activity_det
 		}
 	}
 	else if(detector->state == DETECTOR_STATE_ACTIVITY) {
-		if(level >= detector->level_threshold) {
+		if(active == TRUE) {
 			detector->duration += CODEC_FRAME_TIME_BASE;
 		}
 		else {
@@ -165,7 +304,7 @@ MPF_DECLARE(mpf_detector_event_e) mpf_activity_detector_process(mpf_activity_det
 		}
 	}
 	else if(detector->state == DETECTOR_STATE_INACTIVITY_TRANSITION) {
-		if(level >= detector->level_threshold) {
+		if(active == TRUE) {
 			/* fallback to activity */
 			mpf_activity_detector_state_change(detector,DETECTOR_STATE_ACTIVITY);
 		}
@@ -0,0 +1,604 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <apr_time.h>
+#include "mpf_audio_file_encoder.h"
+#include "mpf_g711_kernel.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+
+#ifdef MPF_HAVE_OPUS
+#include <opus/opus.h>
+#endif
+
+/** Number of samples converted at once */
+#define MPF_ENCODER_CHUNK_SAMPLES 1024
+/** Max size of RIFF/WAVE header (with fmt extension and fact chunk) */
+#define WAV_HEADER_SIZE_MAX       58
+
+/** Names of audio file formats */
+static const char *format_names[MPF_AUDIO_FILE_FORMAT_COUNT] = {
+	"pcm",
+	"wav",
+	"ulaw",
+	"opus"
+};
+
+/** File name extensions of audio file formats */
+static const char *format_exts[MPF_AUDIO_FILE_FORMAT_COUNT] = {
+	"pcm",
+	"wav",
+	"wav",
+	"opus"
+};
+
+/** Media types of audio file formats */
+static const struct {
+	const char             *media_type;
+	mpf_audio_file_format_e format;
+} format_media_types[] = {
+	{"audio/L16",   MPF_AUDIO_FILE_FORMAT_PCM},
+	{"audio/wav",   MPF_AUDIO_FILE_FORMAT_WAV},
+	{"audio/wave",  MPF_AUDIO_FILE_FORMAT_WAV},
+	{"audio/x-wav", MPF_AUDIO_FILE_FORMAT_WAV},
+	{"audio/basic", MPF_AUDIO_FILE_FORMAT_ULAW},
+	{"audio/PCMU",  MPF_AUDIO_FILE_FORMAT_ULAW},
+	{"audio/ogg",   MPF_AUDIO_FILE_FORMAT_OPUS},
+	{"audio/opus",  MPF_AUDIO_FILE_FORMAT_OPUS}
+};
+
+#ifdef MPF_HAVE_OPUS
+typedef struct mpf_ogg_opus_t mpf_ogg_opus_t;
+#endif
+
+/** Audio file encoder */
+typedef struct mpf_audio_file_encoder_t mpf_audio_file_encoder_t;
+
+struct mpf_audio_file_encoder_t {
+	/** Base encoder */
+	apt_file_encoder_t       base;
+	/** Pool the encoder is allocated from */
+	apr_pool_t              *pool;
+	/** Format to encode to */
+	mpf_audio_file_format_e  format;
+	/** Sampling rate */
+	apr_uint16_t             sampling_rate;
+	/** Size of encoded data written */
+	apr_uint32_t             data_size;
+	/** Number of samples encoded */
+	apr_uint32_t             sample_count;
+	/** Buffer of converted samples */
+	apr_byte_t              *chunk;
+	/** G.711 kernels */
+	const mpf_g711_kernel_t *g711;
+	/** Whether the input is u-law already, written as is */
+	apt_bool_t               passthrough;
+#ifdef MPF_HAVE_OPUS
+	/** Ogg Opus state */
+	mpf_ogg_opus_t          *ogg;
+#endif
+};
+
+static APR_INLINE void mpf_le16_put(apr_byte_t *buf, apr_uint16_t value)
+{
+	buf[0] = (apr_byte_t)value;
+	buf[1] = (apr_byte_t)(value >> 8);
+}
+
+static APR_INLINE void mpf_le32_put(apr_byte_t *buf, apr_uint32_t value)
+{
+	buf[0] = (apr_byte_t)value;
+	buf[1] = (apr_byte_t)(value >> 8);
+	buf[2] = (apr_byte_t)(value >> 16);
+	buf[3] = (apr_byte_t)(value >> 24);
+}
+
+/** Compose RIFF/WAVE header out of the current sizes */
+static apr_size_t wav_header_compose(const mpf_audio_file_encoder_t *encoder, apr_byte_t *header)
+{
+	apr_size_t header_size;
+	apr_uint16_t format_tag = 1; /* WAVE_FORMAT_PCM */
+	apr_uint16_t block_align = 2;
+	apr_uint32_t fmt_size = 16;
+	apr_byte_t *pos;
+	if(encoder->format == MPF_AUDIO_FILE_FORMAT_ULAW) {
+		format_tag = 7; /* WAVE_FORMAT_MULAW */
+		block_align = 1;
+		/* non-PCM formats have the fmt extension size and the fact chunk */
+		fmt_size = 18;
+	}
+
+	pos = header;
+	memcpy(pos,"RIFF",4);
+	pos += 8; /* size is set below */
+	memcpy(pos,"WAVE",4);
+	pos += 4;
+	memcpy(pos,"fmt ",4);
+	mpf_le32_put(pos + 4,fmt_size);
+	mpf_le16_put(pos + 8,format_tag);
+	mpf_le16_put(pos + 10,1);
+	mpf_le32_put(pos + 12,encoder->sampling_rate);
+	mpf_le32_put(pos + 16,(apr_uint32_t)encoder->sampling_rate * block_align);
+	mpf_le16_put(pos + 20,block_align);
+	mpf_le16_put(pos + 22,(apr_uint16_t)(block_align * 8));
+	pos += 8 + fmt_size;
+	if(format_tag != 1) {
+		mpf_le16_put(pos - 2,0);
+		memcpy(pos,"fact",4);
+		mpf_le32_put(pos + 4,4);
+		mpf_le32_put(pos + 8,encoder->sample_count);
+		pos += 12;
+	}
+	memcpy(pos,"data",4);
+	mpf_le32_put(pos + 4,encoder->data_size);
+	pos += 8;
+
+	header_size = pos - header;
+	mpf_le32_put(header + 4,(apr_uint32_t)(header_size - 8) + encoder->data_size);
+	return header_size;
+}
+
+static apt_bool_t wav_open(apt_file_encoder_t *base, apr_file_t *file)
+{
+	mpf_audio_file_encoder_t *encoder = base->obj;
+	apr_byte_t header[WAV_HEADER_SIZE_MAX];
+	apr_size_t size = wav_header_compose(encoder,header);
+	return apr_file_write_full(file,header,size,NULL) == APR_SUCCESS ? TRUE : FALSE;
+}
+
+static apt_bool_t wav_write(apt_file_encoder_t *base, apr_file_t *file, const char *data, apr_size_t size)
+{
+	mpf_audio_file_encoder_t *encoder = base->obj;
+	apr_size_t count = size / sizeof(apr_int16_t);
+	const apr_int16_t *samples = (const apr_int16_t*)data;
+
+	if(encoder->passthrough == TRUE) {
+		/* a byte per sample */
+		if(apr_file_write_full(file,data,size,NULL) != APR_SUCCESS) {
+			return FALSE;
+		}
+		encoder->sample_count += (apr_uint32_t)size;
+		encoder->data_size += (apr_uint32_t)size;
+		return TRUE;
+	}
+
+	encoder->sample_count += (apr_uint32_t)count;
+	while(count) {
+		apr_size_t i;
+		apr_size_t chunk_count = count;
+		apr_size_t chunk_size;
+		if(chunk_count > MPF_ENCODER_CHUNK_SAMPLES) {
+			chunk_count = MPF_ENCODER_CHUNK_SAMPLES;
+		}
+		if(encoder->format == MPF_AUDIO_FILE_FORMAT_ULAW) {
+			encoder->g711->ulaw_encode(samples,encoder->chunk,chunk_count);
+			chunk_size = chunk_count;
+		}
+		else {
+			/* WAVE samples are little-endian */
+			for(i=0; i<chunk_count; i++) {
+				mpf_le16_put(encoder->chunk + i*2,(apr_uint16_t)samples[i]);
+			}
+			chunk_size = chunk_count * sizeof(apr_int16_t);
+		}
+		if(apr_file_write_full(file,encoder->chunk,chunk_size,NULL) != APR_SUCCESS) {
+			return FALSE;
+		}
+		encoder->data_size += (apr_uint32_t)chunk_size;
+		samples += chunk_count;
+		count -= chunk_count;
+	}
+	return TRUE;
+}
+
+static void wav_close(apt_file_encoder_t *base, apr_file_t *file)
+{
+	mpf_audio_file_encoder_t *encoder = base->obj;
+	if(file) {
+		/* patch the sizes in the header */
+		apr_byte_t header[WAV_HEADER_SIZE_MAX];
+		apr_size_t size = wav_header_compose(encoder,header);
+		apr_off_t offset = 0;
+		if(apr_file_seek(file,APR_SET,&offset) != APR_SUCCESS ||
+			apr_file_write_full(file,header,size,NULL) != APR_SUCCESS) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Update WAVE Header");
+		}
+	}
+	apr_pool_destroy(encoder->pool);
+}
+
+static const apt_file_encoder_vtable_t wav_vtable = {
+	wav_open,
+	wav_write,
+	wav_close
+};
+
+#ifdef MPF_HAVE_OPUS
+
+/** Duration of an Opus packet in msec */
+#define OGG_OPUS_FRAME_TIME   20
+/** Max size of an Opus packet */
+#define OGG_OPUS_PACKET_MAX   1275
+/** Granule positions of Ogg Opus are in 48 kHz samples */
+#define OGG_OPUS_GRANULE_RATE 48000
+/** Max number of lacing values of an Ogg page */
+#define OGG_PAGE_SEGMENTS_MAX 255
+/** Number of packets per Ogg page (a page per second) */
+#define OGG_PAGE_PACKETS      50
+/** Size of an Ogg page header with no lacing values */
+#define OGG_PAGE_HEADER_SIZE  27
+
+/** Ogg Opus state */
+struct mpf_ogg_opus_t {
+	/** Opus encoder */
+	OpusEncoder *encoder;
+	/** Samples of the packet being collected */
+	apr_int16_t *frame;
+	/** Size of a packet in samples */
+	apr_size_t   frame_samples;
+	/** Number of collected samples */
+	apr_size_t   frame_fill;
+	/** Encoded packet */
+	apr_byte_t   packet[OGG_OPUS_PACKET_MAX];
+
+	/** Bitstream serial number */
+	apr_uint32_t serial;
+	/** Page sequence number */
+	apr_uint32_t page_seq;
+	/** Samples skipped by decoders at the beginning (48 kHz) */
+	apr_uint16_t pre_skip;
+	/** Granule position of the last complete packet */
+	apr_uint64_t granule;
+	/** Page header and lacing values */
+	apr_byte_t   header[OGG_PAGE_HEADER_SIZE + OGG_PAGE_SEGMENTS_MAX];
+	/** Number of lacing values */
+	apr_size_t   segments;
+	/** Page body */
+	apr_byte_t  *body;
+	/** Size of the page body */
+	apr_size_t   body_size;
+	/** Number of packets in the page */
+	apr_size_t   packets;
+};
+
+/** CRC of Ogg pages (polynomial 0x04c11db7, no reflection) */
+static apr_uint32_t ogg_crc_update(apr_uint32_t crc, const apr_byte_t *data, apr_size_t size)
+{
+	while(size--) {
+		int i;
+		crc ^= (apr_uint32_t)*data++ << 24;
+		for(i=0; i<8; i++) {
+			crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+		}
+	}
+	return crc;
+}
+
+/** Write the collected page */
+static apt_bool_t ogg_page_write(mpf_ogg_opus_t *ogg, apr_file_t *file, apr_byte_t flags, apr_uint64_t granule)
+{
+	apr_byte_t *header = ogg->header;
+	apr_size_t header_size = OGG_PAGE_HEADER_SIZE + ogg->segments;
+	apr_uint32_t crc;
+
+	memcpy(header,"OggS",4);
+	header[4] = 0;
+	header[5] = flags;
+	mpf_le32_put(header + 6,(apr_uint32_t)granule);
+	mpf_le32_put(header + 10,(apr_uint32_t)(granule >> 32));
+	mpf_le32_put(header + 14,ogg->serial);
+	mpf_le32_put(header + 18,ogg->page_seq);
+	mpf_le32_put(header + 22,0);
+	header[26] = (apr_byte_t)ogg->segments;
+	crc = ogg_crc_update(0,header,header_size);
+	crc = ogg_crc_update(crc,ogg->body,ogg->body_size);
+	mpf_le32_put(header + 22,crc);
+
+	ogg->page_seq++;
+	ogg->segments = 0;
+	ogg->packets = 0;
+	if(apr_file_write_full(file,header,header_size,NULL) != APR_SUCCESS) {
+		ogg->body_size = 0;
+		return FALSE;
+	}
+	if(ogg->body_size && apr_file_write_full(file,ogg->body,ogg->body_size,NULL) != APR_SUCCESS) {
+		ogg->body_size = 0;
+		return FALSE;
+	}
+	ogg->body_size = 0;
+	return TRUE;
+}
+
+/** Append packet to the page, write the page first if it is full */
+static apt_bool_t ogg_packet_append(mpf_ogg_opus_t *ogg, apr_file_t *file, const apr_byte_t *data, apr_size_t size)
+{
+	apr_size_t length = size;
+	if(ogg->segments + size / 255 + 1 > OGG_PAGE_SEGMENTS_MAX) {
+		if(ogg_page_write(ogg,file,0,ogg->granule) == FALSE) {
+			return FALSE;
+		}
+	}
+	/* lacing values: 255 per full segment, the last one is less than 255 */
+	while(length >= 255) {
+		ogg->header[OGG_PAGE_HEADER_SIZE + ogg->segments++] = 255;
+		length -= 255;
+	}
+	ogg->header[OGG_PAGE_HEADER_SIZE + ogg->segments++] = (apr_byte_t)length;
+	memcpy(ogg->body + ogg->body_size,data,size);
+	ogg->body_size += size;
+	ogg->packets++;
+	return TRUE;
+}
+
+/** Encode the collected samples */
+static apt_bool_t ogg_opus_frame_encode(mpf_audio_file_encoder_t *encoder, apr_file_t *file)
+{
+	mpf_ogg_opus_t *ogg = encoder->ogg;
+	opus_int32 size = opus_encode(ogg->encoder,ogg->frame,(int)ogg->frame_samples,ogg->packet,OGG_OPUS_PACKET_MAX);
+	ogg->frame_fill = 0;
+	if(size < 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Encode Opus Packet: %s",opus_strerror(size));
+		return FALSE;
+	}
+	if(ogg_packet_append(ogg,file,ogg->packet,size) == FALSE) {
+		return FALSE;
+	}
+	ogg->granule += ogg->frame_samples * OGG_OPUS_GRANULE_RATE / encoder->sampling_rate;
+	if(ogg->packets >= OGG_PAGE_PACKETS) {
+		return ogg_page_write(ogg,file,0,ogg->granule);
+	}
+	return TRUE;
+}
+
+static apt_bool_t ogg_opus_open(apt_file_encoder_t *base, apr_file_t *file)
+{
+	mpf_audio_file_encoder_t *encoder = base->obj;
+	mpf_ogg_opus_t *ogg = encoder->ogg;
+	static const char vendor[] = "UniMRCP";
+	apr_byte_t *pos;
+
+	/* identification header (RFC 7845 5.1) on the first page */
+	pos = ogg->body;
+	memcpy(pos,"OpusHead",8);
+	pos[8] = 1;
+	pos[9] = 1;
+	mpf_le16_put(pos + 10,ogg->pre_skip);
+	mpf_le32_put(pos + 12,encoder->sampling_rate);
+	mpf_le16_put(pos + 16,0);
+	pos[18] = 0;
+	ogg->body_size = 19;
+	ogg->segments = 0;
+	ogg->header[OGG_PAGE_HEADER_SIZE + ogg->segments++] = (apr_byte_t)ogg->body_size;
+	if(ogg_page_write(ogg,file,0x02,0) == FALSE) {
+		return FALSE;
+	}
+
+	/* comment header (RFC 7845 5.2) on the second page */
+	pos = ogg->body;
+	memcpy(pos,"OpusTags",8);
+	mpf_le32_put(pos + 8,sizeof(vendor) - 1);
+	memcpy(pos + 12,vendor,sizeof(vendor) - 1);
+	mpf_le32_put(pos + 12 + sizeof(vendor) - 1,0);
+	ogg->body_size = 16 + sizeof(vendor) - 1;
+	ogg->header[OGG_PAGE_HEADER_SIZE + ogg->segments++] = (apr_byte_t)ogg->body_size;
+	return ogg_page_write(ogg,file,0,0);
+}
+
+static apt_bool_t ogg_opus_write(apt_file_encoder_t *base, apr_file_t *file, const char *data, apr_size_t size)
+{
+	mpf_audio_file_encoder_t *encoder = base->obj;
+	mpf_ogg_opus_t *ogg = encoder->ogg;
+	apr_size_t count = size / sizeof(apr_int16_t);
+	const apr_int16_t *samples = (const apr_int16_t*)data;
+
+	encoder->sample_count += (apr_uint32_t)count;
+	while(count) {
+		apr_size_t chunk_count = ogg->frame_samples - ogg->frame_fill;
+		if(chunk_count > count) {
+			chunk_count = count;
+		}
+		memcpy(ogg->frame + ogg->frame_fill,samples,chunk_count * sizeof(apr_int16_t));
+		ogg->frame_fill += chunk_count;
+		samples += chunk_count;
+		count -= chunk_count;
+		if(ogg->frame_fill == ogg->frame_samples) {
+			if(ogg_opus_frame_encode(encoder,file) == FALSE) {
+				return FALSE;
+			}
+		}
+	}
+	return TRUE;
+}
+
+static void ogg_opus_close(apt_file_encoder_t *base, apr_file_t *file)
+{
+	mpf_audio_file_encoder_t *encoder = base->obj;
+	mpf_ogg_opus_t *ogg = encoder->ogg;
+	if(file) {
+		apt_bool_t status = TRUE;
+		if(ogg->frame_fill) {
+			/* pad the last packet with silence, decoders trim it by the final granule position */
+			memset(ogg->frame + ogg->frame_fill,0,(ogg->frame_samples - ogg->frame_fill) * sizeof(apr_int16_t));
+			status = ogg_opus_frame_encode(encoder,file);
+		}
+		if(status == TRUE) {
+			apr_uint64_t granule = ogg->pre_skip +
+				(apr_uint64_t)encoder->sample_count * OGG_OPUS_GRANULE_RATE / encoder->sampling_rate;
+			status = ogg_page_write(ogg,file,0x04,granule);
+		}
+		if(status == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Write Ogg Page");
+		}
+	}
+	opus_encoder_destroy(ogg->encoder);
+	apr_pool_destroy(encoder->pool);
+}
+
+static const apt_file_encoder_vtable_t ogg_opus_vtable = {
+	ogg_opus_open,
+	ogg_opus_write,
+	ogg_opus_close
+};
+
+static apt_bool_t ogg_opus_create(mpf_audio_file_encoder_t *encoder)
+{
+	int error;
+	opus_int32 lookahead = 0;
+	mpf_ogg_opus_t *ogg = apr_palloc(encoder->pool,sizeof(mpf_ogg_opus_t));
+	ogg->encoder = opus_encoder_create(encoder->sampling_rate,1,OPUS_APPLICATION_VOIP,&error);
+	if(!ogg->encoder) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Opus Encoder [%d]: %s",
+			encoder->sampling_rate,opus_strerror(error));
+		return FALSE;
+	}
+	opus_encoder_ctl(ogg->encoder,OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+	opus_encoder_ctl(ogg->encoder,OPUS_GET_LOOKAHEAD(&lookahead));
+
+	ogg->frame_samples = encoder->sampling_rate * OGG_OPUS_FRAME_TIME / 1000;
+	ogg->frame = apr_palloc(encoder->pool,ogg->frame_samples * sizeof(apr_int16_t));
+	ogg->frame_fill = 0;
+	ogg->serial = (apr_uint32_t)apr_time_now() ^ (apr_uint32_t)(apr_uintptr_t)ogg;
+	ogg->page_seq = 0;
+	ogg->pre_skip = (apr_uint16_t)(lookahead * OGG_OPUS_GRANULE_RATE / encoder->sampling_rate);
+	ogg->granule = ogg->pre_skip;
+	ogg->segments = 0;
+	ogg->body = apr_palloc(encoder->pool,OGG_PAGE_SEGMENTS_MAX * 255);
+	ogg->body_size = 0;
+	ogg->packets = 0;
+	encoder->ogg = ogg;
+	return TRUE;
+}
+
+#endif
+
+/** Find audio file format by name */
+MPF_DECLARE(mpf_audio_file_format_e) mpf_audio_file_format_find(const char *name)
+{
+	int i;
+	if(!name) {
+		return MPF_AUDIO_FILE_FORMAT_UNKNOWN;
+	}
+	for(i=0; i<MPF_AUDIO_FILE_FORMAT_COUNT; i++) {
+		if(strcasecmp(format_names[i],name) == 0) {
+			return (mpf_audio_file_format_e)i;
+		}
+	}
+	return MPF_AUDIO_FILE_FORMAT_UNKNOWN;
+}
+
+/** Find audio file format by media type */
+MPF_DECLARE(mpf_audio_file_format_e) mpf_audio_file_format_by_media_type(const apt_str_t *media_type)
+{
+	apr_size_t i;
+	apr_size_t length;
+	const char *params;
+	if(!media_type || !media_type->length) {
+		return MPF_AUDIO_FILE_FORMAT_UNKNOWN;
+	}
+	/* parameters (e.g. ";rate=8000") are not taken into account */
+	length = media_type->length;
+	params = memchr(media_type->buf,';',length);
+	if(params) {
+		length = params - media_type->buf;
+	}
+	while(length && (media_type->buf[length-1] == ' ' || media_type->buf[length-1] == '\t')) {
+		length--;
+	}
+	for(i=0; i<sizeof(format_media_types)/sizeof(format_media_types[0]); i++) {
+		if(strlen(format_media_types[i].media_type) == length &&
+			strncasecmp(format_media_types[i].media_type,media_type->buf,length) == 0) {
+			return format_media_types[i].format;
+		}
+	}
+	return MPF_AUDIO_FILE_FORMAT_UNKNOWN;
+}
+
+/** Get the file name extension of audio file format */
+MPF_DECLARE(const char*) mpf_audio_file_format_ext_get(mpf_audio_file_format_e format)
+{
+	if(format >= MPF_AUDIO_FILE_FORMAT_COUNT) {
+		return NULL;
+	}
+	return format_exts[format];
+}
+
+/** Check whether audio file format is supported */
+MPF_DECLARE(apt_bool_t) mpf_audio_file_format_is_supported(mpf_audio_file_format_e format)
+{
+	if(format >= MPF_AUDIO_FILE_FORMAT_COUNT) {
+		return FALSE;
+	}
+#ifndef MPF_HAVE_OPUS
+	if(format == MPF_AUDIO_FILE_FORMAT_OPUS) {
+		/* libopus is not compiled in (configure --enable-opus) */
+		return FALSE;
+	}
+#endif
+	return TRUE;
+}
+
+/** Create encoder of linear PCM to audio file format */
+MPF_DECLARE(apt_file_encoder_t*) mpf_audio_file_encoder_create(mpf_audio_file_format_e format, apr_uint16_t sampling_rate)
+{
+	mpf_audio_file_encoder_t *encoder;
+	apr_pool_t *pool;
+	if(format == MPF_AUDIO_FILE_FORMAT_PCM || mpf_audio_file_format_is_supported(format) == FALSE) {
+		return NULL;
+	}
+
+	/* the encoder is destroyed in the context of the writer, once the file is closed */
+	pool = apt_pool_create();
+	if(!pool) {
+		return NULL;
+	}
+	encoder = apr_palloc(pool,sizeof(mpf_audio_file_encoder_t));
+	encoder->base.vtable = &wav_vtable;
+	encoder->base.obj = encoder;
+	encoder->pool = pool;
+	encoder->format = format;
+	encoder->sampling_rate = sampling_rate;
+	encoder->data_size = 0;
+	encoder->sample_count = 0;
+	encoder->chunk = apr_palloc(pool,MPF_ENCODER_CHUNK_SAMPLES * sizeof(apr_int16_t));
+	encoder->g711 = mpf_g711_kernel_best_get();
+	encoder->passthrough = FALSE;
+#ifdef MPF_HAVE_OPUS
+	encoder->ogg = NULL;
+	if(format == MPF_AUDIO_FILE_FORMAT_OPUS) {
+		if(ogg_opus_create(encoder) == FALSE) {
+			apr_pool_destroy(pool);
+			return NULL;
+		}
+		encoder->base.vtable = &ogg_opus_vtable;
+	}
+#endif
+	return &encoder->base;
+}
+
+/** Create writer of received u-law to RIFF/WAVE */
+MPF_DECLARE(apt_file_encoder_t*) mpf_audio_file_ulaw_passthrough_create(apr_uint16_t sampling_rate)
+{
+	mpf_audio_file_encoder_t *encoder;
+	apt_file_encoder_t *base = mpf_audio_file_encoder_create(MPF_AUDIO_FILE_FORMAT_ULAW,sampling_rate);
+	if(!base) {
+		return NULL;
+	}
+	encoder = base->obj;
+	encoder->passthrough = TRUE;
+	return base;
+}
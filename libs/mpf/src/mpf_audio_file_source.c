@@ -0,0 +1,161 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <apr_file_io.h>
+#include <apr_mmap.h>
+#include "mpf_audio_file_source.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+
+#if APR_HAS_MMAP && (defined(__unix__) || defined(__APPLE__))
+#include <sys/mman.h>
+#endif
+
+/** Audio file source */
+struct mpf_audio_file_source_t {
+	/** Pool the mapping and the source are allocated from */
+	apr_pool_t *pool;
+	/** Content of the file */
+	const char *data;
+	/** Size of the file */
+	apr_size_t  size;
+	/** Offset of the next frame */
+	apr_size_t  offset;
+};
+
+/** Map the file into memory, return FALSE if mapping is not available */
+static apt_bool_t mpf_audio_file_source_map(mpf_audio_file_source_t *source, apr_file_t *file)
+{
+#if APR_HAS_MMAP
+	apr_mmap_t *mmap;
+	if(apr_mmap_create(&mmap,file,0,source->size,APR_MMAP_READ,source->pool) != APR_SUCCESS) {
+		return FALSE;
+	}
+	source->data = mmap->mm;
+#ifdef MADV_SEQUENTIAL
+	/* frames are read in order, let the kernel read ahead and drop pages behind */
+	madvise(mmap->mm,source->size,MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_WILLNEED
+	madvise(mmap->mm,source->size,MADV_WILLNEED);
+#endif
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+/** Open audio file source */
+MPF_DECLARE(mpf_audio_file_source_t*) mpf_audio_file_source_open(const char *file_path)
+{
+	mpf_audio_file_source_t *source;
+	apr_file_t *file;
+	apr_finfo_t finfo;
+	apr_pool_t *pool = apt_pool_create();
+	if(!pool) {
+		return NULL;
+	}
+
+	if(apr_file_open(&file,file_path,APR_FOPEN_READ | APR_FOPEN_BINARY,APR_OS_DEFAULT,pool) != APR_SUCCESS) {
+		apr_pool_destroy(pool);
+		return NULL;
+	}
+	if(apr_file_info_get(&finfo,APR_FINFO_SIZE,file) != APR_SUCCESS) {
+		apr_file_close(file);
+		apr_pool_destroy(pool);
+		return NULL;
+	}
+
+	source = apr_palloc(pool,sizeof(mpf_audio_file_source_t));
+	source->pool = pool;
+	source->data = NULL;
+	source->size = (apr_size_t)finfo.size;
+	source->offset = 0;
+	if(source->size && mpf_audio_file_source_map(source,file) == FALSE) {
+		/* read the whole file ahead instead */
+		char *data = apr_palloc(pool,source->size);
+		if(apr_file_read_full(file,data,source->size,&source->size) != APR_SUCCESS) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Read File [%s]",file_path);
+			apr_file_close(file);
+			apr_pool_destroy(pool);
+			return NULL;
+		}
+		source->data = data;
+	}
+	/* the mapping outlives the file handle */
+	apr_file_close(file);
+	return source;
+}
+
+/** Create audio source of contiguous buffer */
+MPF_DECLARE(mpf_audio_file_source_t*) mpf_audio_file_source_create(const void *data, apr_size_t size)
+{
+	mpf_audio_file_source_t *source;
+	apr_pool_t *pool = apt_pool_create();
+	if(!pool) {
+		return NULL;
+	}
+
+	source = apr_palloc(pool,sizeof(mpf_audio_file_source_t));
+	source->pool = pool;
+	source->data = data;
+	source->size = size;
+	source->offset = 0;
+	return source;
+}
+
+/** Close audio file source */
+MPF_DECLARE(void) mpf_audio_file_source_close(mpf_audio_file_source_t *source)
+{
+	apr_pool_destroy(source->pool);
+}
+
+/** Get the next frame */
+MPF_DECLARE(const char*) mpf_audio_file_source_frame_get(mpf_audio_file_source_t *source, apr_size_t size)
+{
+	const char *frame;
+	if(source->offset + size > source->size) {
+		return NULL;
+	}
+	frame = source->data + source->offset;
+	source->offset += size;
+	return frame;
+}
+
+/** Read the next frame */
+MPF_DECLARE(apt_bool_t) mpf_audio_file_source_frame_read(mpf_audio_file_source_t *source, void *buffer, apr_size_t size)
+{
+	const char *frame = mpf_audio_file_source_frame_get(source,size);
+	if(!frame) {
+		return FALSE;
+	}
+	memcpy(buffer,frame,size);
+	return TRUE;
+}
+
+/** Lend the next frame */
+MPF_DECLARE(apt_bool_t) mpf_audio_file_source_frame_lend(mpf_audio_file_source_t *source, mpf_frame_t *frame)
+{
+	const char *data = mpf_audio_file_source_frame_get(source,frame->codec_frame.size);
+	if(!data) {
+		return FALSE;
+	}
+	frame->codec_frame.buffer = (void*)data;
+	frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+	return TRUE;
+}
@@ -25,14 +25,15 @@
 /** Audio file stream */
 typedef struct mpf_audio_file_stream_t mpf_audio_file_stream_t;
 struct mpf_audio_file_stream_t {
-	mpf_audio_stream_t *audio_stream;
+	mpf_audio_stream_t      *audio_stream;
 
-	FILE               *read_handle;
-	FILE               *write_handle;
+	FILE                    *read_handle;
+	mpf_audio_file_source_t *read_source;
+	FILE                    *write_handle;
 
-	apt_bool_t          eof;
-	apr_size_t          max_write_size;
-	apr_size_t          cur_write_size;
+	apt_bool_t               eof;
+	apr_size_t               max_write_size;
+	apr_size_t               cur_write_size;
 };
 
 static APR_INLINE void mpf_audio_file_event_raise(mpf_audio_stream_t *stream, int event_id, void *descriptor);
@@ -45,6 +46,10 @@ static apt_bool_t mpf_audio_file_destroy(mpf_audio_stream_t *stream)
 		fclose(file_stream->read_handle);
 		file_stream->read_handle = NULL;
 	}
+	if(file_stream->read_source) {
+		mpf_audio_file_source_close(file_stream->read_source);
+		file_stream->read_source = NULL;
+	}
 	if(file_stream->write_handle) {
 		fclose(file_stream->write_handle);
 		file_stream->write_handle = NULL;
@@ -65,7 +70,17 @@ static apt_bool_t mpf_audio_file_reader_close(mpf_audio_stream_t *stream)
 static apt_bool_t mpf_audio_file_frame_read(mpf_audio_stream_t *stream, mpf_frame_t *frame)
 {
 	mpf_audio_file_stream_t *file_stream = stream->obj;
-	if(file_stream->read_handle && file_stream->eof == FALSE) {
+	if(file_stream->read_source && file_stream->eof == FALSE) {
+		/* no disk I/O from the media thread, the file is mapped into memory */
+		if(mpf_audio_file_source_frame_read(file_stream->read_source,frame->codec_frame.buffer,frame->codec_frame.size) == TRUE) {
+			frame->type = MEDIA_FRAME_TYPE_AUDIO;
+		}
+		else {
+			file_stream->eof = TRUE;
+			mpf_audio_file_event_raise(stream,0,NULL);
+		}
+	}
+	else if(file_stream->read_handle && file_stream->eof == FALSE) {
 		if(fread(frame->codec_frame.buffer,1,frame->codec_frame.size,file_stream->read_handle) == frame->codec_frame.size) {
 			frame->type = MEDIA_FRAME_TYPE_AUDIO;
 		}
@@ -129,6 +144,7 @@ MPF_DECLARE(mpf_audio_stream_t*) mpf_file_stream_create(mpf_termination_t *termi
 	file_stream->audio_stream = audio_stream;
 	file_stream->write_handle = NULL;
 	file_stream->read_handle = NULL;
+	file_stream->read_source = NULL;
 	file_stream->eof = FALSE;
 	file_stream->max_write_size = 0;
 	file_stream->cur_write_size = 0;
@@ -144,6 +160,10 @@ MPF_DECLARE(apt_bool_t) mpf_file_stream_modify(mpf_audio_stream_t *stream, mpf_a
 			fclose(file_stream->read_handle);
 		}
 		file_stream->read_handle = descriptor->read_handle;
+		if(file_stream->read_source) {
+			mpf_audio_file_source_close(file_stream->read_source);
+		}
+		file_stream->read_source = descriptor->read_source;
 		file_stream->eof = FALSE;
 		stream->direction |= FILE_READER;
 
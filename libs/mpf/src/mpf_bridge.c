@@ -37,14 +37,53 @@ struct mpf_bridge_t {
 	mpf_codec_t        *codec;
 	/** Media frame used to read data from source and write it to sink */
 	mpf_frame_t         frame;
+	/** Source before decoder and resampler, drained while the sink is inactive (NULL if the same) */
+	mpf_audio_stream_t *raw_source;
+	/** Media frame used to drain the raw source */
+	mpf_frame_t         raw_frame;
+	/** Source writing named events to the sink on arrival (NULL if events come with the frames) */
+	mpf_audio_stream_t *event_source;
+	/** Pool the frame buffers are borrowed from */
+	mpf_frame_pool_t   *frame_pool;
 };
 
+/** Keep the raw source current, while the sink is not consuming */
+static void mpf_bridge_drain(mpf_bridge_t *bridge)
+{
+	bridge->raw_frame.type = MEDIA_FRAME_TYPE_NONE;
+	bridge->raw_frame.marker = MPF_MARKER_NONE;
+	bridge->raw_source->vtable->read_frame(bridge->raw_source,&bridge->raw_frame);
+
+	/* events are passed on, audio is neither decoded nor resampled */
+	bridge->frame.type = bridge->event_source ? MEDIA_FRAME_TYPE_NONE : bridge->raw_frame.type & MEDIA_FRAME_TYPE_EVENT;
+	bridge->frame.marker = bridge->raw_frame.marker;
+	if(bridge->frame.type == MEDIA_FRAME_TYPE_EVENT) {
+		bridge->frame.event_frame = bridge->raw_frame.event_frame;
+	}
+	bridge->sink->vtable->write_frame(bridge->sink,&bridge->frame);
+}
+
+/* The frame is left in the jitter buffer, read on the next tick */
+static apt_bool_t mpf_bridge_defer(mpf_object_t *object)
+{
+	mpf_bridge_t *bridge = (mpf_bridge_t*) object;
+	return mpf_audio_stream_receive(bridge->source);
+}
+
 static apt_bool_t mpf_bridge_process(mpf_object_t *object)
 {
 	mpf_bridge_t *bridge = (mpf_bridge_t*) object;
+	if(bridge->raw_source && mpf_audio_stream_tx_is_active(bridge->sink) == FALSE) {
+		mpf_bridge_drain(bridge);
+		return TRUE;
+	}
 	bridge->frame.type = MEDIA_FRAME_TYPE_NONE;
 	bridge->frame.marker = MPF_MARKER_NONE;
 	bridge->source->vtable->read_frame(bridge->source,&bridge->frame);
+	if(bridge->event_source) {
+		/* the sink has got the events on arrival */
+		bridge->frame.type &= ~MEDIA_FRAME_TYPE_EVENT;
+	}
 	
 	if((bridge->frame.type & MEDIA_FRAME_TYPE_AUDIO) == 0) {
 		memset(	bridge->frame.codec_frame.buffer,
@@ -62,8 +101,18 @@ static apt_bool_t mpf_null_bridge_process(mpf_object_t *object)
 	bridge->frame.type = MEDIA_FRAME_TYPE_NONE;
 	bridge->frame.marker = MPF_MARKER_NONE;
 	bridge->source->vtable->read_frame(bridge->source,&bridge->frame);
+	/* there is no decoder to conceal lost frames in the encoded domain */
+	bridge->frame.type &= ~MEDIA_FRAME_TYPE_LOST;
+	if(bridge->event_source) {
+		/* the sink has got the events on arrival */
+		bridge->frame.type &= ~MEDIA_FRAME_TYPE_EVENT;
+	}
+	if(!bridge->sink->tx_cn_descriptor) {
+		/* comfort noise is passed through only if the sink signals it too */
+		bridge->frame.type &= ~MEDIA_FRAME_TYPE_CN;
+	}
 
-	if((bridge->frame.type & MEDIA_FRAME_TYPE_AUDIO) == 0) {
+	if((bridge->frame.type & (MEDIA_FRAME_TYPE_AUDIO | MEDIA_FRAME_TYPE_CN)) == 0) {
 		/* generate silence frame */
 		mpf_codec_initialize(bridge->codec,&bridge->frame.codec_frame);
 	}
@@ -98,12 +147,19 @@ static apt_bool_t mpf_bridge_destroy(mpf_object_t *object)
 {
 	mpf_bridge_t *bridge = (mpf_bridge_t*) object;
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Destroy Audio Bridge %s",object->name);
+	if(bridge->event_source) {
+		bridge->event_source->rx_event_sink = NULL;
+	}
 	mpf_audio_stream_rx_close(bridge->source);
 	mpf_audio_stream_tx_close(bridge->sink);
+	mpf_frame_pool_buffer_release(bridge->frame_pool,bridge->frame.codec_frame.buffer);
+	if(bridge->raw_source) {
+		mpf_frame_pool_buffer_release(bridge->frame_pool,bridge->raw_frame.codec_frame.buffer);
+	}
 	return TRUE;
 }
 
-static mpf_bridge_t* mpf_bridge_base_create(mpf_audio_stream_t *source, mpf_audio_stream_t *sink, const char *name, apr_pool_t *pool)
+static mpf_bridge_t* mpf_bridge_base_create(mpf_audio_stream_t *source, mpf_audio_stream_t *sink, const char *name, mpf_frame_pool_t *frame_pool, apr_pool_t *pool)
 {
 	mpf_bridge_t *bridge;
 	if(!source || !sink) {
@@ -114,20 +170,24 @@ static mpf_bridge_t* mpf_bridge_base_create(mpf_audio_stream_t *source, mpf_audi
 	bridge->source = source;
 	bridge->sink = sink;
 	bridge->codec = NULL;
+	bridge->raw_source = NULL;
+	bridge->event_source = NULL;
+	bridge->frame_pool = frame_pool;
 	mpf_object_init(&bridge->base,name);
 	bridge->base.destroy = mpf_bridge_destroy;
 	bridge->base.process = mpf_bridge_process;
 	bridge->base.trace = mpf_bridge_trace;
+	bridge->base.defer = mpf_bridge_defer;
 	return bridge;
 }
 
-static mpf_object_t* mpf_linear_bridge_create(mpf_audio_stream_t *source, mpf_audio_stream_t *sink, const mpf_codec_manager_t *codec_manager, const char *name, apr_pool_t *pool)
+static mpf_object_t* mpf_linear_bridge_create(mpf_audio_stream_t *source, mpf_audio_stream_t *sink, const mpf_codec_manager_t *codec_manager, const char *name, mpf_frame_pool_t *frame_pool, apr_pool_t *pool)
 {
 	mpf_codec_descriptor_t *descriptor;
 	apr_size_t frame_size;
 	mpf_bridge_t *bridge;
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Create Linear Audio Bridge %s",name);
-	bridge = mpf_bridge_base_create(source,sink,name,pool);
+	bridge = mpf_bridge_base_create(source,sink,name,frame_pool,pool);
 	if(!bridge) {
 		return NULL;
 	}
@@ -135,7 +195,6 @@ static mpf_object_t* mpf_linear_bridge_create(mpf_audio_stream_t *source, mpf_au
 	descriptor = source->rx_descriptor;
 	frame_size = mpf_codec_linear_frame_size_calculate(descriptor->sampling_rate,descriptor->channel_count);
 	bridge->frame.codec_frame.size = frame_size;
-	bridge->frame.codec_frame.buffer = apr_palloc(pool,frame_size);
 	
 	if(mpf_audio_stream_rx_open(source,NULL) == FALSE) {
 		return NULL;
@@ -144,16 +203,18 @@ static mpf_object_t* mpf_linear_bridge_create(mpf_audio_stream_t *source, mpf_au
 		mpf_audio_stream_rx_close(source);
 		return NULL;
 	}
+	/* borrowed once the bridge is sure to be destroyed */
+	bridge->frame.codec_frame.buffer = mpf_frame_pool_buffer_get(frame_pool,frame_size,pool);
 	return &bridge->base;
 }
 
-static mpf_object_t* mpf_null_bridge_create(mpf_audio_stream_t *source, mpf_audio_stream_t *sink, const mpf_codec_manager_t *codec_manager, const char *name, apr_pool_t *pool)
+static mpf_object_t* mpf_null_bridge_create(mpf_audio_stream_t *source, mpf_audio_stream_t *sink, const mpf_codec_manager_t *codec_manager, const char *name, mpf_frame_pool_t *frame_pool, apr_pool_t *pool)
 {
 	mpf_codec_t *codec;
 	apr_size_t frame_size;
 	mpf_bridge_t *bridge;
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Create Null Audio Bridge %s",name);
-	bridge = mpf_bridge_base_create(source,sink,name,pool);
+	bridge = mpf_bridge_base_create(source,sink,name,frame_pool,pool);
 	if(!bridge) {
 		return NULL;
 	}
@@ -167,7 +228,6 @@ static mpf_object_t* mpf_null_bridge_create(mpf_audio_stream_t *source, mpf_audi
 	frame_size = mpf_codec_frame_size_calculate(source->rx_descriptor,codec->attribs);
 	bridge->codec = codec;
 	bridge->frame.codec_frame.size = frame_size;
-	bridge->frame.codec_frame.buffer = apr_palloc(pool,frame_size);
 
 	if(mpf_audio_stream_rx_open(source,codec) == FALSE) {
 		return NULL;
@@ -176,16 +236,36 @@ static mpf_object_t* mpf_null_bridge_create(mpf_audio_stream_t *source, mpf_audi
 		mpf_audio_stream_rx_close(source);
 		return NULL;
 	}
+	bridge->frame.codec_frame.buffer = mpf_frame_pool_buffer_get(frame_pool,frame_size,pool);
 	return &bridge->base;
 }
 
+/** Let the source write named events to the sink on arrival, if both are capable of it */
+static mpf_object_t* mpf_bridge_event_direct_set(mpf_object_t *object, mpf_audio_stream_t *source, mpf_audio_stream_t *sink)
+{
+	mpf_bridge_t *bridge = (mpf_bridge_t*) object;
+	if(!bridge || source->rx_event_direct == FALSE || !source->rx_event_descriptor ||
+		!sink->tx_event_descriptor || !sink->vtable->write_event) {
+		return object;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Write Events on Arrival %s",object->name);
+	source->rx_event_sink = sink;
+	bridge->event_source = source;
+	return object;
+}
+
 MPF_DECLARE(mpf_object_t*) mpf_bridge_create(
 						mpf_audio_stream_t *source, 
 						mpf_audio_stream_t *sink, 
 						const mpf_codec_manager_t *codec_manager, 
 						const char *name,
+						mpf_frame_pool_t *frame_pool,
 						apr_pool_t *pool)
 {
+	mpf_object_t *object;
+	mpf_audio_stream_t *raw_source;
+	mpf_audio_stream_t *raw_sink;
+	apr_size_t raw_frame_size;
 	if(!source || !sink) {
 		return NULL;
 	}
@@ -196,14 +276,19 @@ MPF_DECLARE(mpf_object_t*) mpf_bridge_create(
 	}
 
 	if(mpf_codec_descriptors_match(source->rx_descriptor,sink->tx_descriptor) == TRUE) {
-		return mpf_null_bridge_create(source,sink,codec_manager,name,pool);
+		object = mpf_null_bridge_create(source,sink,codec_manager,name,frame_pool,pool);
+		return mpf_bridge_event_direct_set(object,source,sink);
 	}
 
+	raw_source = source;
+	raw_sink = sink;
+	raw_frame_size = mpf_codec_linear_frame_size_calculate(source->rx_descriptor->sampling_rate,source->rx_descriptor->channel_count);
 	if(mpf_codec_lpcm_descriptor_match(source->rx_descriptor) == FALSE) {
 		mpf_codec_t *codec = mpf_codec_manager_codec_get(codec_manager,source->rx_descriptor,pool);
 		if(codec) {
 			/* set decoder before bridge */
 			mpf_audio_stream_t *decoder = mpf_decoder_create(source,codec,pool);
+			raw_frame_size = mpf_codec_frame_size_calculate(source->rx_descriptor,codec->attribs);
 			source = decoder;
 		}
 	}
@@ -226,5 +311,13 @@ MPF_DECLARE(mpf_object_t*) mpf_bridge_create(
 		source = resampler;
 	}
 
-	return mpf_linear_bridge_create(source,sink,codec_manager,name,pool);
+	object = mpf_linear_bridge_create(source,sink,codec_manager,name,frame_pool,pool);
+	if(object && source != raw_source) {
+		/* decoding and resampling are skipped, while the sink is inactive */
+		mpf_bridge_t *bridge = (mpf_bridge_t*) object;
+		bridge->raw_source = raw_source;
+		bridge->raw_frame.codec_frame.size = raw_frame_size;
+		bridge->raw_frame.codec_frame.buffer = mpf_frame_pool_buffer_get(frame_pool,raw_frame_size,pool);
+	}
+	return mpf_bridge_event_direct_set(object,raw_source,raw_sink);
 }
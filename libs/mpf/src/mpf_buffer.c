@@ -20,15 +20,44 @@
 #pragma warning(disable: 4127)
 #endif
 #include <apr_ring.h>
+#include <apr_atomic.h>
 #include "mpf_buffer.h"
 
+/** Max number of pending events of bounded buffer */
+#define MPF_BUFFER_EVENT_COUNT 16
+
 typedef struct mpf_chunk_t mpf_chunk_t;
+typedef struct mpf_buffer_ring_t mpf_buffer_ring_t;
+typedef struct mpf_buffer_event_t mpf_buffer_event_t;
 
 struct mpf_chunk_t {
 	APR_RING_ENTRY(mpf_chunk_t) link;
 	mpf_frame_t                 frame;
 };
 
+/** Event of bounded buffer, raised once the audio written before it is read */
+struct mpf_buffer_event_t {
+	apr_uint32_t      pos;
+	mpf_frame_type_e  type;
+};
+
+/** Bounded single producer single consumer ring */
+struct mpf_buffer_ring_t {
+	char                  *data;
+	apr_uint32_t           mask;
+	/* positions are free-running, written by the producer and the consumer respectively */
+	volatile apr_uint32_t  write_pos;
+	volatile apr_uint32_t  read_pos;
+	mpf_buffer_event_t     events[MPF_BUFFER_EVENT_COUNT];
+	volatile apr_uint32_t  event_write_pos;
+	volatile apr_uint32_t  event_read_pos;
+	/* restart requested by the producer, applied by the consumer */
+	volatile apr_uint32_t  restart;
+	volatile apr_uint32_t  restart_pos;
+	volatile apr_uint32_t  restart_event_pos;
+	volatile apr_uint32_t  watermark_armed;
+};
+
 struct mpf_buffer_t {
 	APR_RING_HEAD(mpf_chunk_head_t, mpf_chunk_t) head;
 	mpf_chunk_t                                 *cur_chunk;
@@ -36,8 +65,21 @@ struct mpf_buffer_t {
 	apr_thread_mutex_t                          *guard;
 	apr_pool_t                                  *pool;
 	apr_size_t                                   size; /* total size */
+	apr_size_t                                   watermark_size;
+	mpf_buffer_watermark_f                       watermark_handler;
+	void                                        *watermark_obj;
+	/* whether data has been written since the handler was called */
+	apt_bool_t                                   watermark_armed;
+	/* bounded ring used instead of the list of chunks, if any */
+	mpf_buffer_ring_t                           *ring;
 };
 
+/** Load with full barrier (acquire semantics) */
+static APR_INLINE apr_uint32_t mpf_buffer_load(volatile apr_uint32_t *mem)
+{
+	return apr_atomic_add32(mem,0);
+}
+
 mpf_buffer_t* mpf_buffer_create(apr_pool_t *pool)
 {
 	mpf_buffer_t *buffer = apr_palloc(pool,sizeof(mpf_buffer_t));
@@ -45,11 +87,44 @@ mpf_buffer_t* mpf_buffer_create(apr_pool_t *pool)
 	buffer->cur_chunk = NULL;
 	buffer->remaining_chunk_size = 0;
 	buffer->size = 0;
+	buffer->watermark_size = 0;
+	buffer->watermark_handler = NULL;
+	buffer->watermark_obj = NULL;
+	buffer->watermark_armed = FALSE;
+	buffer->ring = NULL;
 	APR_RING_INIT(&buffer->head, mpf_chunk_t, link);
 	apr_thread_mutex_create(&buffer->guard,APR_THREAD_MUTEX_UNNESTED,pool);
 	return buffer;
 }
 
+mpf_buffer_t* mpf_buffer_bounded_create(apr_size_t capacity, apr_pool_t *pool)
+{
+	mpf_buffer_ring_t *ring;
+	apr_uint32_t size = 1;
+	mpf_buffer_t *buffer;
+	if(!capacity || capacity > 0x80000000) {
+		return NULL;
+	}
+	while(size < capacity) {
+		size <<= 1;
+	}
+
+	buffer = mpf_buffer_create(pool);
+	ring = apr_palloc(pool,sizeof(mpf_buffer_ring_t));
+	ring->data = apr_palloc(pool,size);
+	ring->mask = size - 1;
+	ring->write_pos = 0;
+	ring->read_pos = 0;
+	ring->event_write_pos = 0;
+	ring->event_read_pos = 0;
+	ring->restart = 0;
+	ring->restart_pos = 0;
+	ring->restart_event_pos = 0;
+	ring->watermark_armed = 0;
+	buffer->ring = ring;
+	return buffer;
+}
+
 void mpf_buffer_destroy(mpf_buffer_t *buffer)
 {
 	if(buffer->guard) {
@@ -60,8 +135,21 @@ void mpf_buffer_destroy(mpf_buffer_t *buffer)
 
 apt_bool_t mpf_buffer_restart(mpf_buffer_t *buffer)
 {
+	if(buffer->ring) {
+		mpf_buffer_ring_t *ring = buffer->ring;
+		/* the consumer skips everything written so far on its next read */
+		apr_atomic_set32(&ring->restart_event_pos,ring->event_write_pos);
+		apr_atomic_set32(&ring->restart_pos,ring->write_pos);
+		apr_atomic_set32(&ring->watermark_armed,0);
+		apr_atomic_set32(&ring->restart,1);
+		return TRUE;
+	}
 	apr_thread_mutex_lock(buffer->guard);
 	APR_RING_INIT(&buffer->head, mpf_chunk_t, link);
+	buffer->cur_chunk = NULL;
+	buffer->remaining_chunk_size = 0;
+	buffer->size = 0;
+	buffer->watermark_armed = FALSE;
 	apr_thread_mutex_unlock(buffer->guard);
 	return TRUE;
 }
@@ -82,10 +170,109 @@ static APR_INLINE mpf_chunk_t* mpf_buffer_chunk_read(mpf_buffer_t *buffer)
 	return chunk;
 }
 
+static apt_bool_t mpf_buffer_ring_audio_write(mpf_buffer_ring_t *ring, const void *data, apr_size_t size)
+{
+	apr_uint32_t write_pos = ring->write_pos;
+	apr_uint32_t offset = write_pos & ring->mask;
+	apr_size_t tail_size = ring->mask + 1 - offset;
+	if(size > ring->mask + 1 - (write_pos - mpf_buffer_load(&ring->read_pos))) {
+		/* doesn't fit, the producer should wait for the watermark */
+		return FALSE;
+	}
+
+	if(size <= tail_size) {
+		memcpy(ring->data + offset,data,size);
+	}
+	else {
+		memcpy(ring->data + offset,data,tail_size);
+		memcpy(ring->data,(const char*)data + tail_size,size - tail_size);
+	}
+	/* publish the data to the consumer */
+	apr_atomic_set32(&ring->write_pos,write_pos + (apr_uint32_t)size);
+	apr_atomic_set32(&ring->watermark_armed,1);
+	return TRUE;
+}
+
+static apt_bool_t mpf_buffer_ring_event_write(mpf_buffer_ring_t *ring, mpf_frame_type_e event_type)
+{
+	apr_uint32_t event_write_pos = ring->event_write_pos;
+	mpf_buffer_event_t *event;
+	if(event_write_pos - mpf_buffer_load(&ring->event_read_pos) >= MPF_BUFFER_EVENT_COUNT) {
+		return FALSE;
+	}
+	event = &ring->events[event_write_pos % MPF_BUFFER_EVENT_COUNT];
+	event->pos = ring->write_pos;
+	event->type = event_type;
+	apr_atomic_set32(&ring->event_write_pos,event_write_pos + 1);
+	return TRUE;
+}
+
+static void mpf_buffer_ring_frame_read(mpf_buffer_t *buffer, mpf_frame_t *media_frame)
+{
+	mpf_buffer_ring_t *ring = buffer->ring;
+	apr_uint32_t read_pos;
+	apr_uint32_t write_pos;
+	apr_uint32_t event_read_pos;
+	apr_uint32_t offset;
+	apr_size_t size = media_frame->codec_frame.size;
+	apr_size_t available;
+	apr_size_t tail_size;
+	char *dest = media_frame->codec_frame.buffer;
+
+	read_pos = ring->read_pos;
+	event_read_pos = ring->event_read_pos;
+	if(ring->restart && apr_atomic_xchg32(&ring->restart,0) == 1) {
+		read_pos = mpf_buffer_load(&ring->restart_pos);
+		event_read_pos = mpf_buffer_load(&ring->restart_event_pos);
+	}
+
+	write_pos = mpf_buffer_load(&ring->write_pos);
+	available = write_pos - read_pos;
+	if(size > available) {
+		memset(dest + available,0,size - available);
+		size = available;
+	}
+	if(size) {
+		offset = read_pos & ring->mask;
+		tail_size = ring->mask + 1 - offset;
+		if(size <= tail_size) {
+			memcpy(dest,ring->data + offset,size);
+		}
+		else {
+			memcpy(dest,ring->data + offset,tail_size);
+			memcpy(dest + tail_size,ring->data,size - tail_size);
+		}
+		read_pos += (apr_uint32_t)size;
+		media_frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+	}
+
+	/* raise the events, which the audio written before is read of */
+	while(event_read_pos != mpf_buffer_load(&ring->event_write_pos)) {
+		const mpf_buffer_event_t *event = &ring->events[event_read_pos % MPF_BUFFER_EVENT_COUNT];
+		if((apr_int32_t)(event->pos - read_pos) > 0) {
+			break;
+		}
+		media_frame->type |= event->type;
+		event_read_pos++;
+	}
+
+	/* release the space to the producer */
+	apr_atomic_set32(&ring->event_read_pos,event_read_pos);
+	apr_atomic_set32(&ring->read_pos,read_pos);
+
+	if(buffer->watermark_handler && write_pos - read_pos < buffer->watermark_size &&
+		ring->watermark_armed && apr_atomic_cas32(&ring->watermark_armed,0,1) == 1) {
+		buffer->watermark_handler(buffer,buffer->watermark_obj);
+	}
+}
+
 apt_bool_t mpf_buffer_audio_write(mpf_buffer_t *buffer, void *data, apr_size_t size)
 {
 	mpf_chunk_t *chunk;
 	apt_bool_t status;
+	if(buffer->ring) {
+		return mpf_buffer_ring_audio_write(buffer->ring,data,size);
+	}
 	apr_thread_mutex_lock(buffer->guard);
 
 	chunk = apr_palloc(buffer->pool,sizeof(mpf_chunk_t));
@@ -97,6 +284,7 @@ apt_bool_t mpf_buffer_audio_write(mpf_buffer_t *buffer, void *data, apr_size_t s
 	status = mpf_buffer_chunk_write(buffer,chunk);
 	
 	buffer->size += size;
+	buffer->watermark_armed = TRUE;
 	apr_thread_mutex_unlock(buffer->guard);
 	return status;
 }
@@ -105,6 +293,9 @@ apt_bool_t mpf_buffer_event_write(mpf_buffer_t *buffer, mpf_frame_type_e event_t
 {
 	mpf_chunk_t *chunk;
 	apt_bool_t status;
+	if(buffer->ring) {
+		return mpf_buffer_ring_event_write(buffer->ring,event_type);
+	}
 	apr_thread_mutex_lock(buffer->guard);
 
 	chunk = apr_palloc(buffer->pool,sizeof(mpf_chunk_t));
@@ -122,7 +313,12 @@ apt_bool_t mpf_buffer_frame_read(mpf_buffer_t *buffer, mpf_frame_t *media_frame)
 {
 	mpf_codec_frame_t *dest;
 	mpf_codec_frame_t *src;
+	mpf_buffer_watermark_f watermark_handler = NULL;
 	apr_size_t remaining_frame_size = media_frame->codec_frame.size;
+	if(buffer->ring) {
+		mpf_buffer_ring_frame_read(buffer,media_frame);
+		return TRUE;
+	}
 	apr_thread_mutex_lock(buffer->guard);
 	do {
 		if(!buffer->cur_chunk) {
@@ -165,11 +361,41 @@ apt_bool_t mpf_buffer_frame_read(mpf_buffer_t *buffer, mpf_frame_t *media_frame)
 		apr_size_t offset = media_frame->codec_frame.size - remaining_frame_size;
 		memset((char*)media_frame->codec_frame.buffer + offset, 0, remaining_frame_size);
 	}
+	if(buffer->watermark_handler && buffer->watermark_armed == TRUE && buffer->size < buffer->watermark_size) {
+		buffer->watermark_armed = FALSE;
+		watermark_handler = buffer->watermark_handler;
+	}
 	apr_thread_mutex_unlock(buffer->guard);
+
+	if(watermark_handler) {
+		/* request the next chunk outside of the lock, the producer may write it right away */
+		watermark_handler(buffer,buffer->watermark_obj);
+	}
 	return TRUE;
 }
 
 apr_size_t mpf_buffer_get_size(const mpf_buffer_t *buffer)
 {
+	if(buffer->ring) {
+		return buffer->ring->write_pos - buffer->ring->read_pos;
+	}
 	return buffer->size;
 }
+
+apr_size_t mpf_buffer_space_get(const mpf_buffer_t *buffer)
+{
+	if(buffer->ring) {
+		return buffer->ring->mask + 1 - (buffer->ring->write_pos - buffer->ring->read_pos);
+	}
+	return (apr_size_t)-1;
+}
+
+apt_bool_t mpf_buffer_watermark_set(mpf_buffer_t *buffer, apr_size_t size, mpf_buffer_watermark_f handler, void *obj)
+{
+	apr_thread_mutex_lock(buffer->guard);
+	buffer->watermark_size = size;
+	buffer->watermark_handler = handler;
+	buffer->watermark_obj = obj;
+	apr_thread_mutex_unlock(buffer->guard);
+	return TRUE;
+}
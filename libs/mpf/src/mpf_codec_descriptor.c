@@ -18,6 +18,7 @@
 
 #include "mpf_codec_descriptor.h"
 #include "mpf_named_event.h"
+#include "mpf_comfort_noise.h"
 #include "mpf_rtp_pt.h"
 
 /* linear PCM (host horder) */
@@ -32,10 +33,48 @@ static const mpf_codec_attribs_t lpcm_attribs = {
 	MPF_SAMPLE_RATE_32000 | MPF_SAMPLE_RATE_48000 /* supported sampling rates */
 };
 
+/* codecs, which RTP clock rate differs from the sampling rate */
+#define G722_CODEC_NAME        "G722"
+#define G722_CODEC_NAME_LENGTH (sizeof(G722_CODEC_NAME)-1)
+#define OPUS_CODEC_NAME        "opus"
+#define OPUS_CODEC_NAME_LENGTH (sizeof(OPUS_CODEC_NAME)-1)
+
+/* G.722 is clocked at 8000 for historical reasons (RFC 3551) */
+#define G722_RTP_CLOCK_RATE    8000
+/* Opus is always clocked at 48000 and signaled as stereo (RFC 7587) */
+#define OPUS_RTP_CLOCK_RATE    48000
+#define OPUS_RTP_CHANNEL_COUNT 2
+/* Opus is decoded to and encoded from mono wideband, which 16 kHz engines use */
+#define OPUS_SAMPLING_RATE     16000
+
+static const apt_str_t g722_name = {G722_CODEC_NAME, G722_CODEC_NAME_LENGTH};
+static const apt_str_t opus_name = {OPUS_CODEC_NAME, OPUS_CODEC_NAME_LENGTH};
+
+/* codec frame time base (msec) */
+static apr_uint16_t codec_frame_time_base = CODEC_FRAME_TIME_DEFAULT;
+
 /** Find matched attribs in codec capabilities by descriptor specified */
 static mpf_codec_attribs_t* mpf_codec_capabilities_attribs_find(const mpf_codec_capabilities_t *capabilities, const mpf_codec_descriptor_t *descriptor);
+/** Find attribs in codec capabilities of the very codec of the descriptor specified */
+static mpf_codec_attribs_t* mpf_codec_capabilities_native_attribs_find(const mpf_codec_capabilities_t *capabilities, const mpf_codec_descriptor_t *descriptor);
 
 
+/** Set codec frame time base */
+MPF_DECLARE(apt_bool_t) mpf_codec_frame_time_base_set(apr_uint16_t frame_time)
+{
+	if(!frame_time || frame_time > CODEC_FRAME_TIME_MAX || frame_time % CODEC_FRAME_TIME_DEFAULT != 0) {
+		return FALSE;
+	}
+	codec_frame_time_base = frame_time;
+	return TRUE;
+}
+
+/** Get codec frame time base */
+MPF_DECLARE(apr_uint16_t) mpf_codec_frame_time_base_get(void)
+{
+	return codec_frame_time_base;
+}
+
 /** Get sampling rate mask (mpf_sample_rate_e) by integer value  */
 MPF_DECLARE(int) mpf_sample_rate_mask_get(apr_uint16_t sampling_rate)
 {
@@ -52,6 +91,55 @@ MPF_DECLARE(int) mpf_sample_rate_mask_get(apr_uint16_t sampling_rate)
 	return MPF_SAMPLE_RATE_NONE;
 }
 
+/** Get RTP clock rate of the codec */
+MPF_DECLARE(apr_uint32_t) mpf_codec_rtp_clock_rate_get(const mpf_codec_descriptor_t *descriptor)
+{
+	if(descriptor->payload_type == RTP_PT_G722 || apt_string_compare(&descriptor->name,&g722_name) == TRUE) {
+		return G722_RTP_CLOCK_RATE;
+	}
+	if(apt_string_compare(&descriptor->name,&opus_name) == TRUE) {
+		return OPUS_RTP_CLOCK_RATE;
+	}
+	return descriptor->sampling_rate;
+}
+
+/** Get channel count to signal in rtpmap */
+MPF_DECLARE(apr_byte_t) mpf_codec_rtp_channel_count_get(const mpf_codec_descriptor_t *descriptor)
+{
+	if(apt_string_compare(&descriptor->name,&opus_name) == TRUE) {
+		return OPUS_RTP_CHANNEL_COUNT;
+	}
+	return descriptor->channel_count;
+}
+
+/** Set sampling rate and channel count by the clock rate and channel count of rtpmap */
+MPF_DECLARE(void) mpf_codec_rtpmap_apply(mpf_codec_descriptor_t *descriptor, apr_uint32_t clock_rate, apr_byte_t channel_count)
+{
+	if(apt_string_compare(&descriptor->name,&g722_name) == TRUE) {
+		descriptor->sampling_rate = 16000;
+		descriptor->channel_count = 1;
+	}
+	else if(apt_string_compare(&descriptor->name,&opus_name) == TRUE) {
+		/* the stereo signaled is a capability of the receiver, mono is sent and accepted */
+		descriptor->sampling_rate = OPUS_SAMPLING_RATE;
+		descriptor->channel_count = 1;
+	}
+	else {
+		descriptor->sampling_rate = (apr_uint16_t)clock_rate;
+		descriptor->channel_count = channel_count ? channel_count : 1;
+	}
+}
+
+/** Get max number of codec frames an RTP packet may carry */
+MPF_DECLARE(apr_size_t) mpf_codec_packet_frames_max_get(const mpf_codec_descriptor_t *descriptor)
+{
+	if(apt_string_compare(&descriptor->name,&opus_name) == TRUE) {
+		/* encoded Opus frames cannot be concatenated, each one makes a packet */
+		return 1;
+	}
+	return 0;
+}
+
 static APR_INLINE apt_bool_t mpf_sampling_rate_check(apr_uint16_t sampling_rate, int mask)
 {
 	return (mpf_sample_rate_mask_get(sampling_rate) & mask) ? TRUE : FALSE;
@@ -73,7 +161,11 @@ MPF_DECLARE(mpf_codec_descriptor_t*) mpf_codec_descriptor_create_by_capabilities
 	mpf_codec_descriptor_t *descriptor;
 	mpf_codec_attribs_t *attribs = NULL;
 	if(capabilities && peer) {
-		attribs = mpf_codec_capabilities_attribs_find(capabilities,peer);
+		/* the codec of the peer is preferred, if listed, so that no transcoding is needed */
+		attribs = mpf_codec_capabilities_native_attribs_find(capabilities,peer);
+		if(!attribs) {
+			attribs = mpf_codec_capabilities_attribs_find(capabilities,peer);
+		}
 	}
 	
 	if(!attribs) {
@@ -171,6 +263,20 @@ static mpf_codec_attribs_t* mpf_codec_capabilities_attribs_find(const mpf_codec_
 	return NULL;
 }
 
+static mpf_codec_attribs_t* mpf_codec_capabilities_native_attribs_find(const mpf_codec_capabilities_t *capabilities, const mpf_codec_descriptor_t *descriptor)
+{
+	int i;
+	mpf_codec_attribs_t *attribs;
+	for(i=0; i<capabilities->attrib_arr->nelts; i++) {
+		attribs = &APR_ARRAY_IDX(capabilities->attrib_arr,i,mpf_codec_attribs_t);
+		if(apt_string_compare(&attribs->name,&descriptor->name) == TRUE &&
+			mpf_sampling_rate_check(descriptor->sampling_rate,attribs->sample_rates) == TRUE) {
+			return attribs;
+		}
+	}
+	return NULL;
+}
+
 /** Match codec list with specified capabilities */
 MPF_DECLARE(apt_bool_t) mpf_codec_list_match(mpf_codec_list_t *codec_list, const mpf_codec_capabilities_t *capabilities)
 {
@@ -206,8 +312,10 @@ MPF_DECLARE(apt_bool_t) mpf_codec_lists_intersect(mpf_codec_list_t *codec_list1,
 	mpf_codec_descriptor_t *descriptor2;
 	codec_list1->primary_descriptor = NULL;
 	codec_list1->event_descriptor = NULL;
+	codec_list1->cn_descriptor = NULL;
 	codec_list2->primary_descriptor = NULL;
 	codec_list2->event_descriptor = NULL;
+	codec_list2->cn_descriptor = NULL;
 	/* find only one match for primary and named event descriptors,
 	set the matched descriptors as preffered, disable the others */
 	for(i=0; i<codec_list1->descriptor_arr->nelts; i++) {
@@ -217,6 +325,11 @@ MPF_DECLARE(apt_bool_t) mpf_codec_lists_intersect(mpf_codec_list_t *codec_list1,
 			continue;
 		}
 
+		/* comfort noise descriptors are matched against the primary one below */
+		if(mpf_cn_descriptor_check(descriptor1) == TRUE) {
+			continue;
+		}
+
 		/* check whether this is a named event descriptor */
 		if(mpf_event_descriptor_check(descriptor1) == TRUE) {
 			/* named event descriptor */
@@ -260,9 +373,30 @@ MPF_DECLARE(apt_bool_t) mpf_codec_lists_intersect(mpf_codec_list_t *codec_list1,
 		}
 	}
 
+	/* find a comfort noise descriptor of the same clock rate as the primary one */
+	for(i=0; i<codec_list1->descriptor_arr->nelts; i++) {
+		descriptor1 = &APR_ARRAY_IDX(codec_list1->descriptor_arr,i,mpf_codec_descriptor_t);
+		if(descriptor1->enabled == FALSE || mpf_cn_descriptor_check(descriptor1) == FALSE) {
+			continue;
+		}
+
+		descriptor1->enabled = FALSE;
+		if(!codec_list1->cn_descriptor && codec_list1->primary_descriptor &&
+			descriptor1->sampling_rate == mpf_codec_rtp_clock_rate_get(codec_list1->primary_descriptor)) {
+			/* find if there is a match */
+			descriptor2 = mpf_codec_list_descriptor_find(codec_list2,descriptor1);
+			if(descriptor2 && descriptor2->enabled == TRUE) {
+				descriptor1->enabled = TRUE;
+				codec_list1->cn_descriptor = descriptor1;
+				codec_list2->cn_descriptor = descriptor2;
+			}
+		}
+	}
+
 	for(i=0; i<codec_list2->descriptor_arr->nelts; i++) {
 		descriptor2 = &APR_ARRAY_IDX(codec_list2->descriptor_arr,i,mpf_codec_descriptor_t);
-		if(descriptor2 == codec_list2->primary_descriptor || descriptor2 == codec_list2->event_descriptor) {
+		if(descriptor2 == codec_list2->primary_descriptor || descriptor2 == codec_list2->event_descriptor ||
+			descriptor2 == codec_list2->cn_descriptor) {
 			descriptor2->enabled = TRUE;
 		}
 		else {
@@ -18,6 +18,7 @@
 
 #include "mpf_codec.h"
 #include "mpf_rtp_pt.h"
+#include "mpf_g711_kernel.h"
 #include "g711/g711.h"
 
 #define G711u_CODEC_NAME        "PCMU"
@@ -38,37 +39,15 @@ static apt_bool_t g711_close(mpf_codec_t *codec)
 
 static apt_bool_t g711u_encode(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
 {
-	const apr_int16_t *decode_buf;
-	unsigned char *encode_buf;
-	apr_size_t i;
-
-	decode_buf = frame_in->buffer;
-	encode_buf = frame_out->buffer;
-
 	frame_out->size = frame_in->size / sizeof(apr_int16_t);
-
-	for(i=0; i<frame_out->size; i++) {
-		encode_buf[i] = linear_to_ulaw(decode_buf[i]);
-	}
-
+	mpf_g711_kernel_best_get()->ulaw_encode(frame_in->buffer,frame_out->buffer,frame_out->size);
 	return TRUE;
 }
 
 static apt_bool_t g711u_decode(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
 {
-	apr_int16_t *decode_buf;
-	const unsigned char *encode_buf;
-	apr_size_t i;
-
-	decode_buf = frame_out->buffer;
-	encode_buf = frame_in->buffer;
-
 	frame_out->size = frame_in->size * sizeof(apr_int16_t);
-
-	for(i=0; i<frame_in->size; i++) {
-		decode_buf[i] = ulaw_to_linear(encode_buf[i]);
-	}
-
+	mpf_g711_kernel_best_get()->ulaw_decode(frame_in->buffer,frame_out->buffer,frame_in->size);
 	return TRUE;
 }
 
@@ -85,37 +64,15 @@ static apt_bool_t g711u_init(mpf_codec_t *codec, mpf_codec_frame_t *frame_out)
 
 static apt_bool_t g711a_encode(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
 {
-	const apr_int16_t *decode_buf;
-	unsigned char *encode_buf;
-	apr_size_t i;
-
-	decode_buf = frame_in->buffer;
-	encode_buf = frame_out->buffer;
-
 	frame_out->size = frame_in->size / sizeof(apr_int16_t);
-
-	for(i=0; i<frame_out->size; i++) {
-		encode_buf[i] = linear_to_alaw(decode_buf[i]);
-	}
-
+	mpf_g711_kernel_best_get()->alaw_encode(frame_in->buffer,frame_out->buffer,frame_out->size);
 	return TRUE;
 }
 
 static apt_bool_t g711a_decode(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
 {
-	apr_int16_t *decode_buf;
-	const unsigned char *encode_buf;
-	apr_size_t i;
-
-	decode_buf = frame_out->buffer;
-	encode_buf = frame_in->buffer;
-
 	frame_out->size = frame_in->size * sizeof(apr_int16_t);
-
-	for(i=0; i<frame_in->size; i++) {
-		decode_buf[i] = alaw_to_linear(encode_buf[i]);
-	}
-
+	mpf_g711_kernel_best_get()->alaw_decode(frame_in->buffer,frame_out->buffer,frame_in->size);
 	return TRUE;
 }
 
@@ -136,7 +93,8 @@ static const mpf_codec_vtable_t g711u_vtable = {
 	g711u_encode,
 	g711u_decode,
 	NULL,
-	g711u_init
+	g711u_init,
+	NULL
 };
 
 static const mpf_codec_vtable_t g711a_vtable = {
@@ -145,7 +103,8 @@ static const mpf_codec_vtable_t g711a_vtable = {
 	g711a_encode,
 	g711a_decode,
 	NULL,
-	g711a_init
+	g711a_init,
+	NULL
 };
 
 static const mpf_codec_descriptor_t g711u_descriptor = {
@@ -182,10 +141,13 @@ static const mpf_codec_attribs_t g711a_attribs = {
 
 mpf_codec_t* mpf_codec_g711u_create(apr_pool_t *pool)
 {
+	/* detect the kernels once at startup rather than on the first frame */
+	mpf_g711_kernel_best_get();
 	return mpf_codec_create(&g711u_vtable,&g711u_attribs,&g711u_descriptor,pool);
 }
 
 mpf_codec_t* mpf_codec_g711a_create(apr_pool_t *pool)
 {
+	mpf_g711_kernel_best_get();
 	return mpf_codec_create(&g711a_vtable,&g711a_attribs,&g711a_descriptor,pool);
 }
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+#include "mpf_codec.h"
+#include "mpf_rtp_pt.h"
+#include "g722/g722.h"
+
+#define G722_CODEC_NAME        "G722"
+#define G722_CODEC_NAME_LENGTH (sizeof(G722_CODEC_NAME)-1)
+
+/** G.722 codec state (ADPCM is stateful, unlike G.711) */
+typedef struct mpf_g722_t mpf_g722_t;
+
+struct mpf_g722_t {
+	g722_state_t encoder;
+	g722_state_t decoder;
+};
+
+static apt_bool_t g722_open(mpf_codec_t *codec)
+{
+	mpf_g722_t *g722 = codec->obj;
+	if(!g722) {
+		g722 = apr_palloc(codec->pool,sizeof(mpf_g722_t));
+		codec->obj = g722;
+	}
+	g722_state_init(&g722->encoder);
+	g722_state_init(&g722->decoder);
+	return TRUE;
+}
+
+static apt_bool_t g722_close(mpf_codec_t *codec)
+{
+	return TRUE;
+}
+
+static apt_bool_t g722_encode_frame(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
+{
+	mpf_g722_t *g722 = codec->obj;
+	if(!g722) {
+		return FALSE;
+	}
+	frame_out->size = g722_encode(&g722->encoder,frame_in->buffer,frame_in->size / sizeof(apr_int16_t),frame_out->buffer);
+	return TRUE;
+}
+
+static apt_bool_t g722_decode_frame(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
+{
+	mpf_g722_t *g722 = codec->obj;
+	if(!g722) {
+		return FALSE;
+	}
+	frame_out->size = g722_decode(&g722->decoder,frame_in->buffer,frame_in->size,frame_out->buffer) * sizeof(apr_int16_t);
+	return TRUE;
+}
+
+static apt_bool_t g722_init(mpf_codec_t *codec, mpf_codec_frame_t *frame_out)
+{
+	/* codewords of silence as encoded from the reset state */
+	g722_state_t state;
+	apr_int16_t silence[2] = {0, 0};
+	apr_byte_t *encode_buf = frame_out->buffer;
+	apr_size_t i;
+	g722_state_init(&state);
+	for(i=0; i<frame_out->size; i++) {
+		g722_encode(&state,silence,2,&encode_buf[i]);
+	}
+	return TRUE;
+}
+
+static const mpf_codec_vtable_t g722_vtable = {
+	g722_open,
+	g722_close,
+	g722_encode_frame,
+	g722_decode_frame,
+	NULL,
+	g722_init,
+	NULL
+};
+
+static const mpf_codec_descriptor_t g722_descriptor = {
+	RTP_PT_G722,
+	{G722_CODEC_NAME, G722_CODEC_NAME_LENGTH},
+	16000,
+	1,
+	{NULL, 0},
+	TRUE
+};
+
+static const mpf_codec_attribs_t g722_attribs = {
+	{G722_CODEC_NAME, G722_CODEC_NAME_LENGTH},    /* codec name */
+	4,                                            /* bits per sample */
+	MPF_SAMPLE_RATE_16000                         /* supported sampling rates */
+};
+
+mpf_codec_t* mpf_codec_g722_create(apr_pool_t *pool)
+{
+	return mpf_codec_create(&g722_vtable,&g722_attribs,&g722_descriptor,pool);
+}
@@ -17,10 +17,21 @@
  */
 
 #define APR_WANT_BYTEFUNC
+#define APR_WANT_MEMFUNC
 #include <apr_want.h>
 #include "mpf_codec.h"
 #include "mpf_rtp_pt.h"
 
+#if (APR_IS_BIGENDIAN == 0)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define L16_SWAP_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define L16_SWAP_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
 /* linear 16-bit PCM (RFC3551) */
 #define L16_CODEC_NAME        "L16"
 #define L16_CODEC_NAME_LENGTH (sizeof(L16_CODEC_NAME)-1)
@@ -36,35 +47,45 @@ static apt_bool_t l16_close(mpf_codec_t *codec)
 	return TRUE;
 }
 
-static apt_bool_t l16_encode(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
+/** Copy samples converting between host and network byte order (the same swap either way) */
+static void l16_swap(const apr_int16_t *buf_in, apr_int16_t *buf_out, apr_size_t samples)
 {
-	apr_uint32_t i;
-	const apr_int16_t *buf_in = frame_in->buffer;
-	apr_int16_t *buf_out = frame_out->buffer;
-	apr_size_t samples = frame_in->size / sizeof(apr_int16_t);
-
-	frame_out->size = frame_in->size;
-
-	for(i=0; i<samples; i++) {
+	apr_size_t i = 0;
+#if (APR_IS_BIGENDIAN == 1)
+	if(buf_out != buf_in) {
+		memcpy(buf_out,buf_in,samples * sizeof(apr_int16_t));
+	}
+	return;
+#elif defined(L16_SWAP_SSE2)
+	/* two shifts and an or per 8 samples, no need for SSSE3 pshufb and a CPU check */
+	for(; i + 8 <= samples; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(buf_in + i));
+		v = _mm_or_si128(_mm_slli_epi16(v,8),_mm_srli_epi16(v,8));
+		_mm_storeu_si128((__m128i*)(buf_out + i),v);
+	}
+#elif defined(L16_SWAP_NEON)
+	for(; i + 8 <= samples; i += 8) {
+		uint8x16_t v = vld1q_u8((const uint8_t*)(buf_in + i));
+		vst1q_u8((uint8_t*)(buf_out + i),vrev16q_u8(v));
+	}
+#endif
+	/* the tail of a frame not a multiple of 8 samples */
+	for(; i<samples; i++) {
 		buf_out[i] = htons(buf_in[i]);
 	}
+}
 
+static apt_bool_t l16_encode(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
+{
+	frame_out->size = frame_in->size;
+	l16_swap(frame_in->buffer,frame_out->buffer,frame_in->size / sizeof(apr_int16_t));
 	return TRUE;
 }
 
 static apt_bool_t l16_decode(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
 {
-	apr_uint32_t i;
-	const apr_int16_t *buf_in = frame_in->buffer;
-	apr_int16_t *buf_out = frame_out->buffer;
-	apr_size_t samples = frame_in->size / sizeof(apr_int16_t);
-
 	frame_out->size = frame_in->size;
-
-	for(i=0; i<samples; i++) {
-		buf_out[i] = ntohs(buf_in[i]);
-	}
-
+	l16_swap(frame_in->buffer,frame_out->buffer,frame_in->size / sizeof(apr_int16_t));
 	return TRUE;
 }
 
@@ -74,6 +95,7 @@ static const mpf_codec_vtable_t l16_vtable = {
 	l16_encode,
 	l16_decode,
 	NULL,
+	NULL,
 	NULL
 };
 
@@ -17,12 +17,63 @@
  */
 
 #include <stdlib.h>
+#include <apr_lib.h>
+#include <apr_hash.h>
+#include <apr_thread_mutex.h>
 #include "mpf_codec_manager.h"
 #include "mpf_rtp_pt.h"
 #include "mpf_named_event.h"
+#include "mpf_comfort_noise.h"
 #include "apt_log.h"
 
 
+/** Number of distinct negotiations kept in the cache */
+#define NEGOTIATION_CACHE_SIZE  16
+/** Max size of the normalized key of a negotiation */
+#define NEGOTIATION_KEY_SIZE    512
+/** Max number of descriptors in a list (bits of enabled mask) */
+#define NEGOTIATION_MAX_CODECS  32
+
+typedef struct codec_list_result_t codec_list_result_t;
+typedef struct codec_negotiation_t codec_negotiation_t;
+typedef struct codec_negotiation_cache_t codec_negotiation_cache_t;
+
+/** Outcome of negotiation for one of the lists */
+struct codec_list_result_t {
+	/** Mask of enabled descriptors */
+	apr_uint32_t enabled;
+	/** Index of primary descriptor or -1 */
+	int          primary;
+	/** Index of named event descriptor or -1 */
+	int          event;
+	/** Index of comfort noise descriptor or -1 */
+	int          cn;
+};
+
+/** Cached negotiation */
+struct codec_negotiation_t {
+	/** Normalized codec lists */
+	char                key[NEGOTIATION_KEY_SIZE];
+	/** Length of the key, 0 for unused entry */
+	apr_size_t          key_length;
+	/** Hash of the key */
+	unsigned int        key_hash;
+	/** Status of the intersection */
+	apt_bool_t          status;
+	/** Outcome for the preferred list */
+	codec_list_result_t result1;
+	/** Outcome for the other list */
+	codec_list_result_t result2;
+};
+
+/** Cache of recent negotiations shared by media engines */
+struct codec_negotiation_cache_t {
+	apr_thread_mutex_t *guard;
+	codec_negotiation_t entries[NEGOTIATION_CACHE_SIZE];
+	/** Next entry to replace (round robin) */
+	apr_size_t          next;
+};
+
 struct mpf_codec_manager_t {
 	/** Memory pool */
 	apr_pool_t             *pool;
@@ -31,6 +82,10 @@ struct mpf_codec_manager_t {
 	apr_array_header_t     *codec_arr;
 	/** Default named event descriptor */
 	mpf_codec_descriptor_t *event_descriptor;
+	/** Default comfort noise descriptor (offered only if listed in config) */
+	mpf_codec_descriptor_t *cn_descriptor;
+	/** Results of recent negotiations */
+	codec_negotiation_cache_t *negotiation_cache;
 };
 
 
@@ -40,12 +95,20 @@ MPF_DECLARE(mpf_codec_manager_t*) mpf_codec_manager_create(apr_size_t codec_coun
 	codec_manager->pool = pool;
 	codec_manager->codec_arr = apr_array_make(pool,(int)codec_count,sizeof(mpf_codec_t*));
 	codec_manager->event_descriptor = mpf_event_descriptor_create(8000,pool);
+	codec_manager->cn_descriptor = mpf_cn_descriptor_create(8000,pool);
+	codec_manager->negotiation_cache = apr_pcalloc(pool,sizeof(codec_negotiation_cache_t));
+	if(apr_thread_mutex_create(&codec_manager->negotiation_cache->guard,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		codec_manager->negotiation_cache = NULL;
+	}
 	return codec_manager;
 }
 
 MPF_DECLARE(void) mpf_codec_manager_destroy(mpf_codec_manager_t *codec_manager)
 {
-	/* nothing to do */
+	if(codec_manager->negotiation_cache) {
+		apr_thread_mutex_destroy(codec_manager->negotiation_cache->guard);
+		codec_manager->negotiation_cache = NULL;
+	}
 }
 
 MPF_DECLARE(apt_bool_t) mpf_codec_manager_codec_register(mpf_codec_manager_t *codec_manager, mpf_codec_t *codec)
@@ -131,16 +194,20 @@ static apt_bool_t mpf_codec_manager_codec_parse(const mpf_codec_manager_t *codec
 			}
 			else {
 				descriptor->payload_type = RTP_PT_DYNAMIC;
-				descriptor->sampling_rate = 8000;
-				descriptor->channel_count = 1;
+				mpf_codec_rtpmap_apply(descriptor,8000,1);
 			}
 		}
 		else {
 			mpf_codec_descriptor_t *event_descriptor = codec_manager->event_descriptor;
+			mpf_codec_descriptor_t *cn_descriptor = codec_manager->cn_descriptor;
 			if(event_descriptor && apt_string_compare(&event_descriptor->name,&name) == TRUE) {
 				descriptor = mpf_codec_list_add(codec_list);
 				*descriptor = *event_descriptor;
 			}
+			else if(cn_descriptor && apt_string_compare(&cn_descriptor->name,&name) == TRUE) {
+				descriptor = mpf_codec_list_add(codec_list);
+				*descriptor = *cn_descriptor;
+			}
 			else {
 				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Such Codec [%s]",str);
 				return FALSE;
@@ -153,16 +220,18 @@ static apt_bool_t mpf_codec_manager_codec_parse(const mpf_codec_manager_t *codec
 		if(str) {
 			descriptor->payload_type = (apr_byte_t)atol(str);
 
-			/* parse optional sampling rate */
+			/* parse optional sampling rate (RTP clock rate as in rtpmap) */
 			str = apr_strtok(codec_desc_str, separator, &state);
 			if(str) {
-				descriptor->sampling_rate = (apr_uint16_t)atol(str);
+				apr_uint32_t clock_rate = (apr_uint32_t)atol(str);
+				apr_byte_t channel_count = 0;
 
 				/* parse optional channel count */
 				str = apr_strtok(codec_desc_str, separator, &state);
 				if(str) {
-					descriptor->channel_count = (apr_byte_t)atol(str);
+					channel_count = (apr_byte_t)atol(str);
 				}
+				mpf_codec_rtpmap_apply(descriptor,clock_rate,channel_count);
 			}
 		}
 	}
@@ -197,3 +266,126 @@ MPF_DECLARE(const mpf_codec_t*) mpf_codec_manager_codec_find(const mpf_codec_man
 	}
 	return NULL;
 }
+
+/** Append normalized codec list to the key, all the attributes the matching depends on are included */
+static apt_bool_t codec_negotiation_key_append(const mpf_codec_list_t *codec_list, char *key, apr_size_t *length)
+{
+	int i;
+	apr_size_t j;
+	apr_size_t size;
+	const mpf_codec_descriptor_t *descriptor;
+	if(codec_list->descriptor_arr->nelts > NEGOTIATION_MAX_CODECS) {
+		return FALSE;
+	}
+
+	for(i=0; i<codec_list->descriptor_arr->nelts; i++) {
+		descriptor = &APR_ARRAY_IDX(codec_list->descriptor_arr,i,mpf_codec_descriptor_t);
+		if(*length + descriptor->name.length + 32 >= NEGOTIATION_KEY_SIZE) {
+			return FALSE;
+		}
+		size = apr_snprintf(key + *length,NEGOTIATION_KEY_SIZE - *length,"%d ",descriptor->payload_type);
+		for(j=0; j<descriptor->name.length; j++) {
+			/* names are compared case insensitive */
+			key[*length + size++] = (char)apr_tolower(descriptor->name.buf[j]);
+		}
+		size += apr_snprintf(key + *length + size,NEGOTIATION_KEY_SIZE - *length - size,"/%d/%d%c;",
+					descriptor->sampling_rate,
+					descriptor->channel_count,
+					descriptor->enabled == TRUE ? '+' : '-');
+		*length += size;
+	}
+	key[(*length)++] = '|';
+	return TRUE;
+}
+
+static int codec_list_index_get(const mpf_codec_list_t *codec_list, const mpf_codec_descriptor_t *descriptor)
+{
+	if(!descriptor) {
+		return -1;
+	}
+	return (int)(descriptor - (mpf_codec_descriptor_t*)codec_list->descriptor_arr->elts);
+}
+
+static void codec_list_result_capture(const mpf_codec_list_t *codec_list, codec_list_result_t *result)
+{
+	int i;
+	result->enabled = 0;
+	for(i=0; i<codec_list->descriptor_arr->nelts; i++) {
+		if(APR_ARRAY_IDX(codec_list->descriptor_arr,i,mpf_codec_descriptor_t).enabled == TRUE) {
+			result->enabled |= 1U << i;
+		}
+	}
+	result->primary = codec_list_index_get(codec_list,codec_list->primary_descriptor);
+	result->event = codec_list_index_get(codec_list,codec_list->event_descriptor);
+	result->cn = codec_list_index_get(codec_list,codec_list->cn_descriptor);
+}
+
+static void codec_list_result_apply(mpf_codec_list_t *codec_list, const codec_list_result_t *result)
+{
+	int i;
+	for(i=0; i<codec_list->descriptor_arr->nelts; i++) {
+		APR_ARRAY_IDX(codec_list->descriptor_arr,i,mpf_codec_descriptor_t).enabled =
+			(result->enabled & (1U << i)) ? TRUE : FALSE;
+	}
+	codec_list->primary_descriptor = mpf_codec_list_descriptor_get(codec_list,result->primary);
+	codec_list->event_descriptor = mpf_codec_list_descriptor_get(codec_list,result->event);
+	codec_list->cn_descriptor = mpf_codec_list_descriptor_get(codec_list,result->cn);
+}
+
+MPF_DECLARE(apt_bool_t) mpf_codec_manager_codec_lists_intersect(const mpf_codec_manager_t *codec_manager, mpf_codec_list_t *codec_list1, mpf_codec_list_t *codec_list2)
+{
+	codec_negotiation_cache_t *cache;
+	codec_negotiation_t *entry;
+	codec_negotiation_t negotiation;
+	apr_size_t i;
+	apt_bool_t found = FALSE;
+	apr_ssize_t key_length;
+
+	cache = codec_manager ? codec_manager->negotiation_cache : NULL;
+	negotiation.key_length = 0;
+	if(!cache ||
+		codec_negotiation_key_append(codec_list1,negotiation.key,&negotiation.key_length) == FALSE ||
+		codec_negotiation_key_append(codec_list2,negotiation.key,&negotiation.key_length) == FALSE) {
+		/* the lists are too long to be cached */
+		return mpf_codec_lists_intersect(codec_list1,codec_list2);
+	}
+
+	key_length = negotiation.key_length;
+	negotiation.key_hash = apr_hashfunc_default(negotiation.key,&key_length);
+
+	apr_thread_mutex_lock(cache->guard);
+	for(i=0; i<NEGOTIATION_CACHE_SIZE; i++) {
+		entry = &cache->entries[i];
+		if(entry->key_hash == negotiation.key_hash && entry->key_length == negotiation.key_length &&
+			memcmp(entry->key,negotiation.key,negotiation.key_length) == 0) {
+			negotiation.status = entry->status;
+			negotiation.result1 = entry->result1;
+			negotiation.result2 = entry->result2;
+			found = TRUE;
+			break;
+		}
+	}
+	apr_thread_mutex_unlock(cache->guard);
+
+	if(found == TRUE) {
+		codec_list_result_apply(codec_list1,&negotiation.result1);
+		codec_list_result_apply(codec_list2,&negotiation.result2);
+		return negotiation.status;
+	}
+
+	negotiation.status = mpf_codec_lists_intersect(codec_list1,codec_list2);
+	codec_list_result_capture(codec_list1,&negotiation.result1);
+	codec_list_result_capture(codec_list2,&negotiation.result2);
+
+	apr_thread_mutex_lock(cache->guard);
+	entry = &cache->entries[cache->next];
+	memcpy(entry->key,negotiation.key,negotiation.key_length);
+	entry->key_length = negotiation.key_length;
+	entry->key_hash = negotiation.key_hash;
+	entry->status = negotiation.status;
+	entry->result1 = negotiation.result1;
+	entry->result2 = negotiation.result2;
+	cache->next = (cache->next + 1) % NEGOTIATION_CACHE_SIZE;
+	apr_thread_mutex_unlock(cache->guard);
+	return negotiation.status;
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+#include "mpf_codec.h"
+#include "mpf_rtp_pt.h"
+#include "apt_log.h"
+
+#define OPUS_CODEC_NAME        "opus"
+#define OPUS_CODEC_NAME_LENGTH (sizeof(OPUS_CODEC_NAME)-1)
+
+#ifdef MPF_HAVE_OPUS
+
+#include <opus/opus.h>
+
+/* max duration of an Opus packet in msec */
+#define OPUS_PACKET_TIME_MAX 120
+
+/*
+ * Unlike the other codecs, Opus packets cannot be split into codec frames
+ * before they are decoded. The dissector therefore decodes a whole packet
+ * into linear PCM, and the jitter buffer slots carry 10 msec chunks of it,
+ * which makes the decode method a plain copy.
+ */
+
+/** Opus codec state */
+typedef struct mpf_opus_t mpf_opus_t;
+
+struct mpf_opus_t {
+	OpusEncoder *encoder;
+	OpusDecoder *decoder;
+	/** Decoded packet to be dissected */
+	apr_int16_t *pcm;
+	/** Size of decoded packet buffer in samples */
+	apr_size_t   pcm_count;
+};
+
+/* an unopened codec passes packets through (null bridge) */
+static apt_bool_t opus_open(mpf_codec_t *codec)
+{
+	mpf_opus_t *opus = codec->obj;
+	if(!opus) {
+		opus = apr_palloc(codec->pool,sizeof(mpf_opus_t));
+		opus->encoder = NULL;
+		opus->decoder = NULL;
+		opus->pcm = NULL;
+		opus->pcm_count = 0;
+		codec->obj = opus;
+	}
+	return TRUE;
+}
+
+static apt_bool_t opus_close(mpf_codec_t *codec)
+{
+	mpf_opus_t *opus = codec->obj;
+	if(!opus) {
+		return TRUE;
+	}
+	if(opus->encoder) {
+		opus_encoder_destroy(opus->encoder);
+		opus->encoder = NULL;
+	}
+	if(opus->decoder) {
+		opus_decoder_destroy(opus->decoder);
+		opus->decoder = NULL;
+	}
+	return TRUE;
+}
+
+/** Get sampling rate by the size of linear frame */
+static APR_INLINE opus_int32 opus_sampling_rate_get(apr_size_t linear_size)
+{
+	return (opus_int32)(linear_size / sizeof(apr_int16_t) * 1000 / CODEC_FRAME_TIME_BASE);
+}
+
+static apt_bool_t opus_encode_frame(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
+{
+	opus_int32 size;
+	mpf_opus_t *opus = codec->obj;
+	if(!opus) {
+		return FALSE;
+	}
+	if(!opus->encoder) {
+		int error;
+		opus_int32 sampling_rate = opus_sampling_rate_get(frame_in->size);
+		/* the encoder is created on the first frame, the sampling rate is known by then */
+		opus->encoder = opus_encoder_create(sampling_rate,1,OPUS_APPLICATION_VOIP,&error);
+		if(!opus->encoder) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Opus Encoder [%d]: %s",sampling_rate,opus_strerror(error));
+			return FALSE;
+		}
+		opus_encoder_ctl(opus->encoder,OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+	}
+
+	/* encoded frame never exceeds the linear one (16 bits per sample) */
+	size = opus_encode(
+				opus->encoder,
+				frame_in->buffer,
+				(int)(frame_in->size / sizeof(apr_int16_t)),
+				frame_out->buffer,
+				(opus_int32)frame_in->size);
+	if(size < 0) {
+		return FALSE;
+	}
+	frame_out->size = size;
+	return TRUE;
+}
+
+static apt_bool_t opus_decode_frame(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
+{
+	/* the frame has been decoded by the dissector */
+	memcpy(frame_out->buffer,frame_in->buffer,frame_in->size);
+	frame_out->size = frame_in->size;
+	return TRUE;
+}
+
+static apt_bool_t opus_dissect(mpf_codec_t *codec, void **buffer, apr_size_t *size, mpf_codec_frame_t *frame)
+{
+	apr_size_t frame_size;
+	mpf_opus_t *opus = codec->obj;
+	if(!opus) {
+		/* pass the packet through as is */
+		if(!*size || *size > frame->size) {
+			return FALSE;
+		}
+		memcpy(frame->buffer,*buffer,*size);
+		frame->size = *size;
+		*size = 0;
+		return TRUE;
+	}
+
+	if(!opus->pcm || *buffer < (void*)opus->pcm || *buffer >= (void*)(opus->pcm + opus->pcm_count)) {
+		/* new packet, decode it whole */
+		int samples;
+		if(!opus->decoder) {
+			int error;
+			opus_int32 sampling_rate = opus_sampling_rate_get(frame->size);
+			opus->decoder = opus_decoder_create(sampling_rate,1,&error);
+			if(!opus->decoder) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Opus Decoder [%d]: %s",sampling_rate,opus_strerror(error));
+				return FALSE;
+			}
+			opus->pcm_count = sampling_rate * OPUS_PACKET_TIME_MAX / 1000;
+			opus->pcm = apr_palloc(codec->pool,opus->pcm_count * sizeof(apr_int16_t));
+		}
+
+		samples = opus_decode(opus->decoder,*buffer,(opus_int32)*size,opus->pcm,(int)opus->pcm_count,0);
+		if(samples <= 0) {
+			return FALSE;
+		}
+		*buffer = opus->pcm;
+		*size = samples * sizeof(apr_int16_t);
+	}
+
+	/* take the next chunk of the decoded packet, a short one (2.5 or 5 msec) is padded with silence */
+	frame_size = frame->size;
+	if(*size < frame_size) {
+		memset((apr_byte_t*)frame->buffer + *size,0,frame_size - *size);
+		frame_size = *size;
+	}
+	memcpy(frame->buffer,*buffer,frame_size);
+	*buffer = (apr_byte_t*)*buffer + frame_size;
+	*size -= frame_size;
+	return TRUE;
+}
+
+static apt_bool_t opus_init(mpf_codec_t *codec, mpf_codec_frame_t *frame_out)
+{
+	if(!codec->obj) {
+		/* packet of a single zero length SILK wideband 10 msec frame (RFC 6716 3.1), decoded as concealment */
+		apr_byte_t *encode_buf = frame_out->buffer;
+		encode_buf[0] = 8 << 3;
+		frame_out->size = 1;
+		return TRUE;
+	}
+	memset(frame_out->buffer,0,frame_out->size);
+	return TRUE;
+}
+
+static apt_bool_t opus_conceal(mpf_codec_t *codec, mpf_codec_frame_t *frame_out)
+{
+	int samples;
+	mpf_opus_t *opus = codec->obj;
+	if(!opus || !opus->decoder) {
+		return FALSE;
+	}
+	/* decoding of a missing packet makes the decoder extrapolate from its state */
+	samples = opus_decode(opus->decoder,NULL,0,frame_out->buffer,(int)(frame_out->size / sizeof(apr_int16_t)),0);
+	if(samples <= 0) {
+		return FALSE;
+	}
+	frame_out->size = samples * sizeof(apr_int16_t);
+	return TRUE;
+}
+
+static const mpf_codec_vtable_t opus_vtable = {
+	opus_open,
+	opus_close,
+	opus_encode_frame,
+	opus_decode_frame,
+	opus_dissect,
+	opus_init,
+	opus_conceal
+};
+
+static const mpf_codec_attribs_t opus_attribs = {
+	{OPUS_CODEC_NAME, OPUS_CODEC_NAME_LENGTH},    /* codec name */
+	16,                                           /* bits per sample (slots carry decoded frames) */
+	MPF_SAMPLE_RATE_8000 | MPF_SAMPLE_RATE_16000 |
+	MPF_SAMPLE_RATE_48000                         /* supported sampling rates */
+};
+
+mpf_codec_t* mpf_codec_opus_create(apr_pool_t *pool)
+{
+	return mpf_codec_create(&opus_vtable,&opus_attribs,NULL,pool);
+}
+
+#else
+
+mpf_codec_t* mpf_codec_opus_create(apr_pool_t *pool)
+{
+	/* libopus is not compiled in (configure --enable-opus) */
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <math.h>
+#include "mpf_comfort_noise.h"
+#include "mpf_rtp_pt.h"
+
+#define CN_NAME        "CN"
+#define CN_NAME_LENGTH (sizeof(CN_NAME)-1)
+
+/** Max level carried in CN payload (-127 dBov) */
+#define CN_LEVEL_MAX   127
+/** Overload point of 16-bit linear samples */
+#define CN_OVERLOAD    32767.0f
+
+MPF_DECLARE(mpf_codec_descriptor_t*) mpf_cn_descriptor_create(apr_uint16_t sampling_rate, apr_pool_t *pool)
+{
+	mpf_codec_descriptor_t *descriptor = apr_palloc(pool,sizeof(mpf_codec_descriptor_t));
+	mpf_codec_descriptor_init(descriptor);
+	descriptor->payload_type = (sampling_rate == 8000) ? RTP_PT_CN : RTP_PT_DYNAMIC;
+	descriptor->name.buf = CN_NAME;
+	descriptor->name.length = CN_NAME_LENGTH;
+	descriptor->sampling_rate = sampling_rate;
+	descriptor->channel_count = 1;
+	return descriptor;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_cn_descriptor_check(const mpf_codec_descriptor_t *descriptor)
+{
+	apt_str_t name;
+	name.buf = CN_NAME;
+	name.length = CN_NAME_LENGTH;
+	return apt_string_compare(&descriptor->name,&name);
+}
+
+MPF_DECLARE(apr_byte_t) mpf_cn_level_calculate(const apr_int16_t *samples, apr_size_t count)
+{
+	apr_size_t i;
+	apr_uint64_t energy = 0;
+	float level;
+	if(!count) {
+		return CN_LEVEL_MAX;
+	}
+
+	for(i=0; i<count; i++) {
+		energy += (apr_int32_t)samples[i] * samples[i];
+	}
+	if(!energy) {
+		return CN_LEVEL_MAX;
+	}
+
+	/* level relative to the overload point, in dB below it */
+	level = -10.0f * log10f((float)energy / count / (CN_OVERLOAD * CN_OVERLOAD));
+	if(level < 0) {
+		return 0;
+	}
+	if(level > CN_LEVEL_MAX) {
+		return CN_LEVEL_MAX;
+	}
+	return (apr_byte_t)(level + 0.5f);
+}
+
+MPF_DECLARE(void) mpf_cn_generator_init(mpf_cn_generator_t *generator)
+{
+	generator->seed = 0x12345678;
+	generator->amplitude = 0;
+}
+
+MPF_DECLARE(void) mpf_cn_generate(mpf_cn_generator_t *generator, apr_byte_t level, apr_int16_t *samples, apr_size_t count)
+{
+	apr_size_t i;
+	float amplitude = 0;
+	float step;
+	if(!count) {
+		return;
+	}
+
+	level &= 0x7f;
+	if(level < CN_LEVEL_MAX) {
+		/* peak of uniform noise is sqrt(3) times its rms */
+		amplitude = 1.732f * CN_OVERLOAD * powf(10.0f,-(float)level / 20.0f);
+		if(amplitude > CN_OVERLOAD) {
+			amplitude = CN_OVERLOAD;
+		}
+	}
+
+	/* ramp the amplitude over the frame to avoid steps on level updates */
+	step = (amplitude - generator->amplitude) / count;
+	for(i=0; i<count; i++) {
+		generator->seed = generator->seed * 1664525 + 1013904223;
+		generator->amplitude += step;
+		/* uniform value in [-1,1) from the upper bits of the sequence */
+		samples[i] = (apr_int16_t)(generator->amplitude * ((apr_int32_t)(generator->seed >> 16) - 32768) / 32768.0f);
+	}
+	generator->amplitude = amplitude;
+}
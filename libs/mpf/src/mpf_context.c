@@ -19,7 +19,14 @@
 #ifdef WIN32
 #pragma warning(disable: 4127)
 #endif
+#include <stdlib.h>
+#include <string.h>
+#ifndef WIN32
+#include <time.h>
+#endif
 #include <apr_ring.h> 
+#include <apr_atomic.h>
+#include <apr_strings.h>
 #include "mpf_context.h"
 #include "mpf_termination.h"
 #include "mpf_stream.h"
@@ -28,6 +35,9 @@
 #include "mpf_mixer.h"
 #include "apt_log.h"
 
+/** Number of objects processed between subsequent checks of the deadline */
+#define MPF_CONTEXT_DEADLINE_CHECK_COUNT 8
+
 /** Item of the association matrix */
 typedef struct {
 	unsigned char on;
@@ -40,10 +50,32 @@ typedef struct {
 	unsigned char      rx_count;
 } header_item_t;
 
+/** Group processing time of contexts is accounted in */
+typedef struct {
+	char          name[MPF_CONTEXT_STAT_NAME_SIZE];
+	apr_uint64_t  total_time;
+} group_item_t;
+
+/** Item of the flat array of media processing objects */
+typedef struct {
+	apt_bool_t   (*process)(mpf_object_t *object);
+	mpf_object_t  *object;
+} object_item_t;
+
 /** Media processing context */
 struct mpf_context_t {
 	/** Ring entry */
 	APR_RING_ENTRY(mpf_context_t) link;
+	/** Ring entry of the list of contexts pending topology apply */
+	APR_RING_ENTRY(mpf_context_t) dirty_link;
+	/** Indicates whether the context is in the list of pending contexts */
+	apt_bool_t                    dirty;
+	/** Ring entry of the list of contexts having objects to process */
+	APR_RING_ENTRY(mpf_context_t) active_link;
+	/** Indicates whether the context is in the list of active contexts */
+	apt_bool_t                    active;
+	/** Indicates whether the context is accounted in the number of live contexts */
+	apt_bool_t                    live;
 	/** Back pointer to the context factory */
 	mpf_context_factory_t        *factory;
 	/** Pool to allocate memory from */
@@ -65,12 +97,56 @@ struct mpf_context_t {
 	/** Array of media processing objects constructed while 
 	applying topology based on association matrix */
 	apr_array_header_t           *mpf_objects;
+
+	/** Name of the group processing time is accounted in (NULL if none) */
+	const char                   *group;
+	/** Group item of the factory, looked up as the context is added to the factory */
+	group_item_t                 *group_item;
+	/** Number of ticks the context has been processed in while accounting */
+	apr_uint32_t                  tick_count;
+	/** Smoothed processing time of a tick in nsec */
+	apr_uint32_t                  avg_time;
+	/** Max processing time of a tick in nsec */
+	apr_uint32_t                  max_time;
+	/** Total processing time in nsec */
+	apr_uint64_t                  total_time;
 };
 
 /** Factory of media contexts */
 struct mpf_context_factory_t {
 	/** Ring head */
 	APR_RING_HEAD(mpf_context_head_t, mpf_context_t) head;
+	/** Ring head of contexts pending topology apply */
+	APR_RING_HEAD(mpf_context_dirty_head_t, mpf_context_t) dirty_head;
+	/** Ring head of contexts having objects to process (active set) */
+	APR_RING_HEAD(mpf_context_active_head_t, mpf_context_t) active_head;
+
+	/** Layout of media processing objects walked on every tick */
+	mpf_context_layout_e          layout;
+	/** Flat array of objects of the active contexts (MPF_CONTEXT_LAYOUT_FLAT) */
+	object_item_t                *items;
+	/** Number of items in the flat array */
+	apr_size_t                    item_count;
+	/** Number of allocated items */
+	apr_size_t                    item_capacity;
+	/** Indicates whether the flat array should be rebuilt */
+	apt_bool_t                    items_invalid;
+	/** Offsets of the priorities in the flat array, the objects are grouped by */
+	apr_size_t                    tier_offsets[MPF_OBJECT_PRIORITY_COUNT + 1];
+	/** Offsets within the priorities to start processing from on the next tick */
+	apr_size_t                    tier_cursors[MPF_OBJECT_PRIORITY_COUNT];
+
+	/** Indicates whether processing time of each context is accounted */
+	apt_bool_t                    accounting;
+	/** Groups processing time of contexts is accounted in */
+	group_item_t                 *groups;
+	/** Number of groups */
+	apr_size_t                    group_count;
+
+	/** Number of contexts created and not destroyed yet (updated from any thread) */
+	volatile apr_uint32_t         context_count;
+	/** Frame buffers borrowed by media processing objects on topology apply */
+	mpf_frame_pool_t             *frame_pool;
 };
 
 
@@ -78,12 +154,29 @@ static APR_INLINE apt_bool_t stream_direction_compatibility_check(mpf_terminatio
 static mpf_object_t* mpf_context_bridge_create(mpf_context_t *context, apr_size_t i);
 static mpf_object_t* mpf_context_multiplier_create(mpf_context_t *context, apr_size_t i);
 static mpf_object_t* mpf_context_mixer_create(mpf_context_t *context, apr_size_t j);
+static mpf_object_t* mpf_context_mixer_n1_create(mpf_context_t *context);
+static APR_INLINE void mpf_context_topology_validate(mpf_context_t *context);
+static APR_INLINE void mpf_context_active_set(mpf_context_t *context, apt_bool_t active);
 
 
 MPF_DECLARE(mpf_context_factory_t*) mpf_context_factory_create(apr_pool_t *pool)
 {
 	mpf_context_factory_t *factory = apr_palloc(pool, sizeof(mpf_context_factory_t));
 	APR_RING_INIT(&factory->head, mpf_context_t, link);
+	APR_RING_INIT(&factory->dirty_head, mpf_context_t, dirty_link);
+	APR_RING_INIT(&factory->active_head, mpf_context_t, active_link);
+	factory->layout = MPF_CONTEXT_LAYOUT_DEFAULT;
+	factory->items = NULL;
+	factory->item_count = 0;
+	factory->item_capacity = 0;
+	factory->items_invalid = FALSE;
+	memset(factory->tier_offsets,0,sizeof(factory->tier_offsets));
+	memset(factory->tier_cursors,0,sizeof(factory->tier_cursors));
+	factory->accounting = FALSE;
+	factory->groups = apr_palloc(pool, sizeof(group_item_t) * MPF_CONTEXT_MAX_GROUP_COUNT);
+	factory->group_count = 0;
+	factory->context_count = 0;
+	factory->frame_pool = mpf_frame_pool_create(pool);
 	return factory;
 }
 
@@ -95,21 +188,334 @@ MPF_DECLARE(void) mpf_context_factory_destroy(mpf_context_factory_t *factory)
 		mpf_context_destroy(context);
 		APR_RING_REMOVE(context, link);
 	}
+	if(factory->items) {
+		free(factory->items);
+		factory->items = NULL;
+	}
+	factory->item_count = factory->item_capacity = 0;
 }
 
-MPF_DECLARE(apt_bool_t) mpf_context_factory_process(mpf_context_factory_t *factory)
+MPF_DECLARE(apr_size_t) mpf_context_factory_context_count_get(const mpf_context_factory_t *factory)
+{
+	return apr_atomic_read32((volatile apr_uint32_t*)&factory->context_count);
+}
+
+MPF_DECLARE(void) mpf_context_factory_layout_set(mpf_context_factory_t *factory, mpf_context_layout_e layout)
+{
+	factory->layout = layout;
+	factory->items_invalid = TRUE;
+}
+
+MPF_DECLARE(mpf_context_layout_e) mpf_context_factory_layout_get(const mpf_context_factory_t *factory)
+{
+	return factory->layout;
+}
+
+MPF_DECLARE(void) mpf_context_factory_accounting_set(mpf_context_factory_t *factory, apt_bool_t enable)
+{
+	factory->accounting = enable;
+}
+
+/** Get monotonic time in nsec to account processing time by */
+static APR_INLINE apr_uint64_t mpf_context_clock_get(void)
+{
+#if defined(CLOCK_MONOTONIC) && !defined(WIN32)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (apr_uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+	return (apr_uint64_t)apr_time_now() * 1000;
+#endif
+}
+
+static APR_INLINE void mpf_context_time_account(mpf_context_t *context, apr_uint32_t elapsed)
+{
+	context->tick_count++;
+	context->total_time += elapsed;
+	if(elapsed > context->max_time) {
+		context->max_time = elapsed;
+	}
+	/* exponentially weighted moving average with the weight of 1/16 */
+	if(context->tick_count == 1) {
+		context->avg_time = elapsed;
+	}
+	else {
+		context->avg_time = context->avg_time - (context->avg_time >> 4) + (elapsed >> 4);
+	}
+	if(context->group_item) {
+		context->group_item->total_time += elapsed;
+	}
+}
+
+static group_item_t* mpf_context_factory_group_find(mpf_context_factory_t *factory, const char *name)
+{
+	group_item_t *item;
+	apr_size_t i;
+	for(i=0; i<factory->group_count; i++) {
+		item = &factory->groups[i];
+		if(strcmp(item->name,name) == 0) {
+			return item;
+		}
+	}
+	if(factory->group_count >= MPF_CONTEXT_MAX_GROUP_COUNT) {
+		/* the contexts of the group are accounted on their own only */
+		return NULL;
+	}
+	/* the name is copied, since groups are kept beyond the lifetime of contexts */
+	item = &factory->groups[factory->group_count++];
+	apr_cpystrn(item->name,name,sizeof(item->name));
+	item->total_time = 0;
+	return item;
+}
+
+static void mpf_context_stat_fill(const mpf_context_t *context, mpf_context_stat_t *stat)
+{
+	apr_cpystrn(stat->name,context->name,sizeof(stat->name));
+	apr_cpystrn(stat->group,context->group ? context->group : "",sizeof(stat->group));
+	stat->termination_count = context->count;
+	stat->object_count = context->mpf_objects->nelts;
+	stat->tick_count = context->tick_count;
+	stat->avg_time = context->avg_time;
+	stat->max_time = context->max_time;
+	stat->total_time = context->total_time;
+}
+
+MPF_DECLARE(apr_size_t) mpf_context_factory_top_get(mpf_context_factory_t *factory, mpf_context_stat_t *stats, apr_size_t max_count)
+{
+	mpf_context_t *context;
+	apr_size_t count = 0;
+	apr_size_t i;
+	if(!stats || !max_count) {
+		return 0;
+	}
+
+	for(context = APR_RING_FIRST(&factory->head);
+			context != APR_RING_SENTINEL(&factory->head, mpf_context_t, link);
+				context = APR_RING_NEXT(context, link)) {
+		if(!context->tick_count) {
+			continue;
+		}
+		/* insert into the array ordered by smoothed processing time, the least one drops out */
+		i = count;
+		while(i > 0 && stats[i-1].avg_time < context->avg_time) {
+			i--;
+		}
+		if(i >= max_count) {
+			continue;
+		}
+		if(count < max_count) {
+			count++;
+		}
+		memmove(&stats[i+1],&stats[i],(count - i - 1) * sizeof(mpf_context_stat_t));
+		mpf_context_stat_fill(context,&stats[i]);
+	}
+	return count;
+}
+
+MPF_DECLARE(apr_size_t) mpf_context_factory_group_stat_get(mpf_context_factory_t *factory, mpf_context_group_stat_t *stats, apr_size_t max_count)
 {
 	mpf_context_t *context;
+	mpf_context_group_stat_t *stat;
+	apr_size_t count = factory->group_count;
+	apr_size_t i;
+	if(!stats) {
+		return 0;
+	}
+
+	if(count > max_count) {
+		count = max_count;
+	}
+	for(i=0; i<count; i++) {
+		stat = &stats[i];
+		apr_cpystrn(stat->name,factory->groups[i].name,sizeof(stat->name));
+		stat->context_count = 0;
+		stat->avg_time = 0;
+		stat->total_time = factory->groups[i].total_time;
+	}
 	for(context = APR_RING_FIRST(&factory->head);
 			context != APR_RING_SENTINEL(&factory->head, mpf_context_t, link);
 				context = APR_RING_NEXT(context, link)) {
+		if(!context->group_item) {
+			continue;
+		}
+		i = context->group_item - factory->groups;
+		if(i < count) {
+			stats[i].context_count++;
+			stats[i].avg_time += context->avg_time;
+		}
+	}
+	return count;
+}
+
+static void mpf_context_factory_accounted_process(mpf_context_factory_t *factory)
+{
+	mpf_context_t *context;
+	apr_uint64_t start_time = mpf_context_clock_get();
+	apr_uint64_t now;
+
+	/* a single reading of the clock per context, the end of one is the start of the next */
+	for(context = APR_RING_FIRST(&factory->active_head);
+			context != APR_RING_SENTINEL(&factory->active_head, mpf_context_t, active_link);
+				context = APR_RING_NEXT(context, active_link)) {
 		
 		mpf_context_process(context);
+		now = mpf_context_clock_get();
+		mpf_context_time_account(context,(apr_uint32_t)(now - start_time));
+		start_time = now;
 	}
+}
 
+static apt_bool_t mpf_context_factory_items_build(mpf_context_factory_t *factory)
+{
+	mpf_context_t *context;
+	mpf_object_t *object;
+	apr_size_t count = 0;
+	int priority;
+	int i;
+
+	for(context = APR_RING_FIRST(&factory->active_head);
+			context != APR_RING_SENTINEL(&factory->active_head, mpf_context_t, active_link);
+				context = APR_RING_NEXT(context, active_link)) {
+		count += context->mpf_objects->nelts;
+	}
+
+	if(count > factory->item_capacity) {
+		apr_size_t capacity = factory->item_capacity ? factory->item_capacity : 64;
+		object_item_t *items;
+		while(capacity < count) {
+			capacity *= 2;
+		}
+		items = realloc(factory->items,capacity * sizeof(object_item_t));
+		if(!items) {
+			return FALSE;
+		}
+		factory->items = items;
+		factory->item_capacity = capacity;
+	}
+
+	/* grouped by priority, the objects writing to the network go first */
+	factory->item_count = 0;
+	for(priority = 0; priority < MPF_OBJECT_PRIORITY_COUNT; priority++) {
+		factory->tier_offsets[priority] = factory->item_count;
+		for(context = APR_RING_FIRST(&factory->active_head);
+				context != APR_RING_SENTINEL(&factory->active_head, mpf_context_t, active_link);
+					context = APR_RING_NEXT(context, active_link)) {
+			for(i=0; i<context->mpf_objects->nelts; i++) {
+				object = APR_ARRAY_IDX(context->mpf_objects,i,mpf_object_t*);
+				if(object->process && object->priority == (mpf_object_priority_e)priority) {
+					factory->items[factory->item_count].process = object->process;
+					factory->items[factory->item_count].object = object;
+					factory->item_count++;
+				}
+			}
+		}
+	}
+	factory->tier_offsets[MPF_OBJECT_PRIORITY_COUNT] = factory->item_count;
+	factory->items_invalid = FALSE;
 	return TRUE;
 }
 
+MPF_DECLARE(apt_bool_t) mpf_context_factory_process(mpf_context_factory_t *factory)
+{
+	mpf_context_t *context;
+	if(factory->accounting == TRUE) {
+		mpf_context_factory_accounted_process(factory);
+		return TRUE;
+	}
+	if(factory->layout == MPF_CONTEXT_LAYOUT_FLAT) {
+		if(factory->items_invalid == FALSE || mpf_context_factory_items_build(factory) == TRUE) {
+			/* linear scan of the objects of all the active contexts */
+			object_item_t *item = factory->items;
+			object_item_t *end = item + factory->item_count;
+			for(; item != end; item++) {
+				item->process(item->object);
+			}
+			return TRUE;
+		}
+	}
+
+	/* walk through the active set only, idle contexts have nothing to process */
+	for(context = APR_RING_FIRST(&factory->active_head);
+			context != APR_RING_SENTINEL(&factory->active_head, mpf_context_t, active_link);
+				context = APR_RING_NEXT(context, active_link)) {
+		
+		mpf_context_process(context);
+	}
+
+	return TRUE;
+}
+
+/** Process the objects of the priority, deferring the ones past the deadline */
+static apr_size_t mpf_context_factory_tier_process(mpf_context_factory_t *factory, mpf_object_priority_e priority, apr_time_t deadline, apt_bool_t *expired)
+{
+	object_item_t *items = factory->items + factory->tier_offsets[priority];
+	apr_size_t count = factory->tier_offsets[priority + 1] - factory->tier_offsets[priority];
+	apr_size_t cursor = factory->tier_cursors[priority];
+	apr_size_t deferred = 0;
+	apr_size_t i;
+	apr_size_t k;
+
+	if(cursor >= count) {
+		cursor = 0;
+	}
+	/* the objects deferred on the previous tick go first, so that none is starved */
+	for(i=0; i<count; i++) {
+		k = cursor + i;
+		if(k >= count) {
+			k -= count;
+		}
+		if(*expired == FALSE && i % MPF_CONTEXT_DEADLINE_CHECK_COUNT == 0 && apr_time_now() >= deadline) {
+			*expired = TRUE;
+			factory->tier_cursors[priority] = k;
+		}
+		if(*expired == TRUE) {
+			mpf_object_defer(items[k].object);
+			deferred++;
+			continue;
+		}
+		items[k].process(items[k].object);
+	}
+	return deferred;
+}
+
+MPF_DECLARE(apr_size_t) mpf_context_factory_deadline_process(mpf_context_factory_t *factory, apr_time_t deadline)
+{
+	object_item_t *item;
+	object_item_t *end;
+	apt_bool_t expired = FALSE;
+	apr_size_t deferred;
+
+	if(factory->accounting == TRUE ||
+		(factory->items_invalid == TRUE && mpf_context_factory_items_build(factory) == FALSE)) {
+		mpf_context_factory_process(factory);
+		return 0;
+	}
+
+	/* the objects writing to the network are processed regardless of the deadline */
+	item = factory->items;
+	end = item + factory->tier_offsets[MPF_OBJECT_PRIORITY_RX];
+	for(; item != end; item++) {
+		item->process(item->object);
+	}
+
+	deferred = mpf_context_factory_tier_process(factory,MPF_OBJECT_PRIORITY_RX,deadline,&expired);
+	deferred += mpf_context_factory_tier_process(factory,MPF_OBJECT_PRIORITY_LOCAL,deadline,&expired);
+	return deferred;
+}
+
+MPF_DECLARE(apr_size_t) mpf_context_factory_topology_apply(mpf_context_factory_t *factory)
+{
+	apr_size_t count = 0;
+	mpf_context_t *context;
+	while(!APR_RING_EMPTY(&factory->dirty_head, mpf_context_t, dirty_link)) {
+		context = APR_RING_FIRST(&factory->dirty_head);
+		/* mpf_context_topology_apply() removes the context from the pending list */
+		mpf_context_topology_apply(context);
+		count++;
+	}
+	return count;
+}
+
  
 MPF_DECLARE(mpf_context_t*) mpf_context_create(
 								mpf_context_factory_t *factory,
@@ -123,6 +529,12 @@ MPF_DECLARE(mpf_context_t*) mpf_context_create(
 	header_item_t *header_item;
 	mpf_context_t *context = apr_palloc(pool,sizeof(mpf_context_t));
 	APR_RING_ELEM_INIT(context,link);
+	APR_RING_ELEM_INIT(context,dirty_link);
+	context->dirty = FALSE;
+	APR_RING_ELEM_INIT(context,active_link);
+	context->active = FALSE;
+	context->live = TRUE;
+	apr_atomic_inc32(&factory->context_count);
 	context->factory = factory;
 	context->obj = obj;
 	context->pool = pool;
@@ -133,6 +545,12 @@ MPF_DECLARE(mpf_context_t*) mpf_context_create(
 	context->capacity = max_termination_count;
 	context->count = 0;
 	context->mpf_objects = apr_array_make(pool,1,sizeof(mpf_object_t*));
+	context->group = NULL;
+	context->group_item = NULL;
+	context->tick_count = 0;
+	context->avg_time = 0;
+	context->max_time = 0;
+	context->total_time = 0;
 	context->header = apr_palloc(pool,context->capacity * sizeof(header_item_t));
 	context->matrix = apr_palloc(pool,context->capacity * sizeof(matrix_item_t*));
 	for(i=0; i<context->capacity; i++) {
@@ -161,6 +579,10 @@ MPF_DECLARE(apt_bool_t) mpf_context_destroy(mpf_context_t *context)
 			mpf_termination_subtract(termination);
 		}
 	}
+	if(context->live == TRUE) {
+		context->live = FALSE;
+		apr_atomic_dec32(&context->factory->context_count);
+	}
 	return TRUE;
 }
 
@@ -169,6 +591,20 @@ MPF_DECLARE(void*) mpf_context_object_get(const mpf_context_t *context)
 	return context->obj;
 }
 
+MPF_DECLARE(apt_bool_t) mpf_context_group_set(mpf_context_t *context, const char *group)
+{
+	if(context->count) {
+		return FALSE;
+	}
+	context->group = group;
+	return TRUE;
+}
+
+MPF_DECLARE(mpf_context_factory_t*) mpf_context_factory_get(const mpf_context_t *context)
+{
+	return context->factory;
+}
+
 MPF_DECLARE(apt_bool_t) mpf_context_termination_add(mpf_context_t *context, mpf_termination_t *termination)
 {
 	apr_size_t i;
@@ -181,6 +617,10 @@ MPF_DECLARE(apt_bool_t) mpf_context_termination_add(mpf_context_t *context, mpf_
 		if(!context->count) {
 			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Add Media Context %s",context->name);
 			APR_RING_INSERT_TAIL(&context->factory->head,context,mpf_context_t,link);
+			if(context->group && !context->group_item) {
+				/* looked up in the thread processing the factory */
+				context->group_item = mpf_context_factory_group_find(context->factory,context->group);
+			}
 		}
 
 		header_item->termination = termination;
@@ -237,6 +677,8 @@ MPF_DECLARE(apt_bool_t) mpf_context_termination_subtract(mpf_context_t *context,
 	if(!context->count) {
 		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Remove Media Context %s",context->name);
 		APR_RING_REMOVE(context,link);
+		mpf_context_topology_validate(context);
+		mpf_context_active_set(context,FALSE);
 	}
 	return TRUE;
 }
@@ -380,6 +822,88 @@ static apt_bool_t mpf_context_object_add(mpf_context_t *context, mpf_object_t *o
 	return TRUE;
 }
 
+static APR_INLINE void mpf_context_active_set(mpf_context_t *context, apt_bool_t active)
+{
+	if(context->active == active) {
+		return;
+	}
+	if(active == TRUE) {
+		APR_RING_INSERT_TAIL(&context->factory->active_head,context,mpf_context_t,active_link);
+	}
+	else {
+		APR_RING_REMOVE(context,active_link);
+	}
+	context->active = active;
+	context->factory->items_invalid = TRUE;
+}
+
+static APR_INLINE apt_bool_t mpf_context_slot_is_network(const mpf_context_t *context, apr_size_t i)
+{
+	mpf_termination_t *termination = context->header[i].termination;
+	if(termination && termination->audio_stream && termination->audio_stream->network == TRUE) {
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/** Get priority of the object reading from the slot and writing to the associated ones,
+    or of the mixer reading from the associated slots and writing to the slot */
+static mpf_object_priority_e mpf_context_object_priority_get(const mpf_context_t *context, apr_size_t i, apt_bool_t mixer)
+{
+	apt_bool_t tx = FALSE;
+	apt_bool_t rx = FALSE;
+	apr_size_t j;
+	for(j=0; j<context->capacity; j++) {
+		if(!context->header[j].termination) {
+			continue;
+		}
+		if(mixer == FALSE ? !context->matrix[i][j].on : !context->matrix[j][i].on) {
+			continue;
+		}
+		if(mpf_context_slot_is_network(context,j) == TRUE) {
+			if(mixer == FALSE) {
+				tx = TRUE;
+			}
+			else {
+				rx = TRUE;
+			}
+		}
+	}
+	if(mpf_context_slot_is_network(context,i) == TRUE) {
+		if(mixer == FALSE) {
+			rx = TRUE;
+		}
+		else {
+			tx = TRUE;
+		}
+	}
+	if(tx == TRUE) {
+		return MPF_OBJECT_PRIORITY_TX;
+	}
+	return rx == TRUE ? MPF_OBJECT_PRIORITY_RX : MPF_OBJECT_PRIORITY_LOCAL;
+}
+
+static APR_INLINE void mpf_context_topology_validate(mpf_context_t *context)
+{
+	if(context->dirty == TRUE) {
+		APR_RING_REMOVE(context,dirty_link);
+		context->dirty = FALSE;
+	}
+}
+
+MPF_DECLARE(apt_bool_t) mpf_context_topology_invalidate(mpf_context_t *context)
+{
+	if(!context->count) {
+		/* the context is not in the factory, nothing to apply */
+		return FALSE;
+	}
+	if(context->dirty == FALSE) {
+		APR_RING_INSERT_TAIL(&context->factory->dirty_head,context,mpf_context_t,dirty_link);
+		context->dirty = TRUE;
+	}
+	return TRUE;
+}
+
 MPF_DECLARE(apt_bool_t) mpf_context_topology_apply(mpf_context_t *context)
 {
 	apr_size_t i,k;
@@ -389,6 +913,20 @@ MPF_DECLARE(apt_bool_t) mpf_context_topology_apply(mpf_context_t *context)
 	/* first destroy existing topology / if any */
 	mpf_context_topology_destroy(context);
 
+	/* each termination of a full mesh hears the others, the sources are read once */
+	object = mpf_context_mixer_n1_create(context);
+	if(object) {
+		for(i=0; i<context->capacity; i++) {
+			if(mpf_context_slot_is_network(context,i) == TRUE) {
+				object->priority = MPF_OBJECT_PRIORITY_TX;
+				break;
+			}
+		}
+		mpf_context_object_add(context,object);
+		mpf_context_active_set(context,TRUE);
+		return TRUE;
+	}
+
 	for(i=0,k=0; i<context->capacity && k<context->count; i++) {
 		header_item = &context->header[i];
 		if(!header_item->termination) {
@@ -405,19 +943,35 @@ MPF_DECLARE(apt_bool_t) mpf_context_topology_apply(mpf_context_t *context)
 				object = mpf_context_multiplier_create(context,i);
 			}
 
+			if(object) {
+				object->priority = mpf_context_object_priority_get(context,i,FALSE);
+			}
 			mpf_context_object_add(context,object);
 		}
 		if(header_item->rx_count > 1) {
 			object = mpf_context_mixer_create(context,i);
+			if(object) {
+				object->priority = mpf_context_object_priority_get(context,i,TRUE);
+			}
 			mpf_context_object_add(context,object);
 		}
 	}
 
+	/* the context is active as long as there is at least one object to process */
+	for(i=0; i<(apr_size_t)context->mpf_objects->nelts; i++) {
+		object = APR_ARRAY_IDX(context->mpf_objects,i,mpf_object_t*);
+		if(object->process) {
+			mpf_context_active_set(context,context->count ? TRUE : FALSE);
+			break;
+		}
+	}
 	return TRUE;
 }
 
 MPF_DECLARE(apt_bool_t) mpf_context_topology_destroy(mpf_context_t *context)
 {
+	/* cancel pending apply / if any */
+	mpf_context_topology_validate(context);
 	if(context->mpf_objects->nelts) {
 		int i;
 		mpf_object_t *object;
@@ -427,6 +981,7 @@ MPF_DECLARE(apt_bool_t) mpf_context_topology_destroy(mpf_context_t *context)
 		}
 		apr_array_clear(context->mpf_objects);
 	}
+	mpf_context_active_set(context,FALSE);
 	return TRUE;
 }
 
@@ -472,6 +1027,7 @@ static mpf_object_t* mpf_context_bridge_create(mpf_context_t *context, apr_size_
 				header_item2->termination->audio_stream,
 				header_item1->termination->codec_manager,
 				context->name,
+				context->factory->frame_pool,
 				context->pool);
 		}
 	}
@@ -504,6 +1060,7 @@ static mpf_object_t* mpf_context_multiplier_create(mpf_context_t *context, apr_s
 				header_item1->tx_count,
 				header_item1->termination->codec_manager,
 				context->name,
+				context->factory->frame_pool,
 				context->pool);
 }
 
@@ -533,6 +1090,50 @@ static mpf_object_t* mpf_context_mixer_create(mpf_context_t *context, apr_size_t
 				header_item1->termination->audio_stream,
 				header_item1->termination->codec_manager,
 				context->name,
+				context->factory->frame_pool,
+				context->pool);
+}
+
+static mpf_object_t* mpf_context_mixer_n1_create(mpf_context_t *context)
+{
+	mpf_audio_stream_t **stream_arr;
+	header_item_t *header_item;
+	const mpf_codec_manager_t *codec_manager = NULL;
+	apr_size_t i,k;
+	if(context->count < 3) {
+		/* bridges do for two terminations */
+		return NULL;
+	}
+	for(i=0,k=0; i<context->capacity && k<context->count; i++) {
+		header_item = &context->header[i];
+		if(!header_item->termination) {
+			continue;
+		}
+		if(header_item->tx_count != context->count - 1 || header_item->rx_count != context->count - 1) {
+			/* not a full mesh */
+			return NULL;
+		}
+		k++;
+	}
+
+	stream_arr = apr_palloc(context->pool,context->count * sizeof(mpf_audio_stream_t*));
+	for(i=0,k=0; i<context->capacity && k<context->count; i++) {
+		header_item = &context->header[i];
+		if(!header_item->termination) {
+			continue;
+		}
+		if(!codec_manager) {
+			codec_manager = header_item->termination->codec_manager;
+		}
+		stream_arr[k] = header_item->termination->audio_stream;
+		k++;
+	}
+	return mpf_mixer_n1_create(
+				stream_arr,
+				context->count,
+				codec_manager,
+				context->name,
+				context->factory->frame_pool,
 				context->pool);
 }
 
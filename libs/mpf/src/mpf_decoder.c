@@ -16,16 +16,49 @@
  * $Id$
  */
 
+#include <string.h>
 #include "mpf_decoder.h"
+#include "mpf_plc.h"
+#include "mpf_comfort_noise.h"
 #include "apt_log.h"
 
+/* skew (usec) tolerated without compensation, in the range of regular jitter */
+#define DECODER_SKEW_DEADBAND    10000
+/* skew (usec) per 1/65536 of resampling ratio, 20 msec is compensated by 0.1% (in 20 sec) */
+#define DECODER_SKEW_RATIO_UNIT  300
+/* max deviation of resampling ratio (1/65536), 0.5% is inaudible */
+#define DECODER_SKEW_RATIO_MAX   328
+
 typedef struct mpf_decoder_t mpf_decoder_t;
+typedef struct mpf_skew_resampler_t mpf_skew_resampler_t;
+
+/** Resampler compensating the time skew of the source by fractions of a sample */
+struct mpf_skew_resampler_t {
+	/** Decoded samples not consumed yet (up to 3 frames) */
+	apr_int16_t *samples;
+	/** Number of samples */
+	apr_size_t   count;
+	/** Position of the next output sample in samples (Q16) */
+	apr_uint32_t pos;
+	/** Smoothed skew of the source (usec) */
+	apr_int32_t  skew;
+	/** Frame the source is read and decoded to */
+	mpf_frame_t  frame;
+};
 
 struct mpf_decoder_t {
 	mpf_audio_stream_t *base;
 	mpf_audio_stream_t *source;
 	mpf_codec_t        *codec;
 	mpf_frame_t         frame_in;
+	/** Waveform substitution for codecs without native concealment */
+	mpf_plc_t          *plc;
+	/** Size of decoded frame */
+	apr_size_t          frame_size;
+	/** Noise generated in silence periods signaled by CN */
+	mpf_cn_generator_t  cn_generator;
+	/** Time skew compensation (NULL if not requested by the source) */
+	mpf_skew_resampler_t *resampler;
 };
 
 
@@ -49,26 +82,139 @@ static apt_bool_t mpf_decoder_close(mpf_audio_stream_t *stream)
 	return mpf_audio_stream_rx_close(decoder->source);
 }
 
-static apt_bool_t mpf_decoder_process(mpf_audio_stream_t *stream, mpf_frame_t *frame)
+static apt_bool_t mpf_decoder_frame_decode(mpf_decoder_t *decoder, mpf_frame_t *frame)
 {
-	mpf_decoder_t *decoder = stream->obj;
 	decoder->frame_in.type = MEDIA_FRAME_TYPE_NONE;
 	decoder->frame_in.marker = MPF_MARKER_NONE;
 	if(mpf_audio_stream_frame_read(decoder->source,&decoder->frame_in) != TRUE) {
 		return FALSE;
 	}
 
-	frame->type = decoder->frame_in.type;
+	frame->type = decoder->frame_in.type & ~(MEDIA_FRAME_TYPE_LOST | MEDIA_FRAME_TYPE_CN);
 	frame->marker = decoder->frame_in.marker;
 	if((frame->type & MEDIA_FRAME_TYPE_EVENT) == MEDIA_FRAME_TYPE_EVENT) {
 		frame->event_frame = decoder->frame_in.event_frame;
 	}
 	if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO) {
 		mpf_codec_decode(decoder->codec,&decoder->frame_in.codec_frame,&frame->codec_frame);
+		if(decoder->plc) {
+			mpf_plc_receive(decoder->plc,frame->codec_frame.buffer,frame->codec_frame.size / sizeof(apr_int16_t));
+		}
+	}
+	else if((decoder->frame_in.type & MEDIA_FRAME_TYPE_CN) == MEDIA_FRAME_TYPE_CN) {
+		/* the source passes the noise level of the current silence period */
+		frame->codec_frame.size = decoder->frame_size;
+		mpf_cn_generate(
+			&decoder->cn_generator,
+			*(const apr_byte_t*)decoder->frame_in.codec_frame.buffer,
+			frame->codec_frame.buffer,
+			frame->codec_frame.size / sizeof(apr_int16_t));
+		frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+		if(decoder->plc) {
+			mpf_plc_receive(decoder->plc,frame->codec_frame.buffer,frame->codec_frame.size / sizeof(apr_int16_t));
+		}
+	}
+	else if((decoder->frame_in.type & MEDIA_FRAME_TYPE_LOST) == MEDIA_FRAME_TYPE_LOST) {
+		/* the source marks lost frames, if packet loss concealment is enabled in RTP settings */
+		frame->codec_frame.size = decoder->frame_size;
+		if(decoder->plc) {
+			if(mpf_plc_conceal(decoder->plc,frame->codec_frame.buffer,frame->codec_frame.size / sizeof(apr_int16_t)) == TRUE) {
+				frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+			}
+		}
+		else if(mpf_codec_conceal(decoder->codec,&frame->codec_frame) == TRUE) {
+			frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+		}
+	}
+	return TRUE;
+}
+
+static apr_uint32_t mpf_skew_resampler_step_get(mpf_skew_resampler_t *resampler, apr_int32_t skew)
+{
+	apr_int32_t adjustment;
+	/* smooth the skew over about 16 frames, the jitter is not to be followed */
+	resampler->skew += (skew - resampler->skew) / 16;
+	if(resampler->skew > -DECODER_SKEW_DEADBAND && resampler->skew < DECODER_SKEW_DEADBAND) {
+		return 0x10000;
+	}
+
+	/* consume faster, if the source runs ahead, and slower otherwise */
+	adjustment = resampler->skew / DECODER_SKEW_RATIO_UNIT;
+	if(adjustment > DECODER_SKEW_RATIO_MAX) {
+		adjustment = DECODER_SKEW_RATIO_MAX;
+	}
+	else if(adjustment < -DECODER_SKEW_RATIO_MAX) {
+		adjustment = -DECODER_SKEW_RATIO_MAX;
+	}
+	return 0x10000 + adjustment;
+}
+
+static apt_bool_t mpf_decoder_resample_process(mpf_decoder_t *decoder, mpf_frame_t *frame)
+{
+	mpf_skew_resampler_t *resampler = decoder->resampler;
+	apr_size_t sample_count = decoder->frame_size / sizeof(apr_int16_t);
+	apr_int16_t *output = frame->codec_frame.buffer;
+	apr_uint32_t step;
+	apr_uint32_t pos;
+	apr_size_t i;
+
+	frame->type = MEDIA_FRAME_TYPE_NONE;
+	frame->marker = MPF_MARKER_NONE;
+	step = mpf_skew_resampler_step_get(resampler,decoder->source->rx_skew);
+	/* the last output sample is interpolated from the sample next to it */
+	while(resampler->count < ((resampler->pos + (sample_count - 1) * step) >> 16) + 2) {
+		resampler->frame.codec_frame.buffer = resampler->samples + resampler->count;
+		resampler->frame.codec_frame.size = decoder->frame_size;
+		if(mpf_decoder_frame_decode(decoder,&resampler->frame) != TRUE) {
+			return FALSE;
+		}
+
+		frame->marker |= resampler->frame.marker;
+		if((resampler->frame.type & MEDIA_FRAME_TYPE_EVENT) == MEDIA_FRAME_TYPE_EVENT) {
+			frame->type |= MEDIA_FRAME_TYPE_EVENT;
+			frame->event_frame = resampler->frame.event_frame;
+		}
+		if((resampler->frame.type & MEDIA_FRAME_TYPE_AUDIO) != MEDIA_FRAME_TYPE_AUDIO) {
+			/* no audio to resample, flush the rest (padded by silence) */
+			if(resampler->count) {
+				memcpy(output,resampler->samples,resampler->count * sizeof(apr_int16_t));
+				memset(output + resampler->count,0,(sample_count - resampler->count) * sizeof(apr_int16_t));
+				frame->codec_frame.size = decoder->frame_size;
+				frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+			}
+			resampler->count = 0;
+			resampler->pos = 0;
+			return TRUE;
+		}
+		resampler->count += sample_count;
 	}
+
+	/* linear interpolation of the ratio, which deviates from 1 by 0.5% at most */
+	pos = resampler->pos;
+	for(i=0; i<sample_count; i++, pos += step) {
+		const apr_int16_t *sample = resampler->samples + (pos >> 16);
+		output[i] = (apr_int16_t)(sample[0] + (((apr_int32_t)sample[1] - sample[0]) * (apr_int32_t)(pos & 0xFFFF) >> 16));
+	}
+	frame->codec_frame.size = decoder->frame_size;
+	frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+
+	/* drop the consumed samples */
+	i = pos >> 16;
+	resampler->count -= i;
+	memmove(resampler->samples,resampler->samples + i,resampler->count * sizeof(apr_int16_t));
+	resampler->pos = pos & 0xFFFF;
 	return TRUE;
 }
 
+static apt_bool_t mpf_decoder_process(mpf_audio_stream_t *stream, mpf_frame_t *frame)
+{
+	mpf_decoder_t *decoder = stream->obj;
+	if(decoder->resampler) {
+		return mpf_decoder_resample_process(decoder,frame);
+	}
+	return mpf_decoder_frame_decode(decoder,frame);
+}
+
 static void mpf_decoder_trace(mpf_audio_stream_t *stream, mpf_stream_direction_e direction, apt_text_stream_t *output)
 {
 	apr_size_t offset;
@@ -88,6 +234,12 @@ static void mpf_decoder_trace(mpf_audio_stream_t *stream, mpf_stream_direction_e
 	}
 }
 
+static apt_bool_t mpf_decoder_receive(mpf_audio_stream_t *stream)
+{
+	mpf_decoder_t *decoder = stream->obj;
+	return mpf_audio_stream_receive(decoder->source);
+}
+
 static const mpf_audio_stream_vtable_t vtable = {
 	mpf_decoder_destroy,
 	mpf_decoder_open,
@@ -96,7 +248,9 @@ static const mpf_audio_stream_vtable_t vtable = {
 	NULL,
 	NULL,
 	NULL,
-	mpf_decoder_trace
+	mpf_decoder_trace,
+	NULL,
+	mpf_decoder_receive
 };
 
 MPF_DECLARE(mpf_audio_stream_t*) mpf_decoder_create(mpf_audio_stream_t *source, mpf_codec_t *codec, apr_pool_t *pool)
@@ -118,6 +272,7 @@ MPF_DECLARE(mpf_audio_stream_t*) mpf_decoder_create(mpf_audio_stream_t *source,
 		source->rx_descriptor->channel_count,
 		pool);
 	decoder->base->rx_event_descriptor = source->rx_event_descriptor;
+	decoder->base->rx_cn_descriptor = source->rx_cn_descriptor;
 
 	decoder->source = source;
 	decoder->codec = codec;
@@ -125,5 +280,24 @@ MPF_DECLARE(mpf_audio_stream_t*) mpf_decoder_create(mpf_audio_stream_t *source,
 	frame_size = mpf_codec_frame_size_calculate(source->rx_descriptor,codec->attribs);
 	decoder->frame_in.codec_frame.size = frame_size;
 	decoder->frame_in.codec_frame.buffer = apr_palloc(pool,frame_size);
+
+	decoder->frame_size = mpf_codec_linear_frame_size_calculate(
+		decoder->base->rx_descriptor->sampling_rate,
+		decoder->base->rx_descriptor->channel_count);
+	mpf_cn_generator_init(&decoder->cn_generator);
+	decoder->plc = NULL;
+	if(!codec->vtable->conceal && decoder->base->rx_descriptor->channel_count == 1) {
+		decoder->plc = mpf_plc_create(decoder->base->rx_descriptor->sampling_rate,pool);
+	}
+	decoder->resampler = NULL;
+	if(source->rx_skew_compensation == TRUE && decoder->base->rx_descriptor->channel_count == 1) {
+		decoder->resampler = apr_palloc(pool,sizeof(mpf_skew_resampler_t));
+		decoder->resampler->samples = apr_palloc(pool,3 * decoder->frame_size);
+		decoder->resampler->count = 0;
+		decoder->resampler->pos = 0;
+		decoder->resampler->skew = 0;
+		decoder->resampler->frame.codec_frame.buffer = NULL;
+		decoder->resampler->frame.codec_frame.size = 0;
+	}
 	return decoder->base;
 }
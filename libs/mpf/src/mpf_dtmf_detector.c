@@ -20,12 +20,21 @@
 #include "apr_thread_mutex.h"
 #include "apt_log.h"
 #include "mpf_named_event.h"
+#include "mpf_termination.h"
 #include <math.h>
 
 #ifndef M_PI
 #	define M_PI 3.141592653589793238462643
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define GOERTZEL_SSE2
+#	include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#	define GOERTZEL_NEON
+#	include <arm_neon.h>
+#endif
+
 /** Max detected DTMF digits buffer length */
 #define MPF_DTMFDET_BUFFER_LEN  32
 
@@ -38,8 +47,12 @@
 /** See RFC4733 */
 #define DTMF_EVENT_ID_MAX       15  /* 0123456789*#ABCD */
 
+/** Min energy of a DTMF tone in the window (at 8kHz) */
+#define GOERTZEL_ENERGY_MIN_8K  8.0e10
+
 /**
- * Goertzel frequency detector (second-order IIR filter) state:
+ * Bank of Goertzel frequency detectors (second-order IIR filters), one per
+ * DTMF frequency, laid out by field so that all of them update in SIMD lanes:
  *
  * s(t) = x(t) + coef * s(t-1) - s(t-2), where s(0)=0; s(1) = 0;
  * x(t) is the input signal
@@ -47,14 +60,14 @@
  * Then energy of frequency f in the signal is:
  * X(f)X'(f) = s(t-2)^2 + s(t-1)^2 - coef*s(t-2)*s(t-1)
  */
-typedef struct goertzel_state_t {
+typedef struct goertzel_bank_t {
 	/** coef = cos(2*pi*f_tone/f_sampling) */
-	double coef;
-	/** s(t-2) or resulting energy @see goertzel_state_t */
-	double s1;
-	/** s(t-1) @see goertzel_state_t */
-	double s2;
-} goertzel_state_t;
+	double coef[DTMF_FREQUENCIES];
+	/** s(t-2) @see goertzel_bank_t */
+	double s1[DTMF_FREQUENCIES];
+	/** s(t-1) @see goertzel_bank_t */
+	double s2[DTMF_FREQUENCIES];
+} goertzel_bank_t;
 
 /** DTMF frequencies */
 static const double dtmf_freqs[DTMF_FREQUENCIES] = {
@@ -74,6 +87,8 @@ struct mpf_dtmf_detector_t {
 	struct apr_thread_mutex_t     *mutex;
 	/** Recognizer band */
 	enum mpf_dtmf_detector_band_e  band;
+	/** Stream digits are got from */
+	const struct mpf_audio_stream_t *stream;
 	/** Detected digits buffer */
 	char                           buf[MPF_DTMFDET_BUFFER_LEN+1];
 	/** Number of digits in the buffer */
@@ -81,9 +96,13 @@ struct mpf_dtmf_detector_t {
 	/** Number of lost digits due to full buffer */
 	apr_size_t                     lost_digits;
 	/** Frequency analyzators */
-	struct goertzel_state_t        energies[DTMF_FREQUENCIES];
+	struct goertzel_bank_t         bank;
 	/** Total energy of signal */
 	double                         totenergy;
+	/** Min energy of a tone in the window */
+	double                         tone_energy;
+	/** Whether the bank has been fed in the current window (silent lead is gated off) */
+	apt_bool_t                     active;
 	/** Number of samples in a window */
 	apr_size_t                     wsamples;
 	/** Number of samples processed */
@@ -115,6 +134,7 @@ MPF_DECLARE(struct mpf_dtmf_detector_t *) mpf_dtmf_detector_create_ex(
 	if (status != APR_SUCCESS) return NULL;
 
 	det->band = (enum mpf_dtmf_detector_band_e) flg_band;
+	det->stream = stream;
 	det->buf[0] = 0;
 	det->digits = 0;
 	det->lost_digits = 0;
@@ -122,13 +142,15 @@ MPF_DECLARE(struct mpf_dtmf_detector_t *) mpf_dtmf_detector_create_ex(
 	if (det->band & MPF_DTMF_DETECTOR_INBAND) {
 		apr_size_t i;
 		for (i = 0; i < DTMF_FREQUENCIES; i++) {
-			det->energies[i].coef = 2 * cos(2 * M_PI * dtmf_freqs[i] /
+			det->bank.coef[i] = 2 * cos(2 * M_PI * dtmf_freqs[i] /
 				stream->tx_descriptor->sampling_rate);
-			det->energies[i].s1 = 0;
-			det->energies[i].s2 = 0;
+			det->bank.s1[i] = 0;
+			det->bank.s2[i] = 0;
 		}
 		det->nsamples = 0;
 		det->wsamples = GOERTZEL_SAMPLES_8K * (stream->tx_descriptor->sampling_rate / 8000);
+		det->tone_energy = GOERTZEL_ENERGY_MIN_8K * det->wsamples / GOERTZEL_SAMPLES_8K;
+		det->active = FALSE;
 		det->last1 = det->last2 = det->curr = 0;
 		det->totenergy = 0;
 	}
@@ -163,6 +185,9 @@ MPF_DECLARE(void) mpf_dtmf_detector_reset(struct mpf_dtmf_detector_t *detector)
 	detector->curr = detector->last1 = detector->last2 = 0;
 	detector->nsamples = 0;
 	detector->totenergy = 0;
+	detector->active = FALSE;
+	memset(detector->bank.s1, 0, sizeof(detector->bank.s1));
+	memset(detector->bank.s2, 0, sizeof(detector->bank.s2));
 	apr_thread_mutex_unlock(detector->mutex);
 }
 
@@ -180,19 +205,98 @@ static APR_INLINE void mpf_dtmf_detector_add_digit(
 	apr_thread_mutex_unlock(detector->mutex);
 }
 
-static APR_INLINE void goertzel_sample(
-								struct mpf_dtmf_detector_t *detector,
-								apr_int16_t sample)
+/** Feed samples to all the filters of the bank */
+static void goertzel_block(
+								struct goertzel_bank_t *bank,
+								const apr_int16_t *samples,
+								apr_size_t count)
 {
+	apr_size_t n;
+#if defined(GOERTZEL_SSE2)
+	__m128d c0 = _mm_loadu_pd(bank->coef), c1 = _mm_loadu_pd(bank->coef + 2);
+	__m128d c2 = _mm_loadu_pd(bank->coef + 4), c3 = _mm_loadu_pd(bank->coef + 6);
+	__m128d a0 = _mm_loadu_pd(bank->s1), a1 = _mm_loadu_pd(bank->s1 + 2);
+	__m128d a2 = _mm_loadu_pd(bank->s1 + 4), a3 = _mm_loadu_pd(bank->s1 + 6);
+	__m128d b0 = _mm_loadu_pd(bank->s2), b1 = _mm_loadu_pd(bank->s2 + 2);
+	__m128d b2 = _mm_loadu_pd(bank->s2 + 4), b3 = _mm_loadu_pd(bank->s2 + 6);
+	__m128d x, t;
+	for (n = 0; n < count; n++) {
+		x = _mm_set1_pd(samples[n]);
+		t = a0; a0 = b0; b0 = _mm_sub_pd(_mm_add_pd(x, _mm_mul_pd(c0, a0)), t);
+		t = a1; a1 = b1; b1 = _mm_sub_pd(_mm_add_pd(x, _mm_mul_pd(c1, a1)), t);
+		t = a2; a2 = b2; b2 = _mm_sub_pd(_mm_add_pd(x, _mm_mul_pd(c2, a2)), t);
+		t = a3; a3 = b3; b3 = _mm_sub_pd(_mm_add_pd(x, _mm_mul_pd(c3, a3)), t);
+	}
+	_mm_storeu_pd(bank->s1, a0); _mm_storeu_pd(bank->s1 + 2, a1);
+	_mm_storeu_pd(bank->s1 + 4, a2); _mm_storeu_pd(bank->s1 + 6, a3);
+	_mm_storeu_pd(bank->s2, b0); _mm_storeu_pd(bank->s2 + 2, b1);
+	_mm_storeu_pd(bank->s2 + 4, b2); _mm_storeu_pd(bank->s2 + 6, b3);
+#elif defined(GOERTZEL_NEON)
+	float64x2_t c0 = vld1q_f64(bank->coef), c1 = vld1q_f64(bank->coef + 2);
+	float64x2_t c2 = vld1q_f64(bank->coef + 4), c3 = vld1q_f64(bank->coef + 6);
+	float64x2_t a0 = vld1q_f64(bank->s1), a1 = vld1q_f64(bank->s1 + 2);
+	float64x2_t a2 = vld1q_f64(bank->s1 + 4), a3 = vld1q_f64(bank->s1 + 6);
+	float64x2_t b0 = vld1q_f64(bank->s2), b1 = vld1q_f64(bank->s2 + 2);
+	float64x2_t b2 = vld1q_f64(bank->s2 + 4), b3 = vld1q_f64(bank->s2 + 6);
+	float64x2_t x, t;
+	for (n = 0; n < count; n++) {
+		x = vdupq_n_f64(samples[n]);
+		t = a0; a0 = b0; b0 = vsubq_f64(vaddq_f64(x, vmulq_f64(c0, a0)), t);
+		t = a1; a1 = b1; b1 = vsubq_f64(vaddq_f64(x, vmulq_f64(c1, a1)), t);
+		t = a2; a2 = b2; b2 = vsubq_f64(vaddq_f64(x, vmulq_f64(c2, a2)), t);
+		t = a3; a3 = b3; b3 = vsubq_f64(vaddq_f64(x, vmulq_f64(c3, a3)), t);
+	}
+	vst1q_f64(bank->s1, a0); vst1q_f64(bank->s1 + 2, a1);
+	vst1q_f64(bank->s1 + 4, a2); vst1q_f64(bank->s1 + 6, a3);
+	vst1q_f64(bank->s2, b0); vst1q_f64(bank->s2 + 2, b1);
+	vst1q_f64(bank->s2 + 4, b2); vst1q_f64(bank->s2 + 6, b3);
+#else
 	apr_size_t i;
 	double s;
+	for (n = 0; n < count; n++) {
+		for (i = 0; i < DTMF_FREQUENCIES; i++) {
+			s = bank->s1[i];
+			bank->s1[i] = bank->s2[i];
+			bank->s2[i] = samples[n] + bank->coef[i] * bank->s1[i] - s;
+		}
+	}
+#endif
+}
+
+/** Sum of squares of samples */
+static double goertzel_block_energy(const apr_int16_t *samples, apr_size_t count)
+{
+	apr_size_t n = 0;
+	apr_uint64_t sum = 0;
+#if defined(GOERTZEL_SSE2)
+	__m128i acc = _mm_setzero_si128();
+	apr_uint64_t acc_arr[2];
+	for (; n + 8 <= count; n += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(samples + n));
+		__m128i sq = _mm_madd_epi16(v, v);
+		/* pairwise sums of squares fit in unsigned 32 bits */
+		acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(sq, _mm_setzero_si128()));
+		acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(sq, _mm_setzero_si128()));
+	}
+	_mm_storeu_si128((__m128i*)acc_arr, acc);
+	sum = acc_arr[0] + acc_arr[1];
+#endif
+	for (; n < count; n++) {
+		sum += (apr_int32_t)samples[n] * samples[n];
+	}
+	return (double)sum;
+}
+
+/** Reset Goertzel's detectors for the next window */
+static void goertzel_window_reset(struct mpf_dtmf_detector_t *detector)
+{
+	apr_size_t i;
 	for (i = 0; i < DTMF_FREQUENCIES; i++) {
-		s = detector->energies[i].s1;
-		detector->energies[i].s1 = detector->energies[i].s2;
-		detector->energies[i].s2 = sample +
-			detector->energies[i].coef * detector->energies[i].s1 - s;
+		detector->bank.s1[i] = 0;
+		detector->bank.s2[i] = 0;
 	}
-	detector->totenergy += sample * sample;
+	detector->totenergy = 0;
+	detector->active = FALSE;
 }
 
 static void goertzel_energies_digit(struct mpf_dtmf_detector_t *detector)
@@ -201,11 +305,12 @@ static void goertzel_energies_digit(struct mpf_dtmf_detector_t *detector)
 	double reng = 0, ceng = 0;
 	char digit = 0;
 
-	/* Calculate energies and maxims */
-	for (i = 0; i < DTMF_FREQUENCIES; i++) {
-		double eng = detector->energies[i].s1 * detector->energies[i].s1 +
-			detector->energies[i].s2 * detector->energies[i].s2 -
-			detector->energies[i].coef * detector->energies[i].s1 * detector->energies[i].s2;
+	/* Calculate energies and maxims, unless the whole window was gated off:
+	 * then energy of any tone is below wsamples * totenergy < tone_energy */
+	for (i = 0; detector->active && i < DTMF_FREQUENCIES; i++) {
+		double eng = detector->bank.s1[i] * detector->bank.s1[i] +
+			detector->bank.s2[i] * detector->bank.s2[i] -
+			detector->bank.coef[i] * detector->bank.s1[i] * detector->bank.s2[i];
 		if (i < DTMF_FREQUENCIES/2) {
 			if (eng > reng) {
 				rmax = i;
@@ -219,8 +324,8 @@ static void goertzel_energies_digit(struct mpf_dtmf_detector_t *detector)
 		}
 	}
 
-	if ((reng < 8.0e10 * detector->wsamples / GOERTZEL_SAMPLES_8K) ||
-		(ceng < 8.0e10 * detector->wsamples / GOERTZEL_SAMPLES_8K))
+	if ((reng < detector->tone_energy) ||
+		(ceng < detector->tone_energy))
 	{
 		/* energy not high enough */
 	} else if ((ceng > reng) && (reng < ceng * 0.398)) {  /* twist > 4dB, error */
@@ -254,18 +359,29 @@ static void goertzel_energies_digit(struct mpf_dtmf_detector_t *detector)
 	detector->last1 = detector->last2;
 	detector->last2 = digit;
 
-	/* Reset Goertzel's detectors */
-	for (i = 0; i < DTMF_FREQUENCIES; i++) {
-		detector->energies[i].s1 = 0;
-		detector->energies[i].s2 = 0;
-	}
-	detector->totenergy = 0;
+	goertzel_window_reset(detector);
 }
 
 MPF_DECLARE(void) mpf_dtmf_detector_get_frame(
 								struct mpf_dtmf_detector_t *detector,
 								const struct mpf_frame_t *frame)
 {
+	mpf_dtmf_detector_features_get_frame(detector, frame, NULL);
+}
+
+MPF_DECLARE(void) mpf_dtmf_detector_features_get_frame(
+								struct mpf_dtmf_detector_t *detector,
+								const struct mpf_frame_t *frame,
+								const mpf_frame_features_t *features)
+{
+	if ((detector->band & MPF_DTMF_DETECTOR_BOTH) == MPF_DTMF_DETECTOR_BOTH &&
+		detector->stream->tx_event_descriptor)
+	{
+		detector->band &= ~MPF_DTMF_DETECTOR_INBAND;
+		apt_log(APT_LOG_MARK, APT_PRIO_INFO, "RFC 4733 negotiated, turning "
+			"in-band DTMF detector off");
+	}
+
 	if ((detector->band & MPF_DTMF_DETECTOR_OUTBAND) &&
 		(frame->type & MEDIA_FRAME_TYPE_EVENT) &&
 		(frame->event_frame.event_id <= DTMF_EVENT_ID_MAX) &&
@@ -282,12 +398,56 @@ MPF_DECLARE(void) mpf_dtmf_detector_get_frame(
 	}
 
 	if ((detector->band & MPF_DTMF_DETECTOR_INBAND) && (frame->type & MEDIA_FRAME_TYPE_AUDIO)) {
-		apr_int16_t *samples = frame->codec_frame.buffer;
-		apr_size_t i;
+		const apr_int16_t *samples = frame->codec_frame.buffer;
+		apr_size_t count = frame->codec_frame.size / 2;
+		apr_size_t chunk;
+
+		if (mpf_termination_overload_level_get(detector->stream->termination) >= MPF_OVERLOAD_SEVERE) {
+			/* Suspended while media processing is overloaded, the partial
+			 * window is dropped and the analysis restarts once it is over. */
+			if (detector->nsamples) {
+				goertzel_window_reset(detector);
+				detector->nsamples = 0;
+			}
+			return;
+		}
+
+		if (features && !features->peak && !detector->active) {
+			/* Digital silence adds no energy, so the pre-gate stays closed
+			 * up to the end of the frame, only the windows are advanced. */
+			while (count) {
+				chunk = detector->wsamples - detector->nsamples;
+				if (chunk > count) chunk = count;
+
+				count -= chunk;
+				detector->nsamples += chunk;
+				if (detector->nsamples >= detector->wsamples) {
+					goertzel_energies_digit(detector);
+					detector->nsamples = 0;
+				}
+			}
+			return;
+		}
+
+		while (count) {
+			/* feed the rest of the current window or the rest of the frame */
+			chunk = detector->wsamples - detector->nsamples;
+			if (chunk > count) chunk = count;
+
+			detector->totenergy += goertzel_block_energy(samples, chunk);
+			/* Energy pre-gate: while the bank is at rest, skipping the silent lead of
+			 * the window equals feeding it zeros. The lead is kept under 1/16 of the
+			 * min tone energy bound (X(f)X'(f) <= wsamples * totenergy). */
+			if (!detector->active &&
+				detector->totenergy * detector->wsamples * 16 >= detector->tone_energy)
+				detector->active = TRUE;
+			if (detector->active)
+				goertzel_block(&detector->bank, samples, chunk);
 
-		for (i = 0; i < frame->codec_frame.size / 2; i++) {
-			goertzel_sample(detector, samples[i]);
-			if (++detector->nsamples >= detector->wsamples) {
+			samples += chunk;
+			count -= chunk;
+			detector->nsamples += chunk;
+			if (detector->nsamples >= detector->wsamples) {
 				goertzel_energies_digit(detector);
 				detector->nsamples = 0;
 			}
@@ -19,7 +19,9 @@
 #include "mpf_dtmf_generator.h"
 #include "apr.h"
 #include "apr_thread_mutex.h"
+#include "apr_atomic.h"
 #include "apt_log.h"
+#include "apt_pool.h"
 #include "mpf_named_event.h"
 #include <math.h>
 
@@ -51,21 +53,30 @@ typedef enum mpf_dtmf_generator_state_e {
 	DTMF_GEN_STATE_SILENCE
 } mpf_dtmf_generator_state_e;
 
+typedef struct dtmf_tone_table_t dtmf_tone_table_t;
+
 /**
- * Sine wave generator (second-order IIR filter) state:
+ * Precomputed period of a dual tone:
  *
- * s(t) = Amp*sin(2*pi*f_tone/f_sampling*t)
+ * s(t) = Amp*sin(2*pi*f1/f_sampling*t) + Amp*sin(2*pi*f2/f_sampling*t)
  *
- * s(t) = coef * s(t-1) - s(t-2); s(0)=0; s(1)=Amp*sin(2*pi*f_tone/f_sampling)
+ * The frequencies are integer, so the signal repeats every lcm(f_sampling/gcd(f_sampling,f1),
+ * f_sampling/gcd(f_sampling,f2)) samples (at most f_sampling, i.e. 1 sec). Tables are built
+ * once per digit and sampling rate and shared by all the generators of the process,
+ * frames are then filled by copying out of the table.
  */
-typedef struct sine_state_t {
-	/** coef = cos(2*pi*f_tone/f_sampling) */
-	double coef;
-	/** s(t-2) @see sine_state_t */
-	double s1;
-	/** s(t-1) @see sine_state_t */
-	double s2;
-} sine_state_t;
+struct dtmf_tone_table_t {
+	/** Sampling rate in Hz */
+	apr_uint32_t       sample_rate;
+	/** Number of samples of the period */
+	apr_size_t         period;
+	/** Samples of the period */
+	apr_int16_t       *samples;
+	/** Pool the table is allocated from */
+	apr_pool_t        *pool;
+	/** Next table of the digit (other sampling rate) */
+	dtmf_tone_table_t *next;
+};
 
 /** Mapping event_id to frequency pair */
 static const double dtmf_freq[DTMF_EVENT_ID_MAX+1][2] = {
@@ -87,6 +98,9 @@ static const double dtmf_freq[DTMF_EVENT_ID_MAX+1][2] = {
 	{941, 1633}   /* D */
 };
 
+/** Process-wide tone tables per digit, listed by sampling rate */
+static dtmf_tone_table_t *volatile dtmf_tone_tables[DTMF_EVENT_ID_MAX+1];
+
 /** Media Processing Framework's Dual Tone Multiple Frequncy generator */
 struct mpf_dtmf_generator_t {
 	/** Generator state */
@@ -111,10 +125,10 @@ struct mpf_dtmf_generator_t {
 	apr_uint32_t                     event_duration;
 	/** Set MPF_MARKER_NEW_SEGMENT in the next event frame */
 	apt_bool_t                       new_segment;
-	/** Lower frequency generator */
-	struct sine_state_t              sine1;
-	/** Higher frequency generator */
-	struct sine_state_t              sine2;
+	/** Tone table of the current digit */
+	const dtmf_tone_table_t         *tone;
+	/** Position in the period of the tone table */
+	apr_size_t                       tone_pos;
 	/** Sampling rate of audio in Hz; used in tone generator */
 	apr_uint32_t                     sample_rate_audio;
 	/** Sampling rate of telephone-events in Hz; used for timing */
@@ -126,6 +140,97 @@ struct mpf_dtmf_generator_t {
 };
 
 
+static apr_uint32_t dtmf_gcd_get(apr_uint32_t a, apr_uint32_t b)
+{
+	while (b) {
+		apr_uint32_t r = a % b;
+		a = b;
+		b = r;
+	}
+	return a;
+}
+
+static dtmf_tone_table_t* dtmf_tone_table_find(dtmf_tone_table_t *table, apr_uint32_t sample_rate)
+{
+	for (; table; table = table->next) {
+		if (table->sample_rate == sample_rate)
+			return table;
+	}
+	return NULL;
+}
+
+static dtmf_tone_table_t* dtmf_tone_table_create(apr_byte_t event_id, apr_uint32_t sample_rate)
+{
+	dtmf_tone_table_t *table;
+	apr_pool_t *pool;
+	apr_uint32_t f1 = (apr_uint32_t) dtmf_freq[event_id][0];
+	apr_uint32_t f2 = (apr_uint32_t) dtmf_freq[event_id][1];
+	apr_uint32_t p1 = sample_rate / dtmf_gcd_get(sample_rate, f1);
+	apr_uint32_t p2 = sample_rate / dtmf_gcd_get(sample_rate, f2);
+	double omega1 = 2 * M_PI * f1 / sample_rate;
+	double omega2 = 2 * M_PI * f2 / sample_rate;
+	apr_size_t i;
+
+	pool = apt_pool_create();
+	if (!pool) return NULL;
+	table = apr_palloc(pool, sizeof(dtmf_tone_table_t));
+	table->sample_rate = sample_rate;
+	/* lcm of the periods of both tones */
+	table->period = (apr_size_t) p1 / dtmf_gcd_get(p1, p2) * p2;
+	table->samples = apr_palloc(pool, table->period * sizeof(apr_int16_t));
+	table->pool = pool;
+	table->next = NULL;
+	for (i = 0; i < table->period; i++) {
+		table->samples[i] = (apr_int16_t) floor(DTMF_SINE_AMPLITUDE * (sin(omega1 * i) + sin(omega2 * i)) + 0.5);
+	}
+	return table;
+}
+
+/** Get the tone table of the digit and sampling rate, building and publishing it the first time */
+static const dtmf_tone_table_t* dtmf_tone_table_get(apr_byte_t event_id, apr_uint32_t sample_rate)
+{
+	dtmf_tone_table_t *head;
+	dtmf_tone_table_t *table = NULL;
+	dtmf_tone_table_t *found;
+
+	if (!sample_rate) return NULL;
+	do {
+		head = apr_atomic_casptr((volatile void**)&dtmf_tone_tables[event_id], NULL, NULL);
+		found = dtmf_tone_table_find(head, sample_rate);
+		if (found) {
+			/* another generator has published the table meanwhile */
+			if (table) apr_pool_destroy(table->pool);
+			return found;
+		}
+		if (!table) {
+			table = dtmf_tone_table_create(event_id, sample_rate);
+			if (!table) return NULL;
+		}
+		table->next = head;
+	} while (apr_atomic_casptr((volatile void**)&dtmf_tone_tables[event_id], table, head) != head);
+	return table;
+}
+
+/** Fill samples out of the tone table, going on from the current position */
+static void dtmf_tone_fill(struct mpf_dtmf_generator_t *generator, apr_int16_t *samples, apr_size_t count)
+{
+	const dtmf_tone_table_t *tone = generator->tone;
+	apr_size_t size;
+	if (!tone) {
+		memset(samples, 0, count * sizeof(apr_int16_t));
+		return;
+	}
+	while (count) {
+		size = tone->period - generator->tone_pos;
+		if (size > count) size = count;
+		memcpy(samples, tone->samples + generator->tone_pos, size * sizeof(apr_int16_t));
+		samples += size;
+		count -= size;
+		generator->tone_pos += size;
+		if (generator->tone_pos == tone->period) generator->tone_pos = 0;
+	}
+}
+
 MPF_DECLARE(struct mpf_dtmf_generator_t *) mpf_dtmf_generator_create_ex(
 								const struct mpf_audio_stream_t *stream,
 								enum mpf_dtmf_generator_band_e band,
@@ -148,6 +253,8 @@ MPF_DECLARE(struct mpf_dtmf_generator_t *) mpf_dtmf_generator_create_ex(
 	gen->band = (enum mpf_dtmf_generator_band_e) flg_band;
 	gen->queue[0] = 0;
 	gen->state = DTMF_GEN_STATE_IDLE;
+	gen->tone = NULL;
+	gen->tone_pos = 0;
 	if (stream->rx_descriptor)
 		gen->sample_rate_audio = stream->rx_descriptor->sampling_rate;
 	gen->sample_rate_events = stream->rx_event_descriptor ?
@@ -220,17 +327,8 @@ MPF_DECLARE(apt_bool_t) mpf_dtmf_generator_put_frame(
 			generator->new_segment = FALSE;
 			/* Initialize tone generator */
 			if (generator->band & MPF_DTMF_GENERATOR_INBAND) {
-				double omega;
-
-				omega = 2 * M_PI * dtmf_freq[generator->event_id][0] / generator->sample_rate_audio;
-				generator->sine1.s1 = 0;
-				generator->sine1.s2 = DTMF_SINE_AMPLITUDE * sin(omega);
-				generator->sine1.coef = 2 * cos(omega);
-
-				omega = 2 * M_PI * dtmf_freq[generator->event_id][1] / generator->sample_rate_audio;
-				generator->sine2.s1 = 0;
-				generator->sine2.s2 = DTMF_SINE_AMPLITUDE * sin(omega);
-				generator->sine2.coef = 2 * cos(omega);
+				generator->tone = dtmf_tone_table_get(generator->event_id, generator->sample_rate_audio);
+				generator->tone_pos = 0;
 			}
 		}
 	}
@@ -241,21 +339,9 @@ MPF_DECLARE(apt_bool_t) mpf_dtmf_generator_put_frame(
 		generator->counter += generator->frame_duration;
 		generator->event_duration += generator->frame_duration;
 		if (generator->band & MPF_DTMF_GENERATOR_INBAND) {
-			apr_size_t i;
-			apr_int16_t *samples = (apr_int16_t *) frame->codec_frame.buffer;
-			double s;
-
 			frame->type |= MEDIA_FRAME_TYPE_AUDIO;
 			/* Tone generator */
-			for (i = 0; i < frame->codec_frame.size / 2; i++) {
-				s = generator->sine1.s1;
-				generator->sine1.s1 = generator->sine1.s2;
-				generator->sine1.s2 = generator->sine1.coef * generator->sine1.s1 - s;
-				samples[i] = (apr_int16_t) (s + generator->sine2.s1);
-				s = generator->sine2.s1;
-				generator->sine2.s1 = generator->sine2.s2;
-				generator->sine2.s2 = generator->sine2.coef * generator->sine2.s1 - s;
-			}
+			dtmf_tone_fill(generator, (apr_int16_t *) frame->codec_frame.buffer, frame->codec_frame.size / 2);
 		}
 		if (generator->band & MPF_DTMF_GENERATOR_OUTBAND) {
 			generator->since_last_event += CODEC_FRAME_TIME_BASE;
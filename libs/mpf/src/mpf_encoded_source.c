@@ -0,0 +1,252 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <apr_atomic.h>
+#include "mpf_encoded_source.h"
+#include "apt_log.h"
+
+/** Frame in the ring */
+typedef struct mpf_encoded_slot_t mpf_encoded_slot_t;
+struct mpf_encoded_slot_t {
+	/** Timestamp of the frame */
+	apr_uint32_t timestamp;
+	/** Size of the payload */
+	apr_size_t   size;
+	/** Payload */
+	char        *data;
+};
+
+/** Encoded source */
+struct mpf_encoded_source_t {
+	/** Frames written by the application */
+	mpf_encoded_slot_t   *slots;
+	/** Number of slots */
+	apr_uint32_t          slot_count;
+	/** Max size of payload */
+	apr_size_t            max_size;
+	/** Number of samples of a frame time */
+	apr_uint32_t          samples;
+
+	/** Separate producer and consumer positions to avoid false sharing */
+	char                  pad1[64];
+	/** Number of written frames (advanced by producer) */
+	volatile apr_uint32_t write_pos;
+	/** Number of frames dropped, as the ring was full */
+	volatile apr_uint32_t overruns;
+	char                  pad2[64];
+	/** Number of read frames (advanced by consumer) */
+	volatile apr_uint32_t read_pos;
+	/** Play-out timestamp of the next frame time (consumer) */
+	apr_uint32_t          play_timestamp;
+	/** Whether the play-out is synchronized to the first frame (consumer) */
+	apt_bool_t            started;
+	/** Counters of the consumer */
+	volatile apr_uint32_t played;
+	volatile apr_uint32_t late;
+	volatile apr_uint32_t gaps;
+	volatile apr_uint32_t resyncs;
+	volatile apr_uint32_t invalid;
+};
+
+static apt_bool_t mpf_encoded_source_destroy(mpf_audio_stream_t *stream);
+static apt_bool_t mpf_encoded_source_open_rx(mpf_audio_stream_t *stream, mpf_codec_t *codec);
+static apt_bool_t mpf_encoded_source_close_rx(mpf_audio_stream_t *stream);
+static apt_bool_t mpf_encoded_source_frame_read(mpf_audio_stream_t *stream, mpf_frame_t *frame);
+
+static const mpf_audio_stream_vtable_t vtable = {
+	mpf_encoded_source_destroy,
+	mpf_encoded_source_open_rx,
+	mpf_encoded_source_close_rx,
+	mpf_encoded_source_frame_read,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+/** Load with full barrier (acquire semantics) */
+static APR_INLINE apr_uint32_t mpf_encoded_source_load(volatile apr_uint32_t *mem)
+{
+	return apr_atomic_add32(mem,0);
+}
+
+MPF_DECLARE(mpf_audio_stream_t*) mpf_encoded_source_create(
+									const mpf_codec_descriptor_t *codec_descriptor,
+									apr_size_t depth,
+									apr_pool_t *pool)
+{
+	mpf_encoded_source_t *source;
+	mpf_stream_capabilities_t *capabilities;
+	mpf_audio_stream_t *stream;
+	apr_uint32_t i;
+
+	if(!codec_descriptor || !codec_descriptor->name.buf) {
+		return NULL;
+	}
+
+	capabilities = mpf_source_stream_capabilities_create(pool);
+	/* the only codec, so that no transcoding is negotiated */
+	mpf_codec_capabilities_add(
+			&capabilities->codecs,
+			mpf_sample_rate_mask_get(codec_descriptor->sampling_rate),
+			codec_descriptor->name.buf);
+
+	source = apr_palloc(pool,sizeof(mpf_encoded_source_t));
+	stream = mpf_audio_stream_create(source,&vtable,capabilities,pool);
+	if(!stream) {
+		return NULL;
+	}
+	stream->rx_descriptor = mpf_codec_descriptor_create(pool);
+	*stream->rx_descriptor = *codec_descriptor;
+
+	if(!depth) {
+		depth = 1;
+	}
+	source->samples = (apr_uint32_t)mpf_codec_frame_samples_calculate(codec_descriptor);
+	/* the payload never exceeds linear PCM of the same frame time */
+	source->max_size = source->samples * BYTES_PER_SAMPLE;
+	source->slot_count = (apr_uint32_t)depth;
+	source->slots = apr_palloc(pool,sizeof(mpf_encoded_slot_t) * source->slot_count);
+	for(i=0; i<source->slot_count; i++) {
+		source->slots[i].timestamp = 0;
+		source->slots[i].size = 0;
+		source->slots[i].data = apr_palloc(pool,source->max_size);
+	}
+	source->write_pos = source->read_pos = 0;
+	source->overruns = 0;
+	source->play_timestamp = 0;
+	source->started = FALSE;
+	source->played = source->late = source->gaps = source->resyncs = source->invalid = 0;
+	return stream;
+}
+
+MPF_DECLARE(mpf_encoded_source_t*) mpf_encoded_source_get(const mpf_audio_stream_t *stream)
+{
+	if(stream->vtable != &vtable) {
+		return NULL;
+	}
+	return stream->obj;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_encoded_source_write(
+									mpf_encoded_source_t *source,
+									const void *data,
+									apr_size_t size,
+									apr_uint32_t timestamp)
+{
+	mpf_encoded_slot_t *slot;
+	apr_uint32_t write_pos = source->write_pos;
+	if(size > source->max_size) {
+		return FALSE;
+	}
+	if(write_pos - mpf_encoded_source_load(&source->read_pos) >= source->slot_count) {
+		/* media processing lags behind, never wait for it */
+		apr_atomic_inc32(&source->overruns);
+		return FALSE;
+	}
+	slot = &source->slots[write_pos % source->slot_count];
+	slot->timestamp = timestamp;
+	slot->size = size;
+	memcpy(slot->data,data,size);
+	/* publish the frame */
+	apr_atomic_set32(&source->write_pos,write_pos + 1);
+	return TRUE;
+}
+
+MPF_DECLARE(void) mpf_encoded_source_stat_get(mpf_encoded_source_t *source, mpf_encoded_source_stat_t *stat)
+{
+	stat->played = apr_atomic_xchg32(&source->played,0);
+	stat->late = apr_atomic_xchg32(&source->late,0);
+	stat->overruns = apr_atomic_xchg32(&source->overruns,0);
+	stat->gaps = apr_atomic_xchg32(&source->gaps,0);
+	stat->resyncs = apr_atomic_xchg32(&source->resyncs,0);
+	stat->invalid = apr_atomic_xchg32(&source->invalid,0);
+}
+
+static apt_bool_t mpf_encoded_source_destroy(mpf_audio_stream_t *stream)
+{
+	return TRUE;
+}
+
+static apt_bool_t mpf_encoded_source_open_rx(mpf_audio_stream_t *stream, mpf_codec_t *codec)
+{
+	mpf_encoded_source_t *source = stream->obj;
+	/* the frames written before are played out, synchronized to the first of them */
+	source->started = FALSE;
+	return TRUE;
+}
+
+static apt_bool_t mpf_encoded_source_close_rx(mpf_audio_stream_t *stream)
+{
+	return TRUE;
+}
+
+static apt_bool_t mpf_encoded_source_frame_read(mpf_audio_stream_t *stream, mpf_frame_t *frame)
+{
+	mpf_encoded_source_t *source = stream->obj;
+	mpf_encoded_slot_t *slot;
+	apr_int32_t diff;
+	apr_uint32_t read_pos = source->read_pos;
+	apr_uint32_t write_pos = mpf_encoded_source_load(&source->write_pos);
+
+	for(; read_pos != write_pos; read_pos++) {
+		slot = &source->slots[read_pos % source->slot_count];
+		if(source->started == FALSE) {
+			source->play_timestamp = slot->timestamp;
+			source->started = TRUE;
+		}
+		diff = (apr_int32_t)(slot->timestamp - source->play_timestamp);
+		if(diff < 0) {
+			/* behind the play-out, drop */
+			apr_atomic_inc32(&source->late);
+			continue;
+		}
+		if(diff >= (apr_int32_t)source->samples) {
+			if(diff <= (apr_int32_t)(source->samples * source->slot_count)) {
+				/* a gap within the depth, send silence for the missing frame */
+				break;
+			}
+			/* too far ahead to wait for, jump to the frame */
+			source->play_timestamp = slot->timestamp;
+			apr_atomic_inc32(&source->resyncs);
+		}
+
+		if(slot->size == frame->codec_frame.size) {
+			memcpy(frame->codec_frame.buffer,slot->data,slot->size);
+			frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+			apr_atomic_inc32(&source->played);
+		}
+		else {
+			/* not a frame of the negotiated codec */
+			apr_atomic_inc32(&source->invalid);
+		}
+		read_pos++;
+		break;
+	}
+	/* release the slots read */
+	apr_atomic_set32(&source->read_pos,read_pos);
+
+	if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == 0 && source->started == TRUE) {
+		apr_atomic_inc32(&source->gaps);
+	}
+	if(source->started == TRUE) {
+		source->play_timestamp += source->samples;
+	}
+	return TRUE;
+}
@@ -17,6 +17,7 @@
  */
 
 #include "mpf_encoder.h"
+#include "mpf_comfort_noise.h"
 #include "apt_log.h"
 
 typedef struct mpf_encoder_t mpf_encoder_t;
@@ -26,6 +27,8 @@ struct mpf_encoder_t {
 	mpf_audio_stream_t *sink;
 	mpf_codec_t        *codec;
 	mpf_frame_t         frame_out;
+	/** Number of consecutive silent frames (used if comfort noise is negotiated) */
+	apr_size_t          silence_count;
 };
 
 
@@ -49,6 +52,26 @@ static apt_bool_t mpf_encoder_close(mpf_audio_stream_t *stream)
 	return mpf_audio_stream_tx_close(encoder->sink);
 }
 
+static void mpf_encoder_silence_detect(mpf_encoder_t *encoder, const mpf_codec_frame_t *frame_in)
+{
+	/* the frame has been encoded anyway to keep the state of the codec continuous */
+	apr_byte_t level = mpf_cn_level_calculate(frame_in->buffer,frame_in->size / sizeof(apr_int16_t));
+	if(level < MPF_CN_SILENCE_LEVEL) {
+		encoder->silence_count = 0;
+		return;
+	}
+
+	if(encoder->silence_count < MPF_CN_HANGOVER_FRAMES) {
+		/* hangover, keep sending the tail of the talkspurt */
+		encoder->silence_count++;
+		return;
+	}
+
+	/* let the sink send the noise level in place of the audio */
+	encoder->frame_out.type = (encoder->frame_out.type & ~MEDIA_FRAME_TYPE_AUDIO) | MEDIA_FRAME_TYPE_CN;
+	*(apr_byte_t*)encoder->frame_out.codec_frame.buffer = level;
+}
+
 static apt_bool_t mpf_encoder_process(mpf_audio_stream_t *stream, const mpf_frame_t *frame)
 {
 	mpf_encoder_t *encoder = stream->obj;
@@ -60,6 +83,9 @@ static apt_bool_t mpf_encoder_process(mpf_audio_stream_t *stream, const mpf_fram
 	}
 	if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO) {
 		mpf_codec_encode(encoder->codec,&frame->codec_frame,&encoder->frame_out.codec_frame);
+		if(encoder->sink->tx_cn_descriptor) {
+			mpf_encoder_silence_detect(encoder,&frame->codec_frame);
+		}
 	}
 	return mpf_audio_stream_frame_write(encoder->sink,&encoder->frame_out);
 }
@@ -114,9 +140,11 @@ MPF_DECLARE(mpf_audio_stream_t*) mpf_encoder_create(mpf_audio_stream_t *sink, mp
 		sink->tx_descriptor->channel_count,
 		pool);
 	encoder->base->tx_event_descriptor = sink->tx_event_descriptor;
+	encoder->base->tx_cn_descriptor = sink->tx_cn_descriptor;
 	
 	encoder->sink = sink;
 	encoder->codec = codec;
+	encoder->silence_count = 0;
 
 	frame_size = mpf_codec_frame_size_calculate(sink->tx_descriptor,codec->attribs);
 	encoder->frame_out.codec_frame.size = frame_size;
@@ -23,25 +23,113 @@
 #include "mpf_scheduler.h"
 #include "mpf_codec_descriptor.h"
 #include "mpf_codec_manager.h"
+#include "mpf_jitter_buffer.h"
+#include "mpf_rtcp_agent.h"
 #include "apt_obj_list.h"
-#include "apt_cyclic_queue.h"
+#include "apt_mpsc_queue.h"
 #include "apt_log.h"
+#include "apt_probe.h"
+#include <apr_atomic.h>
+#include <apr_hash.h>
+#include <apr_strings.h>
 
 #define MPF_TIMER_RESOLUTION 100 /* 100 ms */
 
+/** Max number of pending requests */
+#define MPF_REQUEST_QUEUE_SIZE 4096
+/** Number of requests popped from the request queue at once */
+#define MPF_REQUEST_BATCH_SIZE 64
+
+/** Number of preallocated task messages (requests and responses in flight) */
+#define MPF_ENGINE_MSG_POOL_SIZE 1024
+
+/** Min interval between subsequent reports of tick overruns (usec) */
+#define MPF_OVERRUN_REPORT_INTERVAL APR_USEC_PER_SEC
+
+/** Interval between subsequent snapshots of statistics of contexts (usec) */
+#define MPF_CONTEXT_STAT_INTERVAL APR_USEC_PER_SEC
+
+/** Number of subsequent ticks deferring objects, the overload is severe after */
+#define MPF_OVERLOAD_SEVERE_TICKS 5
+/** Number of subsequent ticks under the overload condition, the level falls one step after */
+#define MPF_OVERLOAD_RECOVERY_TICKS 50
+
+/** Media processing worker (shard of media contexts driven by its own scheduler) */
+typedef struct mpf_engine_worker_t mpf_engine_worker_t;
+/** RTP stream registered to take snapshots of statistics of */
+typedef struct mpf_engine_rtp_stat_entry_t mpf_engine_rtp_stat_entry_t;
+
+struct mpf_engine_rtp_stat_entry_t {
+	void                        *obj;
+	mpf_rtp_stat_handler_f       handler;
+	mpf_engine_rtp_stat_entry_t *next;
+};
+
+struct mpf_engine_worker_t {
+	mpf_engine_t              *engine;
+	apr_size_t                 id;
+	apr_thread_mutex_t        *guard;
+	mpf_context_factory_t     *context_factory;
+	mpf_scheduler_t           *scheduler;
+	apt_timer_queue_t         *timer_queue;
+	mpf_tx_batch_t            *tx_batch;
+	mpf_uring_t               *uring;
+	mpf_jb_slab_t             *jb_slab;
+	/* huge page region the hot data of the worker is allocated from (NULL if none) */
+	apt_huge_region_t         *region;
+
+	/* RTP streams are registered and walked under the stat guard,
+	which is never held for the time of media processing */
+	apr_thread_mutex_t        *stat_guard;
+	apr_hash_t                *rtp_stats;
+	mpf_engine_rtp_stat_entry_t *rtp_stat_free;
+	/* snapshot of statistics of contexts taken by the worker (NULL if not accounted) */
+	mpf_context_stat_t        *context_top;
+	apr_size_t                 context_top_count;
+	mpf_context_group_stat_t  *context_groups;
+	apr_size_t                 context_group_count;
+	apr_time_t                 context_stat_time;
+
+	mpf_engine_tick_stat_t     tick_stat;
+	apr_time_t                 overrun_report_time;
+	apr_uint32_t               overrun_report_count;
+
+	/* overload level the terminations of the worker reduce optional work by */
+	mpf_overload_level_e       overload_level;
+	/* number of subsequent ticks deferring objects */
+	apr_size_t                 deferral_ticks;
+	/* number of subsequent ticks below the current overload level */
+	apr_size_t                 recovery_ticks;
+};
+
 struct mpf_engine_t {
 	apr_pool_t                *pool;
 	apt_task_t                *task;
 	apt_task_msg_type_e        task_msg_type;
-	apr_thread_mutex_t        *request_queue_guard;
-	apt_cyclic_queue_t        *request_queue;
-	mpf_context_factory_t     *context_factory;
-	mpf_scheduler_t           *scheduler;
-	apt_timer_queue_t         *timer_queue;
+	apt_mpsc_queue_t          *request_queue;
+	apr_array_header_t        *pending_responses;
+	mpf_engine_worker_t       *workers;
+	apr_size_t                 worker_count;
+	volatile apr_uint32_t      next_worker;
+	unsigned long              scheduler_rate;
+	mpf_scheduler_clock_e      scheduler_clock;
+	int                        scheduler_priority;
+	int                        scheduler_cpu;
+	apt_cpu_set_t             *scheduler_cpu_set;
+	mpf_context_layout_e       context_layout;
+	apt_bool_t                 io_uring;
+	/* RTCP of all the workers is processed by the agent (NULL if not offloaded) */
+	mpf_rtcp_agent_t          *rtcp_agent;
+	/* size of the huge page region of each worker (0 if none) */
+	apr_size_t                 region_size;
+	apt_bool_t                 cpu_accounting;
+	/* deadline of the tick in percents of its interval (0 if none) */
+	apr_size_t                 tick_deadline;
 	const mpf_codec_manager_t *codec_manager;
 };
 
 static void mpf_engine_main(mpf_scheduler_t *scheduler, void *obj);
+static void mpf_engine_worker_main(mpf_scheduler_t *scheduler, void *obj);
 static void mpf_engine_timer_proc(mpf_scheduler_t *scheduler, void *obj);
 static apt_bool_t mpf_engine_destroy(apt_task_t *task);
 static apt_bool_t mpf_engine_start(apt_task_t *task);
@@ -53,6 +141,8 @@ static apt_bool_t mpf_engine_msg_process(apt_task_t *task, apt_task_msg_t *msg);
 mpf_codec_t* mpf_codec_l16_create(apr_pool_t *pool);
 mpf_codec_t* mpf_codec_g711u_create(apr_pool_t *pool);
 mpf_codec_t* mpf_codec_g711a_create(apr_pool_t *pool);
+mpf_codec_t* mpf_codec_g722_create(apr_pool_t *pool);
+mpf_codec_t* mpf_codec_opus_create(apr_pool_t *pool);
 
 MPF_DECLARE(mpf_engine_t*) mpf_engine_create(const char *id, apr_pool_t *pool)
 {
@@ -61,10 +151,24 @@ MPF_DECLARE(mpf_engine_t*) mpf_engine_create(const char *id, apr_pool_t *pool)
 	mpf_engine_t *engine = apr_palloc(pool,sizeof(mpf_engine_t));
 	engine->pool = pool;
 	engine->request_queue = NULL;
-	engine->context_factory = NULL;
+	engine->pending_responses = NULL;
+	engine->workers = NULL;
+	engine->worker_count = 0;
+	engine->next_worker = 0;
+	engine->scheduler_rate = 1;
+	engine->scheduler_clock = MPF_SCHEDULER_CLOCK_DEFAULT;
+	engine->scheduler_priority = 0;
+	engine->scheduler_cpu = -1;
+	engine->scheduler_cpu_set = NULL;
+	engine->context_layout = MPF_CONTEXT_LAYOUT_DEFAULT;
+	engine->io_uring = FALSE;
+	engine->region_size = 0;
+	engine->cpu_accounting = FALSE;
+	engine->tick_deadline = 0;
+	engine->rtcp_agent = NULL;
 	engine->codec_manager = NULL;
 
-	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(mpf_message_container_t),pool);
+	msg_pool = apt_task_msg_pool_create_static(sizeof(mpf_message_container_t),MPF_ENGINE_MSG_POOL_SIZE,pool);
 
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Create Media Engine [%s]",id);
 	engine->task = apt_task_create(engine,msg_pool,pool);
@@ -85,18 +189,137 @@ MPF_DECLARE(mpf_engine_t*) mpf_engine_create(const char *id, apr_pool_t *pool)
 
 	engine->task_msg_type = TASK_MSG_USER;
 
-	engine->context_factory = mpf_context_factory_create(engine->pool);
-	engine->request_queue = apt_cyclic_queue_create(CYCLIC_QUEUE_DEFAULT_SIZE);
-	apr_thread_mutex_create(&engine->request_queue_guard,APR_THREAD_MUTEX_UNNESTED,engine->pool);
-
-	engine->scheduler = mpf_scheduler_create(engine->pool);
-	mpf_scheduler_media_clock_set(engine->scheduler,CODEC_FRAME_TIME_BASE,mpf_engine_main,engine);
+	engine->request_queue = apt_mpsc_queue_create(MPF_REQUEST_QUEUE_SIZE);
+	engine->pending_responses = apr_array_make(pool,MPF_REQUEST_BATCH_SIZE,sizeof(apt_task_msg_t*));
 
-	engine->timer_queue = apt_timer_queue_create(engine->pool);
-	mpf_scheduler_timer_clock_set(engine->scheduler,MPF_TIMER_RESOLUTION,mpf_engine_timer_proc,engine);
+	/* the first (main) worker also processes the request queue */
+	mpf_engine_worker_count_set(engine,1);
 	return engine;
 }
 
+static void mpf_engine_worker_clock_set(mpf_engine_t *engine, mpf_engine_worker_t *worker)
+{
+	mpf_scheduler_media_clock_set(
+		worker->scheduler,
+		CODEC_FRAME_TIME_BASE,
+		worker->id == 0 ? mpf_engine_main : mpf_engine_worker_main,
+		worker);
+	mpf_scheduler_timer_clock_set(worker->scheduler,MPF_TIMER_RESOLUTION,mpf_engine_timer_proc,worker);
+	if(engine->scheduler_rate > 1) {
+		mpf_scheduler_rate_set(worker->scheduler,engine->scheduler_rate);
+	}
+}
+
+static void mpf_engine_worker_accounting_set(mpf_engine_t *engine, mpf_engine_worker_t *worker, apt_bool_t enable)
+{
+	mpf_context_factory_accounting_set(worker->context_factory,enable);
+	if(enable == TRUE && !worker->context_top) {
+		worker->context_top = apr_palloc(engine->pool,sizeof(mpf_context_stat_t) * MPF_ENGINE_CONTEXT_TOP_SIZE);
+		worker->context_groups = apr_palloc(engine->pool,sizeof(mpf_context_group_stat_t) * MPF_CONTEXT_MAX_GROUP_COUNT);
+	}
+}
+
+static void mpf_engine_worker_init(mpf_engine_t *engine, mpf_engine_worker_t *worker, apr_size_t id)
+{
+	worker->engine = engine;
+	worker->id = id;
+	worker->guard = NULL;
+	if(id != 0) {
+		/* request queue is processed in the context of the main worker, 
+		the rest of the workers should be synchronized with it */
+		apr_thread_mutex_create(&worker->guard,APR_THREAD_MUTEX_UNNESTED,engine->pool);
+	}
+	worker->stat_guard = NULL;
+	apr_thread_mutex_create(&worker->stat_guard,APR_THREAD_MUTEX_UNNESTED,engine->pool);
+	worker->rtp_stats = apr_hash_make(engine->pool);
+	worker->rtp_stat_free = NULL;
+	worker->context_top = NULL;
+	worker->context_top_count = 0;
+	worker->context_groups = NULL;
+	worker->context_group_count = 0;
+	worker->context_stat_time = 0;
+	memset(&worker->tick_stat,0,sizeof(mpf_engine_tick_stat_t));
+	worker->overrun_report_time = 0;
+	worker->overrun_report_count = 0;
+	worker->overload_level = MPF_OVERLOAD_NONE;
+	worker->deferral_ticks = 0;
+	worker->recovery_ticks = 0;
+	worker->context_factory = mpf_context_factory_create(engine->pool);
+	mpf_context_factory_layout_set(worker->context_factory,engine->context_layout);
+	if(engine->cpu_accounting == TRUE) {
+		mpf_engine_worker_accounting_set(engine,worker,TRUE);
+	}
+	worker->scheduler = mpf_scheduler_create(engine->pool);
+	worker->timer_queue = apt_timer_queue_create(engine->pool);
+	worker->tx_batch = mpf_tx_batch_create(MPF_TX_BATCH_DEFAULT_SIZE,engine->pool);
+	worker->uring = NULL;
+	if(engine->io_uring == TRUE) {
+		worker->uring = mpf_uring_create(MPF_URING_DEFAULT_DEPTH,engine->pool);
+		mpf_tx_batch_uring_set(worker->tx_batch,worker->uring);
+	}
+	/* jitter buffers of the worker take their frames from the slab on demand */
+	worker->jb_slab = mpf_jb_slab_create(NULL);
+	worker->region = NULL;
+	if(engine->region_size) {
+		worker->region = apt_huge_region_create(engine->region_size,engine->pool);
+		if(worker->jb_slab) {
+			mpf_jb_slab_region_set(worker->jb_slab,worker->region);
+		}
+	}
+	mpf_engine_worker_clock_set(engine,worker);
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_worker_count_set(mpf_engine_t *engine, apr_size_t worker_count)
+{
+	apr_size_t i;
+	mpf_engine_worker_t *workers;
+	if(worker_count == 0 || worker_count > MPF_MAX_WORKER_COUNT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Number of Media Workers [%"APR_SIZE_T_FMT"] [%s]",
+			worker_count,mpf_engine_id_get(engine));
+		return FALSE;
+	}
+	if(worker_count <= engine->worker_count) {
+		/* workers can only be added before the engine is started */
+		return worker_count == engine->worker_count ? TRUE : FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Number of Media Workers [%"APR_SIZE_T_FMT"] [%s]",
+		worker_count,mpf_engine_id_get(engine));
+	workers = apr_palloc(engine->pool,sizeof(mpf_engine_worker_t) * worker_count);
+	for(i=0; i<engine->worker_count; i++) {
+		/* relocate existing workers and rebind their clocks */
+		workers[i] = engine->workers[i];
+		mpf_engine_worker_clock_set(engine,&workers[i]);
+	}
+	for(; i<worker_count; i++) {
+		mpf_engine_worker_init(engine,&workers[i],i);
+	}
+	engine->workers = workers;
+	engine->worker_count = worker_count;
+	return TRUE;
+}
+
+MPF_DECLARE(apr_size_t) mpf_engine_worker_count_get(const mpf_engine_t *engine)
+{
+	return engine->worker_count;
+}
+
+static APR_INLINE mpf_engine_worker_t* mpf_engine_worker_find(mpf_engine_t *engine, const mpf_context_t *context)
+{
+	apr_size_t i;
+	mpf_context_factory_t *factory;
+	if(!context || engine->worker_count == 1) {
+		return &engine->workers[0];
+	}
+	factory = mpf_context_factory_get(context);
+	for(i=0; i<engine->worker_count; i++) {
+		if(engine->workers[i].context_factory == factory) {
+			return &engine->workers[i];
+		}
+	}
+	return &engine->workers[0];
+}
+
 MPF_DECLARE(mpf_context_t*) mpf_engine_context_create(
 								mpf_engine_t *engine,
 								const char *name,
@@ -104,7 +327,13 @@ MPF_DECLARE(mpf_context_t*) mpf_engine_context_create(
 								apr_size_t max_termination_count,
 								apr_pool_t *pool)
 {
-	return mpf_context_create(engine->context_factory,name,obj,max_termination_count,pool);
+	mpf_engine_worker_t *worker = engine->workers;
+	if(engine->worker_count > 1) {
+		/* pin the context to one of the workers in round-robin fashion */
+		apr_uint32_t index = apr_atomic_inc32(&engine->next_worker);
+		worker = &engine->workers[index % engine->worker_count];
+	}
+	return mpf_context_create(worker->context_factory,name,obj,max_termination_count,pool);
 }
 
 MPF_DECLARE(apt_bool_t) mpf_engine_context_destroy(mpf_context_t *context)
@@ -136,6 +365,7 @@ static mpf_message_t* mpf_engine_message_get(mpf_engine_t *engine, mpf_task_msg_
 		if(container->count >= MAX_MPF_MESSAGE_COUNT) {
 			/* container has been already filled,
 			implicitly send the requests and get new task message */
+			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Split MPF Requests [%d]",MAX_MPF_MESSAGE_COUNT);
 			mpf_engine_message_send(engine,task_msg);
 			return mpf_engine_message_get(engine,task_msg);
 		}
@@ -225,30 +455,79 @@ MPF_DECLARE(apt_bool_t) mpf_engine_message_send(mpf_engine_t *engine, mpf_task_m
 
 static apt_bool_t mpf_engine_destroy(apt_task_t *task)
 {
+	apr_size_t i;
+	mpf_engine_worker_t *worker;
 	mpf_engine_t *engine = apt_task_object_get(task);
 
-	apt_timer_queue_destroy(engine->timer_queue);
-	mpf_scheduler_destroy(engine->scheduler);
-	mpf_context_factory_destroy(engine->context_factory);
-	apt_cyclic_queue_destroy(engine->request_queue);
-	apr_thread_mutex_destroy(engine->request_queue_guard);
+	for(i=0; i<engine->worker_count; i++) {
+		worker = &engine->workers[i];
+		apt_timer_queue_destroy(worker->timer_queue);
+		mpf_tx_batch_destroy(worker->tx_batch);
+		if(worker->uring) {
+			mpf_uring_destroy(worker->uring);
+		}
+		if(worker->jb_slab) {
+			mpf_jb_slab_destroy(worker->jb_slab);
+		}
+		if(worker->region) {
+			/* the blocks of the slab are gone by now */
+			apt_huge_region_destroy(worker->region);
+			worker->region = NULL;
+		}
+		mpf_scheduler_destroy(worker->scheduler);
+		mpf_context_factory_destroy(worker->context_factory);
+		if(worker->guard) {
+			apr_thread_mutex_destroy(worker->guard);
+		}
+		if(worker->stat_guard) {
+			apr_thread_mutex_destroy(worker->stat_guard);
+		}
+	}
+	if(engine->rtcp_agent) {
+		mpf_rtcp_agent_destroy(engine->rtcp_agent);
+		engine->rtcp_agent = NULL;
+	}
+	apt_mpsc_queue_destroy(engine->request_queue);
 	return TRUE;
 }
 
 static apt_bool_t mpf_engine_start(apt_task_t *task)
 {
+	apr_size_t i;
 	mpf_engine_t *engine = apt_task_object_get(task);
 
-	mpf_scheduler_start(engine->scheduler);
+	mpf_scheduler_t *scheduler;
+	for(i=0; i<engine->worker_count; i++) {
+		scheduler = engine->workers[i].scheduler;
+		mpf_scheduler_clock_source_set(scheduler,engine->scheduler_clock);
+		mpf_scheduler_thread_priority_set(scheduler,engine->scheduler_priority);
+		if(engine->scheduler_cpu >= 0) {
+			/* bind workers to consecutive CPUs starting from the specified one */
+			mpf_scheduler_thread_affinity_set(scheduler,engine->scheduler_cpu + (int)i);
+		}
+		else if(engine->scheduler_cpu_set) {
+			mpf_scheduler_thread_cpu_set_set(scheduler,engine->scheduler_cpu_set);
+		}
+		mpf_scheduler_start(scheduler);
+	}
+	if(engine->rtcp_agent) {
+		mpf_rtcp_agent_start(engine->rtcp_agent);
+	}
 	apt_task_start_request_process(task);
 	return TRUE;
 }
 
 static apt_bool_t mpf_engine_terminate(apt_task_t *task)
 {
+	apr_size_t i;
 	mpf_engine_t *engine = apt_task_object_get(task);
 
-	mpf_scheduler_stop(engine->scheduler);
+	for(i=0; i<engine->worker_count; i++) {
+		mpf_scheduler_stop(engine->workers[i].scheduler);
+	}
+	if(engine->rtcp_agent) {
+		mpf_rtcp_agent_stop(engine->rtcp_agent);
+	}
 	apt_task_terminate_request_process(task);
 	return TRUE;
 }
@@ -287,11 +566,10 @@ static apt_bool_t mpf_engine_msg_signal(apt_task_t *task, apt_task_msg_t *msg)
 {
 	mpf_engine_t *engine = apt_task_object_get(task);
 	
-	apr_thread_mutex_lock(engine->request_queue_guard);
-	if(apt_cyclic_queue_push(engine->request_queue,msg) == FALSE) {
+	if(apt_mpsc_queue_push(engine->request_queue,msg) == FALSE) {
 		apt_log(APT_LOG_MARK,APT_PRIO_ERROR,"MPF Request Queue is Full [%s]",apt_task_name_get(task));
+		return FALSE;
 	}
-	apr_thread_mutex_unlock(engine->request_queue_guard);
 	return TRUE;
 }
 
@@ -304,6 +582,7 @@ static apt_bool_t mpf_engine_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 	mpf_message_t *mpf_response;
 	mpf_context_t *context;
 	mpf_termination_t *termination;
+	mpf_engine_worker_t *worker;
 	const mpf_message_t *mpf_request;
 	const mpf_message_container_t *request = (const mpf_message_container_t*) msg->data;
 
@@ -327,13 +606,23 @@ static apt_bool_t mpf_engine_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 		mpf_response->status_code = MPF_STATUS_CODE_SUCCESS;
 		context = mpf_request->context;
 		termination = mpf_request->termination;
+		worker = mpf_engine_worker_find(engine,context);
+		if(worker->guard) {
+			apr_thread_mutex_lock(worker->guard);
+		}
 		switch(mpf_request->command_id) {
 			case MPF_ADD_TERMINATION:
 			{
 				termination->media_engine = engine;
 				termination->event_handler = mpf_engine_event_raise;
 				termination->codec_manager = engine->codec_manager;
-				termination->timer_queue = engine->timer_queue;
+				termination->timer_queue = worker->timer_queue;
+				termination->tx_batch = worker->tx_batch;
+				termination->uring = worker->uring;
+				termination->jb_slab = worker->jb_slab;
+				termination->rtcp_agent = engine->rtcp_agent;
+				termination->worker_id = worker->id;
+				termination->overload_level = &worker->overload_level;
 
 				mpf_termination_add(termination,mpf_request->descriptor);
 				if(mpf_context_termination_add(context,termination) == FALSE) {
@@ -374,7 +663,8 @@ static apt_bool_t mpf_engine_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 			}
 			case MPF_APPLY_TOPOLOGY:
 			{
-				mpf_context_topology_apply(context);
+				/* topology is applied once per tick after all the pending requests are processed */
+				mpf_context_topology_invalidate(context);
 				break;
 			}
 			case MPF_DESTROY_TOPOLOGY:
@@ -387,40 +677,251 @@ static apt_bool_t mpf_engine_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 				mpf_response->status_code = MPF_STATUS_CODE_FAILURE;
 			}
 		}
+		if(worker->guard) {
+			apr_thread_mutex_unlock(worker->guard);
+		}
 	}
 
-	return apt_task_msg_parent_signal(engine->task,response_msg);
+	/* response is sent once the deferred topology changes are applied */
+	APR_ARRAY_PUSH(engine->pending_responses,apt_task_msg_t*) = response_msg;
+	return TRUE;
+}
+
+static void mpf_engine_pending_process(mpf_engine_t *engine)
+{
+	apr_size_t i;
+	int j;
+	mpf_engine_worker_t *worker;
+	if(!engine->pending_responses->nelts) {
+		return;
+	}
+
+	/* apply topology of the contexts modified by the processed requests */
+	for(i=0; i<engine->worker_count; i++) {
+		worker = &engine->workers[i];
+		if(worker->guard) {
+			apr_thread_mutex_lock(worker->guard);
+		}
+		mpf_context_factory_topology_apply(worker->context_factory);
+		if(worker->guard) {
+			apr_thread_mutex_unlock(worker->guard);
+		}
+	}
+
+	for(j=0; j<engine->pending_responses->nelts; j++) {
+		apt_task_msg_parent_signal(engine->task,APR_ARRAY_IDX(engine->pending_responses,j,apt_task_msg_t*));
+	}
+	apr_array_clear(engine->pending_responses);
+}
+
+static const char* mpf_overload_level_str(mpf_overload_level_e level)
+{
+	switch(level) {
+		case MPF_OVERLOAD_ELEVATED: return "elevated";
+		case MPF_OVERLOAD_SEVERE: return "severe";
+		default: break;
+	}
+	return "none";
+}
+
+/** Evaluate the overload level of worker by the tick just processed */
+static void mpf_engine_overload_evaluate(mpf_engine_worker_t *worker, apr_uint32_t interval, apr_size_t deferred)
+{
+	mpf_engine_tick_stat_t *stat = &worker->tick_stat;
+	apr_uint32_t deadline = interval * (apr_uint32_t)worker->engine->tick_deadline / 100;
+	apr_uint32_t avg_time = apr_atomic_read32(&stat->avg_time);
+	mpf_overload_level_e level = MPF_OVERLOAD_NONE;
+
+	if(deferred) {
+		apr_atomic_inc32(&stat->deferral_count);
+		worker->deferral_ticks++;
+	}
+	else {
+		worker->deferral_ticks = 0;
+	}
+
+	if(worker->deferral_ticks >= MPF_OVERLOAD_SEVERE_TICKS || avg_time >= interval) {
+		level = MPF_OVERLOAD_SEVERE;
+	}
+	else if(worker->deferral_ticks || avg_time >= deadline) {
+		level = MPF_OVERLOAD_ELEVATED;
+	}
+
+	/* the level rises at once and falls one step at a time, once the tick keeps recovered */
+	if(level > worker->overload_level) {
+		worker->recovery_ticks = 0;
+	}
+	else if(level < worker->overload_level && ++worker->recovery_ticks >= MPF_OVERLOAD_RECOVERY_TICKS) {
+		worker->recovery_ticks = 0;
+		level = worker->overload_level - 1;
+	}
+	else {
+		if(level == worker->overload_level) {
+			worker->recovery_ticks = 0;
+		}
+		return;
+	}
+
+	apt_log(APT_LOG_MARK,level > worker->overload_level ? APT_PRIO_WARNING : APT_PRIO_NOTICE,
+		"Media Overload [%s] worker [%"APR_SIZE_T_FMT"] level [%s] -> [%s] avg time [%u usec]",
+		mpf_engine_id_get(worker->engine),
+		worker->id,
+		mpf_overload_level_str(worker->overload_level),
+		mpf_overload_level_str(level),
+		avg_time);
+	worker->overload_level = level;
+	apr_atomic_set32(&stat->overload_level,(apr_uint32_t)level);
+}
+
+static void mpf_engine_tick_account(mpf_engine_worker_t *worker, apr_time_t start_time, apr_size_t deferred)
+{
+	apr_time_t now = apr_time_now();
+	apr_uint32_t elapsed = (apr_uint32_t)(now - start_time);
+	apr_uint32_t interval = CODEC_FRAME_TIME_BASE * 1000 / (apr_uint32_t)worker->engine->scheduler_rate;
+	mpf_engine_tick_stat_t *stat = &worker->tick_stat;
+	apr_uint32_t avg_time;
+	apr_size_t bucket = 0;
+
+	APT_PROBE2(mpf_tick_end,worker->id,elapsed);
+	/* the statistics is updated by the worker thread only and can be read from any thread */
+	while(bucket < MPF_TICK_HISTOGRAM_SIZE - 1 && elapsed >= ((apr_uint32_t)64 << bucket)) {
+		bucket++;
+	}
+	apr_atomic_inc32(&stat->histogram[bucket]);
+	apr_atomic_inc32(&stat->tick_count);
+	if(elapsed > apr_atomic_read32(&stat->max_time)) {
+		apr_atomic_set32(&stat->max_time,elapsed);
+	}
+	/* exponentially weighted moving average with the weight of 1/16 */
+	avg_time = apr_atomic_read32(&stat->avg_time);
+	apr_atomic_set32(&stat->avg_time,avg_time - (avg_time >> 4) + (elapsed >> 4));
+
+	if(elapsed > interval) {
+		apr_uint32_t overrun_count = apr_atomic_inc32(&stat->overrun_count) + 1;
+		if(now - worker->overrun_report_time >= MPF_OVERRUN_REPORT_INTERVAL) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Media Tick Overrun [%s] worker [%"APR_SIZE_T_FMT"] "
+				"time [%u usec] overruns since last report [%u]",
+				mpf_engine_id_get(worker->engine),
+				worker->id,
+				elapsed,
+				overrun_count - worker->overrun_report_count);
+			worker->overrun_report_time = now;
+			worker->overrun_report_count = overrun_count;
+		}
+	}
+
+	if(worker->engine->tick_deadline) {
+		mpf_engine_overload_evaluate(worker,interval,deferred);
+	}
+}
+
+/** Process the contexts of worker within the deadline of the tick, if set */
+static APR_INLINE apr_size_t mpf_engine_contexts_process(mpf_engine_worker_t *worker, apr_time_t start_time)
+{
+	mpf_engine_t *engine = worker->engine;
+	apr_time_t interval;
+	if(!engine->tick_deadline) {
+		mpf_context_factory_process(worker->context_factory);
+		return 0;
+	}
+	interval = CODEC_FRAME_TIME_BASE * 1000 / engine->scheduler_rate;
+	return mpf_context_factory_deadline_process(worker->context_factory,
+		start_time + interval * (apr_time_t)engine->tick_deadline / 100);
+}
+
+static void mpf_engine_context_stat_take(mpf_engine_worker_t *worker)
+{
+	apr_time_t now;
+	if(!worker->context_top) {
+		return;
+	}
+	now = apr_time_now();
+	if(now - worker->context_stat_time < MPF_CONTEXT_STAT_INTERVAL) {
+		return;
+	}
+	worker->context_stat_time = now;
+
+	/* the contexts are walked by the worker, readers only copy the snapshot */
+	apr_thread_mutex_lock(worker->stat_guard);
+	worker->context_top_count = mpf_context_factory_top_get(
+		worker->context_factory,worker->context_top,MPF_ENGINE_CONTEXT_TOP_SIZE);
+	worker->context_group_count = mpf_context_factory_group_stat_get(
+		worker->context_factory,worker->context_groups,MPF_CONTEXT_MAX_GROUP_COUNT);
+	apr_thread_mutex_unlock(worker->stat_guard);
 }
 
 static void mpf_engine_main(mpf_scheduler_t *scheduler, void *obj)
 {
-	mpf_engine_t *engine = obj;
-	apt_task_msg_t *msg;
+	mpf_engine_worker_t *worker = obj;
+	mpf_engine_t *engine = worker->engine;
+	void *msgs[MPF_REQUEST_BATCH_SIZE];
+	apr_size_t count;
+	apr_size_t i;
+	apr_size_t deferred;
+	apr_time_t start_time = apr_time_now();
+
+	APT_PROBE1(mpf_tick_start,worker->id);
+	/* process request queue in batches */
+	do {
+		count = apt_mpsc_queue_drain(engine->request_queue,msgs,MPF_REQUEST_BATCH_SIZE);
+		for(i=0; i<count; i++) {
+			apt_task_msg_process(engine->task,msgs[i]);
+		}
+	}
+	while(count == MPF_REQUEST_BATCH_SIZE);
+
+	/* apply deferred topology changes and send responses */
+	mpf_engine_pending_process(engine);
 
-	/* process request queue */
-	apr_thread_mutex_lock(engine->request_queue_guard);
-	msg = apt_cyclic_queue_pop(engine->request_queue);
-	while(msg) {
-		apr_thread_mutex_unlock(engine->request_queue_guard);
-		apt_task_msg_process(engine->task,msg);
-		apr_thread_mutex_lock(engine->request_queue_guard);
-		msg = apt_cyclic_queue_pop(engine->request_queue);
+	/* dispatch datagrams received through io_uring */
+	if(worker->uring) {
+		mpf_uring_process(worker->uring);
 	}
-	apr_thread_mutex_unlock(engine->request_queue_guard);
 
 	/* process factory of media contexts */
-	mpf_context_factory_process(engine->context_factory);
+	deferred = mpf_engine_contexts_process(worker,start_time);
+	/* send datagrams produced during the tick */
+	mpf_tx_batch_flush(worker->tx_batch);
+	mpf_engine_context_stat_take(worker);
+
+	mpf_engine_tick_account(worker,start_time,deferred);
+}
+
+static void mpf_engine_worker_main(mpf_scheduler_t *scheduler, void *obj)
+{
+	mpf_engine_worker_t *worker = obj;
+	apr_size_t deferred;
+	apr_time_t start_time = apr_time_now();
+
+	APT_PROBE1(mpf_tick_start,worker->id);
+	/* process the shard of media contexts assigned to the worker */
+	apr_thread_mutex_lock(worker->guard);
+	if(worker->uring) {
+		mpf_uring_process(worker->uring);
+	}
+	deferred = mpf_engine_contexts_process(worker,start_time);
+	mpf_tx_batch_flush(worker->tx_batch);
+	mpf_engine_context_stat_take(worker);
+	apr_thread_mutex_unlock(worker->guard);
+
+	mpf_engine_tick_account(worker,start_time,deferred);
 }
 
 static void mpf_engine_timer_proc(mpf_scheduler_t *scheduler, void *obj)
 {
-	mpf_engine_t *engine = obj;
-	apt_timer_queue_advance(engine->timer_queue,MPF_TIMER_RESOLUTION);
+	mpf_engine_worker_t *worker = obj;
+	if(worker->guard) {
+		apr_thread_mutex_lock(worker->guard);
+	}
+	apt_timer_queue_advance(worker->timer_queue,MPF_TIMER_RESOLUTION);
+	if(worker->guard) {
+		apr_thread_mutex_unlock(worker->guard);
+	}
 }
 
 MPF_DECLARE(mpf_codec_manager_t*) mpf_engine_codec_manager_create(apr_pool_t *pool)
 {
-	mpf_codec_manager_t *codec_manager = mpf_codec_manager_create(4,pool);
+	mpf_codec_manager_t *codec_manager = mpf_codec_manager_create(6,pool);
 	if(codec_manager) {
 		mpf_codec_t *codec;
 
@@ -432,6 +933,13 @@ MPF_DECLARE(mpf_codec_manager_t*) mpf_engine_codec_manager_create(apr_pool_t *po
 
 		codec = mpf_codec_l16_create(pool);
 		mpf_codec_manager_codec_register(codec_manager,codec);
+
+		codec = mpf_codec_g722_create(pool);
+		mpf_codec_manager_codec_register(codec_manager,codec);
+
+		/* not available unless built with libopus */
+		codec = mpf_codec_opus_create(pool);
+		mpf_codec_manager_codec_register(codec_manager,codec);
 	}
 	return codec_manager;
 }
@@ -444,7 +952,401 @@ MPF_DECLARE(apt_bool_t) mpf_engine_codec_manager_register(mpf_engine_t *engine,
 
 MPF_DECLARE(apt_bool_t) mpf_engine_scheduler_rate_set(mpf_engine_t *engine, unsigned long rate)
 {
-	return mpf_scheduler_rate_set(engine->scheduler,rate);
+	apr_size_t i;
+	if(rate == 0 || rate > 10) {
+		/* the same limits as the scheduler applies */
+		rate = 1;
+	}
+	engine->scheduler_rate = rate;
+	for(i=0; i<engine->worker_count; i++) {
+		mpf_scheduler_rate_set(engine->workers[i].scheduler,rate);
+	}
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_scheduler_clock_set(mpf_engine_t *engine, mpf_scheduler_clock_e clock)
+{
+	if(mpf_scheduler_clock_source_set(engine->workers[0].scheduler,clock) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unsupported Scheduler Clock [%d] [%s]",clock,mpf_engine_id_get(engine));
+		return FALSE;
+	}
+	engine->scheduler_clock = clock;
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_scheduler_priority_set(mpf_engine_t *engine, int priority)
+{
+	if(priority < 0) {
+		return FALSE;
+	}
+	engine->scheduler_priority = priority;
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_scheduler_affinity_set(mpf_engine_t *engine, int cpu)
+{
+	engine->scheduler_cpu = cpu;
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_scheduler_cpu_set_set(mpf_engine_t *engine, const apt_cpu_set_t *cpu_set)
+{
+	if(!cpu_set) {
+		engine->scheduler_cpu_set = NULL;
+		return TRUE;
+	}
+	if(!engine->scheduler_cpu_set) {
+		engine->scheduler_cpu_set = apr_palloc(engine->pool,sizeof(apt_cpu_set_t));
+	}
+	*engine->scheduler_cpu_set = *cpu_set;
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_context_layout_set(mpf_engine_t *engine, mpf_context_layout_e layout)
+{
+	apr_size_t i;
+	engine->context_layout = layout;
+	for(i=0; i<engine->worker_count; i++) {
+		mpf_context_factory_layout_set(engine->workers[i].context_factory,layout);
+	}
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_io_uring_set(mpf_engine_t *engine, apt_bool_t enable)
+{
+	apr_size_t i;
+	mpf_engine_worker_t *worker;
+	if(enable == TRUE && mpf_uring_is_available() == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"io_uring Is Not Available, Use Default Socket I/O [%s]",
+			mpf_engine_id_get(engine));
+		return FALSE;
+	}
+
+	engine->io_uring = enable;
+	for(i=0; i<engine->worker_count; i++) {
+		worker = &engine->workers[i];
+		if(enable == TRUE && !worker->uring) {
+			/* falls back to the default path if the ring cannot be set up */
+			worker->uring = mpf_uring_create(MPF_URING_DEFAULT_DEPTH,engine->pool);
+		}
+		else if(enable == FALSE && worker->uring) {
+			mpf_uring_destroy(worker->uring);
+			worker->uring = NULL;
+		}
+		mpf_tx_batch_uring_set(worker->tx_batch,worker->uring);
+	}
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_rtcp_offload_set(mpf_engine_t *engine, apt_bool_t enable)
+{
+	if(enable == TRUE && !engine->rtcp_agent) {
+		engine->rtcp_agent = mpf_rtcp_agent_create(engine->pool);
+		if(!engine->rtcp_agent) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create RTCP Agent, Process RTCP on Media Tick [%s]",
+				mpf_engine_id_get(engine));
+			return FALSE;
+		}
+	}
+	else if(enable == FALSE && engine->rtcp_agent) {
+		mpf_rtcp_agent_destroy(engine->rtcp_agent);
+		engine->rtcp_agent = NULL;
+	}
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_cpu_accounting_set(mpf_engine_t *engine, apt_bool_t enable)
+{
+	apr_size_t i;
+	engine->cpu_accounting = enable;
+	for(i=0; i<engine->worker_count; i++) {
+		mpf_engine_worker_accounting_set(engine,&engine->workers[i],enable);
+	}
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_tick_deadline_set(mpf_engine_t *engine, apr_size_t percent)
+{
+	if(percent > 100) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Tick Deadline [%"APR_SIZE_T_FMT"%%]",percent);
+		return FALSE;
+	}
+	engine->tick_deadline = percent;
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_huge_pages_set(mpf_engine_t *engine, apr_size_t size)
+{
+	apr_size_t i;
+	mpf_engine_worker_t *worker;
+	apt_bool_t status = TRUE;
+	engine->region_size = size;
+	if(!size) {
+		return TRUE;
+	}
+
+	for(i=0; i<engine->worker_count; i++) {
+		worker = &engine->workers[i];
+		if(worker->region) {
+			continue;
+		}
+		worker->region = apt_huge_region_create(size,engine->pool);
+		if(!worker->region) {
+			/* the frames are allocated from normal pages of the pool */
+			status = FALSE;
+			continue;
+		}
+		if(apt_huge_region_backing_get(worker->region) == APT_HUGE_REGION_NORMAL) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Huge Pages Are Not Available, Use Normal Pages [%s]",
+				mpf_engine_id_get(engine));
+		}
+		if(worker->jb_slab) {
+			mpf_jb_slab_region_set(worker->jb_slab,worker->region);
+		}
+	}
+	return status;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_tick_stat_get(const mpf_engine_t *engine, mpf_engine_tick_stat_t *stat)
+{
+	apr_size_t i,j;
+	apr_uint32_t max_time;
+	mpf_engine_tick_stat_t *worker_stat;
+	if(!stat) {
+		return FALSE;
+	}
+
+	memset(stat,0,sizeof(mpf_engine_tick_stat_t));
+	for(i=0; i<engine->worker_count; i++) {
+		worker_stat = &engine->workers[i].tick_stat;
+		stat->tick_count += apr_atomic_read32(&worker_stat->tick_count);
+		stat->overrun_count += apr_atomic_read32(&worker_stat->overrun_count);
+		stat->deferral_count += apr_atomic_read32(&worker_stat->deferral_count);
+		if(apr_atomic_read32(&worker_stat->overload_level) > stat->overload_level) {
+			stat->overload_level = apr_atomic_read32(&worker_stat->overload_level);
+		}
+		max_time = apr_atomic_read32(&worker_stat->max_time);
+		if(max_time > stat->max_time) {
+			stat->max_time = max_time;
+		}
+		max_time = apr_atomic_read32(&worker_stat->avg_time);
+		if(max_time > stat->avg_time) {
+			stat->avg_time = max_time;
+		}
+		for(j=0; j<MPF_TICK_HISTOGRAM_SIZE; j++) {
+			stat->histogram[j] += apr_atomic_read32(&worker_stat->histogram[j]);
+		}
+	}
+	return TRUE;
+}
+
+MPF_DECLARE(apr_size_t) mpf_engine_context_count_get(const mpf_engine_t *engine)
+{
+	apr_size_t i;
+	apr_size_t count = 0;
+	for(i=0; i<engine->worker_count; i++) {
+		count += mpf_context_factory_context_count_get(engine->workers[i].context_factory);
+	}
+	return count;
+}
+
+MPF_DECLARE(apr_uint32_t) mpf_engine_load_get(const mpf_engine_t *engine)
+{
+	apr_size_t i;
+	apr_uint32_t avg_time;
+	apr_uint32_t max_time = 0;
+	apr_uint32_t interval = CODEC_FRAME_TIME_BASE * 1000 / (apr_uint32_t)engine->scheduler_rate;
+	for(i=0; i<engine->worker_count; i++) {
+		avg_time = apr_atomic_read32((volatile apr_uint32_t*)&engine->workers[i].tick_stat.avg_time);
+		if(avg_time > max_time) {
+			max_time = avg_time;
+		}
+	}
+	return max_time * 100 / interval;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_rtp_stat_register(mpf_engine_t *engine, apr_size_t worker_id, void *obj, mpf_rtp_stat_handler_f handler)
+{
+	mpf_engine_worker_t *worker;
+	mpf_engine_rtp_stat_entry_t *entry;
+	if(worker_id >= engine->worker_count || !obj || !handler) {
+		return FALSE;
+	}
+
+	worker = &engine->workers[worker_id];
+	apr_thread_mutex_lock(worker->stat_guard);
+	entry = apr_hash_get(worker->rtp_stats,&obj,sizeof(void*));
+	if(!entry) {
+		entry = worker->rtp_stat_free;
+		if(entry) {
+			worker->rtp_stat_free = entry->next;
+		}
+		else {
+			entry = apr_palloc(engine->pool,sizeof(mpf_engine_rtp_stat_entry_t));
+		}
+		entry->obj = obj;
+		entry->next = NULL;
+		apr_hash_set(worker->rtp_stats,&entry->obj,sizeof(void*),entry);
+	}
+	entry->handler = handler;
+	apr_thread_mutex_unlock(worker->stat_guard);
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_rtp_stat_unregister(mpf_engine_t *engine, apr_size_t worker_id, void *obj)
+{
+	mpf_engine_worker_t *worker;
+	mpf_engine_rtp_stat_entry_t *entry;
+	if(worker_id >= engine->worker_count) {
+		return FALSE;
+	}
+
+	worker = &engine->workers[worker_id];
+	apr_thread_mutex_lock(worker->stat_guard);
+	entry = apr_hash_get(worker->rtp_stats,&obj,sizeof(void*));
+	if(entry) {
+		apr_hash_set(worker->rtp_stats,&entry->obj,sizeof(void*),NULL);
+		entry->obj = NULL;
+		entry->next = worker->rtp_stat_free;
+		worker->rtp_stat_free = entry;
+	}
+	apr_thread_mutex_unlock(worker->stat_guard);
+	return entry ? TRUE : FALSE;
+}
+
+MPF_DECLARE(apr_size_t) mpf_engine_rtp_stat_get(const mpf_engine_t *engine, mpf_rtp_stream_stat_t *stats, apr_size_t max_count, mpf_rtp_engine_stat_t *total)
+{
+	apr_size_t i;
+	apr_size_t count = 0;
+	apr_hash_index_t *it;
+	void *val;
+	mpf_engine_worker_t *worker;
+	mpf_engine_rtp_stat_entry_t *entry;
+	mpf_rtp_stream_stat_t snapshot;
+	mpf_rtp_stream_stat_t *stat;
+	apr_uint64_t jitter_sum = 0;
+	apr_uint64_t playout_delay_sum = 0;
+
+	if(total) {
+		memset(total,0,sizeof(mpf_rtp_engine_stat_t));
+	}
+	if(!stats) {
+		max_count = 0;
+	}
+	if(!total && !max_count) {
+		return 0;
+	}
+
+	for(i=0; i<engine->worker_count; i++) {
+		worker = &engine->workers[i];
+		apr_thread_mutex_lock(worker->stat_guard);
+		for(it = apr_hash_first(NULL,worker->rtp_stats); it; it = apr_hash_next(it)) {
+			apr_hash_this(it,NULL,NULL,&val);
+			entry = val;
+			stat = (count < max_count) ? &stats[count++] : &snapshot;
+			memset(stat,0,sizeof(mpf_rtp_stream_stat_t));
+			entry->handler(entry->obj,stat);
+			if(!total) {
+				if(count >= max_count) {
+					break;
+				}
+				continue;
+			}
+
+			total->stream_count++;
+			total->received_packets += stat->rx_stat.received_packets;
+			total->lost_packets += stat->rx_stat.lost_packets;
+			total->discarded_packets += stat->rx_stat.discarded_packets;
+			total->invalid_packets += stat->rx_stat.invalid_packets;
+			total->sent_packets += stat->sent_packets;
+			if(stat->jitter > total->max_jitter) {
+				total->max_jitter = stat->jitter;
+			}
+			if(stat->playout_delay > total->max_playout_delay) {
+				total->max_playout_delay = stat->playout_delay;
+			}
+			jitter_sum += stat->jitter;
+			playout_delay_sum += stat->playout_delay;
+		}
+		apr_thread_mutex_unlock(worker->stat_guard);
+		if(!total && count >= max_count) {
+			break;
+		}
+	}
+
+	if(total && total->stream_count) {
+		total->avg_jitter = (apr_uint32_t)(jitter_sum / total->stream_count);
+		total->avg_playout_delay = (apr_uint32_t)(playout_delay_sum / total->stream_count);
+	}
+	return count;
+}
+
+MPF_DECLARE(apr_size_t) mpf_engine_context_top_get(const mpf_engine_t *engine, mpf_context_stat_t *stats, apr_size_t max_count)
+{
+	apr_size_t i;
+	apr_size_t j;
+	apr_size_t k;
+	apr_size_t count = 0;
+	mpf_engine_worker_t *worker;
+	const mpf_context_stat_t *stat;
+	if(!stats || !max_count) {
+		return 0;
+	}
+
+	for(i=0; i<engine->worker_count; i++) {
+		worker = &engine->workers[i];
+		apr_thread_mutex_lock(worker->stat_guard);
+		for(j=0; j<worker->context_top_count; j++) {
+			stat = &worker->context_top[j];
+			/* merge into the array ordered by smoothed processing time */
+			k = count;
+			while(k > 0 && stats[k-1].avg_time < stat->avg_time) {
+				k--;
+			}
+			if(k >= max_count) {
+				/* the rest of the snapshot of the worker is even less expensive */
+				break;
+			}
+			if(count < max_count) {
+				count++;
+			}
+			memmove(&stats[k+1],&stats[k],(count - k - 1) * sizeof(mpf_context_stat_t));
+			stats[k] = *stat;
+		}
+		apr_thread_mutex_unlock(worker->stat_guard);
+	}
+	return count;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_context_group_stat_get(const mpf_engine_t *engine, const char *group, mpf_context_group_stat_t *stat)
+{
+	apr_size_t i;
+	apr_size_t j;
+	mpf_engine_worker_t *worker;
+	const mpf_context_group_stat_t *group_stat;
+	apt_bool_t status = FALSE;
+	if(!group || !stat) {
+		return FALSE;
+	}
+
+	memset(stat,0,sizeof(mpf_context_group_stat_t));
+	apr_cpystrn(stat->name,group,sizeof(stat->name));
+	for(i=0; i<engine->worker_count; i++) {
+		worker = &engine->workers[i];
+		apr_thread_mutex_lock(worker->stat_guard);
+		for(j=0; j<worker->context_group_count; j++) {
+			group_stat = &worker->context_groups[j];
+			if(strcmp(group_stat->name,stat->name) == 0) {
+				stat->context_count += group_stat->context_count;
+				stat->avg_time += group_stat->avg_time;
+				stat->total_time += group_stat->total_time;
+				status = TRUE;
+				break;
+			}
+		}
+		apr_thread_mutex_unlock(worker->stat_guard);
+	}
+	return status;
 }
 
 MPF_DECLARE(const char*) mpf_engine_id_get(const mpf_engine_t *engine)
@@ -17,15 +17,19 @@
  */
 
 #include <apr_tables.h>
+#include <apr_atomic.h>
 #include "mpf_engine_factory.h"
 #include "mpf_termination_factory.h"
+#include "mpf_engine.h"
 
 /** Factory of media engines */
 struct mpf_engine_factory_t {
 	/** Array of pointers to media engines */
 	apr_array_header_t   *engines_arr;
-	/** Index of the current engine */
-	int                   index;
+	/** Index of the current engine (atomic, may grow beyond the number of engines) */
+	volatile apr_uint32_t index;
+	/** Policy of engine selection */
+	mpf_engine_select_policy_e policy;
 };
 
 /** Create factory of media engines. */
@@ -34,6 +38,7 @@ MPF_DECLARE(mpf_engine_factory_t*) mpf_engine_factory_create(apr_pool_t *pool)
 	mpf_engine_factory_t *mpf_factory = apr_palloc(pool,sizeof(mpf_engine_factory_t));
 	mpf_factory->engines_arr = apr_array_make(pool,1,sizeof(mpf_engine_t*));
 	mpf_factory->index = 0;
+	mpf_factory->policy = MPF_ENGINE_SELECT_ROUND_ROBIN;
 	return mpf_factory;
 }
 
@@ -55,14 +60,72 @@ MPF_DECLARE(apt_bool_t) mpf_engine_factory_is_empty(const mpf_engine_factory_t *
 	return apr_is_empty_array(mpf_factory->engines_arr);
 }
 
-/** Select next available media engine. */
+/** Set policy of media engine selection. */
+MPF_DECLARE(void) mpf_engine_factory_policy_set(mpf_engine_factory_t *mpf_factory, mpf_engine_select_policy_e policy)
+{
+	mpf_factory->policy = policy;
+}
+
+/** Get the number of media engines in factory. */
+MPF_DECLARE(apr_size_t) mpf_engine_factory_engine_count_get(const mpf_engine_factory_t *mpf_factory)
+{
+	return mpf_factory->engines_arr->nelts;
+}
+
+static mpf_engine_t* mpf_engine_factory_least_loaded_select(mpf_engine_factory_t *mpf_factory)
+{
+	int i;
+	apr_uint32_t index;
+	mpf_engine_t *media_engine;
+	mpf_engine_t *selected = NULL;
+	mpf_engine_t *least_busy = NULL;
+	apr_size_t context_count;
+	apr_size_t min_context_count = 0;
+	apr_uint32_t load;
+	apr_uint32_t selected_load = 0;
+	apr_uint32_t min_load = 0;
+
+	/* start from the next engine in turn, so that ties are resolved in round-robin fashion */
+	index = apr_atomic_inc32(&mpf_factory->index);
+	for(i=0; i<mpf_factory->engines_arr->nelts; i++) {
+		media_engine = APR_ARRAY_IDX(mpf_factory->engines_arr, 
+						(index + i) % mpf_factory->engines_arr->nelts, mpf_engine_t*);
+		load = mpf_engine_load_get(media_engine);
+		if(!least_busy || load < min_load) {
+			least_busy = media_engine;
+			min_load = load;
+		}
+		if(load >= MPF_ENGINE_OVERLOAD_THRESHOLD) {
+			continue;
+		}
+
+		context_count = mpf_engine_context_count_get(media_engine);
+		if(!selected || context_count < min_context_count ||
+			(context_count == min_context_count && load < selected_load)) {
+			selected = media_engine;
+			min_context_count = context_count;
+			selected_load = load;
+		}
+	}
+
+	/* if all the engines are overloaded, fall back to the least busy one */
+	return selected ? selected : least_busy;
+}
+
+/** Select next available media engine according to the policy. */
 MPF_DECLARE(mpf_engine_t*) mpf_engine_factory_engine_select(mpf_engine_factory_t *mpf_factory)
 {
-	mpf_engine_t *media_engine = APR_ARRAY_IDX(mpf_factory->engines_arr, mpf_factory->index, mpf_engine_t*);
-	if(++mpf_factory->index == mpf_factory->engines_arr->nelts) {
-		mpf_factory->index = 0;
+	apr_uint32_t index;
+	if(apr_is_empty_array(mpf_factory->engines_arr)) {
+		return NULL;
 	}
-	return media_engine;
+	if(mpf_factory->policy == MPF_ENGINE_SELECT_LEAST_LOADED) {
+		return mpf_engine_factory_least_loaded_select(mpf_factory);
+	}
+
+	/* the selection may be requested by several server workers at once */
+	index = apr_atomic_inc32(&mpf_factory->index);
+	return APR_ARRAY_IDX(mpf_factory->engines_arr, index % mpf_factory->engines_arr->nelts, mpf_engine_t*);
 }
 
 /** Associate media engines with RTP termination factory. */
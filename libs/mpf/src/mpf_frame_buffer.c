@@ -16,23 +16,39 @@
  * $Id$
  */
 
+#include <apr_atomic.h>
 #include "mpf_frame_buffer.h"
+#ifdef MPF_FRAME_BUFFER_DEBUG
+#include "apt_file_writer.h"
+#endif
 
 struct mpf_frame_buffer_t {
 	apr_byte_t         *raw_data;
 	mpf_frame_t        *frames;
-	apr_size_t          frame_count;
+	apr_uint32_t        frame_count;
 	apr_size_t          frame_size;
 
-	apr_size_t          write_pos;
-	apr_size_t          read_pos;
+	/** Separate producer and consumer positions to avoid false sharing */
+	char                pad1[64];
+	/** Number of written frames (advanced by producer) */
+	volatile apr_uint32_t write_pos;
+	/** Number of frames dropped, as the buffer was full */
+	volatile apr_uint32_t overruns;
+	char                pad2[64];
+	/** Number of read frames (advanced by consumer) */
+	volatile apr_uint32_t read_pos;
+	/** Number of reads, the buffer was empty at */
+	volatile apr_uint32_t underruns;
+	/** Set by restart, applied by consumer */
+	volatile apr_uint32_t restart;
+	/** Write position to skip to on restart */
+	volatile apr_uint32_t restart_pos;
 
-	apr_thread_mutex_t *guard;
 	apr_pool_t         *pool;
 
 #ifdef MPF_FRAME_BUFFER_DEBUG
-	FILE               *utt_in;
-	FILE               *utt_out;
+	apt_file_writer_t  *utt_in;
+	apt_file_writer_t  *utt_out;
 #endif
 };
 
@@ -44,8 +60,11 @@ mpf_frame_buffer_t* mpf_frame_buffer_create(apr_size_t frame_size, apr_size_t fr
 	mpf_frame_buffer_t *buffer = apr_palloc(pool,sizeof(mpf_frame_buffer_t));
 	buffer->pool = pool;
 
+	if(!frame_count) {
+		frame_count = 1;
+	}
 	buffer->frame_size = frame_size;
-	buffer->frame_count = frame_count;
+	buffer->frame_count = (apr_uint32_t)frame_count;
 	buffer->raw_data = apr_palloc(pool,buffer->frame_size*buffer->frame_count);
 	buffer->frames = apr_palloc(pool,sizeof(mpf_frame_t)*buffer->frame_count);
 	for(i=0; i<buffer->frame_count; i++) {
@@ -56,7 +75,8 @@ mpf_frame_buffer_t* mpf_frame_buffer_create(apr_size_t frame_size, apr_size_t fr
 	}
 
 	buffer->write_pos = buffer->read_pos = 0;
-	apr_thread_mutex_create(&buffer->guard,APR_THREAD_MUTEX_UNNESTED,pool);
+	buffer->overruns = buffer->underruns = 0;
+	buffer->restart = buffer->restart_pos = 0;
 
 #ifdef MPF_FRAME_BUFFER_DEBUG
 	buffer->utt_in = NULL;
@@ -70,48 +90,57 @@ static apr_status_t mpf_frame_buffer_file_close(void *obj)
 {
 	mpf_frame_buffer_t *buffer = obj;
 	if(buffer->utt_out) {
-		fclose(buffer->utt_out);
+		apt_file_writer_destroy(buffer->utt_out);
 		buffer->utt_out = NULL;
 	}
 	if(buffer->utt_in) {
-		fclose(buffer->utt_in);
+		apt_file_writer_destroy(buffer->utt_in);
 		buffer->utt_in = NULL;
 	}
 	return APR_SUCCESS;
 }
 
-apt_bool_t mpf_frame_buffer_file_open(mpf_frame_buffer_t *buffer, const char *utt_file_in, const char *utt_file_out)
+apt_bool_t mpf_frame_buffer_file_open(mpf_frame_buffer_t *buffer, const char *utt_file_in, const char *utt_file_out, apt_executor_t *executor)
 {
-	buffer->utt_in = fopen(utt_file_in,"wb");
-	if(!buffer->utt_in)
+	/* dumps are written by the executor, if any, not to stall the media thread */
+	buffer->utt_in = apt_file_writer_create(executor,0,0,FALSE,buffer->pool);
+	buffer->utt_out = apt_file_writer_create(executor,0,0,FALSE,buffer->pool);
+	if(!buffer->utt_in || !buffer->utt_out)
 		return FALSE;
 
-	buffer->utt_out = fopen(utt_file_out,"wb");
-	if(!buffer->utt_out)
+	apr_pool_cleanup_register(buffer->pool,buffer,mpf_frame_buffer_file_close,NULL);
+	if(apt_file_writer_open(buffer->utt_in,utt_file_in,NULL) == FALSE)
+		return FALSE;
+
+	if(apt_file_writer_open(buffer->utt_out,utt_file_out,NULL) == FALSE)
 		return FALSE;
 
-	apr_pool_cleanup_register(buffer->pool,buffer,mpf_frame_buffer_file_close,NULL);
 	return TRUE;
 }
 #endif
 
+/** Load with full barrier (acquire semantics) */
+static APR_INLINE apr_uint32_t mpf_frame_buffer_load(volatile apr_uint32_t *mem)
+{
+	return apr_atomic_add32(mem,0);
+}
+
 void mpf_frame_buffer_destroy(mpf_frame_buffer_t *buffer)
 {
-	if(buffer->guard) {
-		apr_thread_mutex_destroy(buffer->guard);
-		buffer->guard = NULL;
-	}
+	/* nothing to destroy, the buffer is lock-free */
 }
 
 apt_bool_t mpf_frame_buffer_restart(mpf_frame_buffer_t *buffer)
 {
-	buffer->write_pos = buffer->read_pos;
+	/* the frames written so far are skipped by the consumer on the next read */
+	apr_atomic_set32(&buffer->restart_pos,mpf_frame_buffer_load(&buffer->write_pos));
+	apr_atomic_set32(&buffer->restart,1);
 	return TRUE;
 }
 
-static APR_INLINE mpf_frame_t* mpf_frame_buffer_frame_get(mpf_frame_buffer_t *buffer, apr_size_t pos)
+static APR_INLINE mpf_frame_t* mpf_frame_buffer_frame_get(mpf_frame_buffer_t *buffer, apr_uint32_t pos)
 {
-	apr_size_t index = pos % buffer->frame_count;
+	apr_uint32_t index = pos % buffer->frame_count;
 	return &buffer->frames[index];
 }
 
@@ -120,16 +149,21 @@ apt_bool_t mpf_frame_buffer_write(mpf_frame_buffer_t *buffer, const mpf_frame_t
 	mpf_frame_t *write_frame;
 	void *data = frame->codec_frame.buffer;
 	apr_size_t size = frame->codec_frame.size;
+	apr_uint32_t write_pos = buffer->write_pos;
 
 #ifdef MPF_FRAME_BUFFER_DEBUG
 	if(buffer->utt_in) {
-		fwrite(data,1,size,buffer->utt_in);
+		apt_file_writer_write(buffer->utt_in,data,size);
 	}
 #endif
 
-	apr_thread_mutex_lock(buffer->guard);
-	while(buffer->write_pos - buffer->read_pos < buffer->frame_count && size >= buffer->frame_size) {
-		write_frame = mpf_frame_buffer_frame_get(buffer,buffer->write_pos);
+	while(size >= buffer->frame_size) {
+		if(write_pos - mpf_frame_buffer_load(&buffer->read_pos) >= buffer->frame_count) {
+			/* the consumer lags behind, never wait for it */
+			apr_atomic_add32(&buffer->overruns,(apr_uint32_t)(size / buffer->frame_size));
+			break;
+		}
+		write_frame = mpf_frame_buffer_frame_get(buffer,write_pos);
 		write_frame->type = frame->type;
 		write_frame->codec_frame.size = buffer->frame_size;
 		memcpy(
@@ -139,20 +173,28 @@ apt_bool_t mpf_frame_buffer_write(mpf_frame_buffer_t *buffer, const mpf_frame_t
 
 		data = (char*)data + buffer->frame_size;
 		size -= buffer->frame_size;
-		buffer->write_pos ++;
+		write_pos ++;
+		/* publish the frame */
+		apr_atomic_set32(&buffer->write_pos,write_pos);
 	}
 
-	apr_thread_mutex_unlock(buffer->guard);
 	/* if size != 0 => non frame alligned or buffer is full */
 	return size == 0 ? TRUE : FALSE;
 }
 
 apt_bool_t mpf_frame_buffer_read(mpf_frame_buffer_t *buffer, mpf_frame_t *media_frame)
 {
-	apr_thread_mutex_lock(buffer->guard);
-	if(buffer->write_pos > buffer->read_pos) {
+	apr_uint32_t read_pos = buffer->read_pos;
+	apr_uint32_t write_pos = mpf_frame_buffer_load(&buffer->write_pos);
+	if(buffer->restart && apr_atomic_xchg32(&buffer->restart,0) == 1) {
+		apr_uint32_t restart_pos = mpf_frame_buffer_load(&buffer->restart_pos);
+		if(restart_pos - read_pos <= write_pos - read_pos) {
+			read_pos = restart_pos;
+		}
+	}
+	if(write_pos != read_pos) {
 		/* normal read */
-		mpf_frame_t *src_media_frame = mpf_frame_buffer_frame_get(buffer,buffer->read_pos);
+		mpf_frame_t *src_media_frame = mpf_frame_buffer_frame_get(buffer,read_pos);
 		media_frame->type = src_media_frame->type;
 		media_frame->marker = src_media_frame->marker;
 		if(media_frame->type & MEDIA_FRAME_TYPE_AUDIO) {
@@ -163,7 +205,7 @@ apt_bool_t mpf_frame_buffer_read(mpf_frame_buffer_t *buffer, mpf_frame_t *media_
 				media_frame->codec_frame.size);
 #ifdef MPF_FRAME_BUFFER_DEBUG
 			if(buffer->utt_out) {
-				fwrite(media_frame->codec_frame.buffer,1,media_frame->codec_frame.size,buffer->utt_out);
+				apt_file_writer_write(buffer->utt_out,media_frame->codec_frame.buffer,media_frame->codec_frame.size);
 			}
 #endif
 		}
@@ -172,13 +214,25 @@ apt_bool_t mpf_frame_buffer_read(mpf_frame_buffer_t *buffer, mpf_frame_t *media_
 		}
 		src_media_frame->type = MEDIA_FRAME_TYPE_NONE;
 		src_media_frame->marker = MPF_MARKER_NONE;
-		buffer->read_pos ++;
+		read_pos ++;
 	}
 	else {
 		/* underflow */
 		media_frame->type = MEDIA_FRAME_TYPE_NONE;
 		media_frame->marker = MPF_MARKER_NONE;
+		apr_atomic_inc32(&buffer->underruns);
 	}
-	apr_thread_mutex_unlock(buffer->guard);
+	/* release the frame to the producer */
+	apr_atomic_set32(&buffer->read_pos,read_pos);
 	return TRUE;
 }
+
+apr_size_t mpf_frame_buffer_overruns_get(mpf_frame_buffer_t *buffer)
+{
+	return apr_atomic_xchg32(&buffer->overruns,0);
+}
+
+apr_size_t mpf_frame_buffer_underruns_get(mpf_frame_buffer_t *buffer)
+{
+	return apr_atomic_xchg32(&buffer->underruns,0);
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include "mpf_frame_features.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MPF_FEATURES_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define MPF_FEATURES_NEON
+#include <arm_neon.h>
+#endif
+
+/** Calculate audio features of linear frame */
+MPF_DECLARE(apt_bool_t) mpf_frame_features_calculate(mpf_frame_features_t *features, const mpf_frame_t *frame)
+{
+	const apr_int16_t *samples = frame->codec_frame.buffer;
+	apr_size_t count = frame->codec_frame.size / sizeof(apr_int16_t);
+	apr_uint64_t magnitude;
+	apr_uint64_t energy;
+	apr_uint32_t peak;
+	apr_size_t crossings = 0;
+	apr_size_t i = 1;
+	apr_int32_t value;
+
+	if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == 0 || !samples || !count) {
+		features->count = 0;
+		features->magnitude = 0;
+		features->energy = 0;
+		features->peak = 0;
+		features->crossings = 0;
+		return FALSE;
+	}
+
+	value = samples[0];
+	peak = value < 0 ? -value : value;
+	magnitude = peak;
+	energy = (apr_uint64_t)(value * value);
+#if defined(MPF_FEATURES_SSE2)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		/* there is no unsigned 16-bit max in SSE2, the values are biased to signed range */
+		const __m128i bias = _mm_set1_epi16((short)0x8000);
+		__m128i acc = _mm_setzero_si128();
+		__m128i mag_acc = _mm_setzero_si128();
+		__m128i peak_acc = bias;
+		__m128i zc_acc = _mm_setzero_si128();
+		apr_uint64_t acc_arr[2];
+		apr_uint32_t mag_arr[4];
+		apr_int32_t zc_arr[4];
+		apr_uint16_t peak_arr[8];
+		int j;
+		for(; i+8<=count; i+=8) {
+			__m128i v = _mm_loadu_si128((const __m128i*)(samples+i));
+			__m128i prev = _mm_loadu_si128((const __m128i*)(samples+i-1));
+			__m128i sign = _mm_srai_epi16(v,15);
+			/* absolute values as unsigned 16 bits, -32768 included */
+			__m128i abs = _mm_sub_epi16(_mm_xor_si128(v,sign),sign);
+			/* pairwise sums of squares fit in unsigned 32 bits */
+			__m128i sq = _mm_madd_epi16(v,v);
+			acc = _mm_add_epi64(acc,_mm_unpacklo_epi32(sq,zero));
+			acc = _mm_add_epi64(acc,_mm_unpackhi_epi32(sq,zero));
+			mag_acc = _mm_add_epi32(mag_acc,_mm_unpacklo_epi16(abs,zero));
+			mag_acc = _mm_add_epi32(mag_acc,_mm_unpackhi_epi16(abs,zero));
+			peak_acc = _mm_max_epi16(peak_acc,_mm_xor_si128(abs,bias));
+			/* -1 where the sign differs from the previous sample */
+			zc_acc = _mm_sub_epi16(zc_acc,_mm_srai_epi16(_mm_xor_si128(v,prev),15));
+		}
+		_mm_storeu_si128((__m128i*)acc_arr,acc);
+		_mm_storeu_si128((__m128i*)mag_arr,mag_acc);
+		_mm_storeu_si128((__m128i*)zc_arr,_mm_madd_epi16(zc_acc,_mm_set1_epi16(1)));
+		_mm_storeu_si128((__m128i*)peak_arr,_mm_xor_si128(peak_acc,bias));
+		energy += acc_arr[0] + acc_arr[1];
+		magnitude += (apr_uint64_t)mag_arr[0] + mag_arr[1] + mag_arr[2] + mag_arr[3];
+		crossings += zc_arr[0] + zc_arr[1] + zc_arr[2] + zc_arr[3];
+		for(j=0; j<8; j++) {
+			if(peak_arr[j] > peak) {
+				peak = peak_arr[j];
+			}
+		}
+	}
+#elif defined(MPF_FEATURES_NEON)
+	{
+		int64x2_t acc = vdupq_n_s64(0);
+		uint32x4_t mag_acc = vdupq_n_u32(0);
+		uint16x8_t peak_acc = vdupq_n_u16(0);
+		uint16x8_t zc_acc = vdupq_n_u16(0);
+		uint32x4_t zc_sum;
+		apr_uint16_t peak_arr[8];
+		int j;
+		for(; i+8<=count; i+=8) {
+			int16x8_t v = vld1q_s16(samples+i);
+			int16x8_t prev = vld1q_s16(samples+i-1);
+			int16x8_t sign = vshrq_n_s16(v,15);
+			/* absolute values as unsigned 16 bits, -32768 included (vabsq saturates) */
+			uint16x8_t abs = vreinterpretq_u16_s16(vsubq_s16(veorq_s16(v,sign),sign));
+			acc = vpadalq_s32(acc,vmull_s16(vget_low_s16(v),vget_low_s16(v)));
+			acc = vpadalq_s32(acc,vmull_s16(vget_high_s16(v),vget_high_s16(v)));
+			mag_acc = vpadalq_u16(mag_acc,abs);
+			peak_acc = vmaxq_u16(peak_acc,abs);
+			zc_acc = vaddq_u16(zc_acc,vshrq_n_u16(vreinterpretq_u16_s16(veorq_s16(v,prev)),15));
+		}
+		zc_sum = vpaddlq_u16(zc_acc);
+		vst1q_u16(peak_arr,peak_acc);
+		energy += vgetq_lane_s64(acc,0) + vgetq_lane_s64(acc,1);
+		magnitude += (apr_uint64_t)vgetq_lane_u32(mag_acc,0) + vgetq_lane_u32(mag_acc,1) + vgetq_lane_u32(mag_acc,2) + vgetq_lane_u32(mag_acc,3);
+		crossings += vgetq_lane_u32(zc_sum,0) + vgetq_lane_u32(zc_sum,1) + vgetq_lane_u32(zc_sum,2) + vgetq_lane_u32(zc_sum,3);
+		for(j=0; j<8; j++) {
+			if(peak_arr[j] > peak) {
+				peak = peak_arr[j];
+			}
+		}
+	}
+#endif
+	for(; i<count; i++) {
+		value = samples[i];
+		energy += (apr_uint64_t)(value * value);
+		if(value < 0) {
+			value = -value;
+		}
+		magnitude += value;
+		if((apr_uint32_t)value > peak) {
+			peak = value;
+		}
+		if((samples[i] ^ samples[i-1]) < 0) {
+			crossings++;
+		}
+	}
+
+	features->count = count;
+	features->magnitude = magnitude;
+	features->energy = energy;
+	features->peak = peak;
+	features->crossings = crossings;
+	return TRUE;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include "mpf_frame_pool.h"
+
+/* size classes are 64 << i bytes */
+#define FRAME_POOL_MIN_SHIFT   6
+#define FRAME_POOL_CLASS_COUNT 11
+
+typedef struct mpf_frame_block_t mpf_frame_block_t;
+
+/** Header preceding the buffer */
+struct mpf_frame_block_t {
+	/** Next free block in the list of the size class */
+	mpf_frame_block_t *next;
+	/** Size class of the block (FRAME_POOL_CLASS_COUNT, if not pooled) */
+	apr_size_t         size_class;
+};
+
+/** Pool of frame buffers */
+struct mpf_frame_pool_t {
+	/** Pool to allocate the blocks from */
+	apr_pool_t        *pool;
+	/** Free lists by size class */
+	mpf_frame_block_t *free_list[FRAME_POOL_CLASS_COUNT];
+	/** Number of blocks allocated */
+	apr_size_t         block_count;
+};
+
+/** Allocate a block, the buffer is aligned and the header is right before it */
+static mpf_frame_block_t* mpf_frame_block_alloc(apr_size_t size, apr_size_t size_class, apr_pool_t *pool)
+{
+	apr_size_t offset = APR_ALIGN(sizeof(mpf_frame_block_t),MPF_FRAME_POOL_ALIGNMENT);
+	apr_byte_t *data = apr_palloc(pool,size + offset + MPF_FRAME_POOL_ALIGNMENT - 1);
+	mpf_frame_block_t *block;
+	data = (apr_byte_t*)APR_ALIGN((apr_uintptr_t)data + offset,MPF_FRAME_POOL_ALIGNMENT);
+	block = (mpf_frame_block_t*)data - 1;
+	block->next = NULL;
+	block->size_class = size_class;
+	return block;
+}
+
+MPF_DECLARE(mpf_frame_pool_t*) mpf_frame_pool_create(apr_pool_t *pool)
+{
+	apr_size_t i;
+	mpf_frame_pool_t *frame_pool = apr_palloc(pool,sizeof(mpf_frame_pool_t));
+	frame_pool->pool = pool;
+	for(i=0; i<FRAME_POOL_CLASS_COUNT; i++) {
+		frame_pool->free_list[i] = NULL;
+	}
+	frame_pool->block_count = 0;
+	return frame_pool;
+}
+
+MPF_DECLARE(void*) mpf_frame_pool_buffer_get(mpf_frame_pool_t *frame_pool, apr_size_t size, apr_pool_t *pool)
+{
+	apr_size_t size_class = 0;
+	mpf_frame_block_t *block;
+	if(!frame_pool) {
+		return apr_palloc(pool,size);
+	}
+
+	while(size_class < FRAME_POOL_CLASS_COUNT && size > ((apr_size_t)1 << (size_class + FRAME_POOL_MIN_SHIFT))) {
+		size_class++;
+	}
+	if(size_class == FRAME_POOL_CLASS_COUNT) {
+		/* too large to be pooled, lives as long as the pool of the caller */
+		block = mpf_frame_block_alloc(size,size_class,pool);
+		return block + 1;
+	}
+
+	block = frame_pool->free_list[size_class];
+	if(block) {
+		frame_pool->free_list[size_class] = block->next;
+	}
+	else {
+		block = mpf_frame_block_alloc((apr_size_t)1 << (size_class + FRAME_POOL_MIN_SHIFT),size_class,frame_pool->pool);
+		frame_pool->block_count++;
+	}
+	block->next = NULL;
+	return block + 1;
+}
+
+MPF_DECLARE(void) mpf_frame_pool_buffer_release(mpf_frame_pool_t *frame_pool, void *buffer)
+{
+	mpf_frame_block_t *block;
+	if(!frame_pool || !buffer) {
+		return;
+	}
+
+	block = (mpf_frame_block_t*)buffer - 1;
+	if(block->size_class >= FRAME_POOL_CLASS_COUNT) {
+		return;
+	}
+	block->next = frame_pool->free_list[block->size_class];
+	frame_pool->free_list[block->size_class] = block;
+}
+
+MPF_DECLARE(apr_size_t) mpf_frame_pool_buffer_count_get(const mpf_frame_pool_t *frame_pool)
+{
+	return frame_pool->block_count;
+}
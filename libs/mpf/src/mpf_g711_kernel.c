@@ -0,0 +1,477 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include "mpf_g711_kernel.h"
+#include "g711/g711.h"
+#include "apt_log.h"
+
+/*
+ * The vector kernels compute the same segment/quantization arithmetic
+ * as linear_to_ulaw() and friends in g711.h, lane by lane, without any
+ * lookup table in memory:
+ *  - the segment is the number of thresholds 0x100<<k the magnitude reaches
+ *    (or 8 - clz on NEON),
+ *  - per-lane variable shifts are done as 16-bit multiplications by a power
+ *    of two picked with an in-register byte shuffle (native on NEON).
+ * The u-law bias is added with signed saturation; a saturated magnitude
+ * encodes to the same clipped code as the out of range branch of the
+ * scalar encoder. The tail of a frame is converted by the scalar routines.
+ */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MPF_G711_X86
+#define MPF_G711_SSE41
+#define MPF_G711_AVX2
+#define MPF_G711_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define MPF_G711_X86
+#if _MSC_VER >= 1500
+#define MPF_G711_SSE41
+#endif
+#if _MSC_VER >= 1700
+#define MPF_G711_AVX2
+#endif
+#define MPF_G711_TARGET(isa)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define MPF_G711_NEON
+#include <arm_neon.h>
+#endif
+
+static void scalar_ulaw_encode(const apr_int16_t *linear, apr_byte_t *code, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i<count; i++) {
+		code[i] = linear_to_ulaw(linear[i]);
+	}
+}
+
+static void scalar_ulaw_decode(const apr_byte_t *code, apr_int16_t *linear, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i<count; i++) {
+		linear[i] = ulaw_to_linear(code[i]);
+	}
+}
+
+static void scalar_alaw_encode(const apr_int16_t *linear, apr_byte_t *code, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i<count; i++) {
+		code[i] = linear_to_alaw(linear[i]);
+	}
+}
+
+static void scalar_alaw_decode(const apr_byte_t *code, apr_int16_t *linear, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i<count; i++) {
+		linear[i] = alaw_to_linear(code[i]);
+	}
+}
+
+static const mpf_g711_kernel_t scalar_kernel = {
+	MPF_G711_KERNEL_SCALAR,
+	"scalar",
+	scalar_ulaw_encode,
+	scalar_ulaw_decode,
+	scalar_alaw_encode,
+	scalar_alaw_decode
+};
+
+#ifdef MPF_G711_SSE41
+/** Power of two multipliers indexed by segment (see sse41_shuffle16) */
+#define G711_ULAW_SHR_FACTORS 0x2000,0x1000,0x0800,0x0400,0x0200,0x0100,0x0080,0x0040
+#define G711_ALAW_SHR_FACTORS 0x1000,0x1000,0x0800,0x0400,0x0200,0x0100,0x0080,0x0040
+#define G711_ULAW_SHL_FACTORS 1,2,4,8,16,32,64,128
+#define G711_ALAW_SHL_FACTORS 1,1,2,4,8,16,32,64
+
+/** Select 16-bit entries of the table by segment (0..7) of each lane */
+MPF_G711_TARGET("sse4.1")
+static APR_INLINE __m128i sse41_shuffle16(__m128i table, __m128i seg)
+{
+	/* byte pair (2*seg, 2*seg+1) addresses the little endian entry */
+	__m128i index = _mm_add_epi16(_mm_mullo_epi16(seg,_mm_set1_epi16(0x0202)),_mm_set1_epi16(0x0100));
+	return _mm_shuffle_epi8(table,index);
+}
+
+/** Segment of biased magnitude (0..0x7FFF), top_bit(mag | 0xFF) - 7 */
+MPF_G711_TARGET("sse4.1")
+static APR_INLINE __m128i sse41_segment(__m128i mag)
+{
+	__m128i seg = _mm_setzero_si128();
+	int k;
+	for(k=0; k<7; k++) {
+		seg = _mm_sub_epi16(seg,_mm_cmpgt_epi16(mag,_mm_set1_epi16((short)((0x100 << k) - 1))));
+	}
+	return seg;
+}
+
+MPF_G711_TARGET("sse4.1")
+static APR_INLINE __m128i sse41_ulaw_encode8(__m128i x)
+{
+	const __m128i factors = _mm_setr_epi16(G711_ULAW_SHR_FACTORS);
+	__m128i sign = _mm_srai_epi16(x,15);
+	__m128i mag = _mm_adds_epi16(_mm_xor_si128(x,sign),_mm_set1_epi16(ULAW_BIAS));
+	__m128i seg = sse41_segment(mag);
+	__m128i mant = _mm_and_si128(_mm_mulhi_epu16(mag,sse41_shuffle16(factors,seg)),_mm_set1_epi16(0x0F));
+	__m128i mask = _mm_xor_si128(_mm_set1_epi16(0xFF),_mm_and_si128(sign,_mm_set1_epi16(0x80)));
+	return _mm_xor_si128(_mm_or_si128(_mm_slli_epi16(seg,4),mant),mask);
+}
+
+MPF_G711_TARGET("sse4.1")
+static APR_INLINE __m128i sse41_alaw_encode8(__m128i x)
+{
+	const __m128i factors = _mm_setr_epi16(G711_ALAW_SHR_FACTORS);
+	__m128i sign = _mm_srai_epi16(x,15);
+	__m128i mag = _mm_xor_si128(x,sign);
+	__m128i seg = sse41_segment(mag);
+	__m128i mant = _mm_and_si128(_mm_mulhi_epu16(mag,sse41_shuffle16(factors,seg)),_mm_set1_epi16(0x0F));
+	__m128i mask = _mm_xor_si128(_mm_set1_epi16(ALAW_AMI_MASK | 0x80),_mm_and_si128(sign,_mm_set1_epi16(0x80)));
+	return _mm_xor_si128(_mm_or_si128(_mm_slli_epi16(seg,4),mant),mask);
+}
+
+MPF_G711_TARGET("sse4.1")
+static void sse41_ulaw_encode(const apr_int16_t *linear, apr_byte_t *code, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i+16<=count; i+=16) {
+		__m128i lo = sse41_ulaw_encode8(_mm_loadu_si128((const __m128i*)(linear+i)));
+		__m128i hi = sse41_ulaw_encode8(_mm_loadu_si128((const __m128i*)(linear+i+8)));
+		_mm_storeu_si128((__m128i*)(code+i),_mm_packus_epi16(lo,hi));
+	}
+	scalar_ulaw_encode(linear+i,code+i,count-i);
+}
+
+MPF_G711_TARGET("sse4.1")
+static void sse41_alaw_encode(const apr_int16_t *linear, apr_byte_t *code, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i+16<=count; i+=16) {
+		__m128i lo = sse41_alaw_encode8(_mm_loadu_si128((const __m128i*)(linear+i)));
+		__m128i hi = sse41_alaw_encode8(_mm_loadu_si128((const __m128i*)(linear+i+8)));
+		_mm_storeu_si128((__m128i*)(code+i),_mm_packus_epi16(lo,hi));
+	}
+	scalar_alaw_encode(linear+i,code+i,count-i);
+}
+
+MPF_G711_TARGET("sse4.1")
+static void sse41_ulaw_decode(const apr_byte_t *code, apr_int16_t *linear, apr_size_t count)
+{
+	const __m128i factors = _mm_setr_epi16(G711_ULAW_SHL_FACTORS);
+	const __m128i bias = _mm_set1_epi16(ULAW_BIAS);
+	apr_size_t i;
+	for(i=0; i+8<=count; i+=8) {
+		__m128i u = _mm_xor_si128(_mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(code+i))),_mm_set1_epi16(0xFF));
+		__m128i seg = _mm_and_si128(_mm_srli_epi16(u,4),_mm_set1_epi16(0x07));
+		__m128i t = _mm_add_epi16(_mm_slli_epi16(_mm_and_si128(u,_mm_set1_epi16(0x0F)),3),bias);
+		__m128i sign = _mm_srai_epi16(_mm_slli_epi16(u,8),15);
+		t = _mm_sub_epi16(_mm_mullo_epi16(t,sse41_shuffle16(factors,seg)),bias);
+		_mm_storeu_si128((__m128i*)(linear+i),_mm_sub_epi16(_mm_xor_si128(t,sign),sign));
+	}
+	scalar_ulaw_decode(code+i,linear+i,count-i);
+}
+
+MPF_G711_TARGET("sse4.1")
+static void sse41_alaw_decode(const apr_byte_t *code, apr_int16_t *linear, apr_size_t count)
+{
+	const __m128i factors = _mm_setr_epi16(G711_ALAW_SHL_FACTORS);
+	apr_size_t i;
+	for(i=0; i+8<=count; i+=8) {
+		__m128i a = _mm_xor_si128(_mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(code+i))),_mm_set1_epi16(ALAW_AMI_MASK));
+		__m128i seg = _mm_and_si128(_mm_srli_epi16(a,4),_mm_set1_epi16(0x07));
+		__m128i v = _mm_add_epi16(_mm_slli_epi16(_mm_and_si128(a,_mm_set1_epi16(0x0F)),4),_mm_set1_epi16(8));
+		/* negative unless the sign bit is set */
+		__m128i neg = _mm_xor_si128(_mm_srai_epi16(_mm_slli_epi16(a,8),15),_mm_set1_epi16(-1));
+		v = _mm_add_epi16(v,_mm_and_si128(_mm_cmpgt_epi16(seg,_mm_setzero_si128()),_mm_set1_epi16(0x100)));
+		v = _mm_mullo_epi16(v,sse41_shuffle16(factors,seg));
+		_mm_storeu_si128((__m128i*)(linear+i),_mm_sub_epi16(_mm_xor_si128(v,neg),neg));
+	}
+	scalar_alaw_decode(code+i,linear+i,count-i);
+}
+
+static const mpf_g711_kernel_t sse41_kernel = {
+	MPF_G711_KERNEL_SSE41,
+	"sse4.1",
+	sse41_ulaw_encode,
+	sse41_ulaw_decode,
+	sse41_alaw_encode,
+	sse41_alaw_decode
+};
+#endif
+
+#ifdef MPF_G711_AVX2
+MPF_G711_TARGET("avx2")
+static APR_INLINE __m256i avx2_shuffle16(__m256i table, __m256i seg)
+{
+	__m256i index = _mm256_add_epi16(_mm256_mullo_epi16(seg,_mm256_set1_epi16(0x0202)),_mm256_set1_epi16(0x0100));
+	return _mm256_shuffle_epi8(table,index);
+}
+
+MPF_G711_TARGET("avx2")
+static APR_INLINE __m256i avx2_segment(__m256i mag)
+{
+	__m256i seg = _mm256_setzero_si256();
+	int k;
+	for(k=0; k<7; k++) {
+		seg = _mm256_sub_epi16(seg,_mm256_cmpgt_epi16(mag,_mm256_set1_epi16((short)((0x100 << k) - 1))));
+	}
+	return seg;
+}
+
+MPF_G711_TARGET("avx2")
+static APR_INLINE __m256i avx2_ulaw_encode16(__m256i x)
+{
+	/* byte shuffle works within 128-bit lanes, hence the table is repeated */
+	const __m256i factors = _mm256_setr_epi16(G711_ULAW_SHR_FACTORS,G711_ULAW_SHR_FACTORS);
+	__m256i sign = _mm256_srai_epi16(x,15);
+	__m256i mag = _mm256_adds_epi16(_mm256_xor_si256(x,sign),_mm256_set1_epi16(ULAW_BIAS));
+	__m256i seg = avx2_segment(mag);
+	__m256i mant = _mm256_and_si256(_mm256_mulhi_epu16(mag,avx2_shuffle16(factors,seg)),_mm256_set1_epi16(0x0F));
+	__m256i mask = _mm256_xor_si256(_mm256_set1_epi16(0xFF),_mm256_and_si256(sign,_mm256_set1_epi16(0x80)));
+	return _mm256_xor_si256(_mm256_or_si256(_mm256_slli_epi16(seg,4),mant),mask);
+}
+
+MPF_G711_TARGET("avx2")
+static APR_INLINE __m256i avx2_alaw_encode16(__m256i x)
+{
+	const __m256i factors = _mm256_setr_epi16(G711_ALAW_SHR_FACTORS,G711_ALAW_SHR_FACTORS);
+	__m256i sign = _mm256_srai_epi16(x,15);
+	__m256i mag = _mm256_xor_si256(x,sign);
+	__m256i seg = avx2_segment(mag);
+	__m256i mant = _mm256_and_si256(_mm256_mulhi_epu16(mag,avx2_shuffle16(factors,seg)),_mm256_set1_epi16(0x0F));
+	__m256i mask = _mm256_xor_si256(_mm256_set1_epi16(ALAW_AMI_MASK | 0x80),_mm256_and_si256(sign,_mm256_set1_epi16(0x80)));
+	return _mm256_xor_si256(_mm256_or_si256(_mm256_slli_epi16(seg,4),mant),mask);
+}
+
+MPF_G711_TARGET("avx2")
+static void avx2_ulaw_encode(const apr_int16_t *linear, apr_byte_t *code, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i+32<=count; i+=32) {
+		__m256i lo = avx2_ulaw_encode16(_mm256_loadu_si256((const __m256i*)(linear+i)));
+		__m256i hi = avx2_ulaw_encode16(_mm256_loadu_si256((const __m256i*)(linear+i+16)));
+		/* pack interleaves 128-bit lanes, restore the sample order */
+		_mm256_storeu_si256((__m256i*)(code+i),_mm256_permute4x64_epi64(_mm256_packus_epi16(lo,hi),0xD8));
+	}
+	scalar_ulaw_encode(linear+i,code+i,count-i);
+}
+
+MPF_G711_TARGET("avx2")
+static void avx2_alaw_encode(const apr_int16_t *linear, apr_byte_t *code, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i+32<=count; i+=32) {
+		__m256i lo = avx2_alaw_encode16(_mm256_loadu_si256((const __m256i*)(linear+i)));
+		__m256i hi = avx2_alaw_encode16(_mm256_loadu_si256((const __m256i*)(linear+i+16)));
+		_mm256_storeu_si256((__m256i*)(code+i),_mm256_permute4x64_epi64(_mm256_packus_epi16(lo,hi),0xD8));
+	}
+	scalar_alaw_encode(linear+i,code+i,count-i);
+}
+
+MPF_G711_TARGET("avx2")
+static void avx2_ulaw_decode(const apr_byte_t *code, apr_int16_t *linear, apr_size_t count)
+{
+	const __m256i factors = _mm256_setr_epi16(G711_ULAW_SHL_FACTORS,G711_ULAW_SHL_FACTORS);
+	const __m256i bias = _mm256_set1_epi16(ULAW_BIAS);
+	apr_size_t i;
+	for(i=0; i+16<=count; i+=16) {
+		__m256i u = _mm256_xor_si256(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(code+i))),_mm256_set1_epi16(0xFF));
+		__m256i seg = _mm256_and_si256(_mm256_srli_epi16(u,4),_mm256_set1_epi16(0x07));
+		__m256i t = _mm256_add_epi16(_mm256_slli_epi16(_mm256_and_si256(u,_mm256_set1_epi16(0x0F)),3),bias);
+		__m256i sign = _mm256_srai_epi16(_mm256_slli_epi16(u,8),15);
+		t = _mm256_sub_epi16(_mm256_mullo_epi16(t,avx2_shuffle16(factors,seg)),bias);
+		_mm256_storeu_si256((__m256i*)(linear+i),_mm256_sub_epi16(_mm256_xor_si256(t,sign),sign));
+	}
+	scalar_ulaw_decode(code+i,linear+i,count-i);
+}
+
+MPF_G711_TARGET("avx2")
+static void avx2_alaw_decode(const apr_byte_t *code, apr_int16_t *linear, apr_size_t count)
+{
+	const __m256i factors = _mm256_setr_epi16(G711_ALAW_SHL_FACTORS,G711_ALAW_SHL_FACTORS);
+	apr_size_t i;
+	for(i=0; i+16<=count; i+=16) {
+		__m256i a = _mm256_xor_si256(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(code+i))),_mm256_set1_epi16(ALAW_AMI_MASK));
+		__m256i seg = _mm256_and_si256(_mm256_srli_epi16(a,4),_mm256_set1_epi16(0x07));
+		__m256i v = _mm256_add_epi16(_mm256_slli_epi16(_mm256_and_si256(a,_mm256_set1_epi16(0x0F)),4),_mm256_set1_epi16(8));
+		__m256i neg = _mm256_xor_si256(_mm256_srai_epi16(_mm256_slli_epi16(a,8),15),_mm256_set1_epi16(-1));
+		v = _mm256_add_epi16(v,_mm256_and_si256(_mm256_cmpgt_epi16(seg,_mm256_setzero_si256()),_mm256_set1_epi16(0x100)));
+		v = _mm256_mullo_epi16(v,avx2_shuffle16(factors,seg));
+		_mm256_storeu_si256((__m256i*)(linear+i),_mm256_sub_epi16(_mm256_xor_si256(v,neg),neg));
+	}
+	scalar_alaw_decode(code+i,linear+i,count-i);
+}
+
+static const mpf_g711_kernel_t avx2_kernel = {
+	MPF_G711_KERNEL_AVX2,
+	"avx2",
+	avx2_ulaw_encode,
+	avx2_ulaw_decode,
+	avx2_alaw_encode,
+	avx2_alaw_decode
+};
+#endif
+
+#ifdef MPF_G711_NEON
+static void neon_ulaw_encode(const apr_int16_t *linear, apr_byte_t *code, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i+8<=count; i+=8) {
+		int16x8_t x = vld1q_s16(linear+i);
+		uint16x8_t sign = vreinterpretq_u16_s16(vshrq_n_s16(x,15));
+		uint16x8_t mag = vreinterpretq_u16_s16(vqaddq_s16(veorq_s16(x,vreinterpretq_s16_u16(sign)),vdupq_n_s16(ULAW_BIAS)));
+		uint16x8_t seg = vsubq_u16(vdupq_n_u16(8),vclzq_u16(vorrq_u16(mag,vdupq_n_u16(0xFF))));
+		int16x8_t shift = vnegq_s16(vreinterpretq_s16_u16(vaddq_u16(seg,vdupq_n_u16(3))));
+		uint16x8_t mant = vandq_u16(vshlq_u16(mag,shift),vdupq_n_u16(0x0F));
+		uint16x8_t mask = veorq_u16(vdupq_n_u16(0xFF),vandq_u16(sign,vdupq_n_u16(0x80)));
+		vst1_u8(code+i,vmovn_u16(veorq_u16(vorrq_u16(vshlq_n_u16(seg,4),mant),mask)));
+	}
+	scalar_ulaw_encode(linear+i,code+i,count-i);
+}
+
+static void neon_alaw_encode(const apr_int16_t *linear, apr_byte_t *code, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i+8<=count; i+=8) {
+		int16x8_t x = vld1q_s16(linear+i);
+		uint16x8_t sign = vreinterpretq_u16_s16(vshrq_n_s16(x,15));
+		uint16x8_t mag = veorq_u16(vreinterpretq_u16_s16(x),sign);
+		uint16x8_t seg = vsubq_u16(vdupq_n_u16(8),vclzq_u16(vorrq_u16(mag,vdupq_n_u16(0xFF))));
+		int16x8_t shift = vnegq_s16(vreinterpretq_s16_u16(vaddq_u16(vmaxq_u16(seg,vdupq_n_u16(1)),vdupq_n_u16(3))));
+		uint16x8_t mant = vandq_u16(vshlq_u16(mag,shift),vdupq_n_u16(0x0F));
+		uint16x8_t mask = veorq_u16(vdupq_n_u16(ALAW_AMI_MASK | 0x80),vandq_u16(sign,vdupq_n_u16(0x80)));
+		vst1_u8(code+i,vmovn_u16(veorq_u16(vorrq_u16(vshlq_n_u16(seg,4),mant),mask)));
+	}
+	scalar_alaw_encode(linear+i,code+i,count-i);
+}
+
+static void neon_ulaw_decode(const apr_byte_t *code, apr_int16_t *linear, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i+8<=count; i+=8) {
+		uint16x8_t u = veorq_u16(vmovl_u8(vld1_u8(code+i)),vdupq_n_u16(0xFF));
+		uint16x8_t seg = vandq_u16(vshrq_n_u16(u,4),vdupq_n_u16(0x07));
+		uint16x8_t t = vaddq_u16(vshlq_n_u16(vandq_u16(u,vdupq_n_u16(0x0F)),3),vdupq_n_u16(ULAW_BIAS));
+		int16x8_t v = vreinterpretq_s16_u16(vsubq_u16(vshlq_u16(t,vreinterpretq_s16_u16(seg)),vdupq_n_u16(ULAW_BIAS)));
+		vst1q_s16(linear+i,vbslq_s16(vtstq_u16(u,vdupq_n_u16(0x80)),vnegq_s16(v),v));
+	}
+	scalar_ulaw_decode(code+i,linear+i,count-i);
+}
+
+static void neon_alaw_decode(const apr_byte_t *code, apr_int16_t *linear, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i+8<=count; i+=8) {
+		uint16x8_t a = veorq_u16(vmovl_u8(vld1_u8(code+i)),vdupq_n_u16(ALAW_AMI_MASK));
+		uint16x8_t seg = vandq_u16(vshrq_n_u16(a,4),vdupq_n_u16(0x07));
+		uint16x8_t t = vaddq_u16(vshlq_n_u16(vandq_u16(a,vdupq_n_u16(0x0F)),4),vdupq_n_u16(8));
+		int16x8_t v;
+		t = vaddq_u16(t,vandq_u16(vcgtq_u16(seg,vdupq_n_u16(0)),vdupq_n_u16(0x100)));
+		v = vreinterpretq_s16_u16(vshlq_u16(t,vreinterpretq_s16_u16(vqsubq_u16(seg,vdupq_n_u16(1)))));
+		vst1q_s16(linear+i,vbslq_s16(vtstq_u16(a,vdupq_n_u16(0x80)),v,vnegq_s16(v)));
+	}
+	scalar_alaw_decode(code+i,linear+i,count-i);
+}
+
+static const mpf_g711_kernel_t neon_kernel = {
+	MPF_G711_KERNEL_NEON,
+	"neon",
+	neon_ulaw_encode,
+	neon_ulaw_decode,
+	neon_alaw_encode,
+	neon_alaw_decode
+};
+#endif
+
+#ifdef MPF_G711_X86
+static apt_bool_t g711_cpu_supports(mpf_g711_kernel_e type)
+{
+#if defined(__GNUC__)
+	__builtin_cpu_init();
+	if(type == MPF_G711_KERNEL_SSE41) {
+		return __builtin_cpu_supports("sse4.1") ? TRUE : FALSE;
+	}
+	if(type == MPF_G711_KERNEL_AVX2) {
+		return __builtin_cpu_supports("avx2") ? TRUE : FALSE;
+	}
+#else
+	int info[4];
+	__cpuid(info,1);
+	if(type == MPF_G711_KERNEL_SSE41) {
+		return (info[2] & (1 << 19)) ? TRUE : FALSE;
+	}
+#ifdef MPF_G711_AVX2
+	if(type == MPF_G711_KERNEL_AVX2) {
+		/* OS must save YMM state (OSXSAVE + XCR0) besides CPU support */
+		if(!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 0x06) != 0x06) {
+			return FALSE;
+		}
+		__cpuidex(info,7,0);
+		return (info[1] & (1 << 5)) ? TRUE : FALSE;
+	}
+#endif
+#endif
+	return FALSE;
+}
+#endif
+
+/** Get the kernel set of the specified instruction set */
+MPF_DECLARE(const mpf_g711_kernel_t*) mpf_g711_kernel_get(mpf_g711_kernel_e type)
+{
+	switch(type) {
+		case MPF_G711_KERNEL_SCALAR:
+			return &scalar_kernel;
+#ifdef MPF_G711_SSE41
+		case MPF_G711_KERNEL_SSE41:
+			return g711_cpu_supports(type) == TRUE ? &sse41_kernel : NULL;
+#endif
+#ifdef MPF_G711_AVX2
+		case MPF_G711_KERNEL_AVX2:
+			return g711_cpu_supports(type) == TRUE ? &avx2_kernel : NULL;
+#endif
+#ifdef MPF_G711_NEON
+		case MPF_G711_KERNEL_NEON:
+			return &neon_kernel;
+#endif
+		default:
+			break;
+	}
+	return NULL;
+}
+
+/** Get the fastest kernel set supported by the CPU */
+MPF_DECLARE(const mpf_g711_kernel_t*) mpf_g711_kernel_best_get(void)
+{
+	static const mpf_g711_kernel_t *best_kernel = NULL;
+	if(!best_kernel) {
+		/* detection is idempotent, a concurrent first call is harmless */
+		const mpf_g711_kernel_t *kernel = NULL;
+		int type;
+		for(type = MPF_G711_KERNEL_COUNT - 1; type >= 0 && !kernel; type--) {
+			kernel = mpf_g711_kernel_get((mpf_g711_kernel_e)type);
+		}
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Select G.711 Kernel [%s]",kernel->name);
+		best_kernel = kernel;
+	}
+	return best_kernel;
+}
@@ -18,6 +18,8 @@
 
 #include "mpf_jitter_buffer.h"
 #include "mpf_trace.h"
+#include "apt_pool.h"
+#include "apt_probe.h"
 
 #if ENABLE_JB_TRACE == 1
 #define JB_TRACE printf
@@ -27,15 +29,61 @@
 #define JB_TRACE mpf_null_trace
 #endif
 
+/* number of successive reads the playout delay should exceed the estimated one for before shrink */
+#define JB_SHRINK_HOLD_COUNT   50
+/* number of additional reads the shrink may wait for a missing frame to drop */
+#define JB_SHRINK_WAIT_COUNT   25
+/* max number of successive missing frames to be concealed */
+#define JB_MAX_CONCEAL_COUNT   3
+/* number of frames taken from the slab at once */
+#define JB_BLOCK_FRAMES        8
+
+typedef struct mpf_jb_slab_class_t mpf_jb_slab_class_t;
+
+/** Free blocks of the same size */
+struct mpf_jb_slab_class_t {
+	/* size of a block in bytes */
+	apr_size_t           block_size;
+	/* list of free blocks, linked through their first bytes */
+	void                *free_list;
+	/* next class */
+	mpf_jb_slab_class_t *next;
+};
+
+struct mpf_jb_slab_t {
+	/* pool to allocate blocks from */
+	apr_pool_t          *pool;
+	/* whether the pool is of the slab's own */
+	apt_bool_t           own_pool;
+	/* region to allocate blocks from ahead of the pool (NULL if none) */
+	apt_huge_region_t   *region;
+	/* classes of blocks (one per frame size in use) */
+	mpf_jb_slab_class_t *classes;
+	/* size of the blocks allocated in bytes */
+	apr_size_t           allocated;
+	/* size of the blocks held by jitter buffers in bytes */
+	apr_size_t           used;
+};
+
+/* whether the time skew is detected and adjusted by whole frames in the buffer */
+#define JB_SKEW_DETECTION(jb) \
+	((jb)->config->time_skew_detection && (jb)->config->time_skew_detection != MPF_TIME_SKEW_RESAMPLE)
+
 struct mpf_jitter_buffer_t {
 	/* jitter buffer config */
 	mpf_jb_config_t *config;
 	/* codec to be used to dissect payload */
 	mpf_codec_t     *codec;
 
-	/* cyclic raw data */
-	apr_byte_t      *raw_data;
-	/* frames (out of raw data) */
+	/* slab the blocks of raw data are taken from */
+	mpf_jb_slab_t       *slab;
+	/* class of the blocks in the slab */
+	mpf_jb_slab_class_t *slab_class;
+	/* blocks of cyclic raw data (NULL if not taken from the slab) */
+	apr_byte_t     **blocks;
+	/* number of blocks */
+	apr_size_t       block_count;
+	/* frames (out of the blocks of raw data) */
 	mpf_frame_t     *frames;
 	/* number of frames */
 	apr_size_t       frame_count;
@@ -48,6 +96,24 @@ struct mpf_jitter_buffer_t {
 	apr_uint32_t     playout_delay_ts;
 	/* max playout delay in timetsamp units */
 	apr_uint32_t     max_playout_delay_ts;
+	/* min playout delay in timetsamp units */
+	apr_uint32_t     min_playout_delay_ts;
+
+	/* mean lateness of packets relative to the write sync point (scaled by 16) */
+	apr_int32_t      lateness_mean;
+	/* mean deviation of the lateness (scaled by 16) */
+	apr_int32_t      lateness_dev;
+	/* playout delay estimated out of the lateness in timestamp units */
+	apr_uint32_t     target_playout_delay_ts;
+	/* number of successive reads the playout delay has exceeded the estimated one for */
+	apr_uint32_t     shrink_count;
+
+	/* copy of the last audio frame used to conceal missing frames */
+	mpf_codec_frame_t conceal_frame;
+	/* number of successive frames concealed */
+	apr_uint32_t     conceal_count;
+	/* mark missing frames as lost to be concealed by the decoder */
+	apt_bool_t       loss_mark;
 
 	/* write should be synchronized (offset calculated) */
 	apr_byte_t       write_sync;
@@ -66,6 +132,13 @@ struct mpf_jitter_buffer_t {
 	/* number of statistical measurements made */
 	apr_uint32_t     measurment_count;
 
+	/* timestamp the next in-order packet is expected with (bypass mode) */
+	apr_uint32_t     bypass_next_ts;
+	/* timestamp of the latest written packet (bypass mode) */
+	apr_uint32_t     bypass_last_ts;
+	/* write pos the latest written packet starts at (bypass mode) */
+	apr_uint32_t     bypass_last_pos;
+
 	/* timestamp event starts at */
 	apr_uint32_t                   event_write_base_ts;
 	/* the first (base) frame of the event */
@@ -74,8 +147,97 @@ struct mpf_jitter_buffer_t {
 	const mpf_named_event_frame_t *event_write_update;
 };
 
+static APR_INLINE void mpf_jitter_buffer_frame_allign(mpf_jitter_buffer_t *jb, apr_uint32_t *ts)
+{
+	if(*ts % jb->frame_ts != 0) 
+		*ts -= *ts % jb->frame_ts;
+}
 
-mpf_jitter_buffer_t* mpf_jitter_buffer_create(mpf_jb_config_t *jb_config, mpf_codec_descriptor_t *descriptor, mpf_codec_t *codec, apr_pool_t *pool)
+mpf_jb_slab_t* mpf_jb_slab_create(apr_pool_t *pool)
+{
+	mpf_jb_slab_t *slab;
+	apt_bool_t own_pool = FALSE;
+	if(!pool) {
+		pool = apt_pool_create();
+		if(!pool) {
+			return NULL;
+		}
+		own_pool = TRUE;
+	}
+	slab = apr_palloc(pool,sizeof(mpf_jb_slab_t));
+	slab->pool = pool;
+	slab->own_pool = own_pool;
+	slab->region = NULL;
+	slab->classes = NULL;
+	slab->allocated = 0;
+	slab->used = 0;
+	return slab;
+}
+
+void mpf_jb_slab_destroy(mpf_jb_slab_t *slab)
+{
+	if(slab->own_pool == TRUE) {
+		apr_pool_destroy(slab->pool);
+	}
+}
+
+void mpf_jb_slab_region_set(mpf_jb_slab_t *slab, apt_huge_region_t *region)
+{
+	slab->region = region;
+}
+
+void mpf_jb_slab_stat_get(const mpf_jb_slab_t *slab, apr_size_t *allocated, apr_size_t *used)
+{
+	*allocated = slab->allocated;
+	*used = slab->used;
+}
+
+static mpf_jb_slab_class_t* mpf_jb_slab_class_get(mpf_jb_slab_t *slab, apr_size_t block_size)
+{
+	mpf_jb_slab_class_t *slab_class;
+	if(block_size < sizeof(void*)) {
+		/* free blocks are linked through their first bytes */
+		block_size = sizeof(void*);
+	}
+	for(slab_class = slab->classes; slab_class; slab_class = slab_class->next) {
+		if(slab_class->block_size == block_size) {
+			return slab_class;
+		}
+	}
+	slab_class = apr_palloc(slab->pool,sizeof(mpf_jb_slab_class_t));
+	slab_class->block_size = block_size;
+	slab_class->free_list = NULL;
+	slab_class->next = slab->classes;
+	slab->classes = slab_class;
+	return slab_class;
+}
+
+static APR_INLINE apr_byte_t* mpf_jb_slab_block_take(mpf_jb_slab_t *slab, mpf_jb_slab_class_t *slab_class)
+{
+	void *block = slab_class->free_list;
+	if(block) {
+		/* the most recently released block is the warmest one */
+		slab_class->free_list = *(void**)block;
+	}
+	else {
+		block = slab->region ? apt_huge_region_alloc(slab->region,slab_class->block_size) : NULL;
+		if(!block) {
+			block = apr_palloc(slab->pool,slab_class->block_size);
+		}
+		slab->allocated += slab_class->block_size;
+	}
+	slab->used += slab_class->block_size;
+	return block;
+}
+
+static APR_INLINE void mpf_jb_slab_block_release(mpf_jb_slab_t *slab, mpf_jb_slab_class_t *slab_class, apr_byte_t *block)
+{
+	*(void**)block = slab_class->free_list;
+	slab_class->free_list = block;
+	slab->used -= slab_class->block_size;
+}
+
+mpf_jitter_buffer_t* mpf_jitter_buffer_create(mpf_jb_config_t *jb_config, mpf_codec_descriptor_t *descriptor, mpf_codec_t *codec, mpf_jb_slab_t *slab, apr_pool_t *pool)
 {
 	size_t i;
 	mpf_frame_t *frame;
@@ -103,13 +265,19 @@ mpf_jitter_buffer_t* mpf_jitter_buffer_create(mpf_jb_config_t *jb_config, mpf_co
 	jb->frame_ts = (apr_uint32_t)mpf_codec_frame_samples_calculate(descriptor);
 	jb->frame_size = mpf_codec_frame_size_calculate(descriptor,codec->attribs);
 	jb->frame_count = jb->config->max_playout_delay / CODEC_FRAME_TIME_BASE;
-	jb->raw_data = apr_palloc(pool,jb->frame_size*jb->frame_count);
+	if(!slab) {
+		slab = mpf_jb_slab_create(pool);
+	}
+	jb->slab = slab;
+	jb->slab_class = mpf_jb_slab_class_get(slab,jb->frame_size*JB_BLOCK_FRAMES);
+	jb->block_count = (jb->frame_count + JB_BLOCK_FRAMES - 1) / JB_BLOCK_FRAMES;
+	jb->blocks = apr_pcalloc(pool,sizeof(apr_byte_t*)*jb->block_count);
 	jb->frames = apr_palloc(pool,sizeof(mpf_frame_t)*jb->frame_count);
 	for(i=0; i<jb->frame_count; i++) {
 		frame = &jb->frames[i];
 		frame->type = MEDIA_FRAME_TYPE_NONE;
 		frame->marker = MPF_MARKER_NONE;
-		frame->codec_frame.buffer = jb->raw_data + i*jb->frame_size;
+		frame->codec_frame.buffer = NULL;
 	}
 
 	if(jb->config->initial_playout_delay % CODEC_FRAME_TIME_BASE != 0) {
@@ -119,10 +287,24 @@ mpf_jitter_buffer_t* mpf_jitter_buffer_create(mpf_jb_config_t *jb_config, mpf_co
 	/* calculate playout delay in timestamp units */
 	jb->playout_delay_ts = jb->frame_ts * jb->config->initial_playout_delay / CODEC_FRAME_TIME_BASE;
 	jb->max_playout_delay_ts = jb->frame_ts * jb->config->max_playout_delay / CODEC_FRAME_TIME_BASE;
+	jb->min_playout_delay_ts = jb->frame_ts * jb->config->min_playout_delay / CODEC_FRAME_TIME_BASE;
+	mpf_jitter_buffer_frame_allign(jb,&jb->min_playout_delay_ts);
+
+	/* start the estimation from the initial playout delay */
+	jb->lateness_mean = 0;
+	jb->lateness_dev = jb->playout_delay_ts * 16 / 4;
+	jb->target_playout_delay_ts = jb->playout_delay_ts;
+	jb->shrink_count = 0;
+
+	jb->conceal_frame.buffer = apr_palloc(pool,jb->frame_size);
+	jb->conceal_frame.size = 0;
+	jb->conceal_count = 0;
+	jb->loss_mark = FALSE;
 
 	jb->write_sync = 1;
 	jb->write_ts_offset = 0;
 	jb->write_ts = jb->read_ts = 0;
+	jb->bypass_next_ts = jb->bypass_last_ts = jb->bypass_last_pos = 0;
 
 	jb->min_length_ts = jb->max_length_ts = 0;
 	jb->measurment_count = 0;
@@ -136,6 +318,13 @@ mpf_jitter_buffer_t* mpf_jitter_buffer_create(mpf_jb_config_t *jb_config, mpf_co
 
 void mpf_jitter_buffer_destroy(mpf_jitter_buffer_t *jb)
 {
+	apr_size_t i;
+	for(i=0; i<jb->block_count; i++) {
+		if(jb->blocks[i]) {
+			mpf_jb_slab_block_release(jb->slab,jb->slab_class,jb->blocks[i]);
+			jb->blocks[i] = NULL;
+		}
+	}
 }
 
 apt_bool_t mpf_jitter_buffer_restart(mpf_jitter_buffer_t *jb)
@@ -150,18 +339,74 @@ apt_bool_t mpf_jitter_buffer_restart(mpf_jitter_buffer_t *jb)
 
 	if(jb->config->adaptive && jb->playout_delay_ts == jb->max_playout_delay_ts) {
 		jb->playout_delay_ts = jb->frame_ts * jb->config->initial_playout_delay / CODEC_FRAME_TIME_BASE;
+		jb->target_playout_delay_ts = jb->playout_delay_ts;
 	}
+	jb->shrink_count = 0;
+	jb->conceal_frame.size = 0;
+	jb->conceal_count = 0;
 
 	JB_TRACE("JB restart\n");
 	return TRUE;
 }
 
+apt_bool_t mpf_jitter_buffer_is_empty(const mpf_jitter_buffer_t *jb)
+{
+	return (jb->write_sync || jb->write_ts <= jb->read_ts) ? TRUE : FALSE;
+}
+
 static APR_INLINE mpf_frame_t* mpf_jitter_buffer_frame_get(mpf_jitter_buffer_t *jb, apr_size_t ts)
 {
 	apr_size_t index = (ts / jb->frame_ts) % jb->frame_count;
 	return &jb->frames[index];
 }
 
+/** Get the frame to be written to, taking the block of raw data it belongs to from the slab, if needed */
+static APR_INLINE mpf_frame_t* mpf_jitter_buffer_frame_attach(mpf_jitter_buffer_t *jb, apr_size_t ts)
+{
+	apr_size_t index = (ts / jb->frame_ts) % jb->frame_count;
+	apr_size_t block = index / JB_BLOCK_FRAMES;
+	if(!jb->blocks[block]) {
+		apr_size_t i = block * JB_BLOCK_FRAMES;
+		apr_size_t last = i + JB_BLOCK_FRAMES;
+		apr_byte_t *raw_data = mpf_jb_slab_block_take(jb->slab,jb->slab_class);
+		if(last > jb->frame_count) {
+			last = jb->frame_count;
+		}
+		jb->blocks[block] = raw_data;
+		for(; i<last; i++) {
+			jb->frames[i].codec_frame.buffer = raw_data;
+			raw_data += jb->frame_size;
+		}
+	}
+	return &jb->frames[index];
+}
+
+/** Advance the read pos, giving the block of raw data left behind back to the slab */
+static APR_INLINE void mpf_jitter_buffer_read_advance(mpf_jitter_buffer_t *jb)
+{
+	apr_size_t index = (jb->read_ts / jb->frame_ts) % jb->frame_count;
+	apr_size_t block = index / JB_BLOCK_FRAMES;
+	jb->read_ts += jb->frame_ts;
+	if(index + 1 != jb->frame_count && (index + 1) % JB_BLOCK_FRAMES != 0) {
+		/* the block is still being read */
+		return;
+	}
+	if(jb->blocks[block]) {
+		apr_size_t i = block * JB_BLOCK_FRAMES;
+		for(; i<=index; i++) {
+			if(jb->frames[i].type & MEDIA_FRAME_TYPE_AUDIO) {
+				/* frames of the next cycle are already there */
+				return;
+			}
+		}
+		for(i = block * JB_BLOCK_FRAMES; i<=index; i++) {
+			jb->frames[i].codec_frame.buffer = NULL;
+		}
+		mpf_jb_slab_block_release(jb->slab,jb->slab_class,jb->blocks[block]);
+		jb->blocks[block] = NULL;
+	}
+}
+
 static APR_INLINE void mpf_jitter_buffer_stat_update(mpf_jitter_buffer_t *jb)
 {
 	apr_int32_t length_ts;
@@ -189,10 +434,34 @@ static APR_INLINE void mpf_jitter_buffer_stat_update(mpf_jitter_buffer_t *jb)
 	jb->measurment_count++;
 }
 
-static APR_INLINE void mpf_jitter_buffer_frame_allign(mpf_jitter_buffer_t *jb, apr_uint32_t *ts)
+static APR_INLINE apr_uint32_t mpf_jitter_buffer_delay_estimate(const mpf_jitter_buffer_t *jb, apr_uint32_t ts, apr_int32_t write_ts_offset, apr_int32_t *mean, apr_int32_t *dev)
 {
-	if(*ts % jb->frame_ts != 0) 
-		*ts -= *ts % jb->frame_ts;
+	apr_int32_t error;
+	apr_int32_t target_ts;
+	/* lateness of the packet relative to the sync point (how much later than
+	the sync packet it arrived, measured by the read clock) */
+	apr_int32_t lateness = (apr_int32_t)(jb->read_ts + write_ts_offset - ts);
+
+	/* smoothed mean and mean deviation of the lateness */
+	error = lateness * 16 - *mean;
+	*mean += error / 8;
+	if(error < 0) {
+		error = -error;
+	}
+	*dev += (error - *dev) / 4;
+
+	/* the playout delay should cover the lateness of almost every packet */
+	target_ts = (*mean + 4 * *dev) / 16;
+	if(target_ts < (apr_int32_t)jb->min_playout_delay_ts) {
+		target_ts = jb->min_playout_delay_ts;
+	}
+	else if(target_ts > (apr_int32_t)jb->max_playout_delay_ts) {
+		target_ts = jb->max_playout_delay_ts;
+	}
+	if(target_ts % jb->frame_ts != 0) {
+		target_ts += jb->frame_ts - target_ts % jb->frame_ts;
+	}
+	return target_ts;
 }
 
 static APR_INLINE jb_result_t mpf_jitter_buffer_write_prepare(mpf_jitter_buffer_t *jb, apr_uint32_t ts, apr_uint32_t *write_ts)
@@ -202,8 +471,10 @@ static APR_INLINE jb_result_t mpf_jitter_buffer_write_prepare(mpf_jitter_buffer_
 		/* calculate the offset */
 		jb->write_ts_offset = ts - jb->read_ts;
 		jb->write_sync = 0;
+		/* the lateness is measured relative to the sync point */
+		jb->lateness_mean = 0;
 	
-		if(jb->config->time_skew_detection) {
+		if(JB_SKEW_DETECTION(jb)) {
 			/* reset the statistics */
 			jb->min_length_ts = jb->max_length_ts = jb->playout_delay_ts;
 			jb->measurment_count = 0;
@@ -221,13 +492,149 @@ static APR_INLINE jb_result_t mpf_jitter_buffer_write_prepare(mpf_jitter_buffer_
 	return JB_OK;
 }
 
-jb_result_t mpf_jitter_buffer_write(mpf_jitter_buffer_t *jb, void *buffer, apr_size_t size, apr_uint32_t ts, apr_byte_t marker)
+static apr_uint32_t mpf_jitter_buffer_frames_write(mpf_jitter_buffer_t *jb, void *buffer, apr_size_t size, apr_uint32_t write_ts, apr_size_t available_frame_count)
 {
 	mpf_frame_t *media_frame;
+	while(available_frame_count && size) {
+		media_frame = mpf_jitter_buffer_frame_attach(jb,write_ts);
+		media_frame->codec_frame.size = jb->frame_size;
+		if(buffer == media_frame->codec_frame.buffer && !jb->codec->vtable->dissect) {
+			/* payload has been received in place (see mpf_jitter_buffer_slots_get) */
+			if(size < jb->frame_size) {
+				break;
+			}
+			buffer = (apr_byte_t*)buffer + jb->frame_size;
+			size -= jb->frame_size;
+		}
+		else if(mpf_codec_dissect(jb->codec,&buffer,&size,&media_frame->codec_frame) == FALSE) {
+			break;
+		}
+
+		media_frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+		write_ts += jb->frame_ts;
+		available_frame_count--;
+	}
+
+	if(size) {
+		/* no frame available to write, but some data remains in buffer (partialy too early) */
+	}
+	return write_ts;
+}
+
+static APR_INLINE apr_uint32_t mpf_jitter_buffer_bypass_pos_get(const mpf_jitter_buffer_t *jb)
+{
+	/* frames are queued right after the last written one, or at the read pos after underflow */
+	return (jb->write_ts > jb->read_ts) ? jb->write_ts : jb->read_ts;
+}
+
+static APR_INLINE apt_bool_t mpf_jitter_buffer_bypass_in_order(const mpf_jitter_buffer_t *jb, apr_uint32_t ts, apr_byte_t marker)
+{
+	apr_int32_t delta_ts;
+	if(jb->write_sync || marker) {
+		return TRUE;
+	}
+
+	delta_ts = (apr_int32_t)(ts - jb->bypass_next_ts);
+	if(delta_ts >= 0) {
+		/* next or newer packet, gaps are not kept */
+		return TRUE;
+	}
+	if(delta_ts < -(apr_int32_t)(jb->frame_count * jb->frame_ts)) {
+		/* timestamp jump backwards, treat as a new sequence */
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static jb_result_t mpf_jitter_buffer_bypass_write(mpf_jitter_buffer_t *jb, void *buffer, apr_size_t size, apr_uint32_t ts, apr_byte_t marker)
+{
+	apr_uint32_t write_ts;
+	apr_uint32_t pos;
+	apr_size_t available_frame_count;
+	apr_size_t frame_count;
+	mpf_frame_t *src_media_frame;
+	mpf_frame_t *dst_media_frame;
+
+	if(mpf_jitter_buffer_bypass_in_order(jb,ts,marker) == TRUE) {
+		/* append the frames to the queue */
+		pos = mpf_jitter_buffer_bypass_pos_get(jb);
+		available_frame_count = jb->frame_count - (pos - jb->read_ts)/jb->frame_ts;
+		write_ts = mpf_jitter_buffer_frames_write(jb,buffer,size,pos,available_frame_count);
+		if(write_ts == pos) {
+			JB_TRACE("JB bypass write ts=%u too early => discard\n",ts);
+			return JB_DISCARD_TOO_EARLY;
+		}
+
+		JB_TRACE("JB bypass write ts=%u pos=%u\n",ts,pos);
+		jb->write_sync = 0;
+		jb->write_ts = write_ts;
+		jb->bypass_next_ts = ts + (write_ts - pos);
+		jb->bypass_last_ts = ts;
+		jb->bypass_last_pos = pos;
+
+		/* keep no more than the playout delay queued ahead of the latest packet */
+		if(pos > jb->read_ts + jb->playout_delay_ts) {
+			pos -= jb->playout_delay_ts;
+			JB_TRACE("JB bypass drop ts=%u-%u\n",jb->read_ts,pos);
+			while(jb->read_ts < pos) {
+				src_media_frame = mpf_jitter_buffer_frame_get(jb,jb->read_ts);
+				src_media_frame->type = MEDIA_FRAME_TYPE_NONE;
+				src_media_frame->marker = MPF_MARKER_NONE;
+				mpf_jitter_buffer_read_advance(jb);
+			}
+		}
+		return JB_OK;
+	}
+
+	/* packet is older than expected, it can only be put in front of the latest
+	packet as long as none of the latest packet frames has been played out yet */
+	if(jb->codec->vtable->dissect || (apr_int32_t)(ts - jb->bypass_last_ts) >= 0 || jb->bypass_last_pos < jb->read_ts) {
+		JB_TRACE("JB bypass write ts=%u out of order => discard\n",ts);
+		return JB_DISCARD_TOO_LATE;
+	}
+
+	frame_count = size / jb->frame_size;
+	available_frame_count = jb->frame_count - (jb->write_ts - jb->read_ts)/jb->frame_ts;
+	if(!frame_count || frame_count > available_frame_count) {
+		return JB_DISCARD_TOO_EARLY;
+	}
+
+	/* move the frames of the latest packet forward */
+	JB_TRACE("JB bypass reorder ts=%u pos=%u\n",ts,jb->bypass_last_pos);
+	pos = jb->write_ts;
+	while(pos > jb->bypass_last_pos) {
+		pos -= jb->frame_ts;
+		src_media_frame = mpf_jitter_buffer_frame_get(jb,pos);
+		dst_media_frame = mpf_jitter_buffer_frame_attach(jb,pos + frame_count * jb->frame_ts);
+		dst_media_frame->type = src_media_frame->type;
+		dst_media_frame->marker = src_media_frame->marker;
+		dst_media_frame->event_frame = src_media_frame->event_frame;
+		dst_media_frame->codec_frame.size = src_media_frame->codec_frame.size;
+		if(src_media_frame->type & MEDIA_FRAME_TYPE_AUDIO) {
+			memcpy(dst_media_frame->codec_frame.buffer,src_media_frame->codec_frame.buffer,src_media_frame->codec_frame.size);
+		}
+		src_media_frame->type = MEDIA_FRAME_TYPE_NONE;
+		src_media_frame->marker = MPF_MARKER_NONE;
+	}
+
+	/* and put the older packet in front of them */
+	mpf_jitter_buffer_frames_write(jb,buffer,frame_count * jb->frame_size,jb->bypass_last_pos,frame_count);
+	jb->write_ts += frame_count * jb->frame_ts;
+	jb->bypass_last_ts = ts;
+	return JB_OK;
+}
+
+jb_result_t mpf_jitter_buffer_write(mpf_jitter_buffer_t *jb, void *buffer, apr_size_t size, apr_uint32_t ts, apr_byte_t marker)
+{
 	apr_uint32_t write_ts;
 	apr_size_t available_frame_count;
 	jb_result_t result;
 
+	APT_PROBE4(jb_write,jb,ts,size,marker);
+	if(jb->config->bypass) {
+		return mpf_jitter_buffer_bypass_write(jb,buffer,size,ts,marker);
+	}
+
 	if(marker) {
 		JB_TRACE("JB marker\n");
 		/* new talkspurt detected => test whether the buffer is empty */
@@ -243,6 +650,22 @@ jb_result_t mpf_jitter_buffer_write(mpf_jitter_buffer_t *jb, void *buffer, apr_s
 		return result;
 	}
 
+	if(jb->config->adaptive) {
+		jb->target_playout_delay_ts = mpf_jitter_buffer_delay_estimate(
+			jb,ts,jb->write_ts_offset,&jb->lateness_mean,&jb->lateness_dev);
+		if(jb->target_playout_delay_ts > jb->playout_delay_ts && 
+			jb->playout_delay_ts + jb->frame_ts <= jb->max_playout_delay_ts) {
+			/* grow by a frame, the gap is going to be concealed */
+			jb->playout_delay_ts += jb->frame_ts;
+			write_ts += jb->frame_ts;
+			JB_TRACE("JB grow playout delay=%u target=%u\n",jb->playout_delay_ts,jb->target_playout_delay_ts);
+			if(JB_SKEW_DETECTION(jb)) {
+				jb->min_length_ts += jb->frame_ts;
+				jb->max_length_ts += jb->frame_ts;
+			}
+		}
+	}
+
 	if(write_ts >= jb->read_ts) {
 		if(write_ts >= jb->write_ts) {
 			/* normal order */
@@ -263,7 +686,7 @@ jb_result_t mpf_jitter_buffer_write(mpf_jitter_buffer_t *jb, void *buffer, apr_s
 		/* calculate a minimal adjustment needed in order to place the packet into the buffer */
 		delta_ts = jb->read_ts - write_ts;
 
-		if(jb->config->time_skew_detection) {
+		if(JB_SKEW_DETECTION(jb)) {
 			JB_TRACE("JB stat length [%d : %d] playout delay=%u delta=%u\n",
 				jb->min_length_ts,jb->max_length_ts,jb->playout_delay_ts,delta_ts);
 			
@@ -315,7 +738,7 @@ jb_result_t mpf_jitter_buffer_write(mpf_jitter_buffer_t *jb, void *buffer, apr_s
 			write_ts += delta_ts;
 			JB_TRACE("JB adjust playout delay=%u delta=%u\n",jb->playout_delay_ts,delta_ts);
 
-			if(jb->config->time_skew_detection) {
+			if(JB_SKEW_DETECTION(jb)) {
 				/* adjust the statistics */
 				jb->min_length_ts += delta_ts;
 				jb->max_length_ts += delta_ts;
@@ -332,34 +755,167 @@ jb_result_t mpf_jitter_buffer_write(mpf_jitter_buffer_t *jb, void *buffer, apr_s
 	}
 
 	JB_TRACE("JB write ts=%u size=%"APR_SIZE_T_FMT"\n",write_ts,size);
-	while(available_frame_count && size) {
-		media_frame = mpf_jitter_buffer_frame_get(jb,write_ts);
-		media_frame->codec_frame.size = jb->frame_size;
-		if(mpf_codec_dissect(jb->codec,&buffer,&size,&media_frame->codec_frame) == FALSE) {
-			break;
+	write_ts = mpf_jitter_buffer_frames_write(jb,buffer,size,write_ts,available_frame_count);
+
+	if(write_ts > jb->write_ts) {
+		/* advance write pos */
+		jb->write_ts = write_ts;
+	}
+	return result;
+}
+
+void* mpf_jitter_buffer_slots_get(mpf_jitter_buffer_t *jb, apr_size_t *size)
+{
+	apr_uint32_t write_ts;
+	apr_size_t index;
+	apr_size_t count;
+
+	if(jb->codec->vtable->dissect) {
+		/* payload is to be dissected by the codec */
+		return NULL;
+	}
+
+	/* predict the write pos of the next in-order payload */
+	if(jb->config->bypass) {
+		write_ts = mpf_jitter_buffer_bypass_pos_get(jb);
+	}
+	else if(jb->write_sync) {
+		write_ts = jb->read_ts + jb->playout_delay_ts;
+	}
+	else if(jb->write_ts > jb->read_ts) {
+		write_ts = jb->write_ts;
+	}
+	else {
+		write_ts = jb->read_ts;
+	}
+
+	/* the frames from the write pos on are free, take them up to the end of the block of raw data */
+	count = (write_ts - jb->read_ts)/jb->frame_ts;
+	if(count >= jb->frame_count) {
+		/* too early */
+		return NULL;
+	}
+	count = jb->frame_count - count;
+	index = (write_ts / jb->frame_ts) % jb->frame_count;
+	if(count > JB_BLOCK_FRAMES - index % JB_BLOCK_FRAMES) {
+		count = JB_BLOCK_FRAMES - index % JB_BLOCK_FRAMES;
+	}
+	if(count > jb->frame_count - index) {
+		count = jb->frame_count - index;
+	}
+
+	*size = count * jb->frame_size;
+	return mpf_jitter_buffer_frame_attach(jb,write_ts)->codec_frame.buffer;
+}
+
+apt_bool_t mpf_jitter_buffer_slots_match(const mpf_jitter_buffer_t *jb, const void *buffer, apr_uint32_t ts, apr_byte_t marker)
+{
+	apr_uint32_t write_ts;
+	apr_int32_t write_ts_offset = jb->write_ts_offset;
+	apr_uint32_t playout_delay_ts = jb->playout_delay_ts;
+	apr_int32_t lateness_mean = jb->lateness_mean;
+	apr_int32_t lateness_dev = jb->lateness_dev;
+	apr_size_t index;
+
+	if(jb->config->bypass) {
+		/* only in-order payload is appended where it has been received */
+		if(mpf_jitter_buffer_bypass_in_order(jb,ts,marker) == FALSE) {
+			return FALSE;
 		}
+		index = (mpf_jitter_buffer_bypass_pos_get(jb) / jb->frame_ts) % jb->frame_count;
+		return (buffer == jb->frames[index].codec_frame.buffer) ? TRUE : FALSE;
+	}
 
-		media_frame->type |= MEDIA_FRAME_TYPE_AUDIO;
-		write_ts += jb->frame_ts;
-		available_frame_count--;
+	/* calculate the write pos the same way mpf_jitter_buffer_write() does */
+	if(jb->write_sync || (marker && jb->write_ts <= jb->read_ts)) {
+		write_ts_offset = ts - jb->read_ts;
+		lateness_mean = 0;
+	}
+	if(jb->config->adaptive) {
+		apr_uint32_t target_ts = mpf_jitter_buffer_delay_estimate(jb,ts,write_ts_offset,&lateness_mean,&lateness_dev);
+		if(target_ts > playout_delay_ts && playout_delay_ts + jb->frame_ts <= jb->max_playout_delay_ts) {
+			playout_delay_ts += jb->frame_ts;
+		}
+	}
+	write_ts = ts - write_ts_offset + playout_delay_ts;
+	write_ts -= write_ts % jb->frame_ts;
+	if(write_ts < jb->read_ts) {
+		/* too late, the write pos is to be adjusted */
+		return FALSE;
 	}
 
-	if(size) {
-		/* no frame available to write, but some data remains in buffer (partialy too early) */
+	index = (write_ts / jb->frame_ts) % jb->frame_count;
+	return (buffer == jb->frames[index].codec_frame.buffer) ? TRUE : FALSE;
+}
+
+static jb_result_t mpf_jitter_buffer_bypass_event_write(mpf_jitter_buffer_t *jb, const mpf_named_event_frame_t *named_event, apr_uint32_t ts, apr_byte_t marker)
+{
+	mpf_frame_t *media_frame;
+	apr_uint32_t pos;
+
+	if(!marker && jb->event_write_update && 
+		jb->event_write_base.event_id == named_event->event_id && jb->event_write_base_ts == ts) {
+		/* an update of the current event */
+		if(named_event->duration < jb->event_write_update->duration) {
+			/* something from the past */
+			return JB_OK;
+		}
+		if(named_event->duration == jb->event_write_update->duration &&
+			(jb->event_write_update->edge == 1 || jb->event_write_update->edge == named_event->edge)) {
+			/* retransmission */
+			return JB_OK;
+		}
+	}
+	else {
+		/* new event (the marker might be missing) */
+		marker = 1;
 	}
+	jb->event_write_base = *named_event;
+	jb->event_write_update = &jb->event_write_base;
+	jb->event_write_base_ts = ts;
 
-	if(write_ts > jb->write_ts) {
-		/* advance write pos */
-		jb->write_ts = write_ts;
+	/* attach the event to the latest queued frame, unless it already carries one */
+	pos = mpf_jitter_buffer_bypass_pos_get(jb);
+	if(pos > jb->read_ts) {
+		media_frame = mpf_jitter_buffer_frame_get(jb,pos - jb->frame_ts);
+		if(!(media_frame->type & MEDIA_FRAME_TYPE_EVENT)) {
+			pos -= jb->frame_ts;
+		}
 	}
-	return result;
+	if((pos - jb->read_ts)/jb->frame_ts >= jb->frame_count) {
+		return JB_DISCARD_TOO_EARLY;
+	}
+
+	media_frame = mpf_jitter_buffer_frame_get(jb,pos);
+	media_frame->event_frame = *named_event;
+	media_frame->type |= MEDIA_FRAME_TYPE_EVENT;
+	if(marker) {
+		media_frame->marker = MPF_MARKER_START_OF_EVENT;
+	}
+	else if(named_event->edge == 1) {
+		media_frame->marker = MPF_MARKER_END_OF_EVENT;
+	}
+	JB_TRACE("JB bypass write pos=%u event=%d duration=%d marker=%d\n",
+		pos,named_event->event_id,named_event->duration,media_frame->marker);
+
+	pos += jb->frame_ts;
+	if(pos > jb->write_ts) {
+		jb->write_ts = pos;
+	}
+	return JB_OK;
 }
 
 jb_result_t mpf_jitter_buffer_event_write(mpf_jitter_buffer_t *jb, const mpf_named_event_frame_t *named_event, apr_uint32_t ts, apr_byte_t marker)
 {
 	mpf_frame_t *media_frame;
 	apr_uint32_t write_ts;
-	jb_result_t result = mpf_jitter_buffer_write_prepare(jb,ts,&write_ts);
+	jb_result_t result;
+
+	if(jb->config->bypass) {
+		return mpf_jitter_buffer_bypass_event_write(jb,named_event,ts,marker);
+	}
+
+	result = mpf_jitter_buffer_write_prepare(jb,ts,&write_ts);
 	if(result != JB_OK) {
 		return result;
 	}
@@ -466,9 +1022,55 @@ jb_result_t mpf_jitter_buffer_event_write(mpf_jitter_buffer_t *jb, const mpf_nam
 	return result;
 }
 
+static APR_INLINE void mpf_jitter_buffer_shrink(mpf_jitter_buffer_t *jb)
+{
+	mpf_frame_t *media_frame;
+	if(jb->playout_delay_ts < jb->target_playout_delay_ts + 2 * jb->frame_ts ||
+		jb->playout_delay_ts < jb->min_playout_delay_ts + jb->frame_ts) {
+		/* no excess delay */
+		jb->shrink_count = 0;
+		return;
+	}
+
+	jb->shrink_count++;
+	if(jb->shrink_count < JB_SHRINK_HOLD_COUNT || jb->write_ts < jb->read_ts + 2 * jb->frame_ts) {
+		return;
+	}
+
+	media_frame = mpf_jitter_buffer_frame_get(jb,jb->read_ts);
+	if(media_frame->type & MEDIA_FRAME_TYPE_EVENT) {
+		/* never drop events */
+		return;
+	}
+	if((media_frame->type & MEDIA_FRAME_TYPE_AUDIO) && jb->shrink_count < JB_SHRINK_HOLD_COUNT + JB_SHRINK_WAIT_COUNT) {
+		/* prefer to drop a missing frame */
+		return;
+	}
+
+	/* drop the frame, and keep the write pos of the next packets
+	by adjusting both the offset and the playout delay */
+	JB_TRACE("JB shrink ts=%u playout delay=%u target=%u\n",
+		jb->read_ts,jb->playout_delay_ts,jb->target_playout_delay_ts);
+	media_frame->type = MEDIA_FRAME_TYPE_NONE;
+	media_frame->marker = MPF_MARKER_NONE;
+	mpf_jitter_buffer_read_advance(jb);
+	jb->playout_delay_ts -= jb->frame_ts;
+	jb->write_ts_offset -= jb->frame_ts;
+	if(JB_SKEW_DETECTION(jb)) {
+		jb->min_length_ts -= jb->frame_ts;
+		jb->max_length_ts -= jb->frame_ts;
+	}
+	jb->shrink_count = 0;
+}
+
 apt_bool_t mpf_jitter_buffer_read(mpf_jitter_buffer_t *jb, mpf_frame_t *media_frame)
 {
-	mpf_frame_t *src_media_frame = mpf_jitter_buffer_frame_get(jb,jb->read_ts);
+	mpf_frame_t *src_media_frame;
+	if(jb->config->adaptive && !jb->config->bypass && !jb->write_sync) {
+		mpf_jitter_buffer_shrink(jb);
+	}
+
+	src_media_frame = mpf_jitter_buffer_frame_get(jb,jb->read_ts);
 	if(jb->write_ts > jb->read_ts) {
 		/* normal read */
 		JB_TRACE("JB read ts=%u\n",	jb->read_ts);
@@ -477,6 +1079,28 @@ apt_bool_t mpf_jitter_buffer_read(mpf_jitter_buffer_t *jb, mpf_frame_t *media_fr
 		if(media_frame->type & MEDIA_FRAME_TYPE_AUDIO) {
 			media_frame->codec_frame.size = src_media_frame->codec_frame.size;
 			memcpy(media_frame->codec_frame.buffer,src_media_frame->codec_frame.buffer,media_frame->codec_frame.size);
+			jb->conceal_count = 0;
+			if(jb->config->adaptive && 
+				!(mpf_jitter_buffer_frame_get(jb,jb->read_ts + jb->frame_ts)->type & MEDIA_FRAME_TYPE_AUDIO)) {
+				/* the next frame is missing (so far), keep this one to conceal it */
+				jb->conceal_frame.size = media_frame->codec_frame.size;
+				memcpy(jb->conceal_frame.buffer,media_frame->codec_frame.buffer,jb->conceal_frame.size);
+			}
+		}
+		else if(jb->loss_mark == TRUE) {
+			if(!(media_frame->type & MEDIA_FRAME_TYPE_EVENT)) {
+				/* missing frame, while the next ones are already there => let the decoder conceal the loss */
+				JB_TRACE("JB read ts=%u lost\n",jb->read_ts);
+				media_frame->type |= MEDIA_FRAME_TYPE_LOST;
+			}
+		}
+		else if(jb->config->adaptive && jb->conceal_frame.size && jb->conceal_count < JB_MAX_CONCEAL_COUNT) {
+			/* missing frame, while the next ones are already there => conceal the loss by the last frame */
+			JB_TRACE("JB read ts=%u conceal\n",jb->read_ts);
+			media_frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+			media_frame->codec_frame.size = jb->conceal_frame.size;
+			memcpy(media_frame->codec_frame.buffer,jb->conceal_frame.buffer,jb->conceal_frame.size);
+			jb->conceal_count++;
 		}
 		if(media_frame->type & MEDIA_FRAME_TYPE_EVENT) {
 			media_frame->event_frame = src_media_frame->event_frame;
@@ -488,18 +1112,30 @@ apt_bool_t mpf_jitter_buffer_read(mpf_jitter_buffer_t *jb, mpf_frame_t *media_fr
 		media_frame->type = MEDIA_FRAME_TYPE_NONE;
 		media_frame->marker = MPF_MARKER_NONE;
 	}
+	APT_PROBE3(jb_read,jb,jb->read_ts,media_frame->type);
 	src_media_frame->type = MEDIA_FRAME_TYPE_NONE;
 	src_media_frame->marker = MPF_MARKER_NONE;
 	/* advance read pos */
-	jb->read_ts += jb->frame_ts;
+	mpf_jitter_buffer_read_advance(jb);
 	
-	if(jb->config->time_skew_detection) {
+	if(JB_SKEW_DETECTION(jb)) {
 		/* update statistics after every read */
 		mpf_jitter_buffer_stat_update(jb);
 	}
 	return TRUE;
 }
 
+void mpf_jitter_buffer_loss_mark_set(mpf_jitter_buffer_t *jb, apt_bool_t enable)
+{
+	jb->loss_mark = enable;
+}
+
+apr_int32_t mpf_jitter_buffer_excess_get(const mpf_jitter_buffer_t *jb)
+{
+	apr_int32_t excess_ts = (apr_int32_t)(jb->write_ts - jb->read_ts) - (apr_int32_t)jb->playout_delay_ts;
+	return excess_ts * CODEC_FRAME_TIME_BASE * 1000 / (apr_int32_t)jb->frame_ts;
+}
+
 apr_uint32_t mpf_jitter_buffer_playout_delay_get(const mpf_jitter_buffer_t *jb)
 {
 	if(jb->config->adaptive == 0) {
@@ -23,6 +23,14 @@
 #include "mpf_codec_manager.h"
 #include "apt_log.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MPF_MIXER_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define MPF_MIXER_NEON
+#include <arm_neon.h>
+#endif
+
 typedef struct mpf_mixer_t mpf_mixer_t;
 
 /** MPF mixer derived from MPF object */
@@ -36,56 +44,113 @@ struct mpf_mixer_t {
 	/** Audio sink */
 	mpf_audio_stream_t  *sink;
 
-	/** Frame to read from audio source */
-	mpf_frame_t          frame;
+	/** Frames to read from audio sources (one per source) */
+	mpf_frame_t         *frame_arr;
+	/** Sample buffers of audio frames to mix in the current tick */
+	const apr_int16_t  **buffer_arr;
 	/** Mixed frame to write to audio sink */
 	mpf_frame_t          mix_frame;
+	/** Pool the frame buffers are borrowed from */
+	mpf_frame_pool_t    *frame_pool;
 };
 
-static apt_bool_t mpf_frames_mix(mpf_frame_t *mix_frame, const mpf_frame_t *frame)
+/** Mix buffers into dst in a single pass, accumulating in 32 bits and saturating to 16 bits */
+static void mpf_buffers_mix(apr_int16_t *dst, const apr_int16_t **src_arr, apr_size_t src_count, apr_size_t samples)
 {
-	apr_size_t i;
-	apr_int16_t *mix_buf = mix_frame->codec_frame.buffer;
-	const apr_int16_t *buf = frame->codec_frame.buffer;
-	apr_size_t samples = frame->codec_frame.size / sizeof(apr_int16_t);
-
-	if(mix_frame->codec_frame.size != frame->codec_frame.size) {
-		return FALSE;
+	apr_size_t i = 0;
+	apr_size_t k;
+	apr_int32_t sum;
+#if defined(MPF_MIXER_SSE2)
+	for(; i+8<=samples; i+=8) {
+		__m128i lo = _mm_setzero_si128();
+		__m128i hi = _mm_setzero_si128();
+		for(k=0; k<src_count; k++) {
+			__m128i v = _mm_loadu_si128((const __m128i*)(src_arr[k]+i));
+			/* sign extend to 32 bits */
+			lo = _mm_add_epi32(lo,_mm_srai_epi32(_mm_unpacklo_epi16(v,v),16));
+			hi = _mm_add_epi32(hi,_mm_srai_epi32(_mm_unpackhi_epi16(v,v),16));
+		}
+		_mm_storeu_si128((__m128i*)(dst+i),_mm_packs_epi32(lo,hi));
 	}
-
-	if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO) {
-		for(i=0; i<samples; i++) {
-			/* overflow MUST be considered */
-			mix_buf[i] = mix_buf[i] + buf[i];
+#elif defined(MPF_MIXER_NEON)
+	for(; i+8<=samples; i+=8) {
+		int32x4_t lo = vdupq_n_s32(0);
+		int32x4_t hi = vdupq_n_s32(0);
+		for(k=0; k<src_count; k++) {
+			int16x8_t v = vld1q_s16(src_arr[k]+i);
+			lo = vaddw_s16(lo,vget_low_s16(v));
+			hi = vaddw_s16(hi,vget_high_s16(v));
 		}
-		mix_frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+		vst1q_s16(dst+i,vcombine_s16(vqmovn_s32(lo),vqmovn_s32(hi)));
+	}
+#endif
+	for(; i<samples; i++) {
+		sum = 0;
+		for(k=0; k<src_count; k++) {
+			sum += src_arr[k][i];
+		}
+		if(sum > 32767) {
+			sum = 32767;
+		}
+		else if(sum < -32768) {
+			sum = -32768;
+		}
+		dst[i] = (apr_int16_t)sum;
 	}
-
-	return TRUE;
 }
 
 static apt_bool_t mpf_mixer_process(mpf_object_t *object)
 {
 	apr_size_t i;
+	apr_size_t count = 0;
+	mpf_frame_t *frame;
 	mpf_audio_stream_t *source;
 	mpf_mixer_t *mixer = (mpf_mixer_t*) object;
 
 	mixer->mix_frame.type = MEDIA_FRAME_TYPE_NONE;
 	mixer->mix_frame.marker = MPF_MARKER_NONE;
-	memset(mixer->mix_frame.codec_frame.buffer,0,mixer->mix_frame.codec_frame.size);
 	for(i=0; i<mixer->source_count; i++) {
 		source = mixer->source_arr[i];
 		if(source) {
-			mixer->frame.type = MEDIA_FRAME_TYPE_NONE;
-			mixer->frame.marker = MPF_MARKER_NONE;
-			source->vtable->read_frame(source,&mixer->frame);
-			mpf_frames_mix(&mixer->mix_frame,&mixer->frame);
+			frame = &mixer->frame_arr[i];
+			frame->type = MEDIA_FRAME_TYPE_NONE;
+			frame->marker = MPF_MARKER_NONE;
+			source->vtable->read_frame(source,frame);
+			if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO &&
+				frame->codec_frame.size == mixer->mix_frame.codec_frame.size) {
+				mixer->buffer_arr[count++] = frame->codec_frame.buffer;
+			}
 		}
 	}
+
+	if(count) {
+		mpf_buffers_mix(
+			mixer->mix_frame.codec_frame.buffer,
+			mixer->buffer_arr,
+			count,
+			mixer->mix_frame.codec_frame.size / sizeof(apr_int16_t));
+		mixer->mix_frame.type |= MEDIA_FRAME_TYPE_AUDIO;
+	}
+	else {
+		memset(mixer->mix_frame.codec_frame.buffer,0,mixer->mix_frame.codec_frame.size);
+	}
 	mixer->sink->vtable->write_frame(mixer->sink,&mixer->mix_frame);
 	return TRUE;
 }
 
+/* The frames are left in the jitter buffers, read on the next tick */
+static apt_bool_t mpf_mixer_defer(mpf_object_t *object)
+{
+	mpf_mixer_t *mixer = (mpf_mixer_t*) object;
+	apr_size_t i;
+	for(i=0; i<mixer->source_count; i++) {
+		if(mixer->source_arr[i]) {
+			mpf_audio_stream_receive(mixer->source_arr[i]);
+		}
+	}
+	return TRUE;
+}
+
 static apt_bool_t mpf_mixer_destroy(mpf_object_t *object)
 {
 	apr_size_t i;
@@ -100,6 +165,12 @@ static apt_bool_t mpf_mixer_destroy(mpf_object_t *object)
 		}
 	}
 	mpf_audio_stream_tx_close(mixer->sink);
+	if(mixer->frame_arr) {
+		for(i=0; i<mixer->source_count; i++) {
+			mpf_frame_pool_buffer_release(mixer->frame_pool,mixer->frame_arr[i].codec_frame.buffer);
+		}
+		mpf_frame_pool_buffer_release(mixer->frame_pool,mixer->mix_frame.codec_frame.buffer);
+	}
 	return TRUE;
 }
 
@@ -140,6 +211,7 @@ MPF_DECLARE(mpf_object_t*) mpf_mixer_create(
 								mpf_audio_stream_t *sink, 
 								const mpf_codec_manager_t *codec_manager, 
 								const char *name,
+								mpf_frame_pool_t *frame_pool,
 								apr_pool_t *pool)
 {
 	apr_size_t i;
@@ -156,8 +228,11 @@ MPF_DECLARE(mpf_object_t*) mpf_mixer_create(
 	mixer->source_arr = NULL;
 	mixer->source_count = 0;
 	mixer->sink = NULL;
+	mixer->frame_arr = NULL;
+	mixer->frame_pool = frame_pool;
 	mpf_object_init(&mixer->base,name);
 	mixer->base.process = mpf_mixer_process;
+	mixer->base.defer = mpf_mixer_defer;
 	mixer->base.destroy = mpf_mixer_destroy;
 	mixer->base.trace = mpf_mixer_trace;
 
@@ -194,6 +269,16 @@ MPF_DECLARE(mpf_object_t*) mpf_mixer_create(
 				source = decoder;
 			}
 		}
+
+		if(source->rx_descriptor->sampling_rate != sink->tx_descriptor->sampling_rate) {
+			/* set resampler before mixer */
+			mpf_audio_stream_t *resampler = mpf_resampler_create(source,sink,pool);
+			if(!resampler) {
+				source_arr[i] = NULL;
+				continue;
+			}
+			source = resampler;
+		}
 		source_arr[i] = source;
 		mpf_audio_stream_rx_open(source,NULL);
 	}
@@ -202,9 +287,311 @@ MPF_DECLARE(mpf_object_t*) mpf_mixer_create(
 
 	descriptor = sink->tx_descriptor;
 	frame_size = mpf_codec_linear_frame_size_calculate(descriptor->sampling_rate,descriptor->channel_count);
-	mixer->frame.codec_frame.size = frame_size;
-	mixer->frame.codec_frame.buffer = apr_palloc(pool,frame_size);
+	mixer->frame_arr = apr_palloc(pool,sizeof(mpf_frame_t) * source_count);
+	for(i=0; i<source_count; i++) {
+		mixer->frame_arr[i].codec_frame.size = frame_size;
+		mixer->frame_arr[i].codec_frame.buffer = mpf_frame_pool_buffer_get(frame_pool,frame_size,pool);
+	}
+	mixer->buffer_arr = apr_palloc(pool,sizeof(const apr_int16_t*) * source_count);
+	mixer->mix_frame.codec_frame.size = frame_size;
+	mixer->mix_frame.codec_frame.buffer = mpf_frame_pool_buffer_get(frame_pool,frame_size,pool);
+	return &mixer->base;
+}
+
+typedef struct mpf_mixer_n1_t mpf_mixer_n1_t;
+
+/** MPF N-1 mixer derived from MPF object */
+struct mpf_mixer_n1_t {
+	/** MPF mixer base */
+	mpf_object_t         base;
+	/** Array of audio sources (one per participant) */
+	mpf_audio_stream_t **source_arr;
+	/** Array of audio sinks (one per participant) */
+	mpf_audio_stream_t **sink_arr;
+	/** Number of participants */
+	apr_size_t           count;
+
+	/** Frames read from audio sources (one per participant) */
+	mpf_frame_t         *frame_arr;
+	/** Sum of audio frames of all the participants in the current tick */
+	apr_int32_t         *sum;
+	/** Frame written to audio sinks (N-1 mix) */
+	mpf_frame_t          mix_frame;
+	/** Pool the frame buffers are borrowed from */
+	mpf_frame_pool_t    *frame_pool;
+};
+
+/** Add buffer to the sum of 32-bit samples */
+static void mpf_buffer_accumulate(apr_int32_t *sum, const apr_int16_t *src, apr_size_t samples)
+{
+	apr_size_t i = 0;
+#if defined(MPF_MIXER_SSE2)
+	for(; i+8<=samples; i+=8) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(src+i));
+		__m128i lo = _mm_loadu_si128((const __m128i*)(sum+i));
+		__m128i hi = _mm_loadu_si128((const __m128i*)(sum+i+4));
+		lo = _mm_add_epi32(lo,_mm_srai_epi32(_mm_unpacklo_epi16(v,v),16));
+		hi = _mm_add_epi32(hi,_mm_srai_epi32(_mm_unpackhi_epi16(v,v),16));
+		_mm_storeu_si128((__m128i*)(sum+i),lo);
+		_mm_storeu_si128((__m128i*)(sum+i+4),hi);
+	}
+#elif defined(MPF_MIXER_NEON)
+	for(; i+8<=samples; i+=8) {
+		int16x8_t v = vld1q_s16(src+i);
+		vst1q_s32(sum+i,vaddw_s16(vld1q_s32(sum+i),vget_low_s16(v)));
+		vst1q_s32(sum+i+4,vaddw_s16(vld1q_s32(sum+i+4),vget_high_s16(v)));
+	}
+#endif
+	for(; i<samples; i++) {
+		sum[i] += src[i];
+	}
+}
+
+/** Subtract own buffer (if any) from the sum, saturating to 16 bits */
+static void mpf_buffer_exclude(apr_int16_t *dst, const apr_int32_t *sum, const apr_int16_t *own, apr_size_t samples)
+{
+	apr_size_t i = 0;
+	apr_int32_t value;
+#if defined(MPF_MIXER_SSE2)
+	for(; i+8<=samples; i+=8) {
+		__m128i lo = _mm_loadu_si128((const __m128i*)(sum+i));
+		__m128i hi = _mm_loadu_si128((const __m128i*)(sum+i+4));
+		if(own) {
+			__m128i v = _mm_loadu_si128((const __m128i*)(own+i));
+			lo = _mm_sub_epi32(lo,_mm_srai_epi32(_mm_unpacklo_epi16(v,v),16));
+			hi = _mm_sub_epi32(hi,_mm_srai_epi32(_mm_unpackhi_epi16(v,v),16));
+		}
+		_mm_storeu_si128((__m128i*)(dst+i),_mm_packs_epi32(lo,hi));
+	}
+#elif defined(MPF_MIXER_NEON)
+	for(; i+8<=samples; i+=8) {
+		int32x4_t lo = vld1q_s32(sum+i);
+		int32x4_t hi = vld1q_s32(sum+i+4);
+		if(own) {
+			int16x8_t v = vld1q_s16(own+i);
+			lo = vsubw_s16(lo,vget_low_s16(v));
+			hi = vsubw_s16(hi,vget_high_s16(v));
+		}
+		vst1q_s16(dst+i,vcombine_s16(vqmovn_s32(lo),vqmovn_s32(hi)));
+	}
+#endif
+	for(; i<samples; i++) {
+		value = own ? sum[i] - own[i] : sum[i];
+		if(value > 32767) {
+			value = 32767;
+		}
+		else if(value < -32768) {
+			value = -32768;
+		}
+		dst[i] = (apr_int16_t)value;
+	}
+}
+
+static apt_bool_t mpf_mixer_n1_process(mpf_object_t *object)
+{
+	apr_size_t i;
+	apr_size_t count = 0;
+	apr_size_t samples;
+	apt_bool_t own;
+	mpf_frame_t *frame;
+	mpf_audio_stream_t *source;
+	mpf_mixer_n1_t *mixer = (mpf_mixer_n1_t*) object;
+
+	samples = mixer->mix_frame.codec_frame.size / sizeof(apr_int16_t);
+	memset(mixer->sum,0,samples * sizeof(apr_int32_t));
+	for(i=0; i<mixer->count; i++) {
+		source = mixer->source_arr[i];
+		frame = &mixer->frame_arr[i];
+		frame->type = MEDIA_FRAME_TYPE_NONE;
+		frame->marker = MPF_MARKER_NONE;
+		if(source) {
+			source->vtable->read_frame(source,frame);
+			if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO &&
+				frame->codec_frame.size == mixer->mix_frame.codec_frame.size) {
+				mpf_buffer_accumulate(mixer->sum,frame->codec_frame.buffer,samples);
+				count++;
+				continue;
+			}
+		}
+		/* not part of the mix in this tick */
+		frame->type = MEDIA_FRAME_TYPE_NONE;
+	}
+
+	for(i=0; i<mixer->count; i++) {
+		if(!mixer->sink_arr[i]) {
+			continue;
+		}
+		own = (mixer->frame_arr[i].type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO ? TRUE : FALSE;
+		mixer->mix_frame.type = MEDIA_FRAME_TYPE_NONE;
+		mixer->mix_frame.marker = MPF_MARKER_NONE;
+		if(count > (own == TRUE ? 1U : 0U)) {
+			mpf_buffer_exclude(
+				mixer->mix_frame.codec_frame.buffer,
+				mixer->sum,
+				own == TRUE ? mixer->frame_arr[i].codec_frame.buffer : NULL,
+				samples);
+			mixer->mix_frame.type |= MEDIA_FRAME_TYPE_AUDIO;
+		}
+		else {
+			memset(mixer->mix_frame.codec_frame.buffer,0,mixer->mix_frame.codec_frame.size);
+		}
+		mixer->sink_arr[i]->vtable->write_frame(mixer->sink_arr[i],&mixer->mix_frame);
+	}
+	return TRUE;
+}
+
+/* The frames are left in the jitter buffers, read on the next tick */
+static apt_bool_t mpf_mixer_n1_defer(mpf_object_t *object)
+{
+	mpf_mixer_n1_t *mixer = (mpf_mixer_n1_t*) object;
+	apr_size_t i;
+	for(i=0; i<mixer->count; i++) {
+		if(mixer->source_arr[i]) {
+			mpf_audio_stream_receive(mixer->source_arr[i]);
+		}
+	}
+	return TRUE;
+}
+
+static apt_bool_t mpf_mixer_n1_destroy(mpf_object_t *object)
+{
+	apr_size_t i;
+	mpf_mixer_n1_t *mixer = (mpf_mixer_n1_t*) object;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Destroy N-1 Mixer %s",object->name);
+	for(i=0; i<mixer->count; i++)	{
+		if(mixer->source_arr[i]) {
+			mpf_audio_stream_rx_close(mixer->source_arr[i]);
+		}
+		if(mixer->sink_arr[i]) {
+			mpf_audio_stream_tx_close(mixer->sink_arr[i]);
+		}
+		mpf_frame_pool_buffer_release(mixer->frame_pool,mixer->frame_arr[i].codec_frame.buffer);
+	}
+	mpf_frame_pool_buffer_release(mixer->frame_pool,mixer->mix_frame.codec_frame.buffer);
+	mpf_frame_pool_buffer_release(mixer->frame_pool,mixer->sum);
+	return TRUE;
+}
+
+static void mpf_mixer_n1_trace(mpf_object_t *object)
+{
+	mpf_mixer_n1_t *mixer = (mpf_mixer_n1_t*) object;
+	apr_size_t i;
+	char buf[2048];
+	apr_size_t offset;
+
+	apt_text_stream_t output;
+	apt_text_stream_init(&output,buf,sizeof(buf)-1);
+
+	for(i=0; i<mixer->count; i++)	{
+		if(mixer->source_arr[i]) {
+			mpf_audio_stream_trace(mixer->source_arr[i],STREAM_DIRECTION_RECEIVE,&output);
+			apt_text_char_insert(&output,';');
+		}
+	}
+
+	offset = output.pos - output.text.buf;
+	output.pos += apr_snprintf(output.pos, output.text.length - offset,
+		"->N-1 Mixer->");
+
+	for(i=0; i<mixer->count; i++)	{
+		if(mixer->sink_arr[i]) {
+			mpf_audio_stream_trace(mixer->sink_arr[i],STREAM_DIRECTION_SEND,&output);
+			apt_text_char_insert(&output,';');
+		}
+	}
+
+	*output.pos = '\0';
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Media Path %s %s",
+		object->name,
+		output.text.buf);
+}
+
+MPF_DECLARE(mpf_object_t*) mpf_mixer_n1_create(
+								mpf_audio_stream_t **stream_arr,
+								apr_size_t stream_count,
+								const mpf_codec_manager_t *codec_manager,
+								const char *name,
+								mpf_frame_pool_t *frame_pool,
+								apr_pool_t *pool)
+{
+	apr_size_t i;
+	apr_size_t frame_size = 0;
+	mpf_codec_descriptor_t *descriptor;
+	mpf_audio_stream_t *source;
+	mpf_audio_stream_t *sink;
+	mpf_mixer_n1_t *mixer;
+	if(!stream_arr || stream_count < 2) {
+		return NULL;
+	}
+
+	mixer = apr_palloc(pool,sizeof(mpf_mixer_n1_t));
+	mixer->source_arr = apr_pcalloc(pool,sizeof(mpf_audio_stream_t*) * stream_count);
+	mixer->sink_arr = apr_pcalloc(pool,sizeof(mpf_audio_stream_t*) * stream_count);
+	mixer->count = stream_count;
+	mixer->frame_pool = frame_pool;
+	mpf_object_init(&mixer->base,name);
+	mixer->base.process = mpf_mixer_n1_process;
+	mixer->base.destroy = mpf_mixer_n1_destroy;
+	mixer->base.trace = mpf_mixer_n1_trace;
+	mixer->base.defer = mpf_mixer_n1_defer;
+
+	for(i=0; i<stream_count; i++) {
+		source = stream_arr[i];
+		sink = stream_arr[i];
+		if(!source ||
+			mpf_audio_stream_rx_validate(source,NULL,NULL,pool) == FALSE ||
+			mpf_audio_stream_tx_validate(sink,NULL,NULL,pool) == FALSE) {
+			return NULL;
+		}
+
+		descriptor = source->rx_descriptor;
+		if(mpf_codec_lpcm_descriptor_match(descriptor) == FALSE) {
+			mpf_codec_t *codec = mpf_codec_manager_codec_get(codec_manager,descriptor,pool);
+			if(!codec) {
+				return NULL;
+			}
+			/* set decoder before mixer */
+			source = mpf_decoder_create(source,codec,pool);
+		}
+		descriptor = sink->tx_descriptor;
+		if(mpf_codec_lpcm_descriptor_match(descriptor) == FALSE) {
+			mpf_codec_t *codec = mpf_codec_manager_codec_get(codec_manager,descriptor,pool);
+			if(!codec) {
+				return NULL;
+			}
+			/* set encoder after mixer */
+			sink = mpf_encoder_create(sink,codec,pool);
+		}
+		if(!source || !sink) {
+			return NULL;
+		}
+
+		/* the sum is shared, so are sampling rate and channel count */
+		if(source->rx_descriptor->sampling_rate != sink->tx_descriptor->sampling_rate ||
+			source->rx_descriptor->channel_count != sink->tx_descriptor->channel_count ||
+			(i && mpf_codec_linear_frame_size_calculate(source->rx_descriptor->sampling_rate,
+				source->rx_descriptor->channel_count) != frame_size)) {
+			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Mismatch of Sampling Rates or Channels for N-1 Mixer %s",name);
+			return NULL;
+		}
+		frame_size = mpf_codec_linear_frame_size_calculate(
+			source->rx_descriptor->sampling_rate,
+			source->rx_descriptor->channel_count);
+		mixer->source_arr[i] = source;
+		mixer->sink_arr[i] = sink;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Create N-1 Mixer %s",name);
+	mixer->frame_arr = apr_palloc(pool,sizeof(mpf_frame_t) * stream_count);
+	for(i=0; i<stream_count; i++) {
+		mpf_audio_stream_rx_open(mixer->source_arr[i],NULL);
+		mpf_audio_stream_tx_open(mixer->sink_arr[i],NULL);
+		mixer->frame_arr[i].codec_frame.size = frame_size;
+		mixer->frame_arr[i].codec_frame.buffer = mpf_frame_pool_buffer_get(frame_pool,frame_size,pool);
+	}
 	mixer->mix_frame.codec_frame.size = frame_size;
-	mixer->mix_frame.codec_frame.buffer = apr_palloc(pool,frame_size);
+	mixer->mix_frame.codec_frame.buffer = mpf_frame_pool_buffer_get(frame_pool,frame_size,pool);
+	mixer->sum = mpf_frame_pool_buffer_get(frame_pool,frame_size / sizeof(apr_int16_t) * sizeof(apr_int32_t),pool);
 	return &mixer->base;
 }
@@ -24,6 +24,17 @@
 #include "apt_log.h"
 
 typedef struct mpf_multiplier_t mpf_multiplier_t;
+typedef struct mpf_multiplier_encoding_t mpf_multiplier_encoding_t;
+
+/** Encoded frame shared by the sinks negotiated with the same codec */
+struct mpf_multiplier_encoding_t {
+	/** Codec descriptor of the sinks */
+	const mpf_codec_descriptor_t *descriptor;
+	/** Codec (encoder) */
+	mpf_codec_t                  *codec;
+	/** Frame encoded once per tick */
+	mpf_frame_t                   frame;
+};
 
 /** MPF multiplier derived from MPF object */
 struct mpf_multiplier_t {
@@ -35,15 +46,22 @@ struct mpf_multiplier_t {
 	mpf_audio_stream_t **sink_arr;
 	/** Number of audio sinks */
 	apr_size_t           sink_count;
+	/** Shared encoding per sink (NULL if the sink takes linear frames) */
+	mpf_multiplier_encoding_t **encoding_arr;
+	/** Array of distinct encodings (mpf_multiplier_encoding_t*) */
+	apr_array_header_t  *encodings;
 
 	/** Media frame used to read data from source and write it to sinks */
 	mpf_frame_t          frame;
+	/** Pool the frame buffers are borrowed from */
+	mpf_frame_pool_t    *frame_pool;
 };
 
 static apt_bool_t mpf_multiplier_process(mpf_object_t *object)
 {
 	apr_size_t i;
 	mpf_audio_stream_t *sink;
+	mpf_multiplier_encoding_t *encoding;
 	mpf_multiplier_t *multiplier = (mpf_multiplier_t*) object;
 
 	multiplier->frame.type = MEDIA_FRAME_TYPE_NONE;
@@ -56,19 +74,41 @@ static apt_bool_t mpf_multiplier_process(mpf_object_t *object)
 				multiplier->frame.codec_frame.size);
 	}
 
+	/* encode the frame once per codec, not once per sink */
+	for(i=0; i<(apr_size_t)multiplier->encodings->nelts; i++) {
+		encoding = APR_ARRAY_IDX(multiplier->encodings,i,mpf_multiplier_encoding_t*);
+		encoding->frame.type = multiplier->frame.type;
+		encoding->frame.marker = multiplier->frame.marker;
+		if((multiplier->frame.type & MEDIA_FRAME_TYPE_EVENT) == MEDIA_FRAME_TYPE_EVENT) {
+			encoding->frame.event_frame = multiplier->frame.event_frame;
+		}
+		if((multiplier->frame.type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO) {
+			mpf_codec_encode(encoding->codec,&multiplier->frame.codec_frame,&encoding->frame.codec_frame);
+		}
+	}
+
 	for(i=0; i<multiplier->sink_count; i++)	{
 		sink = multiplier->sink_arr[i];
 		if(sink) {
-			sink->vtable->write_frame(sink,&multiplier->frame);
+			encoding = multiplier->encoding_arr[i];
+			sink->vtable->write_frame(sink,encoding ? &encoding->frame : &multiplier->frame);
 		}
 	}
 	return TRUE;
 }
 
+/* The frame is left in the jitter buffer, read on the next tick */
+static apt_bool_t mpf_multiplier_defer(mpf_object_t *object)
+{
+	mpf_multiplier_t *multiplier = (mpf_multiplier_t*) object;
+	return mpf_audio_stream_receive(multiplier->source);
+}
+
 static apt_bool_t mpf_multiplier_destroy(mpf_object_t *object)
 {
 	apr_size_t i;
 	mpf_audio_stream_t *sink;
+	mpf_multiplier_encoding_t *encoding;
 	mpf_multiplier_t *multiplier = (mpf_multiplier_t*) object;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Destroy Multiplier %s",object->name);
@@ -79,9 +119,17 @@ static apt_bool_t mpf_multiplier_destroy(mpf_object_t *object)
 			mpf_audio_stream_tx_close(sink);
 		}
 	}
+	for(i=0; i<(apr_size_t)multiplier->encodings->nelts; i++) {
+		encoding = APR_ARRAY_IDX(multiplier->encodings,i,mpf_multiplier_encoding_t*);
+		mpf_codec_close(encoding->codec);
+		mpf_frame_pool_buffer_release(multiplier->frame_pool,encoding->frame.codec_frame.buffer);
+	}
+	mpf_frame_pool_buffer_release(multiplier->frame_pool,multiplier->frame.codec_frame.buffer);
 	return TRUE;
 }
 
+static const apt_str_t shared_encoder_str = {"Encoder->", sizeof("Encoder->")-1};
+
 static void mpf_multiplier_trace(mpf_object_t *object)
 {
 	mpf_multiplier_t *multiplier = (mpf_multiplier_t*) object;
@@ -102,6 +150,9 @@ static void mpf_multiplier_trace(mpf_object_t *object)
 	for(i=0; i<multiplier->sink_count; i++)	{
 		sink = multiplier->sink_arr[i];
 		if(sink) {
+			if(multiplier->encoding_arr[i]) {
+				apt_text_string_insert(&output,&shared_encoder_str);
+			}
 			mpf_audio_stream_trace(sink,STREAM_DIRECTION_SEND,&output);
 			apt_text_char_insert(&output,';');
 		}
@@ -113,18 +164,56 @@ static void mpf_multiplier_trace(mpf_object_t *object)
 		output.text.buf);
 }
 
+/** Find the encoding shared by the sinks of the same codec or create a new one */
+static mpf_multiplier_encoding_t* mpf_multiplier_encoding_get(
+								mpf_multiplier_t *multiplier,
+								const mpf_codec_descriptor_t *descriptor,
+								const mpf_codec_manager_t *codec_manager,
+								apr_pool_t *pool)
+{
+	int i;
+	apr_size_t frame_size;
+	mpf_codec_t *codec;
+	mpf_multiplier_encoding_t *encoding;
+	for(i=0; i<multiplier->encodings->nelts; i++) {
+		encoding = APR_ARRAY_IDX(multiplier->encodings,i,mpf_multiplier_encoding_t*);
+		if(mpf_codec_descriptors_match(encoding->descriptor,descriptor) == TRUE &&
+			encoding->descriptor->sampling_rate == descriptor->sampling_rate &&
+			encoding->descriptor->channel_count == descriptor->channel_count) {
+			return encoding;
+		}
+	}
+
+	codec = mpf_codec_manager_codec_get(codec_manager,(mpf_codec_descriptor_t*)descriptor,pool);
+	if(!codec) {
+		return NULL;
+	}
+	mpf_codec_open(codec);
+
+	encoding = apr_palloc(pool,sizeof(mpf_multiplier_encoding_t));
+	encoding->descriptor = descriptor;
+	encoding->codec = codec;
+	frame_size = mpf_codec_frame_size_calculate(descriptor,codec->attribs);
+	encoding->frame.codec_frame.size = frame_size;
+	encoding->frame.codec_frame.buffer = mpf_frame_pool_buffer_get(multiplier->frame_pool,frame_size,pool);
+	APR_ARRAY_PUSH(multiplier->encodings,mpf_multiplier_encoding_t*) = encoding;
+	return encoding;
+}
+
 MPF_DECLARE(mpf_object_t*) mpf_multiplier_create(
 								mpf_audio_stream_t *source,
 								mpf_audio_stream_t **sink_arr,
 								apr_size_t sink_count,
 								const mpf_codec_manager_t *codec_manager,
 								const char *name,
+								mpf_frame_pool_t *frame_pool,
 								apr_pool_t *pool)
 {
 	apr_size_t i;
 	apr_size_t frame_size;
 	mpf_codec_descriptor_t *descriptor;
 	mpf_audio_stream_t *sink;
+	mpf_multiplier_encoding_t *encoding;
 	mpf_multiplier_t *multiplier;
 	if(!source || !sink_arr || !sink_count) {
 		return NULL;
@@ -135,10 +224,15 @@ MPF_DECLARE(mpf_object_t*) mpf_multiplier_create(
 	multiplier->source = NULL;
 	multiplier->sink_arr = NULL;
 	multiplier->sink_count = 0;
+	multiplier->encoding_arr = apr_pcalloc(pool,sizeof(mpf_multiplier_encoding_t*) * sink_count);
+	multiplier->encodings = apr_array_make(pool,1,sizeof(mpf_multiplier_encoding_t*));
+	multiplier->frame.codec_frame.buffer = NULL;
+	multiplier->frame_pool = frame_pool;
 	mpf_object_init(&multiplier->base,name);
 	multiplier->base.process = mpf_multiplier_process;
 	multiplier->base.destroy = mpf_multiplier_destroy;
 	multiplier->base.trace = mpf_multiplier_trace;
+	multiplier->base.defer = mpf_multiplier_defer;
 
 	if(mpf_audio_stream_rx_validate(source,NULL,NULL,pool) == FALSE) {
 		return NULL;
@@ -165,6 +259,18 @@ MPF_DECLARE(mpf_object_t*) mpf_multiplier_create(
 		}
 
 		descriptor = sink->tx_descriptor;
+		if(descriptor && mpf_codec_lpcm_descriptor_match(descriptor) == FALSE &&
+			descriptor->sampling_rate == source->rx_descriptor->sampling_rate &&
+			descriptor->channel_count == source->rx_descriptor->channel_count) {
+			/* share the encoded frame with the other sinks of the same codec */
+			encoding = mpf_multiplier_encoding_get(multiplier,descriptor,codec_manager,pool);
+			if(encoding) {
+				multiplier->encoding_arr[i] = encoding;
+				sink_arr[i] = sink;
+				mpf_audio_stream_tx_open(sink,encoding->codec);
+				continue;
+			}
+		}
 		if(descriptor && mpf_codec_lpcm_descriptor_match(descriptor) == FALSE) {
 			mpf_codec_t *codec = mpf_codec_manager_codec_get(codec_manager,descriptor,pool);
 			if(codec) {
@@ -173,6 +279,16 @@ MPF_DECLARE(mpf_object_t*) mpf_multiplier_create(
 				sink = encoder;
 			}
 		}
+
+		if(source->rx_descriptor->sampling_rate != sink->tx_descriptor->sampling_rate) {
+			/* set resampler after multiplier */
+			mpf_audio_stream_t *resampler = mpf_sink_resampler_create(source,sink,pool);
+			if(!resampler) {
+				sink_arr[i] = NULL;
+				continue;
+			}
+			sink = resampler;
+		}
 		sink_arr[i] = sink;
 		mpf_audio_stream_tx_open(sink,NULL);
 	}
@@ -182,6 +298,6 @@ MPF_DECLARE(mpf_object_t*) mpf_multiplier_create(
 	descriptor = source->rx_descriptor;
 	frame_size = mpf_codec_linear_frame_size_calculate(descriptor->sampling_rate,descriptor->channel_count);
 	multiplier->frame.codec_frame.size = frame_size;
-	multiplier->frame.codec_frame.buffer = apr_palloc(pool,frame_size);
+	multiplier->frame.codec_frame.buffer = mpf_frame_pool_buffer_get(frame_pool,frame_size,pool);
 	return &multiplier->base;
 }
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <string.h>
+#include "mpf_plc.h"
+
+/*
+ * The concealment follows the outline of G.711 Appendix I: the pitch period
+ * of the last received signal is estimated by autocorrelation, and the period
+ * is repeated for the lost frames. The repetition is played at full level
+ * for the first 10 msec, then faded out to silence within the next 50 msec.
+ * The first frame received after the loss is overlapped with the continued
+ * substitution to avoid a click.
+ */
+
+/* pitch search range 66 - 200 Hz */
+#define PLC_PITCH_MIN_HZ  200
+#define PLC_PITCH_MAX_HZ  66
+/* correlation window 20 msec */
+#define PLC_CORR_TIME     20
+/* time played at full level and time to fade out in msec */
+#define PLC_HOLD_TIME     10
+#define PLC_FADE_TIME     50
+
+struct mpf_plc_t {
+	/** Last received samples */
+	apr_int16_t *history;
+	apr_size_t   history_size;
+	/** Number of received samples in history (up to history_size) */
+	apr_size_t   history_count;
+
+	/** Pitch search range and correlation window in samples */
+	apr_size_t   pitch_min;
+	apr_size_t   pitch_max;
+	apr_size_t   corr_size;
+
+	/** Last pitch period with the wrap smoothed */
+	apr_int16_t *pitch_buf;
+	apr_size_t   pitch;
+	apr_size_t   pitch_pos;
+
+	/** Samples substituted within the current loss */
+	apr_size_t   lost_count;
+	apr_size_t   hold_size;
+	apr_size_t   fade_size;
+};
+
+MPF_DECLARE(mpf_plc_t*) mpf_plc_create(apr_uint16_t sampling_rate, apr_pool_t *pool)
+{
+	mpf_plc_t *plc = apr_palloc(pool,sizeof(mpf_plc_t));
+	plc->pitch_min = sampling_rate / PLC_PITCH_MIN_HZ;
+	plc->pitch_max = sampling_rate / PLC_PITCH_MAX_HZ;
+	plc->corr_size = sampling_rate * PLC_CORR_TIME / 1000;
+	plc->history_size = plc->pitch_max + plc->corr_size;
+	plc->history = apr_palloc(pool,plc->history_size * sizeof(apr_int16_t));
+	plc->history_count = 0;
+	plc->pitch_buf = apr_palloc(pool,plc->pitch_max * sizeof(apr_int16_t));
+	plc->pitch = 0;
+	plc->pitch_pos = 0;
+	plc->lost_count = 0;
+	plc->hold_size = sampling_rate * PLC_HOLD_TIME / 1000;
+	plc->fade_size = sampling_rate * PLC_FADE_TIME / 1000;
+	return plc;
+}
+
+/** Find the lag, which correlates the latest window with the history best */
+static apr_size_t mpf_plc_pitch_find(const mpf_plc_t *plc)
+{
+	const apr_int16_t *window = plc->history + plc->history_size - plc->corr_size;
+	const apr_int16_t *lagged;
+	apr_size_t lag;
+	apr_size_t i;
+	apr_size_t pitch = plc->pitch_min;
+	double score;
+	double best_score = 0;
+	for(lag = plc->pitch_min; lag <= plc->pitch_max; lag++) {
+		apr_int64_t corr = 0;
+		apr_int64_t energy = 0;
+		lagged = window - lag;
+		for(i=0; i<plc->corr_size; i++) {
+			corr += (apr_int32_t)window[i] * lagged[i];
+			energy += (apr_int32_t)lagged[i] * lagged[i];
+		}
+		if(corr <= 0 || !energy) {
+			continue;
+		}
+		/* normalized correlation squared, no sqrt needed to compare */
+		score = (double)corr * (double)corr / (double)energy;
+		if(score > best_score) {
+			best_score = score;
+			pitch = lag;
+		}
+	}
+	return pitch;
+}
+
+/** Set the pitch period buffer up at the beginning of a loss */
+static void mpf_plc_pitch_prepare(mpf_plc_t *plc)
+{
+	const apr_int16_t *end = plc->history + plc->history_size;
+	const apr_int16_t *tail;
+	const apr_int16_t *head;
+	apr_size_t overlap;
+	apr_size_t i;
+
+	plc->pitch = mpf_plc_pitch_find(plc);
+	plc->pitch_pos = 0;
+	memcpy(plc->pitch_buf,end - plc->pitch,plc->pitch * sizeof(apr_int16_t));
+
+	/* blend the tail of the period into the signal, which preceded its head */
+	overlap = plc->pitch / 4;
+	tail = end - overlap;
+	head = tail - plc->pitch;
+	for(i=0; i<overlap; i++) {
+		plc->pitch_buf[plc->pitch - overlap + i] = (apr_int16_t)(
+			((apr_int32_t)tail[i] * (apr_int32_t)(overlap - i) +
+			(apr_int32_t)head[i] * (apr_int32_t)(i + 1)) / (apr_int32_t)(overlap + 1));
+	}
+}
+
+/** Get the next substituted sample */
+static APR_INLINE apr_int16_t mpf_plc_sample_next(mpf_plc_t *plc)
+{
+	apr_int32_t sample = plc->pitch_buf[plc->pitch_pos];
+	if(++plc->pitch_pos == plc->pitch) {
+		plc->pitch_pos = 0;
+	}
+	if(plc->lost_count >= plc->hold_size) {
+		apr_size_t faded = plc->lost_count - plc->hold_size;
+		sample = (faded < plc->fade_size) ?
+			sample * (apr_int32_t)(plc->fade_size - faded) / (apr_int32_t)plc->fade_size : 0;
+	}
+	plc->lost_count++;
+	return (apr_int16_t)sample;
+}
+
+MPF_DECLARE(void) mpf_plc_receive(mpf_plc_t *plc, apr_int16_t *samples, apr_size_t count)
+{
+	apr_size_t i;
+	if(plc->lost_count) {
+		/* overlap the received signal with the continued substitution */
+		apr_size_t overlap = plc->pitch / 4;
+		if(overlap > count) {
+			overlap = count;
+		}
+		for(i=0; i<overlap; i++) {
+			apr_int32_t substituted = mpf_plc_sample_next(plc);
+			samples[i] = (apr_int16_t)((substituted * (apr_int32_t)(overlap - i) +
+				(apr_int32_t)samples[i] * (apr_int32_t)(i + 1)) / (apr_int32_t)(overlap + 1));
+		}
+		plc->lost_count = 0;
+	}
+
+	if(count >= plc->history_size) {
+		memcpy(plc->history,samples + count - plc->history_size,plc->history_size * sizeof(apr_int16_t));
+		plc->history_count = plc->history_size;
+	}
+	else {
+		memmove(plc->history,plc->history + count,(plc->history_size - count) * sizeof(apr_int16_t));
+		memcpy(plc->history + plc->history_size - count,samples,count * sizeof(apr_int16_t));
+		plc->history_count += count;
+		if(plc->history_count > plc->history_size) {
+			plc->history_count = plc->history_size;
+		}
+	}
+}
+
+MPF_DECLARE(apt_bool_t) mpf_plc_conceal(mpf_plc_t *plc, apr_int16_t *samples, apr_size_t count)
+{
+	apr_size_t i;
+	if(plc->history_count < plc->history_size) {
+		/* not enough signal received to estimate the pitch */
+		return FALSE;
+	}
+	if(!plc->lost_count) {
+		mpf_plc_pitch_prepare(plc);
+	}
+	else if(plc->lost_count >= plc->hold_size + plc->fade_size) {
+		/* faded out */
+		return FALSE;
+	}
+
+	for(i=0; i<count; i++) {
+		samples[i] = mpf_plc_sample_next(plc);
+	}
+	return TRUE;
+}
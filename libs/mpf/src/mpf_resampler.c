@@ -16,13 +16,390 @@
  * $Id$
  */
 
+#include <math.h>
 #include "mpf_resampler.h"
+#include "mpf_codec_descriptor.h"
 #include "apt_log.h"
 
+/** Max interpolation/decimation factor (8 kHz <-> 48 kHz) */
+#define MPF_RESAMPLER_MAX_FACTOR     6
+/** Number of zero crossings of the windowed sinc on each side */
+#define MPF_RESAMPLER_ZERO_CROSSINGS 8
+/** Cutoff frequency relative to the Nyquist frequency of the lower rate */
+#define MPF_RESAMPLER_CUTOFF         0.92
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef struct mpf_resampler_t mpf_resampler_t;
+
+/** Polyphase resampler converting one frame at a time, the state is kept across frames */
+struct mpf_resampler_t {
+	mpf_audio_stream_t *base;
+	/** Source stream (read side) or sink stream (write side) */
+	mpf_audio_stream_t *stream;
+	/** Interpolation factor */
+	apr_size_t          up;
+	/** Decimation factor */
+	apr_size_t          down;
+	/** Number of taps per phase (multiple of 4) */
+	apr_size_t          taps;
+	/** Time reversed coefficients of each phase [up][taps] */
+	float              *coeffs;
+	/** History of (taps-1) input samples followed by the current input frame */
+	float              *samples;
+	/** Number of samples per input frame */
+	apr_size_t          in_samples;
+	/** Number of samples per output frame */
+	apr_size_t          out_samples;
+	/** Whether the history holds audio (reset on silence) */
+	apt_bool_t          active;
+	/** Frame at the rate of the wrapped stream */
+	mpf_frame_t         frame;
+};
+
+static apr_size_t mpf_gcd(apr_size_t a, apr_size_t b)
+{
+	while(b) {
+		apr_size_t r = a % b;
+		a = b;
+		b = r;
+	}
+	return a;
+}
+
+static apt_bool_t mpf_resampler_init(mpf_resampler_t *resampler, apr_uint16_t in_rate, apr_uint16_t out_rate, apr_pool_t *pool)
+{
+	apr_size_t gcd = mpf_gcd(in_rate,out_rate);
+	apr_size_t factor;
+	apr_size_t length;
+	apr_size_t p;
+	apr_size_t k;
+	double cutoff;
+	double center;
+
+	resampler->up = out_rate / gcd;
+	resampler->down = in_rate / gcd;
+	if(resampler->up > MPF_RESAMPLER_MAX_FACTOR || resampler->down > MPF_RESAMPLER_MAX_FACTOR) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Not Supported Resampling Ratio [%d -> %d]",in_rate,out_rate);
+		return FALSE;
+	}
+
+	resampler->in_samples = mpf_codec_linear_frame_size_calculate(in_rate,1) / sizeof(apr_int16_t);
+	resampler->out_samples = mpf_codec_linear_frame_size_calculate(out_rate,1) / sizeof(apr_int16_t);
+	if(resampler->in_samples * resampler->up != resampler->out_samples * resampler->down) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Not Supported Resampling Frame [%"APR_SIZE_T_FMT" -> %"APR_SIZE_T_FMT" samples]",
+			resampler->in_samples,resampler->out_samples);
+		return FALSE;
+	}
+
+	/* lowpass prototype at the interpolated rate, cut below the lower Nyquist frequency */
+	factor = resampler->up > resampler->down ? resampler->up : resampler->down;
+	resampler->taps = (2 * MPF_RESAMPLER_ZERO_CROSSINGS * factor + resampler->up - 1) / resampler->up;
+	resampler->taps = (resampler->taps + 3) & ~((apr_size_t)3);
+	length = resampler->taps * resampler->up;
+	cutoff = MPF_RESAMPLER_CUTOFF * 0.5 / factor;
+	center = (length - 1) / 2.0;
+
+	resampler->coeffs = apr_palloc(pool,length * sizeof(float));
+	for(p=0; p<resampler->up; p++) {
+		for(k=0; k<resampler->taps; k++) {
+			apr_size_t j = p + k * resampler->up;
+			double x = j - center;
+			double sinc = x == 0 ? 1.0 : sin(2 * M_PI * cutoff * x) / (2 * M_PI * cutoff * x);
+			double window = 0.42 - 0.5 * cos(2 * M_PI * j / (length - 1)) + 0.08 * cos(4 * M_PI * j / (length - 1));
+			resampler->coeffs[p * resampler->taps + resampler->taps - 1 - k] = 
+				(float)(resampler->up * 2 * cutoff * sinc * window);
+		}
+	}
+
+	resampler->samples = apr_pcalloc(pool,(resampler->taps - 1 + resampler->in_samples) * sizeof(float));
+	resampler->active = FALSE;
+	return TRUE;
+}
+
+static void mpf_resampler_frame_process(mpf_resampler_t *resampler, const apr_int16_t *in, apr_int16_t *out)
+{
+	apr_size_t n;
+	apr_size_t k;
+	apr_size_t taps = resampler->taps;
+	float *samples = resampler->samples;
+	float *frame = samples + taps - 1;
+
+	for(n=0; n<resampler->in_samples; n++) {
+		frame[n] = in[n];
+	}
+
+	for(n=0; n<resampler->out_samples; n++) {
+		apr_size_t t = n * resampler->down;
+		const float *coeffs = resampler->coeffs + (t % resampler->up) * taps;
+		const float *x = samples + t / resampler->up;
+		/* four independent sums let the compiler vectorize the dot product (SSE/NEON) */
+		float acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+		float value;
+		for(k=0; k<taps; k+=4) {
+			acc0 += coeffs[k] * x[k];
+			acc1 += coeffs[k+1] * x[k+1];
+			acc2 += coeffs[k+2] * x[k+2];
+			acc3 += coeffs[k+3] * x[k+3];
+		}
+		value = acc0 + acc1 + acc2 + acc3;
+		if(value > 32767.0f) {
+			out[n] = 32767;
+		}
+		else if(value < -32768.0f) {
+			out[n] = -32768;
+		}
+		else {
+			out[n] = (apr_int16_t)(value >= 0 ? value + 0.5f : value - 0.5f);
+		}
+	}
+
+	/* keep the tail of the input as the history of the next frame */
+	memmove(samples,samples + resampler->in_samples,(taps - 1) * sizeof(float));
+	resampler->active = TRUE;
+}
+
+static void mpf_resampler_reset(mpf_resampler_t *resampler)
+{
+	if(resampler->active == TRUE) {
+		memset(resampler->samples,0,(resampler->taps - 1) * sizeof(float));
+		resampler->active = FALSE;
+	}
+}
+
+static mpf_resampler_t* mpf_resampler_alloc(
+							mpf_audio_stream_t *stream,
+							const mpf_audio_stream_vtable_t *vtable,
+							mpf_stream_direction_e direction,
+							const mpf_codec_descriptor_t *in_descriptor,
+							const mpf_codec_descriptor_t *out_descriptor,
+							apr_size_t frame_size,
+							apr_pool_t *pool)
+{
+	mpf_resampler_t *resampler;
+	mpf_stream_capabilities_t *capabilities;
+	if(mpf_codec_lpcm_descriptor_match(in_descriptor) == FALSE || mpf_codec_lpcm_descriptor_match(out_descriptor) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Resample Non-Linear Stream [%s -> %s]",
+			in_descriptor->name.buf,
+			out_descriptor->name.buf);
+		return NULL;
+	}
+	if(in_descriptor->channel_count != 1 || out_descriptor->channel_count != 1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Resample Multichannel Stream");
+		return NULL;
+	}
+
+	resampler = apr_palloc(pool,sizeof(mpf_resampler_t));
+	if(mpf_resampler_init(resampler,in_descriptor->sampling_rate,out_descriptor->sampling_rate,pool) == FALSE) {
+		return NULL;
+	}
+
+	capabilities = mpf_stream_capabilities_create(direction,pool);
+	resampler->base = mpf_audio_stream_create(resampler,vtable,capabilities,pool);
+	if(!resampler->base) {
+		return NULL;
+	}
+	resampler->stream = stream;
+	resampler->frame.type = MEDIA_FRAME_TYPE_NONE;
+	resampler->frame.marker = MPF_MARKER_NONE;
+	resampler->frame.codec_frame.size = frame_size;
+	resampler->frame.codec_frame.buffer = apr_pcalloc(pool,frame_size);
+	return resampler;
+}
+
+static void mpf_resampler_trace_descriptor(const mpf_codec_descriptor_t *descriptor, apt_text_stream_t *output)
+{
+	if(descriptor) {
+		apr_size_t offset = output->pos - output->text.buf;
+		output->pos += apr_snprintf(output->pos, output->text.length - offset,
+			"->Resampler->[%s/%d/%d]",
+			descriptor->name.buf,
+			descriptor->sampling_rate,
+			descriptor->channel_count);
+	}
+}
+
+
+static apt_bool_t mpf_resampler_destroy(mpf_audio_stream_t *stream)
+{
+	mpf_resampler_t *resampler = stream->obj;
+	return mpf_audio_stream_destroy(resampler->stream);
+}
+
+static apt_bool_t mpf_resampler_rx_open(mpf_audio_stream_t *stream, mpf_codec_t *codec)
+{
+	mpf_resampler_t *resampler = stream->obj;
+	return mpf_audio_stream_rx_open(resampler->stream,codec);
+}
+
+static apt_bool_t mpf_resampler_rx_close(mpf_audio_stream_t *stream)
+{
+	mpf_resampler_t *resampler = stream->obj;
+	return mpf_audio_stream_rx_close(resampler->stream);
+}
+
+static apt_bool_t mpf_resampler_read(mpf_audio_stream_t *stream, mpf_frame_t *frame)
+{
+	mpf_resampler_t *resampler = stream->obj;
+	resampler->frame.type = MEDIA_FRAME_TYPE_NONE;
+	resampler->frame.marker = MPF_MARKER_NONE;
+	if(mpf_audio_stream_frame_read(resampler->stream,&resampler->frame) != TRUE) {
+		return FALSE;
+	}
+
+	frame->type = resampler->frame.type;
+	frame->marker = resampler->frame.marker;
+	if((frame->type & MEDIA_FRAME_TYPE_EVENT) == MEDIA_FRAME_TYPE_EVENT) {
+		frame->event_frame = resampler->frame.event_frame;
+	}
+	if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO) {
+		mpf_resampler_frame_process(resampler,resampler->frame.codec_frame.buffer,frame->codec_frame.buffer);
+	}
+	else {
+		mpf_resampler_reset(resampler);
+	}
+	return TRUE;
+}
+
+static void mpf_resampler_rx_trace(mpf_audio_stream_t *stream, mpf_stream_direction_e direction, apt_text_stream_t *output)
+{
+	mpf_resampler_t *resampler = stream->obj;
+	mpf_audio_stream_trace(resampler->stream,direction,output);
+	mpf_resampler_trace_descriptor(resampler->base->rx_descriptor,output);
+}
+
+static apt_bool_t mpf_resampler_receive(mpf_audio_stream_t *stream)
+{
+	mpf_resampler_t *resampler = stream->obj;
+	return mpf_audio_stream_receive(resampler->stream);
+}
+
+static const mpf_audio_stream_vtable_t rx_vtable = {
+	mpf_resampler_destroy,
+	mpf_resampler_rx_open,
+	mpf_resampler_rx_close,
+	mpf_resampler_read,
+	NULL,
+	NULL,
+	NULL,
+	mpf_resampler_rx_trace,
+	NULL,
+	mpf_resampler_receive
+};
+
 MPF_DECLARE(mpf_audio_stream_t*) mpf_resampler_create(mpf_audio_stream_t *source, mpf_audio_stream_t *sink, apr_pool_t *pool)
 {
-	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,
-		"Currently resampling is not supported. "
-		"Try to configure and use the same sampling rate on both ends");
-	return NULL;
+	mpf_resampler_t *resampler;
+	const mpf_codec_descriptor_t *descriptor;
+	if(!source || !sink || !source->rx_descriptor || !sink->tx_descriptor) {
+		return NULL;
+	}
+
+	descriptor = source->rx_descriptor;
+	resampler = mpf_resampler_alloc(
+					source,
+					&rx_vtable,
+					STREAM_DIRECTION_RECEIVE,
+					descriptor,
+					sink->tx_descriptor,
+					mpf_codec_linear_frame_size_calculate(descriptor->sampling_rate,descriptor->channel_count),
+					pool);
+	if(!resampler) {
+		return NULL;
+	}
+
+	resampler->base->rx_descriptor = mpf_codec_lpcm_descriptor_create(
+		sink->tx_descriptor->sampling_rate,
+		descriptor->channel_count,
+		pool);
+	resampler->base->rx_event_descriptor = source->rx_event_descriptor;
+	return resampler->base;
+}
+
+
+static apt_bool_t mpf_resampler_tx_open(mpf_audio_stream_t *stream, mpf_codec_t *codec)
+{
+	mpf_resampler_t *resampler = stream->obj;
+	return mpf_audio_stream_tx_open(resampler->stream,codec);
+}
+
+static apt_bool_t mpf_resampler_tx_close(mpf_audio_stream_t *stream)
+{
+	mpf_resampler_t *resampler = stream->obj;
+	return mpf_audio_stream_tx_close(resampler->stream);
+}
+
+static apt_bool_t mpf_resampler_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame)
+{
+	mpf_resampler_t *resampler = stream->obj;
+
+	resampler->frame.type = frame->type;
+	resampler->frame.marker = frame->marker;
+	if((frame->type & MEDIA_FRAME_TYPE_EVENT) == MEDIA_FRAME_TYPE_EVENT) {
+		resampler->frame.event_frame = frame->event_frame;
+	}
+	if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO) {
+		mpf_resampler_frame_process(resampler,frame->codec_frame.buffer,resampler->frame.codec_frame.buffer);
+	}
+	else {
+		mpf_resampler_reset(resampler);
+	}
+	return mpf_audio_stream_frame_write(resampler->stream,&resampler->frame);
+}
+
+static void mpf_resampler_tx_trace(mpf_audio_stream_t *stream, mpf_stream_direction_e direction, apt_text_stream_t *output)
+{
+	mpf_resampler_t *resampler = stream->obj;
+	const mpf_codec_descriptor_t *descriptor = resampler->base->tx_descriptor;
+	if(descriptor) {
+		apr_size_t offset = output->pos - output->text.buf;
+		output->pos += apr_snprintf(output->pos, output->text.length - offset,
+			"[%s/%d/%d]->Resampler->",
+			descriptor->name.buf,
+			descriptor->sampling_rate,
+			descriptor->channel_count);
+	}
+	mpf_audio_stream_trace(resampler->stream,direction,output);
+}
+
+static const mpf_audio_stream_vtable_t tx_vtable = {
+	mpf_resampler_destroy,
+	NULL,
+	NULL,
+	NULL,
+	mpf_resampler_tx_open,
+	mpf_resampler_tx_close,
+	mpf_resampler_write,
+	mpf_resampler_tx_trace
+};
+
+MPF_DECLARE(mpf_audio_stream_t*) mpf_sink_resampler_create(mpf_audio_stream_t *source, mpf_audio_stream_t *sink, apr_pool_t *pool)
+{
+	mpf_resampler_t *resampler;
+	const mpf_codec_descriptor_t *descriptor;
+	if(!source || !sink || !source->rx_descriptor || !sink->tx_descriptor) {
+		return NULL;
+	}
+
+	descriptor = sink->tx_descriptor;
+	resampler = mpf_resampler_alloc(
+					sink,
+					&tx_vtable,
+					STREAM_DIRECTION_SEND,
+					source->rx_descriptor,
+					descriptor,
+					mpf_codec_linear_frame_size_calculate(descriptor->sampling_rate,descriptor->channel_count),
+					pool);
+	if(!resampler) {
+		return NULL;
+	}
+
+	resampler->base->tx_descriptor = mpf_codec_lpcm_descriptor_create(
+		source->rx_descriptor->sampling_rate,
+		descriptor->channel_count,
+		pool);
+	resampler->base->tx_event_descriptor = sink->tx_event_descriptor;
+	return resampler->base;
 }
@@ -0,0 +1,255 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <apr_atomic.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#include "mpf_rtcp_agent.h"
+#include "apt_clock.h"
+#include "apt_log.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+/* nice value of the thread of the agent */
+#define MPF_RTCP_AGENT_NICE 10
+#endif
+
+struct mpf_rtcp_agent_entry_t {
+	/* object to pass to the handlers */
+	void                   *obj;
+	/* handler of transmission */
+	mpf_rtcp_agent_proc_f   tx_proc;
+	/* interval of transmission */
+	apr_interval_time_t     tx_interval;
+	/* time of the next transmission */
+	apr_time_t              tx_time;
+	/* handler of reception */
+	mpf_rtcp_agent_proc_f   rx_proc;
+	/* interval of reception */
+	apr_interval_time_t     rx_interval;
+	/* time of the next reception */
+	apr_time_t              rx_time;
+
+	mpf_rtcp_agent_entry_t *prev;
+	mpf_rtcp_agent_entry_t *next;
+};
+
+struct mpf_rtcp_agent_t {
+	apr_pool_t             *pool;
+	apr_thread_t           *thread;
+	/* held while the list is changed or a handler is called */
+	apr_thread_mutex_t     *guard;
+	/* signaled to stop the thread */
+	apr_thread_cond_t      *wakeup;
+	volatile apr_uint32_t   running;
+
+	/* entries checked by the thread */
+	mpf_rtcp_agent_entry_t *head;
+	/* next entry to check, the list may change between the checks */
+	mpf_rtcp_agent_entry_t *cursor;
+	/* removed entries to reuse */
+	mpf_rtcp_agent_entry_t *free_list;
+	apr_size_t              count;
+};
+
+MPF_DECLARE(mpf_rtcp_agent_t*) mpf_rtcp_agent_create(apr_pool_t *pool)
+{
+	mpf_rtcp_agent_t *agent = apr_palloc(pool,sizeof(mpf_rtcp_agent_t));
+	agent->pool = pool;
+	agent->thread = NULL;
+	agent->guard = NULL;
+	agent->wakeup = NULL;
+	agent->running = 0;
+	agent->head = NULL;
+	agent->cursor = NULL;
+	agent->free_list = NULL;
+	agent->count = 0;
+	if(apr_thread_mutex_create(&agent->guard,APR_THREAD_MUTEX_UNNESTED,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	if(apr_thread_cond_create(&agent->wakeup,pool) != APR_SUCCESS) {
+		apr_thread_mutex_destroy(agent->guard);
+		return NULL;
+	}
+	return agent;
+}
+
+MPF_DECLARE(void) mpf_rtcp_agent_destroy(mpf_rtcp_agent_t *agent)
+{
+	mpf_rtcp_agent_stop(agent);
+	apr_thread_cond_destroy(agent->wakeup);
+	apr_thread_mutex_destroy(agent->guard);
+}
+
+/** Call the handlers of the entry, which are due */
+static APR_INLINE void mpf_rtcp_agent_entry_process(mpf_rtcp_agent_entry_t *entry, apr_time_t now)
+{
+	if(entry->tx_proc && now >= entry->tx_time) {
+		if(entry->tx_proc(entry->obj) == TRUE) {
+			entry->tx_time = now + entry->tx_interval;
+		}
+	}
+	if(entry->rx_proc && now >= entry->rx_time) {
+		if(entry->rx_proc(entry->obj) == TRUE) {
+			entry->rx_time = now + entry->rx_interval;
+		}
+	}
+}
+
+static void* APR_THREAD_FUNC mpf_rtcp_agent_run(apr_thread_t *thread, void *data)
+{
+	mpf_rtcp_agent_t *agent = data;
+	mpf_rtcp_agent_entry_t *entry;
+	apr_time_t now;
+
+#ifdef __linux__
+	/* threads have nice values of their own on Linux */
+	if(setpriority(PRIO_PROCESS,(id_t)syscall(SYS_gettid),MPF_RTCP_AGENT_NICE) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Failed to Lower Priority of RTCP Agent");
+	}
+#endif
+
+	apr_thread_mutex_lock(agent->guard);
+	while(apr_atomic_read32(&agent->running)) {
+		now = apt_clock_now();
+		/* the guard is released between the entries, so that
+		an entry is added or removed with no wait for the whole walk */
+		agent->cursor = agent->head;
+		while(agent->cursor) {
+			entry = agent->cursor;
+			agent->cursor = entry->next;
+			mpf_rtcp_agent_entry_process(entry,now);
+			apr_thread_mutex_unlock(agent->guard);
+			apr_thread_mutex_lock(agent->guard);
+		}
+
+		if(apr_atomic_read32(&agent->running)) {
+			apr_thread_cond_timedwait(agent->wakeup,agent->guard,
+				apt_clock_wait_timeout_get(MPF_RTCP_AGENT_RESOLUTION * 1000));
+		}
+	}
+	apr_thread_mutex_unlock(agent->guard);
+
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_rtcp_agent_start(mpf_rtcp_agent_t *agent)
+{
+	if(agent->thread) {
+		return FALSE;
+	}
+	apr_atomic_set32(&agent->running,1);
+	if(apr_thread_create(&agent->thread,NULL,mpf_rtcp_agent_run,agent,agent->pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Thread of RTCP Agent");
+		apr_atomic_set32(&agent->running,0);
+		agent->thread = NULL;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_rtcp_agent_stop(mpf_rtcp_agent_t *agent)
+{
+	apr_status_t rv;
+	if(!agent->thread) {
+		return FALSE;
+	}
+	apr_thread_mutex_lock(agent->guard);
+	apr_atomic_set32(&agent->running,0);
+	apr_thread_cond_signal(agent->wakeup);
+	apr_thread_mutex_unlock(agent->guard);
+
+	apr_thread_join(&rv,agent->thread);
+	agent->thread = NULL;
+	return TRUE;
+}
+
+MPF_DECLARE(mpf_rtcp_agent_entry_t*) mpf_rtcp_agent_entry_add(
+								mpf_rtcp_agent_t *agent,
+								void *obj,
+								mpf_rtcp_agent_proc_f tx_proc,
+								apr_uint32_t tx_interval,
+								mpf_rtcp_agent_proc_f rx_proc,
+								apr_uint32_t rx_interval)
+{
+	mpf_rtcp_agent_entry_t *entry;
+	apr_time_t now = apt_clock_now();
+
+	apr_thread_mutex_lock(agent->guard);
+	entry = agent->free_list;
+	if(entry) {
+		agent->free_list = entry->next;
+	}
+	else {
+		entry = apr_palloc(agent->pool,sizeof(mpf_rtcp_agent_entry_t));
+	}
+	entry->obj = obj;
+	entry->tx_proc = tx_proc;
+	entry->tx_interval = (apr_interval_time_t)tx_interval * 1000;
+	entry->tx_time = now + entry->tx_interval;
+	entry->rx_proc = rx_proc;
+	entry->rx_interval = (apr_interval_time_t)rx_interval * 1000;
+	entry->rx_time = now + entry->rx_interval;
+
+	entry->prev = NULL;
+	entry->next = agent->head;
+	if(agent->head) {
+		agent->head->prev = entry;
+	}
+	agent->head = entry;
+	agent->count++;
+	apr_thread_mutex_unlock(agent->guard);
+	return entry;
+}
+
+MPF_DECLARE(void) mpf_rtcp_agent_entry_remove(mpf_rtcp_agent_t *agent, mpf_rtcp_agent_entry_t *entry)
+{
+	apr_thread_mutex_lock(agent->guard);
+	if(agent->cursor == entry) {
+		agent->cursor = entry->next;
+	}
+	if(entry->prev) {
+		entry->prev->next = entry->next;
+	}
+	else {
+		agent->head = entry->next;
+	}
+	if(entry->next) {
+		entry->next->prev = entry->prev;
+	}
+	entry->obj = NULL;
+	entry->prev = NULL;
+	entry->next = agent->free_list;
+	agent->free_list = entry;
+	agent->count--;
+	apr_thread_mutex_unlock(agent->guard);
+}
+
+MPF_DECLARE(apr_size_t) mpf_rtcp_agent_entry_count_get(const mpf_rtcp_agent_t *agent)
+{
+	return agent->count;
+}
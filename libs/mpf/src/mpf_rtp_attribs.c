@@ -26,7 +26,9 @@ static const apt_str_table_item_t mpf_rtp_attrib_table[] = {
 	{{"recvonly", 8},2},
 	{{"sendrecv", 8},4},
 	{{"mid",      3},0},
-	{{"ptime",    5},0}
+	{{"ptime",    5},0},
+	{{"rtcp-mux", 8},3},
+	{{"crypto",   6},0}
 };
 
 
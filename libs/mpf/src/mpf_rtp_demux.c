@@ -0,0 +1,358 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+#include <apr_hash.h>
+#include "mpf_rtp_demux.h"
+#include "mpf_codec_descriptor.h"
+#include "apt_log.h"
+
+/** Max size of RTP/RTCP packet */
+#define MAX_RTP_PACKET_SIZE      1500
+/** Max number of packets drained from a socket at once */
+#define MPF_RTP_DEMUX_DRAIN_MAX  4096
+/** Max size of address key (IPv6 address + port) */
+#define MPF_RTP_DEMUX_KEY_SIZE   18
+
+/** Route of incoming packets */
+typedef struct mpf_rtp_route_t mpf_rtp_route_t;
+struct mpf_rtp_route_t {
+	/** Object to route packets to */
+	void                   *obj;
+	/** Packet handler */
+	mpf_rtp_demux_handler_f handler;
+	/** Remote RTP address (key in address table) */
+	unsigned char           addr_key[MPF_RTP_DEMUX_KEY_SIZE];
+	/** Length of address key (0 if not registered) */
+	apr_size_t              addr_key_len;
+	/** Remote SSRC (key in SSRC table) */
+	apr_uint32_t            ssrc;
+	/** Whether remote SSRC is learnt and registered */
+	apt_bool_t              ssrc_learnt;
+	/** Next route in the list of free routes */
+	mpf_rtp_route_t        *next;
+};
+
+/** RTP demultiplexer */
+struct mpf_rtp_demux_t {
+	apr_pool_t      *pool;
+
+	apr_socket_t    *rtp_socket;
+	apr_sockaddr_t  *rtp_sockaddr;
+	apr_socket_t    *rtcp_socket;
+	apr_sockaddr_t  *rtcp_sockaddr;
+	/** Source address of the last received packet */
+	apr_sockaddr_t  *from;
+
+	/** Table of routes by object */
+	apr_hash_t      *obj_table;
+	/** Table of routes by remote RTP address */
+	apr_hash_t      *addr_table;
+	/** Table of routes by remote SSRC */
+	apr_hash_t      *ssrc_table;
+	/** List of free routes to reuse */
+	mpf_rtp_route_t *free_routes;
+
+	/** Time the sockets were drained last */
+	apr_time_t       drain_time;
+	/** Number of packets matched no route */
+	apr_uint32_t     unrouted_packets;
+};
+
+static apr_socket_t* mpf_rtp_demux_socket_create(const char *ip, apr_port_t port, apr_sockaddr_t **l_sockaddr, apr_pool_t *pool)
+{
+	apr_socket_t *socket = NULL;
+	*l_sockaddr = NULL;
+	apr_sockaddr_info_get(l_sockaddr,ip,APR_INET,port,0,pool);
+	if(!*l_sockaddr) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Get Sockaddr %s:%hu",ip,port);
+		return NULL;
+	}
+	if(apr_socket_create(&socket,APR_INET,SOCK_DGRAM,0,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Socket");
+		return NULL;
+	}
+
+	apr_socket_opt_set(socket,APR_SO_NONBLOCK,1);
+	apr_socket_timeout_set(socket,0);
+	if(apr_socket_bind(socket,*l_sockaddr) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Bind Socket to %s:%hu",ip,port);
+		apr_socket_close(socket);
+		return NULL;
+	}
+	return socket;
+}
+
+MPF_DECLARE(mpf_rtp_demux_t*) mpf_rtp_demux_create(const apt_str_t *ip, apr_port_t port, apt_bool_t rtcp, apr_pool_t *pool)
+{
+	mpf_rtp_demux_t *demux = apr_palloc(pool,sizeof(mpf_rtp_demux_t));
+	demux->pool = pool;
+	demux->rtp_sockaddr = NULL;
+	demux->rtcp_socket = NULL;
+	demux->rtcp_sockaddr = NULL;
+	demux->rtp_socket = mpf_rtp_demux_socket_create(ip->buf,port,&demux->rtp_sockaddr,pool);
+	if(!demux->rtp_socket) {
+		return NULL;
+	}
+	if(rtcp == TRUE) {
+		demux->rtcp_socket = mpf_rtp_demux_socket_create(ip->buf,port+1,&demux->rtcp_sockaddr,pool);
+		if(!demux->rtcp_socket) {
+			apr_socket_close(demux->rtp_socket);
+			return NULL;
+		}
+	}
+
+	demux->from = apr_pcalloc(pool,sizeof(apr_sockaddr_t));
+	demux->from->pool = pool;
+	demux->obj_table = apr_hash_make(pool);
+	demux->addr_table = apr_hash_make(pool);
+	demux->ssrc_table = apr_hash_make(pool);
+	demux->free_routes = NULL;
+	demux->drain_time = 0;
+	demux->unrouted_packets = 0;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Create RTP Demultiplexer %s:%hu rtcp-mux only [%s]",
+		ip->buf,port,rtcp == TRUE ? "no" : "yes");
+	return demux;
+}
+
+MPF_DECLARE(void) mpf_rtp_demux_destroy(mpf_rtp_demux_t *demux)
+{
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Destroy RTP Demultiplexer %s:%hu unrouted packets [%u]",
+		demux->rtp_sockaddr->hostname,
+		demux->rtp_sockaddr->port,
+		demux->unrouted_packets);
+	if(demux->rtp_socket) {
+		apr_socket_close(demux->rtp_socket);
+		demux->rtp_socket = NULL;
+	}
+	if(demux->rtcp_socket) {
+		apr_socket_close(demux->rtcp_socket);
+		demux->rtcp_socket = NULL;
+	}
+}
+
+MPF_DECLARE(apr_socket_t*) mpf_rtp_demux_rtp_socket_get(const mpf_rtp_demux_t *demux)
+{
+	return demux->rtp_socket;
+}
+
+MPF_DECLARE(apr_sockaddr_t*) mpf_rtp_demux_rtp_sockaddr_get(const mpf_rtp_demux_t *demux)
+{
+	return demux->rtp_sockaddr;
+}
+
+MPF_DECLARE(apr_socket_t*) mpf_rtp_demux_rtcp_socket_get(const mpf_rtp_demux_t *demux)
+{
+	return demux->rtcp_socket;
+}
+
+MPF_DECLARE(apr_sockaddr_t*) mpf_rtp_demux_rtcp_sockaddr_get(const mpf_rtp_demux_t *demux)
+{
+	return demux->rtcp_sockaddr;
+}
+
+static APR_INLINE apr_size_t mpf_rtp_demux_addr_key_get(const apr_sockaddr_t *sockaddr, apr_port_t port, unsigned char *key)
+{
+	apr_size_t length = (apr_size_t)sockaddr->ipaddr_len;
+	if(!sockaddr->ipaddr_ptr || length + 2 > MPF_RTP_DEMUX_KEY_SIZE) {
+		return 0;
+	}
+	memcpy(key,sockaddr->ipaddr_ptr,length);
+	key[length++] = (unsigned char)(port >> 8);
+	key[length++] = (unsigned char)(port & 0xFF);
+	return length;
+}
+
+static void mpf_rtp_demux_addr_unregister(mpf_rtp_demux_t *demux, mpf_rtp_route_t *route)
+{
+	if(route->addr_key_len) {
+		if(apr_hash_get(demux->addr_table,route->addr_key,route->addr_key_len) == route) {
+			apr_hash_set(demux->addr_table,route->addr_key,route->addr_key_len,NULL);
+		}
+		route->addr_key_len = 0;
+	}
+}
+
+static void mpf_rtp_demux_ssrc_unregister(mpf_rtp_demux_t *demux, mpf_rtp_route_t *route)
+{
+	if(route->ssrc_learnt == TRUE) {
+		if(apr_hash_get(demux->ssrc_table,&route->ssrc,sizeof(route->ssrc)) == route) {
+			apr_hash_set(demux->ssrc_table,&route->ssrc,sizeof(route->ssrc),NULL);
+		}
+		route->ssrc_learnt = FALSE;
+	}
+}
+
+static void mpf_rtp_demux_ssrc_register(mpf_rtp_demux_t *demux, mpf_rtp_route_t *route, apr_uint32_t ssrc)
+{
+	mpf_rtp_route_t *existing;
+	mpf_rtp_demux_ssrc_unregister(demux,route);
+
+	/* the table references the key stored within the route, evict the other owner first */
+	existing = apr_hash_get(demux->ssrc_table,&ssrc,sizeof(ssrc));
+	if(existing) {
+		mpf_rtp_demux_ssrc_unregister(demux,existing);
+	}
+	route->ssrc = ssrc;
+	route->ssrc_learnt = TRUE;
+	apr_hash_set(demux->ssrc_table,&route->ssrc,sizeof(route->ssrc),route);
+}
+
+MPF_DECLARE(apt_bool_t) mpf_rtp_demux_route_set(
+							mpf_rtp_demux_t *demux,
+							void *obj,
+							mpf_rtp_demux_handler_f handler,
+							const apr_sockaddr_t *remote_sockaddr)
+{
+	mpf_rtp_route_t *existing;
+	mpf_rtp_route_t *route = apr_hash_get(demux->obj_table,&obj,sizeof(obj));
+	if(!route) {
+		route = demux->free_routes;
+		if(route) {
+			demux->free_routes = route->next;
+		}
+		else {
+			route = apr_palloc(demux->pool,sizeof(mpf_rtp_route_t));
+		}
+		route->obj = obj;
+		route->addr_key_len = 0;
+		route->ssrc = 0;
+		route->ssrc_learnt = FALSE;
+		route->next = NULL;
+		apr_hash_set(demux->obj_table,&route->obj,sizeof(route->obj),route);
+	}
+	route->handler = handler;
+
+	mpf_rtp_demux_addr_unregister(demux,route);
+	if(remote_sockaddr) {
+		route->addr_key_len = mpf_rtp_demux_addr_key_get(remote_sockaddr,remote_sockaddr->port,route->addr_key);
+		if(!route->addr_key_len) {
+			return FALSE;
+		}
+		existing = apr_hash_get(demux->addr_table,route->addr_key,route->addr_key_len);
+		if(existing) {
+			mpf_rtp_demux_addr_unregister(demux,existing);
+		}
+		apr_hash_set(demux->addr_table,route->addr_key,route->addr_key_len,route);
+	}
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_rtp_demux_route_remove(mpf_rtp_demux_t *demux, void *obj)
+{
+	mpf_rtp_route_t *route = apr_hash_get(demux->obj_table,&obj,sizeof(obj));
+	if(!route) {
+		return FALSE;
+	}
+
+	mpf_rtp_demux_addr_unregister(demux,route);
+	mpf_rtp_demux_ssrc_unregister(demux,route);
+	apr_hash_set(demux->obj_table,&route->obj,sizeof(route->obj),NULL);
+
+	route->obj = NULL;
+	route->next = demux->free_routes;
+	demux->free_routes = route;
+	return TRUE;
+}
+
+static apt_bool_t mpf_rtp_demux_dispatch(mpf_rtp_demux_t *demux, char *buffer, apr_size_t size, apt_bool_t rtcp_socket)
+{
+	unsigned char key[MPF_RTP_DEMUX_KEY_SIZE];
+	apr_size_t key_len;
+	const unsigned char *data = (const unsigned char*)buffer;
+	const unsigned char *ssrc_data;
+	apr_uint32_t ssrc;
+	apr_port_t port;
+	apt_bool_t rtcp = rtcp_socket;
+	mpf_rtp_route_t *route = NULL;
+
+	if(size < 8 || (data[0] >> 6) != 2) {
+		/* not an RTP/RTCP packet */
+		return FALSE;
+	}
+	if(rtcp == FALSE && data[1] >= 192 && data[1] <= 223) {
+		/* RTCP packet multiplexed with RTP (RFC 5761) */
+		rtcp = TRUE;
+	}
+	if(rtcp == FALSE && size < 12) {
+		return FALSE;
+	}
+
+	/* SSRC of RTP packet or sender SSRC of RTCP packet */
+	ssrc_data = rtcp == TRUE ? data + 4 : data + 8;
+	ssrc = ((apr_uint32_t)ssrc_data[0] << 24) | ((apr_uint32_t)ssrc_data[1] << 16) |
+		((apr_uint32_t)ssrc_data[2] << 8) | (apr_uint32_t)ssrc_data[3];
+
+	/* RTCP socket receives from the remote RTCP port, which is the RTP port + 1 */
+	port = rtcp_socket == TRUE ? demux->from->port - 1 : demux->from->port;
+	key_len = mpf_rtp_demux_addr_key_get(demux->from,port,key);
+	if(key_len) {
+		route = apr_hash_get(demux->addr_table,key,key_len);
+	}
+	if(route) {
+		if(rtcp == FALSE && (route->ssrc_learnt == FALSE || route->ssrc != ssrc)) {
+			/* learn SSRC to route packets if the remote address changes (NAT) */
+			mpf_rtp_demux_ssrc_register(demux,route,ssrc);
+		}
+	}
+	else {
+		route = apr_hash_get(demux->ssrc_table,&ssrc,sizeof(ssrc));
+	}
+
+	if(!route) {
+		demux->unrouted_packets++;
+		return FALSE;
+	}
+
+	route->handler(route->obj,buffer,size,rtcp);
+	return TRUE;
+}
+
+static apr_size_t mpf_rtp_demux_socket_drain(mpf_rtp_demux_t *demux, apr_socket_t *socket, apt_bool_t rtcp_socket)
+{
+	char buffer[MAX_RTP_PACKET_SIZE];
+	apr_size_t size = sizeof(buffer);
+	apr_size_t max_count = MPF_RTP_DEMUX_DRAIN_MAX;
+	apr_size_t count = 0;
+	while(max_count && apr_socket_recvfrom(demux->from,socket,0,buffer,&size) == APR_SUCCESS) {
+		if(mpf_rtp_demux_dispatch(demux,buffer,size,rtcp_socket) == TRUE) {
+			count++;
+		}
+
+		size = sizeof(buffer);
+		max_count--;
+	}
+	return count;
+}
+
+MPF_DECLARE(apr_size_t) mpf_rtp_demux_process(mpf_rtp_demux_t *demux)
+{
+	apr_size_t count;
+	apr_time_t now = apr_time_now();
+	if(now - demux->drain_time < (apr_time_t)CODEC_FRAME_TIME_BASE * 500) {
+		/* already drained on this tick */
+		return 0;
+	}
+	demux->drain_time = now;
+
+	count = mpf_rtp_demux_socket_drain(demux,demux->rtp_socket,FALSE);
+	if(demux->rtcp_socket) {
+		count += mpf_rtp_demux_socket_drain(demux,demux->rtcp_socket,TRUE);
+	}
+	return count;
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <apr_thread_mutex.h>
+#include "mpf_rtp_port_allocator.h"
+#include "apt_log.h"
+
+/** End of the list of free ports */
+#define MPF_RTP_PORT_NONE ((apr_size_t)-1)
+
+/** Slot of RTP/RTCP port pair */
+typedef struct mpf_rtp_port_slot_t mpf_rtp_port_slot_t;
+struct mpf_rtp_port_slot_t {
+	/** Next slot in the list of free ports */
+	apr_size_t   next;
+	/** Time the port was released at */
+	apr_time_t   release_time;
+	/** Whether the port is allocated */
+	apt_bool_t   busy;
+};
+
+/** RTP port allocator */
+struct mpf_rtp_port_allocator_t {
+	/** Min RTP port */
+	apr_port_t           port_min;
+	/** Slots of port pairs */
+	mpf_rtp_port_slot_t *slots;
+	/** Number of slots */
+	apr_size_t           slot_count;
+	/** First (released earliest) free slot */
+	apr_size_t           head;
+	/** Last (released latest) free slot */
+	apr_size_t           tail;
+	/** Number of free slots */
+	apr_size_t           free_count;
+	/** Quarantine of released ports */
+	apr_interval_time_t  quarantine;
+	/** Guard of the list of free ports */
+	apr_thread_mutex_t  *guard;
+};
+
+MPF_DECLARE(mpf_rtp_port_allocator_t*) mpf_rtp_port_allocator_create(
+											apr_port_t port_min,
+											apr_port_t port_max,
+											apr_uint32_t quarantine,
+											apr_pool_t *pool)
+{
+	apr_size_t i;
+	mpf_rtp_port_allocator_t *allocator;
+	if(port_max <= port_min + 1) {
+		return NULL;
+	}
+
+	allocator = apr_palloc(pool,sizeof(mpf_rtp_port_allocator_t));
+	if(apr_thread_mutex_create(&allocator->guard,APR_THREAD_MUTEX_UNNESTED,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	allocator->port_min = port_min;
+	allocator->slot_count = (port_max - port_min) / 2;
+	allocator->slots = apr_palloc(pool,sizeof(mpf_rtp_port_slot_t) * allocator->slot_count);
+	allocator->quarantine = apr_time_from_msec(quarantine);
+	/* initially the ports are given in ascending order */
+	for(i=0; i<allocator->slot_count; i++) {
+		allocator->slots[i].next = i + 1;
+		allocator->slots[i].release_time = 0;
+		allocator->slots[i].busy = FALSE;
+	}
+	allocator->slots[allocator->slot_count - 1].next = MPF_RTP_PORT_NONE;
+	allocator->head = 0;
+	allocator->tail = allocator->slot_count - 1;
+	allocator->free_count = allocator->slot_count;
+	return allocator;
+}
+
+MPF_DECLARE(apr_port_t) mpf_rtp_port_allocator_allocate(mpf_rtp_port_allocator_t *allocator)
+{
+	apr_size_t id;
+	mpf_rtp_port_slot_t *slot;
+	apr_thread_mutex_lock(allocator->guard);
+	id = allocator->head;
+	if(id == MPF_RTP_PORT_NONE) {
+		apr_thread_mutex_unlock(allocator->guard);
+		return 0;
+	}
+
+	slot = &allocator->slots[id];
+	if(slot->release_time && allocator->quarantine &&
+		apr_time_now() - slot->release_time < allocator->quarantine) {
+		/* the rest of the free ports have been released even later */
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Reuse RTP Port in Quarantine [%hu]",
+			(apr_port_t)(allocator->port_min + 2 * id));
+	}
+
+	allocator->head = slot->next;
+	if(allocator->head == MPF_RTP_PORT_NONE) {
+		allocator->tail = MPF_RTP_PORT_NONE;
+	}
+	slot->next = MPF_RTP_PORT_NONE;
+	slot->busy = TRUE;
+	allocator->free_count--;
+	apr_thread_mutex_unlock(allocator->guard);
+	return (apr_port_t)(allocator->port_min + 2 * id);
+}
+
+MPF_DECLARE(apt_bool_t) mpf_rtp_port_allocator_release(mpf_rtp_port_allocator_t *allocator, apr_port_t port)
+{
+	apr_size_t id;
+	mpf_rtp_port_slot_t *slot;
+	if(port < allocator->port_min || (port - allocator->port_min) % 2 != 0) {
+		return FALSE;
+	}
+	id = (port - allocator->port_min) / 2;
+	if(id >= allocator->slot_count) {
+		return FALSE;
+	}
+	slot = &allocator->slots[id];
+	apr_thread_mutex_lock(allocator->guard);
+	if(slot->busy == FALSE) {
+		apr_thread_mutex_unlock(allocator->guard);
+		return FALSE;
+	}
+
+	/* append to the end of the list, so that the port is given out as late as possible */
+	slot->busy = FALSE;
+	slot->release_time = apr_time_now();
+	slot->next = MPF_RTP_PORT_NONE;
+	if(allocator->tail == MPF_RTP_PORT_NONE) {
+		allocator->head = id;
+	}
+	else {
+		allocator->slots[allocator->tail].next = id;
+	}
+	allocator->tail = id;
+	allocator->free_count++;
+	apr_thread_mutex_unlock(allocator->guard);
+	return TRUE;
+}
+
+MPF_DECLARE(apr_size_t) mpf_rtp_port_allocator_free_count_get(const mpf_rtp_port_allocator_t *allocator)
+{
+	/* informative only, the count may change right after it is read */
+	return allocator->free_count;
+}
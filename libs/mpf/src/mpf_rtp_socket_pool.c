@@ -0,0 +1,283 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#include "mpf_rtp_socket_pool.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+
+/** Interval to check for pairs to close and to retry failed refills (usec) */
+#define MPF_RTP_SOCKET_POOL_INTERVAL (100 * 1000)
+
+/** Pool of socket pairs */
+struct mpf_rtp_socket_pool_t {
+	/** Local IP address to bind to */
+	apt_str_t                 ip;
+	/** Allocator to take ports from */
+	mpf_rtp_port_allocator_t *port_allocator;
+	/** Number of pairs kept ready */
+	apr_size_t                size;
+
+	/** List of ready pairs */
+	mpf_rtp_socket_pair_t    *ready;
+	/** Number of ready pairs */
+	apr_size_t                ready_count;
+	/** List of pairs to close */
+	mpf_rtp_socket_pair_t    *closing;
+
+	/** Guard of the lists */
+	apr_thread_mutex_t       *guard;
+	/** Condition the refill thread waits on */
+	apr_thread_cond_t        *wakeup;
+	/** Refill thread */
+	apr_thread_t             *thread;
+	/** Whether the refill thread is running */
+	apt_bool_t                running;
+
+	/** Pool the socket pairs are created from (used by the refill thread only) */
+	apr_pool_t               *pair_pool;
+};
+
+static mpf_rtp_socket_pair_t* mpf_rtp_socket_pair_create(mpf_rtp_socket_pool_t *socket_pool)
+{
+	apr_size_t attempts;
+	apr_pool_t *pool;
+	mpf_rtp_socket_pair_t *pair;
+	apr_pool_create(&pool,socket_pool->pair_pool);
+	pair = apr_palloc(pool,sizeof(mpf_rtp_socket_pair_t));
+	pair->pool = pool;
+	pair->rtp_socket = NULL;
+	pair->rtp_sockaddr = NULL;
+	pair->rtcp_socket = NULL;
+	pair->rtcp_sockaddr = NULL;
+	pair->port = 0;
+	pair->next = NULL;
+
+	/* each free port is tried at most once */
+	attempts = mpf_rtp_port_allocator_free_count_get(socket_pool->port_allocator);
+	while(attempts > 0) {
+		attempts--;
+		pair->port = mpf_rtp_port_allocator_allocate(socket_pool->port_allocator);
+		if(!pair->port) {
+			break;
+		}
+		if(apr_sockaddr_info_get(&pair->rtp_sockaddr,socket_pool->ip.buf,APR_INET,pair->port,0,pool) == APR_SUCCESS &&
+			apr_socket_create(&pair->rtp_socket,APR_INET,SOCK_DGRAM,0,pool) == APR_SUCCESS) {
+			if(apr_socket_bind(pair->rtp_socket,pair->rtp_sockaddr) == APR_SUCCESS) {
+				break;
+			}
+			apr_socket_close(pair->rtp_socket);
+		}
+		pair->rtp_socket = NULL;
+		/* the port is in use by someone else, move it to the end of the list */
+		mpf_rtp_port_allocator_release(socket_pool->port_allocator,pair->port);
+		pair->port = 0;
+	}
+	if(!pair->rtp_socket) {
+		apr_pool_destroy(pool);
+		return NULL;
+	}
+	apr_socket_opt_set(pair->rtp_socket,APR_SO_NONBLOCK,1);
+	apr_socket_timeout_set(pair->rtp_socket,0);
+
+	/* try to bind RTCP socket, continue in either way */
+	if(apr_sockaddr_info_get(&pair->rtcp_sockaddr,socket_pool->ip.buf,APR_INET,pair->port+1,0,pool) == APR_SUCCESS &&
+		apr_socket_create(&pair->rtcp_socket,APR_INET,SOCK_DGRAM,0,pool) == APR_SUCCESS) {
+		if(apr_socket_bind(pair->rtcp_socket,pair->rtcp_sockaddr) == APR_SUCCESS) {
+			apr_socket_opt_set(pair->rtcp_socket,APR_SO_NONBLOCK,1);
+			apr_socket_timeout_set(pair->rtcp_socket,0);
+		}
+		else {
+			apr_socket_close(pair->rtcp_socket);
+			pair->rtcp_socket = NULL;
+			pair->rtcp_sockaddr = NULL;
+		}
+	}
+	else {
+		pair->rtcp_socket = NULL;
+		pair->rtcp_sockaddr = NULL;
+	}
+	return pair;
+}
+
+static void mpf_rtp_socket_pair_destroy(mpf_rtp_socket_pool_t *socket_pool, mpf_rtp_socket_pair_t *pair)
+{
+	apr_port_t port = pair->port;
+	/* the sockets are closed by the cleanup of the pool */
+	apr_pool_destroy(pair->pool);
+	mpf_rtp_port_allocator_release(socket_pool->port_allocator,port);
+}
+
+static void* APR_THREAD_FUNC mpf_rtp_socket_pool_run(apr_thread_t *thread, void *data)
+{
+	mpf_rtp_socket_pool_t *socket_pool = data;
+	mpf_rtp_socket_pair_t *pair;
+	mpf_rtp_socket_pair_t *closing;
+	apt_bool_t refill;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Run RTP Socket Pool %s [%"APR_SIZE_T_FMT"]",
+		socket_pool->ip.buf,
+		socket_pool->size);
+	apr_thread_mutex_lock(socket_pool->guard);
+	while(socket_pool->running == TRUE) {
+		closing = socket_pool->closing;
+		socket_pool->closing = NULL;
+		refill = socket_pool->ready_count < socket_pool->size ? TRUE : FALSE;
+		if(!closing && refill == FALSE) {
+			apr_thread_cond_timedwait(socket_pool->wakeup,socket_pool->guard,MPF_RTP_SOCKET_POOL_INTERVAL);
+			continue;
+		}
+		apr_thread_mutex_unlock(socket_pool->guard);
+
+		/* close first, the released ports are the last to be taken anyway */
+		while(closing) {
+			pair = closing;
+			closing = pair->next;
+			mpf_rtp_socket_pair_destroy(socket_pool,pair);
+		}
+
+		pair = NULL;
+		if(refill == TRUE) {
+			pair = mpf_rtp_socket_pair_create(socket_pool);
+		}
+
+		apr_thread_mutex_lock(socket_pool->guard);
+		if(pair) {
+			pair->next = socket_pool->ready;
+			socket_pool->ready = pair;
+			socket_pool->ready_count++;
+		}
+		else if(refill == TRUE && socket_pool->running == TRUE) {
+			/* the range is exhausted, retry later */
+			apr_thread_cond_timedwait(socket_pool->wakeup,socket_pool->guard,MPF_RTP_SOCKET_POOL_INTERVAL);
+		}
+	}
+	apr_thread_mutex_unlock(socket_pool->guard);
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Exit RTP Socket Pool %s",socket_pool->ip.buf);
+
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+static apr_status_t mpf_rtp_socket_pool_cleanup(void *data)
+{
+	mpf_rtp_socket_pool_t *socket_pool = data;
+	apr_status_t rv;
+	if(!socket_pool->pair_pool) {
+		/* never started */
+		return APR_SUCCESS;
+	}
+
+	if(socket_pool->thread) {
+		apr_thread_mutex_lock(socket_pool->guard);
+		socket_pool->running = FALSE;
+		apr_thread_cond_signal(socket_pool->wakeup);
+		apr_thread_mutex_unlock(socket_pool->guard);
+		apr_thread_join(&rv,socket_pool->thread);
+		socket_pool->thread = NULL;
+	}
+
+	/* the pairs still in the lists are closed along with the pool */
+	socket_pool->ready = NULL;
+	socket_pool->ready_count = 0;
+	socket_pool->closing = NULL;
+	apr_pool_destroy(socket_pool->pair_pool);
+	socket_pool->pair_pool = NULL;
+	return APR_SUCCESS;
+}
+
+MPF_DECLARE(mpf_rtp_socket_pool_t*) mpf_rtp_socket_pool_create(
+										const apt_str_t *ip,
+										mpf_rtp_port_allocator_t *port_allocator,
+										apr_size_t size,
+										apr_pool_t *pool)
+{
+	mpf_rtp_socket_pool_t *socket_pool;
+	if(!port_allocator || !size) {
+		return NULL;
+	}
+
+	socket_pool = apr_palloc(pool,sizeof(mpf_rtp_socket_pool_t));
+	apt_string_copy(&socket_pool->ip,ip,pool);
+	socket_pool->port_allocator = port_allocator;
+	socket_pool->size = size;
+	socket_pool->ready = NULL;
+	socket_pool->ready_count = 0;
+	socket_pool->closing = NULL;
+	socket_pool->thread = NULL;
+	socket_pool->running = FALSE;
+	socket_pool->pair_pool = NULL;
+	if(apr_thread_mutex_create(&socket_pool->guard,APR_THREAD_MUTEX_UNNESTED,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	if(apr_thread_cond_create(&socket_pool->wakeup,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	apr_pool_cleanup_register(pool,socket_pool,mpf_rtp_socket_pool_cleanup,apr_pool_cleanup_null);
+	return socket_pool;
+}
+
+/** Start the refill thread, called with the guard locked */
+static apt_bool_t mpf_rtp_socket_pool_start(mpf_rtp_socket_pool_t *socket_pool)
+{
+	socket_pool->pair_pool = apt_pool_create();
+	if(!socket_pool->pair_pool) {
+		return FALSE;
+	}
+	socket_pool->running = TRUE;
+	if(apr_thread_create(&socket_pool->thread,NULL,mpf_rtp_socket_pool_run,socket_pool,socket_pool->pair_pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create RTP Socket Pool Thread %s",socket_pool->ip.buf);
+		socket_pool->running = FALSE;
+		socket_pool->thread = NULL;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+MPF_DECLARE(mpf_rtp_socket_pair_t*) mpf_rtp_socket_pool_get(mpf_rtp_socket_pool_t *socket_pool)
+{
+	mpf_rtp_socket_pair_t *pair;
+	apr_thread_mutex_lock(socket_pool->guard);
+	if(!socket_pool->pair_pool) {
+		/* started on the first demand, the pool is filled in the meantime */
+		mpf_rtp_socket_pool_start(socket_pool);
+	}
+	pair = socket_pool->ready;
+	if(pair) {
+		socket_pool->ready = pair->next;
+		socket_pool->ready_count--;
+		pair->next = NULL;
+	}
+	if(socket_pool->ready_count < socket_pool->size / 2) {
+		/* wake the refill thread up, once the pool is half empty */
+		apr_thread_cond_signal(socket_pool->wakeup);
+	}
+	apr_thread_mutex_unlock(socket_pool->guard);
+	return pair;
+}
+
+MPF_DECLARE(void) mpf_rtp_socket_pool_put(mpf_rtp_socket_pool_t *socket_pool, mpf_rtp_socket_pair_t *pair)
+{
+	apr_thread_mutex_lock(socket_pool->guard);
+	/* picked up by the refill thread within the check interval */
+	pair->next = socket_pool->closing;
+	socket_pool->closing = pair;
+	apr_thread_mutex_unlock(socket_pool->guard);
+}
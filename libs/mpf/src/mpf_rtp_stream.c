@@ -16,23 +16,48 @@
  * $Id$
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+/* recvmmsg() is a GNU extension */
+#define _GNU_SOURCE
+#endif
+
 #include <apr_network_io.h>
+#include <apr_portable.h>
+#include <apr_atomic.h>
+#if defined(__linux__)
+#include <sys/socket.h>
+#if defined(MSG_WAITFORONE)
+/** Receive RTP packets in batches by a single recvmmsg() call */
+#define ENABLE_RTP_RECVMMSG
+#if defined(SO_TIMESTAMPNS)
+/** Take arrival time of RTP packets from the kernel receive timestamps */
+#define ENABLE_RTP_RX_TIMESTAMP
+#endif
+#endif
+#endif
 #include "apt_net.h"
 #include "apt_timer_queue.h"
 #include "mpf_rtp_stream.h"
 #include "mpf_termination.h"
+#include "mpf_engine.h"
 #include "mpf_codec_manager.h"
 #include "mpf_rtp_header.h"
 #include "mpf_rtcp_packet.h"
+#include "mpf_rtcp_agent.h"
 #include "mpf_rtp_defs.h"
 #include "mpf_rtp_pt.h"
+#include "mpf_srtp.h"
+#include "mpf_comfort_noise.h"
 #include "mpf_trace.h"
 #include "apt_log.h"
+#include "apt_probe.h"
 
 /** Max size of RTP packet */
 #define MAX_RTP_PACKET_SIZE  1500
 /** Max size of RTCP packet */
 #define MAX_RTCP_PACKET_SIZE 1500
+/** Max number of RTP packets received per stream per tick */
+#define RTP_RX_BATCH_SIZE    5
 
 /* Reason strings used in RTCP BYE messages (informative only) */
 #define RTCP_BYE_SESSION_ENDED "Session ended"
@@ -46,6 +71,11 @@
 #define RTP_TRACE mpf_null_trace
 #endif
 
+/** Snapshot of the stream RTCP reports are composed of */
+typedef struct rtcp_report_src_t rtcp_report_src_t;
+/** State of RTCP offloaded to the agent of the engine */
+typedef struct mpf_rtcp_offload_t mpf_rtcp_offload_t;
+
 /** RTP stream */
 typedef struct mpf_rtp_stream_t mpf_rtp_stream_t;
 struct mpf_rtp_stream_t {
@@ -60,6 +90,10 @@ struct mpf_rtp_stream_t {
 
 	mpf_rtp_config_t           *config;
 	mpf_rtp_settings_t         *settings;
+	/** Settings the jitter buffer of the receiver is created with, followed at runtime */
+	mpf_rtp_settings_t         *rx_settings;
+	/** Codec the receiver is open with */
+	mpf_codec_t                *rx_codec;
 
 	apr_socket_t               *rtp_socket;
 	apr_socket_t               *rtcp_socket;
@@ -68,8 +102,37 @@ struct mpf_rtp_stream_t {
 	apr_sockaddr_t             *rtcp_l_sockaddr;
 	apr_sockaddr_t             *rtcp_r_sockaddr;
 
+	mpf_tx_batch_t             *tx_batch;
+	mpf_rtp_demux_t            *demux;
+	mpf_uring_t                *uring;
+	mpf_jb_slab_t              *jb_slab;
+	apt_bool_t                  uring_rx;
+	apt_bool_t                  shared;
+	apt_bool_t                  rtcp_mux;
+	/** RTP port taken from the allocator of the config (0 if none) */
+	apr_port_t                  allocated_port;
+	/** Pre-bound socket pair taken from the pool of the config */
+	mpf_rtp_socket_pair_t      *socket_pair;
+
+	mpf_srtp_t                 *srtp;
+	mpf_srtp_crypto_t          *srtp_tx_crypto;
+	mpf_srtp_crypto_t           srtp_rx_crypto;
+
 	apt_timer_t                *rtcp_tx_timer;
 	apt_timer_t                *rtcp_rx_timer;
+	/** Agent RTCP is offloaded to (NULL if processed by the timers) */
+	mpf_rtcp_agent_t           *rtcp_agent;
+	/** State of offloaded RTCP, allocated once started */
+	mpf_rtcp_offload_t         *rtcp_offload;
+
+	/** Timestamp of the named event last written to the event sink on arrival */
+	apr_uint32_t                event_direct_ts;
+	/** Identifier of the named event last written on arrival */
+	apr_byte_t                  event_direct_id;
+	/** Whether any named event has been written on arrival */
+	apt_bool_t                  event_direct_started;
+	/** Whether the end of the named event is yet to be written */
+	apt_bool_t                  event_direct_active;
 	
 	apr_pool_t                 *pool;
 };
@@ -81,6 +144,7 @@ static apt_bool_t mpf_rtp_stream_receive(mpf_audio_stream_t *stream, mpf_frame_t
 static apt_bool_t mpf_rtp_tx_stream_open(mpf_audio_stream_t *stream, mpf_codec_t *codec);
 static apt_bool_t mpf_rtp_tx_stream_close(mpf_audio_stream_t *stream);
 static apt_bool_t mpf_rtp_stream_transmit(mpf_audio_stream_t *stream, const mpf_frame_t *frame);
+static apt_bool_t mpf_rtp_stream_pending_receive(mpf_audio_stream_t *stream);
 
 static const mpf_audio_stream_vtable_t vtable = {
 	mpf_rtp_stream_destroy,
@@ -90,10 +154,14 @@ static const mpf_audio_stream_vtable_t vtable = {
 	mpf_rtp_tx_stream_open,
 	mpf_rtp_tx_stream_close,
 	mpf_rtp_stream_transmit,
-	NULL /* mpf_rtp_stream_trace */
+	NULL, /* mpf_rtp_stream_trace */
+	NULL, /* write_event */
+	mpf_rtp_stream_pending_receive
 };
 
 static apt_bool_t mpf_rtp_socket_pair_create(mpf_rtp_stream_t *stream, mpf_rtp_media_descriptor_t *local_media, apt_bool_t bind);
+static apt_bool_t mpf_rtp_shared_socket_pair_attach(mpf_rtp_stream_t *stream, mpf_rtp_media_descriptor_t *local_media);
+static apt_bool_t mpf_rtp_pooled_socket_pair_attach(mpf_rtp_stream_t *stream, mpf_rtp_media_descriptor_t *local_media);
 static apt_bool_t mpf_rtp_socket_pair_bind(mpf_rtp_stream_t *stream, mpf_rtp_media_descriptor_t *local_media);
 static void mpf_rtp_socket_pair_close(mpf_rtp_stream_t *stream);
 
@@ -101,6 +169,15 @@ static apt_bool_t mpf_rtcp_report_send(mpf_rtp_stream_t *stream);
 static apt_bool_t mpf_rtcp_bye_send(mpf_rtp_stream_t *stream, apt_str_t *reason);
 static void mpf_rtcp_tx_timer_proc(apt_timer_t *timer, void *obj);
 static void mpf_rtcp_rx_timer_proc(apt_timer_t *timer, void *obj);
+static void mpf_rtcp_start(mpf_rtp_stream_t *rtp_stream);
+static void mpf_rtcp_stop(mpf_rtp_stream_t *rtp_stream);
+static apt_bool_t mpf_rtcp_offload_stop(mpf_rtp_stream_t *rtp_stream);
+static APR_INLINE void mpf_rtcp_offload_serve(mpf_rtp_stream_t *rtp_stream);
+static apt_bool_t mpf_rtcp_compound_packet_receive(mpf_rtp_stream_t *rtp_stream, char *buffer, apr_size_t length);
+static void mpf_rtp_demux_packet_receive(void *obj, char *buffer, apr_size_t size, apt_bool_t rtcp);
+static void mpf_rtp_uring_packet_receive(void *obj, char *buffer, apr_size_t size);
+static void mpf_rtp_uring_rx_stop(mpf_rtp_stream_t *rtp_stream);
+static void rtp_rx_timestamp_enable(mpf_rtp_stream_t *rtp_stream);
 
 
 MPF_DECLARE(mpf_audio_stream_t*) mpf_rtp_stream_create(mpf_termination_t *termination, mpf_rtp_config_t *config, mpf_rtp_settings_t *settings, apr_pool_t *pool)
@@ -114,21 +191,46 @@ MPF_DECLARE(mpf_audio_stream_t*) mpf_rtp_stream_create(mpf_termination_t *termin
 
 	audio_stream->direction = STREAM_DIRECTION_NONE;
 	audio_stream->termination = termination;
+	audio_stream->rx_event_direct = TRUE;
+	audio_stream->network = TRUE;
+	if(settings && settings->jb_config.time_skew_detection == MPF_TIME_SKEW_RESAMPLE && !settings->jb_config.bypass) {
+		/* the decoder resamples by the excess of the jitter buffer */
+		audio_stream->rx_skew_compensation = TRUE;
+	}
 
 	rtp_stream->base = audio_stream;
 	rtp_stream->pool = pool;
 	rtp_stream->config = config;
 	rtp_stream->settings = settings;
+	rtp_stream->rx_settings = settings;
+	rtp_stream->rx_codec = NULL;
 	rtp_stream->local_media = NULL;
+	rtp_stream->allocated_port = 0;
+	rtp_stream->socket_pair = NULL;
 	rtp_stream->remote_media = NULL;
 	rtp_stream->rtp_socket = NULL;
+	rtp_stream->event_direct_ts = 0;
+	rtp_stream->event_direct_id = 0;
+	rtp_stream->event_direct_started = FALSE;
+	rtp_stream->event_direct_active = FALSE;
 	rtp_stream->rtcp_socket = NULL;
 	rtp_stream->rtp_l_sockaddr = NULL;
 	rtp_stream->rtp_r_sockaddr = NULL;
 	rtp_stream->rtcp_l_sockaddr = NULL;
 	rtp_stream->rtcp_r_sockaddr = NULL;
+	rtp_stream->tx_batch = termination->tx_batch;
+	rtp_stream->demux = NULL;
+	rtp_stream->uring = termination->uring;
+	rtp_stream->jb_slab = termination->jb_slab;
+	rtp_stream->uring_rx = FALSE;
+	rtp_stream->shared = FALSE;
+	rtp_stream->rtcp_mux = FALSE;
+	rtp_stream->srtp = NULL;
+	rtp_stream->srtp_tx_crypto = NULL;
 	rtp_stream->rtcp_tx_timer = NULL;
 	rtp_stream->rtcp_rx_timer = NULL;
+	rtp_stream->rtcp_agent = termination->rtcp_agent;
+	rtp_stream->rtcp_offload = NULL;
 	rtp_stream->state = MPF_MEDIA_DISABLED;
 	rtp_receiver_init(&rtp_stream->receiver);
 	rtp_transmitter_init(&rtp_stream->transmitter);
@@ -152,6 +254,27 @@ MPF_DECLARE(mpf_audio_stream_t*) mpf_rtp_stream_create(mpf_termination_t *termin
 	return audio_stream;
 }
 
+MPF_DECLARE(apt_bool_t) mpf_rtp_stream_demux_set(mpf_audio_stream_t *stream, mpf_rtp_demux_t *demux)
+{
+	mpf_rtp_stream_t *rtp_stream = stream->obj;
+	if(rtp_stream->local_media) {
+		/* sockets are already allocated */
+		return FALSE;
+	}
+	rtp_stream->demux = demux;
+	return TRUE;
+}
+
+/** Whether RTCP multiplexed with RTP can be offered/accepted */
+static APR_INLINE apt_bool_t mpf_rtp_stream_rtcp_mux_supported(mpf_rtp_stream_t *rtp_stream)
+{
+	if(rtp_stream->shared == TRUE && !mpf_rtp_demux_rtcp_socket_get(rtp_stream->demux)) {
+		/* the shared port has no RTCP counterpart */
+		return TRUE;
+	}
+	return rtp_stream->config->rtcp_mux;
+}
+
 static apt_bool_t mpf_rtp_stream_local_media_create(mpf_rtp_stream_t *rtp_stream, mpf_rtp_media_descriptor_t *local_media, mpf_rtp_media_descriptor_t *remote_media, mpf_stream_capabilities_t *capabilities)
 {
 	apt_bool_t status = TRUE;
@@ -168,24 +291,38 @@ static apt_bool_t mpf_rtp_stream_local_media_create(mpf_rtp_stream_t *rtp_stream
 		local_media->ip = rtp_stream->config->ip;
 		local_media->ext_ip = rtp_stream->config->ext_ip;
 	}
-	if(local_media->port == 0) {
+	if(local_media->port == 0 && rtp_stream->demux) {
+		/* use the port shared by the streams of the media worker */
+		mpf_rtp_shared_socket_pair_attach(rtp_stream,local_media);
+	}
+	else if(local_media->port == 0 && mpf_rtp_pooled_socket_pair_attach(rtp_stream,local_media) == TRUE) {
+		/* the sockets have been created and bound in advance */
+	}
+	else if(local_media->port == 0) {
 		if(mpf_rtp_socket_pair_create(rtp_stream,local_media,FALSE) == TRUE) {
 			/* RTP port management */
 			mpf_rtp_config_t *rtp_config = rtp_stream->config;
-			apr_port_t first_port_in_search = rtp_config->rtp_port_cur;
+			apr_size_t attempts = 0;
 			apt_bool_t is_port_ok = FALSE;
-			do {
-				local_media->port = rtp_config->rtp_port_cur;
-				rtp_config->rtp_port_cur += 2;
-				if(rtp_config->rtp_port_cur == rtp_config->rtp_port_max) {
-					rtp_config->rtp_port_cur = rtp_config->rtp_port_min;
+			if(rtp_config->port_allocator) {
+				attempts = mpf_rtp_port_allocator_free_count_get(rtp_config->port_allocator);
+			}
+			/* each free port is tried at most once */
+			while(attempts > 0) {
+				attempts--;
+				local_media->port = mpf_rtp_port_allocator_allocate(rtp_config->port_allocator);
+				if(!local_media->port) {
+					break;
 				}
 				
 				if(mpf_rtp_socket_pair_bind(rtp_stream,local_media) == TRUE) {
+					rtp_stream->allocated_port = local_media->port;
 					is_port_ok = TRUE;
 					break;
 				}
-			} while(first_port_in_search != rtp_config->rtp_port_cur);
+				/* the port is in use by someone else, move it to the end of the list */
+				mpf_rtp_port_allocator_release(rtp_config->port_allocator,local_media->port);
+			}
 
 			if(is_port_ok == FALSE) {
 				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Find Free RTP Port %s:[%hu,%hu]",
@@ -208,6 +345,19 @@ static apt_bool_t mpf_rtp_stream_local_media_create(mpf_rtp_stream_t *rtp_stream
 		local_media->state = MPF_MEDIA_DISABLED;
 	}
 
+	local_media->rtcp_mux = mpf_rtp_stream_rtcp_mux_supported(rtp_stream);
+
+	if(rtp_stream->config->srtp_suite != SRTP_CRYPTO_UNKNOWN && !local_media->crypto) {
+		if(!remote_media) {
+			/* offer SRTP */
+			local_media->crypto = mpf_srtp_crypto_create(rtp_stream->config->srtp_suite,1,rtp_stream->pool);
+		}
+		else if(remote_media->crypto) {
+			/* answer SRTP offer with the same tag and suite */
+			local_media->crypto = mpf_srtp_crypto_create(remote_media->crypto->suite,remote_media->crypto->tag,rtp_stream->pool);
+		}
+	}
+
 	if(rtp_stream->settings->ptime) {
 		local_media->ptime = rtp_stream->settings->ptime;
 	}
@@ -304,6 +454,11 @@ static apt_bool_t mpf_rtp_stream_remote_media_update(mpf_rtp_stream_t *rtp_strea
 				media->port+1,
 				0,
 				rtp_stream->pool);
+
+			if(rtp_stream->shared == TRUE) {
+				/* route packets from the remote address to this stream */
+				mpf_rtp_demux_route_set(rtp_stream->demux,rtp_stream,mpf_rtp_demux_packet_receive,rtp_stream->rtp_r_sockaddr);
+			}
 		}
 	}
 
@@ -311,6 +466,57 @@ static apt_bool_t mpf_rtp_stream_remote_media_update(mpf_rtp_stream_t *rtp_strea
 	return status;
 }
 
+static void mpf_rtp_stream_srtp_negotiate(mpf_rtp_stream_t *rtp_stream)
+{
+	mpf_rtp_media_descriptor_t *local_media = rtp_stream->local_media;
+	mpf_srtp_crypto_t *rx_crypto = rtp_stream->remote_media->crypto;
+
+	if(rtp_stream->config->srtp_suite == SRTP_CRYPTO_UNKNOWN || rtp_stream->remote_media->state != MPF_MEDIA_ENABLED) {
+		/* SRTP is disabled locally, RTP/SAVP offer (if any) is answered by RTP/AVP */
+		rx_crypto = NULL;
+	}
+
+	if(!rx_crypto) {
+		if(local_media->crypto && rtp_stream->remote_media->state == MPF_MEDIA_ENABLED) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Fall back to RTP: no SRTP crypto in answer");
+		}
+		local_media->crypto = NULL;
+	}
+	else if(!local_media->crypto || 
+		local_media->crypto->suite != rx_crypto->suite || local_media->crypto->tag != rx_crypto->tag) {
+		/* the remote side has chosen (or changed) the crypto suite */
+		local_media->crypto = mpf_srtp_crypto_create(rx_crypto->suite,rx_crypto->tag,rtp_stream->pool);
+	}
+
+	if(rtp_stream->srtp) {
+		if(rx_crypto && local_media->crypto == rtp_stream->srtp_tx_crypto &&
+			rx_crypto->suite == rtp_stream->srtp_rx_crypto.suite &&
+			memcmp(rx_crypto->key,rtp_stream->srtp_rx_crypto.key,rx_crypto->key_size) == 0) {
+			/* keys remain the same, keep the session (and its rollover counters) */
+			return;
+		}
+		mpf_srtp_destroy(rtp_stream->srtp);
+		rtp_stream->srtp = NULL;
+		rtp_stream->srtp_tx_crypto = NULL;
+	}
+
+	if(rx_crypto && local_media->crypto) {
+		const apt_str_t *suite = mpf_srtp_crypto_suite_str_get(rx_crypto->suite);
+		rtp_stream->srtp = mpf_srtp_create(local_media->crypto,rx_crypto,rtp_stream->pool);
+		if(rtp_stream->srtp) {
+			rtp_stream->srtp_tx_crypto = local_media->crypto;
+			rtp_stream->srtp_rx_crypto = *rx_crypto;
+			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Enable SRTP %s:%hu [%s]",
+				local_media->ip.buf,
+				local_media->port,
+				suite ? suite->buf : "");
+		}
+		else {
+			local_media->crypto = NULL;
+		}
+	}
+}
+
 static apt_bool_t mpf_rtp_stream_media_negotiate(mpf_rtp_stream_t *rtp_stream)
 {
 	mpf_rtp_media_descriptor_t *local_media = rtp_stream->local_media;
@@ -323,6 +529,23 @@ static apt_bool_t mpf_rtp_stream_media_negotiate(mpf_rtp_stream_t *rtp_stream)
 	local_media->mid = remote_media->mid;
 	local_media->ptime = remote_media->ptime;
 
+	/* RTCP is multiplexed with RTP only if both sides support it */
+	rtp_stream->rtcp_mux = (mpf_rtp_stream_rtcp_mux_supported(rtp_stream) == TRUE && remote_media->rtcp_mux == TRUE) ? TRUE : FALSE;
+	local_media->rtcp_mux = rtp_stream->rtcp_mux;
+	if(rtp_stream->rtcp_mux == TRUE) {
+		if(rtp_stream->rtcp_socket != rtp_stream->rtp_socket) {
+			if(rtp_stream->rtcp_socket && rtp_stream->shared == FALSE) {
+				apr_socket_close(rtp_stream->rtcp_socket);
+			}
+			rtp_stream->rtcp_socket = rtp_stream->rtp_socket;
+			rtp_stream->rtcp_l_sockaddr = rtp_stream->rtp_l_sockaddr;
+		}
+		rtp_stream->rtcp_r_sockaddr = rtp_stream->rtp_r_sockaddr;
+	}
+
+	/* SRTP is used only if both sides have agreed on the crypto suite */
+	mpf_rtp_stream_srtp_negotiate(rtp_stream);
+
 	if(rtp_stream->state == MPF_MEDIA_DISABLED && remote_media->state == MPF_MEDIA_ENABLED) {
 		/* enable RTP/RTCP session */
 		rtp_stream->state = MPF_MEDIA_ENABLED;
@@ -332,12 +555,7 @@ static apt_bool_t mpf_rtp_stream_media_negotiate(mpf_rtp_stream_t *rtp_stream)
 				rtp_stream->rtp_l_sockaddr->port);
 		}
 
-		if(rtp_stream->rtcp_tx_timer) {
-			apt_timer_set(rtp_stream->rtcp_tx_timer,rtp_stream->settings->rtcp_tx_interval);
-		}
-		if(rtp_stream->rtcp_rx_timer) {
-			apt_timer_set(rtp_stream->rtcp_rx_timer,rtp_stream->settings->rtcp_rx_resolution);
-		}
+		mpf_rtcp_start(rtp_stream);
 	}
 	else if(rtp_stream->state == MPF_MEDIA_ENABLED && remote_media->state == MPF_MEDIA_DISABLED) {
 		/* disable RTP/RTCP session */
@@ -348,12 +566,7 @@ static apt_bool_t mpf_rtp_stream_media_negotiate(mpf_rtp_stream_t *rtp_stream)
 				rtp_stream->rtp_l_sockaddr->port);
 		}
 
-		if(rtp_stream->rtcp_tx_timer) {
-			apt_timer_kill(rtp_stream->rtcp_tx_timer);
-		}
-		if(rtp_stream->rtcp_rx_timer) {
-			apt_timer_kill(rtp_stream->rtcp_rx_timer);
-		}
+		mpf_rtcp_stop(rtp_stream);
 		if(rtp_stream->settings->rtcp == TRUE && rtp_stream->settings->rtcp_bye_policy != RTCP_BYE_DISABLE) {
 			apt_str_t reason = {RTCP_BYE_SESSION_ENDED, sizeof(RTCP_BYE_SESSION_ENDED)-1};
 			mpf_rtcp_bye_send(rtp_stream,&reason);
@@ -377,7 +590,7 @@ static apt_bool_t mpf_rtp_stream_media_negotiate(mpf_rtp_stream_t *rtp_stream)
 			codec_list1 = &remote_media->codec_list;
 		}
 
-		if(mpf_codec_lists_intersect(codec_list1,codec_list2) == FALSE) {
+		if(mpf_codec_manager_codec_lists_intersect(rtp_stream->base->termination->codec_manager,codec_list1,codec_list2) == FALSE) {
 			/* reject RTP/RTCP session */
 			rtp_stream->state = MPF_MEDIA_DISABLED;
 			local_media->direction = STREAM_DIRECTION_NONE;
@@ -388,12 +601,7 @@ static apt_bool_t mpf_rtp_stream_media_negotiate(mpf_rtp_stream_t *rtp_stream)
 					rtp_stream->rtp_l_sockaddr->port);
 			}
 
-			if(rtp_stream->rtcp_tx_timer) {
-				apt_timer_kill(rtp_stream->rtcp_tx_timer);
-			}
-			if(rtp_stream->rtcp_rx_timer) {
-				apt_timer_kill(rtp_stream->rtcp_rx_timer);
-			}
+			mpf_rtcp_stop(rtp_stream);
 		}
 	}
 
@@ -401,8 +609,49 @@ static apt_bool_t mpf_rtp_stream_media_negotiate(mpf_rtp_stream_t *rtp_stream)
 	return TRUE;
 }
 
+static void mpf_rtp_stream_stat_fill(void *obj, mpf_rtp_stream_stat_t *stat)
+{
+	mpf_rtp_stream_t *rtp_stream = obj;
+	rtp_receiver_t *receiver = &rtp_stream->receiver;
+	mpf_codec_descriptor_t *descriptor = rtp_stream->base->rx_descriptor;
+	mpf_jitter_buffer_t *jb = receiver->jb;
+
+	/* called from a foreign thread, the values are read without synchronization */
+	if(rtp_stream->rtp_l_sockaddr) {
+		stat->local_port = rtp_stream->rtp_l_sockaddr->port;
+	}
+	if(rtp_stream->rtp_r_sockaddr) {
+		stat->remote_port = rtp_stream->rtp_r_sockaddr->port;
+	}
+	stat->rx_ssrc = receiver->rr_stat.ssrc;
+	stat->tx_ssrc = rtp_stream->transmitter.sr_stat.ssrc;
+	stat->rx_stat = receiver->stat;
+	stat->rx_stat.lost_packets = 0;
+	if(stat->rx_stat.received_packets) {
+		apr_uint32_t expected_packets = receiver->history.seq_cycles + 
+			receiver->history.seq_num_max - receiver->history.seq_num_base + 1;
+		if(expected_packets > stat->rx_stat.received_packets) {
+			stat->rx_stat.lost_packets = expected_packets - stat->rx_stat.received_packets;
+		}
+	}
+	if(descriptor && descriptor->sampling_rate) {
+		/* jitter is kept in timestamp units scaled by 16 */
+		stat->jitter = (apr_uint32_t)((apr_uint64_t)receiver->rr_stat.jitter * 1000 / 16 / 
+			(mpf_codec_rtp_clock_rate_get(descriptor) * descriptor->channel_count));
+	}
+	if(jb) {
+		stat->playout_delay = mpf_jitter_buffer_playout_delay_get(jb);
+	}
+	stat->sent_packets = rtp_stream->transmitter.sr_stat.sent_packets;
+	stat->sent_octets = rtp_stream->transmitter.sr_stat.sent_octets;
+}
+
 MPF_DECLARE(apt_bool_t) mpf_rtp_stream_add(mpf_audio_stream_t *stream)
 {
+	mpf_termination_t *termination = stream->termination;
+	if(termination && termination->media_engine) {
+		mpf_engine_rtp_stat_register(termination->media_engine,termination->worker_id,stream->obj,mpf_rtp_stream_stat_fill);
+	}
 	return TRUE;
 }
 
@@ -419,12 +668,7 @@ MPF_DECLARE(apt_bool_t) mpf_rtp_stream_remove(mpf_audio_stream_t *stream)
 				rtp_stream->rtp_l_sockaddr->port);
 		}
 
-		if(rtp_stream->rtcp_tx_timer) {
-			apt_timer_kill(rtp_stream->rtcp_tx_timer);
-		}
-		if(rtp_stream->rtcp_rx_timer) {
-			apt_timer_kill(rtp_stream->rtcp_rx_timer);
-		}
+		mpf_rtcp_stop(rtp_stream);
 		if(rtp_stream->settings->rtcp == TRUE && rtp_stream->settings->rtcp_bye_policy != RTCP_BYE_DISABLE) {
 			apt_str_t reason = {RTCP_BYE_SESSION_ENDED, sizeof(RTCP_BYE_SESSION_ENDED)-1};
 			mpf_rtcp_bye_send(rtp_stream,&reason);
@@ -432,17 +676,29 @@ MPF_DECLARE(apt_bool_t) mpf_rtp_stream_remove(mpf_audio_stream_t *stream)
 	}
 	
 	mpf_rtp_socket_pair_close(rtp_stream);
+	if(rtp_stream->srtp) {
+		mpf_srtp_destroy(rtp_stream->srtp);
+		rtp_stream->srtp = NULL;
+		rtp_stream->srtp_tx_crypto = NULL;
+	}
+	if(stream->termination && stream->termination->media_engine) {
+		mpf_engine_rtp_stat_unregister(stream->termination->media_engine,stream->termination->worker_id,rtp_stream);
+	}
 	return TRUE;
 }
 
 MPF_DECLARE(apt_bool_t) mpf_rtp_stream_modify(mpf_audio_stream_t *stream, mpf_rtp_stream_descriptor_t *descriptor)
 {
 	apt_bool_t status = TRUE;
+	apt_bool_t rtcp_offloaded;
 	mpf_rtp_stream_t *rtp_stream = stream->obj;
 	if(!rtp_stream) {
 		return FALSE;
 	}
 
+	/* the sockets and SRTP may change, offloaded RTCP is restarted afterwards */
+	rtcp_offloaded = mpf_rtcp_offload_stop(rtp_stream);
+
 	if(!rtp_stream->local_media) {
 		/* create local media */
 		status = mpf_rtp_stream_local_media_create(rtp_stream,descriptor->local,descriptor->remote,descriptor->capabilities);
@@ -470,6 +726,7 @@ MPF_DECLARE(apt_bool_t) mpf_rtp_stream_modify(mpf_audio_stream_t *stream, mpf_rt
 		if(codec_list->event_descriptor) {
 			rtp_stream->base->tx_event_descriptor = codec_list->event_descriptor;
 		}
+		rtp_stream->base->tx_cn_descriptor = codec_list->cn_descriptor;
 	}
 	if((rtp_stream->base->direction & STREAM_DIRECTION_RECEIVE) == STREAM_DIRECTION_RECEIVE) {
 		mpf_codec_list_t *codec_list = &rtp_stream->local_media->codec_list;
@@ -477,6 +734,11 @@ MPF_DECLARE(apt_bool_t) mpf_rtp_stream_modify(mpf_audio_stream_t *stream, mpf_rt
 		if(codec_list->event_descriptor) {
 			rtp_stream->base->rx_event_descriptor = codec_list->event_descriptor;
 		}
+		rtp_stream->base->rx_cn_descriptor = codec_list->cn_descriptor;
+	}
+
+	if(rtcp_offloaded == TRUE && rtp_stream->state == MPF_MEDIA_ENABLED) {
+		mpf_rtcp_start(rtp_stream);
 	}
 
 	if(!descriptor->local) {
@@ -490,23 +752,52 @@ static apt_bool_t mpf_rtp_stream_destroy(mpf_audio_stream_t *stream)
 	return TRUE;
 }
 
+/** Get the settings, which have replaced the specified ones at runtime with live update, last */
+static mpf_rtp_settings_t* mpf_rtp_settings_latest_get(mpf_rtp_settings_t *settings)
+{
+	mpf_rtp_settings_t *successor;
+	while(settings) {
+		successor = apr_atomic_casptr((volatile void**)&settings->successor,NULL,NULL);
+		if(!successor || successor->live_update == FALSE) {
+			break;
+		}
+		settings = successor;
+	}
+	return settings;
+}
+
 static apt_bool_t mpf_rtp_rx_stream_open(mpf_audio_stream_t *stream, mpf_codec_t *codec)
 {
 	mpf_rtp_stream_t *rtp_stream = stream->obj;
 	rtp_receiver_t *receiver = &rtp_stream->receiver;
-	mpf_jb_config_t *jb_config = &rtp_stream->settings->jb_config;
+	mpf_jb_config_t *jb_config;
 	if(!rtp_stream->rtp_socket || !rtp_stream->rtp_l_sockaddr || !rtp_stream->rtp_r_sockaddr) {
 		return FALSE;
 	}
 
+	/* a stream reopened (re-offer) starts with the settings in effect */
+	rtp_stream->rx_settings = mpf_rtp_settings_latest_get(rtp_stream->rx_settings);
+	rtp_stream->rx_codec = codec;
+	jb_config = &rtp_stream->rx_settings->jb_config;
 	receiver->jb = mpf_jitter_buffer_create(
 						jb_config,
 						stream->rx_descriptor,
 						codec,
+						rtp_stream->jb_slab,
 						rtp_stream->pool);
+	mpf_jitter_buffer_loss_mark_set(receiver->jb,rtp_stream->rx_settings->plc);
+
+	if(rtp_stream->uring && rtp_stream->shared == FALSE) {
+		/* datagrams are dispatched by the media worker through multishot receive */
+		rtp_stream->uring_rx = mpf_uring_recv_register(rtp_stream->uring,rtp_stream->rtp_socket,mpf_rtp_uring_packet_receive,rtp_stream);
+	}
+	if(rtp_stream->shared == FALSE && rtp_stream->uring_rx == FALSE) {
+		/* the socket is drained by the receiver on the tick */
+		rtp_rx_timestamp_enable(rtp_stream);
+	}
 
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,
-			"Open RTP Receiver %s:%hu <- %s:%hu playout [%u ms] bounds [%u - %u ms] adaptive [%d] skew detection [%d]",
+			"Open RTP Receiver %s:%hu <- %s:%hu playout [%u ms] bounds [%u - %u ms] adaptive [%d] skew detection [%d] bypass [%d]",
 			rtp_stream->rtp_l_sockaddr->hostname,
 			rtp_stream->rtp_l_sockaddr->port,
 			rtp_stream->rtp_r_sockaddr->hostname,
@@ -515,7 +806,8 @@ static apt_bool_t mpf_rtp_rx_stream_open(mpf_audio_stream_t *stream, mpf_codec_t
 			jb_config->min_playout_delay,
 			jb_config->max_playout_delay,
 			jb_config->adaptive,
-			jb_config->time_skew_detection);
+			jb_config->time_skew_detection,
+			jb_config->bypass);
 	return TRUE;
 }
 
@@ -548,7 +840,9 @@ static apt_bool_t mpf_rtp_rx_stream_close(mpf_audio_stream_t *stream)
 			mpf_jitter_buffer_playout_delay_get(receiver->jb),
 			receiver->stat.discarded_packets,
 			receiver->stat.ignored_packets);
+	mpf_rtp_uring_rx_stop(rtp_stream);
 	mpf_jitter_buffer_destroy(receiver->jb);
+	receiver->jb = NULL;
 	return TRUE;
 }
 
@@ -568,6 +862,51 @@ static APR_INLINE void rtp_rx_stat_init(rtp_receiver_t *receiver, rtp_header_t *
 	receiver->history.time_last = *time;
 }
 
+/** Re-create the jitter buffer with the settings replacing the current ones, at a point no audio is buffered */
+static void mpf_rtp_rx_settings_update(mpf_rtp_stream_t *rtp_stream)
+{
+	rtp_receiver_t *receiver = &rtp_stream->receiver;
+	mpf_rtp_settings_t *settings = mpf_rtp_settings_latest_get(rtp_stream->rx_settings);
+	mpf_jitter_buffer_t *jb;
+	if(settings == rtp_stream->rx_settings || !rtp_stream->rx_codec) {
+		return;
+	}
+
+	/* the decoder resamples by the excess, as long as it has been set up at stream creation */
+	if(rtp_stream->base->rx_skew_compensation == TRUE &&
+		(settings->jb_config.time_skew_detection != MPF_TIME_SKEW_RESAMPLE || settings->jb_config.bypass)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Skip RTP Settings Update %s:%hu: skew compensation mismatch",
+			rtp_stream->rtp_l_sockaddr->hostname,
+			rtp_stream->rtp_l_sockaddr->port);
+		rtp_stream->rx_settings = settings;
+		return;
+	}
+
+	jb = mpf_jitter_buffer_create(
+			&settings->jb_config,
+			rtp_stream->base->rx_descriptor,
+			rtp_stream->rx_codec,
+			rtp_stream->jb_slab,
+			rtp_stream->pool);
+	if(!jb) {
+		return;
+	}
+	mpf_jitter_buffer_loss_mark_set(jb,settings->plc);
+	mpf_jitter_buffer_destroy(receiver->jb);
+	receiver->jb = jb;
+	rtp_stream->rx_settings = settings;
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,
+			"Update RTP Receiver %s:%hu playout [%u ms] bounds [%u - %u ms] adaptive [%d] skew detection [%d] bypass [%d]",
+			rtp_stream->rtp_l_sockaddr->hostname,
+			rtp_stream->rtp_l_sockaddr->port,
+			settings->jb_config.initial_playout_delay,
+			settings->jb_config.min_playout_delay,
+			settings->jb_config.max_playout_delay,
+			settings->jb_config.adaptive,
+			settings->jb_config.time_skew_detection,
+			settings->jb_config.bypass);
+}
+
 static APR_INLINE void rtp_rx_restart(rtp_receiver_t *receiver)
 {
 	apr_byte_t restarts = ++receiver->stat.restarts;
@@ -748,7 +1087,7 @@ static APR_INLINE rtp_ts_result_e rtp_rx_ts_update(rtp_receiver_t *receiver, mpf
 	}
 
 	/* arrival time diff in samples */
-	deviation = time_diff * descriptor->channel_count * descriptor->sampling_rate / 1000;
+	deviation = time_diff * descriptor->channel_count * (apr_int32_t)mpf_codec_rtp_clock_rate_get(descriptor) / 1000;
 	/* arrival timestamp diff */
 	deviation -= ts - receiver->history.ts_last;
 
@@ -787,24 +1126,85 @@ static APR_INLINE void rtp_rx_failure_threshold_check(rtp_receiver_t *receiver)
 	}
 }
 
-static apt_bool_t rtp_rx_packet_receive(mpf_rtp_stream_t *rtp_stream, void *buffer, apr_size_t size)
+/* Gap threshold used in RTCP XR burst/gap metrics */
+#define RTCP_XR_GMIN 16
+
+/* Account a packet in RTCP XR burst statistics (RFC 3611 Appendix A.2) */
+static APR_INLINE void rtcp_xr_burst_account(rtcp_xr_burst_stat_t *burst_stat, apt_bool_t lost)
+{
+	if(lost == FALSE) {
+		burst_stat->pkt++;
+		return;
+	}
+
+	if(burst_stat->pkt >= RTCP_XR_GMIN) {
+		if(burst_stat->lost == 1) {
+			burst_stat->c14++;
+		}
+		else {
+			burst_stat->c13++;
+		}
+		burst_stat->lost = 1;
+		burst_stat->c11 += burst_stat->pkt;
+	}
+	else {
+		burst_stat->lost++;
+		if(burst_stat->pkt == 0) {
+			burst_stat->c33++;
+		}
+		else {
+			burst_stat->c23++;
+			burst_stat->c22 += burst_stat->pkt - 1;
+		}
+	}
+	burst_stat->pkt = 0;
+}
+
+/** Write the start and the end of named event to the event sink on arrival, skipping updates and retransmissions */
+static void rtp_rx_event_direct_write(mpf_rtp_stream_t *rtp_stream, const mpf_named_event_frame_t *named_event, apr_uint32_t ts)
+{
+	mpf_audio_stream_t *sink = rtp_stream->base->rx_event_sink;
+	mpf_frame_t frame;
+	frame.type = MEDIA_FRAME_TYPE_EVENT;
+	frame.event_frame = *named_event;
+	frame.codec_frame.buffer = NULL;
+	frame.codec_frame.size = 0;
+
+	if(rtp_stream->event_direct_started == FALSE || ts != rtp_stream->event_direct_ts) {
+		/* packets of an event (segment) share the timestamp, the next segment of
+		a long-lasting event goes on with the same identifier and no end written */
+		if(rtp_stream->event_direct_active == FALSE || named_event->event_id != rtp_stream->event_direct_id) {
+			frame.marker = MPF_MARKER_START_OF_EVENT;
+			sink->vtable->write_event(sink,&frame);
+		}
+		rtp_stream->event_direct_ts = ts;
+		rtp_stream->event_direct_id = (apr_byte_t)named_event->event_id;
+		rtp_stream->event_direct_started = TRUE;
+		rtp_stream->event_direct_active = TRUE;
+	}
+
+	if(named_event->edge == 1 && rtp_stream->event_direct_active == TRUE) {
+		frame.marker = MPF_MARKER_END_OF_EVENT;
+		sink->vtable->write_event(sink,&frame);
+		rtp_stream->event_direct_active = FALSE;
+	}
+}
+
+static apt_bool_t rtp_rx_packet_process(mpf_rtp_stream_t *rtp_stream, rtp_header_t *header, void *buffer, apr_size_t size, apt_bool_t in_slots, apr_time_t arrival_time)
 {
 	rtp_receiver_t *receiver = &rtp_stream->receiver;
 	mpf_codec_descriptor_t *descriptor = rtp_stream->base->rx_descriptor;
 	apr_time_t time;
 	rtp_ssrc_result_e ssrc_result;
-	rtp_header_t *header = rtp_rx_header_skip(&buffer,&size);
-	if(!header) {
-		/* invalid RTP packet */
-		receiver->stat.invalid_packets++;
-		return FALSE;
-	}
+	apr_uint16_t seq_num_max;
+	apt_bool_t discarded = FALSE;
 
 	header->sequence = ntohs((apr_uint16_t)header->sequence);
 	header->timestamp = ntohl(header->timestamp);
 	header->ssrc = ntohl(header->ssrc);
 
-	time = apr_time_now();
+	/* packets drained on the tick would all look simultaneous, the kernel timestamp is used if known */
+	time = arrival_time ? arrival_time : apr_time_now();
 
 	RTP_TRACE("RTP time=%6u ssrc=%8x pt=%3u %cts=%9u seq=%5u size=%"APR_SIZE_T_FMT"\n",
 					(apr_uint32_t)apr_time_usec(time),
@@ -822,21 +1222,46 @@ static apt_bool_t rtp_rx_packet_receive(mpf_rtp_stream_t *rtp_stream, void *buff
 	}
 	else if(ssrc_result == RTP_SSRC_RESTART) {
 		rtp_rx_restart(receiver);
+		mpf_rtp_rx_settings_update(rtp_stream);
 		rtp_rx_stat_init(receiver,header,&time);
 	}
 
-	rtp_rx_seq_update(receiver,(apr_uint16_t)header->sequence);
+	seq_num_max = receiver->history.seq_num_max;
+	if(rtp_rx_seq_update(receiver,(apr_uint16_t)header->sequence) == RTP_SEQ_UPDATE && 
+		rtp_stream->settings->rtcp_xr == TRUE) {
+		/* account the packets missing in front of this one as lost */
+		apr_uint16_t gap = (apr_uint16_t)header->sequence - seq_num_max;
+		while(gap > 1) {
+			rtcp_xr_burst_account(&receiver->burst_stat,TRUE);
+			gap--;
+		}
+	}
 	
 	if(header->type == descriptor->payload_type) {
 		/* codec */
+		char payload[MAX_RTP_PACKET_SIZE];
 		apr_byte_t marker = (apr_byte_t)header->marker;
 		if(rtp_rx_ts_update(receiver,descriptor,&time,header->timestamp,&marker) == RTP_TS_DRIFT) {
 			rtp_rx_restart(receiver);
+			mpf_rtp_rx_settings_update(rtp_stream);
 			return FALSE;
 		}
-	
+		if(marker && mpf_jitter_buffer_is_empty(receiver->jb) == TRUE) {
+			/* the talkspurt starts with nothing buffered, the payload is moved out of the slots then */
+			mpf_rtp_rx_settings_update(rtp_stream);
+		}
+
+		if(in_slots == TRUE && 
+			mpf_jitter_buffer_slots_match(receiver->jb,buffer,header->timestamp,marker) == FALSE) {
+			/* the payload doesn't belong to the slots it has been received into,
+			move it out before the slots get written */
+			memcpy(payload,buffer,size);
+			buffer = payload;
+		}
+
 		if(mpf_jitter_buffer_write(receiver->jb,buffer,size,header->timestamp,marker) != JB_OK) {
 			receiver->stat.discarded_packets++;
+			discarded = TRUE;
 			rtp_rx_failure_threshold_check(receiver);
 		}
 	}
@@ -845,10 +1270,20 @@ static apt_bool_t rtp_rx_packet_receive(mpf_rtp_stream_t *rtp_stream, void *buff
 		/* named event */
 		mpf_named_event_frame_t *named_event = (mpf_named_event_frame_t *)buffer;
 		named_event->duration = ntohs((apr_uint16_t)named_event->duration);
+		if(rtp_stream->base->rx_event_sink) {
+			/* no need to wait for the playout delay, the event is complete as received */
+			rtp_rx_event_direct_write(rtp_stream,named_event,header->timestamp);
+		}
 		if(mpf_jitter_buffer_event_write(receiver->jb,named_event,header->timestamp,(apr_byte_t)header->marker) != JB_OK) {
 			receiver->stat.discarded_packets++;
 		}
 	}
+	else if(rtp_stream->base->rx_cn_descriptor && 
+		header->type == rtp_stream->base->rx_cn_descriptor->payload_type && size) {
+		/* CN packet, the noise is generated until the next talkspurt */
+		receiver->cn_level = *(apr_byte_t*)buffer & 0x7f;
+		receiver->cn = TRUE;
+	}
 	else if(header->type == RTP_PT_CN) {
 		/* CN packet */
 		receiver->stat.ignored_packets++;
@@ -857,30 +1292,265 @@ static apt_bool_t rtp_rx_packet_receive(mpf_rtp_stream_t *rtp_stream, void *buff
 		/* invalid payload type */
 		receiver->stat.ignored_packets++;
 	}
+
+	if(rtp_stream->settings->rtcp_xr == TRUE) {
+		rtcp_xr_burst_account(&receiver->burst_stat,discarded);
+	}
 	
 	return TRUE;
 }
 
+static apt_bool_t rtp_rx_packet_receive(mpf_rtp_stream_t *rtp_stream, void *buffer, apr_size_t size, apr_time_t arrival_time)
+{
+	rtp_header_t *header;
+	APT_PROBE2(rtp_rx_packet,rtp_stream,size);
+	if(rtp_stream->srtp && mpf_srtp_unprotect(rtp_stream->srtp,buffer,&size) == FALSE) {
+		/* not authenticated or replayed SRTP packet, decrypted in place otherwise */
+		rtp_stream->receiver.stat.invalid_packets++;
+		return FALSE;
+	}
+
+	header = rtp_rx_header_skip(&buffer,&size);
+	if(!header) {
+		/* invalid RTP packet */
+		rtp_stream->receiver.stat.invalid_packets++;
+		return FALSE;
+	}
+	return rtp_rx_packet_process(rtp_stream,header,buffer,size,FALSE,arrival_time);
+}
+
+/** Receive datagram of the RTP socket (arrival time is 0 if unknown) */
+static apt_bool_t rtp_rx_datagram_receive(mpf_rtp_stream_t *rtp_stream, char *buffer, apr_size_t size, apr_time_t arrival_time)
+{
+	if(rtp_stream->rtcp_mux == TRUE && size > 1 &&
+		(apr_byte_t)buffer[1] >= 192 && (apr_byte_t)buffer[1] <= 223) {
+		/* RTCP packet multiplexed with RTP (RFC 5761) */
+		return mpf_rtcp_compound_packet_receive(rtp_stream,buffer,size);
+	}
+	return rtp_rx_packet_receive(rtp_stream,buffer,size,arrival_time);
+}
+
+static void mpf_rtp_demux_packet_receive(void *obj, char *buffer, apr_size_t size, apt_bool_t rtcp)
+{
+	mpf_rtp_stream_t *rtp_stream = obj;
+	if(rtcp == TRUE) {
+		if(rtp_stream->settings->rtcp == TRUE) {
+			mpf_rtcp_compound_packet_receive(rtp_stream,buffer,size);
+		}
+		return;
+	}
+
+	if(rtp_stream->receiver.jb) {
+		/* receiver is open */
+		rtp_rx_packet_receive(rtp_stream,buffer,size,0);
+	}
+}
+
+static void mpf_rtp_uring_packet_receive(void *obj, char *buffer, apr_size_t size)
+{
+	mpf_rtp_stream_t *rtp_stream = obj;
+	if(rtp_stream->receiver.jb) {
+		rtp_rx_datagram_receive(rtp_stream,buffer,size,0);
+	}
+}
+
+static void mpf_rtp_uring_rx_stop(mpf_rtp_stream_t *rtp_stream)
+{
+	if(rtp_stream->uring_rx == TRUE) {
+		mpf_uring_recv_unregister(rtp_stream->uring,rtp_stream);
+		rtp_stream->uring_rx = FALSE;
+	}
+}
+
+#ifdef ENABLE_RTP_RX_TIMESTAMP
+/** Size of control data of received message carrying the kernel timestamp */
+#define RTP_RX_CONTROL_SIZE CMSG_SPACE(sizeof(struct timespec))
+
+/** Get the kernel receive timestamp of the message (0 if not present) */
+static APR_INLINE apr_time_t rtp_rx_timestamp_get(struct msghdr *msg_hdr)
+{
+	struct cmsghdr *cmsg;
+	if(msg_hdr->msg_flags & MSG_CTRUNC) {
+		return 0;
+	}
+	for(cmsg = CMSG_FIRSTHDR(msg_hdr); cmsg; cmsg = CMSG_NXTHDR(msg_hdr,cmsg)) {
+		if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+			struct timespec ts;
+			memcpy(&ts,CMSG_DATA(cmsg),sizeof(ts));
+			return apr_time_from_sec(ts.tv_sec) + ts.tv_nsec / 1000;
+		}
+	}
+	return 0;
+}
+#endif
+
+/** Ask the kernel to timestamp the datagrams received by the RTP socket */
+static void rtp_rx_timestamp_enable(mpf_rtp_stream_t *rtp_stream)
+{
+#ifdef ENABLE_RTP_RX_TIMESTAMP
+	apr_os_sock_t fd;
+	int on = 1;
+	if(apr_os_sock_get(&fd,rtp_stream->rtp_socket) != APR_SUCCESS) {
+		return;
+	}
+	if(setsockopt(fd,SOL_SOCKET,SO_TIMESTAMPNS,&on,sizeof(on)) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Failed to Enable Kernel Receive Timestamps of RTP Socket");
+	}
+#endif
+}
+
+#ifdef ENABLE_RTP_RECVMMSG
+static apt_bool_t rtp_rx_scattered_receive(mpf_rtp_stream_t *rtp_stream, rtp_header_t *header, void *slots, apr_size_t slots_size, char *buffer, apr_size_t size, apr_time_t arrival_time)
+{
+	apr_size_t header_size = sizeof(rtp_header_t);
+	apr_size_t slots_used = 0;
+	if(size > header_size) {
+		apr_size_t payload_size = size - header_size;
+		if(header->version == RTP_VERSION && !header->count && !header->extension &&
+			header->type == rtp_stream->base->rx_descriptor->payload_type && payload_size <= slots_size) {
+			/* plain RTP packet, its payload has been received into the jitter buffer slots */
+			return rtp_rx_packet_process(rtp_stream,header,slots,payload_size,TRUE,arrival_time);
+		}
+
+		slots_used = payload_size;
+		if(slots_used > slots_size) {
+			slots_used = slots_size;
+		}
+	}
+	else {
+		header_size = size;
+	}
+
+	/* reassemble the datagram in the overflow buffer and process it ordinarily */
+	memmove(buffer + header_size + slots_used,buffer,size - header_size - slots_used);
+	memcpy(buffer + header_size,slots,slots_used);
+	memcpy(buffer,header,header_size);
+	return rtp_rx_datagram_receive(rtp_stream,buffer,size,arrival_time);
+}
+
+
+static apt_bool_t rtp_rx_process(mpf_rtp_stream_t *rtp_stream)
+{
+	char buffers[RTP_RX_BATCH_SIZE][MAX_RTP_PACKET_SIZE];
+	struct iovec iovecs[RTP_RX_BATCH_SIZE + 2];
+	struct mmsghdr msgs[RTP_RX_BATCH_SIZE];
+#ifdef ENABLE_RTP_RX_TIMESTAMP
+	apr_uint64_t controls[RTP_RX_BATCH_SIZE][(RTP_RX_CONTROL_SIZE + 7) / 8];
+#endif
+	apr_time_t arrival_time = 0;
+	rtp_header_t header;
+	void *slots = NULL;
+	apr_size_t slots_size = 0;
+	apr_os_sock_t fd;
+	int count;
+	int i;
+
+	if(apr_os_sock_get(&fd,rtp_stream->rtp_socket) != APR_SUCCESS) {
+		return FALSE;
+	}
+
+	/* drain up to RTP_RX_BATCH_SIZE packets by a single syscall,
+	the empty socket costs one call returning EAGAIN instead of one per attempt */
+	memset(msgs,0,sizeof(msgs));
+	for(i=0; i<RTP_RX_BATCH_SIZE; i++) {
+		iovecs[i+2].iov_base = buffers[i];
+		iovecs[i+2].iov_len = MAX_RTP_PACKET_SIZE;
+		msgs[i].msg_hdr.msg_iov = &iovecs[i+2];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+#ifdef ENABLE_RTP_RX_TIMESTAMP
+		msgs[i].msg_hdr.msg_control = controls[i];
+		msgs[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+#endif
+	}
+
+	/* scatter the first packet: the fixed header goes aside and the payload goes
+	right into the jitter buffer slots it is expected to occupy, saving a copy;
+	the rest of the datagram (if any) goes to the first buffer */
+	if(!rtp_stream->srtp) {
+		/* SRTP packet is authenticated and decrypted as a whole */
+		slots = mpf_jitter_buffer_slots_get(rtp_stream->receiver.jb,&slots_size);
+	}
+	if(slots) {
+		if(slots_size > MAX_RTP_PACKET_SIZE - sizeof(rtp_header_t)) {
+			slots_size = MAX_RTP_PACKET_SIZE - sizeof(rtp_header_t);
+		}
+		iovecs[0].iov_base = &header;
+		iovecs[0].iov_len = sizeof(rtp_header_t);
+		iovecs[1].iov_base = slots;
+		iovecs[1].iov_len = slots_size;
+		iovecs[2].iov_len = MAX_RTP_PACKET_SIZE - sizeof(rtp_header_t) - slots_size;
+		msgs[0].msg_hdr.msg_iov = &iovecs[0];
+		msgs[0].msg_hdr.msg_iovlen = 3;
+	}
+
+	count = recvmmsg(fd,msgs,RTP_RX_BATCH_SIZE,MSG_DONTWAIT,NULL);
+	for(i=0; i<count; i++) {
+#ifdef ENABLE_RTP_RX_TIMESTAMP
+		arrival_time = rtp_rx_timestamp_get(&msgs[i].msg_hdr);
+#endif
+		if(i == 0 && slots) {
+			rtp_rx_scattered_receive(rtp_stream,&header,slots,slots_size,buffers[0],msgs[0].msg_len,arrival_time);
+			continue;
+		}
+		rtp_rx_datagram_receive(rtp_stream,buffers[i],msgs[i].msg_len,arrival_time);
+	}
+	return TRUE;
+}
+#else
 static apt_bool_t rtp_rx_process(mpf_rtp_stream_t *rtp_stream)
 {
 	char buffer[MAX_RTP_PACKET_SIZE];
 	apr_size_t size = sizeof(buffer);
-	apr_size_t max_count = 5;
+	apr_size_t max_count = RTP_RX_BATCH_SIZE;
 	while(max_count && apr_socket_recv(rtp_stream->rtp_socket,buffer,&size) == APR_SUCCESS) {
-		rtp_rx_packet_receive(rtp_stream,buffer,size);
+		rtp_rx_datagram_receive(rtp_stream,buffer,size,0);
 
 		size = sizeof(buffer);
 		max_count--;
 	}
 	return TRUE;
 }
+#endif
+
+static apt_bool_t mpf_rtp_stream_pending_receive(mpf_audio_stream_t *stream)
+{
+	mpf_rtp_stream_t *rtp_stream = stream->obj;
+	if(rtp_stream->shared == TRUE) {
+		/* packets are dispatched to the jitter buffers by the demultiplexer */
+		mpf_rtp_demux_process(rtp_stream->demux);
+	}
+	else if(rtp_stream->uring_rx == FALSE) {
+		rtp_rx_process(rtp_stream);
+	}
+	return TRUE;
+}
 
 static apt_bool_t mpf_rtp_stream_receive(mpf_audio_stream_t *stream, mpf_frame_t *frame)
 {
 	mpf_rtp_stream_t *rtp_stream = stream->obj;
-	rtp_rx_process(rtp_stream);
+	mpf_rtp_stream_pending_receive(stream);
+	mpf_rtcp_offload_serve(rtp_stream);
+
+	if(mpf_jitter_buffer_read(rtp_stream->receiver.jb,frame) == FALSE) {
+		return FALSE;
+	}
+	if(stream->rx_skew_compensation == TRUE && (frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO) {
+		/* measured while packets keep coming only, silence suppression would drain the buffer */
+		stream->rx_skew = mpf_jitter_buffer_excess_get(rtp_stream->receiver.jb);
+	}
 
-	return mpf_jitter_buffer_read(rtp_stream->receiver.jb,frame);
+	if(rtp_stream->receiver.cn == TRUE) {
+		if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO) {
+			/* talkspurt resumed */
+			rtp_stream->receiver.cn = FALSE;
+		}
+		else {
+			/* silence period, pass the noise level on to the decoder */
+			frame->type = (frame->type & ~MEDIA_FRAME_TYPE_LOST) | MEDIA_FRAME_TYPE_CN;
+			*(apr_byte_t*)frame->codec_frame.buffer = rtp_stream->receiver.cn_level;
+		}
+	}
+	return TRUE;
 }
 
 
@@ -906,17 +1576,31 @@ static apt_bool_t mpf_rtp_tx_stream_open(mpf_audio_stream_t *stream, mpf_codec_t
 			transmitter->ptime = 20;
 		}
 	}
+	if(transmitter->ptime % CODEC_FRAME_TIME_BASE != 0) {
+		/* ptime should be aligned to the frame time of the media engine */
+		apr_uint16_t ptime = transmitter->ptime + CODEC_FRAME_TIME_BASE - transmitter->ptime % CODEC_FRAME_TIME_BASE;
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Align RTP Transmitter ptime %hu -> %hu ms",transmitter->ptime,ptime);
+		transmitter->ptime = ptime;
+	}
 	transmitter->packet_frames = transmitter->ptime / CODEC_FRAME_TIME_BASE;
 	transmitter->current_frames = 0;
+	if(mpf_codec_packet_frames_max_get(stream->tx_descriptor) == 1) {
+		/* frames cannot be concatenated, send one per packet whatever ptime is */
+		transmitter->packet_frames = 1;
+	}
 
 	frame_size = mpf_codec_frame_size_calculate(
 							stream->tx_descriptor,
 							codec->attribs);
+	/* reserve room for SRTP authentication tag appended in place */
 	transmitter->packet_data = apr_palloc(
 							rtp_stream->pool,
-							sizeof(rtp_header_t) + transmitter->packet_frames * frame_size);
+							sizeof(rtp_header_t) + transmitter->packet_frames * frame_size + MPF_SRTP_MAX_TRAILER_SIZE);
 	
 	transmitter->inactivity = 1;
+	/* let the first silence period be signaled at once */
+	transmitter->cn_timestamp = transmitter->timestamp -
+		transmitter->samples_per_frame * MPF_CN_UPDATE_INTERVAL / CODEC_FRAME_TIME_BASE;
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Open RTP Transmitter %s:%hu -> %s:%hu",
 			rtp_stream->rtp_l_sockaddr->hostname,
 			rtp_stream->rtp_l_sockaddr->port,
@@ -959,9 +1643,46 @@ static APR_INLINE void rtp_header_prepare(
 	header->ssrc = htonl(transmitter->sr_stat.ssrc);
 }
 
-static APR_INLINE apt_bool_t mpf_rtp_data_send(mpf_rtp_stream_t *rtp_stream, rtp_transmitter_t *transmitter, const mpf_frame_t *frame)
+static APR_INLINE apt_bool_t mpf_rtp_packet_send(mpf_rtp_stream_t *rtp_stream, char *data, apr_size_t *size)
+{
+	if(rtp_stream->srtp && mpf_srtp_protect(rtp_stream->srtp,data,size) == FALSE) {
+		return FALSE;
+	}
+	if(rtp_stream->tx_batch) {
+		/* queue packet to be sent at the end of the media tick */
+		return mpf_tx_batch_add(rtp_stream->tx_batch,rtp_stream->rtp_socket,rtp_stream->rtp_r_sockaddr,data,*size);
+	}
+	return apr_socket_sendto(rtp_stream->rtp_socket,rtp_stream->rtp_r_sockaddr,0,data,size) == APR_SUCCESS ? TRUE : FALSE;
+}
+
+static APR_INLINE apt_bool_t mpf_rtp_data_flush(mpf_rtp_stream_t *rtp_stream, rtp_transmitter_t *transmitter)
 {
 	apt_bool_t status = TRUE;
+	rtp_header_t *header = (rtp_header_t*)transmitter->packet_data;
+	apr_uint32_t payload_size = (apr_uint32_t)transmitter->packet_size - sizeof(rtp_header_t);
+	header->sequence = htons(++transmitter->last_seq_num);
+	RTP_TRACE("> RTP time=%6u ssrc=%8x pt=%3u %cts=%9u seq=%5hu\n",
+		(apr_uint32_t)apr_time_usec(apr_time_now()),
+		transmitter->sr_stat.ssrc, header->type, 
+		(header->marker == 1) ? '*' : ' ',
+		header->timestamp, transmitter->last_seq_num);
+	header->timestamp = htonl(header->timestamp);
+	if(mpf_rtp_packet_send(
+				rtp_stream,
+				transmitter->packet_data,
+				&transmitter->packet_size) == TRUE) {
+		transmitter->sr_stat.sent_packets++;
+		transmitter->sr_stat.sent_octets += payload_size;
+	}
+	else {
+		status = FALSE;
+	}
+	transmitter->current_frames = 0;
+	return status;
+}
+
+static APR_INLINE apt_bool_t mpf_rtp_data_send(mpf_rtp_stream_t *rtp_stream, rtp_transmitter_t *transmitter, const mpf_frame_t *frame)
+{
 	memcpy(
 		transmitter->packet_data + transmitter->packet_size,
 		frame->codec_frame.buffer,
@@ -969,34 +1690,14 @@ static APR_INLINE apt_bool_t mpf_rtp_data_send(mpf_rtp_stream_t *rtp_stream, rtp
 	transmitter->packet_size += frame->codec_frame.size;
 
 	if(++transmitter->current_frames == transmitter->packet_frames) {
-		rtp_header_t *header = (rtp_header_t*)transmitter->packet_data;
-		header->sequence = htons(++transmitter->last_seq_num);
-		RTP_TRACE("> RTP time=%6u ssrc=%8x pt=%3u %cts=%9u seq=%5hu\n",
-			(apr_uint32_t)apr_time_usec(apr_time_now()),
-			transmitter->sr_stat.ssrc, header->type, 
-			(header->marker == 1) ? '*' : ' ',
-			header->timestamp, transmitter->last_seq_num);
-		header->timestamp = htonl(header->timestamp);
-		if(apr_socket_sendto(
-					rtp_stream->rtp_socket,
-					rtp_stream->rtp_r_sockaddr,
-					0,
-					transmitter->packet_data,
-					&transmitter->packet_size) == APR_SUCCESS) {
-			transmitter->sr_stat.sent_packets++;
-			transmitter->sr_stat.sent_octets += (apr_uint32_t)transmitter->packet_size - sizeof(rtp_header_t);
-		}
-		else {
-			status = FALSE;
-		}
-		transmitter->current_frames = 0;
+		return mpf_rtp_data_flush(rtp_stream,transmitter);
 	}
-	return status;
+	return TRUE;
 }
 
 static APR_INLINE apt_bool_t mpf_rtp_event_send(mpf_rtp_stream_t *rtp_stream, rtp_transmitter_t *transmitter, const mpf_frame_t *frame)
 {
-	char packet_data[20];
+	char packet_data[sizeof(rtp_header_t) + sizeof(mpf_named_event_frame_t) + MPF_SRTP_MAX_TRAILER_SIZE];
 	apr_size_t packet_size = sizeof(rtp_header_t) + sizeof(mpf_named_event_frame_t);
 	rtp_header_t *header = (rtp_header_t*) packet_data;
 	mpf_named_event_frame_t *named_event = (mpf_named_event_frame_t*)(header+1);
@@ -1020,12 +1721,7 @@ static APR_INLINE apt_bool_t mpf_rtp_event_send(mpf_rtp_stream_t *rtp_stream, rt
 		(named_event->edge == 1) ? '*' : ' ');
 	header->timestamp = htonl(header->timestamp);
 	named_event->duration = htons((apr_uint16_t)named_event->duration);
-	if(apr_socket_sendto(
-				rtp_stream->rtp_socket,
-				rtp_stream->rtp_r_sockaddr,
-				0,
-				packet_data,
-				&packet_size) != APR_SUCCESS) {
+	if(mpf_rtp_packet_send(rtp_stream,packet_data,&packet_size) == FALSE) {
 		return FALSE;
 	}
 	transmitter->sr_stat.sent_packets++;
@@ -1033,12 +1729,80 @@ static APR_INLINE apt_bool_t mpf_rtp_event_send(mpf_rtp_stream_t *rtp_stream, rt
 	return TRUE;
 }
 
+static APR_INLINE apt_bool_t mpf_rtp_cn_send(mpf_rtp_stream_t *rtp_stream, rtp_transmitter_t *transmitter, apr_byte_t level)
+{
+	char packet_data[sizeof(rtp_header_t) + 1 + MPF_SRTP_MAX_TRAILER_SIZE];
+	apr_size_t packet_size = sizeof(rtp_header_t) + 1;
+	rtp_header_t *header = (rtp_header_t*) packet_data;
+	rtp_header_prepare(
+		transmitter,
+		header,
+		rtp_stream->base->tx_cn_descriptor->payload_type,
+		0,
+		transmitter->timestamp);
+	*(apr_byte_t*)(header+1) = level;
+
+	header->sequence = htons(++transmitter->last_seq_num);
+	RTP_TRACE("> RTP time=%6u ssrc=%8x pt=%3u  ts=%9u seq=%5hu cn=%3u\n",
+		(apr_uint32_t)apr_time_usec(apr_time_now()),
+		transmitter->sr_stat.ssrc, header->type,
+		header->timestamp, transmitter->last_seq_num, level);
+	header->timestamp = htonl(header->timestamp);
+	if(mpf_rtp_packet_send(rtp_stream,packet_data,&packet_size) == FALSE) {
+		return FALSE;
+	}
+	transmitter->cn_level = level;
+	transmitter->cn_timestamp = transmitter->timestamp;
+	transmitter->sr_stat.sent_packets++;
+	transmitter->sr_stat.sent_octets += 1;
+	return TRUE;
+}
+
+static apt_bool_t mpf_rtp_cn_transmit(mpf_audio_stream_t *stream, const mpf_frame_t *frame)
+{
+	apt_bool_t status = TRUE;
+	mpf_rtp_stream_t *rtp_stream = stream->obj;
+	rtp_transmitter_t *transmitter = &rtp_stream->transmitter;
+	apr_byte_t level = *(const apr_byte_t*)frame->codec_frame.buffer & 0x7f;
+	apr_uint32_t update_interval = transmitter->samples_per_frame * MPF_CN_UPDATE_INTERVAL / CODEC_FRAME_TIME_BASE;
+
+	if(!transmitter->inactivity) {
+		if(transmitter->current_frames) {
+			/* send the pending frames out instead of waiting for ptime */
+			status = mpf_rtp_data_flush(rtp_stream,transmitter);
+		}
+		/* the talkspurt ends, signal the noise level at once */
+		transmitter->inactivity = 1;
+		if(mpf_rtp_cn_send(rtp_stream,transmitter,level) == FALSE) {
+			status = FALSE;
+		}
+		return status;
+	}
+
+	if(transmitter->timestamp - transmitter->cn_timestamp >= update_interval ||
+		level >= transmitter->cn_level + MPF_CN_LEVEL_DELTA ||
+		level + MPF_CN_LEVEL_DELTA <= transmitter->cn_level) {
+		/* refresh the noise level */
+		status = mpf_rtp_cn_send(rtp_stream,transmitter,level);
+	}
+	return status;
+}
+
 static apt_bool_t mpf_rtp_stream_transmit(mpf_audio_stream_t *stream, const mpf_frame_t *frame)
 {
 	apt_bool_t status = TRUE;
 	mpf_rtp_stream_t *rtp_stream = stream->obj;
 	rtp_transmitter_t *transmitter = &rtp_stream->transmitter;
 
+	if(rtp_stream->shared == TRUE && !rtp_stream->receiver.jb) {
+		/* send-only stream still drains the shared sockets for RTCP and the other streams */
+		mpf_rtp_demux_process(rtp_stream->demux);
+	}
+	if(!rtp_stream->receiver.jb) {
+		/* served along with the reception otherwise */
+		mpf_rtcp_offload_serve(rtp_stream);
+	}
+
 	transmitter->timestamp += transmitter->samples_per_frame;
 
 	if(frame->type == MEDIA_FRAME_TYPE_NONE) {
@@ -1075,6 +1839,13 @@ static apt_bool_t mpf_rtp_stream_transmit(mpf_audio_stream_t *stream, const mpf_
 		}
 	}
 
+	if((frame->type & MEDIA_FRAME_TYPE_CN) == MEDIA_FRAME_TYPE_CN){
+		/* silence period, send CN updates instead of audio (DTX) */
+		if(stream->tx_cn_descriptor) {
+			status = mpf_rtp_cn_transmit(stream,frame);
+		}
+	}
+
 	if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO){
 		if(transmitter->current_frames == 0) {
 			rtp_header_t *header = (rtp_header_t*)transmitter->packet_data;
@@ -1174,26 +1945,178 @@ static apt_bool_t mpf_rtp_socket_pair_bind(mpf_rtp_stream_t *stream, mpf_rtp_med
 	return TRUE;
 }
 
+/* Attach to RTP/RTCP sockets shared by the streams of the media worker */
+static apt_bool_t mpf_rtp_shared_socket_pair_attach(mpf_rtp_stream_t *stream, mpf_rtp_media_descriptor_t *local_media)
+{
+	stream->rtp_socket = mpf_rtp_demux_rtp_socket_get(stream->demux);
+	stream->rtp_l_sockaddr = mpf_rtp_demux_rtp_sockaddr_get(stream->demux);
+	stream->rtcp_socket = mpf_rtp_demux_rtcp_socket_get(stream->demux);
+	stream->rtcp_l_sockaddr = mpf_rtp_demux_rtcp_sockaddr_get(stream->demux);
+	stream->shared = TRUE;
+	local_media->port = stream->rtp_l_sockaddr->port;
+	return TRUE;
+}
+
+/* Take RTP/RTCP sockets created and bound in advance, if any ready */
+static apt_bool_t mpf_rtp_pooled_socket_pair_attach(mpf_rtp_stream_t *stream, mpf_rtp_media_descriptor_t *local_media)
+{
+	mpf_rtp_socket_pair_t *pair;
+	if(!stream->config->socket_pool) {
+		return FALSE;
+	}
+	pair = mpf_rtp_socket_pool_get(stream->config->socket_pool);
+	if(!pair) {
+		return FALSE;
+	}
+	stream->socket_pair = pair;
+	stream->rtp_socket = pair->rtp_socket;
+	stream->rtp_l_sockaddr = pair->rtp_sockaddr;
+	stream->rtcp_socket = pair->rtcp_socket;
+	stream->rtcp_l_sockaddr = pair->rtcp_sockaddr;
+	local_media->port = pair->port;
+	return TRUE;
+}
+
 /* Close RTP/RTCP sockets */
 static void mpf_rtp_socket_pair_close(mpf_rtp_stream_t *stream)
 {
+	/* multishot receive should be cancelled before the socket is closed */
+	mpf_rtp_uring_rx_stop(stream);
+	if(stream->shared == TRUE) {
+		/* shared sockets are owned by the demultiplexer */
+		mpf_rtp_demux_route_remove(stream->demux,stream);
+		stream->rtp_socket = NULL;
+		stream->rtcp_socket = NULL;
+		stream->shared = FALSE;
+		return;
+	}
+	if(stream->socket_pair) {
+		/* pooled sockets are closed in background */
+		mpf_rtp_socket_pool_put(stream->config->socket_pool,stream->socket_pair);
+		stream->socket_pair = NULL;
+		stream->rtp_socket = NULL;
+		stream->rtcp_socket = NULL;
+		return;
+	}
+	if(stream->rtcp_socket && stream->rtcp_socket != stream->rtp_socket) {
+		apr_socket_close(stream->rtcp_socket);
+	}
+	stream->rtcp_socket = NULL;
 	if(stream->rtp_socket) {
 		apr_socket_close(stream->rtp_socket);
 		stream->rtp_socket = NULL;
 	}
-	if(stream->rtcp_socket) {
-		apr_socket_close(stream->rtcp_socket);
-		stream->rtcp_socket = NULL;
+	if(stream->allocated_port) {
+		/* the port is quarantined, stray packets of the previous call are not fed to a new one */
+		mpf_rtp_port_allocator_release(stream->config->port_allocator,stream->allocated_port);
+		stream->allocated_port = 0;
 	}
 }
 
 
 
-static APR_INLINE void rtcp_sr_generate(mpf_rtp_stream_t *rtp_stream, rtcp_sr_stat_t *sr_stat)
+struct rtcp_report_src_t {
+	/** Direction of the stream */
+	mpf_stream_direction_e direction;
+	/** Whether RTCP XR is reported */
+	apt_bool_t             xr;
+	/** Statistics of the transmitter (NTP time and RTP timestamp of the capture) */
+	rtcp_sr_stat_t         sr_stat;
+	/** Statistics of the receiver */
+	rtcp_rr_stat_t         rr_stat;
+	/** Number of expected, received and discarded packets */
+	apr_uint32_t           expected_packets;
+	apr_uint32_t           received_packets;
+	apr_uint32_t           discarded_packets;
+	/** Burst/gap statistics of RTCP XR */
+	rtcp_xr_burst_stat_t   burst_stat;
+	/** Playout delay of the jitter buffer */
+	apr_uint32_t           playout_delay;
+	/** Packetization time */
+	apr_uint32_t           ptime;
+	/** Settings of the jitter buffer */
+	apr_uint32_t           max_playout_delay;
+	apt_bool_t             adaptive;
+	/** Whether the equipment impairment factor of the codec is known */
+	apt_bool_t             r_factor_known;
+	/** SDES CNAME */
+	apt_str_t              cname;
+};
+
+struct mpf_rtcp_offload_t {
+	/** Stream the state belongs to */
+	mpf_rtp_stream_t       *rtp_stream;
+	/** Entry of the agent (NULL if stopped) */
+	mpf_rtcp_agent_entry_t *entry;
+	/** Socket and addresses taken at start */
+	apr_socket_t           *socket;
+	apr_sockaddr_t         *l_sockaddr;
+	apr_sockaddr_t         *r_sockaddr;
+	/** Set by the agent and cleared by media processing, once the snapshot is published */
+	volatile apr_uint32_t   request;
+	/** Whether the snapshot is requested (used by the agent only) */
+	apt_bool_t              requested;
+	/** Snapshot of the stream */
+	rtcp_report_src_t       src;
+};
+
+/** Take the snapshot of the stream, called in the context of media processing */
+static void rtcp_report_src_capture(mpf_rtp_stream_t *rtp_stream, rtcp_report_src_t *src)
 {
-	*sr_stat = rtp_stream->transmitter.sr_stat;
-	apt_ntp_time_get(&sr_stat->ntp_sec, &sr_stat->ntp_frac);
-	sr_stat->rtp_ts = rtp_stream->transmitter.timestamp;
+	static const apt_str_t l16 = {"L16", 3};
+	rtp_receiver_t *receiver = &rtp_stream->receiver;
+	mpf_codec_descriptor_t *descriptor = rtp_stream->base->rx_descriptor;
+	mpf_jb_config_t *jb_config = &rtp_stream->rx_settings->jb_config;
+
+	src->direction = rtp_stream->base->direction;
+	if(src->direction != STREAM_DIRECTION_NONE) {
+		/* update periodic (prior) history */
+		rtp_periodic_history_update(receiver);
+	}
+	src->xr = rtp_stream->settings->rtcp_xr;
+
+	src->sr_stat = rtp_stream->transmitter.sr_stat;
+	apt_ntp_time_get(&src->sr_stat.ntp_sec, &src->sr_stat.ntp_frac);
+	src->sr_stat.rtp_ts = rtp_stream->transmitter.timestamp;
+
+	src->rr_stat = receiver->rr_stat;
+	src->rr_stat.last_seq = receiver->history.seq_num_max;
+
+	src->expected_packets = 0;
+	src->received_packets = receiver->stat.received_packets;
+	src->discarded_packets = receiver->stat.discarded_packets;
+	if(src->received_packets) {
+		src->expected_packets = receiver->history.seq_cycles + 
+			receiver->history.seq_num_max - receiver->history.seq_num_base + 1;
+	}
+	src->burst_stat = receiver->burst_stat;
+
+	src->playout_delay = 0;
+	if(receiver->jb) {
+		src->playout_delay = mpf_jitter_buffer_playout_delay_get(receiver->jb);
+	}
+	src->ptime = 20;
+	if(rtp_stream->remote_media && rtp_stream->remote_media->ptime) {
+		src->ptime = rtp_stream->remote_media->ptime;
+	}
+	else if(rtp_stream->transmitter.ptime) {
+		src->ptime = rtp_stream->transmitter.ptime;
+	}
+	src->max_playout_delay = jb_config->max_playout_delay;
+	src->adaptive = jb_config->adaptive ? TRUE : FALSE;
+
+	src->r_factor_known = FALSE;
+	if(descriptor && (descriptor->payload_type == RTP_PT_PCMU || descriptor->payload_type == RTP_PT_PCMA || 
+		apt_string_compare(&descriptor->name,&l16) == TRUE)) {
+		src->r_factor_known = TRUE;
+	}
+
+	src->cname = rtp_stream->local_media->ip;
+}
+
+static APR_INLINE void rtcp_sr_generate(const rtcp_report_src_t *src, rtcp_sr_stat_t *sr_stat)
+{
+	*sr_stat = src->sr_stat;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Generate RTCP SR [ssrc:%u s:%u o:%u ts:%u]",
 				sr_stat->ssrc,
@@ -1203,10 +2126,9 @@ static APR_INLINE void rtcp_sr_generate(mpf_rtp_stream_t *rtp_stream, rtcp_sr_st
 	rtcp_sr_hton(sr_stat);
 }
 
-static APR_INLINE void rtcp_rr_generate(mpf_rtp_stream_t *rtp_stream, rtcp_rr_stat_t *rr_stat)
+static APR_INLINE void rtcp_rr_generate(const rtcp_report_src_t *src, rtcp_rr_stat_t *rr_stat)
 {
-	*rr_stat = rtp_stream->receiver.rr_stat;
-	rr_stat->last_seq =	rtp_stream->receiver.history.seq_num_max;
+	*rr_stat = src->rr_stat;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Generate RTCP RR [ssrc:%u last_seq:%u j:%u lost:%u frac:%d]",
 				rr_stat->ssrc,
@@ -1218,37 +2140,195 @@ static APR_INLINE void rtcp_rr_generate(mpf_rtp_stream_t *rtp_stream, rtcp_rr_st
 }
 
 /* Generate either RTCP SR or RTCP RR packet */
-static APR_INLINE apr_size_t rtcp_report_generate(mpf_rtp_stream_t *rtp_stream, rtcp_packet_t *rtcp_packet, apr_size_t length)
+static APR_INLINE apr_size_t rtcp_report_generate(const rtcp_report_src_t *src, rtcp_packet_t *rtcp_packet, apr_size_t length)
 {
 	apr_size_t offset = 0;
 	rtcp_header_init(&rtcp_packet->header,RTCP_RR);
-	if(rtp_stream->base->direction & STREAM_DIRECTION_SEND) {
+	if(src->direction & STREAM_DIRECTION_SEND) {
 		rtcp_packet->header.pt = RTCP_SR;
 	}
-	if(rtp_stream->base->direction & STREAM_DIRECTION_RECEIVE) {
+	if(src->direction & STREAM_DIRECTION_RECEIVE) {
 		rtcp_packet->header.count = 1;
 	}
 	offset += sizeof(rtcp_header_t);
 
 	if(rtcp_packet->header.pt == RTCP_SR) {
-		rtcp_sr_generate(rtp_stream,&rtcp_packet->r.sr.sr_stat);
+		rtcp_sr_generate(src,&rtcp_packet->r.sr.sr_stat);
 		offset += sizeof(rtcp_sr_stat_t);
 		if(rtcp_packet->header.count) {
-			rtcp_rr_generate(rtp_stream,rtcp_packet->r.sr.rr_stat);
+			rtcp_rr_generate(src,rtcp_packet->r.sr.rr_stat);
 			offset += sizeof(rtcp_rr_stat_t);
 		}
 	}
 	else if(rtcp_packet->header.pt == RTCP_RR) {
-		rtcp_packet->r.rr.ssrc = htonl(rtp_stream->transmitter.sr_stat.ssrc);
-		rtcp_rr_generate(rtp_stream,rtcp_packet->r.rr.rr_stat);
+		rtcp_packet->r.rr.ssrc = htonl(src->sr_stat.ssrc);
+		rtcp_rr_generate(src,rtcp_packet->r.rr.rr_stat);
 		offset += sizeof(rtcp_packet->r.rr);
 	}
 	rtcp_header_length_set(&rtcp_packet->header,offset);
 	return offset;
 }
 
+/* E-model (ITU-T G.107) estimation of R factor for G.711 and L16 codecs */
+static apt_bool_t rtcp_xr_r_factor_estimate(const rtcp_report_src_t *src, apr_uint32_t loss_rate, apr_uint32_t delay, apr_byte_t *r_factor, apr_byte_t *mos_lq, apr_byte_t *mos_cq)
+{
+	double ppl;
+	double bpl;
+	double ie_eff;
+	double id;
+	double r;
+	double r_lq;
+
+	if(src->r_factor_known == FALSE) {
+		/* equipment impairment factor is unknown */
+		return FALSE;
+	}
+
+	/* packet loss robustness factor with and without concealment */
+	bpl = src->adaptive ? 25.1 : 4.3;
+	ppl = loss_rate * 100.0 / 256;
+	ie_eff = 95.0 * ppl / (ppl + bpl);
+
+	id = 0.024 * delay;
+	if(delay > 177) {
+		id += 0.11 * (delay - 177.3);
+	}
+
+	r_lq = 93.2 - ie_eff;
+	if(r_lq < 0) {
+		r_lq = 0;
+	}
+	r = r_lq - id;
+	if(r < 0) {
+		r = 0;
+	}
+
+	*r_factor = (apr_byte_t)(r + 0.5);
+	*mos_cq = (apr_byte_t)(10 * (1 + 0.035 * r + 7e-6 * r * (r - 60) * (100 - r)) + 0.5);
+	*mos_lq = (apr_byte_t)(10 * (1 + 0.035 * r_lq + 7e-6 * r_lq * (r_lq - 60) * (100 - r_lq)) + 0.5);
+	return TRUE;
+}
+
+static APR_INLINE apr_byte_t rtcp_xr_rate_get(apr_uint32_t count, apr_uint32_t total)
+{
+	apr_uint32_t rate;
+	if(!total) {
+		return 0;
+	}
+	rate = (apr_uint32_t)((apr_uint64_t)count * 256 / total);
+	return (apr_byte_t)(rate > 255 ? 255 : rate);
+}
+
+static APR_INLINE void rtcp_xr_voip_metrics_generate(const rtcp_report_src_t *src, rtcp_xr_voip_metrics_t *voip_metrics)
+{
+	rtcp_xr_burst_stat_t burst_stat = src->burst_stat;
+	apr_uint32_t expected_packets = src->expected_packets;
+	apr_uint32_t lost_packets = 0;
+	apr_uint32_t playout_delay = src->playout_delay;
+	apr_uint32_t ptime = src->ptime;
+
+	if(expected_packets > src->received_packets) {
+		lost_packets = expected_packets - src->received_packets;
+	}
+
+	memset(voip_metrics,0,sizeof(rtcp_xr_voip_metrics_t));
+	voip_metrics->bt = RTCP_XR_VOIP_METRICS;
+	voip_metrics->length = sizeof(rtcp_xr_voip_metrics_t) / 4 - 1;
+	voip_metrics->ssrc = src->rr_stat.ssrc;
+	voip_metrics->loss_rate = rtcp_xr_rate_get(lost_packets,expected_packets);
+	voip_metrics->discard_rate = rtcp_xr_rate_get(src->discarded_packets,expected_packets);
+
+	/* complete the pending gap and calculate burst/gap metrics (RFC 3611 Appendix A.2) */
+	burst_stat.c11 += burst_stat.pkt;
+	if(burst_stat.c14 + burst_stat.c13 + burst_stat.c33) {
+		double c11 = burst_stat.c11;
+		double c13 = burst_stat.c13;
+		double c14 = burst_stat.c14;
+		double c22 = burst_stat.c22;
+		double c23 = burst_stat.c23;
+		double c33 = burst_stat.c33;
+		double c31 = c13;
+		double c32 = c23;
+		double ctotal = c11 + c14 + c13 + c22 + c23 + c31 + c32 + c33;
+		double gap_density = 256 * c14 / (c11 + c14 ? c11 + c14 : 1);
+		double gap_length = (c11 + c14 + c13) * ptime;
+		double burst_density = 0;
+		double burst_length = 0;
+
+		if(c13) {
+			double p32 = c32 / (c31 + c32 + c33);
+			double p23 = (c22 + c23) ? 1 - c22 / (c22 + c23) : 1;
+			burst_density = 256 * p23 / (p23 + p32);
+			gap_length /= c13;
+			burst_length = ctotal * ptime / c13 - gap_length;
+		}
+
+		voip_metrics->gap_density = (apr_byte_t)(gap_density > 255 ? 255 : gap_density);
+		voip_metrics->burst_density = (apr_byte_t)(burst_density > 255 ? 255 : burst_density);
+		voip_metrics->gap_duration = (apr_uint16_t)(gap_length > 65535 ? 65535 : gap_length);
+		voip_metrics->burst_duration = (apr_uint16_t)(burst_length > 65535 ? 65535 : burst_length);
+	}
+
+	/* round trip delay is not measured, signal/noise/echo levels are not available */
+	voip_metrics->round_trip_delay = 0;
+	voip_metrics->end_system_delay = (apr_uint16_t)(playout_delay + ptime);
+	voip_metrics->signal_level = 127;
+	voip_metrics->noise_level = 127;
+	voip_metrics->rerl = 127;
+	voip_metrics->gmin = RTCP_XR_GMIN;
+	voip_metrics->r_factor = 127;
+	voip_metrics->ext_r_factor = 127;
+	voip_metrics->mos_lq = 127;
+	voip_metrics->mos_cq = 127;
+	rtcp_xr_r_factor_estimate(
+		src,
+		voip_metrics->loss_rate + voip_metrics->discard_rate,
+		voip_metrics->end_system_delay,
+		&voip_metrics->r_factor,
+		&voip_metrics->mos_lq,
+		&voip_metrics->mos_cq);
+
+	/* PLC: enhanced (repeat) if adaptive, else unspecified; JBA: adaptive or non-adaptive */
+	voip_metrics->rx_config = src->adaptive ? 0xF0 : 0x60;
+	voip_metrics->jb_nominal = (apr_uint16_t)playout_delay;
+	voip_metrics->jb_maximum = (apr_uint16_t)src->max_playout_delay;
+	voip_metrics->jb_abs_max = (apr_uint16_t)src->max_playout_delay;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Generate RTCP XR [ssrc:%u loss:%u discard:%u burst:%u/%u gap:%u/%u delay:%u R:%u MOS:%u]",
+				voip_metrics->ssrc,
+				voip_metrics->loss_rate,
+				voip_metrics->discard_rate,
+				voip_metrics->burst_density,
+				voip_metrics->burst_duration,
+				voip_metrics->gap_density,
+				voip_metrics->gap_duration,
+				voip_metrics->end_system_delay,
+				voip_metrics->r_factor,
+				voip_metrics->mos_cq);
+	rtcp_xr_voip_metrics_hton(voip_metrics);
+}
+
+/* Generate RTCP XR packet with VoIP metrics report block */
+static APR_INLINE apr_size_t rtcp_xr_generate(const rtcp_report_src_t *src, rtcp_packet_t *rtcp_packet, apr_size_t length)
+{
+	apr_size_t offset = 0;
+	if(!src->xr || !(src->direction & STREAM_DIRECTION_RECEIVE)) {
+		return 0;
+	}
+
+	rtcp_header_init(&rtcp_packet->header,RTCP_XR);
+	offset += sizeof(rtcp_header_t);
+
+	rtcp_packet->r.xr.ssrc = htonl(src->sr_stat.ssrc);
+	rtcp_xr_voip_metrics_generate(src,&rtcp_packet->r.xr.voip_metrics);
+	offset += sizeof(rtcp_packet->r.xr);
+
+	rtcp_header_length_set(&rtcp_packet->header,offset);
+	return offset;
+}
+
 /* Generate RTCP SDES packet */
-static APR_INLINE apr_size_t rtcp_sdes_generate(mpf_rtp_stream_t *rtp_stream, rtcp_packet_t *rtcp_packet, apr_size_t length)
+static APR_INLINE apr_size_t rtcp_sdes_generate(const rtcp_report_src_t *src, rtcp_packet_t *rtcp_packet, apr_size_t length)
 {
 	rtcp_sdes_item_t *item;
 	apr_size_t offset = 0;
@@ -1257,14 +2337,14 @@ static APR_INLINE apr_size_t rtcp_sdes_generate(mpf_rtp_stream_t *rtp_stream, rt
 	offset += sizeof(rtcp_header_t);
 
 	rtcp_packet->header.count ++;
-	rtcp_packet->r.sdes.ssrc = htonl(rtp_stream->transmitter.sr_stat.ssrc);
+	rtcp_packet->r.sdes.ssrc = htonl(src->sr_stat.ssrc);
 	offset += sizeof(apr_uint32_t);
 
 	/* insert SDES CNAME item */
 	item = &rtcp_packet->r.sdes.item[0];
 	item->type = RTCP_SDES_CNAME;
-	item->length = (apr_byte_t)rtp_stream->local_media->ip.length;
-	memcpy(item->data,rtp_stream->local_media->ip.buf,item->length);
+	item->length = (apr_byte_t)src->cname.length;
+	memcpy(item->data,src->cname.buf,item->length);
 	offset += sizeof(rtcp_sdes_item_t) - 1 + item->length;
 	
 	/* terminate with end marker and pad to next 4-octet boundary */
@@ -1280,13 +2360,13 @@ static APR_INLINE apr_size_t rtcp_sdes_generate(mpf_rtp_stream_t *rtp_stream, rt
 }
 
 /* Generate RTCP BYE packet */
-static APR_INLINE apr_size_t rtcp_bye_generate(mpf_rtp_stream_t *rtp_stream, rtcp_packet_t *rtcp_packet, apr_size_t length, apt_str_t *reason)
+static APR_INLINE apr_size_t rtcp_bye_generate(const rtcp_report_src_t *src, rtcp_packet_t *rtcp_packet, apr_size_t length, apt_str_t *reason)
 {
 	apr_size_t offset = 0;
 	rtcp_header_init(&rtcp_packet->header,RTCP_BYE);
 	offset += sizeof(rtcp_header_t);
 
-	rtcp_packet->r.bye.ssrc[0] = htonl(rtp_stream->transmitter.sr_stat.ssrc);
+	rtcp_packet->r.bye.ssrc[0] = htonl(src->sr_stat.ssrc);
 	rtcp_packet->header.count++;
 	offset += rtcp_packet->header.count * sizeof(apr_uint32_t);
 
@@ -1310,99 +2390,114 @@ static APR_INLINE apr_size_t rtcp_bye_generate(mpf_rtp_stream_t *rtp_stream, rtc
 	return offset;
 }
 
-/* Send compound RTCP packet (SR/RR + SDES) */
-static apt_bool_t mpf_rtcp_report_send(mpf_rtp_stream_t *rtp_stream)
+/* Compose compound RTCP packet (SR/RR + SDES [+ XR] [+ BYE]) */
+static apr_size_t rtcp_compound_packet_compose(const rtcp_report_src_t *src, char *buffer, apr_size_t size, apt_str_t *reason)
 {
-	char buffer[MAX_RTCP_PACKET_SIZE];
 	apr_size_t length = 0;
 	rtcp_packet_t *rtcp_packet;
 
-	if(!rtp_stream->rtcp_socket || !rtp_stream->rtcp_l_sockaddr || !rtp_stream->rtcp_r_sockaddr) {
-		/* session is not initialized */
-		return FALSE;
-	}
-
-	if(rtp_stream->base->direction != STREAM_DIRECTION_NONE) {
-		/* update periodic (prior) history */
-		rtp_periodic_history_update(&rtp_stream->receiver);
-	}
+	rtcp_packet = (rtcp_packet_t*) (buffer + length);
+	length += rtcp_report_generate(src,rtcp_packet,size-length);
 
 	rtcp_packet = (rtcp_packet_t*) (buffer + length);
-	length += rtcp_report_generate(rtp_stream,rtcp_packet,sizeof(buffer)-length);
+	length += rtcp_sdes_generate(src,rtcp_packet,size-length);
 
 	rtcp_packet = (rtcp_packet_t*) (buffer + length);
-	length += rtcp_sdes_generate(rtp_stream,rtcp_packet,sizeof(buffer)-length);
-	
-	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Send Compound RTCP Packet [%"APR_SIZE_T_FMT" bytes] %s:%hu -> %s:%hu",
+	length += rtcp_xr_generate(src,rtcp_packet,size-length);
+
+	if(reason) {
+		rtcp_packet = (rtcp_packet_t*) (buffer + length);
+		length += rtcp_bye_generate(src,rtcp_packet,size-length,reason);
+	}
+	return length;
+}
+
+/* Protect (if SRTP is used) and send compound RTCP packet */
+static apt_bool_t rtcp_compound_packet_send(
+						apr_socket_t *socket,
+						apr_sockaddr_t *l_sockaddr,
+						apr_sockaddr_t *r_sockaddr,
+						mpf_srtp_t *srtp,
+						char *buffer,
+						apr_size_t length,
+						const char *tag)
+{
+	if(srtp && mpf_srtcp_protect(srtp,buffer,&length) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Protect Compound RTCP Packet%s",tag);
+		return FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Send Compound RTCP Packet%s [%"APR_SIZE_T_FMT" bytes] %s:%hu -> %s:%hu",
+		tag,
 		length,
-		rtp_stream->rtcp_l_sockaddr->hostname,
-		rtp_stream->rtcp_l_sockaddr->port,
-		rtp_stream->rtcp_r_sockaddr->hostname,
-		rtp_stream->rtcp_r_sockaddr->port);
+		l_sockaddr->hostname,
+		l_sockaddr->port,
+		r_sockaddr->hostname,
+		r_sockaddr->port);
 	if(apr_socket_sendto(
-				rtp_stream->rtcp_socket,
-				rtp_stream->rtcp_r_sockaddr,
+				socket,
+				r_sockaddr,
 				0,
 				buffer,
 				&length) != APR_SUCCESS) {
-		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Send Compound RTCP Packet [%"APR_SIZE_T_FMT" bytes] %s:%hu -> %s:%hu",
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Send Compound RTCP Packet%s [%"APR_SIZE_T_FMT" bytes] %s:%hu -> %s:%hu",
+			tag,
 			length,
-			rtp_stream->rtcp_l_sockaddr->hostname,
-			rtp_stream->rtcp_l_sockaddr->port,
-			rtp_stream->rtcp_r_sockaddr->hostname,
-			rtp_stream->rtcp_r_sockaddr->port);
+			l_sockaddr->hostname,
+			l_sockaddr->port,
+			r_sockaddr->hostname,
+			r_sockaddr->port);
 		return FALSE;
 	}
 	return TRUE;
 }
 
-/* Send compound RTCP packet (SR/RR + SDES + BYE) */
-static apt_bool_t mpf_rtcp_bye_send(mpf_rtp_stream_t *rtp_stream, apt_str_t *reason)
+/* Send compound RTCP packet (SR/RR + SDES [+ XR]) */
+static apt_bool_t mpf_rtcp_report_send(mpf_rtp_stream_t *rtp_stream)
 {
 	char buffer[MAX_RTCP_PACKET_SIZE];
-	apr_size_t length = 0;
-	rtcp_packet_t *rtcp_packet;
+	apr_size_t length;
+	rtcp_report_src_t src;
 
 	if(!rtp_stream->rtcp_socket || !rtp_stream->rtcp_l_sockaddr || !rtp_stream->rtcp_r_sockaddr) {
 		/* session is not initialized */
 		return FALSE;
 	}
 
-	if(rtp_stream->base->direction != STREAM_DIRECTION_NONE) {
-		/* update periodic (prior) history */
-		rtp_periodic_history_update(&rtp_stream->receiver);
-	}
-
-	rtcp_packet = (rtcp_packet_t*) (buffer + length);
-	length += rtcp_report_generate(rtp_stream,rtcp_packet,sizeof(buffer)-length);
+	rtcp_report_src_capture(rtp_stream,&src);
+	length = rtcp_compound_packet_compose(&src,buffer,sizeof(buffer),NULL);
+	return rtcp_compound_packet_send(
+				rtp_stream->rtcp_socket,
+				rtp_stream->rtcp_l_sockaddr,
+				rtp_stream->rtcp_r_sockaddr,
+				rtp_stream->srtp,
+				buffer,
+				length,
+				"");
+}
 
-	rtcp_packet = (rtcp_packet_t*) (buffer + length);
-	length += rtcp_sdes_generate(rtp_stream,rtcp_packet,sizeof(buffer)-length);
+/* Send compound RTCP packet (SR/RR + SDES [+ XR] + BYE) */
+static apt_bool_t mpf_rtcp_bye_send(mpf_rtp_stream_t *rtp_stream, apt_str_t *reason)
+{
+	char buffer[MAX_RTCP_PACKET_SIZE];
+	apr_size_t length;
+	rtcp_report_src_t src;
 
-	rtcp_packet = (rtcp_packet_t*) (buffer + length);
-	length += rtcp_bye_generate(rtp_stream,rtcp_packet,sizeof(buffer)-length,reason);
+	if(!rtp_stream->rtcp_socket || !rtp_stream->rtcp_l_sockaddr || !rtp_stream->rtcp_r_sockaddr) {
+		/* session is not initialized */
+		return FALSE;
+	}
 
-	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Send Compound RTCP Packet [BYE] [%"APR_SIZE_T_FMT" bytes] %s:%hu -> %s:%hu",
-		length,
-		rtp_stream->rtcp_l_sockaddr->hostname,
-		rtp_stream->rtcp_l_sockaddr->port,
-		rtp_stream->rtcp_r_sockaddr->hostname,
-		rtp_stream->rtcp_r_sockaddr->port);
-	if(apr_socket_sendto(
+	rtcp_report_src_capture(rtp_stream,&src);
+	length = rtcp_compound_packet_compose(&src,buffer,sizeof(buffer),reason);
+	return rtcp_compound_packet_send(
 				rtp_stream->rtcp_socket,
+				rtp_stream->rtcp_l_sockaddr,
 				rtp_stream->rtcp_r_sockaddr,
-				0,
+				rtp_stream->srtp,
 				buffer,
-				&length) != APR_SUCCESS) {
-		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Send Compound RTCP Packet [BYE] [%"APR_SIZE_T_FMT" bytes] %s:%hu -> %s:%hu",
-			length,
-			rtp_stream->rtcp_l_sockaddr->hostname,
-			rtp_stream->rtcp_l_sockaddr->port,
-			rtp_stream->rtcp_r_sockaddr->hostname,
-			rtp_stream->rtcp_r_sockaddr->port);
-		return FALSE;
-	}
-	return TRUE;
+				length,
+				" [BYE]");
 }
 
 static APR_INLINE void rtcp_sr_get(mpf_rtp_stream_t *rtp_stream, rtcp_sr_stat_t *sr_stat)
@@ -1431,6 +2526,11 @@ static apt_bool_t mpf_rtcp_compound_packet_receive(mpf_rtp_stream_t *rtp_stream,
 	rtcp_packet_t *rtcp_packet = (rtcp_packet_t*) buffer;
 	rtcp_packet_t *rtcp_packet_end;
 
+	if(rtp_stream->srtp && mpf_srtcp_unprotect(rtp_stream->srtp,buffer,&length) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Unprotect Compound SRTCP Packet");
+		return FALSE;
+	}
+
 	rtcp_packet_end = (rtcp_packet_t*)(buffer + length);
 
 	while(rtcp_packet < rtcp_packet_end && rtcp_packet->header.version == RTP_VERSION) {
@@ -1456,6 +2556,9 @@ static apt_bool_t mpf_rtcp_compound_packet_receive(mpf_rtp_stream_t *rtp_stream,
 		else if(rtcp_packet->header.pt == RTCP_BYE) {
 			/* RTCP BYE */
 		}
+		else if(rtcp_packet->header.pt == RTCP_XR) {
+			/* RTCP XR */
+		}
 		else {
 			/* unknown RTCP packet */
 		}
@@ -1476,8 +2579,10 @@ static void mpf_rtcp_tx_timer_proc(apt_timer_t *timer, void *obj)
 {
 	mpf_rtp_stream_t *rtp_stream = obj;
 
-	/* generate and send RTCP compound report (SR/RR + SDES) */
-	mpf_rtcp_report_send(rtp_stream);
+	/* generate and send RTCP compound report (SR/RR + SDES), unless media processing is overloaded */
+	if(mpf_termination_overload_level_get(rtp_stream->base->termination) == MPF_OVERLOAD_NONE) {
+		mpf_rtcp_report_send(rtp_stream);
+	}
 
 	/* re-schedule timer */
 	apt_timer_set(timer,rtp_stream->settings->rtcp_tx_interval);
@@ -1486,7 +2591,11 @@ static void mpf_rtcp_tx_timer_proc(apt_timer_t *timer, void *obj)
 static void mpf_rtcp_rx_timer_proc(apt_timer_t *timer, void *obj)
 {
 	mpf_rtp_stream_t *rtp_stream = obj;
-	if(rtp_stream->rtcp_socket && rtp_stream->rtcp_l_sockaddr && rtp_stream->rtcp_r_sockaddr) {
+	/* multiplexed and shared RTCP is received along with RTP,
+	the reports are left in the socket while media processing is overloaded */
+	if(rtp_stream->rtcp_mux == FALSE && rtp_stream->shared == FALSE &&
+		mpf_termination_overload_level_get(rtp_stream->base->termination) == MPF_OVERLOAD_NONE &&
+		rtp_stream->rtcp_socket && rtp_stream->rtcp_l_sockaddr && rtp_stream->rtcp_r_sockaddr) {
 		char buffer[MAX_RTCP_PACKET_SIZE];
 		apr_size_t length = sizeof(buffer);
 		
@@ -1504,3 +2613,145 @@ static void mpf_rtcp_rx_timer_proc(apt_timer_t *timer, void *obj)
 	/* re-schedule timer */
 	apt_timer_set(timer,rtp_stream->settings->rtcp_rx_resolution);
 }
+
+static apt_bool_t mpf_rtcp_offload_tx_proc(void *obj)
+{
+	mpf_rtcp_offload_t *offload = obj;
+	char buffer[MAX_RTCP_PACKET_SIZE];
+	apr_size_t length;
+
+	if(offload->requested == FALSE) {
+		/* ask media processing for the snapshot of the stream */
+		offload->requested = TRUE;
+		apr_atomic_set32(&offload->request,1);
+		return FALSE;
+	}
+	if(apr_atomic_cas32(&offload->request,0,0) != 0) {
+		/* the snapshot is not published yet */
+		return FALSE;
+	}
+	offload->requested = FALSE;
+
+	length = rtcp_compound_packet_compose(&offload->src,buffer,sizeof(buffer),NULL);
+	rtcp_compound_packet_send(
+				offload->socket,
+				offload->l_sockaddr,
+				offload->r_sockaddr,
+				NULL,
+				buffer,
+				length,
+				"");
+	return TRUE;
+}
+
+static apt_bool_t mpf_rtcp_offload_rx_proc(void *obj)
+{
+	mpf_rtcp_offload_t *offload = obj;
+	char buffer[MAX_RTCP_PACKET_SIZE];
+	apr_size_t length = sizeof(buffer);
+
+	if(apr_socket_recv(offload->socket,buffer,&length) == APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Receive Compound RTCP Packet [%"APR_SIZE_T_FMT" bytes] %s:%hu <- %s:%hu",
+				length,
+				offload->l_sockaddr->hostname,
+				offload->l_sockaddr->port,
+				offload->r_sockaddr->hostname,
+				offload->r_sockaddr->port);
+		mpf_rtcp_compound_packet_receive(offload->rtp_stream,buffer,length);
+	}
+	return TRUE;
+}
+
+/** Publish the snapshot of the stream, if requested by the agent */
+static APR_INLINE void mpf_rtcp_offload_serve(mpf_rtp_stream_t *rtp_stream)
+{
+	mpf_rtcp_offload_t *offload = rtp_stream->rtcp_offload;
+	if(offload && offload->entry && apr_atomic_read32(&offload->request) != 0) {
+		rtcp_report_src_capture(rtp_stream,&offload->src);
+		/* full barrier, the snapshot is visible to the agent once the request is cleared */
+		apr_atomic_cas32(&offload->request,0,1);
+	}
+}
+
+static apt_bool_t mpf_rtcp_offload_start(mpf_rtp_stream_t *rtp_stream)
+{
+	mpf_rtp_settings_t *settings = rtp_stream->settings;
+	mpf_rtcp_offload_t *offload = rtp_stream->rtcp_offload;
+	apt_bool_t rx;
+
+	if(!offload) {
+		offload = apr_palloc(rtp_stream->pool,sizeof(mpf_rtcp_offload_t));
+		offload->rtp_stream = rtp_stream;
+		offload->entry = NULL;
+		offload->request = 0;
+		offload->requested = FALSE;
+		rtp_stream->rtcp_offload = offload;
+	}
+	if(offload->entry) {
+		return TRUE;
+	}
+
+	/* the sockets are changed by media processing only while the entry is removed */
+	offload->socket = rtp_stream->rtcp_socket;
+	offload->l_sockaddr = rtp_stream->rtcp_l_sockaddr;
+	offload->r_sockaddr = rtp_stream->rtcp_r_sockaddr;
+	offload->requested = FALSE;
+	apr_atomic_set32(&offload->request,0);
+
+	/* multiplexed and shared RTCP is received along with RTP */
+	rx = (rtp_stream->rtcp_mux == FALSE && rtp_stream->shared == FALSE && settings->rtcp_rx_resolution) ? TRUE : FALSE;
+	offload->entry = mpf_rtcp_agent_entry_add(
+						rtp_stream->rtcp_agent,
+						offload,
+						settings->rtcp_tx_interval ? mpf_rtcp_offload_tx_proc : NULL,
+						settings->rtcp_tx_interval,
+						rx == TRUE ? mpf_rtcp_offload_rx_proc : NULL,
+						settings->rtcp_rx_resolution);
+	return offload->entry ? TRUE : FALSE;
+}
+
+static apt_bool_t mpf_rtcp_offload_stop(mpf_rtp_stream_t *rtp_stream)
+{
+	mpf_rtcp_offload_t *offload = rtp_stream->rtcp_offload;
+	if(!offload || !offload->entry) {
+		return FALSE;
+	}
+	/* waits for the handler in progress, if any */
+	mpf_rtcp_agent_entry_remove(rtp_stream->rtcp_agent,offload->entry);
+	offload->entry = NULL;
+	offload->requested = FALSE;
+	apr_atomic_set32(&offload->request,0);
+	return TRUE;
+}
+
+/** Start periodic RTCP processing, either by the agent of the engine or by the timers */
+static void mpf_rtcp_start(mpf_rtp_stream_t *rtp_stream)
+{
+	/* SRTCP is processed in the context of media processing, the SRTP session is not thread-safe */
+	if(rtp_stream->rtcp_agent && rtp_stream->settings->rtcp == TRUE && !rtp_stream->srtp &&
+		rtp_stream->rtcp_socket && rtp_stream->rtcp_l_sockaddr && rtp_stream->rtcp_r_sockaddr) {
+		if(mpf_rtcp_offload_start(rtp_stream) == TRUE) {
+			return;
+		}
+	}
+
+	if(rtp_stream->rtcp_tx_timer) {
+		apt_timer_set(rtp_stream->rtcp_tx_timer,rtp_stream->settings->rtcp_tx_interval);
+	}
+	if(rtp_stream->rtcp_rx_timer) {
+		apt_timer_set(rtp_stream->rtcp_rx_timer,rtp_stream->settings->rtcp_rx_resolution);
+	}
+}
+
+/** Stop periodic RTCP processing */
+static void mpf_rtcp_stop(mpf_rtp_stream_t *rtp_stream)
+{
+	mpf_rtcp_offload_stop(rtp_stream);
+
+	if(rtp_stream->rtcp_tx_timer) {
+		apt_timer_kill(rtp_stream->rtcp_tx_timer);
+	}
+	if(rtp_stream->rtcp_rx_timer) {
+		apt_timer_kill(rtp_stream->rtcp_rx_timer);
+	}
+}
@@ -20,6 +20,8 @@
 #include "mpf_termination.h"
 #include "mpf_rtp_termination_factory.h"
 #include "mpf_rtp_stream.h"
+#include "mpf_engine.h"
+#include "apt_pool.h"
 #include "apt_log.h"
 
 typedef struct media_engine_slot_t media_engine_slot_t;
@@ -28,6 +30,8 @@ typedef struct rtp_termination_factory_t rtp_termination_factory_t;
 struct media_engine_slot_t {
 	mpf_engine_t     *media_engine;
 	mpf_rtp_config_t *rtp_config;
+	/** Demultiplexers of shared ports indexed by media worker */
+	mpf_rtp_demux_t **demuxes;
 };
 
 struct rtp_termination_factory_t {
@@ -43,6 +47,36 @@ static apt_bool_t mpf_rtp_termination_destroy(mpf_termination_t *termination)
 	return TRUE;
 }
 
+static mpf_rtp_demux_t* mpf_rtp_termination_demux_get(media_engine_slot_t *slot, apr_size_t worker_id)
+{
+	mpf_rtp_config_t *rtp_config = slot->rtp_config;
+	apr_port_t port;
+	if(worker_id >= MPF_MAX_WORKER_COUNT) {
+		return NULL;
+	}
+	if(slot->demuxes[worker_id]) {
+		return slot->demuxes[worker_id];
+	}
+
+	/* each media worker listens on its own port taken from the beginning of the range */
+	port = (apr_port_t)(rtp_config->rtp_port_min + 2 * worker_id);
+	if(port + 1 >= rtp_config->rtp_port_max) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Shared RTP Port for Media Worker [%"APR_SIZE_T_FMT"] %s:[%hu,%hu]",
+			worker_id,
+			rtp_config->ip.buf,
+			rtp_config->rtp_port_min,
+			rtp_config->rtp_port_max);
+		return NULL;
+	}
+	/* the demultiplexer is created in the context of media engine, use a dedicated pool */
+	slot->demuxes[worker_id] = mpf_rtp_demux_create(
+									&rtp_config->ip,
+									port,
+									TRUE,
+									apt_pool_create());
+	return slot->demuxes[worker_id];
+}
+
 static apt_bool_t mpf_rtp_termination_add(mpf_termination_t *termination, void *descriptor)
 {
 	apt_bool_t status = TRUE;
@@ -51,12 +85,14 @@ static apt_bool_t mpf_rtp_termination_add(mpf_termination_t *termination, void *
 	if(!audio_stream) {
 		int i;
 		media_engine_slot_t *slot;
+		media_engine_slot_t *engine_slot = NULL;
 		rtp_termination_factory_t *rtp_termination_factory = (rtp_termination_factory_t*)termination->termination_factory;
 		mpf_rtp_config_t *rtp_config = rtp_termination_factory->config;
 		for(i=0; i<rtp_termination_factory->media_engine_slots->nelts; i++) {
 			slot = &APR_ARRAY_IDX(rtp_termination_factory->media_engine_slots,i,media_engine_slot_t);
 			if(slot->media_engine == termination->media_engine) {
 				rtp_config = slot->rtp_config;
+				engine_slot = slot;
 				break;
 			}
 		}
@@ -68,6 +104,12 @@ static apt_bool_t mpf_rtp_termination_add(mpf_termination_t *termination, void *
 		if(!audio_stream) {
 			return FALSE;
 		}
+		if(rtp_config->shared_ports == TRUE && engine_slot) {
+			mpf_rtp_demux_t *demux = mpf_rtp_termination_demux_get(engine_slot,termination->worker_id);
+			if(demux) {
+				mpf_rtp_stream_demux_set(audio_stream,demux);
+			}
+		}
 		termination->audio_stream = audio_stream;
 	}
 
@@ -143,6 +185,10 @@ static apt_bool_t mpf_rtp_factory_engine_assign(mpf_termination_factory_t *termi
 	rtp_config = mpf_rtp_config_alloc(rtp_termination_factory->pool);
 	*rtp_config = *rtp_termination_factory->config;
 	slot->rtp_config = rtp_config;
+	slot->demuxes = NULL;
+	if(rtp_config->shared_ports == TRUE) {
+		slot->demuxes = apr_pcalloc(rtp_termination_factory->pool,sizeof(mpf_rtp_demux_t*) * MPF_MAX_WORKER_COUNT);
+	}
 
 	if(rtp_termination_factory->media_engine_slots->nelts > 1) {
 		mpf_rtp_config_t *rtp_config_prev;
@@ -165,8 +211,6 @@ static apt_bool_t mpf_rtp_factory_engine_assign(mpf_termination_factory_t *termi
 			rtp_config = slot->rtp_config;
 			rtp_config->rtp_port_min = rtp_config_prev->rtp_port_max;
 			rtp_config->rtp_port_max = rtp_config->rtp_port_min + ports_per_engine;
-
-			rtp_config->rtp_port_cur = rtp_config->rtp_port_min;
 			
 			rtp_config_prev = rtp_config;
 		}
@@ -176,7 +220,26 @@ static apt_bool_t mpf_rtp_factory_engine_assign(mpf_termination_factory_t *termi
 				rtp_termination_factory->media_engine_slots->nelts-1,media_engine_slot_t);
 		rtp_config = slot->rtp_config;
 		rtp_config->rtp_port_min = rtp_config_prev->rtp_port_max;
-		rtp_config->rtp_port_cur = rtp_config->rtp_port_min;
+	}
+
+	/* (re)create port allocators according to the ranges of the slots */
+	for(i=0; i<rtp_termination_factory->media_engine_slots->nelts; i++) {
+		slot = &APR_ARRAY_IDX(rtp_termination_factory->media_engine_slots,i,media_engine_slot_t);
+		rtp_config = slot->rtp_config;
+		rtp_config->port_allocator = mpf_rtp_port_allocator_create(
+										rtp_config->rtp_port_min,
+										rtp_config->rtp_port_max,
+										rtp_config->rtp_port_quarantine,
+										rtp_termination_factory->pool);
+		rtp_config->socket_pool = NULL;
+		if(rtp_config->socket_pool_size && rtp_config->shared_ports == FALSE) {
+			/* the refill thread is started on the first termination add */
+			rtp_config->socket_pool = mpf_rtp_socket_pool_create(
+										&rtp_config->ip,
+										rtp_config->port_allocator,
+										rtp_config->socket_pool_size,
+										rtp_termination_factory->pool);
+		}
 	}
 	return TRUE;
 }
@@ -189,7 +252,18 @@ MPF_DECLARE(mpf_termination_factory_t*) mpf_rtp_termination_factory_create(
 	if(!rtp_config) {
 		return NULL;
 	}
-	rtp_config->rtp_port_cur = rtp_config->rtp_port_min;
+	rtp_config->port_allocator = mpf_rtp_port_allocator_create(
+									rtp_config->rtp_port_min,
+									rtp_config->rtp_port_max,
+									rtp_config->rtp_port_quarantine,
+									pool);
+	if(rtp_config->srtp_suite != SRTP_CRYPTO_UNKNOWN) {
+		if(mpf_srtp_init() == FALSE || mpf_srtp_crypto_suite_supported(rtp_config->srtp_suite) == FALSE) {
+			const apt_str_t *suite = mpf_srtp_crypto_suite_str_get(rtp_config->srtp_suite);
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Not Supported SRTP Crypto Suite [%s]: disable SRTP",suite ? suite->buf : "");
+			rtp_config->srtp_suite = SRTP_CRYPTO_UNKNOWN;
+		}
+	}
 	rtp_termination_factory = apr_palloc(pool,sizeof(rtp_termination_factory_t));
 	rtp_termination_factory->base.create_termination = mpf_rtp_termination_create;
 	rtp_termination_factory->base.assign_engine = mpf_rtp_factory_engine_assign;
@@ -16,6 +16,11 @@
  * $Id$
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+/* required for CPU affinity macros */
+#define _GNU_SOURCE
+#endif
+
 #include "mpf_scheduler.h"
 
 #ifdef WIN32
@@ -34,6 +39,15 @@
 
 #else
 #include <apr_thread_proc.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#if defined(_POSIX_MONOTONIC_CLOCK) && defined(TIMER_ABSTIME)
+#define ENABLE_MONOTONIC_CLOCK
+#endif
 #endif
 
 
@@ -50,6 +64,12 @@ struct mpf_scheduler_t {
 	mpf_scheduler_proc_f timer_proc;
 	void                *timer_obj;
 
+	mpf_scheduler_clock_e clock;
+	int                  priority;
+	int                  cpu;
+	apt_cpu_set_t        cpu_set;
+	apt_bool_t           cpu_set_enabled;
+
 #ifdef ENABLE_MULTIMEDIA_TIMERS
 	unsigned int         timer_id;
 #else
@@ -76,6 +96,11 @@ MPF_DECLARE(mpf_scheduler_t*) mpf_scheduler_create(apr_pool_t *pool)
 	scheduler->timer_elapsed_time = 0;
 	scheduler->timer_obj = NULL;
 	scheduler->timer_proc = NULL;
+
+	scheduler->clock = MPF_SCHEDULER_CLOCK_DEFAULT;
+	scheduler->priority = 0;
+	scheduler->cpu = -1;
+	scheduler->cpu_set_enabled = FALSE;
 	return scheduler;
 }
 
@@ -129,6 +154,59 @@ MPF_DECLARE(apt_bool_t) mpf_scheduler_rate_set(
 	return TRUE;
 }
 
+/** Set clock source the scheduler is driven by */
+MPF_DECLARE(apt_bool_t) mpf_scheduler_clock_source_set(
+								mpf_scheduler_t *scheduler,
+								mpf_scheduler_clock_e clock)
+{
+#ifndef ENABLE_MONOTONIC_CLOCK
+	if(clock == MPF_SCHEDULER_CLOCK_MONOTONIC) {
+		return FALSE;
+	}
+#endif
+#ifdef ENABLE_MULTIMEDIA_TIMERS
+	if(clock == MPF_SCHEDULER_CLOCK_FREEWHEEL) {
+		return FALSE;
+	}
+#endif
+	scheduler->clock = clock;
+	return TRUE;
+}
+
+/** Set real-time priority of the scheduler thread */
+MPF_DECLARE(apt_bool_t) mpf_scheduler_thread_priority_set(
+								mpf_scheduler_t *scheduler,
+								int priority)
+{
+	if(priority < 0) {
+		return FALSE;
+	}
+	scheduler->priority = priority;
+	return TRUE;
+}
+
+/** Bind the scheduler thread to the specified CPU */
+MPF_DECLARE(apt_bool_t) mpf_scheduler_thread_affinity_set(
+								mpf_scheduler_t *scheduler,
+								int cpu)
+{
+	scheduler->cpu = cpu;
+	return TRUE;
+}
+
+/** Bind the scheduler thread to the set of CPUs */
+MPF_DECLARE(apt_bool_t) mpf_scheduler_thread_cpu_set_set(
+								mpf_scheduler_t *scheduler,
+								const apt_cpu_set_t *cpu_set)
+{
+	scheduler->cpu_set_enabled = FALSE;
+	if(cpu_set) {
+		scheduler->cpu_set = *cpu_set;
+		scheduler->cpu_set_enabled = TRUE;
+	}
+	return TRUE;
+}
+
 static APR_INLINE void mpf_scheduler_resolution_set(mpf_scheduler_t *scheduler)
 {
 	if(scheduler->media_resolution) {
@@ -189,6 +267,8 @@ MPF_DECLARE(apt_bool_t) mpf_scheduler_stop(mpf_scheduler_t *scheduler)
 #else
 
 #include "apt_task.h"
+#include "apt_clock.h"
+#include "apt_log.h"
 
 static APR_INLINE void mpf_scheduler_init(mpf_scheduler_t *scheduler)
 {
@@ -196,6 +276,52 @@ static APR_INLINE void mpf_scheduler_init(mpf_scheduler_t *scheduler)
 	scheduler->running = FALSE;
 }
 
+static void mpf_scheduler_thread_setup(mpf_scheduler_t *scheduler)
+{
+#if APR_HAS_SETTHREADNAME
+	apr_thread_name_set("MPF Scheduler");
+#endif
+	if(scheduler->priority > 0) {
+		struct sched_param param;
+		memset(&param,0,sizeof(param));
+		param.sched_priority = scheduler->priority;
+		if(pthread_setschedparam(pthread_self(),SCHED_FIFO,&param) != 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Set SCHED_FIFO Priority [%d] for MPF Scheduler",
+				scheduler->priority);
+		}
+	}
+	if(scheduler->cpu >= 0) {
+#ifdef __linux__
+		cpu_set_t cpu_set;
+		CPU_ZERO(&cpu_set);
+		CPU_SET(scheduler->cpu,&cpu_set);
+		if(pthread_setaffinity_np(pthread_self(),sizeof(cpu_set),&cpu_set) != 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Bind MPF Scheduler to CPU [%d]",scheduler->cpu);
+		}
+#else
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"CPU Affinity is not Supported");
+#endif
+	}
+	else if(scheduler->cpu_set_enabled == TRUE) {
+		apt_cpu_set_thread_bind(&scheduler->cpu_set);
+	}
+}
+
+static APR_INLINE void mpf_scheduler_tick(mpf_scheduler_t *scheduler)
+{
+	if(scheduler->media_proc) {
+		scheduler->media_proc(scheduler,scheduler->media_obj);
+	}
+
+	if(scheduler->timer_proc) {
+		scheduler->timer_elapsed_time += scheduler->resolution;
+		if(scheduler->timer_elapsed_time >= scheduler->timer_resolution) {
+			scheduler->timer_elapsed_time = 0;
+			scheduler->timer_proc(scheduler,scheduler->timer_obj);
+		}
+	}
+}
+
 static void* APR_THREAD_FUNC timer_thread_proc(apr_thread_t *thread, void *data)
 {
 	mpf_scheduler_t *scheduler = data;
@@ -203,30 +329,18 @@ static void* APR_THREAD_FUNC timer_thread_proc(apr_thread_t *thread, void *data)
 	apr_interval_time_t time_drift = 0;
 	apr_time_t time_now, time_last;
 	
-#if APR_HAS_SETTHREADNAME
-	apr_thread_name_set("MPF Scheduler");
-#endif
-	time_now = apr_time_now();
+	mpf_scheduler_thread_setup(scheduler);
+	time_now = apt_clock_now();
 	while(scheduler->running == TRUE) {
 		time_last = time_now;
 
-		if(scheduler->media_proc) {
-			scheduler->media_proc(scheduler,scheduler->media_obj);
-		}
-
-		if(scheduler->timer_proc) {
-			scheduler->timer_elapsed_time += scheduler->resolution;
-			if(scheduler->timer_elapsed_time >= scheduler->timer_resolution) {
-				scheduler->timer_elapsed_time = 0;
-				scheduler->timer_proc(scheduler,scheduler->timer_obj);
-			}
-		}
+		mpf_scheduler_tick(scheduler);
 
 		if(timeout > time_drift) {
-			apr_sleep(timeout - time_drift);
+			apt_clock_sleep(timeout - time_drift);
 		}
 
-		time_now = apr_time_now();
+		time_now = apt_clock_now();
 		time_drift += time_now - time_last - timeout;
 #if 0
 		printf("time_drift=%d\n",time_drift);
@@ -237,12 +351,84 @@ static void* APR_THREAD_FUNC timer_thread_proc(apr_thread_t *thread, void *data)
 	return NULL;
 }
 
+static void* APR_THREAD_FUNC freewheel_thread_proc(apr_thread_t *thread, void *data)
+{
+	mpf_scheduler_t *scheduler = data;
+
+	mpf_scheduler_thread_setup(scheduler);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run MPF Scheduler in Freewheel Mode");
+	while(scheduler->running == TRUE) {
+		/* media and timer clocks advance by the resolution on every tick,
+		regardless of the wall-clock time elapsed */
+		mpf_scheduler_tick(scheduler);
+		apr_thread_yield();
+	}
+
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+#ifdef ENABLE_MONOTONIC_CLOCK
+
+#define NSEC_PER_SEC 1000000000L
+
+/** Max number of ticks the scheduler may fall behind, before the deadline is reset */
+#define MAX_MISSED_TICKS 10
+
+static void* APR_THREAD_FUNC monotonic_timer_thread_proc(apr_thread_t *thread, void *data)
+{
+	mpf_scheduler_t *scheduler = data;
+	long interval = (long)scheduler->resolution * 1000000L;
+	struct timespec deadline;
+	struct timespec time_now;
+	long long lag;
+
+	mpf_scheduler_thread_setup(scheduler);
+	clock_gettime(CLOCK_MONOTONIC,&deadline);
+	while(scheduler->running == TRUE) {
+		mpf_scheduler_tick(scheduler);
+
+		/* advance the absolute deadline, so that the error does not accumulate */
+		deadline.tv_nsec += interval;
+		while(deadline.tv_nsec >= NSEC_PER_SEC) {
+			deadline.tv_nsec -= NSEC_PER_SEC;
+			deadline.tv_sec++;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC,&time_now);
+		lag = (long long)(time_now.tv_sec - deadline.tv_sec) * NSEC_PER_SEC + (time_now.tv_nsec - deadline.tv_nsec);
+		if(lag > (long long)interval * MAX_MISSED_TICKS) {
+			/* the scheduler has been stalled for too long, resync rather than catch up in a burst */
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"MPF Scheduler Stalled for %lld usec",lag / 1000);
+			deadline = time_now;
+			continue;
+		}
+
+		while(clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&deadline,NULL) == EINTR);
+	}
+
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+#endif
+
 MPF_DECLARE(apt_bool_t) mpf_scheduler_start(mpf_scheduler_t *scheduler)
 {
+	apr_thread_start_t thread_proc = timer_thread_proc;
 	mpf_scheduler_resolution_set(scheduler);
+
+#ifdef ENABLE_MONOTONIC_CLOCK
+	/* a pluggable clock replaces the system monotonic one */
+	if(scheduler->clock == MPF_SCHEDULER_CLOCK_MONOTONIC && !apt_clock_get()) {
+		thread_proc = monotonic_timer_thread_proc;
+	}
+#endif
+	if(scheduler->clock == MPF_SCHEDULER_CLOCK_FREEWHEEL) {
+		thread_proc = freewheel_thread_proc;
+	}
 	
 	scheduler->running = TRUE;
-	if(apr_thread_create(&scheduler->thread,NULL,timer_thread_proc,scheduler,scheduler->pool) != APR_SUCCESS) {
+	if(apr_thread_create(&scheduler->thread,NULL,thread_proc,scheduler,scheduler->pool) != APR_SUCCESS) {
 		scheduler->running = FALSE;
 		return FALSE;
 	}
@@ -0,0 +1,367 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <apr_general.h>
+#include <apr_strings.h>
+#include <apr_base64.h>
+#include "mpf_srtp.h"
+#include "apt_string_table.h"
+#include "apt_log.h"
+
+#define INLINE_KEY_METHOD "inline:"
+
+/** String table of crypto suites (mpf_srtp_crypto_suite_e) */
+static const apt_str_table_item_t mpf_srtp_crypto_suite_table[] = {
+	{{"AES_CM_128_HMAC_SHA1_80", 23},21},
+	{{"AES_CM_128_HMAC_SHA1_32", 23},21},
+	{{"AES_256_CM_HMAC_SHA1_80", 23},4},
+	{{"AEAD_AES_128_GCM",        16},9},
+	{{"AEAD_AES_256_GCM",        16},9}
+};
+
+/** Size of master key and salt by crypto suite (mpf_srtp_crypto_suite_e) */
+static const apr_size_t mpf_srtp_key_size_table[SRTP_CRYPTO_COUNT] = {
+	30, /* 128-bit key + 112-bit salt */
+	30, /* 128-bit key + 112-bit salt */
+	46, /* 256-bit key + 112-bit salt */
+	28, /* 128-bit key + 96-bit salt */
+	44  /* 256-bit key + 96-bit salt */
+};
+
+MPF_DECLARE(const apt_str_t*) mpf_srtp_crypto_suite_str_get(mpf_srtp_crypto_suite_e suite)
+{
+	return apt_string_table_str_get(mpf_srtp_crypto_suite_table,SRTP_CRYPTO_COUNT,suite);
+}
+
+MPF_DECLARE(mpf_srtp_crypto_suite_e) mpf_srtp_crypto_suite_find(const apt_str_t *name)
+{
+	return apt_string_table_id_find(mpf_srtp_crypto_suite_table,SRTP_CRYPTO_COUNT,name);
+}
+
+MPF_DECLARE(mpf_srtp_crypto_t*) mpf_srtp_crypto_create(mpf_srtp_crypto_suite_e suite, apr_size_t tag, apr_pool_t *pool)
+{
+	mpf_srtp_crypto_t *crypto;
+	if(suite >= SRTP_CRYPTO_COUNT) {
+		return NULL;
+	}
+
+	crypto = apr_palloc(pool,sizeof(mpf_srtp_crypto_t));
+	crypto->tag = tag;
+	crypto->suite = suite;
+	crypto->key_size = mpf_srtp_key_size_table[suite];
+	if(apr_generate_random_bytes(crypto->key,crypto->key_size) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Generate SRTP Master Key");
+		return NULL;
+	}
+	return crypto;
+}
+
+MPF_DECLARE(mpf_srtp_crypto_t*) mpf_srtp_crypto_parse(const char *value, apr_pool_t *pool)
+{
+	mpf_srtp_crypto_t *crypto;
+	apt_str_t name;
+	const char *pos;
+	const char *key;
+	char *end;
+	char *coded;
+	char plain[MPF_SRTP_MAX_KEY_SIZE + 4];
+	apr_size_t tag;
+	int size;
+
+	if(!value) {
+		return NULL;
+	}
+
+	tag = strtoul(value,&end,10);
+	if(end == value || *end != ' ') {
+		return NULL;
+	}
+
+	pos = end;
+	while(*pos == ' ') pos++;
+	name.buf = (char*)pos;
+	while(*pos && *pos != ' ') pos++;
+	name.length = pos - name.buf;
+	while(*pos == ' ') pos++;
+
+	if(strncmp(pos,INLINE_KEY_METHOD,sizeof(INLINE_KEY_METHOD)-1) != 0) {
+		return NULL;
+	}
+	key = pos + sizeof(INLINE_KEY_METHOD)-1;
+	pos = key;
+	while(*pos && *pos != '|' && *pos != ';' && *pos != ' ') pos++;
+
+	if(*pos == '|') {
+		/* the lifetime is ignored, MKI is not supported */
+		const char *param = pos + 1;
+		while(*param && *param != '|' && *param != ';' && *param != ' ') {
+			if(*param == ':') {
+				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Not Supported SRTP MKI [%s]",value);
+				return NULL;
+			}
+			param++;
+		}
+		if(*param == '|') {
+			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Not Supported SRTP MKI [%s]",value);
+			return NULL;
+		}
+	}
+
+	crypto = apr_palloc(pool,sizeof(mpf_srtp_crypto_t));
+	crypto->tag = tag;
+	crypto->suite = mpf_srtp_crypto_suite_find(&name);
+	if(crypto->suite == SRTP_CRYPTO_UNKNOWN) {
+		return NULL;
+	}
+
+	coded = apr_pstrmemdup(pool,key,pos - key);
+	if(apr_base64_decode_len(coded) > (int)sizeof(plain)) {
+		return NULL;
+	}
+	size = apr_base64_decode(plain,coded);
+	if(size != (int)mpf_srtp_key_size_table[crypto->suite]) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid SRTP Key Size [%d] for [%s]",size,name.buf);
+		return NULL;
+	}
+	memcpy(crypto->key,plain,size);
+	crypto->key_size = size;
+	return crypto;
+}
+
+MPF_DECLARE(apr_size_t) mpf_srtp_crypto_generate(const mpf_srtp_crypto_t *crypto, char *buffer, apr_size_t size)
+{
+	char coded[((MPF_SRTP_MAX_KEY_SIZE + 2) / 3 * 4) + 1];
+	const apt_str_t *name = mpf_srtp_crypto_suite_str_get(crypto->suite);
+	int length;
+	if(!name) {
+		return 0;
+	}
+
+	apr_base64_encode(coded,(const char*)crypto->key,(int)crypto->key_size);
+	length = apr_snprintf(buffer,size,"%"APR_SIZE_T_FMT" %s "INLINE_KEY_METHOD"%s",crypto->tag,name->buf,coded);
+	if(length < 0) {
+		return 0;
+	}
+	return (apr_size_t)length;
+}
+
+#ifdef MPF_HAVE_SRTP
+
+#include <srtp2/srtp.h>
+
+/** SRTP session */
+struct mpf_srtp_t {
+	srtp_t session;
+};
+
+/** Whether the crypto suite is supported by libsrtp (depends on its crypto backend) */
+static apt_bool_t mpf_srtp_supported_table[SRTP_CRYPTO_COUNT];
+
+static apt_bool_t mpf_srtp_policy_set(srtp_policy_t *policy, const mpf_srtp_crypto_t *crypto, srtp_ssrc_type_t ssrc_type)
+{
+	memset(policy,0,sizeof(srtp_policy_t));
+	switch(crypto->suite) {
+		case SRTP_CRYPTO_AES_CM_128_HMAC_SHA1_80:
+			srtp_crypto_policy_set_rtp_default(&policy->rtp);
+			srtp_crypto_policy_set_rtcp_default(&policy->rtcp);
+			break;
+		case SRTP_CRYPTO_AES_CM_128_HMAC_SHA1_32:
+			/* SRTCP keeps 80-bit tag (RFC 4568) */
+			srtp_crypto_policy_set_aes_cm_128_hmac_sha1_32(&policy->rtp);
+			srtp_crypto_policy_set_rtcp_default(&policy->rtcp);
+			break;
+		case SRTP_CRYPTO_AES_256_CM_HMAC_SHA1_80:
+			srtp_crypto_policy_set_aes_cm_256_hmac_sha1_80(&policy->rtp);
+			srtp_crypto_policy_set_aes_cm_256_hmac_sha1_80(&policy->rtcp);
+			break;
+		case SRTP_CRYPTO_AEAD_AES_128_GCM:
+			srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy->rtp);
+			srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy->rtcp);
+			break;
+		case SRTP_CRYPTO_AEAD_AES_256_GCM:
+			srtp_crypto_policy_set_aes_gcm_256_16_auth(&policy->rtp);
+			srtp_crypto_policy_set_aes_gcm_256_16_auth(&policy->rtcp);
+			break;
+		default:
+			return FALSE;
+	}
+	policy->ssrc.type = ssrc_type;
+	policy->key = (unsigned char*)crypto->key;
+	policy->window_size = 128;
+	policy->allow_repeat_tx = 0;
+	policy->next = NULL;
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_srtp_init(void)
+{
+	mpf_srtp_crypto_t crypto;
+	srtp_policy_t policy;
+	srtp_t session;
+	int i;
+	if(srtp_init() != srtp_err_status_ok) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Initialize SRTP");
+		return FALSE;
+	}
+
+	/* AEAD and AES-256 ciphers are available only with OpenSSL (AES-NI) backend of libsrtp */
+	memset(&crypto,0,sizeof(crypto));
+	for(i=0; i<SRTP_CRYPTO_COUNT; i++) {
+		crypto.suite = i;
+		crypto.key_size = mpf_srtp_key_size_table[i];
+		mpf_srtp_supported_table[i] = FALSE;
+		if(mpf_srtp_policy_set(&policy,&crypto,ssrc_any_outbound) == TRUE &&
+			srtp_create(&session,&policy) == srtp_err_status_ok) {
+			mpf_srtp_supported_table[i] = TRUE;
+			srtp_dealloc(session);
+		}
+	}
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_srtp_is_available(void)
+{
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_srtp_crypto_suite_supported(mpf_srtp_crypto_suite_e suite)
+{
+	if(suite >= SRTP_CRYPTO_COUNT) {
+		return FALSE;
+	}
+	return mpf_srtp_supported_table[suite];
+}
+
+MPF_DECLARE(mpf_srtp_t*) mpf_srtp_create(const mpf_srtp_crypto_t *tx_crypto, const mpf_srtp_crypto_t *rx_crypto, apr_pool_t *pool)
+{
+	mpf_srtp_t *srtp;
+	srtp_policy_t tx_policy;
+	srtp_policy_t rx_policy;
+	srtp_err_status_t status;
+
+	if(mpf_srtp_policy_set(&tx_policy,tx_crypto,ssrc_any_outbound) == FALSE ||
+		mpf_srtp_policy_set(&rx_policy,rx_crypto,ssrc_any_inbound) == FALSE) {
+		return NULL;
+	}
+	tx_policy.next = &rx_policy;
+
+	srtp = apr_palloc(pool,sizeof(mpf_srtp_t));
+	status = srtp_create(&srtp->session,&tx_policy);
+	if(status != srtp_err_status_ok) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create SRTP Session [%d]",status);
+		return NULL;
+	}
+	return srtp;
+}
+
+MPF_DECLARE(void) mpf_srtp_destroy(mpf_srtp_t *srtp)
+{
+	if(srtp->session) {
+		srtp_dealloc(srtp->session);
+		srtp->session = NULL;
+	}
+}
+
+MPF_DECLARE(apt_bool_t) mpf_srtp_protect(mpf_srtp_t *srtp, void *packet, apr_size_t *size)
+{
+	int length = (int)*size;
+	if(srtp_protect(srtp->session,packet,&length) != srtp_err_status_ok) {
+		return FALSE;
+	}
+	*size = length;
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_srtp_unprotect(mpf_srtp_t *srtp, void *packet, apr_size_t *size)
+{
+	int length = (int)*size;
+	if(srtp_unprotect(srtp->session,packet,&length) != srtp_err_status_ok) {
+		return FALSE;
+	}
+	*size = length;
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_srtcp_protect(mpf_srtp_t *srtp, void *packet, apr_size_t *size)
+{
+	int length = (int)*size;
+	if(srtp_protect_rtcp(srtp->session,packet,&length) != srtp_err_status_ok) {
+		return FALSE;
+	}
+	*size = length;
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_srtcp_unprotect(mpf_srtp_t *srtp, void *packet, apr_size_t *size)
+{
+	int length = (int)*size;
+	if(srtp_unprotect_rtcp(srtp->session,packet,&length) != srtp_err_status_ok) {
+		return FALSE;
+	}
+	*size = length;
+	return TRUE;
+}
+
+#else /* MPF_HAVE_SRTP */
+
+MPF_DECLARE(apt_bool_t) mpf_srtp_init(void)
+{
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_srtp_is_available(void)
+{
+	return FALSE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_srtp_crypto_suite_supported(mpf_srtp_crypto_suite_e suite)
+{
+	return FALSE;
+}
+
+MPF_DECLARE(mpf_srtp_t*) mpf_srtp_create(const mpf_srtp_crypto_t *tx_crypto, const mpf_srtp_crypto_t *rx_crypto, apr_pool_t *pool)
+{
+	return NULL;
+}
+
+MPF_DECLARE(void) mpf_srtp_destroy(mpf_srtp_t *srtp)
+{
+}
+
+MPF_DECLARE(apt_bool_t) mpf_srtp_protect(mpf_srtp_t *srtp, void *packet, apr_size_t *size)
+{
+	return FALSE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_srtp_unprotect(mpf_srtp_t *srtp, void *packet, apr_size_t *size)
+{
+	return FALSE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_srtcp_protect(mpf_srtp_t *srtp, void *packet, apr_size_t *size)
+{
+	return FALSE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_srtcp_unprotect(mpf_srtp_t *srtp, void *packet, apr_size_t *size)
+{
+	return FALSE;
+}
+
+#endif /* MPF_HAVE_SRTP */
@@ -75,8 +75,16 @@ MPF_DECLARE(mpf_audio_stream_t*) mpf_audio_stream_create(void *obj, const mpf_au
 	stream->direction = capabilities->direction;
 	stream->rx_descriptor = NULL;
 	stream->rx_event_descriptor = NULL;
+	stream->rx_cn_descriptor = NULL;
 	stream->tx_descriptor = NULL;
 	stream->tx_event_descriptor = NULL;
+	stream->tx_cn_descriptor = NULL;
+	stream->tx_inactive = 0;
+	stream->rx_event_direct = FALSE;
+	stream->rx_event_sink = NULL;
+	stream->rx_skew_compensation = FALSE;
+	stream->rx_skew = 0;
+	stream->network = FALSE;
 	return stream;
 }
 
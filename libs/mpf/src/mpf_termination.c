@@ -36,6 +36,12 @@ MPF_DECLARE(mpf_termination_t*) mpf_termination_base_create(
 	termination->event_handler = NULL;
 	termination->codec_manager = NULL;
 	termination->timer_queue = NULL;
+	termination->tx_batch = NULL;
+	termination->uring = NULL;
+	termination->jb_slab = NULL;
+	termination->rtcp_agent = NULL;
+	termination->worker_id = 0;
+	termination->overload_level = NULL;
 	termination->termination_factory = termination_factory;
 	termination->vtable = vtable;
 	termination->slot = 0;
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+/* sendmmsg() is a GNU extension */
+#define _GNU_SOURCE
+#endif
+
+#include <apr_portable.h>
+#if defined(__linux__)
+#include <sys/socket.h>
+#if defined(MSG_WAITFORONE)
+/** Send datagrams queued for the same socket by a single sendmmsg() call */
+#define ENABLE_TX_SENDMMSG
+#endif
+#endif
+#include "mpf_tx_batch.h"
+#include "apt_log.h"
+
+/** Datagram queued in batch */
+typedef struct mpf_tx_packet_t mpf_tx_packet_t;
+struct mpf_tx_packet_t {
+	apr_socket_t   *socket;
+	apr_sockaddr_t *sockaddr;
+	apr_size_t      size;
+	char            data[MPF_TX_BATCH_PACKET_SIZE];
+};
+
+/** Batch of outgoing datagrams */
+struct mpf_tx_batch_t {
+	mpf_tx_packet_t *packets;
+	apr_size_t       count;
+	apr_size_t       max_count;
+	mpf_uring_t     *uring;
+#ifdef ENABLE_TX_SENDMMSG
+	struct mmsghdr  *msgs;
+	struct iovec    *iovecs;
+#endif
+};
+
+MPF_DECLARE(mpf_tx_batch_t*) mpf_tx_batch_create(apr_size_t max_count, apr_pool_t *pool)
+{
+	mpf_tx_batch_t *batch;
+	if(!max_count) {
+		max_count = MPF_TX_BATCH_DEFAULT_SIZE;
+	}
+	batch = apr_palloc(pool,sizeof(mpf_tx_batch_t));
+	batch->packets = apr_palloc(pool,sizeof(mpf_tx_packet_t) * max_count);
+	batch->count = 0;
+	batch->max_count = max_count;
+	batch->uring = NULL;
+#ifdef ENABLE_TX_SENDMMSG
+	batch->msgs = apr_palloc(pool,sizeof(struct mmsghdr) * max_count);
+	batch->iovecs = apr_palloc(pool,sizeof(struct iovec) * max_count);
+#endif
+	return batch;
+}
+
+MPF_DECLARE(void) mpf_tx_batch_destroy(mpf_tx_batch_t *batch)
+{
+	if(batch->count) {
+		mpf_tx_batch_flush(batch);
+	}
+}
+
+MPF_DECLARE(void) mpf_tx_batch_uring_set(mpf_tx_batch_t *batch, mpf_uring_t *uring)
+{
+	batch->uring = uring;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_tx_batch_add(
+							mpf_tx_batch_t *batch,
+							apr_socket_t *socket,
+							apr_sockaddr_t *sockaddr,
+							const void *data,
+							apr_size_t size)
+{
+	mpf_tx_packet_t *packet;
+	if(size > MPF_TX_BATCH_PACKET_SIZE) {
+		return FALSE;
+	}
+	if(batch->count == batch->max_count) {
+		mpf_tx_batch_flush(batch);
+	}
+
+	packet = &batch->packets[batch->count++];
+	packet->socket = socket;
+	packet->sockaddr = sockaddr;
+	packet->size = size;
+	memcpy(packet->data,data,size);
+	return TRUE;
+}
+
+#ifdef ENABLE_TX_SENDMMSG
+/** Send the run of datagrams queued for the same socket */
+static apr_size_t mpf_tx_batch_run_send(mpf_tx_batch_t *batch, apr_size_t offset, apr_size_t count)
+{
+	apr_os_sock_t fd;
+	struct mmsghdr *msgs = batch->msgs + offset;
+	apr_size_t failed = 0;
+	apr_size_t i;
+	int sent;
+
+	if(apr_os_sock_get(&fd,batch->packets[offset].socket) != APR_SUCCESS) {
+		return count;
+	}
+
+	memset(msgs,0,sizeof(struct mmsghdr) * count);
+	for(i=0; i<count; i++) {
+		mpf_tx_packet_t *packet = &batch->packets[offset + i];
+		batch->iovecs[offset + i].iov_base = packet->data;
+		batch->iovecs[offset + i].iov_len = packet->size;
+		msgs[i].msg_hdr.msg_name = &packet->sockaddr->sa;
+		msgs[i].msg_hdr.msg_namelen = packet->sockaddr->salen;
+		msgs[i].msg_hdr.msg_iov = &batch->iovecs[offset + i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	while(count) {
+		sent = sendmmsg(fd,msgs,(unsigned int)count,0);
+		if(sent <= 0) {
+			/* skip the datagram which failed to send and go on with the rest */
+			sent = 1;
+			failed++;
+		}
+		msgs += sent;
+		count -= sent;
+	}
+	return failed;
+}
+#else
+/** Send the run of datagrams queued for the same socket */
+static apr_size_t mpf_tx_batch_run_send(mpf_tx_batch_t *batch, apr_size_t offset, apr_size_t count)
+{
+	apr_size_t failed = 0;
+	apr_size_t size;
+	apr_size_t i;
+	for(i=offset; i<offset+count; i++) {
+		mpf_tx_packet_t *packet = &batch->packets[i];
+		size = packet->size;
+		if(apr_socket_sendto(packet->socket,packet->sockaddr,0,packet->data,&size) != APR_SUCCESS) {
+			failed++;
+		}
+	}
+	return failed;
+}
+#endif
+
+MPF_DECLARE(apr_size_t) mpf_tx_batch_flush(mpf_tx_batch_t *batch)
+{
+	apr_size_t failed = 0;
+	apr_size_t offset = 0;
+	apr_size_t i;
+
+	if(batch->uring) {
+		/* the datagrams of all the sockets are submitted at once */
+		for(i=0; i<batch->count; i++) {
+			mpf_tx_packet_t *packet = &batch->packets[i];
+			if(mpf_uring_send(batch->uring,packet->socket,packet->sockaddr,packet->data,packet->size) == FALSE) {
+				failed++;
+			}
+		}
+		failed += mpf_uring_send_flush(batch->uring);
+	}
+	else {
+		/* datagrams of a stream are queued in a row, send them run by run */
+		for(i=1; i<=batch->count; i++) {
+			if(i == batch->count || batch->packets[i].socket != batch->packets[offset].socket) {
+				failed += mpf_tx_batch_run_send(batch,offset,i - offset);
+				offset = i;
+			}
+		}
+	}
+
+	if(failed) {
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Failed to Send Datagrams [%"APR_SIZE_T_FMT"/%"APR_SIZE_T_FMT"]",
+			failed,batch->count);
+	}
+	batch->count = 0;
+	return failed;
+}
@@ -0,0 +1,392 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+#include "mpf_uring.h"
+#include "apt_log.h"
+
+#ifdef MPF_HAVE_IO_URING
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <apr_hash.h>
+#include <apr_portable.h>
+#include <liburing.h>
+
+/** Buffer group of provided receive buffers */
+#define MPF_URING_BUF_GROUP 0
+/** Number of provided receive buffers (power of 2) */
+#define MPF_URING_BUF_COUNT 1024
+/** Size of provided receive buffer (max size of RTP packet) */
+#define MPF_URING_BUF_SIZE  1500
+
+/** Multishot receive registration */
+typedef struct mpf_uring_recv_t mpf_uring_recv_t;
+struct mpf_uring_recv_t {
+	/** Object to pass to the handler (key of registration) */
+	void                    *obj;
+	/** Datagram handler */
+	mpf_uring_recv_handler_f handler;
+	/** Socket descriptor */
+	apr_os_sock_t            fd;
+	/** Whether multishot receive is in flight */
+	apt_bool_t               armed;
+	/** Whether the registration is cancelled */
+	apt_bool_t               cancelled;
+	/** Next registration in the list of free ones */
+	mpf_uring_recv_t        *next;
+};
+
+/** io_uring instance */
+struct mpf_uring_t {
+	struct io_uring          ring;
+	struct io_uring_buf_ring *buf_ring;
+	char                    *buffers;
+
+	/** Table of registrations by object */
+	apr_hash_t              *recv_table;
+	/** List of free registrations to reuse */
+	mpf_uring_recv_t        *free_recvs;
+
+	struct msghdr           *send_msgs;
+	struct iovec            *send_iovecs;
+	apr_size_t               send_count;
+	apr_size_t               send_max_count;
+	apr_size_t               send_pending;
+	apr_size_t               send_failed;
+
+	apr_pool_t              *pool;
+};
+
+/* tags of the completions carrying no registration */
+static char mpf_uring_send_tag;
+static char mpf_uring_cancel_tag;
+
+MPF_DECLARE(apt_bool_t) mpf_uring_is_available(void)
+{
+	return TRUE;
+}
+
+MPF_DECLARE(mpf_uring_t*) mpf_uring_create(apr_size_t depth, apr_pool_t *pool)
+{
+	int i;
+	int status;
+	mpf_uring_t *uring;
+	if(!depth) {
+		depth = MPF_URING_DEFAULT_DEPTH;
+	}
+
+	uring = apr_palloc(pool,sizeof(mpf_uring_t));
+	status = io_uring_queue_init((unsigned int)depth,&uring->ring,0);
+	if(status < 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Init io_uring [%d]",status);
+		return NULL;
+	}
+	uring->buf_ring = io_uring_setup_buf_ring(&uring->ring,MPF_URING_BUF_COUNT,MPF_URING_BUF_GROUP,0,&status);
+	if(!uring->buf_ring) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Setup io_uring Provided Buffers [%d]",status);
+		io_uring_queue_exit(&uring->ring);
+		return NULL;
+	}
+	uring->buffers = apr_palloc(pool,MPF_URING_BUF_COUNT * MPF_URING_BUF_SIZE);
+	for(i=0; i<MPF_URING_BUF_COUNT; i++) {
+		io_uring_buf_ring_add(uring->buf_ring,
+			uring->buffers + i * MPF_URING_BUF_SIZE,MPF_URING_BUF_SIZE,
+			(unsigned short)i,io_uring_buf_ring_mask(MPF_URING_BUF_COUNT),i);
+	}
+	io_uring_buf_ring_advance(uring->buf_ring,MPF_URING_BUF_COUNT);
+
+	uring->recv_table = apr_hash_make(pool);
+	uring->free_recvs = NULL;
+	uring->send_max_count = depth;
+	uring->send_msgs = apr_palloc(pool,sizeof(struct msghdr) * depth);
+	uring->send_iovecs = apr_palloc(pool,sizeof(struct iovec) * depth);
+	uring->send_count = 0;
+	uring->send_pending = 0;
+	uring->send_failed = 0;
+	uring->pool = pool;
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Create io_uring [%"APR_SIZE_T_FMT" entries]",depth);
+	return uring;
+}
+
+MPF_DECLARE(void) mpf_uring_destroy(mpf_uring_t *uring)
+{
+	io_uring_free_buf_ring(&uring->ring,uring->buf_ring,MPF_URING_BUF_COUNT,MPF_URING_BUF_GROUP);
+	io_uring_queue_exit(&uring->ring);
+}
+
+static struct io_uring_sqe* mpf_uring_sqe_get(mpf_uring_t *uring)
+{
+	struct io_uring_sqe *sqe = io_uring_get_sqe(&uring->ring);
+	if(!sqe) {
+		/* submission queue is full, submit and retry */
+		io_uring_submit(&uring->ring);
+		sqe = io_uring_get_sqe(&uring->ring);
+	}
+	return sqe;
+}
+
+static apt_bool_t mpf_uring_recv_arm(mpf_uring_t *uring, mpf_uring_recv_t *recv)
+{
+	struct io_uring_sqe *sqe = mpf_uring_sqe_get(uring);
+	if(!sqe) {
+		return FALSE;
+	}
+	io_uring_prep_recv_multishot(sqe,recv->fd,NULL,0,0);
+	sqe->flags |= IOSQE_BUFFER_SELECT;
+	sqe->buf_group = MPF_URING_BUF_GROUP;
+	io_uring_sqe_set_data(sqe,recv);
+	recv->armed = TRUE;
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_uring_recv_register(
+							mpf_uring_t *uring,
+							apr_socket_t *socket,
+							mpf_uring_recv_handler_f handler,
+							void *obj)
+{
+	apr_os_sock_t fd;
+	mpf_uring_recv_t *recv;
+	if(apr_os_sock_get(&fd,socket) != APR_SUCCESS) {
+		return FALSE;
+	}
+	if(apr_hash_get(uring->recv_table,&obj,sizeof(obj))) {
+		/* already registered */
+		return FALSE;
+	}
+
+	recv = uring->free_recvs;
+	if(recv) {
+		uring->free_recvs = recv->next;
+	}
+	else {
+		recv = apr_palloc(uring->pool,sizeof(mpf_uring_recv_t));
+	}
+	recv->obj = obj;
+	recv->handler = handler;
+	recv->fd = fd;
+	recv->armed = FALSE;
+	recv->cancelled = FALSE;
+	recv->next = NULL;
+	if(mpf_uring_recv_arm(uring,recv) == FALSE) {
+		recv->next = uring->free_recvs;
+		uring->free_recvs = recv;
+		return FALSE;
+	}
+	apr_hash_set(uring->recv_table,&recv->obj,sizeof(recv->obj),recv);
+	return TRUE;
+}
+
+static void mpf_uring_recv_release(mpf_uring_t *uring, mpf_uring_recv_t *recv)
+{
+	recv->obj = NULL;
+	recv->next = uring->free_recvs;
+	uring->free_recvs = recv;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_uring_recv_unregister(mpf_uring_t *uring, void *obj)
+{
+	struct io_uring_sqe *sqe;
+	mpf_uring_recv_t *recv = apr_hash_get(uring->recv_table,&obj,sizeof(obj));
+	if(!recv) {
+		return FALSE;
+	}
+	apr_hash_set(uring->recv_table,&recv->obj,sizeof(recv->obj),NULL);
+	recv->cancelled = TRUE;
+	recv->handler = NULL;
+
+	if(recv->armed == FALSE) {
+		mpf_uring_recv_release(uring,recv);
+		return TRUE;
+	}
+
+	/* the registration is released on the final completion of multishot receive */
+	sqe = mpf_uring_sqe_get(uring);
+	if(sqe) {
+		io_uring_prep_cancel(sqe,recv,0);
+		io_uring_sqe_set_data(sqe,&mpf_uring_cancel_tag);
+	}
+	/* submit right away, the socket is about to be closed */
+	io_uring_submit(&uring->ring);
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_uring_send(
+							mpf_uring_t *uring,
+							apr_socket_t *socket,
+							apr_sockaddr_t *sockaddr,
+							const void *data,
+							apr_size_t size)
+{
+	apr_os_sock_t fd;
+	struct io_uring_sqe *sqe;
+	struct msghdr *msg;
+	struct iovec *iov;
+	if(apr_os_sock_get(&fd,socket) != APR_SUCCESS) {
+		return FALSE;
+	}
+	if(uring->send_count == uring->send_max_count) {
+		mpf_uring_send_flush(uring);
+	}
+	sqe = mpf_uring_sqe_get(uring);
+	if(!sqe) {
+		return FALSE;
+	}
+
+	msg = &uring->send_msgs[uring->send_count];
+	iov = &uring->send_iovecs[uring->send_count];
+	uring->send_count++;
+	iov->iov_base = (void*)data;
+	iov->iov_len = size;
+	memset(msg,0,sizeof(struct msghdr));
+	msg->msg_name = &sockaddr->sa;
+	msg->msg_namelen = sockaddr->salen;
+	msg->msg_iov = iov;
+	msg->msg_iovlen = 1;
+
+	/* never wait for the socket to become writable, drop the datagram like sendto() would */
+	io_uring_prep_sendmsg(sqe,fd,msg,MSG_DONTWAIT);
+	io_uring_sqe_set_data(sqe,&mpf_uring_send_tag);
+	uring->send_pending++;
+	return TRUE;
+}
+
+static apr_size_t mpf_uring_cq_reap(mpf_uring_t *uring)
+{
+	struct io_uring_cqe *cqe;
+	mpf_uring_recv_t *recv;
+	void *data;
+	apr_size_t count = 0;
+	while(io_uring_peek_cqe(&uring->ring,&cqe) == 0) {
+		data = io_uring_cqe_get_data(cqe);
+		if(data == &mpf_uring_send_tag) {
+			uring->send_pending--;
+			if(cqe->res < 0) {
+				uring->send_failed++;
+			}
+		}
+		else if(data && data != &mpf_uring_cancel_tag) {
+			recv = data;
+			if(cqe->flags & IORING_CQE_F_BUFFER) {
+				unsigned short bid = (unsigned short)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+				char *buffer = uring->buffers + bid * MPF_URING_BUF_SIZE;
+				if(recv->cancelled == FALSE && cqe->res > 0) {
+					recv->handler(recv->obj,buffer,(apr_size_t)cqe->res);
+					count++;
+				}
+				/* give the buffer back to the kernel */
+				io_uring_buf_ring_add(uring->buf_ring,buffer,MPF_URING_BUF_SIZE,bid,
+					io_uring_buf_ring_mask(MPF_URING_BUF_COUNT),0);
+				io_uring_buf_ring_advance(uring->buf_ring,1);
+			}
+			if(!(cqe->flags & IORING_CQE_F_MORE)) {
+				/* multishot receive terminated */
+				recv->armed = FALSE;
+				if(recv->cancelled == TRUE) {
+					mpf_uring_recv_release(uring,recv);
+				}
+				else if(cqe->res >= 0 || cqe->res == -ENOBUFS) {
+					/* re-arm, submitted on the next call */
+					mpf_uring_recv_arm(uring,recv);
+				}
+				else {
+					apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Multishot Receive Terminated [%d]",cqe->res);
+				}
+			}
+		}
+		io_uring_cqe_seen(&uring->ring,cqe);
+	}
+	return count;
+}
+
+MPF_DECLARE(apr_size_t) mpf_uring_send_flush(mpf_uring_t *uring)
+{
+	apr_size_t failed;
+	while(uring->send_pending) {
+		if(io_uring_submit_and_wait(&uring->ring,1) < 0) {
+			break;
+		}
+		mpf_uring_cq_reap(uring);
+	}
+	failed = uring->send_failed;
+	uring->send_count = 0;
+	uring->send_failed = 0;
+	return failed;
+}
+
+MPF_DECLARE(apr_size_t) mpf_uring_process(mpf_uring_t *uring)
+{
+	if(io_uring_sq_ready(&uring->ring)) {
+		/* re-armed receives */
+		io_uring_submit(&uring->ring);
+	}
+	return mpf_uring_cq_reap(uring);
+}
+
+#else /* MPF_HAVE_IO_URING */
+
+MPF_DECLARE(apt_bool_t) mpf_uring_is_available(void)
+{
+	return FALSE;
+}
+
+MPF_DECLARE(mpf_uring_t*) mpf_uring_create(apr_size_t depth, apr_pool_t *pool)
+{
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"io_uring Support Is Not Compiled In");
+	return NULL;
+}
+
+MPF_DECLARE(void) mpf_uring_destroy(mpf_uring_t *uring)
+{
+}
+
+MPF_DECLARE(apt_bool_t) mpf_uring_recv_register(
+							mpf_uring_t *uring,
+							apr_socket_t *socket,
+							mpf_uring_recv_handler_f handler,
+							void *obj)
+{
+	return FALSE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_uring_recv_unregister(mpf_uring_t *uring, void *obj)
+{
+	return FALSE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_uring_send(
+							mpf_uring_t *uring,
+							apr_socket_t *socket,
+							apr_sockaddr_t *sockaddr,
+							const void *data,
+							apr_size_t size)
+{
+	return FALSE;
+}
+
+MPF_DECLARE(apr_size_t) mpf_uring_send_flush(mpf_uring_t *uring)
+{
+	return 0;
+}
+
+MPF_DECLARE(apr_size_t) mpf_uring_process(mpf_uring_t *uring)
+{
+	return 0;
+}
+
+#endif /* MPF_HAVE_IO_URING */
@@ -371,6 +371,37 @@ MRCP_DECLARE(mpf_termination_t*) mrcp_application_sink_termination_create(
 										mpf_codec_descriptor_t *codec_descriptor,
 										void *obj);
 
+/**
+ * Create source media termination of pre-encoded frames.
+ * @param session the session to create termination for
+ * @param codec_descriptor the codec the frames are encoded with
+ * @param depth the number of frames buffered ahead of play-out
+ * @remark The source offers only the codec, so that the frames are sent by
+ *         pure RTP packetization with no decoding and re-encoding by the client
+ *         media engine. The frames are written from any single application thread
+ *         by mrcp_application_encoded_frame_write(), the timestamps place them
+ *         in time instead of the pace they are written at.
+ */
+MRCP_DECLARE(mpf_termination_t*) mrcp_application_encoded_termination_create(
+										mrcp_session_t *session,
+										const mpf_codec_descriptor_t *codec_descriptor,
+										apr_size_t depth);
+
+/**
+ * Write pre-encoded frame to the termination.
+ * @param termination the termination created by mrcp_application_encoded_termination_create()
+ * @param data the payload of a frame (CODEC_FRAME_TIME_BASE msec of audio of the codec)
+ * @param size the size of the payload
+ * @param timestamp the timestamp of the frame in units of the RTP clock rate of the codec
+ * @return FALSE if the frame is dropped
+ * @see mpf_encoded_source_write()
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_application_encoded_frame_write(
+										mpf_termination_t *termination,
+										const void *data,
+										apr_size_t size,
+										apr_uint32_t timestamp);
+
 APT_END_EXTERN_C
 
 #endif /* MRCP_APPLICATION_H */
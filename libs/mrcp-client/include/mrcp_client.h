@@ -66,6 +66,17 @@ MRCP_DECLARE(apt_bool_t) mrcp_client_shutdown(mrcp_client_t *client);
  */
 MRCP_DECLARE(apt_bool_t) mrcp_client_destroy(mrcp_client_t *client);
 
+/**
+ * Set the number of worker threads sessions are processed by.
+ * @param client the MRCP client to set the worker count for
+ * @param count the number of workers (1 by default)
+ * @remark Messages of a session are always processed by the same worker. The function
+ *         must be called before the client is started. Application message handlers
+ *         are called by the workers, so they must be thread-safe, if more than one
+ *         worker is set.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_client_worker_count_set(mrcp_client_t *client, apr_size_t count);
+
 
 /**
  * Register MRCP resource factory.
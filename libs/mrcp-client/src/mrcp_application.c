@@ -24,6 +24,8 @@
 #include "mrcp_sig_agent.h"
 #include "mrcp_resource_factory.h"
 #include "mpf_termination_factory.h"
+#include "mpf_termination.h"
+#include "mpf_encoded_source.h"
 #include "apt_dir_layout.h"
 #include "apt_pool.h"
 #include "apt_log.h"
@@ -484,6 +486,50 @@ MRCP_DECLARE(mpf_termination_t*) mrcp_application_sink_termination_create(
 			session->pool);       /* memory pool to allocate memory from */
 }
 
+/** Create source media termination of pre-encoded frames */
+MRCP_DECLARE(mpf_termination_t*) mrcp_application_encoded_termination_create(
+										mrcp_session_t *session,
+										const mpf_codec_descriptor_t *codec_descriptor,
+										apr_size_t depth)
+{
+	mpf_audio_stream_t *audio_stream;
+
+	if(!codec_descriptor) {
+		return NULL;
+	}
+
+	/* create audio stream of the only codec */
+	audio_stream = mpf_encoded_source_create(codec_descriptor,depth,session->pool);
+	if(!audio_stream) {
+		return NULL;
+	}
+
+	/* create raw termination */
+	return mpf_raw_termination_create(
+			NULL,                 /* no object to associate */
+			audio_stream,         /* audio stream */
+			NULL,                 /* no video stream */
+			session->pool);       /* memory pool to allocate memory from */
+}
+
+/** Write pre-encoded frame to the termination */
+MRCP_DECLARE(apt_bool_t) mrcp_application_encoded_frame_write(
+										mpf_termination_t *termination,
+										const void *data,
+										apr_size_t size,
+										apr_uint32_t timestamp)
+{
+	mpf_encoded_source_t *source;
+	if(!termination || !termination->audio_stream) {
+		return FALSE;
+	}
+	source = mpf_encoded_source_get(termination->audio_stream);
+	if(!source) {
+		return FALSE;
+	}
+	return mpf_encoded_source_write(source,data,size,timestamp);
+}
+
 /** Dispatch application message */
 MRCP_DECLARE(apt_bool_t) mrcp_application_message_dispatch(const mrcp_app_message_dispatcher_t *dispatcher, const mrcp_app_message_t *app_message)
 {
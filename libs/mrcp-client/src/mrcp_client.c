@@ -17,6 +17,7 @@
  */
 
 #include <apr_thread_cond.h>
+#include <apr_thread_mutex.h>
 #include <apr_hash.h>
 #include "mrcp_client.h"
 #include "mrcp_sig_agent.h"
@@ -24,6 +25,7 @@
 #include "mrcp_client_connection.h"
 #include "mrcp_ca_factory.h"
 #include "mpf_engine_factory.h"
+#include "mpf_engine.h"
 #include "apt_consumer_task.h"
 #include "apt_pool.h"
 #include "apt_log.h"
@@ -59,6 +61,8 @@ struct mrcp_client_t {
 
 	/** Table of sessions/handles */
 	apr_hash_t              *session_table;
+	/** Mutex to protect the table of sessions, as sessions may be processed by several workers */
+	apr_thread_mutex_t      *session_mutex;
 
 	/** Connection task message pool */
 	apt_task_msg_pool_t     *cnt_msg_pool;
@@ -153,6 +157,7 @@ static const mrcp_connection_event_vtable_t connection_method_vtable = {
 static void mrcp_client_on_start_complete(apt_task_t *task);
 static void mrcp_client_on_terminate_complete(apt_task_t *task);
 static apt_bool_t mrcp_client_msg_process(apt_task_t *task, apt_task_msg_t *msg);
+static apr_size_t mrcp_client_msg_affinity_get(apt_consumer_task_t *task, const apt_task_msg_t *msg);
 
 
 /** Create MRCP client instance */
@@ -183,6 +188,7 @@ MRCP_DECLARE(mrcp_client_t*) mrcp_client_create(apt_dir_layout_t *dir_layout)
 	client->profile_table = NULL;
 	client->app_table = NULL;
 	client->session_table = NULL;
+	client->session_mutex = NULL;
 	client->cnt_msg_pool = NULL;
 
 	msg_pool = apt_task_msg_pool_create_dynamic(0,pool);
@@ -210,6 +216,7 @@ MRCP_DECLARE(mrcp_client_t*) mrcp_client_create(apt_dir_layout_t *dir_layout)
 	client->app_table = apr_hash_make(client->pool);
 	
 	client->session_table = apr_hash_make(client->pool);
+	apr_thread_mutex_create(&client->session_mutex,APR_THREAD_MUTEX_DEFAULT,client->pool);
 
 	client->on_start_complete = NULL;
 	client->sync_start_object = NULL;
@@ -308,6 +315,22 @@ MRCP_DECLARE(apt_bool_t) mrcp_client_destroy(mrcp_client_t *client)
 }
 
 
+/** Set the number of worker threads sessions are processed by */
+MRCP_DECLARE(apt_bool_t) mrcp_client_worker_count_set(mrcp_client_t *client, apr_size_t count)
+{
+	if(!client || !client->task) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Client");
+		return FALSE;
+	}
+	if(apt_consumer_task_workers_set(client->task,count,mrcp_client_msg_affinity_get) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Set Worker Count [%"APR_SIZE_T_FMT"]",count);
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Worker Count [%"APR_SIZE_T_FMT"]",count);
+	return TRUE;
+}
+
+
 /** Register MRCP resource factory */
 MRCP_DECLARE(apt_bool_t) mrcp_client_resource_factory_register(mrcp_client_t *client, mrcp_resource_factory_t *resource_factory)
 {
@@ -698,7 +721,9 @@ void mrcp_client_session_add(mrcp_client_t *client, mrcp_client_session_t *sessi
 		apt_obj_log(APT_LOG_MARK,APT_PRIO_INFO,session->base.log_obj,"Add MRCP Handle "APT_NAMESID_FMT,
 			session->base.name,
 			MRCP_SESSION_SID(&session->base));
+		apr_thread_mutex_lock(client->session_mutex);
 		apr_hash_set(client->session_table,session,sizeof(void*),session);
+		apr_thread_mutex_unlock(client->session_mutex);
 	}
 }
 
@@ -708,7 +733,9 @@ void mrcp_client_session_remove(mrcp_client_t *client, mrcp_client_session_t *se
 		apt_obj_log(APT_LOG_MARK,APT_PRIO_INFO,session->base.log_obj,"Remove MRCP Handle "APT_NAMESID_FMT,
 			session->base.name,
 			MRCP_SESSION_SID(&session->base));
+		apr_thread_mutex_lock(client->session_mutex);
 		apr_hash_set(client->session_table,session,sizeof(void*),NULL);
+		apr_thread_mutex_unlock(client->session_mutex);
 	}
 }
 
@@ -813,6 +840,45 @@ static apt_bool_t mrcp_client_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 	return TRUE;
 }
 
+/** Get the session the message belongs to, so that messages of a session are always processed by the same worker */
+static apr_size_t mrcp_client_msg_affinity_get(apt_consumer_task_t *task, const apt_task_msg_t *msg)
+{
+	void *session = NULL;
+	switch(msg->type) {
+		case MRCP_CLIENT_SIGNALING_TASK_MSG:
+		{
+			const sig_agent_task_msg_data_t *data = (const sig_agent_task_msg_data_t*)msg->data;
+			session = data->session;
+			break;
+		}
+		case MRCP_CLIENT_CONNECTION_TASK_MSG:
+		{
+			const connection_agent_task_msg_data_t *data = (const connection_agent_task_msg_data_t*)msg->data;
+			if(data->channel) {
+				session = data->channel->session;
+			}
+			break;
+		}
+		case MRCP_CLIENT_MEDIA_TASK_MSG:
+		{
+			const mpf_message_container_t *container = (const mpf_message_container_t*) msg->data;
+			if(container->count && container->messages[0].context) {
+				session = mpf_engine_context_object_get(container->messages[0].context);
+			}
+			break;
+		}
+		case MRCP_CLIENT_APPLICATION_TASK_MSG:
+		{
+			mrcp_app_message_t *const *app_message = (mrcp_app_message_t *const *) msg->data;
+			session = (*app_message)->session;
+			break;
+		}
+		default:
+			break;
+	}
+	return (apr_size_t)session;
+}
+
 apt_bool_t mrcp_app_signaling_task_msg_signal(mrcp_sig_command_e command_id, mrcp_session_t *session, mrcp_channel_t *channel)
 {
 	mrcp_client_session_t *client_session = (mrcp_client_session_t*)session;
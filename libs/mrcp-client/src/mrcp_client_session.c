@@ -396,7 +396,7 @@ apt_bool_t mrcp_client_app_message_process(mrcp_app_message_t *app_message)
 	if(session->active_request) {
 		apt_obj_log(APT_LOG_MARK,APT_PRIO_DEBUG,session->base.log_obj,"Push Request to Queue "APT_NAMESID_FMT, 
 			MRCP_SESSION_NAMESID(session));
-		apt_list_push_back(session->request_queue,app_message,session->base.pool);
+		apt_list_push_back(session->request_queue,app_message,NULL);
 		return TRUE;
 	}
 
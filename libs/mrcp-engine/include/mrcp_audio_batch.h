@@ -0,0 +1,73 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#ifndef MRCP_AUDIO_BATCH_H
+#define MRCP_AUDIO_BATCH_H
+
+/**
+ * @file mrcp_audio_batch.h
+ * @brief Batched Audio Delivery of Channels to Engine
+ */
+
+#include "mrcp_engine_types.h"
+
+APT_BEGIN_EXTERN_C
+
+/**
+ * Create audio batch of engine.
+ * @param engine the engine to deliver the audio of its channels to
+ *               (see process_batch of mrcp_engine_method_vtable_t)
+ * @param executor the executor to gather the audio by
+ * @remark The audio pipes of open channels are drained by a single job, once the pipe
+ *         of any channel is notified, so that the engine gets all the queued audio
+ *         in one call from the context of the executor.
+ */
+MRCP_DECLARE(mrcp_audio_batch_t*) mrcp_audio_batch_create(mrcp_engine_t *engine, apt_executor_t *executor);
+
+/**
+ * Destroy audio batch, wait for the pending job.
+ * @param batch the batch to destroy
+ */
+MRCP_DECLARE(void) mrcp_audio_batch_destroy(mrcp_audio_batch_t *batch);
+
+/**
+ * Add channel (and its audio pipe) to the batch.
+ * @param batch the batch to add to
+ * @param channel the channel to add, the pipe of which is created by
+ *                mrcp_engine_channel_audio_pipe_create()
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_audio_batch_channel_add(mrcp_audio_batch_t *batch, mrcp_engine_channel_t *channel);
+
+/**
+ * Remove channel from the batch, wait for the running job.
+ * @param batch the batch to remove from
+ * @param channel the channel to remove
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_audio_batch_channel_remove(mrcp_audio_batch_t *batch, mrcp_engine_channel_t *channel);
+
+/**
+ * Notification handler of audio pipes of the channels in the batch.
+ * @param pipe the notified pipe
+ * @param obj the batch
+ */
+MRCP_DECLARE(void) mrcp_audio_batch_notify(mrcp_audio_pipe_t *pipe, void *obj);
+
+APT_END_EXTERN_C
+
+#endif /* MRCP_AUDIO_BATCH_H */
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#ifndef MRCP_AUDIO_PIPE_H
+#define MRCP_AUDIO_PIPE_H
+
+/**
+ * @file mrcp_audio_pipe.h
+ * @brief Audio Pipe from Media Processing to Engine Threads
+ */
+
+#include "mrcp_types.h"
+#include "mpf_frame.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Opaque audio pipe declaration */
+typedef struct mrcp_audio_pipe_t mrcp_audio_pipe_t;
+
+/**
+ * Prototype of handler to notify the consumer by, once a batch of frames is available.
+ * @remark Called from the context of media processing, so the handler must not block
+ *         (e.g. submit a job to the executor or signal a condition variable of own thread).
+ */
+typedef void (*mrcp_audio_pipe_notify_f)(mrcp_audio_pipe_t *pipe, void *obj);
+
+/**
+ * Create audio pipe.
+ * @param frame_size the max size of a frame in bytes (e.g. of 16 kHz linear PCM)
+ * @param capacity the duration of audio the pipe holds in msec
+ * @param batch the duration of audio to notify the consumer at in msec
+ * @param notify the handler to notify the consumer by (NULL to poll)
+ * @param obj the external object to pass to the handler
+ * @param pool the pool to allocate memory from
+ * @remark Frames are copied by a single producer (the write method of the sink stream
+ *         of the channel) to a lock-free ring and pulled in batches by a single consumer
+ *         (the thread of the engine), so that media processing never waits for the engine.
+ *         Should be created along with the channel, not from the context of media processing.
+ */
+MRCP_DECLARE(mrcp_audio_pipe_t*) mrcp_audio_pipe_create(
+									apr_size_t frame_size,
+									apr_size_t capacity,
+									apr_size_t batch,
+									mrcp_audio_pipe_notify_f notify,
+									void *obj,
+									apr_pool_t *pool);
+
+/**
+ * Write frame to the pipe (producer).
+ * @param pipe the pipe to write to
+ * @param frame the frame to write, frames with no audio are written as silence
+ * @return FALSE if the pipe is full (the frame is dropped then)
+ * @remark Never blocks, the time taken does not depend on the number of queued frames.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_audio_pipe_write(mrcp_audio_pipe_t *pipe, const mpf_frame_t *frame);
+
+/**
+ * Notify the consumer of the frames written, even if less than a batch (producer).
+ * @param pipe the pipe to flush
+ * @remark Intended to be called at the end of input (e.g. once the end of speech is detected).
+ */
+MRCP_DECLARE(void) mrcp_audio_pipe_flush(mrcp_audio_pipe_t *pipe);
+
+/**
+ * Read frames from the pipe in one batch (consumer).
+ * @param pipe the pipe to read from
+ * @param buffer the buffer to copy the audio of frames to
+ * @param size the size of the buffer, only whole frames are copied
+ * @return the size of the copied audio in bytes
+ * @remark Re-arms the notification, the consumer is notified again,
+ *         once the next batch is written.
+ */
+MRCP_DECLARE(apr_size_t) mrcp_audio_pipe_read(mrcp_audio_pipe_t *pipe, void *buffer, apr_size_t size);
+
+/**
+ * Discard all the written frames (consumer).
+ * @param pipe the pipe to discard the frames of
+ * @remark Intended to be called, once a new request (e.g. RECOGNIZE) is started.
+ */
+MRCP_DECLARE(void) mrcp_audio_pipe_discard(mrcp_audio_pipe_t *pipe);
+
+/**
+ * Get the number of frames available to read.
+ * @param pipe the pipe to query
+ */
+MRCP_DECLARE(apr_size_t) mrcp_audio_pipe_count_get(const mrcp_audio_pipe_t *pipe);
+
+/**
+ * Get the size of audio the pipe holds in bytes.
+ * @param pipe the pipe to query
+ */
+MRCP_DECLARE(apr_size_t) mrcp_audio_pipe_size_get(const mrcp_audio_pipe_t *pipe);
+
+/**
+ * Get and reset the number of frames dropped, as the pipe was full.
+ * @param pipe the pipe to query
+ */
+MRCP_DECLARE(apr_size_t) mrcp_audio_pipe_dropped_get(mrcp_audio_pipe_t *pipe);
+
+APT_END_EXTERN_C
+
+#endif /* MRCP_AUDIO_PIPE_H */
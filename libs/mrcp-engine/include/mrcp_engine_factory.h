@@ -47,6 +47,9 @@ MRCP_DECLARE(apt_bool_t) mrcp_engine_factory_close(mrcp_engine_factory_t *factor
 /** Register engine */
 MRCP_DECLARE(apt_bool_t) mrcp_engine_factory_engine_register(mrcp_engine_factory_t *factory, mrcp_engine_t *engine);
 
+/** Unregister engine, the engine is not destroyed */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_factory_engine_unregister(mrcp_engine_factory_t *factory, mrcp_engine_t *engine);
+
 /** Get engine by name */
 MRCP_DECLARE(mrcp_engine_t*) mrcp_engine_factory_engine_get(const mrcp_engine_factory_t *factory, const char *name);
 
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#ifndef MRCP_ENGINE_HOST_H
+#define MRCP_ENGINE_HOST_H
+
+/**
+ * @file mrcp_engine_host.h
+ * @brief Hosting of MRCP Engine in Worker Process
+ *
+ * The engine runs in a process forked off the server, so that a crash or
+ * the memory of the plugin does not affect the server. The server uses a proxy
+ * engine, which passes requests, events and audio frames through rings in
+ * shared memory (see apt_shm_ring.h), signalled only if the other side sleeps.
+ */ 
+
+#include "mrcp_engine_types.h"
+#include "apt_dir_layout.h"
+
+APT_BEGIN_EXTERN_C
+
+/**
+ * Create engine in the worker process (e.g. load the plugin).
+ * @param obj the external object passed to mrcp_engine_host_create()
+ * @param pool the pool of the worker process to create the engine from
+ */
+typedef mrcp_engine_t* (*mrcp_engine_host_creator_f)(void *obj, apr_pool_t *pool);
+
+/**
+ * Create proxy of engine hosted in a worker process.
+ * @param id the identifier of the engine
+ * @param config the config of the engine
+ * @param resource_factory the factory messages are passed between the processes by
+ * @param dir_layout the dir layout of the hosted engine
+ * @param creator the handler to create the engine in the worker process by
+ * @param obj the external object to pass to the creator
+ * @param pool the pool to allocate memory from, the worker is stopped on its cleanup
+ * @return the proxy engine (with id and config assigned) or NULL on failure
+ * @remark The worker is forked right away, so the objects passed are valid in it,
+ *         as long as they are created before. The hosted engine has no executor,
+ *         audio of non-linear codecs is passed with no codec. Available, where
+ *         fork is (APR_HAS_FORK).
+ */
+MRCP_DECLARE(mrcp_engine_t*) mrcp_engine_host_create(
+								const char *id,
+								mrcp_engine_config_t *config,
+								const mrcp_resource_factory_t *resource_factory,
+								const apt_dir_layout_t *dir_layout,
+								mrcp_engine_host_creator_f creator,
+								void *obj,
+								apr_pool_t *pool);
+
+APT_END_EXTERN_C
+
+#endif /* MRCP_ENGINE_HOST_H */
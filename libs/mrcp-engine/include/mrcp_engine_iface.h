@@ -24,7 +24,10 @@
  * @brief MRCP Engine User Interface (typically user is an MRCP server)
  */ 
 
+#include <apr_atomic.h>
 #include "mrcp_engine_types.h"
+#include "mrcp_audio_batch.h"
+#include "mrcp_request_batch.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -43,6 +46,46 @@ apt_bool_t mrcp_engine_virtual_close(mrcp_engine_t *engine);
 /** Response to close engine request */
 void mrcp_engine_on_close(mrcp_engine_t *engine);
 
+/**
+ * Prepare engine to be opened in background (MRCP_ENGINE_OPEN_LAZY, MRCP_ENGINE_OPEN_PARALLEL).
+ * @param engine the engine to prepare
+ * @remark Called by the host before the engine is used by several threads.
+ */
+apt_bool_t mrcp_engine_background_open_init(mrcp_engine_t *engine);
+
+/**
+ * Open engine in background by a thread of its own.
+ * @param engine the engine to open
+ * @return TRUE if the open is started, in progress or done already
+ * @remark The response is processed by mrcp_engine_background_open_respond(),
+ *         called by the host on on_open of mrcp_engine_event_vtable_t.
+ */
+apt_bool_t mrcp_engine_background_open(mrcp_engine_t *engine);
+
+/**
+ * Process response to open in background.
+ * @param engine the engine responded
+ * @param status the status of the open
+ * @return FALSE if the engine is not being opened in background, but by the host task
+ */
+apt_bool_t mrcp_engine_background_open_respond(mrcp_engine_t *engine, apt_bool_t status);
+
+/**
+ * Wait for open in background to complete.
+ * @param engine the engine to wait for
+ * @param timeout the max time to wait (usec, negative - no limit)
+ * @return TRUE if the engine is open
+ */
+apt_bool_t mrcp_engine_background_open_wait(mrcp_engine_t *engine, apr_interval_time_t timeout);
+
+/**
+ * Deliver the requests batched so far to the engine in one call.
+ * @param engine the engine to deliver the requests to
+ * @remark Called by the host on on_requests of mrcp_engine_event_vtable_t,
+ *         once the messages pending at its wakeup are processed.
+ */
+apt_bool_t mrcp_engine_requests_flush(mrcp_engine_t *engine);
+
 
 /** Create engine channel */
 mrcp_engine_channel_t* mrcp_engine_channel_virtual_create(mrcp_engine_t *engine, mrcp_version_e mrcp_version, apr_pool_t *pool);
@@ -55,6 +98,9 @@ static APR_INLINE apt_bool_t mrcp_engine_channel_virtual_open(mrcp_engine_channe
 {
 	if(channel->is_open == FALSE) {
 		channel->is_open = channel->method_vtable->open(channel);
+		if(channel->is_open == TRUE && channel->audio_pipe && channel->engine->audio_batch) {
+			mrcp_audio_batch_channel_add(channel->engine->audio_batch,channel);
+		}
 		return channel->is_open;
 	}
 	return FALSE;
@@ -65,17 +111,123 @@ static APR_INLINE apt_bool_t mrcp_engine_channel_virtual_close(mrcp_engine_chann
 {
 	if(channel->is_open == TRUE) {
 		channel->is_open = FALSE;
+		if(channel->audio_pipe && channel->engine->audio_batch) {
+			mrcp_audio_batch_channel_remove(channel->engine->audio_batch,channel);
+		}
+		if(channel->engine->request_batch) {
+			/* the requests of the channel are delivered ahead of close */
+			mrcp_request_batch_flush(channel->engine->request_batch);
+		}
 		return channel->method_vtable->close(channel);
 	}
 	return FALSE;
 }
 
-/** Process request */
+/**
+ * Record time spent inside a plugin callback.
+ * @param engine the engine the callback belongs to
+ * @param callback the kind of callback
+ * @param elapsed the time spent inside the callback (usec)
+ * @remark Slow callbacks are warned about at most once a second per engine,
+ *         the engine is suspended for new sessions on the limit of slow callbacks.
+ */
+void mrcp_engine_callback_time_record(mrcp_engine_t *engine, mrcp_engine_callback_e callback, apr_uint32_t elapsed);
+
+/** Get statistics of time spent inside plugin callbacks of a kind */
+apt_bool_t mrcp_engine_callback_stat_get(const mrcp_engine_t *engine, mrcp_engine_callback_e callback, mrcp_engine_callback_stat_t *stat);
+
+/** Get the name of a kind of plugin callbacks */
+const char* mrcp_engine_callback_name_get(mrcp_engine_callback_e callback);
+
+/** Check whether engine is suspended for new sessions due to slow callbacks */
+static APR_INLINE apt_bool_t mrcp_engine_is_suspended(const mrcp_engine_t *engine)
+{
+	return apr_atomic_read32((volatile apr_uint32_t*)&engine->suspended) ? TRUE : FALSE;
+}
+
+/** Process request, or add it to the request batch of the engine */
 static APR_INLINE apt_bool_t mrcp_engine_channel_request_process(mrcp_engine_channel_t *channel, mrcp_message_t *message)
 {
-	return channel->method_vtable->process_request(channel,message);
+	apr_time_t start_time;
+	apt_bool_t status;
+	mrcp_engine_t *engine = channel->engine;
+	if(engine->request_batch) {
+		if(mrcp_request_batch_add(engine->request_batch,channel,message) == TRUE) {
+			/* the first request since the last flush */
+			engine->event_vtable->on_requests(engine);
+		}
+		return TRUE;
+	}
+	start_time = apr_time_now();
+	status = channel->method_vtable->process_request(channel,message);
+	mrcp_engine_callback_time_record(channel->engine,MRCP_ENGINE_CALLBACK_REQUEST,(apr_uint32_t)(apr_time_now() - start_time));
+	return status;
 }
 
+/** Hint queued request to prefetch (or withdraw the hint), if the channel opts in */
+static APR_INLINE apt_bool_t mrcp_engine_channel_prefetch(mrcp_engine_channel_t *channel, mrcp_message_t *message, apt_bool_t start)
+{
+	apr_time_t start_time;
+	apt_bool_t status;
+	if(!channel->method_vtable->prefetch) {
+		return FALSE;
+	}
+	if(channel->engine->request_batch) {
+		/* the request in progress is delivered ahead of the hint */
+		mrcp_request_batch_flush(channel->engine->request_batch);
+	}
+	start_time = apr_time_now();
+	status = channel->method_vtable->prefetch(channel,message,start);
+	mrcp_engine_callback_time_record(channel->engine,MRCP_ENGINE_CALLBACK_REQUEST,(apr_uint32_t)(apr_time_now() - start_time));
+	return status;
+}
+
+/**
+ * Link engine channels of a session to kill the audio of one on barge-in of another.
+ * @param channel the recognizer channel, START-OF-INPUT of which is barge-in
+ * @param target the channel to mute the source stream of (NULL to unlink)
+ */
+void mrcp_engine_channel_barge_in_link(mrcp_engine_channel_t *channel, mrcp_engine_channel_t *target);
+
+/**
+ * Arm or disarm the source stream of channel to be muted on barge-in.
+ * @param channel the channel to arm or disarm
+ * @param armed whether the audio in progress is killed on barge-in
+ * @remark Both arming and disarming unmute the stream, as any of them starts
+ *         or ends the audio a barge-in is detected against.
+ */
+void mrcp_engine_channel_barge_in_arm(mrcp_engine_channel_t *channel, apt_bool_t armed);
+
+/**
+ * Mute the linked channel right away, if the message is START-OF-INPUT.
+ * @param channel the channel the message is sent by
+ * @param message the event message of the engine
+ * @return TRUE if the linked channel is muted
+ * @remark Called in the context the engine sends the message in (usually media
+ *         processing), so that the barge-in takes effect on the next tick rather
+ *         than once the client reacts with BARGE-IN-OCCURRED.
+ */
+apt_bool_t mrcp_engine_channel_barge_in_process(mrcp_engine_channel_t *channel, const mrcp_message_t *message);
+
+/**
+ * Prefetch the voiceprint models of the request in background, if the request is START-SESSION.
+ * @param engine the engine to prefetch the models of
+ * @param request the request to process
+ * @remark Called by the server ahead of passing the request to the engine,
+ *         so that VERIFY does not wait for the models to load.
+ */
+apt_bool_t mrcp_engine_voiceprint_request_prefetch(mrcp_engine_t *engine, const mrcp_message_t *request);
+
+/**
+ * Prefetch the http:// URIs the request references in background, if the request is
+ * DEFINE-GRAMMAR or RECOGNIZE with a URI list, or SPEAK with a URI list or audio elements.
+ * @param engine the engine to prefetch the documents for
+ * @param request the request to process
+ * @remark Called by the server ahead of passing the request to the engine,
+ *         so that the fetch of the grammars and prompts is off the critical path.
+ */
+apt_bool_t mrcp_engine_uri_request_prefetch(mrcp_engine_t *engine, const mrcp_message_t *request);
+
 /** Allocate engine config */
 mrcp_engine_config_t* mrcp_engine_config_alloc(apr_pool_t *pool);
 
@@ -25,6 +25,7 @@
  */ 
 
 #include "mrcp_engine_types.h"
+#include "mrcp_generic_header.h"
 #include "mpf_stream.h"
 
 APT_BEGIN_EXTERN_C
@@ -55,6 +56,19 @@ const mrcp_engine_config_t* mrcp_engine_config_get(const mrcp_engine_t *engine);
 /** Get engine param by name */
 const char* mrcp_engine_param_get(const mrcp_engine_t *engine, const char *name);
 
+/**
+ * Declare resource specific header field the engine takes from RECOGNIZE, SPEAK, RECORD only.
+ * @param engine the engine to declare the header field for
+ * @param id the identifier of the resource header field (e.g. RECOGNIZER_HEADER_NO_INPUT_TIMEOUT)
+ * @remark SET-PARAMS and GET-PARAMS of declared header fields only are processed by
+ *         the server inline and never reach the engine. The values set are inherited
+ *         by the next requests. Should be called before the engine is registered.
+ */
+apt_bool_t mrcp_engine_param_declare(mrcp_engine_t *engine, apr_size_t id);
+
+/** Declare generic header field the engine takes from RECOGNIZE, SPEAK, RECORD only */
+apt_bool_t mrcp_engine_generic_param_declare(mrcp_engine_t *engine, mrcp_generic_header_id id);
+
 
 /** Create engine channel */
 mrcp_engine_channel_t* mrcp_engine_channel_create(
@@ -64,6 +78,26 @@ mrcp_engine_channel_t* mrcp_engine_channel_create(
 					mpf_termination_t *termination,
 					apr_pool_t *pool);
 
+/**
+ * Create audio pipe to pass audio from the sink stream of channel to the engine by.
+ * @param channel the channel to create the pipe for
+ * @param frame_size the max size of a frame in bytes
+ * @param capacity the duration of audio the pipe holds in msec
+ * @param batch the duration of audio to notify the consumer at in msec
+ * @param notify the handler to notify the consumer by
+ * @param obj the external object to pass to the handler
+ * @remark The sink stream writes frames by mrcp_audio_pipe_write(). If the engine
+ *         implements process_batch, the handler is not used, the audio of all the
+ *         open channels is delivered by process_batch instead.
+ */
+mrcp_audio_pipe_t* mrcp_engine_channel_audio_pipe_create(
+						mrcp_engine_channel_t *channel,
+						apr_size_t frame_size,
+						apr_size_t capacity,
+						apr_size_t batch,
+						mrcp_audio_pipe_notify_f notify,
+						void *obj);
+
 /** Create audio termination */
 mpf_termination_t* mrcp_engine_audio_termination_create(
 								void *obj,
@@ -111,6 +145,29 @@ static APR_INLINE apt_bool_t mrcp_engine_channel_message_send(mrcp_engine_channe
 	return channel->event_vtable->on_message(channel,message);
 }
 
+/**
+ * Send several response/event messages of the channel at once.
+ * @param channel the engine channel
+ * @param messages the messages to send in order
+ * @param count the number of messages
+ * @remark The messages are signalled to the server as one task message, if supported,
+ *         and sent one by one by mrcp_engine_channel_message_send() otherwise.
+ */
+static APR_INLINE apt_bool_t mrcp_engine_channel_messages_send(mrcp_engine_channel_t *channel, mrcp_message_t *const *messages, apr_size_t count)
+{
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+	if(channel->event_vtable->on_messages) {
+		return channel->event_vtable->on_messages(channel,messages,count);
+	}
+	for(i=0; i<count; i++) {
+		if(channel->event_vtable->on_message(channel,messages[i]) == FALSE) {
+			status = FALSE;
+		}
+	}
+	return status;
+}
+
 /** Get channel identifier */
 static APR_INLINE const char* mrcp_engine_channel_id_get(mrcp_engine_channel_t *channel)
 {
@@ -129,6 +186,107 @@ const mpf_codec_descriptor_t* mrcp_engine_source_stream_codec_get(const mrcp_eng
 /** Get codec descriptor of the audio sink stream */
 const mpf_codec_descriptor_t* mrcp_engine_sink_stream_codec_get(const mrcp_engine_channel_t *channel);
 
+/**
+ * Report whether the audio sink stream consumes frames.
+ * @param channel the engine channel
+ * @param active FALSE while no request needs audio (e.g. between RECOGNIZE requests),
+ *               so that received audio is not decoded for the channel
+ * @remark With engine param "preroll" (msec), the latest audio is kept instead, while inactive,
+ *         and written to the stream ahead of the live frames, once active, so that the start
+ *         of speech preceding the request is not lost. Set the state, the frames are consumed
+ *         by, before activating.
+ * @see mpf_audio_stream_tx_active_set()
+ */
+void mrcp_engine_sink_stream_active_set(mrcp_engine_channel_t *channel, apt_bool_t active);
+
+/**
+ * Look up grammar compiled by any channel of the engine.
+ * @param engine the engine to look up the grammar of
+ * @param content_type the content type of the grammar
+ * @param content the grammar body
+ * @return the referenced entry to release, once the grammar is no longer used, or NULL
+ */
+mrcp_grammar_entry_t* mrcp_engine_grammar_lookup(mrcp_engine_t *engine, const apt_str_t *content_type, const apt_str_t *content);
+
+/**
+ * Share compiled grammar with other channels of the engine.
+ * @param engine the engine to share the grammar in
+ * @param content_type the content type of the grammar
+ * @param content the grammar body
+ * @param grammar the compiled grammar to pass the ownership of
+ * @param destroy the handler to destroy the grammar by
+ * @return the referenced entry to release, or NULL if the cache is disabled,
+ *         the grammar is then still owned by the caller
+ */
+mrcp_grammar_entry_t* mrcp_engine_grammar_insert(
+						mrcp_engine_t *engine,
+						const apt_str_t *content_type,
+						const apt_str_t *content,
+						void *grammar,
+						mrcp_grammar_destroy_f destroy);
+
+/** Release grammar entry got by lookup or insert */
+void mrcp_engine_grammar_release(mrcp_engine_t *engine, mrcp_grammar_entry_t *entry);
+
+/**
+ * Look up prompt synthesized by any channel of the engine.
+ * @param engine the engine to look up the prompt of
+ * @param key the key generated by mrcp_prompt_key_generate()
+ * @return the referenced entry to release, once the prompt is streamed, or NULL
+ */
+mrcp_prompt_entry_t* mrcp_engine_prompt_lookup(mrcp_engine_t *engine, const apt_str_t *key);
+
+/**
+ * Create writer to record the prompt being synthesized by.
+ * @param engine the engine to share the prompt in
+ * @param key the key generated by mrcp_prompt_key_generate()
+ * @return the writer to commit or abort, or NULL if the cache is disabled
+ */
+mrcp_prompt_writer_t* mrcp_engine_prompt_writer_create(mrcp_engine_t *engine, const apt_str_t *key);
+
+/** Release prompt entry got by lookup */
+void mrcp_engine_prompt_release(mrcp_engine_t *engine, mrcp_prompt_entry_t *entry);
+
+/**
+ * Set loader of voiceprint models to share the models among channels of the engine by.
+ * @param engine the verifier engine to set the loader of
+ * @param loader the loader (must outlive the engine)
+ * @remark Should be called before the engine is opened. The models of the voiceprints
+ *         of START-SESSION are then prefetched by the server in background.
+ */
+apt_bool_t mrcp_engine_voiceprint_loader_set(mrcp_engine_t *engine, const mrcp_voiceprint_loader_t *loader);
+
+/**
+ * Get voiceprint model loaded by any channel of the engine or prefetched.
+ * @param engine the engine to get the model of
+ * @param repository_uri the URI of the repository
+ * @param voiceprint_id the identifier of the voiceprint
+ * @return the referenced entry to release, once the model is no longer used,
+ *         or NULL if the cache is disabled or the model failed to load
+ * @remark Blocks, while the model is loaded, so it is to be called from a job of the engine.
+ */
+mrcp_voiceprint_entry_t* mrcp_engine_voiceprint_get(mrcp_engine_t *engine, const apt_str_t *repository_uri, const apt_str_t *voiceprint_id);
+
+/** Release voiceprint entry got by get */
+void mrcp_engine_voiceprint_release(mrcp_engine_t *engine, mrcp_voiceprint_entry_t *entry);
+
+/** Invalidate voiceprint model of the engine (e.g. on DELETE-VOICEPRINT or enrollment) */
+void mrcp_engine_voiceprint_invalidate(mrcp_engine_t *engine, const apt_str_t *repository_uri, const apt_str_t *voiceprint_id);
+
+/**
+ * Get document referenced by URI (e.g. http:// grammar or audio prompt),
+ * fetched by any channel of any engine or prefetched.
+ * @param engine the engine to get the document for
+ * @param uri the http:// URI of the document
+ * @return the referenced entry to release, once the document is no longer used,
+ *         or NULL if the cache is disabled or the document failed to fetch
+ * @remark Blocks, while the document is fetched, so it is to be called from a job of the engine.
+ */
+mrcp_fetch_entry_t* mrcp_engine_uri_fetch(mrcp_engine_t *engine, const apt_str_t *uri);
+
+/** Release document entry got by fetch */
+void mrcp_engine_uri_release(mrcp_engine_t *engine, mrcp_fetch_entry_t *entry);
+
 
 APT_END_EXTERN_C
 
@@ -25,6 +25,7 @@
  */ 
 
 #include "mrcp_engine_iface.h"
+#include "apt_dir_layout.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -37,6 +38,21 @@ MRCP_DECLARE(mrcp_engine_loader_t*) mrcp_engine_loader_create(apr_pool_t *pool);
 /** Destroy engine loader */
 MRCP_DECLARE(apt_bool_t) mrcp_engine_loader_destroy(mrcp_engine_loader_t *loader);
 
+/**
+ * Set resource factory, engines hosted in worker processes (param "host" of
+ * the engine set to "process") exchange messages by.
+ * @param loader the loader to set the factory of
+ * @param resource_factory the factory to set
+ */
+MRCP_DECLARE(void) mrcp_engine_loader_resource_factory_set(mrcp_engine_loader_t *loader, const mrcp_resource_factory_t *resource_factory);
+
+/**
+ * Set directory layout passed to engines hosted in worker processes.
+ * @param loader the loader to set the layout of
+ * @param dir_layout the layout to set
+ */
+MRCP_DECLARE(void) mrcp_engine_loader_dir_layout_set(mrcp_engine_loader_t *loader, const apt_dir_layout_t *dir_layout);
+
 /** Unload loaded plugins */
 MRCP_DECLARE(apt_bool_t) mrcp_engine_loader_plugins_unload(mrcp_engine_loader_t *loader);
 
@@ -48,6 +64,17 @@ MRCP_DECLARE(mrcp_engine_t*) mrcp_engine_loader_plugin_load(
 								const char *path,
 								mrcp_engine_config_t *config);
 
+/**
+ * Unload the plugin engine is created by.
+ * @param loader the loader to use
+ * @param engine the destroyed engine to unload the plugin of
+ * @remark The memory of the engine is released along with the plugin.
+ *         The same plugin loaded for another engine stays in memory,
+ *         as the dynamic linker keeps a plugin, until it is unloaded as many
+ *         times as loaded.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_loader_plugin_unload(mrcp_engine_loader_t *loader, mrcp_engine_t *engine);
+
 
 APT_END_EXTERN_C
 
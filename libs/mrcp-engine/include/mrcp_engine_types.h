@@ -25,9 +25,18 @@
  */ 
 
 #include <apr_tables.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
 #include "mrcp_state_machine.h"
 #include "mpf_types.h"
+#include "mpf_frame_buffer.h"
 #include "apt_string.h"
+#include "apt_executor.h"
+#include "mrcp_grammar_cache.h"
+#include "mrcp_prompt_cache.h"
+#include "mrcp_voiceprint_cache.h"
+#include "mrcp_fetch_cache.h"
+#include "mrcp_audio_pipe.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -45,6 +54,14 @@ typedef struct mrcp_engine_channel_t mrcp_engine_channel_t;
 typedef struct mrcp_engine_channel_method_vtable_t mrcp_engine_channel_method_vtable_t;
 /** MRCP engine channel virtual event table declaration */
 typedef struct mrcp_engine_channel_event_vtable_t mrcp_engine_channel_event_vtable_t;
+/** Audio batch of engine declaration */
+typedef struct mrcp_audio_batch_t mrcp_audio_batch_t;
+/** Item of audio batch declaration */
+typedef struct mrcp_audio_batch_item_t mrcp_audio_batch_item_t;
+/** Request batch of engine declaration */
+typedef struct mrcp_request_batch_t mrcp_request_batch_t;
+/** Item of request batch declaration */
+typedef struct mrcp_request_batch_item_t mrcp_request_batch_item_t;
 
 /** Table of channel virtual methods */
 struct mrcp_engine_channel_method_vtable_t {
@@ -56,6 +73,13 @@ struct mrcp_engine_channel_method_vtable_t {
 	apt_bool_t (*close)(mrcp_engine_channel_t *channel);
 	/** Virtual process_request */
 	apt_bool_t (*process_request)(mrcp_engine_channel_t *channel, mrcp_message_t *request);
+	/** Virtual reset (optional), restores a closed channel to the state just after create,
+	    so that the channel can be kept in the idle list of engine and reused by another session */
+	apt_bool_t (*reset)(mrcp_engine_channel_t *channel);
+	/** Virtual prefetch (optional), hints about a SPEAK request queued behind the one in progress
+	    (start is TRUE), so that it can be rendered ahead, or about the hint being withdrawn, once
+	    the request is removed from the queue (start is FALSE); no response is sent to hints */
+	apt_bool_t (*prefetch)(mrcp_engine_channel_t *channel, mrcp_message_t *request, apt_bool_t start);
 };
 
 /** Table of channel virtual event handlers */
@@ -66,6 +90,8 @@ struct mrcp_engine_channel_event_vtable_t {
 	apt_bool_t (*on_close)(mrcp_engine_channel_t *channel);
 	/** Message event handler */
 	apt_bool_t (*on_message)(mrcp_engine_channel_t *channel, mrcp_message_t *message);
+	/** Messages event handler (optional), several responses/events of the channel signalled at once */
+	apt_bool_t (*on_messages)(mrcp_engine_channel_t *channel, mrcp_message_t *const *messages, apr_size_t count);
 };
 
 /** MRCP engine channel declaration */
@@ -90,6 +116,38 @@ struct mrcp_engine_channel_t {
 	apt_bool_t                                is_open;
 	/** Pool to allocate memory from */
 	apr_pool_t                                *pool;
+	/** Own pool of reusable channel, which outlives sessions (NULL if allocated from session pool) */
+	apr_pool_t                                *recycle_pool;
+	/** Audio pipe from the sink stream to the engine (NULL if not used) */
+	mrcp_audio_pipe_t                         *audio_pipe;
+	/** Channel of the same session, the source stream of which is muted on START-OF-INPUT of this one (NULL if none) */
+	mrcp_engine_channel_t                     *barge_in_channel;
+	/** Barge-in state of the source stream of this channel (see mrcp_engine_channel_barge_in_arm()) */
+	volatile apr_uint32_t                      barge_in_state;
+	/** Duration of audio of the sink stream kept while the engine is not consuming it (msec, 0 if disabled) */
+	apr_size_t                                 preroll_time;
+	/** Ring of the latest audio of the sink stream (NULL until the stream is open or if disabled) */
+	mpf_frame_buffer_t                        *preroll;
+	/** Non-zero while the engine consumes the sink stream (see mrcp_engine_sink_stream_active_set()) */
+	volatile apr_uint32_t                      preroll_consuming;
+};
+
+/** Audio of a channel delivered to the engine in a batch */
+struct mrcp_audio_batch_item_t {
+	/** Channel the audio is of */
+	mrcp_engine_channel_t *channel;
+	/** Audio read from the pipe of the channel, valid during the call only */
+	const char            *data;
+	/** Size of the audio in bytes */
+	apr_size_t             size;
+};
+
+/** Request of a channel delivered to the engine in a batch */
+struct mrcp_request_batch_item_t {
+	/** Channel the request is of */
+	mrcp_engine_channel_t *channel;
+	/** Request to process */
+	mrcp_message_t        *request;
 };
 
 /** Table of MRCP engine virtual methods */
@@ -102,6 +160,53 @@ struct mrcp_engine_method_vtable_t {
 	apt_bool_t (*close)(mrcp_engine_t *engine);
 	/** Virtual channel create */
 	mrcp_engine_channel_t* (*create_channel)(mrcp_engine_t *engine, apr_pool_t *pool);
+	/** Virtual process_batch (optional), delivers the audio of all the open channels at once
+	    from the context of the executor, see mrcp_engine_channel_audio_pipe_create() */
+	apt_bool_t (*process_batch)(mrcp_engine_t *engine, const mrcp_audio_batch_item_t *items, apr_size_t count);
+	/** Virtual process_requests (optional), delivers the requests of all the channels dispatched
+	    within one wakeup of the server task at once instead of process_request of each channel */
+	apt_bool_t (*process_requests)(mrcp_engine_t *engine, const mrcp_request_batch_item_t *items, apr_size_t count);
+};
+
+/** Barge-in states of the source stream of engine channel */
+typedef enum {
+	MRCP_BARGE_IN_STATE_NONE,  /**< not killed on barge-in */
+	MRCP_BARGE_IN_STATE_ARMED, /**< killed on barge-in, a SPEAK with kill-on-barge-in is in progress */
+	MRCP_BARGE_IN_STATE_MUTED  /**< silence is sent out, since START-OF-INPUT is detected */
+} mrcp_barge_in_state_e;
+
+/** Modes of opening engine */
+typedef enum {
+	MRCP_ENGINE_OPEN_STARTUP,  /**< opened on start of the host, which waits for the response (default) */
+	MRCP_ENGINE_OPEN_LAZY,     /**< opened in background on creation of the first channel */
+	MRCP_ENGINE_OPEN_PARALLEL  /**< opened in background on start of the host, which does not wait for it */
+} mrcp_engine_open_mode_e;
+
+/** Number of buckets in the histograms of plugin callback time */
+#define MRCP_ENGINE_CALLBACK_HISTOGRAM_SIZE 12
+
+/** Plugin callbacks timed per engine */
+typedef enum {
+	MRCP_ENGINE_CALLBACK_STREAM,  /**< read/write of audio stream, called within media tick */
+	MRCP_ENGINE_CALLBACK_REQUEST, /**< processing of channel request, called within server task */
+
+	MRCP_ENGINE_CALLBACK_COUNT
+} mrcp_engine_callback_e;
+
+/** Statistics of plugin callback time declaration */
+typedef struct mrcp_engine_callback_stat_t mrcp_engine_callback_stat_t;
+
+/** Statistics of time spent inside plugin callbacks */
+struct mrcp_engine_callback_stat_t {
+	/** Number of timed callbacks */
+	apr_uint32_t count;
+	/** Number of callbacks exceeding the slow callback threshold */
+	apr_uint32_t slow_count;
+	/** Max time (usec) */
+	apr_uint32_t max_time;
+	/** Histogram of time, where the bucket N counts the callbacks
+	returned within (16 << N) usec and the last bucket counts the rest */
+	apr_uint32_t histogram[MRCP_ENGINE_CALLBACK_HISTOGRAM_SIZE];
 };
 
 /** Table of MRCP engine virtual event handlers */
@@ -110,6 +215,9 @@ struct mrcp_engine_event_vtable_t {
 	apt_bool_t (*on_open)(mrcp_engine_t *channel, apt_bool_t status);
 	/** Close event handler */
 	apt_bool_t (*on_close)(mrcp_engine_t *channel);
+	/** Requests event handler (optional), raised once a request is added to the empty
+	    request batch, so that the host flushes the batch by mrcp_engine_requests_flush() */
+	apt_bool_t (*on_requests)(mrcp_engine_t *engine);
 };
 
 /** MRCP engine */
@@ -130,12 +238,50 @@ struct mrcp_engine_t {
 	const mpf_codec_manager_t         *codec_manager;
 	/** Dir layout structure */
 	const apt_dir_layout_t            *dir_layout;
+	/** Executor shared among engines to run jobs by instead of own threads */
+	apt_executor_t                    *executor;
 	/** Config of engine */
 	mrcp_engine_config_t              *config;
-	/** Number of simultaneous channels currently in use */
-	apr_size_t                         cur_channel_count;
+	/** Number of simultaneous channels currently in use (atomic) */
+	volatile apr_uint32_t              cur_channel_count;
+	/** Idle channels ready for reuse (NULL if channels are not reusable) */
+	apr_array_header_t                *idle_channels;
+	/** Mutex to protect idle channels, taken and released by several server workers */
+	apr_thread_mutex_t                *idle_mutex;
+	/** Compiled grammars shared among channels (NULL if disabled) */
+	mrcp_grammar_cache_t              *grammar_cache;
+	/** Synthesized prompts shared among channels (NULL if disabled) */
+	mrcp_prompt_cache_t               *prompt_cache;
+	/** Loaded voiceprint models shared among channels (NULL if disabled) */
+	mrcp_voiceprint_cache_t           *voiceprint_cache;
+	/** Loader of voiceprint models (NULL if the engine loads them on its own) */
+	const mrcp_voiceprint_loader_t    *voiceprint_loader;
+	/** Fetched grammars and audio prompts shared among engines (NULL if disabled) */
+	mrcp_fetch_cache_t                *fetch_cache;
+	/** Audio batch of channels (NULL if process_batch is not implemented) */
+	mrcp_audio_batch_t                *audio_batch;
+	/** Request batch of channels (NULL if process_requests is not implemented) */
+	mrcp_request_batch_t              *request_batch;
+	/** Header fields the server processes SET-PARAMS/GET-PARAMS of inline (flags indexed by id, NULL if none) */
+	apr_array_header_t                *inline_params;
+	/** Time spent inside plugin callbacks (atomic) */
+	mrcp_engine_callback_stat_t        callback_stats[MRCP_ENGINE_CALLBACK_COUNT];
+	/** Time of the last warning about slow callbacks (sec) */
+	volatile apr_uint32_t              slow_report_time;
+	/** Number of slow callbacks at the last warning */
+	volatile apr_uint32_t              slow_report_count;
+	/** Engine is suspended for new sessions, having exceeded the limit of slow callbacks (atomic) */
+	volatile apr_uint32_t              suspended;
 	/** Is engine successfully opened */
 	apt_bool_t                         is_open;
+	/** Guard of open in background (NULL if the engine is opened by the host task only) */
+	apr_thread_mutex_t                *open_mutex;
+	/** Condition open in background is waited for by */
+	apr_thread_cond_t                 *open_cond;
+	/** Open in background is in progress */
+	apt_bool_t                         open_pending;
+	/** Time open in background is started at */
+	apr_time_t                         open_time;
 	/** Pool to allocate memory from */
 	apr_pool_t                        *pool;
 
@@ -147,6 +293,22 @@ struct mrcp_engine_t {
 struct mrcp_engine_config_t {
 	/** Max number of simultaneous channels */
 	apr_size_t   max_channel_count;
+	/** Number of idle channels created at open and kept for reuse by next sessions */
+	apr_size_t   min_idle_channels;
+	/** Max number of compiled grammars kept in the cache (0 disables the cache) */
+	apr_size_t   grammar_cache_size;
+	/** Memory budget of the synthesized prompt cache in bytes (0 disables the cache) */
+	apr_size_t   prompt_cache_size;
+	/** Memory budget of the voiceprint model cache in bytes (0 disables the cache) */
+	apr_size_t   voiceprint_cache_size;
+	/** Time of plugin callbacks to warn at (usec, 0 - no warnings) */
+	apr_uint32_t slow_callback_threshold;
+	/** Number of slow callbacks to suspend the engine for new sessions at (0 - never suspended) */
+	apr_uint32_t slow_callback_limit;
+	/** Set of CPUs the engine should bind its own threads to (NULL if not bound) */
+	const apt_cpu_set_t *cpu_set;
+	/** Mode of opening the engine */
+	mrcp_engine_open_mode_e open_mode;
 	/** Table of name/value string params */
 	apr_table_t *params;
 };
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MRCP_FETCH_CACHE_H
+#define MRCP_FETCH_CACHE_H
+
+/**
+ * @file mrcp_fetch_cache.h
+ * @brief Cache of Fetched URIs (Grammars and Audio Prompts)
+ */
+
+#include "mrcp_types.h"
+#include "apt_string.h"
+#include "apt_executor.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Default memory budget of the cache in bytes */
+#define MRCP_FETCH_CACHE_DEFAULT_SIZE (16 * 1024 * 1024)
+
+/** Opaque fetch cache declaration */
+typedef struct mrcp_fetch_cache_t mrcp_fetch_cache_t;
+
+/** Opaque fetch cache entry declaration */
+typedef struct mrcp_fetch_entry_t mrcp_fetch_entry_t;
+
+/** Fetch cache config declaration */
+typedef struct mrcp_fetch_cache_config_t mrcp_fetch_cache_config_t;
+
+/** Fetch cache config */
+struct mrcp_fetch_cache_config_t {
+	/** Memory budget in bytes, unreferenced documents are evicted in least recently used order beyond it */
+	apr_size_t   max_size;
+	/** Directory to keep fetched documents in across restarts (NULL - memory only) */
+	const char  *dir_path;
+	/** Time documents with neither max-age nor no-cache are considered fresh for (sec) */
+	apr_uint32_t default_max_age;
+	/** Time to connect and to receive the response within (msec) */
+	apr_uint32_t timeout;
+	/** Max number of idle keep-alive connections kept per host */
+	apr_size_t   max_idle_connections;
+};
+
+/** Initialize fetch cache config */
+static APR_INLINE void mrcp_fetch_cache_config_init(mrcp_fetch_cache_config_t *config)
+{
+	config->max_size = MRCP_FETCH_CACHE_DEFAULT_SIZE;
+	config->dir_path = NULL;
+	config->default_max_age = 60;
+	config->timeout = 5000;
+	config->max_idle_connections = 4;
+}
+
+/**
+ * Create fetch cache.
+ * @param config the config of the cache (copied)
+ * @param executor the executor to prefetch documents by (NULL - no prefetch)
+ * @param pool the pool to allocate memory from
+ */
+MRCP_DECLARE(mrcp_fetch_cache_t*) mrcp_fetch_cache_create(
+										const mrcp_fetch_cache_config_t *config,
+										apt_executor_t *executor,
+										apr_pool_t *pool);
+
+/**
+ * Destroy fetch cache, the documents in it and the idle connections.
+ * @param cache the cache to destroy
+ * @remark Waits for the prefetches in progress to complete.
+ */
+MRCP_DECLARE(void) mrcp_fetch_cache_destroy(mrcp_fetch_cache_t *cache);
+
+/**
+ * Fetch document in background, unless it is fresh in the cache or being fetched.
+ * @param cache the cache to fetch the document to
+ * @param uri the http:// URI of the document
+ * @return FALSE if the document is neither cached nor being fetched
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_fetch_cache_prefetch(mrcp_fetch_cache_t *cache, const apt_str_t *uri);
+
+/**
+ * Get document.
+ * @param cache the cache to get the document from
+ * @param uri the http:// URI of the document
+ * @return the referenced entry, which must be released, or NULL if the document failed to fetch
+ * @remark Blocks, while the document is being fetched by another thread or, if not fresh
+ *         in the cache, by the caller, so it is not to be called from the context of the server.
+ *         Concurrent gets and prefetches of the same URI are served by a single fetch.
+ */
+MRCP_DECLARE(mrcp_fetch_entry_t*) mrcp_fetch_cache_get(mrcp_fetch_cache_t *cache, const apt_str_t *uri);
+
+/**
+ * Release entry got by get.
+ * @param cache the cache the entry belongs to
+ * @param entry the entry to release
+ */
+MRCP_DECLARE(void) mrcp_fetch_cache_release(mrcp_fetch_cache_t *cache, mrcp_fetch_entry_t *entry);
+
+/**
+ * Get the content of the entry.
+ * @param entry the entry to get the content of
+ * @param size the size of the content in bytes
+ */
+MRCP_DECLARE(const char*) mrcp_fetch_entry_data_get(const mrcp_fetch_entry_t *entry, apr_size_t *size);
+
+/**
+ * Get the content type of the entry.
+ * @param entry the entry to get the content type of
+ * @return the value of Content-Type of the response (empty string if none)
+ */
+MRCP_DECLARE(const char*) mrcp_fetch_entry_content_type_get(const mrcp_fetch_entry_t *entry);
+
+/**
+ * Get the number of documents in the cache.
+ * @param cache the cache to get the number of documents of
+ */
+MRCP_DECLARE(apr_size_t) mrcp_fetch_cache_count_get(const mrcp_fetch_cache_t *cache);
+
+/**
+ * Get the memory used by the documents in the cache.
+ * @param cache the cache to get the used memory of
+ */
+MRCP_DECLARE(apr_size_t) mrcp_fetch_cache_size_get(const mrcp_fetch_cache_t *cache);
+
+APT_END_EXTERN_C
+
+#endif /* MRCP_FETCH_CACHE_H */
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MRCP_FRAME_CLOCK_H
+#define MRCP_FRAME_CLOCK_H
+
+/**
+ * @file mrcp_frame_clock.h
+ * @brief Frame Clock Timers of Engine Channel
+ */
+
+#include "mrcp_engine_types.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Max number of timers per frame clock */
+#define MRCP_FRAME_CLOCK_TIMER_COUNT 4
+
+/** Opaque frame clock declaration */
+typedef struct mrcp_frame_clock_t mrcp_frame_clock_t;
+
+/**
+ * Frame clock of engine channel.
+ * @remark The clock is advanced by the duration of each processed media frame,
+ *         so the timers (no-input, recognition, etc.) expire inline in
+ *         the context of media processing instead of being scheduled in a timer queue.
+ *         It is embedded in the channel and is not thread-safe.
+ */
+struct mrcp_frame_clock_t {
+	/** Elapsed time (msec) */
+	apr_size_t elapsed;
+	/** The earliest deadline of started timers */
+	apr_size_t next;
+	/** Bit mask of started timers */
+	apr_uint32_t started;
+	/** Deadlines of timers (msec) */
+	apr_size_t deadlines[MRCP_FRAME_CLOCK_TIMER_COUNT];
+};
+
+/**
+ * Reset frame clock, stop all the timers.
+ * @param clock the clock to reset
+ */
+MRCP_DECLARE(void) mrcp_frame_clock_reset(mrcp_frame_clock_t *clock);
+
+/**
+ * Start (restart) timer.
+ * @param clock the clock to start the timer of
+ * @param timer_id the identifier of the timer [0..MRCP_FRAME_CLOCK_TIMER_COUNT)
+ * @param timeout the timeout (msec) relative to the elapsed time
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_frame_clock_timer_start(mrcp_frame_clock_t *clock, apr_size_t timer_id, apr_size_t timeout);
+
+/**
+ * Stop timer.
+ * @param clock the clock to stop the timer of
+ * @param timer_id the identifier of the timer
+ */
+MRCP_DECLARE(void) mrcp_frame_clock_timer_stop(mrcp_frame_clock_t *clock, apr_size_t timer_id);
+
+/**
+ * Check whether timer is started.
+ * @param clock the clock to check the timer of
+ * @param timer_id the identifier of the timer
+ */
+static APR_INLINE apt_bool_t mrcp_frame_clock_timer_is_started(const mrcp_frame_clock_t *clock, apr_size_t timer_id)
+{
+	return (timer_id < MRCP_FRAME_CLOCK_TIMER_COUNT && (clock->started & (1 << timer_id))) ? TRUE : FALSE;
+}
+
+/**
+ * Stop and return the earliest expired timer.
+ * @param clock the clock to expire the timer of
+ * @return the identifier of the expired timer or -1 if none
+ */
+MRCP_DECLARE(int) mrcp_frame_clock_expire(mrcp_frame_clock_t *clock);
+
+/**
+ * Advance frame clock by the duration of processed frame.
+ * @param clock the clock to advance
+ * @param duration the duration of the frame (msec), CODEC_FRAME_TIME_BASE usually
+ * @return the identifier of the expired timer or -1 if none
+ * @remark Timers expiring by the same frame are returned by subsequent
+ *         calls of mrcp_frame_clock_expire().
+ */
+static APR_INLINE int mrcp_frame_clock_advance(mrcp_frame_clock_t *clock, apr_size_t duration)
+{
+	clock->elapsed += duration;
+	if(!clock->started || clock->elapsed < clock->next) {
+		return -1;
+	}
+	return mrcp_frame_clock_expire(clock);
+}
+
+APT_END_EXTERN_C
+
+#endif /* MRCP_FRAME_CLOCK_H */
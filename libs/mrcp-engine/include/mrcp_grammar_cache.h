@@ -0,0 +1,110 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MRCP_GRAMMAR_CACHE_H
+#define MRCP_GRAMMAR_CACHE_H
+
+/**
+ * @file mrcp_grammar_cache.h
+ * @brief Content-Addressed Cache of Compiled Grammars
+ */
+
+#include "mrcp_types.h"
+#include "apt_string.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Default max number of grammars kept in the cache */
+#define MRCP_GRAMMAR_CACHE_DEFAULT_SIZE 64
+
+/** Opaque grammar cache declaration */
+typedef struct mrcp_grammar_cache_t mrcp_grammar_cache_t;
+
+/** Opaque grammar cache entry declaration */
+typedef struct mrcp_grammar_entry_t mrcp_grammar_entry_t;
+
+/** Prototype of handler to destroy compiled grammar by */
+typedef void (*mrcp_grammar_destroy_f)(void *grammar);
+
+/**
+ * Create grammar cache.
+ * @param max_count the max number of grammars to keep, unreferenced grammars
+ *                  are evicted in least recently used order beyond it
+ * @param pool the pool to allocate memory from
+ */
+MRCP_DECLARE(mrcp_grammar_cache_t*) mrcp_grammar_cache_create(apr_size_t max_count, apr_pool_t *pool);
+
+/**
+ * Destroy grammar cache and all the grammars in it.
+ * @param cache the cache to destroy
+ */
+MRCP_DECLARE(void) mrcp_grammar_cache_destroy(mrcp_grammar_cache_t *cache);
+
+/**
+ * Look up compiled grammar by content.
+ * @param cache the cache to look up in
+ * @param content_type the content type of the grammar
+ * @param content the grammar body
+ * @return the referenced entry, which must be released, or NULL if not found
+ */
+MRCP_DECLARE(mrcp_grammar_entry_t*) mrcp_grammar_cache_lookup(
+										mrcp_grammar_cache_t *cache,
+										const apt_str_t *content_type,
+										const apt_str_t *content);
+
+/**
+ * Insert compiled grammar.
+ * @param cache the cache to insert to
+ * @param content_type the content type of the grammar
+ * @param content the grammar body (copied)
+ * @param grammar the compiled grammar to pass the ownership of
+ * @param destroy the handler to destroy the grammar by
+ * @return the referenced entry, which must be released, or NULL on failure
+ * @remark If the same grammar has been inserted meanwhile (concurrently compiled
+ *         by another channel), the existing entry is returned and the passed
+ *         grammar is destroyed.
+ */
+MRCP_DECLARE(mrcp_grammar_entry_t*) mrcp_grammar_cache_insert(
+										mrcp_grammar_cache_t *cache,
+										const apt_str_t *content_type,
+										const apt_str_t *content,
+										void *grammar,
+										mrcp_grammar_destroy_f destroy);
+
+/**
+ * Release entry got by lookup or insert.
+ * @param cache the cache the entry belongs to
+ * @param entry the entry to release
+ */
+MRCP_DECLARE(void) mrcp_grammar_cache_release(mrcp_grammar_cache_t *cache, mrcp_grammar_entry_t *entry);
+
+/**
+ * Get compiled grammar of the entry.
+ * @param entry the entry to get the grammar of
+ */
+MRCP_DECLARE(void*) mrcp_grammar_entry_object_get(const mrcp_grammar_entry_t *entry);
+
+/**
+ * Get the number of grammars in the cache.
+ * @param cache the cache to get the number of grammars of
+ */
+MRCP_DECLARE(apr_size_t) mrcp_grammar_cache_count_get(const mrcp_grammar_cache_t *cache);
+
+APT_END_EXTERN_C
+
+#endif /* MRCP_GRAMMAR_CACHE_H */
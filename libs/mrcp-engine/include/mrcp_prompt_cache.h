@@ -0,0 +1,133 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MRCP_PROMPT_CACHE_H
+#define MRCP_PROMPT_CACHE_H
+
+/**
+ * @file mrcp_prompt_cache.h
+ * @brief Cache of Synthesized Prompts
+ */
+
+#include "mrcp_message.h"
+#include "mpf_codec_descriptor.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Default memory budget of the cache in bytes */
+#define MRCP_PROMPT_CACHE_DEFAULT_SIZE (8 * 1024 * 1024)
+
+/** Opaque prompt cache declaration */
+typedef struct mrcp_prompt_cache_t mrcp_prompt_cache_t;
+
+/** Opaque prompt cache entry declaration */
+typedef struct mrcp_prompt_entry_t mrcp_prompt_entry_t;
+
+/** Opaque prompt writer declaration */
+typedef struct mrcp_prompt_writer_t mrcp_prompt_writer_t;
+
+/**
+ * Create prompt cache.
+ * @param max_size the memory budget in bytes, unreferenced prompts
+ *                 are evicted in least recently used order beyond it
+ * @param pool the pool to allocate memory from
+ */
+MRCP_DECLARE(mrcp_prompt_cache_t*) mrcp_prompt_cache_create(apr_size_t max_size, apr_pool_t *pool);
+
+/**
+ * Destroy prompt cache and all the prompts in it.
+ * @param cache the cache to destroy
+ */
+MRCP_DECLARE(void) mrcp_prompt_cache_destroy(mrcp_prompt_cache_t *cache);
+
+/**
+ * Generate the key of the prompt to synthesize.
+ * @param key the key to generate
+ * @param request the SPEAK request (the body, Content-Type, voice, prosody
+ *                and speech language header fields are taken into account)
+ * @param descriptor the codec descriptor the prompt is rendered in
+ * @param pool the pool to allocate memory from
+ * @return FALSE if the request has no body
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_prompt_key_generate(
+							apt_str_t *key,
+							const mrcp_message_t *request,
+							const mpf_codec_descriptor_t *descriptor,
+							apr_pool_t *pool);
+
+/**
+ * Look up prompt by key.
+ * @param cache the cache to look up in
+ * @param key the key of the prompt
+ * @return the referenced entry, which must be released, or NULL if not found
+ */
+MRCP_DECLARE(mrcp_prompt_entry_t*) mrcp_prompt_cache_lookup(mrcp_prompt_cache_t *cache, const apt_str_t *key);
+
+/**
+ * Release entry got by lookup.
+ * @param cache the cache the entry belongs to
+ * @param entry the entry to release
+ */
+MRCP_DECLARE(void) mrcp_prompt_cache_release(mrcp_prompt_cache_t *cache, mrcp_prompt_entry_t *entry);
+
+/**
+ * Get the rendered audio of the prompt.
+ * @param entry the entry to get the audio of
+ * @param size the size of the audio in bytes
+ */
+MRCP_DECLARE(const char*) mrcp_prompt_entry_data_get(const mrcp_prompt_entry_t *entry, apr_size_t *size);
+
+/**
+ * Create writer to record the prompt being synthesized by.
+ * @param cache the cache to record the prompt in
+ * @param key the key of the prompt (copied)
+ */
+MRCP_DECLARE(mrcp_prompt_writer_t*) mrcp_prompt_writer_create(mrcp_prompt_cache_t *cache, const apt_str_t *key);
+
+/**
+ * Append rendered audio to the prompt.
+ * @param writer the writer to append to
+ * @param data the audio to append
+ * @param size the size of the audio
+ * @return FALSE if the prompt exceeds the budget of the cache, the prompt is not cached then
+ * @remark Intended to be called from the context of media processing, as frames are rendered.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_prompt_writer_write(mrcp_prompt_writer_t *writer, const void *data, apr_size_t size);
+
+/**
+ * Insert the recorded prompt into the cache and destroy the writer.
+ * @param writer the writer to commit
+ * @return FALSE if the prompt has not been cached
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_prompt_writer_commit(mrcp_prompt_writer_t *writer);
+
+/**
+ * Discard the recorded prompt (interrupted synthesis) and destroy the writer.
+ * @param writer the writer to abort
+ */
+MRCP_DECLARE(void) mrcp_prompt_writer_abort(mrcp_prompt_writer_t *writer);
+
+/**
+ * Get the memory used by the prompts in the cache.
+ * @param cache the cache to get the used memory of
+ */
+MRCP_DECLARE(apr_size_t) mrcp_prompt_cache_size_get(const mrcp_prompt_cache_t *cache);
+
+APT_END_EXTERN_C
+
+#endif /* MRCP_PROMPT_CACHE_H */
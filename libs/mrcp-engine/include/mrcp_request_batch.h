@@ -0,0 +1,65 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MRCP_REQUEST_BATCH_H
+#define MRCP_REQUEST_BATCH_H
+
+/**
+ * @file mrcp_request_batch.h
+ * @brief Batched Request Delivery of Channels to Engine
+ */
+
+#include "mrcp_engine_types.h"
+
+APT_BEGIN_EXTERN_C
+
+/**
+ * Create request batch of engine.
+ * @param engine the engine to deliver the requests of its channels to
+ *               (see process_requests of mrcp_engine_method_vtable_t)
+ * @remark The batch is created only if the engine implements process_requests and
+ *         the host of the engine handles on_requests of mrcp_engine_event_vtable_t.
+ */
+MRCP_DECLARE(mrcp_request_batch_t*) mrcp_request_batch_create(mrcp_engine_t *engine);
+
+/**
+ * Destroy request batch, the requests not delivered yet are dropped.
+ * @param batch the batch to destroy
+ */
+MRCP_DECLARE(void) mrcp_request_batch_destroy(mrcp_request_batch_t *batch);
+
+/**
+ * Add request of channel to the batch.
+ * @param batch the batch to add to
+ * @param channel the channel the request is of
+ * @param request the request to deliver
+ * @return TRUE if the batch was empty, so that the host is to flush it
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_request_batch_add(mrcp_request_batch_t *batch, mrcp_engine_channel_t *channel, mrcp_message_t *request);
+
+/**
+ * Deliver the requests added so far to the engine in one call.
+ * @param batch the batch to flush
+ * @remark The batch is guarded during delivery, so that the requests of a channel
+ *         are delivered in order, whichever thread flushes the batch.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_request_batch_flush(mrcp_request_batch_t *batch);
+
+APT_END_EXTERN_C
+
+#endif /* MRCP_REQUEST_BATCH_H */
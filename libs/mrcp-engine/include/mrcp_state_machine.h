@@ -24,7 +24,8 @@
  * @brief MRCP State Machine
  */ 
 
-#include "mrcp_types.h"
+#include <apr_tables.h>
+#include "mrcp_message.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -38,6 +39,8 @@ struct mrcp_state_machine_t {
 	void *obj;
 	/** State either active or deactivating */
 	apt_bool_t active;
+	/** Header fields processed inline in SET-PARAMS/GET-PARAMS (flags indexed by id, NULL if none) */
+	const apr_array_header_t *inline_params;
 
 	/** Virtual update */
 	apt_bool_t (*update)(mrcp_state_machine_t *state_machine, mrcp_message_t *message);
@@ -49,6 +52,8 @@ struct mrcp_state_machine_t {
 	apt_bool_t (*on_dispatch)(mrcp_state_machine_t *state_machine, mrcp_message_t *message);
 	/** Deactivated */
 	apt_bool_t (*on_deactivate)(mrcp_state_machine_t *state_machine);
+	/** Queued request to prefetch (start is TRUE) or removed from the queue (start is FALSE), optional */
+	apt_bool_t (*on_prefetch)(mrcp_state_machine_t *state_machine, mrcp_message_t *message, apt_bool_t start);
 };
 
 /** Initialize MRCP state machine */
@@ -56,8 +61,10 @@ static APR_INLINE void mrcp_state_machine_init(mrcp_state_machine_t *state_machi
 {
 	state_machine->obj = obj;
 	state_machine->active = TRUE;
+	state_machine->inline_params = NULL;
 	state_machine->on_dispatch = NULL;
 	state_machine->on_deactivate = NULL;
+	state_machine->on_prefetch = NULL;
 	state_machine->update = NULL;
 	state_machine->deactivate = NULL;
 }
@@ -81,6 +88,32 @@ static APR_INLINE apt_bool_t mrcp_state_machine_deactivate(mrcp_state_machine_t
 	return FALSE;
 }
 
+/**
+ * Check whether all the header fields of SET-PARAMS/GET-PARAMS request are declared
+ * by the engine, so that the request can be processed by the state machine inline.
+ * @param state_machine the state machine of the channel
+ * @param message the request to check
+ * @remark The declared header fields are then inherited by the next request
+ *         (e.g. RECOGNIZE, SPEAK) via mrcp_header_fields_inherit().
+ */
+static APR_INLINE apt_bool_t mrcp_state_machine_params_inline_check(const mrcp_state_machine_t *state_machine, const mrcp_message_t *message)
+{
+	const apt_header_field_t *header_field;
+	const apr_array_header_t *inline_params = state_machine->inline_params;
+	if(!inline_params) {
+		return FALSE;
+	}
+	for(header_field = APR_RING_FIRST(&message->header.header_section.ring);
+			header_field != APR_RING_SENTINEL(&message->header.header_section.ring, apt_header_field_t, link);
+				header_field = APR_RING_NEXT(header_field, link)) {
+		if(header_field->id >= (apr_size_t)inline_params->nelts ||
+			APR_ARRAY_IDX(inline_params,header_field->id,apr_byte_t) == 0) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
 APT_END_EXTERN_C
 
 #endif /* MRCP_STATE_MACHINE_H */
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#ifndef MRCP_VOICEPRINT_CACHE_H
+#define MRCP_VOICEPRINT_CACHE_H
+
+/**
+ * @file mrcp_voiceprint_cache.h
+ * @brief Cache of Voiceprint Models
+ */
+
+#include "mrcp_types.h"
+#include "apt_string.h"
+#include "apt_executor.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Default memory budget of the cache in bytes */
+#define MRCP_VOICEPRINT_CACHE_DEFAULT_SIZE (32 * 1024 * 1024)
+
+/** Opaque voiceprint cache declaration */
+typedef struct mrcp_voiceprint_cache_t mrcp_voiceprint_cache_t;
+
+/** Opaque voiceprint cache entry declaration */
+typedef struct mrcp_voiceprint_entry_t mrcp_voiceprint_entry_t;
+
+/** Voiceprint loader declaration */
+typedef struct mrcp_voiceprint_loader_t mrcp_voiceprint_loader_t;
+
+/** Voiceprint loader, implemented by the engine */
+struct mrcp_voiceprint_loader_t {
+	/** External object passed to the handlers */
+	void  *obj;
+	/** Load the model of voiceprint from storage (may block), return NULL on failure */
+	void* (*load)(void *obj, const char *repository_uri, const char *voiceprint_id, apr_size_t *size);
+	/** Destroy the model loaded */
+	void  (*destroy)(void *obj, void *model);
+};
+
+/**
+ * Create voiceprint cache.
+ * @param max_size the memory budget in bytes, unreferenced models
+ *                 are evicted in least recently used order beyond it
+ * @param loader the loader of models (must outlive the cache)
+ * @param executor the executor to prefetch models by (NULL - no prefetch)
+ * @param pool the pool to allocate memory from
+ */
+MRCP_DECLARE(mrcp_voiceprint_cache_t*) mrcp_voiceprint_cache_create(
+											apr_size_t max_size,
+											const mrcp_voiceprint_loader_t *loader,
+											apt_executor_t *executor,
+											apr_pool_t *pool);
+
+/**
+ * Destroy voiceprint cache and all the models in it.
+ * @param cache the cache to destroy
+ * @remark Waits for the prefetches in progress to complete.
+ */
+MRCP_DECLARE(void) mrcp_voiceprint_cache_destroy(mrcp_voiceprint_cache_t *cache);
+
+/**
+ * Load model of voiceprint in background, unless it is cached or being loaded.
+ * @param cache the cache to load the model to
+ * @param repository_uri the URI of the repository
+ * @param voiceprint_id the identifier of the voiceprint
+ * @return FALSE if the model is neither cached nor being loaded
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_voiceprint_cache_prefetch(
+							mrcp_voiceprint_cache_t *cache,
+							const apt_str_t *repository_uri,
+							const apt_str_t *voiceprint_id);
+
+/**
+ * Get model of voiceprint.
+ * @param cache the cache to get the model from
+ * @param repository_uri the URI of the repository
+ * @param voiceprint_id the identifier of the voiceprint
+ * @return the referenced entry, which must be released, or NULL if the model failed to load
+ * @remark Blocks, while the model is being prefetched or, if not cached, loaded
+ *         by the caller, so it is not to be called from the context of the server.
+ */
+MRCP_DECLARE(mrcp_voiceprint_entry_t*) mrcp_voiceprint_cache_get(
+							mrcp_voiceprint_cache_t *cache,
+							const apt_str_t *repository_uri,
+							const apt_str_t *voiceprint_id);
+
+/**
+ * Release entry got by get.
+ * @param cache the cache the entry belongs to
+ * @param entry the entry to release
+ */
+MRCP_DECLARE(void) mrcp_voiceprint_cache_release(mrcp_voiceprint_cache_t *cache, mrcp_voiceprint_entry_t *entry);
+
+/**
+ * Invalidate model of voiceprint (e.g. deleted or enrolled anew).
+ * @param cache the cache to invalidate the model in
+ * @param repository_uri the URI of the repository
+ * @param voiceprint_id the identifier of the voiceprint
+ * @remark The model is destroyed, once the last reference to it is released.
+ */
+MRCP_DECLARE(void) mrcp_voiceprint_cache_invalidate(
+							mrcp_voiceprint_cache_t *cache,
+							const apt_str_t *repository_uri,
+							const apt_str_t *voiceprint_id);
+
+/**
+ * Get model of the entry.
+ * @param entry the entry to get the model of
+ */
+MRCP_DECLARE(void*) mrcp_voiceprint_entry_model_get(const mrcp_voiceprint_entry_t *entry);
+
+/**
+ * Get the number of models in the cache.
+ * @param cache the cache to get the number of models of
+ */
+MRCP_DECLARE(apr_size_t) mrcp_voiceprint_cache_count_get(const mrcp_voiceprint_cache_t *cache);
+
+/**
+ * Get the memory used by the models in the cache.
+ * @param cache the cache to get the used memory of
+ */
+MRCP_DECLARE(apr_size_t) mrcp_voiceprint_cache_size_get(const mrcp_voiceprint_cache_t *cache);
+
+APT_END_EXTERN_C
+
+#endif /* MRCP_VOICEPRINT_CACHE_H */
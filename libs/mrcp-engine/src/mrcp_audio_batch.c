@@ -0,0 +1,180 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include <apr_atomic.h>
+#include <apr_thread_mutex.h>
+#include "mrcp_audio_batch.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+
+/** Max number of pending jobs, one gather job at a time */
+#define MRCP_AUDIO_BATCH_STRAND_SIZE 2
+
+/** Channel in the batch */
+typedef struct mrcp_audio_batch_member_t mrcp_audio_batch_member_t;
+struct mrcp_audio_batch_member_t {
+	/** Channel */
+	mrcp_engine_channel_t *channel;
+	/** Buffer to read the pipe of the channel to */
+	char                  *buffer;
+	/** Size of the buffer */
+	apr_size_t             size;
+};
+
+/** Audio batch */
+struct mrcp_audio_batch_t {
+	/** Engine to deliver the audio to */
+	mrcp_engine_t         *engine;
+	/** Strand to gather the audio by */
+	apt_executor_strand_t *strand;
+	/** Channels in the batch (mrcp_audio_batch_member_t) */
+	apr_array_header_t    *members;
+	/** Items passed to the engine (mrcp_audio_batch_item_t) */
+	apr_array_header_t    *items;
+	/** Guard of members, held during delivery, so that removed channels are never delivered */
+	apr_thread_mutex_t    *guard;
+	/** Whether a gather job is pending */
+	volatile apr_uint32_t  pending;
+	/** Own pool */
+	apr_pool_t            *pool;
+};
+
+static void mrcp_audio_batch_gather_job(void *obj, void *arg)
+{
+	mrcp_audio_batch_t *batch = obj;
+	mrcp_audio_batch_member_t *member;
+	mrcp_audio_batch_item_t *item;
+	int i;
+
+	/* reset before gathering, so that pipes notified meanwhile get a new job */
+	apr_atomic_set32(&batch->pending,0);
+
+	apr_thread_mutex_lock(batch->guard);
+	apr_array_clear(batch->items);
+	for(i=0; i<batch->members->nelts; i++) {
+		apr_size_t size;
+		member = &APR_ARRAY_IDX(batch->members,i,mrcp_audio_batch_member_t);
+		size = mrcp_audio_pipe_read(member->channel->audio_pipe,member->buffer,member->size);
+		if(!size) {
+			continue;
+		}
+		item = apr_array_push(batch->items);
+		item->channel = member->channel;
+		item->data = member->buffer;
+		item->size = size;
+	}
+	if(batch->items->nelts) {
+		batch->engine->method_vtable->process_batch(
+			batch->engine,
+			(const mrcp_audio_batch_item_t*)batch->items->elts,
+			batch->items->nelts);
+	}
+	apr_thread_mutex_unlock(batch->guard);
+}
+
+/** Create audio batch of engine */
+MRCP_DECLARE(mrcp_audio_batch_t*) mrcp_audio_batch_create(mrcp_engine_t *engine, apt_executor_t *executor)
+{
+	mrcp_audio_batch_t *batch;
+	apr_pool_t *pool;
+	if(!engine->method_vtable->process_batch || !executor) {
+		return NULL;
+	}
+	pool = apt_pool_create();
+	if(!pool) {
+		return NULL;
+	}
+	batch = apr_palloc(pool,sizeof(mrcp_audio_batch_t));
+	batch->engine = engine;
+	batch->pending = 0;
+	batch->pool = pool;
+	batch->members = apr_array_make(pool,8,sizeof(mrcp_audio_batch_member_t));
+	batch->items = apr_array_make(pool,8,sizeof(mrcp_audio_batch_item_t));
+	batch->strand = apt_executor_strand_create(executor,MRCP_AUDIO_BATCH_STRAND_SIZE,pool);
+	if(!batch->strand) {
+		apr_pool_destroy(pool);
+		return NULL;
+	}
+	if(apr_thread_mutex_create(&batch->guard,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		apt_executor_strand_destroy(batch->strand);
+		apr_pool_destroy(pool);
+		return NULL;
+	}
+	return batch;
+}
+
+/** Destroy audio batch */
+MRCP_DECLARE(void) mrcp_audio_batch_destroy(mrcp_audio_batch_t *batch)
+{
+	/* wait for the pending job */
+	apt_executor_strand_destroy(batch->strand);
+	apr_thread_mutex_destroy(batch->guard);
+	apr_pool_destroy(batch->pool);
+}
+
+/** Add channel to the batch */
+MRCP_DECLARE(apt_bool_t) mrcp_audio_batch_channel_add(mrcp_audio_batch_t *batch, mrcp_engine_channel_t *channel)
+{
+	mrcp_audio_batch_member_t *member;
+	if(!channel->audio_pipe) {
+		return FALSE;
+	}
+	apr_thread_mutex_lock(batch->guard);
+	member = apr_array_push(batch->members);
+	member->channel = channel;
+	member->size = mrcp_audio_pipe_size_get(channel->audio_pipe);
+	/* the buffer lives as long as the channel */
+	member->buffer = apr_palloc(channel->pool,member->size);
+	apr_thread_mutex_unlock(batch->guard);
+	/* the audio queued while the channel was not in the batch is stale */
+	mrcp_audio_pipe_discard(channel->audio_pipe);
+	return TRUE;
+}
+
+/** Remove channel from the batch */
+MRCP_DECLARE(apt_bool_t) mrcp_audio_batch_channel_remove(mrcp_audio_batch_t *batch, mrcp_engine_channel_t *channel)
+{
+	apt_bool_t status = FALSE;
+	int i;
+	apr_thread_mutex_lock(batch->guard);
+	for(i=0; i<batch->members->nelts; i++) {
+		mrcp_audio_batch_member_t *member = &APR_ARRAY_IDX(batch->members,i,mrcp_audio_batch_member_t);
+		if(member->channel == channel) {
+			/* move the last member to the place of the removed one */
+			*member = APR_ARRAY_IDX(batch->members,batch->members->nelts - 1,mrcp_audio_batch_member_t);
+			batch->members->nelts--;
+			status = TRUE;
+			break;
+		}
+	}
+	apr_thread_mutex_unlock(batch->guard);
+	return status;
+}
+
+/** Notification handler of audio pipes */
+MRCP_DECLARE(void) mrcp_audio_batch_notify(mrcp_audio_pipe_t *pipe, void *obj)
+{
+	mrcp_audio_batch_t *batch = obj;
+	if(apr_atomic_cas32(&batch->pending,1,0) == 0) {
+		if(apt_executor_job_submit(batch->strand,mrcp_audio_batch_gather_job,batch,NULL) == FALSE) {
+			/* the audio is gathered by the next job */
+			apr_atomic_set32(&batch->pending,0);
+		}
+	}
+}
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include <apr_atomic.h>
+#include "mrcp_audio_pipe.h"
+#include "mpf_codec_descriptor.h"
+
+/** Audio pipe */
+struct mrcp_audio_pipe_t {
+	/** Audio of frames */
+	char                    *frames;
+	/** Size of audio of each frame */
+	apr_size_t              *sizes;
+	/** Max size of a frame */
+	apr_size_t               frame_size;
+	/** Number of frames the ring holds */
+	apr_uint32_t             frame_count;
+	/** Number of frames to notify the consumer at */
+	apr_uint32_t             batch_count;
+	/** Handler to notify the consumer by */
+	mrcp_audio_pipe_notify_f notify;
+	/** External object */
+	void                    *obj;
+
+	/** Separate producer and consumer positions to avoid false sharing */
+	char                     pad1[64];
+	/** Number of written frames (advanced by producer) */
+	volatile apr_uint32_t    produced;
+	char                     pad2[64];
+	/** Number of read frames (advanced by consumer) */
+	volatile apr_uint32_t    consumed;
+	/** Whether the consumer has been notified and not read since */
+	volatile apr_uint32_t    notified;
+	/** Number of frames dropped, as the ring was full */
+	volatile apr_uint32_t    dropped;
+};
+
+/** Load with full barrier (acquire semantics) */
+static APR_INLINE apr_uint32_t mrcp_audio_pipe_load(volatile apr_uint32_t *mem)
+{
+	return apr_atomic_add32(mem,0);
+}
+
+static APR_INLINE apr_uint32_t mrcp_audio_pipe_frames_get(apr_size_t duration)
+{
+	apr_size_t count = duration / CODEC_FRAME_TIME_BASE;
+	return count ? (apr_uint32_t)count : 1;
+}
+
+/** Notify the consumer, unless notified already (producer) */
+static void mrcp_audio_pipe_notify(mrcp_audio_pipe_t *pipe)
+{
+	if(pipe->notify && apr_atomic_cas32(&pipe->notified,1,0) == 0) {
+		pipe->notify(pipe,pipe->obj);
+	}
+}
+
+/** Create audio pipe */
+MRCP_DECLARE(mrcp_audio_pipe_t*) mrcp_audio_pipe_create(
+									apr_size_t frame_size,
+									apr_size_t capacity,
+									apr_size_t batch,
+									mrcp_audio_pipe_notify_f notify,
+									void *obj,
+									apr_pool_t *pool)
+{
+	mrcp_audio_pipe_t *pipe;
+	if(!frame_size) {
+		return NULL;
+	}
+	pipe = apr_palloc(pool,sizeof(mrcp_audio_pipe_t));
+	pipe->frame_count = mrcp_audio_pipe_frames_get(capacity);
+	pipe->batch_count = mrcp_audio_pipe_frames_get(batch);
+	if(pipe->batch_count > pipe->frame_count) {
+		pipe->batch_count = pipe->frame_count;
+	}
+	pipe->frame_size = frame_size;
+	pipe->frames = apr_palloc(pool,frame_size * pipe->frame_count);
+	pipe->sizes = apr_pcalloc(pool,sizeof(apr_size_t) * pipe->frame_count);
+	pipe->notify = notify;
+	pipe->obj = obj;
+	pipe->produced = 0;
+	pipe->consumed = 0;
+	pipe->notified = 0;
+	pipe->dropped = 0;
+	return pipe;
+}
+
+/** Write frame to the pipe */
+MRCP_DECLARE(apt_bool_t) mrcp_audio_pipe_write(mrcp_audio_pipe_t *pipe, const mpf_frame_t *frame)
+{
+	apr_uint32_t index;
+	apr_size_t size = frame->codec_frame.size;
+	char *data;
+	if(size > pipe->frame_size) {
+		size = pipe->frame_size;
+	}
+	if(!size) {
+		return TRUE;
+	}
+	if(pipe->produced - mrcp_audio_pipe_load(&pipe->consumed) >= pipe->frame_count) {
+		/* the engine lags behind, never wait for it */
+		apr_atomic_inc32(&pipe->dropped);
+		mrcp_audio_pipe_notify(pipe);
+		return FALSE;
+	}
+
+	index = pipe->produced % pipe->frame_count;
+	data = pipe->frames + index * pipe->frame_size;
+	if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO && frame->codec_frame.buffer) {
+		memcpy(data,frame->codec_frame.buffer,size);
+	}
+	else {
+		/* keep the timeline of the stream */
+		memset(data,0,size);
+	}
+	pipe->sizes[index] = size;
+	apr_atomic_inc32(&pipe->produced);
+
+	if(pipe->produced - mrcp_audio_pipe_load(&pipe->consumed) >= pipe->batch_count) {
+		mrcp_audio_pipe_notify(pipe);
+	}
+	return TRUE;
+}
+
+/** Notify the consumer of the frames written, even if less than a batch */
+MRCP_DECLARE(void) mrcp_audio_pipe_flush(mrcp_audio_pipe_t *pipe)
+{
+	if(pipe->produced != mrcp_audio_pipe_load(&pipe->consumed)) {
+		mrcp_audio_pipe_notify(pipe);
+	}
+}
+
+/** Read frames from the pipe in one batch */
+MRCP_DECLARE(apr_size_t) mrcp_audio_pipe_read(mrcp_audio_pipe_t *pipe, void *buffer, apr_size_t size)
+{
+	char *pos = buffer;
+	apr_uint32_t consumed = pipe->consumed;
+	apr_uint32_t produced;
+
+	/* reset before reading, so that frames written meanwhile get a new notification */
+	apr_atomic_set32(&pipe->notified,0);
+	produced = mrcp_audio_pipe_load(&pipe->produced);
+	while(consumed != produced) {
+		apr_uint32_t index = consumed % pipe->frame_count;
+		apr_size_t frame_size = pipe->sizes[index];
+		if(frame_size > size) {
+			break;
+		}
+		memcpy(pos,pipe->frames + index * pipe->frame_size,frame_size);
+		pos += frame_size;
+		size -= frame_size;
+		consumed++;
+	}
+	/* publish the read frames at once */
+	apr_atomic_set32(&pipe->consumed,consumed);
+	return pos - (char*)buffer;
+}
+
+/** Discard all the written frames */
+MRCP_DECLARE(void) mrcp_audio_pipe_discard(mrcp_audio_pipe_t *pipe)
+{
+	apr_atomic_set32(&pipe->notified,0);
+	apr_atomic_set32(&pipe->consumed,mrcp_audio_pipe_load(&pipe->produced));
+}
+
+/** Get the number of frames available to read */
+MRCP_DECLARE(apr_size_t) mrcp_audio_pipe_count_get(const mrcp_audio_pipe_t *pipe)
+{
+	mrcp_audio_pipe_t *mutable_pipe = (mrcp_audio_pipe_t*)pipe;
+	return mrcp_audio_pipe_load(&mutable_pipe->produced) - mrcp_audio_pipe_load(&mutable_pipe->consumed);
+}
+
+/** Get the size of audio the pipe holds in bytes */
+MRCP_DECLARE(apr_size_t) mrcp_audio_pipe_size_get(const mrcp_audio_pipe_t *pipe)
+{
+	return pipe->frame_size * pipe->frame_count;
+}
+
+/** Get and reset the number of frames dropped */
+MRCP_DECLARE(apr_size_t) mrcp_audio_pipe_dropped_get(mrcp_audio_pipe_t *pipe)
+{
+	return apr_atomic_xchg32(&pipe->dropped,0);
+}
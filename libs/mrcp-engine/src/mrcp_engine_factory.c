@@ -124,6 +124,20 @@ MRCP_DECLARE(apt_bool_t) mrcp_engine_factory_engine_register(mrcp_engine_factory
 	return TRUE;
 }
 
+/** Unregister engine */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_factory_engine_unregister(mrcp_engine_factory_t *factory, mrcp_engine_t *engine)
+{
+	if(!engine || !engine->id) {
+		return FALSE;
+	}
+	if(apr_hash_get(factory->engines,engine->id,APR_HASH_KEY_STRING) != engine) {
+		/* another engine is registered by the id */
+		return FALSE;
+	}
+	apr_hash_set(factory->engines,engine->id,APR_HASH_KEY_STRING,NULL);
+	return TRUE;
+}
+
 /** Get engine by name */
 MRCP_DECLARE(mrcp_engine_t*) mrcp_engine_factory_engine_get(const mrcp_engine_factory_t *factory, const char *name)
 {
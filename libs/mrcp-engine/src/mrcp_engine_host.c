@@ -0,0 +1,1399 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include "mrcp_engine_host.h"
+#include "apt_log.h"
+
+#if APR_HAS_FORK
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <apr_shm.h>
+#include <apr_atomic.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#include "mrcp_engine_iface.h"
+#include "mrcp_engine_impl.h"
+#include "mrcp_stream.h"
+#include "mrcp_resource.h"
+#include "mpf_termination.h"
+#include "mpf_engine.h"
+#include "mpf_codec_descriptor.h"
+#include "apt_shm_ring.h"
+#include "apt_pool.h"
+
+/** Capacity of the rings of requests and events in bytes (a message takes half at most) */
+#define HOST_MESSAGE_RING_SIZE   (1024 * 1024)
+/** Capacity of the rings of audio frames of a channel in bytes */
+#define HOST_AUDIO_RING_SIZE     (32 * 1024)
+/** Number of channels, if the max number is not configured */
+#define HOST_DEFAULT_SLOT_COUNT  64
+/** Number of frames read from the engine ahead of the server */
+#define HOST_SOURCE_PREFILL      2
+/** Size of the buffer message headers are generated into */
+#define HOST_HEADER_BUFFER_SIZE  8192
+/** Max size of stream capabilities */
+#define HOST_REPLY_SIZE          1024
+/** Time to wait for the worker to reply or for space in a ring */
+#define HOST_REPLY_TIMEOUT       (5 * APR_USEC_PER_SEC)
+/** Time to sleep, till the peer process is checked to be alive */
+#define HOST_IDLE_TIMEOUT        APR_USEC_PER_SEC
+
+/** Types of records */
+typedef enum {
+	HOST_RECORD_READY,           /**< worker -> server: engine created (value: resource id or -1) */
+	HOST_RECORD_ENGINE_OPEN,     /**< open engine, respond (value: status) */
+	HOST_RECORD_ENGINE_CLOSE,    /**< close engine, respond */
+	HOST_RECORD_ENGINE_DESTROY,  /**< server -> worker: destroy engine and exit */
+	HOST_RECORD_CHANNEL_CREATE,  /**< create channel, respond (value: status, stream capabilities follow) */
+	HOST_RECORD_CHANNEL_DESTROY, /**< server -> worker: destroy channel */
+	HOST_RECORD_CHANNEL_OPEN,    /**< open channel (value: MRCP version, channel id follows), respond (value: status) */
+	HOST_RECORD_CHANNEL_CLOSE,   /**< close channel, respond */
+	HOST_RECORD_MESSAGE,         /**< request or response/event (resource name and message follow) */
+	HOST_RECORD_STREAM_OPEN,     /**< server -> worker: open stream (value: direction, host_stream_t follows) */
+	HOST_RECORD_STREAM_CLOSE     /**< server -> worker: close stream (value: direction) */
+} host_record_type_e;
+
+/** Header of record of the rings of messages */
+typedef struct host_record_t host_record_t;
+struct host_record_t {
+	apr_uint16_t type;
+	apr_uint16_t slot;
+	apr_int32_t  value;
+};
+
+/** Codec of opened stream */
+typedef struct host_stream_t host_stream_t;
+struct host_stream_t {
+	apr_uint32_t frame_size;
+	apr_uint16_t sampling_rate;
+	apr_byte_t   channel_count;
+	apr_byte_t   payload_type;
+	/* codec name follows */
+};
+
+/** Header of record of the rings of audio frames */
+typedef struct host_frame_t host_frame_t;
+struct host_frame_t {
+	apr_int32_t             type;
+	apr_int32_t             marker;
+	mpf_named_event_frame_t event_frame;
+	apr_uint32_t            size;
+	/* codec frame follows */
+};
+
+/** Slot of channel */
+typedef struct mrcp_host_slot_t mrcp_host_slot_t;
+struct mrcp_host_slot_t {
+	apr_uint16_t           id;
+	/** Frames written to the engine (server -> worker) */
+	apt_shm_ring_t        *sink_ring;
+	/** Frames read from the engine (worker -> server) */
+	apt_shm_ring_t        *source_ring;
+	/** Buffer message headers are generated into (a copy of its own in each process) */
+	char                  *buffer;
+
+	/* used by the server */
+	/** Proxy channel (NULL if the slot is free) */
+	mrcp_engine_channel_t *proxy;
+	apt_bool_t             in_use;
+	mrcp_parser_t         *proxy_parser;
+	mrcp_generator_t      *proxy_generator;
+	/** Open or close response is awaited (HOST_RECORD_CHANNEL_OPEN or HOST_RECORD_CHANNEL_CLOSE, 0 if none) */
+	apr_uint32_t           pending;
+	/** Reply to channel create is received */
+	apt_bool_t             replied;
+	apr_int32_t            reply_status;
+	char                   reply[HOST_REPLY_SIZE];
+	apr_size_t             reply_size;
+
+	/* used by the worker */
+	mrcp_engine_channel_t *channel;
+	apr_pool_t            *pool;
+	mrcp_parser_t         *parser;
+	mrcp_generator_t      *generator;
+	/** Open or close is responded by the engine */
+	apt_bool_t             responded;
+	apt_bool_t             sink_open;
+	apt_bool_t             source_open;
+	apr_size_t             frame_size;
+};
+
+/** Host of engine */
+typedef struct mrcp_engine_host_t mrcp_engine_host_t;
+struct mrcp_engine_host_t {
+	const char                    *id;
+	/** Proxy engine in the server, hosted engine in the worker */
+	mrcp_engine_t                 *engine;
+	const mrcp_resource_factory_t *resource_factory;
+	const apt_dir_layout_t        *dir_layout;
+	mrcp_engine_config_t          *config;
+
+	apr_shm_t                     *shm;
+	/** Doorbell the worker sleeps on */
+	apt_doorbell_t                *worker_doorbell;
+	/** Doorbell the server (reader thread) sleeps on */
+	apt_doorbell_t                *server_doorbell;
+	/** Requests and commands (server -> worker) */
+	apt_shm_ring_t                *control_ring;
+	/** Responses, events and replies (worker -> server) */
+	apt_shm_ring_t                *event_ring;
+	mrcp_host_slot_t              *slots;
+	apr_size_t                     slot_count;
+
+	/** Worker process */
+	apr_proc_t                     proc;
+	/** Serializes producers of the ring written by the process */
+	apr_thread_mutex_t            *ring_mutex;
+	/** Protects slots and replies (server) */
+	apr_thread_mutex_t            *mutex;
+	apr_thread_cond_t             *cond;
+	/** Thread events are read by (server) */
+	apr_thread_t                  *reader;
+	/** Engine open or close response is awaited */
+	apr_uint32_t                   pending;
+	/** Non-zero while the peer process is alive */
+	volatile apr_uint32_t          alive;
+	volatile apr_uint32_t          running;
+	apt_bool_t                     stopped;
+	apr_pool_t                    *pool;
+};
+
+static APR_INLINE apt_bool_t mrcp_host_is_alive(mrcp_engine_host_t *host)
+{
+	return apr_atomic_read32(&host->alive) ? TRUE : FALSE;
+}
+
+/** Write record to the ring of messages, waiting for space, if full */
+static apt_bool_t mrcp_host_record_send(
+					mrcp_engine_host_t *host,
+					apt_shm_ring_t *ring,
+					apt_doorbell_t *doorbell,
+					host_record_type_e type,
+					apr_uint16_t slot,
+					apr_int32_t value,
+					const void *data1, apr_size_t size1,
+					const void *data2, apr_size_t size2,
+					const void *data3, apr_size_t size3)
+{
+	char *record;
+	host_record_t *header;
+	apr_size_t size = sizeof(host_record_t) + size1 + size2 + size3;
+	apr_time_t start = 0;
+	if(mrcp_host_is_alive(host) == FALSE) {
+		return FALSE;
+	}
+
+	apr_thread_mutex_lock(host->ring_mutex);
+	while((record = apt_shm_ring_reserve(ring,size)) == NULL) {
+		if(size > HOST_MESSAGE_RING_SIZE / 2) {
+			apr_thread_mutex_unlock(host->ring_mutex);
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Too Large Record [%"APR_SIZE_T_FMT" bytes] of Hosted Engine [%s]",size,host->id);
+			return FALSE;
+		}
+		if(!start) {
+			start = apr_time_now();
+		}
+		else if(apr_time_now() - start > HOST_REPLY_TIMEOUT || mrcp_host_is_alive(host) == FALSE) {
+			apr_thread_mutex_unlock(host->ring_mutex);
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Ring of Hosted Engine [%s] Is Full",host->id);
+			return FALSE;
+		}
+		/* the peer drains the ring far faster than it is filled, unless stuck */
+		apr_sleep(1000);
+	}
+	header = (host_record_t*)record;
+	header->type = (apr_uint16_t)type;
+	header->slot = slot;
+	header->value = value;
+	record += sizeof(host_record_t);
+	if(size1) {
+		memcpy(record,data1,size1);
+		record += size1;
+	}
+	if(size2) {
+		memcpy(record,data2,size2);
+		record += size2;
+	}
+	if(size3) {
+		memcpy(record,data3,size3);
+	}
+	apt_shm_ring_commit(ring,size);
+	apr_thread_mutex_unlock(host->ring_mutex);
+	apt_doorbell_ring(doorbell);
+	return TRUE;
+}
+
+/** Send record from the server to the worker */
+static APR_INLINE apt_bool_t mrcp_host_control_send(mrcp_engine_host_t *host, host_record_type_e type, apr_uint16_t slot, apr_int32_t value, const void *data, apr_size_t size)
+{
+	return mrcp_host_record_send(host,host->control_ring,host->worker_doorbell,type,slot,value,data,size,NULL,0,NULL,0);
+}
+
+/** Send record from the worker to the server */
+static APR_INLINE apt_bool_t mrcp_host_event_send(mrcp_engine_host_t *host, host_record_type_e type, apr_uint16_t slot, apr_int32_t value, const void *data, apr_size_t size)
+{
+	return mrcp_host_record_send(host,host->event_ring,host->server_doorbell,type,slot,value,data,size,NULL,0,NULL,0);
+}
+
+/** Send MRCP message as resource name and text */
+static apt_bool_t mrcp_host_message_send(mrcp_engine_host_t *host, mrcp_host_slot_t *slot, mrcp_generator_t *generator, mrcp_message_t *message, apt_bool_t to_worker)
+{
+	apt_text_stream_t stream;
+	const apt_str_t *body;
+	const char *name = message->resource ? message->resource->name.buf : "";
+	apr_size_t name_size = message->resource ? message->resource->name.length + 1 : 1;
+	if(!generator) {
+		return FALSE;
+	}
+
+	body = mrcp_message_body_flatten(message);
+	apt_text_stream_init(&stream,slot->buffer,HOST_HEADER_BUFFER_SIZE);
+	if(mrcp_generator_message_generate(generator,message,&stream) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Generate Message of Hosted Engine [%s]",host->id);
+		return FALSE;
+	}
+	return mrcp_host_record_send(
+				host,
+				to_worker == TRUE ? host->control_ring : host->event_ring,
+				to_worker == TRUE ? host->worker_doorbell : host->server_doorbell,
+				HOST_RECORD_MESSAGE,
+				slot->id,
+				0,
+				name,name_size,
+				stream.text.buf,stream.pos - stream.text.buf,
+				body ? body->buf : NULL,body ? body->length : 0);
+}
+
+/** Parse MRCP message of record */
+static mrcp_message_t* mrcp_host_message_parse(mrcp_engine_host_t *host, mrcp_parser_t **parser, apr_pool_t *pool, const char *data, apr_size_t size)
+{
+	apt_text_stream_t stream;
+	apt_str_t resource_name;
+	mrcp_message_t *message = NULL;
+	apr_size_t name_size = strnlen(data,size);
+	if(name_size == size) {
+		return NULL;
+	}
+	apt_string_set(&resource_name,data);
+	resource_name.length = name_size;
+	name_size++;
+
+	/* the record belongs to the consumer till released */
+	apt_text_stream_init(&stream,(char*)data + name_size,size - name_size);
+	mrcp_parser_resource_set(*parser,&resource_name);
+	if(mrcp_parser_run(*parser,&stream,&message) != APT_MESSAGE_STATUS_COMPLETE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Parse Message of Hosted Engine [%s]",host->id);
+		/* start over with a parser in the initial state */
+		*parser = mrcp_parser_create(host->resource_factory,pool);
+		return NULL;
+	}
+	return message;
+}
+
+
+/* ------------------------- worker process ------------------------- */
+
+static apt_bool_t mrcp_host_engine_on_open(mrcp_engine_t *engine, apt_bool_t status)
+{
+	mrcp_engine_host_t *host = engine->event_obj;
+	host->pending = 0;
+	mrcp_engine_on_open(engine,status);
+	return mrcp_host_event_send(host,HOST_RECORD_ENGINE_OPEN,0,status,NULL,0);
+}
+
+static apt_bool_t mrcp_host_engine_on_close(mrcp_engine_t *engine)
+{
+	mrcp_engine_host_t *host = engine->event_obj;
+	host->pending = 0;
+	mrcp_engine_on_close(engine);
+	return mrcp_host_event_send(host,HOST_RECORD_ENGINE_CLOSE,0,0,NULL,0);
+}
+
+static const mrcp_engine_event_vtable_t host_engine_event_vtable = {
+	mrcp_host_engine_on_open,
+	mrcp_host_engine_on_close
+};
+
+static apt_bool_t mrcp_host_channel_on_open(mrcp_engine_channel_t *channel, apt_bool_t status)
+{
+	mrcp_host_slot_t *slot = channel->event_obj;
+	mrcp_engine_host_t *host = channel->engine->event_obj;
+	slot->responded = TRUE;
+	return mrcp_host_event_send(host,HOST_RECORD_CHANNEL_OPEN,slot->id,status,NULL,0);
+}
+
+static apt_bool_t mrcp_host_channel_on_close(mrcp_engine_channel_t *channel)
+{
+	mrcp_host_slot_t *slot = channel->event_obj;
+	mrcp_engine_host_t *host = channel->engine->event_obj;
+	slot->responded = TRUE;
+	return mrcp_host_event_send(host,HOST_RECORD_CHANNEL_CLOSE,slot->id,0,NULL,0);
+}
+
+static apt_bool_t mrcp_host_channel_on_message(mrcp_engine_channel_t *channel, mrcp_message_t *message)
+{
+	mrcp_host_slot_t *slot = channel->event_obj;
+	mrcp_engine_host_t *host = channel->engine->event_obj;
+	apt_bool_t status;
+	/* the generator and the buffer of the slot are shared by the threads of the engine */
+	apr_thread_mutex_lock(host->mutex);
+	status = mrcp_host_message_send(host,slot,slot->generator,message,FALSE);
+	apr_thread_mutex_unlock(host->mutex);
+	return status;
+}
+
+static const mrcp_engine_channel_event_vtable_t host_channel_event_vtable = {
+	mrcp_host_channel_on_open,
+	mrcp_host_channel_on_close,
+	mrcp_host_channel_on_message
+};
+
+/** Compose stream capabilities of channel to reply with */
+static apr_size_t mrcp_host_capabilities_compose(const mpf_stream_capabilities_t *capabilities, char *buf, apr_size_t max_size)
+{
+	apr_size_t size = 3 * sizeof(apr_uint32_t);
+	apr_uint32_t value;
+	int i;
+	value = capabilities->direction;
+	memcpy(buf,&value,sizeof(value));
+	value = capabilities->codecs.allow_named_events;
+	memcpy(buf + sizeof(value),&value,sizeof(value));
+	value = 0;
+	for(i=0; i<capabilities->codecs.attrib_arr->nelts; i++) {
+		const mpf_codec_attribs_t *attribs = &APR_ARRAY_IDX(capabilities->codecs.attrib_arr,i,mpf_codec_attribs_t);
+		apr_uint32_t sample_rates = attribs->sample_rates;
+		if(size + sizeof(sample_rates) + 1 + attribs->name.length + 1 > max_size) {
+			break;
+		}
+		memcpy(buf + size,&sample_rates,sizeof(sample_rates));
+		size += sizeof(sample_rates);
+		buf[size++] = (char)attribs->bits_per_sample;
+		memcpy(buf + size,attribs->name.buf,attribs->name.length);
+		size += attribs->name.length;
+		buf[size++] = '\0';
+		value++;
+	}
+	memcpy(buf + 2 * sizeof(value),&value,sizeof(value));
+	return size;
+}
+
+static void mrcp_host_channel_create(mrcp_engine_host_t *host, mrcp_host_slot_t *slot)
+{
+	char reply[HOST_REPLY_SIZE];
+	apr_size_t size = 0;
+	mrcp_engine_channel_t *channel;
+	apr_pool_t *pool = apt_pool_create();
+	if(!pool) {
+		mrcp_host_event_send(host,HOST_RECORD_CHANNEL_CREATE,slot->id,FALSE,NULL,0);
+		return;
+	}
+	/* the version is known on open */
+	channel = mrcp_engine_channel_virtual_create(host->engine,MRCP_VERSION_2,pool);
+	if(!channel) {
+		apr_pool_destroy(pool);
+		mrcp_host_event_send(host,HOST_RECORD_CHANNEL_CREATE,slot->id,FALSE,NULL,0);
+		return;
+	}
+	channel->event_vtable = &host_channel_event_vtable;
+	channel->event_obj = slot;
+	slot->channel = channel;
+	slot->pool = pool;
+	slot->parser = mrcp_parser_create(host->resource_factory,pool);
+	slot->generator = mrcp_generator_create(host->resource_factory,pool);
+	slot->sink_open = FALSE;
+	slot->source_open = FALSE;
+	if(channel->termination && channel->termination->audio_stream) {
+		size = mrcp_host_capabilities_compose(channel->termination->audio_stream->capabilities,reply,sizeof(reply));
+	}
+	mrcp_host_event_send(host,HOST_RECORD_CHANNEL_CREATE,slot->id,TRUE,reply,size);
+}
+
+static void mrcp_host_stream_close(mrcp_host_slot_t *slot, mpf_stream_direction_e direction)
+{
+	mpf_audio_stream_t *stream = slot->channel->termination->audio_stream;
+	if(direction == STREAM_DIRECTION_RECEIVE && slot->source_open == TRUE) {
+		slot->source_open = FALSE;
+		if(stream->vtable->close_rx) {
+			stream->vtable->close_rx(stream);
+		}
+	}
+	else if(direction == STREAM_DIRECTION_SEND && slot->sink_open == TRUE) {
+		slot->sink_open = FALSE;
+		if(stream->vtable->close_tx) {
+			stream->vtable->close_tx(stream);
+		}
+		/* the frames written after close are not for the next open */
+		apt_shm_ring_discard(slot->sink_ring);
+	}
+}
+
+static void mrcp_host_stream_open(mrcp_host_slot_t *slot, mpf_stream_direction_e direction, const char *data, apr_size_t size)
+{
+	host_stream_t info;
+	mpf_codec_descriptor_t *descriptor;
+	mpf_audio_stream_t *stream = slot->channel->termination->audio_stream;
+	if(size < sizeof(info)) {
+		return;
+	}
+	memcpy(&info,data,sizeof(info));
+	descriptor = mpf_codec_descriptor_create(slot->pool);
+	descriptor->payload_type = info.payload_type;
+	descriptor->sampling_rate = info.sampling_rate;
+	descriptor->channel_count = info.channel_count;
+	apt_string_assign_n(&descriptor->name,data + sizeof(info),size - sizeof(info),slot->pool);
+
+	mrcp_host_stream_close(slot,direction);
+	if(direction == STREAM_DIRECTION_RECEIVE) {
+		stream->rx_descriptor = descriptor;
+		if(!stream->vtable->open_rx || stream->vtable->open_rx(stream,NULL) == TRUE) {
+			slot->frame_size = info.frame_size;
+			slot->source_open = TRUE;
+		}
+	}
+	else {
+		stream->tx_descriptor = descriptor;
+		if(!stream->vtable->open_tx || stream->vtable->open_tx(stream,NULL) == TRUE) {
+			slot->sink_open = TRUE;
+		}
+	}
+}
+
+static void mrcp_host_channel_destroy(mrcp_host_slot_t *slot)
+{
+	if(slot->channel->termination && slot->channel->termination->audio_stream) {
+		mrcp_host_stream_close(slot,STREAM_DIRECTION_RECEIVE);
+		mrcp_host_stream_close(slot,STREAM_DIRECTION_SEND);
+	}
+	mrcp_engine_channel_virtual_destroy(slot->channel);
+	slot->channel = NULL;
+	apr_pool_destroy(slot->pool);
+	slot->pool = NULL;
+	slot->parser = NULL;
+	slot->generator = NULL;
+}
+
+/** Process record of the server, return FALSE on destroy */
+static apt_bool_t mrcp_host_control_process(mrcp_engine_host_t *host, const host_record_t *record, const char *data, apr_size_t size)
+{
+	mrcp_host_slot_t *slot = NULL;
+	if(record->type >= HOST_RECORD_CHANNEL_CREATE) {
+		if(record->slot >= host->slot_count) {
+			return TRUE;
+		}
+		slot = &host->slots[record->slot];
+		if(record->type != HOST_RECORD_CHANNEL_CREATE && !slot->channel) {
+			return TRUE;
+		}
+	}
+
+	switch(record->type) {
+		case HOST_RECORD_ENGINE_OPEN:
+			host->pending = HOST_RECORD_ENGINE_OPEN;
+			if(mrcp_engine_virtual_open(host->engine) == FALSE && host->pending) {
+				mrcp_host_event_send(host,HOST_RECORD_ENGINE_OPEN,0,FALSE,NULL,0);
+			}
+			break;
+		case HOST_RECORD_ENGINE_CLOSE:
+			host->pending = HOST_RECORD_ENGINE_CLOSE;
+			if(mrcp_engine_virtual_close(host->engine) == FALSE && host->pending) {
+				mrcp_host_event_send(host,HOST_RECORD_ENGINE_CLOSE,0,0,NULL,0);
+			}
+			break;
+		case HOST_RECORD_ENGINE_DESTROY:
+			return FALSE;
+		case HOST_RECORD_CHANNEL_CREATE:
+			if(slot->channel) {
+				mrcp_host_channel_destroy(slot);
+			}
+			mrcp_host_channel_create(host,slot);
+			break;
+		case HOST_RECORD_CHANNEL_DESTROY:
+			mrcp_host_channel_destroy(slot);
+			break;
+		case HOST_RECORD_CHANNEL_OPEN:
+			slot->channel->mrcp_version = record->value;
+			apt_string_assign_n(&slot->channel->id,data,size,slot->pool);
+			slot->responded = FALSE;
+			if(mrcp_engine_channel_virtual_open(slot->channel) == FALSE && slot->responded == FALSE) {
+				mrcp_host_event_send(host,HOST_RECORD_CHANNEL_OPEN,slot->id,FALSE,NULL,0);
+			}
+			break;
+		case HOST_RECORD_CHANNEL_CLOSE:
+			slot->responded = FALSE;
+			if(mrcp_engine_channel_virtual_close(slot->channel) == FALSE && slot->responded == FALSE) {
+				mrcp_host_event_send(host,HOST_RECORD_CHANNEL_CLOSE,slot->id,0,NULL,0);
+			}
+			break;
+		case HOST_RECORD_MESSAGE:
+		{
+			mrcp_message_t *message = mrcp_host_message_parse(host,&slot->parser,slot->pool,data,size);
+			if(message) {
+				mrcp_engine_channel_request_process(slot->channel,message);
+			}
+			break;
+		}
+		case HOST_RECORD_STREAM_OPEN:
+			if(slot->channel->termination && slot->channel->termination->audio_stream) {
+				mrcp_host_stream_open(slot,record->value,data,size);
+			}
+			break;
+		case HOST_RECORD_STREAM_CLOSE:
+			if(slot->channel->termination && slot->channel->termination->audio_stream) {
+				mrcp_host_stream_close(slot,record->value);
+			}
+			break;
+		default:
+			break;
+	}
+	return TRUE;
+}
+
+/** Write the frames of the server to the engine */
+static void mrcp_host_sink_process(mrcp_host_slot_t *slot)
+{
+	mpf_audio_stream_t *stream = slot->channel->termination->audio_stream;
+	const char *record;
+	host_frame_t header;
+	mpf_frame_t frame;
+	apr_size_t size;
+	while((record = apt_shm_ring_peek(slot->sink_ring,&size)) != NULL) {
+		memcpy(&header,record,sizeof(header));
+		frame.type = header.type;
+		frame.marker = header.marker;
+		frame.event_frame = header.event_frame;
+		frame.codec_frame.buffer = (void*)(record + sizeof(header));
+		frame.codec_frame.size = header.size;
+		stream->vtable->write_frame(stream,&frame);
+		apt_shm_ring_release(slot->sink_ring);
+	}
+}
+
+/** Read frames of the engine ahead of the server */
+static void mrcp_host_source_process(mrcp_host_slot_t *slot)
+{
+	mpf_audio_stream_t *stream = slot->channel->termination->audio_stream;
+	char *record;
+	host_frame_t header;
+	mpf_frame_t frame;
+	while(apt_shm_ring_count_get(slot->source_ring) < HOST_SOURCE_PREFILL) {
+		record = apt_shm_ring_reserve(slot->source_ring,sizeof(header) + slot->frame_size);
+		if(!record) {
+			break;
+		}
+		frame.type = MEDIA_FRAME_TYPE_NONE;
+		frame.marker = MPF_MARKER_NONE;
+		frame.codec_frame.buffer = record + sizeof(header);
+		frame.codec_frame.size = slot->frame_size;
+		memset(&frame.event_frame,0,sizeof(frame.event_frame));
+		stream->vtable->read_frame(stream,&frame);
+
+		header.type = frame.type;
+		header.marker = frame.marker;
+		header.event_frame = frame.event_frame;
+		header.size = (frame.type & MEDIA_FRAME_TYPE_AUDIO) ? (apr_uint32_t)frame.codec_frame.size : 0;
+		if(header.size > slot->frame_size) {
+			header.size = (apr_uint32_t)slot->frame_size;
+		}
+		memcpy(record,&header,sizeof(header));
+		apt_shm_ring_commit(slot->source_ring,sizeof(header) + header.size);
+	}
+}
+
+/** Check whether the worker has anything to do */
+static apt_bool_t mrcp_host_worker_is_busy(mrcp_engine_host_t *host)
+{
+	apr_size_t i;
+	mrcp_host_slot_t *slot;
+	if(apt_shm_ring_count_get(host->control_ring)) {
+		return TRUE;
+	}
+	for(i=0; i<host->slot_count; i++) {
+		slot = &host->slots[i];
+		if(slot->sink_open == TRUE && apt_shm_ring_count_get(slot->sink_ring)) {
+			return TRUE;
+		}
+		if(slot->source_open == TRUE && apt_shm_ring_count_get(slot->source_ring) < HOST_SOURCE_PREFILL) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/** Run the engine in the worker process, never returns */
+static void mrcp_host_worker_run(mrcp_engine_host_t *host, mrcp_engine_host_creator_f creator, void *obj)
+{
+	const char *data;
+	apr_size_t size;
+	apr_size_t i;
+	apr_byte_t *inline_params = NULL;
+	apr_size_t inline_param_count = 0;
+	mrcp_host_slot_t *slot;
+	mrcp_engine_t *engine;
+	pid_t server_pid = getppid();
+	apr_pool_t *pool = apt_pool_create();
+	/* the mutexes of the server are not used, as they may be held by its threads at fork */
+	if(!pool ||
+		apr_thread_mutex_create(&host->ring_mutex,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS ||
+		apr_thread_mutex_create(&host->mutex,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		_exit(1);
+	}
+
+	engine = creator(obj,pool);
+	if(!engine) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Hosted Engine [%s]",host->id);
+		mrcp_host_event_send(host,HOST_RECORD_READY,0,-1,NULL,0);
+		_exit(1);
+	}
+	engine->id = host->id;
+	engine->config = host->config;
+	engine->dir_layout = host->dir_layout;
+	engine->codec_manager = mpf_engine_codec_manager_create(pool);
+	engine->event_vtable = &host_engine_event_vtable;
+	engine->event_obj = host;
+	host->engine = engine;
+	if(engine->inline_params) {
+		inline_params = (apr_byte_t*)engine->inline_params->elts;
+		inline_param_count = engine->inline_params->nelts;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Host Engine [%s] in Process [%d]",host->id,(int)getpid());
+	mrcp_host_event_send(host,HOST_RECORD_READY,0,engine->resource_id,inline_params,inline_param_count);
+
+	for(;;) {
+		while((data = apt_shm_ring_peek(host->control_ring,&size)) != NULL) {
+			host_record_t record;
+			if(size < sizeof(record)) {
+				apt_shm_ring_release(host->control_ring);
+				continue;
+			}
+			memcpy(&record,data,sizeof(record));
+			if(mrcp_host_control_process(host,&record,data + sizeof(record),size - sizeof(record)) == FALSE) {
+				apt_shm_ring_release(host->control_ring);
+				apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Destroy Hosted Engine [%s]",host->id);
+				mrcp_engine_virtual_destroy(engine);
+				_exit(0);
+			}
+			apt_shm_ring_release(host->control_ring);
+		}
+
+		for(i=0; i<host->slot_count; i++) {
+			slot = &host->slots[i];
+			if(slot->sink_open == TRUE) {
+				mrcp_host_sink_process(slot);
+			}
+			if(slot->source_open == TRUE) {
+				mrcp_host_source_process(slot);
+			}
+		}
+
+		apt_doorbell_arm(host->worker_doorbell);
+		if(mrcp_host_worker_is_busy(host) == TRUE) {
+			apt_doorbell_wait(host->worker_doorbell,0);
+			continue;
+		}
+		if(apt_doorbell_wait(host->worker_doorbell,HOST_IDLE_TIMEOUT) == FALSE && getppid() != server_pid) {
+			/* the server is gone */
+			_exit(1);
+		}
+	}
+}
+
+
+/* ------------------------- server process ------------------------- */
+
+static apt_bool_t mrcp_proxy_engine_destroy(mrcp_engine_t *engine);
+static apt_bool_t mrcp_proxy_engine_open(mrcp_engine_t *engine);
+static apt_bool_t mrcp_proxy_engine_close(mrcp_engine_t *engine);
+static mrcp_engine_channel_t* mrcp_proxy_engine_channel_create(mrcp_engine_t *engine, apr_pool_t *pool);
+
+static const struct mrcp_engine_method_vtable_t proxy_engine_vtable = {
+	mrcp_proxy_engine_destroy,
+	mrcp_proxy_engine_open,
+	mrcp_proxy_engine_close,
+	mrcp_proxy_engine_channel_create,
+	NULL
+};
+
+static apt_bool_t mrcp_proxy_channel_destroy(mrcp_engine_channel_t *channel);
+static apt_bool_t mrcp_proxy_channel_open(mrcp_engine_channel_t *channel);
+static apt_bool_t mrcp_proxy_channel_close(mrcp_engine_channel_t *channel);
+static apt_bool_t mrcp_proxy_channel_request_process(mrcp_engine_channel_t *channel, mrcp_message_t *request);
+
+static const struct mrcp_engine_channel_method_vtable_t proxy_channel_vtable = {
+	mrcp_proxy_channel_destroy,
+	mrcp_proxy_channel_open,
+	mrcp_proxy_channel_close,
+	mrcp_proxy_channel_request_process,
+	NULL
+};
+
+static apt_bool_t mrcp_proxy_stream_open_rx(mpf_audio_stream_t *stream, mpf_codec_t *codec);
+static apt_bool_t mrcp_proxy_stream_close_rx(mpf_audio_stream_t *stream);
+static apt_bool_t mrcp_proxy_stream_read(mpf_audio_stream_t *stream, mpf_frame_t *frame);
+static apt_bool_t mrcp_proxy_stream_open_tx(mpf_audio_stream_t *stream, mpf_codec_t *codec);
+static apt_bool_t mrcp_proxy_stream_close_tx(mpf_audio_stream_t *stream);
+static apt_bool_t mrcp_proxy_stream_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame);
+
+static const mpf_audio_stream_vtable_t proxy_stream_vtable = {
+	NULL,
+	mrcp_proxy_stream_open_rx,
+	mrcp_proxy_stream_close_rx,
+	mrcp_proxy_stream_read,
+	mrcp_proxy_stream_open_tx,
+	mrcp_proxy_stream_close_tx,
+	mrcp_proxy_stream_write,
+	NULL,
+	NULL
+};
+
+/** Respond to awaited requests, once the worker is gone */
+static void mrcp_host_pending_fail(mrcp_engine_host_t *host)
+{
+	apr_size_t i;
+	mrcp_host_slot_t *slot;
+	apr_uint32_t pending;
+	apr_thread_mutex_lock(host->mutex);
+	pending = host->pending;
+	host->pending = 0;
+	apr_thread_cond_broadcast(host->cond);
+	apr_thread_mutex_unlock(host->mutex);
+	if(pending == HOST_RECORD_ENGINE_OPEN) {
+		mrcp_engine_open_respond(host->engine,FALSE);
+	}
+	else if(pending == HOST_RECORD_ENGINE_CLOSE) {
+		mrcp_engine_close_respond(host->engine);
+	}
+
+	for(i=0; i<host->slot_count; i++) {
+		slot = &host->slots[i];
+		apr_thread_mutex_lock(host->mutex);
+		pending = slot->proxy ? slot->pending : 0;
+		slot->pending = 0;
+		apr_thread_mutex_unlock(host->mutex);
+		if(pending == HOST_RECORD_CHANNEL_OPEN) {
+			mrcp_engine_channel_open_respond(slot->proxy,FALSE);
+		}
+		else if(pending == HOST_RECORD_CHANNEL_CLOSE) {
+			mrcp_engine_channel_close_respond(slot->proxy);
+		}
+	}
+}
+
+static apr_uint32_t mrcp_host_slot_pending_take(mrcp_engine_host_t *host, mrcp_host_slot_t *slot, apr_uint32_t type)
+{
+	apr_uint32_t pending;
+	apr_thread_mutex_lock(host->mutex);
+	pending = slot->proxy && slot->pending == type;
+	if(pending) {
+		slot->pending = 0;
+	}
+	apr_thread_mutex_unlock(host->mutex);
+	return pending;
+}
+
+/** Dispatch record of the worker */
+static void mrcp_host_event_process(mrcp_engine_host_t *host, const host_record_t *record, const char *data, apr_size_t size)
+{
+	mrcp_host_slot_t *slot = record->slot < host->slot_count ? &host->slots[record->slot] : NULL;
+	switch(record->type) {
+		case HOST_RECORD_ENGINE_OPEN:
+			host->pending = 0;
+			mrcp_engine_open_respond(host->engine,record->value ? TRUE : FALSE);
+			break;
+		case HOST_RECORD_ENGINE_CLOSE:
+			host->pending = 0;
+			mrcp_engine_close_respond(host->engine);
+			break;
+		case HOST_RECORD_CHANNEL_CREATE:
+			if(!slot) break;
+			apr_thread_mutex_lock(host->mutex);
+			slot->reply_status = record->value;
+			slot->reply_size = size < HOST_REPLY_SIZE ? size : HOST_REPLY_SIZE;
+			memcpy(slot->reply,data,slot->reply_size);
+			slot->replied = TRUE;
+			apr_thread_cond_broadcast(host->cond);
+			apr_thread_mutex_unlock(host->mutex);
+			break;
+		case HOST_RECORD_CHANNEL_OPEN:
+			if(slot && mrcp_host_slot_pending_take(host,slot,HOST_RECORD_CHANNEL_OPEN)) {
+				mrcp_engine_channel_open_respond(slot->proxy,record->value ? TRUE : FALSE);
+			}
+			break;
+		case HOST_RECORD_CHANNEL_CLOSE:
+			if(slot && mrcp_host_slot_pending_take(host,slot,HOST_RECORD_CHANNEL_CLOSE)) {
+				mrcp_engine_channel_close_respond(slot->proxy);
+			}
+			break;
+		case HOST_RECORD_MESSAGE:
+			if(slot && slot->proxy) {
+				mrcp_message_t *message = mrcp_host_message_parse(host,&slot->proxy_parser,slot->proxy->pool,data,size);
+				if(message) {
+					mrcp_engine_channel_message_send(slot->proxy,message);
+				}
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+/** Read records of the worker */
+static void* APR_THREAD_FUNC mrcp_host_reader_run(apr_thread_t *thread, void *data)
+{
+	mrcp_engine_host_t *host = data;
+	const char *record;
+	apr_size_t size;
+	apr_exit_why_e why;
+	int exit_code;
+	while(apr_atomic_read32(&host->running)) {
+		record = apt_shm_ring_peek(host->event_ring,&size);
+		if(record) {
+			host_record_t header;
+			if(size >= sizeof(header)) {
+				memcpy(&header,record,sizeof(header));
+				mrcp_host_event_process(host,&header,record + sizeof(header),size - sizeof(header));
+			}
+			apt_shm_ring_release(host->event_ring);
+			continue;
+		}
+
+		apt_doorbell_arm(host->server_doorbell);
+		if(apt_shm_ring_count_get(host->event_ring)) {
+			apt_doorbell_wait(host->server_doorbell,0);
+			continue;
+		}
+		if(apt_doorbell_wait(host->server_doorbell,HOST_IDLE_TIMEOUT) == FALSE &&
+			apr_proc_wait(&host->proc,&exit_code,&why,APR_NOWAIT) == APR_CHILD_DONE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_ERROR,"Process [%d] of Hosted Engine [%s] Is Gone [%s %d]",
+				(int)host->proc.pid,
+				host->id,
+				APR_PROC_CHECK_EXIT(why) ? "exit" : "signal",
+				exit_code);
+			apr_atomic_set32(&host->alive,0);
+			mrcp_host_pending_fail(host);
+			break;
+		}
+	}
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+/** Stop the worker and release shared resources */
+static apr_status_t mrcp_host_stop(void *data)
+{
+	mrcp_engine_host_t *host = data;
+	apr_exit_why_e why;
+	int exit_code;
+	apr_status_t rv;
+	int i;
+	if(host->stopped == TRUE) {
+		return APR_SUCCESS;
+	}
+	host->stopped = TRUE;
+	if(host->reader) {
+		apr_atomic_set32(&host->running,0);
+		apt_doorbell_arm(host->server_doorbell);
+		apt_doorbell_ring(host->server_doorbell);
+		apr_thread_join(&rv,host->reader);
+		host->reader = NULL;
+	}
+	if(mrcp_host_is_alive(host) == TRUE) {
+		mrcp_host_control_send(host,HOST_RECORD_ENGINE_DESTROY,0,0,NULL,0);
+		apr_atomic_set32(&host->alive,0);
+		/* give the engine a while to destroy itself */
+		for(i=0; i<20; i++) {
+			if(apr_proc_wait(&host->proc,&exit_code,&why,APR_NOWAIT) == APR_CHILD_DONE) {
+				break;
+			}
+			apr_sleep(HOST_REPLY_TIMEOUT / 20);
+		}
+		if(i == 20) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Kill Process [%d] of Hosted Engine [%s]",(int)host->proc.pid,host->id);
+			apr_proc_kill(&host->proc,SIGKILL);
+			apr_proc_wait(&host->proc,&exit_code,&why,APR_WAIT);
+		}
+	}
+	apt_doorbell_destroy(host->worker_doorbell);
+	apt_doorbell_destroy(host->server_doorbell);
+	apr_shm_destroy(host->shm);
+	return APR_SUCCESS;
+}
+
+static apt_bool_t mrcp_proxy_engine_destroy(mrcp_engine_t *engine)
+{
+	mrcp_host_stop(engine->obj);
+	return TRUE;
+}
+
+static apt_bool_t mrcp_proxy_engine_open(mrcp_engine_t *engine)
+{
+	mrcp_engine_host_t *host = engine->obj;
+	host->pending = HOST_RECORD_ENGINE_OPEN;
+	if(mrcp_host_control_send(host,HOST_RECORD_ENGINE_OPEN,0,0,NULL,0) == FALSE) {
+		host->pending = 0;
+		return mrcp_engine_open_respond(engine,FALSE);
+	}
+	return TRUE;
+}
+
+static apt_bool_t mrcp_proxy_engine_close(mrcp_engine_t *engine)
+{
+	mrcp_engine_host_t *host = engine->obj;
+	host->pending = HOST_RECORD_ENGINE_CLOSE;
+	if(mrcp_host_control_send(host,HOST_RECORD_ENGINE_CLOSE,0,0,NULL,0) == FALSE) {
+		host->pending = 0;
+		return mrcp_engine_close_respond(engine);
+	}
+	return TRUE;
+}
+
+/** Restore stream capabilities of the reply to channel create */
+static mpf_stream_capabilities_t* mrcp_proxy_capabilities_parse(const char *buf, apr_size_t size, apr_pool_t *pool)
+{
+	mpf_stream_capabilities_t *capabilities;
+	apr_uint32_t direction;
+	apr_uint32_t named_events;
+	apr_uint32_t count;
+	apr_uint32_t sample_rates;
+	apr_size_t pos = 3 * sizeof(apr_uint32_t);
+	apr_size_t length;
+	if(size < pos) {
+		return NULL;
+	}
+	memcpy(&direction,buf,sizeof(direction));
+	memcpy(&named_events,buf + sizeof(direction),sizeof(named_events));
+	memcpy(&count,buf + 2 * sizeof(count),sizeof(count));
+	capabilities = mpf_stream_capabilities_create(direction,pool);
+	capabilities->codecs.allow_named_events = named_events ? TRUE : FALSE;
+	while(count-- && pos + sizeof(sample_rates) + 1 < size) {
+		mpf_codec_attribs_t *attribs;
+		memcpy(&sample_rates,buf + pos,sizeof(sample_rates));
+		pos += sizeof(sample_rates);
+		length = strnlen(buf + pos + 1,size - pos - 1);
+		if(pos + 1 + length >= size) {
+			break;
+		}
+		mpf_codec_capabilities_add(&capabilities->codecs,sample_rates,buf + pos + 1);
+		attribs = &APR_ARRAY_IDX(capabilities->codecs.attrib_arr,capabilities->codecs.attrib_arr->nelts - 1,mpf_codec_attribs_t);
+		attribs->bits_per_sample = (apr_byte_t)buf[pos];
+		pos += 1 + length + 1;
+	}
+	return capabilities;
+}
+
+static mrcp_engine_channel_t* mrcp_proxy_engine_channel_create(mrcp_engine_t *engine, apr_pool_t *pool)
+{
+	mrcp_engine_host_t *host = engine->obj;
+	mrcp_host_slot_t *slot = NULL;
+	mrcp_engine_channel_t *channel;
+	mpf_termination_t *termination = NULL;
+	apr_time_t deadline;
+	apr_size_t i;
+
+	apr_thread_mutex_lock(host->mutex);
+	for(i=0; i<host->slot_count; i++) {
+		if(host->slots[i].in_use == FALSE) {
+			slot = &host->slots[i];
+			slot->in_use = TRUE;
+			slot->replied = FALSE;
+			slot->pending = 0;
+			break;
+		}
+	}
+	apr_thread_mutex_unlock(host->mutex);
+	if(!slot) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Free Slot of Hosted Engine [%s]",host->id);
+		return NULL;
+	}
+
+	/* frames left of the previous channel are not read */
+	apt_shm_ring_discard(slot->source_ring);
+	if(mrcp_host_control_send(host,HOST_RECORD_CHANNEL_CREATE,slot->id,0,NULL,0) == FALSE) {
+		slot->in_use = FALSE;
+		return NULL;
+	}
+
+	/* channels are created synchronously, as the capabilities of the stream are needed by the server */
+	deadline = apr_time_now() + HOST_REPLY_TIMEOUT;
+	apr_thread_mutex_lock(host->mutex);
+	while(slot->replied == FALSE && mrcp_host_is_alive(host) == TRUE && apr_time_now() < deadline) {
+		apr_thread_cond_timedwait(host->cond,host->mutex,deadline - apr_time_now());
+	}
+	apr_thread_mutex_unlock(host->mutex);
+	if(slot->replied == FALSE || !slot->reply_status) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Channel of Hosted Engine [%s]",host->id);
+		if(slot->replied == TRUE) {
+			slot->in_use = FALSE;
+		}
+		/* otherwise the slot is not reused, as the reply may still come */
+		return NULL;
+	}
+
+	if(slot->reply_size) {
+		mpf_stream_capabilities_t *capabilities = mrcp_proxy_capabilities_parse(slot->reply,slot->reply_size,pool);
+		if(capabilities) {
+			termination = mrcp_engine_audio_termination_create(slot,&proxy_stream_vtable,capabilities,pool);
+		}
+	}
+	channel = mrcp_engine_channel_create(engine,&proxy_channel_vtable,slot,termination,pool);
+	if(!channel) {
+		mrcp_host_control_send(host,HOST_RECORD_CHANNEL_DESTROY,slot->id,0,NULL,0);
+		slot->in_use = FALSE;
+		return NULL;
+	}
+	slot->proxy_parser = mrcp_parser_create(host->resource_factory,pool);
+	slot->proxy_generator = mrcp_generator_create(host->resource_factory,pool);
+	apr_thread_mutex_lock(host->mutex);
+	slot->proxy = channel;
+	apr_thread_mutex_unlock(host->mutex);
+	return channel;
+}
+
+static apt_bool_t mrcp_proxy_channel_destroy(mrcp_engine_channel_t *channel)
+{
+	mrcp_host_slot_t *slot = channel->method_obj;
+	mrcp_engine_host_t *host = channel->engine->obj;
+	mrcp_host_control_send(host,HOST_RECORD_CHANNEL_DESTROY,slot->id,0,NULL,0);
+	apr_thread_mutex_lock(host->mutex);
+	slot->proxy = NULL;
+	slot->pending = 0;
+	slot->in_use = FALSE;
+	apr_thread_mutex_unlock(host->mutex);
+	return TRUE;
+}
+
+static apt_bool_t mrcp_proxy_channel_open(mrcp_engine_channel_t *channel)
+{
+	mrcp_host_slot_t *slot = channel->method_obj;
+	mrcp_engine_host_t *host = channel->engine->obj;
+	slot->pending = HOST_RECORD_CHANNEL_OPEN;
+	if(mrcp_host_control_send(host,HOST_RECORD_CHANNEL_OPEN,slot->id,channel->mrcp_version,channel->id.buf,channel->id.length) == FALSE) {
+		slot->pending = 0;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t mrcp_proxy_channel_close(mrcp_engine_channel_t *channel)
+{
+	mrcp_host_slot_t *slot = channel->method_obj;
+	mrcp_engine_host_t *host = channel->engine->obj;
+	slot->pending = HOST_RECORD_CHANNEL_CLOSE;
+	if(mrcp_host_control_send(host,HOST_RECORD_CHANNEL_CLOSE,slot->id,0,NULL,0) == FALSE) {
+		slot->pending = 0;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t mrcp_proxy_channel_request_process(mrcp_engine_channel_t *channel, mrcp_message_t *request)
+{
+	mrcp_host_slot_t *slot = channel->method_obj;
+	mrcp_engine_host_t *host = channel->engine->obj;
+	return mrcp_host_message_send(host,slot,slot->proxy_generator,request,TRUE);
+}
+
+/** Pass the codec of the stream to the worker */
+static apt_bool_t mrcp_proxy_stream_open(mpf_audio_stream_t *stream, mpf_stream_direction_e direction, const mpf_codec_descriptor_t *descriptor)
+{
+	mrcp_host_slot_t *slot = stream->obj;
+	mrcp_engine_host_t *host = slot->proxy->engine->obj;
+	host_stream_t info;
+	if(!descriptor) {
+		return FALSE;
+	}
+	/* encoded frames never exceed linear ones */
+	info.frame_size = (apr_uint32_t)mpf_codec_linear_frame_size_calculate(descriptor->sampling_rate,descriptor->channel_count);
+	info.sampling_rate = descriptor->sampling_rate;
+	info.channel_count = descriptor->channel_count;
+	info.payload_type = descriptor->payload_type;
+	return mrcp_host_record_send(host,host->control_ring,host->worker_doorbell,HOST_RECORD_STREAM_OPEN,slot->id,direction,
+				&info,sizeof(info),
+				descriptor->name.buf,descriptor->name.length,
+				NULL,0);
+}
+
+static apt_bool_t mrcp_proxy_stream_open_rx(mpf_audio_stream_t *stream, mpf_codec_t *codec)
+{
+	mrcp_host_slot_t *slot = stream->obj;
+	/* the frames of the previous open, if any, are stale */
+	apt_shm_ring_discard(slot->source_ring);
+	return mrcp_proxy_stream_open(stream,STREAM_DIRECTION_RECEIVE,stream->rx_descriptor);
+}
+
+static apt_bool_t mrcp_proxy_stream_close_rx(mpf_audio_stream_t *stream)
+{
+	mrcp_host_slot_t *slot = stream->obj;
+	mrcp_engine_host_t *host = slot->proxy->engine->obj;
+	return mrcp_host_control_send(host,HOST_RECORD_STREAM_CLOSE,slot->id,STREAM_DIRECTION_RECEIVE,NULL,0);
+}
+
+static apt_bool_t mrcp_proxy_stream_read(mpf_audio_stream_t *stream, mpf_frame_t *frame)
+{
+	mrcp_host_slot_t *slot = stream->obj;
+	mrcp_engine_host_t *host = slot->proxy->engine->obj;
+	host_frame_t header;
+	apr_size_t size;
+	const char *record = apt_shm_ring_peek(slot->source_ring,&size);
+	if(!record) {
+		/* the engine is late, silence goes out */
+		return TRUE;
+	}
+	memcpy(&header,record,sizeof(header));
+	frame->type = header.type;
+	frame->marker = header.marker;
+	frame->event_frame = header.event_frame;
+	if(header.size) {
+		if(header.size < frame->codec_frame.size) {
+			frame->codec_frame.size = header.size;
+		}
+		memcpy(frame->codec_frame.buffer,record + sizeof(header),frame->codec_frame.size);
+	}
+	apt_shm_ring_release(slot->source_ring);
+	/* the worker reads the next frame ahead */
+	apt_doorbell_ring(host->worker_doorbell);
+	return TRUE;
+}
+
+static apt_bool_t mrcp_proxy_stream_open_tx(mpf_audio_stream_t *stream, mpf_codec_t *codec)
+{
+	return mrcp_proxy_stream_open(stream,STREAM_DIRECTION_SEND,stream->tx_descriptor);
+}
+
+static apt_bool_t mrcp_proxy_stream_close_tx(mpf_audio_stream_t *stream)
+{
+	mrcp_host_slot_t *slot = stream->obj;
+	mrcp_engine_host_t *host = slot->proxy->engine->obj;
+	return mrcp_host_control_send(host,HOST_RECORD_STREAM_CLOSE,slot->id,STREAM_DIRECTION_SEND,NULL,0);
+}
+
+static apt_bool_t mrcp_proxy_stream_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame)
+{
+	mrcp_host_slot_t *slot = stream->obj;
+	mrcp_engine_host_t *host = slot->proxy->engine->obj;
+	host_frame_t *header;
+	apr_size_t size = (frame->type & MEDIA_FRAME_TYPE_AUDIO) ? frame->codec_frame.size : 0;
+	char *record = apt_shm_ring_reserve(slot->sink_ring,sizeof(host_frame_t) + size);
+	if(!record) {
+		/* the engine is stuck, the frame is dropped rather than the media processing stalled */
+		return FALSE;
+	}
+	header = (host_frame_t*)record;
+	header->type = frame->type;
+	header->marker = frame->marker;
+	header->event_frame = frame->event_frame;
+	header->size = (apr_uint32_t)size;
+	if(size) {
+		memcpy(record + sizeof(host_frame_t),frame->codec_frame.buffer,size);
+	}
+	apt_shm_ring_commit(slot->sink_ring,sizeof(host_frame_t) + size);
+	apt_doorbell_ring(host->worker_doorbell);
+	return TRUE;
+}
+
+/** Lay out the rings in shared memory */
+static apt_bool_t mrcp_host_memory_create(mrcp_engine_host_t *host)
+{
+	apr_size_t doorbell_size = APR_ALIGN(apt_doorbell_size_get(),64);
+	apr_size_t message_ring_size = apt_shm_ring_size_get(HOST_MESSAGE_RING_SIZE);
+	apr_size_t audio_ring_size = apt_shm_ring_size_get(HOST_AUDIO_RING_SIZE);
+	apr_size_t size = 2 * doorbell_size + 2 * message_ring_size + host->slot_count * 2 * audio_ring_size;
+	char *mem;
+	apr_size_t i;
+	if(apr_shm_create(&host->shm,size,NULL,host->pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Shared Memory [%"APR_SIZE_T_FMT" bytes] of Hosted Engine [%s]",size,host->id);
+		return FALSE;
+	}
+	mem = apr_shm_baseaddr_get(host->shm);
+	host->worker_doorbell = apt_doorbell_create(mem);
+	mem += doorbell_size;
+	host->server_doorbell = apt_doorbell_create(mem);
+	mem += doorbell_size;
+	if(!host->worker_doorbell || !host->server_doorbell) {
+		if(host->worker_doorbell) {
+			apt_doorbell_destroy(host->worker_doorbell);
+		}
+		apr_shm_destroy(host->shm);
+		return FALSE;
+	}
+	host->control_ring = apt_shm_ring_create(mem,HOST_MESSAGE_RING_SIZE);
+	mem += message_ring_size;
+	host->event_ring = apt_shm_ring_create(mem,HOST_MESSAGE_RING_SIZE);
+	mem += message_ring_size;
+
+	host->slots = apr_pcalloc(host->pool,sizeof(mrcp_host_slot_t) * host->slot_count);
+	for(i=0; i<host->slot_count; i++) {
+		mrcp_host_slot_t *slot = &host->slots[i];
+		slot->id = (apr_uint16_t)i;
+		slot->sink_ring = apt_shm_ring_create(mem,HOST_AUDIO_RING_SIZE);
+		mem += audio_ring_size;
+		slot->source_ring = apt_shm_ring_create(mem,HOST_AUDIO_RING_SIZE);
+		mem += audio_ring_size;
+		slot->buffer = apr_palloc(host->pool,HOST_HEADER_BUFFER_SIZE);
+	}
+	return TRUE;
+}
+
+/** Wait for the worker to create the engine */
+static apt_bool_t mrcp_host_ready_wait(mrcp_engine_host_t *host, mrcp_resource_id *resource_id, apr_array_header_t **inline_params)
+{
+	apr_time_t deadline = apr_time_now() + HOST_REPLY_TIMEOUT;
+	host_record_t header;
+	const char *record;
+	apr_size_t size;
+	apr_exit_why_e why;
+	int exit_code;
+	while((record = apt_shm_ring_peek(host->event_ring,&size)) == NULL) {
+		if(apr_proc_wait(&host->proc,&exit_code,&why,APR_NOWAIT) == APR_CHILD_DONE) {
+			/* reaped already */
+			apr_atomic_set32(&host->alive,0);
+			return FALSE;
+		}
+		if(apr_time_now() > deadline) {
+			return FALSE;
+		}
+		apt_doorbell_arm(host->server_doorbell);
+		if(apt_shm_ring_count_get(host->event_ring) == 0) {
+			apt_doorbell_wait(host->server_doorbell,HOST_REPLY_TIMEOUT / 50);
+		}
+		else {
+			apt_doorbell_wait(host->server_doorbell,0);
+		}
+	}
+
+	memcpy(&header,record,sizeof(header));
+	if(size < sizeof(header) || header.type != HOST_RECORD_READY || header.value < 0) {
+		apt_shm_ring_release(host->event_ring);
+		return FALSE;
+	}
+	*resource_id = header.value;
+	*inline_params = NULL;
+	if(size > sizeof(header)) {
+		*inline_params = apr_array_make(host->pool,(int)(size - sizeof(header)),sizeof(apr_byte_t));
+		memcpy((*inline_params)->elts,record + sizeof(header),size - sizeof(header));
+		(*inline_params)->nelts = (int)(size - sizeof(header));
+	}
+	apt_shm_ring_release(host->event_ring);
+	return TRUE;
+}
+
+/** Create proxy of engine hosted in a worker process */
+MRCP_DECLARE(mrcp_engine_t*) mrcp_engine_host_create(
+								const char *id,
+								mrcp_engine_config_t *config,
+								const mrcp_resource_factory_t *resource_factory,
+								const apt_dir_layout_t *dir_layout,
+								mrcp_engine_host_creator_f creator,
+								void *obj,
+								apr_pool_t *pool)
+{
+	mrcp_engine_host_t *host;
+	mrcp_engine_config_t *proxy_config;
+	mrcp_resource_id resource_id;
+	apr_array_header_t *inline_params;
+	apr_status_t rv;
+	mrcp_engine_t *engine;
+	if(!resource_factory || !creator) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Host Engine [%s]: no resource factory",id);
+		return NULL;
+	}
+
+	host = apr_pcalloc(pool,sizeof(mrcp_engine_host_t));
+	host->id = id;
+	host->config = config;
+	host->resource_factory = resource_factory;
+	host->dir_layout = dir_layout;
+	host->pool = pool;
+	host->slot_count = config->max_channel_count ? config->max_channel_count : HOST_DEFAULT_SLOT_COUNT;
+	if(host->slot_count > 0xFFFF) {
+		host->slot_count = 0xFFFF;
+	}
+	if(mrcp_host_memory_create(host) == FALSE) {
+		return NULL;
+	}
+	host->alive = 1;
+
+	rv = apr_proc_fork(&host->proc,pool);
+	if(rv == APR_INCHILD) {
+		mrcp_host_worker_run(host,creator,obj);
+		_exit(1);
+	}
+	if(rv != APR_INPARENT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Fork Process of Hosted Engine [%s]",id);
+		apt_doorbell_destroy(host->worker_doorbell);
+		apt_doorbell_destroy(host->server_doorbell);
+		apr_shm_destroy(host->shm);
+		return NULL;
+	}
+
+	apr_thread_mutex_create(&host->ring_mutex,APR_THREAD_MUTEX_DEFAULT,pool);
+	apr_thread_mutex_create(&host->mutex,APR_THREAD_MUTEX_DEFAULT,pool);
+	apr_thread_cond_create(&host->cond,pool);
+	apr_pool_cleanup_register(pool,host,mrcp_host_stop,apr_pool_cleanup_null);
+	if(mrcp_host_ready_wait(host,&resource_id,&inline_params) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Start Process [%d] of Hosted Engine [%s]",(int)host->proc.pid,id);
+		return NULL;
+	}
+
+	engine = mrcp_engine_create(resource_id,host,&proxy_engine_vtable,pool);
+	engine->id = id;
+	engine->inline_params = inline_params;
+	/* idle channels, caches and pre-roll belong to the hosted engine */
+	proxy_config = apr_palloc(pool,sizeof(mrcp_engine_config_t));
+	*proxy_config = *config;
+	proxy_config->min_idle_channels = 0;
+	proxy_config->grammar_cache_size = 0;
+	proxy_config->prompt_cache_size = 0;
+	proxy_config->voiceprint_cache_size = 0;
+	if(config->params) {
+		proxy_config->params = apr_table_copy(pool,config->params);
+		apr_table_unset(proxy_config->params,"preroll");
+	}
+	engine->config = proxy_config;
+	host->engine = engine;
+
+	host->running = 1;
+	if(apr_thread_create(&host->reader,NULL,mrcp_host_reader_run,host,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Reader Thread of Hosted Engine [%s]",id);
+		host->reader = NULL;
+		return NULL;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Host Engine [%s] in Process [%d] with [%"APR_SIZE_T_FMT"] Channels",
+		id,(int)host->proc.pid,host->slot_count);
+	return engine;
+}
+
+#else
+
+/** Create proxy of engine hosted in a worker process */
+MRCP_DECLARE(mrcp_engine_t*) mrcp_engine_host_create(
+								const char *id,
+								mrcp_engine_config_t *config,
+								const mrcp_resource_factory_t *resource_factory,
+								const apt_dir_layout_t *dir_layout,
+								mrcp_engine_host_creator_f creator,
+								void *obj,
+								apr_pool_t *pool)
+{
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Host Engine [%s]: not supported",id);
+	return NULL;
+}
+
+#endif
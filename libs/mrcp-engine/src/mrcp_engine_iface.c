@@ -16,12 +16,136 @@
  * $Id$
  */
 
+#include <apr_atomic.h>
+#include <apr_thread_proc.h>
 #include "mrcp_engine_iface.h"
+#include "mrcp_resource.h"
+#include "mrcp_recog_resource.h"
+#include "mrcp_synth_resource.h"
+#include "mrcp_verifier_resource.h"
+#include "mrcp_verifier_header.h"
+#include "apt_text_stream.h"
+#include "apt_pool.h"
 #include "apt_log.h"
 
+/** Create reusable channel in own pool, which outlives the session */
+static mrcp_engine_channel_t* mrcp_engine_recyclable_channel_create(mrcp_engine_t *engine)
+{
+	mrcp_engine_channel_t *channel;
+	apr_pool_t *pool = apt_pool_create();
+	if(!pool) {
+		return NULL;
+	}
+	apt_pool_owner_set(pool,APT_POOL_OWNER_CHANNEL);
+	channel = engine->method_vtable->create_channel(engine,pool);
+	if(!channel) {
+		apr_pool_destroy(pool);
+		return NULL;
+	}
+	channel->recycle_pool = pool;
+	return channel;
+}
+
+/** Destroy channel and its own pool, if any */
+static apt_bool_t mrcp_engine_channel_release(mrcp_engine_channel_t *channel)
+{
+	apr_pool_t *pool = channel->recycle_pool;
+	apt_bool_t status;
+	if(pool) {
+		/* account the memory the channel has grown to by the end of its life */
+		apt_pool_account_update(pool);
+	}
+	status = channel->method_vtable->destroy(channel);
+	if(pool) {
+		apr_pool_destroy(pool);
+	}
+	return status;
+}
+
+/** Create idle channels in advance, if configured and supported by engine */
+static void mrcp_engine_idle_channels_create(mrcp_engine_t *engine)
+{
+	mrcp_engine_channel_t *channel;
+	apr_size_t count = engine->config ? engine->config->min_idle_channels : 0;
+	if(!count) {
+		return;
+	}
+	if(engine->config->max_channel_count && count > engine->config->max_channel_count) {
+		count = engine->config->max_channel_count;
+	}
+
+	channel = mrcp_engine_recyclable_channel_create(engine);
+	if(!channel) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Idle Channel for Engine [%s]",engine->id);
+		return;
+	}
+	if(!channel->method_vtable->reset) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Channels of Engine [%s] cannot be reset, ignore min-idle-channels",engine->id);
+		mrcp_engine_channel_release(channel);
+		return;
+	}
+
+	if(!engine->idle_channels) {
+		if(apr_thread_mutex_create(&engine->idle_mutex,APR_THREAD_MUTEX_DEFAULT,engine->pool) != APR_SUCCESS) {
+			mrcp_engine_channel_release(channel);
+			return;
+		}
+		engine->idle_channels = apr_array_make(engine->pool,(int)count,sizeof(mrcp_engine_channel_t*));
+	}
+
+	apr_thread_mutex_lock(engine->idle_mutex);
+	APR_ARRAY_PUSH(engine->idle_channels,mrcp_engine_channel_t*) = channel;
+	while((apr_size_t)engine->idle_channels->nelts < count) {
+		channel = mrcp_engine_recyclable_channel_create(engine);
+		if(!channel) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Idle Channel for Engine [%s]",engine->id);
+			break;
+		}
+		APR_ARRAY_PUSH(engine->idle_channels,mrcp_engine_channel_t*) = channel;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Created %d Idle Channel(s) for Engine [%s]",
+		engine->idle_channels->nelts,
+		engine->id);
+	apr_thread_mutex_unlock(engine->idle_mutex);
+}
+
+/** Destroy idle channels */
+static void mrcp_engine_idle_channels_destroy(mrcp_engine_t *engine)
+{
+	mrcp_engine_channel_t **channel;
+	if(!engine->idle_channels) {
+		return;
+	}
+	apr_thread_mutex_lock(engine->idle_mutex);
+	while((channel = apr_array_pop(engine->idle_channels)) != NULL) {
+		mrcp_engine_channel_release(*channel);
+	}
+	apr_thread_mutex_unlock(engine->idle_mutex);
+}
+
 /** Destroy engine */
 apt_bool_t mrcp_engine_virtual_destroy(mrcp_engine_t *engine)
 {
+	if(engine->grammar_cache) {
+		mrcp_grammar_cache_destroy(engine->grammar_cache);
+		engine->grammar_cache = NULL;
+	}
+	if(engine->prompt_cache) {
+		mrcp_prompt_cache_destroy(engine->prompt_cache);
+		engine->prompt_cache = NULL;
+	}
+	if(engine->voiceprint_cache) {
+		mrcp_voiceprint_cache_destroy(engine->voiceprint_cache);
+		engine->voiceprint_cache = NULL;
+	}
+	if(engine->audio_batch) {
+		mrcp_audio_batch_destroy(engine->audio_batch);
+		engine->audio_batch = NULL;
+	}
+	if(engine->request_batch) {
+		mrcp_request_batch_destroy(engine->request_batch);
+		engine->request_batch = NULL;
+	}
 	return engine->method_vtable->destroy(engine);
 }
 
@@ -30,6 +154,31 @@ apt_bool_t mrcp_engine_virtual_open(mrcp_engine_t *engine)
 {
 	if(engine->is_open == FALSE) {
 		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Open Engine [%s]",engine->id);
+		if(!engine->grammar_cache && engine->config && engine->config->grammar_cache_size) {
+			engine->grammar_cache = mrcp_grammar_cache_create(engine->config->grammar_cache_size,engine->pool);
+		}
+		if(!engine->prompt_cache && engine->resource_id == MRCP_SYNTHESIZER_RESOURCE &&
+			engine->config && engine->config->prompt_cache_size) {
+			engine->prompt_cache = mrcp_prompt_cache_create(engine->config->prompt_cache_size,engine->pool);
+		}
+		if(!engine->voiceprint_cache && engine->voiceprint_loader &&
+			engine->config && engine->config->voiceprint_cache_size) {
+			engine->voiceprint_cache = mrcp_voiceprint_cache_create(
+											engine->config->voiceprint_cache_size,
+											engine->voiceprint_loader,
+											engine->executor,
+											engine->pool);
+		}
+		if(!engine->audio_batch && engine->method_vtable->process_batch) {
+			engine->audio_batch = mrcp_audio_batch_create(engine,engine->executor);
+			if(!engine->audio_batch) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Audio Batch of Engine [%s]",engine->id);
+			}
+		}
+		if(!engine->request_batch && engine->method_vtable->process_requests) {
+			/* with no batch, requests are delivered by process_request of each channel */
+			engine->request_batch = mrcp_request_batch_create(engine);
+		}
 		return engine->method_vtable->open(engine);
 	}
 	return FALSE;
@@ -42,6 +191,131 @@ void mrcp_engine_on_open(mrcp_engine_t *engine, apt_bool_t status)
 		engine->id,
 		status == TRUE ? "success" : "failure");
 	engine->is_open = status;
+	if(status == TRUE) {
+		mrcp_engine_idle_channels_create(engine);
+	}
+}
+
+/** Prepare engine to be opened in background */
+apt_bool_t mrcp_engine_background_open_init(mrcp_engine_t *engine)
+{
+	if(engine->open_mutex) {
+		return TRUE;
+	}
+	if(apr_thread_mutex_create(&engine->open_mutex,APR_THREAD_MUTEX_DEFAULT,engine->pool) != APR_SUCCESS) {
+		engine->open_mutex = NULL;
+		return FALSE;
+	}
+	if(apr_thread_cond_create(&engine->open_cond,engine->pool) != APR_SUCCESS) {
+		apr_thread_mutex_destroy(engine->open_mutex);
+		engine->open_mutex = NULL;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Thread engine is opened in background by */
+static void* APR_THREAD_FUNC mrcp_engine_open_thread_run(apr_thread_t *thread, void *data)
+{
+	mrcp_engine_t *engine = data;
+	if(mrcp_engine_virtual_open(engine) == FALSE) {
+		/* no response is expected */
+		mrcp_engine_background_open_respond(engine,FALSE);
+	}
+	return NULL;
+}
+
+/** Open engine in background by a thread of its own */
+apt_bool_t mrcp_engine_background_open(mrcp_engine_t *engine)
+{
+	apr_threadattr_t *attr = NULL;
+	apr_thread_t *thread;
+	if(!engine->open_mutex) {
+		return FALSE;
+	}
+
+	apr_thread_mutex_lock(engine->open_mutex);
+	if(engine->is_open == TRUE || engine->open_pending == TRUE) {
+		apr_thread_mutex_unlock(engine->open_mutex);
+		return TRUE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Open Engine in Background [%s]",engine->id);
+	engine->open_pending = TRUE;
+	engine->open_time = apr_time_now();
+	/* no one joins the thread, the response is waited for instead */
+	if(apr_threadattr_create(&attr,engine->pool) == APR_SUCCESS) {
+		apr_threadattr_detach_set(attr,1);
+	}
+	if(apr_thread_create(&thread,attr,mrcp_engine_open_thread_run,engine,engine->pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Thread to Open Engine [%s]",engine->id);
+		engine->open_pending = FALSE;
+		apr_thread_cond_broadcast(engine->open_cond);
+		apr_thread_mutex_unlock(engine->open_mutex);
+		return FALSE;
+	}
+	apr_thread_mutex_unlock(engine->open_mutex);
+	return TRUE;
+}
+
+/** Process response to open in background */
+apt_bool_t mrcp_engine_background_open_respond(mrcp_engine_t *engine, apt_bool_t status)
+{
+	if(!engine->open_mutex) {
+		return FALSE;
+	}
+
+	apr_thread_mutex_lock(engine->open_mutex);
+	if(engine->open_pending == FALSE) {
+		/* opened by the host task */
+		apr_thread_mutex_unlock(engine->open_mutex);
+		return FALSE;
+	}
+	apr_thread_mutex_unlock(engine->open_mutex);
+
+	/* idle channels are created by the responding thread, the engine is not used by channels yet */
+	mrcp_engine_on_open(engine,status);
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,
+		"Engine Opened in Background [%s] status [%s] in %"APR_TIME_T_FMT" msec",
+		engine->id,
+		status == TRUE ? "success" : "failure",
+		apr_time_as_msec(apr_time_now() - engine->open_time));
+
+	apr_thread_mutex_lock(engine->open_mutex);
+	engine->open_pending = FALSE;
+	apr_thread_cond_broadcast(engine->open_cond);
+	apr_thread_mutex_unlock(engine->open_mutex);
+	return TRUE;
+}
+
+/** Wait for open in background to complete */
+apt_bool_t mrcp_engine_background_open_wait(mrcp_engine_t *engine, apr_interval_time_t timeout)
+{
+	apt_bool_t status;
+	if(!engine->open_mutex) {
+		return engine->is_open;
+	}
+
+	apr_thread_mutex_lock(engine->open_mutex);
+	while(engine->open_pending == TRUE) {
+		if(timeout < 0) {
+			apr_thread_cond_wait(engine->open_cond,engine->open_mutex);
+		}
+		else if(apr_thread_cond_timedwait(engine->open_cond,engine->open_mutex,timeout) == APR_TIMEUP) {
+			break;
+		}
+	}
+	status = engine->is_open;
+	apr_thread_mutex_unlock(engine->open_mutex);
+	return status;
+}
+
+/** Deliver the requests batched so far */
+apt_bool_t mrcp_engine_requests_flush(mrcp_engine_t *engine)
+{
+	if(!engine->request_batch) {
+		return FALSE;
+	}
+	return mrcp_request_batch_flush(engine->request_batch);
 }
 
 /** Close engine */
@@ -50,6 +324,8 @@ apt_bool_t mrcp_engine_virtual_close(mrcp_engine_t *engine)
 	if(engine->is_open == TRUE) {
 		engine->is_open = FALSE;
 		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Close Engine [%s]",engine->id);
+		mrcp_engine_requests_flush(engine);
+		mrcp_engine_idle_channels_destroy(engine);
 		return engine->method_vtable->close(engine);
 	}
 	return FALSE;
@@ -66,19 +342,38 @@ void mrcp_engine_on_close(mrcp_engine_t *engine)
 mrcp_engine_channel_t* mrcp_engine_channel_virtual_create(mrcp_engine_t *engine, mrcp_version_e mrcp_version, apr_pool_t *pool)
 {
 	mrcp_engine_channel_t *channel;
+	apr_uint32_t count;
 	if(engine->is_open != TRUE) {
 		return NULL;
 	}
-	if(engine->config->max_channel_count && engine->cur_channel_count >= engine->config->max_channel_count) {
+	/* reserve the channel first, channels may be created by several server workers at once */
+	count = apr_atomic_inc32(&engine->cur_channel_count);
+	if(engine->config->max_channel_count && count >= engine->config->max_channel_count) {
+		apr_atomic_dec32(&engine->cur_channel_count);
 		apt_log(APT_LOG_MARK, APT_PRIO_NOTICE, "Maximum channel count %"APR_SIZE_T_FMT" exceeded for engine [%s]",
 			engine->config->max_channel_count, engine->id);
 		return NULL;
 	}
-	channel = engine->method_vtable->create_channel(engine,pool);
-	if(channel) {
-		channel->mrcp_version = mrcp_version;
-		engine->cur_channel_count++;
+	if(engine->idle_channels) {
+		/* take an idle channel, if any, instead of creating a new one */
+		channel = NULL;
+		apr_thread_mutex_lock(engine->idle_mutex);
+		if(engine->idle_channels->nelts) {
+			channel = *(mrcp_engine_channel_t**)apr_array_pop(engine->idle_channels);
+		}
+		apr_thread_mutex_unlock(engine->idle_mutex);
+		if(!channel) {
+			channel = mrcp_engine_recyclable_channel_create(engine);
+		}
+	}
+	else {
+		channel = engine->method_vtable->create_channel(engine,pool);
+	}
+	if(!channel) {
+		apr_atomic_dec32(&engine->cur_channel_count);
+		return NULL;
 	}
+	channel->mrcp_version = mrcp_version;
 	return channel;
 }
 
@@ -86,10 +381,232 @@ mrcp_engine_channel_t* mrcp_engine_channel_virtual_create(mrcp_engine_t *engine,
 apt_bool_t mrcp_engine_channel_virtual_destroy(mrcp_engine_channel_t *channel)
 {
 	mrcp_engine_t *engine = channel->engine;
-	if(engine->cur_channel_count) {
-		engine->cur_channel_count--;
+	if(apr_atomic_read32(&engine->cur_channel_count)) {
+		apr_atomic_dec32(&engine->cur_channel_count);
+	}
+	if(channel->recycle_pool && channel->is_open == FALSE && engine->is_open == TRUE &&
+		channel->method_vtable->reset(channel) == TRUE) {
+		apt_bool_t recycled = FALSE;
+		/* detach the channel from the session */
+		channel->event_vtable = NULL;
+		channel->event_obj = NULL;
+		channel->barge_in_channel = NULL;
+		apr_atomic_set32(&channel->barge_in_state,MRCP_BARGE_IN_STATE_NONE);
+		apr_atomic_set32(&channel->preroll_consuming,0);
+		if(channel->preroll) {
+			/* the audio of the previous session is not replayed */
+			mpf_frame_buffer_restart(channel->preroll);
+		}
+		apt_string_reset(&channel->id);
+		apr_thread_mutex_lock(engine->idle_mutex);
+		if((apr_size_t)engine->idle_channels->nelts < engine->config->min_idle_channels) {
+			APR_ARRAY_PUSH(engine->idle_channels,mrcp_engine_channel_t*) = channel;
+			recycled = TRUE;
+		}
+		apr_thread_mutex_unlock(engine->idle_mutex);
+		if(recycled == TRUE) {
+			return TRUE;
+		}
+	}
+	return mrcp_engine_channel_release(channel);
+}
+
+/** Link engine channels of a session to kill the audio of one on barge-in of another */
+void mrcp_engine_channel_barge_in_link(mrcp_engine_channel_t *channel, mrcp_engine_channel_t *target)
+{
+	channel->barge_in_channel = target;
+}
+
+/** Arm or disarm the source stream of channel to be muted on barge-in */
+void mrcp_engine_channel_barge_in_arm(mrcp_engine_channel_t *channel, apt_bool_t armed)
+{
+	apr_atomic_set32(&channel->barge_in_state,armed == TRUE ? MRCP_BARGE_IN_STATE_ARMED : MRCP_BARGE_IN_STATE_NONE);
+}
+
+/** Prefetch the voiceprint models of the request in background, if the request is START-SESSION */
+apt_bool_t mrcp_engine_voiceprint_request_prefetch(mrcp_engine_t *engine, const mrcp_message_t *request)
+{
+	mrcp_verifier_header_t *verifier_header;
+	apt_str_t voiceprint_id;
+	apt_str_t list;
+	if(!engine->voiceprint_cache || engine->resource_id != MRCP_VERIFIER_RESOURCE ||
+		request->start_line.method_id != VERIFIER_START_SESSION) {
+		return FALSE;
+	}
+	verifier_header = mrcp_resource_header_get(request);
+	if(!verifier_header ||
+		mrcp_resource_header_property_check(request,VERIFIER_HEADER_REPOSITORY_URI) != TRUE ||
+		mrcp_resource_header_property_check(request,VERIFIER_HEADER_VOICEPRINT_IDENTIFIER) != TRUE) {
+		return FALSE;
+	}
+
+	/* the identifiers of identification are separated by semicolons */
+	list = verifier_header->voiceprint_identifier;
+	while(list.length) {
+		char *sep = memchr(list.buf,';',list.length);
+		voiceprint_id.buf = list.buf;
+		voiceprint_id.length = sep ? (apr_size_t)(sep - list.buf) : list.length;
+		list.buf += voiceprint_id.length;
+		list.length -= voiceprint_id.length;
+		if(sep) {
+			list.buf++;
+			list.length--;
+		}
+		while(voiceprint_id.length && (*voiceprint_id.buf == APT_TOKEN_SP || *voiceprint_id.buf == APT_TOKEN_HTAB)) {
+			voiceprint_id.buf++;
+			voiceprint_id.length--;
+		}
+		while(voiceprint_id.length &&
+			(voiceprint_id.buf[voiceprint_id.length-1] == APT_TOKEN_SP || voiceprint_id.buf[voiceprint_id.length-1] == APT_TOKEN_HTAB)) {
+			voiceprint_id.length--;
+		}
+		if(voiceprint_id.length) {
+			mrcp_voiceprint_cache_prefetch(engine->voiceprint_cache,&verifier_header->repository_uri,&voiceprint_id);
+		}
+	}
+	return TRUE;
+}
+
+/** Prefetch the http:// URI, trimmed of white space */
+static void mrcp_engine_uri_prefetch(mrcp_fetch_cache_t *cache, const char *pos, apr_size_t length)
+{
+	apt_str_t uri;
+	while(length && (*pos == APT_TOKEN_SP || *pos == APT_TOKEN_HTAB)) {
+		pos++;
+		length--;
+	}
+	while(length && (pos[length-1] == APT_TOKEN_SP || pos[length-1] == APT_TOKEN_HTAB || pos[length-1] == APT_TOKEN_CR)) {
+		length--;
+	}
+	/* URIs with entity references are decoded by the engine, the key would not match */
+	if(length <= 7 || strncasecmp(pos,"http://",7) != 0 || memchr(pos,'&',length)) {
+		return;
+	}
+	uri.buf = (char*)pos;
+	uri.length = length;
+	mrcp_fetch_cache_prefetch(cache,&uri);
+}
+
+/** Prefetch the URIs of text/uri-list, comments start with '#' */
+static void mrcp_engine_uri_list_prefetch(mrcp_fetch_cache_t *cache, const apt_str_t *body)
+{
+	const char *pos = body->buf;
+	const char *end = body->buf + body->length;
+	const char *lf;
+	while(pos < end) {
+		lf = memchr(pos,APT_TOKEN_LF,end - pos);
+		if(!lf) {
+			lf = end;
+		}
+		if(*pos != '#') {
+			mrcp_engine_uri_prefetch(cache,pos,lf - pos);
+		}
+		pos = lf + 1;
+	}
+}
+
+/** Prefetch the src URIs of the audio elements of SSML */
+static void mrcp_engine_ssml_audio_prefetch(mrcp_fetch_cache_t *cache, const apt_str_t *body)
+{
+	const char *pos = body->buf;
+	const char *end = body->buf + body->length;
+	const char *tag_end;
+	const char *value_end;
+	char quote;
+	while(pos + 6 < end) {
+		pos = memchr(pos,'<',end - pos);
+		if(!pos) {
+			break;
+		}
+		pos++;
+		if(end - pos < 6 || strncmp(pos,"audio",5) != 0 || (pos[5] != APT_TOKEN_SP && pos[5] != APT_TOKEN_HTAB &&
+			pos[5] != APT_TOKEN_CR && pos[5] != APT_TOKEN_LF)) {
+			continue;
+		}
+		tag_end = memchr(pos,'>',end - pos);
+		if(!tag_end) {
+			break;
+		}
+		for(pos += 5; pos + 4 < tag_end; pos++) {
+			if(strncmp(pos,"src",3) != 0 || (pos[-1] != APT_TOKEN_SP && pos[-1] != APT_TOKEN_HTAB &&
+				pos[-1] != APT_TOKEN_CR && pos[-1] != APT_TOKEN_LF)) {
+				continue;
+			}
+			pos += 3;
+			while(pos < tag_end && (*pos == APT_TOKEN_SP || *pos == APT_TOKEN_HTAB)) {
+				pos++;
+			}
+			if(pos >= tag_end || *pos != '=') {
+				continue;
+			}
+			pos++;
+			while(pos < tag_end && (*pos == APT_TOKEN_SP || *pos == APT_TOKEN_HTAB)) {
+				pos++;
+			}
+			if(pos >= tag_end || (*pos != '"' && *pos != '\'')) {
+				continue;
+			}
+			quote = *pos++;
+			value_end = memchr(pos,quote,tag_end - pos);
+			if(value_end) {
+				mrcp_engine_uri_prefetch(cache,pos,value_end - pos);
+			}
+			break;
+		}
+		pos = tag_end + 1;
+	}
+}
+
+/** Prefetch the http:// URIs the request references in background */
+apt_bool_t mrcp_engine_uri_request_prefetch(mrcp_engine_t *engine, const mrcp_message_t *request)
+{
+	mrcp_generic_header_t *generic_header;
+	apt_bool_t uri_list;
+	if(!engine->fetch_cache || !request->body.length) {
+		return FALSE;
+	}
+	if(engine->resource_id == MRCP_RECOGNIZER_RESOURCE) {
+		if(request->start_line.method_id != RECOGNIZER_RECOGNIZE &&
+			request->start_line.method_id != RECOGNIZER_DEFINE_GRAMMAR) {
+			return FALSE;
+		}
+	}
+	else if(engine->resource_id != MRCP_SYNTHESIZER_RESOURCE || request->start_line.method_id != SYNTHESIZER_SPEAK) {
+		return FALSE;
+	}
+
+	generic_header = mrcp_generic_header_get(request);
+	uri_list = (generic_header &&
+		mrcp_generic_header_property_check(request,GENERIC_HEADER_CONTENT_TYPE) == TRUE &&
+		generic_header->content_type.length >= 13 &&
+		strncasecmp(generic_header->content_type.buf,"text/uri-list",13) == 0) ? TRUE : FALSE;
+	if(uri_list == TRUE) {
+		mrcp_engine_uri_list_prefetch(engine->fetch_cache,&request->body);
+	}
+	else if(engine->resource_id == MRCP_SYNTHESIZER_RESOURCE) {
+		mrcp_engine_ssml_audio_prefetch(engine->fetch_cache,&request->body);
+	}
+	else {
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Mute the linked channel right away, if the message is START-OF-INPUT */
+apt_bool_t mrcp_engine_channel_barge_in_process(mrcp_engine_channel_t *channel, const mrcp_message_t *message)
+{
+	mrcp_engine_channel_t *target = channel->barge_in_channel;
+	if(!target || message->start_line.message_type != MRCP_MESSAGE_TYPE_EVENT ||
+		!message->resource || message->resource->id != MRCP_RECOGNIZER_RESOURCE ||
+		message->start_line.method_id != RECOGNIZER_START_OF_INPUT) {
+		return FALSE;
+	}
+	/* only the audio in progress, which is killed on barge-in, is muted */
+	if(apr_atomic_cas32(&target->barge_in_state,MRCP_BARGE_IN_STATE_MUTED,MRCP_BARGE_IN_STATE_ARMED) != MRCP_BARGE_IN_STATE_ARMED) {
+		return FALSE;
 	}
-	return channel->method_vtable->destroy(channel);
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Mute on Barge-In <%s> by <%s>",target->id.buf,channel->id.buf);
+	return TRUE;
 }
 
 /** Allocate engine config */
@@ -97,6 +614,95 @@ mrcp_engine_config_t* mrcp_engine_config_alloc(apr_pool_t *pool)
 {
 	mrcp_engine_config_t *config = apr_palloc(pool,sizeof(mrcp_engine_config_t));
 	config->max_channel_count = 0;
+	config->min_idle_channels = 0;
+	config->grammar_cache_size = MRCP_GRAMMAR_CACHE_DEFAULT_SIZE;
+	config->prompt_cache_size = MRCP_PROMPT_CACHE_DEFAULT_SIZE;
+	config->voiceprint_cache_size = MRCP_VOICEPRINT_CACHE_DEFAULT_SIZE;
+	config->slow_callback_threshold = 0;
+	config->slow_callback_limit = 0;
+	config->cpu_set = NULL;
+	config->open_mode = MRCP_ENGINE_OPEN_STARTUP;
 	config->params = NULL;
 	return config;
 }
+
+/** Record time spent inside a plugin callback */
+void mrcp_engine_callback_time_record(mrcp_engine_t *engine, mrcp_engine_callback_e callback, apr_uint32_t elapsed)
+{
+	mrcp_engine_callback_stat_t *stat;
+	apr_uint32_t max_time;
+	apr_size_t i;
+	if(callback >= MRCP_ENGINE_CALLBACK_COUNT) {
+		return;
+	}
+	stat = &engine->callback_stats[callback];
+	apr_atomic_inc32(&stat->count);
+	for(i=0; i<MRCP_ENGINE_CALLBACK_HISTOGRAM_SIZE-1; i++) {
+		if(elapsed < ((apr_uint32_t)16 << i)) {
+			break;
+		}
+	}
+	apr_atomic_inc32(&stat->histogram[i]);
+	max_time = apr_atomic_read32(&stat->max_time);
+	while(elapsed > max_time) {
+		apr_uint32_t prev = apr_atomic_cas32(&stat->max_time,elapsed,max_time);
+		if(prev == max_time) {
+			break;
+		}
+		max_time = prev;
+	}
+
+	if(engine->config && engine->config->slow_callback_threshold && elapsed >= engine->config->slow_callback_threshold) {
+		apr_uint32_t slow_count = apr_atomic_inc32(&stat->slow_count) + 1;
+		apr_uint32_t now = (apr_uint32_t)apr_time_sec(apr_time_now());
+		apr_uint32_t report_time = apr_atomic_read32(&engine->slow_report_time);
+		/* warn at most once a second, the callback is on the hot path */
+		if(now != report_time && apr_atomic_cas32(&engine->slow_report_time,now,report_time) == report_time) {
+			apr_uint32_t report_count = apr_atomic_xchg32(&engine->slow_report_count,slow_count);
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Slow %s Callback of Engine [%s] %u usec, %u Slow Callback(s) since Last Report",
+				mrcp_engine_callback_name_get(callback),
+				engine->id,
+				elapsed,
+				slow_count > report_count ? slow_count - report_count : 1);
+		}
+		if(engine->config->slow_callback_limit && slow_count >= engine->config->slow_callback_limit &&
+			apr_atomic_xchg32(&engine->suspended,1) == 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_ERROR,"Suspend Engine [%s] for New Sessions: %u Slow %s Callback(s)",
+				engine->id,
+				slow_count,
+				mrcp_engine_callback_name_get(callback));
+		}
+	}
+}
+
+/** Get statistics of time spent inside plugin callbacks of a kind */
+apt_bool_t mrcp_engine_callback_stat_get(const mrcp_engine_t *engine, mrcp_engine_callback_e callback, mrcp_engine_callback_stat_t *stat)
+{
+	mrcp_engine_callback_stat_t *src;
+	apr_size_t i;
+	if(callback >= MRCP_ENGINE_CALLBACK_COUNT || !stat) {
+		return FALSE;
+	}
+	src = (mrcp_engine_callback_stat_t*)&engine->callback_stats[callback];
+	stat->count = apr_atomic_read32(&src->count);
+	stat->slow_count = apr_atomic_read32(&src->slow_count);
+	stat->max_time = apr_atomic_read32(&src->max_time);
+	for(i=0; i<MRCP_ENGINE_CALLBACK_HISTOGRAM_SIZE; i++) {
+		stat->histogram[i] = apr_atomic_read32(&src->histogram[i]);
+	}
+	return TRUE;
+}
+
+/** Get the name of a kind of plugin callbacks */
+const char* mrcp_engine_callback_name_get(mrcp_engine_callback_e callback)
+{
+	switch(callback) {
+		case MRCP_ENGINE_CALLBACK_STREAM:
+			return "stream";
+		case MRCP_ENGINE_CALLBACK_REQUEST:
+			return "request";
+		default:
+			break;
+	}
+	return "unknown";
+}
@@ -16,8 +16,13 @@
  * $Id$
  */
 
+#include <stdlib.h>
+#include <string.h>
 #include "mrcp_engine_impl.h"
+#include "mrcp_engine_iface.h"
+#include "mrcp_audio_batch.h"
 #include "mpf_termination_factory.h"
+#include "mpf_termination.h"
 
 /** Create engine */
 mrcp_engine_t* mrcp_engine_create(
@@ -36,8 +41,27 @@ mrcp_engine_t* mrcp_engine_create(
 	engine->config = NULL;
 	engine->codec_manager = NULL;
 	engine->dir_layout = NULL;
+	engine->executor = NULL;
 	engine->cur_channel_count = 0;
+	engine->idle_channels = NULL;
+	engine->idle_mutex = NULL;
+	engine->grammar_cache = NULL;
+	engine->prompt_cache = NULL;
+	engine->voiceprint_cache = NULL;
+	engine->voiceprint_loader = NULL;
+	engine->fetch_cache = NULL;
+	engine->inline_params = NULL;
+	engine->audio_batch = NULL;
+	engine->request_batch = NULL;
+	memset(engine->callback_stats,0,sizeof(engine->callback_stats));
+	engine->slow_report_time = 0;
+	engine->slow_report_count = 0;
+	engine->suspended = 0;
 	engine->is_open = FALSE;
+	engine->open_mutex = NULL;
+	engine->open_cond = NULL;
+	engine->open_pending = FALSE;
+	engine->open_time = 0;
 	engine->pool = pool;
 	engine->create_state_machine = NULL;
 	return engine;
@@ -58,6 +82,170 @@ const char* mrcp_engine_param_get(const mrcp_engine_t *engine, const char *name)
 	return apr_table_get(engine->config->params,name);
 }
 
+/** Declare header field by identifier in the scope of all header fields */
+static apt_bool_t mrcp_engine_inline_param_set(mrcp_engine_t *engine, apr_size_t id)
+{
+	if(!engine->inline_params) {
+		engine->inline_params = apr_array_make(engine->pool,GENERIC_HEADER_COUNT,sizeof(apr_byte_t));
+	}
+	while((apr_size_t)engine->inline_params->nelts <= id) {
+		APR_ARRAY_PUSH(engine->inline_params,apr_byte_t) = 0;
+	}
+	APR_ARRAY_IDX(engine->inline_params,id,apr_byte_t) = 1;
+	return TRUE;
+}
+
+/** Declare generic header field the engine takes from the next request only */
+apt_bool_t mrcp_engine_generic_param_declare(mrcp_engine_t *engine, mrcp_generic_header_id id)
+{
+	if(id >= GENERIC_HEADER_COUNT) {
+		return FALSE;
+	}
+	return mrcp_engine_inline_param_set(engine,id);
+}
+
+/** Declare resource header field the engine takes from the next request only */
+apt_bool_t mrcp_engine_param_declare(mrcp_engine_t *engine, apr_size_t id)
+{
+	return mrcp_engine_inline_param_set(engine,GENERIC_HEADER_COUNT + id);
+}
+
+/** Audio stream methods of plugin wrapped to be timed */
+typedef struct mrcp_engine_timed_stream_t mrcp_engine_timed_stream_t;
+struct mrcp_engine_timed_stream_t {
+	/** Copy of plugin methods with read/write overridden (must be the first member) */
+	mpf_audio_stream_vtable_t        vtable;
+	/** Original methods of plugin */
+	const mpf_audio_stream_vtable_t *plugin_vtable;
+	/** Engine to account the time to */
+	mrcp_engine_t                   *engine;
+	/** Channel the stream belongs to */
+	mrcp_engine_channel_t           *channel;
+	/** Whether the engine consumed the sink stream as of the last write (media thread only) */
+	apt_bool_t                       consuming;
+	/** Frame the pre-roll is replayed by */
+	mpf_frame_t                      preroll_frame;
+};
+
+static apt_bool_t mrcp_engine_timed_frame_read(mpf_audio_stream_t *stream, mpf_frame_t *frame)
+{
+	const mrcp_engine_timed_stream_t *timed_stream = (const mrcp_engine_timed_stream_t*)stream->vtable;
+	apr_time_t start_time = apr_time_now();
+	apt_bool_t status = timed_stream->plugin_vtable->read_frame(stream,frame);
+	mrcp_engine_callback_time_record(timed_stream->engine,MRCP_ENGINE_CALLBACK_STREAM,(apr_uint32_t)(apr_time_now() - start_time));
+	if(apr_atomic_read32(&timed_stream->channel->barge_in_state) == MRCP_BARGE_IN_STATE_MUTED) {
+		/* the plugin keeps on producing, while silence is sent out till the barge-in is reconciled */
+		frame->type &= ~MEDIA_FRAME_TYPE_AUDIO;
+	}
+	return status;
+}
+
+static apt_bool_t mrcp_engine_timed_frame_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame)
+{
+	const mrcp_engine_timed_stream_t *timed_stream = (const mrcp_engine_timed_stream_t*)stream->vtable;
+	apr_time_t start_time = apr_time_now();
+	apt_bool_t status = timed_stream->plugin_vtable->write_frame(stream,frame);
+	mrcp_engine_callback_time_record(timed_stream->engine,MRCP_ENGINE_CALLBACK_STREAM,(apr_uint32_t)(apr_time_now() - start_time));
+	return status;
+}
+
+/** Keep the latest audio, while the engine is not consuming, and replay it, once the engine starts to */
+static apt_bool_t mrcp_engine_preroll_frame_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame)
+{
+	mrcp_engine_timed_stream_t *timed_stream = (mrcp_engine_timed_stream_t*)stream->vtable;
+	mrcp_engine_channel_t *channel = timed_stream->channel;
+	mpf_frame_buffer_t *preroll = channel->preroll;
+	mpf_frame_t idle_frame;
+	if(!preroll) {
+		return mrcp_engine_timed_frame_write(stream,frame);
+	}
+
+	if(!apr_atomic_read32(&channel->preroll_consuming)) {
+		timed_stream->consuming = FALSE;
+		if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO &&
+			mpf_frame_buffer_write(preroll,frame) == FALSE) {
+			/* full, the oldest frame gives way (the ring is both written and read in the media context) */
+			mpf_frame_buffer_read(preroll,&timed_stream->preroll_frame);
+			mpf_frame_buffer_write(preroll,frame);
+		}
+		/* the engine gets the events only, as if the sink were inactive */
+		idle_frame = *frame;
+		idle_frame.type &= ~MEDIA_FRAME_TYPE_AUDIO;
+		return mrcp_engine_timed_frame_write(stream,&idle_frame);
+	}
+
+	if(timed_stream->consuming == FALSE) {
+		timed_stream->consuming = TRUE;
+		/* the audio preceding the start of the request comes first, all at once */
+		for(;;) {
+			mpf_frame_buffer_read(preroll,&timed_stream->preroll_frame);
+			if((timed_stream->preroll_frame.type & MEDIA_FRAME_TYPE_AUDIO) != MEDIA_FRAME_TYPE_AUDIO) {
+				break;
+			}
+			timed_stream->preroll_frame.marker = MPF_MARKER_NONE;
+			mrcp_engine_timed_frame_write(stream,&timed_stream->preroll_frame);
+		}
+		/* reads of the empty ring are no underruns to report */
+		mpf_frame_buffer_underruns_get(preroll);
+	}
+	return mrcp_engine_timed_frame_write(stream,frame);
+}
+
+static apt_bool_t mrcp_engine_preroll_tx_open(mpf_audio_stream_t *stream, mpf_codec_t *codec)
+{
+	mrcp_engine_timed_stream_t *timed_stream = (mrcp_engine_timed_stream_t*)stream->vtable;
+	mrcp_engine_channel_t *channel = timed_stream->channel;
+	const mpf_codec_descriptor_t *descriptor = stream->tx_descriptor;
+	apr_size_t frame_size;
+	if(timed_stream->plugin_vtable->open_tx && timed_stream->plugin_vtable->open_tx(stream,codec) == FALSE) {
+		return FALSE;
+	}
+
+	if(!descriptor || mpf_codec_lpcm_descriptor_match(descriptor) == FALSE) {
+		/* the pre-roll holds decoded audio only */
+		return TRUE;
+	}
+	frame_size = mpf_codec_linear_frame_size_calculate(descriptor->sampling_rate,descriptor->channel_count);
+	if(!channel->preroll || timed_stream->preroll_frame.codec_frame.size != frame_size) {
+		/* created once per sampling rate, the channel may be reused by many sessions */
+		timed_stream->preroll_frame.codec_frame.size = frame_size;
+		timed_stream->preroll_frame.codec_frame.buffer = apr_palloc(channel->pool,frame_size);
+		channel->preroll = mpf_frame_buffer_create(frame_size,channel->preroll_time / CODEC_FRAME_TIME_BASE,channel->pool);
+		timed_stream->consuming = FALSE;
+	}
+	return TRUE;
+}
+
+/** Wrap read/write methods of the audio stream of plugin to time them */
+static void mrcp_engine_audio_stream_time(mrcp_engine_channel_t *channel, mpf_audio_stream_t *stream, apr_pool_t *pool)
+{
+	mrcp_engine_timed_stream_t *timed_stream;
+	if(!stream->vtable || (!stream->vtable->read_frame && !stream->vtable->write_frame)) {
+		return;
+	}
+	timed_stream = apr_palloc(pool,sizeof(mrcp_engine_timed_stream_t));
+	timed_stream->vtable = *stream->vtable;
+	timed_stream->plugin_vtable = stream->vtable;
+	timed_stream->engine = channel->engine;
+	timed_stream->channel = channel;
+	timed_stream->consuming = FALSE;
+	timed_stream->preroll_frame.type = MEDIA_FRAME_TYPE_NONE;
+	timed_stream->preroll_frame.marker = MPF_MARKER_NONE;
+	timed_stream->preroll_frame.codec_frame.buffer = NULL;
+	timed_stream->preroll_frame.codec_frame.size = 0;
+	if(stream->vtable->read_frame) {
+		timed_stream->vtable.read_frame = mrcp_engine_timed_frame_read;
+	}
+	if(stream->vtable->write_frame) {
+		timed_stream->vtable.write_frame = mrcp_engine_timed_frame_write;
+		if(channel->preroll_time) {
+			timed_stream->vtable.open_tx = mrcp_engine_preroll_tx_open;
+			timed_stream->vtable.write_frame = mrcp_engine_preroll_frame_write;
+		}
+	}
+	stream->vtable = &timed_stream->vtable;
+}
+
 /** Create engine channel */
 mrcp_engine_channel_t* mrcp_engine_channel_create(
 							mrcp_engine_t *engine, 
@@ -75,10 +263,45 @@ mrcp_engine_channel_t* mrcp_engine_channel_create(
 	channel->engine = engine;
 	channel->is_open = FALSE;
 	channel->pool = pool;
+	channel->recycle_pool = NULL;
+	channel->audio_pipe = NULL;
+	channel->barge_in_channel = NULL;
+	channel->barge_in_state = MRCP_BARGE_IN_STATE_NONE;
+	channel->preroll_time = 0;
+	channel->preroll = NULL;
+	channel->preroll_consuming = 0;
+	if(engine->config && engine->config->params) {
+		const char *preroll = apr_table_get(engine->config->params,"preroll");
+		if(preroll) {
+			channel->preroll_time = atol(preroll);
+		}
+	}
 	apt_string_reset(&channel->id);
+	if(termination && termination->audio_stream) {
+		mrcp_engine_audio_stream_time(channel,termination->audio_stream,pool);
+	}
 	return channel;
 }
 
+/** Create audio pipe of channel */
+mrcp_audio_pipe_t* mrcp_engine_channel_audio_pipe_create(
+						mrcp_engine_channel_t *channel,
+						apr_size_t frame_size,
+						apr_size_t capacity,
+						apr_size_t batch,
+						mrcp_audio_pipe_notify_f notify,
+						void *obj)
+{
+	mrcp_engine_t *engine = channel->engine;
+	if(engine->audio_batch) {
+		/* the pipes of all the channels are drained at once */
+		notify = mrcp_audio_batch_notify;
+		obj = engine->audio_batch;
+	}
+	channel->audio_pipe = mrcp_audio_pipe_create(frame_size,capacity,batch,notify,obj,channel->pool);
+	return channel->audio_pipe;
+}
+
 /** Create audio termination */
 mpf_termination_t* mrcp_engine_audio_termination_create(
 								void *obj,
@@ -244,3 +467,128 @@ const mpf_codec_descriptor_t* mrcp_engine_sink_stream_codec_get(const mrcp_engin
 	}
 	return NULL;
 }
+
+/** Report whether the audio sink stream consumes frames */
+void mrcp_engine_sink_stream_active_set(mrcp_engine_channel_t *channel, apt_bool_t active)
+{
+	if(channel && channel->termination) {
+		mpf_audio_stream_t *audio_stream = mpf_termination_audio_stream_get(channel->termination);
+		if(audio_stream) {
+			if(channel->preroll_time) {
+				/* the audio is decoded for the pre-roll anyway, the stream stays active */
+				apr_atomic_set32(&channel->preroll_consuming,active == TRUE ? 1 : 0);
+				return;
+			}
+			mpf_audio_stream_tx_active_set(audio_stream,active);
+		}
+	}
+}
+
+/** Look up grammar compiled by any channel of the engine */
+mrcp_grammar_entry_t* mrcp_engine_grammar_lookup(mrcp_engine_t *engine, const apt_str_t *content_type, const apt_str_t *content)
+{
+	if(!engine->grammar_cache || !content_type || !content) {
+		return NULL;
+	}
+	return mrcp_grammar_cache_lookup(engine->grammar_cache,content_type,content);
+}
+
+/** Share compiled grammar with other channels of the engine */
+mrcp_grammar_entry_t* mrcp_engine_grammar_insert(
+						mrcp_engine_t *engine,
+						const apt_str_t *content_type,
+						const apt_str_t *content,
+						void *grammar,
+						mrcp_grammar_destroy_f destroy)
+{
+	if(!engine->grammar_cache || !content_type || !content) {
+		return NULL;
+	}
+	return mrcp_grammar_cache_insert(engine->grammar_cache,content_type,content,grammar,destroy);
+}
+
+/** Release grammar entry got by lookup or insert */
+void mrcp_engine_grammar_release(mrcp_engine_t *engine, mrcp_grammar_entry_t *entry)
+{
+	if(engine->grammar_cache && entry) {
+		mrcp_grammar_cache_release(engine->grammar_cache,entry);
+	}
+}
+
+/** Look up prompt synthesized by any channel of the engine */
+mrcp_prompt_entry_t* mrcp_engine_prompt_lookup(mrcp_engine_t *engine, const apt_str_t *key)
+{
+	if(!engine->prompt_cache || !key) {
+		return NULL;
+	}
+	return mrcp_prompt_cache_lookup(engine->prompt_cache,key);
+}
+
+/** Create writer to record the prompt being synthesized by */
+mrcp_prompt_writer_t* mrcp_engine_prompt_writer_create(mrcp_engine_t *engine, const apt_str_t *key)
+{
+	if(!engine->prompt_cache || !key) {
+		return NULL;
+	}
+	return mrcp_prompt_writer_create(engine->prompt_cache,key);
+}
+
+/** Release prompt entry got by lookup */
+void mrcp_engine_prompt_release(mrcp_engine_t *engine, mrcp_prompt_entry_t *entry)
+{
+	if(engine->prompt_cache && entry) {
+		mrcp_prompt_cache_release(engine->prompt_cache,entry);
+	}
+}
+
+/** Set loader of voiceprint models to share the models among channels of the engine by */
+apt_bool_t mrcp_engine_voiceprint_loader_set(mrcp_engine_t *engine, const mrcp_voiceprint_loader_t *loader)
+{
+	if(engine->is_open == TRUE || (loader && !loader->load)) {
+		return FALSE;
+	}
+	engine->voiceprint_loader = loader;
+	return TRUE;
+}
+
+/** Get voiceprint model loaded by any channel of the engine or prefetched */
+mrcp_voiceprint_entry_t* mrcp_engine_voiceprint_get(mrcp_engine_t *engine, const apt_str_t *repository_uri, const apt_str_t *voiceprint_id)
+{
+	if(!engine->voiceprint_cache || !repository_uri || !voiceprint_id) {
+		return NULL;
+	}
+	return mrcp_voiceprint_cache_get(engine->voiceprint_cache,repository_uri,voiceprint_id);
+}
+
+/** Release voiceprint entry got by get */
+void mrcp_engine_voiceprint_release(mrcp_engine_t *engine, mrcp_voiceprint_entry_t *entry)
+{
+	if(engine->voiceprint_cache && entry) {
+		mrcp_voiceprint_cache_release(engine->voiceprint_cache,entry);
+	}
+}
+
+/** Get document referenced by URI, fetched by any channel of any engine or prefetched */
+mrcp_fetch_entry_t* mrcp_engine_uri_fetch(mrcp_engine_t *engine, const apt_str_t *uri)
+{
+	if(!engine->fetch_cache || !uri) {
+		return NULL;
+	}
+	return mrcp_fetch_cache_get(engine->fetch_cache,uri);
+}
+
+/** Release document entry got by fetch */
+void mrcp_engine_uri_release(mrcp_engine_t *engine, mrcp_fetch_entry_t *entry)
+{
+	if(engine->fetch_cache && entry) {
+		mrcp_fetch_cache_release(engine->fetch_cache,entry);
+	}
+}
+
+/** Invalidate voiceprint model of the engine */
+void mrcp_engine_voiceprint_invalidate(mrcp_engine_t *engine, const apt_str_t *repository_uri, const apt_str_t *voiceprint_id)
+{
+	if(engine->voiceprint_cache && repository_uri && voiceprint_id) {
+		mrcp_voiceprint_cache_invalidate(engine->voiceprint_cache,repository_uri,voiceprint_id);
+	}
+}
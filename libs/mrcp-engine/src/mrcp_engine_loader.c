@@ -18,15 +18,35 @@
 
 #include <apr_dso.h>
 #include <apr_hash.h>
+#include <apr_strings.h>
 #include "mrcp_engine_loader.h"
 #include "mrcp_engine_plugin.h"
+#include "mrcp_engine_host.h"
+#include "apt_pool.h"
 #include "apt_log.h"
 
+/** Plugin loaded by engine loader */
+typedef struct mrcp_engine_plugin_t mrcp_engine_plugin_t;
+
+/** Plugin loaded by engine loader */
+struct mrcp_engine_plugin_t {
+	/** Engine created by the plugin */
+	mrcp_engine_t    *engine;
+	/** Handle of the loaded plugin */
+	apr_dso_handle_t *handle;
+	/** Own pool the plugin is loaded into and the engine is created from */
+	apr_pool_t       *pool;
+};
+
 /** Engine loader declaration */
 struct mrcp_engine_loader_t {
-	/** Table of plugins (apr_dso_handle_t*) */
-	apr_hash_t *plugins;
-	apr_pool_t *pool;
+	/** Table of plugins by engine (mrcp_engine_plugin_t*) */
+	apr_hash_t                    *plugins;
+	/** Resource factory engines hosted in worker processes parse messages by */
+	const mrcp_resource_factory_t *resource_factory;
+	/** Directory layout passed to engines hosted in worker processes */
+	const apt_dir_layout_t        *dir_layout;
+	apr_pool_t                    *pool;
 };
 
 
@@ -36,9 +56,23 @@ MRCP_DECLARE(mrcp_engine_loader_t*) mrcp_engine_loader_create(apr_pool_t *pool)
 	mrcp_engine_loader_t *loader = apr_palloc(pool,sizeof(mrcp_engine_loader_t));
 	loader->pool = pool;
 	loader->plugins = apr_hash_make(pool);
+	loader->resource_factory = NULL;
+	loader->dir_layout = NULL;
 	return loader;
 }
 
+/** Set resource factory */
+MRCP_DECLARE(void) mrcp_engine_loader_resource_factory_set(mrcp_engine_loader_t *loader, const mrcp_resource_factory_t *resource_factory)
+{
+	loader->resource_factory = resource_factory;
+}
+
+/** Set directory layout */
+MRCP_DECLARE(void) mrcp_engine_loader_dir_layout_set(mrcp_engine_loader_t *loader, const apt_dir_layout_t *dir_layout)
+{
+	loader->dir_layout = dir_layout;
+}
+
 /** Destroy engine loader */
 MRCP_DECLARE(apt_bool_t) mrcp_engine_loader_destroy(mrcp_engine_loader_t *loader)
 {
@@ -50,20 +84,34 @@ MRCP_DECLARE(apt_bool_t) mrcp_engine_loader_plugins_unload(mrcp_engine_loader_t
 {
 	apr_hash_index_t *it;
 	void *val;
-	apr_dso_handle_t *plugin;
+	mrcp_engine_plugin_t *plugin;
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Unload Plugins");
 	it=apr_hash_first(loader->pool,loader->plugins);
 	for(; it; it = apr_hash_next(it)) {
 		apr_hash_this(it,NULL,NULL,&val);
 		plugin = val;
-		if(plugin) {
-			apr_dso_unload(plugin);
+		if(plugin && plugin->handle) {
+			apr_dso_unload(plugin->handle);
 		}
 	}
 	apr_hash_clear(loader->plugins);
 	return TRUE;
 }
 
+/** Unload the plugin engine is created by */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_loader_plugin_unload(mrcp_engine_loader_t *loader, mrcp_engine_t *engine)
+{
+	mrcp_engine_plugin_t *plugin = apr_hash_get(loader->plugins,&engine,sizeof(mrcp_engine_t*));
+	if(!plugin) {
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Unload Plugin [%s]",engine->id);
+	apr_hash_set(loader->plugins,&plugin->engine,sizeof(mrcp_engine_t*),NULL);
+	/* the plugin is unloaded by the cleanup of its pool, once the memory of the engine is released */
+	apr_pool_destroy(plugin->pool);
+	return TRUE;
+}
+
 static apt_bool_t plugin_version_load(apr_dso_handle_t *plugin)
 {
 	apr_dso_handle_sym_t version_handle = NULL;
@@ -122,48 +170,98 @@ static apt_bool_t plugin_logger_load(apr_dso_handle_t *plugin)
 }
 
 
-/** Load engine plugin */
-MRCP_DECLARE(mrcp_engine_t*) mrcp_engine_loader_plugin_load(mrcp_engine_loader_t *loader, const char *id, const char *path, mrcp_engine_config_t *config)
+/** Load plugin and create engine */
+static mrcp_engine_t* plugin_engine_create(const char *path, apr_dso_handle_t **handle, apr_pool_t *pool)
 {
-	apr_dso_handle_t *plugin = NULL;
 	mrcp_plugin_creator_f plugin_creator = NULL;
-	mrcp_engine_t *engine = NULL;
-	if(!path || !id) {
-		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Load Plugin: invalid params");
-		return NULL;
-	}
-
-	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Load Plugin [%s] [%s]",id,path);
-	if(apr_dso_load(&plugin,path,loader->pool) != APR_SUCCESS) {
+	mrcp_engine_t *engine;
+	if(apr_dso_load(handle,path,pool) != APR_SUCCESS) {
 		char derr[512] = "";
-		apr_dso_error(plugin,derr,sizeof(derr));
+		apr_dso_error(*handle,derr,sizeof(derr));
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Load DSO: %s", derr);
 		return NULL;
 	}
 
-	if(plugin_version_load(plugin) != TRUE) {
-		apr_dso_unload(plugin);
+	if(plugin_version_load(*handle) != TRUE) {
 		return NULL;
 	}
 
-	plugin_creator = plugin_creator_load(plugin);
+	plugin_creator = plugin_creator_load(*handle);
 	if(!plugin_creator) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Entry Point Found for Plugin");
-		apr_dso_unload(plugin);
 		return NULL;
 	}
 
-	plugin_logger_load(plugin);
-
-	apr_hash_set(loader->plugins,id,APR_HASH_KEY_STRING,plugin);
+	plugin_logger_load(*handle);
 
-	engine = plugin_creator(loader->pool);
+	engine = plugin_creator(pool);
 	if(!engine) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create MRCP Engine");
 		return NULL;
 	}
-	
-	engine->id = id;
-	engine->config = config;
+	return engine;
+}
+
+/** Load plugin in worker process */
+static mrcp_engine_t* plugin_host_engine_create(void *obj, apr_pool_t *pool)
+{
+	apr_dso_handle_t *handle = NULL;
+	return plugin_engine_create(obj,&handle,pool);
+}
+
+/** Load engine plugin */
+MRCP_DECLARE(mrcp_engine_t*) mrcp_engine_loader_plugin_load(mrcp_engine_loader_t *loader, const char *id, const char *path, mrcp_engine_config_t *config)
+{
+	apr_dso_handle_t *handle = NULL;
+	mrcp_engine_plugin_t *plugin;
+	mrcp_engine_t *engine = NULL;
+	const char *host = NULL;
+	apr_pool_t *pool;
+	if(!path || !id) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Load Plugin: invalid params");
+		return NULL;
+	}
+
+	/* each plugin has own pool, so that it can be unloaded at runtime */
+	pool = apt_subpool_create(loader->pool);
+	if(!pool) {
+		return NULL;
+	}
+
+	if(config && config->params) {
+		host = apr_table_get(config->params,"host");
+	}
+	if(host && strcasecmp(host,"process") == 0) {
+		/* the plugin is loaded in the worker only, so that a crash of the engine spares the server */
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Load Plugin [%s] [%s] in Worker Process",id,path);
+		engine = mrcp_engine_host_create(
+					id,
+					config,
+					loader->resource_factory,
+					loader->dir_layout,
+					plugin_host_engine_create,
+					apr_pstrdup(pool,path),
+					pool);
+		if(!engine) {
+			apr_pool_destroy(pool);
+			return NULL;
+		}
+	}
+	else {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Load Plugin [%s] [%s]",id,path);
+		engine = plugin_engine_create(path,&handle,pool);
+		if(!engine) {
+			apr_pool_destroy(pool);
+			return NULL;
+		}
+		engine->id = id;
+		engine->config = config;
+	}
+
+	plugin = apr_palloc(pool,sizeof(mrcp_engine_plugin_t));
+	plugin->engine = engine;
+	plugin->handle = handle;
+	plugin->pool = pool;
+	apr_hash_set(loader->plugins,&plugin->engine,sizeof(mrcp_engine_t*),plugin);
 	return engine;
 }
@@ -0,0 +1,1352 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <apr_ring.h>
+#include <apr_hash.h>
+#include <apr_strings.h>
+#include <apr_network_io.h>
+#include <apr_file_io.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#include "mrcp_fetch_cache.h"
+#include "apt_text_stream.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+
+/** Number of hash buckets (power of 2) */
+#define MRCP_FETCH_BUCKET_COUNT        256
+/** Number of strands documents are prefetched by in parallel */
+#define MRCP_FETCH_STRAND_COUNT        4
+/** Max number of pending prefetches per strand */
+#define MRCP_FETCH_STRAND_SIZE         64
+/** Size of the receive buffer of connection, also the max length of the status line and of a header */
+#define MRCP_FETCH_BUFFER_SIZE         4096
+/** Time idle connections are reused within, servers close them on their own soon after (usec) */
+#define MRCP_FETCH_IDLE_TIMEOUT        (15 * 1000 * 1000)
+/** Time a stale document is served for, once it failed to revalidate (usec) */
+#define MRCP_FETCH_RETRY_INTERVAL      (5 * 1000 * 1000)
+/** Max number of redirects followed */
+#define MRCP_FETCH_MAX_REDIRECTS       3
+
+/** Status of HTTP fetch */
+typedef enum {
+	MRCP_FETCH_STATUS_OK,           /**< the document is fetched */
+	MRCP_FETCH_STATUS_NOT_MODIFIED, /**< the cached document is still valid (304) */
+	MRCP_FETCH_STATUS_REDIRECT,     /**< the document is moved to the location */
+	MRCP_FETCH_STATUS_FAILED        /**< the document failed to fetch */
+} mrcp_fetch_status_e;
+
+/** Fetched document (the memory is allocated by malloc) */
+typedef struct mrcp_fetch_doc_t mrcp_fetch_doc_t;
+struct mrcp_fetch_doc_t {
+	/** Content */
+	char       *data;
+	/** Size of content */
+	apr_size_t  size;
+	/** Content type (NULL if none) */
+	char       *content_type;
+	/** Entity tag to revalidate the document by (NULL if none) */
+	char       *etag;
+	/** Time the document is fresh until */
+	apr_time_t  expires;
+	/** The document is not to be stored */
+	apt_bool_t  no_store;
+};
+
+/** Fetch cache entry */
+struct mrcp_fetch_entry_t {
+	/** Ring entry of unreferenced (evictable) entries */
+	APR_RING_ENTRY(mrcp_fetch_entry_t) link;
+	/** Next entry in the same bucket (or in the list of entries to free) */
+	mrcp_fetch_entry_t *next;
+	/** Hash of the URI */
+	apr_uint32_t        hash;
+	/** URI (copy, NUL-terminated) */
+	apt_str_t           uri;
+	/** Fetched document */
+	mrcp_fetch_doc_t    doc;
+	/** Number of references, including the one of the fetch in progress */
+	apr_size_t          ref_count;
+	/** Is the document being fetched for the first time */
+	apt_bool_t          loading;
+	/** Is the stale document being revalidated */
+	apt_bool_t          revalidating;
+	/** Has the document been fetched successfully */
+	apt_bool_t          fetched;
+	/** Is the entry in the buckets (not failed, evicted or replaced) */
+	apt_bool_t          linked;
+};
+
+/** Ring of fetch cache entries */
+APR_RING_HEAD(mrcp_fetch_ring_t, mrcp_fetch_entry_t);
+
+/** Keep-alive connection */
+typedef struct mrcp_fetch_conn_t mrcp_fetch_conn_t;
+struct mrcp_fetch_conn_t {
+	/** Next idle connection to the same host */
+	mrcp_fetch_conn_t *next;
+	/** Connected socket */
+	apr_socket_t      *sock;
+	/** Time the connection became idle at */
+	apr_time_t         idle_time;
+	/** Position of unread data in the buffer */
+	apr_size_t         pos;
+	/** Length of received data in the buffer */
+	apr_size_t         length;
+	/** Receive buffer */
+	char               buf[MRCP_FETCH_BUFFER_SIZE];
+	/** Pool the connection is allocated from */
+	apr_pool_t        *pool;
+};
+
+/** Idle connections to a host */
+typedef struct mrcp_fetch_host_t mrcp_fetch_host_t;
+struct mrcp_fetch_host_t {
+	/** Idle connections, the most recently used first */
+	mrcp_fetch_conn_t *idle;
+	/** Number of idle connections */
+	apr_size_t         count;
+};
+
+/** Fetch cache */
+struct mrcp_fetch_cache_t {
+	/** Hash buckets */
+	mrcp_fetch_entry_t       *buckets[MRCP_FETCH_BUCKET_COUNT];
+	/** Unreferenced entries in least recently used order */
+	struct mrcp_fetch_ring_t  idle;
+	/** Number of fetched documents */
+	apr_size_t                count;
+	/** Memory used by the fetched documents */
+	apr_size_t                size;
+	/** Config (copy) */
+	mrcp_fetch_cache_config_t config;
+	/** Idle connections per "host:port" */
+	apr_hash_t               *hosts;
+	/** Strands to prefetch documents by (NULL if no executor) */
+	apt_executor_strand_t    *strands[MRCP_FETCH_STRAND_COUNT];
+	/** Index of the strand to submit the next prefetch to */
+	apr_size_t                next_strand;
+	/** Mutex, the cache is shared among engines, channels and prefetch jobs */
+	apr_thread_mutex_t       *mutex;
+	/** Signaled, once a document is fetched or revalidated */
+	apr_thread_cond_t        *cond;
+	/** Pool to allocate memory from */
+	apr_pool_t               *pool;
+};
+
+/** Compute FNV-1a hash of the URI */
+static apr_uint32_t mrcp_fetch_hash(const apt_str_t *uri)
+{
+	apr_uint32_t hash = 2166136261U;
+	apr_size_t i;
+	for(i=0; i<uri->length; i++) {
+		hash ^= (apr_byte_t)uri->buf[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static APR_INLINE mrcp_fetch_entry_t** mrcp_fetch_bucket_get(mrcp_fetch_cache_t *cache, apr_uint32_t hash)
+{
+	return &cache->buckets[(hash ^ (hash >> 16)) & (MRCP_FETCH_BUCKET_COUNT - 1)];
+}
+
+static APR_INLINE apr_size_t mrcp_fetch_entry_size(const mrcp_fetch_entry_t *entry)
+{
+	return sizeof(mrcp_fetch_entry_t) + entry->uri.length + entry->doc.size;
+}
+
+static void mrcp_fetch_doc_reset(mrcp_fetch_doc_t *doc)
+{
+	doc->data = NULL;
+	doc->size = 0;
+	doc->content_type = NULL;
+	doc->etag = NULL;
+	doc->expires = 0;
+	doc->no_store = FALSE;
+}
+
+static void mrcp_fetch_doc_free(mrcp_fetch_doc_t *doc)
+{
+	if(doc->data) {
+		free(doc->data);
+	}
+	if(doc->content_type) {
+		free(doc->content_type);
+	}
+	if(doc->etag) {
+		free(doc->etag);
+	}
+	mrcp_fetch_doc_reset(doc);
+}
+
+static char* mrcp_fetch_strdup(const char *str)
+{
+	apr_size_t length = strlen(str);
+	char *copy = malloc(length + 1);
+	if(copy) {
+		memcpy(copy,str,length + 1);
+	}
+	return copy;
+}
+
+/** Replace the string of the document by the copy of the other one */
+static void mrcp_fetch_doc_str_set(char **str, const char *value)
+{
+	if(*str) {
+		free(*str);
+	}
+	*str = value ? mrcp_fetch_strdup(value) : NULL;
+}
+
+/** Reserve space for the content of the document to grow by */
+static apt_bool_t mrcp_fetch_doc_reserve(mrcp_fetch_doc_t *doc, apr_size_t *capacity, apr_size_t size, apr_size_t max_size)
+{
+	apr_size_t new_capacity;
+	char *data;
+	if(doc->size + size > max_size) {
+		return FALSE;
+	}
+	if(doc->size + size <= *capacity) {
+		return TRUE;
+	}
+	new_capacity = *capacity ? *capacity * 2 : 16 * 1024;
+	while(new_capacity < doc->size + size) {
+		new_capacity *= 2;
+	}
+	data = realloc(doc->data,new_capacity);
+	if(!data) {
+		return FALSE;
+	}
+	doc->data = data;
+	*capacity = new_capacity;
+	return TRUE;
+}
+
+static mrcp_fetch_entry_t* mrcp_fetch_entry_find(mrcp_fetch_cache_t *cache, apr_uint32_t hash, const apt_str_t *uri)
+{
+	mrcp_fetch_entry_t *entry = *mrcp_fetch_bucket_get(cache,hash);
+	for(; entry; entry = entry->next) {
+		if(entry->hash == hash && apt_string_compare(&entry->uri,uri) == TRUE) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/** Create entry of the document to fetch, insert it, if linked (called with the lock held) */
+static mrcp_fetch_entry_t* mrcp_fetch_entry_create(mrcp_fetch_cache_t *cache, apr_uint32_t hash, const apt_str_t *uri, apt_bool_t linked)
+{
+	mrcp_fetch_entry_t **bucket;
+	mrcp_fetch_entry_t *entry = malloc(sizeof(mrcp_fetch_entry_t) + uri->length + 1);
+	if(!entry) {
+		return NULL;
+	}
+	entry->uri.buf = (char*)(entry + 1);
+	memcpy(entry->uri.buf,uri->buf,uri->length);
+	entry->uri.buf[uri->length] = '\0';
+	entry->uri.length = uri->length;
+	entry->hash = hash;
+	mrcp_fetch_doc_reset(&entry->doc);
+	/* referenced by the fetch in progress */
+	entry->ref_count = 1;
+	entry->loading = TRUE;
+	entry->revalidating = FALSE;
+	entry->fetched = FALSE;
+	entry->linked = linked;
+	entry->next = NULL;
+	APR_RING_ELEM_INIT(entry,link);
+
+	if(linked == TRUE) {
+		bucket = mrcp_fetch_bucket_get(cache,hash);
+		entry->next = *bucket;
+		*bucket = entry;
+	}
+	return entry;
+}
+
+/** Remove entry from the buckets (called with the lock held) */
+static void mrcp_fetch_entry_unlink(mrcp_fetch_cache_t *cache, mrcp_fetch_entry_t *entry)
+{
+	mrcp_fetch_entry_t **it;
+	if(entry->linked == FALSE) {
+		return;
+	}
+	for(it = mrcp_fetch_bucket_get(cache,entry->hash); *it; it = &(*it)->next) {
+		if(*it == entry) {
+			*it = entry->next;
+			break;
+		}
+	}
+	entry->next = NULL;
+	entry->linked = FALSE;
+	if(entry->fetched == TRUE) {
+		cache->count--;
+		cache->size -= mrcp_fetch_entry_size(entry);
+	}
+}
+
+/** Drop reference to entry, prepend the entry to the list to free, if unlinked (called with the lock held) */
+static void mrcp_fetch_entry_unref(mrcp_fetch_cache_t *cache, mrcp_fetch_entry_t *entry, mrcp_fetch_entry_t **garbage)
+{
+	if(!entry->ref_count || --entry->ref_count) {
+		return;
+	}
+	if(entry->linked == TRUE) {
+		APR_RING_INSERT_TAIL(&cache->idle,entry,mrcp_fetch_entry_t,link);
+	}
+	else {
+		entry->next = *garbage;
+		*garbage = entry;
+	}
+}
+
+/** Take reference to entry found (called with the lock held) */
+static APR_INLINE void mrcp_fetch_entry_ref(mrcp_fetch_entry_t *entry)
+{
+	if(entry->ref_count++ == 0) {
+		/* fetched entries only are unreferenced */
+		APR_RING_REMOVE(entry,link);
+	}
+}
+
+/** Store the fetched document in the entry (called with the lock held) */
+static void mrcp_fetch_entry_publish(mrcp_fetch_cache_t *cache, mrcp_fetch_entry_t *entry, mrcp_fetch_doc_t *doc)
+{
+	entry->doc = *doc;
+	mrcp_fetch_doc_reset(doc);
+	entry->fetched = TRUE;
+	if(entry->linked == TRUE) {
+		cache->count++;
+		cache->size += mrcp_fetch_entry_size(entry);
+		if(entry->doc.no_store == TRUE || mrcp_fetch_entry_size(entry) > cache->config.max_size) {
+			/* delivered to the waiters, but not kept */
+			mrcp_fetch_entry_unlink(cache,entry);
+		}
+	}
+}
+
+/** Unlink least recently used entries over the budget (called with the lock held) */
+static void mrcp_fetch_cache_evict(mrcp_fetch_cache_t *cache, mrcp_fetch_entry_t **garbage)
+{
+	mrcp_fetch_entry_t *entry;
+	while(cache->size > cache->config.max_size && !APR_RING_EMPTY(&cache->idle,mrcp_fetch_entry_t,link)) {
+		entry = APR_RING_FIRST(&cache->idle);
+		APR_RING_REMOVE(entry,link);
+		mrcp_fetch_entry_unlink(cache,entry);
+		entry->next = *garbage;
+		*garbage = entry;
+	}
+}
+
+/** Free entries of the list (called with no lock held) */
+static void mrcp_fetch_entries_free(mrcp_fetch_entry_t *entry)
+{
+	mrcp_fetch_entry_t *next;
+	for(; entry; entry = next) {
+		next = entry->next;
+		mrcp_fetch_doc_free(&entry->doc);
+		free(entry);
+	}
+}
+
+/** Compose the path of the file the document of the entry is stored in */
+static char* mrcp_fetch_file_path_get(const mrcp_fetch_cache_t *cache, const mrcp_fetch_entry_t *entry, apr_pool_t *pool)
+{
+	char *file_path = NULL;
+	apr_filepath_merge(&file_path,cache->config.dir_path,
+		apr_psprintf(pool,"%08x.fetch",entry->hash),
+		APR_FILEPATH_NATIVE,pool);
+	return file_path;
+}
+
+/** Get the next line of the header of the stored document */
+static char* mrcp_fetch_file_line_get(char **pos, char *end)
+{
+	char *line = *pos;
+	char *lf = memchr(line,APT_TOKEN_LF,end - line);
+	if(!lf) {
+		return NULL;
+	}
+	*lf = '\0';
+	*pos = lf + 1;
+	return line;
+}
+
+/**
+ * Read the document stored by the previous fetch of the URI.
+ * The file starts with the lines of the URI, the entity tag, the content type,
+ * the time of expiration and the size of the content, followed by the content.
+ */
+static apt_bool_t mrcp_fetch_file_read(const mrcp_fetch_cache_t *cache, const mrcp_fetch_entry_t *entry, mrcp_fetch_doc_t *doc, apr_pool_t *pool)
+{
+	apr_file_t *file;
+	apr_finfo_t finfo;
+	char *buf;
+	char *pos;
+	char *end;
+	char *uri;
+	char *etag;
+	char *content_type;
+	char *expires;
+	char *size;
+	const char *file_path = mrcp_fetch_file_path_get(cache,entry,pool);
+	if(!file_path) {
+		return FALSE;
+	}
+
+	if(apr_file_open(&file,file_path,APR_FOPEN_READ | APR_FOPEN_BINARY,APR_OS_DEFAULT,pool) != APR_SUCCESS) {
+		return FALSE;
+	}
+	if(apr_file_info_get(&finfo,APR_FINFO_SIZE,file) != APR_SUCCESS ||
+		(apr_size_t)finfo.size > cache->config.max_size + entry->uri.length + MRCP_FETCH_BUFFER_SIZE) {
+		apr_file_close(file);
+		return FALSE;
+	}
+	buf = apr_palloc(pool,(apr_size_t)finfo.size + 1);
+	if(apr_file_read_full(file,buf,(apr_size_t)finfo.size,NULL) != APR_SUCCESS) {
+		apr_file_close(file);
+		return FALSE;
+	}
+	apr_file_close(file);
+
+	pos = buf;
+	end = buf + (apr_size_t)finfo.size;
+	uri = mrcp_fetch_file_line_get(&pos,end);
+	etag = uri ? mrcp_fetch_file_line_get(&pos,end) : NULL;
+	content_type = etag ? mrcp_fetch_file_line_get(&pos,end) : NULL;
+	expires = content_type ? mrcp_fetch_file_line_get(&pos,end) : NULL;
+	size = expires ? mrcp_fetch_file_line_get(&pos,end) : NULL;
+	if(!size || strcmp(uri,entry->uri.buf) != 0 || (apr_size_t)apr_atoi64(size) != (apr_size_t)(end - pos)) {
+		/* another URI of the same hash or a partially written file */
+		return FALSE;
+	}
+
+	doc->size = end - pos;
+	doc->data = malloc(doc->size ? doc->size : 1);
+	if(!doc->data) {
+		return FALSE;
+	}
+	memcpy(doc->data,pos,doc->size);
+	doc->etag = *etag ? mrcp_fetch_strdup(etag) : NULL;
+	doc->content_type = *content_type ? mrcp_fetch_strdup(content_type) : NULL;
+	doc->expires = apr_atoi64(expires);
+	doc->no_store = FALSE;
+	return TRUE;
+}
+
+/** Store the fetched document, the file is replaced at once, so that readers never see it partially written */
+static void mrcp_fetch_file_write(const mrcp_fetch_cache_t *cache, const mrcp_fetch_entry_t *entry, const mrcp_fetch_doc_t *doc, apr_pool_t *pool)
+{
+	apr_file_t *file;
+	const char *head;
+	char *temp_path;
+	apt_bool_t status;
+	const char *file_path = mrcp_fetch_file_path_get(cache,entry,pool);
+	if(!file_path) {
+		return;
+	}
+	if(doc->no_store == TRUE) {
+		apr_file_remove(file_path,pool);
+		return;
+	}
+
+	temp_path = apr_pstrcat(pool,file_path,".tmp",NULL);
+	if(apr_file_open(&file,temp_path,APR_FOPEN_WRITE | APR_FOPEN_CREATE | APR_FOPEN_TRUNCATE | APR_FOPEN_BINARY,
+			APR_OS_DEFAULT,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open Fetch Cache File [%s]",temp_path);
+		return;
+	}
+	head = apr_psprintf(pool,"%s\n%s\n%s\n%"APR_TIME_T_FMT"\n%"APR_SIZE_T_FMT"\n",
+		entry->uri.buf,
+		doc->etag ? doc->etag : "",
+		doc->content_type ? doc->content_type : "",
+		doc->expires,
+		doc->size);
+	status = (apr_file_write_full(file,head,strlen(head),NULL) == APR_SUCCESS &&
+		(!doc->size || apr_file_write_full(file,doc->data,doc->size,NULL) == APR_SUCCESS)) ? TRUE : FALSE;
+	if(apr_file_close(file) != APR_SUCCESS) {
+		status = FALSE;
+	}
+	if(status == FALSE || apr_file_rename(temp_path,file_path,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Write Fetch Cache File [%s]",file_path);
+		apr_file_remove(temp_path,pool);
+	}
+}
+
+/** Split http:// URI into the host, the port and the path */
+static apt_bool_t mrcp_fetch_uri_parse(const char *uri, char **host, apr_port_t *port, char **path, apr_pool_t *pool)
+{
+	const char *authority;
+	const char *slash;
+	const char *colon;
+	const char *end;
+	if(strncasecmp(uri,"http://",7) != 0 || strpbrk(uri,"\r\n \t")) {
+		return FALSE;
+	}
+
+	authority = uri + 7;
+	end = authority + strcspn(authority,"#");
+	slash = memchr(authority,'/',end - authority);
+	if(!slash) {
+		slash = authority + strcspn(authority,"?#");
+	}
+	colon = memchr(authority,':',slash - authority);
+	if(colon) {
+		*port = (apr_port_t)atoi(colon + 1);
+		if(!*port) {
+			return FALSE;
+		}
+	}
+	else {
+		colon = slash;
+		*port = 80;
+	}
+	if(colon == authority) {
+		return FALSE;
+	}
+	*host = apr_pstrmemdup(pool,authority,colon - authority);
+	if(*slash == '/') {
+		*path = apr_pstrmemdup(pool,slash,end - slash);
+	}
+	else {
+		*path = apr_pstrcat(pool,"/",apr_pstrmemdup(pool,slash,end - slash),NULL);
+	}
+	return TRUE;
+}
+
+static void mrcp_fetch_conn_close(mrcp_fetch_conn_t *conn)
+{
+	apr_socket_close(conn->sock);
+	apr_pool_destroy(conn->pool);
+}
+
+/** Take an idle connection to the host or connect anew */
+static mrcp_fetch_conn_t* mrcp_fetch_conn_acquire(
+								mrcp_fetch_cache_t *cache,
+								const char *host,
+								apr_port_t port,
+								const char *key,
+								apt_bool_t *reused,
+								apr_pool_t *pool)
+{
+	mrcp_fetch_conn_t *conn = NULL;
+	mrcp_fetch_conn_t *expired = NULL;
+	mrcp_fetch_host_t *fetch_host;
+	apr_sockaddr_t *sockaddr;
+	apr_pool_t *conn_pool;
+	apr_time_t now = apr_time_now();
+
+	apr_thread_mutex_lock(cache->mutex);
+	fetch_host = apr_hash_get(cache->hosts,key,APR_HASH_KEY_STRING);
+	while(fetch_host && fetch_host->idle) {
+		conn = fetch_host->idle;
+		fetch_host->idle = conn->next;
+		fetch_host->count--;
+		if(now - conn->idle_time < MRCP_FETCH_IDLE_TIMEOUT) {
+			break;
+		}
+		conn->next = expired;
+		expired = conn;
+		conn = NULL;
+	}
+	apr_thread_mutex_unlock(cache->mutex);
+
+	for(; expired; expired = expired->next) {
+		mrcp_fetch_conn_close(expired);
+	}
+	if(conn) {
+		*reused = TRUE;
+		conn->next = NULL;
+		conn->pos = 0;
+		conn->length = 0;
+		return conn;
+	}
+
+	*reused = FALSE;
+	if(apr_sockaddr_info_get(&sockaddr,host,APR_UNSPEC,port,0,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Resolve Host [%s]",host);
+		return NULL;
+	}
+	conn_pool = apt_pool_create();
+	if(!conn_pool) {
+		return NULL;
+	}
+	conn = apr_palloc(conn_pool,sizeof(mrcp_fetch_conn_t));
+	conn->next = NULL;
+	conn->sock = NULL;
+	conn->idle_time = 0;
+	conn->pos = 0;
+	conn->length = 0;
+	conn->pool = conn_pool;
+	if(apr_socket_create(&conn->sock,sockaddr->family,SOCK_STREAM,APR_PROTO_TCP,conn_pool) != APR_SUCCESS) {
+		apr_pool_destroy(conn_pool);
+		return NULL;
+	}
+	apr_socket_timeout_set(conn->sock,apr_time_from_msec(cache->config.timeout));
+	if(apr_socket_connect(conn->sock,sockaddr) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Connect to Host [%s:%hu]",host,port);
+		mrcp_fetch_conn_close(conn);
+		return NULL;
+	}
+	return conn;
+}
+
+/** Keep the connection for the next fetches from the host or close it */
+static void mrcp_fetch_conn_release(mrcp_fetch_cache_t *cache, mrcp_fetch_conn_t *conn, const char *key, apt_bool_t keep_alive)
+{
+	mrcp_fetch_host_t *fetch_host;
+	if(keep_alive == TRUE && conn->pos == conn->length) {
+		apr_thread_mutex_lock(cache->mutex);
+		fetch_host = apr_hash_get(cache->hosts,key,APR_HASH_KEY_STRING);
+		if(!fetch_host) {
+			fetch_host = apr_palloc(cache->pool,sizeof(mrcp_fetch_host_t));
+			fetch_host->idle = NULL;
+			fetch_host->count = 0;
+			apr_hash_set(cache->hosts,apr_pstrdup(cache->pool,key),APR_HASH_KEY_STRING,fetch_host);
+		}
+		if(fetch_host->count < cache->config.max_idle_connections) {
+			conn->idle_time = apr_time_now();
+			conn->next = fetch_host->idle;
+			fetch_host->idle = conn;
+			fetch_host->count++;
+			conn = NULL;
+		}
+		apr_thread_mutex_unlock(cache->mutex);
+	}
+	if(conn) {
+		mrcp_fetch_conn_close(conn);
+	}
+}
+
+static apt_bool_t mrcp_fetch_conn_send(mrcp_fetch_conn_t *conn, const char *data, apr_size_t size)
+{
+	apr_size_t length;
+	while(size) {
+		length = size;
+		if(apr_socket_send(conn->sock,data,&length) != APR_SUCCESS) {
+			return FALSE;
+		}
+		data += length;
+		size -= length;
+	}
+	return TRUE;
+}
+
+static apt_bool_t mrcp_fetch_conn_fill(mrcp_fetch_conn_t *conn)
+{
+	apr_size_t length = sizeof(conn->buf);
+	if(apr_socket_recv(conn->sock,conn->buf,&length) != APR_SUCCESS || !length) {
+		return FALSE;
+	}
+	conn->pos = 0;
+	conn->length = length;
+	return TRUE;
+}
+
+/** Read the line terminated by LF or CRLF */
+static apt_bool_t mrcp_fetch_line_read(mrcp_fetch_conn_t *conn, char *line, apr_size_t max_size)
+{
+	apr_size_t length = 0;
+	char ch;
+	for(;;) {
+		if(conn->pos == conn->length && mrcp_fetch_conn_fill(conn) == FALSE) {
+			return FALSE;
+		}
+		ch = conn->buf[conn->pos++];
+		if(ch == APT_TOKEN_LF) {
+			break;
+		}
+		if(length + 1 >= max_size) {
+			return FALSE;
+		}
+		line[length++] = ch;
+	}
+	if(length && line[length-1] == APT_TOKEN_CR) {
+		length--;
+	}
+	line[length] = '\0';
+	return TRUE;
+}
+
+/** Append the size bytes of the body to the content of the document */
+static apt_bool_t mrcp_fetch_body_read(mrcp_fetch_cache_t *cache, mrcp_fetch_conn_t *conn, mrcp_fetch_doc_t *doc, apr_size_t *capacity, apr_size_t size)
+{
+	apr_size_t length;
+	if(mrcp_fetch_doc_reserve(doc,capacity,size,cache->config.max_size) == FALSE) {
+		return FALSE;
+	}
+	while(size) {
+		if(conn->pos == conn->length && mrcp_fetch_conn_fill(conn) == FALSE) {
+			return FALSE;
+		}
+		length = conn->length - conn->pos;
+		if(length > size) {
+			length = size;
+		}
+		memcpy(doc->data + doc->size,conn->buf + conn->pos,length);
+		conn->pos += length;
+		doc->size += length;
+		size -= length;
+	}
+	return TRUE;
+}
+
+/** Append the chunked body to the content of the document */
+static apt_bool_t mrcp_fetch_chunked_body_read(mrcp_fetch_cache_t *cache, mrcp_fetch_conn_t *conn, mrcp_fetch_doc_t *doc, apr_size_t *capacity)
+{
+	char line[MRCP_FETCH_BUFFER_SIZE];
+	apr_size_t chunk_size;
+	for(;;) {
+		if(mrcp_fetch_line_read(conn,line,sizeof(line)) == FALSE) {
+			return FALSE;
+		}
+		chunk_size = (apr_size_t)strtoul(line,NULL,16);
+		if(!chunk_size) {
+			break;
+		}
+		if(mrcp_fetch_body_read(cache,conn,doc,capacity,chunk_size) == FALSE ||
+			mrcp_fetch_line_read(conn,line,sizeof(line)) == FALSE) {
+			return FALSE;
+		}
+	}
+	/* trailer, terminated by an empty line */
+	do {
+		if(mrcp_fetch_line_read(conn,line,sizeof(line)) == FALSE) {
+			return FALSE;
+		}
+	}
+	while(*line);
+	return TRUE;
+}
+
+/** Append the body, delimited by the end of the connection, to the content of the document */
+static apt_bool_t mrcp_fetch_closed_body_read(mrcp_fetch_cache_t *cache, mrcp_fetch_conn_t *conn, mrcp_fetch_doc_t *doc, apr_size_t *capacity)
+{
+	apr_size_t length;
+	for(;;) {
+		length = conn->length - conn->pos;
+		if(length && mrcp_fetch_body_read(cache,conn,doc,capacity,length) == FALSE) {
+			return FALSE;
+		}
+		if(mrcp_fetch_conn_fill(conn) == FALSE) {
+			break;
+		}
+	}
+	return TRUE;
+}
+
+/** Get the freshness of the response from Cache-Control */
+static void mrcp_fetch_cache_control_parse(const char *value, apt_bool_t *no_cache, apt_bool_t *no_store, apr_int64_t *max_age)
+{
+	const char *pos = value;
+	apr_size_t length;
+	while(*pos) {
+		pos += strspn(pos," \t,");
+		length = strcspn(pos,",");
+		if(strncasecmp(pos,"no-store",8) == 0) {
+			*no_store = TRUE;
+		}
+		else if(strncasecmp(pos,"no-cache",8) == 0 || strncasecmp(pos,"must-revalidate",15) == 0) {
+			*no_cache = TRUE;
+		}
+		else if(strncasecmp(pos,"max-age=",8) == 0) {
+			*max_age = apr_atoi64(pos + 8);
+		}
+		pos += length;
+	}
+}
+
+/** Receive the response to GET */
+static mrcp_fetch_status_e mrcp_fetch_response_receive(
+								mrcp_fetch_cache_t *cache,
+								mrcp_fetch_conn_t *conn,
+								mrcp_fetch_doc_t *doc,
+								char **location,
+								apt_bool_t *keep_alive,
+								apt_bool_t *responded,
+								apr_pool_t *pool)
+{
+	char line[MRCP_FETCH_BUFFER_SIZE];
+	char *value;
+	apr_size_t capacity = 0;
+	apr_int64_t content_length = -1;
+	apr_int64_t max_age = -1;
+	apt_bool_t chunked = FALSE;
+	apt_bool_t no_cache = FALSE;
+	apt_bool_t no_store = FALSE;
+	apt_bool_t body_read;
+	int status_code;
+
+	*keep_alive = FALSE;
+	*responded = FALSE;
+	if(mrcp_fetch_line_read(conn,line,sizeof(line)) == FALSE) {
+		return MRCP_FETCH_STATUS_FAILED;
+	}
+	*responded = TRUE;
+	if(strncmp(line,"HTTP/1.",7) != 0 || strlen(line) < 12) {
+		return MRCP_FETCH_STATUS_FAILED;
+	}
+	/* HTTP/1.1 connections are persistent by default */
+	*keep_alive = (line[7] == '1') ? TRUE : FALSE;
+	status_code = atoi(line + 9);
+
+	for(;;) {
+		if(mrcp_fetch_line_read(conn,line,sizeof(line)) == FALSE) {
+			*keep_alive = FALSE;
+			return MRCP_FETCH_STATUS_FAILED;
+		}
+		if(!*line) {
+			break;
+		}
+		value = strchr(line,':');
+		if(!value) {
+			continue;
+		}
+		*value++ = '\0';
+		value += strspn(value," \t");
+		if(strcasecmp(line,"Content-Length") == 0) {
+			content_length = apr_atoi64(value);
+		}
+		else if(strcasecmp(line,"Transfer-Encoding") == 0) {
+			chunked = strcasecmp(value,"chunked") == 0 ? TRUE : FALSE;
+		}
+		else if(strcasecmp(line,"Connection") == 0) {
+			if(strcasecmp(value,"close") == 0) {
+				*keep_alive = FALSE;
+			}
+			else if(strcasecmp(value,"keep-alive") == 0) {
+				*keep_alive = TRUE;
+			}
+		}
+		else if(strcasecmp(line,"Cache-Control") == 0) {
+			mrcp_fetch_cache_control_parse(value,&no_cache,&no_store,&max_age);
+		}
+		else if(strcasecmp(line,"ETag") == 0) {
+			mrcp_fetch_doc_str_set(&doc->etag,value);
+		}
+		else if(strcasecmp(line,"Content-Type") == 0) {
+			mrcp_fetch_doc_str_set(&doc->content_type,value);
+		}
+		else if(strcasecmp(line,"Location") == 0) {
+			*location = apr_pstrdup(pool,value);
+		}
+	}
+
+	/* the document is fresh for max-age, revalidated on every use for no-cache */
+	if(no_cache == TRUE) {
+		max_age = 0;
+	}
+	else if(max_age < 0) {
+		max_age = cache->config.default_max_age;
+	}
+	doc->expires = apr_time_now() + apr_time_from_sec(max_age);
+	doc->no_store = no_store;
+
+	if(status_code == 304 || status_code == 204 || (status_code >= 100 && status_code < 200)) {
+		/* no body */
+		return status_code == 304 ? MRCP_FETCH_STATUS_NOT_MODIFIED : MRCP_FETCH_STATUS_FAILED;
+	}
+	if(status_code != 200) {
+		/* the body is not read, the connection is not reused */
+		*keep_alive = FALSE;
+		if(status_code >= 300 && status_code < 400 && status_code != 304 && *location) {
+			return MRCP_FETCH_STATUS_REDIRECT;
+		}
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Status Code [%d]",status_code);
+		return MRCP_FETCH_STATUS_FAILED;
+	}
+
+	if(chunked == TRUE) {
+		body_read = mrcp_fetch_chunked_body_read(cache,conn,doc,&capacity);
+	}
+	else if(content_length >= 0) {
+		body_read = mrcp_fetch_body_read(cache,conn,doc,&capacity,(apr_size_t)content_length);
+	}
+	else {
+		*keep_alive = FALSE;
+		body_read = mrcp_fetch_closed_body_read(cache,conn,doc,&capacity);
+	}
+	if(body_read == FALSE) {
+		*keep_alive = FALSE;
+		return MRCP_FETCH_STATUS_FAILED;
+	}
+	if(!doc->data) {
+		/* empty document */
+		doc->data = malloc(1);
+		if(!doc->data) {
+			return MRCP_FETCH_STATUS_FAILED;
+		}
+	}
+	else if(doc->size < capacity) {
+		/* shrink to fit, the budget is accounted by the actual size */
+		char *data = realloc(doc->data,doc->size);
+		if(data) {
+			doc->data = data;
+		}
+	}
+	return MRCP_FETCH_STATUS_OK;
+}
+
+/** Send GET to the host and receive the response, retry once, if an idle connection turns out to be closed */
+static mrcp_fetch_status_e mrcp_fetch_http_request(
+								mrcp_fetch_cache_t *cache,
+								const char *uri,
+								const char *etag,
+								mrcp_fetch_doc_t *doc,
+								char **location,
+								apr_pool_t *pool)
+{
+	mrcp_fetch_conn_t *conn;
+	mrcp_fetch_status_e status;
+	char *host;
+	char *path;
+	char *key;
+	char *request;
+	apr_port_t port;
+	apt_bool_t reused;
+	apt_bool_t keep_alive;
+	apt_bool_t responded;
+	int attempt;
+
+	if(mrcp_fetch_uri_parse(uri,&host,&port,&path,pool) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unsupported URI [%s]",uri);
+		return MRCP_FETCH_STATUS_FAILED;
+	}
+	key = apr_psprintf(pool,"%s:%hu",host,port);
+	request = apr_psprintf(pool,
+		"GET %s HTTP/1.1\r\n"
+		"Host: %s\r\n"
+		"User-Agent: UniMRCP\r\n"
+		"Accept: */*\r\n"
+		"%s%s%s"
+		"\r\n",
+		path,
+		port == 80 ? host : key,
+		etag ? "If-None-Match: " : "",
+		etag ? etag : "",
+		etag ? "\r\n" : "");
+
+	for(attempt = 0; attempt < 2; attempt++) {
+		conn = mrcp_fetch_conn_acquire(cache,host,port,key,&reused,pool);
+		if(!conn) {
+			return MRCP_FETCH_STATUS_FAILED;
+		}
+		keep_alive = FALSE;
+		responded = FALSE;
+		status = MRCP_FETCH_STATUS_FAILED;
+		if(mrcp_fetch_conn_send(conn,request,strlen(request)) == TRUE) {
+			status = mrcp_fetch_response_receive(cache,conn,doc,location,&keep_alive,&responded,pool);
+		}
+		mrcp_fetch_conn_release(cache,conn,key,status == MRCP_FETCH_STATUS_FAILED ? FALSE : keep_alive);
+		if(status != MRCP_FETCH_STATUS_FAILED || responded == TRUE || reused == FALSE) {
+			return status;
+		}
+		/* the idle connection has been closed by the server meanwhile */
+		mrcp_fetch_doc_free(doc);
+	}
+	return MRCP_FETCH_STATUS_FAILED;
+}
+
+/** Fetch the document, conditionally, if the entity tag of the cached one is known */
+static mrcp_fetch_status_e mrcp_fetch_http_get(mrcp_fetch_cache_t *cache, const char *uri, const char *etag, mrcp_fetch_doc_t *doc, apr_pool_t *pool)
+{
+	mrcp_fetch_status_e status;
+	char *location;
+	int redirects = 0;
+	do {
+		location = NULL;
+		mrcp_fetch_doc_free(doc);
+		status = mrcp_fetch_http_request(cache,uri,etag,doc,&location,pool);
+		if(status == MRCP_FETCH_STATUS_REDIRECT) {
+			/* the entity tag is of the document at the original location */
+			uri = location;
+			etag = NULL;
+		}
+	}
+	while(status == MRCP_FETCH_STATUS_REDIRECT && ++redirects <= MRCP_FETCH_MAX_REDIRECTS);
+
+	if(status != MRCP_FETCH_STATUS_OK && status != MRCP_FETCH_STATUS_NOT_MODIFIED) {
+		mrcp_fetch_doc_free(doc);
+		return MRCP_FETCH_STATUS_FAILED;
+	}
+	return status;
+}
+
+/** Fetch the document of the entry being loaded or revalidated, return the referenced entry to use (called with no lock held) */
+static mrcp_fetch_entry_t* mrcp_fetch_entry_refresh(mrcp_fetch_cache_t *cache, mrcp_fetch_entry_t *entry)
+{
+	mrcp_fetch_doc_t doc;
+	mrcp_fetch_doc_t stored;
+	const mrcp_fetch_doc_t *validator = NULL;
+	mrcp_fetch_entry_t *result = entry;
+	mrcp_fetch_entry_t *garbage = NULL;
+	mrcp_fetch_status_e status;
+	apr_time_t start_time = apr_time_now();
+	/* the flag is changed by the fetch in progress only */
+	apt_bool_t loading = entry->loading;
+	apr_pool_t *pool = apt_pool_create();
+
+	mrcp_fetch_doc_reset(&doc);
+	mrcp_fetch_doc_reset(&stored);
+	if(loading == FALSE) {
+		/* the content of fetched entries is not modified, while referenced */
+		validator = &entry->doc;
+	}
+	else if(cache->config.dir_path && pool && mrcp_fetch_file_read(cache,entry,&stored,pool) == TRUE) {
+		validator = &stored;
+	}
+
+	if(validator == &stored && stored.expires > start_time) {
+		/* stored by the previous run, still fresh */
+		status = MRCP_FETCH_STATUS_NOT_MODIFIED;
+		doc.expires = stored.expires;
+	}
+	else if(pool) {
+		status = mrcp_fetch_http_get(cache,entry->uri.buf,validator ? validator->etag : NULL,&doc,pool);
+		if(status == MRCP_FETCH_STATUS_NOT_MODIFIED && !validator) {
+			/* unconditional GET is never expected to get 304 */
+			status = MRCP_FETCH_STATUS_FAILED;
+		}
+		if(status == MRCP_FETCH_STATUS_OK && cache->config.dir_path) {
+			mrcp_fetch_file_write(cache,entry,&doc,pool);
+		}
+		else if(status == MRCP_FETCH_STATUS_NOT_MODIFIED && cache->config.dir_path) {
+			mrcp_fetch_doc_t updated = *validator;
+			updated.expires = doc.expires;
+			if(doc.etag) {
+				updated.etag = doc.etag;
+			}
+			mrcp_fetch_file_write(cache,entry,&updated,pool);
+		}
+	}
+	else {
+		status = MRCP_FETCH_STATUS_FAILED;
+	}
+
+	if(status == MRCP_FETCH_STATUS_FAILED) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Fetch [%s]%s",
+			entry->uri.buf,
+			validator ? ", serve stale document" : "");
+	}
+	else {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"%s [%s] %"APR_SIZE_T_FMT" bytes in %"APR_TIME_T_FMT" usec",
+			status == MRCP_FETCH_STATUS_OK ? "Fetch" : "Revalidate",
+			entry->uri.buf,
+			status == MRCP_FETCH_STATUS_OK ? doc.size : validator->size,
+			apr_time_now() - start_time);
+	}
+
+	apr_thread_mutex_lock(cache->mutex);
+	if(loading == TRUE) {
+		if(status != MRCP_FETCH_STATUS_OK && validator) {
+			/* the stored document is still valid or, if failed, served as stale for a while */
+			if(status == MRCP_FETCH_STATUS_NOT_MODIFIED) {
+				stored.expires = doc.expires;
+				if(doc.etag) {
+					mrcp_fetch_doc_str_set(&stored.etag,doc.etag);
+				}
+			}
+			else {
+				stored.expires = apr_time_now() + MRCP_FETCH_RETRY_INTERVAL;
+			}
+			mrcp_fetch_entry_publish(cache,entry,&stored);
+		}
+		else if(status == MRCP_FETCH_STATUS_OK) {
+			mrcp_fetch_entry_publish(cache,entry,&doc);
+		}
+		else {
+			/* the next request retries to fetch the document */
+			mrcp_fetch_entry_unlink(cache,entry);
+			mrcp_fetch_entry_unref(cache,entry,&garbage);
+			result = NULL;
+		}
+		entry->loading = FALSE;
+	}
+	else {
+		if(status == MRCP_FETCH_STATUS_OK) {
+			/* referenced stale document stays with its holders, the new one replaces it */
+			mrcp_fetch_entry_t *replacement = NULL;
+			if(entry->linked == TRUE) {
+				mrcp_fetch_entry_unlink(cache,entry);
+				replacement = mrcp_fetch_entry_create(cache,entry->hash,&entry->uri,TRUE);
+			}
+			if(replacement) {
+				mrcp_fetch_entry_publish(cache,replacement,&doc);
+				replacement->loading = FALSE;
+				mrcp_fetch_entry_unref(cache,entry,&garbage);
+				result = replacement;
+			}
+		}
+		else if(status == MRCP_FETCH_STATUS_NOT_MODIFIED) {
+			entry->doc.expires = doc.expires;
+		}
+		else {
+			entry->doc.expires = apr_time_now() + MRCP_FETCH_RETRY_INTERVAL;
+		}
+		entry->revalidating = FALSE;
+	}
+	apr_thread_cond_broadcast(cache->cond);
+	mrcp_fetch_cache_evict(cache,&garbage);
+	apr_thread_mutex_unlock(cache->mutex);
+
+	mrcp_fetch_entries_free(garbage);
+	mrcp_fetch_doc_free(&doc);
+	mrcp_fetch_doc_free(&stored);
+	if(pool) {
+		apr_pool_destroy(pool);
+	}
+	return result;
+}
+
+/** Prefetch job, run by the executor */
+static void mrcp_fetch_prefetch_process(void *obj, void *arg)
+{
+	mrcp_fetch_cache_t *cache = obj;
+	mrcp_fetch_entry_t *entry = mrcp_fetch_entry_refresh(cache,arg);
+	mrcp_fetch_cache_release(cache,entry);
+}
+
+/** Create fetch cache */
+MRCP_DECLARE(mrcp_fetch_cache_t*) mrcp_fetch_cache_create(
+										const mrcp_fetch_cache_config_t *config,
+										apt_executor_t *executor,
+										apr_pool_t *pool)
+{
+	apr_size_t i;
+	mrcp_fetch_cache_t *cache;
+	if(!config || !config->max_size) {
+		return NULL;
+	}
+
+	cache = apr_pcalloc(pool,sizeof(mrcp_fetch_cache_t));
+	APR_RING_INIT(&cache->idle,mrcp_fetch_entry_t,link);
+	cache->count = 0;
+	cache->size = 0;
+	cache->config = *config;
+	cache->config.dir_path = NULL;
+	if(config->dir_path) {
+		if(apr_dir_make_recursive(config->dir_path,APR_OS_DEFAULT,pool) == APR_SUCCESS) {
+			cache->config.dir_path = apr_pstrdup(pool,config->dir_path);
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Fetch Cache Dir [%s]",config->dir_path);
+		}
+	}
+	cache->hosts = apr_hash_make(pool);
+	cache->next_strand = 0;
+	cache->pool = pool;
+	if(apr_thread_mutex_create(&cache->mutex,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	if(apr_thread_cond_create(&cache->cond,pool) != APR_SUCCESS) {
+		apr_thread_mutex_destroy(cache->mutex);
+		return NULL;
+	}
+	for(i=0; i<MRCP_FETCH_STRAND_COUNT; i++) {
+		cache->strands[i] = executor ? apt_executor_strand_create(executor,MRCP_FETCH_STRAND_SIZE,pool) : NULL;
+	}
+	return cache;
+}
+
+/** Destroy fetch cache, the documents in it and the idle connections */
+MRCP_DECLARE(void) mrcp_fetch_cache_destroy(mrcp_fetch_cache_t *cache)
+{
+	apr_hash_index_t *it;
+	mrcp_fetch_host_t *fetch_host;
+	mrcp_fetch_conn_t *conn;
+	void *val;
+	apr_size_t i;
+	for(i=0; i<MRCP_FETCH_STRAND_COUNT; i++) {
+		if(cache->strands[i]) {
+			/* wait for the prefetches in progress */
+			apt_executor_strand_destroy(cache->strands[i]);
+			cache->strands[i] = NULL;
+		}
+	}
+	for(i=0; i<MRCP_FETCH_BUCKET_COUNT; i++) {
+		mrcp_fetch_entries_free(cache->buckets[i]);
+		cache->buckets[i] = NULL;
+	}
+	APR_RING_INIT(&cache->idle,mrcp_fetch_entry_t,link);
+	cache->count = 0;
+	cache->size = 0;
+	for(it = apr_hash_first(cache->pool,cache->hosts); it; it = apr_hash_next(it)) {
+		apr_hash_this(it,NULL,NULL,&val);
+		fetch_host = val;
+		while(fetch_host->idle) {
+			conn = fetch_host->idle;
+			fetch_host->idle = conn->next;
+			mrcp_fetch_conn_close(conn);
+		}
+		fetch_host->count = 0;
+	}
+	apr_thread_cond_destroy(cache->cond);
+	apr_thread_mutex_destroy(cache->mutex);
+}
+
+/** Fetch document in background */
+MRCP_DECLARE(apt_bool_t) mrcp_fetch_cache_prefetch(mrcp_fetch_cache_t *cache, const apt_str_t *uri)
+{
+	mrcp_fetch_entry_t *entry;
+	mrcp_fetch_entry_t *garbage = NULL;
+	apt_executor_strand_t *strand;
+	apr_uint32_t hash;
+	if(!cache->strands[0] || !uri->length) {
+		return FALSE;
+	}
+
+	hash = mrcp_fetch_hash(uri);
+	apr_thread_mutex_lock(cache->mutex);
+	entry = mrcp_fetch_entry_find(cache,hash,uri);
+	if(entry) {
+		if(entry->loading == TRUE || entry->revalidating == TRUE || entry->doc.expires > apr_time_now()) {
+			/* fresh or being fetched already */
+			apr_thread_mutex_unlock(cache->mutex);
+			return TRUE;
+		}
+		/* stale, revalidate it ahead of the use */
+		mrcp_fetch_entry_ref(entry);
+		entry->revalidating = TRUE;
+	}
+	else {
+		entry = mrcp_fetch_entry_create(cache,hash,uri,TRUE);
+	}
+	strand = cache->strands[cache->next_strand++ % MRCP_FETCH_STRAND_COUNT];
+	apr_thread_mutex_unlock(cache->mutex);
+	if(!entry) {
+		return FALSE;
+	}
+
+	if(apt_executor_job_submit(strand,mrcp_fetch_prefetch_process,cache,entry) == TRUE) {
+		return TRUE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Prefetch [%s]: too many pending",entry->uri.buf);
+	apr_thread_mutex_lock(cache->mutex);
+	if(entry->loading == TRUE) {
+		entry->loading = FALSE;
+		mrcp_fetch_entry_unlink(cache,entry);
+	}
+	entry->revalidating = FALSE;
+	apr_thread_cond_broadcast(cache->cond);
+	mrcp_fetch_entry_unref(cache,entry,&garbage);
+	apr_thread_mutex_unlock(cache->mutex);
+	mrcp_fetch_entries_free(garbage);
+	return FALSE;
+}
+
+/** Get document */
+MRCP_DECLARE(mrcp_fetch_entry_t*) mrcp_fetch_cache_get(mrcp_fetch_cache_t *cache, const apt_str_t *uri)
+{
+	mrcp_fetch_entry_t *entry;
+	mrcp_fetch_entry_t *garbage = NULL;
+	apr_uint32_t hash;
+	if(!uri->length) {
+		return NULL;
+	}
+
+	hash = mrcp_fetch_hash(uri);
+	apr_thread_mutex_lock(cache->mutex);
+	for(;;) {
+		entry = mrcp_fetch_entry_find(cache,hash,uri);
+		if(!entry) {
+			/* not cached, fetch it right away */
+			entry = mrcp_fetch_entry_create(cache,hash,uri,TRUE);
+			apr_thread_mutex_unlock(cache->mutex);
+			mrcp_fetch_entries_free(garbage);
+			return entry ? mrcp_fetch_entry_refresh(cache,entry) : NULL;
+		}
+
+		mrcp_fetch_entry_ref(entry);
+		if(entry->loading == TRUE) {
+			/* being fetched by another thread */
+			while(entry->loading == TRUE) {
+				apr_thread_cond_wait(cache->cond,cache->mutex);
+			}
+			if(entry->fetched == FALSE) {
+				mrcp_fetch_entry_unref(cache,entry,&garbage);
+				entry = NULL;
+			}
+			break;
+		}
+		if(entry->doc.expires > apr_time_now()) {
+			break;
+		}
+		if(entry->revalidating == TRUE) {
+			/* being revalidated by another thread, look the entry up anew, once done */
+			while(entry->revalidating == TRUE) {
+				apr_thread_cond_wait(cache->cond,cache->mutex);
+			}
+			mrcp_fetch_entry_unref(cache,entry,&garbage);
+			continue;
+		}
+
+		/* stale, revalidate it right away */
+		entry->revalidating = TRUE;
+		apr_thread_mutex_unlock(cache->mutex);
+		mrcp_fetch_entries_free(garbage);
+		return mrcp_fetch_entry_refresh(cache,entry);
+	}
+	apr_thread_mutex_unlock(cache->mutex);
+
+	mrcp_fetch_entries_free(garbage);
+	return entry;
+}
+
+/** Release entry got by get */
+MRCP_DECLARE(void) mrcp_fetch_cache_release(mrcp_fetch_cache_t *cache, mrcp_fetch_entry_t *entry)
+{
+	mrcp_fetch_entry_t *garbage = NULL;
+	if(!entry) {
+		return;
+	}
+
+	apr_thread_mutex_lock(cache->mutex);
+	mrcp_fetch_entry_unref(cache,entry,&garbage);
+	mrcp_fetch_cache_evict(cache,&garbage);
+	apr_thread_mutex_unlock(cache->mutex);
+
+	mrcp_fetch_entries_free(garbage);
+}
+
+/** Get the content of the entry */
+MRCP_DECLARE(const char*) mrcp_fetch_entry_data_get(const mrcp_fetch_entry_t *entry, apr_size_t *size)
+{
+	*size = entry->doc.size;
+	return entry->doc.data;
+}
+
+/** Get the content type of the entry */
+MRCP_DECLARE(const char*) mrcp_fetch_entry_content_type_get(const mrcp_fetch_entry_t *entry)
+{
+	return entry->doc.content_type ? entry->doc.content_type : "";
+}
+
+/** Get the number of documents in the cache */
+MRCP_DECLARE(apr_size_t) mrcp_fetch_cache_count_get(const mrcp_fetch_cache_t *cache)
+{
+	return cache->count;
+}
+
+/** Get the memory used by the documents in the cache */
+MRCP_DECLARE(apr_size_t) mrcp_fetch_cache_size_get(const mrcp_fetch_cache_t *cache)
+{
+	return cache->size;
+}
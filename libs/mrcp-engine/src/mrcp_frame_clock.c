@@ -0,0 +1,83 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include "mrcp_frame_clock.h"
+
+/** Find the earliest deadline of started timers */
+static void mrcp_frame_clock_next_update(mrcp_frame_clock_t *clock)
+{
+	apr_size_t i;
+	apt_bool_t found = FALSE;
+	for(i=0; i<MRCP_FRAME_CLOCK_TIMER_COUNT; i++) {
+		if(clock->started & (1 << i)) {
+			if(found == FALSE || clock->deadlines[i] < clock->next) {
+				clock->next = clock->deadlines[i];
+				found = TRUE;
+			}
+		}
+	}
+}
+
+/** Reset frame clock, stop all the timers */
+MRCP_DECLARE(void) mrcp_frame_clock_reset(mrcp_frame_clock_t *clock)
+{
+	clock->elapsed = 0;
+	clock->next = 0;
+	clock->started = 0;
+}
+
+/** Start (restart) timer */
+MRCP_DECLARE(apt_bool_t) mrcp_frame_clock_timer_start(mrcp_frame_clock_t *clock, apr_size_t timer_id, apr_size_t timeout)
+{
+	if(timer_id >= MRCP_FRAME_CLOCK_TIMER_COUNT) {
+		return FALSE;
+	}
+	clock->deadlines[timer_id] = clock->elapsed + timeout;
+	clock->started |= 1 << timer_id;
+	mrcp_frame_clock_next_update(clock);
+	return TRUE;
+}
+
+/** Stop timer */
+MRCP_DECLARE(void) mrcp_frame_clock_timer_stop(mrcp_frame_clock_t *clock, apr_size_t timer_id)
+{
+	if(mrcp_frame_clock_timer_is_started(clock,timer_id) == FALSE) {
+		return;
+	}
+	clock->started &= ~(1 << timer_id);
+	mrcp_frame_clock_next_update(clock);
+}
+
+/** Stop and return the earliest expired timer */
+MRCP_DECLARE(int) mrcp_frame_clock_expire(mrcp_frame_clock_t *clock)
+{
+	apr_size_t i;
+	int timer_id = -1;
+	for(i=0; i<MRCP_FRAME_CLOCK_TIMER_COUNT; i++) {
+		if((clock->started & (1 << i)) && clock->deadlines[i] <= clock->elapsed) {
+			if(timer_id < 0 || clock->deadlines[i] < clock->deadlines[timer_id]) {
+				timer_id = (int)i;
+			}
+		}
+	}
+	if(timer_id >= 0) {
+		clock->started &= ~(1 << timer_id);
+		mrcp_frame_clock_next_update(clock);
+	}
+	return timer_id;
+}
@@ -0,0 +1,297 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <ctype.h>
+#include <apr_ring.h>
+#include <apr_thread_mutex.h>
+#include "mrcp_grammar_cache.h"
+#include "apt_string_intern.h"
+#include "apt_log.h"
+
+/** Grammar cache entry */
+struct mrcp_grammar_entry_t {
+	/** Ring entry of unreferenced (evictable) entries */
+	APR_RING_ENTRY(mrcp_grammar_entry_t) link;
+	/** Next entry in the same bucket */
+	mrcp_grammar_entry_t  *next;
+	/** Hash of content type and content */
+	apr_uint32_t           hash;
+	/** Content type (copy) */
+	apt_str_t              content_type;
+	/** Content (copy), compared on lookup, so that hash collisions never match */
+	apt_str_t              content;
+	/** Compiled grammar */
+	void                  *grammar;
+	/** Handler to destroy compiled grammar by */
+	mrcp_grammar_destroy_f destroy;
+	/** Number of references (the entry is evictable if 0) */
+	apr_size_t             ref_count;
+};
+
+/** Ring of grammar cache entries */
+APR_RING_HEAD(mrcp_grammar_ring_t, mrcp_grammar_entry_t);
+
+/** Grammar cache */
+struct mrcp_grammar_cache_t {
+	/** Hash buckets (power of 2) */
+	mrcp_grammar_entry_t     **buckets;
+	/** Number of buckets minus 1 */
+	apr_size_t                 bucket_mask;
+	/** Unreferenced entries in least recently used order */
+	struct mrcp_grammar_ring_t idle;
+	/** Number of entries */
+	apr_size_t                 count;
+	/** Max number of entries */
+	apr_size_t                 max_count;
+	/** Mutex, the cache is shared among channels processed by several threads */
+	apr_thread_mutex_t        *mutex;
+};
+
+/** Compute FNV-1a hash of content type (case folded) and content */
+static apr_uint32_t mrcp_grammar_hash(const apt_str_t *content_type, const apt_str_t *content)
+{
+	apr_uint32_t hash = 2166136261U;
+	apr_size_t i;
+	for(i=0; i<content_type->length; i++) {
+		hash ^= (apr_byte_t)tolower((apr_byte_t)content_type->buf[i]);
+		hash *= 16777619U;
+	}
+	/* separate the type from the content */
+	hash ^= 0xff;
+	hash *= 16777619U;
+	for(i=0; i<content->length; i++) {
+		hash ^= (apr_byte_t)content->buf[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static APR_INLINE apr_size_t mrcp_grammar_bucket_get(const mrcp_grammar_cache_t *cache, apr_uint32_t hash)
+{
+	return (apr_size_t)(hash ^ (hash >> 16)) & cache->bucket_mask;
+}
+
+static mrcp_grammar_entry_t* mrcp_grammar_entry_find(
+								mrcp_grammar_cache_t *cache,
+								apr_uint32_t hash,
+								const apt_str_t *content_type,
+								const apt_str_t *content)
+{
+	mrcp_grammar_entry_t *entry = cache->buckets[mrcp_grammar_bucket_get(cache,hash)];
+	for(; entry; entry = entry->next) {
+		if(entry->hash == hash &&
+			entry->content.length == content->length &&
+			apt_string_intern_compare(&entry->content_type,content_type) == TRUE &&
+			memcmp(entry->content.buf,content->buf,content->length) == 0) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+static APR_INLINE void mrcp_grammar_entry_ref(mrcp_grammar_entry_t *entry)
+{
+	if(entry->ref_count++ == 0) {
+		APR_RING_REMOVE(entry,link);
+	}
+}
+
+/** Unlink least recently used entries beyond max count, return them as a list */
+static mrcp_grammar_entry_t* mrcp_grammar_cache_evict(mrcp_grammar_cache_t *cache)
+{
+	mrcp_grammar_entry_t *evicted = NULL;
+	mrcp_grammar_entry_t *entry;
+	mrcp_grammar_entry_t **it;
+	while(cache->count > cache->max_count && !APR_RING_EMPTY(&cache->idle,mrcp_grammar_entry_t,link)) {
+		entry = APR_RING_FIRST(&cache->idle);
+		APR_RING_REMOVE(entry,link);
+		for(it = &cache->buckets[mrcp_grammar_bucket_get(cache,entry->hash)]; *it; it = &(*it)->next) {
+			if(*it == entry) {
+				*it = entry->next;
+				break;
+			}
+		}
+		cache->count--;
+		entry->next = evicted;
+		evicted = entry;
+	}
+	return evicted;
+}
+
+/** Destroy entries of the list (called with no lock held, as destroy handlers belong to plugins) */
+static void mrcp_grammar_entries_destroy(mrcp_grammar_entry_t *entry)
+{
+	mrcp_grammar_entry_t *next;
+	for(; entry; entry = next) {
+		next = entry->next;
+		if(entry->destroy) {
+			entry->destroy(entry->grammar);
+		}
+		free(entry);
+	}
+}
+
+/** Create grammar cache */
+MRCP_DECLARE(mrcp_grammar_cache_t*) mrcp_grammar_cache_create(apr_size_t max_count, apr_pool_t *pool)
+{
+	apr_size_t bucket_count = 16;
+	mrcp_grammar_cache_t *cache = apr_palloc(pool,sizeof(mrcp_grammar_cache_t));
+	while(bucket_count < max_count) {
+		bucket_count <<= 1;
+	}
+	cache->buckets = apr_pcalloc(pool,sizeof(mrcp_grammar_entry_t*) * bucket_count);
+	cache->bucket_mask = bucket_count - 1;
+	APR_RING_INIT(&cache->idle,mrcp_grammar_entry_t,link);
+	cache->count = 0;
+	cache->max_count = max_count;
+	cache->mutex = NULL;
+	if(apr_thread_mutex_create(&cache->mutex,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	return cache;
+}
+
+/** Destroy grammar cache and all the grammars in it */
+MRCP_DECLARE(void) mrcp_grammar_cache_destroy(mrcp_grammar_cache_t *cache)
+{
+	apr_size_t i;
+	for(i=0; i<=cache->bucket_mask; i++) {
+		mrcp_grammar_entries_destroy(cache->buckets[i]);
+		cache->buckets[i] = NULL;
+	}
+	APR_RING_INIT(&cache->idle,mrcp_grammar_entry_t,link);
+	cache->count = 0;
+	apr_thread_mutex_destroy(cache->mutex);
+}
+
+/** Look up compiled grammar by content */
+MRCP_DECLARE(mrcp_grammar_entry_t*) mrcp_grammar_cache_lookup(
+										mrcp_grammar_cache_t *cache,
+										const apt_str_t *content_type,
+										const apt_str_t *content)
+{
+	mrcp_grammar_entry_t *entry;
+	apr_uint32_t hash;
+	if(!content->length) {
+		return NULL;
+	}
+
+	hash = mrcp_grammar_hash(content_type,content);
+	apr_thread_mutex_lock(cache->mutex);
+	entry = mrcp_grammar_entry_find(cache,hash,content_type,content);
+	if(entry) {
+		mrcp_grammar_entry_ref(entry);
+	}
+	apr_thread_mutex_unlock(cache->mutex);
+	return entry;
+}
+
+/** Insert compiled grammar */
+MRCP_DECLARE(mrcp_grammar_entry_t*) mrcp_grammar_cache_insert(
+										mrcp_grammar_cache_t *cache,
+										const apt_str_t *content_type,
+										const apt_str_t *content,
+										void *grammar,
+										mrcp_grammar_destroy_f destroy)
+{
+	mrcp_grammar_entry_t *entry;
+	mrcp_grammar_entry_t *evicted;
+	apr_size_t bucket;
+	apr_uint32_t hash;
+	char *buf;
+	if(!content->length) {
+		return NULL;
+	}
+
+	hash = mrcp_grammar_hash(content_type,content);
+	apr_thread_mutex_lock(cache->mutex);
+	entry = mrcp_grammar_entry_find(cache,hash,content_type,content);
+	if(entry) {
+		/* the same grammar has been compiled meanwhile, keep the cached one */
+		mrcp_grammar_entry_ref(entry);
+		apr_thread_mutex_unlock(cache->mutex);
+		if(destroy) {
+			destroy(grammar);
+		}
+		return entry;
+	}
+
+	entry = malloc(sizeof(mrcp_grammar_entry_t) + content_type->length + content->length + 2);
+	if(!entry) {
+		apr_thread_mutex_unlock(cache->mutex);
+		return NULL;
+	}
+	buf = (char*)(entry + 1);
+	memcpy(buf,content_type->buf,content_type->length);
+	buf[content_type->length] = '\0';
+	entry->content_type.buf = buf;
+	entry->content_type.length = content_type->length;
+	/* well-known content types are compared by identity */
+	apt_string_intern(&entry->content_type);
+	buf += content_type->length + 1;
+	memcpy(buf,content->buf,content->length);
+	buf[content->length] = '\0';
+	entry->content.buf = buf;
+	entry->content.length = content->length;
+	entry->hash = hash;
+	entry->grammar = grammar;
+	entry->destroy = destroy;
+	entry->ref_count = 1;
+	APR_RING_ELEM_INIT(entry,link);
+
+	bucket = mrcp_grammar_bucket_get(cache,hash);
+	entry->next = cache->buckets[bucket];
+	cache->buckets[bucket] = entry;
+	cache->count++;
+	evicted = mrcp_grammar_cache_evict(cache);
+	apr_thread_mutex_unlock(cache->mutex);
+
+	mrcp_grammar_entries_destroy(evicted);
+	return entry;
+}
+
+/** Release entry got by lookup or insert */
+MRCP_DECLARE(void) mrcp_grammar_cache_release(mrcp_grammar_cache_t *cache, mrcp_grammar_entry_t *entry)
+{
+	mrcp_grammar_entry_t *evicted = NULL;
+	if(!entry) {
+		return;
+	}
+
+	apr_thread_mutex_lock(cache->mutex);
+	if(entry->ref_count && --entry->ref_count == 0) {
+		APR_RING_INSERT_TAIL(&cache->idle,entry,mrcp_grammar_entry_t,link);
+		evicted = mrcp_grammar_cache_evict(cache);
+	}
+	apr_thread_mutex_unlock(cache->mutex);
+
+	mrcp_grammar_entries_destroy(evicted);
+}
+
+/** Get compiled grammar of the entry */
+MRCP_DECLARE(void*) mrcp_grammar_entry_object_get(const mrcp_grammar_entry_t *entry)
+{
+	return entry->grammar;
+}
+
+/** Get the number of grammars in the cache */
+MRCP_DECLARE(apr_size_t) mrcp_grammar_cache_count_get(const mrcp_grammar_cache_t *cache)
+{
+	return cache->count;
+}
@@ -0,0 +1,417 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <apr_ring.h>
+#include <apr_strings.h>
+#include <apr_thread_mutex.h>
+#include "mrcp_prompt_cache.h"
+#include "mrcp_synth_header.h"
+#include "apt_log.h"
+
+/** Number of hash buckets (power of 2) */
+#define MRCP_PROMPT_BUCKET_COUNT 256
+
+/** Prompt cache entry */
+struct mrcp_prompt_entry_t {
+	/** Ring entry of unreferenced (evictable) entries */
+	APR_RING_ENTRY(mrcp_prompt_entry_t) link;
+	/** Next entry in the same bucket */
+	mrcp_prompt_entry_t *next;
+	/** Hash of the key */
+	apr_uint32_t         hash;
+	/** Key (copy) */
+	apt_str_t            key;
+	/** Rendered audio */
+	char                *data;
+	/** Size of rendered audio */
+	apr_size_t           size;
+	/** Number of references (the entry is evictable if 0) */
+	apr_size_t           ref_count;
+};
+
+/** Ring of prompt cache entries */
+APR_RING_HEAD(mrcp_prompt_ring_t, mrcp_prompt_entry_t);
+
+/** Prompt cache */
+struct mrcp_prompt_cache_t {
+	/** Hash buckets */
+	mrcp_prompt_entry_t      *buckets[MRCP_PROMPT_BUCKET_COUNT];
+	/** Unreferenced entries in least recently used order */
+	struct mrcp_prompt_ring_t idle;
+	/** Memory used by the entries */
+	apr_size_t                size;
+	/** Memory budget */
+	apr_size_t                max_size;
+	/** Mutex, the cache is shared among channels processed by several threads */
+	apr_thread_mutex_t       *mutex;
+};
+
+/** Prompt writer */
+struct mrcp_prompt_writer_t {
+	/** Cache to commit the prompt to */
+	mrcp_prompt_cache_t *cache;
+	/** Entry being recorded */
+	mrcp_prompt_entry_t *entry;
+	/** Allocated size of rendered audio */
+	apr_size_t           capacity;
+	/** Is the prompt over the budget */
+	apt_bool_t           overflow;
+};
+
+/** Synthesizer header fields the rendered audio depends on */
+static const apr_size_t prompt_header_ids[] = {
+	SYNTHESIZER_HEADER_VOICE_GENDER,
+	SYNTHESIZER_HEADER_VOICE_AGE,
+	SYNTHESIZER_HEADER_VOICE_VARIANT,
+	SYNTHESIZER_HEADER_VOICE_NAME,
+	SYNTHESIZER_HEADER_PROSODY_VOLUME,
+	SYNTHESIZER_HEADER_PROSODY_RATE,
+	SYNTHESIZER_HEADER_SPEECH_LANGUAGE
+};
+
+/** Compute FNV-1a hash of the key */
+static apr_uint32_t mrcp_prompt_hash(const apt_str_t *key)
+{
+	apr_uint32_t hash = 2166136261U;
+	apr_size_t i;
+	for(i=0; i<key->length; i++) {
+		hash ^= (apr_byte_t)key->buf[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static APR_INLINE mrcp_prompt_entry_t** mrcp_prompt_bucket_get(mrcp_prompt_cache_t *cache, apr_uint32_t hash)
+{
+	return &cache->buckets[(hash ^ (hash >> 16)) & (MRCP_PROMPT_BUCKET_COUNT - 1)];
+}
+
+static APR_INLINE apr_size_t mrcp_prompt_entry_size(const mrcp_prompt_entry_t *entry)
+{
+	return sizeof(mrcp_prompt_entry_t) + entry->key.length + entry->size;
+}
+
+static mrcp_prompt_entry_t* mrcp_prompt_entry_find(mrcp_prompt_cache_t *cache, apr_uint32_t hash, const apt_str_t *key)
+{
+	mrcp_prompt_entry_t *entry = *mrcp_prompt_bucket_get(cache,hash);
+	for(; entry; entry = entry->next) {
+		if(entry->hash == hash &&
+			entry->key.length == key->length &&
+			memcmp(entry->key.buf,key->buf,key->length) == 0) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+static void mrcp_prompt_entry_free(mrcp_prompt_entry_t *entry)
+{
+	if(entry->data) {
+		free(entry->data);
+	}
+	free(entry);
+}
+
+/** Unlink least recently used entries over the budget, return them as a list */
+static mrcp_prompt_entry_t* mrcp_prompt_cache_evict(mrcp_prompt_cache_t *cache)
+{
+	mrcp_prompt_entry_t *evicted = NULL;
+	mrcp_prompt_entry_t *entry;
+	mrcp_prompt_entry_t **it;
+	while(cache->size > cache->max_size && !APR_RING_EMPTY(&cache->idle,mrcp_prompt_entry_t,link)) {
+		entry = APR_RING_FIRST(&cache->idle);
+		APR_RING_REMOVE(entry,link);
+		for(it = mrcp_prompt_bucket_get(cache,entry->hash); *it; it = &(*it)->next) {
+			if(*it == entry) {
+				*it = entry->next;
+				break;
+			}
+		}
+		cache->size -= mrcp_prompt_entry_size(entry);
+		entry->next = evicted;
+		evicted = entry;
+	}
+	return evicted;
+}
+
+/** Free entries of the list (called with no lock held) */
+static void mrcp_prompt_entries_free(mrcp_prompt_entry_t *entry)
+{
+	mrcp_prompt_entry_t *next;
+	for(; entry; entry = next) {
+		next = entry->next;
+		mrcp_prompt_entry_free(entry);
+	}
+}
+
+/** Create prompt cache */
+MRCP_DECLARE(mrcp_prompt_cache_t*) mrcp_prompt_cache_create(apr_size_t max_size, apr_pool_t *pool)
+{
+	mrcp_prompt_cache_t *cache = apr_pcalloc(pool,sizeof(mrcp_prompt_cache_t));
+	APR_RING_INIT(&cache->idle,mrcp_prompt_entry_t,link);
+	cache->size = 0;
+	cache->max_size = max_size;
+	cache->mutex = NULL;
+	if(apr_thread_mutex_create(&cache->mutex,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	return cache;
+}
+
+/** Destroy prompt cache and all the prompts in it */
+MRCP_DECLARE(void) mrcp_prompt_cache_destroy(mrcp_prompt_cache_t *cache)
+{
+	apr_size_t i;
+	for(i=0; i<MRCP_PROMPT_BUCKET_COUNT; i++) {
+		mrcp_prompt_entries_free(cache->buckets[i]);
+		cache->buckets[i] = NULL;
+	}
+	APR_RING_INIT(&cache->idle,mrcp_prompt_entry_t,link);
+	cache->size = 0;
+	apr_thread_mutex_destroy(cache->mutex);
+}
+
+/** Generate the key of the prompt to synthesize */
+MRCP_DECLARE(apt_bool_t) mrcp_prompt_key_generate(
+							apt_str_t *key,
+							const mrcp_message_t *request,
+							const mpf_codec_descriptor_t *descriptor,
+							apr_pool_t *pool)
+{
+	const apt_header_field_t *header_fields[sizeof(prompt_header_ids)/sizeof(prompt_header_ids[0]) + 1];
+	const apt_header_section_t *header_section = &request->header.header_section;
+	const char *codec;
+	apr_size_t codec_length;
+	apr_size_t count = 0;
+	apr_size_t length;
+	apr_size_t i;
+	char *pos;
+
+	if(!request->body.length || !descriptor) {
+		return FALSE;
+	}
+
+	/* raw values of the header fields are used as is, there is no need to decode them */
+	header_fields[count++] = apt_header_section_field_get(header_section,GENERIC_HEADER_CONTENT_TYPE);
+	for(i=0; i<sizeof(prompt_header_ids)/sizeof(prompt_header_ids[0]); i++) {
+		header_fields[count++] = apt_header_section_field_get(header_section,prompt_header_ids[i] + GENERIC_HEADER_COUNT);
+	}
+
+	codec = apr_psprintf(pool,"%.*s/%d/%d",
+				(int)descriptor->name.length,
+				descriptor->name.buf,
+				descriptor->sampling_rate,
+				descriptor->channel_count);
+	codec_length = strlen(codec);
+
+	/* codec, header field values and body, each field terminated by LF */
+	length = codec_length + 1 + count + request->body.length;
+	for(i=0; i<count; i++) {
+		if(header_fields[i]) {
+			length += header_fields[i]->value.length;
+		}
+	}
+
+	pos = apr_palloc(pool,length + 1);
+	key->buf = pos;
+	key->length = length;
+	memcpy(pos,codec,codec_length);
+	pos += codec_length;
+	*pos++ = APT_TOKEN_LF;
+	for(i=0; i<count; i++) {
+		if(header_fields[i]) {
+			memcpy(pos,header_fields[i]->value.buf,header_fields[i]->value.length);
+			pos += header_fields[i]->value.length;
+		}
+		*pos++ = APT_TOKEN_LF;
+	}
+	memcpy(pos,request->body.buf,request->body.length);
+	pos += request->body.length;
+	*pos = '\0';
+	return TRUE;
+}
+
+/** Look up prompt by key */
+MRCP_DECLARE(mrcp_prompt_entry_t*) mrcp_prompt_cache_lookup(mrcp_prompt_cache_t *cache, const apt_str_t *key)
+{
+	mrcp_prompt_entry_t *entry;
+	apr_uint32_t hash = mrcp_prompt_hash(key);
+	apr_thread_mutex_lock(cache->mutex);
+	entry = mrcp_prompt_entry_find(cache,hash,key);
+	if(entry && entry->ref_count++ == 0) {
+		APR_RING_REMOVE(entry,link);
+	}
+	apr_thread_mutex_unlock(cache->mutex);
+	return entry;
+}
+
+/** Release entry got by lookup */
+MRCP_DECLARE(void) mrcp_prompt_cache_release(mrcp_prompt_cache_t *cache, mrcp_prompt_entry_t *entry)
+{
+	mrcp_prompt_entry_t *evicted = NULL;
+	if(!entry) {
+		return;
+	}
+
+	apr_thread_mutex_lock(cache->mutex);
+	if(entry->ref_count && --entry->ref_count == 0) {
+		APR_RING_INSERT_TAIL(&cache->idle,entry,mrcp_prompt_entry_t,link);
+		evicted = mrcp_prompt_cache_evict(cache);
+	}
+	apr_thread_mutex_unlock(cache->mutex);
+
+	mrcp_prompt_entries_free(evicted);
+}
+
+/** Get the rendered audio of the prompt */
+MRCP_DECLARE(const char*) mrcp_prompt_entry_data_get(const mrcp_prompt_entry_t *entry, apr_size_t *size)
+{
+	*size = entry->size;
+	return entry->data;
+}
+
+/** Create writer to record the prompt being synthesized by */
+MRCP_DECLARE(mrcp_prompt_writer_t*) mrcp_prompt_writer_create(mrcp_prompt_cache_t *cache, const apt_str_t *key)
+{
+	mrcp_prompt_writer_t *writer;
+	mrcp_prompt_entry_t *entry;
+	if(!key->length) {
+		return NULL;
+	}
+
+	writer = malloc(sizeof(mrcp_prompt_writer_t));
+	if(!writer) {
+		return NULL;
+	}
+	entry = malloc(sizeof(mrcp_prompt_entry_t) + key->length + 1);
+	if(!entry) {
+		free(writer);
+		return NULL;
+	}
+	entry->key.buf = (char*)(entry + 1);
+	memcpy(entry->key.buf,key->buf,key->length);
+	entry->key.buf[key->length] = '\0';
+	entry->key.length = key->length;
+	entry->hash = mrcp_prompt_hash(key);
+	entry->next = NULL;
+	entry->data = NULL;
+	entry->size = 0;
+	entry->ref_count = 0;
+	APR_RING_ELEM_INIT(entry,link);
+
+	writer->cache = cache;
+	writer->entry = entry;
+	writer->capacity = 0;
+	writer->overflow = FALSE;
+	return writer;
+}
+
+/** Append rendered audio to the prompt */
+MRCP_DECLARE(apt_bool_t) mrcp_prompt_writer_write(mrcp_prompt_writer_t *writer, const void *data, apr_size_t size)
+{
+	mrcp_prompt_entry_t *entry = writer->entry;
+	if(writer->overflow == TRUE) {
+		return FALSE;
+	}
+
+	if(mrcp_prompt_entry_size(entry) + size > writer->cache->max_size) {
+		/* the prompt would never fit, stop recording it */
+		writer->overflow = TRUE;
+		if(entry->data) {
+			free(entry->data);
+			entry->data = NULL;
+		}
+		entry->size = 0;
+		writer->capacity = 0;
+		return FALSE;
+	}
+
+	if(entry->size + size > writer->capacity) {
+		apr_size_t capacity = writer->capacity ? writer->capacity * 2 : 16 * 1024;
+		char *buffer;
+		while(capacity < entry->size + size) {
+			capacity *= 2;
+		}
+		buffer = realloc(entry->data,capacity);
+		if(!buffer) {
+			writer->overflow = TRUE;
+			return FALSE;
+		}
+		entry->data = buffer;
+		writer->capacity = capacity;
+	}
+	memcpy(entry->data + entry->size,data,size);
+	entry->size += size;
+	return TRUE;
+}
+
+/** Insert the recorded prompt into the cache and destroy the writer */
+MRCP_DECLARE(apt_bool_t) mrcp_prompt_writer_commit(mrcp_prompt_writer_t *writer)
+{
+	mrcp_prompt_cache_t *cache = writer->cache;
+	mrcp_prompt_entry_t *entry = writer->entry;
+	mrcp_prompt_entry_t *evicted;
+	mrcp_prompt_entry_t **bucket;
+	apr_size_t capacity = writer->capacity;
+	apt_bool_t overflow = writer->overflow;
+	free(writer);
+
+	if(overflow == TRUE || !entry->size) {
+		mrcp_prompt_entry_free(entry);
+		return FALSE;
+	}
+	if(entry->size < capacity) {
+		/* shrink to fit, the budget is accounted by the actual size */
+		char *buffer = realloc(entry->data,entry->size);
+		if(buffer) {
+			entry->data = buffer;
+		}
+	}
+
+	apr_thread_mutex_lock(cache->mutex);
+	if(mrcp_prompt_entry_find(cache,entry->hash,&entry->key)) {
+		/* the same prompt has been recorded meanwhile by another channel */
+		apr_thread_mutex_unlock(cache->mutex);
+		mrcp_prompt_entry_free(entry);
+		return FALSE;
+	}
+	bucket = mrcp_prompt_bucket_get(cache,entry->hash);
+	entry->next = *bucket;
+	*bucket = entry;
+	cache->size += mrcp_prompt_entry_size(entry);
+	APR_RING_INSERT_TAIL(&cache->idle,entry,mrcp_prompt_entry_t,link);
+	evicted = mrcp_prompt_cache_evict(cache);
+	apr_thread_mutex_unlock(cache->mutex);
+
+	mrcp_prompt_entries_free(evicted);
+	return TRUE;
+}
+
+/** Discard the recorded prompt and destroy the writer */
+MRCP_DECLARE(void) mrcp_prompt_writer_abort(mrcp_prompt_writer_t *writer)
+{
+	mrcp_prompt_entry_free(writer->entry);
+	free(writer);
+}
+
+/** Get the memory used by the prompts in the cache */
+MRCP_DECLARE(apr_size_t) mrcp_prompt_cache_size_get(const mrcp_prompt_cache_t *cache)
+{
+	return cache->size;
+}
@@ -101,6 +101,11 @@ static APR_INLINE void recog_state_change(mrcp_recog_state_machine_t *state_mach
 static apt_bool_t recog_request_set_params(mrcp_recog_state_machine_t *state_machine, mrcp_message_t *message)
 {
 	mrcp_header_fields_set(state_machine->properties,&message->header,message->pool);
+	if(mrcp_state_machine_params_inline_check(&state_machine->base,message) == TRUE) {
+		/* the engine takes these header fields from the next request, no need to pass them now */
+		mrcp_message_t *response_message = mrcp_response_create(message,message->pool);
+		return recog_response_dispatch(state_machine,response_message);
+	}
 	return recog_request_dispatch(state_machine,message);
 }
 
@@ -111,6 +116,12 @@ static apt_bool_t recog_response_set_params(mrcp_recog_state_machine_t *state_ma
 
 static apt_bool_t recog_request_get_params(mrcp_recog_state_machine_t *state_machine, mrcp_message_t *message)
 {
+	if(mrcp_state_machine_params_inline_check(&state_machine->base,message) == TRUE) {
+		/* the values of these header fields are known from SET-PARAMS only */
+		mrcp_message_t *response_message = mrcp_response_create(message,message->pool);
+		mrcp_header_fields_get(&response_message->header,state_machine->properties,&message->header,message->pool);
+		return recog_response_dispatch(state_machine,response_message);
+	}
 	return recog_request_dispatch(state_machine,message);
 }
 
@@ -153,7 +164,7 @@ static apt_bool_t recog_request_recognize(mrcp_recog_state_machine_t *state_mach
 			MRCP_MESSAGE_SIDRES(message),
 			message->start_line.request_id);
 		message->start_line.request_state = MRCP_REQUEST_STATE_PENDING;
-		apt_list_push_back(state_machine->queue,message,message->pool);
+		apt_list_push_back(state_machine->queue,message,NULL);
 		
 		response = mrcp_response_create(message,message->pool);
 		response->start_line.request_state = MRCP_REQUEST_STATE_PENDING;
@@ -386,6 +397,25 @@ static apt_bool_t recog_event_interpretation_complete(mrcp_recog_state_machine_t
 	return recog_event_dispatch(state_machine,message);
 }
 
+static apt_bool_t recog_event_intermediate_result(mrcp_recog_state_machine_t *state_machine, mrcp_message_t *message)
+{
+	if(!state_machine->recog || state_machine->state != RECOGNIZER_STATE_RECOGNIZING ||
+		state_machine->recog->start_line.request_id != message->start_line.request_id) {
+		/* unexpected event, no in-progress recognition request */
+		return FALSE;
+	}
+
+	if(state_machine->active_request && state_machine->active_request->start_line.method_id == RECOGNIZER_STOP) {
+		/* the hypothesis is of no use, once the recognition is being stopped */
+		return FALSE;
+	}
+
+	message->start_line.request_state = MRCP_REQUEST_STATE_INPROGRESS;
+	/* the next intermediate result or RECOGNITION-COMPLETE supersedes this one */
+	message->is_discardable = TRUE;
+	return recog_event_dispatch(state_machine,message);
+}
+
 static recog_method_f recog_request_method_array[RECOGNIZER_METHOD_COUNT] = {
 	recog_request_set_params,
 	recog_request_get_params,
@@ -411,7 +441,8 @@ static recog_method_f recog_response_method_array[RECOGNIZER_METHOD_COUNT] = {
 static recog_method_f recog_event_method_array[RECOGNIZER_EVENT_COUNT] = {
 	recog_event_start_of_input,
 	recog_event_recognition_complete,
-	recog_event_interpretation_complete
+	recog_event_interpretation_complete,
+	recog_event_intermediate_result
 };
 
 /** Update state according to received incoming request from MRCP client */
@@ -95,6 +95,11 @@ static APR_INLINE void recorder_state_change(mrcp_recorder_state_machine_t *stat
 static apt_bool_t recorder_request_set_params(mrcp_recorder_state_machine_t *state_machine, mrcp_message_t *message)
 {
 	mrcp_header_fields_set(state_machine->properties,&message->header,message->pool);
+	if(mrcp_state_machine_params_inline_check(&state_machine->base,message) == TRUE) {
+		/* the engine takes these header fields from the next request, no need to pass them now */
+		mrcp_message_t *response_message = mrcp_response_create(message,message->pool);
+		return recorder_response_dispatch(state_machine,response_message);
+	}
 	return recorder_request_dispatch(state_machine,message);
 }
 
@@ -105,6 +110,12 @@ static apt_bool_t recorder_response_set_params(mrcp_recorder_state_machine_t *st
 
 static apt_bool_t recorder_request_get_params(mrcp_recorder_state_machine_t *state_machine, mrcp_message_t *message)
 {
+	if(mrcp_state_machine_params_inline_check(&state_machine->base,message) == TRUE) {
+		/* the values of these header fields are known from SET-PARAMS only */
+		mrcp_message_t *response_message = mrcp_response_create(message,message->pool);
+		mrcp_header_fields_get(&response_message->header,state_machine->properties,&message->header,message->pool);
+		return recorder_response_dispatch(state_machine,response_message);
+	}
 	return recorder_request_dispatch(state_machine,message);
 }
 
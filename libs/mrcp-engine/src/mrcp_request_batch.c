@@ -0,0 +1,123 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <apr_thread_mutex.h>
+#include "mrcp_request_batch.h"
+#include "mrcp_engine_iface.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+
+/** Request batch */
+struct mrcp_request_batch_t {
+	/** Engine to deliver the requests to */
+	mrcp_engine_t         *engine;
+	/** Requests added since the last flush (mrcp_request_batch_item_t) */
+	apr_array_header_t    *pending;
+	/** Items passed to the engine (mrcp_request_batch_item_t) */
+	apr_array_header_t    *items;
+	/** Guard of pending requests */
+	apr_thread_mutex_t    *guard;
+	/** Guard held during delivery, so that the batches are delivered in order */
+	apr_thread_mutex_t    *delivery_guard;
+	/** Own pool */
+	apr_pool_t            *pool;
+};
+
+/** Create request batch of engine */
+MRCP_DECLARE(mrcp_request_batch_t*) mrcp_request_batch_create(mrcp_engine_t *engine)
+{
+	mrcp_request_batch_t *batch;
+	apr_pool_t *pool;
+	if(!engine->method_vtable->process_requests || !engine->event_vtable || !engine->event_vtable->on_requests) {
+		return NULL;
+	}
+	pool = apt_pool_create();
+	if(!pool) {
+		return NULL;
+	}
+	batch = apr_palloc(pool,sizeof(mrcp_request_batch_t));
+	batch->engine = engine;
+	batch->pool = pool;
+	batch->pending = apr_array_make(pool,8,sizeof(mrcp_request_batch_item_t));
+	batch->items = apr_array_make(pool,8,sizeof(mrcp_request_batch_item_t));
+	if(apr_thread_mutex_create(&batch->guard,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		apr_pool_destroy(pool);
+		return NULL;
+	}
+	if(apr_thread_mutex_create(&batch->delivery_guard,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		apr_thread_mutex_destroy(batch->guard);
+		apr_pool_destroy(pool);
+		return NULL;
+	}
+	return batch;
+}
+
+/** Destroy request batch */
+MRCP_DECLARE(void) mrcp_request_batch_destroy(mrcp_request_batch_t *batch)
+{
+	if(batch->pending->nelts) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Drop %d Undelivered Request(s) of Engine [%s]",
+			batch->pending->nelts,batch->engine->id);
+	}
+	apr_thread_mutex_destroy(batch->delivery_guard);
+	apr_thread_mutex_destroy(batch->guard);
+	apr_pool_destroy(batch->pool);
+}
+
+/** Add request of channel to the batch */
+MRCP_DECLARE(apt_bool_t) mrcp_request_batch_add(mrcp_request_batch_t *batch, mrcp_engine_channel_t *channel, mrcp_message_t *request)
+{
+	mrcp_request_batch_item_t *item;
+	apt_bool_t first;
+	apr_thread_mutex_lock(batch->guard);
+	first = batch->pending->nelts ? FALSE : TRUE;
+	item = apr_array_push(batch->pending);
+	item->channel = channel;
+	item->request = request;
+	apr_thread_mutex_unlock(batch->guard);
+	return first;
+}
+
+/** Deliver the requests added so far to the engine in one call */
+MRCP_DECLARE(apt_bool_t) mrcp_request_batch_flush(mrcp_request_batch_t *batch)
+{
+	apr_array_header_t *items;
+	apr_time_t start_time;
+	apt_bool_t status = TRUE;
+
+	apr_thread_mutex_lock(batch->delivery_guard);
+	/* swap the arrays, so that requests are added meanwhile with no wait for delivery */
+	apr_thread_mutex_lock(batch->guard);
+	items = batch->pending;
+	batch->pending = batch->items;
+	batch->items = items;
+	apr_thread_mutex_unlock(batch->guard);
+
+	if(items->nelts) {
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Deliver %d Request(s) to Engine [%s]",items->nelts,batch->engine->id);
+		start_time = apr_time_now();
+		status = batch->engine->method_vtable->process_requests(
+					batch->engine,
+					(const mrcp_request_batch_item_t*)items->elts,
+					items->nelts);
+		mrcp_engine_callback_time_record(batch->engine,MRCP_ENGINE_CALLBACK_REQUEST,(apr_uint32_t)(apr_time_now() - start_time));
+		apr_array_clear(items);
+	}
+	apr_thread_mutex_unlock(batch->delivery_guard);
+	return status;
+}
@@ -85,6 +85,13 @@ static APR_INLINE apt_bool_t synth_event_dispatch(mrcp_synth_state_machine_t *st
 	return state_machine->base.on_dispatch(&state_machine->base,message);
 }
 
+static APR_INLINE void synth_prefetch_dispatch(mrcp_synth_state_machine_t *state_machine, mrcp_message_t *message, apt_bool_t start)
+{
+	if(state_machine->base.on_prefetch) {
+		state_machine->base.on_prefetch(&state_machine->base,message,start);
+	}
+}
+
 static APR_INLINE void synth_state_change(mrcp_synth_state_machine_t *state_machine, mrcp_synth_state_e state, mrcp_message_t *message)
 {
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"State Transition %s -> %s "APT_SIDRES_FMT,
@@ -101,6 +108,11 @@ static APR_INLINE void synth_state_change(mrcp_synth_state_machine_t *state_mach
 static apt_bool_t synth_request_set_params(mrcp_synth_state_machine_t *state_machine, mrcp_message_t *message)
 {
 	mrcp_header_fields_set(state_machine->properties,&message->header,message->pool);
+	if(mrcp_state_machine_params_inline_check(&state_machine->base,message) == TRUE) {
+		/* the engine takes these header fields from the next request, no need to pass them now */
+		mrcp_message_t *response_message = mrcp_response_create(message,message->pool);
+		return synth_response_dispatch(state_machine,response_message);
+	}
 	return synth_request_dispatch(state_machine,message);
 }
 
@@ -111,6 +123,12 @@ static apt_bool_t synth_response_set_params(mrcp_synth_state_machine_t *state_ma
 
 static apt_bool_t synth_request_get_params(mrcp_synth_state_machine_t *state_machine, mrcp_message_t *message)
 {
+	if(mrcp_state_machine_params_inline_check(&state_machine->base,message) == TRUE) {
+		/* the values of these header fields are known from SET-PARAMS only */
+		mrcp_message_t *response_message = mrcp_response_create(message,message->pool);
+		mrcp_header_fields_get(&response_message->header,state_machine->properties,&message->header,message->pool);
+		return synth_response_dispatch(state_machine,response_message);
+	}
 	return synth_request_dispatch(state_machine,message);
 }
 
@@ -129,11 +147,14 @@ static apt_bool_t synth_request_speak(mrcp_synth_state_machine_t *state_machine,
 			MRCP_MESSAGE_SIDRES(message),
 			message->start_line.request_id);
 		message->start_line.request_state = MRCP_REQUEST_STATE_PENDING;
-		apt_list_push_back(state_machine->queue,message,message->pool);
+		apt_list_push_back(state_machine->queue,message,NULL);
 		
 		response = mrcp_response_create(message,message->pool);
 		response->start_line.request_state = MRCP_REQUEST_STATE_PENDING;
-		return synth_response_dispatch(state_machine,response);
+		synth_response_dispatch(state_machine,response);
+		/* let the engine render the queued prompt ahead, while the one in progress is played out */
+		synth_prefetch_dispatch(state_machine,message,TRUE);
+		return TRUE;
 	}
 
 	return synth_request_dispatch(state_machine,message);
@@ -180,6 +201,7 @@ static apt_bool_t synth_pending_requests_remove(mrcp_synth_state_machine_t *stat
 				MRCP_MESSAGE_SIDRES(pending_message),
 				pending_message->start_line.request_id);
 			elem = apt_list_elem_remove(state_machine->queue,elem);
+			synth_prefetch_dispatch(state_machine,pending_message,FALSE);
 			/* append active id list */
 			active_request_id_list_append(response_generic_header,pending_message->start_line.request_id);
 		}
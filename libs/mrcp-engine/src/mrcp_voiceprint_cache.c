@@ -0,0 +1,494 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include <stdlib.h>
+#include <apr_ring.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#include "mrcp_voiceprint_cache.h"
+#include "apt_log.h"
+
+/** Number of hash buckets (power of 2) */
+#define MRCP_VOICEPRINT_BUCKET_COUNT  256
+/** Number of strands models are prefetched by in parallel */
+#define MRCP_VOICEPRINT_STRAND_COUNT  4
+/** Max number of pending prefetches per strand */
+#define MRCP_VOICEPRINT_STRAND_SIZE   64
+
+/** Voiceprint cache entry */
+struct mrcp_voiceprint_entry_t {
+	/** Ring entry of unreferenced (evictable) entries */
+	APR_RING_ENTRY(mrcp_voiceprint_entry_t) link;
+	/** Next entry in the same bucket (or in the list of entries to free) */
+	mrcp_voiceprint_entry_t *next;
+	/** Hash of the key */
+	apr_uint32_t             hash;
+	/** Repository URI (copy, NUL-terminated) */
+	apt_str_t                repository_uri;
+	/** Voiceprint identifier (copy, NUL-terminated) */
+	apt_str_t                voiceprint_id;
+	/** Loaded model */
+	void                    *model;
+	/** Size of the model reported by the loader */
+	apr_size_t               size;
+	/** Number of references, including the one of the load in progress */
+	apr_size_t               ref_count;
+	/** Is the model being loaded */
+	apt_bool_t               loading;
+	/** Is the entry in the buckets (not failed, evicted or invalidated) */
+	apt_bool_t               linked;
+};
+
+/** Ring of voiceprint cache entries */
+APR_RING_HEAD(mrcp_voiceprint_ring_t, mrcp_voiceprint_entry_t);
+
+/** Voiceprint cache */
+struct mrcp_voiceprint_cache_t {
+	/** Hash buckets */
+	mrcp_voiceprint_entry_t        *buckets[MRCP_VOICEPRINT_BUCKET_COUNT];
+	/** Unreferenced entries in least recently used order */
+	struct mrcp_voiceprint_ring_t   idle;
+	/** Number of loaded models */
+	apr_size_t                      count;
+	/** Memory used by the loaded models */
+	apr_size_t                      size;
+	/** Memory budget */
+	apr_size_t                      max_size;
+	/** Loader of models */
+	const mrcp_voiceprint_loader_t *loader;
+	/** Strands to prefetch models by (NULL if no executor) */
+	apt_executor_strand_t          *strands[MRCP_VOICEPRINT_STRAND_COUNT];
+	/** Index of the strand to submit the next prefetch to */
+	apr_size_t                      next_strand;
+	/** Mutex, the cache is shared among channels and prefetch jobs */
+	apr_thread_mutex_t             *mutex;
+	/** Signaled, once a model is loaded */
+	apr_thread_cond_t              *cond;
+};
+
+/** Compute FNV-1a hash of the key */
+static apr_uint32_t mrcp_voiceprint_hash(const apt_str_t *repository_uri, const apt_str_t *voiceprint_id)
+{
+	apr_uint32_t hash = 2166136261U;
+	apr_size_t i;
+	for(i=0; i<repository_uri->length; i++) {
+		hash ^= (apr_byte_t)repository_uri->buf[i];
+		hash *= 16777619U;
+	}
+	/* separator, so that the split of the key into the two strings matters */
+	hash ^= '\n';
+	hash *= 16777619U;
+	for(i=0; i<voiceprint_id->length; i++) {
+		hash ^= (apr_byte_t)voiceprint_id->buf[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static APR_INLINE mrcp_voiceprint_entry_t** mrcp_voiceprint_bucket_get(mrcp_voiceprint_cache_t *cache, apr_uint32_t hash)
+{
+	return &cache->buckets[(hash ^ (hash >> 16)) & (MRCP_VOICEPRINT_BUCKET_COUNT - 1)];
+}
+
+static APR_INLINE apr_size_t mrcp_voiceprint_entry_size(const mrcp_voiceprint_entry_t *entry)
+{
+	return sizeof(mrcp_voiceprint_entry_t) + entry->repository_uri.length + entry->voiceprint_id.length + entry->size;
+}
+
+static mrcp_voiceprint_entry_t* mrcp_voiceprint_entry_find(
+									mrcp_voiceprint_cache_t *cache,
+									apr_uint32_t hash,
+									const apt_str_t *repository_uri,
+									const apt_str_t *voiceprint_id)
+{
+	mrcp_voiceprint_entry_t *entry = *mrcp_voiceprint_bucket_get(cache,hash);
+	for(; entry; entry = entry->next) {
+		if(entry->hash == hash &&
+			apt_string_compare(&entry->repository_uri,repository_uri) == TRUE &&
+			apt_string_compare(&entry->voiceprint_id,voiceprint_id) == TRUE) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/** Create entry of the model to load and insert it (called with the lock held) */
+static mrcp_voiceprint_entry_t* mrcp_voiceprint_entry_insert(
+									mrcp_voiceprint_cache_t *cache,
+									apr_uint32_t hash,
+									const apt_str_t *repository_uri,
+									const apt_str_t *voiceprint_id)
+{
+	mrcp_voiceprint_entry_t **bucket;
+	mrcp_voiceprint_entry_t *entry = malloc(sizeof(mrcp_voiceprint_entry_t) + repository_uri->length + voiceprint_id->length + 2);
+	if(!entry) {
+		return NULL;
+	}
+	entry->repository_uri.buf = (char*)(entry + 1);
+	memcpy(entry->repository_uri.buf,repository_uri->buf,repository_uri->length);
+	entry->repository_uri.buf[repository_uri->length] = '\0';
+	entry->repository_uri.length = repository_uri->length;
+	entry->voiceprint_id.buf = entry->repository_uri.buf + repository_uri->length + 1;
+	memcpy(entry->voiceprint_id.buf,voiceprint_id->buf,voiceprint_id->length);
+	entry->voiceprint_id.buf[voiceprint_id->length] = '\0';
+	entry->voiceprint_id.length = voiceprint_id->length;
+	entry->hash = hash;
+	entry->model = NULL;
+	entry->size = 0;
+	/* referenced by the load in progress */
+	entry->ref_count = 1;
+	entry->loading = TRUE;
+	entry->linked = TRUE;
+	APR_RING_ELEM_INIT(entry,link);
+
+	bucket = mrcp_voiceprint_bucket_get(cache,hash);
+	entry->next = *bucket;
+	*bucket = entry;
+	return entry;
+}
+
+/** Remove entry from the buckets (called with the lock held) */
+static void mrcp_voiceprint_entry_unlink(mrcp_voiceprint_cache_t *cache, mrcp_voiceprint_entry_t *entry)
+{
+	mrcp_voiceprint_entry_t **it;
+	for(it = mrcp_voiceprint_bucket_get(cache,entry->hash); *it; it = &(*it)->next) {
+		if(*it == entry) {
+			*it = entry->next;
+			break;
+		}
+	}
+	entry->next = NULL;
+	entry->linked = FALSE;
+	if(entry->loading == FALSE && entry->model) {
+		cache->count--;
+		cache->size -= mrcp_voiceprint_entry_size(entry);
+	}
+}
+
+/** Drop reference to entry, prepend the entry to the list to free, if unlinked (called with the lock held) */
+static void mrcp_voiceprint_entry_unref(mrcp_voiceprint_cache_t *cache, mrcp_voiceprint_entry_t *entry, mrcp_voiceprint_entry_t **garbage)
+{
+	if(!entry->ref_count || --entry->ref_count) {
+		return;
+	}
+	if(entry->linked == TRUE) {
+		APR_RING_INSERT_TAIL(&cache->idle,entry,mrcp_voiceprint_entry_t,link);
+	}
+	else {
+		entry->next = *garbage;
+		*garbage = entry;
+	}
+}
+
+/** Store the result of load and wake up the waiters (called with the lock held) */
+static void mrcp_voiceprint_entry_publish(mrcp_voiceprint_cache_t *cache, mrcp_voiceprint_entry_t *entry, void *model, apr_size_t size)
+{
+	entry->loading = FALSE;
+	if(model) {
+		entry->model = model;
+		entry->size = size;
+		if(entry->linked == TRUE) {
+			cache->count++;
+			cache->size += mrcp_voiceprint_entry_size(entry);
+		}
+	}
+	else if(entry->linked == TRUE) {
+		/* the next request retries to load the model */
+		mrcp_voiceprint_entry_unlink(cache,entry);
+	}
+	apr_thread_cond_broadcast(cache->cond);
+}
+
+/** Unlink least recently used entries over the budget (called with the lock held) */
+static void mrcp_voiceprint_cache_evict(mrcp_voiceprint_cache_t *cache, mrcp_voiceprint_entry_t **garbage)
+{
+	mrcp_voiceprint_entry_t *entry;
+	while(cache->size > cache->max_size && !APR_RING_EMPTY(&cache->idle,mrcp_voiceprint_entry_t,link)) {
+		entry = APR_RING_FIRST(&cache->idle);
+		APR_RING_REMOVE(entry,link);
+		mrcp_voiceprint_entry_unlink(cache,entry);
+		entry->next = *garbage;
+		*garbage = entry;
+	}
+}
+
+/** Free entries of the list (called with no lock held) */
+static void mrcp_voiceprint_entries_free(mrcp_voiceprint_cache_t *cache, mrcp_voiceprint_entry_t *entry)
+{
+	mrcp_voiceprint_entry_t *next;
+	for(; entry; entry = next) {
+		next = entry->next;
+		if(entry->model && cache->loader->destroy) {
+			cache->loader->destroy(cache->loader->obj,entry->model);
+		}
+		free(entry);
+	}
+}
+
+/** Load the model of the entry (called with no lock held) */
+static void* mrcp_voiceprint_model_load(mrcp_voiceprint_cache_t *cache, mrcp_voiceprint_entry_t *entry, apr_size_t *size)
+{
+	void *model;
+	apr_time_t start_time = apr_time_now();
+	*size = 0;
+	model = cache->loader->load(cache->loader->obj,entry->repository_uri.buf,entry->voiceprint_id.buf,size);
+	if(!model) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Load Voiceprint [%s] of Repository [%s]",
+			entry->voiceprint_id.buf,
+			entry->repository_uri.buf);
+		return NULL;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Load Voiceprint [%s] of Repository [%s] %"APR_SIZE_T_FMT" bytes in %"APR_TIME_T_FMT" usec",
+		entry->voiceprint_id.buf,
+		entry->repository_uri.buf,
+		*size,
+		apr_time_now() - start_time);
+	return model;
+}
+
+/** Prefetch job, run by the executor */
+static void mrcp_voiceprint_prefetch_process(void *obj, void *arg)
+{
+	mrcp_voiceprint_cache_t *cache = obj;
+	mrcp_voiceprint_entry_t *entry = arg;
+	mrcp_voiceprint_entry_t *garbage = NULL;
+	apr_size_t size;
+	void *model = mrcp_voiceprint_model_load(cache,entry,&size);
+
+	apr_thread_mutex_lock(cache->mutex);
+	mrcp_voiceprint_entry_publish(cache,entry,model,size);
+	mrcp_voiceprint_entry_unref(cache,entry,&garbage);
+	mrcp_voiceprint_cache_evict(cache,&garbage);
+	apr_thread_mutex_unlock(cache->mutex);
+
+	mrcp_voiceprint_entries_free(cache,garbage);
+}
+
+/** Create voiceprint cache */
+MRCP_DECLARE(mrcp_voiceprint_cache_t*) mrcp_voiceprint_cache_create(
+											apr_size_t max_size,
+											const mrcp_voiceprint_loader_t *loader,
+											apt_executor_t *executor,
+											apr_pool_t *pool)
+{
+	apr_size_t i;
+	mrcp_voiceprint_cache_t *cache;
+	if(!loader || !loader->load) {
+		return NULL;
+	}
+
+	cache = apr_pcalloc(pool,sizeof(mrcp_voiceprint_cache_t));
+	APR_RING_INIT(&cache->idle,mrcp_voiceprint_entry_t,link);
+	cache->count = 0;
+	cache->size = 0;
+	cache->max_size = max_size;
+	cache->loader = loader;
+	cache->next_strand = 0;
+	if(apr_thread_mutex_create(&cache->mutex,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	if(apr_thread_cond_create(&cache->cond,pool) != APR_SUCCESS) {
+		apr_thread_mutex_destroy(cache->mutex);
+		return NULL;
+	}
+	for(i=0; i<MRCP_VOICEPRINT_STRAND_COUNT; i++) {
+		cache->strands[i] = executor ? apt_executor_strand_create(executor,MRCP_VOICEPRINT_STRAND_SIZE,pool) : NULL;
+	}
+	return cache;
+}
+
+/** Destroy voiceprint cache and all the models in it */
+MRCP_DECLARE(void) mrcp_voiceprint_cache_destroy(mrcp_voiceprint_cache_t *cache)
+{
+	apr_size_t i;
+	for(i=0; i<MRCP_VOICEPRINT_STRAND_COUNT; i++) {
+		if(cache->strands[i]) {
+			/* wait for the prefetches in progress */
+			apt_executor_strand_destroy(cache->strands[i]);
+			cache->strands[i] = NULL;
+		}
+	}
+	for(i=0; i<MRCP_VOICEPRINT_BUCKET_COUNT; i++) {
+		mrcp_voiceprint_entries_free(cache,cache->buckets[i]);
+		cache->buckets[i] = NULL;
+	}
+	APR_RING_INIT(&cache->idle,mrcp_voiceprint_entry_t,link);
+	cache->count = 0;
+	cache->size = 0;
+	apr_thread_cond_destroy(cache->cond);
+	apr_thread_mutex_destroy(cache->mutex);
+}
+
+/** Load model of voiceprint in background */
+MRCP_DECLARE(apt_bool_t) mrcp_voiceprint_cache_prefetch(
+							mrcp_voiceprint_cache_t *cache,
+							const apt_str_t *repository_uri,
+							const apt_str_t *voiceprint_id)
+{
+	mrcp_voiceprint_entry_t *entry;
+	mrcp_voiceprint_entry_t *garbage = NULL;
+	apt_executor_strand_t *strand;
+	apr_uint32_t hash;
+	if(!cache->strands[0] || !voiceprint_id->length) {
+		return FALSE;
+	}
+
+	hash = mrcp_voiceprint_hash(repository_uri,voiceprint_id);
+	apr_thread_mutex_lock(cache->mutex);
+	entry = mrcp_voiceprint_entry_find(cache,hash,repository_uri,voiceprint_id);
+	if(entry) {
+		/* cached or being loaded already */
+		apr_thread_mutex_unlock(cache->mutex);
+		return TRUE;
+	}
+	entry = mrcp_voiceprint_entry_insert(cache,hash,repository_uri,voiceprint_id);
+	strand = cache->strands[cache->next_strand++ % MRCP_VOICEPRINT_STRAND_COUNT];
+	apr_thread_mutex_unlock(cache->mutex);
+	if(!entry) {
+		return FALSE;
+	}
+
+	if(apt_executor_job_submit(strand,mrcp_voiceprint_prefetch_process,cache,entry) == TRUE) {
+		return TRUE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Prefetch Voiceprint [%s]: too many pending",entry->voiceprint_id.buf);
+	apr_thread_mutex_lock(cache->mutex);
+	mrcp_voiceprint_entry_publish(cache,entry,NULL,0);
+	mrcp_voiceprint_entry_unref(cache,entry,&garbage);
+	apr_thread_mutex_unlock(cache->mutex);
+	mrcp_voiceprint_entries_free(cache,garbage);
+	return FALSE;
+}
+
+/** Get model of voiceprint */
+MRCP_DECLARE(mrcp_voiceprint_entry_t*) mrcp_voiceprint_cache_get(
+							mrcp_voiceprint_cache_t *cache,
+							const apt_str_t *repository_uri,
+							const apt_str_t *voiceprint_id)
+{
+	mrcp_voiceprint_entry_t *entry;
+	mrcp_voiceprint_entry_t *garbage = NULL;
+	apr_uint32_t hash;
+	apr_size_t size;
+	void *model;
+	if(!voiceprint_id->length) {
+		return NULL;
+	}
+
+	hash = mrcp_voiceprint_hash(repository_uri,voiceprint_id);
+	apr_thread_mutex_lock(cache->mutex);
+	entry = mrcp_voiceprint_entry_find(cache,hash,repository_uri,voiceprint_id);
+	if(entry) {
+		if(entry->ref_count++ == 0) {
+			/* loaded entries only are unreferenced */
+			APR_RING_REMOVE(entry,link);
+		}
+		while(entry->loading == TRUE) {
+			/* prefetched by another thread */
+			apr_thread_cond_wait(cache->cond,cache->mutex);
+		}
+		if(!entry->model) {
+			mrcp_voiceprint_entry_unref(cache,entry,&garbage);
+			entry = NULL;
+		}
+		apr_thread_mutex_unlock(cache->mutex);
+		mrcp_voiceprint_entries_free(cache,garbage);
+		return entry;
+	}
+
+	/* not cached, load it right away */
+	entry = mrcp_voiceprint_entry_insert(cache,hash,repository_uri,voiceprint_id);
+	apr_thread_mutex_unlock(cache->mutex);
+	if(!entry) {
+		return NULL;
+	}
+
+	model = mrcp_voiceprint_model_load(cache,entry,&size);
+
+	apr_thread_mutex_lock(cache->mutex);
+	mrcp_voiceprint_entry_publish(cache,entry,model,size);
+	if(!model) {
+		mrcp_voiceprint_entry_unref(cache,entry,&garbage);
+		entry = NULL;
+	}
+	mrcp_voiceprint_cache_evict(cache,&garbage);
+	apr_thread_mutex_unlock(cache->mutex);
+
+	mrcp_voiceprint_entries_free(cache,garbage);
+	return entry;
+}
+
+/** Release entry got by get */
+MRCP_DECLARE(void) mrcp_voiceprint_cache_release(mrcp_voiceprint_cache_t *cache, mrcp_voiceprint_entry_t *entry)
+{
+	mrcp_voiceprint_entry_t *garbage = NULL;
+	if(!entry) {
+		return;
+	}
+
+	apr_thread_mutex_lock(cache->mutex);
+	mrcp_voiceprint_entry_unref(cache,entry,&garbage);
+	mrcp_voiceprint_cache_evict(cache,&garbage);
+	apr_thread_mutex_unlock(cache->mutex);
+
+	mrcp_voiceprint_entries_free(cache,garbage);
+}
+
+/** Invalidate model of voiceprint */
+MRCP_DECLARE(void) mrcp_voiceprint_cache_invalidate(
+							mrcp_voiceprint_cache_t *cache,
+							const apt_str_t *repository_uri,
+							const apt_str_t *voiceprint_id)
+{
+	mrcp_voiceprint_entry_t *entry;
+	mrcp_voiceprint_entry_t *garbage = NULL;
+	apr_uint32_t hash = mrcp_voiceprint_hash(repository_uri,voiceprint_id);
+
+	apr_thread_mutex_lock(cache->mutex);
+	entry = mrcp_voiceprint_entry_find(cache,hash,repository_uri,voiceprint_id);
+	if(entry) {
+		mrcp_voiceprint_entry_unlink(cache,entry);
+		if(!entry->ref_count) {
+			APR_RING_REMOVE(entry,link);
+			garbage = entry;
+		}
+	}
+	apr_thread_mutex_unlock(cache->mutex);
+
+	mrcp_voiceprint_entries_free(cache,garbage);
+}
+
+/** Get model of the entry */
+MRCP_DECLARE(void*) mrcp_voiceprint_entry_model_get(const mrcp_voiceprint_entry_t *entry)
+{
+	return entry->model;
+}
+
+/** Get the number of models in the cache */
+MRCP_DECLARE(apr_size_t) mrcp_voiceprint_cache_count_get(const mrcp_voiceprint_cache_t *cache)
+{
+	return cache->count;
+}
+
+/** Get the memory used by the models in the cache */
+MRCP_DECLARE(apr_size_t) mrcp_voiceprint_cache_size_get(const mrcp_voiceprint_cache_t *cache)
+{
+	return cache->size;
+}
@@ -27,6 +27,7 @@
 #include "mrcp_server_types.h"
 #include "mrcp_engine_iface.h"
 #include "mpf_rtp_descriptor.h"
+#include "mpf_context.h"
 #include "apt_task.h"
 
 APT_BEGIN_EXTERN_C
@@ -56,6 +57,249 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_shutdown(mrcp_server_t *server);
  */
 MRCP_DECLARE(apt_bool_t) mrcp_server_destroy(mrcp_server_t *server);
 
+/**
+ * Set the number of worker threads sessions are processed by.
+ * @param server the MRCP server to set the worker count for
+ * @param count the number of workers (1 by default)
+ * @remark Messages of a session are always processed by the same worker. The function
+ *         must be called before the server is started, and engine plugins must be
+ *         thread-safe, if more than one worker is set.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_worker_count_set(mrcp_server_t *server, apr_size_t count);
+
+/**
+ * Set the number of threads of the executor shared among MRCP engines.
+ * @param server the MRCP server to set the thread count for
+ * @param count the number of threads
+ * @remark Must be called before the server is started.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_executor_thread_count_set(mrcp_server_t *server, apr_size_t count);
+
+/**
+ * Bind the threads of the executor shared among MRCP engines to the set of CPUs.
+ * @param server the MRCP server to bind the executor of
+ * @param cpu_set the set of CPUs (NULL - no binding)
+ * @remark Must be called before the server is started.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_executor_cpu_set_set(mrcp_server_t *server, const apt_cpu_set_t *cpu_set);
+
+/**
+ * Set admission control of new sessions.
+ * @param server the MRCP server to set admission control for
+ * @param admission the thresholds of live load to copy
+ * @remark Besides the thresholds, a session is rejected as overloaded, if any engine
+ *         of the requested resources already has max-channel-count channels in use.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_admission_set(mrcp_server_t *server, const mrcp_server_admission_t *admission);
+
+/**
+ * Set the number of shards of the table of sessions.
+ * @param server the MRCP server to set the number of shards for
+ * @param count the number of shards (rounded up to the power of two)
+ * @remark Sessions are looked up without locking, while adding and removing
+ *         of sessions is serialized per shard. Must be set before the server is started.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_session_table_shards_set(mrcp_server_t *server, apr_size_t count);
+
+/**
+ * Get admission control of new sessions.
+ * @param server the MRCP server to get admission control of
+ */
+MRCP_DECLARE(const mrcp_server_admission_t*) mrcp_server_admission_get(const mrcp_server_t *server);
+
+/** Default max number of pools of terminated sessions kept for reuse */
+#define MRCP_SERVER_SESSION_CACHE_DEFAULT_SIZE 64
+
+/**
+ * Set the max number of pools of terminated sessions kept for reuse.
+ * @param server the MRCP server to set the size for
+ * @param size the number of pools (0 - pools are destroyed along with sessions)
+ * @remark A pool is cleared rather than destroyed, so a new session is allocated from
+ *         the memory blocks already owned by the pool. Must be set before the server is started.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_session_cache_size_set(mrcp_server_t *server, apr_size_t size);
+
+/**
+ * Start draining the server before it is shut down (e.g. for a rolling restart).
+ * @param server the MRCP server to drain
+ * @remark New sessions are rejected as overloaded (503 for both SIP and RTSP, followed by
+ *         Retry-After, if configured by admission control), while existing sessions
+ *         run to completion. Draining cannot be cancelled.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_drain(mrcp_server_t *server);
+
+/**
+ * Check whether the server is draining.
+ * @param server the MRCP server to check
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_is_draining(const mrcp_server_t *server);
+
+/**
+ * Check whether the server is draining and has no session in progress anymore,
+ * so that it can be shut down without dropping calls.
+ * @param server the MRCP server to check
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_is_drained(const mrcp_server_t *server);
+
+/**
+ * Set the threshold of session setup time to log the phases of slow setups at.
+ * @param server the MRCP server to set the threshold for
+ * @param threshold the threshold in msec (0 - slow setups are not logged)
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_slow_setup_threshold_set(mrcp_server_t *server, apr_size_t threshold);
+
+/**
+ * Enable delivery of events of engines to MRCPv2 connection agents at the send site.
+ * @param server the MRCP server to enable the delivery for
+ * @param enable whether an event is validated by the state machine of its channel
+ *               in the context of the engine and queued to the connection agent,
+ *               rather than signalled to the server task first
+ * @remark Events are still signalled to the server task, while messages of the channel
+ *         sent before are queued there, so that the channel keeps the order of messages.
+ *         Must be set before the server is started.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_event_fast_path_set(mrcp_server_t *server, apt_bool_t enable);
+
+/**
+ * Enable memory accounting of the pools of sessions, engine channels and MRCPv2 connections.
+ * @param server the MRCP server to enable accounting for
+ * @param session_budget the size of memory in bytes to log sessions exceeding at (0 - not logged)
+ * @remark Must be set before the server is started, the statistics is taken by apt_pool_account_stat_get().
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_memory_accounting_set(mrcp_server_t *server, apr_size_t session_budget);
+
+/**
+ * Enable the cache of fetched URIs (http:// grammars and audio prompts) shared among MRCP engines.
+ * @param server the MRCP server to enable the cache for
+ * @param config the config of the cache
+ * @remark Must be set before the engines are loaded. The URIs referenced by requests
+ *         are prefetched by the executor, as the requests are passed to the engines,
+ *         which get the documents by mrcp_engine_uri_fetch().
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_fetch_cache_set(mrcp_server_t *server, const mrcp_fetch_cache_config_t *config);
+
+/**
+ * Get statistics of a phase of session setup accumulated across all the sessions.
+ * @param server the MRCP server to get statistics of
+ * @param phase the phase to get statistics of
+ * @param stat the statistics to fill
+ * @remark Can be called from any thread, counters are read one by one.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_setup_stat_get(const mrcp_server_t *server, mrcp_setup_phase_e phase, mrcp_setup_stat_t *stat);
+
+/**
+ * Get statistics of engine channel open time of an engine.
+ * @param server the MRCP server to get statistics of
+ * @param engine_id the identifier of the engine
+ * @param stat the statistics to fill
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_engine_setup_stat_get(const mrcp_server_t *server, const char *engine_id, mrcp_setup_stat_t *stat);
+
+/**
+ * Get the upper bound of time a percentage of setups completed within.
+ * @param stat the statistics to estimate the percentile by
+ * @param percentile the percentile (e.g. 50, 99)
+ * @return the time in usec (0 if nothing is measured)
+ */
+MRCP_DECLARE(apr_uint32_t) mrcp_setup_stat_percentile_get(const mrcp_setup_stat_t *stat, apr_size_t percentile);
+
+/**
+ * Get the name of a phase of session setup.
+ * @param phase the phase to get the name of
+ */
+MRCP_DECLARE(const char*) mrcp_setup_phase_name_get(mrcp_setup_phase_e phase);
+
+/**
+ * Get statistics of the time requests of a method are responded within.
+ * @param server the MRCP server to get statistics of
+ * @param resource_id the identifier of the resource
+ * @param method_id the identifier of the method of the resource
+ * @param stat the statistics to fill
+ * @remark The time is measured from the request is received to the response is sent,
+ *         including the time the request is queued behind other requests of the session.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_request_stat_get(const mrcp_server_t *server, mrcp_resource_id resource_id, mrcp_method_id method_id, mrcp_setup_stat_t *stat);
+
+/**
+ * Get statistics of the time an engine processes requests of a method within.
+ * @param server the MRCP server to get statistics of
+ * @param engine_id the identifier of the engine
+ * @param method_id the identifier of the method of the resource of the engine
+ * @param stage the stage of processing, up to the response or up to the COMPLETE event
+ * @param stat the statistics to fill
+ * @remark The time is measured from the request is sent to the engine, so unlike
+ *         mrcp_server_request_stat_get(), it doesn't depend on the load of the server.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_engine_request_stat_get(
+								const mrcp_server_t *server,
+								const char *engine_id,
+								mrcp_method_id method_id,
+								mrcp_request_stage_e stage,
+								mrcp_setup_stat_t *stat);
+
+/**
+ * Get the name of a stage of request processing by engine.
+ * @param stage the stage to get the name of
+ */
+MRCP_DECLARE(const char*) mrcp_request_stage_name_get(mrcp_request_stage_e stage);
+
+/**
+ * Get statistics of media processing time of the sessions taking the most of it across all the media engines.
+ * @param server the MRCP server to get statistics of
+ * @param stats the array of statistics to fill, ordered by smoothed processing time of a tick
+ * @param max_count the max number of statistics to fill
+ * @return the number of statistics filled
+ * @remark The name of a statistics is the name of the session and the group is the profile of it.
+ *         Only the media engines with <cpu-accounting> enabled are accounted.
+ */
+MRCP_DECLARE(apr_size_t) mrcp_server_session_cpu_top_get(const mrcp_server_t *server, mpf_context_stat_t *stats, apr_size_t max_count);
+
+/**
+ * Get statistics of media processing time of the sessions of a profile across all the media engines.
+ * @param server the MRCP server to get statistics of
+ * @param profile_id the identifier of the profile
+ * @param stat the statistics to fill
+ * @return FALSE if no session of the profile has been accounted yet
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_profile_cpu_stat_get(const mrcp_server_t *server, const char *profile_id, mpf_context_group_stat_t *stat);
+
+/**
+ * Get the number of messages waiting to be processed by the server.
+ * @param server the MRCP server to get the queue depth of
+ * @remark Can be called from any thread, the value is approximate.
+ */
+MRCP_DECLARE(apr_size_t) mrcp_server_queue_depth_get(const mrcp_server_t *server);
+
+/**
+ * Set the HTTP listener metrics are exported by (Prometheus text format on GET /metrics).
+ * @param server the MRCP server to export metrics of
+ * @param ip the local IP address to listen on
+ * @param port the local port to listen on
+ * @remark Must be called before the server is started, the listener is started
+ *         and stopped along with the server.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_metrics_listener_set(mrcp_server_t *server, const char *ip, apr_port_t port);
+
+/**
+ * Render metrics of the server in Prometheus text exposition format.
+ * @param server the MRCP server to render metrics of
+ * @param pool the pool to allocate the text from
+ * @remark Can be called from any thread, counters are read one by one.
+ */
+MRCP_DECLARE(char*) mrcp_server_metrics_render(const mrcp_server_t *server, apr_pool_t *pool);
+
+/**
+ * Render the load of the server as a compact list of parameters.
+ * @param server the MRCP server to render the load of
+ * @param pool the pool to allocate the text from
+ * @return "sessions=N;headroom=H[;free.<engine-id>=F...];weight=W", where H is
+ *         100 less the load of the busiest media engine, F is the number of free
+ *         channels of an engine with max channel count set, and W (0-100) is the
+ *         least of H and F in percents, 0 while draining
+ * @remark Can be called from any thread, meant for load balancers probing the server.
+ */
+MRCP_DECLARE(char*) mrcp_server_load_render(const mrcp_server_t *server, apr_pool_t *pool);
+
 
 /**
  * Register MRCP resource factory.
@@ -75,6 +319,33 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_engine_register(
 								mrcp_server_t *server, 
 								mrcp_engine_t *engine);
 
+/**
+ * Enable MRCP engine loaded at runtime.
+ * @param server the MRCP server to enable engine for
+ * @param engine the engine to enable
+ * @remark The engine is opened by the server task and, once opened, replaces
+ *         the registered engine of the same id in the profiles, so that new sessions
+ *         use it, while existing sessions run to completion on the replaced engine.
+ *         The replaced engine is closed and unloaded after its last channel is destroyed.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_engine_enable(mrcp_server_t *server, mrcp_engine_t *engine);
+
+/**
+ * Disable and unload MRCP engine at runtime.
+ * @param server the MRCP server to disable engine for
+ * @param id the identifier of the engine to disable
+ * @remark New sessions use another engine of the resource, if any,
+ *         existing sessions run to completion on the disabled engine.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_engine_disable(mrcp_server_t *server, const char *id);
+
+/**
+ * Get registered MRCP engine by id.
+ * @param server the MRCP server to get from
+ * @param id the identifier to lookup
+ */
+MRCP_DECLARE(mrcp_engine_t*) mrcp_server_engine_get(const mrcp_server_t *server, const char *id);
+
 /**
  * Register codec manager.
  * @param server the MRCP server to set codec manager for
@@ -113,6 +384,10 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_rtp_factory_register(
  * @param server the MRCP server to set RTP settings for
  * @param rtp_settings the settings to set
  * @param name the name of the settings
+ * @remark The settings registered by the name already replace the previous ones
+ *         for the profiles loaded next. The receivers open with the previous ones
+ *         switch to the jitter buffer config of the new ones at safe points,
+ *         if the new ones are marked for live update.
  */
 MRCP_DECLARE(apt_bool_t) mrcp_server_rtp_settings_register(
 								mrcp_server_t *server, 
@@ -137,6 +412,20 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_connection_agent_register(
 								mrcp_server_t *server, 
 								mrcp_connection_agent_t *connection_agent);
 
+/**
+ * Co-locate the processing of the sessions served by MRCP connection agent with the agent.
+ * @param server the MRCP server to co-locate the processing of
+ * @param connection_agent the registered connection agent (single worker) to co-locate with
+ * @remark All the messages of the sessions of the profiles the agent is used by are processed
+ *         on the poller thread of the agent rather than by the server task. MRCP messages are
+ *         parsed and dispatched to the session inline, with no queue hop, while the responses
+ *         and events are queued to the agent on the same thread. Must be set before the server
+ *         is started.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_connection_agent_colocate(
+								mrcp_server_t *server,
+								mrcp_connection_agent_t *connection_agent);
+
 /** Create MRCP profile */
 MRCP_DECLARE(mrcp_server_profile_t*) mrcp_server_profile_create(
 										const char *id,
@@ -149,17 +438,63 @@ MRCP_DECLARE(mrcp_server_profile_t*) mrcp_server_profile_create(
 										mpf_rtp_settings_t *rtp_settings,
 										apr_pool_t *pool);
 
+/**
+ * Create MRCP profile (extended version).
+ * @param id the identifier of the profile
+ * @param mrcp_version the MRCP version
+ * @param resource_factory the MRCP resource factory
+ * @param signaling_agent the signaling agent
+ * @param connection_agent the connection agent (MRCPv2 only)
+ * @param mpf_factory the factory (pool) of media engines to select an engine from for each session
+ * @param rtp_factory the RTP termination factory
+ * @param rtp_settings the RTP settings
+ * @param pool the pool to allocate memory from
+ */
+MRCP_DECLARE(mrcp_server_profile_t*) mrcp_server_profile_create_ex(
+										const char *id,
+										mrcp_version_e mrcp_version,
+										mrcp_resource_factory_t *resource_factory,
+										mrcp_sig_agent_t *signaling_agent,
+										mrcp_connection_agent_t *connection_agent,
+										mpf_engine_factory_t *mpf_factory,
+										mpf_termination_factory_t *rtp_factory,
+										mpf_rtp_settings_t *rtp_settings,
+										apr_pool_t *pool);
+
+/**
+ * Set the quota of the resources of MRCP profile.
+ * @param profile the profile to set the quota for
+ * @param quota the quota to copy
+ * @param pool the pool to allocate the token buckets from
+ * @remark Should be set before the profile is registered. New sessions beyond
+ *         max_session_count or max_session_rate are answered as overloaded, while
+ *         MRCP requests beyond max_request_rate are responded with 407 (Method Failed)
+ *         at once, with no engine involved and no queuing behind in-progress requests.
+ *         The rates are enforced by token buckets holding up to a second of tokens.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_profile_quota_set(mrcp_server_profile_t *profile, const mrcp_server_quota_t *quota, apr_pool_t *pool);
+
 /**
  * Register MRCP profile.
  * @param server the MRCP server to set profile for
  * @param profile the profile to set
  * @param plugin_map the map of engines (plugins)
+ * @remark Can be called at runtime. The profile registered by the same id
+ *         is replaced for new sessions, existing sessions keep using it.
  */
 MRCP_DECLARE(apt_bool_t) mrcp_server_profile_register(
 									mrcp_server_t *server, 
 									mrcp_server_profile_t *profile,
 									apr_table_t *plugin_map);
 
+/**
+ * Unregister MRCP profile at runtime.
+ * @param server the MRCP server to unregister profile from
+ * @param id the identifier of the profile
+ * @remark Existing sessions of the profile run to completion.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_profile_unregister(mrcp_server_t *server, const char *id);
+
 /**
  * Load MRCP engine as a plugin.
  * @param server the MRCP server to use
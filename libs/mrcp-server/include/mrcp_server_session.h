@@ -29,6 +29,7 @@
 #include "mpf_engine.h"
 #include "apt_task.h"
 #include "apt_obj_list.h"
+#include "apt_token_bucket.h"
 
 
 APT_BEGIN_EXTERN_C
@@ -61,6 +62,9 @@ struct mrcp_signaling_message_t {
 	mrcp_channel_t               *channel;
 	/** MRCP message */
 	mrcp_message_t               *message;
+
+	/** Time the message is received at */
+	apr_time_t                    time;
 };
 
 /** Server session states */
@@ -89,6 +93,12 @@ struct mrcp_server_session_t {
 	apr_array_header_t         *terminations;
 	/** MRCP control channel array */
 	apr_array_header_t         *channels;
+	/** Table of RTP termination slots by termination */
+	apr_hash_t                 *termination_table;
+	/** Table of MRCP channels by resource name */
+	apr_hash_t                 *channel_table;
+	/** Table of MRCP channels by engine channel termination */
+	apr_hash_t                 *channel_termination_table;
 
 	/** In-progress signaling request */
 	mrcp_signaling_message_t   *active_request;
@@ -99,6 +109,10 @@ struct mrcp_server_session_t {
 	mrcp_session_descriptor_t  *offer;
 	/** In-progres answer */
 	mrcp_session_descriptor_t  *answer;
+	/** Last successfully answered offer (the new offers are diffed against) */
+	mrcp_session_descriptor_t  *active_offer;
+	/** Answer to the active offer */
+	mrcp_session_descriptor_t  *active_answer;
 
 	/** MPF task message, which construction is in progress */
 	mpf_task_msg_t             *mpf_task_msg;
@@ -107,6 +121,13 @@ struct mrcp_server_session_t {
 	mrcp_server_session_state_e state;
 	/** Number of in-progress sub requests */
 	apr_size_t                  subrequest_count;
+
+	/** Time the in-progress offer is received at */
+	apr_time_t                  offer_time;
+	/** Time the processing of the in-progress offer is started at */
+	apr_time_t                  process_time;
+	/** Time the media of the in-progress offer is added at (engine channels are opened then) */
+	apr_time_t                  media_time;
 };
 
 /** MRCP server profile */
@@ -117,10 +138,12 @@ struct mrcp_server_profile_t {
 	mrcp_version_e             mrcp_version;
 	/** Table of engines (mrcp_engine_t*) */
 	apr_hash_t                *engine_table;
+	/** Map of resources to the names of the engines, engines loaded at runtime are assigned by (NULL if none) */
+	apr_table_t               *plugin_map;
 	/** MRCP resource factory */
 	mrcp_resource_factory_t   *resource_factory;
-	/** Media processing engine */
-	mpf_engine_t              *media_engine;
+	/** Factory (pool) of media processing engines */
+	mpf_engine_factory_t      *mpf_factory;
 	/** RTP termination factory */
 	mpf_termination_factory_t *rtp_termination_factory;
 	/** RTP settings */
@@ -129,10 +152,22 @@ struct mrcp_server_profile_t {
 	mrcp_sig_agent_t          *signaling_agent;
 	/** Connection agent */
 	mrcp_connection_agent_t   *connection_agent;
+	/** Number of sessions of the profile in the table of sessions */
+	volatile apr_uint32_t      session_count;
+	/** Quota of the resources of the profile */
+	mrcp_server_quota_t        quota;
+	/** Token bucket of session setups (NULL if not limited) */
+	apt_token_bucket_t        *session_bucket;
+	/** Token bucket of MRCP requests (NULL if not limited) */
+	apt_token_bucket_t        *request_bucket;
+	/** Number of sessions rejected by the quota */
+	volatile apr_uint32_t      session_reject_count;
+	/** Number of MRCP requests rejected by the quota */
+	volatile apr_uint32_t      request_reject_count;
 };
 
-/** Create server session */
-mrcp_server_session_t* mrcp_server_session_create(void);
+/** Create server session, from a pool of the recycler, if any */
+mrcp_server_session_t* mrcp_server_session_create(mrcp_session_recycler_t *recycler);
 
 /** Process signaling message */
 apt_bool_t mrcp_server_signaling_message_process(mrcp_signaling_message_t *signaling_message);
@@ -154,10 +189,31 @@ apt_bool_t mrcp_server_on_engine_channel_open(mrcp_channel_t *channel, apt_bool_
 apt_bool_t mrcp_server_on_engine_channel_close(mrcp_channel_t *channel);
 /** Process message receive event */
 apt_bool_t mrcp_server_on_engine_channel_message(mrcp_channel_t *channel, mrcp_message_t *message);
+/** Process event in the context of the engine, FALSE if it is to be signalled to the server task */
+apt_bool_t mrcp_server_on_engine_channel_event(mrcp_channel_t *channel, mrcp_message_t *message);
+/** Account message of the engine signalled to the server task */
+void mrcp_server_engine_channel_message_queue(mrcp_channel_t *channel, apr_size_t count);
+/** Process request dispatched by the state machine on delivery of event at the send site */
+apt_bool_t mrcp_server_on_engine_channel_request(mrcp_channel_t *channel, mrcp_message_t *message);
+/** Signal request dispatched by the state machine on delivery of event at the send site */
+apt_bool_t mrcp_server_engine_channel_request_signal(mrcp_channel_t *channel, mrcp_message_t *message);
 
 /** Get session by channel */
 mrcp_session_t* mrcp_server_channel_session_get(mrcp_channel_t *channel);
 
+/** Get whether events of engines are delivered to connection agents at the send site */
+apt_bool_t mrcp_server_event_fast_path_get(const mrcp_server_t *server);
+/** Get the threshold of session setup time to log slow setups at (msec) */
+apr_size_t mrcp_server_slow_setup_threshold_get(const mrcp_server_t *server);
+/** Record the time of a phase of session setup */
+void mrcp_server_setup_time_record(mrcp_server_t *server, mrcp_setup_phase_e phase, apr_interval_time_t elapsed);
+/** Record the time of engine channel open */
+void mrcp_server_engine_setup_time_record(mrcp_server_t *server, const char *engine_id, apr_interval_time_t elapsed);
+/** Record the time an engine processes a request within up to a stage */
+void mrcp_server_engine_request_time_record(mrcp_server_t *server, const char *engine_id, mrcp_method_id method_id, mrcp_request_stage_e stage, apr_interval_time_t elapsed);
+/** Record the time a request is responded within */
+void mrcp_server_request_time_record(mrcp_server_t *server, mrcp_resource_id resource_id, mrcp_method_id method_id, apr_interval_time_t elapsed);
+
 APT_END_EXTERN_C
 
 #endif /* MRCP_SERVER_SESSION_H */
@@ -36,6 +36,67 @@ typedef struct mrcp_server_t mrcp_server_t;
 /** Opaque MRCP server profile declaration */
 typedef struct mrcp_server_profile_t mrcp_server_profile_t;
 
+/** MRCP server admission control declaration */
+typedef struct mrcp_server_admission_t mrcp_server_admission_t;
+
+/** MRCP server profile quota declaration */
+typedef struct mrcp_server_quota_t mrcp_server_quota_t;
+
+/** Thresholds of live load, new sessions are rejected as overloaded beyond any of them */
+struct mrcp_server_admission_t {
+	/** Max load of the media engine in percents of the tick interval (0 - not checked) */
+	apr_uint32_t max_media_load;
+	/** Max number of messages waiting to be processed by the server (0 - not checked) */
+	apr_size_t   max_queue_depth;
+	/** Interval in seconds rejected sessions are advised to be retried after (0 - not advised) */
+	apr_size_t   retry_after;
+};
+
+/** Quota of the resources of a profile, the sessions and requests beyond are rejected */
+struct mrcp_server_quota_t {
+	/** Max number of sessions in progress (0 - not limited) */
+	apr_size_t max_session_count;
+	/** Max number of session setups per second (0 - not limited) */
+	apr_size_t max_session_rate;
+	/** Max number of MRCP requests per second across the sessions (0 - not limited) */
+	apr_size_t max_request_rate;
+};
+
+/** Number of buckets in the histogram of session setup time */
+#define MRCP_SETUP_HISTOGRAM_SIZE 16
+
+/** Phases of session setup (offer to answer) */
+typedef enum {
+	MRCP_SETUP_PHASE_SIGNALING, /**< offer is received, waiting to be processed (task queue, in-progress requests) */
+	MRCP_SETUP_PHASE_MEDIA,     /**< media terminations and control channels are added (MPF, connection agent) */
+	MRCP_SETUP_PHASE_ENGINE,    /**< engine channels are opened */
+	MRCP_SETUP_PHASE_TOTAL,     /**< offer is received to answer is sent */
+
+	MRCP_SETUP_PHASE_COUNT
+} mrcp_setup_phase_e;
+
+/** Stages of request processing by engine */
+typedef enum {
+	MRCP_REQUEST_STAGE_RESPONSE, /**< request is sent to engine to response is received */
+	MRCP_REQUEST_STAGE_COMPLETE, /**< request is sent to engine to COMPLETE event is received */
+
+	MRCP_REQUEST_STAGE_COUNT
+} mrcp_request_stage_e;
+
+/** MRCP session setup statistics declaration */
+typedef struct mrcp_setup_stat_t mrcp_setup_stat_t;
+
+/** Statistics of session setup time */
+struct mrcp_setup_stat_t {
+	/** Number of measured setups */
+	apr_uint32_t count;
+	/** Max time (usec) */
+	apr_uint32_t max_time;
+	/** Histogram of time, where the bucket N counts the setups
+	completed within (256 << N) usec and the last bucket counts the rest */
+	apr_uint32_t histogram[MRCP_SETUP_HISTOGRAM_SIZE];
+};
+
 
 APT_END_EXTERN_C
 
@@ -16,6 +16,10 @@
  * $Id$
  */
 
+#include <stdlib.h>
+#include <apr_thread_mutex.h>
+#include <apr_atomic.h>
+#include <apr_strings.h>
 #include "mrcp_server.h"
 #include "mrcp_server_session.h"
 #include "mrcp_message.h"
@@ -26,13 +30,45 @@
 #include "mrcp_sig_agent.h"
 #include "mrcp_server_connection.h"
 #include "mpf_termination_factory.h"
+#include "mpf_engine_factory.h"
+#include "mpf_engine.h"
 #include "apt_pool.h"
 #include "apt_consumer_task.h"
+#include "apt_shard_table.h"
 #include "apt_obj_list.h"
+#include "apt_http_exporter.h"
 #include "apt_log.h"
 
 #define SERVER_TASK_NAME "MRCP Server"
 
+/** Number of preallocated messages of the server task */
+#define MRCP_SERVER_MSG_POOL_SIZE 1024
+
+/** Number of buckets per shard of the table of sessions */
+#define SESSION_TABLE_BUCKET_COUNT 64
+
+/** Interval to check whether retired engines have channels left at (msec) */
+#define ENGINE_RETIRE_CHECK_INTERVAL 1000
+
+/** Content type of exported metrics (Prometheus text exposition format) */
+#define METRICS_CONTENT_TYPE "text/plain; version=0.0.4; charset=utf-8"
+
+/** Number of the most expensive sessions in metrics */
+#define METRICS_CPU_TOP_SIZE 10
+
+/** Statistics of an engine, kept by engine id across reloads */
+typedef struct mrcp_engine_stat_t mrcp_engine_stat_t;
+struct mrcp_engine_stat_t {
+	/** Time engine channels are opened within */
+	mrcp_setup_stat_t  open;
+	/** Resource of the engine */
+	mrcp_resource_t   *resource;
+	/** Number of methods of the resource of the engine */
+	apr_size_t         method_count;
+	/** Time requests are processed within by stage and method id */
+	mrcp_setup_stat_t *requests[MRCP_REQUEST_STAGE_COUNT];
+};
+
 /** MRCP server */
 struct mrcp_server_t {
 	/** Main message processing task */
@@ -44,6 +80,18 @@ struct mrcp_server_t {
 	mrcp_engine_factory_t   *engine_factory;
 	/** Loader of plugins for MRCP engines */
 	mrcp_engine_loader_t    *engine_loader;
+	/** Engines loaded or retired at runtime (engine_reload_t) */
+	apr_array_header_t      *engine_reloads;
+	/** Timer to check retired engines by */
+	apt_timer_t             *retire_timer;
+	/** Mutex to serialize changes of engines and profiles at runtime */
+	apr_thread_mutex_t      *reload_mutex;
+	/** Pool of the engine factory and loader and of the tables replaced at runtime, used under the reload mutex */
+	apr_pool_t              *reload_pool;
+	/** Executor of jobs shared among MRCP engines */
+	apt_executor_t          *executor;
+	/** Cache of fetched URIs shared among MRCP engines (NULL if disabled) */
+	mrcp_fetch_cache_t      *fetch_cache;
 
 	/** Codec manager */
 	mpf_codec_manager_t     *codec_manager;
@@ -55,19 +103,47 @@ struct mrcp_server_t {
 	apr_hash_t              *sig_agent_table;
 	/** Table of connection agents (mrcp_connection_agent_t*) */
 	apr_hash_t              *cnt_agent_table;
-	/** Table of RTP settings (mpf_rtp_settings_t*) */
+	/** Table of RTP settings (mpf_rtp_settings_t*), replaced as a whole at runtime */
 	apr_hash_t              *rtp_settings_table;
-	/** Table of profiles (mrcp_server_profile_t*) */
+	/** Table of profiles (mrcp_server_profile_t*), replaced as a whole at runtime */
 	apr_hash_t              *profile_table;
 
-	/** Table of sessions */
-	apr_hash_t              *session_table;
+	/** Table of sessions, sharded as sessions may be served by several workers */
+	apt_shard_table_t       *session_table;
+	/** Recycler of the pools of terminated sessions */
+	mrcp_session_recycler_t *session_recycler;
 
 	/** Connection task message pool */
 	apt_task_msg_pool_t     *connection_msg_pool;
+	/** Number of connection agents the processing of sessions is co-located with */
+	apr_size_t               colocated_count;
+	/** Signal method of the server task, messages of other sessions than co-located are signaled by */
+	apt_bool_t             (*task_msg_signal)(apt_task_t *task, apt_task_msg_t *msg);
 	/** Engine task message pool */
 	apt_task_msg_pool_t     *engine_msg_pool;
 
+	/** Admission control of new sessions */
+	mrcp_server_admission_t  admission;
+	/** Whether new sessions are rejected, while existing ones run to completion */
+	volatile apr_uint32_t    draining;
+
+	/** Threshold of session setup time to log slow setups at (msec) */
+	apr_size_t               slow_setup_threshold;
+	/** Size of memory to log sessions exceeding at (bytes) */
+	apr_size_t               session_memory_budget;
+	/** Whether events of engines are delivered to connection agents at the send site */
+	apt_bool_t               event_fast_path;
+	/** Statistics of the phases of session setup */
+	mrcp_setup_stat_t        setup_stats[MRCP_SETUP_PHASE_COUNT];
+	/** Table of statistics of engines by engine id (mrcp_engine_stat_t*), replaced as a whole at runtime */
+	apr_hash_t              *engine_stat_table;
+	/** Statistics of response time by resource id and method id, allocated at start */
+	mrcp_setup_stat_t      **request_stats;
+	/** Number of resources in request statistics */
+	apr_size_t               request_stat_count;
+	/** HTTP listener metrics are exported by (NULL if not configured) */
+	apt_http_exporter_t     *metrics_exporter;
+
 	/** Dir layout structure */
 	apt_dir_layout_t        *dir_layout;
 	/** Time server started at */
@@ -135,44 +211,94 @@ typedef enum {
 	ENGINE_TASK_MSG_CLOSE_ENGINE,
 	ENGINE_TASK_MSG_OPEN_CHANNEL,
 	ENGINE_TASK_MSG_CLOSE_CHANNEL,
-	ENGINE_TASK_MSG_MESSAGE
+	ENGINE_TASK_MSG_MESSAGE,
+	ENGINE_TASK_MSG_ENABLE_ENGINE,
+	ENGINE_TASK_MSG_DISABLE_ENGINE,
+	ENGINE_TASK_MSG_MESSAGES,
+	ENGINE_TASK_MSG_REQUESTS,
+	ENGINE_TASK_MSG_REQUEST
 } engine_task_msg_type_e;
 
+/** Max number of messages of a channel signalled by one task message */
+#define ENGINE_TASK_MSG_MAX_MESSAGES 8
+
 typedef struct engine_task_msg_data_t engine_task_msg_data_t;
 struct engine_task_msg_data_t {
 	mrcp_engine_t  *engine;
 	mrcp_channel_t *channel;
 	apt_bool_t      status;
 	mrcp_message_t *mrcp_message;
+	/** Messages signalled at once (ENGINE_TASK_MSG_MESSAGES) */
+	mrcp_message_t *mrcp_messages[ENGINE_TASK_MSG_MAX_MESSAGES];
+	apr_size_t      message_count;
 };
 
+/** State of engine loaded or retired at runtime */
+typedef enum {
+	ENGINE_RELOAD_OPENING, /**< loaded engine is being opened to replace the registered one */
+	ENGINE_RELOAD_RETIRED, /**< replaced engine waits for the channels of existing sessions to be destroyed */
+	ENGINE_RELOAD_CLOSING, /**< retired engine is being closed */
+	ENGINE_RELOAD_CLOSED   /**< retired engine is closed and is unloaded on the next check */
+} engine_reload_state_e;
+
+typedef struct engine_reload_t engine_reload_t;
+/** Engine loaded or retired at runtime */
+struct engine_reload_t {
+	mrcp_engine_t        *engine;
+	engine_reload_state_e state;
+	/** Whether the terminate request of the task waits for the engine to be closed */
+	apt_bool_t            terminating;
+};
+
+static apt_bool_t mrcp_server_engine_task_msg_signal(engine_task_msg_type_e type, mrcp_engine_t *engine, apt_bool_t status);
 static apt_bool_t mrcp_server_engine_open_signal(mrcp_engine_t *engine, apt_bool_t status);
 static apt_bool_t mrcp_server_engine_close_signal(mrcp_engine_t *engine);
+static apt_bool_t mrcp_server_engine_requests_signal(mrcp_engine_t *engine);
 
 const mrcp_engine_event_vtable_t engine_vtable = {
 	mrcp_server_engine_open_signal,
 	mrcp_server_engine_close_signal,
+	mrcp_server_engine_requests_signal
 };
 
 static apt_bool_t mrcp_server_channel_open_signal(mrcp_engine_channel_t *channel, apt_bool_t status);
 static apt_bool_t mrcp_server_channel_close_signal(mrcp_engine_channel_t *channel);
 static apt_bool_t mrcp_server_channel_message_signal(mrcp_engine_channel_t *channel, mrcp_message_t *message);
+static apt_bool_t mrcp_server_channel_messages_signal(mrcp_engine_channel_t *channel, mrcp_message_t *const *messages, apr_size_t count);
 
 const mrcp_engine_channel_event_vtable_t engine_channel_vtable = {
 	mrcp_server_channel_open_signal,
 	mrcp_server_channel_close_signal,
-	mrcp_server_channel_message_signal
+	mrcp_server_channel_message_signal,
+	mrcp_server_channel_messages_signal
 };
 
 /* Task interface */
 static apt_bool_t mrcp_server_msg_process(apt_task_t *task, apt_task_msg_t *msg);
+static apr_size_t mrcp_server_msg_affinity_get(apt_consumer_task_t *task, const apt_task_msg_t *msg);
+static apt_bool_t mrcp_server_task_msg_signal(apt_task_t *task, apt_task_msg_t *msg);
 static apt_bool_t mrcp_server_start_request_process(apt_task_t *task);
 static apt_bool_t mrcp_server_terminate_request_process(apt_task_t *task);
 static void mrcp_server_on_start_complete(apt_task_t *task);
 static void mrcp_server_on_terminate_complete(apt_task_t *task);
 
 static mrcp_session_t* mrcp_server_sig_agent_session_create(mrcp_sig_agent_t *signaling_agent);
+static char* mrcp_server_sig_agent_load_render(mrcp_sig_agent_t *signaling_agent, apr_pool_t *pool);
+
+static void mrcp_server_retire_timer_proc(apt_timer_t *timer, void *obj);
+
+/** Get the current version of a table, which is replaced as a whole at runtime */
+static APR_INLINE apr_hash_t* mrcp_server_table_get(apr_hash_t *const *table)
+{
+	/* compare-and-swap of NULL to NULL is a load with a full barrier */
+	return apr_atomic_casptr((volatile void**)table,NULL,NULL);
+}
 
+/** Publish a new version of a table, the previous one stays valid for the readers, which have got it */
+static APR_INLINE void mrcp_server_table_publish(apr_hash_t **table, apr_hash_t *new_table)
+{
+	apr_atomic_xchgptr((volatile void**)table,new_table);
+}
 
 /** Create MRCP server instance */
 MRCP_DECLARE(mrcp_server_t*) mrcp_server_create(apt_dir_layout_t *dir_layout)
@@ -195,6 +321,12 @@ MRCP_DECLARE(mrcp_server_t*) mrcp_server_create(apt_dir_layout_t *dir_layout)
 	server->resource_factory = NULL;
 	server->engine_factory = NULL;
 	server->engine_loader = NULL;
+	server->engine_reloads = NULL;
+	server->retire_timer = NULL;
+	server->reload_mutex = NULL;
+	server->reload_pool = NULL;
+	server->executor = NULL;
+	server->fetch_cache = NULL;
 	server->media_engine_table = NULL;
 	server->rtp_factory_table = NULL;
 	server->sig_agent_table = NULL;
@@ -202,10 +334,25 @@ MRCP_DECLARE(mrcp_server_t*) mrcp_server_create(apt_dir_layout_t *dir_layout)
 	server->rtp_settings_table = NULL;
 	server->profile_table = NULL;
 	server->session_table = NULL;
+	server->session_recycler = NULL;
 	server->connection_msg_pool = NULL;
+	server->colocated_count = 0;
+	server->task_msg_signal = NULL;
 	server->engine_msg_pool = NULL;
-
-	msg_pool = apt_task_msg_pool_create_dynamic(0,pool);
+	server->admission.max_media_load = 0;
+	server->admission.max_queue_depth = 0;
+	server->admission.retry_after = 0;
+	server->draining = 0;
+	server->slow_setup_threshold = 0;
+	server->session_memory_budget = 0;
+	server->event_fast_path = FALSE;
+	memset(server->setup_stats,0,sizeof(server->setup_stats));
+	server->engine_stat_table = NULL;
+	server->request_stats = NULL;
+	server->request_stat_count = 0;
+	server->metrics_exporter = NULL;
+
+	msg_pool = apt_task_msg_pool_create_static(0,MRCP_SERVER_MSG_POOL_SIZE,pool);
 
 	server->task = apt_consumer_task_create(server,msg_pool,pool);
 	if(!server->task) {
@@ -217,27 +364,1033 @@ MRCP_DECLARE(mrcp_server_t*) mrcp_server_create(apt_dir_layout_t *dir_layout)
 	vtable = apt_task_vtable_get(task);
 	if(vtable) {
 		vtable->process_msg = mrcp_server_msg_process;
+		server->task_msg_signal = vtable->signal_msg;
+		vtable->signal_msg = mrcp_server_task_msg_signal;
 		vtable->process_start = mrcp_server_start_request_process;
 		vtable->process_terminate = mrcp_server_terminate_request_process;
 		vtable->on_start_complete = mrcp_server_on_start_complete;
 		vtable->on_terminate_complete = mrcp_server_on_terminate_complete;
 	}
 
-	server->engine_factory = mrcp_engine_factory_create(server->pool);
-	server->engine_loader = mrcp_engine_loader_create(server->pool);
+	/* engines and profiles may be changed at runtime by other threads than the ones the server pool is used by */
+	server->reload_pool = apt_subpool_create(server->pool);
+	apr_thread_mutex_create(&server->reload_mutex,APR_THREAD_MUTEX_DEFAULT,server->pool);
+	server->engine_reloads = apr_array_make(server->reload_pool,1,sizeof(engine_reload_t));
+	server->retire_timer = apt_consumer_task_timer_create(server->task,mrcp_server_retire_timer_proc,server,server->pool);
+
+	server->engine_factory = mrcp_engine_factory_create(server->reload_pool);
+	server->engine_loader = mrcp_engine_loader_create(server->reload_pool);
+	mrcp_engine_loader_dir_layout_set(server->engine_loader,dir_layout);
+	server->executor = apt_executor_create(EXECUTOR_DEFAULT_THREAD_COUNT,server->pool);
 
 	server->media_engine_table = apr_hash_make(server->pool);
 	server->rtp_factory_table = apr_hash_make(server->pool);
-	server->rtp_settings_table = apr_hash_make(server->pool);
+	server->rtp_settings_table = apr_hash_make(server->reload_pool);
 	server->sig_agent_table = apr_hash_make(server->pool);
 	server->cnt_agent_table = apr_hash_make(server->pool);
 
-	server->profile_table = apr_hash_make(server->pool);
+	server->profile_table = apr_hash_make(server->reload_pool);
+	server->engine_stat_table = apr_hash_make(server->reload_pool);
 	
-	server->session_table = apr_hash_make(server->pool);
+	server->session_table = apt_shard_table_create(APT_SHARD_TABLE_DEFAULT_SHARD_COUNT,SESSION_TABLE_BUCKET_COUNT,server->pool);
+	server->session_recycler = mrcp_session_recycler_create(MRCP_SERVER_SESSION_CACHE_DEFAULT_SIZE,server->pool);
 	return server;
 }
 
+/** Set the number of worker threads sessions are processed by */
+MRCP_DECLARE(apt_bool_t) mrcp_server_worker_count_set(mrcp_server_t *server, apr_size_t count)
+{
+	if(!server || !server->task) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server");
+		return FALSE;
+	}
+	if(apt_consumer_task_workers_set(server->task,count,mrcp_server_msg_affinity_get) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Set Worker Count [%"APR_SIZE_T_FMT"]",count);
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Worker Count [%"APR_SIZE_T_FMT"]",count);
+	return TRUE;
+}
+
+/** Set the number of shards of the table of sessions */
+MRCP_DECLARE(apt_bool_t) mrcp_server_session_table_shards_set(mrcp_server_t *server, apr_size_t count)
+{
+	apt_shard_table_t *table;
+	if(!server || !server->session_table) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server");
+		return FALSE;
+	}
+	if(apt_shard_table_count_get(server->session_table) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Set Session Table Shards [%"APR_SIZE_T_FMT"]: sessions in progress",count);
+		return FALSE;
+	}
+	table = apt_shard_table_create(count,SESSION_TABLE_BUCKET_COUNT,server->pool);
+	if(!table) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Session Table [%"APR_SIZE_T_FMT"]",count);
+		return FALSE;
+	}
+	apt_shard_table_destroy(server->session_table);
+	server->session_table = table;
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Session Table Shards [%"APR_SIZE_T_FMT"]",apt_shard_table_shard_count_get(table));
+	return TRUE;
+}
+
+/** Set the max number of pools of terminated sessions kept for reuse */
+MRCP_DECLARE(apt_bool_t) mrcp_server_session_cache_size_set(mrcp_server_t *server, apr_size_t size)
+{
+	mrcp_session_recycler_t *recycler;
+	if(!server || !server->session_table) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server");
+		return FALSE;
+	}
+	if(apt_shard_table_count_get(server->session_table) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Set Session Cache Size [%"APR_SIZE_T_FMT"]: sessions in progress",size);
+		return FALSE;
+	}
+	recycler = NULL;
+	if(size) {
+		recycler = mrcp_session_recycler_create(size,server->pool);
+		if(!recycler) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Session Recycler [%"APR_SIZE_T_FMT"]",size);
+			return FALSE;
+		}
+	}
+	if(server->session_recycler) {
+		mrcp_session_recycler_destroy(server->session_recycler);
+	}
+	server->session_recycler = recycler;
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Session Cache Size [%"APR_SIZE_T_FMT"]",size);
+	return TRUE;
+}
+
+/** Set admission control of new sessions */
+MRCP_DECLARE(apt_bool_t) mrcp_server_admission_set(mrcp_server_t *server, const mrcp_server_admission_t *admission)
+{
+	if(!server || !admission) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server");
+		return FALSE;
+	}
+	server->admission = *admission;
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Admission Control [max media load %u%%, max queue depth %"APR_SIZE_T_FMT", retry after %"APR_SIZE_T_FMT" s]",
+		admission->max_media_load,
+		admission->max_queue_depth,
+		admission->retry_after);
+	return TRUE;
+}
+
+/** Get admission control of new sessions */
+MRCP_DECLARE(const mrcp_server_admission_t*) mrcp_server_admission_get(const mrcp_server_t *server)
+{
+	return &server->admission;
+}
+
+/** Start draining the server */
+MRCP_DECLARE(apt_bool_t) mrcp_server_drain(mrcp_server_t *server)
+{
+	if(!server || !server->session_table) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server");
+		return FALSE;
+	}
+	if(apr_atomic_cas32(&server->draining,1,0) == 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Drain Server [%"APR_SIZE_T_FMT" sessions in progress]",
+			apt_shard_table_count_get(server->session_table));
+	}
+	return TRUE;
+}
+
+/** Check whether the server is draining */
+MRCP_DECLARE(apt_bool_t) mrcp_server_is_draining(const mrcp_server_t *server)
+{
+	return server->draining ? TRUE : FALSE;
+}
+
+/** Check whether the server is draining and has no session in progress */
+MRCP_DECLARE(apt_bool_t) mrcp_server_is_drained(const mrcp_server_t *server)
+{
+	if(mrcp_server_is_draining(server) == FALSE) {
+		return FALSE;
+	}
+	return apt_shard_table_count_get(server->session_table) == 0 ? TRUE : FALSE;
+}
+
+/** Set the threshold of session setup time to log slow setups at */
+MRCP_DECLARE(apt_bool_t) mrcp_server_slow_setup_threshold_set(mrcp_server_t *server, apr_size_t threshold)
+{
+	if(!server) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server");
+		return FALSE;
+	}
+	server->slow_setup_threshold = threshold;
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Slow Setup Threshold [%"APR_SIZE_T_FMT" ms]",threshold);
+	return TRUE;
+}
+
+/** Enable delivery of events of engines to connection agents at the send site */
+MRCP_DECLARE(apt_bool_t) mrcp_server_event_fast_path_set(mrcp_server_t *server, apt_bool_t enable)
+{
+	if(!server) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server");
+		return FALSE;
+	}
+	server->event_fast_path = enable;
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Event Fast Path [%s]",enable == TRUE ? "on" : "off");
+	return TRUE;
+}
+
+/** Enable memory accounting of sessions, channels and connections */
+MRCP_DECLARE(apt_bool_t) mrcp_server_memory_accounting_set(mrcp_server_t *server, apr_size_t session_budget)
+{
+	if(!server) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server");
+		return FALSE;
+	}
+	apt_pool_accounting_set(TRUE);
+	server->session_memory_budget = session_budget;
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Enable Memory Accounting session budget [%"APR_SIZE_T_FMT" bytes]",session_budget);
+	return TRUE;
+}
+
+/** Enable the cache of fetched URIs shared among MRCP engines */
+MRCP_DECLARE(apt_bool_t) mrcp_server_fetch_cache_set(mrcp_server_t *server, const mrcp_fetch_cache_config_t *config)
+{
+	if(!server || !config || server->fetch_cache) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server");
+		return FALSE;
+	}
+	server->fetch_cache = mrcp_fetch_cache_create(config,server->executor,server->pool);
+	if(!server->fetch_cache) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Fetch Cache");
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Enable Fetch Cache [%"APR_SIZE_T_FMT" bytes] dir [%s]",
+		config->max_size,
+		config->dir_path ? config->dir_path : "none");
+	return TRUE;
+}
+
+/** Get whether events of engines are delivered to connection agents at the send site */
+apt_bool_t mrcp_server_event_fast_path_get(const mrcp_server_t *server)
+{
+	return server->event_fast_path;
+}
+
+/** Get the threshold of session setup time to log slow setups at */
+apr_size_t mrcp_server_slow_setup_threshold_get(const mrcp_server_t *server)
+{
+	return server->slow_setup_threshold;
+}
+
+static void mrcp_setup_stat_record(mrcp_setup_stat_t *stat, apr_interval_time_t elapsed)
+{
+	apr_uint32_t time;
+	apr_uint32_t max_time;
+	apr_size_t bucket = 0;
+	if(elapsed < 0) {
+		elapsed = 0;
+	}
+	time = elapsed > 0xFFFFFFFF ? 0xFFFFFFFF : (apr_uint32_t)elapsed;
+
+	while(bucket < MRCP_SETUP_HISTOGRAM_SIZE - 1 && time >= ((apr_uint32_t)256 << bucket)) {
+		bucket++;
+	}
+	/* sessions are served by several workers */
+	apr_atomic_inc32(&stat->histogram[bucket]);
+	apr_atomic_inc32(&stat->count);
+	do {
+		max_time = apr_atomic_read32(&stat->max_time);
+		if(time <= max_time) {
+			break;
+		}
+	}
+	while(apr_atomic_cas32(&stat->max_time,time,max_time) != max_time);
+}
+
+static void mrcp_setup_stat_copy(mrcp_setup_stat_t *stat, const mrcp_setup_stat_t *src_stat)
+{
+	apr_size_t i;
+	stat->count = apr_atomic_read32((volatile apr_uint32_t*)&src_stat->count);
+	stat->max_time = apr_atomic_read32((volatile apr_uint32_t*)&src_stat->max_time);
+	for(i=0; i<MRCP_SETUP_HISTOGRAM_SIZE; i++) {
+		stat->histogram[i] = apr_atomic_read32((volatile apr_uint32_t*)&src_stat->histogram[i]);
+	}
+}
+
+/** Record the time of a phase of session setup */
+void mrcp_server_setup_time_record(mrcp_server_t *server, mrcp_setup_phase_e phase, apr_interval_time_t elapsed)
+{
+	if(phase >= MRCP_SETUP_PHASE_COUNT) {
+		return;
+	}
+	mrcp_setup_stat_record(&server->setup_stats[phase],elapsed);
+}
+
+/** Record the time of engine channel open */
+void mrcp_server_engine_setup_time_record(mrcp_server_t *server, const char *engine_id, apr_interval_time_t elapsed)
+{
+	mrcp_engine_stat_t *engine_stat = apr_hash_get(mrcp_server_table_get(&server->engine_stat_table),engine_id,APR_HASH_KEY_STRING);
+	if(engine_stat) {
+		mrcp_setup_stat_record(&engine_stat->open,elapsed);
+	}
+}
+
+/** Record the time an engine processes a request within up to a stage */
+void mrcp_server_engine_request_time_record(mrcp_server_t *server, const char *engine_id, mrcp_method_id method_id, mrcp_request_stage_e stage, apr_interval_time_t elapsed)
+{
+	mrcp_engine_stat_t *engine_stat = apr_hash_get(mrcp_server_table_get(&server->engine_stat_table),engine_id,APR_HASH_KEY_STRING);
+	if(engine_stat && stage < MRCP_REQUEST_STAGE_COUNT && method_id < engine_stat->method_count) {
+		mrcp_setup_stat_record(&engine_stat->requests[stage][method_id],elapsed);
+	}
+}
+
+/** Allocate statistics of response time for the methods of the registered resources */
+static void mrcp_server_request_stats_create(mrcp_server_t *server)
+{
+	apr_size_t i;
+	mrcp_resource_t *resource;
+	if(!server->resource_factory || server->request_stats) {
+		return;
+	}
+	server->request_stat_count = mrcp_resource_count_get(server->resource_factory);
+	server->request_stats = apr_pcalloc(server->pool,sizeof(mrcp_setup_stat_t*) * (server->request_stat_count + 1));
+	for(i=0; i<server->request_stat_count; i++) {
+		resource = mrcp_resource_get(server->resource_factory,i);
+		if(resource && resource->method_count) {
+			server->request_stats[i] = apr_pcalloc(server->pool,sizeof(mrcp_setup_stat_t) * resource->method_count);
+		}
+	}
+}
+
+/** Get statistics of response time of a method */
+static mrcp_setup_stat_t* mrcp_server_request_stat_find(const mrcp_server_t *server, mrcp_resource_id resource_id, mrcp_method_id method_id)
+{
+	mrcp_resource_t *resource;
+	if(resource_id >= server->request_stat_count || !server->request_stats[resource_id]) {
+		return NULL;
+	}
+	resource = mrcp_resource_get(server->resource_factory,resource_id);
+	if(!resource || method_id >= resource->method_count) {
+		return NULL;
+	}
+	return &server->request_stats[resource_id][method_id];
+}
+
+/** Record the time a request is responded within */
+void mrcp_server_request_time_record(mrcp_server_t *server, mrcp_resource_id resource_id, mrcp_method_id method_id, apr_interval_time_t elapsed)
+{
+	mrcp_setup_stat_t *stat = mrcp_server_request_stat_find(server,resource_id,method_id);
+	if(stat) {
+		mrcp_setup_stat_record(stat,elapsed);
+	}
+}
+
+/** Get statistics of response time of a method */
+MRCP_DECLARE(apt_bool_t) mrcp_server_request_stat_get(const mrcp_server_t *server, mrcp_resource_id resource_id, mrcp_method_id method_id, mrcp_setup_stat_t *stat)
+{
+	const mrcp_setup_stat_t *request_stat;
+	if(!server || !stat) {
+		return FALSE;
+	}
+	request_stat = mrcp_server_request_stat_find(server,resource_id,method_id);
+	if(!request_stat) {
+		return FALSE;
+	}
+	mrcp_setup_stat_copy(stat,request_stat);
+	return TRUE;
+}
+
+/** Get statistics of media processing time of the most expensive sessions */
+MRCP_DECLARE(apr_size_t) mrcp_server_session_cpu_top_get(const mrcp_server_t *server, mpf_context_stat_t *stats, apr_size_t max_count)
+{
+	apr_hash_index_t *it;
+	void *val;
+	mpf_context_stat_t *engine_stats;
+	apr_size_t engine_count;
+	apr_size_t count = 0;
+	apr_size_t i;
+	apr_size_t k;
+	if(!server || !stats || !max_count) {
+		return 0;
+	}
+
+	engine_stats = malloc(sizeof(mpf_context_stat_t) * max_count);
+	if(!engine_stats) {
+		return 0;
+	}
+	for(it = apr_hash_first(NULL,server->media_engine_table); it; it = apr_hash_next(it)) {
+		apr_hash_this(it,NULL,NULL,&val);
+		engine_count = mpf_engine_context_top_get(val,engine_stats,max_count);
+		for(i=0; i<engine_count; i++) {
+			/* merge into the array ordered by smoothed processing time */
+			k = count;
+			while(k > 0 && stats[k-1].avg_time < engine_stats[i].avg_time) {
+				k--;
+			}
+			if(k >= max_count) {
+				break;
+			}
+			if(count < max_count) {
+				count++;
+			}
+			memmove(&stats[k+1],&stats[k],(count - k - 1) * sizeof(mpf_context_stat_t));
+			stats[k] = engine_stats[i];
+		}
+	}
+	free(engine_stats);
+	return count;
+}
+
+/** Get statistics of media processing time of the sessions of a profile */
+MRCP_DECLARE(apt_bool_t) mrcp_server_profile_cpu_stat_get(const mrcp_server_t *server, const char *profile_id, mpf_context_group_stat_t *stat)
+{
+	apr_hash_index_t *it;
+	void *val;
+	mpf_context_group_stat_t engine_stat;
+	apt_bool_t status = FALSE;
+	if(!server || !profile_id || !stat) {
+		return FALSE;
+	}
+
+	memset(stat,0,sizeof(mpf_context_group_stat_t));
+	apr_cpystrn(stat->name,profile_id,sizeof(stat->name));
+	for(it = apr_hash_first(NULL,server->media_engine_table); it; it = apr_hash_next(it)) {
+		apr_hash_this(it,NULL,NULL,&val);
+		if(mpf_engine_context_group_stat_get(val,profile_id,&engine_stat) == TRUE) {
+			stat->context_count += engine_stat.context_count;
+			stat->avg_time += engine_stat.avg_time;
+			stat->total_time += engine_stat.total_time;
+			status = TRUE;
+		}
+	}
+	return status;
+}
+
+/** Get statistics of a phase of session setup */
+MRCP_DECLARE(apt_bool_t) mrcp_server_setup_stat_get(const mrcp_server_t *server, mrcp_setup_phase_e phase, mrcp_setup_stat_t *stat)
+{
+	if(!server || !stat || phase >= MRCP_SETUP_PHASE_COUNT) {
+		return FALSE;
+	}
+	mrcp_setup_stat_copy(stat,&server->setup_stats[phase]);
+	return TRUE;
+}
+
+/** Get statistics of engine channel open time of an engine */
+MRCP_DECLARE(apt_bool_t) mrcp_server_engine_setup_stat_get(const mrcp_server_t *server, const char *engine_id, mrcp_setup_stat_t *stat)
+{
+	const mrcp_engine_stat_t *engine_stat;
+	if(!server || !engine_id || !stat) {
+		return FALSE;
+	}
+	engine_stat = apr_hash_get(mrcp_server_table_get(&server->engine_stat_table),engine_id,APR_HASH_KEY_STRING);
+	if(!engine_stat) {
+		return FALSE;
+	}
+	mrcp_setup_stat_copy(stat,&engine_stat->open);
+	return TRUE;
+}
+
+/** Get statistics of the time an engine processes requests of a method within */
+MRCP_DECLARE(apt_bool_t) mrcp_server_engine_request_stat_get(
+								const mrcp_server_t *server,
+								const char *engine_id,
+								mrcp_method_id method_id,
+								mrcp_request_stage_e stage,
+								mrcp_setup_stat_t *stat)
+{
+	const mrcp_engine_stat_t *engine_stat;
+	if(!server || !engine_id || !stat || stage >= MRCP_REQUEST_STAGE_COUNT) {
+		return FALSE;
+	}
+	engine_stat = apr_hash_get(mrcp_server_table_get(&server->engine_stat_table),engine_id,APR_HASH_KEY_STRING);
+	if(!engine_stat || method_id >= engine_stat->method_count) {
+		return FALSE;
+	}
+	mrcp_setup_stat_copy(stat,&engine_stat->requests[stage][method_id]);
+	return TRUE;
+}
+
+/** Get the name of a stage of request processing by engine */
+MRCP_DECLARE(const char*) mrcp_request_stage_name_get(mrcp_request_stage_e stage)
+{
+	static const char *names[MRCP_REQUEST_STAGE_COUNT] = {
+		"response",
+		"complete"
+	};
+	if(stage >= MRCP_REQUEST_STAGE_COUNT) {
+		return "unknown";
+	}
+	return names[stage];
+}
+
+/** Get the upper bound of time a percentage of setups completed within */
+MRCP_DECLARE(apr_uint32_t) mrcp_setup_stat_percentile_get(const mrcp_setup_stat_t *stat, apr_size_t percentile)
+{
+	apr_size_t i;
+	apr_size_t total = 0;
+	apr_size_t target;
+	apr_size_t accumulated = 0;
+	for(i=0; i<MRCP_SETUP_HISTOGRAM_SIZE; i++) {
+		total += stat->histogram[i];
+	}
+	if(!total) {
+		return 0;
+	}
+	if(percentile > 100) {
+		percentile = 100;
+	}
+	target = (total * percentile + 99) / 100;
+	for(i=0; i<MRCP_SETUP_HISTOGRAM_SIZE - 1; i++) {
+		accumulated += stat->histogram[i];
+		if(accumulated >= target && accumulated) {
+			apr_uint32_t bound = (apr_uint32_t)256 << i;
+			/* never report more than the max measured */
+			return (stat->max_time && stat->max_time < bound) ? stat->max_time : bound;
+		}
+	}
+	return stat->max_time;
+}
+
+/** Get the name of a phase of session setup */
+MRCP_DECLARE(const char*) mrcp_setup_phase_name_get(mrcp_setup_phase_e phase)
+{
+	static const char *names[MRCP_SETUP_PHASE_COUNT] = {
+		"signaling",
+		"media",
+		"engine",
+		"total"
+	};
+	if(phase >= MRCP_SETUP_PHASE_COUNT) {
+		return NULL;
+	}
+	return names[phase];
+}
+
+/** Get the number of messages waiting to be processed by the server */
+MRCP_DECLARE(apr_size_t) mrcp_server_queue_depth_get(const mrcp_server_t *server)
+{
+	return apt_consumer_task_queue_depth_get(server->task);
+}
+
+/** Append a line of metrics */
+static void mrcp_metrics_printf(apr_array_header_t *lines, const char *format, ...)
+{
+	va_list args;
+	va_start(args,format);
+	APR_ARRAY_PUSH(lines,const char*) = apr_pvsprintf(lines->pool,format,args);
+	va_end(args);
+}
+
+/** Append the description of a metric family, its samples must follow */
+static void mrcp_metrics_family_print(apr_array_header_t *lines, const char *name, const char *type, const char *help)
+{
+	mrcp_metrics_printf(lines,"# HELP unimrcp_%s %s\n# TYPE unimrcp_%s %s\n",name,help,name,type);
+}
+
+/** Append the samples of a histogram, where the bucket N counts the values within (base << N) usec */
+static void mrcp_metrics_histogram_print(
+				apr_array_header_t *lines,
+				const char *name,
+				const char *labels,
+				const apr_uint32_t *histogram,
+				apr_size_t size,
+				apr_uint32_t base)
+{
+	apr_size_t i;
+	apr_uint32_t count = 0;
+	const char *separator = *labels ? "," : "";
+	for(i=0; i<size - 1; i++) {
+		count += histogram[i];
+		mrcp_metrics_printf(lines,"unimrcp_%s_bucket{%s%sle=\"%.6f\"} %u\n",
+			name,labels,separator,(double)(base << i) / 1000000,count);
+	}
+	/* the last bucket counts the rest */
+	count += histogram[size - 1];
+	mrcp_metrics_printf(lines,"unimrcp_%s_bucket{%s%sle=\"+Inf\"} %u\n",name,labels,separator,count);
+	if(*labels) {
+		mrcp_metrics_printf(lines,"unimrcp_%s_count{%s} %u\n",name,labels,count);
+	}
+	else {
+		mrcp_metrics_printf(lines,"unimrcp_%s_count %u\n",name,count);
+	}
+}
+
+static void mrcp_metrics_task_collect(apt_task_t *task, void *obj)
+{
+	apr_array_header_t *tasks = obj;
+	APR_ARRAY_PUSH(tasks,apt_task_t*) = task;
+}
+
+/** Render metrics of the server */
+MRCP_DECLARE(char*) mrcp_server_metrics_render(const mrcp_server_t *server, apr_pool_t *pool)
+{
+	apr_array_header_t *lines;
+	apr_hash_t *profile_table;
+	apr_hash_t *engine_table;
+	apr_hash_t *engine_stat_table;
+	apr_hash_index_t *it;
+	const void *key;
+	void *val;
+	apr_size_t i;
+	apr_size_t j;
+	mrcp_setup_stat_t stat;
+	apt_pool_stat_t pool_stat;
+	apr_size_t media_engine_count;
+	mpf_engine_t **media_engines;
+	mpf_engine_tick_stat_t *tick_stats;
+	mpf_rtp_engine_stat_t *rtp_stats;
+	apr_array_header_t *tasks;
+	apt_task_stat_t *task_stats;
+	mpf_context_stat_t cpu_stats[METRICS_CPU_TOP_SIZE];
+	mpf_context_group_stat_t cpu_stat;
+	apr_size_t cpu_count;
+	apt_bool_t cpu_printed;
+
+	if(!server || !pool) {
+		return NULL;
+	}
+	lines = apr_array_make(pool,256,sizeof(const char*));
+	profile_table = mrcp_server_table_get(&server->profile_table);
+	engine_stat_table = mrcp_server_table_get(&server->engine_stat_table);
+
+	/* server */
+	mrcp_metrics_family_print(lines,"uptime_seconds","gauge","Time since the server is started.");
+	mrcp_metrics_printf(lines,"unimrcp_uptime_seconds %.3f\n",(double)(apr_time_now() - server->start_time) / APR_USEC_PER_SEC);
+	mrcp_metrics_family_print(lines,"draining","gauge","Whether new sessions are rejected before shutdown.");
+	mrcp_metrics_printf(lines,"unimrcp_draining %d\n",server->draining ? 1 : 0);
+	mrcp_metrics_family_print(lines,"sessions_active","gauge","Number of sessions in progress.");
+	mrcp_metrics_printf(lines,"unimrcp_sessions_active %"APR_SIZE_T_FMT"\n",apt_shard_table_count_get(server->session_table));
+	mrcp_metrics_family_print(lines,"task_queue_depth","gauge","Number of messages waiting to be processed by the server task.");
+	mrcp_metrics_printf(lines,"unimrcp_task_queue_depth %"APR_SIZE_T_FMT"\n",mrcp_server_queue_depth_get(server));
+
+	/* profiles, the engines of the profiles are collected on the way */
+	engine_table = apr_hash_make(pool);
+	mrcp_metrics_family_print(lines,"profile_sessions_active","gauge","Number of sessions in progress per profile.");
+	for(it = apr_hash_first(pool,profile_table); it; it = apr_hash_next(it)) {
+		apr_hash_index_t *engine_it;
+		mrcp_server_profile_t *profile;
+		apr_hash_this(it,NULL,NULL,&val);
+		profile = val;
+		if(!profile) continue;
+		mrcp_metrics_printf(lines,"unimrcp_profile_sessions_active{profile=\"%s\"} %u\n",
+			profile->id,apr_atomic_read32(&profile->session_count));
+		for(engine_it = apr_hash_first(pool,profile->engine_table); engine_it; engine_it = apr_hash_next(engine_it)) {
+			mrcp_engine_t *engine;
+			apr_hash_this(engine_it,NULL,NULL,&val);
+			engine = val;
+			if(engine && engine->id) {
+				apr_hash_set(engine_table,engine->id,APR_HASH_KEY_STRING,engine);
+			}
+		}
+	}
+
+	mrcp_metrics_family_print(lines,"profile_quota_rejects_total","counter","Number of sessions and requests rejected by the quota per profile.");
+	for(it = apr_hash_first(pool,profile_table); it; it = apr_hash_next(it)) {
+		mrcp_server_profile_t *profile;
+		apr_hash_this(it,NULL,NULL,&val);
+		profile = val;
+		if(!profile) continue;
+		mrcp_metrics_printf(lines,"unimrcp_profile_quota_rejects_total{profile=\"%s\",kind=\"session\"} %u\n",
+			profile->id,apr_atomic_read32(&profile->session_reject_count));
+		mrcp_metrics_printf(lines,"unimrcp_profile_quota_rejects_total{profile=\"%s\",kind=\"request\"} %u\n",
+			profile->id,apr_atomic_read32(&profile->request_reject_count));
+	}
+
+	/* engines */
+	mrcp_metrics_family_print(lines,"engine_channels_active","gauge","Number of engine channels in use per engine.");
+	for(it = apr_hash_first(pool,engine_table); it; it = apr_hash_next(it)) {
+		mrcp_engine_t *engine;
+		apr_hash_this(it,NULL,NULL,&val);
+		engine = val;
+		mrcp_metrics_printf(lines,"unimrcp_engine_channels_active{engine=\"%s\"} %u\n",
+			engine->id,apr_atomic_read32(&engine->cur_channel_count));
+	}
+	mrcp_metrics_family_print(lines,"engine_channels_max","gauge","Max number of engine channels per engine, if limited.");
+	for(it = apr_hash_first(pool,engine_table); it; it = apr_hash_next(it)) {
+		mrcp_engine_t *engine;
+		apr_hash_this(it,NULL,NULL,&val);
+		engine = val;
+		if(engine->config && engine->config->max_channel_count) {
+			mrcp_metrics_printf(lines,"unimrcp_engine_channels_max{engine=\"%s\"} %"APR_SIZE_T_FMT"\n",
+				engine->id,engine->config->max_channel_count);
+		}
+	}
+	mrcp_metrics_family_print(lines,"engine_suspended","gauge","Whether an engine is suspended for new sessions due to slow callbacks.");
+	for(it = apr_hash_first(pool,engine_table); it; it = apr_hash_next(it)) {
+		mrcp_engine_t *engine;
+		apr_hash_this(it,NULL,NULL,&val);
+		engine = val;
+		mrcp_metrics_printf(lines,"unimrcp_engine_suspended{engine=\"%s\"} %d\n",
+			engine->id,mrcp_engine_is_suspended(engine) == TRUE ? 1 : 0);
+	}
+	mrcp_metrics_family_print(lines,"engine_callback_seconds","histogram","Time spent inside plugin callbacks per engine and kind of callback.");
+	for(it = apr_hash_first(pool,engine_table); it; it = apr_hash_next(it)) {
+		mrcp_engine_t *engine;
+		mrcp_engine_callback_stat_t callback_stat;
+		apr_hash_this(it,NULL,NULL,&val);
+		engine = val;
+		for(j=0; j<MRCP_ENGINE_CALLBACK_COUNT; j++) {
+			mrcp_engine_callback_stat_get(engine,(mrcp_engine_callback_e)j,&callback_stat);
+			if(!callback_stat.count) continue;
+			mrcp_metrics_histogram_print(lines,"engine_callback_seconds",
+				apr_psprintf(pool,"engine=\"%s\",callback=\"%s\"",engine->id,mrcp_engine_callback_name_get((mrcp_engine_callback_e)j)),
+				callback_stat.histogram,MRCP_ENGINE_CALLBACK_HISTOGRAM_SIZE,16);
+		}
+	}
+	mrcp_metrics_family_print(lines,"engine_callbacks_slow_total","counter","Number of plugin callbacks exceeding the slow callback threshold per engine and kind of callback.");
+	for(it = apr_hash_first(pool,engine_table); it; it = apr_hash_next(it)) {
+		mrcp_engine_t *engine;
+		mrcp_engine_callback_stat_t callback_stat;
+		apr_hash_this(it,NULL,NULL,&val);
+		engine = val;
+		for(j=0; j<MRCP_ENGINE_CALLBACK_COUNT; j++) {
+			mrcp_engine_callback_stat_get(engine,(mrcp_engine_callback_e)j,&callback_stat);
+			if(!callback_stat.slow_count) continue;
+			mrcp_metrics_printf(lines,"unimrcp_engine_callbacks_slow_total{engine=\"%s\",callback=\"%s\"} %u\n",
+				engine->id,mrcp_engine_callback_name_get((mrcp_engine_callback_e)j),callback_stat.slow_count);
+		}
+	}
+	mrcp_metrics_family_print(lines,"engine_open_seconds","histogram","Time engine channels are opened within per engine.");
+	for(it = apr_hash_first(pool,engine_stat_table); it; it = apr_hash_next(it)) {
+		const mrcp_engine_stat_t *engine_stat;
+		apr_hash_this(it,&key,NULL,&val);
+		engine_stat = val;
+		mrcp_setup_stat_copy(&stat,&engine_stat->open);
+		mrcp_metrics_histogram_print(lines,"engine_open_seconds",apr_psprintf(pool,"engine=\"%s\"",(const char*)key),
+			stat.histogram,MRCP_SETUP_HISTOGRAM_SIZE,256);
+	}
+	mrcp_metrics_family_print(lines,"engine_request_seconds","histogram","Time engines process requests within per method, up to the response and up to the COMPLETE event.");
+	for(it = apr_hash_first(pool,engine_stat_table); it; it = apr_hash_next(it)) {
+		const mrcp_engine_stat_t *engine_stat;
+		const apt_str_table_item_t *method_table;
+		apr_size_t stage;
+		apr_hash_this(it,&key,NULL,&val);
+		engine_stat = val;
+		if(!engine_stat->resource || !engine_stat->resource->get_method_str_table) continue;
+		method_table = engine_stat->resource->get_method_str_table(MRCP_VERSION_2);
+		for(j=0; j<engine_stat->method_count; j++) {
+			for(stage=0; stage<MRCP_REQUEST_STAGE_COUNT; stage++) {
+				mrcp_setup_stat_copy(&stat,&engine_stat->requests[stage][j]);
+				if(!stat.count) {
+					/* methods never requested or never completed are omitted */
+					continue;
+				}
+				mrcp_metrics_histogram_print(lines,"engine_request_seconds",
+					apr_psprintf(pool,"engine=\"%s\",method=\"%s\",stage=\"%s\"",
+						(const char*)key,
+						method_table[j].value.buf,
+						mrcp_request_stage_name_get((mrcp_request_stage_e)stage)),
+					stat.histogram,MRCP_SETUP_HISTOGRAM_SIZE,256);
+			}
+		}
+	}
+
+	/* session setup and requests */
+	mrcp_metrics_family_print(lines,"session_setup_seconds","histogram","Time of the phases of session setup.");
+	for(i=0; i<MRCP_SETUP_PHASE_COUNT; i++) {
+		mrcp_setup_stat_copy(&stat,&server->setup_stats[i]);
+		mrcp_metrics_histogram_print(lines,"session_setup_seconds",
+			apr_psprintf(pool,"phase=\"%s\"",mrcp_setup_phase_name_get((mrcp_setup_phase_e)i)),
+			stat.histogram,MRCP_SETUP_HISTOGRAM_SIZE,256);
+	}
+	mrcp_metrics_family_print(lines,"request_seconds","histogram","Time MRCP requests are responded within per resource and method.");
+	for(i=0; i<server->request_stat_count; i++) {
+		const apt_str_table_item_t *method_table;
+		mrcp_resource_t *resource = mrcp_resource_get(server->resource_factory,i);
+		if(!resource || !server->request_stats[i] || !resource->get_method_str_table) continue;
+		method_table = resource->get_method_str_table(MRCP_VERSION_2);
+		for(j=0; j<resource->method_count; j++) {
+			mrcp_setup_stat_copy(&stat,&server->request_stats[i][j]);
+			if(!stat.count) {
+				/* methods never requested are omitted */
+				continue;
+			}
+			mrcp_metrics_histogram_print(lines,"request_seconds",
+				apr_psprintf(pool,"resource=\"%s\",method=\"%s\"",resource->name.buf,method_table[j].value.buf),
+				stat.histogram,MRCP_SETUP_HISTOGRAM_SIZE,256);
+		}
+	}
+
+	/* media engines, stats are taken once and printed by families */
+	media_engine_count = apr_hash_count(server->media_engine_table);
+	media_engines = apr_palloc(pool,sizeof(mpf_engine_t*) * (media_engine_count + 1));
+	tick_stats = apr_palloc(pool,sizeof(mpf_engine_tick_stat_t) * (media_engine_count + 1));
+	rtp_stats = apr_palloc(pool,sizeof(mpf_rtp_engine_stat_t) * (media_engine_count + 1));
+	i = 0;
+	for(it = apr_hash_first(pool,server->media_engine_table); it && i < media_engine_count; it = apr_hash_next(it)) {
+		apr_hash_this(it,NULL,NULL,&val);
+		media_engines[i] = val;
+		memset(&tick_stats[i],0,sizeof(mpf_engine_tick_stat_t));
+		memset(&rtp_stats[i],0,sizeof(mpf_rtp_engine_stat_t));
+		mpf_engine_tick_stat_get(media_engines[i],&tick_stats[i]);
+		mpf_engine_rtp_stat_get(media_engines[i],NULL,0,&rtp_stats[i]);
+		i++;
+	}
+	media_engine_count = i;
+
+	mrcp_metrics_family_print(lines,"mpf_load_percent","gauge","Load of media engine in percents of the tick interval.");
+	for(i=0; i<media_engine_count; i++) {
+		mrcp_metrics_printf(lines,"unimrcp_mpf_load_percent{engine=\"%s\"} %u\n",
+			mpf_engine_id_get(media_engines[i]),mpf_engine_load_get(media_engines[i]));
+	}
+	mrcp_metrics_family_print(lines,"mpf_tick_overruns_total","counter","Number of media ticks which took longer than the tick interval.");
+	for(i=0; i<media_engine_count; i++) {
+		mrcp_metrics_printf(lines,"unimrcp_mpf_tick_overruns_total{engine=\"%s\"} %u\n",
+			mpf_engine_id_get(media_engines[i]),tick_stats[i].overrun_count);
+	}
+	mrcp_metrics_family_print(lines,"mpf_tick_deferrals_total","counter","Number of media ticks which deferred objects past the tick deadline.");
+	for(i=0; i<media_engine_count; i++) {
+		mrcp_metrics_printf(lines,"unimrcp_mpf_tick_deferrals_total{engine=\"%s\"} %u\n",
+			mpf_engine_id_get(media_engines[i]),tick_stats[i].deferral_count);
+	}
+	mrcp_metrics_family_print(lines,"mpf_overload_level","gauge","Overload level of media engine (0 - none, 1 - RTCP suspended, 2 - in-band DTMF suspended).");
+	for(i=0; i<media_engine_count; i++) {
+		mrcp_metrics_printf(lines,"unimrcp_mpf_overload_level{engine=\"%s\"} %u\n",
+			mpf_engine_id_get(media_engines[i]),tick_stats[i].overload_level);
+	}
+	mrcp_metrics_family_print(lines,"mpf_tick_max_seconds","gauge","Max processing time of a media tick.");
+	for(i=0; i<media_engine_count; i++) {
+		mrcp_metrics_printf(lines,"unimrcp_mpf_tick_max_seconds{engine=\"%s\"} %.6f\n",
+			mpf_engine_id_get(media_engines[i]),(double)tick_stats[i].max_time / 1000000);
+	}
+	mrcp_metrics_family_print(lines,"mpf_tick_seconds","histogram","Processing time of media ticks.");
+	for(i=0; i<media_engine_count; i++) {
+		mrcp_metrics_histogram_print(lines,"mpf_tick_seconds",
+			apr_psprintf(pool,"engine=\"%s\"",mpf_engine_id_get(media_engines[i])),
+			tick_stats[i].histogram,MPF_TICK_HISTOGRAM_SIZE,64);
+	}
+
+	/* media processing time of sessions, accounted by the media engines with cpu-accounting enabled */
+	cpu_printed = FALSE;
+	for(it = apr_hash_first(pool,profile_table); it; it = apr_hash_next(it)) {
+		mrcp_server_profile_t *profile;
+		apr_hash_this(it,NULL,NULL,&val);
+		profile = val;
+		if(!profile || mrcp_server_profile_cpu_stat_get(server,profile->id,&cpu_stat) == FALSE) continue;
+		if(cpu_printed == FALSE) {
+			mrcp_metrics_family_print(lines,"profile_media_cpu_seconds_total","counter","Media processing time of the sessions per profile.");
+			cpu_printed = TRUE;
+		}
+		mrcp_metrics_printf(lines,"unimrcp_profile_media_cpu_seconds_total{profile=\"%s\"} %.6f\n",
+			profile->id,(double)cpu_stat.total_time / 1000000000);
+	}
+	cpu_count = mrcp_server_session_cpu_top_get(server,cpu_stats,METRICS_CPU_TOP_SIZE);
+	if(cpu_count) {
+		mrcp_metrics_family_print(lines,"session_media_tick_seconds","gauge","Smoothed media processing time of a tick of the most expensive sessions.");
+		for(i=0; i<cpu_count; i++) {
+			mrcp_metrics_printf(lines,"unimrcp_session_media_tick_seconds{session=\"%s\",profile=\"%s\"} %.9f\n",
+				cpu_stats[i].name,cpu_stats[i].group,(double)cpu_stats[i].avg_time / 1000000000);
+		}
+	}
+
+	mrcp_metrics_family_print(lines,"rtp_streams","gauge","Number of RTP streams.");
+	for(i=0; i<media_engine_count; i++) {
+		mrcp_metrics_printf(lines,"unimrcp_rtp_streams{engine=\"%s\"} %u\n",
+			mpf_engine_id_get(media_engines[i]),rtp_stats[i].stream_count);
+	}
+	mrcp_metrics_family_print(lines,"rtp_packets","gauge","Number of RTP packets of the current streams by kind.");
+	for(i=0; i<media_engine_count; i++) {
+		const char *id = mpf_engine_id_get(media_engines[i]);
+		mrcp_metrics_printf(lines,"unimrcp_rtp_packets{engine=\"%s\",kind=\"received\"} %u\n",id,rtp_stats[i].received_packets);
+		mrcp_metrics_printf(lines,"unimrcp_rtp_packets{engine=\"%s\",kind=\"lost\"} %u\n",id,rtp_stats[i].lost_packets);
+		mrcp_metrics_printf(lines,"unimrcp_rtp_packets{engine=\"%s\",kind=\"discarded\"} %u\n",id,rtp_stats[i].discarded_packets);
+		mrcp_metrics_printf(lines,"unimrcp_rtp_packets{engine=\"%s\",kind=\"invalid\"} %u\n",id,rtp_stats[i].invalid_packets);
+		mrcp_metrics_printf(lines,"unimrcp_rtp_packets{engine=\"%s\",kind=\"sent\"} %u\n",id,rtp_stats[i].sent_packets);
+	}
+	mrcp_metrics_family_print(lines,"rtp_jitter_seconds","gauge","Interarrival jitter across the RTP streams.");
+	for(i=0; i<media_engine_count; i++) {
+		const char *id = mpf_engine_id_get(media_engines[i]);
+		mrcp_metrics_printf(lines,"unimrcp_rtp_jitter_seconds{engine=\"%s\",stat=\"max\"} %.3f\n",id,(double)rtp_stats[i].max_jitter / 1000);
+		mrcp_metrics_printf(lines,"unimrcp_rtp_jitter_seconds{engine=\"%s\",stat=\"avg\"} %.3f\n",id,(double)rtp_stats[i].avg_jitter / 1000);
+	}
+	mrcp_metrics_family_print(lines,"rtp_playout_delay_seconds","gauge","Playout delay across the RTP streams.");
+	for(i=0; i<media_engine_count; i++) {
+		const char *id = mpf_engine_id_get(media_engines[i]);
+		mrcp_metrics_printf(lines,"unimrcp_rtp_playout_delay_seconds{engine=\"%s\",stat=\"max\"} %.3f\n",id,(double)rtp_stats[i].max_playout_delay / 1000);
+		mrcp_metrics_printf(lines,"unimrcp_rtp_playout_delay_seconds{engine=\"%s\",stat=\"avg\"} %.3f\n",id,(double)rtp_stats[i].avg_playout_delay / 1000);
+	}
+
+	/* the server task, signaling and connection agents, media engines and plugin tasks */
+	tasks = apr_array_make(pool,8,sizeof(apt_task_t*));
+	apt_task_walk(apt_consumer_task_base_get(server->task),mrcp_metrics_task_collect,tasks);
+	task_stats = apr_palloc(pool,sizeof(apt_task_stat_t) * (tasks->nelts + 1));
+	for(i=0; i<(apr_size_t)tasks->nelts; i++) {
+		apt_task_stat_get(APR_ARRAY_IDX(tasks,i,apt_task_t*),&task_stats[i]);
+	}
+	mrcp_metrics_family_print(lines,"task_msg_queued","gauge","Number of messages signalled to task, but not processed yet.");
+	for(i=0; i<(apr_size_t)tasks->nelts; i++) {
+		mrcp_metrics_printf(lines,"unimrcp_task_msg_queued{task=\"%s\"} %u\n",
+			apt_task_name_get(APR_ARRAY_IDX(tasks,i,apt_task_t*)),task_stats[i].queue_depth);
+	}
+	mrcp_metrics_family_print(lines,"task_msg_queued_max","gauge","Max number of messages signalled to task, but not processed yet.");
+	for(i=0; i<(apr_size_t)tasks->nelts; i++) {
+		mrcp_metrics_printf(lines,"unimrcp_task_msg_queued_max{task=\"%s\"} %u\n",
+			apt_task_name_get(APR_ARRAY_IDX(tasks,i,apt_task_t*)),task_stats[i].max_queue_depth);
+	}
+	mrcp_metrics_family_print(lines,"task_msg_wait_seconds","histogram","Time from message is signalled to task to it is processed.");
+	for(i=0; i<(apr_size_t)tasks->nelts; i++) {
+		mrcp_metrics_histogram_print(lines,"task_msg_wait_seconds",
+			apr_psprintf(pool,"task=\"%s\"",apt_task_name_get(APR_ARRAY_IDX(tasks,i,apt_task_t*))),
+			task_stats[i].wait_histogram,APT_TASK_HISTOGRAM_SIZE,64);
+	}
+	mrcp_metrics_family_print(lines,"task_msg_process_seconds","histogram","Time task messages are processed within.");
+	for(i=0; i<(apr_size_t)tasks->nelts; i++) {
+		mrcp_metrics_histogram_print(lines,"task_msg_process_seconds",
+			apr_psprintf(pool,"task=\"%s\"",apt_task_name_get(APR_ARRAY_IDX(tasks,i,apt_task_t*))),
+			task_stats[i].process_histogram,APT_TASK_HISTOGRAM_SIZE,64);
+	}
+
+	/* memory */
+	apt_pool_stat_get(&pool_stat);
+	mrcp_metrics_family_print(lines,"pools_active","gauge","Number of root memory pools in use.");
+	mrcp_metrics_printf(lines,"unimrcp_pools_active %"APR_SIZE_T_FMT"\n",pool_stat.pool_count);
+	mrcp_metrics_family_print(lines,"pool_allocators_cached","gauge","Number of idle allocators kept for new pools.");
+	mrcp_metrics_printf(lines,"unimrcp_pool_allocators_cached %"APR_SIZE_T_FMT"\n",pool_stat.cached_allocator_count);
+	mrcp_metrics_family_print(lines,"session_pools_cached","gauge","Number of pools of terminated sessions kept for reuse.");
+	mrcp_metrics_printf(lines,"unimrcp_session_pools_cached %"APR_SIZE_T_FMT"\n",
+		server->session_recycler ? mrcp_session_recycler_count_get(server->session_recycler) : 0);
+	if(apt_pool_accounting_get() == TRUE) {
+		apt_pool_account_stat_t account_stats[APT_POOL_OWNER_COUNT];
+		for(i=0; i<APT_POOL_OWNER_COUNT; i++) {
+			apt_pool_account_stat_get((apt_pool_owner_e)i,&account_stats[i]);
+		}
+		mrcp_metrics_family_print(lines,"pool_bytes","gauge","Size of memory held by accounted pools per owner, as of their last update.");
+		for(i=0; i<APT_POOL_OWNER_COUNT; i++) {
+			mrcp_metrics_printf(lines,"unimrcp_pool_bytes{owner=\"%s\"} %"APR_SIZE_T_FMT"\n",
+				apt_pool_owner_name_get((apt_pool_owner_e)i),account_stats[i].bytes);
+		}
+		mrcp_metrics_family_print(lines,"pool_bytes_peak","gauge","Max size of memory ever held by accounted pools per owner at once.");
+		for(i=0; i<APT_POOL_OWNER_COUNT; i++) {
+			mrcp_metrics_printf(lines,"unimrcp_pool_bytes_peak{owner=\"%s\"} %"APR_SIZE_T_FMT"\n",
+				apt_pool_owner_name_get((apt_pool_owner_e)i),account_stats[i].peak_bytes);
+		}
+		mrcp_metrics_family_print(lines,"pools_accounted","gauge","Number of accounted pools in use per owner.");
+		for(i=0; i<APT_POOL_OWNER_COUNT; i++) {
+			mrcp_metrics_printf(lines,"unimrcp_pools_accounted{owner=\"%s\"} %"APR_SIZE_T_FMT"\n",
+				apt_pool_owner_name_get((apt_pool_owner_e)i),account_stats[i].pool_count);
+		}
+	}
+
+	return apr_array_pstrcat(pool,lines,0);
+}
+
+/** Render the load of the server as a compact list of parameters */
+MRCP_DECLARE(char*) mrcp_server_load_render(const mrcp_server_t *server, apr_pool_t *pool)
+{
+	apr_array_header_t *params;
+	apr_hash_t *profile_table;
+	apr_hash_t *engine_table;
+	apr_hash_index_t *it;
+	void *val;
+	apr_uint32_t load;
+	apr_uint32_t max_load = 0;
+	apr_uint32_t headroom;
+	apr_uint32_t weight;
+
+	if(!server || !pool) {
+		return NULL;
+	}
+	params = apr_array_make(pool,8,sizeof(const char*));
+	profile_table = mrcp_server_table_get(&server->profile_table);
+
+	/* media engines, the busiest one limits the headroom */
+	for(it = apr_hash_first(pool,server->media_engine_table); it; it = apr_hash_next(it)) {
+		apr_hash_this(it,NULL,NULL,&val);
+		if(!val) continue;
+		load = mpf_engine_load_get(val);
+		if(load > max_load) {
+			max_load = load;
+		}
+	}
+	headroom = max_load < 100 ? 100 - max_load : 0;
+	weight = server->draining ? 0 : headroom;
+
+	APR_ARRAY_PUSH(params,const char*) = apr_psprintf(pool,"sessions=%"APR_SIZE_T_FMT,
+		apt_shard_table_count_get(server->session_table));
+	APR_ARRAY_PUSH(params,const char*) = apr_psprintf(pool,";headroom=%u",headroom);
+
+	/* engines of the profiles, only limited ones have free channels to report */
+	engine_table = apr_hash_make(pool);
+	for(it = apr_hash_first(pool,profile_table); it; it = apr_hash_next(it)) {
+		apr_hash_index_t *engine_it;
+		mrcp_server_profile_t *profile;
+		apr_hash_this(it,NULL,NULL,&val);
+		profile = val;
+		if(!profile) continue;
+		for(engine_it = apr_hash_first(pool,profile->engine_table); engine_it; engine_it = apr_hash_next(engine_it)) {
+			mrcp_engine_t *engine;
+			apr_size_t cur_count;
+			apr_size_t free_count;
+			apr_hash_this(engine_it,NULL,NULL,&val);
+			engine = val;
+			if(!engine || !engine->id || !engine->config || !engine->config->max_channel_count) continue;
+			if(apr_hash_get(engine_table,engine->id,APR_HASH_KEY_STRING)) continue;
+			apr_hash_set(engine_table,engine->id,APR_HASH_KEY_STRING,engine);
+
+			cur_count = apr_atomic_read32(&engine->cur_channel_count);
+			free_count = cur_count < engine->config->max_channel_count ? engine->config->max_channel_count - cur_count : 0;
+			if(mrcp_engine_is_suspended(engine) == TRUE) {
+				free_count = 0;
+			}
+			/* the weight is the least of the headroom and the free channels in percents */
+			if(free_count * 100 / engine->config->max_channel_count < weight) {
+				weight = (apr_uint32_t)(free_count * 100 / engine->config->max_channel_count);
+			}
+			APR_ARRAY_PUSH(params,const char*) = apr_psprintf(pool,";free.%s=%"APR_SIZE_T_FMT,engine->id,free_count);
+		}
+	}
+	APR_ARRAY_PUSH(params,const char*) = apr_psprintf(pool,";weight=%u",weight);
+	return apr_array_pstrcat(pool,params,0);
+}
+
+static const char* mrcp_server_metrics_exporter_render(void *obj, const char *path, apr_pool_t *pool)
+{
+	if(strcmp(path,"/metrics") != 0) {
+		return NULL;
+	}
+	return mrcp_server_metrics_render(obj,pool);
+}
+
+/** Set the HTTP listener metrics are exported by */
+MRCP_DECLARE(apt_bool_t) mrcp_server_metrics_listener_set(mrcp_server_t *server, const char *ip, apr_port_t port)
+{
+	if(!server || !ip || !port) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Metrics Listener");
+		return FALSE;
+	}
+	server->metrics_exporter = apt_http_exporter_create(ip,port,METRICS_CONTENT_TYPE,
+		mrcp_server_metrics_exporter_render,server,server->pool);
+	if(!server->metrics_exporter) {
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Metrics Listener %s:%hu",ip,port);
+	return TRUE;
+}
+
+/** Set the number of threads of the executor shared among MRCP engines */
+MRCP_DECLARE(apt_bool_t) mrcp_server_executor_thread_count_set(mrcp_server_t *server, apr_size_t count)
+{
+	if(!server || !server->executor) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server");
+		return FALSE;
+	}
+	if(apt_executor_thread_count_set(server->executor,count) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Set Executor Thread Count [%"APR_SIZE_T_FMT"]",count);
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Executor Thread Count [%"APR_SIZE_T_FMT"]",count);
+	return TRUE;
+}
+
+/** Bind the threads of the executor shared among MRCP engines to the set of CPUs */
+MRCP_DECLARE(apt_bool_t) mrcp_server_executor_cpu_set_set(mrcp_server_t *server, const apt_cpu_set_t *cpu_set)
+{
+	if(!server || !server->executor) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server");
+		return FALSE;
+	}
+	return apt_executor_cpu_set_set(server->executor,cpu_set);
+}
+
 /** Start message processing loop */
 MRCP_DECLARE(apt_bool_t) mrcp_server_start(mrcp_server_t *server)
 {
@@ -247,14 +1400,57 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_start(mrcp_server_t *server)
 		return FALSE;
 	}
 	server->start_time = apr_time_now();
+	mrcp_server_request_stats_create(server);
+	if(server->executor) {
+		/* engines may submit jobs as soon as they are opened */
+		apt_executor_start(server->executor);
+	}
 	task = apt_consumer_task_base_get(server->task);
 	if(apt_task_start(task) == FALSE) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Start Server Task");
 		return FALSE;
 	}
+	if(server->metrics_exporter) {
+		apt_http_exporter_start(server->metrics_exporter);
+	}
 	return TRUE;
 }
 
+/** Log percentiles of the time engines processed requests within */
+static void mrcp_server_engine_request_stats_log(mrcp_server_t *server)
+{
+	apr_hash_index_t *it;
+	const void *key;
+	void *val;
+	apr_size_t i;
+	apr_size_t stage;
+	mrcp_setup_stat_t stat;
+	const mrcp_engine_stat_t *engine_stat;
+	const apt_str_table_item_t *method_table;
+	apr_hash_t *table = mrcp_server_table_get(&server->engine_stat_table);
+
+	for(it = apr_hash_first(server->pool,table); it; it = apr_hash_next(it)) {
+		apr_hash_this(it,&key,NULL,&val);
+		engine_stat = val;
+		if(!engine_stat->resource || !engine_stat->resource->get_method_str_table) continue;
+		method_table = engine_stat->resource->get_method_str_table(MRCP_VERSION_2);
+		for(i=0; i<engine_stat->method_count; i++) {
+			for(stage=0; stage<MRCP_REQUEST_STAGE_COUNT; stage++) {
+				mrcp_setup_stat_copy(&stat,&engine_stat->requests[stage][i]);
+				if(!stat.count) continue;
+				apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Engine [%s] %s to %s: count %u p50 %u p99 %u max %u usec",
+					(const char*)key,
+					method_table[i].value.buf,
+					mrcp_request_stage_name_get((mrcp_request_stage_e)stage),
+					stat.count,
+					mrcp_setup_stat_percentile_get(&stat,50),
+					mrcp_setup_stat_percentile_get(&stat,99),
+					stat.max_time);
+			}
+		}
+	}
+}
+
 /** Shutdown message processing loop */
 MRCP_DECLARE(apt_bool_t) mrcp_server_shutdown(mrcp_server_t *server)
 {
@@ -264,14 +1460,22 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_shutdown(mrcp_server_t *server)
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server");
 		return FALSE;
 	}
+	if(server->metrics_exporter) {
+		/* no metrics are rendered, while the server is being torn down */
+		apt_http_exporter_stop(server->metrics_exporter);
+	}
 	task = apt_consumer_task_base_get(server->task);
 	if(apt_task_terminate(task,TRUE) == FALSE) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Shutdown Server Task");
 		return FALSE;
 	}
-	server->session_table = NULL;
+	if(server->executor) {
+		/* engines are closed by now */
+		apt_executor_stop(server->executor);
+	}
 	uptime = apr_time_now() - server->start_time;
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Server Uptime [%"APR_TIME_T_FMT" sec]", apr_time_sec(uptime));
+	mrcp_server_engine_request_stats_log(server);
 	return TRUE;
 }
 
@@ -279,48 +1483,150 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_shutdown(mrcp_server_t *server)
 MRCP_DECLARE(apt_bool_t) mrcp_server_destroy(mrcp_server_t *server)
 {
 	apt_task_t *task;
+	engine_reload_t *reload;
 	if(!server || !server->task) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server");
 		return FALSE;
 	}
 
+	/* engines being enabled or retired are not registered in the factory */
+	while((reload = apr_array_pop(server->engine_reloads)) != NULL) {
+		mrcp_engine_virtual_destroy(reload->engine);
+	}
 	mrcp_engine_factory_destroy(server->engine_factory);
 	mrcp_engine_loader_destroy(server->engine_loader);
 
 	task = apt_consumer_task_base_get(server->task);
 	apt_task_destroy(task);
 
+	if(server->fetch_cache) {
+		/* prefetches in progress are completed by the executor */
+		mrcp_fetch_cache_destroy(server->fetch_cache);
+		server->fetch_cache = NULL;
+	}
+	if(server->executor) {
+		apt_executor_destroy(server->executor);
+		server->executor = NULL;
+	}
+	if(server->session_table) {
+		apt_shard_table_destroy(server->session_table);
+		server->session_table = NULL;
+	}
+	if(server->session_recycler) {
+		mrcp_session_recycler_destroy(server->session_recycler);
+		server->session_recycler = NULL;
+	}
 	apr_pool_destroy(server->pool);
 	return TRUE;
 }
 
-/** Register MRCP resource factory */
-MRCP_DECLARE(apt_bool_t) mrcp_server_resource_factory_register(mrcp_server_t *server, mrcp_resource_factory_t *resource_factory)
+/** Register MRCP resource factory */
+MRCP_DECLARE(apt_bool_t) mrcp_server_resource_factory_register(mrcp_server_t *server, mrcp_resource_factory_t *resource_factory)
+{
+	if(!resource_factory) {
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Register Resource Factory");
+	server->resource_factory = resource_factory;
+	mrcp_engine_loader_resource_factory_set(server->engine_loader,resource_factory);
+	return TRUE;
+}
+
+/** Attach engine to the server, before the engine is opened (the reload mutex is held) */
+static void mrcp_server_engine_prepare(mrcp_server_t *server, mrcp_engine_t *engine)
+{
+	apr_hash_t *table;
+	if(!server->engine_msg_pool) {
+		server->engine_msg_pool = apt_task_msg_pool_create_dynamic(sizeof(engine_task_msg_data_t),server->reload_pool);
+	}
+	engine->codec_manager = server->codec_manager;
+	engine->dir_layout = server->dir_layout;
+	engine->executor = server->executor;
+	engine->fetch_cache = server->fetch_cache;
+	engine->event_vtable = &engine_vtable;
+	engine->event_obj = server;
+	table = mrcp_server_table_get(&server->engine_stat_table);
+	if(!apr_hash_get(table,engine->id,APR_HASH_KEY_STRING)) {
+		mrcp_engine_stat_t *engine_stat = apr_pcalloc(server->reload_pool,sizeof(mrcp_engine_stat_t));
+		mrcp_resource_t *resource = server->resource_factory ?
+			mrcp_resource_get(server->resource_factory,engine->resource_id) : NULL;
+		engine_stat->resource = resource;
+		if(resource && resource->method_count) {
+			apr_size_t i;
+			engine_stat->method_count = resource->method_count;
+			for(i=0; i<MRCP_REQUEST_STAGE_COUNT; i++) {
+				engine_stat->requests[i] = apr_pcalloc(server->reload_pool,sizeof(mrcp_setup_stat_t) * resource->method_count);
+			}
+		}
+		/* the table is read without lock by the workers, add to a copy of it */
+		table = apr_hash_copy(server->reload_pool,table);
+		apr_hash_set(table,engine->id,APR_HASH_KEY_STRING,engine_stat);
+		mrcp_server_table_publish(&server->engine_stat_table,table);
+	}
+}
+
+/** Register MRCP engine */
+MRCP_DECLARE(apt_bool_t) mrcp_server_engine_register(mrcp_server_t *server, mrcp_engine_t *engine)
+{
+	apt_bool_t status;
+	if(!engine || !engine->id) {
+		return FALSE;
+	}
+	
+	apr_thread_mutex_lock(server->reload_mutex);
+	mrcp_server_engine_prepare(server,engine);
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Register MRCP Engine [%s]",engine->id);
+	status = mrcp_engine_factory_engine_register(server->engine_factory,engine);
+	apr_thread_mutex_unlock(server->reload_mutex);
+	return status;
+}
+
+/** Get registered MRCP engine by id */
+MRCP_DECLARE(mrcp_engine_t*) mrcp_server_engine_get(const mrcp_server_t *server, const char *id)
+{
+	mrcp_engine_t *engine;
+	apr_thread_mutex_lock(server->reload_mutex);
+	engine = mrcp_engine_factory_engine_get(server->engine_factory,id);
+	apr_thread_mutex_unlock(server->reload_mutex);
+	return engine;
+}
+
+/** Enable MRCP engine loaded at runtime */
+MRCP_DECLARE(apt_bool_t) mrcp_server_engine_enable(mrcp_server_t *server, mrcp_engine_t *engine)
 {
-	if(!resource_factory) {
+	engine_reload_t *reload;
+	if(!server || !engine || !engine->id) {
 		return FALSE;
 	}
-	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Register Resource Factory");
-	server->resource_factory = resource_factory;
-	return TRUE;
+
+	apr_thread_mutex_lock(server->reload_mutex);
+	mrcp_server_engine_prepare(server,engine);
+	reload = apr_array_push(server->engine_reloads);
+	reload->engine = engine;
+	reload->state = ENGINE_RELOAD_OPENING;
+	reload->terminating = FALSE;
+	apr_thread_mutex_unlock(server->reload_mutex);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Enable MRCP Engine [%s]",engine->id);
+	/* the engine is opened by the server task */
+	return mrcp_server_engine_task_msg_signal(ENGINE_TASK_MSG_ENABLE_ENGINE,engine,TRUE);
 }
 
-/** Register MRCP engine */
-MRCP_DECLARE(apt_bool_t) mrcp_server_engine_register(mrcp_server_t *server, mrcp_engine_t *engine)
+/** Disable and unload MRCP engine at runtime */
+MRCP_DECLARE(apt_bool_t) mrcp_server_engine_disable(mrcp_server_t *server, const char *id)
 {
-	if(!engine || !engine->id) {
+	mrcp_engine_t *engine;
+	if(!server || !id) {
 		return FALSE;
 	}
-	
-	if(!server->engine_msg_pool) {
-		server->engine_msg_pool = apt_task_msg_pool_create_dynamic(sizeof(engine_task_msg_data_t),server->pool);
+
+	engine = mrcp_server_engine_get(server,id);
+	if(!engine) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Disable MRCP Engine [%s]: not registered",id);
+		return FALSE;
 	}
-	engine->codec_manager = server->codec_manager;
-	engine->dir_layout = server->dir_layout;
-	engine->event_vtable = &engine_vtable;
-	engine->event_obj = server;
-	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Register MRCP Engine [%s]",engine->id);
-	return mrcp_engine_factory_engine_register(server->engine_factory,engine);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Disable MRCP Engine [%s]",id);
+	return mrcp_server_engine_task_msg_signal(ENGINE_TASK_MSG_DISABLE_ENGINE,engine,TRUE);
 }
 
 /** Register codec manager */
@@ -389,18 +1695,34 @@ MRCP_DECLARE(mpf_termination_factory_t*) mrcp_server_rtp_factory_get(const mrcp_
 /** Register RTP settings */
 MRCP_DECLARE(apt_bool_t) mrcp_server_rtp_settings_register(mrcp_server_t *server, mpf_rtp_settings_t *rtp_settings, const char *name)
 {
+	apr_hash_t *table;
+	mpf_rtp_settings_t *prior;
 	if(!rtp_settings || !name) {
 		return FALSE;
 	}
-	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Register RTP Settings [%s]",name);
-	apr_hash_set(server->rtp_settings_table,name,APR_HASH_KEY_STRING,rtp_settings);
+	apr_thread_mutex_lock(server->reload_mutex);
+	table = mrcp_server_table_get(&server->rtp_settings_table);
+	prior = apr_hash_get(table,name,APR_HASH_KEY_STRING);
+	if(prior && prior != rtp_settings) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Replace RTP Settings [%s] live update [%d]",name,rtp_settings->live_update);
+		/* the sessions keep the settings they are created with, the receivers
+		open with the replaced settings follow them with live update at safe points */
+		apr_atomic_xchgptr((volatile void**)&prior->successor,rtp_settings);
+	}
+	else {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Register RTP Settings [%s]",name);
+	}
+	table = apr_hash_copy(server->reload_pool,table);
+	apr_hash_set(table,name,APR_HASH_KEY_STRING,rtp_settings);
+	mrcp_server_table_publish(&server->rtp_settings_table,table);
+	apr_thread_mutex_unlock(server->reload_mutex);
 	return TRUE;
 }
 
 /** Get RTP settings by name */
 MRCP_DECLARE(mpf_rtp_settings_t*) mrcp_server_rtp_settings_get(const mrcp_server_t *server, const char *name)
 {
-	return apr_hash_get(server->rtp_settings_table,name,APR_HASH_KEY_STRING);
+	return apr_hash_get(mrcp_server_table_get(&server->rtp_settings_table),name,APR_HASH_KEY_STRING);
 }
 
 /** Register MRCP signaling agent */
@@ -413,6 +1735,7 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_signaling_agent_register(mrcp_server_t *ser
 	signaling_agent->parent = server;
 	signaling_agent->resource_factory = server->resource_factory;
 	signaling_agent->create_server_session = mrcp_server_sig_agent_session_create;
+	signaling_agent->render_load = mrcp_server_sig_agent_load_render;
 	signaling_agent->msg_pool = apt_task_msg_pool_create_dynamic(sizeof(mrcp_signaling_message_t*),server->pool);
 	apr_hash_set(server->sig_agent_table,signaling_agent->id,APR_HASH_KEY_STRING,signaling_agent);
 	if(server->task) {
@@ -452,6 +1775,24 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_connection_agent_register(mrcp_server_t *se
 	return TRUE;
 }
 
+/** Co-locate the processing of the sessions served by MRCP connection agent with the agent */
+MRCP_DECLARE(apt_bool_t) mrcp_server_connection_agent_colocate(mrcp_server_t *server, mrcp_connection_agent_t *connection_agent)
+{
+	apt_task_t *task;
+	if(!server->task || !connection_agent) {
+		return FALSE;
+	}
+	task = apt_consumer_task_base_get(server->task);
+	if(mrcp_server_connection_colocated_task_get(connection_agent) == task) {
+		return TRUE;
+	}
+	if(mrcp_server_connection_colocated_task_set(connection_agent,task) == FALSE) {
+		return FALSE;
+	}
+	server->colocated_count++;
+	return TRUE;
+}
+
 /** Get connection agent by name */
 MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_server_connection_agent_get(const mrcp_server_t *server, const char *name)
 {
@@ -469,22 +1810,85 @@ MRCP_DECLARE(mrcp_server_profile_t*) mrcp_server_profile_create(
 										mpf_termination_factory_t *rtp_factory,
 										mpf_rtp_settings_t *rtp_settings,
 										apr_pool_t *pool)
+{
+	mpf_engine_factory_t *mpf_factory = NULL;
+	if(media_engine) {
+		mpf_factory = mpf_engine_factory_create(pool);
+		mpf_engine_factory_engine_add(mpf_factory,media_engine);
+	}
+
+	return mrcp_server_profile_create_ex(
+				id,
+				mrcp_version,
+				resource_factory,
+				signaling_agent,
+				connection_agent,
+				mpf_factory,
+				rtp_factory,
+				rtp_settings,
+				pool);
+}
+
+/** Create MRCP profile (extended version) */
+MRCP_DECLARE(mrcp_server_profile_t*) mrcp_server_profile_create_ex(
+										const char *id,
+										mrcp_version_e mrcp_version,
+										mrcp_resource_factory_t *resource_factory,
+										mrcp_sig_agent_t *signaling_agent,
+										mrcp_connection_agent_t *connection_agent,
+										mpf_engine_factory_t *mpf_factory,
+										mpf_termination_factory_t *rtp_factory,
+										mpf_rtp_settings_t *rtp_settings,
+										apr_pool_t *pool)
 {
 	mrcp_server_profile_t *profile = apr_palloc(pool,sizeof(mrcp_server_profile_t));
 	profile->id = id;
 	profile->mrcp_version = mrcp_version;
 	profile->resource_factory = resource_factory;
 	profile->engine_table = NULL;
-	profile->media_engine = media_engine;
+	profile->plugin_map = NULL;
+	profile->mpf_factory = mpf_factory;
 	profile->rtp_termination_factory = rtp_factory;
 	profile->rtp_settings = rtp_settings;
 	profile->signaling_agent = signaling_agent;
 	profile->connection_agent = connection_agent;
-
-	mpf_termination_factory_engine_assign(rtp_factory,media_engine);
+	profile->session_count = 0;
+	profile->quota.max_session_count = 0;
+	profile->quota.max_session_rate = 0;
+	profile->quota.max_request_rate = 0;
+	profile->session_bucket = NULL;
+	profile->request_bucket = NULL;
+	profile->session_reject_count = 0;
+	profile->request_reject_count = 0;
+
+	if(mpf_factory && rtp_factory)
+		mpf_engine_factory_rtp_factory_assign(mpf_factory,rtp_factory);
 	return profile;
 }
 
+/** Set the quota of the resources of MRCP profile */
+MRCP_DECLARE(apt_bool_t) mrcp_server_profile_quota_set(mrcp_server_profile_t *profile, const mrcp_server_quota_t *quota, apr_pool_t *pool)
+{
+	if(!profile || !quota) {
+		return FALSE;
+	}
+	profile->quota = *quota;
+	profile->session_bucket = NULL;
+	profile->request_bucket = NULL;
+	if(quota->max_session_rate) {
+		profile->session_bucket = apt_token_bucket_create(quota->max_session_rate,0,pool);
+	}
+	if(quota->max_request_rate) {
+		profile->request_bucket = apt_token_bucket_create(quota->max_request_rate,0,pool);
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Set Quota of Profile [%s] max sessions [%"APR_SIZE_T_FMT"] session rate [%"APR_SIZE_T_FMT"/s] request rate [%"APR_SIZE_T_FMT"/s]",
+		profile->id,
+		quota->max_session_count,
+		quota->max_session_rate,
+		quota->max_request_rate);
+	return TRUE;
+}
+
 static apt_bool_t mrcp_server_engine_table_make(mrcp_server_t *server, mrcp_server_profile_t *profile, apr_table_t *plugin_map)
 {
 	int i;
@@ -492,7 +1896,8 @@ static apt_bool_t mrcp_server_engine_table_make(mrcp_server_t *server, mrcp_serv
 	const char *plugin_name = NULL;
 	mrcp_engine_t *engine;
 
-	profile->engine_table = apr_hash_make(server->pool);
+	profile->engine_table = apr_hash_make(server->reload_pool);
+	profile->plugin_map = plugin_map;
 	for(i=0; i<MRCP_RESOURCE_TYPE_COUNT; i++) {
 		resource = mrcp_resource_get(server->resource_factory,i);
 		if(!resource) continue;
@@ -525,16 +1930,13 @@ static apt_bool_t mrcp_server_engine_table_make(mrcp_server_t *server, mrcp_serv
 	return TRUE;
 }
 
-/** Register MRCP profile */
-MRCP_DECLARE(apt_bool_t) mrcp_server_profile_register(
+/** Add profile to a new version of the table of profiles (the reload mutex is held) */
+static apt_bool_t mrcp_server_profile_add(
 							mrcp_server_t *server,
 							mrcp_server_profile_t *profile,
 							apr_table_t *plugin_map)
 {
-	if(!profile || !profile->id) {
-		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Register Profile: no name");
-		return FALSE;
-	}
+	apr_hash_t *table;
 	if(!profile->resource_factory) {
 		if(!server->resource_factory) {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Register Profile [%s]: missing resource factory",profile->id);
@@ -553,7 +1955,7 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_profile_register(
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Register Profile [%s]: missing connection agent",profile->id);
 		return FALSE;
 	}
-	if(!profile->media_engine) {
+	if(!profile->mpf_factory || mpf_engine_factory_is_empty(profile->mpf_factory) == TRUE) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Register Profile [%s]: missing media engine",profile->id);
 		return FALSE;
 	}
@@ -562,15 +1964,63 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_profile_register(
 		return FALSE;
 	}
 
-	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Register Profile [%s]",profile->id);
-	apr_hash_set(server->profile_table,profile->id,APR_HASH_KEY_STRING,profile);
+	table = mrcp_server_table_get(&server->profile_table);
+	if(apr_hash_get(table,profile->id,APR_HASH_KEY_STRING)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Replace Profile [%s]",profile->id);
+	}
+	else {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Register Profile [%s]",profile->id);
+	}
+	/* the table is read without lock by the signaling agents, sessions keep the profile they are created with */
+	table = apr_hash_copy(server->reload_pool,table);
+	apr_hash_set(table,profile->id,APR_HASH_KEY_STRING,profile);
+	mrcp_server_table_publish(&server->profile_table,table);
+	return TRUE;
+}
+
+/** Register MRCP profile */
+MRCP_DECLARE(apt_bool_t) mrcp_server_profile_register(
+							mrcp_server_t *server,
+							mrcp_server_profile_t *profile,
+							apr_table_t *plugin_map)
+{
+	apt_bool_t status;
+	if(!profile || !profile->id) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Register Profile: no name");
+		return FALSE;
+	}
+	apr_thread_mutex_lock(server->reload_mutex);
+	status = mrcp_server_profile_add(server,profile,plugin_map);
+	apr_thread_mutex_unlock(server->reload_mutex);
+	return status;
+}
+
+/** Unregister MRCP profile */
+MRCP_DECLARE(apt_bool_t) mrcp_server_profile_unregister(mrcp_server_t *server, const char *id)
+{
+	apr_hash_t *table;
+	if(!server || !id) {
+		return FALSE;
+	}
+	apr_thread_mutex_lock(server->reload_mutex);
+	table = mrcp_server_table_get(&server->profile_table);
+	if(!apr_hash_get(table,id,APR_HASH_KEY_STRING)) {
+		apr_thread_mutex_unlock(server->reload_mutex);
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Unregister Profile [%s]: not registered",id);
+		return FALSE;
+	}
+	table = apr_hash_copy(server->reload_pool,table);
+	apr_hash_set(table,id,APR_HASH_KEY_STRING,NULL);
+	mrcp_server_table_publish(&server->profile_table,table);
+	apr_thread_mutex_unlock(server->reload_mutex);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Unregister Profile [%s]",id);
 	return TRUE;
 }
 
 /** Get profile by name */
 MRCP_DECLARE(mrcp_server_profile_t*) mrcp_server_profile_get(const mrcp_server_t *server, const char *name)
 {
-	return apr_hash_get(server->profile_table,name,APR_HASH_KEY_STRING);
+	return apr_hash_get(mrcp_server_table_get(&server->profile_table),name,APR_HASH_KEY_STRING);
 }
 
 /** Load MRCP engine */
@@ -585,7 +2035,9 @@ MRCP_DECLARE(mrcp_engine_t*) mrcp_server_engine_load(
 		return FALSE;
 	}
 
+	apr_thread_mutex_lock(server->reload_mutex);
 	engine = mrcp_engine_loader_plugin_load(server->engine_loader,id,path,config);
+	apr_thread_mutex_unlock(server->reload_mutex);
 	if(!engine) {
 		return FALSE;
 	}
@@ -602,21 +2054,41 @@ void mrcp_server_session_add(mrcp_server_session_t *session)
 {
 	if(session->base.id.buf) {
 		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Add Session "APT_SID_FMT,MRCP_SESSION_SID(&session->base));
-		apr_hash_set(session->server->session_table,session->base.id.buf,session->base.id.length,session);
+		if(apt_shard_table_get(session->server->session_table,session->base.id.buf,session->base.id.length) == session) {
+			return;
+		}
+		if(apt_shard_table_set(session->server->session_table,session->base.id.buf,session->base.id.length,session) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Add Session "APT_SID_FMT": too long id",MRCP_SESSION_SID(&session->base));
+			return;
+		}
+		apr_atomic_inc32(&session->profile->session_count);
 	}
 }
 
 void mrcp_server_session_remove(mrcp_server_session_t *session)
 {
+	/* the pool of the session has grown to its peak by the termination */
+	apr_size_t bytes = apt_pool_account_update(session->base.pool);
+	if(session->server->session_memory_budget && bytes > session->server->session_memory_budget) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Session "APT_NAMESID_FMT" Exceeds Memory Budget [%"APR_SIZE_T_FMT" > %"APR_SIZE_T_FMT" bytes]",
+			session->base.name,
+			MRCP_SESSION_SID(&session->base),
+			bytes,
+			session->server->session_memory_budget);
+	}
 	if(session->base.id.buf) {
 		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Remove Session "APT_SID_FMT,MRCP_SESSION_SID(&session->base));
-		apr_hash_set(session->server->session_table,session->base.id.buf,session->base.id.length,NULL);
+		if(apt_shard_table_get(session->server->session_table,session->base.id.buf,session->base.id.length) != session) {
+			return;
+		}
+		apt_shard_table_set(session->server->session_table,session->base.id.buf,session->base.id.length,NULL);
+		apr_atomic_dec32(&session->profile->session_count);
 	}
 }
 
 static APR_INLINE mrcp_server_session_t* mrcp_server_session_find(mrcp_server_t *server, const apt_str_t *session_id)
 {
-	return apr_hash_get(server->session_table,session_id->buf,session_id->length);
+	return apt_shard_table_get(server->session_table,session_id->buf,session_id->length);
 }
 
 static apt_bool_t mrcp_server_start_request_process(apt_task_t *task)
@@ -631,10 +2103,22 @@ static apt_bool_t mrcp_server_start_request_process(apt_task_t *task)
 	for(; it; it = apr_hash_next(it)) {
 		apr_hash_this(it,NULL,NULL,&val);
 		engine = val;
-		if(engine) {
-			if(mrcp_engine_virtual_open(engine) == TRUE) {
-				apt_task_start_request_add(task);
+		if(!engine) {
+			continue;
+		}
+		if(engine->config && engine->config->open_mode != MRCP_ENGINE_OPEN_STARTUP &&
+			mrcp_engine_background_open_init(engine) == TRUE) {
+			/* the start does not wait for the engine opened in background */
+			if(engine->config->open_mode == MRCP_ENGINE_OPEN_PARALLEL) {
+				mrcp_engine_background_open(engine);
 			}
+			else {
+				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Open Engine on First Channel [%s]",engine->id);
+			}
+			continue;
+		}
+		if(mrcp_engine_virtual_open(engine) == TRUE) {
+			apt_task_start_request_add(task);
 		}
 	}
 
@@ -647,22 +2131,271 @@ static apt_bool_t mrcp_server_terminate_request_process(apt_task_t *task)
 	mrcp_server_t *server = apt_consumer_task_object_get(consumer_task);
 
 	mrcp_engine_t *engine;
+	engine_reload_t *reload;
 	apr_hash_index_t *it;
 	void *val;
+	int i;
+	apr_thread_mutex_lock(server->reload_mutex);
 	it = mrcp_engine_factory_engine_first(server->engine_factory);
 	for(; it; it = apr_hash_next(it)) {
 		apr_hash_this(it,NULL,NULL,&val);
 		engine = val;
 		if(engine) {
+			/* the engine being opened in background is closed, once opened */
+			mrcp_engine_background_open_wait(engine,-1);
 			if(mrcp_engine_virtual_close(engine) == TRUE) {
 				apt_task_terminate_request_add(task);
 			}
 		}
 	}
 
+	/* retired engines are closed regardless of the channels left */
+	for(i=0; i<server->engine_reloads->nelts; i++) {
+		reload = &APR_ARRAY_IDX(server->engine_reloads,i,engine_reload_t);
+		if(reload->state == ENGINE_RELOAD_RETIRED) {
+			reload->state = ENGINE_RELOAD_CLOSING;
+			if(mrcp_engine_virtual_close(reload->engine) == FALSE) {
+				reload->state = ENGINE_RELOAD_CLOSED;
+			}
+		}
+		if(reload->state == ENGINE_RELOAD_CLOSING) {
+			reload->terminating = TRUE;
+			apt_task_terminate_request_add(task);
+		}
+	}
+	apr_thread_mutex_unlock(server->reload_mutex);
+
 	return apt_task_terminate_request_process(task);
 }
 
+/** Find engine loaded or retired at runtime (the reload mutex is held) */
+static engine_reload_t* mrcp_server_engine_reload_find(mrcp_server_t *server, const mrcp_engine_t *engine)
+{
+	engine_reload_t *reload;
+	int i;
+	for(i=0; i<server->engine_reloads->nelts; i++) {
+		reload = &APR_ARRAY_IDX(server->engine_reloads,i,engine_reload_t);
+		if(reload->engine == engine) {
+			return reload;
+		}
+	}
+	return NULL;
+}
+
+/** Replace engine of resource in the profiles it is assigned to and publish the profiles for new sessions (the reload mutex is held) */
+static void mrcp_server_profiles_engine_replace(
+						mrcp_server_t *server,
+						mrcp_resource_id resource_id,
+						const mrcp_engine_t *engine,
+						mrcp_engine_t *new_engine)
+{
+	apr_hash_t *table = mrcp_server_table_get(&server->profile_table);
+	apr_hash_t *new_table = NULL;
+	mrcp_server_profile_t *profile;
+	mrcp_server_profile_t *new_profile;
+	mrcp_resource_t *resource;
+	const mrcp_engine_t *cur_engine;
+	const char *plugin_name;
+	apr_hash_index_t *it;
+	void *val;
+
+	it = apr_hash_first(server->reload_pool,table);
+	for(; it; it = apr_hash_next(it)) {
+		apr_hash_this(it,NULL,NULL,&val);
+		profile = val;
+		resource = mrcp_resource_get(profile->resource_factory,resource_id);
+		if(!resource) {
+			continue;
+		}
+		cur_engine = apr_hash_get(profile->engine_table,resource->name.buf,resource->name.length);
+		if(cur_engine != engine) {
+			/* the profile may name the new engine in its map, while another one is assigned */
+			plugin_name = NULL;
+			if(new_engine && profile->plugin_map) {
+				plugin_name = apr_table_get(profile->plugin_map,resource->name.buf);
+			}
+			if(!plugin_name || cur_engine == new_engine || strcasecmp(plugin_name,new_engine->id) != 0) {
+				continue;
+			}
+		}
+
+		/* existing sessions keep the profile they are created with */
+		new_profile = apr_palloc(server->reload_pool,sizeof(mrcp_server_profile_t));
+		*new_profile = *profile;
+		new_profile->engine_table = apr_hash_copy(server->reload_pool,profile->engine_table);
+		apr_hash_set(new_profile->engine_table,resource->name.buf,resource->name.length,new_engine);
+		if(new_engine) {
+			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Assign MRCP Engine [%s] [%s] to Profile [%s]",resource->name.buf,new_engine->id,profile->id);
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No MRCP Engine Available [%s] in Profile [%s]",resource->name.buf,profile->id);
+		}
+
+		if(!new_table) {
+			new_table = apr_hash_copy(server->reload_pool,table);
+		}
+		apr_hash_set(new_table,new_profile->id,APR_HASH_KEY_STRING,new_profile);
+	}
+
+	if(new_table) {
+		mrcp_server_table_publish(&server->profile_table,new_table);
+	}
+}
+
+/** Retire engine, which is closed and unloaded, once the channels of existing sessions are destroyed (the reload mutex is held) */
+static void mrcp_server_engine_retire(mrcp_server_t *server, mrcp_engine_t *engine)
+{
+	engine_reload_t *reload = mrcp_server_engine_reload_find(server,engine);
+	if(!reload) {
+		reload = apr_array_push(server->engine_reloads);
+		reload->engine = engine;
+		reload->terminating = FALSE;
+	}
+	reload->state = ENGINE_RELOAD_RETIRED;
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Retire MRCP Engine [%s] channels [%u]",
+		engine->id,
+		apr_atomic_read32(&engine->cur_channel_count));
+	apt_timer_set(server->retire_timer,ENGINE_RETIRE_CHECK_INTERVAL);
+}
+
+/** Open engine loaded at runtime */
+static void mrcp_server_engine_reload_open(mrcp_server_t *server, mrcp_engine_t *engine)
+{
+	engine_reload_t *reload;
+	apr_thread_mutex_lock(server->reload_mutex);
+	reload = mrcp_server_engine_reload_find(server,engine);
+	if(reload && reload->state == ENGINE_RELOAD_OPENING) {
+		if(mrcp_engine_virtual_open(engine) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open MRCP Engine [%s]",engine->id);
+			reload->state = ENGINE_RELOAD_CLOSED;
+			apt_timer_set(server->retire_timer,ENGINE_RETIRE_CHECK_INTERVAL);
+		}
+	}
+	apr_thread_mutex_unlock(server->reload_mutex);
+}
+
+/** Process open response of engine loaded at runtime, replace the registered engine of the same id by it */
+static apt_bool_t mrcp_server_engine_reload_on_open(mrcp_server_t *server, mrcp_engine_t *engine, apt_bool_t status)
+{
+	engine_reload_t *reload;
+	mrcp_engine_t *replaced;
+	apr_thread_mutex_lock(server->reload_mutex);
+	reload = mrcp_server_engine_reload_find(server,engine);
+	if(!reload || reload->state != ENGINE_RELOAD_OPENING) {
+		/* opened on start of the server */
+		apr_thread_mutex_unlock(server->reload_mutex);
+		return FALSE;
+	}
+
+	mrcp_engine_on_open(engine,status);
+	if(status == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open MRCP Engine [%s]",engine->id);
+		reload->state = ENGINE_RELOAD_CLOSED;
+		apt_timer_set(server->retire_timer,ENGINE_RETIRE_CHECK_INTERVAL);
+		apr_thread_mutex_unlock(server->reload_mutex);
+		return TRUE;
+	}
+
+	replaced = mrcp_engine_factory_engine_get(server->engine_factory,engine->id);
+	if(mrcp_engine_factory_engine_register(server->engine_factory,engine) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Register MRCP Engine [%s]",engine->id);
+		mrcp_server_engine_retire(server,engine);
+		apr_thread_mutex_unlock(server->reload_mutex);
+		return TRUE;
+	}
+
+	/* the engine is registered now */
+	*reload = APR_ARRAY_IDX(server->engine_reloads,server->engine_reloads->nelts - 1,engine_reload_t);
+	apr_array_pop(server->engine_reloads);
+
+	if(replaced) {
+		mrcp_server_profiles_engine_replace(server,replaced->resource_id,replaced,
+			replaced->resource_id == engine->resource_id ? engine :
+			mrcp_engine_factory_engine_find(server->engine_factory,replaced->resource_id));
+		mrcp_server_engine_retire(server,replaced);
+	}
+	if(!replaced || replaced->resource_id != engine->resource_id) {
+		/* assign the engine to the profiles, which have no engine of the resource */
+		mrcp_server_profiles_engine_replace(server,engine->resource_id,NULL,engine);
+	}
+	apr_thread_mutex_unlock(server->reload_mutex);
+	return TRUE;
+}
+
+/** Disable registered engine at runtime */
+static void mrcp_server_engine_reload_disable(mrcp_server_t *server, mrcp_engine_t *engine)
+{
+	apr_thread_mutex_lock(server->reload_mutex);
+	if(mrcp_engine_factory_engine_unregister(server->engine_factory,engine) == TRUE) {
+		mrcp_server_profiles_engine_replace(server,engine->resource_id,engine,
+			mrcp_engine_factory_engine_find(server->engine_factory,engine->resource_id));
+		mrcp_server_engine_retire(server,engine);
+	}
+	apr_thread_mutex_unlock(server->reload_mutex);
+}
+
+/** Process close response of engine retired at runtime */
+static apt_bool_t mrcp_server_engine_reload_on_close(mrcp_server_t *server, mrcp_engine_t *engine, apt_task_t *task)
+{
+	engine_reload_t *reload;
+	apr_thread_mutex_lock(server->reload_mutex);
+	reload = mrcp_server_engine_reload_find(server,engine);
+	if(!reload || reload->state != ENGINE_RELOAD_CLOSING) {
+		/* closed on termination of the server */
+		apr_thread_mutex_unlock(server->reload_mutex);
+		return FALSE;
+	}
+
+	mrcp_engine_on_close(engine);
+	reload->state = ENGINE_RELOAD_CLOSED;
+	if(reload->terminating == TRUE) {
+		apt_task_terminate_request_remove(task);
+	}
+	apr_thread_mutex_unlock(server->reload_mutex);
+	return TRUE;
+}
+
+/** Check retired engines, close the ones without channels and unload the closed ones */
+static void mrcp_server_retire_timer_proc(apt_timer_t *timer, void *obj)
+{
+	mrcp_server_t *server = obj;
+	engine_reload_t *reload;
+	mrcp_engine_t *engine;
+	apt_bool_t pending = FALSE;
+	int i = 0;
+
+	apr_thread_mutex_lock(server->reload_mutex);
+	while(i < server->engine_reloads->nelts) {
+		reload = &APR_ARRAY_IDX(server->engine_reloads,i,engine_reload_t);
+		engine = reload->engine;
+		if(reload->state == ENGINE_RELOAD_CLOSED) {
+			/* closed by the previous check at least, so that no channel is being destroyed anymore */
+			*reload = APR_ARRAY_IDX(server->engine_reloads,server->engine_reloads->nelts - 1,engine_reload_t);
+			apr_array_pop(server->engine_reloads);
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Unload MRCP Engine [%s]",engine->id);
+			mrcp_engine_virtual_destroy(engine);
+			mrcp_engine_loader_plugin_unload(server->engine_loader,engine);
+			continue;
+		}
+
+		if(reload->state == ENGINE_RELOAD_RETIRED && apr_atomic_read32(&engine->cur_channel_count) == 0) {
+			reload->state = ENGINE_RELOAD_CLOSING;
+			if(mrcp_engine_virtual_close(engine) == FALSE) {
+				reload->state = ENGINE_RELOAD_CLOSED;
+			}
+		}
+		if(reload->state != ENGINE_RELOAD_OPENING) {
+			pending = TRUE;
+		}
+		i++;
+	}
+	apr_thread_mutex_unlock(server->reload_mutex);
+
+	if(pending == TRUE) {
+		apt_timer_set(timer,ENGINE_RETIRE_CHECK_INTERVAL);
+	}
+}
+
 static void mrcp_server_on_start_complete(apt_task_t *task)
 {
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,SERVER_TASK_NAME" Started");
@@ -721,12 +2454,22 @@ static apt_bool_t mrcp_server_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 			engine_task_msg_data_t *data = (engine_task_msg_data_t*)msg->data;
 			switch(msg->sub_type) {
 				case ENGINE_TASK_MSG_OPEN_ENGINE:
-					mrcp_engine_on_open(data->engine,data->status);
-					apt_task_start_request_remove(task);
+					if(mrcp_server_engine_reload_on_open(data->engine->event_obj,data->engine,data->status) == FALSE) {
+						mrcp_engine_on_open(data->engine,data->status);
+						apt_task_start_request_remove(task);
+					}
 					break;
 				case ENGINE_TASK_MSG_CLOSE_ENGINE:
-					mrcp_engine_on_close(data->engine);
-					apt_task_terminate_request_remove(task);
+					if(mrcp_server_engine_reload_on_close(data->engine->event_obj,data->engine,task) == FALSE) {
+						mrcp_engine_on_close(data->engine);
+						apt_task_terminate_request_remove(task);
+					}
+					break;
+				case ENGINE_TASK_MSG_ENABLE_ENGINE:
+					mrcp_server_engine_reload_open(data->engine->event_obj,data->engine);
+					break;
+				case ENGINE_TASK_MSG_DISABLE_ENGINE:
+					mrcp_server_engine_reload_disable(data->engine->event_obj,data->engine);
 					break;
 				case ENGINE_TASK_MSG_OPEN_CHANNEL:
 					mrcp_server_on_engine_channel_open(data->channel,data->status);
@@ -737,6 +2480,21 @@ static apt_bool_t mrcp_server_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 				case ENGINE_TASK_MSG_MESSAGE:
 					mrcp_server_on_engine_channel_message(data->channel,data->mrcp_message);
 					break;
+				case ENGINE_TASK_MSG_MESSAGES:
+				{
+					apr_size_t i;
+					for(i=0; i<data->message_count; i++) {
+						mrcp_server_on_engine_channel_message(data->channel,data->mrcp_messages[i]);
+					}
+					break;
+				}
+				case ENGINE_TASK_MSG_REQUESTS:
+					/* signalled behind the messages the requests are dispatched by */
+					mrcp_engine_requests_flush(data->engine);
+					break;
+				case ENGINE_TASK_MSG_REQUEST:
+					mrcp_server_on_engine_channel_request(data->channel,data->mrcp_message);
+					break;
 				default:
 					break;
 			}
@@ -757,6 +2515,64 @@ static apt_bool_t mrcp_server_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 	return TRUE;
 }
 
+/** Get the session the message belongs to, so that messages of a session are always processed by the same worker */
+static apr_size_t mrcp_server_msg_affinity_get(apt_consumer_task_t *task, const apt_task_msg_t *msg)
+{
+	void *session = NULL;
+	switch(msg->type) {
+		case MRCP_SERVER_SIGNALING_TASK_MSG:
+		{
+			mrcp_signaling_message_t *const *signaling_message = (mrcp_signaling_message_t *const *) msg->data;
+			session = (*signaling_message)->session;
+			break;
+		}
+		case MRCP_SERVER_CONNECTION_TASK_MSG:
+		{
+			const connection_agent_task_msg_data_t *data = (const connection_agent_task_msg_data_t*)msg->data;
+			if(data->channel) {
+				session = mrcp_server_channel_session_get(data->channel);
+			}
+			break;
+		}
+		case MRCP_SERVER_ENGINE_TASK_MSG:
+		{
+			/* engine open/close complete the start/terminate requests of the task itself */
+			const engine_task_msg_data_t *data = (const engine_task_msg_data_t*)msg->data;
+			if(data->channel) {
+				session = mrcp_server_channel_session_get(data->channel);
+			}
+			break;
+		}
+		case MRCP_SERVER_MEDIA_TASK_MSG:
+		{
+			const mpf_message_container_t *container = (const mpf_message_container_t*) msg->data;
+			if(container->count && container->messages[0].context) {
+				session = mpf_engine_context_object_get(container->messages[0].context);
+			}
+			break;
+		}
+		default:
+			break;
+	}
+	return (apr_size_t)session;
+}
+
+/** Signal message to the server task, or to the connection agent the processing of the session is co-located with */
+static apt_bool_t mrcp_server_task_msg_signal(apt_task_t *task, apt_task_msg_t *msg)
+{
+	mrcp_server_t *server = apt_consumer_task_object_get(apt_task_object_get(task));
+	if(server->colocated_count) {
+		mrcp_server_session_t *session = (mrcp_server_session_t*)mrcp_server_msg_affinity_get(server->task,msg);
+		if(session && session->profile && session->profile->connection_agent &&
+			mrcp_server_connection_colocated_task_get(session->profile->connection_agent) == task) {
+			/* released on failure, not to be released once more by the caller */
+			apt_task_msg_forward(task,mrcp_server_connection_agent_task_get(session->profile->connection_agent),msg);
+			return TRUE;
+		}
+	}
+	return server->task_msg_signal(task,msg);
+}
+
 static apt_bool_t mrcp_server_signaling_task_msg_signal(mrcp_signaling_message_type_e type, mrcp_session_t *session, mrcp_session_descriptor_t *descriptor, mrcp_message_t *message)
 {
 	mrcp_signaling_message_t *signaling_message;
@@ -771,6 +2587,7 @@ static apt_bool_t mrcp_server_signaling_task_msg_signal(mrcp_signaling_message_t
 	signaling_message->descriptor = descriptor;
 	signaling_message->channel = NULL;
 	signaling_message->message = message;
+	signaling_message->time = apr_time_now();
 	*slot = signaling_message;
 	
 	return apt_task_msg_parent_signal(session->signaling_agent->task,task_msg);
@@ -796,6 +2613,10 @@ static apt_bool_t mrcp_server_connection_task_msg_signal(
 	data->message = message;
 	data->status = status;
 
+	if(mrcp_server_connection_colocated_task_get(agent) == task) {
+		/* raised on the poller thread the sessions of the agent are processed on, no queue hop */
+		return apt_task_msg_process(task,task_msg);
+	}
 	return apt_task_msg_signal(task,task_msg);
 }
 
@@ -815,6 +2636,7 @@ static apt_bool_t mrcp_server_engine_task_msg_signal(
 	data->channel = NULL;
 	data->status = status;
 	data->mrcp_message = NULL;
+	data->message_count = 0;
 
 	return apt_task_msg_signal(task,task_msg);
 }
@@ -838,6 +2660,27 @@ static apt_bool_t mrcp_server_channel_task_msg_signal(
 	data->channel = channel;
 	data->status = status;
 	data->mrcp_message = message;
+	data->message_count = 0;
+
+	return apt_task_msg_signal(task,task_msg);
+}
+
+/** Signal request dispatched by the state machine on delivery of event at the send site */
+apt_bool_t mrcp_server_engine_channel_request_signal(mrcp_channel_t *channel, mrcp_message_t *message)
+{
+	mrcp_session_t *session = mrcp_server_channel_session_get(channel);
+	mrcp_server_t *server = session->signaling_agent->parent;
+	apt_task_t *task = apt_consumer_task_base_get(server->task);
+	engine_task_msg_data_t *data;
+	apt_task_msg_t *task_msg = apt_task_msg_acquire(server->engine_msg_pool);
+	task_msg->type = MRCP_SERVER_ENGINE_TASK_MSG;
+	task_msg->sub_type = ENGINE_TASK_MSG_REQUEST;
+	data = (engine_task_msg_data_t*) task_msg->data;
+	data->engine = NULL;
+	data->channel = channel;
+	data->status = TRUE;
+	data->mrcp_message = message;
+	data->message_count = 0;
 
 	return apt_task_msg_signal(task,task_msg);
 }
@@ -847,7 +2690,11 @@ static mrcp_server_profile_t* mrcp_server_profile_get_by_agent(mrcp_server_t *se
 	mrcp_server_profile_t *profile;
 	apr_hash_index_t *it;
 	void *val;
-	it = apr_hash_first(session->base.pool,server->profile_table);
+	if(signaling_agent->primary) {
+		/* workers serve the profiles of the primary agent */
+		signaling_agent = signaling_agent->primary;
+	}
+	it = apr_hash_first(session->base.pool,mrcp_server_table_get(&server->profile_table));
 	for(; it; it = apr_hash_next(it)) {
 		apr_hash_this(it,NULL,NULL,&val);
 		profile = val;
@@ -858,10 +2705,18 @@ static mrcp_server_profile_t* mrcp_server_profile_get_by_agent(mrcp_server_t *se
 	return NULL;
 }
 
+static char* mrcp_server_sig_agent_load_render(mrcp_sig_agent_t *signaling_agent, apr_pool_t *pool)
+{
+	return mrcp_server_load_render(signaling_agent->parent,pool);
+}
+
 static mrcp_session_t* mrcp_server_sig_agent_session_create(mrcp_sig_agent_t *signaling_agent)
 {
 	mrcp_server_t *server = signaling_agent->parent;
-	mrcp_server_session_t *session = mrcp_server_session_create();
+	mrcp_server_session_t *session = mrcp_server_session_create(server->session_recycler);
+	if(!session) {
+		return NULL;
+	}
 	session->server = server;
 	session->profile = mrcp_server_profile_get_by_agent(server,session,signaling_agent);
 	if(!session->profile) {
@@ -957,6 +2812,10 @@ static apt_bool_t mrcp_server_disconnect_signal(mrcp_control_channel_t *channel)
 
 static apt_bool_t mrcp_server_engine_open_signal(mrcp_engine_t *engine, apt_bool_t status)
 {
+	if(mrcp_engine_background_open_respond(engine,status) == TRUE) {
+		/* opened in background, the server task is not waiting for the response */
+		return TRUE;
+	}
 	return mrcp_server_engine_task_msg_signal(
 								ENGINE_TASK_MSG_OPEN_ENGINE,
 								engine,
@@ -971,6 +2830,14 @@ static apt_bool_t mrcp_server_engine_close_signal(mrcp_engine_t *engine)
 								TRUE);
 }
 
+static apt_bool_t mrcp_server_engine_requests_signal(mrcp_engine_t *engine)
+{
+	return mrcp_server_engine_task_msg_signal(
+								ENGINE_TASK_MSG_REQUESTS,
+								engine,
+								TRUE);
+}
+
 static apt_bool_t mrcp_server_channel_open_signal(mrcp_engine_channel_t *channel, apt_bool_t status)
 {
 	return mrcp_server_channel_task_msg_signal(
@@ -991,9 +2858,49 @@ static apt_bool_t mrcp_server_channel_close_signal(mrcp_engine_channel_t *channe
 
 static apt_bool_t mrcp_server_channel_message_signal(mrcp_engine_channel_t *channel, mrcp_message_t *message)
 {
+	/* barge-in is acted on in the context of the engine, ahead of the task */
+	mrcp_engine_channel_barge_in_process(channel,message);
+	if(mrcp_server_on_engine_channel_event(channel->event_obj,message) == TRUE) {
+		/* validated and queued to the connection agent with no hop by the server task */
+		return TRUE;
+	}
+	mrcp_server_engine_channel_message_queue(channel->event_obj,1);
 	return mrcp_server_channel_task_msg_signal(
 								ENGINE_TASK_MSG_MESSAGE,
 								channel,
 								TRUE,
 								message);
 }
+
+static apt_bool_t mrcp_server_channel_messages_signal(mrcp_engine_channel_t *engine_channel, mrcp_message_t *const *messages, apr_size_t count)
+{
+	mrcp_channel_t *channel = engine_channel->event_obj;
+	mrcp_session_t *session = mrcp_server_channel_session_get(channel);
+	mrcp_server_t *server = session->signaling_agent->parent;
+	apt_task_t *task = apt_consumer_task_base_get(server->task);
+	engine_task_msg_data_t *data;
+	apt_task_msg_t *task_msg;
+	apt_bool_t status = TRUE;
+
+	while(count) {
+		task_msg = apt_task_msg_acquire(server->engine_msg_pool);
+		task_msg->type = MRCP_SERVER_ENGINE_TASK_MSG;
+		task_msg->sub_type = ENGINE_TASK_MSG_MESSAGES;
+		data = (engine_task_msg_data_t*) task_msg->data;
+		data->engine = engine_channel->engine;
+		data->channel = channel;
+		data->status = TRUE;
+		data->mrcp_message = NULL;
+		data->message_count = 0;
+		/* larger batches take several task messages, processed in order by the same worker */
+		for(; count && data->message_count < ENGINE_TASK_MSG_MAX_MESSAGES; count--, messages++) {
+			mrcp_engine_channel_barge_in_process(engine_channel,*messages);
+			data->mrcp_messages[data->message_count++] = *messages;
+		}
+		mrcp_server_engine_channel_message_queue(channel,data->message_count);
+		if(apt_task_msg_signal(task,task_msg) == FALSE) {
+			status = FALSE;
+		}
+	}
+	return status;
+}
@@ -16,6 +16,8 @@
  * $Id$
  */
 
+#include <apr_atomic.h>
+#include <apr_thread_mutex.h>
 #include "mrcp_server.h"
 #include "mrcp_server_session.h"
 #include "mrcp_resource.h"
@@ -27,9 +29,13 @@
 #include "mrcp_control_descriptor.h"
 #include "mrcp_state_machine.h"
 #include "mrcp_message.h"
+#include "mrcp_synth_resource.h"
+#include "mrcp_synth_header.h"
 #include "mpf_termination_factory.h"
+#include "mpf_engine_factory.h"
 #include "mpf_stream.h"
 #include "apt_consumer_task.h"
+#include "apt_pool.h"
 #include "apt_log.h"
 
 /** Macro to log session name and identifier */
@@ -38,6 +44,25 @@
 
 #define MRCP_SESSION_ID_HEX_STRING_LENGTH 16
 
+/** Max number of requests in progress per channel, the COMPLETE event of which is waited for */
+#define MRCP_CHANNEL_PENDING_REQUEST_COUNT 4
+
+/** Max time the channel waits for the engine opened on its creation (usec), if opening takes
+    longer, the channel is rejected and the engine keeps opening for the next sessions */
+#define MRCP_ENGINE_LAZY_OPEN_TIMEOUT (5 * APR_USEC_PER_SEC)
+
+typedef struct mrcp_pending_request_t mrcp_pending_request_t;
+
+/** Request in progress, sent to engine */
+struct mrcp_pending_request_t {
+	/** Request identifier (0 if the slot is free) */
+	mrcp_request_id request_id;
+	/** Method identifier */
+	mrcp_method_id  method_id;
+	/** Time the request is sent to engine at */
+	apr_time_t      time;
+};
+
 struct mrcp_channel_t {
 	/** Memory pool */
 	apr_pool_t             *pool;
@@ -49,6 +74,8 @@ struct mrcp_channel_t {
 	mrcp_control_channel_t *control_channel;
 	/** MRCP engine channel */
 	mrcp_engine_channel_t  *engine_channel;
+	/** Media termination of engine channel (key of the session table) */
+	mpf_termination_t      *termination;
 	/** MRCP resource state machine  */
 	mrcp_state_machine_t   *state_machine;
 	/** media descriptor id (position in session descriptor) */
@@ -59,6 +86,22 @@ struct mrcp_channel_t {
 	apt_bool_t              waiting_for_channel;
 	/** waiting state of media termination */
 	apt_bool_t              waiting_for_termination;
+	/** Time the engine channel open is requested at */
+	apr_time_t              open_time;
+	/** Time the engine channel open took */
+	apr_interval_time_t     open_elapsed;
+	/** Time the last request is sent to engine at */
+	apr_time_t              request_time;
+	/** Requests in progress (the oldest one is replaced, if all the slots are taken) */
+	mrcp_pending_request_t  pending_requests[MRCP_CHANNEL_PENDING_REQUEST_COUNT];
+	/** Slot of the next request in progress */
+	apr_size_t              pending_request_pos;
+	/** Guards the state machine, while events are delivered at the send site (NULL otherwise) */
+	apr_thread_mutex_t     *mutex;
+	/** Number of messages of the engine signalled to the server task and not processed yet */
+	volatile apr_uint32_t   queued_message_count;
+	/** Whether the state machine is updated by event in the context of the engine */
+	apt_bool_t              event_direct;
 };
 
 typedef struct mrcp_termination_slot_t mrcp_termination_slot_t;
@@ -83,10 +126,11 @@ void mrcp_server_session_add(mrcp_server_session_t *session);
 void mrcp_server_session_remove(mrcp_server_session_t *session);
 
 static apt_bool_t mrcp_server_signaling_message_dispatch(mrcp_server_session_t *session, mrcp_signaling_message_t *signaling_message);
+static apt_bool_t mrcp_server_request_quota_check(mrcp_server_session_t *session, mrcp_channel_t *channel, mrcp_message_t *message);
 
 static apt_bool_t mrcp_server_resource_offer_process(mrcp_server_session_t *session, mrcp_session_descriptor_t *descriptor);
 static apt_bool_t mrcp_server_control_media_offer_process(mrcp_server_session_t *session, mrcp_session_descriptor_t *descriptor);
-static apt_bool_t mrcp_server_av_media_offer_process(mrcp_server_session_t *session, mrcp_session_descriptor_t *descriptor);
+static apt_bool_t mrcp_server_av_media_offer_process(mrcp_server_session_t *session, mrcp_session_descriptor_t *descriptor, apt_bool_t channels_changed, apt_bool_t topology_changed);
 
 static apt_bool_t mrcp_server_engine_channels_update(mrcp_server_session_t *session);
 static apt_bool_t mrcp_server_session_answer_send(mrcp_server_session_t *session);
@@ -94,23 +138,44 @@ static apt_bool_t mrcp_server_session_terminate_process(mrcp_server_session_t *s
 static apt_bool_t mrcp_server_session_terminate_send(mrcp_server_session_t *session);
 
 static mrcp_channel_t* mrcp_server_channel_find(mrcp_server_session_t *session, const apt_str_t *resource_name);
+static void mrcp_server_channel_add(mrcp_server_session_t *session, mrcp_channel_t *channel);
+static mrcp_termination_slot_t* mrcp_server_rtp_termination_add(mrcp_server_session_t *session, mpf_termination_t *termination);
 
 static apt_bool_t state_machine_on_message_dispatch(mrcp_state_machine_t *state_machine, mrcp_message_t *message);
 static apt_bool_t state_machine_on_deactivate(mrcp_state_machine_t *state_machine);
+static apt_bool_t state_machine_on_prefetch(mrcp_state_machine_t *state_machine, mrcp_message_t *message, apt_bool_t start);
 
 
-mrcp_server_session_t* mrcp_server_session_create()
+mrcp_server_session_t* mrcp_server_session_create(mrcp_session_recycler_t *recycler)
 {
-	mrcp_server_session_t *session = (mrcp_server_session_t*) mrcp_session_create(sizeof(mrcp_server_session_t)-sizeof(mrcp_session_t));
+	mrcp_server_session_t *session;
+	if(recycler) {
+		session = (mrcp_server_session_t*) mrcp_session_recycled_create(recycler,sizeof(mrcp_server_session_t)-sizeof(mrcp_session_t));
+	}
+	else {
+		session = (mrcp_server_session_t*) mrcp_session_create(sizeof(mrcp_server_session_t)-sizeof(mrcp_session_t));
+	}
+	if(!session) {
+		return NULL;
+	}
+	apt_pool_owner_set(session->base.pool,APT_POOL_OWNER_SESSION);
 	session->context = NULL;
 	session->terminations = apr_array_make(session->base.pool,2,sizeof(mrcp_termination_slot_t));
 	session->channels = apr_array_make(session->base.pool,2,sizeof(mrcp_channel_t*));
+	session->termination_table = apr_hash_make(session->base.pool);
+	session->channel_table = apr_hash_make(session->base.pool);
+	session->channel_termination_table = apr_hash_make(session->base.pool);
 	session->active_request = NULL;
 	session->request_queue = apt_list_create(session->base.pool);
 	session->offer = NULL;
 	session->answer = NULL;
+	session->active_offer = NULL;
+	session->active_answer = NULL;
 	session->mpf_task_msg = NULL;
 	session->subrequest_count = 0;
+	session->offer_time = 0;
+	session->process_time = 0;
+	session->media_time = 0;
 	session->state = SESSION_STATE_NONE;
 	session->base.name = apr_psprintf(session->base.pool,"0x%pp",session);
 	return session;
@@ -144,6 +209,18 @@ static mrcp_engine_channel_t* mrcp_server_engine_channel_create(
 	if(channel->state_machine) {
 		channel->state_machine->on_dispatch = state_machine_on_message_dispatch;
 		channel->state_machine->on_deactivate = state_machine_on_deactivate;
+		channel->state_machine->on_prefetch = state_machine_on_prefetch;
+		channel->state_machine->inline_params = engine->inline_params;
+	}
+
+	if(engine->is_open == FALSE && engine->open_mutex) {
+		/* opened on creation of the first channel (MRCP_ENGINE_OPEN_LAZY) or still being opened */
+		if(mrcp_engine_background_open(engine) == TRUE &&
+			mrcp_engine_background_open_wait(engine,MRCP_ENGINE_LAZY_OPEN_TIMEOUT) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"MRCP Engine Is Not Open Yet "APT_NAMESID_FMT" [%s]",
+				MRCP_SESSION_NAMESID(session),
+				engine->id);
+		}
 	}
 
 	return mrcp_engine_channel_virtual_create(engine,mrcp_session_version_get(session),session->base.pool);
@@ -161,10 +238,19 @@ static mrcp_channel_t* mrcp_server_channel_create(mrcp_server_session_t *session
 	channel->control_channel = NULL;
 	channel->state_machine = NULL;
 	channel->engine_channel = NULL;
+	channel->termination = NULL;
 	channel->id = id;
 	channel->cmid_arr = cmid_arr;
 	channel->waiting_for_channel = FALSE;
 	channel->waiting_for_termination = FALSE;
+	channel->open_time = 0;
+	channel->open_elapsed = 0;
+	channel->request_time = 0;
+	memset(channel->pending_requests,0,sizeof(channel->pending_requests));
+	channel->pending_request_pos = 0;
+	channel->mutex = NULL;
+	channel->queued_message_count = 0;
+	channel->event_direct = FALSE;
 
 	if(resource_name && resource_name->buf) {
 		mrcp_resource_t *resource;
@@ -177,6 +263,10 @@ static mrcp_channel_t* mrcp_server_channel_create(mrcp_server_session_t *session
 									session->profile->connection_agent,
 									channel,
 									pool);
+				if(mrcp_server_event_fast_path_get(session->server) == TRUE) {
+					/* nested, a response dispatches the next request of the session, which may be of the same channel */
+					apr_thread_mutex_create(&channel->mutex,APR_THREAD_MUTEX_NESTED,pool);
+				}
 			}
 			engine_channel = mrcp_server_engine_channel_create(session,channel,resource_name);
 			if(engine_channel) {
@@ -184,6 +274,7 @@ static mrcp_channel_t* mrcp_server_channel_create(mrcp_server_session_t *session
 				engine_channel->event_obj = channel;
 				engine_channel->event_vtable = &engine_channel_vtable;
 				channel->engine_channel = engine_channel;
+				channel->termination = engine_channel->termination;
 			}
 			else {
 				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Engine Channel "APT_NAMESID_FMT" [%s]",
@@ -258,10 +349,15 @@ mrcp_session_t* mrcp_server_channel_session_get(mrcp_channel_t *channel)
 apt_bool_t mrcp_server_signaling_message_process(mrcp_signaling_message_t *signaling_message)
 {
 	mrcp_server_session_t *session = signaling_message->session;
+	if(signaling_message->type == SIGNALING_MESSAGE_CONTROL && signaling_message->message &&
+		mrcp_server_request_quota_check(session,signaling_message->channel,signaling_message->message) == FALSE) {
+		/* excess requests are rejected rather than queued */
+		return TRUE;
+	}
 	if(session->active_request) {
 		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Push Request to Queue "APT_NAMESID_FMT, 
 			MRCP_SESSION_NAMESID(session));
-		apt_list_push_back(session->request_queue,signaling_message,session->base.pool);
+		apt_list_push_back(session->request_queue,signaling_message,NULL);
 	}
 	else {
 		session->active_request = signaling_message;
@@ -313,6 +409,7 @@ apt_bool_t mrcp_server_on_channel_message(mrcp_channel_t *channel, mrcp_message_
 	signaling_message->descriptor = NULL;
 	signaling_message->channel = channel;
 	signaling_message->message = message;
+	signaling_message->time = apr_time_now();
 	return mrcp_server_signaling_message_process(signaling_message);
 }
 
@@ -332,6 +429,13 @@ apt_bool_t mrcp_server_on_engine_channel_open(mrcp_channel_t *channel, apt_bool_
 	if(status == FALSE) {
 		session->answer->status = MRCP_SESSION_STATUS_UNAVAILABLE_RESOURCE;
 	}
+	if(channel->open_time) {
+		channel->open_elapsed = apr_time_now() - channel->open_time;
+		channel->open_time = 0;
+		if(channel->engine_channel) {
+			mrcp_server_engine_setup_time_record(session->server,channel->engine_channel->engine->id,channel->open_elapsed);
+		}
+	}
 	mrcp_server_session_subrequest_remove(session);
 	return TRUE;
 }
@@ -346,17 +450,343 @@ apt_bool_t mrcp_server_on_engine_channel_close(mrcp_channel_t *channel)
 	return TRUE;
 }
 
+static APR_INLINE void mrcp_server_channel_lock(mrcp_channel_t *channel)
+{
+	if(channel->mutex) {
+		apr_thread_mutex_lock(channel->mutex);
+	}
+}
+
+static APR_INLINE void mrcp_server_channel_unlock(mrcp_channel_t *channel)
+{
+	if(channel->mutex) {
+		apr_thread_mutex_unlock(channel->mutex);
+	}
+}
+
 apt_bool_t mrcp_server_on_engine_channel_message(mrcp_channel_t *channel, mrcp_message_t *message)
 {
-	if(!channel->state_machine) {
+	apt_bool_t status = FALSE;
+	mrcp_server_channel_lock(channel);
+	if(channel->state_machine) {
+		/* update state machine */
+		status = mrcp_state_machine_update(channel->state_machine,message);
+	}
+	if(channel->mutex) {
+		/* the message is sent on, events may take the fast path again, once the queue is empty */
+		apr_atomic_dec32(&channel->queued_message_count);
+	}
+	mrcp_server_channel_unlock(channel);
+	return status;
+}
+
+void mrcp_server_engine_channel_message_queue(mrcp_channel_t *channel, apr_size_t count)
+{
+	if(channel->mutex) {
+		apr_atomic_add32(&channel->queued_message_count,(apr_uint32_t)count);
+	}
+}
+
+apt_bool_t mrcp_server_on_engine_channel_event(mrcp_channel_t *channel, mrcp_message_t *message)
+{
+	if(!channel->mutex || !channel->control_channel ||
+		message->start_line.message_type != MRCP_MESSAGE_TYPE_EVENT) {
 		return FALSE;
 	}
-	/* update state machine */
-	return mrcp_state_machine_update(channel->state_machine,message);
+
+	apr_thread_mutex_lock(channel->mutex);
+	if(!channel->state_machine || apr_atomic_read32(&channel->queued_message_count)) {
+		/* a response or event sent before is still queued to the server task */
+		apr_thread_mutex_unlock(channel->mutex);
+		return FALSE;
+	}
+	channel->event_direct = TRUE;
+	/* an unexpected event is dropped by the state machine the same way the server task does */
+	mrcp_state_machine_update(channel->state_machine,message);
+	channel->event_direct = FALSE;
+	apr_thread_mutex_unlock(channel->mutex);
+	return TRUE;
+}
+
+static apt_bool_t mrcp_server_engine_admission_check(mrcp_server_session_t *session, const apt_str_t *resource_name)
+{
+	mrcp_engine_t *engine;
+	if(!resource_name->length) {
+		return TRUE;
+	}
+	engine = apr_hash_get(session->profile->engine_table,resource_name->buf,resource_name->length);
+	if(!engine || !engine->config) {
+		/* missing engine is reported by the answer itself */
+		return TRUE;
+	}
+	if(mrcp_engine_is_suspended(engine) == TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Reject Session "APT_NAMESID_FMT" Engine [%s] Is Suspended due to Slow Callbacks",
+			MRCP_SESSION_NAMESID(session),
+			engine->id);
+		return FALSE;
+	}
+	if(engine->config->max_channel_count &&
+		apr_atomic_read32(&engine->cur_channel_count) >= engine->config->max_channel_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Reject Session "APT_NAMESID_FMT" All %"APR_SIZE_T_FMT" Channels of Engine [%s] in Use",
+			MRCP_SESSION_NAMESID(session),
+			engine->config->max_channel_count,
+			engine->id);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Check whether the quota of the profile allows to admit a new session */
+static apt_bool_t mrcp_server_session_quota_check(mrcp_server_session_t *session)
+{
+	mrcp_server_profile_t *profile = session->profile;
+	/* the session is already counted in the table of sessions */
+	if(profile->quota.max_session_count &&
+		apr_atomic_read32(&profile->session_count) > profile->quota.max_session_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Reject Session "APT_NAMESID_FMT" All %"APR_SIZE_T_FMT" Sessions of Profile [%s] in Use",
+			MRCP_SESSION_NAMESID(session),
+			profile->quota.max_session_count,
+			profile->id);
+		apr_atomic_inc32(&profile->session_reject_count);
+		return FALSE;
+	}
+	if(profile->session_bucket && apt_token_bucket_take(profile->session_bucket) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Reject Session "APT_NAMESID_FMT" Setup Rate of Profile [%s] Exceeds %"APR_SIZE_T_FMT"/s",
+			MRCP_SESSION_NAMESID(session),
+			profile->id,
+			profile->quota.max_session_rate);
+		apr_atomic_inc32(&profile->session_reject_count);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Check whether the quota of the profile allows to process a control request, respond at once otherwise */
+static apt_bool_t mrcp_server_request_quota_check(mrcp_server_session_t *session, mrcp_channel_t *channel, mrcp_message_t *message)
+{
+	mrcp_server_profile_t *profile = session->profile;
+	mrcp_message_t *response;
+	if(!profile || !profile->request_bucket || message->start_line.message_type != MRCP_MESSAGE_TYPE_REQUEST) {
+		return TRUE;
+	}
+	if(apt_token_bucket_take(profile->request_bucket) == TRUE) {
+		return TRUE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Reject %s Request "APT_SIDRES_FMT" [%"MRCP_REQUEST_ID_FMT"] Request Rate of Profile [%s] Exceeds %"APR_SIZE_T_FMT"/s",
+		message->start_line.method_name.buf,
+		MRCP_MESSAGE_SIDRES(message),
+		message->start_line.request_id,
+		profile->id,
+		profile->quota.max_request_rate);
+	apr_atomic_inc32(&profile->request_reject_count);
+
+	response = mrcp_response_create(message,message->pool);
+	response->start_line.status_code = MRCP_STATUS_CODE_METHOD_FAILED;
+	if(channel && channel->control_channel) {
+		/* MRCPv2 */
+		mrcp_server_control_message_send(channel->control_channel,response);
+	}
+	else {
+		/* MRCPv1 */
+		mrcp_session_control_response(&session->base,response);
+	}
+	return FALSE;
+}
+
+/** Check whether the live load of the server allows to admit a new session */
+static apt_bool_t mrcp_server_session_admission_check(mrcp_server_session_t *session, mrcp_session_descriptor_t *descriptor)
+{
+	const mrcp_server_admission_t *admission = mrcp_server_admission_get(session->server);
+
+	if(mrcp_server_is_draining(session->server) == TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Reject Session "APT_NAMESID_FMT" Server Is Draining",
+			MRCP_SESSION_NAMESID(session));
+		return FALSE;
+	}
+
+	if(mrcp_server_session_quota_check(session) == FALSE) {
+		return FALSE;
+	}
+
+	if(mrcp_session_version_get(session) == MRCP_VERSION_1) {
+		if(mrcp_server_engine_admission_check(session,&descriptor->resource_name) == FALSE) {
+			return FALSE;
+		}
+	}
+	else {
+		mrcp_control_descriptor_t *control_descriptor;
+		int i;
+		for(i=0; i<descriptor->control_media_arr->nelts; i++) {
+			control_descriptor = APR_ARRAY_IDX(descriptor->control_media_arr,i,mrcp_control_descriptor_t*);
+			if(control_descriptor && 
+				mrcp_server_engine_admission_check(session,&control_descriptor->resource_name) == FALSE) {
+				return FALSE;
+			}
+		}
+	}
+
+	if(admission->max_media_load && session->base.media_engine) {
+		/* ticks of the least loaded engine already take most of the interval */
+		apr_uint32_t load = mpf_engine_load_get(session->base.media_engine);
+		if(load >= admission->max_media_load) {
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Reject Session "APT_NAMESID_FMT" Media Engine [%s] Load %u%%",
+				MRCP_SESSION_NAMESID(session),
+				mpf_engine_id_get(session->base.media_engine),
+				load);
+			return FALSE;
+		}
+	}
+
+	if(admission->max_queue_depth) {
+		apr_size_t depth = mrcp_server_queue_depth_get(session->server);
+		if(depth >= admission->max_queue_depth) {
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Reject Session "APT_NAMESID_FMT" %"APR_SIZE_T_FMT" Messages in Queue",
+				MRCP_SESSION_NAMESID(session),
+				depth);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/** Check whether control media of the offer is the same as of the active offer */
+static apt_bool_t mrcp_server_control_media_equal(const mrcp_control_descriptor_t *offer, const mrcp_control_descriptor_t *active_offer)
+{
+	int i;
+	if(offer->port != active_offer->port ||
+		offer->proto != active_offer->proto ||
+		offer->setup_type != active_offer->setup_type ||
+		offer->connection_type != active_offer->connection_type ||
+		apt_string_compare(&offer->ip,&active_offer->ip) == FALSE ||
+		apt_string_compare(&offer->resource_name,&active_offer->resource_name) == FALSE) {
+		return FALSE;
+	}
+	if(!offer->cmid_arr || !active_offer->cmid_arr) {
+		return offer->cmid_arr == active_offer->cmid_arr ? TRUE : FALSE;
+	}
+	if(offer->cmid_arr->nelts != active_offer->cmid_arr->nelts) {
+		return FALSE;
+	}
+	for(i=0; i<offer->cmid_arr->nelts; i++) {
+		if(APR_ARRAY_IDX(offer->cmid_arr,i,apr_size_t) != APR_ARRAY_IDX(active_offer->cmid_arr,i,apr_size_t)) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/** Check whether audio media of the offer is the same as of the active offer */
+static apt_bool_t mrcp_server_audio_media_equal(const mpf_rtp_media_descriptor_t *offer, const mpf_rtp_media_descriptor_t *active_offer)
+{
+	int i;
+	const apr_array_header_t *codecs;
+	const apr_array_header_t *active_codecs;
+	if(offer->state != active_offer->state ||
+		offer->port != active_offer->port ||
+		offer->direction != active_offer->direction ||
+		offer->ptime != active_offer->ptime ||
+		offer->mid != active_offer->mid ||
+		offer->rtcp_mux != active_offer->rtcp_mux ||
+		apt_string_compare(&offer->ip,&active_offer->ip) == FALSE) {
+		return FALSE;
+	}
+	if(offer->crypto || active_offer->crypto) {
+		if(!offer->crypto || !active_offer->crypto ||
+			offer->crypto->tag != active_offer->crypto->tag ||
+			offer->crypto->suite != active_offer->crypto->suite ||
+			offer->crypto->key_size != active_offer->crypto->key_size ||
+			memcmp(offer->crypto->key,active_offer->crypto->key,offer->crypto->key_size) != 0) {
+			return FALSE;
+		}
+	}
+	codecs = offer->codec_list.descriptor_arr;
+	active_codecs = active_offer->codec_list.descriptor_arr;
+	if(!codecs || !active_codecs) {
+		return (!codecs || !codecs->nelts) && (!active_codecs || !active_codecs->nelts) ? TRUE : FALSE;
+	}
+	if(codecs->nelts != active_codecs->nelts) {
+		return FALSE;
+	}
+	for(i=0; i<codecs->nelts; i++) {
+		const mpf_codec_descriptor_t *codec = &APR_ARRAY_IDX(codecs,i,mpf_codec_descriptor_t);
+		const mpf_codec_descriptor_t *active_codec = &APR_ARRAY_IDX(active_codecs,i,mpf_codec_descriptor_t);
+		if(codec->payload_type != active_codec->payload_type ||
+			mpf_codec_descriptors_match(codec,active_codec) == FALSE) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/** Get the answer to unchanged control media of the active offer, if any */
+static mrcp_control_descriptor_t* mrcp_server_active_control_answer_get(mrcp_server_session_t *session, apr_size_t id, const mrcp_control_descriptor_t *offer)
+{
+	mrcp_control_descriptor_t *active_offer;
+	if(!session->active_offer || !session->active_answer) {
+		return NULL;
+	}
+	active_offer = mrcp_session_control_media_get(session->active_offer,id);
+	if(!active_offer || mrcp_server_control_media_equal(offer,active_offer) == FALSE) {
+		return NULL;
+	}
+	return mrcp_session_control_media_get(session->active_answer,id);
+}
+
+/** Get the answer to unchanged audio media of the active offer, if any */
+static mpf_rtp_media_descriptor_t* mrcp_server_active_audio_answer_get(mrcp_server_session_t *session, apr_size_t id, const mpf_rtp_media_descriptor_t *offer)
+{
+	mpf_rtp_media_descriptor_t *active_offer;
+	if(!session->active_offer || !session->active_answer) {
+		return NULL;
+	}
+	active_offer = mrcp_session_audio_media_get(session->active_offer,id);
+	if(!active_offer || mrcp_server_audio_media_equal(offer,active_offer) == FALSE) {
+		return NULL;
+	}
+	return mrcp_session_audio_media_get(session->active_answer,id);
+}
+
+/** Check whether control channels are added, removed or modified by the offer */
+static apt_bool_t mrcp_server_control_media_changed(mrcp_server_session_t *session, const mrcp_session_descriptor_t *descriptor)
+{
+	int i;
+	mrcp_control_descriptor_t *control_descriptor;
+	if(descriptor->control_media_arr->nelts != session->active_offer->control_media_arr->nelts) {
+		return TRUE;
+	}
+	for(i=0; i<descriptor->control_media_arr->nelts; i++) {
+		control_descriptor = mrcp_session_control_media_get(descriptor,i);
+		if(control_descriptor && !mrcp_server_active_control_answer_get(session,i,control_descriptor)) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/** Check whether RTP terminations are added or modified by the offer */
+static apt_bool_t mrcp_server_audio_media_changed(mrcp_server_session_t *session, const mrcp_session_descriptor_t *descriptor)
+{
+	int i;
+	mpf_rtp_media_descriptor_t *media_descriptor;
+	if(descriptor->audio_media_arr->nelts != session->active_offer->audio_media_arr->nelts) {
+		return TRUE;
+	}
+	for(i=0; i<descriptor->audio_media_arr->nelts; i++) {
+		media_descriptor = mrcp_session_audio_media_get(descriptor,i);
+		if(media_descriptor && !mrcp_server_active_audio_answer_get(session,i,media_descriptor)) {
+			return TRUE;
+		}
+	}
+	return FALSE;
 }
 
 static apt_bool_t mrcp_server_session_offer_process(mrcp_server_session_t *session, mrcp_session_descriptor_t *descriptor)
 {
+	apt_bool_t channels_changed;
+	apt_bool_t topology_changed;
+	session->process_time = apr_time_now();
+	session->media_time = 0;
 	if(!session->context) {
 		/* initial offer received, generate session id and add to session's table */
 		if(!session->base.id.length) {
@@ -364,10 +794,26 @@ static apt_bool_t mrcp_server_session_offer_process(mrcp_server_session_t *sessi
 		}
 		mrcp_server_session_add(session);
 
+		/* select media engine from the pool of the profile */
+		session->base.media_engine = mpf_engine_factory_engine_select(session->profile->mpf_factory);
+
+		if(mrcp_server_session_admission_check(session,descriptor) == FALSE) {
+			/* shed the load before any resource is allocated for the session */
+			session->offer = descriptor;
+			session->answer = mrcp_session_answer_create(descriptor,session->base.pool);
+			session->answer->status = MRCP_SESSION_STATUS_OVERLOADED;
+			session->answer->retry_after = mrcp_server_admission_get(session->server)->retry_after;
+			return mrcp_server_session_answer_send(session);
+		}
+
 		session->context = mpf_engine_context_create(
-			session->profile->media_engine,
+			session->base.media_engine,
 			session->base.name,
 			session,5,session->base.pool);
+		if(session->context) {
+			/* media processing time is accounted per profile */
+			mpf_context_group_set(session->context,session->profile->id);
+		}
 	}
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Receive Offer "APT_NAMESID_FMT" [c:%d a:%d v:%d]",
 		MRCP_SESSION_NAMESID(session),
@@ -381,17 +827,27 @@ static apt_bool_t mrcp_server_session_offer_process(mrcp_server_session_t *sessi
 
 	mrcp_server_session_state_set(session,SESSION_STATE_GENERATING_ANSWER);
 
-	/* first, reset/destroy existing associations and topology */
-	if(mpf_engine_topology_message_add(
-				session->profile->media_engine,
-				MPF_RESET_ASSOCIATIONS,session->context,
-				&session->mpf_task_msg) == TRUE){
-		mrcp_server_session_subrequest_add(session);
+	channels_changed = TRUE;
+	topology_changed = TRUE;
+	if(mrcp_session_version_get(session) == MRCP_VERSION_2 && session->active_offer) {
+		/* session update, only the changed channels and terminations are processed */
+		channels_changed = mrcp_server_control_media_changed(session,descriptor);
+		topology_changed = channels_changed == TRUE ? TRUE : mrcp_server_audio_media_changed(session,descriptor);
+	}
+
+	if(topology_changed == TRUE) {
+		/* first, reset/destroy existing associations and topology */
+		if(mpf_engine_topology_message_add(
+					session->base.media_engine,
+					MPF_RESET_ASSOCIATIONS,session->context,
+					&session->mpf_task_msg) == TRUE){
+			mrcp_server_session_subrequest_add(session);
+		}
 	}
 
 	if(mrcp_session_version_get(session) == MRCP_VERSION_1) {
 		if(mrcp_server_resource_offer_process(session,descriptor) == TRUE) {
-			mrcp_server_av_media_offer_process(session,descriptor);
+			mrcp_server_av_media_offer_process(session,descriptor,TRUE,TRUE);
 		}
 		else {
 			session->answer->resource_state = FALSE;
@@ -399,17 +855,19 @@ static apt_bool_t mrcp_server_session_offer_process(mrcp_server_session_t *sessi
 	}
 	else {
 		mrcp_server_control_media_offer_process(session,descriptor);
-		mrcp_server_av_media_offer_process(session,descriptor);
+		mrcp_server_av_media_offer_process(session,descriptor,channels_changed,topology_changed);
 	}
 
-	/* apply topology based on assigned associations */
-	if(mpf_engine_topology_message_add(
-				session->profile->media_engine,
-				MPF_APPLY_TOPOLOGY,session->context,
-				&session->mpf_task_msg) == TRUE) {
-		mrcp_server_session_subrequest_add(session);
+	if(topology_changed == TRUE) {
+		/* apply topology based on assigned associations */
+		if(mpf_engine_topology_message_add(
+					session->base.media_engine,
+					MPF_APPLY_TOPOLOGY,session->context,
+					&session->mpf_task_msg) == TRUE) {
+			mrcp_server_session_subrequest_add(session);
+		}
 	}
-	mpf_engine_message_send(session->profile->media_engine,&session->mpf_task_msg);
+	mpf_engine_message_send(session->base.media_engine,&session->mpf_task_msg);
 
 	if(!session->subrequest_count) {
 		/* send answer to client */
@@ -430,7 +888,7 @@ static apt_bool_t mrcp_server_session_terminate_process(mrcp_server_session_t *s
 	if(session->context) {
 		/* first, destroy existing topology */
 		if(mpf_engine_topology_message_add(
-					session->profile->media_engine,
+					session->base.media_engine,
 					MPF_RESET_ASSOCIATIONS,session->context,
 					&session->mpf_task_msg) == TRUE){
 			mrcp_server_session_subrequest_add(session);
@@ -461,7 +919,7 @@ static apt_bool_t mrcp_server_session_terminate_process(mrcp_server_session_t *s
 					MRCP_SESSION_NAMESID(session),
 					mpf_termination_name_get(termination));
 				if(mpf_engine_termination_message_add(
-							session->profile->media_engine,
+							session->base.media_engine,
 							MPF_SUBTRACT_TERMINATION,session->context,termination,NULL,
 							&session->mpf_task_msg) == TRUE) {
 					channel->waiting_for_termination = TRUE;
@@ -485,7 +943,7 @@ static apt_bool_t mrcp_server_session_terminate_process(mrcp_server_session_t *s
 			MRCP_SESSION_NAMESID(session),
 			mpf_termination_name_get(slot->termination));
 		if(mpf_engine_termination_message_add(
-				session->profile->media_engine,
+				session->base.media_engine,
 				MPF_SUBTRACT_TERMINATION,session->context,slot->termination,NULL,
 				&session->mpf_task_msg) == TRUE) {
 			slot->waiting = TRUE;
@@ -494,7 +952,7 @@ static apt_bool_t mrcp_server_session_terminate_process(mrcp_server_session_t *s
 	}
 
 	if(session->context) {
-		mpf_engine_message_send(session->profile->media_engine,&session->mpf_task_msg);
+		mpf_engine_message_send(session->base.media_engine,&session->mpf_task_msg);
 	}
 
 	mrcp_server_session_remove(session);
@@ -516,9 +974,11 @@ static apt_bool_t mrcp_server_session_deactivate(mrcp_server_session_t *session)
 		channel = APR_ARRAY_IDX(session->channels,i,mrcp_channel_t*);
 		if(!channel || !channel->state_machine) continue;
 
+		mrcp_server_channel_lock(channel);
 		if(mrcp_state_machine_deactivate(channel->state_machine) == TRUE) {
 			mrcp_server_session_subrequest_add(session);
 		}
+		mrcp_server_channel_unlock(channel);
 	}
 	
 	if(!session->subrequest_count) {
@@ -530,6 +990,7 @@ static apt_bool_t mrcp_server_session_deactivate(mrcp_server_session_t *session)
 
 static apt_bool_t mrcp_server_on_message_receive(mrcp_server_session_t *session, mrcp_channel_t *channel, mrcp_message_t *message)
 {
+	apt_bool_t status;
 	if(!channel) {
 		channel = mrcp_server_channel_find(session,&message->channel_id.resource_name);
 		if(!channel) {
@@ -547,7 +1008,10 @@ static apt_bool_t mrcp_server_on_message_receive(mrcp_server_session_t *session,
 	}
 
 	/* update state machine */
-	return mrcp_state_machine_update(channel->state_machine,message);
+	mrcp_server_channel_lock(channel);
+	status = mrcp_state_machine_update(channel->state_machine,message);
+	mrcp_server_channel_unlock(channel);
+	return status;
 }
 
 static apt_bool_t mrcp_server_signaling_message_dispatch(mrcp_server_session_t *session, mrcp_signaling_message_t *signaling_message)
@@ -555,6 +1019,7 @@ static apt_bool_t mrcp_server_signaling_message_dispatch(mrcp_server_session_t *
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Dispatch Signaling Message [%d]",signaling_message->type);
 	switch(signaling_message->type) {
 		case SIGNALING_MESSAGE_OFFER:
+			signaling_message->session->offer_time = signaling_message->time;
 			mrcp_server_session_offer_process(signaling_message->session,signaling_message->descriptor);
 			break;
 		case SIGNALING_MESSAGE_CONTROL:
@@ -578,12 +1043,15 @@ static apt_bool_t mrcp_server_engine_channels_update(mrcp_server_session_t *sess
 	}
 	
 	mrcp_server_session_state_set(session,SESSION_STATE_INITIALIZING);
+	session->media_time = apr_time_now();
 
 	if(mrcp_session_version_get(session) == MRCP_VERSION_1) {
 		if(session->offer) {
 			channel = mrcp_server_channel_find(session,&descriptor->resource_name);
 			if(channel && channel->engine_channel) {
 				/* open engine channel */
+				channel->open_time = apr_time_now();
+				channel->open_elapsed = 0;
 				if(mrcp_engine_channel_virtual_open(channel->engine_channel) == TRUE) {
 					mrcp_server_session_subrequest_add(session);
 				}
@@ -602,6 +1070,8 @@ static apt_bool_t mrcp_server_engine_channels_update(mrcp_server_session_t *sess
 
 			if(control_descriptor->port) {
 				/* open engine channel */
+				channel->open_time = apr_time_now();
+				channel->open_elapsed = 0;
 				if(mrcp_engine_channel_virtual_open(channel->engine_channel) == TRUE) {
 					mrcp_server_session_subrequest_add(session);
 				}
@@ -642,12 +1112,12 @@ static apt_bool_t mrcp_server_resource_offer_process(mrcp_server_session_t *sess
 			MRCP_SESSION_NAMESID(session),
 			channel->resource->name.buf,
 			count);
-		APR_ARRAY_PUSH(session->channels,mrcp_channel_t*) = channel;
+		mrcp_server_channel_add(session,channel);
 		if(channel->engine_channel && channel->engine_channel->termination) {
 			mpf_termination_t *termination = channel->engine_channel->termination;
 			/* send add termination request (add to media context) */
 			if(mpf_engine_termination_message_add(
-					session->profile->media_engine,
+					session->base.media_engine,
 					MPF_ADD_TERMINATION,session->context,termination,NULL,
 					&session->mpf_task_msg) == TRUE) {
 				channel->waiting_for_termination = TRUE;
@@ -665,6 +1135,7 @@ static apt_bool_t mrcp_server_control_media_offer_process(mrcp_server_session_t
 {
 	mrcp_channel_t *channel;
 	mrcp_control_descriptor_t *control_descriptor;
+	mrcp_control_descriptor_t *answer;
 	int i;
 	int count = session->channels->nelts;
 	if(count > descriptor->control_media_arr->nelts) {
@@ -683,6 +1154,17 @@ static apt_bool_t mrcp_server_control_media_offer_process(mrcp_server_session_t
 		control_descriptor = mrcp_session_control_media_get(descriptor,i);
 		if(!control_descriptor) continue;
 
+		answer = mrcp_server_active_control_answer_get(session,i,control_descriptor);
+		if(answer) {
+			/* the channel is not changed by the offer, keep it as is */
+			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Keep Control Channel "APT_NAMESIDRES_FMT" [%d]",
+				MRCP_SESSION_NAMESID(session),
+				channel->resource->name.buf,
+				i);
+			mrcp_session_control_media_set(session->answer,channel->id,answer);
+			continue;
+		}
+
 		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Modify Control Channel "APT_NAMESIDRES_FMT" [%d]",
 			MRCP_SESSION_NAMESID(session),
 			channel->resource->name.buf,
@@ -718,7 +1200,7 @@ static apt_bool_t mrcp_server_control_media_offer_process(mrcp_server_session_t
 			MRCP_SESSION_NAMESID(session),
 			channel->resource->name.buf,
 			i);
-		APR_ARRAY_PUSH(session->channels,mrcp_channel_t*) = channel;
+		mrcp_server_channel_add(session,channel);
 
 		if(channel->control_channel) {
 			/* send modify connection request */
@@ -739,7 +1221,7 @@ static apt_bool_t mrcp_server_control_media_offer_process(mrcp_server_session_t
 			mpf_termination_t *termination = channel->engine_channel->termination;
 			/* send add termination request (add to media context) */
 			if(mpf_engine_termination_message_add(
-					session->profile->media_engine,
+					session->base.media_engine,
 					MPF_ADD_TERMINATION,session->context,termination,NULL,
 					&session->mpf_task_msg) == TRUE) {
 				channel->waiting_for_termination = TRUE;
@@ -834,7 +1316,7 @@ static apt_bool_t mrcp_server_associations_set(mrcp_server_session_t *session, m
 		if(!channel || !channel->engine_channel) continue;
 
 		if(mpf_engine_assoc_message_add(
-				session->profile->media_engine,
+				session->base.media_engine,
 				MPF_ADD_ASSOCIATION,session->context,slot->termination,channel->engine_channel->termination,
 				&session->mpf_task_msg) == TRUE) {
 			mrcp_server_session_subrequest_add(session);
@@ -843,8 +1325,9 @@ static apt_bool_t mrcp_server_associations_set(mrcp_server_session_t *session, m
 	return TRUE;
 }
 
-static apt_bool_t mrcp_server_av_media_offer_process(mrcp_server_session_t *session, mrcp_session_descriptor_t *descriptor)
+static apt_bool_t mrcp_server_av_media_offer_process(mrcp_server_session_t *session, mrcp_session_descriptor_t *descriptor, apt_bool_t channels_changed, apt_bool_t topology_changed)
 {
+	mpf_rtp_media_descriptor_t *answer;
 	mpf_rtp_termination_descriptor_t *rtp_descriptor;
 	mrcp_termination_slot_t *slot;
 	int i;
@@ -869,21 +1352,40 @@ static apt_bool_t mrcp_server_av_media_offer_process(mrcp_server_session_t *sess
 		rtp_descriptor = mrcp_server_associations_build(session,descriptor,slot);
 		if(!rtp_descriptor) continue;
 
-		/* send modify termination request */
-		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Modify Media Termination "APT_NAMESIDRES_FMT" [%d]",
-				MRCP_SESSION_NAMESID(session),
-				mpf_termination_name_get(slot->termination),
-				i);
-		if(mpf_engine_termination_message_add(
-				session->profile->media_engine,
-				MPF_MODIFY_TERMINATION,session->context,slot->termination,rtp_descriptor,
-				&session->mpf_task_msg) == TRUE) {
-			slot->waiting = TRUE;
-			mrcp_server_session_subrequest_add(session);
+		answer = NULL;
+		if(channels_changed == FALSE) {
+			/* the capabilities of associated channels are the same as well */
+			answer = mrcp_server_active_audio_answer_get(session,i,rtp_descriptor->audio.remote);
+		}
+		if(answer) {
+			/* the termination is not changed by the offer, keep it as is */
+			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Keep Media Termination "APT_NAMESIDRES_FMT" [%d]",
+					MRCP_SESSION_NAMESID(session),
+					mpf_termination_name_get(slot->termination),
+					i);
+			session->answer->ip = session->active_answer->ip;
+			session->answer->ext_ip = session->active_answer->ext_ip;
+			mrcp_session_audio_media_set(session->answer,slot->id,answer);
+		}
+		else {
+			/* send modify termination request */
+			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Modify Media Termination "APT_NAMESIDRES_FMT" [%d]",
+					MRCP_SESSION_NAMESID(session),
+					mpf_termination_name_get(slot->termination),
+					i);
+			if(mpf_engine_termination_message_add(
+					session->base.media_engine,
+					MPF_MODIFY_TERMINATION,session->context,slot->termination,rtp_descriptor,
+					&session->mpf_task_msg) == TRUE) {
+				slot->waiting = TRUE;
+				mrcp_server_session_subrequest_add(session);
+			}
 		}
 
-		/* set built associations */
-		mrcp_server_associations_set(session,descriptor,slot);
+		if(topology_changed == TRUE) {
+			/* set built associations, the existing ones have been reset */
+			mrcp_server_associations_set(session,descriptor,slot);
+		}
 	}
 	
 	/* add new terminations */
@@ -896,11 +1398,10 @@ static apt_bool_t mrcp_server_av_media_offer_process(mrcp_server_session_t *sess
 				MRCP_SESSION_NAMESID(session),
 				mpf_termination_name_get(termination),
 				i);
-		slot = apr_array_push(session->terminations);
+		slot = mrcp_server_rtp_termination_add(session,termination);
 		slot->id = i;
 		slot->mid = 0;
 		slot->waiting = FALSE;
-		slot->termination = termination;
 		slot->channels = NULL;
 
 		/* build associations between specified RTP termination and control channels */
@@ -909,7 +1410,7 @@ static apt_bool_t mrcp_server_av_media_offer_process(mrcp_server_session_t *sess
 
 		/* send add termination request (add to media context) */
 		if(mpf_engine_termination_message_add(
-				session->profile->media_engine,
+				session->base.media_engine,
 				MPF_ADD_TERMINATION,session->context,termination,rtp_descriptor,
 				&session->mpf_task_msg) == TRUE) {
 			slot->waiting = TRUE;
@@ -922,6 +1423,52 @@ static apt_bool_t mrcp_server_av_media_offer_process(mrcp_server_session_t *sess
 	return TRUE;
 }
 
+/** Record the phases of session setup, log them if the setup is slow */
+static void mrcp_server_session_setup_trace(mrcp_server_session_t *session)
+{
+	apr_interval_time_t elapsed[MRCP_SETUP_PHASE_COUNT];
+	apr_size_t threshold;
+	apr_time_t now;
+	int i;
+	if(!session->offer_time || !session->media_time) {
+		/* rejected before media is added */
+		return;
+	}
+
+	now = apr_time_now();
+	elapsed[MRCP_SETUP_PHASE_SIGNALING] = session->process_time - session->offer_time;
+	elapsed[MRCP_SETUP_PHASE_MEDIA] = session->media_time - session->process_time;
+	elapsed[MRCP_SETUP_PHASE_ENGINE] = now - session->media_time;
+	elapsed[MRCP_SETUP_PHASE_TOTAL] = now - session->offer_time;
+	for(i=0; i<MRCP_SETUP_PHASE_COUNT; i++) {
+		mrcp_server_setup_time_record(session->server,(mrcp_setup_phase_e)i,elapsed[i]);
+	}
+
+	threshold = mrcp_server_slow_setup_threshold_get(session->server);
+	if(threshold && elapsed[MRCP_SETUP_PHASE_TOTAL] >= (apr_interval_time_t)threshold * 1000) {
+		/* breakdown of the engine phase by channels */
+		const char *engines = "";
+		mrcp_channel_t *channel;
+		for(i=0; i<session->channels->nelts; i++) {
+			channel = APR_ARRAY_IDX(session->channels,i,mrcp_channel_t*);
+			if(!channel || !channel->engine_channel || !channel->open_elapsed) continue;
+
+			engines = apr_psprintf(session->base.pool,"%s %s:%"APR_TIME_T_FMT" ms",
+				engines,
+				channel->engine_channel->engine->id,
+				apr_time_as_msec(channel->open_elapsed));
+		}
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Slow Session Setup "APT_NAMESID_FMT" [%"APR_TIME_T_FMT" ms] "
+			"signaling:%"APR_TIME_T_FMT" media:%"APR_TIME_T_FMT" engine:%"APR_TIME_T_FMT" ms%s",
+			MRCP_SESSION_NAMESID(session),
+			apr_time_as_msec(elapsed[MRCP_SETUP_PHASE_TOTAL]),
+			apr_time_as_msec(elapsed[MRCP_SETUP_PHASE_SIGNALING]),
+			apr_time_as_msec(elapsed[MRCP_SETUP_PHASE_MEDIA]),
+			apr_time_as_msec(elapsed[MRCP_SETUP_PHASE_ENGINE]),
+			engines);
+	}
+}
+
 static apt_bool_t mrcp_server_session_answer_send(mrcp_server_session_t *session)
 {
 	apt_bool_t status;
@@ -933,6 +1480,16 @@ static apt_bool_t mrcp_server_session_answer_send(mrcp_server_session_t *session
 		descriptor->video_media_arr->nelts,
 		mrcp_session_status_phrase_get(descriptor->status));
 	status = mrcp_session_answer(&session->base,descriptor);
+	mrcp_server_session_setup_trace(session);
+	session->offer_time = 0;
+	session->media_time = 0;
+	/* subsequent offers are diffed against the last successful one */
+	session->active_offer = NULL;
+	session->active_answer = NULL;
+	if(descriptor->status == MRCP_SESSION_STATUS_OK) {
+		session->active_offer = session->offer;
+		session->active_answer = descriptor;
+	}
 	session->offer = NULL;
 	session->answer = NULL;
 
@@ -968,45 +1525,97 @@ static apt_bool_t mrcp_server_session_terminate_send(mrcp_server_session_t *sess
 
 static mrcp_termination_slot_t* mrcp_server_rtp_termination_find(mrcp_server_session_t *session, mpf_termination_t *termination)
 {
-	int i;
-	mrcp_termination_slot_t *slot;
-	for(i=0; i<session->terminations->nelts; i++) {
-		slot = &APR_ARRAY_IDX(session->terminations,i,mrcp_termination_slot_t);
-		if(slot->termination == termination) {
-			return slot;
-		}
-	}
-	return NULL;
+	return apr_hash_get(session->termination_table,&termination,sizeof(termination));
 }
 
 static mrcp_channel_t* mrcp_server_channel_termination_find(mrcp_server_session_t *session, mpf_termination_t *termination)
 {
-	int i;
+	mrcp_channel_t *channel = apr_hash_get(session->channel_termination_table,&termination,sizeof(termination));
+	if(channel && !channel->engine_channel) {
+		/* engine channel is already destroyed */
+		return NULL;
+	}
+	return channel;
+}
+
+static mrcp_channel_t* mrcp_server_channel_find(mrcp_server_session_t *session, const apt_str_t *resource_name)
+{
+	if(!resource_name->buf || !resource_name->length) {
+		return NULL;
+	}
+	return apr_hash_get(session->channel_table,resource_name->buf,resource_name->length);
+}
+
+/** Link recognizer and synthesizer channels of the session, if the recognizer engine kills the audio itself */
+static void mrcp_server_barge_in_link(mrcp_server_session_t *session)
+{
+	mrcp_channel_t *recog_channel = NULL;
+	mrcp_channel_t *synth_channel = NULL;
 	mrcp_channel_t *channel;
+	const mrcp_engine_config_t *config;
+	const char *value = NULL;
+	int i;
 	for(i=0; i<session->channels->nelts; i++) {
 		channel = APR_ARRAY_IDX(session->channels,i,mrcp_channel_t*);
-		if(!channel) continue;
+		if(!channel || !channel->engine_channel || !channel->resource) continue;
 
-		if(channel->engine_channel && channel->engine_channel->termination == termination) {
-			return channel;
+		if(channel->resource->id == MRCP_RECOGNIZER_RESOURCE && !recog_channel) {
+			recog_channel = channel;
+		}
+		else if(channel->resource->id == MRCP_SYNTHESIZER_RESOURCE && !synth_channel) {
+			synth_channel = channel;
 		}
 	}
-	return NULL;
+	if(!recog_channel || !synth_channel || recog_channel->engine_channel->barge_in_channel) {
+		return;
+	}
+
+	config = recog_channel->engine_channel->engine->config;
+	if(config && config->params) {
+		value = apr_table_get(config->params,"fast-barge-in");
+	}
+	if(value && strcasecmp(value,"true") == 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Link Channels on Barge-In "APT_NAMESID_FMT,MRCP_SESSION_NAMESID(session));
+		mrcp_engine_channel_barge_in_link(recog_channel->engine_channel,synth_channel->engine_channel);
+	}
 }
 
-static mrcp_channel_t* mrcp_server_channel_find(mrcp_server_session_t *session, const apt_str_t *resource_name)
+/** Add channel to the session and index it */
+static void mrcp_server_channel_add(mrcp_server_session_t *session, mrcp_channel_t *channel)
 {
-	int i;
-	mrcp_channel_t *channel;
-	for(i=0; i<session->channels->nelts; i++) {
-		channel = APR_ARRAY_IDX(session->channels,i,mrcp_channel_t*);
-		if(!channel) continue;
+	APR_ARRAY_PUSH(session->channels,mrcp_channel_t*) = channel;
+	/* the first channel of a resource is found by name, as it was by scanning the array */
+	if(!apr_hash_get(session->channel_table,channel->resource->name.buf,channel->resource->name.length)) {
+		apr_hash_set(session->channel_table,channel->resource->name.buf,channel->resource->name.length,channel);
+	}
+	if(channel->termination) {
+		apr_hash_set(session->channel_termination_table,&channel->termination,sizeof(channel->termination),channel);
+	}
+	mrcp_server_barge_in_link(session);
+}
 
-		if(apt_string_compare(&channel->resource->name,resource_name) == TRUE) {
-			return channel;
+/** Add RTP termination slot to the session and index it */
+static mrcp_termination_slot_t* mrcp_server_rtp_termination_add(mrcp_server_session_t *session, mpf_termination_t *termination)
+{
+	int i;
+	mrcp_termination_slot_t *slot;
+	mrcp_termination_slot_t *slots = (mrcp_termination_slot_t*)session->terminations->elts;
+	slot = apr_array_push(session->terminations);
+	slot->termination = termination;
+	if(slots != (mrcp_termination_slot_t*)session->terminations->elts) {
+		/* the slots are moved (the keys with them), index them again */
+		apr_hash_clear(session->termination_table);
+		for(i=0; i<session->terminations->nelts - 1; i++) {
+			mrcp_termination_slot_t *moved_slot = &APR_ARRAY_IDX(session->terminations,i,mrcp_termination_slot_t);
+			if(moved_slot->termination) {
+				apr_hash_set(session->termination_table,&moved_slot->termination,sizeof(moved_slot->termination),moved_slot);
+			}
 		}
 	}
-	return NULL;
+	if(termination) {
+		apr_hash_set(session->termination_table,&slot->termination,sizeof(slot->termination),slot);
+	}
+	return slot;
 }
 
 static apt_bool_t mrcp_server_on_termination_modify(mrcp_server_session_t *session, const mpf_message_t *mpf_message)
@@ -1114,18 +1723,130 @@ apt_bool_t mrcp_server_mpf_message_process(mpf_message_container_t *mpf_message_
 	return TRUE;
 }
 
+/** Record the time the engine processed a request within, up to the response or up to the COMPLETE event */
+static void mrcp_server_engine_request_trace(mrcp_channel_t *channel, const mrcp_message_t *message)
+{
+	mrcp_server_session_t *session = (mrcp_server_session_t*)channel->session;
+	mrcp_pending_request_t *pending;
+	apr_time_t now;
+	apr_size_t i;
+	if(!channel->engine_channel || !channel->engine_channel->engine) {
+		return;
+	}
+
+	now = apr_time_now();
+	if(message->start_line.message_type == MRCP_MESSAGE_TYPE_RESPONSE) {
+		if(!channel->request_time) {
+			/* the response is generated by the server itself */
+			return;
+		}
+		mrcp_server_engine_request_time_record(session->server,
+			channel->engine_channel->engine->id,
+			message->start_line.method_id,
+			MRCP_REQUEST_STAGE_RESPONSE,
+			now - channel->request_time);
+		if(message->start_line.request_state == MRCP_REQUEST_STATE_INPROGRESS ||
+			message->start_line.request_state == MRCP_REQUEST_STATE_PENDING) {
+			pending = &channel->pending_requests[channel->pending_request_pos];
+			pending->request_id = message->start_line.request_id;
+			pending->method_id = message->start_line.method_id;
+			pending->time = channel->request_time;
+			channel->pending_request_pos = (channel->pending_request_pos + 1) % MRCP_CHANNEL_PENDING_REQUEST_COUNT;
+		}
+		channel->request_time = 0;
+		return;
+	}
+
+	if(message->start_line.request_state != MRCP_REQUEST_STATE_COMPLETE) {
+		return;
+	}
+	for(i=0; i<MRCP_CHANNEL_PENDING_REQUEST_COUNT; i++) {
+		pending = &channel->pending_requests[i];
+		if(pending->request_id && pending->request_id == message->start_line.request_id) {
+			mrcp_server_engine_request_time_record(session->server,
+				channel->engine_channel->engine->id,
+				pending->method_id,
+				MRCP_REQUEST_STAGE_COMPLETE,
+				now - pending->time);
+			pending->request_id = 0;
+			break;
+		}
+	}
+}
+
+/** Arm the synthesizer channel to be muted on barge-in, while a SPEAK with kill-on-barge-in is in progress */
+static void mrcp_server_barge_in_update(mrcp_channel_t *channel, mrcp_message_t *message)
+{
+	mrcp_message_type_e message_type = message->start_line.message_type;
+	mrcp_method_id method_id = message->start_line.method_id;
+	if(channel->resource->id != MRCP_SYNTHESIZER_RESOURCE) {
+		return;
+	}
+
+	if(message_type == MRCP_MESSAGE_TYPE_REQUEST) {
+		if(method_id == SYNTHESIZER_SPEAK) {
+			apt_bool_t kill_on_barge_in = TRUE;
+			mrcp_synth_header_t *synth_header = mrcp_resource_header_get(message);
+			if(synth_header && mrcp_resource_header_property_check(message,SYNTHESIZER_HEADER_KILL_ON_BARGE_IN) == TRUE) {
+				kill_on_barge_in = synth_header->kill_on_barge_in;
+			}
+			mrcp_engine_channel_barge_in_arm(channel->engine_channel,kill_on_barge_in);
+		}
+	}
+	else if(message_type == MRCP_MESSAGE_TYPE_RESPONSE) {
+		if((method_id == SYNTHESIZER_SPEAK && message->start_line.request_state == MRCP_REQUEST_STATE_COMPLETE) ||
+			method_id == SYNTHESIZER_STOP || method_id == SYNTHESIZER_BARGE_IN_OCCURRED) {
+			mrcp_engine_channel_barge_in_arm(channel->engine_channel,FALSE);
+		}
+	}
+	else if(method_id == SYNTHESIZER_SPEAK_COMPLETE) {
+		mrcp_engine_channel_barge_in_arm(channel->engine_channel,FALSE);
+	}
+}
+
+/** Send request message to engine for actual processing */
+static void mrcp_server_engine_request_dispatch(mrcp_channel_t *channel, mrcp_message_t *message)
+{
+	channel->request_time = apr_time_now();
+	/* the models are loaded, while the engine processes START-SESSION and awaits VERIFY */
+	mrcp_engine_voiceprint_request_prefetch(channel->engine_channel->engine,message);
+	mrcp_engine_uri_request_prefetch(channel->engine_channel->engine,message);
+	mrcp_engine_channel_request_process(channel->engine_channel,message);
+}
+
+apt_bool_t mrcp_server_on_engine_channel_request(mrcp_channel_t *channel, mrcp_message_t *message)
+{
+	mrcp_server_channel_lock(channel);
+	if(channel->engine_channel) {
+		mrcp_server_barge_in_update(channel,message);
+		mrcp_server_engine_request_dispatch(channel,message);
+	}
+	mrcp_server_channel_unlock(channel);
+	return TRUE;
+}
+
 static apt_bool_t state_machine_on_message_dispatch(mrcp_state_machine_t *state_machine, mrcp_message_t *message)
 {
 	mrcp_channel_t *channel = state_machine->obj;
 
+	if(channel->event_direct == TRUE && message->start_line.message_type == MRCP_MESSAGE_TYPE_REQUEST) {
+		/* pending request is dispatched on completion event, the engine is not reentered from its own send */
+		return mrcp_server_engine_channel_request_signal(channel,message);
+	}
+
+	if(channel->engine_channel) {
+		mrcp_server_barge_in_update(channel,message);
+	}
+
 	if(message->start_line.message_type == MRCP_MESSAGE_TYPE_REQUEST) {
 		/* send request message to engine for actual processing */
 		if(channel->engine_channel) {
-			mrcp_engine_channel_request_process(channel->engine_channel,message);
+			mrcp_server_engine_request_dispatch(channel,message);
 		}
 	}
 	else if(message->start_line.message_type == MRCP_MESSAGE_TYPE_RESPONSE) {
 		mrcp_server_session_t *session = (mrcp_server_session_t*)channel->session;
+		mrcp_server_engine_request_trace(channel,message);
 		/* send response message to client */
 		if(channel->control_channel) {
 			/* MRCPv2 */
@@ -1136,12 +1857,20 @@ static apt_bool_t state_machine_on_message_dispatch(mrcp_state_machine_t *state_
 			mrcp_session_control_response(channel->session,message);
 		}
 
+		if(session->active_request && session->active_request->message) {
+			/* from the request is received, including the time it is queued behind others */
+			mrcp_server_request_time_record(session->server,
+				channel->resource->id,
+				message->start_line.method_id,
+				apr_time_now() - session->active_request->time);
+		}
 		session->active_request = apt_list_pop_front(session->request_queue);
 		if(session->active_request) {
 			mrcp_server_signaling_message_dispatch(session,session->active_request);
 		}
 	}
 	else { 
+		mrcp_server_engine_request_trace(channel,message);
 		/* send event message to client */
 		if(channel->control_channel) {
 			/* MRCPv2 */
@@ -1162,3 +1891,17 @@ static apt_bool_t state_machine_on_deactivate(mrcp_state_machine_t *state_machin
 	mrcp_server_session_subrequest_remove(session);
 	return TRUE;
 }
+
+static apt_bool_t state_machine_on_prefetch(mrcp_state_machine_t *state_machine, mrcp_message_t *message, apt_bool_t start)
+{
+	mrcp_channel_t *channel = state_machine->obj;
+	if(!channel->engine_channel || state_machine->active == FALSE) {
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"%s Prefetch of %s Request "APT_SIDRES_FMT" [%"MRCP_REQUEST_ID_FMT"]",
+		start == TRUE ? "Hint" : "Withdraw",
+		message->start_line.method_name.buf,
+		MRCP_MESSAGE_SIDRES(message),
+		message->start_line.request_id);
+	return mrcp_engine_channel_prefetch(channel->engine_channel,message,start);
+}
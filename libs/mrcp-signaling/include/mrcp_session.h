@@ -46,6 +46,8 @@ typedef struct mrcp_session_request_vtable_t mrcp_session_request_vtable_t;
 typedef struct mrcp_session_response_vtable_t mrcp_session_response_vtable_t;
 /** MRCP session event vtable declaration */
 typedef struct mrcp_session_event_vtable_t mrcp_session_event_vtable_t;
+/** Recycler of session pools declaration */
+typedef struct mrcp_session_recycler_t mrcp_session_recycler_t;
 
 /** MRCP session */
 struct mrcp_session_t {
@@ -53,6 +55,8 @@ struct mrcp_session_t {
 	apr_pool_t       *pool;
 	/** Whether the memory pool is self-owned or not */
 	apt_bool_t        self_owned;
+	/** Recycler to return the self-owned pool to on destroy, if any */
+	mrcp_session_recycler_t *recycler;
 	/** External object associated with session */
 	void             *obj;
 	/** External logger object associated with session */
@@ -123,6 +127,25 @@ MRCP_DECLARE(mrcp_session_t*) mrcp_session_create_ex(apr_pool_t *pool, apt_bool_
 /** Destroy session and assosiated memory pool. */
 MRCP_DECLARE(void) mrcp_session_destroy(mrcp_session_t *session);
 
+/**
+ * Create recycler of session pools.
+ * @param max_count the max number of cleared pools kept for reuse
+ * @param pool the pool to allocate the recycler from
+ * @remark A pool of destroyed session is cleared rather than destroyed, so the next
+ *         session is allocated from the memory blocks already owned by the pool.
+ *         The recycler can be used by several threads.
+ */
+MRCP_DECLARE(mrcp_session_recycler_t*) mrcp_session_recycler_create(apr_size_t max_count, apr_pool_t *pool);
+
+/** Destroy recycler and the pools it keeps (all the sessions must have been destroyed by now) */
+MRCP_DECLARE(void) mrcp_session_recycler_destroy(mrcp_session_recycler_t *recycler);
+
+/** Allocate session object from a recycled memory pool, or from a new one if there is none */
+MRCP_DECLARE(mrcp_session_t*) mrcp_session_recycled_create(mrcp_session_recycler_t *recycler, apr_size_t padding);
+
+/** Get the number of cleared pools kept for reuse (approximate, read without lock) */
+MRCP_DECLARE(apr_size_t) mrcp_session_recycler_count_get(const mrcp_session_recycler_t *recycler);
+
 
 /** Offer */
 static APR_INLINE apt_bool_t mrcp_session_offer(mrcp_session_t *session, mrcp_session_descriptor_t *descriptor)
@@ -26,11 +26,31 @@
 
 #include <apr_network_io.h>
 #include <apr_tables.h>
+#include <apr_thread_mutex.h>
 #include "mrcp_sig_types.h"
 #include "apt_task.h"
 
 APT_BEGIN_EXTERN_C
 
+/** Opaque server endpoint declaration */
+typedef struct mrcp_sig_endpoint_t mrcp_sig_endpoint_t;
+
+/** Server endpoint of signaling settings */
+struct mrcp_sig_endpoint_t {
+	/** Server IP address */
+	char        *server_ip;
+	/** Server port */
+	apr_port_t   server_port;
+	/** Weight of endpoint in round-robin selection */
+	int          weight;
+	/** Current weight (smooth weighted round-robin) */
+	int          current_weight;
+	/** Number of consecutive failures */
+	apr_size_t   failures;
+	/** Time the circuit is open until (0 if closed) */
+	apr_time_t   open_until;
+};
+
 /** Signaling settings */
 struct mrcp_sig_settings_t {
 	/** Server IP address */
@@ -48,6 +68,14 @@ struct mrcp_sig_settings_t {
 	apt_bool_t   force_destination;
 	/** Optional feature tags */
 	char        *feature_tags;
+	/** Optional list of server endpoints (mrcp_sig_endpoint_t*) to fail over among */
+	apr_array_header_t  *endpoints;
+	/** Number of consecutive failures opening the circuit of endpoint */
+	apr_size_t           failure_threshold;
+	/** Time the circuit of endpoint stays open for (msec) */
+	apr_uint32_t         open_timeout;
+	/** Mutex guarding the state of endpoints */
+	apr_thread_mutex_t  *mutex;
 };
 
 /** MRCP signaling agent  */
@@ -60,6 +88,8 @@ struct mrcp_sig_agent_t {
 	void                    *obj;
 	/** Parent object (client/server) */
 	void                    *parent;
+	/** Primary agent the agent is a worker of (NULL for the primary agent itself) */
+	mrcp_sig_agent_t        *primary;
 	/** MRCP resource factory */
 	mrcp_resource_factory_t *resource_factory;
 	/** Task interface */
@@ -71,6 +101,8 @@ struct mrcp_sig_agent_t {
 	mrcp_session_t* (*create_server_session)(mrcp_sig_agent_t *signaling_agent);
 	/** Virtual create_client_session */
 	apt_bool_t (*create_client_session)(mrcp_session_t *session, const mrcp_sig_settings_t *settings);
+	/** Virtual render_load (optional), a compact report of the load of the server */
+	char* (*render_load)(mrcp_sig_agent_t *signaling_agent, apr_pool_t *pool);
 };
 
 /** Create signaling agent. */
@@ -91,6 +123,47 @@ MRCP_DECLARE(mrcp_sig_agent_t*) mrcp_sa_factory_agent_select(mrcp_sa_factory_t *
 /** Allocate MRCP signaling settings. */
 MRCP_DECLARE(mrcp_sig_settings_t*) mrcp_signaling_settings_alloc(apr_pool_t *pool);
 
+/**
+ * Add server endpoint to signaling settings.
+ * @param settings the settings to add endpoint to
+ * @param server_ip the IP address of the server
+ * @param server_port the port of the server
+ * @param weight the weight of endpoint in round-robin selection
+ * @param pool the pool to allocate memory from
+ */
+MRCP_DECLARE(mrcp_sig_endpoint_t*) mrcp_signaling_settings_endpoint_add(
+									mrcp_sig_settings_t *settings,
+									const char *server_ip,
+									apr_port_t server_port,
+									int weight,
+									apr_pool_t *pool);
+
+/**
+ * Set circuit breaker parameters of server endpoints.
+ * @param settings the settings to set parameters of
+ * @param failure_threshold the number of consecutive failures opening the circuit (0 - never open)
+ * @param open_timeout the time the circuit stays open for, before a trial request is let through (msec)
+ */
+MRCP_DECLARE(void) mrcp_signaling_settings_breaker_set(mrcp_sig_settings_t *settings, apr_size_t failure_threshold, apr_uint32_t open_timeout);
+
+/**
+ * Select next available server endpoint (weighted round-robin).
+ * @param settings the settings to select endpoint from
+ * @param tried the mask of endpoints already tried by the session, updated on return
+ * @return NULL if no endpoint is available
+ * @remark Endpoints with open circuit are skipped. Once the open timeout elapses,
+ *         a single trial request is let through (half-open state).
+ */
+MRCP_DECLARE(mrcp_sig_endpoint_t*) mrcp_signaling_settings_endpoint_select(const mrcp_sig_settings_t *settings, apr_uint32_t *tried);
+
+/**
+ * Report the outcome of a request sent to server endpoint.
+ * @param settings the settings endpoint belongs to
+ * @param endpoint the endpoint to report the outcome of
+ * @param success whether the server responded
+ */
+MRCP_DECLARE(void) mrcp_signaling_settings_endpoint_report(const mrcp_sig_settings_t *settings, mrcp_sig_endpoint_t *endpoint, apt_bool_t success);
+
 
 APT_END_EXTERN_C
 
@@ -28,6 +28,7 @@ MRCP_DECLARE(mrcp_session_descriptor_t*) mrcp_session_descriptor_create(apr_pool
 	descriptor->resource_state = FALSE;
 	descriptor->status = MRCP_SESSION_STATUS_OK;
 	descriptor->response_code = 0;
+	descriptor->retry_after = 0;
 	descriptor->control_media_arr = apr_array_make(pool,1,sizeof(void*));
 	descriptor->audio_media_arr = apr_array_make(pool,1,sizeof(mpf_rtp_media_descriptor_t*));
 	descriptor->video_media_arr = apr_array_make(pool,0,sizeof(mpf_rtp_media_descriptor_t*));
@@ -44,6 +45,7 @@ MRCP_DECLARE(mrcp_session_descriptor_t*) mrcp_session_answer_create(const mrcp_s
 	answer->resource_name = offer->resource_name;
 	answer->resource_state = offer->resource_state;
 	answer->status = offer->status;
+	answer->retry_after = 0;
 	answer->control_media_arr = apr_array_make(pool,offer->control_media_arr->nelts,sizeof(void*));
 	for(i=0; i<offer->control_media_arr->nelts; i++) {
 		APR_ARRAY_PUSH(answer->control_media_arr,void*) = NULL;
@@ -72,6 +74,8 @@ MRCP_DECLARE(const char*) mrcp_session_status_phrase_get(mrcp_session_status_e s
 			return "Unavailable";
 		case MRCP_SESSION_STATUS_ERROR:
 			return "Error";
+		case MRCP_SESSION_STATUS_OVERLOADED:
+			return "Overloaded";
 	}
 	return "Unknown";
 }
@@ -18,14 +18,22 @@
 
 #include "mrcp_sig_agent.h"
 #include "mrcp_session.h"
+#include <apr_thread_mutex.h>
+#include <apr_atomic.h>
+#include <apr_strings.h>
 #include "apt_pool.h"
+#include "apt_log.h"
+#include "apt_probe.h"
+
+/** Max number of server endpoints (size of the mask of tried endpoints) */
+#define MAX_SIG_ENDPOINTS 32
 
 /** Factory of MRCP signaling agents */
 struct mrcp_sa_factory_t {
 	/** Array of pointers to signaling agents */
 	apr_array_header_t   *agents_arr;
-	/** Index of the current agent */
-	int                   index;
+	/** Index of the current agent (atomic, may grow beyond the number of agents) */
+	volatile apr_uint32_t index;
 };
 
 /** Create signaling agent */
@@ -37,10 +45,12 @@ MRCP_DECLARE(mrcp_sig_agent_t*) mrcp_signaling_agent_create(const char *id, void
 	sig_agent->obj = obj;
 	sig_agent->resource_factory = NULL;
 	sig_agent->parent = NULL;
+	sig_agent->primary = NULL;
 	sig_agent->task = NULL;
 	sig_agent->msg_pool = NULL;
 	sig_agent->create_server_session = NULL;
 	sig_agent->create_client_session = NULL;
+	sig_agent->render_load = NULL;
 	return sig_agent;
 }
 
@@ -74,11 +84,9 @@ MRCP_DECLARE(apt_bool_t) mrcp_sa_factory_is_empty(const mrcp_sa_factory_t *sa_fa
 /** Select next available signaling agent */
 MRCP_DECLARE(mrcp_sig_agent_t*) mrcp_sa_factory_agent_select(mrcp_sa_factory_t *sa_factory)
 {
-	mrcp_sig_agent_t *sig_agent = APR_ARRAY_IDX(sa_factory->agents_arr, sa_factory->index, mrcp_sig_agent_t*);
-	if(++sa_factory->index == sa_factory->agents_arr->nelts) {
-		sa_factory->index = 0;
-	}
-	return sig_agent;
+	/* the selection may be requested by several client workers at once */
+	apr_uint32_t index = apr_atomic_inc32(&sa_factory->index);
+	return APR_ARRAY_IDX(sa_factory->agents_arr, index % sa_factory->agents_arr->nelts, mrcp_sig_agent_t*);
 }
 
 /** Allocate MRCP signaling settings */
@@ -92,9 +100,115 @@ MRCP_DECLARE(mrcp_sig_settings_t*) mrcp_signaling_settings_alloc(apr_pool_t *poo
 	settings->resource_map = apr_table_make(pool,2);
 	settings->force_destination = FALSE;
 	settings->feature_tags = NULL;
+	settings->endpoints = NULL;
+	settings->failure_threshold = 3;
+	settings->open_timeout = 30000;
+	settings->mutex = NULL;
 	return settings;
 }
 
+MRCP_DECLARE(mrcp_sig_endpoint_t*) mrcp_signaling_settings_endpoint_add(
+									mrcp_sig_settings_t *settings,
+									const char *server_ip,
+									apr_port_t server_port,
+									int weight,
+									apr_pool_t *pool)
+{
+	mrcp_sig_endpoint_t *endpoint;
+	if(!settings->endpoints) {
+		settings->endpoints = apr_array_make(pool,2,sizeof(mrcp_sig_endpoint_t*));
+		if(apr_thread_mutex_create(&settings->mutex,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+			settings->mutex = NULL;
+		}
+	}
+	if(settings->endpoints->nelts >= MAX_SIG_ENDPOINTS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Too Many Server Endpoints [%d]",settings->endpoints->nelts);
+		return NULL;
+	}
+
+	endpoint = apr_palloc(pool,sizeof(mrcp_sig_endpoint_t));
+	endpoint->server_ip = apr_pstrdup(pool,server_ip);
+	endpoint->server_port = server_port;
+	endpoint->weight = weight > 0 ? weight : 1;
+	endpoint->current_weight = 0;
+	endpoint->failures = 0;
+	endpoint->open_until = 0;
+	APR_ARRAY_PUSH(settings->endpoints,mrcp_sig_endpoint_t*) = endpoint;
+	return endpoint;
+}
+
+MRCP_DECLARE(void) mrcp_signaling_settings_breaker_set(mrcp_sig_settings_t *settings, apr_size_t failure_threshold, apr_uint32_t open_timeout)
+{
+	settings->failure_threshold = failure_threshold;
+	settings->open_timeout = open_timeout;
+}
+
+MRCP_DECLARE(mrcp_sig_endpoint_t*) mrcp_signaling_settings_endpoint_select(const mrcp_sig_settings_t *settings, apr_uint32_t *tried)
+{
+	mrcp_sig_endpoint_t *endpoint;
+	mrcp_sig_endpoint_t *selected = NULL;
+	int selected_index = 0;
+	int total_weight = 0;
+	int i;
+	apr_time_t now;
+	if(!settings->endpoints) {
+		return NULL;
+	}
+
+	now = apr_time_now();
+	if(settings->mutex) apr_thread_mutex_lock(settings->mutex);
+	for(i=0; i<settings->endpoints->nelts; i++) {
+		if(*tried & (1U << i)) {
+			continue;
+		}
+		endpoint = APR_ARRAY_IDX(settings->endpoints,i,mrcp_sig_endpoint_t*);
+		if(endpoint->open_until && now < endpoint->open_until) {
+			/* circuit is open */
+			continue;
+		}
+		endpoint->current_weight += endpoint->weight;
+		total_weight += endpoint->weight;
+		if(!selected || endpoint->current_weight > selected->current_weight) {
+			selected = endpoint;
+			selected_index = i;
+		}
+	}
+	if(selected) {
+		selected->current_weight -= total_weight;
+		if(selected->open_until) {
+			/* half-open: let a single trial through, keep the circuit open for others */
+			selected->open_until = now + apr_time_from_msec(settings->open_timeout);
+		}
+		*tried |= 1U << selected_index;
+	}
+	if(settings->mutex) apr_thread_mutex_unlock(settings->mutex);
+	return selected;
+}
+
+MRCP_DECLARE(void) mrcp_signaling_settings_endpoint_report(const mrcp_sig_settings_t *settings, mrcp_sig_endpoint_t *endpoint, apt_bool_t success)
+{
+	if(settings->mutex) apr_thread_mutex_lock(settings->mutex);
+	if(success == TRUE) {
+		if(endpoint->open_until) {
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Close Circuit of Server Endpoint %s:%hu",
+				endpoint->server_ip,endpoint->server_port);
+		}
+		endpoint->failures = 0;
+		endpoint->open_until = 0;
+	}
+	else {
+		endpoint->failures++;
+		if(settings->failure_threshold && endpoint->failures >= settings->failure_threshold) {
+			if(!endpoint->open_until) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Open Circuit of Server Endpoint %s:%hu [%"APR_SIZE_T_FMT" failures]",
+					endpoint->server_ip,endpoint->server_port,endpoint->failures);
+			}
+			endpoint->open_until = apr_time_now() + apr_time_from_msec(settings->open_timeout);
+		}
+	}
+	if(settings->mutex) apr_thread_mutex_unlock(settings->mutex);
+}
+
 
 MRCP_DECLARE(mrcp_session_t*) mrcp_session_create(apr_size_t padding)
 {
@@ -111,6 +225,7 @@ MRCP_DECLARE(mrcp_session_t*) mrcp_session_create_ex(apr_pool_t *pool, apt_bool_
 	mrcp_session_t *session;
 	session = apr_palloc(pool,sizeof(mrcp_session_t)+padding);
 	session->self_owned = take_ownership;
+	session->recycler = NULL;
 	session->pool = pool;
 	session->obj = NULL;
 	session->log_obj = NULL;
@@ -124,12 +239,102 @@ MRCP_DECLARE(mrcp_session_t*) mrcp_session_create_ex(apr_pool_t *pool, apt_bool_
 	session->event_vtable = NULL;
 	apt_string_reset(&session->id);
 	session->last_request_id = 0;
+	APT_PROBE1(session_create,session);
 	return session;
 }
 
+static apt_bool_t mrcp_session_recycler_put(mrcp_session_recycler_t *recycler, apr_pool_t *pool);
+
 MRCP_DECLARE(void) mrcp_session_destroy(mrcp_session_t *session)
 {
+	APT_PROBE2(session_destroy,session,session->id.buf);
 	if(session->pool && session->self_owned == TRUE) {
-		apr_pool_destroy(session->pool);
+		apr_pool_t *pool = session->pool;
+		/* the session itself is allocated from the pool, so it isn't referred to afterwards */
+		if(session->recycler && mrcp_session_recycler_put(session->recycler,pool) == TRUE) {
+			return;
+		}
+		apr_pool_destroy(pool);
+	}
+}
+
+/** Recycler of session pools */
+struct mrcp_session_recycler_t {
+	/** Cleared pools kept for reuse */
+	apr_pool_t        **pools;
+	/** Number of kept pools */
+	apr_size_t          count;
+	/** Max number of kept pools */
+	apr_size_t          max_count;
+	/** Guard of the kept pools */
+	apr_thread_mutex_t *guard;
+};
+
+MRCP_DECLARE(mrcp_session_recycler_t*) mrcp_session_recycler_create(apr_size_t max_count, apr_pool_t *pool)
+{
+	mrcp_session_recycler_t *recycler = apr_palloc(pool,sizeof(mrcp_session_recycler_t));
+	recycler->pools = apr_palloc(pool,sizeof(apr_pool_t*) * (max_count ? max_count : 1));
+	recycler->count = 0;
+	recycler->max_count = max_count;
+	if(apr_thread_mutex_create(&recycler->guard,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		return NULL;
 	}
+	return recycler;
+}
+
+MRCP_DECLARE(void) mrcp_session_recycler_destroy(mrcp_session_recycler_t *recycler)
+{
+	apr_thread_mutex_lock(recycler->guard);
+	while(recycler->count) {
+		apr_pool_destroy(recycler->pools[--recycler->count]);
+	}
+	/* sessions destroyed after this point destroy their pools */
+	recycler->max_count = 0;
+	apr_thread_mutex_unlock(recycler->guard);
+}
+
+MRCP_DECLARE(mrcp_session_t*) mrcp_session_recycled_create(mrcp_session_recycler_t *recycler, apr_size_t padding)
+{
+	mrcp_session_t *session;
+	apr_pool_t *pool = NULL;
+	apr_thread_mutex_lock(recycler->guard);
+	if(recycler->count) {
+		pool = recycler->pools[--recycler->count];
+	}
+	apr_thread_mutex_unlock(recycler->guard);
+
+	if(!pool) {
+		pool = apt_pool_create();
+		if(!pool) {
+			return NULL;
+		}
+	}
+	session = mrcp_session_create_ex(pool,TRUE,padding);
+	session->recycler = recycler;
+	return session;
+}
+
+MRCP_DECLARE(apr_size_t) mrcp_session_recycler_count_get(const mrcp_session_recycler_t *recycler)
+{
+	return recycler->count;
+}
+
+static apt_bool_t mrcp_session_recycler_put(mrcp_session_recycler_t *recycler, apr_pool_t *pool)
+{
+	apt_bool_t kept = FALSE;
+	if(!recycler->max_count) {
+		return FALSE;
+	}
+	/* run the cleanups out of the guard, the memory blocks of the pool remain for the next session */
+	apt_pool_clear(pool);
+	apr_thread_mutex_lock(recycler->guard);
+	if(recycler->count < recycler->max_count) {
+		recycler->pools[recycler->count++] = pool;
+		kept = TRUE;
+	}
+	apr_thread_mutex_unlock(recycler->guard);
+	if(kept == FALSE) {
+		apr_pool_destroy(pool);
+	}
+	return TRUE;
 }
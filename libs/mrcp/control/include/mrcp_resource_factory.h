@@ -41,6 +41,9 @@ MRCP_DECLARE(apt_bool_t) mrcp_resource_register(mrcp_resource_factory_t *resourc
 /** Get MRCP resource by resource id */
 MRCP_DECLARE(mrcp_resource_t*) mrcp_resource_get(const mrcp_resource_factory_t *resource_factory, mrcp_resource_id resource_id);
 
+/** Get the number of MRCP resources (the max resource id + 1) */
+MRCP_DECLARE(apr_size_t) mrcp_resource_count_get(const mrcp_resource_factory_t *resource_factory);
+
 /** Find MRCP resource by resource name */
 MRCP_DECLARE(mrcp_resource_t*) mrcp_resource_find(const mrcp_resource_factory_t *resource_factory, const apt_str_t *name);
 
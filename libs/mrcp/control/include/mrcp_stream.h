@@ -45,6 +45,15 @@ MRCP_DECLARE(void) mrcp_parser_resource_set(mrcp_parser_t *parser, const apt_str
 /** Set verbose mode for the parser */
 MRCP_DECLARE(void) mrcp_parser_verbose_set(mrcp_parser_t *parser, apt_bool_t verbose);
 
+/** Set lazy mode for the parser (header field values are parsed on first access) */
+MRCP_DECLARE(void) mrcp_parser_lazy_set(mrcp_parser_t *parser, apt_bool_t lazy);
+
+/** Set zero-copy mode for the parser (parsed messages reference the stream, see apt_message_parser_zero_copy_set()) */
+MRCP_DECLARE(void) mrcp_parser_zero_copy_set(mrcp_parser_t *parser, apt_bool_t zero_copy);
+
+/** Check whether messages parsed since the last check reference the stream */
+MRCP_DECLARE(apt_bool_t) mrcp_parser_stream_pinned(mrcp_parser_t *parser);
+
 /** Parse MRCP stream */
 MRCP_DECLARE(apt_message_status_e) mrcp_parser_run(mrcp_parser_t *parser, apt_text_stream_t *stream, mrcp_message_t **message);
 
@@ -63,6 +72,14 @@ MRCP_DECLARE(apt_message_status_e) mrcp_generator_run(mrcp_generator_t *generato
 /** Generate MRCP message (excluding message body) */
 MRCP_DECLARE(apt_bool_t) mrcp_message_generate(const mrcp_resource_factory_t *resource_factory, mrcp_message_t *message, apt_text_stream_t *stream);
 
+/**
+ * Generate MRCP message (excluding message body) by start-line templates of the generator.
+ * @remark Start-lines of MRCPv2 responses and events are compiled once per resource, method,
+ *         status-code and request-state, then only request-id and message-length are patched in.
+ *         The output is the same as of mrcp_message_generate().
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_generator_message_generate(mrcp_generator_t *generator, mrcp_message_t *message, apt_text_stream_t *stream);
+
 
 APT_END_EXTERN_C
 
@@ -21,6 +21,7 @@
 #include "mrcp_message.h"
 #include "mrcp_resource.h"
 #include "mrcp_generic_header.h"
+#include "apt_string_intern.h"
 
 /** Resource factory definition (aggregation of resources) */
 struct mrcp_resource_factory_t {
@@ -76,6 +77,8 @@ MRCP_DECLARE(apt_bool_t) mrcp_resource_register(mrcp_resource_factory_t *resourc
 		/* invalid resource */
 		return FALSE;
 	}
+	/* the names of standard resources are compared by identity in mrcp_resource_find() */
+	apt_string_intern(&resource->name);
 	resource_factory->resource_array[resource->id] = resource;
 	apr_hash_set(resource_factory->resource_hash,resource->name.buf,resource->name.length,resource);
 	return TRUE;
@@ -90,6 +93,12 @@ MRCP_DECLARE(mrcp_resource_t*) mrcp_resource_get(const mrcp_resource_factory_t *
 	return resource_factory->resource_array[resource_id];
 }
 
+/** Get the number of MRCP resources */
+MRCP_DECLARE(apr_size_t) mrcp_resource_count_get(const mrcp_resource_factory_t *resource_factory)
+{
+	return resource_factory->resource_count;
+}
+
 /** Find MRCP resource by resource name */
 MRCP_DECLARE(mrcp_resource_t*) mrcp_resource_find(const mrcp_resource_factory_t *resource_factory, const apt_str_t *name)
 {
@@ -97,5 +106,16 @@ MRCP_DECLARE(mrcp_resource_t*) mrcp_resource_find(const mrcp_resource_factory_t
 		return NULL;
 	}
 
+	if(apt_string_is_interned(name) == TRUE) {
+		/* parsed names of standard resources are interned */
+		apr_size_t i;
+		mrcp_resource_t *resource;
+		for(i=0; i<resource_factory->resource_count; i++) {
+			resource = resource_factory->resource_array[i];
+			if(resource && resource->name.buf == name->buf) {
+				return resource;
+			}
+		}
+	}
 	return apr_hash_get(resource_factory->resource_hash,name->buf,name->length);
 }
@@ -16,11 +16,13 @@
  * $Id$
  */
 
+#include <apr_hash.h>
 #include "mrcp_stream.h"
 #include "mrcp_message.h"
 #include "mrcp_resource_factory.h"
 #include "mrcp_resource.h"
 #include "apt_log.h"
+#include "apt_probe.h"
 
 
 /** MRCP parser */
@@ -28,12 +30,29 @@ struct mrcp_parser_t {
 	apt_message_parser_t          *base;
 	const mrcp_resource_factory_t *resource_factory;
 	mrcp_resource_t               *resource;
+	apt_bool_t                     lazy;
 };
 
+/** Max number of start-line templates cached by MRCP generator */
+#define MRCP_GENERATOR_MAX_TEMPLATE_COUNT 256
+
 /** MRCP generator */
 struct mrcp_generator_t {
 	apt_message_generator_t       *base;
 	const mrcp_resource_factory_t *resource_factory;
+	/** Start-line templates of responses and events (mrcp_template_key_t -> mrcp_start_line_template_t) */
+	apr_hash_t                    *templates;
+	apr_pool_t                    *pool;
+};
+
+/** Key of start-line template */
+typedef struct mrcp_template_key_t mrcp_template_key_t;
+struct mrcp_template_key_t {
+	mrcp_resource_id     resource_id;
+	mrcp_message_type_e  message_type;
+	mrcp_method_id       method_id;
+	mrcp_status_code_e   status_code;
+	mrcp_request_state_e request_state;
 };
 
 /** Create message and read start line */
@@ -66,6 +85,7 @@ MRCP_DECLARE(mrcp_parser_t*) mrcp_parser_create(const mrcp_resource_factory_t *r
 	parser->base = apt_message_parser_create(parser,&parser_vtable,pool);
 	parser->resource_factory = resource_factory;
 	parser->resource = NULL;
+	parser->lazy = FALSE;
 	return parser;
 }
 
@@ -83,10 +103,32 @@ MRCP_DECLARE(void) mrcp_parser_verbose_set(mrcp_parser_t *parser, apt_bool_t ver
 	apt_message_parser_verbose_set(parser->base,verbose);
 }
 
+/** Set lazy mode for the parser */
+MRCP_DECLARE(void) mrcp_parser_lazy_set(mrcp_parser_t *parser, apt_bool_t lazy)
+{
+	parser->lazy = lazy;
+}
+
+/** Set zero-copy mode for the parser */
+MRCP_DECLARE(void) mrcp_parser_zero_copy_set(mrcp_parser_t *parser, apt_bool_t zero_copy)
+{
+	apt_message_parser_zero_copy_set(parser->base,zero_copy);
+}
+
+/** Check whether messages parsed since the last check reference the stream */
+MRCP_DECLARE(apt_bool_t) mrcp_parser_stream_pinned(mrcp_parser_t *parser)
+{
+	return apt_message_parser_stream_pinned(parser->base);
+}
+
 /** Parse MRCP stream */
 MRCP_DECLARE(apt_message_status_e) mrcp_parser_run(mrcp_parser_t *parser, apt_text_stream_t *stream, mrcp_message_t **message)
 {
-	return apt_message_parser_run(parser->base,stream,(void**)message);
+	apt_message_status_e status;
+	APT_PROBE2(mrcp_parser_run_start,parser,stream->text.length);
+	status = apt_message_parser_run(parser->base,stream,(void**)message);
+	APT_PROBE3(mrcp_parser_run_end,parser,status,*message);
+	return status;
 }
 
 /** Create message and read start line */
@@ -131,13 +173,13 @@ static apt_bool_t mrcp_parser_on_start(apt_message_parser_t *parser, apt_message
 static apt_bool_t mrcp_parser_on_header_complete(apt_message_parser_t *parser, apt_message_context_t *context)
 {
 	mrcp_message_t *mrcp_message = context->message;
+	mrcp_parser_t *mrcp_parser = apt_message_parser_object_get(parser);
+	apt_bool_t status;
 	if(mrcp_message->start_line.version == MRCP_VERSION_2) {
 		mrcp_resource_t *resource;
-		mrcp_parser_t *mrcp_parser;
 		if(mrcp_channel_id_parse(&mrcp_message->channel_id,&mrcp_message->header,mrcp_message->pool) == FALSE) {
 			return FALSE;
 		}
-		mrcp_parser = apt_message_parser_object_get(parser);
 		/* find resource */
 		resource = mrcp_resource_find(mrcp_parser->resource_factory,&mrcp_message->channel_id.resource_name);
 		if(!resource) {
@@ -149,7 +191,13 @@ static apt_bool_t mrcp_parser_on_header_complete(apt_message_parser_t *parser, a
 		}
 	}
 
-	if(mrcp_header_fields_parse(&mrcp_message->header,mrcp_message->pool) == FALSE) {
+	if(mrcp_parser->lazy == TRUE) {
+		status = mrcp_header_fields_lazy_parse(&mrcp_message->header,mrcp_message->pool);
+	}
+	else {
+		status = mrcp_header_fields_parse(&mrcp_message->header,mrcp_message->pool);
+	}
+	if(status == FALSE) {
 		return FALSE;
 	}
 
@@ -169,6 +217,8 @@ MRCP_DECLARE(mrcp_generator_t*) mrcp_generator_create(const mrcp_resource_factor
 	mrcp_generator_t *generator = apr_palloc(pool,sizeof(mrcp_generator_t));
 	generator->base = apt_message_generator_create(generator,&generator_vtable,pool);
 	generator->resource_factory = resource_factory;
+	generator->templates = apr_hash_make(pool);
+	generator->pool = pool;
 	return generator;
 }
 
@@ -184,6 +234,80 @@ MRCP_DECLARE(apt_message_status_e) mrcp_generator_run(mrcp_generator_t *generato
 	return apt_message_generator_run(generator->base,message,stream);
 }
 
+/** Find or compile start-line template of MRCPv2 response or event */
+static const mrcp_start_line_template_t* mrcp_generator_template_get(mrcp_generator_t *generator, const mrcp_message_t *message)
+{
+	mrcp_template_key_t key;
+	mrcp_template_key_t *new_key;
+	mrcp_start_line_template_t *tmpl;
+	const mrcp_start_line_t *start_line = &message->start_line;
+	if(start_line->version != MRCP_VERSION_2 || !message->resource ||
+		(start_line->message_type != MRCP_MESSAGE_TYPE_RESPONSE && start_line->message_type != MRCP_MESSAGE_TYPE_EVENT)) {
+		return NULL;
+	}
+
+	/* padding is zeroed, the key is compared bytewise */
+	memset(&key,0,sizeof(key));
+	key.resource_id = message->resource->id;
+	key.message_type = start_line->message_type;
+	key.method_id = start_line->method_id;
+	key.status_code = start_line->status_code;
+	key.request_state = start_line->request_state;
+	tmpl = apr_hash_get(generator->templates,&key,sizeof(key));
+	if(tmpl) {
+		return tmpl;
+	}
+
+	if(apr_hash_count(generator->templates) >= MRCP_GENERATOR_MAX_TEMPLATE_COUNT) {
+		return NULL;
+	}
+	if(start_line->message_type == MRCP_MESSAGE_TYPE_EVENT) {
+		/* the event name is a part of the template, make sure it is the one of the resource */
+		const apt_str_t *name = NULL;
+		if(message->resource->get_event_str_table && start_line->method_id < message->resource->event_count) {
+			name = apt_string_table_str_get(
+						message->resource->get_event_str_table(start_line->version),
+						message->resource->event_count,
+						start_line->method_id);
+		}
+		if(!name || apt_string_compare(name,&start_line->method_name) == FALSE) {
+			return NULL;
+		}
+	}
+	tmpl = apr_palloc(generator->pool,sizeof(mrcp_start_line_template_t));
+	if(mrcp_start_line_template_compile(tmpl,start_line,generator->pool) == FALSE) {
+		return NULL;
+	}
+	new_key = apr_palloc(generator->pool,sizeof(key));
+	*new_key = key;
+	apr_hash_set(generator->templates,new_key,sizeof(key),tmpl);
+	return tmpl;
+}
+
+/** Generate start-line and channel-id of MRCP message */
+static apt_bool_t mrcp_generator_start_line_generate(mrcp_generator_t *generator, mrcp_message_t *message, apt_text_stream_t *stream)
+{
+	const mrcp_start_line_template_t *tmpl = NULL;
+	if(generator) {
+		tmpl = mrcp_generator_template_get(generator,message);
+	}
+
+	if(tmpl) {
+		/* precompiled start-line, only request-id is patched in */
+		if(mrcp_start_line_template_generate(tmpl,&message->start_line,stream) == FALSE) {
+			return FALSE;
+		}
+	}
+	else if(mrcp_start_line_generate(&message->start_line,stream) == FALSE) {
+		return FALSE;
+	}
+
+	if(message->start_line.version == MRCP_VERSION_2) {
+		mrcp_channel_id_generate(&message->channel_id,stream);
+	}
+	return TRUE;
+}
+
 /** Initialize by generating message start line and return header section and body */
 apt_bool_t mrcp_generator_on_start(apt_message_generator_t *generator, apt_message_context_t *context, apt_text_stream_t *stream)
 {
@@ -193,13 +317,9 @@ apt_bool_t mrcp_generator_on_start(apt_message_generator_t *generator, apt_messa
 		return FALSE;
 	}
 	/* generate start-line */
-	if(mrcp_start_line_generate(&mrcp_message->start_line,stream) == FALSE) {
+	if(mrcp_generator_start_line_generate(apt_message_generator_object_get(generator),mrcp_message,stream) == FALSE) {
 		return FALSE;
 	}
-		
-	if(mrcp_message->start_line.version == MRCP_VERSION_2) {
-		mrcp_channel_id_generate(&mrcp_message->channel_id,stream);
-	}
 
 	context->header = &mrcp_message->header.header_section;
 	context->body = &mrcp_message->body;
@@ -215,7 +335,7 @@ apt_bool_t mrcp_generator_on_header_complete(apt_message_generator_t *generator,
 }
 
 /** Generate MRCP message (excluding message body) */
-MRCP_DECLARE(apt_bool_t) mrcp_message_generate(const mrcp_resource_factory_t *resource_factory, mrcp_message_t *message, apt_text_stream_t *stream)
+static apt_bool_t mrcp_message_head_generate(mrcp_generator_t *generator, mrcp_message_t *message, apt_text_stream_t *stream)
 {
 	/* validate message */
 	if(mrcp_message_validate(message) == FALSE) {
@@ -223,14 +343,10 @@ MRCP_DECLARE(apt_bool_t) mrcp_message_generate(const mrcp_resource_factory_t *re
 	}
 	
 	/* generate start-line */
-	if(mrcp_start_line_generate(&message->start_line,stream) == FALSE) {
+	if(mrcp_generator_start_line_generate(generator,message,stream) == FALSE) {
 		return FALSE;
 	}
 
-	if(message->start_line.version == MRCP_VERSION_2) {
-		mrcp_channel_id_generate(&message->channel_id,stream);
-	}
-
 	/* generate header section */
 	if(apt_header_section_generate(&message->header.header_section,stream) == FALSE) {
 		return FALSE;
@@ -243,3 +359,15 @@ MRCP_DECLARE(apt_bool_t) mrcp_message_generate(const mrcp_resource_factory_t *re
 
 	return TRUE;
 }
+
+/** Generate MRCP message (excluding message body) */
+MRCP_DECLARE(apt_bool_t) mrcp_message_generate(const mrcp_resource_factory_t *resource_factory, mrcp_message_t *message, apt_text_stream_t *stream)
+{
+	return mrcp_message_head_generate(NULL,message,stream);
+}
+
+/** Generate MRCP message (excluding message body) by start-line templates of the generator */
+MRCP_DECLARE(apt_bool_t) mrcp_generator_message_generate(mrcp_generator_t *generator, mrcp_message_t *message, apt_text_stream_t *stream)
+{
+	return mrcp_message_head_generate(generator,message,stream);
+}
@@ -92,18 +92,51 @@ static APR_INLINE void mrcp_message_header_destroy(mrcp_message_header_t *header
 MRCP_DECLARE(apt_bool_t) mrcp_header_field_add(mrcp_message_header_t *header, apt_header_field_t *header_field, apr_pool_t *pool);
 
 
-/** Set (copy) MRCP header fields */
+/**
+ * Set (copy) MRCP header fields.
+ * @remark The values are copied rather than overwritten in place, so that the headers
+ *         inherited from the header before keep referring to the previous values.
+ */
 MRCP_DECLARE(apt_bool_t) mrcp_header_fields_set(mrcp_message_header_t *header, const mrcp_message_header_t *src_header, apr_pool_t *pool);
 
-/** Get (copy) MRCP header fields */
+/**
+ * Get MRCP header fields specified by the mask header.
+ * @remark The header fields refer to the names and values of the source and mask headers.
+ */
 MRCP_DECLARE(apt_bool_t) mrcp_header_fields_get(mrcp_message_header_t *header, const mrcp_message_header_t *src_header, const mrcp_message_header_t *mask_header, apr_pool_t *pool);
 
-/** Inherit (copy) MRCP header fields */
+/**
+ * Inherit MRCP header fields not set in the header yet (copy-on-write).
+ * @remark The inherited header fields refer to the names and values of the source header
+ *         (e.g. session defaults) instead of copying them, while the header fields set in
+ *         the header itself override the source ones. The source header must outlive the header.
+ */
 MRCP_DECLARE(apt_bool_t) mrcp_header_fields_inherit(mrcp_message_header_t *header, const mrcp_message_header_t *src_header, apr_pool_t *pool);
 
 /** Parse MRCP header fields */
 MRCP_DECLARE(apt_bool_t) mrcp_header_fields_parse(mrcp_message_header_t *header, apr_pool_t *pool);
 
+/**
+ * Parse MRCP header fields lazily.
+ * @remark Only the names of header fields are resolved, so that the header fields
+ * can be checked by property (numeric identifier), while the values stay raw strings.
+ * The values are parsed into header data on first access to either generic or
+ * resource header (see mrcp_header_data_get()).
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_header_fields_lazy_parse(mrcp_message_header_t *header, apr_pool_t *pool);
+
+/** Parse the values of header fields pending for the specified accessor of MRCP header */
+MRCP_DECLARE(apt_bool_t) mrcp_header_fields_decode(mrcp_message_header_t *header, mrcp_header_accessor_t *accessor, apr_pool_t *pool);
+
+/** Get header data of the specified accessor, parsing pending header fields first */
+static APR_INLINE void* mrcp_header_data_get(mrcp_message_header_t *header, mrcp_header_accessor_t *accessor, apr_pool_t *pool)
+{
+	if(accessor->pending == TRUE) {
+		mrcp_header_fields_decode(header,accessor,pool);
+	}
+	return accessor->data;
+}
+
 
 /** Initialize MRCP channel-identifier */
 MRCP_DECLARE(void) mrcp_channel_id_init(mrcp_channel_id *channel_id);
@@ -53,6 +53,8 @@ struct mrcp_header_vtable_t {
 	const apt_str_table_item_t *field_table;
 	/** Number of fields  */
 	apr_size_t                  field_count;
+	/** Perfect hash of fields (optional) */
+	const apt_str_table_hash_t *field_hash;
 };
 
 /** MRCP header accessor */
@@ -61,6 +63,8 @@ struct mrcp_header_accessor_t {
 	void                       *data;
 	/** Header accessor interface */
 	const mrcp_header_vtable_t *vtable;
+	/** Header fields are not parsed into data yet (lazy parsing) */
+	apt_bool_t                  pending;
 };
 
 
@@ -75,6 +79,7 @@ static APR_INLINE void mrcp_header_vtable_init(mrcp_header_vtable_t *vtable)
 	vtable->duplicate_field = NULL;
 	vtable->field_table = NULL;
 	vtable->field_count = 0;
+	vtable->field_hash = NULL;
 }
 
 /** Validate header vtable */
@@ -92,6 +97,7 @@ static APR_INLINE void mrcp_header_accessor_init(mrcp_header_accessor_t *accesso
 {
 	accessor->data = NULL;
 	accessor->vtable = NULL;
+	accessor->pending = FALSE;
 }
 
 /** Allocate header data */
@@ -116,12 +122,18 @@ static APR_INLINE void mrcp_header_destroy(mrcp_header_accessor_t *accessor)
 }
 
 
+/** Resolve numeric identifier of header field by its name */
+MRCP_DECLARE(apt_bool_t) mrcp_header_field_name_resolve(const mrcp_header_accessor_t *accessor, apt_header_field_t *header_field);
+
 /** Parse header field value */
 MRCP_DECLARE(apt_bool_t) mrcp_header_field_value_parse(mrcp_header_accessor_t *accessor, apt_header_field_t *header_field, apr_pool_t *pool);
 
 /** Generate header field value */
 MRCP_DECLARE(apt_header_field_t*) mrcp_header_field_value_generate(const mrcp_header_accessor_t *accessor, apr_size_t id, apt_bool_t empty_value, apr_pool_t *pool);
 
+/** Generate header field value into already allocated header field */
+MRCP_DECLARE(apt_bool_t) mrcp_header_field_value_generate2(const mrcp_header_accessor_t *accessor, apr_size_t id, apt_bool_t empty_value, apt_header_field_t *header_field, apr_pool_t *pool);
+
 /** Duplicate header field value */
 MRCP_DECLARE(apt_bool_t) mrcp_header_field_value_duplicate(mrcp_header_accessor_t *accessor, const mrcp_header_accessor_t *src_accessor, apr_size_t id, const apt_str_t *value, apr_pool_t *pool);
 
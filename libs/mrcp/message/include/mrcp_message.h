@@ -45,9 +45,16 @@ struct mrcp_message_t {
 	mrcp_message_header_t  header;
 	/** Body of MRCP message */
 	apt_str_t              body;
+	/** Segments of the body sent by reference (optional, see mrcp_message_body_vec_set()) */
+	const struct iovec    *body_vec;
+	/** Number of the body segments */
+	apr_size_t             body_vec_count;
 
 	/** Associated MRCP resource */
 	const mrcp_resource_t *resource;
+	/** Whether the message may be dropped, while the connection is congested
+	    (e.g. intermediate result superseded by the next one) */
+	apt_bool_t             is_discardable;
 	/** Memory pool to allocate memory from */
 	apr_pool_t            *pool;
 };
@@ -89,6 +96,23 @@ MRCP_DECLARE(mrcp_message_t*) mrcp_event_create(
 								mrcp_method_id event_id, 
 								apr_pool_t *pool);
 
+/**
+ * Set the body of MRCP message as vector of segments (scatter/gather).
+ * @param message the message to set the body of
+ * @param vec the segments of the body to be valid until the message is sent
+ * @param count the number of segments
+ * @remark The body is sent by MRCPv2 connection segment by segment with no copies made,
+ *         body.length is set to the total length, while body.buf is left NULL until
+ *         the body is gathered by mrcp_message_body_flatten().
+ */
+MRCP_DECLARE(void) mrcp_message_body_vec_set(mrcp_message_t *message, const struct iovec *vec, apr_size_t count);
+
+/**
+ * Gather the segments of the body into a single buffer, if not done yet.
+ * @param message the message to gather the body of
+ */
+MRCP_DECLARE(const apt_str_t*) mrcp_message_body_flatten(mrcp_message_t *message);
+
 /**
  * Associate MRCP resource with message.
  * @param message the message to associate resource with
@@ -115,7 +139,12 @@ MRCP_DECLARE(void) mrcp_message_destroy(mrcp_message_t *message);
  */
 static APR_INLINE mrcp_generic_header_t* mrcp_generic_header_get(const mrcp_message_t *message)
 {
-	return (mrcp_generic_header_t*) message->header.generic_header_accessor.data;
+	/* lazily parsed header fields are decoded on first access, hence the const is cast away */
+	mrcp_message_t *parsed_message = (mrcp_message_t*) message;
+	return (mrcp_generic_header_t*) mrcp_header_data_get(
+			&parsed_message->header,
+			&parsed_message->header.generic_header_accessor,
+			parsed_message->pool);
 }
 
 /**
@@ -124,6 +153,7 @@ static APR_INLINE mrcp_generic_header_t* mrcp_generic_header_get(const mrcp_mess
  */
 static APR_INLINE mrcp_generic_header_t* mrcp_generic_header_prepare(mrcp_message_t *message)
 {
+	mrcp_header_fields_decode(&message->header,&message->header.generic_header_accessor,message->pool);
 	return (mrcp_generic_header_t*) mrcp_header_allocate(&message->header.generic_header_accessor,message->pool);
 }
 
@@ -173,7 +203,12 @@ static APR_INLINE apt_bool_t mrcp_generic_header_property_check(const mrcp_messa
  */
 static APR_INLINE void* mrcp_resource_header_get(const mrcp_message_t *message)
 {
-	return message->header.resource_header_accessor.data;
+	/* lazily parsed header fields are decoded on first access, hence the const is cast away */
+	mrcp_message_t *parsed_message = (mrcp_message_t*) message;
+	return mrcp_header_data_get(
+			&parsed_message->header,
+			&parsed_message->header.resource_header_accessor,
+			parsed_message->pool);
 }
 
 /**
@@ -182,6 +217,7 @@ static APR_INLINE void* mrcp_resource_header_get(const mrcp_message_t *message)
  */
 static APR_INLINE void* mrcp_resource_header_prepare(mrcp_message_t *mrcp_message)
 {
+	mrcp_header_fields_decode(&mrcp_message->header,&mrcp_message->header.resource_header_accessor,mrcp_message->pool);
 	return mrcp_header_allocate(&mrcp_message->header.resource_header_accessor,mrcp_message->pool);
 }
 
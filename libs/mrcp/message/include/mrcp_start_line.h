@@ -97,6 +97,19 @@ struct mrcp_start_line_t {
 	mrcp_request_state_e request_state;
 };
 
+/** MRCP start-line template declaration */
+typedef struct mrcp_start_line_template_t mrcp_start_line_template_t;
+
+/** Precompiled MRCPv2 start-line of response or event, only request-id and message-length are patched in */
+struct mrcp_start_line_template_t {
+	/** Text preceding request-id (version, reserved message-length and event name) */
+	apt_str_t            head;
+	/** Text following request-id (status-code, request-state and end-of-line) */
+	apt_str_t            tail;
+	/** Offset of reserved message-length in the head */
+	apr_size_t           length_offset;
+};
+
 /** Initialize MRCP start-line */
 MRCP_DECLARE(void) mrcp_start_line_init(mrcp_start_line_t *start_line);
 /** Parse MRCP start-line */
@@ -106,6 +119,22 @@ MRCP_DECLARE(apt_bool_t) mrcp_start_line_generate(mrcp_start_line_t *start_line,
 /** Finalize MRCP start-line generation */
 MRCP_DECLARE(apt_bool_t) mrcp_start_line_finalize(mrcp_start_line_t *start_line, apr_size_t content_length, apt_text_stream_t *text_stream);
 
+/**
+ * Compile MRCPv2 start-line of response or event into template.
+ * @param tmpl the template to compile
+ * @param start_line the start-line to compile the template from (request-id is ignored)
+ * @param pool the pool to allocate memory from
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_start_line_template_compile(mrcp_start_line_template_t *tmpl, const mrcp_start_line_t *start_line, apr_pool_t *pool);
+/**
+ * Generate MRCPv2 start-line by template, the same as mrcp_start_line_generate() does.
+ * @param tmpl the template to generate start-line by
+ * @param start_line the start-line to take request-id from and store offset of message-length to
+ * @param text_stream the stream to generate start-line into
+ * @remark The generated start-line is finalized by mrcp_start_line_finalize()
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_start_line_template_generate(const mrcp_start_line_template_t *tmpl, mrcp_start_line_t *start_line, apt_text_stream_t *text_stream);
+
 /** Parse MRCP request-id */
 MRCP_DECLARE(mrcp_request_id) mrcp_request_id_parse(const apt_str_t *field);
 /** Generate MRCP request-id */
@@ -18,6 +18,7 @@
 
 #include "mrcp_generic_header.h"
 #include "mrcp_start_line.h"
+#include "apt_string_intern.h"
 
 /** String table of mrcp generic-header fields (mrcp_generic_header_id) */
 static const apt_str_table_item_t generic_header_string_table[] = {
@@ -39,6 +40,14 @@ static const apt_str_table_item_t generic_header_string_table[] = {
 	{{"Set-Cookie2",               11},10}
 };
 
+/** Perfect hash of generic_header_string_table (generated by strtablegen) */
+static const apr_byte_t generic_header_string_table_hash_slots[32] = {
+	0,14,0,0,0,6,0,15,0,16,13,12,0,0,0,0,
+	0,0,9,7,0,2,8,10,0,0,4,5,11,0,3,1
+};
+
+static const apt_str_table_hash_t generic_header_string_table_hash = {93,31,generic_header_string_table_hash_slots};
+
 /** Parse mrcp request-id list */
 static apt_bool_t mrcp_request_id_list_parse(mrcp_request_id_list_t *request_id_list, const apt_str_t *value)
 {
@@ -61,11 +70,10 @@ static apt_bool_t mrcp_request_id_list_parse(mrcp_request_id_list_t *request_id_
 static apt_bool_t mrcp_request_id_list_generate(const mrcp_request_id_list_t *request_id_list, apt_str_t *str, apr_pool_t *pool)
 {
 	apr_size_t i;
-	int length;
 	char *pos;
 
-	/* compute estimated length, assuming request-ids consist of upto 10 digits */
-	str->length = 10 * request_id_list->count;
+	/* compute max length of request-ids */
+	str->length = APT_UINT64_VALUE_MAX_LENGTH * request_id_list->count;
 	if(request_id_list->count > 1) {
 		/* , */
 		str->length += request_id_list->count - 1;
@@ -79,12 +87,10 @@ static apt_bool_t mrcp_request_id_list_generate(const mrcp_request_id_list_t *re
 			*pos++ = ',';
 		}
 
-		length = apr_snprintf(pos, str->length - (pos - str->buf), "%"MRCP_REQUEST_ID_FMT, request_id_list->ids[i]);
-		if(length < 0)
-			return FALSE;
-		pos += length;
+		pos += apt_uint64_value_format(request_id_list->ids[i],pos);
 	}
 	*pos = '\0';
+	str->length = pos - str->buf;
 	return TRUE;
 }
 
@@ -138,6 +144,7 @@ static apt_bool_t mrcp_generic_header_parse(mrcp_header_accessor_t *accessor, si
 			break;
 		case GENERIC_HEADER_CONTENT_TYPE:
 			generic_header->content_type =  *value;
+			apt_string_intern(&generic_header->content_type);
 			break;
 		case GENERIC_HEADER_CONTENT_ID:
 			generic_header->content_id = *value;
@@ -265,6 +272,7 @@ static apt_bool_t mrcp_generic_header_duplicate(mrcp_header_accessor_t *accessor
 			break;
 		case GENERIC_HEADER_CONTENT_TYPE:
 			generic_header->content_type = *value;
+			apt_string_intern(&generic_header->content_type);
 			break;
 		case GENERIC_HEADER_CONTENT_ID:
 			generic_header->content_id = *value;
@@ -315,7 +323,8 @@ static const mrcp_header_vtable_t vtable = {
 	mrcp_generic_header_generate,
 	mrcp_generic_header_duplicate,
 	generic_header_string_table,
-	GENERIC_HEADER_COUNT
+	GENERIC_HEADER_COUNT,
+	&generic_header_string_table_hash
 };
 
 
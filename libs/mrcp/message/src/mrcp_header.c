@@ -38,9 +38,11 @@ MRCP_DECLARE(apt_bool_t) mrcp_message_header_data_alloc(
 
 	header->generic_header_accessor.data = NULL;
 	header->generic_header_accessor.vtable = generic_header_vtable;
+	header->generic_header_accessor.pending = FALSE;
 
 	header->resource_header_accessor.data = NULL;
 	header->resource_header_accessor.vtable = resource_header_vtable;
+	header->resource_header_accessor.pending = FALSE;
 
 	apt_header_section_array_alloc(
 		&header->header_section,
@@ -106,11 +108,82 @@ MRCP_DECLARE(apt_bool_t) mrcp_header_fields_parse(mrcp_message_header_t *header,
 	return TRUE;
 }
 
+/** Parse lazily MRCP header fields */
+MRCP_DECLARE(apt_bool_t) mrcp_header_fields_lazy_parse(mrcp_message_header_t *header, apr_pool_t *pool)
+{
+	apt_header_field_t *header_field;
+	for(header_field = APR_RING_FIRST(&header->header_section.ring);
+			header_field != APR_RING_SENTINEL(&header->header_section.ring, apt_header_field_t, link);
+				header_field = APR_RING_NEXT(header_field, link)) {
+
+		if(mrcp_header_field_name_resolve(&header->resource_header_accessor,header_field) == TRUE) {
+			header_field->id += GENERIC_HEADER_COUNT;
+			apt_header_section_field_set(&header->header_section,header_field);
+			header->resource_header_accessor.pending = TRUE;
+		}
+		else if(mrcp_header_field_name_resolve(&header->generic_header_accessor,header_field) == TRUE) {
+			apt_header_section_field_set(&header->header_section,header_field);
+			header->generic_header_accessor.pending = TRUE;
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown MRCP header field: %s",header_field->name.buf);
+		}
+	}
+
+	return TRUE;
+}
+
+/** Parse the values of pending header fields */
+MRCP_DECLARE(apt_bool_t) mrcp_header_fields_decode(mrcp_message_header_t *header, mrcp_header_accessor_t *accessor, apr_pool_t *pool)
+{
+	apt_header_field_t *header_field;
+	apr_size_t offset = 0;
+	apr_size_t id;
+	if(accessor->pending == FALSE || !accessor->vtable) {
+		return TRUE;
+	}
+	accessor->pending = FALSE;
+
+	if(accessor == &header->resource_header_accessor) {
+		offset = GENERIC_HEADER_COUNT;
+	}
+	for(header_field = APR_RING_FIRST(&header->header_section.ring);
+			header_field != APR_RING_SENTINEL(&header->header_section.ring, apt_header_field_t, link);
+				header_field = APR_RING_NEXT(header_field, link)) {
+
+		if(header_field->id < offset || 
+			apt_header_section_field_get(&header->header_section,header_field->id) != header_field) {
+			/* the header field belongs to another accessor or is unknown */
+			continue;
+		}
+		id = header_field->id - offset;
+		if(id >= accessor->vtable->field_count || !header_field->value.length) {
+			continue;
+		}
+
+		if(accessor->vtable->parse_field(accessor,id,&header_field->value,pool) == FALSE) {
+			/* treat the header field as unknown one, as eager parsing does */
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Parse MRCP header field: %s",header_field->name.buf);
+			apt_header_section_field_unset(&header->header_section,header_field);
+		}
+	}
+	return TRUE;
+}
+
 static apt_bool_t mrcp_header_accessor_value_duplicate(mrcp_message_header_t *header, apt_header_field_t *header_field,
 											  const mrcp_message_header_t *src_header, const apt_header_field_t *src_header_field, 
 											  apr_pool_t *pool)
 {
 	apt_bool_t status = FALSE;
+	/* both headers must have been parsed, since values are duplicated by header data */
+	mrcp_header_fields_decode(header,&header->generic_header_accessor,pool);
+	mrcp_header_fields_decode(header,&header->resource_header_accessor,pool);
+	if(src_header->generic_header_accessor.pending == TRUE || src_header->resource_header_accessor.pending == TRUE) {
+		mrcp_message_header_t *parsed_header = (mrcp_message_header_t*)src_header;
+		mrcp_header_fields_decode(parsed_header,&parsed_header->generic_header_accessor,pool);
+		mrcp_header_fields_decode(parsed_header,&parsed_header->resource_header_accessor,pool);
+	}
+
 	if(header_field->id < GENERIC_HEADER_COUNT) {
 		status = mrcp_header_field_value_duplicate(
 			&header->generic_header_accessor,
@@ -130,6 +203,16 @@ static apt_bool_t mrcp_header_accessor_value_duplicate(mrcp_message_header_t *he
 	return status;
 }
 
+/** Allocate header field referring to the name and value of the source one (no copies made) */
+static APR_INLINE apt_header_field_t* mrcp_header_field_refer(mrcp_message_header_t *header, const apt_header_field_t *src_header_field, apr_pool_t *pool)
+{
+	apt_header_field_t *header_field = apt_header_section_field_alloc(&header->header_section,pool);
+	header_field->name = src_header_field->name;
+	header_field->value = src_header_field->value;
+	header_field->id = src_header_field->id;
+	return header_field;
+}
+
 /** Set (copy) MRCP header fields */
 MRCP_DECLARE(apt_bool_t) mrcp_header_fields_set(mrcp_message_header_t *header, const mrcp_message_header_t *src_header, apr_pool_t *pool)
 {
@@ -174,13 +257,13 @@ MRCP_DECLARE(apt_bool_t) mrcp_header_fields_get(mrcp_message_header_t *header, c
 
 		src_header_field = apt_header_section_field_get(&src_header->header_section,mask_header_field->id);
 		if(src_header_field) {
-			/* copy the entire header field */
-			header_field = apt_header_field_copy(src_header_field,pool);
+			/* refer to the entire header field */
+			header_field = mrcp_header_field_refer(header,src_header_field,pool);
 			mrcp_header_accessor_value_duplicate(header,header_field,src_header,src_header_field,pool);
 		}
 		else {
-			/* copy only the name of the header field */
-			header_field = apt_header_field_copy(mask_header_field,pool);
+			/* refer to the header field of the mask */
+			header_field = mrcp_header_field_refer(header,mask_header_field,pool);
 		}
 		/* add the header field to the header section */
 		apt_header_section_field_add(&header->header_section,header_field);
@@ -189,7 +272,7 @@ MRCP_DECLARE(apt_bool_t) mrcp_header_fields_get(mrcp_message_header_t *header, c
 	return TRUE;
 }
 
-/** Inherit (copy) MRCP header fields */
+/** Inherit MRCP header fields (copy-on-write) */
 MRCP_DECLARE(apt_bool_t) mrcp_header_fields_inherit(mrcp_message_header_t *header, const mrcp_message_header_t *src_header, apr_pool_t *pool)
 {
 	apt_header_field_t *header_field;
@@ -204,8 +287,8 @@ MRCP_DECLARE(apt_bool_t) mrcp_header_fields_inherit(mrcp_message_header_t *heade
 			continue;
 		}
 
-		/* copy the entire header field and add it to the header section */
-		header_field = apt_header_field_copy(src_header_field,pool);
+		/* refer to the header field of the source and add it to the header section */
+		header_field = mrcp_header_field_refer(header,src_header_field,pool);
 		mrcp_header_accessor_value_duplicate(header,header_field,src_header,src_header_field,pool);
 		apt_header_section_field_add(&header->header_section,header_field);
 	}
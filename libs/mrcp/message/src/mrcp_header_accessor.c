@@ -19,19 +19,32 @@
 #include "mrcp_header_accessor.h"
 
 
-/** Parse header field value */
-MRCP_DECLARE(apt_bool_t) mrcp_header_field_value_parse(mrcp_header_accessor_t *accessor, apt_header_field_t *header_field, apr_pool_t *pool)
+/** Resolve numeric identifier of header field by its name */
+MRCP_DECLARE(apt_bool_t) mrcp_header_field_name_resolve(const mrcp_header_accessor_t *accessor, apt_header_field_t *header_field)
 {
 	apr_size_t id;
 	if(!accessor->vtable) {
 		return FALSE;
 	}
 
-	id = apt_string_table_id_find(accessor->vtable->field_table,accessor->vtable->field_count,&header_field->name);
+	id = apt_string_table_id_hash_find(
+			accessor->vtable->field_table,
+			accessor->vtable->field_count,
+			accessor->vtable->field_hash,
+			&header_field->name);
 	if(id >= accessor->vtable->field_count) {
 		return FALSE;
 	}
 	header_field->id = id;
+	return TRUE;
+}
+
+/** Parse header field value */
+MRCP_DECLARE(apt_bool_t) mrcp_header_field_value_parse(mrcp_header_accessor_t *accessor, apt_header_field_t *header_field, apr_pool_t *pool)
+{
+	if(mrcp_header_field_name_resolve(accessor,header_field) == FALSE) {
+		return FALSE;
+	}
 
 	if(header_field->value.length) {
 		if(accessor->vtable->parse_field(accessor,header_field->id,&header_field->value,pool) == FALSE) {
@@ -46,13 +59,27 @@ MRCP_DECLARE(apt_bool_t) mrcp_header_field_value_parse(mrcp_header_accessor_t *a
 MRCP_DECLARE(apt_header_field_t*) mrcp_header_field_value_generate(const mrcp_header_accessor_t *accessor, apr_size_t id, apt_bool_t empty_value, apr_pool_t *pool)
 {
 	apt_header_field_t *header_field;
-	const apt_str_t *name;
 
 	if(!accessor->vtable) {
 		return NULL;
 	}
 	
 	header_field = apt_header_field_alloc(pool);
+	if(mrcp_header_field_value_generate2(accessor,id,empty_value,header_field,pool) == FALSE) {
+		return NULL;
+	}
+	return header_field;
+}
+
+/** Generate header field value into already allocated header field */
+MRCP_DECLARE(apt_bool_t) mrcp_header_field_value_generate2(const mrcp_header_accessor_t *accessor, apr_size_t id, apt_bool_t empty_value, apt_header_field_t *header_field, apr_pool_t *pool)
+{
+	const apt_str_t *name;
+
+	if(!accessor->vtable) {
+		return FALSE;
+	}
+	
 	name = apt_string_table_str_get(accessor->vtable->field_table,accessor->vtable->field_count,id);
 	if(name) {
 		header_field->name = *name;
@@ -60,11 +87,11 @@ MRCP_DECLARE(apt_header_field_t*) mrcp_header_field_value_generate(const mrcp_he
 
 	if(empty_value == FALSE) {
 		if(accessor->vtable->generate_field(accessor,id,&header_field->value,pool) == FALSE) {
-			return NULL;
+			return FALSE;
 		}
 	}
 
-	return header_field;
+	return TRUE;
 }
 
 /** Duplicate header field value */
@@ -16,6 +16,7 @@
  * $Id$
  */
 
+#include <string.h>
 #include "mrcp_message.h"
 #include "mrcp_generic_header.h"
 #include "mrcp_resource.h"
@@ -105,7 +106,10 @@ MRCP_DECLARE(mrcp_message_t*) mrcp_message_create(apr_pool_t *pool)
 	mrcp_channel_id_init(&message->channel_id);
 	mrcp_message_header_init(&message->header);
 	apt_string_reset(&message->body);
+	message->body_vec = NULL;
+	message->body_vec_count = 0;
 	message->resource = NULL;
+	message->is_discardable = FALSE;
 	message->pool = pool;
 	return message;
 }
@@ -158,9 +162,40 @@ MRCP_DECLARE(mrcp_message_t*) mrcp_event_create(const mrcp_message_t *request_me
 MRCP_DECLARE(void) mrcp_message_destroy(mrcp_message_t *message)
 {
 	apt_string_reset(&message->body);
+	message->body_vec = NULL;
+	message->body_vec_count = 0;
 	mrcp_message_header_destroy(&message->header);
 }
 
+/** Set the body of MRCP message as vector of segments */
+MRCP_DECLARE(void) mrcp_message_body_vec_set(mrcp_message_t *message, const struct iovec *vec, apr_size_t count)
+{
+	apr_size_t i;
+	message->body_vec = vec;
+	message->body_vec_count = count;
+	message->body.buf = NULL;
+	message->body.length = 0;
+	for(i=0; i<count; i++) {
+		message->body.length += vec[i].iov_len;
+	}
+}
+
+/** Gather the segments of the body into a single buffer */
+MRCP_DECLARE(const apt_str_t*) mrcp_message_body_flatten(mrcp_message_t *message)
+{
+	if(message->body_vec && !message->body.buf) {
+		char *buf = apr_palloc(message->pool,message->body.length + 1);
+		apr_size_t i;
+		message->body.buf = buf;
+		for(i=0; i<message->body_vec_count; i++) {
+			memcpy(buf,message->body_vec[i].iov_base,message->body_vec[i].iov_len);
+			buf += message->body_vec[i].iov_len;
+		}
+		*buf = '\0';
+	}
+	return &message->body;
+}
+
 /** Validate MRCP message */
 MRCP_DECLARE(apt_bool_t) mrcp_message_validate(mrcp_message_t *message)
 {
@@ -180,64 +215,46 @@ MRCP_DECLARE(apt_bool_t) mrcp_message_validate(mrcp_message_t *message)
 	return TRUE;
 }
 
-/** Add MRCP generic header field by specified property (numeric identifier) */
-MRCP_DECLARE(apt_bool_t) mrcp_generic_header_property_add(mrcp_message_t *message, apr_size_t id)
+/** Generate header field by specified property into inline storage of the header section */
+static apt_bool_t mrcp_header_property_add(mrcp_message_t *message, const mrcp_header_accessor_t *accessor, apr_size_t id, apr_size_t offset, apt_bool_t empty_value)
 {
-	apt_header_field_t *header_field = mrcp_header_field_value_generate(
-										&message->header.generic_header_accessor,
-										id,
-										FALSE,
-										message->pool);
-	if(!header_field) {
+	apt_header_section_t *header_section = &message->header.header_section;
+	apt_header_field_t *header_field;
+	if(apt_header_section_field_check(header_section,id + offset) == TRUE) {
+		/* such header field already exists */
 		return FALSE;
 	}
-	header_field->id = id;
-	return apt_header_section_field_add(&message->header.header_section,header_field);
+
+	header_field = apt_header_section_field_alloc(header_section,message->pool);
+	if(mrcp_header_field_value_generate2(accessor,id,empty_value,header_field,message->pool) == FALSE) {
+		return FALSE;
+	}
+	header_field->id = id + offset;
+	return apt_header_section_field_add(header_section,header_field);
+}
+
+/** Add MRCP generic header field by specified property (numeric identifier) */
+MRCP_DECLARE(apt_bool_t) mrcp_generic_header_property_add(mrcp_message_t *message, apr_size_t id)
+{
+	return mrcp_header_property_add(message,&message->header.generic_header_accessor,id,0,FALSE);
 }
 
 /** Add only the name of MRCP generic header field specified by property (numeric identifier) */
 MRCP_DECLARE(apt_bool_t) mrcp_generic_header_name_property_add(mrcp_message_t *message, apr_size_t id)
 {
-	apt_header_field_t *header_field = mrcp_header_field_value_generate(
-										&message->header.generic_header_accessor,
-										id,
-										TRUE,
-										message->pool);
-	if(!header_field) {
-		return FALSE;
-	}
-	header_field->id = id;
-	return apt_header_section_field_add(&message->header.header_section,header_field);
+	return mrcp_header_property_add(message,&message->header.generic_header_accessor,id,0,TRUE);
 }
 
 /** Add MRCP resource header field by specified property (numeric identifier) */
 MRCP_DECLARE(apt_bool_t) mrcp_resource_header_property_add(mrcp_message_t *message, apr_size_t id)
 {
-	apt_header_field_t *header_field = mrcp_header_field_value_generate(
-										&message->header.resource_header_accessor,
-										id,
-										FALSE,
-										message->pool);
-	if(!header_field) {
-		return FALSE;
-	}
-	header_field->id = id + GENERIC_HEADER_COUNT;
-	return apt_header_section_field_add(&message->header.header_section,header_field);
+	return mrcp_header_property_add(message,&message->header.resource_header_accessor,id,GENERIC_HEADER_COUNT,FALSE);
 }
 
 /** Add only the name of MRCP resource header field specified by property (numeric identifier) */
 MRCP_DECLARE(apt_bool_t) mrcp_resource_header_name_property_add(mrcp_message_t *message, apr_size_t id)
 {
-	apt_header_field_t *header_field = mrcp_header_field_value_generate(
-										&message->header.resource_header_accessor,
-										id,
-										TRUE,
-										message->pool);
-	if(!header_field) {
-		return FALSE;
-	}
-	header_field->id = id + GENERIC_HEADER_COUNT;
-	return apt_header_section_field_add(&message->header.header_section,header_field);
+	return mrcp_header_property_add(message,&message->header.resource_header_accessor,id,GENERIC_HEADER_COUNT,TRUE);
 }
 
 /** Get the next MRCP header field */
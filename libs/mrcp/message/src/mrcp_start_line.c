@@ -398,6 +398,71 @@ MRCP_DECLARE(apt_bool_t) mrcp_start_line_generate(mrcp_start_line_t *start_line,
 	return apt_text_eol_insert(text_stream);
 }
 
+/** Compile MRCPv2 start-line of response or event into template */
+MRCP_DECLARE(apt_bool_t) mrcp_start_line_template_compile(mrcp_start_line_template_t *tmpl, const mrcp_start_line_t *start_line, apr_pool_t *pool)
+{
+	apt_text_stream_t stream;
+	apr_size_t size;
+	char *buffer;
+	if(start_line->version != MRCP_VERSION_2 ||
+		(start_line->message_type != MRCP_MESSAGE_TYPE_RESPONSE && start_line->message_type != MRCP_MESSAGE_TYPE_EVENT)) {
+		return FALSE;
+	}
+
+	/* version, message-length, method name, status-code, request-state and separators */
+	size = MRCP_NAME_LENGTH + 4 + MAX_DIGIT_COUNT + 1 + start_line->method_name.length + 32;
+	buffer = apr_palloc(pool,size);
+	apt_text_stream_init(&stream,buffer,size);
+
+	/* head */
+	mrcp_version_generate(start_line->version,&stream);
+	*stream.pos++ = APT_TOKEN_SP;
+	tmpl->length_offset = stream.pos - buffer;
+	memset(stream.pos,APT_TOKEN_SP,MAX_DIGIT_COUNT+1);
+	stream.pos += MAX_DIGIT_COUNT+1;
+	if(start_line->message_type == MRCP_MESSAGE_TYPE_EVENT) {
+		memcpy(stream.pos,start_line->method_name.buf,start_line->method_name.length);
+		stream.pos += start_line->method_name.length;
+		*stream.pos++ = APT_TOKEN_SP;
+	}
+	tmpl->head.buf = buffer;
+	tmpl->head.length = stream.pos - buffer;
+
+	/* tail */
+	tmpl->tail.buf = stream.pos;
+	*stream.pos++ = APT_TOKEN_SP;
+	if(start_line->message_type == MRCP_MESSAGE_TYPE_RESPONSE) {
+		mrcp_status_code_generate(start_line->status_code,&stream);
+		*stream.pos++ = APT_TOKEN_SP;
+	}
+	mrcp_request_state_generate(start_line->request_state,&stream);
+	if(apt_text_eol_insert(&stream) == FALSE) {
+		return FALSE;
+	}
+	tmpl->tail.length = stream.pos - tmpl->tail.buf;
+	return TRUE;
+}
+
+/** Generate MRCPv2 start-line by template */
+MRCP_DECLARE(apt_bool_t) mrcp_start_line_template_generate(const mrcp_start_line_template_t *tmpl, mrcp_start_line_t *start_line, apt_text_stream_t *text_stream)
+{
+	/* request-id takes up to 20 digits */
+	if(text_stream->pos + tmpl->head.length + 20 + tmpl->tail.length >= text_stream->end) {
+		return FALSE;
+	}
+	start_line->length = tmpl->length_offset; /* length is temporary used to store offset */
+	memcpy(text_stream->pos,tmpl->head.buf,tmpl->head.length);
+	text_stream->pos += tmpl->head.length;
+
+	if(mrcp_request_id_generate(start_line->request_id,text_stream) == FALSE) {
+		return FALSE;
+	}
+
+	memcpy(text_stream->pos,tmpl->tail.buf,tmpl->tail.length);
+	text_stream->pos += tmpl->tail.length;
+	return TRUE;
+}
+
 /** Finalize MRCP start-line generation */
 MRCP_DECLARE(apt_bool_t) mrcp_start_line_finalize(mrcp_start_line_t *start_line, apr_size_t content_length, apt_text_stream_t *text_stream)
 {
@@ -430,23 +495,15 @@ MRCP_DECLARE(apt_bool_t) mrcp_start_line_finalize(mrcp_start_line_t *start_line,
 /** Parse MRCP request-id */
 MRCP_DECLARE(mrcp_request_id) mrcp_request_id_parse(const apt_str_t *field)
 {
-	if(field->buf) {
-#ifdef TOO_LONG_MRCP_REQUEST_ID
-		return apr_atoi64(field->buf);
-#else
-		return atol(field->buf);
-#endif
-	}
-	return 0;
+	return (mrcp_request_id)apt_uint64_value_parse(field);
 }
 
 /** Generate MRCP request-id */
 MRCP_DECLARE(apt_bool_t) mrcp_request_id_generate(mrcp_request_id request_id, apt_text_stream_t *stream)
 {
-	int length = apr_snprintf(stream->pos, stream->end - stream->pos, "%"MRCP_REQUEST_ID_FMT, request_id);
-	if(length <= 0) {
+	if(stream->pos + APT_UINT64_VALUE_MAX_LENGTH >= stream->end) {
 		return FALSE;
 	}
-	stream->pos += length;
+	stream->pos += apt_uint64_value_format(request_id,stream->pos);
 	return TRUE;
 }
@@ -67,6 +67,20 @@ static const apt_str_table_item_t v1_recog_header_string_table[] = {
 	{{"Abort-Phrase-Enrollment",          23},0}
 };
 
+/** Perfect hash of v1_recog_header_string_table (generated by strtablegen) */
+static const apr_byte_t v1_recog_header_string_table_hash_slots[128] = {
+	0,0,39,14,0,7,27,29,0,0,0,0,25,0,45,0,
+	5,0,0,0,0,0,0,43,0,0,0,0,0,0,0,6,
+	19,0,0,0,15,0,21,0,0,16,0,0,12,0,0,0,
+	0,0,23,0,18,10,0,0,0,0,28,0,0,4,0,17,
+	26,20,0,31,0,0,8,0,36,0,38,40,0,13,0,42,
+	0,0,0,0,3,32,0,0,24,0,1,0,0,0,0,30,
+	41,0,0,0,0,0,22,0,0,44,0,0,0,0,0,33,
+	11,2,0,35,34,0,0,37,9,0,0,0,0,0,0,0
+};
+
+static const apt_str_table_hash_t v1_recog_header_string_table_hash = {14549,127,v1_recog_header_string_table_hash_slots};
+
 /** String table of MRCPv2 recognizer header fields (mrcp_recog_header_id) */
 static const apt_str_table_item_t v2_recog_header_string_table[] = {
 	{{"Confidence-Threshold",             20},16},
@@ -116,6 +130,20 @@ static const apt_str_table_item_t v2_recog_header_string_table[] = {
 	{{"Abort-Phrase-Enrollment",          23},0}
 };
 
+/** Perfect hash of v2_recog_header_string_table (generated by strtablegen) */
+static const apr_byte_t v2_recog_header_string_table_hash_slots[128] = {
+	23,15,44,0,0,0,0,0,20,0,0,19,0,0,45,0,
+	0,0,0,0,0,0,18,0,38,0,0,37,0,0,0,2,
+	3,0,0,0,5,0,10,0,14,6,0,25,0,31,30,12,
+	0,0,0,35,22,0,0,0,0,0,0,26,34,17,0,0,
+	0,32,9,0,0,0,4,0,0,0,0,0,0,40,11,33,
+	0,43,28,8,16,0,27,0,0,0,24,0,0,0,0,39,
+	0,29,0,0,0,0,21,0,0,0,42,0,0,0,0,7,
+	0,13,1,0,0,0,0,0,0,0,0,36,0,0,41,0
+};
+
+static const apt_str_table_hash_t v2_recog_header_string_table_hash = {14055,127,v2_recog_header_string_table_hash_slots};
+
 /** String table of MRCPv1 recognizer completion-cause fields (mrcp_recog_completion_cause_e) */
 static const apt_str_table_item_t v1_completion_cause_string_table[] = {
 	{{"success",                     7},1},
@@ -749,7 +777,8 @@ static const mrcp_header_vtable_t v1_vtable = {
 	mrcp_v1_recog_header_generate,
 	mrcp_recog_header_duplicate,
 	v1_recog_header_string_table,
-	RECOGNIZER_HEADER_COUNT
+	RECOGNIZER_HEADER_COUNT,
+	&v1_recog_header_string_table_hash
 };
 
 static const mrcp_header_vtable_t v2_vtable = {
@@ -759,7 +788,8 @@ static const mrcp_header_vtable_t v2_vtable = {
 	mrcp_v2_recog_header_generate,
 	mrcp_recog_header_duplicate,
 	v2_recog_header_string_table,
-	RECOGNIZER_HEADER_COUNT
+	RECOGNIZER_HEADER_COUNT,
+	&v2_recog_header_string_table_hash
 };
 
 const mrcp_header_vtable_t* mrcp_recog_header_vtable_get(mrcp_version_e version)
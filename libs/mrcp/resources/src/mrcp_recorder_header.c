@@ -37,6 +37,14 @@ static const apt_str_table_item_t recorder_header_string_table[] = {
 	{{"New-Audio-Channel",    17},2}
 };
 
+/** Perfect hash of recorder_header_string_table (generated by strtablegen) */
+static const apr_byte_t recorder_header_string_table_hash_slots[32] = {
+	3,15,13,6,0,11,0,0,10,8,0,0,12,0,0,0,
+	7,0,1,2,0,0,0,0,14,4,5,0,0,0,0,9
+};
+
+static const apt_str_table_hash_t recorder_header_string_table_hash = {3,31,recorder_header_string_table_hash_slots};
+
 /** String table of recorder completion-cause fields (mrcp_recorder_completion_cause_e) */
 static const apt_str_table_item_t completion_cause_string_table[] = {
 	{{"success-silence",  15},8},
@@ -266,7 +274,8 @@ static const mrcp_header_vtable_t vtable = {
 	mrcp_recorder_header_generate,
 	mrcp_recorder_header_duplicate,
 	recorder_header_string_table,
-	RECORDER_HEADER_COUNT
+	RECORDER_HEADER_COUNT,
+	&recorder_header_string_table_hash
 };
 
 const mrcp_header_vtable_t* mrcp_recorder_header_vtable_get(mrcp_version_e version)
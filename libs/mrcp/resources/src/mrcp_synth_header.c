@@ -43,6 +43,16 @@ static const apt_str_table_item_t synth_header_string_table[] = {
 	{{"Lexicon-Search-Order",20},2}
 };
 
+/** Perfect hash of synth_header_string_table (generated by strtablegen) */
+static const apr_byte_t synth_header_string_table_hash_slots[64] = {
+	3,4,0,0,0,16,0,19,0,0,0,8,0,13,0,0,
+	0,0,0,0,12,0,2,0,0,0,0,0,0,0,0,0,
+	18,10,20,15,0,0,0,0,9,0,11,0,0,0,17,21,
+	1,0,0,0,14,0,0,0,7,5,6,0,0,0,0,0
+};
+
+static const apt_str_table_hash_t synth_header_string_table_hash = {16,63,synth_header_string_table_hash_slots};
+
 /** String table of MRCP speech-unit fields (mrcp_speech_unit_t) */
 static const apt_str_table_item_t speech_unit_string_table[] = {
 	{{"Second",   6},2},
@@ -249,6 +259,7 @@ static apt_bool_t mrcp_speech_length_generate(mrcp_speech_length_value_t *speech
 		}
 	}
 	else {
+		char *pos;
 		const apt_str_t *unit_name = apt_string_table_str_get(
 										speech_unit_string_table,
 										SPEECH_UNIT_COUNT,
@@ -257,11 +268,16 @@ static apt_bool_t mrcp_speech_length_generate(mrcp_speech_length_value_t *speech
 			return FALSE;
 		}
 
-		str->buf = apr_psprintf(pool, "%c%"APR_SIZE_T_FMT" %s",
-						speech_length->type == SPEECH_LENGTH_TYPE_NUMERIC_POSITIVE ? '+' : '-',
-						speech_length->value.numeric.length,
-						unit_name->buf);
-		str->length = strlen(str->buf);
+		/* sign + digits + space + unit */
+		str->buf = apr_palloc(pool,1 + APT_UINT64_VALUE_MAX_LENGTH + 1 + unit_name->length + 1);
+		pos = str->buf;
+		*pos++ = speech_length->type == SPEECH_LENGTH_TYPE_NUMERIC_POSITIVE ? '+' : '-';
+		pos += apt_uint64_value_format(speech_length->value.numeric.length,pos);
+		*pos++ = APT_TOKEN_SP;
+		memcpy(pos,unit_name->buf,unit_name->length);
+		pos += unit_name->length;
+		*pos = '\0';
+		str->length = pos - str->buf;
 	}
 	return TRUE;
 }
@@ -549,7 +565,8 @@ static const mrcp_header_vtable_t vtable = {
 	mrcp_synth_header_generate,
 	mrcp_synth_header_duplicate,
 	synth_header_string_table,
-	SYNTHESIZER_HEADER_COUNT
+	SYNTHESIZER_HEADER_COUNT,
+	&synth_header_string_table_hash
 };
 
 const mrcp_header_vtable_t* mrcp_synth_header_vtable_get(mrcp_version_e version)
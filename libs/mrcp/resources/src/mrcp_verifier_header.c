@@ -43,6 +43,16 @@ static const apt_str_table_item_t verifier_header_string_table[] = {
 	{{"Start-Input-Timers",          18},1}
 };
 
+/** Perfect hash of verifier_header_string_table (generated by strtablegen) */
+static const apr_byte_t verifier_header_string_table_hash_slots[64] = {
+	0,0,0,10,0,0,0,8,0,14,0,0,6,0,12,0,
+	4,15,0,7,18,0,20,0,0,0,0,0,13,0,0,0,
+	0,0,0,0,0,11,0,0,1,9,0,0,21,2,0,0,
+	16,5,0,0,0,0,0,0,0,19,3,0,17,0,0,0
+};
+
+static const apt_str_table_hash_t verifier_header_string_table_hash = {72,63,verifier_header_string_table_hash_slots};
+
 /** String table of MRCP verifier completion-cause fields (mrcp_verifier_completion_cause_e) */
 static const apt_str_table_item_t completion_cause_string_table[] = {
 	{{"success",                 7},2},
@@ -337,7 +347,8 @@ static const mrcp_header_vtable_t header_vtable = {
 	mrcp_verifier_header_generate,
 	mrcp_verifier_header_duplicate,
 	verifier_header_string_table,
-	VERIFIER_HEADER_COUNT
+	VERIFIER_HEADER_COUNT,
+	&verifier_header_string_table_hash
 };
 
 const mrcp_header_vtable_t* mrcp_verifier_header_vtable_get(mrcp_version_e version)
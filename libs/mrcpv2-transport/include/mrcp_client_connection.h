@@ -26,6 +26,7 @@
 
 #include "apt_task.h"
 #include "mrcp_connection_types.h"
+#include "mrcp_tls.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -89,6 +90,16 @@ MRCP_DECLARE(void) mrcp_client_connection_rx_size_set(
 								mrcp_connection_agent_t *agent,
 								apr_size_t size);
 
+/**
+ * Set max size rx buffer grows to.
+ * @param agent the agent to set max buffer size for
+ * @param size the max size of rx buffer, which is grown for big messages and
+ *             shrunk back to rx buffer size at message boundaries
+ */
+MRCP_DECLARE(void) mrcp_client_connection_rx_max_size_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t size);
+
 /**
  * Set tx buffer size.
  * @param agent the agent to set buffer size for
@@ -97,6 +108,35 @@ MRCP_DECLARE(void) mrcp_client_connection_rx_size_set(
 MRCP_DECLARE(void) mrcp_client_connection_tx_size_set(
 								mrcp_connection_agent_t *agent,
 								apr_size_t size);
+
+/**
+ * Set high-water mark of tx pending data.
+ * @param agent the agent to set the limit for
+ * @param size the max amount of data (bytes) queued for a slow peer, above which
+ *             the peer is no longer read until the queue drains (0 - unlimited)
+ */
+MRCP_DECLARE(void) mrcp_client_connection_tx_queue_limit_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t size);
+
+/**
+ * Set TLS context, which makes the agent offer TCP/TLS/MRCPv2 instead of TCP/MRCPv2.
+ * @param agent the agent to set TLS context for
+ * @param tls_context the TLS context created by mrcp_tls_context_create()
+ */
+MRCP_DECLARE(void) mrcp_client_connection_tls_set(
+								mrcp_connection_agent_t *agent,
+								mrcp_tls_context_t *tls_context);
+
+/**
+ * Set path of Unix domain socket, which makes the agent offer UNIX/MRCPv2 instead of TCP/MRCPv2.
+ * @param agent the agent to set the path for
+ * @param path the path of the socket to connect to, unless the server answers with another one
+ * @remark Meant for clients co-located with the server.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_client_connection_unix_path_set(
+								mrcp_connection_agent_t *agent,
+								const char *path);
 /**
  * Set request timeout.
  * @param agent the agent to set timeout for
@@ -106,6 +146,20 @@ MRCP_DECLARE(void) mrcp_client_connection_timeout_set(
 								mrcp_connection_agent_t *agent,
 								apr_size_t timeout);
 
+/**
+ * Set the pool of long-lived connections.
+ * @param agent the agent to set the pool for
+ * @param size the number of connections kept open per server endpoint (0 - no pool)
+ * @param idle_timeout the timeout (msec) to close an unused connection of the pool at (0 - never)
+ * @remark Channels are multiplexed over the connections of the pool, the least loaded
+ *         connection is selected, once there are as many connections as the size of the pool.
+ *         Existing connections are offered to the server, regardless of offer-new-connection.
+ */
+MRCP_DECLARE(void) mrcp_client_connection_pool_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t size,
+								apr_size_t idle_timeout);
+
 /**
  * Get task.
  * @param agent the agent to get task from
@@ -32,11 +32,17 @@
 #include <apr_ring.h>
 #include "mrcp_connection_types.h"
 #include "mrcp_stream.h"
+#include "mrcp_tls.h"
+#include "apt_timer_queue.h"
 
 APT_BEGIN_EXTERN_C
 
 /** Size of the buffer used for MRCP rx/tx stream */
 #define MRCP_STREAM_BUFFER_SIZE 1024
+/** Default max size the rx buffer grows to in order to take big messages with fewer receives */
+#define MRCP_STREAM_BUFFER_MAX_SIZE (64 * 1024)
+/** Default high-water mark of tx pending data of MRCP connection */
+#define MRCP_TX_QUEUE_LIMIT     (1024 * 1024)
 
 /** MRCPv2 connection */
 struct mrcp_connection_t {
@@ -54,6 +60,8 @@ struct mrcp_connection_t {
 	apr_sockaddr_t   *l_sockaddr;
 	/** Remote sockaddr */
 	apr_sockaddr_t   *r_sockaddr;
+	/** TLS session (TCP/TLS/MRCPv2) or NULL */
+	mrcp_tls_t       *tls;
 	/** Remote IP */
 	apt_str_t         remote_ip;
 	/** String identifier used for traces */
@@ -66,14 +74,24 @@ struct mrcp_connection_t {
 	apr_size_t        access_count;
 	/** Opaque agent */
 	void             *agent;
+	/** Connection is kept open in the pool of the agent, even if no channel uses it */
+	apt_bool_t        persistent;
+	/** Timer to close the unused persistent connection at */
+	apt_timer_t      *idle_timer;
 
 	/** Table of control channels */
 	apr_hash_t       *channel_table;
 
 	/** Rx buffer */
 	char             *rx_buffer;
-	/** Rx buffer size */
+	/** Rx buffer size (current) */
 	apr_size_t        rx_buffer_size;
+	/** Base rx buffer of min size (allocated from the pool and reused) */
+	char             *rx_buffer_base;
+	/** Rx buffer size the buffer starts with and shrinks back to */
+	apr_size_t        rx_buffer_min_size;
+	/** Rx buffer size the buffer grows up to (buffers above min size are allocated from the heap) */
+	apr_size_t        rx_buffer_max_size;
 	/** Rx stream */
 	apt_text_stream_t rx_stream;
 	/** MRCP parser to parser MRCP messages out of rx stream */
@@ -85,6 +103,17 @@ struct mrcp_connection_t {
 	apr_size_t        tx_buffer_size;
 	/** MRCP generator to generate MRCP messages into tx stream */
 	mrcp_generator_t *generator;
+
+	/** Data the socket did not accept yet (sent as soon as the socket is writable) */
+	char             *tx_pending;
+	/** Offset of the first byte pending to be sent */
+	apr_size_t        tx_pending_offset;
+	/** Length of the data in tx pending buffer (including offset) */
+	apr_size_t        tx_pending_length;
+	/** Allocated size of tx pending buffer */
+	apr_size_t        tx_pending_size;
+	/** High-water mark of tx pending data, above which the peer is no longer read (0 - unlimited) */
+	apr_size_t        tx_queue_limit;
 };
 
 /** Create MRCP connection. */
@@ -105,6 +134,69 @@ apt_bool_t mrcp_connection_channel_remove(mrcp_connection_t *connection, mrcp_co
 /** Raise disconnect event for each channel from the specified connection. */
 apt_bool_t mrcp_connection_disconnect_raise(mrcp_connection_t *connection, const mrcp_connection_event_vtable_t *vtable);
 
+/**
+ * Send MRCP message through the non-blocking socket of MRCP connection.
+ * @param connection the connection to send message through
+ * @param message the message to send
+ * @param resource_factory the resource factory
+ * @remark The start line and the header section are generated into tx buffer, while the body
+ * is sent by reference in the same scatter/gather call. Whatever the socket does not accept
+ * is copied to tx pending buffer and should be flushed by mrcp_connection_tx_flush() once
+ * the socket becomes writable (see mrcp_connection_tx_is_pending()).
+ * @return FALSE if the message cannot be generated or the socket fails
+ */
+apt_bool_t mrcp_connection_message_send(mrcp_connection_t *connection, mrcp_message_t *message, const mrcp_resource_factory_t *resource_factory);
+
+/**
+ * Send the data pending in tx buffer of MRCP connection (if any).
+ * @return FALSE if the socket fails
+ */
+apt_bool_t mrcp_connection_tx_flush(mrcp_connection_t *connection);
+
+/**
+ * Initialize rx buffer and stream of MRCP connection.
+ * @param connection the connection to initialize rx buffer of
+ * @param min_size the size the buffer starts with and shrinks back to
+ * @param max_size the size the buffer may grow up to
+ */
+void mrcp_connection_rx_buffer_init(mrcp_connection_t *connection, apr_size_t min_size, apr_size_t max_size);
+
+/**
+ * Prepare rx stream of MRCP connection for the next receive, once the received data is parsed.
+ * @param connection the connection to prepare rx stream of
+ * @param boundary TRUE if the parsed data ends at a message boundary (the stream is drained)
+ * @remark If the last receive filled the buffer up, the buffer is doubled (up to max size),
+ * so that the rest of a big message takes fewer receives. At a message boundary, the buffer
+ * shrinks back to min size, so that the memory footprint of idle connections stays small.
+ */
+void mrcp_connection_rx_stream_adjust(mrcp_connection_t *connection, apt_bool_t boundary);
+
+/**
+ * Receive data through the non-blocking socket of MRCP connection.
+ * @remark Data is decrypted, if the connection is secured by TLS.
+ * @return APR_SUCCESS, APR_EAGAIN if no data is available yet or APR_EOF
+ */
+apr_status_t mrcp_connection_recv(mrcp_connection_t *connection, char *buf, apr_size_t *len);
+
+/** Check whether received data is buffered (by TLS layer) and the socket will not signal it */
+static APR_INLINE apt_bool_t mrcp_connection_rx_is_pending(const mrcp_connection_t *connection)
+{
+	return connection->tls ? mrcp_tls_rx_is_pending(connection->tls) : FALSE;
+}
+
+/** Check whether there is data pending to be sent through MRCP connection */
+static APR_INLINE apt_bool_t mrcp_connection_tx_is_pending(const mrcp_connection_t *connection)
+{
+	return connection->tx_pending_offset < connection->tx_pending_length ? TRUE : FALSE;
+}
+
+/** Check whether tx pending data of MRCP connection has reached the high-water mark */
+static APR_INLINE apt_bool_t mrcp_connection_tx_is_congested(const mrcp_connection_t *connection)
+{
+	return connection->tx_queue_limit &&
+		connection->tx_pending_length - connection->tx_pending_offset >= connection->tx_queue_limit ? TRUE : FALSE;
+}
+
 APT_END_EXTERN_C
 
 #endif /* MRCP_CONNECTION_H */
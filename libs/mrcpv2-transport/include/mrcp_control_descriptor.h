@@ -38,6 +38,7 @@ APT_BEGIN_EXTERN_C
 typedef enum {
 	MRCP_PROTO_TCP,
 	MRCP_PROTO_TLS,
+	MRCP_PROTO_UNIX,
 
 	MRCP_PROTO_COUNT,
 	MRCP_PROTO_UNKNOWN = MRCP_PROTO_COUNT
@@ -51,6 +52,7 @@ typedef enum {
 	MRCP_ATTRIB_RESOURCE,
 	MRCP_ATTRIB_CHANNEL,
 	MRCP_ATTRIB_CMID,
+	MRCP_ATTRIB_UNIX_PATH,
 
 	MRCP_ATTRIB_COUNT,
 	MRCP_ATTRIB_UNKNOWN = MRCP_ATTRIB_COUNT
@@ -82,6 +84,8 @@ struct mrcp_control_descriptor_t {
 	apt_str_t              ip;
 	/** Port */
 	apr_port_t             port;
+	/** Path of Unix domain socket (UNIX/MRCPv2) */
+	apt_str_t              path;
 	/** Protocol type */
 	mrcp_proto_type_e      proto;
 	/** Setup type */
@@ -26,6 +26,7 @@
 
 #include "apt_task.h"
 #include "mrcp_connection_types.h"
+#include "mrcp_tls.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -64,6 +65,23 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_connection_agent_start(mrcp_connection_agen
  */
 MRCP_DECLARE(apt_bool_t) mrcp_server_connection_agent_terminate(mrcp_connection_agent_t *agent);
 
+/**
+ * Set number of connection agent workers.
+ * @param agent the agent to set the number of workers for
+ * @param worker_count the number of workers (threads), each having its own pollset and
+ *                     listening socket bound to the same address using SO_REUSEPORT
+ * @remark Workers can only be added before the agent is started.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_connection_worker_count_set(mrcp_connection_agent_t *agent, apr_size_t worker_count);
+
+/**
+ * Bind connection agent workers to the set of CPUs (e.g. of the NUMA node the NIC is attached to).
+ * @param agent the agent to bind
+ * @param cpu_set the set of CPUs to bind all the workers to (NULL - no binding)
+ * @remark Must be set before the agent is started.
+ */
+MRCP_DECLARE(void) mrcp_server_connection_cpu_set_set(mrcp_connection_agent_t *agent, const apt_cpu_set_t *cpu_set);
+
 /**
  * Set connection event handler.
  * @param agent the agent to set event hadler for
@@ -93,6 +111,16 @@ MRCP_DECLARE(void) mrcp_server_connection_rx_size_set(
 								mrcp_connection_agent_t *agent,
 								apr_size_t size);
 
+/**
+ * Set max size rx buffer grows to.
+ * @param agent the agent to set max buffer size for
+ * @param size the max size of rx buffer, which is grown for big messages and
+ *             shrunk back to rx buffer size at message boundaries
+ */
+MRCP_DECLARE(void) mrcp_server_connection_rx_max_size_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t size);
+
 /**
  * Set tx buffer size.
  * @param agent the agent to set buffer size for
@@ -102,6 +130,66 @@ MRCP_DECLARE(void) mrcp_server_connection_tx_size_set(
 								mrcp_connection_agent_t *agent,
 								apr_size_t size);
 
+/**
+ * Set high-water mark of tx pending data.
+ * @param agent the agent to set the limit for
+ * @param size the max amount of data (bytes) queued for a slow peer, above which
+ *             the peer is no longer read until the queue drains (0 - unlimited)
+ */
+MRCP_DECLARE(void) mrcp_server_connection_tx_queue_limit_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t size);
+
+/**
+ * Defer accepting connections until the first data arrives (TCP_DEFER_ACCEPT).
+ * @param agent the agent to set the timeout for
+ * @param timeout the time in seconds the kernel waits for the first data of a connection within
+ * @remark Supported on Linux only, not applied to UNIX/MRCPv2. Clients, which connect
+ *         ahead of time and send nothing until a request, are accepted after the timeout.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_connection_defer_accept_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t timeout);
+
+/**
+ * Co-locate the processing of messages of another task with the poller of the agent.
+ * @param agent the agent to co-locate the task with
+ * @param task the task, which messages forwarded to the agent are processed by
+ *        the process_msg method of, on the poller thread (NULL - none)
+ * @remark Requires a single worker of the agent. The messages forwarded are told
+ *         from the ones of the agent by the pool they are allocated from.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_connection_colocated_task_set(
+								mrcp_connection_agent_t *agent,
+								apt_task_t *task);
+
+/**
+ * Get the task co-located with the poller of the agent.
+ * @param agent the agent to get the task of
+ * @return NULL if none
+ */
+MRCP_DECLARE(apt_task_t*) mrcp_server_connection_colocated_task_get(const mrcp_connection_agent_t *agent);
+
+/**
+ * Set TLS context, which makes the agent serve TCP/TLS/MRCPv2 instead of TCP/MRCPv2.
+ * @param agent the agent to set TLS context for
+ * @param tls_context the TLS context created by mrcp_tls_context_create()
+ */
+MRCP_DECLARE(void) mrcp_server_connection_tls_set(
+								mrcp_connection_agent_t *agent,
+								mrcp_tls_context_t *tls_context);
+
+/**
+ * Set path of Unix domain socket, which makes the agent serve UNIX/MRCPv2 instead of TCP/MRCPv2.
+ * @param agent the agent to set the path for
+ * @param path the path of the socket the agent listens on instead of the TCP port
+ * @remark Meant for clients co-located with the server. The socket is accepted
+ *         by the first worker only, as it can not be shared by SO_REUSEPORT.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_connection_unix_path_set(
+								mrcp_connection_agent_t *agent,
+								const char *path);
+
 /**
  * Get task.
  * @param agent the agent to get task from
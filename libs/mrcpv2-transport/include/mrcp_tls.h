@@ -0,0 +1,114 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MRCP_TLS_H
+#define MRCP_TLS_H
+
+/**
+ * @file mrcp_tls.h
+ * @brief TLS Layer of MRCPv2 Connection (TCP/TLS/MRCPv2)
+ */
+
+#include <apr_network_io.h>
+#define APR_WANT_IOVEC
+#include <apr_want.h>
+#include "mrcp_connection_types.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Opaque TLS context declaration (certificates and session cache shared by connections) */
+typedef struct mrcp_tls_context_t mrcp_tls_context_t;
+
+/** Opaque TLS session declaration (TLS layer of a single connection) */
+typedef struct mrcp_tls_t mrcp_tls_t;
+
+/** Status of TLS handshake */
+typedef enum {
+	MRCP_TLS_STATUS_DONE,       /**< handshake is complete, application data can be exchanged */
+	MRCP_TLS_STATUS_WANT_READ,  /**< handshake is in progress, the socket must become readable */
+	MRCP_TLS_STATUS_WANT_WRITE, /**< handshake is in progress, the socket must become writable */
+	MRCP_TLS_STATUS_FAILED      /**< handshake failed */
+} mrcp_tls_status_e;
+
+/** Check whether TLS is supported (UniMRCP is built with OpenSSL) */
+MRCP_DECLARE(apt_bool_t) mrcp_tls_is_available(void);
+
+/**
+ * Create TLS context.
+ * @param server TRUE for the server side, FALSE for the client one
+ * @param cert_file the certificate chain file (PEM), mandatory for the server side
+ * @param key_file the private key file (PEM), mandatory for the server side
+ * @param ca_file the file of trusted CA certificates (PEM); if set, the peer is verified
+ * @param pool the pool to allocate memory from
+ * @remark Kernel TLS offload is enabled if supported by OpenSSL and the kernel,
+ * so that once the handshake is complete, records are encrypted by the kernel and
+ * messages are still sent from the tx buffer and the message body by reference.
+ * Session resumption is enabled (server side session cache and tickets, client side
+ * cache of the last session per peer).
+ */
+MRCP_DECLARE(mrcp_tls_context_t*) mrcp_tls_context_create(
+								apt_bool_t server,
+								const char *cert_file,
+								const char *key_file,
+								const char *ca_file,
+								apr_pool_t *pool);
+
+/** Destroy TLS context */
+MRCP_DECLARE(void) mrcp_tls_context_destroy(mrcp_tls_context_t *context);
+
+/**
+ * Create TLS session on the connected/accepted socket.
+ * @param context the TLS context
+ * @param sock the socket
+ * @param peer_id the identifier of the peer (remote address), which the client side
+ *                caches the session by to resume it on reconnect
+ * @param pool the pool to allocate memory from
+ */
+MRCP_DECLARE(mrcp_tls_t*) mrcp_tls_create(mrcp_tls_context_t *context, apr_socket_t *sock, const char *peer_id, apr_pool_t *pool);
+
+/** Destroy TLS session */
+MRCP_DECLARE(void) mrcp_tls_destroy(mrcp_tls_t *tls);
+
+/**
+ * Proceed with TLS handshake.
+ * @remark On a blocking socket, the handshake completes or fails within a single call.
+ */
+MRCP_DECLARE(mrcp_tls_status_e) mrcp_tls_handshake(mrcp_tls_t *tls);
+
+/** Get the status of TLS handshake */
+MRCP_DECLARE(mrcp_tls_status_e) mrcp_tls_status_get(const mrcp_tls_t *tls);
+
+/**
+ * Receive application data.
+ * @return APR_SUCCESS, APR_EAGAIN if no data is available yet or APR_EOF
+ */
+MRCP_DECLARE(apr_status_t) mrcp_tls_recv(mrcp_tls_t *tls, char *buf, apr_size_t *len);
+
+/** Check whether received application data is pending to be read (not signalled by the socket) */
+MRCP_DECLARE(apt_bool_t) mrcp_tls_rx_is_pending(const mrcp_tls_t *tls);
+
+/**
+ * Send vector of application data.
+ * @remark With kernel TLS offload the vector is passed to the socket as is.
+ * @return APR_SUCCESS (len is set to the number of bytes sent) or APR_EAGAIN
+ */
+MRCP_DECLARE(apr_status_t) mrcp_tls_sendv(mrcp_tls_t *tls, const struct iovec *vec, apr_int32_t nvec, apr_size_t *len);
+
+APT_END_EXTERN_C
+
+#endif /* MRCP_TLS_H */
@@ -17,14 +17,15 @@
  */
 
 #include <apr_tables.h>
+#include <apr_atomic.h>
 #include "mrcp_ca_factory.h"
 
 /** Factory of MRCPv2 connection agents */
 struct mrcp_ca_factory_t {
 	/** Array of pointers to agents */
 	apr_array_header_t   *agent_arr;
-	/** Index of the current agent */
-	int                   index;
+	/** Index of the current agent (atomic, may grow beyond the number of agents) */
+	volatile apr_uint32_t index;
 };
 
 /** Create factory of connection agents. */
@@ -57,9 +58,7 @@ MRCP_DECLARE(apt_bool_t) mrcp_ca_factory_is_empty(const mrcp_ca_factory_t *facto
 /** Select next available agent. */
 MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_ca_factory_agent_select(mrcp_ca_factory_t *factory)
 {
-	mrcp_connection_agent_t *agent = APR_ARRAY_IDX(factory->agent_arr, factory->index, mrcp_connection_agent_t*);
-	if(++factory->index == factory->agent_arr->nelts) {
-		factory->index = 0;
-	}
-	return agent;
+	/* the selection may be requested by several client workers at once */
+	apr_uint32_t index = apr_atomic_inc32(&factory->index);
+	return APR_ARRAY_IDX(factory->agent_arr, index % factory->agent_arr->nelts, mrcp_connection_agent_t*);
 }
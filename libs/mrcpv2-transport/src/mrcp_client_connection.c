@@ -36,8 +36,18 @@ struct mrcp_connection_agent_t {
 
 	apr_uint32_t                          request_timeout;
 	apt_bool_t                            offer_new_connection;
+	/** Number of long-lived connections kept per server endpoint (0 - no pool) */
+	apr_size_t                            pool_size;
+	/** Timeout to close unused connections of the pool at (msec) */
+	apr_uint32_t                          idle_timeout;
 	apr_size_t                            tx_buffer_size;
+	apr_size_t                            tx_queue_limit;
 	apr_size_t                            rx_buffer_size;
+	apr_size_t                            rx_buffer_max_size;
+	/** TLS context (TCP/TLS/MRCPv2) or NULL (TCP/MRCPv2) */
+	mrcp_tls_context_t                   *tls_context;
+	/** Path of Unix domain socket (UNIX/MRCPv2) or NULL */
+	const char                           *unix_path;
 
 	void                                 *obj;
 	const mrcp_connection_event_vtable_t *vtable;
@@ -63,6 +73,8 @@ struct connection_task_msg_t {
 static apt_bool_t mrcp_client_agent_msg_process(apt_task_t *task, apt_task_msg_t *task_msg);
 static apt_bool_t mrcp_client_poller_signal_process(void *obj, const apr_pollfd_t *descriptor);
 static void mrcp_client_timer_proc(apt_timer_t *timer, void *obj);
+static void mrcp_client_idle_timer_proc(apt_timer_t *timer, void *obj);
+static void mrcp_client_agent_connection_close(mrcp_connection_agent_t *agent, mrcp_connection_t *connection);
 
 /** Create connection agent. */
 MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_client_connection_agent_create(
@@ -82,8 +94,14 @@ MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_client_connection_agent_create(
 	agent->pool = pool;
 	agent->request_timeout = 0;
 	agent->offer_new_connection = offer_new_connection;
+	agent->pool_size = 0;
+	agent->idle_timeout = 0;
 	agent->rx_buffer_size = MRCP_STREAM_BUFFER_SIZE;
+	agent->rx_buffer_max_size = MRCP_STREAM_BUFFER_MAX_SIZE;
 	agent->tx_buffer_size = MRCP_STREAM_BUFFER_SIZE;
+	agent->tx_queue_limit = MRCP_TX_QUEUE_LIMIT;
+	agent->tls_context = NULL;
+	agent->unix_path = NULL;
 
 	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(connection_task_msg_t),pool);
 
@@ -114,8 +132,20 @@ MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_client_connection_agent_create(
 /** Destroy connection agent. */
 MRCP_DECLARE(apt_bool_t) mrcp_client_connection_agent_destroy(mrcp_connection_agent_t *agent)
 {
+	mrcp_connection_t *connection;
+	mrcp_connection_t *next;
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Destroy MRCPv2 Agent [%s]",
 		mrcp_client_connection_agent_id_get(agent));
+
+	/* close the connections left open in the pool */
+	for(connection = APR_RING_FIRST(&agent->connection_list);
+			connection != APR_RING_SENTINEL(&agent->connection_list, mrcp_connection_t, link);
+				connection = next) {
+		next = APR_RING_NEXT(connection, link);
+		if(!connection->access_count) {
+			mrcp_client_agent_connection_close(agent,connection);
+		}
+	}
 	return apt_poller_task_destroy(agent->task);
 }
 
@@ -160,6 +190,14 @@ MRCP_DECLARE(void) mrcp_client_connection_rx_size_set(
 	agent->rx_buffer_size = size;
 }
 
+/** Set max size rx buffer grows to */
+MRCP_DECLARE(void) mrcp_client_connection_rx_max_size_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t size)
+{
+	agent->rx_buffer_max_size = size;
+}
+
 /** Set tx buffer size */
 MRCP_DECLARE(void) mrcp_client_connection_tx_size_set(
 								mrcp_connection_agent_t *agent,
@@ -171,6 +209,60 @@ MRCP_DECLARE(void) mrcp_client_connection_tx_size_set(
 	agent->tx_buffer_size = size;
 }
 
+/** Set high-water mark of tx pending data */
+MRCP_DECLARE(void) mrcp_client_connection_tx_queue_limit_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t size)
+{
+	agent->tx_queue_limit = size;
+}
+
+/** Set TLS context */
+MRCP_DECLARE(void) mrcp_client_connection_tls_set(
+								mrcp_connection_agent_t *agent,
+								mrcp_tls_context_t *tls_context)
+{
+	agent->tls_context = tls_context;
+}
+
+/** Set path of Unix domain socket */
+MRCP_DECLARE(apt_bool_t) mrcp_client_connection_unix_path_set(
+								mrcp_connection_agent_t *agent,
+								const char *path)
+{
+#ifdef APR_UNIX
+	if(!path || *path == '\0') {
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Set UNIX/MRCPv2 Path [%s] %s",
+		apt_task_name_get(apt_poller_task_base_get(agent->task)),path);
+	agent->unix_path = apr_pstrdup(agent->pool,path);
+	return TRUE;
+#else
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"UNIX/MRCPv2 is not supported");
+	return FALSE;
+#endif
+}
+
+/** Get path of Unix domain socket to connect to, the one of the answer takes precedence */
+static const char* mrcp_client_agent_unix_path_get(const mrcp_connection_agent_t *agent, const mrcp_control_descriptor_t *descriptor)
+{
+	if(descriptor->path.length) {
+		return descriptor->path.buf;
+	}
+	return agent->unix_path;
+}
+
+/** Set the pool of long-lived connections */
+MRCP_DECLARE(void) mrcp_client_connection_pool_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t size,
+								apr_size_t idle_timeout)
+{
+	agent->pool_size = size;
+	agent->idle_timeout = (apr_uint32_t)idle_timeout;
+}
+
 /** Set request timeout */
 MRCP_DECLARE(void) mrcp_client_connection_timeout_set(
 								mrcp_connection_agent_t *agent,
@@ -288,15 +380,29 @@ static mrcp_connection_t* mrcp_client_agent_connection_create(mrcp_connection_ag
 {
 	char *local_ip = NULL;
 	char *remote_ip = NULL;
+	const char *unix_path = NULL;
+	int protocol = APR_PROTO_TCP;
 	mrcp_connection_t *connection = mrcp_connection_create();
 
-	apr_sockaddr_info_get(&connection->r_sockaddr,descriptor->ip.buf,APR_INET,descriptor->port,0,connection->pool);
+	if(descriptor->proto == MRCP_PROTO_UNIX) {
+		unix_path = mrcp_client_agent_unix_path_get(agent,descriptor);
+#ifdef APR_UNIX
+		if(unix_path) {
+			apr_sockaddr_info_get(&connection->r_sockaddr,unix_path,APR_UNIX,0,0,connection->pool);
+		}
+#endif
+		/* no transport protocol is specified for Unix domain socket */
+		protocol = 0;
+	}
+	else {
+		apr_sockaddr_info_get(&connection->r_sockaddr,descriptor->ip.buf,APR_INET,descriptor->port,0,connection->pool);
+	}
 	if(!connection->r_sockaddr) {
 		mrcp_connection_destroy(connection);
 		return NULL;
 	}
 
-	if(apr_socket_create(&connection->sock,connection->r_sockaddr->family,SOCK_STREAM,APR_PROTO_TCP,connection->pool) != APR_SUCCESS) {
+	if(apr_socket_create(&connection->sock,connection->r_sockaddr->family,SOCK_STREAM,protocol,connection->pool) != APR_SUCCESS) {
 		mrcp_connection_destroy(connection);
 		return NULL;
 	}
@@ -317,11 +423,42 @@ static mrcp_connection_t* mrcp_client_agent_connection_create(mrcp_connection_ag
 		return NULL;
 	}
 
-	apr_sockaddr_ip_get(&local_ip,connection->l_sockaddr);
-	apr_sockaddr_ip_get(&remote_ip,connection->r_sockaddr);
-	connection->id = apr_psprintf(connection->pool,"%s:%hu <-> %s:%hu",
-		local_ip,connection->l_sockaddr->port,
-		remote_ip,connection->r_sockaddr->port);
+	if(unix_path) {
+		/* the connections are found by the path they are established to */
+		apt_string_assign(&connection->remote_ip,unix_path,connection->pool);
+		connection->id = apr_psprintf(connection->pool,"unix:%s",unix_path);
+	}
+	else {
+		apr_sockaddr_ip_get(&local_ip,connection->l_sockaddr);
+		apr_sockaddr_ip_get(&remote_ip,connection->r_sockaddr);
+		connection->id = apr_psprintf(connection->pool,"%s:%hu <-> %s:%hu",
+			local_ip,connection->l_sockaddr->port,
+			remote_ip,connection->r_sockaddr->port);
+	}
+
+	if(descriptor->proto == MRCP_PROTO_TLS) {
+		const char *peer_id;
+		if(!agent->tls_context) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No TLS Context Configured for TCP/TLS/MRCPv2 %s",connection->id);
+			apr_socket_close(connection->sock);
+			mrcp_connection_destroy(connection);
+			return NULL;
+		}
+		/* the session is cached by the remote address to be resumed on reconnect */
+		peer_id = apr_psprintf(connection->pool,"%s:%hu",remote_ip,connection->r_sockaddr->port);
+		connection->tls = mrcp_tls_create(agent->tls_context,connection->sock,peer_id,connection->pool);
+		/* the handshake blocks the same way the connect does */
+		if(!connection->tls || mrcp_tls_handshake(connection->tls) != MRCP_TLS_STATUS_DONE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Establish TLS Session %s",connection->id);
+			apr_socket_close(connection->sock);
+			mrcp_connection_destroy(connection);
+			return NULL;
+		}
+	}
+
+	/* messages are sent without blocking, the data the socket does not accept is queued */
+	apr_socket_opt_set(connection->sock, APR_SO_NONBLOCK, 1);
+	apr_socket_timeout_set(connection->sock, 0);
 
 	memset(&connection->sock_pfd,0,sizeof(apr_pollfd_t));
 	connection->sock_pfd.desc_type = APR_POLL_SOCKET;
@@ -344,10 +481,9 @@ static mrcp_connection_t* mrcp_client_agent_connection_create(mrcp_connection_ag
 
 	connection->tx_buffer_size = agent->tx_buffer_size;
 	connection->tx_buffer = apr_palloc(connection->pool,connection->tx_buffer_size+1);
+	connection->tx_queue_limit = agent->tx_queue_limit;
 
-	connection->rx_buffer_size = agent->rx_buffer_size;
-	connection->rx_buffer = apr_palloc(connection->pool,connection->rx_buffer_size+1);
-	apt_text_stream_init(&connection->rx_stream,connection->rx_buffer,connection->rx_buffer_size);
+	mrcp_connection_rx_buffer_init(connection,agent->rx_buffer_size,agent->rx_buffer_max_size);
 
 	if(apt_log_masking_get() != APT_LOG_MASKING_NONE) {
 		connection->verbose = FALSE;
@@ -358,23 +494,46 @@ static mrcp_connection_t* mrcp_client_agent_connection_create(mrcp_connection_ag
 	return connection;
 }
 
-static mrcp_connection_t* mrcp_client_agent_connection_find(mrcp_connection_agent_t *agent, mrcp_control_descriptor_t *descriptor)
+static mrcp_connection_t* mrcp_client_agent_connection_find(mrcp_connection_agent_t *agent, mrcp_control_descriptor_t *descriptor, apr_size_t *count, apr_pool_t *pool)
 {
-	apr_sockaddr_t *sockaddr;
+	apr_sockaddr_t *sockaddr = NULL;
 	mrcp_connection_t *connection;
+	mrcp_connection_t *least_loaded = NULL;
+	apt_str_t unix_path;
+
+	*count = 0;
+	apt_string_reset(&unix_path);
+	if(descriptor->proto == MRCP_PROTO_UNIX) {
+		apt_string_set(&unix_path,mrcp_client_agent_unix_path_get(agent,descriptor));
+		if(!unix_path.length) {
+			return NULL;
+		}
+	}
+	/* the address is resolved in the pool of the channel, as connections may live long */
+	else if(apr_sockaddr_info_get(&sockaddr,descriptor->ip.buf,APR_INET,descriptor->port,0,pool) != APR_SUCCESS) {
+		return NULL;
+	}
 
+	/* find the least loaded of the connections established to the endpoint */
 	for(connection = APR_RING_FIRST(&agent->connection_list);
 			connection != APR_RING_SENTINEL(&agent->connection_list, mrcp_connection_t, link);
 				connection = APR_RING_NEXT(connection, link)) {
-		if(apr_sockaddr_info_get(&sockaddr,descriptor->ip.buf,APR_INET,descriptor->port,0,connection->pool) == APR_SUCCESS) {
-			if(apr_sockaddr_equal(sockaddr,connection->r_sockaddr) != 0 && 
-				descriptor->port == connection->r_sockaddr->port) {
-				return connection;
+		if(!connection->sock) {
+			continue;
+		}
+		if(sockaddr ?
+			(!connection->remote_ip.length &&
+			apr_sockaddr_equal(sockaddr,connection->r_sockaddr) != 0 &&
+			descriptor->port == connection->r_sockaddr->port) :
+			apt_string_compare(&unix_path,&connection->remote_ip) == TRUE) {
+			(*count)++;
+			if(!least_loaded || connection->access_count < least_loaded->access_count) {
+				least_loaded = connection;
 			}
 		}
 	}
 
-	return NULL;
+	return least_loaded;
 }
 
 static apt_bool_t mrcp_client_agent_connection_remove(mrcp_connection_agent_t *agent, mrcp_connection_t *connection)
@@ -391,9 +550,20 @@ static apt_bool_t mrcp_client_agent_connection_remove(mrcp_connection_agent_t *a
 	return TRUE;
 }
 
+/** Close the connection no channel uses any longer */
+static void mrcp_client_agent_connection_close(mrcp_connection_agent_t *agent, mrcp_connection_t *connection)
+{
+	if(connection->idle_timer) {
+		apt_timer_kill(connection->idle_timer);
+	}
+	mrcp_client_agent_connection_remove(agent,connection);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Destroy TCP/MRCPv2 Connection %s",connection->id);
+	mrcp_connection_destroy(connection);
+}
+
 static apt_bool_t mrcp_client_agent_channel_add(mrcp_connection_agent_t *agent, mrcp_control_channel_t *channel, mrcp_control_descriptor_t *descriptor)
 {
-	if(agent->offer_new_connection == TRUE) {
+	if(agent->offer_new_connection == TRUE && !agent->pool_size) {
 		descriptor->connection_type = MRCP_CONNECTION_TYPE_NEW;
 	}
 	else {
@@ -403,6 +573,12 @@ static apt_bool_t mrcp_client_agent_channel_add(mrcp_connection_agent_t *agent,
 			descriptor->connection_type = MRCP_CONNECTION_TYPE_NEW;
 		}
 	}
+	if(agent->unix_path) {
+		descriptor->proto = MRCP_PROTO_UNIX;
+	}
+	else {
+		descriptor->proto = agent->tls_context ? MRCP_PROTO_TLS : MRCP_PROTO_TCP;
+	}
 	/* send response */
 	return mrcp_control_channel_add_respond(agent->vtable,channel,descriptor,TRUE);
 }
@@ -413,11 +589,20 @@ static apt_bool_t mrcp_client_agent_channel_modify(mrcp_connection_agent_t *agen
 	if(descriptor->port) {
 		if(!channel->connection) {
 			mrcp_connection_t *connection = NULL;
+			apr_size_t count = 0;
 			apt_id_resource_generate(&descriptor->session_id,&descriptor->resource_name,'@',&channel->identifier,channel->pool);
 			/* no connection yet */
-			if(descriptor->connection_type == MRCP_CONNECTION_TYPE_EXISTING) {
+			if(agent->pool_size) {
+				connection = mrcp_client_agent_connection_find(agent,descriptor,&count,channel->pool);
+				/* fill the pool up, before channels are multiplexed over the connections in use */
+				if(descriptor->connection_type == MRCP_CONNECTION_TYPE_NEW ||
+					(connection && connection->access_count && count < agent->pool_size)) {
+					connection = NULL;
+				}
+			}
+			else if(descriptor->connection_type == MRCP_CONNECTION_TYPE_EXISTING) {
 				/* try to find existing connection */
-				connection = mrcp_client_agent_connection_find(agent,descriptor);
+				connection = mrcp_client_agent_connection_find(agent,descriptor,&count,channel->pool);
 				if(!connection) {
 					apt_obj_log(APT_LOG_MARK,APT_PRIO_WARNING,channel->log_obj,"Found No Existing TCP/MRCPv2 Connection");
 				}
@@ -428,6 +613,13 @@ static apt_bool_t mrcp_client_agent_channel_modify(mrcp_connection_agent_t *agen
 				if(!connection) {
 					apt_obj_log(APT_LOG_MARK,APT_PRIO_WARNING,channel->log_obj,"Failed to Establish TCP/MRCPv2 Connection");
 				}
+				else if(count < agent->pool_size) {
+					connection->persistent = TRUE;
+				}
+			}
+			else if(connection->idle_timer) {
+				/* the unused connection of the pool is taken again */
+				apt_timer_kill(connection->idle_timer);
 			}
 
 			if(connection) {
@@ -460,10 +652,27 @@ static apt_bool_t mrcp_client_agent_channel_remove(mrcp_connection_agent_t *agen
 				channel->identifier.buf,
 				apr_hash_count(connection->channel_table));
 		if(!connection->access_count) {
-			mrcp_client_agent_connection_remove(agent,connection);
-			/* set connection to be destroyed on channel destroy */
-			channel->connection = connection;
-			channel->removed = TRUE;
+			if(connection->persistent == TRUE && connection->sock) {
+				/* keep the connection open in the pool for the next channels */
+				if(agent->idle_timeout) {
+					if(!connection->idle_timer) {
+						connection->idle_timer = apt_poller_task_timer_create(
+													agent->task,
+													mrcp_client_idle_timer_proc,
+													connection,
+													connection->pool);
+					}
+					if(connection->idle_timer) {
+						apt_timer_set(connection->idle_timer,agent->idle_timeout);
+					}
+				}
+			}
+			else {
+				mrcp_client_agent_connection_remove(agent,connection);
+				/* set connection to be destroyed on channel destroy */
+				channel->connection = connection;
+				channel->removed = TRUE;
+			}
 		}
 	}
 	
@@ -507,12 +716,44 @@ static apt_bool_t mrcp_client_agent_disconnect_raise(mrcp_connection_agent_t *ag
 	return TRUE;
 }
 
+/** Poll the socket of the connection for writability while tx data is pending and stop
+    reading the peer while tx pending data is above the high-water mark */
+static apt_bool_t mrcp_client_agent_connection_pollout_set(mrcp_connection_agent_t *agent, mrcp_connection_t *connection)
+{
+	apr_int16_t reqevents = APR_POLLIN;
+	if(mrcp_connection_tx_is_pending(connection) == TRUE) {
+		reqevents |= APR_POLLOUT;
+		if(mrcp_connection_tx_is_congested(connection) == TRUE) {
+			/* stop reading the slow peer until it drains the queue */
+			reqevents = APR_POLLOUT;
+		}
+	}
+	if(connection->sock_pfd.reqevents == reqevents) {
+		return TRUE;
+	}
+
+	if(!(reqevents & APR_POLLIN)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"MRCPv2 Tx Queue Reached High-Water Mark %s [%"APR_SIZE_T_FMT" bytes]",
+			connection->id,
+			connection->tx_pending_length - connection->tx_pending_offset);
+	}
+	else if(!(connection->sock_pfd.reqevents & APR_POLLIN)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"MRCPv2 Tx Queue Drained below High-Water Mark %s",connection->id);
+	}
+
+	apt_poller_task_descriptor_remove(agent->task,&connection->sock_pfd);
+	connection->sock_pfd.reqevents = reqevents;
+	if(apt_poller_task_descriptor_add(agent->task,&connection->sock_pfd) != TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Add to Pollset %s",connection->id);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static apt_bool_t mrcp_client_agent_messsage_send(mrcp_connection_agent_t *agent, mrcp_control_channel_t *channel, mrcp_message_t *message)
 {
 	apt_bool_t status = FALSE;
 	mrcp_connection_t *connection = channel->connection;
-	apt_text_stream_t stream;
-	apt_message_status_e result;
 
 	if(!connection || !connection->sock) {
 		apt_obj_log(APT_LOG_MARK,APT_PRIO_WARNING,channel->log_obj,"Null MRCPv2 Connection "APT_SIDRES_FMT,MRCP_MESSAGE_SIDRES(message));
@@ -520,33 +761,13 @@ static apt_bool_t mrcp_client_agent_messsage_send(mrcp_connection_agent_t *agent
 		return FALSE;
 	}
 
-	do {
-		apt_text_stream_init(&stream,connection->tx_buffer,connection->tx_buffer_size);
-		result = mrcp_generator_run(connection->generator,message,&stream);
-		if(result != APT_MESSAGE_STATUS_INVALID) {
-			stream.text.length = stream.pos - stream.text.buf;
-			*stream.pos = '\0';
-
-			apt_obj_log(APT_LOG_MARK,APT_PRIO_INFO,channel->log_obj,"Send MRCPv2 Data %s [%"APR_SIZE_T_FMT" bytes]\n%.*s",
-				connection->id,
-				stream.text.length,
-				connection->verbose == TRUE ? stream.text.length : 0,
-				stream.text.buf);
-
-			if(apr_socket_send(connection->sock,stream.text.buf,&stream.text.length) == APR_SUCCESS) {
-				status = TRUE;
-			}
-			else {
-				apt_obj_log(APT_LOG_MARK,APT_PRIO_WARNING,channel->log_obj,"Failed to Send MRCPv2 Data %s",
-					connection->id);
-			}
-		}
-		else {
-			apt_obj_log(APT_LOG_MARK,APT_PRIO_WARNING,channel->log_obj,"Failed to Generate MRCPv2 Data %s",
-				connection->id);
-		}
+	if(mrcp_connection_message_send(connection,message,agent->resource_factory) == TRUE) {
+		status = mrcp_client_agent_connection_pollout_set(agent,connection);
+	}
+	else {
+		apt_obj_log(APT_LOG_MARK,APT_PRIO_WARNING,channel->log_obj,"Failed to Send MRCPv2 Data %s",
+			connection->id);
 	}
-	while(result == APT_MESSAGE_STATUS_INCOMPLETE);
 
 	if(status == TRUE) {
 		channel->active_request = message;
@@ -596,29 +817,26 @@ static apt_bool_t mrcp_client_message_handler(mrcp_connection_t *connection, mrc
 	return TRUE;
 }
 
-/* Receive MRCP message through TCP/MRCPv2 connection */
-static apt_bool_t mrcp_client_poller_signal_process(void *obj, const apr_pollfd_t *descriptor)
+/* Receive and process data available in TCP/MRCPv2 connection, return TRUE if more data is pending */
+static apt_bool_t mrcp_client_agent_connection_receive(mrcp_connection_agent_t *agent, mrcp_connection_t *connection)
 {
-	mrcp_connection_agent_t *agent = obj;
-	mrcp_connection_t *connection = descriptor->client_data;
 	apr_status_t status;
 	apr_size_t offset;
 	apr_size_t length;
-	apt_text_stream_t *stream;
+	apt_text_stream_t *stream = &connection->rx_stream;
 	mrcp_message_t *message;
 	apt_message_status_e msg_status;
 
-	if(!connection || !connection->sock) {
-		return FALSE;
-	}
-	stream = &connection->rx_stream;
-
 	/* calculate offset remaining from the previous receive / if any */
 	offset = stream->pos - stream->text.buf;
 	/* calculate available length */
 	length = connection->rx_buffer_size - offset;
 
-	status = apr_socket_recv(connection->sock,stream->pos,&length);
+	status = mrcp_connection_recv(connection,stream->pos,&length);
+	if(APR_STATUS_IS_EAGAIN(status)) {
+		/* spurious wakeup of non-blocking socket */
+		return FALSE;
+	}
 	if(status == APR_EOF || length == 0) {
 		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"TCP/MRCPv2 Peer Disconnected %s",connection->id);
 		apt_poller_task_descriptor_remove(agent->task,&connection->sock_pfd);
@@ -626,7 +844,11 @@ static apt_bool_t mrcp_client_poller_signal_process(void *obj, const apr_pollfd_
 		connection->sock = NULL;
 
 		mrcp_client_agent_disconnect_raise(agent,connection);
-		return TRUE;
+		if(!connection->access_count) {
+			/* unused connection of the pool, no channel is to destroy it */
+			mrcp_client_agent_connection_close(agent,connection);
+		}
+		return FALSE;
 	}
 	
 	/* calculate actual length of the stream */
@@ -649,8 +871,36 @@ static apt_bool_t mrcp_client_poller_signal_process(void *obj, const apr_pollfd_
 	}
 	while(apt_text_is_eos(stream) == FALSE);
 
-	/* scroll remaining stream */
-	apt_text_stream_scroll(stream);
+	/* grow, shrink or scroll the buffer */
+	mrcp_connection_rx_stream_adjust(connection,msg_status == APT_MESSAGE_STATUS_COMPLETE ? TRUE : FALSE);
+	/* data decrypted by TLS layer, but not read yet, is not signalled by the socket */
+	return mrcp_connection_rx_is_pending(connection);
+}
+
+/* Receive MRCP message through TCP/MRCPv2 connection */
+static apt_bool_t mrcp_client_poller_signal_process(void *obj, const apr_pollfd_t *descriptor)
+{
+	mrcp_connection_agent_t *agent = obj;
+	mrcp_connection_t *connection = descriptor->client_data;
+
+	if(!connection || !connection->sock) {
+		return FALSE;
+	}
+
+	if(descriptor->rtnevents & APR_POLLOUT) {
+		/* socket is writable, send pending data */
+		if(mrcp_connection_tx_flush(connection) == TRUE) {
+			mrcp_client_agent_connection_pollout_set(agent,connection);
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Send MRCPv2 Data %s",connection->id);
+		}
+		if(!(descriptor->rtnevents & (APR_POLLIN | APR_POLLHUP | APR_POLLERR))) {
+			return TRUE;
+		}
+	}
+
+	while(mrcp_client_agent_connection_receive(agent,connection) == TRUE);
 	return TRUE;
 }
 
@@ -679,6 +929,16 @@ static apt_bool_t mrcp_client_agent_msg_process(apt_task_t *task, apt_task_msg_t
 	return TRUE;
 }
 
+/* Idle timer callback of the unused connection of the pool */
+static void mrcp_client_idle_timer_proc(apt_timer_t *timer, void *obj)
+{
+	mrcp_connection_t *connection = obj;
+	if(connection && !connection->access_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Idle Timeout Elapsed %s",connection->id);
+		mrcp_client_agent_connection_close(connection->agent,connection);
+	}
+}
+
 /* Timer callback */
 static void mrcp_client_timer_proc(apt_timer_t *timer, void *obj)
 {
@@ -16,8 +16,16 @@
  * $Id$
  */
 
+#include <stdlib.h>
+#define APR_WANT_IOVEC
+#include <apr_want.h>
 #include "mrcp_connection.h"
+#include "mrcp_message.h"
 #include "apt_pool.h"
+#include "apt_log.h"
+
+/** Max number of body segments sent along with the header by a single call */
+#define MRCP_CONNECTION_MAX_BODY_VEC 16
 
 mrcp_connection_t* mrcp_connection_create(void)
 {
@@ -27,34 +35,142 @@ mrcp_connection_t* mrcp_connection_create(void)
 		return NULL;
 	}
 	
+	apt_pool_owner_set(pool,APT_POOL_OWNER_CONNECTION);
 	connection = apr_palloc(pool,sizeof(mrcp_connection_t));
 	connection->pool = pool;
 	apt_string_reset(&connection->remote_ip);
 	connection->l_sockaddr = NULL;
 	connection->r_sockaddr = NULL;
 	connection->sock = NULL;
+	connection->tls = NULL;
 	connection->id = NULL;
 	connection->verbose = TRUE;
 	connection->access_count = 0;
+	connection->persistent = FALSE;
+	connection->idle_timer = NULL;
 	APR_RING_ELEM_INIT(connection,link);
 	connection->channel_table = apr_hash_make(pool);
 	connection->parser = NULL;
 	connection->generator = NULL;
 	connection->rx_buffer = NULL;
 	connection->rx_buffer_size = 0;
+	connection->rx_buffer_base = NULL;
+	connection->rx_buffer_min_size = 0;
+	connection->rx_buffer_max_size = 0;
 	connection->tx_buffer = NULL;
 	connection->tx_buffer_size = 0;
+	connection->tx_pending = NULL;
+	connection->tx_pending_offset = 0;
+	connection->tx_pending_length = 0;
+	connection->tx_pending_size = 0;
+	connection->tx_queue_limit = MRCP_TX_QUEUE_LIMIT;
 
 	return connection;
 }
 
 void mrcp_connection_destroy(mrcp_connection_t *connection)
 {
+	if(connection && connection->tls) {
+		mrcp_tls_destroy(connection->tls);
+		connection->tls = NULL;
+	}
+	if(connection && connection->tx_pending) {
+		free(connection->tx_pending);
+		connection->tx_pending = NULL;
+	}
+	if(connection && connection->rx_buffer && connection->rx_buffer_size > connection->rx_buffer_min_size) {
+		free(connection->rx_buffer);
+		connection->rx_buffer = NULL;
+	}
 	if(connection && connection->pool) {
 		apr_pool_destroy(connection->pool);
 	}
 }
 
+void mrcp_connection_rx_buffer_init(mrcp_connection_t *connection, apr_size_t min_size, apr_size_t max_size)
+{
+	if(max_size < min_size) {
+		max_size = min_size;
+	}
+	connection->rx_buffer_min_size = min_size;
+	connection->rx_buffer_max_size = max_size;
+	connection->rx_buffer_size = min_size;
+	connection->rx_buffer_base = apr_palloc(connection->pool,min_size+1);
+	connection->rx_buffer = connection->rx_buffer_base;
+	apt_text_stream_init(&connection->rx_stream,connection->rx_buffer,connection->rx_buffer_size);
+}
+
+/** Free the grown rx buffer referenced by parsed messages along with the pool of the connection */
+static apr_status_t mrcp_connection_rx_buffer_cleanup(void *data)
+{
+	free(data);
+	return APR_SUCCESS;
+}
+
+void mrcp_connection_rx_stream_adjust(mrcp_connection_t *connection, apt_bool_t boundary)
+{
+	apt_text_stream_t *stream = &connection->rx_stream;
+	char *buffer = connection->rx_buffer;
+	apr_size_t size = connection->rx_buffer_size;
+	apt_bool_t pinned = mrcp_parser_stream_pinned(connection->parser);
+
+	if(boundary == TRUE) {
+		/* nothing is left in the stream, shrink back */
+		size = connection->rx_buffer_min_size;
+	}
+	else if(stream->text.length == connection->rx_buffer_size && size < connection->rx_buffer_max_size) {
+		/* the last receive filled the buffer up, the rest of a big message is likely to follow */
+		size *= 2;
+		if(size > connection->rx_buffer_max_size) {
+			size = connection->rx_buffer_max_size;
+		}
+	}
+
+	if(pinned == TRUE) {
+		/* parsed messages reference the buffer, which must live as long as the messages do
+		(in the pool of the connection); move the remaining stream to another buffer */
+		if(buffer == connection->rx_buffer_base) {
+			connection->rx_buffer_base = NULL;
+		}
+		else {
+			apr_pool_cleanup_register(connection->pool,buffer,mrcp_connection_rx_buffer_cleanup,apr_pool_cleanup_null);
+		}
+	}
+	else if(size == connection->rx_buffer_size) {
+		/* scroll remaining stream */
+		apt_text_stream_scroll(stream);
+		return;
+	}
+
+	if(size > connection->rx_buffer_min_size) {
+		connection->rx_buffer = malloc(size+1);
+		if(!connection->rx_buffer && pinned == FALSE) {
+			/* keep receiving into the current buffer */
+			connection->rx_buffer = buffer;
+			apt_text_stream_scroll(stream);
+			return;
+		}
+	}
+	else {
+		connection->rx_buffer = NULL;
+	}
+	if(!connection->rx_buffer) {
+		/* fall back to the base buffer */
+		size = connection->rx_buffer_min_size;
+		if(!connection->rx_buffer_base) {
+			connection->rx_buffer_base = apr_palloc(connection->pool,size+1);
+		}
+		connection->rx_buffer = connection->rx_buffer_base;
+	}
+
+	apt_text_stream_relocate(stream,connection->rx_buffer,size);
+	if(pinned == FALSE && connection->rx_buffer_size > connection->rx_buffer_min_size) {
+		/* the grown buffer is no longer used */
+		free(buffer);
+	}
+	connection->rx_buffer_size = size;
+}
+
 apt_bool_t mrcp_connection_channel_add(mrcp_connection_t *connection, mrcp_control_channel_t *channel)
 {
 	if(!connection || !channel) {
@@ -102,3 +218,174 @@ apt_bool_t mrcp_connection_disconnect_raise(mrcp_connection_t *connection, const
 	}
 	return TRUE;
 }
+
+/** Append data to tx pending buffer */
+static apt_bool_t mrcp_connection_tx_pending_append(mrcp_connection_t *connection, const char *data, apr_size_t length)
+{
+	apr_size_t pending_length = connection->tx_pending_length - connection->tx_pending_offset;
+	if(connection->tx_pending_offset) {
+		/* reclaim the space of already sent data */
+		memmove(connection->tx_pending,connection->tx_pending + connection->tx_pending_offset,pending_length);
+		connection->tx_pending_offset = 0;
+		connection->tx_pending_length = pending_length;
+	}
+
+	if(pending_length + length > connection->tx_pending_size) {
+		apr_size_t size = connection->tx_pending_size ? connection->tx_pending_size : MRCP_STREAM_BUFFER_SIZE;
+		char *buffer;
+		while(size < pending_length + length) {
+			size <<= 1;
+		}
+		buffer = realloc(connection->tx_pending,size);
+		if(!buffer) {
+			return FALSE;
+		}
+		connection->tx_pending = buffer;
+		connection->tx_pending_size = size;
+	}
+
+	memcpy(connection->tx_pending + connection->tx_pending_length,data,length);
+	connection->tx_pending_length += length;
+	return TRUE;
+}
+
+/** Send vector of data, appending unsent remainder to tx pending buffer */
+static apt_bool_t mrcp_connection_vec_send(mrcp_connection_t *connection, struct iovec *vec, apr_int32_t nvec)
+{
+	apr_size_t length = 0;
+	apr_int32_t i;
+
+	if(mrcp_connection_tx_is_pending(connection) == FALSE) {
+		apr_status_t status = connection->tls ?
+			mrcp_tls_sendv(connection->tls,vec,nvec,&length) :
+			apr_socket_sendv(connection->sock,vec,nvec,&length);
+		if(status != APR_SUCCESS && !APR_STATUS_IS_EAGAIN(status)) {
+			return FALSE;
+		}
+	}
+
+	/* data must be sent in order, queue whatever has not been sent */
+	for(i=0; i<nvec; i++) {
+		if(length >= vec[i].iov_len) {
+			length -= vec[i].iov_len;
+			continue;
+		}
+		if(mrcp_connection_tx_pending_append(
+				connection,
+				(const char*)vec[i].iov_base + length,
+				vec[i].iov_len - length) == FALSE) {
+			return FALSE;
+		}
+		length = 0;
+	}
+	return TRUE;
+}
+
+/** Send MRCP message through the non-blocking socket of MRCP connection */
+apt_bool_t mrcp_connection_message_send(mrcp_connection_t *connection, mrcp_message_t *message, const mrcp_resource_factory_t *resource_factory)
+{
+	apt_text_stream_t stream;
+	struct iovec vec[1 + MRCP_CONNECTION_MAX_BODY_VEC];
+	apr_int32_t nvec = 1;
+	apt_message_status_e result;
+	apt_bool_t status = FALSE;
+
+	if(message->body_vec && !message->body.buf && message->body_vec_count > MRCP_CONNECTION_MAX_BODY_VEC) {
+		/* too many segments to send at once */
+		mrcp_message_body_flatten(message);
+	}
+
+	apt_text_stream_init(&stream,connection->tx_buffer,connection->tx_buffer_size);
+	if(mrcp_generator_message_generate(connection->generator,message,&stream) == TRUE) {
+		stream.text.length = stream.pos - stream.text.buf;
+		*stream.pos = '\0';
+
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Send MRCPv2 Data %s [%"APR_SIZE_T_FMT" bytes]\n%.*s",
+				connection->id,
+				stream.text.length + message->body.length,
+				connection->verbose == TRUE ? stream.text.length : 0,
+				stream.text.buf);
+
+		/* header is sent from tx buffer, body by reference */
+		vec[0].iov_base = stream.text.buf;
+		vec[0].iov_len = stream.text.length;
+		if(message->body_vec && !message->body.buf) {
+			/* segments of the body gathered by the socket */
+			memcpy(vec + 1,message->body_vec,sizeof(struct iovec) * message->body_vec_count);
+			nvec += (apr_int32_t)message->body_vec_count;
+		}
+		else if(message->body.length) {
+			vec[1].iov_base = message->body.buf;
+			vec[1].iov_len = message->body.length;
+			nvec++;
+		}
+		return mrcp_connection_vec_send(connection,vec,nvec);
+	}
+
+	/* header section does not fit into tx buffer, generate the message chunk by chunk */
+	mrcp_message_body_flatten(message);
+	do {
+		apt_text_stream_init(&stream,connection->tx_buffer,connection->tx_buffer_size);
+		result = mrcp_generator_run(connection->generator,message,&stream);
+		if(result == APT_MESSAGE_STATUS_INVALID) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Generate MRCPv2 Data %s",connection->id);
+			return FALSE;
+		}
+
+		stream.text.length = stream.pos - stream.text.buf;
+		*stream.pos = '\0';
+
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Send MRCPv2 Data %s [%"APR_SIZE_T_FMT" bytes]\n%.*s",
+				connection->id,
+				stream.text.length,
+				connection->verbose == TRUE ? stream.text.length : 0,
+				stream.text.buf);
+
+		vec[0].iov_base = stream.text.buf;
+		vec[0].iov_len = stream.text.length;
+		status = mrcp_connection_vec_send(connection,vec,1);
+	}
+	while(status == TRUE && result == APT_MESSAGE_STATUS_INCOMPLETE);
+
+	return status;
+}
+
+/** Receive data through MRCP connection */
+apr_status_t mrcp_connection_recv(mrcp_connection_t *connection, char *buf, apr_size_t *len)
+{
+	if(connection->tls) {
+		return mrcp_tls_recv(connection->tls,buf,len);
+	}
+	return apr_socket_recv(connection->sock,buf,len);
+}
+
+/** Send the data pending in tx buffer of MRCP connection */
+apt_bool_t mrcp_connection_tx_flush(mrcp_connection_t *connection)
+{
+	apr_size_t length;
+	apr_status_t status;
+	if(mrcp_connection_tx_is_pending(connection) == FALSE) {
+		return TRUE;
+	}
+
+	length = connection->tx_pending_length - connection->tx_pending_offset;
+	if(connection->tls) {
+		struct iovec vec;
+		vec.iov_base = connection->tx_pending + connection->tx_pending_offset;
+		vec.iov_len = length;
+		status = mrcp_tls_sendv(connection->tls,&vec,1,&length);
+	}
+	else {
+		status = apr_socket_send(connection->sock,connection->tx_pending + connection->tx_pending_offset,&length);
+	}
+	if(status != APR_SUCCESS && !APR_STATUS_IS_EAGAIN(status)) {
+		return FALSE;
+	}
+
+	connection->tx_pending_offset += length;
+	if(connection->tx_pending_offset == connection->tx_pending_length) {
+		connection->tx_pending_offset = 0;
+		connection->tx_pending_length = 0;
+	}
+	return TRUE;
+}
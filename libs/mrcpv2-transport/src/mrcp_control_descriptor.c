@@ -22,7 +22,8 @@
 /** String table of mrcp proto types (mrcp_proto_type_e) */
 static const apt_str_table_item_t mrcp_proto_type_table[] = {
 	{{"TCP/MRCPv2",    10},4},
-	{{"TCP/TLS/MRCPv2",14},4}
+	{{"TCP/TLS/MRCPv2",14},4},
+	{{"UNIX/MRCPv2",   11},0}
 };
 
 /** String table of mrcp attributes (mrcp_attrib_e) */
@@ -31,7 +32,8 @@ static const apt_str_table_item_t mrcp_attrib_table[] = {
 	{{"connection",10},1},
 	{{"resource",   8},0},
 	{{"channel",    7},1},
-	{{"cmid",       4},1}
+	{{"cmid",       4},1},
+	{{"unix-path",  9},0}
 };
 
 /** String table of mrcp setup attribute values (mrcp_setup_type_e) */
@@ -95,6 +97,7 @@ MRCP_DECLARE(mrcp_control_descriptor_t*) mrcp_control_descriptor_create(apr_pool
 
 	apt_string_reset(&descriptor->ip);
 	descriptor->port = 0;
+	apt_string_reset(&descriptor->path);
 	descriptor->proto = MRCP_PROTO_UNKNOWN;
 	descriptor->setup_type = MRCP_SETUP_TYPE_UNKNOWN;
 	descriptor->connection_type = MRCP_CONNECTION_TYPE_UNKNOWN;
@@ -136,6 +139,7 @@ MRCP_DECLARE(mrcp_control_descriptor_t*) mrcp_control_offer_copy(const mrcp_cont
 		*descriptor = *offer;
 		descriptor->cmid_arr = apr_array_copy(pool,offer->cmid_arr);
 		apt_string_copy(&descriptor->ip,&offer->ip,pool);
+		apt_string_copy(&descriptor->path,&offer->path,pool);
 		apt_string_copy(&descriptor->resource_name,&offer->resource_name,pool);
 		apt_string_copy(&descriptor->session_id,&offer->session_id,pool);
 	}
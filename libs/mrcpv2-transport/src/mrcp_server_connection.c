@@ -12,39 +12,111 @@
  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
  * See the License for the specific language governing permissions and
  * limitations under the License.
- * 
+ *
  * $Id$
  */
 
+#include <apr_portable.h>
+#include <apr_thread_mutex.h>
+#include <apr_file_io.h>
+#ifndef WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
 #include "mrcp_connection.h"
 #include "mrcp_server_connection.h"
 #include "mrcp_control_descriptor.h"
 #include "mrcp_resource_factory.h"
 #include "mrcp_message.h"
 #include "apt_text_stream.h"
+#include "apt_listener.h"
 #include "apt_poller_task.h"
 #include "apt_pool.h"
 #include "apt_log.h"
+#include "apt_probe.h"
+
+/** Max number of connection agent workers */
+#define MRCP_SERVER_MAX_WORKER_COUNT 64
+
+/** Max length of remote IP address the connections are indexed by */
+#define MRCP_CONNECTION_IP_MAX_LENGTH 64
+
+/** Remote address the connections over Unix domain socket are indexed by */
+#define MRCP_CONNECTION_UNIX_PEER "unix"
+
+/** Max number of connections accepted per wakeup of the poller, so that the connections
+    already established are not starved by a storm of reconnects */
+#define MRCP_SERVER_ACCEPT_BATCH_SIZE 32
+
+/** Connections established from the same remote IP address */
+typedef struct mrcp_connection_ip_entry_t mrcp_connection_ip_entry_t;
+
+struct mrcp_connection_ip_entry_t {
+	/** List (ring) of MRCP connections from the remote IP */
+	APR_RING_HEAD(mrcp_connection_head_t, mrcp_connection_t) connection_list;
+	/** Next entry in the list of free entries */
+	mrcp_connection_ip_entry_t *next;
+	/** Remote IP address (key of the entry) */
+	char                        ip[MRCP_CONNECTION_IP_MAX_LENGTH];
+	apr_size_t                  ip_length;
+};
+
+/** Connection agent worker declaration */
+typedef struct mrcp_connection_worker_t mrcp_connection_worker_t;
 
+/** Connection agent worker, which has its own thread, pollset and listening socket */
+struct mrcp_connection_worker_t {
+	/** Agent the worker belongs to */
+	mrcp_connection_agent_t              *agent;
+	/** Poller task */
+	apt_poller_task_t                    *task;
+	/** Pool of the messages of the agent, others are of the co-located task */
+	apt_task_msg_pool_t                  *msg_pool;
+
+	/* Listening socket */
+	apr_socket_t                         *listen_sock;
+	apr_pollfd_t                          listen_sock_pfd;
+	/** Connection created for the accept, which found no pending connection, kept for the next one */
+	mrcp_connection_t                    *spare_connection;
+};
 
 struct mrcp_connection_agent_t {
 	apr_pool_t                           *pool;
-	apt_poller_task_t                    *task;
 	const mrcp_resource_factory_t        *resource_factory;
 
-	/** List (ring) of MRCP connections */
-	APR_RING_HEAD(mrcp_connection_head_t, mrcp_connection_t) connection_list;
+	/** Workers (the first one is the main task of the agent) */
+	mrcp_connection_worker_t            **workers;
+	apr_size_t                            worker_count;
+	apr_size_t                            max_connection_count;
+
+	/** Guard of pending channel table and connection table shared by workers */
+	apr_thread_mutex_t                   *guard;
 	/** Table of pending control channels */
 	apr_hash_t                           *pending_channel_table;
+	/** Table of MRCP connections indexed by remote IP [mrcp_connection_ip_entry_t] */
+	apr_hash_t                           *connection_table;
+	/** List of free (reusable) connection table entries */
+	mrcp_connection_ip_entry_t           *free_ip_entries;
 
 	apt_bool_t                            force_new_connection;
 	apr_size_t                            tx_buffer_size;
+	apr_size_t                            tx_queue_limit;
 	apr_size_t                            rx_buffer_size;
+	apr_size_t                            rx_buffer_max_size;
+	/** Time in seconds accepting connections is deferred for until data arrives (0 - not deferred) */
+	apr_size_t                            defer_accept;
+	/** Task the messages of which are processed on the poller thread (NULL if none) */
+	apt_task_t                           *colocated_task;
 
-	/* Listening socket */
+	/* Listening address */
 	apr_sockaddr_t                       *sockaddr;
-	apr_socket_t                         *listen_sock;
-	apr_pollfd_t                          listen_sock_pfd;
+	/** TLS context (TCP/TLS/MRCPv2) or NULL (TCP/MRCPv2) */
+	mrcp_tls_context_t                   *tls_context;
+	/** Path of Unix domain socket (UNIX/MRCPv2) or NULL */
+	const char                           *unix_path;
+	/** Number of connections accepted over Unix domain socket (used in identifiers) */
+	apr_size_t                            unix_connection_count;
 
 	void                                 *obj;
 	const mrcp_connection_event_vtable_t *vtable;
@@ -70,9 +142,48 @@ static apt_bool_t mrcp_server_agent_on_destroy(apt_task_t *task);
 static apt_bool_t mrcp_server_agent_msg_process(apt_task_t *task, apt_task_msg_t *task_msg);
 static apt_bool_t mrcp_server_poller_signal_process(void *obj, const apr_pollfd_t *descriptor);
 
-static apt_bool_t mrcp_server_agent_listening_socket_create(mrcp_connection_agent_t *agent);
-static void mrcp_server_agent_listening_socket_destroy(mrcp_connection_agent_t *agent);
+static apt_bool_t mrcp_server_agent_listening_socket_create(mrcp_connection_worker_t *worker);
+static void mrcp_server_agent_listening_socket_destroy(mrcp_connection_worker_t *worker);
+static apt_bool_t mrcp_server_agent_listening_socket_poll(mrcp_connection_worker_t *worker);
+
+
+/** Create connection agent worker */
+static mrcp_connection_worker_t* mrcp_server_agent_worker_create(mrcp_connection_agent_t *agent, const char *id)
+{
+	apt_task_t *task;
+	apt_task_vtable_t *vtable;
+	apt_task_msg_pool_t *msg_pool;
+	mrcp_connection_worker_t *worker = apr_palloc(agent->pool,sizeof(mrcp_connection_worker_t));
+	worker->agent = agent;
+	worker->listen_sock = NULL;
+	worker->spare_connection = NULL;
 
+	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(connection_task_msg_t),agent->pool);
+	worker->msg_pool = msg_pool;
+
+	worker->task = apt_poller_task_create(
+					agent->max_connection_count + 1,
+					mrcp_server_poller_signal_process,
+					worker,
+					msg_pool,
+					agent->pool);
+	if(!worker->task) {
+		return NULL;
+	}
+
+	task = apt_poller_task_base_get(worker->task);
+	if(task) {
+		apt_task_name_set(task,id);
+	}
+
+	vtable = apt_poller_task_vtable_get(worker->task);
+	if(vtable) {
+		vtable->destroy = mrcp_server_agent_on_destroy;
+		vtable->process_msg = mrcp_server_agent_msg_process;
+	}
+
+	return worker;
+}
 
 /** Create connection agent */
 MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_server_connection_agent_create(
@@ -83,58 +194,59 @@ MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_server_connection_agent_create(
 										apt_bool_t force_new_connection,
 										apr_pool_t *pool)
 {
-	apt_task_t *task;
-	apt_task_vtable_t *vtable;
-	apt_task_msg_pool_t *msg_pool;
 	mrcp_connection_agent_t *agent;
+	mrcp_connection_worker_t *worker;
 
 	if(!listen_ip) {
 		return NULL;
 	}
-	
+
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Create MRCPv2 Agent [%s] %s:%hu [%"APR_SIZE_T_FMT"]",
 		id,listen_ip,listen_port,max_connection_count);
 	agent = apr_palloc(pool,sizeof(mrcp_connection_agent_t));
 	agent->pool = pool;
+	agent->resource_factory = NULL;
+	agent->workers = NULL;
+	agent->worker_count = 0;
+	agent->max_connection_count = max_connection_count;
+	agent->guard = NULL;
 	agent->sockaddr = NULL;
-	agent->listen_sock = NULL;
+	agent->tls_context = NULL;
+	agent->unix_path = NULL;
+	agent->unix_connection_count = 0;
 	agent->force_new_connection = force_new_connection;
 	agent->rx_buffer_size = MRCP_STREAM_BUFFER_SIZE;
+	agent->rx_buffer_max_size = MRCP_STREAM_BUFFER_MAX_SIZE;
 	agent->tx_buffer_size = MRCP_STREAM_BUFFER_SIZE;
+	agent->tx_queue_limit = MRCP_TX_QUEUE_LIMIT;
+	agent->defer_accept = 0;
+	agent->colocated_task = NULL;
+	agent->obj = NULL;
+	agent->vtable = NULL;
 
 	apr_sockaddr_info_get(&agent->sockaddr,listen_ip,APR_INET,listen_port,0,pool);
 	if(!agent->sockaddr) {
 		return NULL;
 	}
 
-	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(connection_task_msg_t),pool);
-	
-	agent->task = apt_poller_task_create(
-					max_connection_count + 1,
-					mrcp_server_poller_signal_process,
-					agent,
-					msg_pool,
-					pool);
-	if(!agent->task) {
+	if(apr_thread_mutex_create(&agent->guard,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
 		return NULL;
 	}
 
-	task = apt_poller_task_base_get(agent->task);
-	if(task) {
-		apt_task_name_set(task,id);
-	}
-
-	vtable = apt_poller_task_vtable_get(agent->task);
-	if(vtable) {
-		vtable->destroy = mrcp_server_agent_on_destroy;
-		vtable->process_msg = mrcp_server_agent_msg_process;
+	worker = mrcp_server_agent_worker_create(agent,id);
+	if(!worker) {
+		return NULL;
 	}
+	agent->workers = apr_palloc(pool,sizeof(mrcp_connection_worker_t*));
+	agent->workers[0] = worker;
+	agent->worker_count = 1;
 
-	APR_RING_INIT(&agent->connection_list, mrcp_connection_t, link);
 	agent->pending_channel_table = apr_hash_make(pool);
+	agent->connection_table = apr_hash_make(pool);
+	agent->free_ip_entries = NULL;
 
-	if(mrcp_server_agent_listening_socket_create(agent) != TRUE) {
-		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Listening Socket [%s] %s:%hu", 
+	if(mrcp_server_agent_listening_socket_create(worker) != TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Listening Socket [%s] %s:%hu",
 				id,
 				listen_ip,
 				listen_port);
@@ -145,9 +257,9 @@ MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_server_connection_agent_create(
 static apt_bool_t mrcp_server_agent_on_destroy(apt_task_t *task)
 {
 	apt_poller_task_t *poller_task = apt_task_object_get(task);
-	mrcp_connection_agent_t *agent = apt_poller_task_object_get(poller_task);
+	mrcp_connection_worker_t *worker = apt_poller_task_object_get(poller_task);
 
-	mrcp_server_agent_listening_socket_destroy(agent);
+	mrcp_server_agent_listening_socket_destroy(worker);
 	apt_poller_task_cleanup(poller_task);
 	return TRUE;
 }
@@ -157,19 +269,91 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_connection_agent_destroy(mrcp_connection_ag
 {
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Destroy MRCPv2 Agent [%s]",
 		mrcp_server_connection_agent_id_get(agent));
-	return apt_poller_task_destroy(agent->task);
+	/* additional workers are child tasks of the first one */
+	return apt_poller_task_destroy(agent->workers[0]->task);
 }
 
 /** Start connection agent. */
 MRCP_DECLARE(apt_bool_t) mrcp_server_connection_agent_start(mrcp_connection_agent_t *agent)
 {
-	return apt_poller_task_start(agent->task);
+	return apt_poller_task_start(agent->workers[0]->task);
 }
 
 /** Terminate connection agent. */
 MRCP_DECLARE(apt_bool_t) mrcp_server_connection_agent_terminate(mrcp_connection_agent_t *agent)
 {
-	return apt_poller_task_terminate(agent->task);
+	return apt_poller_task_terminate(agent->workers[0]->task);
+}
+
+/** Set number of connection agent workers */
+MRCP_DECLARE(apt_bool_t) mrcp_server_connection_worker_count_set(mrcp_connection_agent_t *agent, apr_size_t worker_count)
+{
+	apt_task_t *main_task = apt_poller_task_base_get(agent->workers[0]->task);
+	const char *id = apt_task_name_get(main_task);
+#ifdef SO_REUSEPORT
+	apr_size_t i;
+	mrcp_connection_worker_t **workers;
+#endif
+	if(worker_count == 0 || worker_count > MRCP_SERVER_MAX_WORKER_COUNT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Number of MRCPv2 Agent Workers [%"APR_SIZE_T_FMT"] [%s]",
+			worker_count,id);
+		return FALSE;
+	}
+	if(worker_count > 1 && agent->colocated_task) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Use Single MRCPv2 Agent Worker, a task is co-located [%s]",id);
+		return FALSE;
+	}
+	if(worker_count <= agent->worker_count) {
+		/* workers can only be added before the agent is started */
+		return worker_count == agent->worker_count ? TRUE : FALSE;
+	}
+#ifndef SO_REUSEPORT
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Use Single MRCPv2 Agent Worker, SO_REUSEPORT is not supported [%s]",id);
+	return FALSE;
+#else
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Number of MRCPv2 Agent Workers [%"APR_SIZE_T_FMT"] [%s]",
+		worker_count,id);
+	workers = apr_palloc(agent->pool,sizeof(mrcp_connection_worker_t*) * worker_count);
+	for(i=0; i<agent->worker_count; i++) {
+		workers[i] = agent->workers[i];
+	}
+	if(agent->worker_count == 1) {
+		/* re-create the listening socket of the first worker to share the port with the others */
+		agent->worker_count = worker_count;
+		mrcp_server_agent_listening_socket_destroy(workers[0]);
+		mrcp_server_agent_listening_socket_create(workers[0]);
+		agent->worker_count = 1;
+	}
+	agent->workers = workers;
+	for(; i<worker_count; i++) {
+		mrcp_connection_worker_t *worker = mrcp_server_agent_worker_create(
+				agent,
+				apr_psprintf(agent->pool,"%s-%"APR_SIZE_T_FMT,id,i));
+		if(!worker) {
+			break;
+		}
+		/* the kernel distributes incoming connections among the listening sockets */
+		if(mrcp_server_agent_listening_socket_create(worker) != TRUE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Listening Socket [%s]",
+				apt_task_name_get(apt_poller_task_base_get(worker->task)));
+		}
+		/* additional workers are started and terminated along with the first one */
+		apt_task_cpu_set_set(apt_poller_task_base_get(worker->task),apt_task_cpu_set_get(main_task));
+		apt_task_add(main_task,apt_poller_task_base_get(worker->task));
+		workers[i] = worker;
+		agent->worker_count++;
+	}
+	return agent->worker_count == worker_count ? TRUE : FALSE;
+#endif
+}
+
+/** Bind connection agent workers to the set of CPUs */
+MRCP_DECLARE(void) mrcp_server_connection_cpu_set_set(mrcp_connection_agent_t *agent, const apt_cpu_set_t *cpu_set)
+{
+	apr_size_t i;
+	for(i=0; i<agent->worker_count; i++) {
+		apt_task_cpu_set_set(apt_poller_task_base_get(agent->workers[i]->task),cpu_set);
+	}
 }
 
 /** Set connection event handler. */
@@ -201,6 +385,14 @@ MRCP_DECLARE(void) mrcp_server_connection_rx_size_set(
 	agent->rx_buffer_size = size;
 }
 
+/** Set max size rx buffer grows to */
+MRCP_DECLARE(void) mrcp_server_connection_rx_max_size_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t size)
+{
+	agent->rx_buffer_max_size = size;
+}
+
 /** Set tx buffer size */
 MRCP_DECLARE(void) mrcp_server_connection_tx_size_set(
 								mrcp_connection_agent_t *agent,
@@ -212,10 +404,128 @@ MRCP_DECLARE(void) mrcp_server_connection_tx_size_set(
 	agent->tx_buffer_size = size;
 }
 
+/** Set high-water mark of tx pending data */
+MRCP_DECLARE(void) mrcp_server_connection_tx_queue_limit_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t size)
+{
+	agent->tx_queue_limit = size;
+}
+
+/** Apply the timeout of deferred accept to listening socket */
+static void mrcp_server_agent_listening_socket_defer(mrcp_connection_worker_t *worker)
+{
+#ifdef TCP_DEFER_ACCEPT
+	apr_os_sock_t fd;
+	int timeout = (int)worker->agent->defer_accept;
+	if(!worker->listen_sock || worker->agent->unix_path) {
+		return;
+	}
+	if(apr_os_sock_get(&fd,worker->listen_sock) == APR_SUCCESS) {
+		setsockopt(fd,IPPROTO_TCP,TCP_DEFER_ACCEPT,(const void*)&timeout,sizeof(timeout));
+	}
+#endif
+}
+
+/** Defer accepting connections until the first data arrives */
+MRCP_DECLARE(apt_bool_t) mrcp_server_connection_defer_accept_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t timeout)
+{
+#ifdef TCP_DEFER_ACCEPT
+	apr_size_t i;
+	agent->defer_accept = timeout;
+	for(i=0; i<agent->worker_count; i++) {
+		mrcp_server_agent_listening_socket_defer(agent->workers[i]);
+	}
+	return TRUE;
+#else
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Defer Accept, TCP_DEFER_ACCEPT is not supported");
+	return FALSE;
+#endif
+}
+
+/** Set TLS context */
+MRCP_DECLARE(void) mrcp_server_connection_tls_set(
+								mrcp_connection_agent_t *agent,
+								mrcp_tls_context_t *tls_context)
+{
+	agent->tls_context = tls_context;
+}
+
+/** Set path of Unix domain socket */
+MRCP_DECLARE(apt_bool_t) mrcp_server_connection_unix_path_set(
+								mrcp_connection_agent_t *agent,
+								const char *path)
+{
+#ifdef APR_UNIX
+	apr_sockaddr_t *sockaddr = NULL;
+	mrcp_connection_worker_t *worker = agent->workers[0];
+	if(!path || *path == '\0') {
+		return FALSE;
+	}
+	if(apr_sockaddr_info_get(&sockaddr,path,APR_UNIX,0,0,agent->pool) != APR_SUCCESS || !sockaddr) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Get Unix Socket Address [%s] %s",
+			apt_task_name_get(apt_poller_task_base_get(worker->task)),path);
+		return FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Set UNIX/MRCPv2 Path [%s] %s",
+		apt_task_name_get(apt_poller_task_base_get(worker->task)),path);
+	/* the agent listens on the Unix domain socket instead of the TCP port */
+	mrcp_server_agent_listening_socket_destroy(worker);
+	agent->unix_path = apr_pstrdup(agent->pool,path);
+	agent->sockaddr = sockaddr;
+	if(mrcp_server_agent_listening_socket_create(worker) != TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Listening Socket [%s] %s",
+			apt_task_name_get(apt_poller_task_base_get(worker->task)),path);
+	}
+	return TRUE;
+#else
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"UNIX/MRCPv2 is not supported");
+	return FALSE;
+#endif
+}
+
+/** Get MRCPv2 transport the agent serves */
+static APR_INLINE mrcp_proto_type_e mrcp_server_agent_proto_get(const mrcp_connection_agent_t *agent)
+{
+	if(agent->unix_path) {
+		return MRCP_PROTO_UNIX;
+	}
+	return agent->tls_context ? MRCP_PROTO_TLS : MRCP_PROTO_TCP;
+}
+
+/** Co-locate the processing of messages of another task with the poller of the agent */
+MRCP_DECLARE(apt_bool_t) mrcp_server_connection_colocated_task_set(mrcp_connection_agent_t *agent, apt_task_t *task)
+{
+	apt_task_t *main_task = apt_poller_task_base_get(agent->workers[0]->task);
+	if(task && agent->worker_count > 1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Cannot Co-locate Task [%s] with %"APR_SIZE_T_FMT" MRCPv2 Agent Workers [%s]",
+			apt_task_name_get(task),
+			agent->worker_count,
+			apt_task_name_get(main_task));
+		return FALSE;
+	}
+	if(task) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Co-locate Task [%s] with MRCPv2 Agent [%s]",
+			apt_task_name_get(task),
+			apt_task_name_get(main_task));
+	}
+	agent->colocated_task = task;
+	return TRUE;
+}
+
+/** Get the task co-located with the poller of the agent */
+MRCP_DECLARE(apt_task_t*) mrcp_server_connection_colocated_task_get(const mrcp_connection_agent_t *agent)
+{
+	return agent->colocated_task;
+}
+
 /** Get task */
 MRCP_DECLARE(apt_task_t*) mrcp_server_connection_agent_task_get(const mrcp_connection_agent_t *agent)
 {
-	return apt_poller_task_base_get(agent->task);
+	return apt_poller_task_base_get(agent->workers[0]->task);
 }
 
 /** Get external object */
@@ -227,7 +537,7 @@ MRCP_DECLARE(void*) mrcp_server_connection_agent_object_get(const mrcp_connectio
 /** Get string identifier */
 MRCP_DECLARE(const char*) mrcp_server_connection_agent_id_get(const mrcp_connection_agent_t *agent)
 {
-	apt_task_t *task = apt_poller_task_base_get(agent->task);
+	apt_task_t *task = apt_poller_task_base_get(agent->workers[0]->task);
 	return apt_task_name_get(task);
 }
 
@@ -259,6 +569,21 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_control_channel_destroy(mrcp_control_channe
 	return TRUE;
 }
 
+/** Get the worker in charge of the channel: the owner of the connection the channel
+    is assigned to or the first worker, while the channel is pending */
+static mrcp_connection_worker_t* mrcp_server_channel_worker_get(mrcp_connection_agent_t *agent, const mrcp_control_channel_t *channel)
+{
+	mrcp_connection_worker_t *worker = agent->workers[0];
+	if(agent->worker_count > 1) {
+		apr_thread_mutex_lock(agent->guard);
+		if(channel->connection) {
+			worker = channel->connection->agent;
+		}
+		apr_thread_mutex_unlock(agent->guard);
+	}
+	return worker;
+}
+
 /** Signal task message */
 static apt_bool_t mrcp_server_control_message_signal(
 								connection_task_msg_type_e type,
@@ -267,7 +592,8 @@ static apt_bool_t mrcp_server_control_message_signal(
 								mrcp_control_descriptor_t *descriptor,
 								mrcp_message_t *message)
 {
-	apt_task_t *task = apt_poller_task_base_get(agent->task);
+	mrcp_connection_worker_t *worker = mrcp_server_channel_worker_get(agent,channel);
+	apt_task_t *task = apt_poller_task_base_get(worker->task);
 	apt_task_msg_t *task_msg = apt_task_msg_get(task);
 	if(task_msg) {
 		connection_task_msg_t *msg = (connection_task_msg_t*)task_msg->data;
@@ -306,60 +632,114 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_control_message_send(mrcp_control_channel_t
 }
 
 /** Create listening socket and add it to pollset */
-static apt_bool_t mrcp_server_agent_listening_socket_create(mrcp_connection_agent_t *agent)
+static apt_bool_t mrcp_server_agent_listening_socket_create(mrcp_connection_worker_t *worker)
 {
 	apr_status_t status;
+	int protocol = APR_PROTO_TCP;
+	mrcp_connection_agent_t *agent = worker->agent;
 	if(!agent->sockaddr) {
 		return FALSE;
 	}
 
+	if(agent->unix_path) {
+		if(worker != agent->workers[0]) {
+			/* a Unix domain socket can not be shared by SO_REUSEPORT, the first worker accepts all the connections */
+			worker->listen_sock = NULL;
+			return TRUE;
+		}
+		protocol = 0;
+	}
+
+	/* take the socket bound already by the previous process or by systemd, if any,
+	so that the connections are queued rather than refused while the process starts */
+	worker->listen_sock = apt_listener_inherit(agent->sockaddr,SOCK_STREAM,agent->pool);
+	if(worker->listen_sock) {
+		/* connections are accepted in batches until the backlog is drained */
+		apr_socket_opt_set(worker->listen_sock, APR_SO_NONBLOCK, 1);
+		apr_socket_timeout_set(worker->listen_sock, 0);
+		return mrcp_server_agent_listening_socket_poll(worker);
+	}
+
+	if(agent->unix_path) {
+		/* remove the socket file left behind by the previous run, if any */
+		apr_file_remove(agent->unix_path,agent->pool);
+	}
+
 	/* create listening socket */
-	status = apr_socket_create(&agent->listen_sock, agent->sockaddr->family, SOCK_STREAM, APR_PROTO_TCP, agent->pool);
+	status = apr_socket_create(&worker->listen_sock, agent->sockaddr->family, SOCK_STREAM, protocol, agent->pool);
 	if(status != APR_SUCCESS) {
 		return FALSE;
 	}
 
-	apr_socket_opt_set(agent->listen_sock, APR_SO_NONBLOCK, 0);
-	apr_socket_timeout_set(agent->listen_sock, -1);
-	apr_socket_opt_set(agent->listen_sock, APR_SO_REUSEADDR, 1);
+	apr_socket_opt_set(worker->listen_sock, APR_SO_NONBLOCK, 1);
+	apr_socket_timeout_set(worker->listen_sock, 0);
+	apr_socket_opt_set(worker->listen_sock, APR_SO_REUSEADDR, 1);
+#ifdef SO_REUSEPORT
+	if(agent->worker_count > 1 && !agent->unix_path) {
+		/* each worker listens on its own socket bound to the same address */
+		apr_os_sock_t fd;
+		int on = 1;
+		if(apr_os_sock_get(&fd,worker->listen_sock) == APR_SUCCESS) {
+			setsockopt(fd,SOL_SOCKET,SO_REUSEPORT,(const void*)&on,sizeof(on));
+		}
+	}
+#endif
 
-	status = apr_socket_bind(agent->listen_sock, agent->sockaddr);
+	status = apr_socket_bind(worker->listen_sock, agent->sockaddr);
 	if(status != APR_SUCCESS) {
-		apr_socket_close(agent->listen_sock);
-		agent->listen_sock = NULL;
+		apr_socket_close(worker->listen_sock);
+		worker->listen_sock = NULL;
 		return FALSE;
 	}
-	status = apr_socket_listen(agent->listen_sock, SOMAXCONN);
+	status = apr_socket_listen(worker->listen_sock, SOMAXCONN);
 	if(status != APR_SUCCESS) {
-		apr_socket_close(agent->listen_sock);
-		agent->listen_sock = NULL;
+		apr_socket_close(worker->listen_sock);
+		worker->listen_sock = NULL;
 		return FALSE;
 	}
+	return mrcp_server_agent_listening_socket_poll(worker);
+}
 
+/** Add listening socket to pollset and register it to hand off */
+static apt_bool_t mrcp_server_agent_listening_socket_poll(mrcp_connection_worker_t *worker)
+{
 	/* add listening socket to pollset */
-	memset(&agent->listen_sock_pfd,0,sizeof(apr_pollfd_t));
-	agent->listen_sock_pfd.desc_type = APR_POLL_SOCKET;
-	agent->listen_sock_pfd.reqevents = APR_POLLIN;
-	agent->listen_sock_pfd.desc.s = agent->listen_sock;
-	agent->listen_sock_pfd.client_data = agent->listen_sock;
-	if(apt_poller_task_descriptor_add(agent->task, &agent->listen_sock_pfd) != TRUE) {
+	memset(&worker->listen_sock_pfd,0,sizeof(apr_pollfd_t));
+	worker->listen_sock_pfd.desc_type = APR_POLL_SOCKET;
+	worker->listen_sock_pfd.reqevents = APR_POLLIN;
+	worker->listen_sock_pfd.desc.s = worker->listen_sock;
+	worker->listen_sock_pfd.client_data = worker->listen_sock;
+	if(apt_poller_task_descriptor_add(worker->task, &worker->listen_sock_pfd) != TRUE) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Add Listening Socket to Pollset [%s]",
-			apt_task_name_get(apt_poller_task_base_get(agent->task)));
-		apr_socket_close(agent->listen_sock);
-		agent->listen_sock = NULL;
+			apt_task_name_get(apt_poller_task_base_get(worker->task)));
+		apr_socket_close(worker->listen_sock);
+		worker->listen_sock = NULL;
 		return FALSE;
 	}
 
+	apt_listener_register(worker->listen_sock);
+	if(worker->agent->defer_accept) {
+		mrcp_server_agent_listening_socket_defer(worker);
+	}
 	return TRUE;
 }
 
 /** Remove from pollset and destroy listening socket */
-static void mrcp_server_agent_listening_socket_destroy(mrcp_connection_agent_t *agent)
+static void mrcp_server_agent_listening_socket_destroy(mrcp_connection_worker_t *worker)
 {
-	if(agent->listen_sock) {
-		apt_poller_task_descriptor_remove(agent->task,&agent->listen_sock_pfd);
-		apr_socket_close(agent->listen_sock);
-		agent->listen_sock = NULL;
+	if(worker->listen_sock) {
+		apt_poller_task_descriptor_remove(worker->task,&worker->listen_sock_pfd);
+		apt_listener_unregister(worker->listen_sock);
+		apr_socket_close(worker->listen_sock);
+		worker->listen_sock = NULL;
+		if(worker->agent->unix_path && apt_listeners_are_handed_off() == FALSE) {
+			/* the socket file is in use by the new process otherwise */
+			apr_file_remove(worker->agent->unix_path,worker->agent->pool);
+		}
+	}
+	if(worker->spare_connection) {
+		mrcp_connection_destroy(worker->spare_connection);
+		worker->spare_connection = NULL;
 	}
 }
 
@@ -373,6 +753,8 @@ static mrcp_control_channel_t* mrcp_connection_channel_associate(mrcp_connection
 	apt_id_resource_generate(&message->channel_id.session_id,&message->channel_id.resource_name,'@',&identifier,connection->pool);
 	channel = mrcp_connection_channel_find(connection,&identifier);
 	if(!channel) {
+		/* pending channels are shared by the workers, the one which accepted the connection takes the channel */
+		apr_thread_mutex_lock(agent->guard);
 		channel = apr_hash_get(agent->pending_channel_table,identifier.buf,identifier.length);
 		if(channel) {
 			apr_hash_set(agent->pending_channel_table,identifier.buf,identifier.length,NULL);
@@ -383,44 +765,125 @@ static mrcp_control_channel_t* mrcp_connection_channel_associate(mrcp_connection
 				apr_hash_count(agent->pending_channel_table),
 				apr_hash_count(connection->channel_table));
 		}
+		apr_thread_mutex_unlock(agent->guard);
 	}
 	return channel;
 }
 
+/** Find any connection established from the remote IP (the guard must be held) */
 static mrcp_connection_t* mrcp_connection_find(mrcp_connection_agent_t *agent, const apt_str_t *remote_ip)
 {
-	mrcp_connection_t *connection;
+	mrcp_connection_ip_entry_t *entry;
 	if(!agent || !remote_ip) {
 		return NULL;
 	}
 
-	for(connection = APR_RING_FIRST(&agent->connection_list);
-			connection != APR_RING_SENTINEL(&agent->connection_list, mrcp_connection_t, link);
-				connection = APR_RING_NEXT(connection, link)) {
-		if(apt_string_compare(&connection->remote_ip,remote_ip) == TRUE) {
-			return connection;
-		}
+	entry = apr_hash_get(agent->connection_table,remote_ip->buf,remote_ip->length);
+	if(!entry || APR_RING_EMPTY(&entry->connection_list, mrcp_connection_t, link)) {
+		return NULL;
+	}
+	return APR_RING_FIRST(&entry->connection_list);
+}
+
+/** Index connection by remote IP */
+static apt_bool_t mrcp_connection_insert(mrcp_connection_agent_t *agent, mrcp_connection_t *connection)
+{
+	mrcp_connection_ip_entry_t *entry;
+	if(connection->remote_ip.length >= MRCP_CONNECTION_IP_MAX_LENGTH) {
+		return FALSE;
 	}
 
-	return NULL;
+	apr_thread_mutex_lock(agent->guard);
+	entry = apr_hash_get(agent->connection_table,connection->remote_ip.buf,connection->remote_ip.length);
+	if(!entry) {
+		entry = agent->free_ip_entries;
+		if(entry) {
+			agent->free_ip_entries = entry->next;
+		}
+		else {
+			entry = apr_palloc(agent->pool,sizeof(mrcp_connection_ip_entry_t));
+		}
+		APR_RING_INIT(&entry->connection_list, mrcp_connection_t, link);
+		entry->next = NULL;
+		memcpy(entry->ip,connection->remote_ip.buf,connection->remote_ip.length);
+		entry->ip[connection->remote_ip.length] = '\0';
+		entry->ip_length = connection->remote_ip.length;
+		apr_hash_set(agent->connection_table,entry->ip,entry->ip_length,entry);
+	}
+	APR_RING_INSERT_TAIL(&entry->connection_list,connection,mrcp_connection_t,link);
+	apr_thread_mutex_unlock(agent->guard);
+	return TRUE;
 }
 
-static apt_bool_t mrcp_connection_remove(mrcp_connection_agent_t *agent, mrcp_connection_t *connection)
+static apt_bool_t mrcp_connection_remove(mrcp_connection_worker_t *worker, mrcp_connection_t *connection)
 {
-	APR_RING_REMOVE(connection,link);
+	mrcp_connection_agent_t *agent = worker->agent;
+	mrcp_connection_ip_entry_t *entry;
+
+	apr_thread_mutex_lock(agent->guard);
+	entry = apr_hash_get(agent->connection_table,connection->remote_ip.buf,connection->remote_ip.length);
+	if(entry) {
+		APR_RING_REMOVE(connection,link);
+		if(APR_RING_EMPTY(&entry->connection_list, mrcp_connection_t, link)) {
+			/* no more connections from the remote IP, keep the entry for reuse */
+			apr_hash_set(agent->connection_table,entry->ip,entry->ip_length,NULL);
+			entry->next = agent->free_ip_entries;
+			agent->free_ip_entries = entry;
+		}
+	}
+	apr_thread_mutex_unlock(agent->guard);
 	return TRUE;
 }
 
-static apt_bool_t mrcp_server_agent_connection_accept(mrcp_connection_agent_t *agent)
+/** Create parser, generator and buffers of connection, as the first data arrives */
+static void mrcp_server_agent_connection_state_create(mrcp_connection_agent_t *agent, mrcp_connection_t *connection)
+{
+	connection->parser = mrcp_parser_create(agent->resource_factory,connection->pool);
+	/* header field values are parsed only if accessed by the server or plugins */
+	mrcp_parser_lazy_set(connection->parser,TRUE);
+	/* parsed messages reference the rx buffer, which is always terminated by '\0' */
+	mrcp_parser_zero_copy_set(connection->parser,TRUE);
+	connection->generator = mrcp_generator_create(agent->resource_factory,connection->pool);
+
+	connection->tx_buffer_size = agent->tx_buffer_size;
+	connection->tx_buffer = apr_palloc(connection->pool,connection->tx_buffer_size+1);
+	connection->tx_queue_limit = agent->tx_queue_limit;
+
+	mrcp_connection_rx_buffer_init(connection,agent->rx_buffer_size,agent->rx_buffer_max_size);
+
+	if(apt_log_masking_get() != APT_LOG_MASKING_NONE) {
+		connection->verbose = FALSE;
+		mrcp_parser_verbose_set(connection->parser,TRUE);
+		mrcp_generator_verbose_set(connection->generator,TRUE);
+	}
+}
+
+/* Accept a connection pending in the backlog, return FALSE if there is none */
+static apt_bool_t mrcp_server_agent_connection_accept(mrcp_connection_worker_t *worker)
 {
 	char *local_ip = NULL;
 	char *remote_ip = NULL;
-	
-	mrcp_connection_t *connection = mrcp_connection_create();
+	apr_size_t pending_count;
+	apr_status_t status;
+	mrcp_connection_agent_t *agent = worker->agent;
+	mrcp_connection_t *connection = worker->spare_connection;
 
-	if(apr_socket_accept(&connection->sock,agent->listen_sock,connection->pool) != APR_SUCCESS) {
-		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Accept Connection");
-		mrcp_connection_destroy(connection);
+	if(!connection) {
+		connection = mrcp_connection_create();
+		if(!connection) {
+			return FALSE;
+		}
+	}
+	worker->spare_connection = NULL;
+
+	status = apr_socket_accept(&connection->sock,worker->listen_sock,connection->pool);
+	if(status != APR_SUCCESS) {
+		connection->sock = NULL;
+		if(!APR_STATUS_IS_EAGAIN(status)) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Accept Connection");
+		}
+		/* nothing has been allocated from the pool, keep the connection for the next wakeup */
+		worker->spare_connection = connection;
 		return FALSE;
 	}
 
@@ -429,21 +892,49 @@ static apt_bool_t mrcp_server_agent_connection_accept(mrcp_connection_agent_t *a
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Get Socket Address");
 		apr_socket_close(connection->sock);
 		mrcp_connection_destroy(connection);
-		return FALSE;
+		return TRUE;
 	}
 
-	apr_sockaddr_ip_get(&local_ip,connection->l_sockaddr);
-	apr_sockaddr_ip_get(&remote_ip,connection->r_sockaddr);
-	apt_string_set(&connection->remote_ip,remote_ip);
-	connection->id = apr_psprintf(connection->pool,"%s:%hu <-> %s:%hu",
-		local_ip,connection->l_sockaddr->port,
-		remote_ip,connection->r_sockaddr->port);
+	/* messages are sent without blocking, the data the socket does not accept is queued */
+	apr_socket_opt_set(connection->sock, APR_SO_NONBLOCK, 1);
+	apr_socket_timeout_set(connection->sock, 0);
+
+	if(agent->unix_path) {
+		/* peers of Unix domain socket are unnamed, all of them are indexed as the same one */
+		apt_string_set(&connection->remote_ip,MRCP_CONNECTION_UNIX_PEER);
+		connection->id = apr_psprintf(connection->pool,"unix:%s <-> %s-%"APR_SIZE_T_FMT,
+			agent->unix_path,
+			MRCP_CONNECTION_UNIX_PEER,
+			++agent->unix_connection_count);
+	}
+	else {
+		apr_sockaddr_ip_get(&local_ip,connection->l_sockaddr);
+		apr_sockaddr_ip_get(&remote_ip,connection->r_sockaddr);
+		apt_string_set(&connection->remote_ip,remote_ip);
+		connection->id = apr_psprintf(connection->pool,"%s:%hu <-> %s:%hu",
+			local_ip,connection->l_sockaddr->port,
+			remote_ip,connection->r_sockaddr->port);
+	}
 
-	if(apr_hash_count(agent->pending_channel_table) == 0) {
+	apr_thread_mutex_lock(agent->guard);
+	pending_count = apr_hash_count(agent->pending_channel_table);
+	apr_thread_mutex_unlock(agent->guard);
+	if(pending_count == 0) {
 		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Reject Unexpected TCP/MRCPv2 Connection %s",connection->id);
 		apr_socket_close(connection->sock);
 		mrcp_connection_destroy(connection);
-		return FALSE;
+		return TRUE;
+	}
+
+	if(agent->tls_context && !agent->unix_path) {
+		/* TLS handshake is driven by the poller, the peer is expected to start it */
+		connection->tls = mrcp_tls_create(agent->tls_context,connection->sock,connection->id,connection->pool);
+		if(!connection->tls) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create TLS Session %s",connection->id);
+			apr_socket_close(connection->sock);
+			mrcp_connection_destroy(connection);
+			return TRUE;
+		}
 	}
 
 	memset(&connection->sock_pfd,0,sizeof(apr_pollfd_t));
@@ -451,56 +942,86 @@ static apt_bool_t mrcp_server_agent_connection_accept(mrcp_connection_agent_t *a
 	connection->sock_pfd.reqevents = APR_POLLIN;
 	connection->sock_pfd.desc.s = connection->sock;
 	connection->sock_pfd.client_data = connection;
-	if(apt_poller_task_descriptor_add(agent->task, &connection->sock_pfd) != TRUE) {
+	if(apt_poller_task_descriptor_add(worker->task, &connection->sock_pfd) != TRUE) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Add to Pollset %s",connection->id);
 		apr_socket_close(connection->sock);
 		mrcp_connection_destroy(connection);
-		return FALSE;
+		return TRUE;
 	}
 
-	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Accepted TCP/MRCPv2 Connection %s",connection->id);
-	connection->agent = agent;
-	APR_RING_INSERT_TAIL(&agent->connection_list,connection,mrcp_connection_t,link);
-
-	connection->parser = mrcp_parser_create(agent->resource_factory,connection->pool);
-	connection->generator = mrcp_generator_create(agent->resource_factory,connection->pool);
-
-	connection->tx_buffer_size = agent->tx_buffer_size;
-	connection->tx_buffer = apr_palloc(connection->pool,connection->tx_buffer_size+1);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Accepted TCP/MRCPv2 Connection %s [%s]",
+		connection->id,
+		apt_task_name_get(apt_poller_task_base_get(worker->task)));
+	/* the connection is processed by the worker which accepted it */
+	connection->agent = worker;
+	if(mrcp_connection_insert(agent,connection) != TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Index TCP/MRCPv2 Connection %s",connection->id);
+		apt_poller_task_descriptor_remove(worker->task,&connection->sock_pfd);
+		apr_socket_close(connection->sock);
+		mrcp_connection_destroy(connection);
+		return TRUE;
+	}
+	/* parser, generator and buffers are created as the first data arrives */
+	return TRUE;
+}
 
-	connection->rx_buffer_size = agent->rx_buffer_size;
-	connection->rx_buffer = apr_palloc(connection->pool,connection->rx_buffer_size+1);
-	apt_text_stream_init(&connection->rx_stream,connection->rx_buffer,connection->rx_buffer_size);
-	
-	if(apt_log_masking_get() != APT_LOG_MASKING_NONE) {
-		connection->verbose = FALSE;
-		mrcp_parser_verbose_set(connection->parser,TRUE);
-		mrcp_generator_verbose_set(connection->generator,TRUE);
+/* Accept the connections pending in the backlog, up to the batch size */
+static apt_bool_t mrcp_server_agent_connections_accept(mrcp_connection_worker_t *worker)
+{
+	apr_size_t i;
+	for(i=0; i<MRCP_SERVER_ACCEPT_BATCH_SIZE; i++) {
+		if(mrcp_server_agent_connection_accept(worker) == FALSE) {
+			break;
+		}
 	}
+	/* the rest of the backlog, if any, is accepted on the next wakeup */
 	return TRUE;
 }
 
-static apt_bool_t mrcp_server_agent_connection_close(mrcp_connection_agent_t *agent, mrcp_connection_t *connection)
+static apt_bool_t mrcp_server_agent_connection_close(mrcp_connection_worker_t *worker, mrcp_connection_t *connection)
 {
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"TCP/MRCPv2 Peer Disconnected %s",connection->id);
-	apt_poller_task_descriptor_remove(agent->task,&connection->sock_pfd);
+	apt_poller_task_descriptor_remove(worker->task,&connection->sock_pfd);
 	apr_socket_close(connection->sock);
 	connection->sock = NULL;
 	if(!connection->access_count) {
-		mrcp_connection_remove(agent,connection);
+		mrcp_connection_remove(worker,connection);
 		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Destroy TCP/MRCPv2 Connection %s",connection->id);
 		mrcp_connection_destroy(connection);
 	}
 	return TRUE;
 }
 
+/** Set the address the client is to connect to in answer */
+static void mrcp_server_agent_answer_address_set(mrcp_connection_agent_t *agent, mrcp_control_descriptor_t *answer)
+{
+	if(agent->unix_path) {
+		/* the port is meaningless, but must not be 0, which would reject the channel */
+		answer->port = TCP_DISCARD_PORT;
+		apt_string_set(&answer->path,agent->unix_path);
+	}
+	else {
+		answer->port = agent->sockaddr->port;
+		apt_string_reset(&answer->path);
+	}
+}
+
 static apt_bool_t mrcp_server_agent_channel_add(mrcp_connection_agent_t *agent, mrcp_control_channel_t *channel, mrcp_control_descriptor_t *offer)
 {
+	mrcp_proto_type_e proto = mrcp_server_agent_proto_get(agent);
 	mrcp_control_descriptor_t *answer = mrcp_control_answer_create(offer,channel->pool);
 	apt_id_resource_generate(&offer->session_id,&offer->resource_name,'@',&channel->identifier,channel->pool);
 	if(offer->port) {
-		answer->port = agent->sockaddr->port;
+		mrcp_server_agent_answer_address_set(agent,answer);
 	}
+	if(offer->proto != proto) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unsupported Control Channel Transport <%s> %s expected",
+			channel->identifier.buf,
+			mrcp_proto_get(proto)->buf);
+	}
+	answer->proto = proto;
+
+	apr_thread_mutex_lock(agent->guard);
 	if(offer->connection_type == MRCP_CONNECTION_TYPE_EXISTING) {
 		if(agent->force_new_connection == TRUE) {
 			/* force client to establish new connection */
@@ -509,7 +1030,14 @@ static apt_bool_t mrcp_server_agent_channel_add(mrcp_connection_agent_t *agent,
 		else {
 			mrcp_connection_t *connection = NULL;
 			/* try to find any existing connection */
-			connection = mrcp_connection_find(agent,&offer->ip);
+			if(agent->unix_path) {
+				apt_str_t peer;
+				apt_string_set(&peer,MRCP_CONNECTION_UNIX_PEER);
+				connection = mrcp_connection_find(agent,&peer);
+			}
+			else {
+				connection = mrcp_connection_find(agent,&offer->ip);
+			}
 			if(!connection) {
 				/* no existing conection found, force the new one */
 				answer->connection_type = MRCP_CONNECTION_TYPE_NEW;
@@ -521,6 +1049,7 @@ static apt_bool_t mrcp_server_agent_channel_add(mrcp_connection_agent_t *agent,
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Add Pending Control Channel <%s> [%d]",
 			channel->identifier.buf,
 			apr_hash_count(agent->pending_channel_table));
+	apr_thread_mutex_unlock(agent->guard);
 	/* send response */
 	return mrcp_control_channel_add_respond(agent->vtable,channel,answer,TRUE);
 }
@@ -529,16 +1058,29 @@ static apt_bool_t mrcp_server_agent_channel_modify(mrcp_connection_agent_t *agen
 {
 	mrcp_control_descriptor_t *answer = mrcp_control_answer_create(offer,channel->pool);
 	if(offer->port) {
-		answer->port = agent->sockaddr->port;
+		mrcp_server_agent_answer_address_set(agent,answer);
 	}
+	answer->proto = mrcp_server_agent_proto_get(agent);
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Modify Control Channel <%s>",channel->identifier.buf);
 	/* send response */
 	return mrcp_control_channel_modify_respond(agent->vtable,channel,answer,TRUE);
 }
 
-static apt_bool_t mrcp_server_agent_channel_remove(mrcp_connection_agent_t *agent, mrcp_control_channel_t *channel)
+static apt_bool_t mrcp_server_agent_channel_remove(mrcp_connection_worker_t *worker, mrcp_control_channel_t *channel)
 {
-	mrcp_connection_t *connection = channel->connection;
+	mrcp_connection_agent_t *agent = worker->agent;
+	mrcp_connection_t *connection;
+
+	apr_thread_mutex_lock(agent->guard);
+	connection = channel->connection;
+	if(!connection) {
+		apr_hash_set(agent->pending_channel_table,channel->identifier.buf,channel->identifier.length,NULL);
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Remove Pending Control Channel <%s> [%d]",
+				channel->identifier.buf,
+				apr_hash_count(agent->pending_channel_table));
+	}
+	apr_thread_mutex_unlock(agent->guard);
+
 	if(connection) {
 		mrcp_connection_channel_remove(connection,channel);
 		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Remove Control Channel <%s> [%d]",
@@ -546,7 +1088,7 @@ static apt_bool_t mrcp_server_agent_channel_remove(mrcp_connection_agent_t *agen
 				apr_hash_count(connection->channel_table));
 		if(!connection->access_count) {
 			if(!connection->sock) {
-				mrcp_connection_remove(agent,connection);
+				mrcp_connection_remove(worker,connection);
 				/* set connection to be destroyed on channel destroy */
 				apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Mark Connection for Removal %s",connection->id);
 				channel->connection = connection;
@@ -554,61 +1096,86 @@ static apt_bool_t mrcp_server_agent_channel_remove(mrcp_connection_agent_t *agen
 			}
 		}
 	}
-	else {
-		apr_hash_set(agent->pending_channel_table,channel->identifier.buf,channel->identifier.length,NULL);
-		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Remove Pending Control Channel <%s> [%d]",
-				channel->identifier.buf,
-				apr_hash_count(agent->pending_channel_table));
-	}
 	/* send response */
 	return mrcp_control_channel_remove_respond(agent->vtable,channel,TRUE);
 }
 
-static apt_bool_t mrcp_server_agent_messsage_send(mrcp_connection_agent_t *agent, mrcp_connection_t *connection, mrcp_message_t *message)
+/** Poll the socket of the connection for writability while tx data is pending and stop
+    reading the peer while tx pending data is above the high-water mark */
+static apt_bool_t mrcp_server_agent_connection_pollout_set(mrcp_connection_worker_t *worker, mrcp_connection_t *connection)
 {
-	apt_bool_t status = FALSE;
-	apt_text_stream_t stream;
-	apt_message_status_e result;
+	apr_int16_t reqevents = APR_POLLIN;
+	if(mrcp_connection_tx_is_pending(connection) == TRUE) {
+		reqevents |= APR_POLLOUT;
+		if(mrcp_connection_tx_is_congested(connection) == TRUE) {
+			/* stop reading the slow peer until it drains the queue */
+			reqevents = APR_POLLOUT;
+		}
+	}
+	else if(connection->tls && mrcp_tls_status_get(connection->tls) == MRCP_TLS_STATUS_WANT_WRITE) {
+		/* TLS handshake is waiting for the socket to become writable */
+		reqevents |= APR_POLLOUT;
+	}
+	if(connection->sock_pfd.reqevents == reqevents) {
+		return TRUE;
+	}
+
+	if(!(reqevents & APR_POLLIN)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"MRCPv2 Tx Queue Reached High-Water Mark %s [%"APR_SIZE_T_FMT" bytes]",
+			connection->id,
+			connection->tx_pending_length - connection->tx_pending_offset);
+	}
+	else if(!(connection->sock_pfd.reqevents & APR_POLLIN)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"MRCPv2 Tx Queue Drained below High-Water Mark %s",connection->id);
+	}
+
+	apt_poller_task_descriptor_remove(worker->task,&connection->sock_pfd);
+	connection->sock_pfd.reqevents = reqevents;
+	if(apt_poller_task_descriptor_add(worker->task,&connection->sock_pfd) != TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Add to Pollset %s",connection->id);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t mrcp_server_agent_messsage_send(mrcp_connection_worker_t *worker, mrcp_connection_t *connection, mrcp_message_t *message)
+{
+	APT_PROBE3(mrcp_message_send,message->start_line.message_type,message->start_line.request_id,message->start_line.method_id);
 	if(!connection || !connection->sock) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Null MRCPv2 Connection "APT_SIDRES_FMT,MRCP_MESSAGE_SIDRES(message));
 		return FALSE;
 	}
+	if(!connection->generator) {
+		mrcp_server_agent_connection_state_create(worker->agent,connection);
+	}
 
-	do {
-		apt_text_stream_init(&stream,connection->tx_buffer,connection->tx_buffer_size);
-		result = mrcp_generator_run(connection->generator,message,&stream);
-		if(result != APT_MESSAGE_STATUS_INVALID) {
-			stream.text.length = stream.pos - stream.text.buf;
-			*stream.pos = '\0';
-
-			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Send MRCPv2 Data %s [%"APR_SIZE_T_FMT" bytes]\n%.*s",
-					connection->id,
-					stream.text.length,
-					connection->verbose == TRUE ? stream.text.length : 0,
-					stream.text.buf);
-
-			if(apr_socket_send(connection->sock,stream.text.buf,&stream.text.length) == APR_SUCCESS) {
-				status = TRUE;
-			}
-			else {
-				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Send MRCPv2 Data");
-			}
-		}
-		else {
-			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Generate MRCPv2 Data");
-		}
+	if(message->is_discardable == TRUE && mrcp_connection_tx_is_congested(connection) == TRUE) {
+		/* the peer does not keep up, never queue data it is going to get a newer version of */
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Drop %s Event "APT_SIDRES_FMT" [%"MRCP_REQUEST_ID_FMT"] in Congested Connection %s",
+			message->start_line.method_name.buf,
+			MRCP_MESSAGE_SIDRES(message),
+			message->start_line.request_id,
+			connection->id);
+		return TRUE;
 	}
-	while(result == APT_MESSAGE_STATUS_INCOMPLETE);
 
-	return status;
+	if(mrcp_connection_message_send(connection,message,worker->agent->resource_factory) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Send MRCPv2 Data %s",connection->id);
+		return FALSE;
+	}
+
+	return mrcp_server_agent_connection_pollout_set(worker,connection);
 }
 
 static apt_bool_t mrcp_server_message_handler(mrcp_connection_t *connection, mrcp_message_t *message, apt_message_status_e status)
 {
-	mrcp_connection_agent_t *agent = connection->agent;
+	mrcp_connection_worker_t *worker = connection->agent;
+	mrcp_connection_agent_t *agent = worker->agent;
 	if(status == APT_MESSAGE_STATUS_COMPLETE) {
 		/* message is completely parsed */
-		mrcp_control_channel_t *channel = mrcp_connection_channel_associate(agent,connection,message);
+		mrcp_control_channel_t *channel;
+		apt_pool_account_update(connection->pool);
+		channel = mrcp_connection_channel_associate(agent,connection,message);
 		if(channel) {
 			mrcp_connection_message_receive(agent->vtable,channel,message);
 		}
@@ -625,7 +1192,7 @@ static apt_bool_t mrcp_server_message_handler(mrcp_connection_t *connection, mrc
 			mrcp_message_t *response;
 			response = mrcp_response_create(message,message->pool);
 			response->start_line.status_code = MRCP_STATUS_CODE_UNRECOGNIZED_MESSAGE;
-			if(mrcp_server_agent_messsage_send(agent,connection,response) == FALSE) {
+			if(mrcp_server_agent_messsage_send(worker,connection,response) == FALSE) {
 				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Send MRCPv2 Response");
 			}
 		}
@@ -633,35 +1200,43 @@ static apt_bool_t mrcp_server_message_handler(mrcp_connection_t *connection, mrc
 	return TRUE;
 }
 
-/* Receive MRCP message through TCP/MRCPv2 connection */
-static apt_bool_t mrcp_server_poller_signal_process(void *obj, const apr_pollfd_t *descriptor)
+/* Proceed with TLS handshake of TCP/TLS/MRCPv2 connection */
+static apt_bool_t mrcp_server_agent_tls_handshake(mrcp_connection_worker_t *worker, mrcp_connection_t *connection)
+{
+	if(mrcp_tls_handshake(connection->tls) == MRCP_TLS_STATUS_FAILED) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Establish TLS Session %s",connection->id);
+		return mrcp_server_agent_connection_close(worker,connection);
+	}
+	return mrcp_server_agent_connection_pollout_set(worker,connection);
+}
+
+/* Receive and process data available in TCP/MRCPv2 connection, return TRUE if more data is pending */
+static apt_bool_t mrcp_server_agent_connection_receive(mrcp_connection_worker_t *worker, mrcp_connection_t *connection)
 {
-	mrcp_connection_agent_t *agent = obj;
-	mrcp_connection_t *connection = descriptor->client_data;
 	apr_status_t status;
 	apr_size_t offset;
 	apr_size_t length;
-	apt_text_stream_t *stream;
+	apt_text_stream_t *stream = &connection->rx_stream;
 	mrcp_message_t *message;
 	apt_message_status_e msg_status;
 
-	if(descriptor->desc.s == agent->listen_sock) {
-		return mrcp_server_agent_connection_accept(agent);
-	}
-	
-	if(!connection || !connection->sock) {
-		return FALSE;
+	if(!connection->parser) {
+		mrcp_server_agent_connection_state_create(worker->agent,connection);
 	}
-	stream = &connection->rx_stream;
 
 	/* calculate offset remaining from the previous receive / if any */
 	offset = stream->pos - stream->text.buf;
 	/* calculate available length */
 	length = connection->rx_buffer_size - offset;
 
-	status = apr_socket_recv(connection->sock,stream->pos,&length);
+	status = mrcp_connection_recv(connection,stream->pos,&length);
+	if(APR_STATUS_IS_EAGAIN(status)) {
+		/* spurious wakeup of non-blocking socket */
+		return FALSE;
+	}
 	if(status == APR_EOF || length == 0) {
-		return mrcp_server_agent_connection_close(agent,connection);
+		mrcp_server_agent_connection_close(worker,connection);
+		return FALSE;
 	}
 
 	/* calculate actual length of the stream */
@@ -685,8 +1260,50 @@ static apt_bool_t mrcp_server_poller_signal_process(void *obj, const apr_pollfd_
 	}
 	while(apt_text_is_eos(stream) == FALSE);
 
-	/* scroll remaining stream */
-	apt_text_stream_scroll(stream);
+	/* grow, shrink or scroll the buffer */
+	mrcp_connection_rx_stream_adjust(connection,msg_status == APT_MESSAGE_STATUS_COMPLETE ? TRUE : FALSE);
+	/* data decrypted by TLS layer, but not read yet, is not signalled by the socket */
+	return mrcp_connection_rx_is_pending(connection);
+}
+
+/* Receive MRCP message through TCP/MRCPv2 connection */
+static apt_bool_t mrcp_server_poller_signal_process(void *obj, const apr_pollfd_t *descriptor)
+{
+	mrcp_connection_worker_t *worker = obj;
+	mrcp_connection_t *connection = descriptor->client_data;
+
+	if(descriptor->desc.s == worker->listen_sock) {
+		if(apt_listeners_are_handed_off() == TRUE) {
+			/* leave the connection pending to the new process, which listens on the socket too */
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Stop Accepting MRCPv2 Connections [%s]",
+				apt_task_name_get(apt_poller_task_base_get(worker->task)));
+			mrcp_server_agent_listening_socket_destroy(worker);
+			return TRUE;
+		}
+		return mrcp_server_agent_connections_accept(worker);
+	}
+
+	if(!connection || !connection->sock) {
+		return FALSE;
+	}
+
+	if(connection->tls && mrcp_tls_status_get(connection->tls) != MRCP_TLS_STATUS_DONE) {
+		return mrcp_server_agent_tls_handshake(worker,connection);
+	}
+
+	if(descriptor->rtnevents & APR_POLLOUT) {
+		/* socket is writable, send pending data */
+		if(mrcp_connection_tx_flush(connection) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Send MRCPv2 Data %s",connection->id);
+			return mrcp_server_agent_connection_close(worker,connection);
+		}
+		mrcp_server_agent_connection_pollout_set(worker,connection);
+		if(!(descriptor->rtnevents & (APR_POLLIN | APR_POLLHUP | APR_POLLERR))) {
+			return TRUE;
+		}
+	}
+
+	while(mrcp_server_agent_connection_receive(worker,connection) == TRUE);
 	return TRUE;
 }
 
@@ -694,8 +1311,27 @@ static apt_bool_t mrcp_server_poller_signal_process(void *obj, const apr_pollfd_
 static apt_bool_t mrcp_server_agent_msg_process(apt_task_t *task, apt_task_msg_t *task_msg)
 {
 	apt_poller_task_t *poller_task = apt_task_object_get(task);
-	mrcp_connection_agent_t *agent = apt_poller_task_object_get(poller_task);
+	mrcp_connection_worker_t *worker = apt_poller_task_object_get(poller_task);
+	mrcp_connection_agent_t *agent = worker->agent;
 	connection_task_msg_t *msg = (connection_task_msg_t*) task_msg->data;
+
+	if(task_msg->msg_pool != worker->msg_pool) {
+		/* the message is forwarded by the co-located task */
+		apt_task_vtable_t *vtable;
+		if(!agent->colocated_task) {
+			return FALSE;
+		}
+		vtable = apt_task_vtable_get(agent->colocated_task);
+		return vtable->process_msg ? vtable->process_msg(agent->colocated_task,task_msg) : FALSE;
+	}
+
+	if(msg->type == CONNECTION_TASK_MSG_REMOVE_CHANNEL || msg->type == CONNECTION_TASK_MSG_SEND_MESSAGE) {
+		if(mrcp_server_channel_worker_get(agent,msg->channel) != worker) {
+			/* the channel has meanwhile been assigned to a connection of another worker */
+			return mrcp_server_control_message_signal(msg->type,agent,msg->channel,msg->descriptor,msg->message);
+		}
+	}
+
 	switch(msg->type) {
 		case CONNECTION_TASK_MSG_ADD_CHANNEL:
 			mrcp_server_agent_channel_add(agent,msg->channel,msg->descriptor);
@@ -704,10 +1340,10 @@ static apt_bool_t mrcp_server_agent_msg_process(apt_task_t *task, apt_task_msg_t
 			mrcp_server_agent_channel_modify(agent,msg->channel,msg->descriptor);
 			break;
 		case CONNECTION_TASK_MSG_REMOVE_CHANNEL:
-			mrcp_server_agent_channel_remove(agent,msg->channel);
+			mrcp_server_agent_channel_remove(worker,msg->channel);
 			break;
 		case CONNECTION_TASK_MSG_SEND_MESSAGE:
-			mrcp_server_agent_messsage_send(agent,msg->channel->connection,msg->message);
+			mrcp_server_agent_messsage_send(worker,msg->channel->connection,msg->message);
 			break;
 	}
 
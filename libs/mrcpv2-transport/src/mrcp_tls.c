@@ -0,0 +1,436 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include "mrcp_tls.h"
+#include "apt_log.h"
+
+#ifdef MRCP_HAVE_TLS
+
+#include <apr_portable.h>
+#include <apr_hash.h>
+#include <apr_strings.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+/** Session id context the server side caches sessions under */
+#define MRCP_TLS_SESSION_ID_CONTEXT "unimrcp"
+
+struct mrcp_tls_context_t {
+	/** OpenSSL context */
+	SSL_CTX      *ctx;
+	/** Server or client side */
+	apt_bool_t    server;
+	/** Client side cache of the last session per peer [SSL_SESSION*] */
+	apr_hash_t   *session_table;
+	/** Pool to allocate memory from */
+	apr_pool_t   *pool;
+};
+
+struct mrcp_tls_t {
+	/** TLS context */
+	mrcp_tls_context_t *context;
+	/** OpenSSL session */
+	SSL                *ssl;
+	/** Socket */
+	apr_socket_t       *sock;
+	/** Peer identifier */
+	const char         *peer_id;
+	/** Status of handshake */
+	mrcp_tls_status_e   status;
+	/** Records are encrypted by the kernel on send */
+	apt_bool_t          ktls_tx;
+	/** Records are decrypted by the kernel on receive */
+	apt_bool_t          ktls_rx;
+};
+
+/** Index of ex data of SSL, which holds mrcp_tls_t */
+static int tls_ex_index = -1;
+
+static void mrcp_tls_error_log(const char *what)
+{
+	unsigned long err;
+	char buf[256];
+	while((err = ERR_get_error()) != 0) {
+		ERR_error_string_n(err,buf,sizeof(buf));
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"%s: %s",what,buf);
+	}
+}
+
+/** Cache new session of the client side (also delivered after the handshake in TLS 1.3) */
+static int mrcp_tls_session_new(SSL *ssl, SSL_SESSION *session)
+{
+	mrcp_tls_t *tls = SSL_get_ex_data(ssl,tls_ex_index);
+	SSL_SESSION *old_session;
+	if(!tls || !tls->peer_id) {
+		return 0;
+	}
+
+	old_session = apr_hash_get(tls->context->session_table,tls->peer_id,APR_HASH_KEY_STRING);
+	if(old_session == session) {
+		return 0;
+	}
+	if(old_session) {
+		SSL_SESSION_free(old_session);
+		apr_hash_set(tls->context->session_table,tls->peer_id,APR_HASH_KEY_STRING,session);
+	}
+	else {
+		apr_hash_set(tls->context->session_table,apr_pstrdup(tls->context->pool,tls->peer_id),APR_HASH_KEY_STRING,session);
+	}
+	/* the reference is taken over by the cache */
+	return 1;
+}
+
+MRCP_DECLARE(apt_bool_t) mrcp_tls_is_available(void)
+{
+	return TRUE;
+}
+
+MRCP_DECLARE(mrcp_tls_context_t*) mrcp_tls_context_create(
+								apt_bool_t server,
+								const char *cert_file,
+								const char *key_file,
+								const char *ca_file,
+								apr_pool_t *pool)
+{
+	mrcp_tls_context_t *context;
+	SSL_CTX *ctx;
+
+	if(OPENSSL_init_ssl(0,NULL) != 1) {
+		return NULL;
+	}
+	if(tls_ex_index < 0) {
+		tls_ex_index = SSL_get_ex_new_index(0,NULL,NULL,NULL,NULL);
+	}
+
+	ctx = SSL_CTX_new(server == TRUE ? TLS_server_method() : TLS_client_method());
+	if(!ctx) {
+		mrcp_tls_error_log("Failed to Create TLS Context");
+		return NULL;
+	}
+	SSL_CTX_set_min_proto_version(ctx,TLS1_2_VERSION);
+	/* partially sent records are completed by the next call with the data relocated to tx pending buffer */
+	SSL_CTX_set_mode(ctx,SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+#ifdef SSL_OP_ENABLE_KTLS
+	/* offload record encryption to the kernel, if supported */
+	SSL_CTX_set_options(ctx,SSL_OP_ENABLE_KTLS);
+#endif
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+	/* peers commonly close the connection without close_notify, which is not an error */
+	SSL_CTX_set_options(ctx,SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+
+	if(cert_file) {
+		if(SSL_CTX_use_certificate_chain_file(ctx,cert_file) != 1) {
+			mrcp_tls_error_log("Failed to Load TLS Certificate");
+			SSL_CTX_free(ctx);
+			return NULL;
+		}
+	}
+	if(key_file) {
+		if(SSL_CTX_use_PrivateKey_file(ctx,key_file,SSL_FILETYPE_PEM) != 1 || SSL_CTX_check_private_key(ctx) != 1) {
+			mrcp_tls_error_log("Failed to Load TLS Private Key");
+			SSL_CTX_free(ctx);
+			return NULL;
+		}
+	}
+	else if(server == TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No TLS Certificate and Private Key Specified");
+		SSL_CTX_free(ctx);
+		return NULL;
+	}
+	if(ca_file) {
+		if(SSL_CTX_load_verify_locations(ctx,ca_file,NULL) != 1) {
+			mrcp_tls_error_log("Failed to Load TLS CA Certificates");
+			SSL_CTX_free(ctx);
+			return NULL;
+		}
+		SSL_CTX_set_verify(ctx,SSL_VERIFY_PEER | (server == TRUE ? SSL_VERIFY_FAIL_IF_NO_PEER_CERT : 0),NULL);
+	}
+
+	context = apr_palloc(pool,sizeof(mrcp_tls_context_t));
+	context->ctx = ctx;
+	context->server = server;
+	context->session_table = NULL;
+	context->pool = pool;
+
+	if(server == TRUE) {
+		/* sessions are resumed either by the cache or by tickets (stateless) */
+		SSL_CTX_set_session_cache_mode(ctx,SSL_SESS_CACHE_SERVER);
+		SSL_CTX_set_session_id_context(ctx,(const unsigned char*)MRCP_TLS_SESSION_ID_CONTEXT,sizeof(MRCP_TLS_SESSION_ID_CONTEXT)-1);
+	}
+	else {
+		context->session_table = apr_hash_make(pool);
+		SSL_CTX_set_session_cache_mode(ctx,SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+		SSL_CTX_sess_set_new_cb(ctx,mrcp_tls_session_new);
+	}
+	return context;
+}
+
+MRCP_DECLARE(void) mrcp_tls_context_destroy(mrcp_tls_context_t *context)
+{
+	if(context->session_table) {
+		apr_hash_index_t *it;
+		void *val;
+		for(it = apr_hash_first(context->pool,context->session_table); it; it = apr_hash_next(it)) {
+			apr_hash_this(it,NULL,NULL,&val);
+			SSL_SESSION_free(val);
+		}
+		apr_hash_clear(context->session_table);
+	}
+	SSL_CTX_free(context->ctx);
+	context->ctx = NULL;
+}
+
+MRCP_DECLARE(mrcp_tls_t*) mrcp_tls_create(mrcp_tls_context_t *context, apr_socket_t *sock, const char *peer_id, apr_pool_t *pool)
+{
+	mrcp_tls_t *tls;
+	apr_os_sock_t fd;
+	if(!context || apr_os_sock_get(&fd,sock) != APR_SUCCESS) {
+		return NULL;
+	}
+
+	tls = apr_palloc(pool,sizeof(mrcp_tls_t));
+	tls->context = context;
+	tls->sock = sock;
+	tls->peer_id = peer_id ? apr_pstrdup(pool,peer_id) : NULL;
+	tls->status = MRCP_TLS_STATUS_WANT_READ;
+	tls->ktls_tx = FALSE;
+	tls->ktls_rx = FALSE;
+	tls->ssl = SSL_new(context->ctx);
+	if(!tls->ssl) {
+		mrcp_tls_error_log("Failed to Create TLS Session");
+		return NULL;
+	}
+	SSL_set_ex_data(tls->ssl,tls_ex_index,tls);
+	if(SSL_set_fd(tls->ssl,(int)fd) != 1) {
+		mrcp_tls_error_log("Failed to Set TLS Socket");
+		SSL_free(tls->ssl);
+		return NULL;
+	}
+
+	if(context->server == TRUE) {
+		SSL_set_accept_state(tls->ssl);
+	}
+	else {
+		SSL_set_connect_state(tls->ssl);
+		if(tls->peer_id) {
+			/* try to resume the last session with the peer */
+			SSL_SESSION *session = apr_hash_get(context->session_table,tls->peer_id,APR_HASH_KEY_STRING);
+			if(session) {
+				SSL_set_session(tls->ssl,session);
+			}
+		}
+	}
+	return tls;
+}
+
+MRCP_DECLARE(void) mrcp_tls_destroy(mrcp_tls_t *tls)
+{
+	if(tls->ssl) {
+		/* the socket is already closed by now, no close_notify is sent; the shutdown is
+		marked complete though, otherwise the session is considered bad and not resumed */
+		SSL_set_shutdown(tls->ssl,SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+		SSL_free(tls->ssl);
+		tls->ssl = NULL;
+	}
+}
+
+MRCP_DECLARE(mrcp_tls_status_e) mrcp_tls_handshake(mrcp_tls_t *tls)
+{
+	int rv;
+	if(tls->status == MRCP_TLS_STATUS_DONE || tls->status == MRCP_TLS_STATUS_FAILED) {
+		return tls->status;
+	}
+
+	rv = SSL_do_handshake(tls->ssl);
+	if(rv == 1) {
+		tls->status = MRCP_TLS_STATUS_DONE;
+#ifdef SSL_OP_ENABLE_KTLS
+		tls->ktls_tx = BIO_get_ktls_send(SSL_get_wbio(tls->ssl)) ? TRUE : FALSE;
+		tls->ktls_rx = BIO_get_ktls_recv(SSL_get_rbio(tls->ssl)) ? TRUE : FALSE;
+#endif
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"TLS Handshake Completed [%s] [%s] resumed:%d ktls-tx:%d ktls-rx:%d",
+			tls->peer_id ? tls->peer_id : "",
+			SSL_get_version(tls->ssl),
+			SSL_session_reused(tls->ssl),
+			tls->ktls_tx,
+			tls->ktls_rx);
+		return tls->status;
+	}
+
+	switch(SSL_get_error(tls->ssl,rv)) {
+		case SSL_ERROR_WANT_READ:
+			tls->status = MRCP_TLS_STATUS_WANT_READ;
+			break;
+		case SSL_ERROR_WANT_WRITE:
+			tls->status = MRCP_TLS_STATUS_WANT_WRITE;
+			break;
+		default:
+			mrcp_tls_error_log("TLS Handshake Failed");
+			tls->status = MRCP_TLS_STATUS_FAILED;
+			break;
+	}
+	return tls->status;
+}
+
+MRCP_DECLARE(mrcp_tls_status_e) mrcp_tls_status_get(const mrcp_tls_t *tls)
+{
+	return tls->status;
+}
+
+MRCP_DECLARE(apr_status_t) mrcp_tls_recv(mrcp_tls_t *tls, char *buf, apr_size_t *len)
+{
+	size_t read_bytes = 0;
+	/* with kernel TLS offload, this is a plain recvmsg, which also takes care of
+	non application data records (e.g. TLS 1.3 session tickets) */
+	int rv = SSL_read_ex(tls->ssl,buf,*len,&read_bytes);
+	if(rv == 1) {
+		*len = read_bytes;
+		return APR_SUCCESS;
+	}
+
+	*len = 0;
+	switch(SSL_get_error(tls->ssl,rv)) {
+		case SSL_ERROR_WANT_READ:
+		case SSL_ERROR_WANT_WRITE:
+			return APR_EAGAIN;
+		case SSL_ERROR_ZERO_RETURN:
+			return APR_EOF;
+		default:
+			mrcp_tls_error_log("Failed to Receive TLS Data");
+			break;
+	}
+	return APR_EOF;
+}
+
+MRCP_DECLARE(apt_bool_t) mrcp_tls_rx_is_pending(const mrcp_tls_t *tls)
+{
+	return SSL_pending(tls->ssl) > 0 ? TRUE : FALSE;
+}
+
+MRCP_DECLARE(apr_status_t) mrcp_tls_sendv(mrcp_tls_t *tls, const struct iovec *vec, apr_int32_t nvec, apr_size_t *len)
+{
+	apr_int32_t i;
+	if(tls->ktls_tx == TRUE) {
+		/* records are built by the kernel, no need to copy the data through OpenSSL */
+		return apr_socket_sendv(tls->sock,vec,nvec,len);
+	}
+
+	*len = 0;
+	i = 0;
+	while(i < nvec) {
+		/* OpenSSL copies the data to the record anyway, so small vectors (e.g. the header
+		and the body) are gathered into a single record rather than one record per vector */
+		char record[SSL3_RT_MAX_PLAIN_LENGTH];
+		const char *data = record;
+		size_t size = 0;
+		size_t written = 0;
+		int rv;
+		if(vec[i].iov_len >= sizeof(record)) {
+			data = vec[i].iov_base;
+			size = vec[i].iov_len;
+			i++;
+		}
+		else {
+			for(; i<nvec && size + vec[i].iov_len <= sizeof(record); i++) {
+				memcpy(record + size,vec[i].iov_base,vec[i].iov_len);
+				size += vec[i].iov_len;
+			}
+			if(!size) {
+				continue;
+			}
+		}
+
+		rv = SSL_write_ex(tls->ssl,data,size,&written);
+		if(rv != 1) {
+			int err = SSL_get_error(tls->ssl,rv);
+			if(err == SSL_ERROR_WANT_WRITE || err == SSL_ERROR_WANT_READ) {
+				/* the same data is passed again once the socket is writable (queued by the caller) */
+				return *len ? APR_SUCCESS : APR_EAGAIN;
+			}
+			mrcp_tls_error_log("Failed to Send TLS Data");
+			return APR_EGENERAL;
+		}
+		*len += written;
+		if(written < size) {
+			/* partial write, the rest is queued */
+			break;
+		}
+	}
+	return APR_SUCCESS;
+}
+
+#else /* MRCP_HAVE_TLS */
+
+MRCP_DECLARE(apt_bool_t) mrcp_tls_is_available(void)
+{
+	return FALSE;
+}
+
+MRCP_DECLARE(mrcp_tls_context_t*) mrcp_tls_context_create(
+								apt_bool_t server,
+								const char *cert_file,
+								const char *key_file,
+								const char *ca_file,
+								apr_pool_t *pool)
+{
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"TLS is not supported, build with --enable-tls");
+	return NULL;
+}
+
+MRCP_DECLARE(void) mrcp_tls_context_destroy(mrcp_tls_context_t *context)
+{
+}
+
+MRCP_DECLARE(mrcp_tls_t*) mrcp_tls_create(mrcp_tls_context_t *context, apr_socket_t *sock, const char *peer_id, apr_pool_t *pool)
+{
+	return NULL;
+}
+
+MRCP_DECLARE(void) mrcp_tls_destroy(mrcp_tls_t *tls)
+{
+}
+
+MRCP_DECLARE(mrcp_tls_status_e) mrcp_tls_handshake(mrcp_tls_t *tls)
+{
+	return MRCP_TLS_STATUS_FAILED;
+}
+
+MRCP_DECLARE(mrcp_tls_status_e) mrcp_tls_status_get(const mrcp_tls_t *tls)
+{
+	return MRCP_TLS_STATUS_FAILED;
+}
+
+MRCP_DECLARE(apr_status_t) mrcp_tls_recv(mrcp_tls_t *tls, char *buf, apr_size_t *len)
+{
+	*len = 0;
+	return APR_EOF;
+}
+
+MRCP_DECLARE(apt_bool_t) mrcp_tls_rx_is_pending(const mrcp_tls_t *tls)
+{
+	return FALSE;
+}
+
+MRCP_DECLARE(apr_status_t) mrcp_tls_sendv(mrcp_tls_t *tls, const struct iovec *vec, apr_int32_t nvec, apr_size_t *len)
+{
+	*len = 0;
+	return APR_ENOTIMPL;
+}
+
+#endif /* MRCP_HAVE_TLS */
@@ -96,6 +96,15 @@ RTSP_DECLARE(apt_task_t*) rtsp_client_task_get(const rtsp_client_t *client);
  */
 RTSP_DECLARE(void*) rtsp_client_object_get(const rtsp_client_t *client);
 
+/**
+ * Set whether to keep RTSP connections open, when no session uses them.
+ * @param client the client to set the option for
+ * @param keep_alive the option to set
+ * @remark Sessions to the same server share the connection regardless of
+ *         the option, which makes the subsequent sessions reuse it as well.
+ */
+RTSP_DECLARE(void) rtsp_client_keep_alive_set(rtsp_client_t *client, apt_bool_t keep_alive);
+
 
 /**
  * Create RTSP session.
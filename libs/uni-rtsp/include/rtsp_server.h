@@ -72,6 +72,33 @@ RTSP_DECLARE(rtsp_server_t*) rtsp_server_create(
  */
 RTSP_DECLARE(apt_bool_t) rtsp_server_destroy(rtsp_server_t *server);
 
+/**
+ * Share the listening port with the servers of other processes (SO_REUSEPORT).
+ * @param server the server to share the port of
+ * @remark Must be called before the server is started. Each connection carries
+ *         the whole session, so that it may be accepted by any of the processes.
+ */
+RTSP_DECLARE(apt_bool_t) rtsp_server_port_share_set(rtsp_server_t *server);
+
+/**
+ * Defer accepting connections until the first data arrives (TCP_DEFER_ACCEPT).
+ * @param server the server to set the timeout for
+ * @param timeout the time in seconds the kernel waits for the first data of a connection within
+ * @remark Supported on Linux only.
+ */
+RTSP_DECLARE(apt_bool_t) rtsp_server_defer_accept_set(rtsp_server_t *server, apr_size_t timeout);
+
+/**
+ * Set the number of poller threads (workers) to process RTSP connections by.
+ * @param server the server to set the number of workers for
+ * @param worker_count the number of workers including the primary one
+ * @remark Must be called before the server is started. The primary worker
+ *         accepts connections and hands them to the workers in round-robin.
+ *         Sessions are processed by the worker of their connection, so the
+ *         handlers of the server are called from the threads of the workers.
+ */
+RTSP_DECLARE(apt_bool_t) rtsp_server_worker_count_set(rtsp_server_t *server, apr_size_t worker_count);
+
 /**
  * Start server and wait for incoming requests.
  * @param server the server to start
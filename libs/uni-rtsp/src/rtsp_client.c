@@ -48,6 +48,8 @@ struct rtsp_client_t {
 	APR_RING_HEAD(rtsp_client_connection_head_t, rtsp_client_connection_t) connection_list;
 
 	apr_uint32_t                request_timeout;
+	/** Keep connections open, when no session uses them */
+	apt_bool_t                  keep_alive;
 
 	void                       *obj;
 	const rtsp_client_vtable_t *vtable;
@@ -68,6 +70,9 @@ struct rtsp_client_connection_t {
 	const char       *id;
 	/** RTSP client, connection belongs to */
 	rtsp_client_t    *client;
+	/** Server IP address and port the connection is established to */
+	const char       *server_ip;
+	apr_port_t        server_port;
 
 	/** Handle table (rtsp_client_session_t*) */
 	apr_hash_t       *handle_table;
@@ -195,9 +200,16 @@ RTSP_DECLARE(rtsp_client_t*) rtsp_client_create(
 
 	APR_RING_INIT(&client->connection_list, rtsp_client_connection_t, link);
 	client->request_timeout = (apr_uint32_t)request_timeout;
+	client->keep_alive = FALSE;
 	return client;
 }
 
+/** Set whether to keep RTSP connections open for subsequent sessions */
+RTSP_DECLARE(void) rtsp_client_keep_alive_set(rtsp_client_t *client, apt_bool_t keep_alive)
+{
+	client->keep_alive = keep_alive;
+}
+
 /** Destroy RTSP client */
 RTSP_DECLARE(apt_bool_t) rtsp_client_destroy(rtsp_client_t *client)
 {
@@ -416,6 +428,8 @@ static apt_bool_t rtsp_client_connection_create(rtsp_client_t *client, rtsp_clie
 	rtsp_connection->parser = rtsp_parser_create(pool);
 	rtsp_connection->generator = rtsp_generator_create(pool);
 	rtsp_connection->last_cseq = 0;
+	rtsp_connection->server_ip = apr_pstrdup(pool,session->server_ip.buf);
+	rtsp_connection->server_port = session->server_port;
 
 	rtsp_connection->client = client;
 	APR_RING_INSERT_TAIL(&client->connection_list,rtsp_connection,rtsp_client_connection_t,link);
@@ -435,6 +449,32 @@ static apt_bool_t rtsp_client_connection_destroy(rtsp_client_connection_t *rtsp_
 	return TRUE;
 }
 
+/* Find established RTSP connection to the server of the session */
+static rtsp_client_connection_t* rtsp_client_connection_find(rtsp_client_t *client, rtsp_client_session_t *session)
+{
+	rtsp_client_connection_t *rtsp_connection;
+	for(rtsp_connection = APR_RING_FIRST(&client->connection_list);
+			rtsp_connection != APR_RING_SENTINEL(&client->connection_list, rtsp_client_connection_t, link);
+				rtsp_connection = APR_RING_NEXT(rtsp_connection, link)) {
+		if(rtsp_connection->sock && rtsp_connection->server_port == session->server_port &&
+			strcmp(rtsp_connection->server_ip,session->server_ip.buf) == 0) {
+			return rtsp_connection;
+		}
+	}
+	return NULL;
+}
+
+/* Release RTSP connection no session uses anymore, return TRUE if the connection has been destroyed */
+static apt_bool_t rtsp_client_connection_release(rtsp_client_connection_t *rtsp_connection)
+{
+	if(rtsp_connection->client->keep_alive == TRUE && rtsp_connection->sock) {
+		/* keep the connection open for subsequent sessions */
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Keep Idle RTSP Connection %s",rtsp_connection->id);
+		return FALSE;
+	}
+	return rtsp_client_connection_destroy(rtsp_connection);
+}
+
 /* Respond to session termination request */
 static apt_bool_t rtsp_client_session_terminate_respond(rtsp_client_t *client, rtsp_client_session_t *session)
 {
@@ -492,7 +532,7 @@ static apt_bool_t rtsp_client_session_terminate_process(rtsp_client_t *client, r
 			rtsp_client_session_terminate_respond(client,session);
 
 			if(apr_hash_count(rtsp_connection->handle_table) == 0) {
-				rtsp_client_connection_destroy(rtsp_connection);
+				rtsp_client_connection_release(rtsp_connection);
 			}
 		}
 	}
@@ -565,8 +605,13 @@ static apt_bool_t rtsp_client_request_pop(rtsp_client_connection_t *rtsp_connect
 static apt_bool_t rtsp_client_session_request_process(rtsp_client_t *client, rtsp_client_session_t *session, rtsp_message_t *message)
 {
 	if(!session->connection) {
+		/* reuse RTSP connection to the same server, requests of the sessions are pipelined over it */
+		session->connection = rtsp_client_connection_find(client,session);
+		if(session->connection) {
+			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Reuse RTSP Connection %s",session->connection->id);
+		}
 		/* create RTSP connection */
-		if(rtsp_client_connection_create(client,session) == FALSE) {
+		else if(rtsp_client_connection_create(client,session) == FALSE) {
 			/* respond with error */
 			return FALSE;
 		}
@@ -811,6 +856,10 @@ static apt_bool_t rtsp_client_on_disconnect(rtsp_client_t *client, rtsp_client_c
 			}
 		}
 	}
+	else {
+		/* idle connection kept alive */
+		rtsp_client_connection_destroy(rtsp_connection);
+	}
 
 	return TRUE;
 }
@@ -889,8 +938,8 @@ static apt_bool_t rtsp_client_message_handler(rtsp_client_connection_t *rtsp_con
 				if(apr_hash_count(session->resource_table) == 0) {
 					rtsp_client_session_terminate_respond(rtsp_connection->client,session);
 
-					if(apr_hash_count(rtsp_connection->handle_table) == 0) {
-						rtsp_client_connection_destroy(rtsp_connection);
+					if(apr_hash_count(rtsp_connection->handle_table) == 0 &&
+						rtsp_client_connection_release(rtsp_connection) == TRUE) {
 						/* return FALSE to indicate connection has been destroyed */
 						return FALSE;
 					}
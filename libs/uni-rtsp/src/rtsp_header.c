@@ -30,6 +30,13 @@ static const apt_str_table_item_t rtsp_header_string_table[] = {
 	{{"Content-Length",14},8}
 };
 
+/** Perfect hash of rtsp_header_string_table (generated by strtablegen) */
+static const apr_byte_t rtsp_header_string_table_hash_slots[16] = {
+	0,2,0,4,0,0,0,0,6,0,0,1,0,0,3,5
+};
+
+static const apt_str_table_hash_t rtsp_header_string_table_hash = {3,15,rtsp_header_string_table_hash_slots};
+
 /** String table of RTSP content types (rtsp_content_type) */
 static const apt_str_table_item_t rtsp_content_type_string_table[] = {
 	{{"application/sdp", 15},12},
@@ -366,9 +373,10 @@ static apt_bool_t rtsp_header_field_value_generate(const rtsp_header_t *header,
 RTSP_DECLARE(apt_bool_t) rtsp_header_field_add(rtsp_header_t *header, apt_header_field_t *header_field, apr_pool_t *pool)
 {
 	/* parse header field (name-value) */
-	header_field->id = apt_string_table_id_find(
+	header_field->id = apt_string_table_id_hash_find(
 								rtsp_header_string_table,
 								RTSP_HEADER_FIELD_COUNT,
+								&rtsp_header_string_table_hash,
 								&header_field->name);
 	if(apt_string_is_empty(&header_field->value) == FALSE) {
 		rtsp_header_field_value_parse(header,header_field->id,&header_field->value,pool);
@@ -385,9 +393,10 @@ RTSP_DECLARE(apt_bool_t) rtsp_header_fields_parse(rtsp_header_t *header, apr_poo
 			header_field != APR_RING_SENTINEL(&header->header_section.ring, apt_header_field_t, link);
 				header_field = APR_RING_NEXT(header_field, link)) {
 
-		header_field->id = apt_string_table_id_find(
+		header_field->id = apt_string_table_id_hash_find(
 								rtsp_header_string_table,
 								RTSP_HEADER_FIELD_COUNT,
+								&rtsp_header_string_table_hash,
 								&header_field->name);
 		if(apt_string_is_empty(&header_field->value) == FALSE) {
 			rtsp_header_field_value_parse(header,header_field->id,&header_field->value,pool);
@@ -407,7 +416,7 @@ RTSP_DECLARE(apt_bool_t) rtsp_header_property_add(rtsp_header_t *header, rtsp_he
 		return rtsp_header_field_value_generate(header,id,&header_field->value,pool);
 	}
 
-	header_field = apt_header_field_alloc(pool);
+	header_field = apt_header_section_field_alloc(&header->header_section,pool);
 	if(rtsp_header_field_value_generate(header,id,&header_field->value,pool) == TRUE) {
 		const apt_str_t *name = apt_string_table_str_get(rtsp_header_string_table,RTSP_HEADER_FIELD_COUNT,id);
 		if(name) {
@@ -21,31 +21,64 @@
 #endif
 #include <apr_ring.h>
 #include <apr_hash.h>
+#include <apr_tables.h>
+#include <apr_portable.h>
+#ifndef WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
 #include "rtsp_server.h"
 #include "rtsp_stream.h"
 #include "apt_poller_task.h"
 #include "apt_text_stream.h"
 #include "apt_pool.h"
 #include "apt_obj_list.h"
+#include "apt_listener.h"
 #include "apt_log.h"
 
 #define RTSP_SESSION_ID_HEX_STRING_LENGTH 16
 #define RTSP_STREAM_BUFFER_SIZE 1024
+/** Max number of connections accepted per wakeup of the poller */
+#define RTSP_SERVER_ACCEPT_BATCH_SIZE 32
 
 typedef struct rtsp_server_connection_t rtsp_server_connection_t;
+typedef struct rtsp_server_worker_t rtsp_server_worker_t;
+
+/** RTSP server worker (poller thread connections are processed by) */
+struct rtsp_server_worker_t {
+	/** Poller task */
+	apt_poller_task_t          *task;
+	/** RTSP server, worker belongs to */
+	rtsp_server_t              *server;
+
+	/** List (ring) of RTSP connections */
+	APR_RING_HEAD(rtsp_server_connection_head_t, rtsp_server_connection_t) connection_list;
+};
 
 /** RTSP server */
 struct rtsp_server_t {
 	apr_pool_t                 *pool;
+	/** Task of the primary worker, which also accepts connections */
 	apt_poller_task_t          *task;
 
-	/** List (ring) of RTSP connections */
-	APR_RING_HEAD(rtsp_server_connection_head_t, rtsp_server_connection_t) connection_list;
+	/** Array of workers (rtsp_server_worker_t*), the primary one goes first */
+	apr_array_header_t         *workers;
+	/** Index of the worker to hand the next accepted connection to */
+	apr_size_t                  next_worker;
+	/** Number of max RTSP connections per worker */
+	apr_size_t                  max_connection_count;
 
 	/* Listening socket descriptor */
 	apr_sockaddr_t             *sockaddr;
 	apr_socket_t               *listen_sock;
 	apr_pollfd_t                listen_sock_pfd;
+	/** Whether the port is shared with the servers of other processes (SO_REUSEPORT) */
+	apt_bool_t                  port_shared;
+	/** Time in seconds accepting connections is deferred for until data arrives (0 - not deferred) */
+	apr_size_t                  defer_accept;
+	/** Connection created for the accept, which found no pending connection, kept for the next one */
+	rtsp_server_connection_t   *spare_connection;
 
 	void                       *obj;
 	const rtsp_server_vtable_t *vtable;
@@ -69,15 +102,18 @@ struct rtsp_server_connection_t {
 
 	/** RTSP server, connection belongs to */
 	rtsp_server_t     *server;
+	/** Worker, connection is processed by */
+	rtsp_server_worker_t *worker;
 
 	/** Session table (rtsp_server_session_t*) */
 	apr_hash_t        *session_table;
 
-	char               rx_buffer[RTSP_STREAM_BUFFER_SIZE];
+	/** Buffers, parser and generator are created as the first data arrives */
+	char              *rx_buffer;
 	apt_text_stream_t  rx_stream;
 	rtsp_parser_t     *parser;
 
-	char               tx_buffer[RTSP_STREAM_BUFFER_SIZE];
+	char              *tx_buffer;
 	apt_text_stream_t  tx_stream;
 	rtsp_generator_t  *generator;
 };
@@ -108,25 +144,31 @@ struct rtsp_server_session_t {
 
 typedef enum {
 	TASK_MSG_SEND_MESSAGE,
-	TASK_MSG_TERMINATE_SESSION
+	TASK_MSG_TERMINATE_SESSION,
+	TASK_MSG_ADD_CONNECTION
 } task_msg_data_type_e;
 
 typedef struct task_msg_data_t task_msg_data_t;
 
 struct task_msg_data_t {
-	task_msg_data_type_e   type;
-	rtsp_server_t         *server;
-	rtsp_server_session_t *session;
-	rtsp_message_t        *message;
+	task_msg_data_type_e      type;
+	rtsp_server_t            *server;
+	rtsp_server_session_t    *session;
+	rtsp_message_t           *message;
+	rtsp_server_connection_t *connection;
 };
 
 static apt_bool_t rtsp_server_on_destroy(apt_task_t *task);
+static apt_bool_t rtsp_server_worker_on_destroy(apt_task_t *task);
 static apt_bool_t rtsp_server_task_msg_process(apt_task_t *task, apt_task_msg_t *msg);
 static apt_bool_t rtsp_server_poller_signal_process(void *obj, const apr_pollfd_t *descriptor);
 static apt_bool_t rtsp_server_message_send(rtsp_server_t *server, rtsp_server_connection_t *connection, rtsp_message_t *message);
 
 static apt_bool_t rtsp_server_listening_socket_create(rtsp_server_t *server);
 static void rtsp_server_listening_socket_destroy(rtsp_server_t *server);
+static apt_bool_t rtsp_server_listening_socket_poll(rtsp_server_t *server);
+static apt_bool_t rtsp_server_connection_add(rtsp_server_worker_t *worker, rtsp_server_connection_t *rtsp_connection);
+static void rtsp_server_connection_state_create(rtsp_server_connection_t *rtsp_connection);
 
 /** Get string identifier */
 static const char* rtsp_server_id_get(const rtsp_server_t *server)
@@ -149,6 +191,7 @@ RTSP_DECLARE(rtsp_server_t*) rtsp_server_create(
 	apt_task_vtable_t *vtable;
 	apt_task_msg_pool_t *msg_pool;
 	rtsp_server_t *server;
+	rtsp_server_worker_t *worker;
 
 	if(!listen_ip) {
 		return NULL;
@@ -163,8 +206,14 @@ RTSP_DECLARE(rtsp_server_t*) rtsp_server_create(
 	server->pool = pool;
 	server->obj = obj;
 	server->vtable = handler;
+	server->workers = apr_array_make(pool,1,sizeof(rtsp_server_worker_t*));
+	server->next_worker = 0;
+	server->max_connection_count = max_connection_count;
 
 	server->listen_sock = NULL;
+	server->port_shared = FALSE;
+	server->defer_accept = 0;
+	server->spare_connection = NULL;
 	server->sockaddr = NULL;
 	apr_sockaddr_info_get(&server->sockaddr,listen_ip,APR_INET,listen_port,0,pool);
 	if(!server->sockaddr) {
@@ -173,15 +222,20 @@ RTSP_DECLARE(rtsp_server_t*) rtsp_server_create(
 
 	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(task_msg_data_t),pool);
 
-	server->task = apt_poller_task_create(
+	worker = apr_palloc(pool,sizeof(rtsp_server_worker_t));
+	worker->server = server;
+	APR_RING_INIT(&worker->connection_list, rtsp_server_connection_t, link);
+	worker->task = apt_poller_task_create(
 						max_connection_count + 1,
 						rtsp_server_poller_signal_process,
-						server,
+						worker,
 						msg_pool,
 						pool);
-	if(!server->task) {
+	if(!worker->task) {
 		return NULL;
 	}
+	server->task = worker->task;
+	APR_ARRAY_PUSH(server->workers,rtsp_server_worker_t*) = worker;
 
 	task = apt_poller_task_base_get(server->task);
 	if(task) {
@@ -194,8 +248,6 @@ RTSP_DECLARE(rtsp_server_t*) rtsp_server_create(
 		vtable->process_msg = rtsp_server_task_msg_process;
 	}
 
-	APR_RING_INIT(&server->connection_list, rtsp_server_connection_t, link);
-
 	if(rtsp_server_listening_socket_create(server) != TRUE) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Listening Socket [%s] %s:%hu", 
 				id,
@@ -208,13 +260,107 @@ RTSP_DECLARE(rtsp_server_t*) rtsp_server_create(
 static apt_bool_t rtsp_server_on_destroy(apt_task_t *task)
 {
 	apt_poller_task_t *poller_task = apt_task_object_get(task);
-	rtsp_server_t *server = apt_poller_task_object_get(poller_task);
+	rtsp_server_worker_t *worker = apt_poller_task_object_get(poller_task);
 
-	rtsp_server_listening_socket_destroy(server);
+	rtsp_server_listening_socket_destroy(worker->server);
 	apt_poller_task_cleanup(poller_task);
 	return TRUE;
 }
 
+static apt_bool_t rtsp_server_worker_on_destroy(apt_task_t *task)
+{
+	apt_poller_task_t *poller_task = apt_task_object_get(task);
+	apt_poller_task_cleanup(poller_task);
+	return TRUE;
+}
+
+/** Share the listening port of RTSP server with the servers of other processes */
+RTSP_DECLARE(apt_bool_t) rtsp_server_port_share_set(rtsp_server_t *server)
+{
+#ifndef SO_REUSEPORT
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Share RTSP Port, SO_REUSEPORT is not supported");
+	return FALSE;
+#else
+	if(server->port_shared == TRUE) {
+		return TRUE;
+	}
+	/* re-create the listening socket to share the port */
+	server->port_shared = TRUE;
+	rtsp_server_listening_socket_destroy(server);
+	return rtsp_server_listening_socket_create(server);
+#endif
+}
+
+/** Apply the timeout of deferred accept to listening socket */
+static void rtsp_server_listening_socket_defer(rtsp_server_t *server)
+{
+#ifdef TCP_DEFER_ACCEPT
+	apr_os_sock_t fd;
+	int timeout = (int)server->defer_accept;
+	if(server->listen_sock && apr_os_sock_get(&fd,server->listen_sock) == APR_SUCCESS) {
+		setsockopt(fd,IPPROTO_TCP,TCP_DEFER_ACCEPT,(const void*)&timeout,sizeof(timeout));
+	}
+#endif
+}
+
+/** Defer accepting connections until the first data arrives */
+RTSP_DECLARE(apt_bool_t) rtsp_server_defer_accept_set(rtsp_server_t *server, apr_size_t timeout)
+{
+#ifndef TCP_DEFER_ACCEPT
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Defer RTSP Accept, TCP_DEFER_ACCEPT is not supported");
+	return FALSE;
+#else
+	server->defer_accept = timeout;
+	rtsp_server_listening_socket_defer(server);
+	return TRUE;
+#endif
+}
+
+/** Run connections of RTSP server in several poller threads */
+RTSP_DECLARE(apt_bool_t) rtsp_server_worker_count_set(rtsp_server_t *server, apr_size_t worker_count)
+{
+	apt_task_t *task;
+	apt_task_t *parent_task = apt_poller_task_base_get(server->task);
+	apt_task_vtable_t *vtable;
+	apt_task_msg_pool_t *msg_pool;
+	rtsp_server_worker_t *worker;
+
+	while((apr_size_t)server->workers->nelts < worker_count) {
+		worker = apr_palloc(server->pool,sizeof(rtsp_server_worker_t));
+		worker->server = server;
+		APR_RING_INIT(&worker->connection_list, rtsp_server_connection_t, link);
+
+		msg_pool = apt_task_msg_pool_create_dynamic(sizeof(task_msg_data_t),server->pool);
+		worker->task = apt_poller_task_create(
+							server->max_connection_count,
+							rtsp_server_poller_signal_process,
+							worker,
+							msg_pool,
+							server->pool);
+		if(!worker->task) {
+			return FALSE;
+		}
+
+		task = apt_poller_task_base_get(worker->task);
+		apt_task_name_set(task,apr_psprintf(server->pool,"%s-%d",
+			apt_task_name_get(parent_task),server->workers->nelts + 1));
+
+		vtable = apt_poller_task_vtable_get(worker->task);
+		if(vtable) {
+			vtable->destroy = rtsp_server_worker_on_destroy;
+			vtable->process_msg = rtsp_server_task_msg_process;
+		}
+
+		/* started and terminated along with the primary task */
+		apt_task_add(parent_task,task);
+		APR_ARRAY_PUSH(server->workers,rtsp_server_worker_t*) = worker;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Set RTSP Server Workers [%s] [%d]",
+		rtsp_server_id_get(server),
+		server->workers->nelts);
+	return TRUE;
+}
+
 /** Destroy RTSP server */
 RTSP_DECLARE(apt_bool_t) rtsp_server_destroy(rtsp_server_t *server)
 {
@@ -287,7 +433,8 @@ static apt_bool_t rtsp_server_control_message_signal(
 								rtsp_server_session_t *session,
 								rtsp_message_t *message)
 {
-	apt_task_t *task = apt_poller_task_base_get(server->task);
+	/* the session is processed by the worker of its connection */
+	apt_task_t *task = apt_poller_task_base_get(session->connection->worker->task);
 	apt_task_msg_t *task_msg = apt_task_msg_get(task);
 	if(task_msg) {
 		task_msg_data_t *data = (task_msg_data_t*)task_msg->data;
@@ -295,6 +442,7 @@ static apt_bool_t rtsp_server_control_message_signal(
 		data->server = server;
 		data->session = session;
 		data->message = message;
+		data->connection = NULL;
 		apt_task_msg_signal(task,task_msg);
 	}
 	return TRUE;
@@ -601,10 +749,13 @@ static apt_bool_t rtsp_server_message_send(rtsp_server_t *server, rtsp_server_co
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No RTSP Connection");
 		return FALSE;
 	}
+	if(!rtsp_connection->generator) {
+		rtsp_server_connection_state_create(rtsp_connection);
+	}
 	stream = &rtsp_connection->tx_stream;
 
 	do {
-		stream->text.length = sizeof(rtsp_connection->tx_buffer)-1;
+		stream->text.length = RTSP_STREAM_BUFFER_SIZE-1;
 		apt_text_stream_reset(stream);
 		result = rtsp_generator_run(rtsp_connection->generator,message,stream);
 		if(result != APT_MESSAGE_STATUS_INVALID) {
@@ -666,15 +817,34 @@ static apt_bool_t rtsp_server_listening_socket_create(rtsp_server_t *server)
 		return FALSE;
 	}
 
+	/* take the socket bound already by the previous process or by systemd, if any */
+	server->listen_sock = apt_listener_inherit(server->sockaddr,SOCK_STREAM,server->pool);
+	if(server->listen_sock) {
+		/* connections are accepted in batches until the backlog is drained */
+		apr_socket_opt_set(server->listen_sock, APR_SO_NONBLOCK, 1);
+		apr_socket_timeout_set(server->listen_sock, 0);
+		return rtsp_server_listening_socket_poll(server);
+	}
+
 	/* create listening socket */
 	status = apr_socket_create(&server->listen_sock, server->sockaddr->family, SOCK_STREAM, APR_PROTO_TCP, server->pool);
 	if(status != APR_SUCCESS) {
 		return FALSE;
 	}
 
-	apr_socket_opt_set(server->listen_sock, APR_SO_NONBLOCK, 0);
-	apr_socket_timeout_set(server->listen_sock, -1);
+	apr_socket_opt_set(server->listen_sock, APR_SO_NONBLOCK, 1);
+	apr_socket_timeout_set(server->listen_sock, 0);
 	apr_socket_opt_set(server->listen_sock, APR_SO_REUSEADDR, 1);
+#ifdef SO_REUSEPORT
+	if(server->port_shared == TRUE) {
+		/* the kernel spreads the connections among the processes listening on the port */
+		apr_os_sock_t fd;
+		int on = 1;
+		if(apr_os_sock_get(&fd,server->listen_sock) == APR_SUCCESS) {
+			setsockopt(fd,SOL_SOCKET,SO_REUSEPORT,(const void*)&on,sizeof(on));
+		}
+	}
+#endif
 
 	status = apr_socket_bind(server->listen_sock, server->sockaddr);
 	if(status != APR_SUCCESS) {
@@ -688,7 +858,12 @@ static apt_bool_t rtsp_server_listening_socket_create(rtsp_server_t *server)
 		server->listen_sock = NULL;
 		return FALSE;
 	}
+	return rtsp_server_listening_socket_poll(server);
+}
 
+/** Add listening socket to pollset and register it to hand off */
+static apt_bool_t rtsp_server_listening_socket_poll(rtsp_server_t *server)
+{
 	/* add listening socket to pollset */
 	memset(&server->listen_sock_pfd,0,sizeof(apr_pollfd_t));
 	server->listen_sock_pfd.desc_type = APR_POLL_SOCKET;
@@ -702,6 +877,10 @@ static apt_bool_t rtsp_server_listening_socket_create(rtsp_server_t *server)
 		return FALSE;
 	}
 
+	apt_listener_register(server->listen_sock);
+	if(server->defer_accept) {
+		rtsp_server_listening_socket_defer(server);
+	}
 	return TRUE;
 }
 
@@ -710,41 +889,72 @@ static void rtsp_server_listening_socket_destroy(rtsp_server_t *server)
 {
 	if(server->listen_sock) {
 		apt_poller_task_descriptor_remove(server->task,&server->listen_sock_pfd);
+		apt_listener_unregister(server->listen_sock);
 		apr_socket_close(server->listen_sock);
 		server->listen_sock = NULL;
 	}
+	if(server->spare_connection) {
+		apr_pool_destroy(server->spare_connection->pool);
+		server->spare_connection = NULL;
+	}
 }
 
-/* Accept RTSP connection */
+/** Create buffers, parser and generator of connection, as the first data arrives */
+static void rtsp_server_connection_state_create(rtsp_server_connection_t *rtsp_connection)
+{
+	rtsp_connection->rx_buffer = apr_palloc(rtsp_connection->pool,RTSP_STREAM_BUFFER_SIZE);
+	rtsp_connection->tx_buffer = apr_palloc(rtsp_connection->pool,RTSP_STREAM_BUFFER_SIZE);
+	apt_text_stream_init(&rtsp_connection->rx_stream,rtsp_connection->rx_buffer,RTSP_STREAM_BUFFER_SIZE-1);
+	apt_text_stream_init(&rtsp_connection->tx_stream,rtsp_connection->tx_buffer,RTSP_STREAM_BUFFER_SIZE-1);
+	rtsp_connection->parser = rtsp_parser_create(rtsp_connection->pool);
+	rtsp_connection->generator = rtsp_generator_create(rtsp_connection->pool);
+}
+
+/* Accept RTSP connection pending in the backlog, return FALSE if there is none */
 static apt_bool_t rtsp_server_connection_accept(rtsp_server_t *server)
 {
-	rtsp_server_connection_t *rtsp_connection;
+	rtsp_server_connection_t *rtsp_connection = server->spare_connection;
 	char *local_ip = NULL;
 	char *remote_ip = NULL;
 	apr_sockaddr_t *l_sockaddr = NULL;
 	apr_sockaddr_t *r_sockaddr = NULL;
-	apr_pool_t *pool = apt_pool_create();
-	if(!pool) {
-		return FALSE;
-	}
+	apr_status_t status;
+	apr_pool_t *pool;
 
-	rtsp_connection = apr_palloc(pool,sizeof(rtsp_server_connection_t));
-	rtsp_connection->pool = pool;
-	rtsp_connection->sock = NULL;
-	rtsp_connection->client_ip = NULL;
-	APR_RING_ELEM_INIT(rtsp_connection,link);
+	if(!rtsp_connection) {
+		pool = apt_pool_create();
+		if(!pool) {
+			return FALSE;
+		}
+		rtsp_connection = apr_palloc(pool,sizeof(rtsp_server_connection_t));
+		rtsp_connection->pool = pool;
+		rtsp_connection->sock = NULL;
+		rtsp_connection->client_ip = NULL;
+		APR_RING_ELEM_INIT(rtsp_connection,link);
+	}
+	server->spare_connection = NULL;
+	pool = rtsp_connection->pool;
 
-	if(apr_socket_accept(&rtsp_connection->sock,server->listen_sock,rtsp_connection->pool) != APR_SUCCESS) {
-		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Accept RTSP Connection");
-		apr_pool_destroy(pool);
+	status = apr_socket_accept(&rtsp_connection->sock,server->listen_sock,rtsp_connection->pool);
+	if(status != APR_SUCCESS) {
+		rtsp_connection->sock = NULL;
+		if(!APR_STATUS_IS_EAGAIN(status)) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Accept RTSP Connection");
+		}
+		/* keep the connection for the next wakeup */
+		server->spare_connection = rtsp_connection;
 		return FALSE;
 	}
+	/* the accepted socket inherits the non-blocking mode of the listening one */
+	apr_socket_opt_set(rtsp_connection->sock, APR_SO_NONBLOCK, 0);
+	apr_socket_timeout_set(rtsp_connection->sock, -1);
 
 	if(apr_socket_addr_get(&l_sockaddr,APR_LOCAL,rtsp_connection->sock) != APR_SUCCESS ||
 		apr_socket_addr_get(&r_sockaddr,APR_REMOTE,rtsp_connection->sock) != APR_SUCCESS) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Get RTSP Socket Address");
+		apr_socket_close(rtsp_connection->sock);
 		apr_pool_destroy(pool);
-		return FALSE;
+		return TRUE;
 	}
 
 	apr_sockaddr_ip_get(&local_ip,l_sockaddr);
@@ -759,21 +969,62 @@ static apt_bool_t rtsp_server_connection_accept(rtsp_server_t *server)
 	rtsp_connection->sock_pfd.reqevents = APR_POLLIN;
 	rtsp_connection->sock_pfd.desc.s = rtsp_connection->sock;
 	rtsp_connection->sock_pfd.client_data = rtsp_connection;
-	if(apt_poller_task_descriptor_add(server->task,&rtsp_connection->sock_pfd) != TRUE) {
-		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Add to Pollset %s",rtsp_connection->id);
-		apr_socket_close(rtsp_connection->sock);
-		apr_pool_destroy(pool);
-		return FALSE;
-	}
 
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Accepted TCP Connection %s",rtsp_connection->id);
 	rtsp_connection->session_table = apr_hash_make(rtsp_connection->pool);
-	apt_text_stream_init(&rtsp_connection->rx_stream,rtsp_connection->rx_buffer,sizeof(rtsp_connection->rx_buffer)-1);
-	apt_text_stream_init(&rtsp_connection->tx_stream,rtsp_connection->tx_buffer,sizeof(rtsp_connection->tx_buffer)-1);
-	rtsp_connection->parser = rtsp_parser_create(rtsp_connection->pool);
-	rtsp_connection->generator = rtsp_generator_create(rtsp_connection->pool);
+	rtsp_connection->rx_buffer = NULL;
+	rtsp_connection->tx_buffer = NULL;
+	rtsp_connection->parser = NULL;
+	rtsp_connection->generator = NULL;
 	rtsp_connection->server = server;
-	APR_RING_INSERT_TAIL(&server->connection_list,rtsp_connection,rtsp_server_connection_t,link);
+
+	/* distribute connections across the workers in round-robin */
+	rtsp_connection->worker = APR_ARRAY_IDX(server->workers,server->next_worker,rtsp_server_worker_t*);
+	server->next_worker = (server->next_worker + 1) % server->workers->nelts;
+	if(rtsp_connection->worker->task != server->task) {
+		apt_task_t *task = apt_poller_task_base_get(rtsp_connection->worker->task);
+		apt_task_msg_t *task_msg = apt_task_msg_get(task);
+		if(task_msg) {
+			task_msg_data_t *data = (task_msg_data_t*)task_msg->data;
+			data->type = TASK_MSG_ADD_CONNECTION;
+			data->server = server;
+			data->session = NULL;
+			data->message = NULL;
+			data->connection = rtsp_connection;
+			apt_task_msg_signal(task,task_msg);
+			return TRUE;
+		}
+		apr_socket_close(rtsp_connection->sock);
+		apr_pool_destroy(pool);
+		return TRUE;
+	}
+	rtsp_server_connection_add(rtsp_connection->worker,rtsp_connection);
+	return TRUE;
+}
+
+/* Accept RTSP connections pending in the backlog, up to the batch size */
+static apt_bool_t rtsp_server_connections_accept(rtsp_server_t *server)
+{
+	apr_size_t i;
+	for(i=0; i<RTSP_SERVER_ACCEPT_BATCH_SIZE; i++) {
+		if(rtsp_server_connection_accept(server) == FALSE) {
+			break;
+		}
+	}
+	/* the rest of the backlog, if any, is accepted on the next wakeup */
+	return TRUE;
+}
+
+/* Add accepted RTSP connection to the pollset of the worker */
+static apt_bool_t rtsp_server_connection_add(rtsp_server_worker_t *worker, rtsp_server_connection_t *rtsp_connection)
+{
+	if(apt_poller_task_descriptor_add(worker->task,&rtsp_connection->sock_pfd) != TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Add to Pollset %s",rtsp_connection->id);
+		apr_socket_close(rtsp_connection->sock);
+		apr_pool_destroy(rtsp_connection->pool);
+		return FALSE;
+	}
+	APR_RING_INSERT_TAIL(&worker->connection_list,rtsp_connection,rtsp_server_connection_t,link);
 	return TRUE;
 }
 
@@ -785,7 +1036,7 @@ static apt_bool_t rtsp_server_connection_close(rtsp_server_t *server, rtsp_serve
 		return FALSE;
 	}
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Close RTSP Connection %s",rtsp_connection->id);
-	apt_poller_task_descriptor_remove(server->task,&rtsp_connection->sock_pfd);
+	apt_poller_task_descriptor_remove(rtsp_connection->worker->task,&rtsp_connection->sock_pfd);
 	apr_socket_close(rtsp_connection->sock);
 	rtsp_connection->sock = NULL;
 
@@ -817,7 +1068,8 @@ static apt_bool_t rtsp_server_connection_close(rtsp_server_t *server, rtsp_serve
 /* Receive RTSP message through RTSP connection */
 static apt_bool_t rtsp_server_poller_signal_process(void *obj, const apr_pollfd_t *descriptor)
 {
-	rtsp_server_t *server = obj;
+	rtsp_server_worker_t *worker = obj;
+	rtsp_server_t *server = worker->server;
 	rtsp_server_connection_t *rtsp_connection = descriptor->client_data;
 	apr_status_t status;
 	apr_size_t offset;
@@ -827,19 +1079,28 @@ static apt_bool_t rtsp_server_poller_signal_process(void *obj, const apr_pollfd_
 	apt_message_status_e msg_status;
 
 	if(descriptor->desc.s == server->listen_sock) {
+		if(apt_listeners_are_handed_off() == TRUE) {
+			/* leave the connection pending to the new process, which listens on the socket too */
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Stop Accepting RTSP Connections");
+			rtsp_server_listening_socket_destroy(server);
+			return TRUE;
+		}
 		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Accept Connection");
-		return rtsp_server_connection_accept(server);
+		return rtsp_server_connections_accept(server);
 	}
 	
 	if(!rtsp_connection || !rtsp_connection->sock) {
 		return FALSE;
 	}
+	if(!rtsp_connection->parser) {
+		rtsp_server_connection_state_create(rtsp_connection);
+	}
 	stream = &rtsp_connection->rx_stream;
 
 	/* calculate offset remaining from the previous receive / if any */
 	offset = stream->pos - stream->text.buf;
 	/* calculate available length */
-	length = sizeof(rtsp_connection->rx_buffer) - 1 - offset;
+	length = RTSP_STREAM_BUFFER_SIZE - 1 - offset;
 
 	status = apr_socket_recv(rtsp_connection->sock,stream->pos,&length);
 	if(status == APR_EOF || length == 0) {
@@ -873,7 +1134,8 @@ static apt_bool_t rtsp_server_poller_signal_process(void *obj, const apr_pollfd_
 static apt_bool_t rtsp_server_task_msg_process(apt_task_t *task, apt_task_msg_t *task_msg)
 {
 	apt_poller_task_t *poller_task = apt_task_object_get(task);
-	rtsp_server_t *server = apt_poller_task_object_get(poller_task);
+	rtsp_server_worker_t *worker = apt_poller_task_object_get(poller_task);
+	rtsp_server_t *server = worker->server;
 
 	task_msg_data_t *data = (task_msg_data_t*) task_msg->data;
 	switch(data->type) {
@@ -883,6 +1145,9 @@ static apt_bool_t rtsp_server_task_msg_process(apt_task_t *task, apt_task_msg_t
 		case TASK_MSG_TERMINATE_SESSION:
 			rtsp_server_session_do_terminate(server,data->session);
 			break;
+		case TASK_MSG_ADD_CONNECTION:
+			rtsp_server_connection_add(worker,data->connection);
+			break;
 	}
 
 	return TRUE;
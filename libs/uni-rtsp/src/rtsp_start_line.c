@@ -36,6 +36,13 @@ static const apt_str_table_item_t rtsp_method_string_table[] = {
 	{{"DESCRIBE", 8},0}
 };
 
+/** Perfect hash of rtsp_method_string_table (generated by strtablegen) */
+static const apr_byte_t rtsp_method_string_table_hash_slots[8] = {
+	1,0,0,4,0,3,2,0
+};
+
+static const apt_str_table_hash_t rtsp_method_string_table_hash = {3,7,rtsp_method_string_table_hash_slots};
+
 /** String table of RTSP reason phrases (rtsp_reason_phrase_e) */
 static const apt_str_table_item_t rtsp_reason_string_table[] = {
 	{{"OK",                     2},0},
@@ -49,7 +56,8 @@ static const apt_str_table_item_t rtsp_reason_string_table[] = {
 	{{"Request Timeout",       15},0},
 	{{"Session Not Found",     17},0},
 	{{"Internal Server Error", 21},0},
-	{{"Not Implemented",       15},4}
+	{{"Not Implemented",       15},4},
+	{{"Service Unavailable",   19},0}
 };
 
 /** Parse RTSP URI */
@@ -214,7 +222,7 @@ RTSP_DECLARE(apt_bool_t) rtsp_start_line_parse(rtsp_start_line_t *start_line, ap
 		rtsp_request_line_init(request_line);
 
 		apt_string_copy(&request_line->method_name,&field,pool);
-		request_line->method_id = apt_string_table_id_find(rtsp_method_string_table,RTSP_METHOD_COUNT,&field);
+		request_line->method_id = apt_string_table_id_hash_find(rtsp_method_string_table,RTSP_METHOD_COUNT,&rtsp_method_string_table_hash,&field);
 
 		if(apt_text_field_read(&line,APT_TOKEN_SP,TRUE,&field) == FALSE) {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Cannot parse URL in request-line");
@@ -59,10 +59,18 @@ struct mrcp_sofia_server_config_t {
 	apr_size_t sip_t4;
 	/** SIP T1x64 timer */
 	apr_size_t sip_t1x64;
+	/** Reuse TCP/TLS connections for the requests sent to the same peer */
+	apt_bool_t tport_reuse;
+	/** Idle timeout of TCP/TLS connections in msec (0 - connections are kept open) */
+	apr_size_t tport_idle_timeout;
+	/** Interval of keep-alives (CRLF) over TCP/TLS connections in msec (0 - disabled) */
+	apr_size_t tport_keepalive;
 	/** Print out SIP messages to the console */
 	apt_bool_t tport_log;
 	/** Dump SIP messages to the specified file */
 	char      *tport_dump_file;
+	/** Name of the header to report the load of the server in OPTIONS and INVITE responses (NULL - disabled) */
+	char      *load_header;
 };
 
 /**
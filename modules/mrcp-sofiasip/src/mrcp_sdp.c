@@ -27,12 +27,51 @@
 #include "apt_text_stream.h"
 #include "apt_log.h"
 
-static apr_size_t sdp_rtp_media_generate(char *buffer, apr_size_t size, const mrcp_session_descriptor_t *descriptor, const mpf_rtp_media_descriptor_t *audio_descriptor);
-static apr_size_t sdp_control_media_generate(char *buffer, apr_size_t size, const mrcp_session_descriptor_t *descriptor, const mrcp_control_descriptor_t *control_media, apt_bool_t offer);
+static apt_bool_t sdp_rtp_media_generate(apt_text_stream_t *stream, const mrcp_session_descriptor_t *descriptor, const mpf_rtp_media_descriptor_t *audio_descriptor);
+static apt_bool_t sdp_control_media_generate(apt_text_stream_t *stream, const mrcp_session_descriptor_t *descriptor, const mrcp_control_descriptor_t *control_media, apt_bool_t offer);
 
 static apt_bool_t mpf_rtp_media_generate(mpf_rtp_media_descriptor_t *rtp_media, const sdp_media_t *sdp_media, const apt_str_t *ip, apr_pool_t *pool);
 static apt_bool_t mrcp_control_media_generate(mrcp_control_descriptor_t *mrcp_media, const sdp_media_t *sdp_media, const apt_str_t *ip, apr_pool_t *pool);
 
+/** Insert string literal (the static parts of SDP are copied as is rather than formatted) */
+#define SDP_LITERAL_INSERT(stream,literal) sdp_text_insert(stream,literal,sizeof(literal)-1)
+
+/** Insert text of the given length */
+static APR_INLINE apt_bool_t sdp_text_insert(apt_text_stream_t *stream, const char *text, apr_size_t length)
+{
+	if(stream->pos + length >= stream->end) {
+		return FALSE;
+	}
+	memcpy(stream->pos,text,length);
+	stream->pos += length;
+	return TRUE;
+}
+
+/** Insert null-terminated string */
+static APR_INLINE apt_bool_t sdp_cstr_insert(apt_text_stream_t *stream, const char *str)
+{
+	return sdp_text_insert(stream,str,strlen(str));
+}
+
+/** Insert string, which may be not set */
+static APR_INLINE apt_bool_t sdp_str_insert(apt_text_stream_t *stream, const apt_str_t *str)
+{
+	return str ? apt_text_string_insert(stream,str) : TRUE;
+}
+
+/** Insert unsigned decimal number */
+static apt_bool_t sdp_number_insert(apt_text_stream_t *stream, apr_size_t value)
+{
+	char digits[20];
+	apr_size_t length = 0;
+	do {
+		digits[sizeof(digits) - ++length] = (char)('0' + value % 10);
+		value /= 10;
+	}
+	while(value && length < sizeof(digits));
+	return sdp_text_insert(stream,digits + sizeof(digits) - length,length);
+}
+
 /** Generate SDP string by MRCP descriptor */
 MRCP_DECLARE(apr_size_t) sdp_string_generate_by_mrcp_descriptor(char *buffer, apr_size_t size, const mrcp_session_descriptor_t *descriptor, apt_bool_t offer)
 {
@@ -44,43 +83,56 @@ MRCP_DECLARE(apr_size_t) sdp_string_generate_by_mrcp_descriptor(char *buffer, ap
 	mpf_rtp_media_descriptor_t *video_media;
 	apr_size_t control_index = 0;
 	mrcp_control_descriptor_t *control_media;
-	apr_size_t offset = 0;
+	apt_text_stream_t stream;
+	apt_bool_t status = TRUE;
 	const char *ip = descriptor->ext_ip.buf ? descriptor->ext_ip.buf : (descriptor->ip.buf ? descriptor->ip.buf : "0.0.0.0");
+	apr_size_t ip_length = strlen(ip);
+	if(!size) {
+		return 0;
+	}
 	buffer[0] = '\0';
-	offset += snprintf(buffer+offset,size-offset,
-			"v=0\r\n"
-			"o=%s 0 0 IN IP4 %s\r\n"
-			"s=-\r\n"
-			"c=IN IP4 %s\r\n"
-			"t=0 0\r\n",
-			descriptor->origin.buf ? descriptor->origin.buf : "-",
-			ip,
-			ip);
+	apt_text_stream_init(&stream,buffer,size);
+
+	status &= SDP_LITERAL_INSERT(&stream,"v=0\r\no=");
+	status &= sdp_cstr_insert(&stream,descriptor->origin.buf ? descriptor->origin.buf : "-");
+	status &= SDP_LITERAL_INSERT(&stream," 0 0 IN IP4 ");
+	status &= sdp_text_insert(&stream,ip,ip_length);
+	status &= SDP_LITERAL_INSERT(&stream,"\r\ns=-\r\nc=IN IP4 ");
+	status &= sdp_text_insert(&stream,ip,ip_length);
+	status &= SDP_LITERAL_INSERT(&stream,"\r\nt=0 0\r\n");
+
 	count = mrcp_session_media_count_get(descriptor);
-	for(i=0; i<count; i++) {
+	for(i=0; i<count && status == TRUE; i++) {
 		audio_media = mrcp_session_audio_media_get(descriptor,audio_index);
 		if(audio_media && audio_media->id == i) {
 			/* generate audio media */
 			audio_index++;
-			offset += sdp_rtp_media_generate(buffer+offset,size-offset,descriptor,audio_media);
+			status = sdp_rtp_media_generate(&stream,descriptor,audio_media);
 			continue;
 		}
 		video_media = mrcp_session_video_media_get(descriptor,video_index);
 		if(video_media && video_media->id == i) {
 			/* generate video media */
 			video_index++;
-			offset += sdp_rtp_media_generate(buffer+offset,size-offset,descriptor,video_media);
+			status = sdp_rtp_media_generate(&stream,descriptor,video_media);
 			continue;
 		}
 		control_media = mrcp_session_control_media_get(descriptor,control_index);
 		if(control_media && control_media->id == i) {
 			/** generate mrcp control media */
 			control_index++;
-			offset += sdp_control_media_generate(buffer+offset,size-offset,descriptor,control_media,offer);
+			status = sdp_control_media_generate(&stream,descriptor,control_media,offer);
 			continue;
 		}
 	}
-	return offset;
+
+	if(status == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Generate SDP: buffer of %"APR_SIZE_T_FMT" bytes is too small",size);
+		buffer[0] = '\0';
+		return 0;
+	}
+	*stream.pos = '\0';
+	return stream.pos - buffer;
 }
 
 /** Generate MRCP descriptor by SDP session */
@@ -132,9 +184,9 @@ MRCP_DECLARE(apt_bool_t) mrcp_descriptor_generate_by_sdp_session(mrcp_session_de
 }
 
 /** Generate SDP media by RTP media descriptor */
-static apr_size_t sdp_rtp_media_generate(char *buffer, apr_size_t size, const mrcp_session_descriptor_t *descriptor, const mpf_rtp_media_descriptor_t *audio_media)
+static apt_bool_t sdp_rtp_media_generate(apt_text_stream_t *stream, const mrcp_session_descriptor_t *descriptor, const mpf_rtp_media_descriptor_t *audio_media)
 {
-	apr_size_t offset = 0;
+	apt_bool_t status = TRUE;
 	if(audio_media->state == MPF_MEDIA_ENABLED) {
 		int codec_count = 0;
 		int i;
@@ -142,127 +194,149 @@ static apr_size_t sdp_rtp_media_generate(char *buffer, apr_size_t size, const mr
 		apr_array_header_t *descriptor_arr = audio_media->codec_list.descriptor_arr;
 		const apt_str_t *direction_str;
 		if(!descriptor_arr) {
-			return 0;
+			return TRUE;
 		}
 
-		offset += snprintf(buffer+offset,size-offset,"m=audio %d RTP/AVP",audio_media->port);
+		status &= SDP_LITERAL_INSERT(stream,"m=audio ");
+		status &= sdp_number_insert(stream,audio_media->port);
+		if(audio_media->crypto) {
+			status &= SDP_LITERAL_INSERT(stream," RTP/SAVP");
+		}
+		else {
+			status &= SDP_LITERAL_INSERT(stream," RTP/AVP");
+		}
 		for(i=0; i<descriptor_arr->nelts; i++) {
 			codec_descriptor = &APR_ARRAY_IDX(descriptor_arr,i,mpf_codec_descriptor_t);
 			if(codec_descriptor->enabled == TRUE) {
-				offset += snprintf(buffer+offset,size-offset," %d",codec_descriptor->payload_type);
+				status &= apt_text_space_insert(stream);
+				status &= sdp_number_insert(stream,codec_descriptor->payload_type);
 				codec_count++;
 			}
 		}
 		if(!codec_count){
 			/* SDP m line should have at least one media format listed; use a reserved RTP payload type */
-			offset += snprintf(buffer+offset,size-offset," %d",RTP_PT_RESERVED);
+			status &= apt_text_space_insert(stream);
+			status &= sdp_number_insert(stream,RTP_PT_RESERVED);
 		}
-		offset += snprintf(buffer+offset,size-offset,"\r\n");
+		status &= apt_text_eol_insert(stream);
 		
 		if(descriptor->ip.length && audio_media->ip.length && 
 			apt_string_compare(&descriptor->ip,&audio_media->ip) != TRUE) {
-			const char *media_ip = audio_media->ext_ip.buf ? audio_media->ext_ip.buf : audio_media->ip.buf;
-			offset += snprintf(buffer+offset,size-offset,"c=IN IP4 %s\r\n",media_ip);
+			const apt_str_t *media_ip = audio_media->ext_ip.buf ? &audio_media->ext_ip : &audio_media->ip;
+			status &= SDP_LITERAL_INSERT(stream,"c=IN IP4 ");
+			status &= apt_text_string_insert(stream,media_ip);
+			status &= apt_text_eol_insert(stream);
 		}
 		
 		for(i=0; i<descriptor_arr->nelts; i++) {
 			codec_descriptor = &APR_ARRAY_IDX(descriptor_arr,i,mpf_codec_descriptor_t);
 			if(codec_descriptor->enabled == TRUE && codec_descriptor->name.buf) {
-				offset += snprintf(buffer+offset,size-offset,"a=rtpmap:%d %s/%d\r\n",
-					codec_descriptor->payload_type,
-					codec_descriptor->name.buf,
-					codec_descriptor->sampling_rate);
+				apr_byte_t channel_count = mpf_codec_rtp_channel_count_get(codec_descriptor);
+				status &= SDP_LITERAL_INSERT(stream,"a=rtpmap:");
+				status &= sdp_number_insert(stream,codec_descriptor->payload_type);
+				status &= apt_text_space_insert(stream);
+				status &= apt_text_string_insert(stream,&codec_descriptor->name);
+				status &= apt_text_char_insert(stream,'/');
+				status &= sdp_number_insert(stream,mpf_codec_rtp_clock_rate_get(codec_descriptor));
+				if(channel_count > 1) {
+					status &= apt_text_char_insert(stream,'/');
+					status &= sdp_number_insert(stream,channel_count);
+				}
+				status &= apt_text_eol_insert(stream);
 				if(codec_descriptor->format.buf) {
-					offset += snprintf(buffer+offset,size-offset,"a=fmtp:%d %s\r\n",
-						codec_descriptor->payload_type,
-						codec_descriptor->format.buf);
+					status &= SDP_LITERAL_INSERT(stream,"a=fmtp:");
+					status &= sdp_number_insert(stream,codec_descriptor->payload_type);
+					status &= apt_text_space_insert(stream);
+					status &= apt_text_string_insert(stream,&codec_descriptor->format);
+					status &= apt_text_eol_insert(stream);
 				}
 			}
 		}
 		
 		direction_str = mpf_rtp_direction_str_get(audio_media->direction);
 		if(direction_str) {
-			offset += snprintf(buffer+offset,size-offset,"a=%s\r\n",direction_str->buf);
+			status &= SDP_LITERAL_INSERT(stream,"a=");
+			status &= apt_text_string_insert(stream,direction_str);
+			status &= apt_text_eol_insert(stream);
 		}
 		
 		if(audio_media->ptime) {
-			offset += snprintf(buffer+offset,size-offset,"a=ptime:%hu\r\n",audio_media->ptime);
+			status &= SDP_LITERAL_INSERT(stream,"a=ptime:");
+			status &= sdp_number_insert(stream,audio_media->ptime);
+			status &= apt_text_eol_insert(stream);
+		}
+
+		if(audio_media->rtcp_mux == TRUE) {
+			status &= SDP_LITERAL_INSERT(stream,"a=rtcp-mux\r\n");
+		}
+
+		if(audio_media->crypto) {
+			status &= SDP_LITERAL_INSERT(stream,"a=crypto:");
+			if(status == TRUE) {
+				stream->pos += mpf_srtp_crypto_generate(audio_media->crypto,stream->pos,stream->end - stream->pos);
+			}
+			status &= apt_text_eol_insert(stream);
 		}
 	}
 	else {
-		offset += snprintf(buffer+offset,size-offset,"m=audio 0 RTP/AVP %d\r\n",RTP_PT_RESERVED);
+		status &= SDP_LITERAL_INSERT(stream,"m=audio 0 RTP/AVP ");
+		status &= sdp_number_insert(stream,RTP_PT_RESERVED);
+		status &= apt_text_eol_insert(stream);
 	}
 
-	offset += snprintf(buffer+offset,size-offset,"a=mid:%"APR_SIZE_T_FMT"\r\n",audio_media->mid);
-	return offset;
+	status &= SDP_LITERAL_INSERT(stream,"a=mid:");
+	status &= sdp_number_insert(stream,audio_media->mid);
+	status &= apt_text_eol_insert(stream);
+	return status;
 }
 
 /** Generate SDP media by MRCP control media descriptor */
-static apr_size_t sdp_control_media_generate(char *buffer, apr_size_t size, const mrcp_session_descriptor_t *descriptor, const mrcp_control_descriptor_t *control_media, apt_bool_t offer)
+static apt_bool_t sdp_control_media_generate(apt_text_stream_t *stream, const mrcp_session_descriptor_t *descriptor, const mrcp_control_descriptor_t *control_media, apt_bool_t offer)
 {
 	int i;
-	apr_size_t offset = 0;
+	apt_bool_t status = TRUE;
 	const apt_str_t *proto;
 	const apt_str_t *setup_type;
 	const apt_str_t *connection_type;
 	proto = mrcp_proto_get(control_media->proto);
 	setup_type = mrcp_setup_type_get(control_media->setup_type);
 	connection_type = mrcp_connection_type_get(control_media->connection_type);
-	if(offer == TRUE) { /* offer */
-		if(control_media->port) {
-			offset += snprintf(buffer+offset,size-offset,
-				"m=application %d %s 1\r\n"
-				"a=setup:%s\r\n"
-				"a=connection:%s\r\n"
-				"a=resource:%s\r\n",
-				control_media->port,
-				proto ? proto->buf : "",
-				setup_type ? setup_type->buf : "",
-				connection_type ? connection_type->buf : "",
-				control_media->resource_name.buf);
 
+	status &= SDP_LITERAL_INSERT(stream,"m=application ");
+	status &= sdp_number_insert(stream,control_media->port);
+	status &= apt_text_space_insert(stream);
+	status &= sdp_str_insert(stream,proto);
+	status &= SDP_LITERAL_INSERT(stream," 1\r\n");
+	if(control_media->port) {
+		status &= SDP_LITERAL_INSERT(stream,"a=setup:");
+		status &= sdp_str_insert(stream,setup_type);
+		status &= SDP_LITERAL_INSERT(stream,"\r\na=connection:");
+		status &= sdp_str_insert(stream,connection_type);
+		status &= apt_text_eol_insert(stream);
+		if(control_media->proto == MRCP_PROTO_UNIX && control_media->path.length) {
+			status &= SDP_LITERAL_INSERT(stream,"a=unix-path:");
+			status &= apt_text_string_insert(stream,&control_media->path);
+			status &= apt_text_eol_insert(stream);
 		}
-		else {
-			offset += snprintf(buffer+offset,size-offset,
-				"m=application %d %s 1\r\n"
-				"a=resource:%s\r\n",
-				control_media->port,
-				proto ? proto->buf : "",
-				control_media->resource_name.buf);
-		}
+	}
+	if(offer == TRUE) { /* offer */
+		status &= SDP_LITERAL_INSERT(stream,"a=resource:");
+		status &= apt_text_string_insert(stream,&control_media->resource_name);
 	}
 	else { /* answer */
-		if(control_media->port) {
-			offset += snprintf(buffer+offset,size-offset,
-				"m=application %d %s 1\r\n"
-				"a=setup:%s\r\n"
-				"a=connection:%s\r\n"
-				"a=channel:%s@%s\r\n",
-				control_media->port,
-				proto ? proto->buf : "",
-				setup_type ? setup_type->buf : "",
-				connection_type ? connection_type->buf : "",
-				control_media->session_id.buf,
-				control_media->resource_name.buf);
-		}
-		else {
-			offset += snprintf(buffer+offset,size-offset,
-				"m=application %d %s 1\r\n"
-				"a=channel:%s@%s\r\n",
-				control_media->port,
-				proto ? proto->buf : "",
-				control_media->session_id.buf,
-				control_media->resource_name.buf);
-		}
+		status &= SDP_LITERAL_INSERT(stream,"a=channel:");
+		status &= apt_text_string_insert(stream,&control_media->session_id);
+		status &= apt_text_char_insert(stream,'@');
+		status &= apt_text_string_insert(stream,&control_media->resource_name);
 	}
+	status &= apt_text_eol_insert(stream);
 
 	for(i=0; i<control_media->cmid_arr->nelts; i++) {
-		offset += snprintf(buffer+offset,size-offset,
-			"a=cmid:%"APR_SIZE_T_FMT"\r\n",
-			APR_ARRAY_IDX(control_media->cmid_arr,i,apr_size_t));
+		status &= SDP_LITERAL_INSERT(stream,"a=cmid:");
+		status &= sdp_number_insert(stream,APR_ARRAY_IDX(control_media->cmid_arr,i,apr_size_t));
+		status &= apt_text_eol_insert(stream);
 	}
-
-	return offset;
+	return status;
 }
 
 /** Generate RTP media descriptor by SDP media */
@@ -283,6 +357,22 @@ static apt_bool_t mpf_rtp_media_generate(mpf_rtp_media_descriptor_t *rtp_media,
 			case RTP_ATTRIB_PTIME:
 				rtp_media->ptime = (apr_uint16_t)atoi(attrib->a_value);
 				break;
+			case RTP_ATTRIB_RTCP_MUX:
+				rtp_media->rtcp_mux = TRUE;
+				break;
+			case RTP_ATTRIB_CRYPTO:
+			{
+				/* use the first crypto attribute of a supported suite */
+				mpf_srtp_crypto_t *crypto;
+				if(rtp_media->crypto) {
+					break;
+				}
+				crypto = mpf_srtp_crypto_parse(attrib->a_value,pool);
+				if(crypto && mpf_srtp_crypto_suite_supported(crypto->suite) == TRUE) {
+					rtp_media->crypto = crypto;
+				}
+				break;
+			}
 			default:
 				break;
 		}
@@ -294,8 +384,10 @@ static apt_bool_t mpf_rtp_media_generate(mpf_rtp_media_descriptor_t *rtp_media,
 		if(codec) {
 			codec->payload_type = (apr_byte_t)map->rm_pt;
 			apt_string_assign(&codec->name,map->rm_encoding,pool);
-			codec->sampling_rate = (apr_uint16_t)map->rm_rate;
-			codec->channel_count = 1;
+			mpf_codec_rtpmap_apply(
+				codec,
+				(apr_uint32_t)map->rm_rate,
+				map->rm_params ? (apr_byte_t)atoi(map->rm_params) : 1);
 		}
 	}
 
@@ -339,7 +431,7 @@ static apt_bool_t mrcp_control_media_generate(mrcp_control_descriptor_t *control
 	sdp_attribute_t *attrib = NULL;
 	apt_string_set(&name,sdp_media->m_proto_name);
 	control_media->proto = mrcp_proto_find(&name);
-	if(control_media->proto != MRCP_PROTO_TCP) {
+	if(control_media->proto == MRCP_PROTO_UNKNOWN) {
 		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Not supported SDP Proto [%s], expected [%s]",sdp_media->m_proto_name,mrcp_proto_get(MRCP_PROTO_TCP)->buf);
 		return FALSE;
 	}
@@ -366,6 +458,9 @@ static apt_bool_t mrcp_control_media_generate(mrcp_control_descriptor_t *control
 			case MRCP_ATTRIB_CMID:
 				mrcp_cmid_add(control_media->cmid_arr,atoi(attrib->a_value));
 				break;
+			case MRCP_ATTRIB_UNIX_PATH:
+				apt_string_assign(&control_media->path,attrib->a_value,pool);
+				break;
 			default:
 				break;
 		}
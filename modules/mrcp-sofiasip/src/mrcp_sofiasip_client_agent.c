@@ -54,6 +54,8 @@ struct mrcp_sofia_agent_t {
 struct mrcp_sofia_session_t {
 	mrcp_session_t            *session;
 	const mrcp_sig_settings_t *sip_settings;
+	mrcp_sig_endpoint_t       *endpoint;
+	apr_uint32_t               tried_endpoints;
 
 	su_home_t                 *home;
 	nua_handle_t              *nh;
@@ -260,36 +262,29 @@ static APR_INLINE mrcp_sofia_agent_t* mrcp_sofia_agent_get(mrcp_session_t *sessi
 	return session->signaling_agent->obj;
 }
 
-static apt_bool_t mrcp_sofia_session_create(mrcp_session_t *session, const mrcp_sig_settings_t *settings)
+/** Create NUA handle addressed to the selected server endpoint (if any) */
+static void mrcp_sofia_session_handle_create(mrcp_sofia_agent_t *sofia_agent, mrcp_sofia_session_t *sofia_session)
 {
 	const char *sip_to_str;
-	mrcp_sofia_agent_t *sofia_agent = mrcp_sofia_agent_get(session);
-	mrcp_sofia_session_t *sofia_session;
-	session->request_vtable = &session_request_vtable;
-
-	if(!sofia_agent->nua) {
-		return FALSE;
+	mrcp_session_t *session = sofia_session->session;
+	const mrcp_sig_settings_t *settings = sofia_session->sip_settings;
+	const char *server_ip = settings->server_ip;
+	apr_port_t server_port = settings->server_port;
+	if(sofia_session->endpoint) {
+		server_ip = sofia_session->endpoint->server_ip;
+		server_port = sofia_session->endpoint->server_port;
 	}
 
-	sofia_session = apr_palloc(session->pool,sizeof(mrcp_sofia_session_t));
-	sofia_session->mutex = NULL;
-	sofia_session->home = su_home_new(sizeof(*sofia_session->home));
-	sofia_session->session = session;
-	sofia_session->sip_settings = settings;
-	sofia_session->terminate_requested = FALSE;
-	sofia_session->descriptor = NULL;
-	session->obj = sofia_session;
-
 	if(settings->user_name && *settings->user_name != '\0') {
 		sip_to_str = apr_psprintf(session->pool,"sip:%s@%s:%hu",
 										settings->user_name,
-										settings->server_ip,
-										settings->server_port);
+										server_ip,
+										server_port);
 	}
 	else {
 		sip_to_str = apr_psprintf(session->pool,"sip:%s:%hu",
-										settings->server_ip,
-										settings->server_port);
+										server_ip,
+										server_port);
 	}
 
 	sofia_session->nh = nua_handle(
@@ -300,6 +295,43 @@ static apt_bool_t mrcp_sofia_session_create(mrcp_session_t *session, const mrcp_
 				TAG_IF(sofia_agent->sip_contact_str,SIPTAG_CONTACT_STR(sofia_agent->sip_contact_str)),
 				TAG_IF(settings->feature_tags,SIPTAG_ACCEPT_CONTACT_STR(settings->feature_tags)),
 				TAG_END());
+}
+
+static apt_bool_t mrcp_sofia_session_create(mrcp_session_t *session, const mrcp_sig_settings_t *settings)
+{
+	mrcp_sofia_agent_t *sofia_agent = mrcp_sofia_agent_get(session);
+	mrcp_sofia_session_t *sofia_session;
+	mrcp_sig_endpoint_t *endpoint = NULL;
+	apr_uint32_t tried_endpoints = 0;
+	session->request_vtable = &session_request_vtable;
+
+	if(!sofia_agent->nua) {
+		return FALSE;
+	}
+
+	if(settings->endpoints) {
+		endpoint = mrcp_signaling_settings_endpoint_select(settings,&tried_endpoints);
+		if(!endpoint) {
+			/* fail fast, all the circuits are open */
+			apt_obj_log(APT_LOG_MARK,APT_PRIO_WARNING,session->log_obj,"No Server Endpoint Available "APT_NAMESID_FMT,
+				session->name,
+				MRCP_SESSION_SID(session));
+			return FALSE;
+		}
+	}
+
+	sofia_session = apr_palloc(session->pool,sizeof(mrcp_sofia_session_t));
+	sofia_session->mutex = NULL;
+	sofia_session->home = su_home_new(sizeof(*sofia_session->home));
+	sofia_session->session = session;
+	sofia_session->sip_settings = settings;
+	sofia_session->endpoint = endpoint;
+	sofia_session->tried_endpoints = tried_endpoints;
+	sofia_session->terminate_requested = FALSE;
+	sofia_session->descriptor = NULL;
+	session->obj = sofia_session;
+
+	mrcp_sofia_session_handle_create(sofia_agent,sofia_session);
 	sofia_session->nua_state = nua_callstate_init;
 
 	apr_thread_mutex_create(&sofia_session->mutex,APR_THREAD_MUTEX_DEFAULT,session->pool);
@@ -422,6 +454,10 @@ static void mrcp_sofia_on_session_ready(
 	mrcp_session_descriptor_t *descriptor = mrcp_session_descriptor_create(session->pool);
 	descriptor->response_code = status;
 
+	if(sofia_session->endpoint) {
+		mrcp_signaling_settings_endpoint_report(sofia_session->sip_settings,sofia_session->endpoint,TRUE);
+	}
+
 	tl_gets(tags, 
 			SOATAG_REMOTE_SDP_STR_REF(remote_sdp_str),
 			TAG_END());
@@ -438,7 +474,8 @@ static void mrcp_sofia_on_session_ready(
 		parser = sdp_parse(sofia_session->home,remote_sdp_str,(int)strlen(remote_sdp_str),0);
 		sdp = sdp_session(parser);
 		if(sofia_session->sip_settings->force_destination == TRUE) {
-			force_destination_ip = sofia_session->sip_settings->server_ip;
+			force_destination_ip = sofia_session->endpoint ?
+				sofia_session->endpoint->server_ip : sofia_session->sip_settings->server_ip;
 		}
 
 		mrcp_descriptor_generate_by_sdp_session(descriptor,sdp,force_destination_ip,session->pool);
@@ -492,6 +529,50 @@ static void mrcp_sofia_on_session_redirect(
 	mrcp_sofia_session_offer(sofia_session->session,sofia_session->descriptor);
 }
 
+/** Fail over the offer rejected by (or timed out at) the server to the next endpoint */
+static apt_bool_t mrcp_sofia_on_session_failover(
+						int                   status,
+						mrcp_sofia_agent_t   *sofia_agent,
+						mrcp_sofia_session_t *sofia_session)
+{
+	mrcp_session_t *session = sofia_session->session;
+	mrcp_sig_endpoint_t *endpoint = sofia_session->endpoint;
+	if(!endpoint || !sofia_session->descriptor || sofia_session->terminate_requested == TRUE || sofia_session->nua_state == nua_callstate_ready) {
+		return FALSE;
+	}
+	if(status != 408 && status != 503) {
+		/* the server is alive, the offer has been rejected for another reason */
+		mrcp_signaling_settings_endpoint_report(sofia_session->sip_settings,endpoint,TRUE);
+		return FALSE;
+	}
+
+	mrcp_signaling_settings_endpoint_report(sofia_session->sip_settings,endpoint,FALSE);
+	endpoint = mrcp_signaling_settings_endpoint_select(sofia_session->sip_settings,&sofia_session->tried_endpoints);
+	if(!endpoint) {
+		return FALSE;
+	}
+
+	apt_obj_log(APT_LOG_MARK,APT_PRIO_NOTICE,session->log_obj,"Failover "APT_NAMESID_FMT" to %s:%hu [%d]",
+		session->name,
+		MRCP_SESSION_SID(session),
+		endpoint->server_ip,
+		endpoint->server_port,
+		status);
+
+	apr_thread_mutex_lock(sofia_session->mutex);
+	if(sofia_session->nh) {
+		nua_handle_bind(sofia_session->nh, NULL);
+		nua_handle_destroy(sofia_session->nh);
+		sofia_session->nh = NULL;
+	}
+	sofia_session->endpoint = endpoint;
+	mrcp_sofia_session_handle_create(sofia_agent,sofia_session);
+	sofia_session->nua_state = nua_callstate_init;
+	apr_thread_mutex_unlock(sofia_session->mutex);
+
+	return mrcp_sofia_session_offer(session,sofia_session->descriptor);
+}
+
 static void mrcp_sofia_on_session_terminate(
 						int                   status,
 						mrcp_sofia_agent_t   *sofia_agent,
@@ -549,6 +630,9 @@ static void mrcp_sofia_on_state_change(
 		nua_callstate_name(nua_state));
 
 	if(nua_state == nua_callstate_terminated) {
+		if(mrcp_sofia_on_session_failover(status,sofia_agent,sofia_session) == TRUE) {
+			return;
+		}
 		mrcp_sofia_on_session_terminate(status,sofia_agent,nh,sofia_session,sip,tags);
 		return;
 	}
@@ -16,6 +16,8 @@
  * $Id$
  */
 
+#include <limits.h>
+
 typedef struct mrcp_sofia_agent_t mrcp_sofia_agent_t;
 #define NUA_MAGIC_T mrcp_sofia_agent_t
 
@@ -31,11 +33,13 @@ typedef struct mrcp_sofia_session_t mrcp_sofia_session_t;
 #undef strcasecmp
 #undef strncasecmp
 #include <apr_general.h>
+#include <apr_strings.h>
 
 #include "mrcp_sofiasip_server_agent.h"
 #include "mrcp_session.h"
 #include "mrcp_session_descriptor.h"
 #include "mrcp_sdp.h"
+#include "apt_pool.h"
 #include "apt_log.h"
 
 struct mrcp_sofia_agent_t {
@@ -44,6 +48,8 @@ struct mrcp_sofia_agent_t {
 	mrcp_sofia_server_config_t *config;
 	char                       *sip_contact_str;
 	char                       *sip_bind_str;
+	/** Resource discovery SDP, which depends on the config only */
+	char                       *discovery_sdp_str;
 
 	su_root_t                  *root;
 	nua_t                      *nua;
@@ -135,8 +141,14 @@ MRCP_DECLARE(mrcp_sofia_server_config_t*) mrcp_sofiasip_server_config_alloc(apr_
 	config->sip_t4 = 0;
 	config->sip_t1x64 = 0;
 
+	/* trunks from proxies are kept open and alive by default */
+	config->tport_reuse = TRUE;
+	config->tport_idle_timeout = 0;
+	config->tport_keepalive = 30000;
+
 	config->tport_log = FALSE;
 	config->tport_dump_file = NULL;
+	config->load_header = NULL;
 
 	return config;
 }
@@ -146,6 +158,23 @@ MRCP_DECLARE(apt_bool_t) mrcp_sofiasip_server_logger_init(const char *name, cons
 	return mrcp_sofiasip_log_init(name,level_str,redirect);
 }
 
+/** Generate resource discovery SDP to respond to OPTIONS with */
+static void mrcp_sofia_discovery_sdp_generate(mrcp_sofia_agent_t *sofia_agent, apr_pool_t *pool)
+{
+	char sdp_str[2048];
+	apr_size_t length;
+	const char *ip = sofia_agent->config->ext_ip ? 
+		sofia_agent->config->ext_ip : sofia_agent->config->local_ip;
+
+	sofia_agent->discovery_sdp_str = NULL;
+	length = sdp_resource_discovery_string_generate(ip,sofia_agent->config->origin,sdp_str,sizeof(sdp_str));
+	if(length > 0) {
+		sofia_agent->discovery_sdp_str = apr_pstrmemdup(pool,sdp_str,length);
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Resource Discovery SDP\n[%s]\n", 
+				sofia_agent->discovery_sdp_str);
+	}
+}
+
 static apt_bool_t mrcp_sofia_config_validate(mrcp_sofia_agent_t *sofia_agent, mrcp_sofia_server_config_t *config, apr_pool_t *pool)
 {
 	sofia_agent->config = config;
@@ -165,6 +194,7 @@ static apt_bool_t mrcp_sofia_config_validate(mrcp_sofia_agent_t *sofia_agent, mr
 											config->local_ip,
 											config->local_port);
 	}
+	mrcp_sofia_discovery_sdp_generate(sofia_agent,pool);
 	return TRUE;
 }
 
@@ -192,6 +222,9 @@ static void mrcp_sofia_task_initialize(apt_task_t *task)
 		TAG_IF(sofia_config->sip_t2,NTATAG_SIP_T2(sofia_config->sip_t2)),
 		TAG_IF(sofia_config->sip_t4,NTATAG_SIP_T4(sofia_config->sip_t4)),
 		TAG_IF(sofia_config->sip_t1x64,NTATAG_SIP_T1X64(sofia_config->sip_t1x64)),
+		TPTAG_REUSE(sofia_config->tport_reuse == TRUE ? 1 : 0), /* Reuse connections to the same peer */
+		TPTAG_IDLE(sofia_config->tport_idle_timeout ? (unsigned)sofia_config->tport_idle_timeout : UINT_MAX), /* Never close idle connections by default */
+		TAG_IF(sofia_config->tport_keepalive,TPTAG_KEEPALIVE((unsigned)sofia_config->tport_keepalive)),
 		SIPTAG_USER_AGENT_STR(sofia_config->user_agent_name),
 		TAG_IF(sofia_config->tport_log == TRUE,TPTAG_LOG(1)), /* Print out SIP messages to the console */
 		TAG_IF(sofia_config->tport_dump_file,TPTAG_DUMP(sofia_config->tport_dump_file)), /* Dump SIP messages to the file */
@@ -267,25 +300,56 @@ static int sip_status_get(mrcp_session_status_e status)
 			return 480;
 		case MRCP_SESSION_STATUS_ERROR:
 			return 500;
+		case MRCP_SESSION_STATUS_OVERLOADED:
+			return 503;
 	}
 	return 200;
 }
 
+/** Compose the header reporting the load of the server, if configured */
+static const char* mrcp_sofia_load_header_compose(mrcp_sofia_agent_t *sofia_agent, char *buf, apr_size_t size)
+{
+	apr_pool_t *pool;
+	char *load_str;
+	mrcp_sig_agent_t *sig_agent = sofia_agent->sig_agent;
+	if(!sofia_agent->config->load_header || !sig_agent->render_load) {
+		return NULL;
+	}
+
+	pool = apt_pool_create();
+	load_str = sig_agent->render_load(sig_agent,pool);
+	if(load_str) {
+		apr_snprintf(buf,size,"%s: %s",sofia_agent->config->load_header,load_str);
+	}
+	apr_pool_destroy(pool);
+	return load_str ? buf : NULL;
+}
+
 static apt_bool_t mrcp_sofia_on_session_answer(mrcp_session_t *session, mrcp_session_descriptor_t *descriptor)
 {
 	mrcp_sofia_session_t *sofia_session = session->obj;
 	mrcp_sofia_agent_t *sofia_agent = session->signaling_agent->obj;
 	const char *local_sdp_str = NULL;
+	const char *load_header_str;
 	char sdp_str[2048];
+	char load_str[512];
 
 	if(!sofia_agent || !sofia_session || !sofia_session->nh) {
 		return FALSE;
 	}
 
+	load_header_str = mrcp_sofia_load_header_compose(sofia_agent,load_str,sizeof(load_str));
+
 	if(descriptor->status != MRCP_SESSION_STATUS_OK) {
 		int status = sip_status_get(descriptor->status);
+		char retry_after_str[32];
+		if(descriptor->retry_after) {
+			apr_snprintf(retry_after_str,sizeof(retry_after_str),"%"APR_SIZE_T_FMT,descriptor->retry_after);
+		}
 		nua_respond(sofia_session->nh, status, sip_status_phrase(status),
 					TAG_IF(sofia_agent->sip_contact_str,SIPTAG_CONTACT_STR(sofia_agent->sip_contact_str)),
+					TAG_IF(descriptor->retry_after,SIPTAG_RETRY_AFTER_STR(retry_after_str)),
+					TAG_IF(load_header_str,SIPTAG_HEADER_STR(load_header_str)),
 					TAG_END());
 		return TRUE;
 	}
@@ -307,6 +371,7 @@ static apt_bool_t mrcp_sofia_on_session_answer(mrcp_session_t *session, mrcp_ses
 				TAG_IF(local_sdp_str,SOATAG_USER_SDP_STR(local_sdp_str)),
 				SOATAG_AUDIO_AUX("telephone-event"),
 				NUTAG_AUTOANSWER(0),
+				TAG_IF(load_header_str,SIPTAG_HEADER_STR(load_header_str)),
 				TAG_END());
 	
 	return TRUE;
@@ -420,23 +485,18 @@ static void mrcp_sofia_on_resource_discover(mrcp_sofia_agent_t   *sofia_agent,
 									        sip_t const          *sip,
 									        tagi_t                tags[])
 {
-	char sdp_str[2048];
-	const char *local_sdp_str = NULL;
-
-	const char *ip = sofia_agent->config->ext_ip ? 
-		sofia_agent->config->ext_ip : sofia_agent->config->local_ip;
-
-	if(sdp_resource_discovery_string_generate(ip,sofia_agent->config->origin,sdp_str,sizeof(sdp_str)) > 0) {
-		local_sdp_str = sdp_str;
-		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Resource Discovery SDP\n[%s]\n", 
-				local_sdp_str);
-	}
+	/* the SDP is generated once at startup, OPTIONS (often health checks) just respond with it */
+	const char *local_sdp_str = sofia_agent->discovery_sdp_str;
+	/* the load is rendered per request, so that proxies probing the server get the current one */
+	char load_str[512];
+	const char *load_header_str = mrcp_sofia_load_header_compose(sofia_agent,load_str,sizeof(load_str));
 
 	nua_respond(nh, SIP_200_OK, 
 				NUTAG_WITH_CURRENT(sofia_agent->nua),
 				TAG_IF(sofia_agent->sip_contact_str,SIPTAG_CONTACT_STR(sofia_agent->sip_contact_str)),
 				TAG_IF(local_sdp_str,SOATAG_USER_SDP_STR(local_sdp_str)),
 				SOATAG_AUDIO_AUX("telephone-event"),
+				TAG_IF(load_header_str,SIPTAG_HEADER_STR(load_header_str)),
 				TAG_END());
 }
 
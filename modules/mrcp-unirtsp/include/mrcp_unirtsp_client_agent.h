@@ -41,6 +41,8 @@ struct rtsp_client_config_t {
 	apr_size_t   max_connection_count;
 	/** Request timeout */
 	apr_size_t   request_timeout;
+	/** Keep connections open for subsequent sessions */
+	apt_bool_t   keep_alive;
 };
 
 /**
@@ -71,6 +71,15 @@ MRCP_DECLARE(mrcp_session_descriptor_t*) mrcp_resource_discovery_response_genera
 											apr_pool_t *pool,
 											su_home_t *home);
 
+/** Generate SDP of RTSP resource discovery response */
+MRCP_DECLARE(apr_size_t) rtsp_resource_discovery_string_generate(const char *ip, const char *origin, char *buffer, apr_size_t size);
+
+/** Create RTSP resource discovery response with SDP generated in advance */
+MRCP_DECLARE(rtsp_message_t*) rtsp_resource_discovery_response_create(
+											const rtsp_message_t *request,
+											const apt_str_t *sdp,
+											apr_pool_t *pool);
+
 /** Generate RTSP resource discovery response */
 MRCP_DECLARE(rtsp_message_t*) rtsp_resource_discovery_response_generate(
 											const rtsp_message_t *request,
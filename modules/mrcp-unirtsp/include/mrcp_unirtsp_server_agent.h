@@ -49,6 +49,12 @@ struct rtsp_server_config_t {
 
 	/** Number of max RTSP connections */
 	apr_size_t   max_connection_count;
+	/** Number of poller threads to process RTSP connections by */
+	apr_size_t   worker_count;
+	/** Share the port with the agents of other worker processes */
+	apt_bool_t   shared_port;
+	/** Time in seconds accepting connections is deferred for until data arrives (0 - not deferred) */
+	apr_size_t   defer_accept;
 
 	/** Force destination IP address. Should be used only in case 
 	SDP contains incorrect connection address (local IP address behind NAT) */
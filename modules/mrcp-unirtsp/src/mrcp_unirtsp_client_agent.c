@@ -104,6 +104,8 @@ MRCP_DECLARE(mrcp_sig_agent_t*) mrcp_unirtsp_client_agent_create(const char *id,
 		return NULL;
 	}
 
+	rtsp_client_keep_alive_set(agent->rtsp_client,config->keep_alive);
+
 	task = rtsp_client_task_get(agent->rtsp_client);
 	agent->sig_agent->task = task;
 
@@ -117,6 +119,7 @@ MRCP_DECLARE(rtsp_client_config_t*) mrcp_unirtsp_client_config_alloc(apr_pool_t
 	config->origin = NULL;
 	config->max_connection_count = 100;
 	config->request_timeout = 0;
+	config->keep_alive = FALSE;
 	return config;
 }
 
@@ -379,6 +382,8 @@ static apt_bool_t mrcp_unirtsp_session_control(mrcp_session_t *mrcp_session, mrc
 									mrcp_message->channel_id.resource_name.buf);
 	rtsp_message->start_line.common.request_line.method_id = RTSP_METHOD_ANNOUNCE;
 
+	/* MRCPv1 message is carried in the body of RTSP message as a whole */
+	mrcp_message_body_flatten(mrcp_message);
 	body = &rtsp_message->body;
 	body->length = mrcp_message->start_line.length;
 	body->buf = apr_palloc(rtsp_message->pool,body->length+1);
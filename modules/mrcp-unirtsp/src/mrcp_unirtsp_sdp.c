@@ -39,7 +39,7 @@ static apr_size_t sdp_rtp_media_generate(char *buffer, apr_size_t size, const mr
 		if(!descriptor_arr) {
 			return 0;
 		}
-		offset += snprintf(buffer+offset,size-offset,"m=audio %d RTP/AVP",audio_media->port);
+		offset += snprintf(buffer+offset,size-offset,"m=audio %d %s",audio_media->port,audio_media->crypto ? "RTP/SAVP" : "RTP/AVP");
 		for(i=0; i<descriptor_arr->nelts; i++) {
 			codec_descriptor = &APR_ARRAY_IDX(descriptor_arr,i,mpf_codec_descriptor_t);
 			if(codec_descriptor->enabled == TRUE) {
@@ -56,10 +56,15 @@ static apr_size_t sdp_rtp_media_generate(char *buffer, apr_size_t size, const mr
 		for(i=0; i<descriptor_arr->nelts; i++) {
 			codec_descriptor = &APR_ARRAY_IDX(descriptor_arr,i,mpf_codec_descriptor_t);
 			if(codec_descriptor->enabled == TRUE && codec_descriptor->name.buf) {
-				offset += snprintf(buffer+offset,size-offset,"a=rtpmap:%d %s/%d\r\n",
+				apr_byte_t channel_count = mpf_codec_rtp_channel_count_get(codec_descriptor);
+				offset += snprintf(buffer+offset,size-offset,"a=rtpmap:%d %s/%u",
 					codec_descriptor->payload_type,
 					codec_descriptor->name.buf,
-					codec_descriptor->sampling_rate);
+					mpf_codec_rtp_clock_rate_get(codec_descriptor));
+				if(channel_count > 1) {
+					offset += snprintf(buffer+offset,size-offset,"/%d",channel_count);
+				}
+				offset += snprintf(buffer+offset,size-offset,"\r\n");
 				if(codec_descriptor->format.buf) {
 					offset += snprintf(buffer+offset,size-offset,"a=fmtp:%d %s\r\n",
 						codec_descriptor->payload_type,
@@ -76,6 +81,16 @@ static apr_size_t sdp_rtp_media_generate(char *buffer, apr_size_t size, const mr
 		if(audio_media->ptime) {
 			offset += snprintf(buffer+offset,size-offset,"a=ptime:%hu\r\n",audio_media->ptime);
 		}
+
+		if(audio_media->rtcp_mux == TRUE) {
+			offset += snprintf(buffer+offset,size-offset,"a=rtcp-mux\r\n");
+		}
+
+		if(audio_media->crypto) {
+			offset += snprintf(buffer+offset,size-offset,"a=crypto:");
+			offset += mpf_srtp_crypto_generate(audio_media->crypto,buffer+offset,size-offset);
+			offset += snprintf(buffer+offset,size-offset,"\r\n");
+		}
 	}
 	else {
 		offset += snprintf(buffer+offset,size-offset,"m=audio 0 RTP/AVP %d\r\n",RTP_PT_RESERVED);
@@ -99,6 +114,22 @@ static apt_bool_t mpf_rtp_media_generate(mpf_rtp_media_descriptor_t *rtp_media,
 			case RTP_ATTRIB_PTIME:
 				rtp_media->ptime = (apr_uint16_t)atoi(attrib->a_value);
 				break;
+			case RTP_ATTRIB_RTCP_MUX:
+				rtp_media->rtcp_mux = TRUE;
+				break;
+			case RTP_ATTRIB_CRYPTO:
+			{
+				/* use the first crypto attribute of a supported suite */
+				mpf_srtp_crypto_t *crypto;
+				if(rtp_media->crypto) {
+					break;
+				}
+				crypto = mpf_srtp_crypto_parse(attrib->a_value,pool);
+				if(crypto && mpf_srtp_crypto_suite_supported(crypto->suite) == TRUE) {
+					rtp_media->crypto = crypto;
+				}
+				break;
+			}
 			default:
 				break;
 		}
@@ -110,8 +141,10 @@ static apt_bool_t mpf_rtp_media_generate(mpf_rtp_media_descriptor_t *rtp_media,
 		if(codec) {
 			codec->payload_type = (apr_byte_t)map->rm_pt;
 			apt_string_assign(&codec->name,map->rm_encoding,pool);
-			codec->sampling_rate = (apr_uint16_t)map->rm_rate;
-			codec->channel_count = 1;
+			mpf_codec_rtpmap_apply(
+				codec,
+				(apr_uint32_t)map->rm_rate,
+				map->rm_params ? (apr_byte_t)atoi(map->rm_params) : 1);
 		}
 	}
 
@@ -389,6 +422,9 @@ MRCP_DECLARE(rtsp_message_t*) rtsp_response_generate_by_mrcp_descriptor(const rt
 		case MRCP_SESSION_STATUS_ERROR:
 			response = rtsp_response_create(request,RTSP_STATUS_CODE_INTERNAL_SERVER_ERROR,RTSP_REASON_PHRASE_INTERNAL_SERVER_ERROR,pool);
 			break;
+		case MRCP_SESSION_STATUS_OVERLOADED:
+			response = rtsp_response_create(request,RTSP_STATUS_CODE_SERVICE_UNAVAILABLE,RTSP_REASON_PHRASE_SERVICE_UNAVAILABLE,pool);
+			break;
 	}
 
 	if(!response) {
@@ -518,6 +554,53 @@ MRCP_DECLARE(mrcp_session_descriptor_t*) mrcp_resource_discovery_response_genera
 	return descriptor;
 }
 
+/** Generate SDP of RTSP resource discovery response */
+MRCP_DECLARE(apr_size_t) rtsp_resource_discovery_string_generate(const char *ip, const char *origin, char *buffer, apr_size_t size)
+{
+	apr_size_t offset = 0;
+	if(!ip) {
+		ip = "0.0.0.0";
+	}
+	if(!origin) {
+		origin = "-";
+	}
+
+	buffer[0] = '\0';
+	offset += snprintf(buffer+offset,size-offset,
+		"v=0\r\n"
+		"o=%s 0 0 IN IP4 %s\r\n"
+		"s=-\r\n"
+		"c=IN IP4 %s\r\n"
+		"t=0 0\r\n"
+		"m=audio 0 RTP/AVP 0 8 96 101\r\n"
+		"a=rtpmap:0 PCMU/8000\r\n"
+		"a=rtpmap:8 PCMA/8000\r\n"
+		"a=rtpmap:96 L16/8000\r\n"
+		"a=rtpmap:101 telephone-event/8000\r\n",
+		origin,
+		ip,
+		ip);
+	return offset;
+}
+
+/** Create RTSP resource discovery response with SDP generated in advance */
+MRCP_DECLARE(rtsp_message_t*) rtsp_resource_discovery_response_create(
+											const rtsp_message_t *request,
+											const apt_str_t *sdp,
+											apr_pool_t *pool)
+{
+	rtsp_message_t *response = rtsp_response_create(request,RTSP_STATUS_CODE_OK,RTSP_REASON_PHRASE_OK,pool);
+	if(response && sdp && sdp->length) {
+		/* the body is only read by the generator, refer to the SDP rather than copy it */
+		response->body = *sdp;
+		response->header.content_type = RTSP_CONTENT_TYPE_SDP;
+		rtsp_header_property_add(&response->header,RTSP_HEADER_FIELD_CONTENT_TYPE,response->pool);
+		response->header.content_length = sdp->length;
+		rtsp_header_property_add(&response->header,RTSP_HEADER_FIELD_CONTENT_LENGTH,response->pool);
+	}
+	return response;
+}
+
 /** Generate RTSP resource discovery response */
 MRCP_DECLARE(rtsp_message_t*) rtsp_resource_discovery_response_generate(
 											const rtsp_message_t *request, 
@@ -525,45 +608,14 @@ MRCP_DECLARE(rtsp_message_t*) rtsp_resource_discovery_response_generate(
 											const char *origin,
 											apr_pool_t *pool)
 {
-	rtsp_message_t *response = rtsp_response_create(request,RTSP_STATUS_CODE_OK,RTSP_REASON_PHRASE_OK,pool);
-	if(response) {
-		apr_size_t offset = 0;
-		char buffer[2048];
-		apr_size_t size = sizeof(buffer);
-		
-		if(!ip) {
-			ip = "0.0.0.0";
-		}
-		if(!origin) {
-			origin = "-";
-		}
-		
-		buffer[0] = '\0';
-		offset += snprintf(buffer+offset,size-offset,
-			"v=0\r\n"
-			"o=%s 0 0 IN IP4 %s\r\n"
-			"s=-\r\n"
-			"c=IN IP4 %s\r\n"
-			"t=0 0\r\n"
-			"m=audio 0 RTP/AVP 0 8 96 101\r\n"
-			"a=rtpmap:0 PCMU/8000\r\n"
-			"a=rtpmap:8 PCMA/8000\r\n"
-			"a=rtpmap:96 L16/8000\r\n"
-			"a=rtpmap:101 telephone-event/8000\r\n",
-			origin,
-			ip,
-			ip);
-		
-		if(offset) {
-			apt_string_assign_n(&response->body,buffer,offset,pool);
-			response->header.content_type = RTSP_CONTENT_TYPE_SDP;
-			rtsp_header_property_add(&response->header,RTSP_HEADER_FIELD_CONTENT_TYPE,response->pool);
-			response->header.content_length = offset;
-			rtsp_header_property_add(&response->header,RTSP_HEADER_FIELD_CONTENT_LENGTH,response->pool);
-		}
+	char buffer[2048];
+	apt_str_t sdp;
+	apr_size_t length = rtsp_resource_discovery_string_generate(ip,origin,buffer,sizeof(buffer));
+	apt_string_reset(&sdp);
+	if(length > 0) {
+		apt_string_assign_n(&sdp,buffer,length,pool);
 	}
-
-	return response;
+	return rtsp_resource_discovery_response_create(request,&sdp,pool);
 }
 
 /** Get MRCP resource name by RTSP resource name */
@@ -38,6 +38,8 @@ struct mrcp_unirtsp_agent_t {
 	rtsp_server_t        *rtsp_server;
 
 	rtsp_server_config_t *config;
+	/** Resource discovery SDP, which depends on the config only */
+	apt_str_t             discovery_sdp;
 };
 
 struct mrcp_unirtsp_session_t {
@@ -71,6 +73,17 @@ static const rtsp_server_vtable_t session_request_vtable = {
 
 static apt_bool_t rtsp_config_validate(mrcp_unirtsp_agent_t *agent, rtsp_server_config_t *config, apr_pool_t *pool);
 
+/** Generate resource discovery SDP to respond to DESCRIBE with */
+static void mrcp_unirtsp_discovery_sdp_generate(mrcp_unirtsp_agent_t *agent, apr_pool_t *pool)
+{
+	char buffer[2048];
+	apr_size_t length = rtsp_resource_discovery_string_generate(agent->config->local_ip,agent->config->origin,buffer,sizeof(buffer));
+	apt_string_reset(&agent->discovery_sdp);
+	if(length > 0) {
+		apt_string_assign_n(&agent->discovery_sdp,buffer,length,pool);
+	}
+}
+
 
 /** Create UniRTSP Signaling Agent */
 MRCP_DECLARE(mrcp_sig_agent_t*) mrcp_unirtsp_server_agent_create(const char *id, rtsp_server_config_t *config, apr_pool_t *pool)
@@ -84,6 +97,7 @@ MRCP_DECLARE(mrcp_sig_agent_t*) mrcp_unirtsp_server_agent_create(const char *id,
 	if(rtsp_config_validate(agent,config,pool) == FALSE) {
 		return NULL;
 	}
+	mrcp_unirtsp_discovery_sdp_generate(agent,pool);
 
 	agent->rtsp_server = rtsp_server_create(
 							id,
@@ -96,6 +110,15 @@ MRCP_DECLARE(mrcp_sig_agent_t*) mrcp_unirtsp_server_agent_create(const char *id,
 	if(!agent->rtsp_server) {
 		return NULL;
 	}
+	if(config->shared_port == TRUE) {
+		rtsp_server_port_share_set(agent->rtsp_server);
+	}
+	if(config->worker_count > 1) {
+		rtsp_server_worker_count_set(agent->rtsp_server,config->worker_count);
+	}
+	if(config->defer_accept) {
+		rtsp_server_defer_accept_set(agent->rtsp_server,config->defer_accept);
+	}
 
 	task = rtsp_server_task_get(agent->rtsp_server);
 	agent->sig_agent->task = task;
@@ -113,6 +136,9 @@ MRCP_DECLARE(rtsp_server_config_t*) mrcp_unirtsp_server_config_alloc(apr_pool_t
 	config->resource_location = NULL;
 	config->resource_map = apr_table_make(pool,2);
 	config->max_connection_count = 100;
+	config->worker_count = 1;
+	config->shared_port = FALSE;
+	config->defer_accept = 0;
 	config->force_destination = FALSE;
 	return config;
 }
@@ -205,6 +231,7 @@ static apt_bool_t mrcp_unirtsp_session_announce(mrcp_unirtsp_agent_t *agent, mrc
 
 		parser = mrcp_parser_create(agent->sig_agent->resource_factory,session->mrcp_session->pool);
 		mrcp_parser_resource_set(parser,&resource_name_str);
+		mrcp_parser_lazy_set(parser,TRUE);
 		if(mrcp_parser_run(parser,&text_stream,&mrcp_message) == APT_MESSAGE_STATUS_COMPLETE) {
 			mrcp_message->channel_id.session_id = message->header.session_id;
 			status = mrcp_session_control_request(session->mrcp_session,mrcp_message);
@@ -265,10 +292,10 @@ static apt_bool_t mrcp_unirtsp_message_handle(rtsp_server_t *rtsp_server, rtsp_s
 		}
 		case RTSP_METHOD_DESCRIBE:
 		{
-			rtsp_message_t *response = rtsp_resource_discovery_response_generate(
+			/* the SDP is generated once at startup */
+			rtsp_message_t *response = rtsp_resource_discovery_response_create(
 						rtsp_message,
-						agent->config->local_ip,
-						agent->config->origin,
+						&agent->discovery_sdp,
 						session->mrcp_session->pool);
 			status = rtsp_server_session_respond(rtsp_server,session->rtsp_session,response);
 			break;
@@ -362,6 +389,8 @@ static apt_bool_t mrcp_unirtsp_on_session_control(mrcp_session_t *mrcp_session,
 		return FALSE;
 	}
 
+	/* MRCPv1 message is carried in the body of RTSP message as a whole */
+	mrcp_message_body_flatten(mrcp_message);
 	body = &rtsp_message->body;
 	body->length = mrcp_message->start_line.length;
 	body->buf = apr_palloc(rtsp_message->pool,body->length+1);
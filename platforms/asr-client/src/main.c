@@ -21,12 +21,23 @@
 #include <apr_getopt.h>
 #include <apr_file_info.h>
 #include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
+#include <apr_atomic.h>
+#include <apr_strings.h>
 #include "asr_engine.h"
 
 typedef struct {
 	const char        *root_dir_path;
 	apt_log_priority_e log_priority;
 	apt_log_output_e   log_output;
+	/** Manifest of grammar/audio pairs to recognize in batch mode (NULL - interactive mode) */
+	const char        *manifest;
+	/** File to write the results of batch mode to (NULL - stdout) */
+	const char        *output;
+	/** Profile of batch mode */
+	const char        *profile;
+	/** Number of concurrent sessions of batch mode */
+	int                session_count;
 	apr_pool_t        *pool;
 } client_options_t;
 
@@ -40,6 +51,56 @@ typedef struct {
 	apr_pool_t        *pool;
 } asr_params_t;
 
+typedef struct {
+	asr_engine_t      *engine;
+	const char        *grammar_file;
+	const char        *input_file;
+	const char        *profile;
+
+	/** Number of sessions not destroyed yet */
+	apr_uint32_t       pending;
+	apr_pool_t        *pool;
+} asr_batch_t;
+
+/** Utterance of manifest */
+typedef struct {
+	const char        *grammar_file;
+	const char        *input_file;
+} asr_utterance_t;
+
+/** Driver of batch recognition over a manifest */
+typedef struct {
+	asr_engine_t       *engine;
+	const char         *profile;
+	/** Utterances to recognize (asr_utterance_t) */
+	apr_array_header_t *utterances;
+	/** Index of the next utterance to recognize */
+	volatile apr_uint32_t next;
+	/** Number of sessions not destroyed yet */
+	volatile apr_uint32_t pending;
+	/** Number of recognized and failed utterances */
+	volatile apr_uint32_t recognized;
+	volatile apr_uint32_t failed;
+	/** Stream the results are written to as JSON lines */
+	FILE               *output;
+	/** Mutex of the output, written from the context of the client stack */
+	apr_thread_mutex_t *mutex;
+	/** Signalled, once all the sessions are destroyed */
+	apr_thread_cond_t  *done;
+	apr_pool_t         *pool;
+} asr_driver_t;
+
+/** Session of driver, reused for the utterances in turn */
+typedef struct {
+	asr_driver_t       *driver;
+	/** Index of the utterance in progress */
+	apr_uint32_t        index;
+	/** Number of utterances recognized in the session */
+	apr_uint32_t        count;
+	/** Time the recognition of the utterance in progress is initiated at */
+	apr_time_t          start_time;
+} asr_driver_slot_t;
+
 /** Thread function to run ASR scenario in */
 static void* APR_THREAD_FUNC asr_session_run(apr_thread_t *thread, void *data)
 {
@@ -101,6 +162,315 @@ static apt_bool_t asr_session_launch(asr_engine_t *engine, const char *grammar_f
 	return TRUE;
 }
 
+/** Callback of asynchronous session destroy */
+static void asr_batch_on_destroy(asr_session_t *session, apt_bool_t status, void *obj)
+{
+	asr_batch_t *batch = obj;
+	if(apr_atomic_dec32(&batch->pending) == 0) {
+		apr_pool_destroy(batch->pool);
+	}
+}
+
+/** Callback of asynchronous recognition */
+static void asr_batch_on_result(asr_session_t *session, const char *result, void *obj)
+{
+	if(result) {
+		printf("Recog Result [%s]",result);
+	}
+	asr_session_destroy_async(session,asr_batch_on_destroy,obj);
+}
+
+/** Callback of asynchronous session create */
+static void asr_batch_on_create(asr_session_t *session, apt_bool_t status, void *obj)
+{
+	asr_batch_t *batch = obj;
+	if(status == FALSE ||
+		asr_session_file_recognize_async(session,batch->grammar_file,batch->input_file,asr_batch_on_result,batch) == FALSE) {
+		asr_session_destroy_async(session,asr_batch_on_destroy,batch);
+	}
+}
+
+/** Launch a number of demo ASR sessions asynchronously from the calling thread */
+static apt_bool_t asr_batch_launch(asr_engine_t *engine, int count, const char *grammar_file, const char *input_file, const char *profile)
+{
+	apr_pool_t *pool;
+	asr_batch_t *batch;
+	int i;
+
+	if(count <= 0) {
+		return FALSE;
+	}
+
+	/* create pool to allocate batch from */
+	apr_pool_create(&pool,NULL);
+	batch = apr_palloc(pool,sizeof(asr_batch_t));
+	batch->pool = pool;
+	batch->engine = engine;
+	batch->grammar_file = grammar_file ? apr_pstrdup(pool,grammar_file) : "grammar.xml";
+	batch->input_file = input_file ? apr_pstrdup(pool,input_file) : "one-8kHz.pcm";
+	batch->profile = profile ? apr_pstrdup(pool,profile) : "uni2";
+	/* one extra reference is held until all the sessions are launched */
+	apr_atomic_set32(&batch->pending,count + 1);
+
+	for(i=0; i<count; i++) {
+		if(!asr_session_create_async(engine,batch->profile,asr_batch_on_create,batch)) {
+			apr_atomic_dec32(&batch->pending);
+		}
+	}
+
+	if(apr_atomic_dec32(&batch->pending) == 0) {
+		apr_pool_destroy(pool);
+	}
+	return TRUE;
+}
+
+/** Load manifest of utterances, one "grammar_file audio_input_file" pair per line */
+static apr_array_header_t* asr_manifest_load(const char *file_path, apr_pool_t *pool)
+{
+	apr_array_header_t *utterances;
+	asr_utterance_t *utterance;
+	apr_file_t *file;
+	apr_finfo_t finfo;
+	char *content;
+	char *line;
+	char *last;
+	char *grammar_file;
+	char *input_file;
+	char *last_token;
+	apr_size_t line_number = 0;
+
+	if(apr_file_open(&file,file_path,APR_FOPEN_READ | APR_FOPEN_BINARY,APR_OS_DEFAULT,pool) != APR_SUCCESS) {
+		printf("Failed to Open Manifest [%s]\n",file_path);
+		return NULL;
+	}
+	if(apr_file_info_get(&finfo,APR_FINFO_SIZE,file) != APR_SUCCESS) {
+		apr_file_close(file);
+		return NULL;
+	}
+	content = apr_palloc(pool,(apr_size_t)finfo.size + 1);
+	if(finfo.size && apr_file_read_full(file,content,(apr_size_t)finfo.size,NULL) != APR_SUCCESS) {
+		printf("Failed to Read Manifest [%s]\n",file_path);
+		apr_file_close(file);
+		return NULL;
+	}
+	content[finfo.size] = '\0';
+	apr_file_close(file);
+
+	utterances = apr_array_make(pool,1024,sizeof(asr_utterance_t));
+	for(line = apr_strtok(content,"\r\n",&last); line; line = apr_strtok(NULL,"\r\n",&last)) {
+		line_number++;
+		grammar_file = apr_strtok(line," \t",&last_token);
+		if(!grammar_file || *grammar_file == '#') {
+			/* empty line or comment */
+			continue;
+		}
+		input_file = apr_strtok(NULL," \t",&last_token);
+		if(!input_file) {
+			printf("Skip Line [%"APR_SIZE_T_FMT"] of Manifest: no audio input file\n",line_number);
+			continue;
+		}
+		utterance = apr_array_push(utterances);
+		utterance->grammar_file = grammar_file;
+		utterance->input_file = input_file;
+	}
+	return utterances;
+}
+
+/** Write string as JSON string literal */
+static void json_string_write(FILE *stream, const char *str)
+{
+	fputc('"',stream);
+	for(; str && *str; str++) {
+		switch(*str) {
+			case '"':  fputs("\\\"",stream); break;
+			case '\\': fputs("\\\\",stream); break;
+			case '\n': fputs("\\n",stream); break;
+			case '\r': fputs("\\r",stream); break;
+			case '\t': fputs("\\t",stream); break;
+			default:
+				if((unsigned char)*str < 0x20) {
+					fprintf(stream,"\\u%04x",(unsigned char)*str);
+				}
+				else {
+					fputc(*str,stream);
+				}
+				break;
+		}
+	}
+	fputc('"',stream);
+}
+
+/** Write result of utterance as JSON line */
+static void asr_driver_result_write(asr_driver_t *driver, apr_uint32_t index, const char *result, apr_time_t latency)
+{
+	const asr_utterance_t *utterance = &APR_ARRAY_IDX(driver->utterances,index,asr_utterance_t);
+	apr_thread_mutex_lock(driver->mutex);
+	fprintf(driver->output,"{\"index\":%u,\"grammar\":",index);
+	json_string_write(driver->output,utterance->grammar_file);
+	fputs(",\"input\":",driver->output);
+	json_string_write(driver->output,utterance->input_file);
+	fprintf(driver->output,",\"status\":\"%s\",\"latency_ms\":%.1f,\"result\":",
+		result ? "ok" : "failed",
+		(double)latency / 1000);
+	if(result) {
+		json_string_write(driver->output,result);
+	}
+	else {
+		fputs("null",driver->output);
+	}
+	fputs("}\n",driver->output);
+	apr_thread_mutex_unlock(driver->mutex);
+
+	apr_atomic_inc32(result ? &driver->recognized : &driver->failed);
+}
+
+static void asr_driver_on_create(asr_session_t *session, apt_bool_t status, void *obj);
+static void asr_driver_on_result(asr_session_t *session, const char *result, void *obj);
+
+/** Release session of driver */
+static void asr_driver_on_destroy(asr_session_t *session, apt_bool_t status, void *obj)
+{
+	asr_driver_slot_t *slot = obj;
+	asr_driver_t *driver = slot->driver;
+	if(slot->count && apr_atomic_read32(&driver->next) < (apr_uint32_t)driver->utterances->nelts) {
+		/* the session is terminated in the middle of the manifest, replace it,
+		unless it never recognized anything, so that a failing server is not retried forever */
+		slot->count = 0;
+		if(asr_session_create_async(driver->engine,driver->profile,asr_driver_on_create,slot)) {
+			return;
+		}
+	}
+	if(apr_atomic_dec32(&driver->pending) == 0) {
+		apr_thread_mutex_lock(driver->mutex);
+		apr_thread_cond_signal(driver->done);
+		apr_thread_mutex_unlock(driver->mutex);
+	}
+}
+
+/** Recognize the next utterance of manifest in warm session, or destroy the session, once the manifest is over */
+static void asr_driver_next(asr_session_t *session, asr_driver_slot_t *slot)
+{
+	asr_driver_t *driver = slot->driver;
+	const asr_utterance_t *utterance;
+	slot->index = apr_atomic_inc32(&driver->next);
+	if(slot->index < (apr_uint32_t)driver->utterances->nelts) {
+		utterance = &APR_ARRAY_IDX(driver->utterances,slot->index,asr_utterance_t);
+		slot->start_time = apr_time_now();
+		if(asr_session_file_recognize_async(session,utterance->grammar_file,utterance->input_file,asr_driver_on_result,slot) == TRUE) {
+			return;
+		}
+		/* the session is not usable any more, it is replaced on destroy */
+		asr_driver_result_write(driver,slot->index,NULL,0);
+	}
+	asr_session_destroy_async(session,asr_driver_on_destroy,slot);
+}
+
+/** Callback of asynchronous recognition in session of driver */
+static void asr_driver_on_result(asr_session_t *session, const char *result, void *obj)
+{
+	asr_driver_slot_t *slot = obj;
+	asr_driver_result_write(slot->driver,slot->index,result,apr_time_now() - slot->start_time);
+	if(result) {
+		slot->count++;
+	}
+	asr_driver_next(session,slot);
+}
+
+/** Callback of asynchronous session create of driver */
+static void asr_driver_on_create(asr_session_t *session, apt_bool_t status, void *obj)
+{
+	if(status == FALSE) {
+		asr_session_destroy_async(session,asr_driver_on_destroy,obj);
+		return;
+	}
+	asr_driver_next(session,obj);
+}
+
+/** Recognize the utterances of manifest by a number of concurrent sessions, wait for completion */
+static apt_bool_t asr_driver_run(asr_engine_t *engine, const char *manifest, const char *output, const char *profile, int session_count)
+{
+	apr_pool_t *pool;
+	asr_driver_t *driver;
+	asr_driver_slot_t *slot;
+	apr_time_t start_time;
+	apr_time_t elapsed;
+	int i;
+
+	if(!manifest || session_count <= 0) {
+		return FALSE;
+	}
+
+	apr_pool_create(&pool,NULL);
+	driver = apr_palloc(pool,sizeof(asr_driver_t));
+	driver->pool = pool;
+	driver->engine = engine;
+	driver->profile = profile ? apr_pstrdup(pool,profile) : "uni2";
+	driver->next = 0;
+	driver->recognized = 0;
+	driver->failed = 0;
+	driver->utterances = asr_manifest_load(manifest,pool);
+	if(!driver->utterances) {
+		apr_pool_destroy(pool);
+		return FALSE;
+	}
+	if(!driver->utterances->nelts) {
+		printf("No Utterances in Manifest [%s]\n",manifest);
+		apr_pool_destroy(pool);
+		return FALSE;
+	}
+	if(session_count > driver->utterances->nelts) {
+		session_count = driver->utterances->nelts;
+	}
+	driver->output = output ? fopen(output,"w") : stdout;
+	if(!driver->output) {
+		printf("Failed to Open Output [%s]\n",output);
+		apr_pool_destroy(pool);
+		return FALSE;
+	}
+	apr_thread_mutex_create(&driver->mutex,APR_THREAD_MUTEX_DEFAULT,pool);
+	apr_thread_cond_create(&driver->done,pool);
+
+	printf("Recognize [%d] Utterances by [%d] Sessions of Profile [%s]\n",
+		driver->utterances->nelts,session_count,driver->profile);
+	start_time = apr_time_now();
+
+	apr_thread_mutex_lock(driver->mutex);
+	/* one extra reference is held until all the sessions are launched */
+	apr_atomic_set32(&driver->pending,session_count + 1);
+	for(i=0; i<session_count; i++) {
+		slot = apr_palloc(pool,sizeof(asr_driver_slot_t));
+		slot->driver = driver;
+		slot->index = 0;
+		slot->count = 0;
+		slot->start_time = 0;
+		if(!asr_session_create_async(engine,driver->profile,asr_driver_on_create,slot)) {
+			apr_atomic_dec32(&driver->pending);
+		}
+	}
+	apr_atomic_dec32(&driver->pending);
+	while(apr_atomic_read32(&driver->pending) != 0) {
+		/* the mutex is released while waiting, so that the results are written meanwhile */
+		apr_thread_cond_wait(driver->done,driver->mutex);
+	}
+	apr_thread_mutex_unlock(driver->mutex);
+
+	elapsed = apr_time_now() - start_time;
+	if(driver->output != stdout) {
+		fclose(driver->output);
+	}
+	printf("Recognized [%u] Failed [%u] Skipped [%u] in [%.3f] sec (%.1f utterances/sec)\n",
+		apr_atomic_read32(&driver->recognized),
+		apr_atomic_read32(&driver->failed),
+		(apr_uint32_t)driver->utterances->nelts - apr_atomic_read32(&driver->recognized) - apr_atomic_read32(&driver->failed),
+		(double)elapsed / APR_USEC_PER_SEC,
+		elapsed ? (double)(apr_atomic_read32(&driver->recognized) + apr_atomic_read32(&driver->failed)) * APR_USEC_PER_SEC / elapsed : 0);
+
+	apr_thread_cond_destroy(driver->done);
+	apr_thread_mutex_destroy(driver->mutex);
+	apr_pool_destroy(pool);
+	return TRUE;
+}
+
 static apt_bool_t cmdline_process(asr_engine_t *engine, char *cmdline)
 {
 	apt_bool_t running = TRUE;
@@ -114,6 +484,30 @@ static apt_bool_t cmdline_process(asr_engine_t *engine, char *cmdline)
 		char *profile = apr_strtok(NULL, " ", &last);
 		asr_session_launch(engine,grammar,input,profile);
 	}
+	else if(strcasecmp(name,"arun") == 0) {
+		char *count = apr_strtok(NULL, " ", &last);
+		char *grammar = apr_strtok(NULL, " ", &last);
+		char *input = apr_strtok(NULL, " ", &last);
+		char *profile = apr_strtok(NULL, " ", &last);
+		asr_batch_launch(engine,count ? atoi(count) : 1,grammar,input,profile);
+	}
+	else if(strcasecmp(name,"mrun") == 0) {
+		char *count = apr_strtok(NULL, " ", &last);
+		char *manifest = apr_strtok(NULL, " ", &last);
+		char *output = apr_strtok(NULL, " ", &last);
+		char *profile = apr_strtok(NULL, " ", &last);
+		if(output && strcmp(output,"-") == 0) {
+			output = NULL;
+		}
+		asr_driver_run(engine,manifest,output,profile,count ? atoi(count) : 1);
+	}
+	else if(strcasecmp(name,"pool") == 0) {
+		char *profile = apr_strtok(NULL, " ", &last);
+		char *size = apr_strtok(NULL, " ", &last);
+		if(profile && size) {
+			asr_engine_session_pool_set(engine,profile,atol(size));
+		}
+	}
 	else if(strcasecmp(name,"loglevel") == 0) {
 		char *priority = apr_strtok(NULL, " ", &last);
 		if(priority) {
@@ -133,6 +527,16 @@ static apt_bool_t cmdline_process(asr_engine_t *engine, char *cmdline)
 			"           run\n"
 			"           run grammar.xml one.pcm\n"
 			"           run grammar.xml one.pcm uni1\n"
+			"\n- arun [count] [grammar_file] [audio_input_file] [profile_name] (run a number of demo asr clients asynchronously)\n"
+			"\n       examples: \n"
+			"           arun 100\n"
+			"           arun 100 grammar.xml one.pcm uni1\n"
+			"\n- mrun [count] [manifest_file] [output_file] [profile_name] (recognize utterances of manifest by a number of sessions)\n"
+			"       manifest_file lists a grammar_file and an audio_input_file per line\n"
+			"       output_file is written with a JSON line per utterance, '-' for stdout\n"
+			"\n       examples: \n"
+			"           mrun 50 manifest.txt results.jsonl\n"
+		    "\n- pool [profile_name] [size] (keep warm sessions of profile)\n"
 		    "\n- loglevel [level] (set loglevel, one of 0,1...7)\n"
 		    "\n- quit, exit\n");
 	}
@@ -183,6 +587,14 @@ static void usage(void)
 		"   -o [--log-output] mode   : Set the log output mode.\n"
 		"                              (0-none, 1-console only, 2-file only, 3-both)\n"
 		"\n"
+		"   -m [--manifest] path     : Recognize the grammar/audio pairs of the manifest and exit.\n"
+		"\n"
+		"   -n [--sessions] count    : Set the number of concurrent sessions of the manifest.\n"
+		"\n"
+		"   -j [--json-output] path  : Write the results of the manifest as JSON lines to the file.\n"
+		"\n"
+		"   -p [--profile] name      : Set the profile of the manifest.\n"
+		"\n"
 		"   -h [--help]              : Show the help.\n"
 		"\n");
 }
@@ -208,6 +620,10 @@ static client_options_t* options_load(int argc, const char * const *argv)
 		{ "root-dir",    'r', TRUE,  "path to root dir" },  /* -r arg or --root-dir arg */
 		{ "log-prio",    'l', TRUE,  "log priority" },      /* -l arg or --log-prio arg */
 		{ "log-output",  'o', TRUE,  "log output mode" },   /* -o arg or --log-output arg */
+		{ "manifest",    'm', TRUE,  "manifest file" },     /* -m arg or --manifest arg */
+		{ "sessions",    'n', TRUE,  "session count" },     /* -n arg or --sessions arg */
+		{ "json-output", 'j', TRUE,  "result file" },       /* -j arg or --json-output arg */
+		{ "profile",     'p', TRUE,  "profile name" },      /* -p arg or --profile arg */
 		{ "help",        'h', FALSE, "show help" },         /* -h or --help */
 		{ NULL, 0, 0, NULL },                               /* end */
 	};
@@ -223,6 +639,10 @@ static client_options_t* options_load(int argc, const char * const *argv)
 	options->root_dir_path = NULL;
 	options->log_priority = APT_PRIO_INFO;
 	options->log_output = APT_LOG_OUTPUT_CONSOLE;
+	options->manifest = NULL;
+	options->output = NULL;
+	options->profile = NULL;
+	options->session_count = 1;
 
 
 	rv = apr_getopt_init(&opt, pool , argc, argv);
@@ -246,6 +666,20 @@ static client_options_t* options_load(int argc, const char * const *argv)
 					options->log_output = atoi(optarg);
 				}
 				break;
+			case 'm':
+				options->manifest = optarg;
+				break;
+			case 'n':
+				if(optarg) {
+					options->session_count = atoi(optarg);
+				}
+				break;
+			case 'j':
+				options->output = optarg;
+				break;
+			case 'p':
+				options->profile = optarg;
+				break;
 			case 'h':
 				usage();
 				return FALSE;
@@ -285,8 +719,14 @@ int main(int argc, const char * const *argv)
 				options->log_priority,
 				options->log_output);
 	if(engine) {
-		/* run command line  */
-		cmdline_run(engine);
+		if(options->manifest) {
+			/* run batch recognition */
+			asr_driver_run(engine,options->manifest,options->output,options->profile,options->session_count);
+		}
+		else {
+			/* run command line  */
+			cmdline_run(engine);
+		}
 		/* destroy demo framework */
 		asr_engine_destroy(engine);
 	}
@@ -49,6 +49,22 @@ typedef struct asr_engine_t asr_engine_t;
 /** Opaque ASR session */
 typedef struct asr_session_t asr_session_t;
 
+/**
+ * Callback of asynchronous session operation (create, destroy).
+ * @param session the session the operation is completed for
+ * @param status the status of the operation
+ * @param obj the object passed to the asynchronous call
+ */
+typedef void (*asr_session_status_f)(asr_session_t *session, apt_bool_t status, void *obj);
+
+/**
+ * Callback of asynchronous recognition.
+ * @param session the session the recognition is completed in
+ * @param result the recognition result (input element of NLSML content) or NULL on failure
+ * @param obj the object passed to the asynchronous call
+ */
+typedef void (*asr_session_result_f)(asr_session_t *session, const char *result, void *obj);
+
 
 /**
  * Create ASR engine.
@@ -88,6 +104,24 @@ ASR_CLIENT_DECLARE(const char*) asr_session_file_recognize(
 									const char *grammar_file, 
 									const char *input_file);
 
+/**
+ * Initiate recognition based on specified grammar and input buffer.
+ * @param session the session to run recognition in the scope of
+ * @param grammar_file the name of the grammar file to use (path is relative to data dir)
+ * @param data the audio data to recognize (8 kHz linear PCM)
+ * @param size the size of data
+ * @return the recognition result (input element of NLSML content)
+ *
+ * @remark Frames are served as slices of the buffer with no copy,
+ *         the buffer must stay unchanged until the next recognition
+ *         or destruction of the session.
+ */
+ASR_CLIENT_DECLARE(const char*) asr_session_buffer_recognize(
+									asr_session_t *session,
+									const char *grammar_file,
+									const void *data,
+									apr_size_t size);
+
 /**
  * Initiate recognition based on specified grammar and input stream.
  * @param session the session to run recognition in the scope of
@@ -114,6 +148,20 @@ ASR_CLIENT_DECLARE(apt_bool_t) asr_session_stream_write(
 									char *data,
 									int size);
 
+/**
+ * Get and reset the counters of audio data written by asr_session_stream_write().
+ * @param session the session to get the counters of
+ * @param overruns the number of frames dropped, as the buffer was full (may be NULL)
+ * @param underruns the number of frames the client stack found no audio for (may be NULL)
+ *
+ * @remark The audio is handed over to the client stack by a lock-free ring
+ *         of a single writer and a single reader, neither of them ever waits.
+ */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_stream_stat_get(
+									asr_session_t *session,
+									apr_size_t *overruns,
+									apr_size_t *underruns);
+
 /**
  * Destroy ASR session.
  * @param session the session to destroy
@@ -121,6 +169,93 @@ ASR_CLIENT_DECLARE(apt_bool_t) asr_session_stream_write(
 ASR_CLIENT_DECLARE(apt_bool_t) asr_session_destroy(asr_session_t *session);
 
 
+/**
+ * Create ASR session asynchronously.
+ * @param engine the engine session belongs to
+ * @param profile the name of UniMRCP profile to use
+ * @param on_create the callback to be called, once the channel is added
+ * @param obj the object to pass to the callback
+ * @return the session or NULL if the channel cannot be requested
+ *
+ * @remark The callbacks of asynchronous calls are invoked from the context of
+ *         the client stack and MUST not block. Only one asynchronous operation
+ *         may be in progress per session, while any number of sessions may be
+ *         driven by a single application thread.
+ *         The session MUST be destroyed, even if the creation fails.
+ */
+ASR_CLIENT_DECLARE(asr_session_t*) asr_session_create_async(
+									asr_engine_t *engine,
+									const char *profile,
+									asr_session_status_f on_create,
+									void *obj);
+
+/**
+ * Initiate recognition based on specified grammar and input file asynchronously.
+ * @param session the session to run recognition in the scope of
+ * @param grammar_file the name of the grammar file to use (path is relative to data dir)
+ * @param input_file the name of the audio input file to use (path is relative to data dir)
+ * @param on_result the callback to be called with the recognition result
+ * @param obj the object to pass to the callback
+ * @return FALSE if the recognition cannot be initiated, the callback is not called then
+ */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_file_recognize_async(
+									asr_session_t *session,
+									const char *grammar_file,
+									const char *input_file,
+									asr_session_result_f on_result,
+									void *obj);
+
+/**
+ * Initiate recognition based on specified grammar and input stream asynchronously.
+ * @param session the session to run recognition in the scope of
+ * @param grammar_file the name of the grammar file to use (path is relative to data dir)
+ * @param on_result the callback to be called with the recognition result
+ * @param obj the object to pass to the callback
+ * @return FALSE if the recognition cannot be initiated, the callback is not called then
+ *
+ * @remark Audio data should be streamed through
+ *         asr_session_stream_write() function calls.
+ */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_stream_recognize_async(
+									asr_session_t *session,
+									const char *grammar_file,
+									asr_session_result_f on_result,
+									void *obj);
+
+/**
+ * Destroy ASR session asynchronously.
+ * @param session the session to destroy
+ * @param on_destroy the callback to be called (may be NULL), the session is destroyed right after
+ * @param obj the object to pass to the callback
+ * @return FALSE if the session cannot be terminated, it is destroyed at once then
+ */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_destroy_async(
+									asr_session_t *session,
+									asr_session_status_f on_destroy,
+									void *obj);
+
+
+/**
+ * Keep a pool of warm sessions of profile.
+ * @param engine the engine to keep the sessions in
+ * @param profile the name of UniMRCP profile to create the sessions for
+ * @param size the number of warm sessions to keep
+ *
+ * @remark The sessions are created in the background with the channel added
+ *         (SIP/RTSP and MRCPv2 connection are established), so that
+ *         asr_session_create() and asr_session_create_async() of the profile
+ *         just check out a ready session, which is replaced in the background then.
+ *         Should be set only once per profile, before the sessions of it are created.
+ */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_engine_session_pool_set(asr_engine_t *engine, const char *profile, apr_size_t size);
+
+/**
+ * Set the depth of audio buffer of sessions created afterwards.
+ * @param engine the engine to set the depth for
+ * @param depth the number of 10 msec frames the buffer holds (20 by default)
+ */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_engine_stream_depth_set(asr_engine_t *engine, apr_size_t depth);
+
 /**
  * Set log priority.
  * @param priority the priority to set
@@ -17,10 +17,13 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 /* APR includes */
 #include <apr_thread_cond.h>
 #include <apr_thread_proc.h>
+#include <apr_hash.h>
+#include <apr_strings.h>
 
 /* Common includes */
 #include "unimrcp_client.h"
@@ -32,6 +35,7 @@
 #include "mrcp_recog_resource.h"
 /* MPF includes */
 #include <mpf_frame_buffer.h>
+#include <mpf_audio_file_source.h>
 /* APT includes */
 #include "apt_nlsml_doc.h"
 #include "apt_log.h"
@@ -39,18 +43,40 @@
 
 #include "asr_engine.h"
 
+/** Size of frame written to and read from the media buffer (10 msec of 8 kHz linear PCM) */
+#define ASR_STREAM_FRAME_SIZE    160
+/** Default number of frames the media buffer holds */
+#define ASR_STREAM_DEFAULT_DEPTH 20
+
 typedef enum {
 	INPUT_MODE_NONE,
 	INPUT_MODE_FILE,
 	INPUT_MODE_STREAM
 } input_mode_e;
 
+/** States of asynchronous operation of session */
+typedef enum {
+	ASYNC_STATE_NONE,
+	ASYNC_STATE_CHANNEL_ADD,
+	ASYNC_STATE_DEFINE_GRAMMAR,
+	ASYNC_STATE_RECOGNIZE,
+	ASYNC_STATE_RECOGNITION,
+	ASYNC_STATE_TERMINATE
+} async_state_e;
+
+/** Pool of warm sessions of profile */
+typedef struct asr_session_pool_t asr_session_pool_t;
+
 /** ASR engine on top of UniMRCP client stack */
 struct asr_engine_t {
 	/** MRCP client stack */
 	mrcp_client_t      *mrcp_client;
 	/** MRCP client stack */
 	mrcp_application_t *mrcp_app;
+	/** Number of frames the media buffer of sessions holds */
+	apr_size_t          stream_depth;
+	/** Pools of warm sessions by profile name */
+	apr_hash_t         *session_pools;
 	/** Memory pool */
 	apr_pool_t         *pool;
 };
@@ -69,8 +95,14 @@ struct asr_session_t {
 
 	/** Input mode (either file or stream) */
 	input_mode_e              input_mode;
-	/** File to read media frames from */
-	FILE                     *audio_in;
+	/** File or buffer media frames are lent from */
+	mpf_audio_file_source_t  *audio_source;
+	/** Own buffer of the frame read by the client stack */
+	void                     *frame_buffer;
+	/** Buffer supplied by the application to recognize */
+	const void               *input_data;
+	/** Size of the buffer supplied by the application */
+	apr_size_t                input_size;
 	/* Buffer of media frames */
 	mpf_frame_buffer_t       *media_buffer;
 	/** Streaming is in-progress */
@@ -83,6 +115,40 @@ struct asr_session_t {
 
 	/** Message sent from client stack */
 	const mrcp_app_message_t *app_message;
+
+	/** State of asynchronous operation in progress */
+	async_state_e             async_state;
+	/** Input mode of asynchronous recognition */
+	input_mode_e              async_input_mode;
+	/** Input file of asynchronous recognition */
+	const char               *async_input_file;
+	/** Callback of asynchronous create/destroy */
+	asr_session_status_f      on_status;
+	/** Callback of asynchronous recognition */
+	asr_session_result_f      on_result;
+	/** Object to pass to the callbacks */
+	void                     *async_obj;
+
+	/** Pool the session is warm in, NULL once checked out */
+	asr_session_pool_t       *session_pool;
+	/** Session is terminated by the server */
+	volatile apt_bool_t       terminated;
+};
+
+/** Pool of warm sessions of profile */
+struct asr_session_pool_t {
+	/** Back pointer to engine */
+	asr_engine_t             *engine;
+	/** Profile the sessions are created for */
+	const char               *profile;
+	/** Number of warm sessions to keep */
+	apr_size_t                size;
+	/** Number of sessions being created */
+	apr_size_t                pending;
+	/** Warm sessions (asr_session_t*) ready to check out */
+	apr_array_header_t       *sessions;
+	/** Mutex of the pool */
+	apr_thread_mutex_t       *mutex;
 };
 
 
@@ -101,6 +167,7 @@ static const mpf_audio_stream_vtable_t audio_stream_vtable = {
 };
 
 static apt_bool_t app_message_handler(const mrcp_app_message_t *app_message);
+static apt_bool_t asr_session_async_process(asr_session_t *asr_session, const mrcp_app_message_t *app_message);
 
 
 /** Create ASR engine */
@@ -136,6 +203,8 @@ ASR_CLIENT_DECLARE(asr_engine_t*) asr_engine_create(
 	engine->pool = pool;
 	engine->mrcp_client = NULL;
 	engine->mrcp_app = NULL;
+	engine->stream_depth = ASR_STREAM_DEFAULT_DEPTH;
+	engine->session_pools = apr_hash_make(pool);
 
 	/* create UniMRCP client stack */
 	mrcp_client = unimrcp_client_create(dir_layout);
@@ -173,10 +242,14 @@ ASR_CLIENT_DECLARE(asr_engine_t*) asr_engine_create(
 	return engine;
 }
 
+static void asr_session_pools_destroy(asr_engine_t *engine);
+
 /** Destroy ASR engine */
 ASR_CLIENT_DECLARE(apt_bool_t) asr_engine_destroy(asr_engine_t *engine)
 {
 	if(engine->mrcp_client) {
+		/* terminate warm sessions */
+		asr_session_pools_destroy(engine);
 		/* shutdown client stack */
 		mrcp_client_shutdown(engine->mrcp_client);
 		/* destroy client stack */
@@ -206,9 +279,9 @@ static apt_bool_t asr_session_destroy_ex(asr_session_t *asr_session, apt_bool_t
 		apr_thread_mutex_unlock(asr_session->mutex);
 	}
 
-	if(asr_session->audio_in) {
-		fclose(asr_session->audio_in);
-		asr_session->audio_in = NULL;
+	if(asr_session->audio_source) {
+		mpf_audio_file_source_close(asr_session->audio_source);
+		asr_session->audio_source = NULL;
 	}
 
 	if(asr_session->mutex) {
@@ -227,25 +300,38 @@ static apt_bool_t asr_session_destroy_ex(asr_session_t *asr_session, apt_bool_t
 	return mrcp_application_session_destroy(asr_session->mrcp_session);
 }
 
-/** Open audio input file */
+/** Open audio input file (or the buffer supplied by the application, if no file specified) */
 static apt_bool_t asr_input_file_open(asr_session_t *asr_session, const char *input_file)
 {
-	const apt_dir_layout_t *dir_layout = mrcp_application_dir_layout_get(asr_session->engine->mrcp_app);
-	apr_pool_t *pool = mrcp_application_session_pool_get(asr_session->mrcp_session);
-	char *input_file_path = apt_datadir_filepath_get(dir_layout,input_file,pool);
-	if(!input_file_path) {
-		return FALSE;
+	char *input_file_path = NULL;
+	if(input_file) {
+		const apt_dir_layout_t *dir_layout = mrcp_application_dir_layout_get(asr_session->engine->mrcp_app);
+		apr_pool_t *pool = mrcp_application_session_pool_get(asr_session->mrcp_session);
+		input_file_path = apt_datadir_filepath_get(dir_layout,input_file,pool);
+		if(!input_file_path) {
+			return FALSE;
+		}
 	}
 	
-	if(asr_session->audio_in) {
-		fclose(asr_session->audio_in);
-		asr_session->audio_in = NULL;
+	if(asr_session->audio_source) {
+		asr_session->streaming = FALSE;
+		mpf_audio_file_source_close(asr_session->audio_source);
+		asr_session->audio_source = NULL;
 	}
 
-	asr_session->audio_in = fopen(input_file_path,"rb");
-	if(!asr_session->audio_in) {
-		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Cannot Open [%s]",input_file_path);
-		return FALSE;
+	if(input_file_path) {
+		/* the file is mapped, frames are lent with no read from the media thread */
+		asr_session->audio_source = mpf_audio_file_source_open(input_file_path);
+		if(!asr_session->audio_source) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Cannot Open [%s]",input_file_path);
+			return FALSE;
+		}
+	}
+	else {
+		asr_session->audio_source = mpf_audio_file_source_create(asr_session->input_data,asr_session->input_size);
+		if(!asr_session->audio_source) {
+			return FALSE;
+		}
 	}
 
 	return TRUE;
@@ -255,14 +341,21 @@ static apt_bool_t asr_input_file_open(asr_session_t *asr_session, const char *in
 static apt_bool_t asr_stream_read(mpf_audio_stream_t *stream, mpf_frame_t *frame)
 {
 	asr_session_t *asr_session = stream->obj;
-	if(asr_session && asr_session->streaming == TRUE) {
+	if(!asr_session) {
+		return TRUE;
+	}
+	/* give the frame its own buffer back, the previous one may have been lent */
+	if(asr_session->frame_buffer) {
+		frame->codec_frame.buffer = asr_session->frame_buffer;
+	}
+	else {
+		asr_session->frame_buffer = frame->codec_frame.buffer;
+	}
+	if(asr_session->streaming == TRUE) {
 		if(asr_session->input_mode == INPUT_MODE_FILE) {
-			if(asr_session->audio_in) {
-				if(fread(frame->codec_frame.buffer,1,frame->codec_frame.size,asr_session->audio_in) == frame->codec_frame.size) {
-					/* normal read */
-					frame->type |= MEDIA_FRAME_TYPE_AUDIO;
-				}
-				else {
+			if(asr_session->audio_source) {
+				/* the frame points to the source, no copy */
+				if(mpf_audio_file_source_frame_lend(asr_session->audio_source,frame) == FALSE) {
 					/* file is over */
 					asr_session->streaming = FALSE;
 				}
@@ -386,12 +479,34 @@ static mrcp_message_t* recognize_message_create(asr_session_t *asr_session)
 	return mrcp_message;
 }
 
+/** Take the first interpretation scanned */
+static apt_bool_t nlsml_first_interpretation_take(void *obj, const nlsml_interpretation_span_t *interpretation)
+{
+	nlsml_interpretation_span_t *first_interpretation = obj;
+	*first_interpretation = *interpretation;
+	return FALSE;
+}
+
 /** Get NLSML result */
 static const char* nlsml_result_get(mrcp_message_t *message)
 {
+	nlsml_interpretation_span_t first_interpretation;
 	nlsml_interpretation_t *interpretation;
 	nlsml_instance_t *instance;
-	nlsml_result_t *result = nlsml_result_parse(message->body.buf, message->body.length, message->pool);
+	nlsml_result_t *result;
+
+	/* plain text instance of the best interpretation is taken with no document built */
+	first_interpretation.instance_count = 0;
+	if(nlsml_result_scan(message->body.buf, message->body.length, NULL, nlsml_first_interpretation_take, &first_interpretation) == TRUE &&
+		first_interpretation.instance_count) {
+		const apt_str_t *span = &first_interpretation.instances[0];
+		if(!span->length || !memchr(span->buf, '<', span->length)) {
+			return nlsml_span_text_generate(span, message->pool);
+		}
+	}
+
+	/* SWI elements and nested markup are normalized by the document */
+	result = nlsml_result_parse(message->body.buf, message->body.length, message->pool);
 	if(!result) {
 		return NULL;
 	}
@@ -417,10 +532,22 @@ static const char* nlsml_result_get(mrcp_message_t *message)
 static apt_bool_t app_message_handler(const mrcp_app_message_t *app_message)
 {
 	if((app_message->message_type == MRCP_APP_MESSAGE_TYPE_SIGNALING && 
-		app_message->sig_message.message_type == MRCP_SIG_MESSAGE_TYPE_RESPONSE) ||
+		app_message->sig_message.message_type != MRCP_SIG_MESSAGE_TYPE_REQUEST) ||
 		app_message->message_type == MRCP_APP_MESSAGE_TYPE_CONTROL) {
 
 		asr_session_t *asr_session = mrcp_application_session_object_get(app_message->session);
+		if(asr_session && app_message->message_type == MRCP_APP_MESSAGE_TYPE_SIGNALING &&
+			app_message->sig_message.message_type == MRCP_SIG_MESSAGE_TYPE_EVENT) {
+			if(app_message->sig_message.event_id == MRCP_SIG_EVENT_TERMINATE) {
+				/* warm sessions terminated meanwhile are not checked out */
+				asr_session->terminated = TRUE;
+			}
+			return TRUE;
+		}
+		if(asr_session && asr_session->async_state != ASYNC_STATE_NONE) {
+			/* drive asynchronous operation right in the context of the client stack */
+			return asr_session_async_process(asr_session,app_message);
+		}
 		if(asr_session) {
 			apr_thread_mutex_lock(asr_session->mutex);
 			asr_session->app_message = app_message;
@@ -474,13 +601,12 @@ static mrcp_message_t* mrcp_event_get(const mrcp_app_message_t *app_message)
 	return mrcp_message;
 }
 
-/** Create ASR session */
-ASR_CLIENT_DECLARE(asr_session_t*) asr_session_create(asr_engine_t *engine, const char *profile)
+/** Allocate ASR session, the channel of which is yet to be added */
+static asr_session_t* asr_session_alloc(asr_engine_t *engine, const char *profile)
 {
 	mpf_termination_t *termination;
 	mrcp_channel_t *channel;
 	mrcp_session_t *session;
-	const mrcp_app_message_t *app_message;
 	apr_pool_t *pool;
 	asr_session_t *asr_session;
 	mpf_stream_capabilities_t *capabilities;
@@ -527,18 +653,48 @@ ASR_CLIENT_DECLARE(asr_session_t*) asr_session_create(asr_engine_t *engine, cons
 	asr_session->recog_complete = NULL;
 	asr_session->input_mode = INPUT_MODE_NONE;
 	asr_session->streaming = FALSE;
-	asr_session->audio_in = NULL;
+	asr_session->audio_source = NULL;
+	asr_session->frame_buffer = NULL;
+	asr_session->input_data = NULL;
+	asr_session->input_size = 0;
 	asr_session->media_buffer = NULL;
 	asr_session->mutex = NULL;
 	asr_session->wait_object = NULL;
 	asr_session->app_message = NULL;
+	asr_session->async_state = ASYNC_STATE_NONE;
+	asr_session->async_input_mode = INPUT_MODE_NONE;
+	asr_session->async_input_file = NULL;
+	asr_session->on_status = NULL;
+	asr_session->on_result = NULL;
+	asr_session->async_obj = NULL;
+	asr_session->session_pool = NULL;
+	asr_session->terminated = FALSE;
 
 	/* Create cond wait object and mutex */
 	apr_thread_mutex_create(&asr_session->mutex,APR_THREAD_MUTEX_DEFAULT,pool);
 	apr_thread_cond_create(&asr_session->wait_object,pool);
 
 	/* Create media buffer */
-	asr_session->media_buffer = mpf_frame_buffer_create(160,20,pool);
+	asr_session->media_buffer = mpf_frame_buffer_create(ASR_STREAM_FRAME_SIZE,engine->stream_depth,pool);
+	return asr_session;
+}
+
+static asr_session_t* asr_session_pool_checkout(asr_engine_t *engine, const char *profile);
+
+/** Create ASR session */
+ASR_CLIENT_DECLARE(asr_session_t*) asr_session_create(asr_engine_t *engine, const char *profile)
+{
+	const mrcp_app_message_t *app_message;
+	asr_session_t *asr_session = asr_session_pool_checkout(engine,profile);
+	if(asr_session) {
+		/* the channel of warm session is added already */
+		return asr_session;
+	}
+
+	asr_session = asr_session_alloc(engine,profile);
+	if(!asr_session) {
+		return NULL;
+	}
 
 	/* Send add channel request and wait for the response */
 	apr_thread_mutex_lock(asr_session->mutex);
@@ -557,10 +713,10 @@ ASR_CLIENT_DECLARE(asr_session_t*) asr_session_create(asr_engine_t *engine, cons
 	return asr_session;
 }
 
-/** Initiate recognition based on specified grammar and input file */
-ASR_CLIENT_DECLARE(const char*) asr_session_file_recognize(
-									asr_session_t *asr_session, 
-									const char *grammar_file, 
+/** Initiate recognition based on specified grammar and input file (or buffer, if no file specified) */
+static const char* asr_session_input_recognize(
+									asr_session_t *asr_session,
+									const char *grammar_file,
 									const char *input_file)
 {
 	const mrcp_app_message_t *app_message;
@@ -639,6 +795,27 @@ ASR_CLIENT_DECLARE(const char*) asr_session_file_recognize(
 	return nlsml_result_get(asr_session->recog_complete);
 }
 
+/** Initiate recognition based on specified grammar and input file */
+ASR_CLIENT_DECLARE(const char*) asr_session_file_recognize(
+									asr_session_t *asr_session, 
+									const char *grammar_file, 
+									const char *input_file)
+{
+	return asr_session_input_recognize(asr_session,grammar_file,input_file);
+}
+
+/** Initiate recognition based on specified grammar and input buffer */
+ASR_CLIENT_DECLARE(const char*) asr_session_buffer_recognize(
+									asr_session_t *asr_session,
+									const char *grammar_file,
+									const void *data,
+									apr_size_t size)
+{
+	asr_session->input_data = data;
+	asr_session->input_size = size;
+	return asr_session_input_recognize(asr_session,grammar_file,NULL);
+}
+
 /** Initiate recognition based on specified grammar and input stream */
 ASR_CLIENT_DECLARE(const char*) asr_session_stream_recognize(
 									asr_session_t *asr_session,
@@ -739,12 +916,370 @@ ASR_CLIENT_DECLARE(apt_bool_t) asr_session_stream_write(
 	return TRUE;
 }
 
+/** Get and reset the counters of media buffer */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_stream_stat_get(
+									asr_session_t *asr_session,
+									apr_size_t *overruns,
+									apr_size_t *underruns)
+{
+	if(!asr_session->media_buffer) {
+		return FALSE;
+	}
+	if(overruns) {
+		*overruns = mpf_frame_buffer_overruns_get(asr_session->media_buffer);
+	}
+	if(underruns) {
+		*underruns = mpf_frame_buffer_underruns_get(asr_session->media_buffer);
+	}
+	return TRUE;
+}
+
 /** Destroy ASR session */
 ASR_CLIENT_DECLARE(apt_bool_t) asr_session_destroy(asr_session_t *asr_session)
 {
 	return asr_session_destroy_ex(asr_session,TRUE);
 }
 
+/** Complete asynchronous recognition */
+static void asr_session_async_result(asr_session_t *asr_session, const char *result)
+{
+	asr_session->async_state = ASYNC_STATE_NONE;
+	if(asr_session->on_result) {
+		asr_session->on_result(asr_session,result,asr_session->async_obj);
+	}
+}
+
+/** Process message of asynchronous operation (client stack context) */
+static apt_bool_t asr_session_async_process(asr_session_t *asr_session, const mrcp_app_message_t *app_message)
+{
+	mrcp_message_t *mrcp_message;
+	switch(asr_session->async_state) {
+		case ASYNC_STATE_CHANNEL_ADD:
+			asr_session->async_state = ASYNC_STATE_NONE;
+			if(asr_session->on_status) {
+				asr_session->on_status(asr_session,sig_response_check(app_message),asr_session->async_obj);
+			}
+			break;
+		case ASYNC_STATE_DEFINE_GRAMMAR:
+			if(mrcp_response_check(app_message,MRCP_REQUEST_STATE_COMPLETE) == FALSE) {
+				asr_session_async_result(asr_session,NULL);
+				break;
+			}
+
+			/* Reset prev recog result (if any) */
+			asr_session->recog_complete = NULL;
+
+			mrcp_message = recognize_message_create(asr_session);
+			if(!mrcp_message) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create RECOGNIZE Request");
+				asr_session_async_result(asr_session,NULL);
+				break;
+			}
+			asr_session->async_state = ASYNC_STATE_RECOGNIZE;
+			if(mrcp_application_message_send(asr_session->mrcp_session,asr_session->mrcp_channel,mrcp_message) == FALSE) {
+				asr_session_async_result(asr_session,NULL);
+			}
+			break;
+		case ASYNC_STATE_RECOGNIZE:
+			if(mrcp_response_check(app_message,MRCP_REQUEST_STATE_INPROGRESS) == FALSE) {
+				asr_session_async_result(asr_session,NULL);
+				break;
+			}
+
+			/* Open input file or reset media buffer and start streaming */
+			if(asr_session->async_input_mode == INPUT_MODE_FILE) {
+				if(asr_input_file_open(asr_session,asr_session->async_input_file) == FALSE) {
+					asr_session_async_result(asr_session,NULL);
+					break;
+				}
+			}
+			else {
+				mpf_frame_buffer_restart(asr_session->media_buffer);
+			}
+			asr_session->input_mode = asr_session->async_input_mode;
+			asr_session->async_state = ASYNC_STATE_RECOGNITION;
+			asr_session->streaming = TRUE;
+			break;
+		case ASYNC_STATE_RECOGNITION:
+			/* Wait for events either START-OF-INPUT or RECOGNITION-COMPLETE */
+			mrcp_message = mrcp_event_get(app_message);
+			if(mrcp_message && mrcp_message->start_line.method_id == RECOGNIZER_RECOGNITION_COMPLETE) {
+				asr_session->recog_complete = mrcp_message;
+				asr_session_async_result(asr_session,nlsml_result_get(mrcp_message));
+			}
+			break;
+		case ASYNC_STATE_TERMINATE:
+		{
+			asr_session_status_f on_destroy = asr_session->on_status;
+			if(app_message->message_type != MRCP_APP_MESSAGE_TYPE_SIGNALING) {
+				/* events of the recognition still in progress */
+				break;
+			}
+			asr_session->async_state = ASYNC_STATE_NONE;
+			if(on_destroy) {
+				on_destroy(asr_session,sig_response_check(app_message),asr_session->async_obj);
+			}
+			asr_session_destroy_ex(asr_session,FALSE);
+			break;
+		}
+		default:
+			break;
+	}
+	return TRUE;
+}
+
+/** Initiate asynchronous recognition by DEFINE-GRAMMAR request */
+static apt_bool_t asr_session_recognize_async(
+						asr_session_t *asr_session,
+						const char *grammar_file,
+						input_mode_e input_mode,
+						const char *input_file,
+						asr_session_result_f on_result,
+						void *obj)
+{
+	mrcp_message_t *mrcp_message;
+	if(asr_session->async_state != ASYNC_STATE_NONE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Asynchronous Operation Is in Progress");
+		return FALSE;
+	}
+
+	mrcp_message = define_grammar_message_create(asr_session,grammar_file);
+	if(!mrcp_message) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create DEFINE-GRAMMAR Request");
+		return FALSE;
+	}
+
+	asr_session->async_input_mode = input_mode;
+	asr_session->async_input_file = input_file ?
+		apr_pstrdup(mrcp_application_session_pool_get(asr_session->mrcp_session),input_file) : NULL;
+	asr_session->on_result = on_result;
+	asr_session->async_obj = obj;
+	/* the state is set prior to sending, the response is processed by the client stack */
+	asr_session->async_state = ASYNC_STATE_DEFINE_GRAMMAR;
+	if(mrcp_application_message_send(asr_session->mrcp_session,asr_session->mrcp_channel,mrcp_message) == FALSE) {
+		asr_session->async_state = ASYNC_STATE_NONE;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Create ASR session and add its channel asynchronously */
+static asr_session_t* asr_session_create_async_ex(
+						asr_engine_t *engine,
+						const char *profile,
+						asr_session_status_f on_create,
+						void *obj)
+{
+	asr_session_t *asr_session = asr_session_alloc(engine,profile);
+	if(!asr_session) {
+		return NULL;
+	}
+
+	asr_session->on_status = on_create;
+	asr_session->async_obj = obj;
+	asr_session->async_state = ASYNC_STATE_CHANNEL_ADD;
+	if(mrcp_application_channel_add(asr_session->mrcp_session,asr_session->mrcp_channel) == FALSE) {
+		asr_session->async_state = ASYNC_STATE_NONE;
+		asr_session_destroy_ex(asr_session,FALSE);
+		return NULL;
+	}
+	return asr_session;
+}
+
+/** Create ASR session asynchronously */
+ASR_CLIENT_DECLARE(asr_session_t*) asr_session_create_async(
+									asr_engine_t *engine,
+									const char *profile,
+									asr_session_status_f on_create,
+									void *obj)
+{
+	asr_session_t *asr_session = asr_session_pool_checkout(engine,profile);
+	if(asr_session) {
+		/* the channel of warm session is added already */
+		if(on_create) {
+			on_create(asr_session,TRUE,obj);
+		}
+		return asr_session;
+	}
+	return asr_session_create_async_ex(engine,profile,on_create,obj);
+}
+
+/** Initiate recognition based on specified grammar and input file asynchronously */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_file_recognize_async(
+									asr_session_t *asr_session,
+									const char *grammar_file,
+									const char *input_file,
+									asr_session_result_f on_result,
+									void *obj)
+{
+	return asr_session_recognize_async(asr_session,grammar_file,INPUT_MODE_FILE,input_file,on_result,obj);
+}
+
+/** Initiate recognition based on specified grammar and input stream asynchronously */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_stream_recognize_async(
+									asr_session_t *asr_session,
+									const char *grammar_file,
+									asr_session_result_f on_result,
+									void *obj)
+{
+	return asr_session_recognize_async(asr_session,grammar_file,INPUT_MODE_STREAM,NULL,on_result,obj);
+}
+
+/** Destroy ASR session asynchronously */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_destroy_async(
+									asr_session_t *asr_session,
+									asr_session_status_f on_destroy,
+									void *obj)
+{
+	/* stop streaming of pending recognition (if any), its result is not reported */
+	asr_session->streaming = FALSE;
+	asr_session->on_status = on_destroy;
+	asr_session->async_obj = obj;
+	asr_session->async_state = ASYNC_STATE_TERMINATE;
+	if(mrcp_application_session_terminate(asr_session->mrcp_session) == FALSE) {
+		asr_session->async_state = ASYNC_STATE_NONE;
+		asr_session_destroy_ex(asr_session,FALSE);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Callback of warm session creation (client stack context) */
+static void asr_session_pool_on_create(asr_session_t *asr_session, apt_bool_t status, void *obj)
+{
+	asr_session_pool_t *session_pool = obj;
+	apt_bool_t added = FALSE;
+	apr_thread_mutex_lock(session_pool->mutex);
+	session_pool->pending--;
+	if(status == TRUE && session_pool->size) {
+		asr_session->session_pool = session_pool;
+		APR_ARRAY_PUSH(session_pool->sessions,asr_session_t*) = asr_session;
+		added = TRUE;
+	}
+	apr_thread_mutex_unlock(session_pool->mutex);
+
+	if(added == FALSE) {
+		if(status == FALSE) {
+			/* not retried until the next checkout */
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Warm Session [%s]",session_pool->profile);
+		}
+		asr_session_destroy_async(asr_session,NULL,NULL);
+	}
+}
+
+/** Create sessions missing in the pool in the background */
+static void asr_session_pool_refill(asr_session_pool_t *session_pool)
+{
+	apr_size_t count = 0;
+	apr_size_t available;
+	apr_thread_mutex_lock(session_pool->mutex);
+	available = session_pool->sessions->nelts + session_pool->pending;
+	if(available < session_pool->size) {
+		count = session_pool->size - available;
+		session_pool->pending += count;
+	}
+	apr_thread_mutex_unlock(session_pool->mutex);
+
+	while(count) {
+		if(!asr_session_create_async_ex(session_pool->engine,session_pool->profile,asr_session_pool_on_create,session_pool)) {
+			apr_thread_mutex_lock(session_pool->mutex);
+			session_pool->pending--;
+			apr_thread_mutex_unlock(session_pool->mutex);
+		}
+		count--;
+	}
+}
+
+/** Check out warm session of profile, if any, and refill the pool */
+static asr_session_t* asr_session_pool_checkout(asr_engine_t *engine, const char *profile)
+{
+	asr_session_t *asr_session;
+	asr_session_pool_t *session_pool = profile ? apr_hash_get(engine->session_pools,profile,APR_HASH_KEY_STRING) : NULL;
+	if(!session_pool) {
+		return NULL;
+	}
+
+	do {
+		asr_session = NULL;
+		apr_thread_mutex_lock(session_pool->mutex);
+		if(session_pool->sessions->nelts) {
+			asr_session = *(asr_session_t**)apr_array_pop(session_pool->sessions);
+			asr_session->session_pool = NULL;
+		}
+		apr_thread_mutex_unlock(session_pool->mutex);
+
+		if(asr_session && asr_session->terminated == TRUE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Discard Terminated Warm Session [%s]",profile);
+			asr_session_destroy_async(asr_session,NULL,NULL);
+			continue;
+		}
+		break;
+	}
+	while(1);
+
+	asr_session_pool_refill(session_pool);
+	return asr_session;
+}
+
+/** Destroy warm sessions of all the pools */
+static void asr_session_pools_destroy(asr_engine_t *engine)
+{
+	apr_hash_index_t *it;
+	void *val;
+	asr_session_pool_t *session_pool;
+	asr_session_t *asr_session;
+	for(it = apr_hash_first(engine->pool,engine->session_pools); it; it = apr_hash_next(it)) {
+		apr_hash_this(it,NULL,NULL,&val);
+		session_pool = val;
+		apr_thread_mutex_lock(session_pool->mutex);
+		/* sessions being created are not added from now on */
+		session_pool->size = 0;
+		while(session_pool->sessions->nelts) {
+			asr_session = *(asr_session_t**)apr_array_pop(session_pool->sessions);
+			asr_session_destroy_async(asr_session,NULL,NULL);
+		}
+		apr_thread_mutex_unlock(session_pool->mutex);
+	}
+}
+
+/** Keep warm sessions of profile */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_engine_session_pool_set(asr_engine_t *engine, const char *profile, apr_size_t size)
+{
+	asr_session_pool_t *session_pool;
+	if(!profile || !size) {
+		return FALSE;
+	}
+	if(apr_hash_get(engine->session_pools,profile,APR_HASH_KEY_STRING)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Session Pool Already Exists [%s]",profile);
+		return FALSE;
+	}
+
+	session_pool = apr_palloc(engine->pool,sizeof(asr_session_pool_t));
+	session_pool->engine = engine;
+	session_pool->profile = apr_pstrdup(engine->pool,profile);
+	session_pool->size = size;
+	session_pool->pending = 0;
+	session_pool->sessions = apr_array_make(engine->pool,(int)size,sizeof(asr_session_t*));
+	if(apr_thread_mutex_create(&session_pool->mutex,APR_THREAD_MUTEX_DEFAULT,engine->pool) != APR_SUCCESS) {
+		return FALSE;
+	}
+	apr_hash_set(engine->session_pools,session_pool->profile,APR_HASH_KEY_STRING,session_pool);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Create Session Pool [%s] size [%"APR_SIZE_T_FMT"]",profile,size);
+	asr_session_pool_refill(session_pool);
+	return TRUE;
+}
+
+/** Set the depth of media buffer of sessions to be created */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_engine_stream_depth_set(asr_engine_t *engine, apr_size_t depth)
+{
+	if(!depth) {
+		return FALSE;
+	}
+	engine->stream_depth = depth;
+	return TRUE;
+}
+
 /** Set log priority */
 ASR_CLIENT_DECLARE(apt_bool_t) asr_engine_log_priority_set(apt_log_priority_e log_priority)
 {
@@ -483,6 +483,11 @@ static apt_bool_t unimrcp_client_rtsp_uac_load(unimrcp_client_loader_t *loader,
 				config->request_timeout = atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"keep-alive") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				config->keep_alive = cdata_bool_get(elem);
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -492,6 +497,12 @@ static apt_bool_t unimrcp_client_rtsp_uac_load(unimrcp_client_loader_t *loader,
 	return mrcp_client_signaling_agent_register(loader->client,agent);
 }
 
+/** Get file path of TLS certificate or key, which is relative to conf dir unless absolute */
+static const char* unimrcp_client_tls_file_get(unimrcp_client_loader_t *loader, const apr_xml_elem *elem)
+{
+	return apt_confdir_filepath_get(loader->dir_layout,cdata_text_get(elem),loader->pool);
+}
+
 /** Load MRCPv2 connection agent */
 static apt_bool_t unimrcp_client_mrcpv2_uac_load(unimrcp_client_loader_t *loader, const apr_xml_elem *root, const char *id)
 {
@@ -500,8 +511,16 @@ static apt_bool_t unimrcp_client_mrcpv2_uac_load(unimrcp_client_loader_t *loader
 	apr_size_t max_connection_count = 100;
 	apt_bool_t offer_new_connection = FALSE;
 	const char *rx_buffer_size = NULL;
+	const char *rx_buffer_max_size = NULL;
 	const char *tx_buffer_size = NULL;
+	const char *tx_queue_limit = NULL;
+	const char *tls_cert_file = NULL;
+	const char *tls_key_file = NULL;
+	const char *tls_ca_file = NULL;
+	const char *unix_path = NULL;
 	const char *request_timeout = NULL;
+	const char *pool_size = NULL;
+	const char *idle_timeout = NULL;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading MRCPv2 Agent <%s>",id);
 	for(elem = root->first_child; elem; elem = elem->next) {
@@ -521,16 +540,56 @@ static apt_bool_t unimrcp_client_mrcpv2_uac_load(unimrcp_client_loader_t *loader
 				rx_buffer_size = cdata_text_get(elem);
 			}
 		}
+		else if(strcasecmp(elem->name,"rx-buffer-max-size") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rx_buffer_max_size = cdata_text_get(elem);
+			}
+		}
 		else if(strcasecmp(elem->name,"tx-buffer-size") == 0) {
 			if(is_cdata_valid(elem) == TRUE) {
 				tx_buffer_size = cdata_text_get(elem);
 			}
 		}
+		else if(strcasecmp(elem->name,"tx-queue-limit") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				tx_queue_limit = cdata_text_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"tls-cert-file") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				tls_cert_file = unimrcp_client_tls_file_get(loader,elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"tls-key-file") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				tls_key_file = unimrcp_client_tls_file_get(loader,elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"tls-ca-file") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				tls_ca_file = unimrcp_client_tls_file_get(loader,elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"unix-path") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				unix_path = cdata_text_get(elem);
+			}
+		}
 		else if(strcasecmp(elem->name,"request-timeout") == 0) {
 			if(is_cdata_valid(elem) == TRUE) {
 				request_timeout = cdata_text_get(elem);
 			}
 		}
+		else if(strcasecmp(elem->name,"connection-pool-size") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				pool_size = cdata_text_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"connection-idle-timeout") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				idle_timeout = cdata_text_get(elem);
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -541,12 +600,37 @@ static apt_bool_t unimrcp_client_mrcpv2_uac_load(unimrcp_client_loader_t *loader
 		if(rx_buffer_size) {
 			mrcp_client_connection_rx_size_set(agent,atol(rx_buffer_size));
 		}
+		if(rx_buffer_max_size) {
+			mrcp_client_connection_rx_max_size_set(agent,atol(rx_buffer_max_size));
+		}
 		if(tx_buffer_size) {
 			mrcp_client_connection_tx_size_set(agent,atol(tx_buffer_size));
 		}
+		if(tx_queue_limit) {
+			mrcp_client_connection_tx_queue_limit_set(agent,atol(tx_queue_limit));
+		}
+		if(tls_cert_file || tls_ca_file) {
+			/* TCP/TLS/MRCPv2 */
+			mrcp_tls_context_t *tls_context = mrcp_tls_context_create(FALSE,tls_cert_file,tls_key_file,tls_ca_file,loader->pool);
+			if(!tls_context) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create TLS Context for MRCPv2 Agent <%s>",id);
+				return FALSE;
+			}
+			mrcp_client_connection_tls_set(agent,tls_context);
+		}
+		if(unix_path) {
+			/* UNIX/MRCPv2 */
+			if(mrcp_client_connection_unix_path_set(agent,unix_path) != TRUE) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Set Unix Socket Path for MRCPv2 Agent <%s>",id);
+				return FALSE;
+			}
+		}
 		if(request_timeout) {
 			mrcp_client_connection_timeout_set(agent,atol(request_timeout));
 		}
+		if(pool_size) {
+			mrcp_client_connection_pool_set(agent,atol(pool_size),idle_timeout ? atol(idle_timeout) : 0);
+		}
 	}
 	return mrcp_client_connection_agent_register(loader->client,agent);
 }
@@ -557,6 +641,17 @@ static apt_bool_t unimrcp_client_media_engine_load(unimrcp_client_loader_t *load
 	const apr_xml_elem *elem;
 	mpf_engine_t *media_engine;
 	unsigned long realtime_rate = 1;
+	apr_size_t worker_count = 1;
+	mpf_scheduler_clock_e scheduler_clock = MPF_SCHEDULER_CLOCK_DEFAULT;
+	int scheduler_priority = 0;
+	int scheduler_cpu = -1;
+	mpf_context_layout_e context_layout = MPF_CONTEXT_LAYOUT_DEFAULT;
+	apt_bool_t io_uring = FALSE;
+	apt_bool_t rtcp_offload = FALSE;
+	apr_size_t huge_pages = 0;
+	apt_bool_t cpu_accounting = FALSE;
+	apr_size_t tick_deadline = 0;
+	apr_uint16_t frame_time = 0;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Media Engine <%s>",id);
 	for(elem = root->first_child; elem; elem = elem->next) {
@@ -566,14 +661,126 @@ static apt_bool_t unimrcp_client_media_engine_load(unimrcp_client_loader_t *load
 				realtime_rate = atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"worker-count") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				worker_count = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"scheduler-clock") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				const char *clock = cdata_text_get(elem);
+				if(strcasecmp(clock,"monotonic") == 0) {
+					scheduler_clock = MPF_SCHEDULER_CLOCK_MONOTONIC;
+				}
+				else if(strcasecmp(clock,"freewheel") == 0) {
+					scheduler_clock = MPF_SCHEDULER_CLOCK_FREEWHEEL;
+				}
+				else if(strcasecmp(clock,"default") != 0) {
+					apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Scheduler Clock <%s>",clock);
+				}
+			}
+		}
+		else if(strcasecmp(elem->name,"scheduler-priority") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				scheduler_priority = atoi(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"scheduler-cpu") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				scheduler_cpu = atoi(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"frame-time") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				frame_time = (apr_uint16_t)atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"context-layout") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				const char *layout = cdata_text_get(elem);
+				if(strcasecmp(layout,"flat") == 0) {
+					context_layout = MPF_CONTEXT_LAYOUT_FLAT;
+				}
+				else if(strcasecmp(layout,"default") != 0) {
+					apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Context Layout <%s>",layout);
+				}
+			}
+		}
+		else if(strcasecmp(elem->name,"io-uring") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				io_uring = cdata_bool_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"rtcp-offload") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtcp_offload = cdata_bool_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"huge-pages") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				/* size of the region per worker in MB */
+				huge_pages = (apr_size_t)atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"cpu-accounting") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				cpu_accounting = cdata_bool_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"tick-deadline") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				/* deadline in percents of the tick interval */
+				tick_deadline = (apr_size_t)atol(cdata_text_get(elem));
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
 	}
 
+	if(frame_time && frame_time != CODEC_FRAME_TIME_BASE) {
+		/* frame time is process wide, it must be set before the engine is created */
+		if(mpf_codec_frame_time_base_set(frame_time) == TRUE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Set Media Frame Time [%hu ms]",frame_time);
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Media Frame Time [%hu ms]",frame_time);
+		}
+	}
+
 	media_engine = mpf_engine_create(id,loader->pool);
 	if(media_engine) {
+		if(worker_count > 1) {
+			mpf_engine_worker_count_set(media_engine,worker_count);
+		}
 		mpf_engine_scheduler_rate_set(media_engine,realtime_rate);
+		if(scheduler_clock != MPF_SCHEDULER_CLOCK_DEFAULT) {
+			mpf_engine_scheduler_clock_set(media_engine,scheduler_clock);
+		}
+		if(scheduler_priority > 0) {
+			mpf_engine_scheduler_priority_set(media_engine,scheduler_priority);
+		}
+		if(scheduler_cpu >= 0) {
+			mpf_engine_scheduler_affinity_set(media_engine,scheduler_cpu);
+		}
+		if(context_layout != MPF_CONTEXT_LAYOUT_DEFAULT) {
+			mpf_engine_context_layout_set(media_engine,context_layout);
+		}
+		if(io_uring == TRUE) {
+			mpf_engine_io_uring_set(media_engine,TRUE);
+		}
+		if(rtcp_offload == TRUE) {
+			mpf_engine_rtcp_offload_set(media_engine,TRUE);
+		}
+		if(huge_pages) {
+			mpf_engine_huge_pages_set(media_engine,huge_pages * 1024 * 1024);
+		}
+		if(cpu_accounting == TRUE) {
+			mpf_engine_cpu_accounting_set(media_engine,TRUE);
+		}
+		if(tick_deadline) {
+			mpf_engine_tick_deadline_set(media_engine,tick_deadline);
+		}
 	}
 	return mrcp_client_media_engine_register(loader->client,media_engine);
 }
@@ -610,6 +817,36 @@ static apt_bool_t unimrcp_client_rtp_factory_load(unimrcp_client_loader_t *loade
 				rtp_config->rtp_port_max = (apr_port_t)atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"rtp-port-quarantine") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtp_config->rtp_port_quarantine = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"rtp-socket-pool-size") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtp_config->socket_pool_size = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"rtp-shared-ports") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtp_config->shared_ports = cdata_bool_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"rtcp-mux") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtp_config->rtcp_mux = cdata_bool_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"srtp-crypto") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				apt_str_t suite;
+				apt_string_set(&suite,cdata_text_get(elem));
+				rtp_config->srtp_suite = mpf_srtp_crypto_suite_find(&suite);
+				if(rtp_config->srtp_suite == SRTP_CRYPTO_UNKNOWN) {
+					apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown SRTP Crypto Suite <%s>",suite.buf);
+				}
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -633,6 +870,35 @@ static apt_bool_t unimrcp_client_rtp_factory_load(unimrcp_client_loader_t *loade
 }
 
 
+/** Load server endpoint of SIP settings */
+static apt_bool_t unimrcp_client_sip_endpoint_load(unimrcp_client_loader_t *loader, mrcp_sig_settings_t *settings, const apr_xml_elem *elem)
+{
+	const apr_xml_attr *attr;
+	const char *server_ip = NULL;
+	apr_port_t server_port = 0;
+	int weight = 1;
+	for(attr = elem->attr; attr; attr = attr->next) {
+		if(is_attr_valid(attr) == FALSE) {
+			continue;
+		}
+		if(strcasecmp(attr->name,"ip") == 0) {
+			server_ip = attr->value;
+		}
+		else if(strcasecmp(attr->name,"port") == 0) {
+			server_port = (apr_port_t)atol(attr->value);
+		}
+		else if(strcasecmp(attr->name,"weight") == 0) {
+			weight = atoi(attr->value);
+		}
+	}
+	if(!server_ip) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Missing IP Address of <%s>",elem->name);
+		return FALSE;
+	}
+	/* port 0 is resolved to the server port, once all the settings are loaded */
+	return mrcp_signaling_settings_endpoint_add(settings,server_ip,server_port,weight,loader->pool) ? TRUE : FALSE;
+}
+
 /** Load SIP settings */
 static apt_bool_t unimrcp_client_sip_settings_load(unimrcp_client_loader_t *loader, const apr_xml_elem *root, const char *id)
 {
@@ -665,6 +931,19 @@ static apt_bool_t unimrcp_client_sip_settings_load(unimrcp_client_loader_t *load
 				settings->feature_tags = cdata_copy(elem,loader->pool);
 			}
 		}
+		else if(strcasecmp(elem->name,"server-endpoint") == 0) {
+			unimrcp_client_sip_endpoint_load(loader,settings,elem);
+		}
+		else if(strcasecmp(elem->name,"failure-threshold") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				settings->failure_threshold = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"circuit-open-timeout") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				settings->open_timeout = atol(cdata_text_get(elem));
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -673,6 +952,18 @@ static apt_bool_t unimrcp_client_sip_settings_load(unimrcp_client_loader_t *load
 	if(!settings->server_ip) {
 		settings->server_ip = apr_pstrdup(loader->pool,loader->server_ip);
 	}
+	if(settings->endpoints) {
+		int i;
+		mrcp_sig_endpoint_t *endpoint;
+		for(i=0; i<settings->endpoints->nelts; i++) {
+			endpoint = APR_ARRAY_IDX(settings->endpoints,i,mrcp_sig_endpoint_t*);
+			if(!endpoint->server_port) {
+				endpoint->server_port = settings->server_port;
+			}
+			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Add Server Endpoint %s:%hu [weight %d]",
+				endpoint->server_ip,endpoint->server_port,endpoint->weight);
+		}
+	}
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Create SIP Settings %s:%hu",settings->server_ip,settings->server_port);
 	return mrcp_client_signaling_settings_register(loader->client,settings,id);
 }
@@ -765,6 +1056,11 @@ static apt_bool_t unimrcp_client_jb_settings_load(unimrcp_client_loader_t *loade
 				jb->time_skew_detection = (apr_byte_t) atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"bypass") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				jb->bypass = (apr_byte_t) atol(cdata_text_get(elem));
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -807,6 +1103,11 @@ static apt_bool_t unimrcp_client_rtcp_settings_load(unimrcp_client_loader_t *loa
 				rtcp_settings->rtcp_rx_resolution = (apr_uint16_t)atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"xr-voip-metrics") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtcp_settings->rtcp_xr = cdata_bool_get(elem);
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -841,6 +1142,11 @@ static apt_bool_t unimrcp_client_rtp_settings_load(unimrcp_client_loader_t *load
 					loader->pool);
 			}
 		}
+		else if(strcasecmp(elem->name,"plc") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtp_settings->plc = cdata_bool_get(elem);
+			}
+		}
 		else if(strcasecmp(elem->name,"rtcp") == 0) {
 			unimrcp_client_rtcp_settings_load(loader,rtp_settings,elem);
 		}
@@ -1067,6 +1373,13 @@ static apt_bool_t unimrcp_client_properties_load(unimrcp_client_loader_t *loader
 			loader->server_ip = unimrcp_client_ip_address_get(loader,elem,DEFAULT_IP_ADDRESS);
 			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Property server-ip:%s",loader->server_ip);
 		}
+		else if(strcasecmp(elem->name,"worker-count") == 0) {
+			const char *worker_count = cdata_text_get(elem);
+			if(worker_count) {
+				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Property worker-count:%s",worker_count);
+				mrcp_client_worker_count_set(loader->client,atol(worker_count));
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -34,12 +34,44 @@ APT_BEGIN_EXTERN_C
  */
 MRCP_DECLARE(mrcp_server_t*) unimrcp_server_start(apt_dir_layout_t *dir_layout);
 
+/**
+ * Start UniMRCP server in one of the worker processes (prefork mode).
+ * @param dir_layout the dir layout structure
+ * @param worker_index the index of the worker process [0..worker_count)
+ * @param worker_count the number of worker processes
+ * @remark Each process runs its own server with its own media engines.
+ *         The RTP port range is split evenly among the processes.
+ *         RTSP agents share the port of the config (SO_REUSEPORT), since
+ *         a connection carries the whole session. SIP and MRCPv2 agents take
+ *         the ports following the configured ones by the index of the process,
+ *         since the SIP stack binds its own sockets and the channels must be
+ *         connected to the process, which has answered the offer.
+ */
+MRCP_DECLARE(mrcp_server_t*) unimrcp_server_worker_start(apt_dir_layout_t *dir_layout, apr_size_t worker_index, apr_size_t worker_count);
+
 /** 
  * Shutdown UniMRCP server.
  * @param server the MRCP server to shutdown
  */
 MRCP_DECLARE(apt_bool_t) unimrcp_server_shutdown(mrcp_server_t *server);
 
+/**
+ * Reload plugins and profiles of running UniMRCP server.
+ * @param server the MRCP server to reload
+ * @param dir_layout the dir layout structure
+ * @param engine_id the identifier of the engine to reload, although it is loaded
+ *                  already ("*" to reload all the engines, NULL to load new ones only)
+ * @remark The config file is read again. New and requested engines are loaded
+ *         and replace the loaded ones, once opened. Engines and profiles disabled
+ *         in the file are unregistered, all the enabled profiles are registered again.
+ *         Existing sessions run to completion on the engines and profiles they use.
+ *         RTP settings are loaded again, unless an engine is requested, and apply
+ *         to the profiles registered next (see mrcp_server_rtp_settings_register()).
+ *         Other components are not changed without restart, so that profiles
+ *         should refer to the media engines and RTP factories as loaded.
+ */
+MRCP_DECLARE(apt_bool_t) unimrcp_server_reload(mrcp_server_t *server, apt_dir_layout_t *dir_layout, const char *engine_id);
+
 APT_END_EXTERN_C
 
 #endif /* UNIMRCP_SERVER_H */
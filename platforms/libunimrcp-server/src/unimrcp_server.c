@@ -25,10 +25,12 @@
 #include "mrcp_resource_loader.h"
 #include "mpf_engine.h"
 #include "mpf_codec_manager.h"
+#include "mpf_engine_factory.h"
 #include "mpf_rtp_termination_factory.h"
 #include "mrcp_sofiasip_server_agent.h"
 #include "mrcp_unirtsp_server_agent.h"
 #include "mrcp_server_connection.h"
+#include "apt_pool.h"
 #include "apt_net.h"
 #include "apt_log.h"
 
@@ -72,21 +74,44 @@ struct unimrcp_server_loader_t {
 	
 	/** Implicitly detected, cached IP address */
 	const char      *auto_ip;
+
+	/** Whether the document is reloaded at runtime, only plugins and profiles are applied then */
+	apt_bool_t       reload;
+	/** Identifier of the engine to reload, although it is loaded already ("*" for all, NULL for none) */
+	const char      *engine_id;
+
+	/** Index of the worker process the document is loaded for (prefork mode) */
+	apr_size_t       worker_index;
+	/** Number of worker processes (1 - single process) */
+	apr_size_t       worker_count;
 };
 
-static apt_bool_t unimrcp_server_load(mrcp_server_t *mrcp_server, apt_dir_layout_t *dir_layout, apr_pool_t *pool);
+static unimrcp_server_loader_t* unimrcp_server_loader_create(mrcp_server_t *mrcp_server, apt_dir_layout_t *dir_layout, apr_pool_t *pool);
+static apt_bool_t unimrcp_server_load(mrcp_server_t *mrcp_server, apt_dir_layout_t *dir_layout, apr_size_t worker_index, apr_size_t worker_count, apr_pool_t *pool);
+static apt_bool_t unimrcp_server_plugin_factory_load(unimrcp_server_loader_t *loader, const apr_xml_elem *root);
+static apt_bool_t unimrcp_server_settings_load(unimrcp_server_loader_t *loader, const apr_xml_elem *root);
+static apt_bool_t unimrcp_server_profiles_load(unimrcp_server_loader_t *loader, const apr_xml_elem *root);
 
 /** Start UniMRCP server */
 MRCP_DECLARE(mrcp_server_t*) unimrcp_server_start(apt_dir_layout_t *dir_layout)
+{
+	return unimrcp_server_worker_start(dir_layout,0,1);
+}
+
+/** Start UniMRCP server in one of the worker processes */
+MRCP_DECLARE(mrcp_server_t*) unimrcp_server_worker_start(apt_dir_layout_t *dir_layout, apr_size_t worker_index, apr_size_t worker_count)
 {
 	apr_pool_t *pool;
 	mrcp_server_t *server;
 
-	if(!dir_layout) {
+	if(!dir_layout || !worker_count || worker_index >= worker_count) {
 		return NULL;
 	}
 
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"UniMRCP Server ["UNI_VERSION_STRING"] [r"UNI_REVISION_STRING"]");
+	if(worker_count > 1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Worker Process [%"APR_SIZE_T_FMT"/%"APR_SIZE_T_FMT"]",worker_index+1,worker_count);
+	}
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"APR ["APR_VERSION_STRING"]");
 	server = mrcp_server_create(dir_layout);
 	if(!server) {
@@ -97,7 +122,7 @@ MRCP_DECLARE(mrcp_server_t*) unimrcp_server_start(apt_dir_layout_t *dir_layout)
 		return NULL;
 	}
 
-	if(unimrcp_server_load(server,dir_layout,pool) == FALSE) {
+	if(unimrcp_server_load(server,dir_layout,worker_index,worker_count,pool) == FALSE) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Load UniMRCP Server Document");
 	}
 
@@ -114,6 +139,59 @@ MRCP_DECLARE(apt_bool_t) unimrcp_server_shutdown(mrcp_server_t *server)
 	return mrcp_server_destroy(server);
 }
 
+/** Reload plugins and profiles of running UniMRCP server */
+MRCP_DECLARE(apt_bool_t) unimrcp_server_reload(mrcp_server_t *server, apt_dir_layout_t *dir_layout, const char *engine_id)
+{
+	apr_pool_t *pool;
+	unimrcp_server_loader_t *loader;
+	const apr_xml_elem *elem;
+	const apr_xml_elem *child;
+
+	if(!server || !dir_layout) {
+		return FALSE;
+	}
+
+	/* the engines and profiles loaded refer to the pool, as long as the server runs */
+	pool = apt_subpool_create(mrcp_server_memory_pool_get(server));
+	if(!pool) {
+		return FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Reload UniMRCP Server Document");
+	loader = unimrcp_server_loader_create(server,dir_layout,pool);
+	if(!loader) {
+		apr_pool_destroy(pool);
+		return FALSE;
+	}
+	loader->reload = TRUE;
+	loader->engine_id = engine_id;
+
+	/* plugins first, so that the profiles are assigned the engines already registered */
+	for(elem = loader->doc->root->first_child; elem; elem = elem->next) {
+		if(strcasecmp(elem->name,"components") == 0) {
+			for(child = elem->first_child; child; child = child->next) {
+				if(strcasecmp(child->name,"plugin-factory") == 0) {
+					unimrcp_server_plugin_factory_load(loader,child);
+				}
+			}
+		}
+	}
+	/* settings next, so that the profiles and the sessions created with them refer to the settings retuned */
+	if(!engine_id) {
+		for(elem = loader->doc->root->first_child; elem; elem = elem->next) {
+			if(strcasecmp(elem->name,"settings") == 0) {
+				unimrcp_server_settings_load(loader,elem);
+			}
+		}
+	}
+	for(elem = loader->doc->root->first_child; elem; elem = elem->next) {
+		if(strcasecmp(elem->name,"profiles") == 0) {
+			unimrcp_server_profiles_load(loader,elem);
+		}
+	}
+	return TRUE;
+}
+
 
 /** Check whether specified attribute is valid */
 static APR_INLINE apt_bool_t is_attr_valid(const apr_xml_attr *attr)
@@ -240,6 +318,21 @@ static char* unimrcp_server_ip_address_get(unimrcp_server_loader_t *loader, cons
 	return apr_pstrdup(loader->pool,loader->ip);
 }
 
+/** Get set of CPUs (e.g. "0-3,8" or "node:1") to bind threads to */
+static apt_cpu_set_t* unimrcp_server_cpu_set_get(unimrcp_server_loader_t *loader, const apr_xml_elem *elem)
+{
+	apt_cpu_set_t *cpu_set;
+	if(is_cdata_valid(elem) == FALSE) {
+		return NULL;
+	}
+	cpu_set = apr_palloc(loader->pool,sizeof(apt_cpu_set_t));
+	if(apt_cpu_set_parse(cpu_set,cdata_text_get(elem),loader->pool) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid CPU Set <%s>",cdata_text_get(elem));
+		return NULL;
+	}
+	return cpu_set;
+}
+
 /** Load resource */
 static apt_bool_t unimrcp_server_resource_load(mrcp_resource_loader_t *resource_loader, const apr_xml_elem *root, apr_pool_t *pool)
 {
@@ -290,6 +383,8 @@ static apt_bool_t unimrcp_server_sip_uas_load(unimrcp_server_loader_t *loader, c
 	const apr_xml_elem *elem;
 	mrcp_sig_agent_t *agent;
 	mrcp_sofia_server_config_t *config;
+	apr_size_t worker_count = 1;
+	apr_size_t i;
 
 	config = mrcp_sofiasip_server_config_alloc(loader->pool);
 	config->local_port = DEFAULT_SIP_PORT;
@@ -361,6 +456,21 @@ static apt_bool_t unimrcp_server_sip_uas_load(unimrcp_server_loader_t *loader, c
 				config->sip_t1x64 = atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"sip-connection-reuse") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				config->tport_reuse = cdata_bool_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"sip-idle-timeout") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				config->tport_idle_timeout = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"sip-keepalive-interval") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				config->tport_keepalive = atol(cdata_text_get(elem));
+			}
+		}
 		else if(strcasecmp(elem->name,"sip-message-output") == 0) {
 			if(is_cdata_valid(elem) == TRUE) {
 				config->tport_log = cdata_bool_get(elem);
@@ -380,6 +490,16 @@ static apt_bool_t unimrcp_server_sip_uas_load(unimrcp_server_loader_t *loader, c
 					config->tport_dump_file = cdata_copy(elem,loader->pool);
 			}
 		}
+		else if(strcasecmp(elem->name,"load-header") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				config->load_header = cdata_copy(elem,loader->pool);
+			}
+		}
+		else if(strcasecmp(elem->name,"worker-count") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				worker_count = atol(cdata_text_get(elem));
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -393,9 +513,38 @@ static apt_bool_t unimrcp_server_sip_uas_load(unimrcp_server_loader_t *loader, c
 		/* use default ext IP address if not specified */
 		config->ext_ip = apr_pstrdup(loader->pool,loader->ext_ip);
 	}
+	if(loader->worker_index) {
+		/* the SIP stack binds its own sockets, each worker process takes the ports next to the ones of the previous process */
+		config->local_port = (apr_port_t)(config->local_port + loader->worker_index * worker_count);
+		if(config->tport_dump_file) {
+			config->tport_dump_file = apr_psprintf(loader->pool,"%s.w%"APR_SIZE_T_FMT,config->tport_dump_file,loader->worker_index+1);
+		}
+	}
 
 	agent = mrcp_sofiasip_server_agent_create(id,config,loader->pool);
-	return mrcp_server_signaling_agent_register(loader->server,agent);
+	if(mrcp_server_signaling_agent_register(loader->server,agent) == FALSE) {
+		return FALSE;
+	}
+
+	/* each worker runs its own SIP stack on the next port, serving the profiles of the agent */
+	for(i=1; i<worker_count; i++) {
+		mrcp_sig_agent_t *worker;
+		mrcp_sofia_server_config_t *worker_config = apr_pmemdup(loader->pool,config,sizeof(mrcp_sofia_server_config_t));
+		const char *worker_id = apr_psprintf(loader->pool,"%s-%"APR_SIZE_T_FMT,id,i+1);
+		worker_config->local_port = (apr_port_t)(config->local_port + i);
+		if(config->tport_dump_file) {
+			worker_config->tport_dump_file = apr_psprintf(loader->pool,"%s.%"APR_SIZE_T_FMT,config->tport_dump_file,i+1);
+		}
+		worker = mrcp_sofiasip_server_agent_create(worker_id,worker_config,loader->pool);
+		if(!worker) {
+			return FALSE;
+		}
+		worker->primary = agent;
+		if(mrcp_server_signaling_agent_register(loader->server,worker) == FALSE) {
+			return FALSE;
+		}
+	}
+	return TRUE;
 }
 
 /** Load UniRTSP signaling agent */
@@ -429,6 +578,16 @@ static apt_bool_t unimrcp_server_rtsp_uas_load(unimrcp_server_loader_t *loader,
 				config->max_connection_count = atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"worker-count") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				config->worker_count = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"defer-accept") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				config->defer_accept = atol(cdata_text_get(elem));
+			}
+		}
 		else if(strcasecmp(elem->name,"force-destination") == 0) {
 			if(is_cdata_valid(elem) == TRUE) {
 				config->force_destination = cdata_bool_get(elem);
@@ -455,11 +614,21 @@ static apt_bool_t unimrcp_server_rtsp_uas_load(unimrcp_server_loader_t *loader,
 		/* use default IP address if not specified */
 		config->local_ip = apr_pstrdup(loader->pool,loader->ip);
 	}
+	if(loader->worker_count > 1) {
+		/* the connection carries the whole session, any of the worker processes may accept it */
+		config->shared_port = TRUE;
+	}
 
 	agent = mrcp_unirtsp_server_agent_create(id,config,loader->pool);
 	return mrcp_server_signaling_agent_register(loader->server,agent);
 }
 
+/** Get file path of TLS certificate or key, which is relative to conf dir unless absolute */
+static const char* unimrcp_server_tls_file_get(unimrcp_server_loader_t *loader, const apr_xml_elem *elem)
+{
+	return apt_confdir_filepath_get(loader->dir_layout,cdata_text_get(elem),loader->pool);
+}
+
 /** Load MRCPv2 connection agent */
 static apt_bool_t unimrcp_server_mrcpv2_uas_load(unimrcp_server_loader_t *loader, const apr_xml_elem *root, const char *id)
 {
@@ -470,7 +639,17 @@ static apt_bool_t unimrcp_server_mrcpv2_uas_load(unimrcp_server_loader_t *loader
 	apr_size_t max_connection_count = 100;
 	apt_bool_t force_new_connection = FALSE;
 	apr_size_t rx_buffer_size = 0;
+	apr_size_t rx_buffer_max_size = 0;
 	apr_size_t tx_buffer_size = 0;
+	const char *tx_queue_limit = NULL;
+	apr_size_t defer_accept = 0;
+	const char *tls_cert_file = NULL;
+	const char *tls_key_file = NULL;
+	const char *tls_ca_file = NULL;
+	const char *unix_path = NULL;
+	apr_size_t worker_count = 1;
+	const apt_cpu_set_t *cpu_set = NULL;
+	apt_bool_t colocated = FALSE;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading MRCPv2 Agent <%s>",id);
 	for(elem = root->first_child; elem; elem = elem->next) {
@@ -498,11 +677,59 @@ static apt_bool_t unimrcp_server_mrcpv2_uas_load(unimrcp_server_loader_t *loader
 				rx_buffer_size = atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"rx-buffer-max-size") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rx_buffer_max_size = atol(cdata_text_get(elem));
+			}
+		}
 		else if(strcasecmp(elem->name,"tx-buffer-size") == 0) {
 			if(is_cdata_valid(elem) == TRUE) {
 				tx_buffer_size = atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"tx-queue-limit") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				tx_queue_limit = cdata_text_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"defer-accept") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				defer_accept = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"tls-cert-file") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				tls_cert_file = unimrcp_server_tls_file_get(loader,elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"tls-key-file") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				tls_key_file = unimrcp_server_tls_file_get(loader,elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"tls-ca-file") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				tls_ca_file = unimrcp_server_tls_file_get(loader,elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"unix-path") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				unix_path = cdata_text_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"worker-count") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				worker_count = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"cpu-set") == 0) {
+			cpu_set = unimrcp_server_cpu_set_get(loader,elem);
+		}
+		else if(strcasecmp(elem->name,"colocated") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				colocated = cdata_bool_get(elem);
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -512,17 +739,61 @@ static apt_bool_t unimrcp_server_mrcpv2_uas_load(unimrcp_server_loader_t *loader
 		/* use default IP address if not specified */
 		mrcp_ip = apr_pstrdup(loader->pool,loader->ip);
 	}
+	if(loader->worker_index) {
+		/* the channels are connected to the process, which has answered the offer, on the port of the process */
+		mrcp_port = (apr_port_t)(mrcp_port + loader->worker_index);
+		if(unix_path) {
+			unix_path = apr_psprintf(loader->pool,"%s.%"APR_SIZE_T_FMT,unix_path,loader->worker_index+1);
+		}
+	}
 
 	agent = mrcp_server_connection_agent_create(id,mrcp_ip,mrcp_port,max_connection_count,force_new_connection,loader->pool);
 	if(agent) {
 		if(rx_buffer_size) {
 			mrcp_server_connection_rx_size_set(agent,rx_buffer_size);
 		}
+		if(rx_buffer_max_size) {
+			mrcp_server_connection_rx_max_size_set(agent,rx_buffer_max_size);
+		}
 		if(tx_buffer_size) {
 			mrcp_server_connection_tx_size_set(agent,tx_buffer_size);
 		}
+		if(tx_queue_limit) {
+			mrcp_server_connection_tx_queue_limit_set(agent,atol(tx_queue_limit));
+		}
+		if(defer_accept) {
+			mrcp_server_connection_defer_accept_set(agent,defer_accept);
+		}
+		if(tls_cert_file) {
+			/* TCP/TLS/MRCPv2 */
+			mrcp_tls_context_t *tls_context = mrcp_tls_context_create(TRUE,tls_cert_file,tls_key_file,tls_ca_file,loader->pool);
+			if(!tls_context) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create TLS Context for MRCPv2 Agent <%s>",id);
+				return FALSE;
+			}
+			mrcp_server_connection_tls_set(agent,tls_context);
+		}
+		if(unix_path) {
+			/* UNIX/MRCPv2 */
+			if(mrcp_server_connection_unix_path_set(agent,unix_path) != TRUE) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Set Unix Socket Path for MRCPv2 Agent <%s>",id);
+				return FALSE;
+			}
+		}
+		if(worker_count > 1) {
+			mrcp_server_connection_worker_count_set(agent,worker_count);
+		}
+		if(cpu_set) {
+			mrcp_server_connection_cpu_set_set(agent,cpu_set);
+		}
+	}
+	if(mrcp_server_connection_agent_register(loader->server,agent) == FALSE) {
+		return FALSE;
 	}
-	return mrcp_server_connection_agent_register(loader->server,agent);
+	if(colocated == TRUE) {
+		mrcp_server_connection_agent_colocate(loader->server,agent);
+	}
+	return TRUE;
 }
 
 /** Load media engine */
@@ -531,6 +802,18 @@ static apt_bool_t unimrcp_server_media_engine_load(unimrcp_server_loader_t *load
 	const apr_xml_elem *elem;
 	mpf_engine_t *media_engine;
 	unsigned long realtime_rate = 1;
+	apr_size_t worker_count = 1;
+	mpf_scheduler_clock_e scheduler_clock = MPF_SCHEDULER_CLOCK_DEFAULT;
+	int scheduler_priority = 0;
+	int scheduler_cpu = -1;
+	const apt_cpu_set_t *cpu_set = NULL;
+	mpf_context_layout_e context_layout = MPF_CONTEXT_LAYOUT_DEFAULT;
+	apt_bool_t io_uring = FALSE;
+	apt_bool_t rtcp_offload = FALSE;
+	apr_size_t huge_pages = 0;
+	apt_bool_t cpu_accounting = FALSE;
+	apr_size_t tick_deadline = 0;
+	apr_uint16_t frame_time = 0;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Media Engine <%s>",id);
 	for(elem = root->first_child; elem; elem = elem->next) {
@@ -540,14 +823,132 @@ static apt_bool_t unimrcp_server_media_engine_load(unimrcp_server_loader_t *load
 				realtime_rate = atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"worker-count") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				worker_count = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"scheduler-clock") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				const char *clock = cdata_text_get(elem);
+				if(strcasecmp(clock,"monotonic") == 0) {
+					scheduler_clock = MPF_SCHEDULER_CLOCK_MONOTONIC;
+				}
+				else if(strcasecmp(clock,"freewheel") == 0) {
+					scheduler_clock = MPF_SCHEDULER_CLOCK_FREEWHEEL;
+				}
+				else if(strcasecmp(clock,"default") != 0) {
+					apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Scheduler Clock <%s>",clock);
+				}
+			}
+		}
+		else if(strcasecmp(elem->name,"scheduler-priority") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				scheduler_priority = atoi(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"scheduler-cpu") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				scheduler_cpu = atoi(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"cpu-set") == 0) {
+			cpu_set = unimrcp_server_cpu_set_get(loader,elem);
+		}
+		else if(strcasecmp(elem->name,"frame-time") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				frame_time = (apr_uint16_t)atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"context-layout") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				const char *layout = cdata_text_get(elem);
+				if(strcasecmp(layout,"flat") == 0) {
+					context_layout = MPF_CONTEXT_LAYOUT_FLAT;
+				}
+				else if(strcasecmp(layout,"default") != 0) {
+					apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Context Layout <%s>",layout);
+				}
+			}
+		}
+		else if(strcasecmp(elem->name,"io-uring") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				io_uring = cdata_bool_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"rtcp-offload") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtcp_offload = cdata_bool_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"huge-pages") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				/* size of the region per worker in MB */
+				huge_pages = (apr_size_t)atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"cpu-accounting") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				cpu_accounting = cdata_bool_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"tick-deadline") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				/* deadline in percents of the tick interval */
+				tick_deadline = (apr_size_t)atol(cdata_text_get(elem));
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
 	}
 	
+	if(frame_time && frame_time != CODEC_FRAME_TIME_BASE) {
+		/* frame time is process wide, it must be set before the engine is created */
+		if(mpf_codec_frame_time_base_set(frame_time) == TRUE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Set Media Frame Time [%hu ms]",frame_time);
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Media Frame Time [%hu ms]",frame_time);
+		}
+	}
+
 	media_engine = mpf_engine_create(id,loader->pool);
 	if(media_engine) {
+		if(worker_count > 1) {
+			mpf_engine_worker_count_set(media_engine,worker_count);
+		}
 		mpf_engine_scheduler_rate_set(media_engine,realtime_rate);
+		if(scheduler_clock != MPF_SCHEDULER_CLOCK_DEFAULT) {
+			mpf_engine_scheduler_clock_set(media_engine,scheduler_clock);
+		}
+		if(scheduler_priority > 0) {
+			mpf_engine_scheduler_priority_set(media_engine,scheduler_priority);
+		}
+		if(scheduler_cpu >= 0) {
+			mpf_engine_scheduler_affinity_set(media_engine,scheduler_cpu);
+		}
+		if(cpu_set) {
+			mpf_engine_scheduler_cpu_set_set(media_engine,cpu_set);
+		}
+		if(context_layout != MPF_CONTEXT_LAYOUT_DEFAULT) {
+			mpf_engine_context_layout_set(media_engine,context_layout);
+		}
+		if(io_uring == TRUE) {
+			mpf_engine_io_uring_set(media_engine,TRUE);
+		}
+		if(rtcp_offload == TRUE) {
+			mpf_engine_rtcp_offload_set(media_engine,TRUE);
+		}
+		if(huge_pages) {
+			mpf_engine_huge_pages_set(media_engine,huge_pages * 1024 * 1024);
+		}
+		if(cpu_accounting == TRUE) {
+			mpf_engine_cpu_accounting_set(media_engine,TRUE);
+		}
+		if(tick_deadline) {
+			mpf_engine_tick_deadline_set(media_engine,tick_deadline);
+		}
 	}
 	return mrcp_server_media_engine_register(loader->server,media_engine);
 }
@@ -584,6 +985,36 @@ static apt_bool_t unimrcp_server_rtp_factory_load(unimrcp_server_loader_t *loade
 				rtp_config->rtp_port_max = (apr_port_t)atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"rtp-port-quarantine") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtp_config->rtp_port_quarantine = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"rtp-socket-pool-size") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtp_config->socket_pool_size = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"rtp-shared-ports") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtp_config->shared_ports = cdata_bool_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"rtcp-mux") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtp_config->rtcp_mux = cdata_bool_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"srtp-crypto") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				apt_str_t suite;
+				apt_string_set(&suite,cdata_text_get(elem));
+				rtp_config->srtp_suite = mpf_srtp_crypto_suite_find(&suite);
+				if(rtp_config->srtp_suite == SRTP_CRYPTO_UNKNOWN) {
+					apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown SRTP Crypto Suite <%s>",suite.buf);
+				}
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -601,6 +1032,21 @@ static apt_bool_t unimrcp_server_rtp_factory_load(unimrcp_server_loader_t *loade
 	else if(loader->ext_ip){
 		apt_string_set(&rtp_config->ext_ip,loader->ext_ip);
 	}
+	if(loader->worker_count > 1) {
+		/* each worker process allocates the ports from its own slice of the range */
+		apr_uint16_t ports_per_worker = (apr_uint16_t)((rtp_config->rtp_port_max - rtp_config->rtp_port_min) / loader->worker_count);
+		if(ports_per_worker % 2 != 0) {
+			/* number of ports per worker should be even (RTP/RTCP pair) */
+			ports_per_worker--;
+		}
+		rtp_config->rtp_port_min = (apr_port_t)(rtp_config->rtp_port_min + ports_per_worker * loader->worker_index);
+		if(loader->worker_index + 1 < loader->worker_count) {
+			/* the last worker keeps the max port */
+			rtp_config->rtp_port_max = (apr_port_t)(rtp_config->rtp_port_min + ports_per_worker);
+		}
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set RTP Port Range of Worker Process [%hu - %hu] <%s>",
+			rtp_config->rtp_port_min,rtp_config->rtp_port_max,id);
+	}
 
 	rtp_factory = mpf_rtp_termination_factory_create(rtp_config,loader->pool);
 	return mrcp_server_rtp_factory_register(loader->server,rtp_factory,id);
@@ -617,6 +1063,7 @@ static apt_bool_t unimrcp_server_plugin_load(unimrcp_server_loader_t *loader, co
 	const char *plugin_name = NULL;
 	const char *plugin_ext = NULL;
 	apt_bool_t plugin_enabled = TRUE;
+	mrcp_engine_open_mode_e open_mode = MRCP_ENGINE_OPEN_STARTUP;
 	const apr_xml_attr *attr;
 	for(attr = root->attr; attr; attr = attr->next) {
 		if(strcasecmp(attr->name,"id") == 0) {
@@ -631,6 +1078,17 @@ static apt_bool_t unimrcp_server_plugin_load(unimrcp_server_loader_t *loader, co
 		else if(strcasecmp(attr->name,"enable") == 0) {
 			plugin_enabled = is_attr_enabled(attr);
 		}
+		else if(strcasecmp(attr->name,"open") == 0) {
+			if(strcasecmp(attr->value,"lazy") == 0) {
+				open_mode = MRCP_ENGINE_OPEN_LAZY;
+			}
+			else if(strcasecmp(attr->value,"parallel") == 0) {
+				open_mode = MRCP_ENGINE_OPEN_PARALLEL;
+			}
+			else if(strcasecmp(attr->value,"startup") != 0) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Open Mode <%s>",attr->value);
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Attribute <%s>",attr->name);
 		}
@@ -642,10 +1100,22 @@ static apt_bool_t unimrcp_server_plugin_load(unimrcp_server_loader_t *loader, co
 	}
 
 	if(!plugin_enabled) {
+		if(loader->reload == TRUE && mrcp_server_engine_get(loader->server,plugin_id)) {
+			/* disabled at runtime */
+			return mrcp_server_engine_disable(loader->server,plugin_id);
+		}
 		/* disabled plugin, just skip it */
 		return TRUE;
 	}
 
+	if(loader->reload == TRUE && mrcp_server_engine_get(loader->server,plugin_id)) {
+		if(!loader->engine_id ||
+			(strcmp(loader->engine_id,"*") != 0 && strcasecmp(loader->engine_id,plugin_id) != 0)) {
+			/* loaded already and not requested to be reloaded */
+			return TRUE;
+		}
+	}
+
 	if(!plugin_ext) {
 		plugin_ext = DEFAULT_PLUGIN_EXT;
 	}
@@ -658,6 +1128,7 @@ static apt_bool_t unimrcp_server_plugin_load(unimrcp_server_loader_t *loader, co
 	}
 
 	config = mrcp_engine_config_alloc(loader->pool);
+	config->open_mode = open_mode;
 
 	/* load optional named and generic name/value params */
 	if(root->first_child){
@@ -672,6 +1143,39 @@ static apt_bool_t unimrcp_server_plugin_load(unimrcp_server_loader_t *loader, co
 					config->max_channel_count = atol(cdata_text_get(elem));
 				}
 			}
+			else if(strcasecmp(elem->name,"min-idle-channels") == 0) {
+				if(is_cdata_valid(elem) == TRUE) {
+					config->min_idle_channels = atol(cdata_text_get(elem));
+				}
+			}
+			else if(strcasecmp(elem->name,"grammar-cache-size") == 0) {
+				if(is_cdata_valid(elem) == TRUE) {
+					config->grammar_cache_size = atol(cdata_text_get(elem));
+				}
+			}
+			else if(strcasecmp(elem->name,"prompt-cache-size") == 0) {
+				if(is_cdata_valid(elem) == TRUE) {
+					config->prompt_cache_size = atol(cdata_text_get(elem));
+				}
+			}
+			else if(strcasecmp(elem->name,"voiceprint-cache-size") == 0) {
+				if(is_cdata_valid(elem) == TRUE) {
+					config->voiceprint_cache_size = atol(cdata_text_get(elem));
+				}
+			}
+			else if(strcasecmp(elem->name,"slow-callback-threshold") == 0) {
+				if(is_cdata_valid(elem) == TRUE) {
+					config->slow_callback_threshold = atol(cdata_text_get(elem));
+				}
+			}
+			else if(strcasecmp(elem->name,"slow-callback-limit") == 0) {
+				if(is_cdata_valid(elem) == TRUE) {
+					config->slow_callback_limit = atol(cdata_text_get(elem));
+				}
+			}
+			else if(strcasecmp(elem->name,"cpu-set") == 0) {
+				config->cpu_set = unimrcp_server_cpu_set_get(loader,elem);
+			}
 			else if(strcasecmp(elem->name,"param") == 0) {
 				if(name_value_attribs_get(elem,&attr_name,&attr_value) == TRUE) {
 					apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Param %s:%s",attr_name->value,attr_value->value);
@@ -682,6 +1186,10 @@ static apt_bool_t unimrcp_server_plugin_load(unimrcp_server_loader_t *loader, co
 	}
 
 	engine = mrcp_server_engine_load(loader->server,plugin_id,plugin_path,config);
+	if(loader->reload == TRUE) {
+		/* the engine replaces the loaded one, once it is opened */
+		return engine ? mrcp_server_engine_enable(loader->server,engine) : FALSE;
+	}
 	return mrcp_server_engine_register(loader->server,engine);
 }
 
@@ -736,6 +1244,11 @@ static apt_bool_t unimrcp_server_jb_settings_load(unimrcp_server_loader_t *loade
 				jb->time_skew_detection = (apr_byte_t) atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"bypass") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				jb->bypass = (apr_byte_t) atol(cdata_text_get(elem));
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -778,6 +1291,11 @@ static apt_bool_t unimrcp_server_rtcp_settings_load(unimrcp_server_loader_t *loa
 				rtcp_settings->rtcp_rx_resolution = (apr_uint16_t)atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"xr-voip-metrics") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtcp_settings->rtcp_xr = cdata_bool_get(elem);
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -789,9 +1307,16 @@ static apt_bool_t unimrcp_server_rtcp_settings_load(unimrcp_server_loader_t *loa
 static apt_bool_t unimrcp_server_rtp_settings_load(unimrcp_server_loader_t *loader, const apr_xml_elem *root, const char *id)
 {
 	const apr_xml_elem *elem;
+	const apr_xml_attr *attr;
 	mpf_rtp_settings_t *rtp_settings = mpf_rtp_settings_alloc(loader->pool);
 
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading RTP Settings <%s>",id);
+	for(attr = root->attr; attr; attr = attr->next) {
+		if(strcasecmp(attr->name,"live-update") == 0) {
+			rtp_settings->live_update = is_attr_enabled(attr);
+			break;
+		}
+	}
 	for(elem = root->first_child; elem; elem = elem->next) {
 		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Element <%s>",elem->name);
 		if(strcasecmp(elem->name,"jitter-buffer") == 0) {
@@ -803,7 +1328,6 @@ static apt_bool_t unimrcp_server_rtp_settings_load(unimrcp_server_loader_t *load
 			}
 		}
 		else if(strcasecmp(elem->name,"codecs") == 0) {
-			const apr_xml_attr *attr;
 			const mpf_codec_manager_t *codec_manager = mrcp_server_codec_manager_get(loader->server);
 			if(is_cdata_valid(elem) == TRUE && codec_manager) {
 				mpf_codec_manager_codec_list_load(
@@ -819,6 +1343,11 @@ static apt_bool_t unimrcp_server_rtp_settings_load(unimrcp_server_loader_t *load
 				}
 			}
 		}
+		else if(strcasecmp(elem->name,"plc") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtp_settings->plc = cdata_bool_get(elem);
+			}
+		}
 		else if(strcasecmp(elem->name,"rtcp") == 0) {
 			unimrcp_server_rtcp_settings_load(loader,rtp_settings,elem);
 		}
@@ -849,6 +1378,66 @@ static apr_table_t* resource_engine_map_load(const apr_xml_elem *root, apr_pool_
 	return plugin_map;
 }
 
+/** Create factory (pool) of media engines */
+static mpf_engine_factory_t* unimrcp_server_mpf_factory_create(unimrcp_server_loader_t *loader, const apr_xml_elem *elem)
+{
+	mpf_engine_factory_t *mpf_factory = NULL;
+	mpf_engine_t *media_engine;
+
+	char *name;
+	char *state;
+	char *list_str = apr_pstrdup(loader->pool,cdata_text_get(elem));
+	do {
+		name = apr_strtok(list_str, ",", &state);
+		if(name) {
+			media_engine = mrcp_server_media_engine_get(loader->server,name);
+			if(media_engine) {
+				if(!mpf_factory)
+					mpf_factory = mpf_engine_factory_create(loader->pool);
+
+				mpf_engine_factory_engine_add(mpf_factory,media_engine);
+			}
+			else {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Media Engine Name <%s>",name);
+			}
+		}
+		list_str = NULL; /* make sure we pass NULL on subsequent calls of apr_strtok() */
+	}
+	while(name);
+
+	if(mpf_factory && mpf_engine_factory_engine_count_get(mpf_factory) > 1) {
+		/* place new sessions on the least loaded engine of the pool */
+		mpf_engine_factory_policy_set(mpf_factory,MPF_ENGINE_SELECT_LEAST_LOADED);
+	}
+	return mpf_factory;
+}
+
+/** Initialize the quota of profile, not limited by default */
+static void unimrcp_server_quota_init(mrcp_server_quota_t *quota)
+{
+	quota->max_session_count = 0;
+	quota->max_session_rate = 0;
+	quota->max_request_rate = 0;
+}
+
+/** Load an element of the quota of profile, if it is such */
+static apt_bool_t unimrcp_server_quota_elem_load(const apr_xml_elem *elem, mrcp_server_quota_t *quota)
+{
+	if(strcasecmp(elem->name,"max-sessions") == 0) {
+		quota->max_session_count = atol(cdata_text_get(elem));
+	}
+	else if(strcasecmp(elem->name,"max-session-rate") == 0) {
+		quota->max_session_rate = atol(cdata_text_get(elem));
+	}
+	else if(strcasecmp(elem->name,"max-request-rate") == 0) {
+		quota->max_request_rate = atol(cdata_text_get(elem));
+	}
+	else {
+		return FALSE;
+	}
+	return TRUE;
+}
+
 /** Load MRCPv2 profile */
 static apt_bool_t unimrcp_server_mrcpv2_profile_load(unimrcp_server_loader_t *loader, const apr_xml_elem *root, const char *id)
 {
@@ -856,11 +1445,14 @@ static apt_bool_t unimrcp_server_mrcpv2_profile_load(unimrcp_server_loader_t *lo
 	mrcp_server_profile_t *profile;
 	mrcp_sig_agent_t *sip_agent = NULL;
 	mrcp_connection_agent_t *mrcpv2_agent = NULL;
-	mpf_engine_t *media_engine = NULL;
+	mpf_engine_factory_t *mpf_factory = NULL;
 	mpf_termination_factory_t *rtp_factory = NULL;
 	mpf_rtp_settings_t *rtp_settings = NULL;
 	apr_table_t *resource_engine_map = NULL;
+	mrcp_server_quota_t quota;
+	apt_bool_t quota_set = FALSE;
 
+	unimrcp_server_quota_init(&quota);
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading MRCPv2 Profile <%s>",id);
 	for(elem = root->first_child; elem; elem = elem->next) {
 		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Element <%s>",elem->name);
@@ -876,7 +1468,7 @@ static apt_bool_t unimrcp_server_mrcpv2_profile_load(unimrcp_server_loader_t *lo
 			mrcpv2_agent = mrcp_server_connection_agent_get(loader->server,cdata_text_get(elem));
 		}
 		else if(strcasecmp(elem->name,"media-engine") == 0) {
-			media_engine = mrcp_server_media_engine_get(loader->server,cdata_text_get(elem));
+			mpf_factory = unimrcp_server_mpf_factory_create(loader,elem);
 		}
 		else if(strcasecmp(elem->name,"rtp-factory") == 0) {
 			rtp_factory = mrcp_server_rtp_factory_get(loader->server,cdata_text_get(elem));
@@ -887,22 +1479,28 @@ static apt_bool_t unimrcp_server_mrcpv2_profile_load(unimrcp_server_loader_t *lo
 		else if(strcasecmp(elem->name,"resource-engine-map") == 0) {
 			resource_engine_map = resource_engine_map_load(elem,loader->pool);
 		}
+		else if(unimrcp_server_quota_elem_load(elem,&quota) == TRUE) {
+			quota_set = TRUE;
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
 	}
 
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Create MRCPv2 Profile [%s]",id);
-	profile = mrcp_server_profile_create(
+	profile = mrcp_server_profile_create_ex(
 				id,
 				MRCP_VERSION_2,
 				NULL,
 				sip_agent,
 				mrcpv2_agent,
-				media_engine,
+				mpf_factory,
 				rtp_factory,
 				rtp_settings,
 				loader->pool);
+	if(quota_set == TRUE) {
+		mrcp_server_profile_quota_set(profile,&quota,loader->pool);
+	}
 	return mrcp_server_profile_register(loader->server,profile,resource_engine_map);
 }
 
@@ -912,11 +1510,14 @@ static apt_bool_t unimrcp_server_mrcpv1_profile_load(unimrcp_server_loader_t *lo
 	const apr_xml_elem *elem;
 	mrcp_server_profile_t *profile;
 	mrcp_sig_agent_t *rtsp_agent = NULL;
-	mpf_engine_t *media_engine = NULL;
+	mpf_engine_factory_t *mpf_factory = NULL;
 	mpf_termination_factory_t *rtp_factory = NULL;
 	mpf_rtp_settings_t *rtp_settings = NULL;
 	apr_table_t *resource_engine_map = NULL;
+	mrcp_server_quota_t quota;
+	apt_bool_t quota_set = FALSE;
 
+	unimrcp_server_quota_init(&quota);
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading MRCPv1 Profile <%s>",id);
 	for(elem = root->first_child; elem; elem = elem->next) {
 		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Element <%s>",elem->name);
@@ -929,7 +1530,7 @@ static apt_bool_t unimrcp_server_mrcpv1_profile_load(unimrcp_server_loader_t *lo
 			rtsp_agent = mrcp_server_signaling_agent_get(loader->server,cdata_text_get(elem));
 		}
 		else if(strcasecmp(elem->name,"media-engine") == 0) {
-			media_engine = mrcp_server_media_engine_get(loader->server,cdata_text_get(elem));
+			mpf_factory = unimrcp_server_mpf_factory_create(loader,elem);
 		}
 		else if(strcasecmp(elem->name,"rtp-factory") == 0) {
 			rtp_factory = mrcp_server_rtp_factory_get(loader->server,cdata_text_get(elem));
@@ -940,26 +1541,165 @@ static apt_bool_t unimrcp_server_mrcpv1_profile_load(unimrcp_server_loader_t *lo
 		else if(strcasecmp(elem->name,"resource-engine-map") == 0) {
 			resource_engine_map = resource_engine_map_load(elem,loader->pool);
 		}
+		else if(unimrcp_server_quota_elem_load(elem,&quota) == TRUE) {
+			quota_set = TRUE;
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
 	}
 
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Create MRCPv1 Profile [%s]",id);
-	profile = mrcp_server_profile_create(
+	profile = mrcp_server_profile_create_ex(
 				id,
 				MRCP_VERSION_1,
 				NULL,
 				rtsp_agent,
 				NULL,
-				media_engine,
+				mpf_factory,
 				rtp_factory,
 				rtp_settings,
 				loader->pool);
+	if(quota_set == TRUE) {
+		mrcp_server_profile_quota_set(profile,&quota,loader->pool);
+	}
 	return mrcp_server_profile_register(loader->server,profile,resource_engine_map);
 }
 
 
+/** Load admission control */
+static apt_bool_t unimrcp_server_admission_load(unimrcp_server_loader_t *loader, const apr_xml_elem *root)
+{
+	const apr_xml_elem *elem;
+	mrcp_server_admission_t admission;
+	admission.max_media_load = 0;
+	admission.max_queue_depth = 0;
+	admission.retry_after = 0;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Admission Control");
+	for(elem = root->first_child; elem; elem = elem->next) {
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Element <%s>",elem->name);
+		if(strcasecmp(elem->name,"max-media-load") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				admission.max_media_load = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"max-queue-depth") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				admission.max_queue_depth = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"retry-after") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				admission.retry_after = atol(cdata_text_get(elem));
+			}
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
+		}
+	}
+	return mrcp_server_admission_set(loader->server,&admission);
+}
+
+/** Load metrics listener */
+static apt_bool_t unimrcp_server_metrics_listener_load(unimrcp_server_loader_t *loader, const apr_xml_elem *root)
+{
+	const apr_xml_elem *elem;
+	const char *ip = NULL;
+	apr_port_t port = 0;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Metrics Listener");
+	for(elem = root->first_child; elem; elem = elem->next) {
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Element <%s>",elem->name);
+		if(strcasecmp(elem->name,"ip") == 0) {
+			ip = unimrcp_server_ip_address_get(loader,elem);
+		}
+		else if(strcasecmp(elem->name,"port") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				port = (apr_port_t)atol(cdata_text_get(elem));
+			}
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
+		}
+	}
+	if(!port) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Missing Port of Metrics Listener");
+		return FALSE;
+	}
+	return mrcp_server_metrics_listener_set(loader->server,ip ? ip : loader->ip,port);
+}
+
+/** Load memory accounting */
+static apt_bool_t unimrcp_server_memory_accounting_load(unimrcp_server_loader_t *loader, const apr_xml_elem *root)
+{
+	const apr_xml_elem *elem;
+	apr_size_t session_budget = 0;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Memory Accounting");
+	for(elem = root->first_child; elem; elem = elem->next) {
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Element <%s>",elem->name);
+		if(strcasecmp(elem->name,"session-budget") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				/* in KB */
+				session_budget = (apr_size_t)atol(cdata_text_get(elem)) * 1024;
+			}
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
+		}
+	}
+	return mrcp_server_memory_accounting_set(loader->server,session_budget);
+}
+
+/** Load fetch cache */
+static apt_bool_t unimrcp_server_fetch_cache_load(unimrcp_server_loader_t *loader, const apr_xml_elem *root)
+{
+	const apr_xml_elem *elem;
+	mrcp_fetch_cache_config_t config;
+	mrcp_fetch_cache_config_init(&config);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Fetch Cache");
+	for(elem = root->first_child; elem; elem = elem->next) {
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Element <%s>",elem->name);
+		if(strcasecmp(elem->name,"size") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				/* in KB */
+				config.max_size = (apr_size_t)atol(cdata_text_get(elem)) * 1024;
+			}
+		}
+		else if(strcasecmp(elem->name,"dir") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				const char *root_path;
+				const char *path = cdata_text_get(elem);
+				if(loader->dir_layout && apr_filepath_root(&root_path,&path,0,loader->pool) == APR_ERELATIVE)
+					config.dir_path = apt_vardir_filepath_get(loader->dir_layout,path,loader->pool);
+				else
+					config.dir_path = cdata_copy(elem,loader->pool);
+			}
+		}
+		else if(strcasecmp(elem->name,"default-max-age") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				config.default_max_age = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"timeout") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				config.timeout = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"max-idle-connections") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				config.max_idle_connections = atol(cdata_text_get(elem));
+			}
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
+		}
+	}
+	return mrcp_server_fetch_cache_set(loader->server,&config);
+}
+
 /** Load properties */
 static apt_bool_t unimrcp_server_properties_load(unimrcp_server_loader_t *loader, const apr_xml_elem *root)
 {
@@ -976,6 +1716,66 @@ static apt_bool_t unimrcp_server_properties_load(unimrcp_server_loader_t *loader
 			loader->ext_ip = unimrcp_server_ip_address_get(loader,elem);
 			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Property ext-ip:%s",loader->ext_ip);
 		}
+		else if(strcasecmp(elem->name,"worker-count") == 0) {
+			const char *worker_count = cdata_text_get(elem);
+			if(worker_count) {
+				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Property worker-count:%s",worker_count);
+				mrcp_server_worker_count_set(loader->server,atol(worker_count));
+			}
+		}
+		else if(strcasecmp(elem->name,"executor-thread-count") == 0) {
+			const char *thread_count = cdata_text_get(elem);
+			if(thread_count) {
+				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Property executor-thread-count:%s",thread_count);
+				mrcp_server_executor_thread_count_set(loader->server,atol(thread_count));
+			}
+		}
+		else if(strcasecmp(elem->name,"executor-cpu-set") == 0) {
+			const apt_cpu_set_t *cpu_set = unimrcp_server_cpu_set_get(loader,elem);
+			if(cpu_set) {
+				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Property executor-cpu-set:%s",cdata_text_get(elem));
+				mrcp_server_executor_cpu_set_set(loader->server,cpu_set);
+			}
+		}
+		else if(strcasecmp(elem->name,"admission-control") == 0) {
+			unimrcp_server_admission_load(loader,elem);
+		}
+		else if(strcasecmp(elem->name,"slow-setup-threshold") == 0) {
+			const char *threshold = cdata_text_get(elem);
+			if(threshold) {
+				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Property slow-setup-threshold:%s",threshold);
+				mrcp_server_slow_setup_threshold_set(loader->server,atol(threshold));
+			}
+		}
+		else if(strcasecmp(elem->name,"session-cache-size") == 0) {
+			const char *size = cdata_text_get(elem);
+			if(size) {
+				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Property session-cache-size:%s",size);
+				mrcp_server_session_cache_size_set(loader->server,atol(size));
+			}
+		}
+		else if(strcasecmp(elem->name,"session-table-shards") == 0) {
+			const char *shards = cdata_text_get(elem);
+			if(shards) {
+				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Property session-table-shards:%s",shards);
+				mrcp_server_session_table_shards_set(loader->server,atol(shards));
+			}
+		}
+		else if(strcasecmp(elem->name,"event-fast-path") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Property event-fast-path:%s",cdata_text_get(elem));
+				mrcp_server_event_fast_path_set(loader->server,cdata_bool_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"metrics-listener") == 0) {
+			unimrcp_server_metrics_listener_load(loader,elem);
+		}
+		else if(strcasecmp(elem->name,"memory-accounting") == 0) {
+			unimrcp_server_memory_accounting_load(loader,elem);
+		}
+		else if(strcasecmp(elem->name,"fetch-cache") == 0) {
+			unimrcp_server_fetch_cache_load(loader,elem);
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -1091,6 +1891,10 @@ static apt_bool_t unimrcp_server_profiles_load(unimrcp_server_loader_t *loader,
 			continue;
 		}
 		if(is_attr_enabled(enable_attr) == FALSE) {
+			if(loader->reload == TRUE && mrcp_server_profile_get(loader->server,id_attr->value)) {
+				/* disabled at runtime */
+				mrcp_server_profile_unregister(loader->server,id_attr->value);
+			}
 			/* disabled element, just skip it */
 			continue;
 		}
@@ -1174,11 +1978,11 @@ static apr_xml_doc* unimrcp_server_doc_parse(const char *file_path, apr_pool_t *
 	return xml_doc;
 }
 
-static apt_bool_t unimrcp_server_load(mrcp_server_t *mrcp_server, apt_dir_layout_t *dir_layout, apr_pool_t *pool)
+/** Parse and check the document, create loader of it */
+static unimrcp_server_loader_t* unimrcp_server_loader_create(mrcp_server_t *mrcp_server, apt_dir_layout_t *dir_layout, apr_pool_t *pool)
 {
 	const char *file_path;
 	apr_xml_doc *doc;
-	const apr_xml_elem *elem;
 	const apr_xml_elem *root;
 	const apr_xml_attr *attr;
 	unimrcp_server_loader_t *loader;
@@ -1187,13 +1991,13 @@ static apt_bool_t unimrcp_server_load(mrcp_server_t *mrcp_server, apt_dir_layout
 	file_path = apt_confdir_filepath_get(dir_layout,CONF_FILE_NAME,pool);
 	if(!file_path) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Get Path to Conf File [%s]",CONF_FILE_NAME);
-		return FALSE;
+		return NULL;
 	}
 
 	/* Parse XML document */
 	doc = unimrcp_server_doc_parse(file_path,pool);
 	if(!doc) {
-		return FALSE;
+		return NULL;
 	}
 
 	root = doc->root;
@@ -1201,7 +2005,7 @@ static apt_bool_t unimrcp_server_load(mrcp_server_t *mrcp_server, apt_dir_layout
 	/* Match document name */
 	if(!root || strcasecmp(root->name,"unimrcpserver") != 0) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Document <%s>",root ? root->name : "null");
-		return FALSE;
+		return NULL;
 	}
 
 	/* Read attributes */
@@ -1214,7 +2018,7 @@ static apt_bool_t unimrcp_server_load(mrcp_server_t *mrcp_server, apt_dir_layout
 	/* Check version number first */
 	if(!version) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Version");
-		return FALSE;
+		return NULL;
 	}
 
 	loader = apr_palloc(pool,sizeof(unimrcp_server_loader_t));
@@ -1225,9 +2029,27 @@ static apt_bool_t unimrcp_server_load(mrcp_server_t *mrcp_server, apt_dir_layout
 	loader->ip = DEFAULT_IP_ADDRESS;
 	loader->ext_ip = NULL;
 	loader->auto_ip = NULL;
+	loader->reload = FALSE;
+	loader->engine_id = NULL;
+	loader->worker_index = 0;
+	loader->worker_count = 1;
+	return loader;
+}
+
+static apt_bool_t unimrcp_server_load(mrcp_server_t *mrcp_server, apt_dir_layout_t *dir_layout, apr_size_t worker_index, apr_size_t worker_count, apr_pool_t *pool)
+{
+	const apr_xml_elem *elem;
+	unimrcp_server_loader_t *loader;
+
+	loader = unimrcp_server_loader_create(mrcp_server,dir_layout,pool);
+	if(!loader) {
+		return FALSE;
+	}
+	loader->worker_index = worker_index;
+	loader->worker_count = worker_count;
 
 	/* Navigate through document */
-	for(elem = root->first_child; elem; elem = elem->next) {
+	for(elem = loader->doc->root->first_child; elem; elem = elem->next) {
 		if(strcasecmp(elem->name,"properties") == 0) {
 			unimrcp_server_properties_load(loader,elem);
 		}
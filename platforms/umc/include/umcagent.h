@@ -0,0 +1,79 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#ifndef UMC_AGENT_H
+#define UMC_AGENT_H
+
+/**
+ * @file umcagent.h
+ * @brief UMC Agent of Distributed Load
+ */
+
+#include <apr_network_io.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#include "umcload.h"
+
+class UmcFramework;
+
+/**
+ * Agent accepting loads from a remote coordinator (see UmcCoordinator).
+ *
+ * The coordinator connects and sends a single line
+ *   LOAD scenario profile cps concurrency total ramp-up
+ * the load is run by the framework, and the agent replies with a single line
+ *   RESULT status started completed failed elapsed-usec histogram
+ * and closes the connection. One load is run at a time.
+ */
+class UmcAgent : public UmcLoadListener
+{
+public:
+/* ============================ CREATORS =================================== */
+	UmcAgent(UmcFramework* pFramework);
+	~UmcAgent();
+
+/* ============================ MANIPULATORS =============================== */
+	bool Start(apr_port_t port);
+	void Stop();
+
+	/* called in the context of the framework task */
+	virtual void OnLoadComplete(const UmcLoad* pLoad, bool status);
+
+protected:
+	void Run();
+	void ProcessConnection(apr_socket_t* pSocket);
+
+	friend void* APR_THREAD_FUNC UmcAgentThreadProc(apr_thread_t* pThread, void* pData);
+
+private:
+/* ============================ DATA ======================================= */
+	UmcFramework*        m_pFramework;
+	apr_pool_t*          m_pPool;
+	apr_socket_t*        m_pListenSocket;
+	apr_thread_t*        m_pThread;
+	volatile bool        m_Running;
+
+	/** Connection of the coordinator, the load of which is in progress */
+	apr_thread_mutex_t*  m_pGuard;
+	apr_thread_cond_t*   m_pCompletion;
+	apr_socket_t*        m_pConnection;
+};
+
+#endif /* UMC_AGENT_H */
@@ -52,10 +52,12 @@ private:
 		const char*        m_DirLayoutConf;
 		const char*        m_LogPriority;
 		const char*        m_LogOutput;
+		const char*        m_AgentPort;
 
 		UmcOptions() : 
 			m_RootDirPath(NULL), m_DirLayoutConf(NULL), 
-			m_LogPriority(NULL), m_LogOutput(NULL) {}
+			m_LogPriority(NULL), m_LogOutput(NULL),
+			m_AgentPort(NULL) {}
 	};
 
 	UmcOptions      m_Options;
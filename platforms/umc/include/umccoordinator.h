@@ -0,0 +1,107 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#ifndef UMC_COORDINATOR_H
+#define UMC_COORDINATOR_H
+
+/**
+ * @file umccoordinator.h
+ * @brief UMC Coordinator of Distributed Load
+ */
+
+#include <apr_network_io.h>
+#include <apr_thread_proc.h>
+#include "umchistogram.h"
+
+/** Max number of agents of distributed load */
+#define UMC_COORDINATOR_MAX_AGENTS 64
+
+/**
+ * Coordinator distributing load over remote agents (see UmcAgent).
+ *
+ * The rate and the total number of sessions are split evenly between the agents,
+ * the results of the agents are collected and merged into a single report.
+ */
+class UmcCoordinator
+{
+public:
+/* ============================ CREATORS =================================== */
+	UmcCoordinator();
+	~UmcCoordinator();
+
+/* ============================ MANIPULATORS =============================== */
+	/**
+	 * Run distributed load in the background.
+	 * @param pAgents comma-separated list of agents as host:port
+	 */
+	bool Run(const char* pAgents, const char* pScenarioName, const char* pProfileName,
+		double cps, apr_size_t concurrency, apr_size_t total, apr_size_t rampUp);
+	void Stop();
+
+/* ============================ INQUIRIES ================================== */
+	bool IsInProgress() const;
+
+protected:
+	struct Agent
+	{
+		const char*    m_pAddress;
+		apr_socket_t*  m_pSocket;
+		double         m_Cps;
+		apr_size_t     m_Concurrency;
+		apr_size_t     m_Total;
+
+		bool           m_Status;
+		apr_size_t     m_Started;
+		apr_size_t     m_Completed;
+		apr_size_t     m_Failed;
+		apr_time_t     m_Elapsed;
+		UmcHistogram   m_Durations;
+	};
+
+	void Process();
+	bool Connect(Agent* pAgent);
+	bool Receive(Agent* pAgent, apr_time_t deadline);
+	void Report();
+
+	friend void* APR_THREAD_FUNC UmcCoordinatorThreadProc(apr_thread_t* pThread, void* pData);
+
+private:
+/* ============================ DATA ======================================= */
+	apr_pool_t*          m_pPool;
+	apr_thread_t*        m_pThread;
+	volatile bool        m_Running;
+	volatile bool        m_InProgress;
+
+	const char*          m_pScenarioName;
+	const char*          m_pProfileName;
+	apr_size_t           m_RampUp;
+	/** Time the results are waited for until (usec) */
+	apr_interval_time_t  m_Timeout;
+
+	Agent*               m_pAgents;
+	int                  m_AgentCount;
+};
+
+/* ============================ INLINE METHODS ============================= */
+inline bool UmcCoordinator::IsInProgress() const
+{
+	return m_InProgress;
+}
+
+#endif /* UMC_COORDINATOR_H */
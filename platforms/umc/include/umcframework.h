@@ -28,8 +28,11 @@
 #include <apr_hash.h>
 #include "apt_consumer_task.h"
 #include "umcsession.h"
+#include "umcscenario.h"
 
-class UmcScenario;
+class UmcLoad;
+class UmcAgent;
+class UmcCoordinator;
 
 class UmcFramework : public UmcSessionMethodProvider
 {
@@ -46,8 +49,21 @@ public:
 	void StopSession(const char* id);
 	void KillSession(const char* id);
 
+	void RunLoad(const char* pScenarioName, const char* pProfileName,
+		double cps, apr_size_t concurrency, apr_size_t total, apr_size_t rampUp);
+	/** Run the load, the framework takes the ownership of */
+	void RunLoad(UmcLoad* pLoad);
+	void StopLoad();
+
+	/** Accept loads from a remote coordinator on the port */
+	bool StartAgent(apr_port_t port);
+	/** Distribute the load over the comma-separated list of agents (host:port) */
+	void RunDistributedLoad(const char* pAgents, const char* pScenarioName, const char* pProfileName,
+		double cps, apr_size_t concurrency, apr_size_t total, apr_size_t rampUp);
+
 	void ShowScenarios();
 	void ShowSessions();
+	void ShowTimings(UmcReportFormat format);
 
 protected:
 	bool CreateMrcpClient();
@@ -62,11 +78,17 @@ protected:
 	bool LoadScenarios();
 	void DestroyScenarios();
 
+	UmcSession* LaunchSession(UmcScenario* pScenario, const char* pProfileName);
 	bool ProcessRunRequest(const char* pScenarioName, const char* pProfileName);
+	bool ProcessRunLoadRequest(UmcLoad* pLoad);
+	void ProcessStopLoadRequest();
+	void CompleteLoad(UmcLoad* pLoad, bool status);
+	void ProcessLoadTimer();
 	void ProcessStopRequest(const char* id);
 	void ProcessKillRequest(const char* id);
 	void ProcessShowScenarios();
 	void ProcessShowSessions();
+	void ProcessShowTimings(UmcReportFormat format);
 	void ProcessSessionExit(UmcSession* pUmcSession);
 
 	bool AddSession(UmcSession* pSession);
@@ -80,6 +102,7 @@ protected:
 	friend void UmcOnStartComplete(apt_task_t* pTask);
 	friend void UmcOnTerminateComplete(apt_task_t* pTask);
 	friend apt_bool_t AppMessageHandler(const mrcp_app_message_t* pAppMessage);
+	friend void UmcOnLoadTimer(apt_timer_t* pTimer, void* pObj);
 
 private:
 /* ============================ DATA ======================================= */
@@ -92,6 +115,13 @@ private:
 
 	apr_hash_t*          m_pScenarioTable;
 	apr_hash_t*          m_pSessionTable;
+
+	apt_timer_t*         m_pLoadTimer;
+	UmcLoad*             m_pLoad;
+	apr_hash_t*          m_pLoadSessionTable;
+
+	UmcAgent*            m_pAgent;
+	UmcCoordinator*      m_pCoordinator;
 };
 
 #endif /* UMC_FRAMEWORK_H */
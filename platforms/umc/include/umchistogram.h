@@ -0,0 +1,96 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef UMC_HISTOGRAM_H
+#define UMC_HISTOGRAM_H
+
+/**
+ * @file umchistogram.h
+ * @brief UMC Histogram of Latencies
+ */
+
+#include <apr_pools.h>
+#include "apt.h"
+
+/** Number of sub-buckets per power of two, the precision of recorded values is 1/16 */
+#define UMC_HISTOGRAM_SUB_BUCKETS  16
+/** Number of buckets to cover 32-bit values */
+#define UMC_HISTOGRAM_BUCKET_COUNT (UMC_HISTOGRAM_SUB_BUCKETS * 29)
+
+/**
+ * Log-linear histogram (HDR histogram alike) of values in usec.
+ * Memory and the cost of recording do not depend on the number of values.
+ */
+class UmcHistogram
+{
+public:
+/* ============================ CREATORS =================================== */
+	UmcHistogram();
+
+/* ============================ MANIPULATORS =============================== */
+	void Reset();
+	void Record(apr_interval_time_t value);
+	/** Add the values of another histogram, e.g. of a remote agent */
+	void Merge(const UmcHistogram& other);
+	/** Decode the histogram from the text composed by Encode() */
+	bool Decode(const char* pText);
+
+/* ============================ ACCESSORS ================================== */
+	apr_uint32_t GetCount() const;
+	apr_uint32_t GetMin() const;
+	apr_uint32_t GetMax() const;
+	apr_uint32_t GetMean() const;
+	apr_uint32_t GetPercentile(double percent) const;
+	/** Encode the histogram as text "count min max sum [index:count]..." of non-empty buckets */
+	const char* Encode(apr_pool_t* pool) const;
+
+private:
+/* ============================ ACCESSORS ================================== */
+	static apr_size_t GetIndex(apr_uint32_t value);
+	static apr_uint32_t GetValue(apr_size_t index);
+
+/* ============================ DATA ======================================= */
+	apr_uint32_t m_Counts[UMC_HISTOGRAM_BUCKET_COUNT];
+	apr_uint32_t m_Count;
+	apr_uint32_t m_Min;
+	apr_uint32_t m_Max;
+	apr_uint64_t m_Sum;
+};
+
+/* ============================ INLINE METHODS ============================= */
+inline apr_uint32_t UmcHistogram::GetCount() const
+{
+	return m_Count;
+}
+
+inline apr_uint32_t UmcHistogram::GetMin() const
+{
+	return m_Count ? m_Min : 0;
+}
+
+inline apr_uint32_t UmcHistogram::GetMax() const
+{
+	return m_Max;
+}
+
+inline apr_uint32_t UmcHistogram::GetMean() const
+{
+	return m_Count ? (apr_uint32_t)(m_Sum / m_Count) : 0;
+}
+
+#endif /* UMC_HISTOGRAM_H */
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef UMC_LOAD_H
+#define UMC_LOAD_H
+
+/**
+ * @file umcload.h
+ * @brief UMC Load Generator
+ */
+
+#include "apt.h"
+#include "umchistogram.h"
+
+class UmcLoad;
+
+/** Listener of load completion, e.g. the agent reporting to a remote coordinator */
+class UmcLoadListener
+{
+public:
+	virtual ~UmcLoadListener() {}
+	/** Called once the load is complete or rejected (status is false then) */
+	virtual void OnLoadComplete(const UmcLoad* pLoad, bool status) = 0;
+};
+
+class UmcLoad
+{
+public:
+/* ============================ CREATORS =================================== */
+	UmcLoad(const char* pScenarioName, const char* pProfileName,
+		double cps, apr_size_t concurrency, apr_size_t total, apr_size_t rampUp);
+	~UmcLoad();
+
+/* ============================ MANIPULATORS =============================== */
+	void Start(apr_time_t now);
+	void Stop();
+
+	void OnSessionStart(bool status);
+	void OnSessionExit(apr_interval_time_t duration);
+
+	void Report(apr_time_t now);
+
+	void SetListener(UmcLoadListener* pListener);
+
+/* ============================ ACCESSORS ================================== */
+	const char* GetScenarioName() const;
+	const char* GetProfileName() const;
+
+	apr_size_t GetDueCount(apr_time_t now) const;
+
+	UmcLoadListener* GetListener() const;
+	apr_time_t GetStartTime() const;
+	apr_size_t GetStarted() const;
+	apr_size_t GetCompleted() const;
+	apr_size_t GetFailed() const;
+	/** Durations of completed sessions (usec) */
+	const UmcHistogram& GetDurations() const;
+
+/* ============================ INQUIRIES ================================== */
+	bool IsComplete() const;
+	bool IsReportDue(apr_time_t now) const;
+
+private:
+/* ============================ DATA ======================================= */
+	apr_pool_t*          m_pPool;
+	const char*          m_pScenarioName;
+	const char*          m_pProfileName;
+
+	/** Target rate of session launches (calls per second) */
+	double               m_Cps;
+	/** Max number of sessions in progress (0 - unlimited) */
+	apr_size_t           m_Concurrency;
+	/** Total number of sessions to launch */
+	apr_size_t           m_Total;
+	/** Duration the rate is linearly raised to the target in (sec) */
+	apr_size_t           m_RampUp;
+
+	apr_time_t           m_StartTime;
+	apr_time_t           m_ReportTime;
+	apr_size_t           m_ReportCompleted;
+
+	apr_size_t           m_Started;
+	apr_size_t           m_Failed;
+	apr_size_t           m_Completed;
+	/** Durations of completed sessions (usec) */
+	UmcHistogram         m_Durations;
+
+	UmcLoadListener*     m_pListener;
+};
+
+/* ============================ INLINE METHODS ============================= */
+inline const char* UmcLoad::GetScenarioName() const
+{
+	return m_pScenarioName;
+}
+
+inline const char* UmcLoad::GetProfileName() const
+{
+	return m_pProfileName;
+}
+
+inline void UmcLoad::SetListener(UmcLoadListener* pListener)
+{
+	m_pListener = pListener;
+}
+
+inline UmcLoadListener* UmcLoad::GetListener() const
+{
+	return m_pListener;
+}
+
+inline apr_time_t UmcLoad::GetStartTime() const
+{
+	return m_StartTime;
+}
+
+inline apr_size_t UmcLoad::GetStarted() const
+{
+	return m_Started;
+}
+
+inline apr_size_t UmcLoad::GetCompleted() const
+{
+	return m_Completed;
+}
+
+inline apr_size_t UmcLoad::GetFailed() const
+{
+	return m_Failed;
+}
+
+inline const UmcHistogram& UmcLoad::GetDurations() const
+{
+	return m_Durations;
+}
+
+inline bool UmcLoad::IsComplete() const
+{
+	return m_Started >= m_Total && m_Completed + m_Failed >= m_Started;
+}
+
+inline bool UmcLoad::IsReportDue(apr_time_t now) const
+{
+	return now - m_ReportTime >= APR_USEC_PER_SEC;
+}
+
+#endif /* UMC_LOAD_H */
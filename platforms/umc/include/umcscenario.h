@@ -26,8 +26,16 @@
 
 #include <apr_xml.h>
 #include "mrcp_application.h"
+#include "umcsession.h"
+#include "umchistogram.h"
 
-class UmcSession;
+/** Formats to report timings in */
+enum UmcReportFormat
+{
+	UMC_REPORT_FORMAT_TEXT,
+	UMC_REPORT_FORMAT_CSV,
+	UMC_REPORT_FORMAT_JSON
+};
 
 class UmcScenario
 {
@@ -48,6 +56,14 @@ public:
 
 	bool InitCapabilities(mpf_stream_capabilities_t* pCapabilities) const;
 
+	/** Aggregate the timings captured by the session */
+	void RecordTimings(const UmcSession* pSession);
+	void ResetTimings();
+	/** Print percentiles of the timings aggregated so far */
+	void ReportTimings(UmcReportFormat format, bool header) const;
+
+	static const char* GetTimingName(UmcTiming id);
+
 /* ============================ ACCESSORS ================================== */
 	apt_dir_layout_t* GetDirLayout() const;
 	const char* GetName() const;
@@ -79,6 +95,8 @@ protected:
 	bool                              m_ResourceDiscovery;
 	mpf_codec_capabilities_t*         m_pCapabilities;
 	mpf_rtp_termination_descriptor_t* m_pRtpDescriptor;
+
+	UmcHistogram                      m_Timings[UMC_TIMING_COUNT];
 };
 
 
@@ -29,6 +29,19 @@
 class UmcScenario;
 class UmcSession;
 
+/** Latencies captured per session */
+enum UmcTiming
+{
+	UMC_TIMING_SETUP,                /**< session start to channel added */
+	UMC_TIMING_FIRST_RESPONSE,       /**< first request to its response */
+	UMC_TIMING_START_OF_INPUT,       /**< RECOGNIZE to START-OF-INPUT */
+	UMC_TIMING_RECOGNITION_COMPLETE, /**< RECOGNIZE to RECOGNITION-COMPLETE */
+	UMC_TIMING_SPEAK_COMPLETE,       /**< SPEAK to SPEAK-COMPLETE */
+	UMC_TIMING_FIRST_RTP,            /**< SPEAK to the first audio frame received */
+
+	UMC_TIMING_COUNT
+};
+
 class UmcSessionEventHandler
 {
 public:
@@ -70,6 +83,8 @@ public:
 	apr_pool_t* GetSessionPool() const;
 
 	const char* GetId() const;
+	apr_time_t GetStartTime() const;
+	apr_interval_time_t GetTiming(UmcTiming id) const;
 
 protected:
 /* ============================ MANIPULATORS =============================== */
@@ -83,6 +98,11 @@ protected:
 	bool SendMrcpRequest(mrcp_channel_t* pMrcpChannel, mrcp_message_t* pMrcpMessage);
 	bool DiscoverResources();
 
+	/** Capture the latency of the event just received, once per session */
+	void MarkTiming(UmcTiming id);
+	/** Capture the latency of the event happened at the specified time */
+	void SetTiming(UmcTiming id, apr_time_t time);
+
 	mrcp_channel_t* CreateMrcpChannel(
 			mrcp_resource_id resource_id,
 			mpf_termination_t* pTermination,
@@ -122,6 +142,9 @@ private:
 	mrcp_session_t*             m_pMrcpSession;
 	mrcp_message_t*             m_pMrcpMessage; /* last message sent */
 	apt_timer_t*                m_pTimer;
+	apr_time_t                  m_StartTime;
+	apr_time_t                  m_RequestTime; /* time the last message sent */
+	apr_interval_time_t         m_Timings[UMC_TIMING_COUNT];
 	bool                        m_Running;
 	bool                        m_Terminating;
 };
@@ -137,6 +160,16 @@ inline const char* UmcSession::GetId() const
 	return m_Id;
 }
 
+inline apr_time_t UmcSession::GetStartTime() const
+{
+	return m_StartTime;
+}
+
+inline apr_interval_time_t UmcSession::GetTiming(UmcTiming id) const
+{
+	return m_Timings[id];
+}
+
 inline apr_pool_t* UmcSession::GetSessionPool() const
 {
 	return m_Pool;
@@ -280,6 +280,7 @@ bool RecogSession::OnMessageReceive(mrcp_channel_t* pMrcpChannel, mrcp_message_t
 	{
 		if(pMrcpMessage->start_line.method_id == RECOGNIZER_RECOGNITION_COMPLETE) 
 		{
+			MarkTiming(UMC_TIMING_RECOGNITION_COMPLETE);
 			ParseNLSMLResult(pMrcpMessage);
 			if(pRecogChannel) 
 				pRecogChannel->m_Streaming = false;
@@ -293,6 +294,7 @@ bool RecogSession::OnMessageReceive(mrcp_channel_t* pMrcpChannel, mrcp_message_t
 		else if(pMrcpMessage->start_line.method_id == RECOGNIZER_START_OF_INPUT) 
 		{
 			/* received start-of-input, do whatever you need here */
+			MarkTiming(UMC_TIMING_START_OF_INPUT);
 		}
 	}
 	return true;
@@ -32,8 +32,10 @@ struct SynthChannel
 	mrcp_message_t* m_pSpeakRequest;
 	/** File to write audio stream to */
 	FILE*           m_pAudioOut;
+	/** Time the first audio frame received (set in the context of media processing) */
+	apr_time_t      m_FirstAudioTime;
 
-	SynthChannel() : m_pMrcpChannel(NULL), m_pSpeakRequest(NULL), m_pAudioOut(NULL) {}
+	SynthChannel() : m_pMrcpChannel(NULL), m_pSpeakRequest(NULL), m_pAudioOut(NULL), m_FirstAudioTime(0) {}
 };
 
 SynthSession::SynthSession(const SynthScenario* pScenario) :
@@ -117,6 +119,8 @@ bool SynthSession::OnSessionTerminate(mrcp_sig_status_code_e status)
 static apt_bool_t WriteStream(mpf_audio_stream_t* pStream, const mpf_frame_t* pFrame)
 {
 	SynthChannel* pSynthChannel = (SynthChannel*) pStream->obj;
+	if(pSynthChannel && !pSynthChannel->m_FirstAudioTime && (pFrame->type & MEDIA_FRAME_TYPE_AUDIO))
+		pSynthChannel->m_FirstAudioTime = apr_time_now();
 	if(pSynthChannel && pSynthChannel->m_pAudioOut) 
 	{
 		fwrite(pFrame->codec_frame.buffer,1,pFrame->codec_frame.size,pSynthChannel->m_pAudioOut);
@@ -235,9 +239,15 @@ bool SynthSession::OnMessageReceive(mrcp_channel_t* pMrcpChannel, mrcp_message_t
 		/* received MRCP event */
 		if(pMrcpMessage->start_line.method_id == SYNTHESIZER_SPEAK_COMPLETE) 
 		{
+			MarkTiming(UMC_TIMING_SPEAK_COMPLETE);
 			SynthChannel* pSynthChannel = (SynthChannel*) mrcp_application_channel_object_get(pMrcpChannel);
 			if(pSynthChannel)
+			{
 				pSynthChannel->m_pSpeakRequest = NULL;
+				/* audio received before SPEAK is not accounted */
+				if(pSynthChannel->m_FirstAudioTime)
+					SetTiming(UMC_TIMING_FIRST_RTP,pSynthChannel->m_FirstAudioTime);
+			}
 			/* received SPEAK-COMPLETE event, terminate the session */
 			Terminate();
 		}
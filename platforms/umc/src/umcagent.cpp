@@ -0,0 +1,230 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <apr_strings.h>
+#include "umcagent.h"
+#include "umcframework.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+
+/** Interval to check whether the agent is stopped at (usec) */
+#define UMC_AGENT_POLL_INTERVAL 500000
+/** Max length of the line of the protocol */
+#define UMC_AGENT_MAX_LINE      1024
+
+void* APR_THREAD_FUNC UmcAgentThreadProc(apr_thread_t* pThread, void* pData)
+{
+	UmcAgent* pAgent = (UmcAgent*) pData;
+	pAgent->Run();
+	apr_thread_exit(pThread,APR_SUCCESS);
+	return NULL;
+}
+
+UmcAgent::UmcAgent(UmcFramework* pFramework) :
+	m_pFramework(pFramework),
+	m_pPool(NULL),
+	m_pListenSocket(NULL),
+	m_pThread(NULL),
+	m_Running(false),
+	m_pGuard(NULL),
+	m_pCompletion(NULL),
+	m_pConnection(NULL)
+{
+	m_pPool = apt_pool_create();
+	/* nested, the load may be completed right away in the context of the agent */
+	apr_thread_mutex_create(&m_pGuard,APR_THREAD_MUTEX_NESTED,m_pPool);
+	apr_thread_cond_create(&m_pCompletion,m_pPool);
+}
+
+UmcAgent::~UmcAgent()
+{
+	Stop();
+	apr_thread_cond_destroy(m_pCompletion);
+	apr_thread_mutex_destroy(m_pGuard);
+	apr_pool_destroy(m_pPool);
+}
+
+bool UmcAgent::Start(apr_port_t port)
+{
+	apr_sockaddr_t* pSockAddr = NULL;
+	if(m_pThread)
+		return false;
+
+	if(apr_sockaddr_info_get(&pSockAddr,NULL,APR_INET,port,0,m_pPool) != APR_SUCCESS ||
+		apr_socket_create(&m_pListenSocket,pSockAddr->family,SOCK_STREAM,APR_PROTO_TCP,m_pPool) != APR_SUCCESS)
+	{
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Agent Socket [%hu]",port);
+		return false;
+	}
+
+	apr_socket_opt_set(m_pListenSocket,APR_SO_REUSEADDR,1);
+	/* accept is waited for with a timeout not to miss the stop */
+	apr_socket_timeout_set(m_pListenSocket,UMC_AGENT_POLL_INTERVAL);
+	if(apr_socket_bind(m_pListenSocket,pSockAddr) != APR_SUCCESS ||
+		apr_socket_listen(m_pListenSocket,SOMAXCONN) != APR_SUCCESS)
+	{
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Listen Agent Socket [%hu]",port);
+		apr_socket_close(m_pListenSocket);
+		m_pListenSocket = NULL;
+		return false;
+	}
+
+	m_Running = true;
+	if(apr_thread_create(&m_pThread,NULL,UmcAgentThreadProc,this,m_pPool) != APR_SUCCESS)
+	{
+		m_Running = false;
+		m_pThread = NULL;
+		apr_socket_close(m_pListenSocket);
+		m_pListenSocket = NULL;
+		return false;
+	}
+
+	printf("Agent Is Listening on Port [%hu]\n",port);
+	return true;
+}
+
+void UmcAgent::Stop()
+{
+	if(!m_pThread)
+		return;
+
+	apr_thread_mutex_lock(m_pGuard);
+	m_Running = false;
+	apr_thread_cond_signal(m_pCompletion);
+	apr_thread_mutex_unlock(m_pGuard);
+
+	apr_status_t rv;
+	apr_thread_join(&rv,m_pThread);
+	m_pThread = NULL;
+
+	apr_socket_close(m_pListenSocket);
+	m_pListenSocket = NULL;
+}
+
+void UmcAgent::Run()
+{
+	while(m_Running)
+	{
+		apr_pool_t* pPool = apt_subpool_create(m_pPool);
+		apr_socket_t* pSocket = NULL;
+		if(apr_socket_accept(&pSocket,m_pListenSocket,pPool) == APR_SUCCESS)
+		{
+			ProcessConnection(pSocket);
+		}
+		apr_pool_destroy(pPool);
+	}
+}
+
+void UmcAgent::ProcessConnection(apr_socket_t* pSocket)
+{
+	char line[UMC_AGENT_MAX_LINE];
+	apr_size_t length = 0;
+	char* pEnd = NULL;
+
+	/* the command is expected right away */
+	apr_socket_timeout_set(pSocket,10 * APR_USEC_PER_SEC);
+	while(length < sizeof(line) - 1)
+	{
+		apr_size_t size = sizeof(line) - 1 - length;
+		if(apr_socket_recv(pSocket,line + length,&size) != APR_SUCCESS || !size)
+			break;
+		length += size;
+		line[length] = '\0';
+		pEnd = strchr(line,'\n');
+		if(pEnd)
+			break;
+	}
+	if(!pEnd)
+	{
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Receive Agent Command");
+		apr_socket_close(pSocket);
+		return;
+	}
+	*pEnd = '\0';
+
+	char* pLast;
+	const char* pName = apr_strtok(line," \r",&pLast);
+	const char* pScenarioName = apr_strtok(NULL," \r",&pLast);
+	const char* pProfileName = apr_strtok(NULL," \r",&pLast);
+	const char* pCps = apr_strtok(NULL," \r",&pLast);
+	const char* pConcurrency = apr_strtok(NULL," \r",&pLast);
+	const char* pTotal = apr_strtok(NULL," \r",&pLast);
+	const char* pRampUp = apr_strtok(NULL," \r",&pLast);
+	if(!pName || strcasecmp(pName,"LOAD") != 0 || !pRampUp || atof(pCps) <= 0 || atol(pTotal) <= 0)
+	{
+		static const char reject[] = "RESULT 0\n";
+		apr_size_t size = sizeof(reject) - 1;
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Agent Command");
+		apr_socket_send(pSocket,reject,&size);
+		apr_socket_close(pSocket);
+		return;
+	}
+
+	UmcLoad* pLoad = new UmcLoad(pScenarioName,pProfileName,atof(pCps),atol(pConcurrency),atol(pTotal),atol(pRampUp));
+	pLoad->SetListener(this);
+	printf("Agent Received Load [%s] from Coordinator\n",pScenarioName);
+
+	apr_thread_mutex_lock(m_pGuard);
+	m_pConnection = pSocket;
+	m_pFramework->RunLoad(pLoad);
+	/* the connection is closed by OnLoadComplete() */
+	while(m_pConnection && m_Running)
+		apr_thread_cond_timedwait(m_pCompletion,m_pGuard,UMC_AGENT_POLL_INTERVAL);
+	if(m_pConnection)
+	{
+		/* the agent is stopped with the load in progress */
+		apr_socket_close(m_pConnection);
+		m_pConnection = NULL;
+	}
+	apr_thread_mutex_unlock(m_pGuard);
+}
+
+void UmcAgent::OnLoadComplete(const UmcLoad* pLoad, bool status)
+{
+	apr_thread_mutex_lock(m_pGuard);
+	if(m_pConnection)
+	{
+		apr_pool_t* pPool = apt_subpool_create(m_pPool);
+		const char* pResult = apr_psprintf(pPool,"RESULT %d %" APR_SIZE_T_FMT " %" APR_SIZE_T_FMT " %" APR_SIZE_T_FMT " %" APR_TIME_T_FMT " %s\n",
+			status ? 1 : 0,
+			pLoad->GetStarted(),
+			pLoad->GetCompleted(),
+			pLoad->GetFailed(),
+			pLoad->GetStartTime() ? apr_time_now() - pLoad->GetStartTime() : 0,
+			pLoad->GetDurations().Encode(pPool));
+		apr_size_t length = strlen(pResult);
+		const char* pPos = pResult;
+		while(length)
+		{
+			apr_size_t size = length;
+			if(apr_socket_send(m_pConnection,pPos,&size) != APR_SUCCESS)
+				break;
+			pPos += size;
+			length -= size;
+		}
+		apr_pool_destroy(pPool);
+
+		apr_socket_close(m_pConnection);
+		m_pConnection = NULL;
+		apr_thread_cond_signal(m_pCompletion);
+	}
+	apr_thread_mutex_unlock(m_pGuard);
+}
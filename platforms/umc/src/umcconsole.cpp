@@ -112,6 +112,11 @@ bool UmcConsole::Run(int argc, const char * const *argv)
 	/* create demo framework */
 	if(m_pFramework->Create(pDirLayout,pool))
 	{
+		if(m_Options.m_AgentPort)
+		{
+			/* accept loads from a remote coordinator */
+			m_pFramework->StartAgent((apr_port_t)atoi(m_Options.m_AgentPort));
+		}
 		/* run command line  */
 		RunCmdLine();
 		/* destroy demo framework */
@@ -147,6 +152,60 @@ bool UmcConsole::ProcessCmdLine(char* pCmdLine)
 			m_pFramework->RunSession(pScenarioName,pProfileName);
 		}
 	}
+	else if(strcasecmp(name,"load") == 0)
+	{
+		char* pScenarioName = apr_strtok(NULL, " ", &last);
+		if(pScenarioName && strcasecmp(pScenarioName,"stop") == 0)
+		{
+			m_pFramework->StopLoad();
+		}
+		else if(pScenarioName) 
+		{
+			const char* pProfileName = apr_strtok(NULL, " ", &last);
+			const char* pCps = apr_strtok(NULL, " ", &last);
+			const char* pConcurrency = apr_strtok(NULL, " ", &last);
+			const char* pTotal = apr_strtok(NULL, " ", &last);
+			const char* pRampUp = apr_strtok(NULL, " ", &last);
+			double cps = pCps ? atof(pCps) : 1;
+			long total = pTotal ? atol(pTotal) : 100;
+			if(cps > 0 && total > 0)
+			{
+				m_pFramework->RunLoad(
+					pScenarioName,
+					pProfileName ? pProfileName : "uni2",
+					cps,
+					pConcurrency ? atol(pConcurrency) : 0,
+					total,
+					pRampUp ? atol(pRampUp) : 0);
+			}
+		}
+	}
+	else if(strcasecmp(name,"distribute") == 0)
+	{
+		char* pAgents = apr_strtok(NULL, " ", &last);
+		char* pScenarioName = apr_strtok(NULL, " ", &last);
+		if(pAgents && pScenarioName) 
+		{
+			const char* pProfileName = apr_strtok(NULL, " ", &last);
+			const char* pCps = apr_strtok(NULL, " ", &last);
+			const char* pConcurrency = apr_strtok(NULL, " ", &last);
+			const char* pTotal = apr_strtok(NULL, " ", &last);
+			const char* pRampUp = apr_strtok(NULL, " ", &last);
+			double cps = pCps ? atof(pCps) : 1;
+			long total = pTotal ? atol(pTotal) : 100;
+			if(cps > 0 && total > 0)
+			{
+				m_pFramework->RunDistributedLoad(
+					pAgents,
+					pScenarioName,
+					pProfileName ? pProfileName : "uni2",
+					cps,
+					pConcurrency ? atol(pConcurrency) : 0,
+					total,
+					pRampUp ? atol(pRampUp) : 0);
+			}
+		}
+	}
 	else if(strcasecmp(name,"kill") == 0)
 	{
 		char* pID = apr_strtok(NULL, " ", &last);
@@ -172,6 +231,16 @@ bool UmcConsole::ProcessCmdLine(char* pCmdLine)
 				m_pFramework->ShowSessions();
 			else if(strcasecmp(pWhat,"scenarios") == 0)
 				m_pFramework->ShowScenarios();
+			else if(strcasecmp(pWhat,"timings") == 0)
+			{
+				const char* pFormat = apr_strtok(NULL, " ", &last);
+				UmcReportFormat format = UMC_REPORT_FORMAT_TEXT;
+				if(pFormat && strcasecmp(pFormat,"csv") == 0)
+					format = UMC_REPORT_FORMAT_CSV;
+				else if(pFormat && strcasecmp(pFormat,"json") == 0)
+					format = UMC_REPORT_FORMAT_JSON;
+				m_pFramework->ShowTimings(format);
+			}
 		}
 	}
 	else if(strcasecmp(name,"loglevel") == 0) 
@@ -197,14 +266,31 @@ bool UmcConsole::ProcessCmdLine(char* pCmdLine)
 			   "           run recog\n"
 			   "           run synth uni1\n"
 			   "           run recog uni1\n"
+		       "\n- load [scenario] [profile] [cps] [concurrency] [total] [ramp-up] (run sessions at a rate)\n"
+			   "       cps is the target number of sessions launched per second (1 by default)\n"
+			   "       concurrency is the max number of sessions in progress (0 - unlimited)\n"
+			   "       total is the number of sessions to launch (100 by default)\n"
+			   "       ramp-up is the number of seconds to reach the target rate in (0 by default)\n"
+			   "\n       examples: \n"
+			   "           load recog uni2 10 50 1000 10\n"
+			   "           load stop\n"
+		       "\n- distribute [agents] [scenario] [profile] [cps] [concurrency] [total] [ramp-up] (run load on remote agents)\n"
+			   "       agents is a comma-separated list of host:port of umc started with --agent\n"
+			   "       cps, concurrency and total are split evenly between the agents,\n"
+			   "       the latency histograms and error counts of the agents are merged into one report\n"
+			   "\n       example: \n"
+			   "           distribute 10.0.0.1:8100,10.0.0.2:8100 recog uni2 100 500 10000 10\n"
 		       "\n- kill [id] (kill session)\n"
 			   "       id is a session identifier: 1, 2, ... (use 'show sessions')\n"
 			   "\n       example: \n"
 			   "           kill 1\n"
-		       "\n- show [what] (show either available scenarios or in-progress sessions)\n"
+		       "\n- show [what] (show available scenarios, in-progress sessions or latency percentiles)\n"
+			   "       timings are aggregated per scenario, optionally in 'csv' or 'json' (usec)\n"
 			   "\n       examples: \n"
 			   "           show scenarios\n"
 			   "           show sessions\n"
+			   "           show timings\n"
+			   "           show timings csv\n"
 		       "\n- loglevel [level] (set loglevel, one of 0,1...7)\n"
 		       "\n- quit, exit\n");
 	}
@@ -267,6 +353,8 @@ void UmcConsole::Usage()
 		"   -o [--log-output] mode   : Set the log output mode.\n"
 		"                              (0-none, 1-console only, 2-file only, 3-both)\n"
 		"\n"
+		"   -a [--agent] port        : Accept loads from a remote coordinator on the port.\n"
+		"\n"
 		"   -v [--version]           : Show the version.\n"
 		"\n"
 		"   -h [--help]              : Show the help.\n"
@@ -287,6 +375,7 @@ bool UmcConsole::LoadOptions(int argc, const char * const *argv, apr_pool_t *poo
 		{ "dir-layout",  'c', TRUE,  "path to dir layout conf" },  /* -c arg or --dir-layout arg */
 		{ "log-prio",    'l', TRUE,  "log priority" },             /* -l arg or --log-prio arg */
 		{ "log-output",  'o', TRUE,  "log output mode" },          /* -o arg or --log-output arg */
+		{ "agent",       'a', TRUE,  "agent port" },               /* -a arg or --agent arg */
 		{ "version",     'v', FALSE, "show version" },             /* -v or --version */
 		{ "help",        'h', FALSE, "show help" },                /* -h or --help */
 		{ NULL, 0, 0, NULL },                                      /* end */
@@ -314,6 +403,10 @@ bool UmcConsole::LoadOptions(int argc, const char * const *argv, apr_pool_t *poo
 				if(optarg) 
 				m_Options.m_LogOutput = optarg;
 				break;
+			case 'a':
+				if(optarg) 
+				m_Options.m_AgentPort = optarg;
+				break;
 			case 'v':
 				printf(UNI_VERSION_STRING);
 				return FALSE;
@@ -0,0 +1,323 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <apr_strings.h>
+#include "umccoordinator.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+
+/** Interval to check whether the coordinator is stopped at (usec) */
+#define UMC_COORDINATOR_POLL_INTERVAL 500000
+/** Time to wait for the sessions in progress to complete after the last launch (sec) */
+#define UMC_COORDINATOR_GRACE_TIME    60
+/** Max length of the result line of an agent */
+#define UMC_COORDINATOR_MAX_LINE      (256 + 22 * UMC_HISTOGRAM_BUCKET_COUNT)
+
+void* APR_THREAD_FUNC UmcCoordinatorThreadProc(apr_thread_t* pThread, void* pData)
+{
+	UmcCoordinator* pCoordinator = (UmcCoordinator*) pData;
+	pCoordinator->Process();
+	apr_thread_exit(pThread,APR_SUCCESS);
+	return NULL;
+}
+
+UmcCoordinator::UmcCoordinator() :
+	m_pPool(NULL),
+	m_pThread(NULL),
+	m_Running(false),
+	m_InProgress(false),
+	m_pScenarioName(NULL),
+	m_pProfileName(NULL),
+	m_RampUp(0),
+	m_Timeout(0),
+	m_pAgents(NULL),
+	m_AgentCount(0)
+{
+}
+
+UmcCoordinator::~UmcCoordinator()
+{
+	Stop();
+}
+
+bool UmcCoordinator::Run(const char* pAgents, const char* pScenarioName, const char* pProfileName,
+		double cps, apr_size_t concurrency, apr_size_t total, apr_size_t rampUp)
+{
+	if(m_InProgress)
+	{
+		printf("Distributed Load [%s] Is in Progress\n",m_pScenarioName);
+		return false;
+	}
+	/* clean up the previous load */
+	Stop();
+
+	m_pPool = apt_pool_create();
+	m_pScenarioName = apr_pstrdup(m_pPool,pScenarioName);
+	m_pProfileName = apr_pstrdup(m_pPool,pProfileName);
+	m_RampUp = rampUp;
+
+	const char* addresses[UMC_COORDINATOR_MAX_AGENTS];
+	int count = 0;
+	char* pLast;
+	char* pAddress = apr_strtok(apr_pstrdup(m_pPool,pAgents),",",&pLast);
+	for(; pAddress && count < UMC_COORDINATOR_MAX_AGENTS; pAddress = apr_strtok(NULL,",",&pLast))
+		addresses[count++] = pAddress;
+	/* every agent launches at least one session */
+	if((apr_size_t)count > total)
+		count = (int)total;
+	if(!count)
+	{
+		apr_pool_destroy(m_pPool);
+		m_pPool = NULL;
+		return false;
+	}
+
+	/* split the load evenly, the remainder goes to the first agents */
+	m_pAgents = new Agent[count];
+	m_AgentCount = count;
+	for(int i = 0; i < count; i++)
+	{
+		Agent* pAgent = &m_pAgents[i];
+		pAgent->m_pAddress = addresses[i];
+		pAgent->m_pSocket = NULL;
+		pAgent->m_Cps = cps / count;
+		pAgent->m_Total = total / count + ((apr_size_t)i < total % count ? 1 : 0);
+		pAgent->m_Concurrency = 0;
+		if(concurrency)
+		{
+			pAgent->m_Concurrency = concurrency / count + ((apr_size_t)i < concurrency % count ? 1 : 0);
+			if(!pAgent->m_Concurrency)
+				pAgent->m_Concurrency = 1;
+		}
+		pAgent->m_Status = false;
+		pAgent->m_Started = 0;
+		pAgent->m_Completed = 0;
+		pAgent->m_Failed = 0;
+		pAgent->m_Elapsed = 0;
+	}
+
+	/* the launches take total / cps after the ramp-up of half the rate on average */
+	m_Timeout = apr_time_from_sec((apr_time_t)((double)total / cps + (double)rampUp / 2) + UMC_COORDINATOR_GRACE_TIME);
+
+	m_Running = true;
+	m_InProgress = true;
+	if(apr_thread_create(&m_pThread,NULL,UmcCoordinatorThreadProc,this,m_pPool) != APR_SUCCESS)
+	{
+		m_Running = false;
+		m_InProgress = false;
+		m_pThread = NULL;
+		return false;
+	}
+	printf("Start Distributed Load [%s] profile [%s] agents [%d] cps [%.1f] concurrency [%" APR_SIZE_T_FMT "] total [%" APR_SIZE_T_FMT "] ramp-up [%" APR_SIZE_T_FMT " sec]\n",
+		m_pScenarioName,m_pProfileName,m_AgentCount,cps,concurrency,total,rampUp);
+	return true;
+}
+
+void UmcCoordinator::Stop()
+{
+	if(m_pThread)
+	{
+		apr_status_t rv;
+		m_Running = false;
+		apr_thread_join(&rv,m_pThread);
+		m_pThread = NULL;
+	}
+	if(m_pAgents)
+	{
+		delete [] m_pAgents;
+		m_pAgents = NULL;
+		m_AgentCount = 0;
+	}
+	if(m_pPool)
+	{
+		apr_pool_destroy(m_pPool);
+		m_pPool = NULL;
+	}
+}
+
+bool UmcCoordinator::Connect(Agent* pAgent)
+{
+	char* pHost = NULL;
+	char* pScope = NULL;
+	apr_port_t port = 0;
+	apr_sockaddr_t* pSockAddr = NULL;
+	if(apr_parse_addr_port(&pHost,&pScope,&port,pAgent->m_pAddress,m_pPool) != APR_SUCCESS || !pHost || !port)
+	{
+		printf("Invalid Agent Address [%s], host:port is expected\n",pAgent->m_pAddress);
+		return false;
+	}
+	if(apr_sockaddr_info_get(&pSockAddr,pHost,APR_UNSPEC,port,0,m_pPool) != APR_SUCCESS ||
+		apr_socket_create(&pAgent->m_pSocket,pSockAddr->family,SOCK_STREAM,APR_PROTO_TCP,m_pPool) != APR_SUCCESS)
+	{
+		printf("Failed to Resolve Agent [%s]\n",pAgent->m_pAddress);
+		return false;
+	}
+
+	apr_socket_timeout_set(pAgent->m_pSocket,10 * APR_USEC_PER_SEC);
+	if(apr_socket_connect(pAgent->m_pSocket,pSockAddr) != APR_SUCCESS)
+	{
+		printf("Failed to Connect Agent [%s]\n",pAgent->m_pAddress);
+		apr_socket_close(pAgent->m_pSocket);
+		pAgent->m_pSocket = NULL;
+		return false;
+	}
+
+	const char* pCommand = apr_psprintf(m_pPool,"LOAD %s %s %f %" APR_SIZE_T_FMT " %" APR_SIZE_T_FMT " %" APR_SIZE_T_FMT "\n",
+		m_pScenarioName,
+		m_pProfileName,
+		pAgent->m_Cps,
+		pAgent->m_Concurrency,
+		pAgent->m_Total,
+		m_RampUp);
+	apr_size_t length = strlen(pCommand);
+	if(apr_socket_send(pAgent->m_pSocket,pCommand,&length) != APR_SUCCESS || length != strlen(pCommand))
+	{
+		printf("Failed to Send Load to Agent [%s]\n",pAgent->m_pAddress);
+		apr_socket_close(pAgent->m_pSocket);
+		pAgent->m_pSocket = NULL;
+		return false;
+	}
+	return true;
+}
+
+bool UmcCoordinator::Receive(Agent* pAgent, apr_time_t deadline)
+{
+	char* pLine = (char*) apr_palloc(m_pPool,UMC_COORDINATOR_MAX_LINE);
+	apr_size_t length = 0;
+	char* pEnd = NULL;
+
+	apr_socket_timeout_set(pAgent->m_pSocket,UMC_COORDINATOR_POLL_INTERVAL);
+	while(m_Running && length < UMC_COORDINATOR_MAX_LINE - 1)
+	{
+		apr_size_t size = UMC_COORDINATOR_MAX_LINE - 1 - length;
+		apr_status_t rv = apr_socket_recv(pAgent->m_pSocket,pLine + length,&size);
+		length += size;
+		pLine[length] = '\0';
+		pEnd = strchr(pLine,'\n');
+		if(pEnd)
+			break;
+		if(APR_STATUS_IS_TIMEUP(rv) || APR_STATUS_IS_EAGAIN(rv))
+		{
+			if(apr_time_now() > deadline)
+			{
+				printf("Timed Out Waiting for Agent [%s]\n",pAgent->m_pAddress);
+				break;
+			}
+			continue;
+		}
+		if(rv != APR_SUCCESS)
+			break;
+	}
+	apr_socket_close(pAgent->m_pSocket);
+	pAgent->m_pSocket = NULL;
+	if(!pEnd)
+		return false;
+
+	/* RESULT status started completed failed elapsed histogram */
+	char* pPos = pLine;
+	if(strncasecmp(pPos,"RESULT ",7) != 0)
+		return false;
+	pPos += 7;
+	pAgent->m_Status = strtol(pPos,&pPos,10) ? true : false;
+	if(!pAgent->m_Status)
+	{
+		printf("Agent [%s] Rejected Load\n",pAgent->m_pAddress);
+		return false;
+	}
+	pAgent->m_Started = (apr_size_t) strtoul(pPos,&pPos,10);
+	pAgent->m_Completed = (apr_size_t) strtoul(pPos,&pPos,10);
+	pAgent->m_Failed = (apr_size_t) strtoul(pPos,&pPos,10);
+	pAgent->m_Elapsed = (apr_time_t) apr_strtoi64(pPos,&pPos,10);
+	if(!pAgent->m_Durations.Decode(pPos))
+	{
+		printf("Malformed Result of Agent [%s]\n",pAgent->m_pAddress);
+		pAgent->m_Status = false;
+		return false;
+	}
+	return true;
+}
+
+void UmcCoordinator::Process()
+{
+	int i;
+	for(i = 0; i < m_AgentCount && m_Running; i++)
+		Connect(&m_pAgents[i]);
+
+	apr_time_t deadline = apr_time_now() + m_Timeout;
+	for(i = 0; i < m_AgentCount; i++)
+	{
+		if(m_pAgents[i].m_pSocket)
+			Receive(&m_pAgents[i],deadline);
+	}
+
+	Report();
+	m_InProgress = false;
+}
+
+void UmcCoordinator::Report()
+{
+	UmcHistogram durations;
+	apr_size_t started = 0;
+	apr_size_t completed = 0;
+	apr_size_t failed = 0;
+	apr_time_t elapsed = 0;
+	int reported = 0;
+	for(int i = 0; i < m_AgentCount; i++)
+	{
+		const Agent* pAgent = &m_pAgents[i];
+		if(!pAgent->m_Status)
+		{
+			printf("Agent [%s]: no result\n",pAgent->m_pAddress);
+			continue;
+		}
+		printf("Agent [%s]: started %" APR_SIZE_T_FMT " completed %" APR_SIZE_T_FMT " failed %" APR_SIZE_T_FMT " duration p50 %u p99 %u msec\n",
+			pAgent->m_pAddress,
+			pAgent->m_Started,
+			pAgent->m_Completed,
+			pAgent->m_Failed,
+			pAgent->m_Durations.GetPercentile(50) / 1000,
+			pAgent->m_Durations.GetPercentile(99) / 1000);
+
+		durations.Merge(pAgent->m_Durations);
+		started += pAgent->m_Started;
+		completed += pAgent->m_Completed;
+		failed += pAgent->m_Failed;
+		if(pAgent->m_Elapsed > elapsed)
+			elapsed = pAgent->m_Elapsed;
+		reported++;
+	}
+
+	double seconds = (double)elapsed / APR_USEC_PER_SEC;
+	printf("Distributed Load [%s] agents %d/%d %" APR_TIME_T_FMT " sec: started %" APR_SIZE_T_FMT " completed %" APR_SIZE_T_FMT " failed %" APR_SIZE_T_FMT
+		" rate %.1f/sec duration p50 %u p90 %u p99 %u max %u msec [Complete]\n",
+		m_pScenarioName,
+		reported,
+		m_AgentCount,
+		apr_time_sec(elapsed),
+		started,
+		completed,
+		failed,
+		seconds > 0 ? completed / seconds : 0,
+		durations.GetPercentile(50) / 1000,
+		durations.GetPercentile(90) / 1000,
+		durations.GetPercentile(99) / 1000,
+		durations.GetMax() / 1000);
+}
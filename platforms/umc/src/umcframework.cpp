@@ -17,6 +17,9 @@
  */
 
 #include "umcframework.h"
+#include "umcload.h"
+#include "umcagent.h"
+#include "umccoordinator.h"
 #include "synthscenario.h"
 #include "recogscenario.h"
 #include "recorderscenario.h"
@@ -33,8 +36,13 @@ typedef struct
 	char                      m_ProfileName[128];
 	const mrcp_app_message_t* m_pAppMessage;
 	UmcSession*               m_pSession;
+	UmcLoad*                  m_pLoad;
+	UmcReportFormat           m_Format;
 } UmcTaskMsg;
 
+/** Interval to launch sessions of load at (msec) */
+#define UMC_LOAD_TIMER_INTERVAL 10
+
 enum UmcTaskMsgType
 {
 	UMC_TASK_CLIENT_MSG,
@@ -43,13 +51,17 @@ enum UmcTaskMsgType
 	UMC_TASK_KILL_SESSION_MSG,
 	UMC_TASK_SHOW_SCENARIOS_MSG,
 	UMC_TASK_SHOW_SESSIONS_MSG,
-	UMC_TASK_EXIT_SESSION_MSG
+	UMC_TASK_SHOW_TIMINGS_MSG,
+	UMC_TASK_EXIT_SESSION_MSG,
+	UMC_TASK_RUN_LOAD_MSG,
+	UMC_TASK_STOP_LOAD_MSG
 };
 
 apt_bool_t UmcProcessMsg(apt_task_t* pTask, apt_task_msg_t* pMsg);
 void UmcOnStartComplete(apt_task_t* pTask);
 void UmcOnTerminateComplete(apt_task_t* pTask);
 apt_bool_t AppMessageHandler(const mrcp_app_message_t* pAppMessage);
+void UmcOnLoadTimer(apt_timer_t* pTimer, void* pObj);
 
 
 UmcFramework::UmcFramework() :
@@ -59,7 +71,12 @@ UmcFramework::UmcFramework() :
 	m_pMrcpClient(NULL),
 	m_pMrcpApplication(NULL),
 	m_pScenarioTable(NULL),
-	m_pSessionTable(NULL)
+	m_pSessionTable(NULL),
+	m_pLoadTimer(NULL),
+	m_pLoad(NULL),
+	m_pLoadSessionTable(NULL),
+	m_pAgent(NULL),
+	m_pCoordinator(NULL)
 {
 }
 
@@ -74,15 +91,35 @@ bool UmcFramework::Create(apt_dir_layout_t* pDirLayout, apr_pool_t* pool)
 
 	m_pSessionTable = apr_hash_make(m_pPool);
 	m_pScenarioTable = apr_hash_make(m_pPool);
+	m_pLoadSessionTable = apr_hash_make(m_pPool);
+	m_pCoordinator = new UmcCoordinator;
 	return CreateTask();
 }
 
 void UmcFramework::Destroy()
 {
+	/* no more loads are posted by the agent to the task */
+	if(m_pAgent)
+		m_pAgent->Stop();
+	m_pCoordinator->Stop();
+
 	DestroyTask();
 
+	if(m_pLoad)
+	{
+		delete m_pLoad;
+		m_pLoad = NULL;
+	}
+	if(m_pAgent)
+	{
+		delete m_pAgent;
+		m_pAgent = NULL;
+	}
+	delete m_pCoordinator;
+	m_pCoordinator = NULL;
 	m_pScenarioTable = NULL;
 	m_pSessionTable = NULL;
+	m_pLoadSessionTable = NULL;
 }
 
 bool UmcFramework::CreateMrcpClient()
@@ -148,6 +185,9 @@ bool UmcFramework::CreateTask()
 		pVtable->on_terminate_complete = UmcOnTerminateComplete;
 	}
 
+	/* timers must be created before the task is started */
+	m_pLoadTimer = apt_consumer_task_timer_create(m_pTask,UmcOnLoadTimer,this,m_pPool);
+
 	apt_task_start(pTask);
 	return true;
 }
@@ -324,30 +364,110 @@ bool UmcFramework::RemoveSession(UmcSession* pSession)
 	return true;
 }
 
+UmcSession* UmcFramework::LaunchSession(UmcScenario* pScenario, const char* pProfileName)
+{
+	UmcSession* pSession = pScenario->CreateSession();
+	if(!pSession)
+		return NULL;
+
+	pSession->SetMrcpProfile(pProfileName);
+	pSession->SetMrcpApplication(m_pMrcpApplication);
+	pSession->SetMethodProvider(this);
+	if(!pSession->Run())
+	{
+		delete pSession;
+		return NULL;
+	}
+
+	AddSession(pSession);
+	return pSession;
+}
+
 bool UmcFramework::ProcessRunRequest(const char* pScenarioName, const char* pProfileName)
 {
 	UmcScenario* pScenario = (UmcScenario*) apr_hash_get(m_pScenarioTable,pScenarioName,APR_HASH_KEY_STRING);
 	if(!pScenario)
 		return false;
 
-	UmcSession* pSession = pScenario->CreateSession();
+	UmcSession* pSession = LaunchSession(pScenario,pProfileName);
 	if(!pSession)
 		return false;
 
 	printf("[%s]\n",pSession->GetId());
-	pSession->SetMrcpProfile(pProfileName);
-	pSession->SetMrcpApplication(m_pMrcpApplication);
-	pSession->SetMethodProvider(this);
-	if(!pSession->Run())
+	return true;
+}
+
+bool UmcFramework::ProcessRunLoadRequest(UmcLoad* pLoad)
+{
+	if(m_pLoad)
 	{
-		delete pSession;
+		printf("Load [%s] Is in Progress\n",m_pLoad->GetScenarioName());
+		CompleteLoad(pLoad,false);
+		return false;
+	}
+	if(!apr_hash_get(m_pScenarioTable,pLoad->GetScenarioName(),APR_HASH_KEY_STRING))
+	{
+		printf("No Such Scenario [%s]\n",pLoad->GetScenarioName());
+		CompleteLoad(pLoad,false);
 		return false;
 	}
 
-	AddSession(pSession);
+	/* timings are reported per load */
+	UmcScenario* pScenario = (UmcScenario*) apr_hash_get(m_pScenarioTable,pLoad->GetScenarioName(),APR_HASH_KEY_STRING);
+	pScenario->ResetTimings();
+
+	m_pLoad = pLoad;
+	m_pLoad->Start(apr_time_now());
+	ProcessLoadTimer();
 	return true;
 }
 
+void UmcFramework::ProcessStopLoadRequest()
+{
+	if(m_pLoad)
+		m_pLoad->Stop();
+}
+
+void UmcFramework::CompleteLoad(UmcLoad* pLoad, bool status)
+{
+	if(pLoad->GetListener())
+		pLoad->GetListener()->OnLoadComplete(pLoad,status);
+	delete pLoad;
+}
+
+void UmcFramework::ProcessLoadTimer()
+{
+	if(!m_pLoad)
+		return;
+
+	apr_time_t now = apr_time_now();
+	UmcScenario* pScenario = (UmcScenario*) apr_hash_get(m_pScenarioTable,m_pLoad->GetScenarioName(),APR_HASH_KEY_STRING);
+	apr_size_t count = pScenario ? m_pLoad->GetDueCount(now) : 0;
+	for(; count; count--)
+	{
+		UmcSession* pSession = LaunchSession(pScenario,m_pLoad->GetProfileName());
+		if(pSession)
+			apr_hash_set(m_pLoadSessionTable,pSession,sizeof(pSession),pSession);
+		m_pLoad->OnSessionStart(pSession != NULL);
+	}
+	if(!pScenario)
+		m_pLoad->Stop();
+
+	if(m_pLoad->IsComplete())
+	{
+		m_pLoad->Report(now);
+		if(pScenario)
+			pScenario->ReportTimings(UMC_REPORT_FORMAT_TEXT,true);
+		CompleteLoad(m_pLoad,pScenario != NULL);
+		m_pLoad = NULL;
+		return;
+	}
+
+	if(m_pLoad->IsReportDue(now))
+		m_pLoad->Report(now);
+	apt_timer_set(m_pLoadTimer,UMC_LOAD_TIMER_INTERVAL);
+}
+
 void UmcFramework::ProcessStopRequest(const char* id)
 {
 	UmcSession* pSession;
@@ -418,11 +538,41 @@ void UmcFramework::ProcessShowSessions()
 	}
 }
 
+void UmcFramework::ProcessShowTimings(UmcReportFormat format)
+{
+	UmcScenario* pScenario;
+	void* pVal;
+	bool header = true;
+	apr_hash_index_t* it = apr_hash_first(m_pPool,m_pScenarioTable);
+	for(; it; it = apr_hash_next(it))
+	{
+		apr_hash_this(it,NULL,NULL,&pVal);
+		pScenario = (UmcScenario*) pVal;
+		if(pScenario)
+		{
+			pScenario->ReportTimings(format,header);
+			header = false;
+		}
+	}
+}
+
 void UmcFramework::ProcessSessionExit(UmcSession* pUmcSession)
 {
 	if(!pUmcSession)
 		return;
 
+	/* sessions refer to scenarios as const, look the scenario up to aggregate timings */
+	UmcScenario* pScenario = (UmcScenario*) apr_hash_get(m_pScenarioTable,pUmcSession->GetScenario()->GetName(),APR_HASH_KEY_STRING);
+	if(pScenario)
+		pScenario->RecordTimings(pUmcSession);
+
+	if(apr_hash_get(m_pLoadSessionTable,pUmcSession,sizeof(pUmcSession)))
+	{
+		apr_hash_set(m_pLoadSessionTable,pUmcSession,sizeof(pUmcSession),NULL);
+		if(m_pLoad)
+			m_pLoad->OnSessionExit(apr_time_now() - pUmcSession->GetStartTime());
+	}
+
 	RemoveSession(pUmcSession);
 	delete pUmcSession;
 }
@@ -475,6 +625,65 @@ void UmcFramework::KillSession(const char* id)
 	apt_task_msg_signal(pTask,pTaskMsg);
 }
 
+void UmcFramework::RunLoad(const char* pScenarioName, const char* pProfileName,
+		double cps, apr_size_t concurrency, apr_size_t total, apr_size_t rampUp)
+{
+	RunLoad(new UmcLoad(pScenarioName,pProfileName,cps,concurrency,total,rampUp));
+}
+
+void UmcFramework::RunLoad(UmcLoad* pLoad)
+{
+	apt_task_t* pTask = apt_consumer_task_base_get(m_pTask);
+	apt_task_msg_t* pTaskMsg = apt_task_msg_get(pTask);
+	if(!pTaskMsg) 
+	{
+		CompleteLoad(pLoad,false);
+		return;
+	}
+
+	pTaskMsg->type = TASK_MSG_USER;
+	pTaskMsg->sub_type = UMC_TASK_RUN_LOAD_MSG;
+	
+	UmcTaskMsg* pUmcMsg = (UmcTaskMsg*) pTaskMsg->data;
+	pUmcMsg->m_pLoad = pLoad;
+	pUmcMsg->m_pAppMessage = NULL;
+	apt_task_msg_signal(pTask,pTaskMsg);
+}
+
+bool UmcFramework::StartAgent(apr_port_t port)
+{
+	if(m_pAgent)
+		return false;
+
+	m_pAgent = new UmcAgent(this);
+	if(!m_pAgent->Start(port))
+	{
+		delete m_pAgent;
+		m_pAgent = NULL;
+		return false;
+	}
+	return true;
+}
+
+void UmcFramework::RunDistributedLoad(const char* pAgents, const char* pScenarioName, const char* pProfileName,
+		double cps, apr_size_t concurrency, apr_size_t total, apr_size_t rampUp)
+{
+	/* the coordinator runs in the background, the load is not run locally */
+	m_pCoordinator->Run(pAgents,pScenarioName,pProfileName,cps,concurrency,total,rampUp);
+}
+
+void UmcFramework::StopLoad()
+{
+	apt_task_t* pTask = apt_consumer_task_base_get(m_pTask);
+	apt_task_msg_t* pTaskMsg = apt_task_msg_get(pTask);
+	if(!pTaskMsg) 
+		return;
+
+	pTaskMsg->type = TASK_MSG_USER;
+	pTaskMsg->sub_type = UMC_TASK_STOP_LOAD_MSG;
+	apt_task_msg_signal(pTask,pTaskMsg);
+}
+
 void UmcFramework::ShowScenarios()
 {
 	apt_task_t* pTask = apt_consumer_task_base_get(m_pTask);
@@ -499,6 +708,20 @@ void UmcFramework::ShowSessions()
 	apt_task_msg_signal(pTask,pTaskMsg);
 }
 
+void UmcFramework::ShowTimings(UmcReportFormat format)
+{
+	apt_task_t* pTask = apt_consumer_task_base_get(m_pTask);
+	apt_task_msg_t* pTaskMsg = apt_task_msg_get(pTask);
+	if(!pTaskMsg) 
+		return;
+
+	pTaskMsg->type = TASK_MSG_USER;
+	pTaskMsg->sub_type = UMC_TASK_SHOW_TIMINGS_MSG;
+	UmcTaskMsg* pUmcMsg = (UmcTaskMsg*) pTaskMsg->data;
+	pUmcMsg->m_Format = format;
+	apt_task_msg_signal(pTask,pTaskMsg);
+}
+
 void UmcFramework::ExitSession(UmcSession* pUmcSession)
 {
 	apt_task_t* pTask = apt_consumer_task_base_get(m_pTask);
@@ -577,6 +800,12 @@ apt_bool_t AppOnResourceDiscover(mrcp_application_t* pApplication, mrcp_session_
 	return pEventHandler->OnResourceDiscover(pDescriptor,status);
 }
 
+void UmcOnLoadTimer(apt_timer_t* pTimer, void* pObj)
+{
+	UmcFramework* pFramework = (UmcFramework*) pObj;
+	pFramework->ProcessLoadTimer();
+}
+
 void UmcOnStartComplete(apt_task_t* pTask)
 {
 	apt_consumer_task_t* pConsumerTask = (apt_consumer_task_t*) apt_task_object_get(pTask);
@@ -646,11 +875,26 @@ apt_bool_t UmcProcessMsg(apt_task_t *pTask, apt_task_msg_t *pMsg)
 			pFramework->ProcessShowSessions();
 			break;
 		}
+		case UMC_TASK_SHOW_TIMINGS_MSG:
+		{
+			pFramework->ProcessShowTimings(pUmcMsg->m_Format);
+			break;
+		}
 		case UMC_TASK_EXIT_SESSION_MSG:
 		{
 			pFramework->ProcessSessionExit(pUmcMsg->m_pSession);
 			break;
 		}
+		case UMC_TASK_RUN_LOAD_MSG:
+		{
+			pFramework->ProcessRunLoadRequest(pUmcMsg->m_pLoad);
+			break;
+		}
+		case UMC_TASK_STOP_LOAD_MSG:
+		{
+			pFramework->ProcessStopLoadRequest();
+			break;
+		}
 	}
 	return TRUE;
 }
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <apr_strings.h>
+#include "umchistogram.h"
+
+UmcHistogram::UmcHistogram()
+{
+	Reset();
+}
+
+void UmcHistogram::Reset()
+{
+	memset(m_Counts,0,sizeof(m_Counts));
+	m_Count = 0;
+	m_Min = 0;
+	m_Max = 0;
+	m_Sum = 0;
+}
+
+apr_size_t UmcHistogram::GetIndex(apr_uint32_t value)
+{
+	/* values below 2 * sub-buckets are exact */
+	if(value < 2 * UMC_HISTOGRAM_SUB_BUCKETS)
+		return value;
+
+	/* shift the value to [sub-buckets, 2 * sub-buckets) */
+	apr_size_t shift = 0;
+	while((value >> shift) >= 2 * UMC_HISTOGRAM_SUB_BUCKETS)
+		shift++;
+	return shift * UMC_HISTOGRAM_SUB_BUCKETS + (value >> shift);
+}
+
+apr_uint32_t UmcHistogram::GetValue(apr_size_t index)
+{
+	if(index < 2 * UMC_HISTOGRAM_SUB_BUCKETS)
+		return (apr_uint32_t)index;
+
+	/* the highest value equivalent to the bucket */
+	apr_size_t shift = index / UMC_HISTOGRAM_SUB_BUCKETS - 1;
+	apr_uint64_t value = index % UMC_HISTOGRAM_SUB_BUCKETS + UMC_HISTOGRAM_SUB_BUCKETS;
+	value = ((value + 1) << shift) - 1;
+	return value > 0xFFFFFFFF ? 0xFFFFFFFF : (apr_uint32_t)value;
+}
+
+void UmcHistogram::Record(apr_interval_time_t value)
+{
+	if(value < 0)
+		return;
+
+	apr_uint32_t v = value > 0xFFFFFFFF ? 0xFFFFFFFF : (apr_uint32_t)value;
+	m_Counts[GetIndex(v)]++;
+	if(!m_Count || v < m_Min)
+		m_Min = v;
+	if(v > m_Max)
+		m_Max = v;
+	m_Sum += v;
+	m_Count++;
+}
+
+void UmcHistogram::Merge(const UmcHistogram& other)
+{
+	if(!other.m_Count)
+		return;
+
+	for(apr_size_t i = 0; i < UMC_HISTOGRAM_BUCKET_COUNT; i++)
+		m_Counts[i] += other.m_Counts[i];
+	if(!m_Count || other.m_Min < m_Min)
+		m_Min = other.m_Min;
+	if(other.m_Max > m_Max)
+		m_Max = other.m_Max;
+	m_Sum += other.m_Sum;
+	m_Count += other.m_Count;
+}
+
+const char* UmcHistogram::Encode(apr_pool_t* pool) const
+{
+	/* up to 2 x 10 digits, colon and space per bucket */
+	apr_size_t size = 64 + 22 * UMC_HISTOGRAM_BUCKET_COUNT;
+	char* pText = (char*) apr_palloc(pool,size);
+	char* pPos = pText;
+	char* pEnd = pText + size;
+	pPos += apr_snprintf(pPos,pEnd - pPos,"%u %u %u %" APR_UINT64_T_FMT,
+		m_Count,GetMin(),m_Max,m_Sum);
+	for(apr_size_t i = 0; i < UMC_HISTOGRAM_BUCKET_COUNT; i++)
+	{
+		if(m_Counts[i])
+			pPos += apr_snprintf(pPos,pEnd - pPos," %" APR_SIZE_T_FMT ":%u",i,m_Counts[i]);
+	}
+	return pText;
+}
+
+bool UmcHistogram::Decode(const char* pText)
+{
+	char* pEnd;
+	apr_uint32_t count = 0;
+	Reset();
+
+	m_Count = (apr_uint32_t) strtoul(pText,&pEnd,10);
+	m_Min = (apr_uint32_t) strtoul(pEnd,&pEnd,10);
+	m_Max = (apr_uint32_t) strtoul(pEnd,&pEnd,10);
+	m_Sum = (apr_uint64_t) apr_strtoi64(pEnd,&pEnd,10);
+	while(*pEnd == ' ')
+	{
+		unsigned long index = strtoul(pEnd,&pEnd,10);
+		if(*pEnd != ':' || index >= UMC_HISTOGRAM_BUCKET_COUNT)
+			break;
+		m_Counts[index] = (apr_uint32_t) strtoul(pEnd + 1,&pEnd,10);
+		count += m_Counts[index];
+	}
+
+	if(count != m_Count || (*pEnd != '\0' && *pEnd != '\r' && *pEnd != '\n'))
+	{
+		Reset();
+		return false;
+	}
+	return true;
+}
+
+apr_uint32_t UmcHistogram::GetPercentile(double percent) const
+{
+	if(!m_Count)
+		return 0;
+
+	apr_uint64_t target = (apr_uint64_t)(percent * m_Count / 100 + 0.999999);
+	if(target < 1)
+		target = 1;
+
+	apr_uint64_t count = 0;
+	for(apr_size_t i = 0; i < UMC_HISTOGRAM_BUCKET_COUNT; i++)
+	{
+		count += m_Counts[i];
+		if(count >= target)
+		{
+			apr_uint32_t value = GetValue(i);
+			return value < m_Max ? value : m_Max;
+		}
+	}
+	return m_Max;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdio.h>
+#include <apr_strings.h>
+#include "umcload.h"
+#include "apt_pool.h"
+
+UmcLoad::UmcLoad(const char* pScenarioName, const char* pProfileName,
+		double cps, apr_size_t concurrency, apr_size_t total, apr_size_t rampUp) :
+	m_Cps(cps),
+	m_Concurrency(concurrency),
+	m_Total(total),
+	m_RampUp(rampUp),
+	m_StartTime(0),
+	m_ReportTime(0),
+	m_ReportCompleted(0),
+	m_Started(0),
+	m_Failed(0),
+	m_Completed(0),
+	m_pListener(NULL)
+{
+	m_pPool = apt_pool_create();
+	m_pScenarioName = apr_pstrdup(m_pPool,pScenarioName);
+	m_pProfileName = apr_pstrdup(m_pPool,pProfileName);
+}
+
+UmcLoad::~UmcLoad()
+{
+	apr_pool_destroy(m_pPool);
+}
+
+void UmcLoad::Start(apr_time_t now)
+{
+	m_StartTime = now;
+	m_ReportTime = now;
+	printf("Start Load [%s] profile [%s] cps [%.1f] concurrency [%" APR_SIZE_T_FMT "] total [%" APR_SIZE_T_FMT "] ramp-up [%" APR_SIZE_T_FMT " sec]\n",
+		m_pScenarioName,m_pProfileName,m_Cps,m_Concurrency,m_Total,m_RampUp);
+}
+
+void UmcLoad::Stop()
+{
+	/* no more launches, the sessions in progress are waited for */
+	m_Total = m_Started;
+}
+
+apr_size_t UmcLoad::GetDueCount(apr_time_t now) const
+{
+	if(m_Started >= m_Total)
+		return 0;
+
+	/* the number of launches expected by now, the rate grows linearly during ramp-up */
+	double elapsed = (double)(now - m_StartTime) / APR_USEC_PER_SEC;
+	double expected;
+	if(elapsed < m_RampUp)
+		expected = m_Cps * elapsed * elapsed / (2 * m_RampUp);
+	else
+		expected = m_Cps * (elapsed - (double)m_RampUp / 2);
+
+	/* the first session is launched at once */
+	apr_size_t target = (apr_size_t)expected + 1;
+	if(target > m_Total)
+		target = m_Total;
+	if(target <= m_Started)
+		return 0;
+
+	apr_size_t due = target - m_Started;
+	if(m_Concurrency)
+	{
+		apr_size_t active = m_Started - m_Failed - m_Completed;
+		if(active >= m_Concurrency)
+			return 0;
+		if(due > m_Concurrency - active)
+			due = m_Concurrency - active;
+	}
+	return due;
+}
+
+void UmcLoad::OnSessionStart(bool status)
+{
+	m_Started++;
+	if(!status)
+		m_Failed++;
+}
+
+void UmcLoad::OnSessionExit(apr_interval_time_t duration)
+{
+	m_Completed++;
+	m_Durations.Record(duration);
+}
+
+void UmcLoad::Report(apr_time_t now)
+{
+	double interval = (double)(now - m_ReportTime) / APR_USEC_PER_SEC;
+	double rate = interval > 0 ? (m_Completed - m_ReportCompleted) / interval : 0;
+
+	printf("Load [%s] %" APR_TIME_T_FMT " sec: started %" APR_SIZE_T_FMT " active %" APR_SIZE_T_FMT " completed %" APR_SIZE_T_FMT " failed %" APR_SIZE_T_FMT
+		" rate %.1f/sec duration p50 %u p90 %u p99 %u max %u msec%s\n",
+		m_pScenarioName,
+		apr_time_sec(now - m_StartTime),
+		m_Started,
+		m_Started - m_Failed - m_Completed,
+		m_Completed,
+		m_Failed,
+		rate,
+		m_Durations.GetPercentile(50) / 1000,
+		m_Durations.GetPercentile(90) / 1000,
+		m_Durations.GetPercentile(99) / 1000,
+		m_Durations.GetMax() / 1000,
+		IsComplete() ? " [Complete]" : "");
+
+	m_ReportTime = now;
+	m_ReportCompleted = m_Completed;
+}
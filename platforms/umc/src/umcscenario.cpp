@@ -17,6 +17,7 @@
  */
 
 #include <stdlib.h>
+#include <stdio.h>
 #include "umcscenario.h"
 #include "apt_log.h"
 
@@ -50,6 +51,92 @@ void UmcScenario::Destroy()
 {
 }
 
+const char* UmcScenario::GetTimingName(UmcTiming id)
+{
+	static const char* names[UMC_TIMING_COUNT] =
+	{
+		"setup",
+		"first-response",
+		"start-of-input",
+		"recognition-complete",
+		"speak-complete",
+		"first-rtp"
+	};
+	return names[id];
+}
+
+void UmcScenario::RecordTimings(const UmcSession* pSession)
+{
+	for(int i = 0; i < UMC_TIMING_COUNT; i++)
+		m_Timings[i].Record(pSession->GetTiming((UmcTiming)i));
+}
+
+void UmcScenario::ResetTimings()
+{
+	for(int i = 0; i < UMC_TIMING_COUNT; i++)
+		m_Timings[i].Reset();
+}
+
+void UmcScenario::ReportTimings(UmcReportFormat format, bool header) const
+{
+	if(header)
+	{
+		if(format == UMC_REPORT_FORMAT_TEXT)
+			printf("%-10s %-20s %8s %10s %10s %10s %10s %10s %10s %10s (msec)\n",
+				"scenario","timing","count","min","mean","p50","p90","p99","p99.9","max");
+		else if(format == UMC_REPORT_FORMAT_CSV)
+			printf("scenario,timing,count,min,mean,p50,p90,p99,p999,max\n");
+	}
+
+	for(int i = 0; i < UMC_TIMING_COUNT; i++)
+	{
+		const UmcHistogram& timing = m_Timings[i];
+		/* not applicable to the scenario */
+		if(!timing.GetCount())
+			continue;
+
+		const char* name = GetTimingName((UmcTiming)i);
+		switch(format)
+		{
+			case UMC_REPORT_FORMAT_TEXT:
+				printf("%-10s %-20s %8u %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+					m_pName,name,timing.GetCount(),
+					timing.GetMin() / 1000.0,
+					timing.GetMean() / 1000.0,
+					timing.GetPercentile(50) / 1000.0,
+					timing.GetPercentile(90) / 1000.0,
+					timing.GetPercentile(99) / 1000.0,
+					timing.GetPercentile(99.9) / 1000.0,
+					timing.GetMax() / 1000.0);
+				break;
+			case UMC_REPORT_FORMAT_CSV:
+				printf("%s,%s,%u,%u,%u,%u,%u,%u,%u,%u\n",
+					m_pName,name,timing.GetCount(),
+					timing.GetMin(),
+					timing.GetMean(),
+					timing.GetPercentile(50),
+					timing.GetPercentile(90),
+					timing.GetPercentile(99),
+					timing.GetPercentile(99.9),
+					timing.GetMax());
+				break;
+			case UMC_REPORT_FORMAT_JSON:
+				/* one object per line, values in usec */
+				printf("{\"scenario\":\"%s\",\"timing\":\"%s\",\"count\":%u,\"min\":%u,\"mean\":%u,"
+					"\"p50\":%u,\"p90\":%u,\"p99\":%u,\"p999\":%u,\"max\":%u}\n",
+					m_pName,name,timing.GetCount(),
+					timing.GetMin(),
+					timing.GetMean(),
+					timing.GetPercentile(50),
+					timing.GetPercentile(90),
+					timing.GetPercentile(99),
+					timing.GetPercentile(99.9),
+					timing.GetMax());
+				break;
+		}
+	}
+}
+
 bool UmcScenario::LoadElement(const apr_xml_elem* pElem, apr_pool_t* pool)
 {
 	if(strcasecmp(pElem->name,"resource-discovery") == 0)
@@ -28,6 +28,8 @@ UmcSession::UmcSession(const UmcScenario* pScenario) :
 	m_pMrcpApplication(NULL),
 	m_pMrcpSession(NULL),
 	m_pMrcpMessage(NULL),
+	m_StartTime(0),
+	m_RequestTime(0),
 	m_Running(false),
 	m_Terminating(false)
 {
@@ -38,6 +40,10 @@ UmcSession::UmcSession(const UmcScenario* pScenario) :
 
 	m_Pool = apt_pool_create();
 	m_Id = apr_psprintf(m_Pool,"%d",id);
+
+	/* not captured */
+	for(int i = 0; i < UMC_TIMING_COUNT; i++)
+		m_Timings[i] = -1;
 }
 
 UmcSession::~UmcSession()
@@ -59,7 +65,8 @@ bool UmcSession::Run()
 	/* create session */
 	if(!CreateMrcpSession(m_pMrcpProfile))
 		return false;
-	
+
+	m_StartTime = apr_time_now();
 	m_Running = true;
 	
 	bool ret = false;
@@ -113,6 +120,8 @@ bool UmcSession::OnSessionUpdate(mrcp_sig_status_code_e status)
 
 bool UmcSession::OnChannelAdd(mrcp_channel_t* pMrcpChannel, mrcp_sig_status_code_e status)
 {
+	if(m_Running && status == MRCP_SIG_STATUS_CODE_SUCCESS)
+		MarkTiming(UMC_TIMING_SETUP);
 	return m_Running;
 }
 
@@ -133,6 +142,8 @@ bool UmcSession::OnMessageReceive(mrcp_channel_t* pMrcpChannel, mrcp_message_t*
 	if(m_pMrcpMessage->start_line.request_id != pMrcpMessage->start_line.request_id)
 		return false;
 
+	if(pMrcpMessage->start_line.message_type == MRCP_MESSAGE_TYPE_RESPONSE)
+		MarkTiming(UMC_TIMING_FIRST_RESPONSE);
 	return true;
 }
 
@@ -197,6 +208,7 @@ bool UmcSession::SendMrcpRequest(mrcp_channel_t* pMrcpChannel, mrcp_message_t* p
 		return false;
 
 	m_pMrcpMessage = pMrcpMessage;
+	m_RequestTime = apr_time_now();
 	return (mrcp_application_message_send(m_pMrcpSession,pMrcpChannel,pMrcpMessage) == TRUE);
 }
 
@@ -208,6 +220,24 @@ bool UmcSession::DiscoverResources()
 	return (mrcp_application_resource_discover(m_pMrcpSession) == TRUE);
 }
 
+void UmcSession::MarkTiming(UmcTiming id)
+{
+	SetTiming(id,apr_time_now());
+}
+
+void UmcSession::SetTiming(UmcTiming id, apr_time_t time)
+{
+	if(m_Timings[id] >= 0)
+		return;
+
+	/* setup is measured from the session start, the rest from the last request */
+	apr_time_t base = (id == UMC_TIMING_SETUP) ? m_StartTime : m_RequestTime;
+	if(!base || time < base)
+		return;
+
+	m_Timings[id] = time - base;
+}
+
 mrcp_channel_t* UmcSession::CreateMrcpChannel(
 						mrcp_resource_id resource_id, 
 						mpf_termination_t* pTermination, 
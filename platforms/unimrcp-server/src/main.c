@@ -32,13 +32,15 @@ typedef struct {
 	const char   *log_output;
 #ifdef WIN32
 	const char   *svcname;
+#else
+	const char   *worker_count;
 #endif
 } server_options_t;
 
 #ifdef WIN32
 apt_bool_t uni_service_run(const char *name, apt_dir_layout_t *dir_layout, apr_pool_t *pool);
 #else
-apt_bool_t uni_daemon_run(apt_dir_layout_t *dir_layout, apr_pool_t *pool);
+apt_bool_t uni_daemon_run(apt_dir_layout_t *dir_layout, apr_size_t worker_count, const char * const *argv, apr_pool_t *pool);
 #endif
 
 apt_bool_t uni_cmdline_run(apt_dir_layout_t *dir_layout, apr_pool_t *pool);
@@ -77,6 +79,9 @@ static void usage()
 #else
 		"   -d [--daemon]            : Run as a daemon.\n"
 		"\n"
+		"   -w [--workers] count     : Run the daemon as master of worker processes.\n"
+		"                              (each worker runs a server on a slice of ports)\n"
+		"\n"
 #endif
 		"   -v [--version]           : Show the version.\n"
 		"\n"
@@ -102,6 +107,7 @@ static apt_bool_t options_load(server_options_t *options, int argc, const char *
 		{ "name",        'n', TRUE,  "service name" },             /* -n or --name arg */
 #else
 		{ "daemon",      'd', FALSE, "start as daemon" },          /* -d or --daemon */
+		{ "workers",     'w', TRUE,  "number of worker processes" }, /* -w arg or --workers arg */
 #endif
 		{ "version",     'v', FALSE, "show version" },             /* -v or --version */
 		{ "help",        'h', FALSE, "show help" },                /* -h or --help */
@@ -121,6 +127,8 @@ static apt_bool_t options_load(server_options_t *options, int argc, const char *
 	options->log_output = NULL;
 #ifdef WIN32
 	options->svcname = NULL;
+#else
+	options->worker_count = NULL;
 #endif
 
 	while((rv = apr_getopt_long(opt, opt_option, &optch, &optarg)) == APR_SUCCESS) {
@@ -148,6 +156,9 @@ static apt_bool_t options_load(server_options_t *options, int argc, const char *
 			case 'd':
 				options->foreground = FALSE;
 				break;
+			case 'w':
+				options->worker_count = optarg;
+				break;
 #endif
 			case 'v':
 				printf(UNI_VERSION_STRING);
@@ -243,7 +254,7 @@ int main(int argc, const char * const *argv)
 #else
 	else {
 		/* run as daemon */
-		uni_daemon_run(dir_layout,pool);
+		uni_daemon_run(dir_layout,options.worker_count ? atol(options.worker_count) : 1,argv,pool);
 	}
 #endif
 
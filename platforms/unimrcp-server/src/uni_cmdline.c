@@ -21,7 +21,17 @@
 #include "unimrcp_server.h"
 #include "apt_log.h"
 
-static apt_bool_t cmdline_process(char *cmdline)
+/** Reject new sessions and wait for the sessions in progress to complete */
+static void cmdline_drain(mrcp_server_t *server)
+{
+	mrcp_server_drain(server);
+	while(mrcp_server_is_drained(server) == FALSE) {
+		apr_sleep(1000000);
+	}
+	printf("server is drained\n");
+}
+
+static apt_bool_t cmdline_process(mrcp_server_t *server, apt_dir_layout_t *dir_layout, char *cmdline)
 {
 	apt_bool_t running = TRUE;
 	char *name;
@@ -37,9 +47,19 @@ static apt_bool_t cmdline_process(char *cmdline)
 	else if(strcasecmp(name,"exit") == 0 || strcmp(name,"quit") == 0) {
 		running = FALSE;
 	}
+	else if(strcasecmp(name,"drain") == 0) {
+		cmdline_drain(server);
+		running = FALSE;
+	}
+	else if(strcasecmp(name,"reload") == 0) {
+		char *engine_id = apr_strtok(NULL, " ", &last);
+		unimrcp_server_reload(server,dir_layout,engine_id);
+	}
 	else if(strcasecmp(name,"help") == 0) {
 		printf("usage:\n");
 		printf("- loglevel [level] (set loglevel, one of 0,1...7)\n");
+		printf("- drain (reject new sessions, exit once the sessions in progress complete)\n");
+		printf("- reload [engine-id|*] (load new plugins and profiles, reload the specified plugins)\n");
 		printf("- quit, exit\n");
 	}
 	else {
@@ -72,7 +92,7 @@ apt_bool_t uni_cmdline_run(apt_dir_layout_t *dir_layout, apr_pool_t *pool)
 			}
 		}
 		if(*cmdline) {
-			running = cmdline_process(cmdline);
+			running = cmdline_process(server,dir_layout,cmdline);
 		}
 	}
 	while(running != 0);
@@ -16,37 +16,268 @@
  * $Id$
  */
 
+#include <string.h>
 #include <apr_signal.h>
 #include <apr_thread_proc.h>
+#include <apr_file_info.h>
 #include "unimrcp_server.h"
+#include "apt_listener.h"
 #include "apt_log.h"
 
+/** Max number of worker processes */
+#define MAX_WORKER_COUNT 64
+
+/** Worker process run by the master process */
+typedef struct uni_worker_t uni_worker_t;
+struct uni_worker_t {
+	/** Process of the worker */
+	apr_proc_t  proc;
+	/** Whether the process is running */
+	apt_bool_t  running;
+};
+
 static apt_bool_t daemon_running;
+static apt_bool_t daemon_draining;
+static apt_bool_t daemon_reloading;
+static apt_bool_t daemon_upgrading;
 
 static void sigterm_handler(int signo)
 {
 	daemon_running = FALSE;
 }
 
-apt_bool_t uni_daemon_run(apt_dir_layout_t *dir_layout, apr_pool_t *pool)
+#ifdef SIGUSR1
+static void sigusr1_handler(int signo)
 {
-	mrcp_server_t *server;
+	/* exit, once the sessions in progress complete */
+	daemon_draining = TRUE;
+}
+#endif
 
-	daemon_running = TRUE;
-	apr_signal(SIGTERM,sigterm_handler);
+#ifdef SIGHUP
+static void sighup_handler(int signo)
+{
+	/* load new plugins and profiles */
+	daemon_reloading = TRUE;
+}
+#endif
 
-	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run as Daemon");
-	apr_proc_detach(APR_PROC_DETACH_DAEMONIZE);
+#ifdef SIGUSR2
+static void sigusr2_handler(int signo)
+{
+	/* start the binary again, hand off the listeners to it and drain */
+	daemon_upgrading = TRUE;
+}
+#endif
+
+/** Start the binary again with the listeners handed off, the new process accepts the connections next */
+static apt_bool_t uni_daemon_upgrade(const char *program, const char * const *argv, apr_pool_t *pool)
+{
+	apr_procattr_t *attr;
+	apr_proc_t proc;
+	apr_exit_why_e why;
+	int exit_code;
+
+	if(apt_listeners_hand_off() == FALSE) {
+		return FALSE;
+	}
+	if(apr_procattr_create(&attr,pool) != APR_SUCCESS ||
+		apr_procattr_cmdtype_set(attr,strchr(program,'/') ? APR_PROGRAM_ENV : APR_PROGRAM_PATH) != APR_SUCCESS ||
+		apr_proc_create(&proc,program,argv,NULL,attr,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Start New Process [%s]",program);
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Start New Process [%s] pid [%d]",program,proc.pid);
+	/* the process exits, once it has detached as daemon */
+	apr_proc_wait(&proc,&exit_code,&why,APR_WAIT);
+	return TRUE;
+}
+
+/** Run the server till terminated */
+static apt_bool_t uni_daemon_server_run(apt_dir_layout_t *dir_layout, apr_size_t worker_index, apr_size_t worker_count, const char *program, const char * const *argv, apr_pool_t *pool)
+{
+	mrcp_server_t *server;
 
 	/* start server */
-	server = unimrcp_server_start(dir_layout);
+	server = unimrcp_server_worker_start(dir_layout,worker_index,worker_count);
 	if(!server) {
 		return FALSE;
 	}
 
-	while(daemon_running) apr_sleep(1000000);
+	while(daemon_running) {
+		apr_sleep(1000000);
+		if(daemon_reloading) {
+			daemon_reloading = FALSE;
+			unimrcp_server_reload(server,dir_layout,NULL);
+		}
+		if(daemon_upgrading) {
+			daemon_upgrading = FALSE;
+			if(worker_count > 1) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Upgrade Is Supported in Single Process Mode Only");
+			}
+			else if(uni_daemon_upgrade(program,argv,pool) == TRUE) {
+				/* the sessions in progress complete in this process */
+				daemon_draining = TRUE;
+			}
+		}
+		if(daemon_draining) {
+			mrcp_server_drain(server);
+			if(mrcp_server_is_drained(server) == TRUE) {
+				apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Server Is Drained");
+				break;
+			}
+		}
+	}
 
 	/* shutdown server */
 	unimrcp_server_shutdown(server);
 	return TRUE;
 }
+
+/** Fork worker process, return TRUE in the child process */
+static apt_bool_t uni_daemon_worker_spawn(uni_worker_t *worker, apr_size_t worker_index, apr_pool_t *pool)
+{
+	apr_status_t status = apr_proc_fork(&worker->proc,pool);
+	if(status == APR_INCHILD) {
+		return TRUE;
+	}
+	if(status != APR_INPARENT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Fork Worker Process [%"APR_SIZE_T_FMT"]",worker_index+1);
+		worker->running = FALSE;
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Spawn Worker Process [%"APR_SIZE_T_FMT"] pid [%d]",worker_index+1,worker->proc.pid);
+	worker->running = TRUE;
+	return FALSE;
+}
+
+/** Send signal to the worker processes running */
+static void uni_daemon_workers_signal(uni_worker_t *workers, apr_size_t worker_count, int signo)
+{
+	apr_size_t i;
+	for(i=0; i<worker_count; i++) {
+		if(workers[i].running == TRUE) {
+			apr_proc_kill(&workers[i].proc,signo);
+		}
+	}
+}
+
+/** Run the worker processes and restart the ones which exit unexpectedly, return TRUE in the child processes */
+static apt_bool_t uni_daemon_master_run(apt_dir_layout_t *dir_layout, apr_size_t worker_count, apr_size_t *worker_index, apr_pool_t *pool)
+{
+	uni_worker_t workers[MAX_WORKER_COUNT];
+	apr_proc_t proc;
+	apr_exit_why_e why;
+	int exit_code;
+	apr_size_t running_count;
+	apr_size_t i;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run Master Process [%"APR_SIZE_T_FMT" workers]",worker_count);
+	for(i=0; i<worker_count; i++) {
+		if(uni_daemon_worker_spawn(&workers[i],i,pool) == TRUE) {
+			*worker_index = i;
+			return TRUE;
+		}
+	}
+
+	while(daemon_running) {
+		apr_sleep(1000000);
+		while(apr_proc_wait_all_procs(&proc,&exit_code,&why,APR_NOWAIT,pool) == APR_CHILD_DONE) {
+			for(i=0; i<worker_count; i++) {
+				if(workers[i].running == TRUE && workers[i].proc.pid == proc.pid) {
+					apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Worker Process [%"APR_SIZE_T_FMT"] pid [%d] Exited [%d] %s",
+						i+1,proc.pid,exit_code,(why & APR_PROC_SIGNAL) ? "by signal" : "");
+					workers[i].running = FALSE;
+					break;
+				}
+			}
+		}
+
+		if(daemon_reloading) {
+			daemon_reloading = FALSE;
+#ifdef SIGHUP
+			uni_daemon_workers_signal(workers,worker_count,SIGHUP);
+#endif
+		}
+		if(daemon_draining) {
+			/* the workers exit, once drained, and are not restarted then */
+#ifdef SIGUSR1
+			uni_daemon_workers_signal(workers,worker_count,SIGUSR1);
+#endif
+		}
+
+		running_count = 0;
+		for(i=0; i<worker_count; i++) {
+			if(workers[i].running == FALSE && daemon_running && !daemon_draining) {
+				/* restart the worker with the same slice of ports */
+				if(uni_daemon_worker_spawn(&workers[i],i,pool) == TRUE) {
+					*worker_index = i;
+					return TRUE;
+				}
+			}
+			if(workers[i].running == TRUE) {
+				running_count++;
+			}
+		}
+		if(daemon_draining && !running_count) {
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Worker Processes Are Drained");
+			break;
+		}
+	}
+
+	/* terminate the workers and wait for them to shutdown */
+	uni_daemon_workers_signal(workers,worker_count,SIGTERM);
+	for(i=0; i<worker_count; i++) {
+		if(workers[i].running == TRUE) {
+			apr_proc_wait(&workers[i].proc,&exit_code,&why,APR_WAIT);
+			workers[i].running = FALSE;
+		}
+	}
+	return FALSE;
+}
+
+apt_bool_t uni_daemon_run(apt_dir_layout_t *dir_layout, apr_size_t worker_count, const char * const *argv, apr_pool_t *pool)
+{
+	apr_size_t worker_index = 0;
+	char *program = NULL;
+
+	daemon_running = TRUE;
+	daemon_draining = FALSE;
+	daemon_reloading = FALSE;
+	daemon_upgrading = FALSE;
+	apr_signal(SIGTERM,sigterm_handler);
+#ifdef SIGUSR1
+	apr_signal(SIGUSR1,sigusr1_handler);
+#endif
+#ifdef SIGHUP
+	apr_signal(SIGHUP,sighup_handler);
+#endif
+#ifdef SIGUSR2
+	apr_signal(SIGUSR2,sigusr2_handler);
+#endif
+
+	/* resolve the path of the binary, before the working dir is changed */
+	if(strchr(argv[0],'/') == NULL ||
+		apr_filepath_merge(&program,NULL,argv[0],APR_FILEPATH_NATIVE,pool) != APR_SUCCESS) {
+		program = apr_pstrdup(pool,argv[0]);
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run as Daemon");
+	apr_proc_detach(APR_PROC_DETACH_DAEMONIZE);
+
+	if(worker_count > MAX_WORKER_COUNT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Limit Number of Worker Processes [%d]",MAX_WORKER_COUNT);
+		worker_count = MAX_WORKER_COUNT;
+	}
+	if(worker_count > 1) {
+		if(uni_daemon_master_run(dir_layout,worker_count,&worker_index,pool) == FALSE) {
+			/* the master process is done */
+			return TRUE;
+		}
+	}
+	else {
+		worker_count = 1;
+	}
+
+	return uni_daemon_server_run(dir_layout,worker_index,worker_count,program,argv,pool);
+}
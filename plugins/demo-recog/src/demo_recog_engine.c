@@ -30,11 +30,23 @@
  */
 
 #include "mrcp_recog_engine.h"
+#include "mrcp_frame_clock.h"
 #include "mpf_activity_detector.h"
-#include "apt_consumer_task.h"
+#include "apt_executor.h"
+#include "apt_task_msg.h"
 #include "apt_log.h"
 
-#define RECOG_ENGINE_TASK_NAME "Demo Recog Engine"
+/** Default timeouts of voice activity detector (msec) */
+#define DEMO_RECOG_NOINPUT_TIMEOUT 5000
+#define DEMO_RECOG_SILENCE_TIMEOUT 300
+/** Default recognition timeout (msec) */
+#define DEMO_RECOG_RECOGNITION_TIMEOUT 10000
+
+/** Frame clock timers of demo recognizer channel */
+typedef enum {
+	DEMO_RECOG_TIMER_NOINPUT,
+	DEMO_RECOG_TIMER_RECOGNITION
+} demo_recog_timer_e;
 
 typedef struct demo_recog_engine_t demo_recog_engine_t;
 typedef struct demo_recog_channel_t demo_recog_channel_t;
@@ -59,12 +71,14 @@ static apt_bool_t demo_recog_channel_destroy(mrcp_engine_channel_t *channel);
 static apt_bool_t demo_recog_channel_open(mrcp_engine_channel_t *channel);
 static apt_bool_t demo_recog_channel_close(mrcp_engine_channel_t *channel);
 static apt_bool_t demo_recog_channel_request_process(mrcp_engine_channel_t *channel, mrcp_message_t *request);
+static apt_bool_t demo_recog_channel_reset(mrcp_engine_channel_t *channel);
 
 static const struct mrcp_engine_channel_method_vtable_t channel_vtable = {
 	demo_recog_channel_destroy,
 	demo_recog_channel_open,
 	demo_recog_channel_close,
-	demo_recog_channel_request_process
+	demo_recog_channel_request_process,
+	demo_recog_channel_reset
 };
 
 /** Declaration of recognizer audio stream methods */
@@ -72,6 +86,7 @@ static apt_bool_t demo_recog_stream_destroy(mpf_audio_stream_t *stream);
 static apt_bool_t demo_recog_stream_open(mpf_audio_stream_t *stream, mpf_codec_t *codec);
 static apt_bool_t demo_recog_stream_close(mpf_audio_stream_t *stream);
 static apt_bool_t demo_recog_stream_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame);
+static apt_bool_t demo_recog_stream_event_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame);
 
 static const mpf_audio_stream_vtable_t audio_stream_vtable = {
 	demo_recog_stream_destroy,
@@ -81,12 +96,16 @@ static const mpf_audio_stream_vtable_t audio_stream_vtable = {
 	demo_recog_stream_open,
 	demo_recog_stream_close,
 	demo_recog_stream_write,
-	NULL
+	NULL,
+	demo_recog_stream_event_write
 };
 
 /** Declaration of demo recognizer engine */
 struct demo_recog_engine_t {
-	apt_consumer_task_t    *task;
+	/** Executor to run jobs by, shared among engines */
+	apt_executor_t         *executor;
+	/** Pool of messages passed to jobs */
+	apt_task_msg_pool_t    *msg_pool;
 };
 
 /** Declaration of demo recognizer channel */
@@ -95,6 +114,8 @@ struct demo_recog_channel_t {
 	demo_recog_engine_t     *demo_engine;
 	/** Engine channel base */
 	mrcp_engine_channel_t   *channel;
+	/** Strand to run jobs of the channel by in order */
+	apt_executor_strand_t   *strand;
 
 	/** Active (in-progress) recognition request */
 	mrcp_message_t          *recog_request;
@@ -102,6 +123,14 @@ struct demo_recog_channel_t {
 	mrcp_message_t          *stop_response;
 	/** Indicates whether input timers are started */
 	apt_bool_t               timers_started;
+	/** Indicates whether noinput timer is processed (media context) */
+	apt_bool_t               noinput_started;
+	/** Noinput timeout of the request (msec) */
+	apr_size_t               noinput_timeout;
+	/** Recognition timeout of the request (msec) */
+	apr_size_t               recognition_timeout;
+	/** Timers driven by processed frames */
+	mrcp_frame_clock_t       clock;
 	/** Voice activity detector */
 	mpf_activity_detector_t *detector;
 	/** File to write utterance to */
@@ -122,7 +151,7 @@ struct demo_recog_msg_t {
 };
 
 static apt_bool_t demo_recog_msg_signal(demo_recog_msg_type_e type, mrcp_engine_channel_t *channel, mrcp_message_t *request);
-static apt_bool_t demo_recog_msg_process(apt_task_t *task, apt_task_msg_t *msg);
+static void demo_recog_msg_process(void *obj, void *arg);
 
 /** Declare this macro to set plugin version */
 MRCP_PLUGIN_VERSION_DECLARE
@@ -133,40 +162,38 @@ MRCP_PLUGIN_LOGGER_IMPLEMENT
 /** Create demo recognizer engine */
 MRCP_PLUGIN_DECLARE(mrcp_engine_t*) mrcp_plugin_create(apr_pool_t *pool)
 {
+	mrcp_engine_t *engine;
 	demo_recog_engine_t *demo_engine = apr_palloc(pool,sizeof(demo_recog_engine_t));
-	apt_task_t *task;
-	apt_task_vtable_t *vtable;
-	apt_task_msg_pool_t *msg_pool;
 
-	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(demo_recog_msg_t),pool);
-	demo_engine->task = apt_consumer_task_create(demo_engine,msg_pool,pool);
-	if(!demo_engine->task) {
-		return NULL;
-	}
-	task = apt_consumer_task_base_get(demo_engine->task);
-	apt_task_name_set(task,RECOG_ENGINE_TASK_NAME);
-	vtable = apt_task_vtable_get(task);
-	if(vtable) {
-		vtable->process_msg = demo_recog_msg_process;
-	}
+	/* jobs are run by the executor shared among engines, which is available once the engine is opened */
+	demo_engine->executor = NULL;
+	demo_engine->msg_pool = apt_task_msg_pool_create_dynamic(sizeof(demo_recog_msg_t),pool);
 
 	/* create engine base */
-	return mrcp_engine_create(
+	engine = mrcp_engine_create(
 				MRCP_RECOGNIZER_RESOURCE,  /* MRCP resource identifier */
 				demo_engine,               /* object to associate */
 				&engine_vtable,            /* virtual methods table of engine */
 				pool);                     /* pool to allocate memory from */
+	if(engine) {
+		/* timeouts and thresholds are taken from RECOGNIZE, SET-PARAMS/GET-PARAMS of them are processed by the server */
+		mrcp_engine_param_declare(engine,RECOGNIZER_HEADER_CONFIDENCE_THRESHOLD);
+		mrcp_engine_param_declare(engine,RECOGNIZER_HEADER_SENSITIVITY_LEVEL);
+		mrcp_engine_param_declare(engine,RECOGNIZER_HEADER_SPEED_VS_ACCURACY);
+		mrcp_engine_param_declare(engine,RECOGNIZER_HEADER_N_BEST_LIST_LENGTH);
+		mrcp_engine_param_declare(engine,RECOGNIZER_HEADER_NO_INPUT_TIMEOUT);
+		mrcp_engine_param_declare(engine,RECOGNIZER_HEADER_RECOGNITION_TIMEOUT);
+		mrcp_engine_param_declare(engine,RECOGNIZER_HEADER_SPEECH_COMPLETE_TIMEOUT);
+		mrcp_engine_param_declare(engine,RECOGNIZER_HEADER_SPEECH_INCOMPLETE_TIMEOUT);
+		mrcp_engine_param_declare(engine,RECOGNIZER_HEADER_SPEECH_LANGUAGE);
+	}
+	return engine;
 }
 
 /** Destroy recognizer engine */
 static apt_bool_t demo_recog_engine_destroy(mrcp_engine_t *engine)
 {
-	demo_recog_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_destroy(task);
-		demo_engine->task = NULL;
-	}
+	/* nothing to destroy, the executor is owned by the server */
 	return TRUE;
 }
 
@@ -174,9 +201,10 @@ static apt_bool_t demo_recog_engine_destroy(mrcp_engine_t *engine)
 static apt_bool_t demo_recog_engine_open(mrcp_engine_t *engine)
 {
 	demo_recog_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_start(task);
+	demo_engine->executor = engine->executor;
+	if(!demo_engine->executor) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Executor Available [%s]",engine->id);
+		return mrcp_engine_open_respond(engine,FALSE);
 	}
 	return mrcp_engine_open_respond(engine,TRUE);
 }
@@ -184,11 +212,7 @@ static apt_bool_t demo_recog_engine_open(mrcp_engine_t *engine)
 /** Close recognizer engine */
 static apt_bool_t demo_recog_engine_close(mrcp_engine_t *engine)
 {
-	demo_recog_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_terminate(task,TRUE);
-	}
+	/* channels are closed by now, their strands wait for pending jobs on destroy */
 	return mrcp_engine_close_respond(engine);
 }
 
@@ -200,9 +224,23 @@ static mrcp_engine_channel_t* demo_recog_engine_channel_create(mrcp_engine_t *en
 	/* create demo recog channel */
 	demo_recog_channel_t *recog_channel = apr_palloc(pool,sizeof(demo_recog_channel_t));
 	recog_channel->demo_engine = engine->obj;
+	recog_channel->strand = apt_executor_strand_create(engine->executor,EXECUTOR_STRAND_DEFAULT_SIZE,pool);
+	if(!recog_channel->strand) {
+		return NULL;
+	}
 	recog_channel->recog_request = NULL;
 	recog_channel->stop_response = NULL;
+	recog_channel->timers_started = FALSE;
+	recog_channel->noinput_started = FALSE;
+	recog_channel->noinput_timeout = DEMO_RECOG_NOINPUT_TIMEOUT;
+	recog_channel->recognition_timeout = DEMO_RECOG_RECOGNITION_TIMEOUT;
+	mrcp_frame_clock_reset(&recog_channel->clock);
 	recog_channel->detector = mpf_activity_detector_create(pool);
+	mpf_activity_detector_silence_timeout_set(recog_channel->detector,DEMO_RECOG_SILENCE_TIMEOUT);
+	/* optional "vad-classifier" engine param selects the classifier of voice activity */
+	mpf_activity_detector_classifier_set(
+			recog_channel->detector,
+			mpf_activity_classifier_create(mrcp_engine_param_get(engine,"vad-classifier"),pool));
 	recog_channel->audio_out = NULL;
 
 	capabilities = mpf_sink_stream_capabilities_create(pool);
@@ -226,13 +264,17 @@ static mrcp_engine_channel_t* demo_recog_engine_channel_create(mrcp_engine_t *en
 			termination,          /* associated media termination */
 			pool);                /* pool to allocate memory from */
 
+	/* no audio is decoded for the channel until RECOGNIZE */
+	mrcp_engine_sink_stream_active_set(recog_channel->channel,FALSE);
 	return recog_channel->channel;
 }
 
 /** Destroy engine channel */
 static apt_bool_t demo_recog_channel_destroy(mrcp_engine_channel_t *channel)
 {
-	/* nothing to destrtoy */
+	demo_recog_channel_t *recog_channel = channel->method_obj;
+	/* wait for the jobs of the channel to complete */
+	apt_executor_strand_destroy(recog_channel->strand);
 	return TRUE;
 }
 
@@ -254,6 +296,24 @@ static apt_bool_t demo_recog_channel_request_process(mrcp_engine_channel_t *chan
 	return demo_recog_msg_signal(DEMO_RECOG_MSG_REQUEST_PROCESS,channel,request);
 }
 
+/** Reset closed engine channel to be reused by another session */
+static apt_bool_t demo_recog_channel_reset(mrcp_engine_channel_t *channel)
+{
+	demo_recog_channel_t *recog_channel = channel->method_obj;
+	if(recog_channel->audio_out) {
+		return FALSE;
+	}
+	recog_channel->recog_request = NULL;
+	recog_channel->stop_response = NULL;
+	recog_channel->timers_started = FALSE;
+	recog_channel->noinput_started = FALSE;
+	mrcp_frame_clock_reset(&recog_channel->clock);
+	/* restore the timeouts a RECOGNIZE request may have changed */
+	mpf_activity_detector_silence_timeout_set(recog_channel->detector,DEMO_RECOG_SILENCE_TIMEOUT);
+	mpf_activity_detector_reset(recog_channel->detector);
+	return TRUE;
+}
+
 /** Process RECOGNIZE request */
 static apt_bool_t demo_recog_channel_recognize(mrcp_engine_channel_t *channel, mrcp_message_t *request, mrcp_message_t *response)
 {
@@ -269,6 +329,11 @@ static apt_bool_t demo_recog_channel_recognize(mrcp_engine_channel_t *channel, m
 	}
 
 	recog_channel->timers_started = TRUE;
+	recog_channel->noinput_started = FALSE;
+	recog_channel->noinput_timeout = DEMO_RECOG_NOINPUT_TIMEOUT;
+	recog_channel->recognition_timeout = DEMO_RECOG_RECOGNITION_TIMEOUT;
+	/* no frame of the request is processed until it is set as active below */
+	mrcp_frame_clock_reset(&recog_channel->clock);
 
 	/* get recognizer header */
 	recog_header = mrcp_resource_header_get(request);
@@ -277,7 +342,10 @@ static apt_bool_t demo_recog_channel_recognize(mrcp_engine_channel_t *channel, m
 			recog_channel->timers_started = recog_header->start_input_timers;
 		}
 		if(mrcp_resource_header_property_check(request,RECOGNIZER_HEADER_NO_INPUT_TIMEOUT) == TRUE) {
-			mpf_activity_detector_noinput_timeout_set(recog_channel->detector,recog_header->no_input_timeout);
+			recog_channel->noinput_timeout = recog_header->no_input_timeout;
+		}
+		if(mrcp_resource_header_property_check(request,RECOGNIZER_HEADER_RECOGNITION_TIMEOUT) == TRUE) {
+			recog_channel->recognition_timeout = recog_header->recognition_timeout;
 		}
 		if(mrcp_resource_header_property_check(request,RECOGNIZER_HEADER_SPEECH_COMPLETE_TIMEOUT) == TRUE) {
 			mpf_activity_detector_silence_timeout_set(recog_channel->detector,recog_header->speech_complete_timeout);
@@ -286,10 +354,11 @@ static apt_bool_t demo_recog_channel_recognize(mrcp_engine_channel_t *channel, m
 
 	if(!recog_channel->audio_out) {
 		const apt_dir_layout_t *dir_layout = channel->engine->dir_layout;
-		char *file_name = apr_psprintf(channel->pool,"utter-%dkHz-%s.pcm",
+		/* allocate from request pool, the channel may be reused by many sessions */
+		char *file_name = apr_psprintf(request->pool,"utter-%dkHz-%s.pcm",
 							descriptor->sampling_rate/1000,
 							request->channel_id.session_id.buf);
-		char *file_path = apt_vardir_filepath_get(dir_layout,file_name,channel->pool);
+		char *file_path = apt_vardir_filepath_get(dir_layout,file_name,request->pool);
 		if(file_path) {
 			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Open Utterance Output File [%s] for Writing",file_path);
 			recog_channel->audio_out = fopen(file_path,"wb");
@@ -303,6 +372,8 @@ static apt_bool_t demo_recog_channel_recognize(mrcp_engine_channel_t *channel, m
 	/* send asynchronous response */
 	mrcp_engine_channel_message_send(channel,response);
 	recog_channel->recog_request = request;
+	/* the pre-roll (if any) is written right after, the request is to be set by then */
+	mrcp_engine_sink_stream_active_set(channel,TRUE);
 	return TRUE;
 }
 
@@ -453,10 +524,37 @@ static apt_bool_t demo_recog_recognition_complete(demo_recog_channel_t *recog_ch
 	}
 
 	recog_channel->recog_request = NULL;
+	mrcp_engine_sink_stream_active_set(recog_channel->channel,FALSE);
 	/* send asynch event */
 	return mrcp_engine_channel_message_send(recog_channel->channel,message);
 }
 
+/** Process named event (DTMF) received either with the frames or on arrival */
+static void demo_recog_event_process(demo_recog_channel_t *recog_channel, const mpf_frame_t *frame)
+{
+	if(frame->marker == MPF_MARKER_START_OF_EVENT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Detected Start of Event "APT_SIDRES_FMT" id:%d",
+			MRCP_MESSAGE_SIDRES(recog_channel->recog_request),
+			frame->event_frame.event_id);
+	}
+	else if(frame->marker == MPF_MARKER_END_OF_EVENT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Detected End of Event "APT_SIDRES_FMT" id:%d duration:%d ts",
+			MRCP_MESSAGE_SIDRES(recog_channel->recog_request),
+			frame->event_frame.event_id,
+			frame->event_frame.duration);
+	}
+}
+
+/** Callback is called from MPF engine context to write named event on arrival, ahead of the frames */
+static apt_bool_t demo_recog_stream_event_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame)
+{
+	demo_recog_channel_t *recog_channel = stream->obj;
+	if(recog_channel->recog_request && !recog_channel->stop_response) {
+		demo_recog_event_process(recog_channel,frame);
+	}
+	return TRUE;
+}
+
 /** Callback is called from MPF engine context to write/send new frame */
 static apt_bool_t demo_recog_stream_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame)
 {
@@ -466,15 +564,42 @@ static apt_bool_t demo_recog_stream_write(mpf_audio_stream_t *stream, const mpf_
 		mrcp_engine_channel_message_send(recog_channel->channel,recog_channel->stop_response);
 		recog_channel->stop_response = NULL;
 		recog_channel->recog_request = NULL;
+		mrcp_engine_sink_stream_active_set(recog_channel->channel,FALSE);
 		return TRUE;
 	}
 
 	if(recog_channel->recog_request) {
-		mpf_detector_event_e det_event = mpf_activity_detector_process(recog_channel->detector,frame);
+		mpf_detector_event_e det_event;
+		int timer_id;
+		if(recog_channel->timers_started == TRUE && recog_channel->noinput_started == FALSE) {
+			/* the timers may be started by RECOGNIZE or by START-INPUT-TIMERS later on */
+			recog_channel->noinput_started = TRUE;
+			mrcp_frame_clock_timer_start(&recog_channel->clock,DEMO_RECOG_TIMER_NOINPUT,recog_channel->noinput_timeout);
+		}
+
+		timer_id = mrcp_frame_clock_advance(&recog_channel->clock,CODEC_FRAME_TIME_BASE);
+		if(timer_id == DEMO_RECOG_TIMER_NOINPUT) {
+			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Detected Noinput "APT_SIDRES_FMT,
+				MRCP_MESSAGE_SIDRES(recog_channel->recog_request));
+			demo_recog_recognition_complete(recog_channel,RECOGNIZER_COMPLETION_CAUSE_NO_INPUT_TIMEOUT);
+			return TRUE;
+		}
+		if(timer_id == DEMO_RECOG_TIMER_RECOGNITION) {
+			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Detected Recognition Timeout "APT_SIDRES_FMT,
+				MRCP_MESSAGE_SIDRES(recog_channel->recog_request));
+			demo_recog_recognition_complete(recog_channel,RECOGNIZER_COMPLETION_CAUSE_RECOGNITION_TIMEOUT);
+			return TRUE;
+		}
+
+		det_event = mpf_activity_detector_process(recog_channel->detector,frame);
 		switch(det_event) {
 			case MPF_DETECTOR_EVENT_ACTIVITY:
 				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Detected Voice Activity "APT_SIDRES_FMT,
 					MRCP_MESSAGE_SIDRES(recog_channel->recog_request));
+				/* no noinput once the input is detected, recognition timer runs from now on */
+				recog_channel->noinput_started = TRUE;
+				mrcp_frame_clock_timer_stop(&recog_channel->clock,DEMO_RECOG_TIMER_NOINPUT);
+				mrcp_frame_clock_timer_start(&recog_channel->clock,DEMO_RECOG_TIMER_RECOGNITION,recog_channel->recognition_timeout);
 				demo_recog_start_of_input(recog_channel);
 				break;
 			case MPF_DETECTOR_EVENT_INACTIVITY:
@@ -482,29 +607,12 @@ static apt_bool_t demo_recog_stream_write(mpf_audio_stream_t *stream, const mpf_
 					MRCP_MESSAGE_SIDRES(recog_channel->recog_request));
 				demo_recog_recognition_complete(recog_channel,RECOGNIZER_COMPLETION_CAUSE_SUCCESS);
 				break;
-			case MPF_DETECTOR_EVENT_NOINPUT:
-				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Detected Noinput "APT_SIDRES_FMT,
-					MRCP_MESSAGE_SIDRES(recog_channel->recog_request));
-				if(recog_channel->timers_started == TRUE) {
-					demo_recog_recognition_complete(recog_channel,RECOGNIZER_COMPLETION_CAUSE_NO_INPUT_TIMEOUT);
-				}
-				break;
 			default:
 				break;
 		}
 
 		if((frame->type & MEDIA_FRAME_TYPE_EVENT) == MEDIA_FRAME_TYPE_EVENT) {
-			if(frame->marker == MPF_MARKER_START_OF_EVENT) {
-				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Detected Start of Event "APT_SIDRES_FMT" id:%d",
-					MRCP_MESSAGE_SIDRES(recog_channel->recog_request),
-					frame->event_frame.event_id);
-			}
-			else if(frame->marker == MPF_MARKER_END_OF_EVENT) {
-				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Detected End of Event "APT_SIDRES_FMT" id:%d duration:%d ts",
-					MRCP_MESSAGE_SIDRES(recog_channel->recog_request),
-					frame->event_frame.event_id,
-					frame->event_frame.duration);
-			}
+			demo_recog_event_process(recog_channel,frame);
 		}
 
 		if(recog_channel->audio_out) {
@@ -519,8 +627,7 @@ static apt_bool_t demo_recog_msg_signal(demo_recog_msg_type_e type, mrcp_engine_
 	apt_bool_t status = FALSE;
 	demo_recog_channel_t *demo_channel = channel->method_obj;
 	demo_recog_engine_t *demo_engine = demo_channel->demo_engine;
-	apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-	apt_task_msg_t *msg = apt_task_msg_get(task);
+	apt_task_msg_t *msg = apt_task_msg_acquire(demo_engine->msg_pool);
 	if(msg) {
 		demo_recog_msg_t *demo_msg;
 		msg->type = TASK_MSG_USER;
@@ -529,13 +636,17 @@ static apt_bool_t demo_recog_msg_signal(demo_recog_msg_type_e type, mrcp_engine_
 		demo_msg->type = type;
 		demo_msg->channel = channel;
 		demo_msg->request = request;
-		status = apt_task_msg_signal(task,msg);
+		status = apt_executor_job_submit(demo_channel->strand,demo_recog_msg_process,demo_engine,msg);
+		if(status == FALSE) {
+			apt_task_msg_release(msg);
+		}
 	}
 	return status;
 }
 
-static apt_bool_t demo_recog_msg_process(apt_task_t *task, apt_task_msg_t *msg)
+static void demo_recog_msg_process(void *obj, void *arg)
 {
+	apt_task_msg_t *msg = arg;
 	demo_recog_msg_t *demo_msg = (demo_recog_msg_t*)msg->data;
 	switch(demo_msg->type) {
 		case DEMO_RECOG_MSG_OPEN_CHANNEL:
@@ -560,5 +671,5 @@ static apt_bool_t demo_recog_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 		default:
 			break;
 	}
-	return TRUE;
+	apt_task_msg_release(msg);
 }
@@ -30,11 +30,11 @@
  */
 
 #include "mrcp_synth_engine.h"
-#include "apt_consumer_task.h"
+#include "mpf_audio_file_source.h"
+#include "apt_executor.h"
+#include "apt_task_msg.h"
 #include "apt_log.h"
 
-#define SYNTH_ENGINE_TASK_NAME "Demo Synth Engine"
-
 typedef struct demo_synth_engine_t demo_synth_engine_t;
 typedef struct demo_synth_channel_t demo_synth_channel_t;
 typedef struct demo_synth_msg_t demo_synth_msg_t;
@@ -85,26 +85,37 @@ static const mpf_audio_stream_vtable_t audio_stream_vtable = {
 
 /** Declaration of demo synthesizer engine */
 struct demo_synth_engine_t {
-	apt_consumer_task_t    *task;
+	/** Executor to run jobs by, shared among engines */
+	apt_executor_t         *executor;
+	/** Pool of messages passed to jobs */
+	apt_task_msg_pool_t    *msg_pool;
 };
 
 /** Declaration of demo synthesizer channel */
 struct demo_synth_channel_t {
 	/** Back pointer to engine */
-	demo_synth_engine_t   *demo_engine;
+	demo_synth_engine_t     *demo_engine;
 	/** Engine channel base */
-	mrcp_engine_channel_t *channel;
+	mrcp_engine_channel_t   *channel;
+	/** Strand to run jobs of the channel by in order */
+	apt_executor_strand_t   *strand;
 
 	/** Active (in-progress) speak request */
-	mrcp_message_t        *speak_request;
+	mrcp_message_t          *speak_request;
 	/** Pending stop response */
-	mrcp_message_t        *stop_response;
+	mrcp_message_t          *stop_response;
 	/** Estimated time to complete */
-	apr_size_t             time_to_complete;
+	apr_size_t               time_to_complete;
 	/** Is paused */
-	apt_bool_t             paused;
+	apt_bool_t               paused;
 	/** Speech source (used instead of actual synthesis) */
-	FILE                  *audio_file;
+	mpf_audio_file_source_t *audio_source;
+	/** Cached prompt streamed instead of synthesis */
+	mrcp_prompt_entry_t     *prompt;
+	/** Offset of the next frame in the cached prompt */
+	apr_size_t               prompt_offset;
+	/** Writer to cache the prompt being synthesized by */
+	mrcp_prompt_writer_t    *prompt_writer;
 };
 
 typedef enum {
@@ -122,7 +133,7 @@ struct demo_synth_msg_t {
 
 
 static apt_bool_t demo_synth_msg_signal(demo_synth_msg_type_e type, mrcp_engine_channel_t *channel, mrcp_message_t *request);
-static apt_bool_t demo_synth_msg_process(apt_task_t *task, apt_task_msg_t *msg);
+static void demo_synth_msg_process(void *obj, void *arg);
 
 /** Declare this macro to set plugin version */
 MRCP_PLUGIN_VERSION_DECLARE
@@ -133,42 +144,36 @@ MRCP_PLUGIN_LOGGER_IMPLEMENT
 /** Create demo synthesizer engine */
 MRCP_PLUGIN_DECLARE(mrcp_engine_t*) mrcp_plugin_create(apr_pool_t *pool)
 {
+	mrcp_engine_t *engine;
 	/* create demo engine */
 	demo_synth_engine_t *demo_engine = apr_palloc(pool,sizeof(demo_synth_engine_t));
-	apt_task_t *task;
-	apt_task_vtable_t *vtable;
-	apt_task_msg_pool_t *msg_pool;
-
-	/* create task/thread to run demo engine in the context of this task */
-	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(demo_synth_msg_t),pool);
-	demo_engine->task = apt_consumer_task_create(demo_engine,msg_pool,pool);
-	if(!demo_engine->task) {
-		return NULL;
-	}
-	task = apt_consumer_task_base_get(demo_engine->task);
-	apt_task_name_set(task,SYNTH_ENGINE_TASK_NAME);
-	vtable = apt_task_vtable_get(task);
-	if(vtable) {
-		vtable->process_msg = demo_synth_msg_process;
-	}
+
+	/* jobs are run by the executor shared among engines, which is available once the engine is opened */
+	demo_engine->executor = NULL;
+	demo_engine->msg_pool = apt_task_msg_pool_create_dynamic(sizeof(demo_synth_msg_t),pool);
 
 	/* create engine base */
-	return mrcp_engine_create(
+	engine = mrcp_engine_create(
 				MRCP_SYNTHESIZER_RESOURCE, /* MRCP resource identifier */
 				demo_engine,               /* object to associate */
 				&engine_vtable,            /* virtual methods table of engine */
 				pool);                     /* pool to allocate memory from */
+	if(engine) {
+		/* voice params are taken from SPEAK, SET-PARAMS/GET-PARAMS of them are processed by the server */
+		mrcp_engine_param_declare(engine,SYNTHESIZER_HEADER_VOICE_GENDER);
+		mrcp_engine_param_declare(engine,SYNTHESIZER_HEADER_VOICE_AGE);
+		mrcp_engine_param_declare(engine,SYNTHESIZER_HEADER_VOICE_NAME);
+		mrcp_engine_param_declare(engine,SYNTHESIZER_HEADER_PROSODY_VOLUME);
+		mrcp_engine_param_declare(engine,SYNTHESIZER_HEADER_PROSODY_RATE);
+		mrcp_engine_param_declare(engine,SYNTHESIZER_HEADER_SPEECH_LANGUAGE);
+	}
+	return engine;
 }
 
 /** Destroy synthesizer engine */
 static apt_bool_t demo_synth_engine_destroy(mrcp_engine_t *engine)
 {
-	demo_synth_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_destroy(task);
-		demo_engine->task = NULL;
-	}
+	/* nothing to destroy, the executor is owned by the server */
 	return TRUE;
 }
 
@@ -176,9 +181,10 @@ static apt_bool_t demo_synth_engine_destroy(mrcp_engine_t *engine)
 static apt_bool_t demo_synth_engine_open(mrcp_engine_t *engine)
 {
 	demo_synth_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_start(task);
+	demo_engine->executor = engine->executor;
+	if(!demo_engine->executor) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Executor Available [%s]",engine->id);
+		return mrcp_engine_open_respond(engine,FALSE);
 	}
 	return mrcp_engine_open_respond(engine,TRUE);
 }
@@ -186,11 +192,7 @@ static apt_bool_t demo_synth_engine_open(mrcp_engine_t *engine)
 /** Close synthesizer engine */
 static apt_bool_t demo_synth_engine_close(mrcp_engine_t *engine)
 {
-	demo_synth_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_terminate(task,TRUE);
-	}
+	/* channels are closed by now, their strands wait for pending jobs on destroy */
 	return mrcp_engine_close_respond(engine);
 }
 
@@ -203,11 +205,18 @@ static mrcp_engine_channel_t* demo_synth_engine_channel_create(mrcp_engine_t *en
 	/* create demo synth channel */
 	demo_synth_channel_t *synth_channel = apr_palloc(pool,sizeof(demo_synth_channel_t));
 	synth_channel->demo_engine = engine->obj;
+	synth_channel->strand = apt_executor_strand_create(engine->executor,EXECUTOR_STRAND_DEFAULT_SIZE,pool);
+	if(!synth_channel->strand) {
+		return NULL;
+	}
 	synth_channel->speak_request = NULL;
 	synth_channel->stop_response = NULL;
 	synth_channel->time_to_complete = 0;
 	synth_channel->paused = FALSE;
-	synth_channel->audio_file = NULL;
+	synth_channel->audio_source = NULL;
+	synth_channel->prompt = NULL;
+	synth_channel->prompt_offset = 0;
+	synth_channel->prompt_writer = NULL;
 	
 	capabilities = mpf_source_stream_capabilities_create(pool);
 	mpf_codec_capabilities_add(
@@ -233,10 +242,37 @@ static mrcp_engine_channel_t* demo_synth_engine_channel_create(mrcp_engine_t *en
 	return synth_channel->channel;
 }
 
+/** Close speech source, cache the recorded prompt if the synthesis is completed */
+static void demo_synth_speech_source_close(demo_synth_channel_t *synth_channel, apt_bool_t completed)
+{
+	if(synth_channel->audio_source) {
+		mpf_audio_file_source_close(synth_channel->audio_source);
+		synth_channel->audio_source = NULL;
+	}
+	if(synth_channel->prompt_writer) {
+		if(completed == TRUE) {
+			mrcp_prompt_writer_commit(synth_channel->prompt_writer);
+		}
+		else {
+			mrcp_prompt_writer_abort(synth_channel->prompt_writer);
+		}
+		synth_channel->prompt_writer = NULL;
+	}
+	if(synth_channel->prompt) {
+		mrcp_engine_prompt_release(synth_channel->channel->engine,synth_channel->prompt);
+		synth_channel->prompt = NULL;
+		synth_channel->prompt_offset = 0;
+	}
+}
+
 /** Destroy engine channel */
 static apt_bool_t demo_synth_channel_destroy(mrcp_engine_channel_t *channel)
 {
-	/* nothing to destroy */
+	demo_synth_channel_t *synth_channel = channel->method_obj;
+	/* wait for the jobs of the channel to complete */
+	apt_executor_strand_destroy(synth_channel->strand);
+	/* the session may be terminated in the middle of SPEAK */
+	demo_synth_speech_source_close(synth_channel,FALSE);
 	return TRUE;
 }
 
@@ -262,6 +298,8 @@ static apt_bool_t demo_synth_channel_request_process(mrcp_engine_channel_t *chan
 static apt_bool_t demo_synth_channel_speak(mrcp_engine_channel_t *channel, mrcp_message_t *request, mrcp_message_t *response)
 {
 	char *file_path = NULL;
+	apt_str_t prompt_key;
+	apt_bool_t cacheable = FALSE;
 	demo_synth_channel_t *synth_channel = channel->method_obj;
 	const mpf_codec_descriptor_t *descriptor = mrcp_engine_source_stream_codec_get(channel);
 
@@ -273,15 +311,31 @@ static apt_bool_t demo_synth_channel_speak(mrcp_engine_channel_t *channel, mrcp_
 
 	synth_channel->time_to_complete = 0;
 	if(channel->engine) {
+		cacheable = mrcp_prompt_key_generate(&prompt_key,request,descriptor,request->pool);
+		if(cacheable == TRUE) {
+			synth_channel->prompt = mrcp_engine_prompt_lookup(channel->engine,&prompt_key);
+		}
+	}
+	if(synth_channel->prompt) {
+		/* the same prompt has been synthesized before, no need to synthesize it again */
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Stream Cached Prompt "APT_SIDRES_FMT,MRCP_MESSAGE_SIDRES(request));
+		synth_channel->prompt_offset = 0;
+	}
+	else if(channel->engine) {
 		char *file_name = apr_psprintf(channel->pool,"demo-%dkHz.pcm",descriptor->sampling_rate/1000);
 		file_path = apt_datadir_filepath_get(channel->engine->dir_layout,file_name,channel->pool);
 	}
 	if(file_path) {
-		synth_channel->audio_file = fopen(file_path,"rb");
-		if(synth_channel->audio_file) {
+		/* mapped into memory, so that frames are read with no disk I/O from the media thread */
+		synth_channel->audio_source = mpf_audio_file_source_open(file_path);
+		if(synth_channel->audio_source) {
 			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set [%s] as Speech Source "APT_SIDRES_FMT,
 				file_path,
 				MRCP_MESSAGE_SIDRES(request));
+			if(cacheable == TRUE) {
+				/* record the rendered audio to stream it for the next identical requests */
+				synth_channel->prompt_writer = mrcp_engine_prompt_writer_create(channel->engine,&prompt_key);
+			}
 		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"No Speech Source [%s] Found "APT_SIDRES_FMT,
@@ -452,10 +506,7 @@ static apt_bool_t demo_synth_stream_read(mpf_audio_stream_t *stream, mpf_frame_t
 		synth_channel->stop_response = NULL;
 		synth_channel->speak_request = NULL;
 		synth_channel->paused = FALSE;
-		if(synth_channel->audio_file) {
-			fclose(synth_channel->audio_file);
-			synth_channel->audio_file = NULL;
-		}
+		demo_synth_speech_source_close(synth_channel,FALSE);
 		return TRUE;
 	}
 
@@ -463,11 +514,28 @@ static apt_bool_t demo_synth_stream_read(mpf_audio_stream_t *stream, mpf_frame_t
 	if(synth_channel->speak_request && synth_channel->paused == FALSE) {
 		/* normal processing */
 		apt_bool_t completed = FALSE;
-		if(synth_channel->audio_file) {
+		if(synth_channel->prompt) {
+			/* stream speech from the cache */
+			apr_size_t size = frame->codec_frame.size;
+			apr_size_t prompt_size;
+			const char *prompt_data = mrcp_prompt_entry_data_get(synth_channel->prompt,&prompt_size);
+			if(synth_channel->prompt_offset + size <= prompt_size) {
+				memcpy(frame->codec_frame.buffer,prompt_data + synth_channel->prompt_offset,size);
+				synth_channel->prompt_offset += size;
+				frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+			}
+			else {
+				completed = TRUE;
+			}
+		}
+		else if(synth_channel->audio_source) {
 			/* read speech from file */
 			apr_size_t size = frame->codec_frame.size;
-			if(fread(frame->codec_frame.buffer,1,size,synth_channel->audio_file) == size) {
+			if(mpf_audio_file_source_frame_read(synth_channel->audio_source,frame->codec_frame.buffer,size) == TRUE) {
 				frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+				if(synth_channel->prompt_writer) {
+					mrcp_prompt_writer_write(synth_channel->prompt_writer,frame->codec_frame.buffer,size);
+				}
 			}
 			else {
 				completed = TRUE;
@@ -503,10 +571,7 @@ static apt_bool_t demo_synth_stream_read(mpf_audio_stream_t *stream, mpf_frame_t
 				message->start_line.request_state = MRCP_REQUEST_STATE_COMPLETE;
 
 				synth_channel->speak_request = NULL;
-				if(synth_channel->audio_file) {
-					fclose(synth_channel->audio_file);
-					synth_channel->audio_file = NULL;
-				}
+				demo_synth_speech_source_close(synth_channel,TRUE);
 				/* send asynch event */
 				mrcp_engine_channel_message_send(synth_channel->channel,message);
 			}
@@ -520,8 +585,7 @@ static apt_bool_t demo_synth_msg_signal(demo_synth_msg_type_e type, mrcp_engine_
 	apt_bool_t status = FALSE;
 	demo_synth_channel_t *demo_channel = channel->method_obj;
 	demo_synth_engine_t *demo_engine = demo_channel->demo_engine;
-	apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-	apt_task_msg_t *msg = apt_task_msg_get(task);
+	apt_task_msg_t *msg = apt_task_msg_acquire(demo_engine->msg_pool);
 	if(msg) {
 		demo_synth_msg_t *demo_msg;
 		msg->type = TASK_MSG_USER;
@@ -530,13 +594,17 @@ static apt_bool_t demo_synth_msg_signal(demo_synth_msg_type_e type, mrcp_engine_
 		demo_msg->type = type;
 		demo_msg->channel = channel;
 		demo_msg->request = request;
-		status = apt_task_msg_signal(task,msg);
+		status = apt_executor_job_submit(demo_channel->strand,demo_synth_msg_process,demo_engine,msg);
+		if(status == FALSE) {
+			apt_task_msg_release(msg);
+		}
 	}
 	return status;
 }
 
-static apt_bool_t demo_synth_msg_process(apt_task_t *task, apt_task_msg_t *msg)
+static void demo_synth_msg_process(void *obj, void *arg)
 {
+	apt_task_msg_t *msg = arg;
 	demo_synth_msg_t *demo_msg = (demo_synth_msg_t*)msg->data;
 	switch(demo_msg->type) {
 		case DEMO_SYNTH_MSG_OPEN_CHANNEL:
@@ -553,5 +621,5 @@ static apt_bool_t demo_synth_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 		default:
 			break;
 	}
-	return TRUE;
+	apt_task_msg_release(msg);
 }
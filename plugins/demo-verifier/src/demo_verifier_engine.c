@@ -29,13 +29,13 @@
  * 5. Methods (callbacks) of the MPF engine stream MUST not block.
  */
 
+#include <stdlib.h>
 #include "mrcp_verifier_engine.h"
 #include "mpf_activity_detector.h"
-#include "apt_consumer_task.h"
+#include "apt_executor.h"
+#include "apt_task_msg.h"
 #include "apt_log.h"
 
-#define VERIFIER_ENGINE_TASK_NAME "Demo Verifier Engine"
-
 typedef struct demo_verifier_engine_t demo_verifier_engine_t;
 typedef struct demo_verifier_channel_t demo_verifier_channel_t;
 typedef struct demo_verifier_msg_t demo_verifier_msg_t;
@@ -86,7 +86,12 @@ static const mpf_audio_stream_vtable_t audio_stream_vtable = {
 
 /** Declaration of demo verification engine */
 struct demo_verifier_engine_t {
-	apt_consumer_task_t    *task;
+	/** Executor to run jobs by, shared among engines */
+	apt_executor_t         *executor;
+	/** Pool of messages passed to jobs */
+	apt_task_msg_pool_t    *msg_pool;
+	/** Loader of voiceprint models cached by the server */
+	mrcp_voiceprint_loader_t voiceprint_loader;
 };
 
 /** Declaration of demo verification channel */
@@ -95,6 +100,8 @@ struct demo_verifier_channel_t {
 	demo_verifier_engine_t     *demo_engine;
 	/** Engine channel base */
 	mrcp_engine_channel_t   *channel;
+	/** Strand to run jobs of the channel by in order */
+	apt_executor_strand_t   *strand;
 
 	/** Active (in-progress) verification request */
 	mrcp_message_t          *verifier_request;
@@ -106,6 +113,10 @@ struct demo_verifier_channel_t {
 	mpf_activity_detector_t *detector;
 	/** File to write voiceprint to */
 	FILE                    *audio_out;
+	/** START-SESSION request of the verification session in progress */
+	mrcp_message_t          *session_request;
+	/** Model of the voiceprint of the session (got from the cache of the server) */
+	mrcp_voiceprint_entry_t *voiceprint;
 };
 
 typedef enum {
@@ -122,10 +133,13 @@ struct demo_verifier_msg_t {
 };
 
 static apt_bool_t demo_verifier_msg_signal(demo_verifier_msg_type_e type, mrcp_engine_channel_t *channel, mrcp_message_t *request);
-static apt_bool_t demo_verifier_msg_process(apt_task_t *task, apt_task_msg_t *msg);
+static void demo_verifier_msg_process(void *obj, void *arg);
 
 static apt_bool_t demo_verifier_result_load(demo_verifier_channel_t *verifier_channel, mrcp_message_t *message);
 
+static void* demo_verifier_voiceprint_load(void *obj, const char *repository_uri, const char *voiceprint_id, apr_size_t *size);
+static void demo_verifier_voiceprint_destroy(void *obj, void *model);
+
 /** Declare this macro to set plugin version */
 MRCP_PLUGIN_VERSION_DECLARE
 
@@ -135,40 +149,33 @@ MRCP_PLUGIN_LOGGER_IMPLEMENT
 /** Create demo verification engine */
 MRCP_PLUGIN_DECLARE(mrcp_engine_t*) mrcp_plugin_create(apr_pool_t *pool)
 {
+	mrcp_engine_t *engine;
 	demo_verifier_engine_t *demo_engine = apr_palloc(pool,sizeof(demo_verifier_engine_t));
-	apt_task_t *task;
-	apt_task_vtable_t *vtable;
-	apt_task_msg_pool_t *msg_pool;
 
-	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(demo_verifier_msg_t),pool);
-	demo_engine->task = apt_consumer_task_create(demo_engine,msg_pool,pool);
-	if(!demo_engine->task) {
-		return NULL;
-	}
-	task = apt_consumer_task_base_get(demo_engine->task);
-	apt_task_name_set(task,VERIFIER_ENGINE_TASK_NAME);
-	vtable = apt_task_vtable_get(task);
-	if(vtable) {
-		vtable->process_msg = demo_verifier_msg_process;
-	}
+	/* jobs are run by the executor shared among engines, which is available once the engine is opened */
+	demo_engine->executor = NULL;
+	demo_engine->msg_pool = apt_task_msg_pool_create_dynamic(sizeof(demo_verifier_msg_t),pool);
+	demo_engine->voiceprint_loader.obj = demo_engine;
+	demo_engine->voiceprint_loader.load = demo_verifier_voiceprint_load;
+	demo_engine->voiceprint_loader.destroy = demo_verifier_voiceprint_destroy;
 
 	/* create engine base */
-	return mrcp_engine_create(
+	engine = mrcp_engine_create(
 				MRCP_VERIFIER_RESOURCE,    /* MRCP resource identifier */
 				demo_engine,               /* object to associate */
 				&engine_vtable,            /* virtual methods table of engine */
 				pool);                     /* pool to allocate memory from */
+	if(engine) {
+		/* voiceprint models are loaded through the server, which caches and prefetches them */
+		mrcp_engine_voiceprint_loader_set(engine,&demo_engine->voiceprint_loader);
+	}
+	return engine;
 }
 
 /** Destroy verification engine */
 static apt_bool_t demo_verifier_engine_destroy(mrcp_engine_t *engine)
 {
-	demo_verifier_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_destroy(task);
-		demo_engine->task = NULL;
-	}
+	/* nothing to destroy, the executor is owned by the server */
 	return TRUE;
 }
 
@@ -176,9 +183,10 @@ static apt_bool_t demo_verifier_engine_destroy(mrcp_engine_t *engine)
 static apt_bool_t demo_verifier_engine_open(mrcp_engine_t *engine)
 {
 	demo_verifier_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_start(task);
+	demo_engine->executor = engine->executor;
+	if(!demo_engine->executor) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Executor Available [%s]",engine->id);
+		return mrcp_engine_open_respond(engine,FALSE);
 	}
 	return mrcp_engine_open_respond(engine,TRUE);
 }
@@ -186,11 +194,7 @@ static apt_bool_t demo_verifier_engine_open(mrcp_engine_t *engine)
 /** Close verification engine */
 static apt_bool_t demo_verifier_engine_close(mrcp_engine_t *engine)
 {
-	demo_verifier_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_terminate(task,TRUE);
-	}
+	/* channels are closed by now, their strands wait for pending jobs on destroy */
 	return mrcp_engine_close_respond(engine);
 }
 
@@ -202,10 +206,20 @@ static mrcp_engine_channel_t* demo_verifier_engine_channel_create(mrcp_engine_t
 	/* create demo verification channel */
 	demo_verifier_channel_t *verifier_channel = apr_palloc(pool,sizeof(demo_verifier_channel_t));
 	verifier_channel->demo_engine = engine->obj;
+	verifier_channel->strand = apt_executor_strand_create(engine->executor,EXECUTOR_STRAND_DEFAULT_SIZE,pool);
+	if(!verifier_channel->strand) {
+		return NULL;
+	}
 	verifier_channel->verifier_request = NULL;
 	verifier_channel->stop_response = NULL;
 	verifier_channel->detector = mpf_activity_detector_create(pool);
+	/* optional "vad-classifier" engine param selects the classifier of voice activity */
+	mpf_activity_detector_classifier_set(
+			verifier_channel->detector,
+			mpf_activity_classifier_create(mrcp_engine_param_get(engine,"vad-classifier"),pool));
 	verifier_channel->audio_out = NULL;
+	verifier_channel->session_request = NULL;
+	verifier_channel->voiceprint = NULL;
 
 	capabilities = mpf_sink_stream_capabilities_create(pool);
 	mpf_codec_capabilities_add(
@@ -234,7 +248,9 @@ static mrcp_engine_channel_t* demo_verifier_engine_channel_create(mrcp_engine_t
 /** Destroy engine channel */
 static apt_bool_t demo_verifier_channel_destroy(mrcp_engine_channel_t *channel)
 {
-	/* nothing to destrtoy */
+	demo_verifier_channel_t *verifier_channel = channel->method_obj;
+	/* wait for the jobs of the channel to complete */
+	apt_executor_strand_destroy(verifier_channel->strand);
 	return TRUE;
 }
 
@@ -272,6 +288,19 @@ static apt_bool_t demo_verifier_channel_verify(mrcp_engine_channel_t *channel, m
 
 	verifier_channel->timers_started = TRUE;
 
+	if(verifier_channel->session_request && !verifier_channel->voiceprint) {
+		/* prefetched on START-SESSION, the model is ready by now, unless storage is slow */
+		mrcp_verifier_header_t *session_header = mrcp_resource_header_get(verifier_channel->session_request);
+		if(session_header) {
+			apt_str_t voiceprint_id = session_header->voiceprint_identifier;
+			const char *sep = memchr(voiceprint_id.buf,';',voiceprint_id.length);
+			if(sep) {
+				voiceprint_id.length = sep - voiceprint_id.buf;
+			}
+			verifier_channel->voiceprint = mrcp_engine_voiceprint_get(channel->engine,&session_header->repository_uri,&voiceprint_id);
+		}
+	}
+
 	/* get verifier header */
 	verifier_header = mrcp_resource_header_get(request);
 	if(verifier_header) {
@@ -308,6 +337,37 @@ static apt_bool_t demo_verifier_channel_verify(mrcp_engine_channel_t *channel, m
 	return TRUE;
 }
 
+/** Process START-SESSION request */
+static apt_bool_t demo_verifier_channel_session_start(mrcp_engine_channel_t *channel, mrcp_message_t *request, mrcp_message_t *response)
+{
+	demo_verifier_channel_t *verifier_channel = channel->method_obj;
+	mrcp_engine_voiceprint_release(channel->engine,verifier_channel->voiceprint);
+	verifier_channel->voiceprint = NULL;
+	verifier_channel->session_request = request;
+	return FALSE;
+}
+
+/** Process END-SESSION request */
+static apt_bool_t demo_verifier_channel_session_end(mrcp_engine_channel_t *channel, mrcp_message_t *request, mrcp_message_t *response)
+{
+	demo_verifier_channel_t *verifier_channel = channel->method_obj;
+	mrcp_engine_voiceprint_release(channel->engine,verifier_channel->voiceprint);
+	verifier_channel->voiceprint = NULL;
+	verifier_channel->session_request = NULL;
+	return FALSE;
+}
+
+/** Process DELETE-VOICEPRINT request */
+static apt_bool_t demo_verifier_channel_voiceprint_delete(mrcp_engine_channel_t *channel, mrcp_message_t *request, mrcp_message_t *response)
+{
+	mrcp_verifier_header_t *verifier_header = mrcp_resource_header_get(request);
+	if(verifier_header) {
+		/* the model must not be used anymore, once deleted from the repository */
+		mrcp_engine_voiceprint_invalidate(channel->engine,&verifier_header->repository_uri,&verifier_header->voiceprint_identifier);
+	}
+	return FALSE;
+}
+
 /** Process STOP request */
 static apt_bool_t demo_verifier_channel_stop(mrcp_engine_channel_t *channel, mrcp_message_t *request, mrcp_message_t *response)
 {
@@ -346,12 +406,15 @@ static apt_bool_t demo_verifier_channel_request_dispatch(mrcp_engine_channel_t *
 		case VERIFIER_GET_PARAMS:
 			break;
 		case VERIFIER_START_SESSION:
+			processed = demo_verifier_channel_session_start(channel,request,response);
 			break;
 		case VERIFIER_END_SESSION:
+			processed = demo_verifier_channel_session_end(channel,request,response);
 			break;
 		case VERIFIER_QUERY_VOICEPRINT:
 			break;
 		case VERIFIER_DELETE_VOICEPRINT:
+			processed = demo_verifier_channel_voiceprint_delete(channel,request,response);
 			break;
 		case VERIFIER_VERIFY:
 			processed = demo_verifier_channel_verify(channel,request,response);
@@ -544,8 +607,7 @@ static apt_bool_t demo_verifier_msg_signal(demo_verifier_msg_type_e type, mrcp_e
 	apt_bool_t status = FALSE;
 	demo_verifier_channel_t *demo_channel = channel->method_obj;
 	demo_verifier_engine_t *demo_engine = demo_channel->demo_engine;
-	apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-	apt_task_msg_t *msg = apt_task_msg_get(task);
+	apt_task_msg_t *msg = apt_task_msg_acquire(demo_engine->msg_pool);
 	if(msg) {
 		demo_verifier_msg_t *demo_msg;
 		msg->type = TASK_MSG_USER;
@@ -554,13 +616,17 @@ static apt_bool_t demo_verifier_msg_signal(demo_verifier_msg_type_e type, mrcp_e
 		demo_msg->type = type;
 		demo_msg->channel = channel;
 		demo_msg->request = request;
-		status = apt_task_msg_signal(task,msg);
+		status = apt_executor_job_submit(demo_channel->strand,demo_verifier_msg_process,demo_engine,msg);
+		if(status == FALSE) {
+			apt_task_msg_release(msg);
+		}
 	}
 	return status;
 }
 
-static apt_bool_t demo_verifier_msg_process(apt_task_t *task, apt_task_msg_t *msg)
+static void demo_verifier_msg_process(void *obj, void *arg)
 {
+	apt_task_msg_t *msg = arg;
 	demo_verifier_msg_t *demo_msg = (demo_verifier_msg_t*)msg->data;
 	switch(demo_msg->type) {
 		case DEMO_VERIF_MSG_OPEN_CHANNEL:
@@ -575,6 +641,9 @@ static apt_bool_t demo_verifier_msg_process(apt_task_t *task, apt_task_msg_t *ms
 				fclose(verifier_channel->audio_out);
 				verifier_channel->audio_out = NULL;
 			}
+			mrcp_engine_voiceprint_release(demo_msg->channel->engine,verifier_channel->voiceprint);
+			verifier_channel->voiceprint = NULL;
+			verifier_channel->session_request = NULL;
 
 			mrcp_engine_channel_close_respond(demo_msg->channel);
 			break;
@@ -585,5 +654,25 @@ static apt_bool_t demo_verifier_msg_process(apt_task_t *task, apt_task_msg_t *ms
 		default:
 			break;
 	}
-	return TRUE;
+	apt_task_msg_release(msg);
+}
+
+/** Load voiceprint model, called by the server in background or from a job of a channel */
+static void* demo_verifier_voiceprint_load(void *obj, const char *repository_uri, const char *voiceprint_id, apr_size_t *size)
+{
+	/* real engines read the model from the repository here, the demo one keeps the identifier only */
+	apr_size_t length = strlen(voiceprint_id);
+	char *model = malloc(length + 1);
+	if(!model) {
+		return NULL;
+	}
+	memcpy(model,voiceprint_id,length + 1);
+	*size = length + 1;
+	return model;
+}
+
+/** Destroy voiceprint model, once evicted from the cache */
+static void demo_verifier_voiceprint_destroy(void *obj, void *model)
+{
+	free(model);
 }
@@ -29,13 +29,26 @@
  * 5. Methods (callbacks) of the MPF engine stream MUST not block.
  */
 
+#include <stdlib.h>
 #include "mrcp_recorder_engine.h"
+#include "mrcp_generic_header.h"
 #include "mpf_activity_detector.h"
+#include "mpf_audio_file_encoder.h"
+#include "mpf_g711_kernel.h"
+#include "mpf_rtp_pt.h"
+#include "apt_file_writer.h"
 #include "apt_log.h"
 
 #define RECORDER_ENGINE_TASK_NAME "Recorder Engine"
+/* max number of u-law samples of a frame (8 kHz) */
+#define RECORDER_DECODE_SAMPLES_MAX (8 * CODEC_FRAME_TIME_MAX)
+/* silence is written as is */
+#define RECORDER_TRIM_NONE ((apr_size_t)-1)
+/* max silence held back from the writer (msec) */
+#define RECORDER_TRIM_HOLD_MAX 10000
 
 typedef struct recorder_channel_t recorder_channel_t;
+typedef struct recorder_fifo_t recorder_fifo_t;
 
 /** Declaration of recorder engine methods */
 static apt_bool_t recorder_engine_destroy(mrcp_engine_t *engine);
@@ -81,6 +94,20 @@ static const mpf_audio_stream_vtable_t audio_stream_vtable = {
 	NULL
 };
 
+/** Frames held back from the writer, while it's not known yet whether they are to be written */
+struct recorder_fifo_t {
+	/** Buffer of frames */
+	char                    *buf;
+	/** Allocated size of the buffer */
+	apr_size_t               max_size;
+	/** Size in use of the buffer, a multiple of the frame size */
+	apr_size_t               capacity;
+	/** Size of the frames held */
+	apr_size_t               size;
+	/** Position of the oldest frame */
+	apr_size_t               pos;
+};
+
 /** Declaration of recorder channel */
 struct recorder_channel_t {
 	/** Engine channel base */
@@ -100,10 +127,36 @@ struct recorder_channel_t {
 	apr_size_t               cur_time;
 	/** Written size of the recording in bytes */
 	apr_size_t               cur_size;
+	/** Written duration of the recording in msec */
+	apr_size_t               rec_time;
+	/** Size of frames of the stream in bytes */
+	apr_size_t               frame_size;
+	/** Default leading silence to keep in msec (RECORDER_TRIM_NONE - keep all) */
+	apr_size_t               lead_trim_default;
+	/** Default trailing silence to keep in msec (RECORDER_TRIM_NONE - keep all) */
+	apr_size_t               tail_trim_default;
+	/** Leading silence of the recording to keep in msec */
+	apr_size_t               lead_trim;
+	/** Trailing silence of the recording to keep in msec */
+	apr_size_t               tail_trim;
+	/** Whether the FIFOs are set up for the recording */
+	apt_bool_t               trim_ready;
+	/** Whether voice activity of the recording is detected */
+	apt_bool_t               activity;
+	/** Latest frames before voice activity, older ones are dropped */
+	recorder_fifo_t          lead_fifo;
+	/** Frames delayed by the part of the final silence to be dropped */
+	recorder_fifo_t          tail_fifo;
 	/** File name of the recording */
 	const char              *file_name;
-	/** File to write to */
-	FILE                    *audio_out;
+	/** File to write to, disk I/O and encoding are off the media thread */
+	apt_file_writer_t       *audio_out;
+	/** Default format of recordings */
+	mpf_audio_file_format_e  format;
+	/** Whether the stream receives u-law as is (no decoder in the bridge) */
+	apt_bool_t               passthrough;
+	/** G.711 kernels to decode frames for the activity detector in passthrough */
+	const mpf_g711_kernel_t *g711;
 };
 
 
@@ -116,12 +169,22 @@ MRCP_PLUGIN_LOGGER_IMPLEMENT
 /** Create recorder engine */
 MRCP_PLUGIN_DECLARE(mrcp_engine_t*) mrcp_plugin_create(apr_pool_t *pool)
 {
+	mrcp_engine_t *engine;
 	/* create engine base */
-	return mrcp_engine_create(
+	engine = mrcp_engine_create(
 				MRCP_RECORDER_RESOURCE,    /* MRCP resource identifier */
 				NULL,                      /* object to associate */
 				&engine_vtable,            /* virtual methods table of engine */
 				pool);                     /* pool to allocate memory from */
+	if(engine) {
+		/* recording params are taken from RECORD, SET-PARAMS/GET-PARAMS of them are processed by the server */
+		mrcp_engine_param_declare(engine,RECORDER_HEADER_SENSITIVITY_LEVEL);
+		mrcp_engine_param_declare(engine,RECORDER_HEADER_NO_INPUT_TIMEOUT);
+		mrcp_engine_param_declare(engine,RECORDER_HEADER_MEDIA_TYPE);
+		mrcp_engine_param_declare(engine,RECORDER_HEADER_MAX_TIME);
+		mrcp_engine_param_declare(engine,RECORDER_HEADER_FINAL_SILENCE);
+	}
+	return engine;
 }
 
 /** Destroy recorder engine */
@@ -142,27 +205,102 @@ static apt_bool_t recorder_engine_close(mrcp_engine_t *engine)
 	return mrcp_engine_close_respond(engine);
 }
 
+/** Get silence trimming param in msec */
+static apr_size_t recorder_trim_param_parse(const char *value, apr_size_t default_value)
+{
+	long trim;
+	if(!value || *value == '\0') {
+		return default_value;
+	}
+	trim = atol(value);
+	if(trim < 0) {
+		return RECORDER_TRIM_NONE;
+	}
+	return (apr_size_t)trim;
+}
+
+static void recorder_fifo_init(recorder_fifo_t *fifo)
+{
+	fifo->buf = NULL;
+	fifo->max_size = 0;
+	fifo->capacity = 0;
+	fifo->size = 0;
+	fifo->pos = 0;
+}
+
 static mrcp_engine_channel_t* recorder_engine_channel_create(mrcp_engine_t *engine, apr_pool_t *pool)
 {
 	mpf_stream_capabilities_t *capabilities;
 	mpf_termination_t *termination; 
+	const char *direct_io;
+	const char *record_format;
 
 	/* create recorder channel */
 	recorder_channel_t *recorder_channel = apr_palloc(pool,sizeof(recorder_channel_t));
 	recorder_channel->record_request = NULL;
 	recorder_channel->stop_response = NULL;
 	recorder_channel->detector = mpf_activity_detector_create(pool);
+	/* optional "vad-classifier" engine param selects the classifier of voice activity */
+	mpf_activity_detector_classifier_set(
+			recorder_channel->detector,
+			mpf_activity_classifier_create(mrcp_engine_param_get(engine,"vad-classifier"),pool));
 	recorder_channel->max_time = 0;
 	recorder_channel->cur_time = 0;
 	recorder_channel->cur_size = 0;
+	recorder_channel->rec_time = 0;
+	recorder_channel->frame_size = 0;
+	/* optional "trim-leading-silence" and "trim-trailing-silence" engine params (msec) limit
+	the silence written before and after the voice, may be overridden per RECORD request */
+	recorder_channel->lead_trim_default = recorder_trim_param_parse(
+			mrcp_engine_param_get(engine,"trim-leading-silence"),RECORDER_TRIM_NONE);
+	recorder_channel->tail_trim_default = recorder_trim_param_parse(
+			mrcp_engine_param_get(engine,"trim-trailing-silence"),RECORDER_TRIM_NONE);
+	recorder_channel->lead_trim = RECORDER_TRIM_NONE;
+	recorder_channel->tail_trim = RECORDER_TRIM_NONE;
+	recorder_channel->trim_ready = FALSE;
+	recorder_channel->activity = FALSE;
+	recorder_fifo_init(&recorder_channel->lead_fifo);
+	recorder_fifo_init(&recorder_channel->tail_fifo);
 	recorder_channel->file_name = NULL;
-	recorder_channel->audio_out = NULL;
+	/* optional "direct-io" engine param bypasses the page cache of recordings */
+	direct_io = mrcp_engine_param_get(engine,"direct-io");
+	recorder_channel->audio_out = apt_file_writer_create(
+			engine->executor,
+			APT_FILE_WRITER_DEFAULT_BLOCK_SIZE,
+			APT_FILE_WRITER_DEFAULT_BLOCK_COUNT,
+			(direct_io && strcasecmp(direct_io,"true") == 0) ? TRUE : FALSE,
+			pool);
+	if(!recorder_channel->audio_out) {
+		return NULL;
+	}
+	/* optional "record-format" engine param (pcm, wav, ulaw, opus) selects the default format of recordings */
+	recorder_channel->format = MPF_AUDIO_FILE_FORMAT_PCM;
+	record_format = mrcp_engine_param_get(engine,"record-format");
+	if(record_format) {
+		mpf_audio_file_format_e format = mpf_audio_file_format_find(record_format);
+		if(mpf_audio_file_format_is_supported(format) == TRUE) {
+			recorder_channel->format = format;
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unsupported Record Format [%s], Use PCM",record_format);
+		}
+	}
+
+	recorder_channel->passthrough = FALSE;
+	recorder_channel->g711 = mpf_g711_kernel_best_get();
 
 	capabilities = mpf_sink_stream_capabilities_create(pool);
 	mpf_codec_capabilities_add(
 			&capabilities->codecs,
 			MPF_SAMPLE_RATE_8000 | MPF_SAMPLE_RATE_16000,
 			"LPCM");
+	if(recorder_channel->format == MPF_AUDIO_FILE_FORMAT_ULAW) {
+		/* accept u-law as received, so that a null bridge is created and the payloads are stored as is */
+		mpf_codec_capabilities_add(
+				&capabilities->codecs,
+				MPF_SAMPLE_RATE_8000,
+				"PCMU");
+	}
 
 	/* create media termination */
 	termination = mrcp_engine_audio_termination_create(
@@ -185,7 +323,9 @@ static mrcp_engine_channel_t* recorder_engine_channel_create(mrcp_engine_t *engi
 /** Destroy engine channel */
 static apt_bool_t recorder_channel_destroy(mrcp_engine_channel_t *channel)
 {
-	/* nothing to destrtoy */
+	recorder_channel_t *recorder_channel = channel->method_obj;
+	/* wait for the recording to be written */
+	apt_file_writer_destroy(recorder_channel->audio_out);
 	return TRUE;
 }
 
@@ -203,37 +343,79 @@ static apt_bool_t recorder_channel_close(mrcp_engine_channel_t *channel)
 	return mrcp_engine_channel_close_respond(channel);
 }
 
+/** Determine the format of the recording */
+static mpf_audio_file_format_e recorder_format_get(recorder_channel_t *recorder_channel, mrcp_message_t *request)
+{
+	mpf_audio_file_format_e format;
+	mrcp_recorder_header_t *recorder_header = mrcp_resource_header_get(request);
+	if(!recorder_header || mrcp_resource_header_property_check(request,RECORDER_HEADER_MEDIA_TYPE) != TRUE) {
+		return recorder_channel->format;
+	}
+
+	/* Media-Type of the request overrides the default format */
+	format = mpf_audio_file_format_by_media_type(&recorder_header->media_type);
+	if(mpf_audio_file_format_is_supported(format) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Unsupported Media-Type [%s], Use Default Format "APT_SIDRES_FMT,
+			recorder_header->media_type.buf,
+			MRCP_MESSAGE_SIDRES(request));
+		return recorder_channel->format;
+	}
+	return format;
+}
+
 /** Open file to record */
 static apt_bool_t recorder_file_open(recorder_channel_t *recorder_channel, mrcp_message_t *request)
 {
 	char *file_path;
 	char *file_name;
+	apt_file_encoder_t *encoder = NULL;
 	mrcp_engine_channel_t *channel = recorder_channel->channel;
 	const apt_dir_layout_t *dir_layout = channel->engine->dir_layout;
 	const mpf_codec_descriptor_t *descriptor = mrcp_engine_sink_stream_codec_get(channel);
+	mpf_audio_file_format_e format;
 
 	if(!descriptor) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Get Codec Descriptor "APT_SIDRES_FMT, MRCP_MESSAGE_SIDRES(request));
 		return FALSE;
 	}
 
-	file_name = apr_psprintf(channel->pool,"rec-%dkHz-%s-%"MRCP_REQUEST_ID_FMT".pcm",
+	format = recorder_format_get(recorder_channel,request);
+	recorder_channel->passthrough = (descriptor->payload_type == RTP_PT_PCMU) ? TRUE : FALSE;
+	if(recorder_channel->passthrough == TRUE) {
+		if(format != MPF_AUDIO_FILE_FORMAT_ULAW) {
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Record u-law as Received "APT_SIDRES_FMT, MRCP_MESSAGE_SIDRES(request));
+			format = MPF_AUDIO_FILE_FORMAT_ULAW;
+		}
+		encoder = mpf_audio_file_ulaw_passthrough_create(descriptor->sampling_rate);
+		if(!encoder) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create u-law Writer "APT_SIDRES_FMT, MRCP_MESSAGE_SIDRES(request));
+			return FALSE;
+		}
+	}
+	else if(format != MPF_AUDIO_FILE_FORMAT_PCM) {
+		/* the encoder runs in the context of the writer */
+		encoder = mpf_audio_file_encoder_create(format,descriptor->sampling_rate);
+		if(!encoder) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Encoder, Record PCM "APT_SIDRES_FMT, MRCP_MESSAGE_SIDRES(request));
+			format = MPF_AUDIO_FILE_FORMAT_PCM;
+		}
+	}
+
+	file_name = apr_psprintf(channel->pool,"rec-%dkHz-%s-%"MRCP_REQUEST_ID_FMT".%s",
 		descriptor->sampling_rate/1000,
 		request->channel_id.session_id.buf,
-		request->start_line.request_id);
+		request->start_line.request_id,
+		mpf_audio_file_format_ext_get(format));
 	file_path = apt_vardir_filepath_get(dir_layout,file_name,channel->pool);
 	if(!file_path) {
+		if(encoder) {
+			encoder->vtable->close(encoder,NULL);
+		}
 		return FALSE;
 	}
 
-	if(recorder_channel->audio_out) {
-		fclose(recorder_channel->audio_out);
-		recorder_channel->audio_out = NULL;
-	}
-
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Open Utterance Output File [%s] for Writing",file_path);
-	recorder_channel->audio_out = fopen(file_path,"wb");
-	if(!recorder_channel->audio_out) {
+	if(apt_file_writer_open(recorder_channel->audio_out,file_path,encoder) == FALSE) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open Utterance Output File [%s] for Writing",file_path);
 		return FALSE;
 	}
@@ -257,13 +439,148 @@ static apt_bool_t recorder_channel_uri_set(recorder_channel_t *recorder_channel,
 		"<file://mediaserver/data/%s>;size=%"APR_SIZE_T_FMT";duration=%"APR_SIZE_T_FMT,
 		recorder_channel->file_name,
 		recorder_channel->cur_size,
-		recorder_channel->cur_time);
+		recorder_channel->rec_time);
 
 	apt_string_set(&recorder_header->record_uri,record_uri);
 	mrcp_resource_header_property_add(message,RECORDER_HEADER_RECORD_URI);
 	return TRUE;
 }
 
+/** Get silence trimming of the request from vendor specific params */
+static apr_size_t recorder_trim_get(mrcp_message_t *request, const char *name, apr_size_t default_value)
+{
+	const apt_pair_t *pair;
+	apt_str_t param_name;
+	mrcp_generic_header_t *generic_header;
+	if(mrcp_generic_header_property_check(request,GENERIC_HEADER_VENDOR_SPECIFIC_PARAMS) != TRUE) {
+		return default_value;
+	}
+	generic_header = mrcp_generic_header_get(request);
+	if(!generic_header || !generic_header->vendor_specific_params) {
+		return default_value;
+	}
+	apt_string_set(&param_name,name);
+	pair = apt_pair_array_find(generic_header->vendor_specific_params,&param_name);
+	if(!pair) {
+		return default_value;
+	}
+	return recorder_trim_param_parse(pair->value.buf,default_value);
+}
+
+/** Write audio to the file */
+static void recorder_audio_write(recorder_channel_t *recorder_channel, const char *data, apr_size_t size)
+{
+	if(!size) {
+		return;
+	}
+	apt_file_writer_write(recorder_channel->audio_out,data,size);
+	recorder_channel->cur_size += size;
+	if(recorder_channel->frame_size) {
+		recorder_channel->rec_time += size / recorder_channel->frame_size * CODEC_FRAME_TIME_BASE;
+	}
+}
+
+/** Set up FIFO to hold back the frames of the duration */
+static void recorder_fifo_setup(recorder_fifo_t *fifo, apr_size_t duration, apr_size_t frame_size, apr_pool_t *pool)
+{
+	if(duration > RECORDER_TRIM_HOLD_MAX) {
+		duration = RECORDER_TRIM_HOLD_MAX;
+	}
+	fifo->capacity = duration / CODEC_FRAME_TIME_BASE * frame_size;
+	if(fifo->capacity > fifo->max_size) {
+		/* the buffer is reused by the next recordings of the channel */
+		fifo->buf = apr_palloc(pool,fifo->capacity);
+		fifo->max_size = fifo->capacity;
+	}
+	fifo->size = 0;
+	fifo->pos = 0;
+}
+
+/** Write out (or drop) the oldest frames of FIFO */
+static void recorder_fifo_pop(recorder_channel_t *recorder_channel, recorder_fifo_t *fifo, apr_size_t size, apt_bool_t drop)
+{
+	apr_size_t chunk;
+	while(size && fifo->size) {
+		chunk = fifo->capacity - fifo->pos;
+		if(chunk > size) chunk = size;
+		if(chunk > fifo->size) chunk = fifo->size;
+		if(drop == FALSE) {
+			recorder_audio_write(recorder_channel,fifo->buf + fifo->pos,chunk);
+		}
+		fifo->pos += chunk;
+		if(fifo->pos == fifo->capacity) fifo->pos = 0;
+		fifo->size -= chunk;
+		size -= chunk;
+	}
+	if(!fifo->size) {
+		fifo->pos = 0;
+	}
+}
+
+/** Push frame to FIFO, the oldest frames are written out (or dropped), once it's full */
+static void recorder_fifo_push(recorder_channel_t *recorder_channel, recorder_fifo_t *fifo, const char *data, apr_size_t size, apt_bool_t drop)
+{
+	apr_size_t tail;
+	apr_size_t chunk;
+	if(size > fifo->capacity) {
+		/* nothing to hold back */
+		recorder_fifo_pop(recorder_channel,fifo,fifo->size,drop);
+		if(drop == FALSE) {
+			recorder_audio_write(recorder_channel,data,size);
+		}
+		return;
+	}
+	if(fifo->size + size > fifo->capacity) {
+		recorder_fifo_pop(recorder_channel,fifo,fifo->size + size - fifo->capacity,drop);
+	}
+
+	tail = (fifo->pos + fifo->size) % fifo->capacity;
+	chunk = fifo->capacity - tail;
+	if(chunk > size) chunk = size;
+	memcpy(fifo->buf + tail,data,chunk);
+	if(size > chunk) {
+		memcpy(fifo->buf,data + chunk,size - chunk);
+	}
+	fifo->size += size;
+}
+
+/** Write out the frames held back */
+static void recorder_fifos_flush(recorder_channel_t *recorder_channel)
+{
+	recorder_fifo_pop(recorder_channel,&recorder_channel->lead_fifo,recorder_channel->lead_fifo.size,FALSE);
+	recorder_fifo_pop(recorder_channel,&recorder_channel->tail_fifo,recorder_channel->tail_fifo.size,FALSE);
+}
+
+/** Write frame to the file, holding silence back as set by the request */
+static void recorder_frame_write(recorder_channel_t *recorder_channel, const mpf_frame_t *frame)
+{
+	const char *data = frame->codec_frame.buffer;
+	apr_size_t size = frame->codec_frame.size;
+	if(recorder_channel->trim_ready == FALSE) {
+		apr_size_t final_silence = mpf_activity_detector_silence_timeout_get(recorder_channel->detector);
+		apr_pool_t *pool = recorder_channel->channel->pool;
+		recorder_channel->frame_size = size;
+		if(recorder_channel->lead_trim != RECORDER_TRIM_NONE) {
+			recorder_fifo_setup(&recorder_channel->lead_fifo,recorder_channel->lead_trim,size,pool);
+		}
+		if(recorder_channel->tail_trim != RECORDER_TRIM_NONE && final_silence > recorder_channel->tail_trim) {
+			/* the recording completes after the final silence, the part of it beyond the trailing silence is dropped then */
+			recorder_fifo_setup(&recorder_channel->tail_fifo,final_silence - recorder_channel->tail_trim,size,pool);
+		}
+		recorder_channel->trim_ready = TRUE;
+	}
+
+	if(recorder_channel->activity == FALSE && recorder_channel->lead_trim != RECORDER_TRIM_NONE) {
+		recorder_fifo_push(recorder_channel,&recorder_channel->lead_fifo,data,size,TRUE);
+	}
+	else if(recorder_channel->tail_fifo.capacity) {
+		recorder_fifo_push(recorder_channel,&recorder_channel->tail_fifo,data,size,FALSE);
+	}
+	else {
+		recorder_audio_write(recorder_channel,data,size);
+	}
+}
+
 /** Process RECORD request */
 static apt_bool_t recorder_channel_record(recorder_channel_t *recorder_channel, mrcp_message_t *request, mrcp_message_t *response)
 {
@@ -299,6 +616,16 @@ static apt_bool_t recorder_channel_record(recorder_channel_t *recorder_channel,
 
 	recorder_channel->cur_time = 0;
 	recorder_channel->cur_size = 0;
+	recorder_channel->rec_time = 0;
+	/* Vendor-Specific-Parameters trim-leading-silence and trim-trailing-silence override the engine params */
+	recorder_channel->lead_trim = recorder_trim_get(request,"trim-leading-silence",recorder_channel->lead_trim_default);
+	recorder_channel->tail_trim = recorder_trim_get(request,"trim-trailing-silence",recorder_channel->tail_trim_default);
+	recorder_channel->trim_ready = FALSE;
+	recorder_channel->activity = FALSE;
+	recorder_channel->lead_fifo.capacity = 0;
+	recorder_channel->lead_fifo.size = 0;
+	recorder_channel->tail_fifo.capacity = 0;
+	recorder_channel->tail_fifo.size = 0;
 	response->start_line.request_state = MRCP_REQUEST_STATE_INPROGRESS;
 	/* send asynchronous response */
 	mrcp_engine_channel_message_send(recorder_channel->channel,response);
@@ -382,10 +709,8 @@ static apt_bool_t recorder_record_complete(recorder_channel_t *recorder_channel,
 		return FALSE;
 	}
 
-	if(recorder_channel->audio_out) {
-		fclose(recorder_channel->audio_out);
-		recorder_channel->audio_out = NULL;
-	}
+	recorder_fifos_flush(recorder_channel);
+	apt_file_writer_close(recorder_channel->audio_out);
 
 	/* get/allocate recorder header */
 	recorder_header = mrcp_resource_header_prepare(message);
@@ -427,10 +752,10 @@ static apt_bool_t recorder_stream_write(mpf_audio_stream_t *stream, const mpf_fr
 {
 	recorder_channel_t *recorder_channel = stream->obj;
 	if(recorder_channel->stop_response) {
-		if(recorder_channel->audio_out) {
-			fclose(recorder_channel->audio_out);
-			recorder_channel->audio_out = NULL;
+		if(recorder_channel->record_request) {
+			recorder_fifos_flush(recorder_channel);
 		}
+		apt_file_writer_close(recorder_channel->audio_out);
 		
 		if(recorder_channel->record_request){
 			/* set record-uri */
@@ -444,16 +769,37 @@ static apt_bool_t recorder_stream_write(mpf_audio_stream_t *stream, const mpf_fr
 	}
 
 	if(recorder_channel->record_request) {
-		mpf_detector_event_e det_event = mpf_activity_detector_process(recorder_channel->detector,frame);
+		mpf_detector_event_e det_event;
+		if(recorder_channel->passthrough == TRUE) {
+			/* the detector runs on linear samples, the payloads are stored as received */
+			apr_int16_t samples[RECORDER_DECODE_SAMPLES_MAX];
+			mpf_frame_t decoded_frame = *frame;
+			apr_size_t count = frame->codec_frame.size;
+			if(count > RECORDER_DECODE_SAMPLES_MAX) {
+				count = RECORDER_DECODE_SAMPLES_MAX;
+			}
+			recorder_channel->g711->ulaw_decode(frame->codec_frame.buffer,samples,count);
+			decoded_frame.codec_frame.buffer = samples;
+			decoded_frame.codec_frame.size = count * sizeof(apr_int16_t);
+			det_event = mpf_activity_detector_process(recorder_channel->detector,&decoded_frame);
+		}
+		else {
+			det_event = mpf_activity_detector_process(recorder_channel->detector,frame);
+		}
 		switch(det_event) {
 			case MPF_DETECTOR_EVENT_ACTIVITY:
 				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Detected Voice Activity "APT_SIDRES_FMT,
 					MRCP_MESSAGE_SIDRES(recorder_channel->record_request));
 				recorder_start_of_input(recorder_channel);
+				/* the leading silence kept goes first */
+				recorder_channel->activity = TRUE;
+				recorder_fifo_pop(recorder_channel,&recorder_channel->lead_fifo,recorder_channel->lead_fifo.size,FALSE);
 				break;
 			case MPF_DETECTOR_EVENT_INACTIVITY:
 				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Detected Voice Inactivity "APT_SIDRES_FMT,
 					MRCP_MESSAGE_SIDRES(recorder_channel->record_request));
+				/* the final silence beyond the trailing silence to keep is held back, drop it */
+				recorder_fifo_pop(recorder_channel,&recorder_channel->tail_fifo,recorder_channel->tail_fifo.size,TRUE);
 				recorder_record_complete(recorder_channel,RECORDER_COMPLETION_CAUSE_SUCCESS_SILENCE);
 				break;
 			case MPF_DETECTOR_EVENT_NOINPUT:
@@ -467,10 +813,9 @@ static apt_bool_t recorder_stream_write(mpf_audio_stream_t *stream, const mpf_fr
 				break;
 		}
 
-		if(recorder_channel->audio_out) {
-			fwrite(frame->codec_frame.buffer,1,frame->codec_frame.size,recorder_channel->audio_out);
+		if(apt_file_writer_is_open(recorder_channel->audio_out) == TRUE) {
+			recorder_frame_write(recorder_channel,frame);
 			
-			recorder_channel->cur_size += frame->codec_frame.size;
 			recorder_channel->cur_time += CODEC_FRAME_TIME_BASE;
 			if(recorder_channel->max_time && recorder_channel->cur_time >= recorder_channel->max_time) {
 				recorder_record_complete(recorder_channel,RECORDER_COMPLETION_CAUSE_SUCCESS_MAXTIME);
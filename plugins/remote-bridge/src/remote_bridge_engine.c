@@ -0,0 +1,1404 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+/*
+ * Bridge of MRCP channels to a remote (cloud or microservice) engine.
+ *
+ * Channels are mapped onto streams multiplexed over a small pool of TCP
+ * connections, so that no connection is set up per channel. The framing
+ * and the flow control follow HTTP/2 (RFC 7540), with no HPACK:
+ *
+ *   +-----------------------------------------------+
+ *   |                 Length (24)                   |
+ *   +---------------+---------------+---------------+
+ *   |   Type (8)    |   Flags (8)   |
+ *   +-+-------------+---------------+-------------------------------+
+ *   |R|                 Stream Identifier (31)                      |
+ *   +=+=============================================================+
+ *   |                   Frame Payload (0...)                      ...
+ *   +---------------------------------------------------------------+
+ *
+ * - the bridge sends the preface "MRCP-BRIDGE/1.0\r\n\r\n" and SETTINGS
+ *   (INITIAL_WINDOW_SIZE, MAX_FRAME_SIZE) on connect;
+ * - HEADERS opens the stream of a channel, the block is plain text
+ *   ("Resource", "Channel-Identifier", "Sampling-Rate" lines);
+ * - MESSAGE (0xA0) carries an MRCP message as text, requests of the client
+ *   one way, responses and events of the remote engine the other way;
+ * - DATA carries linear PCM (16-bit, host byte order), batched frames
+ *   of the recognizer to the remote, audio of the synthesizer back;
+ * - WINDOW_UPDATE grants credits of DATA per stream and per connection,
+ *   audio of the recognizer is dropped, once stalled for longer than
+ *   its ring holds;
+ * - RST_STREAM fails, PING and GOAWAY are handled as in HTTP/2.
+ *
+ * The plugin is built twice out of this file, as remoterecog (recognizer)
+ * and as remotesynth (synthesizer, REMOTE_BRIDGE_SYNTHESIZER defined).
+ */
+
+#include <stdlib.h>
+#include <apr_strings.h>
+#include <apr_network_io.h>
+#include <apr_atomic.h>
+#include <apr_hash.h>
+#include "mrcp_engine_plugin.h"
+#include "mrcp_engine_impl.h"
+#include "mrcp_stream.h"
+#include "mrcp_resource_loader.h"
+#include "mrcp_resource_factory.h"
+#include "mrcp_resource.h"
+#include "mrcp_generic_header.h"
+#ifdef REMOTE_BRIDGE_SYNTHESIZER
+#include "mrcp_synth_resource.h"
+#include "mrcp_synth_header.h"
+#else
+#include "mrcp_recog_resource.h"
+#include "mrcp_recog_header.h"
+#endif
+#include "mpf_codec_descriptor.h"
+#include "apt_poller_task.h"
+#include "apt_shm_ring.h"
+#include "apt_text_stream.h"
+#include "apt_log.h"
+
+#ifdef REMOTE_BRIDGE_SYNTHESIZER
+#define REMOTE_BRIDGE_RESOURCE         MRCP_SYNTHESIZER_RESOURCE
+#else
+#define REMOTE_BRIDGE_RESOURCE         MRCP_RECOGNIZER_RESOURCE
+#endif
+
+/** Default number of connections of the pool */
+#define REMOTE_BRIDGE_CONNECTIONS      2
+/** Default number of frames batched in a DATA frame */
+#define REMOTE_BRIDGE_BATCH_FRAMES     5
+/** Default window of a stream (bytes) */
+#define REMOTE_BRIDGE_WINDOW_SIZE      65535
+/** Default max payload of a frame (bytes) */
+#define REMOTE_BRIDGE_MAX_FRAME_SIZE   65536
+/** Capacity of the tx buffer of a connection (bytes) */
+#define REMOTE_BRIDGE_TX_BUFFER_SIZE   (512 * 1024)
+/** Timeout of connect (usec) */
+#define REMOTE_BRIDGE_CONNECT_TIMEOUT  (2 * APR_USEC_PER_SEC)
+/** Initial and max delays of reconnect (msec) */
+#define REMOTE_BRIDGE_RECONNECT_DELAY  500
+#define REMOTE_BRIDGE_RECONNECT_MAX    30000
+
+/** Size of frame header */
+#define FRAME_HEADER_SIZE              9
+/** Size of generated MRCP message head */
+#define MESSAGE_HEAD_SIZE              8192
+
+/** Types of frames */
+#define FRAME_TYPE_DATA                0x0
+#define FRAME_TYPE_HEADERS             0x1
+#define FRAME_TYPE_RST_STREAM          0x3
+#define FRAME_TYPE_SETTINGS            0x4
+#define FRAME_TYPE_PING                0x6
+#define FRAME_TYPE_GOAWAY              0x7
+#define FRAME_TYPE_WINDOW_UPDATE       0x8
+#define FRAME_TYPE_MESSAGE             0xA0
+
+/** Flags of frames */
+#define FRAME_FLAG_END_STREAM          0x1
+#define FRAME_FLAG_ACK                 0x1
+#define FRAME_FLAG_END_HEADERS         0x4
+
+/** Identifiers of settings */
+#define SETTINGS_INITIAL_WINDOW_SIZE   0x4
+#define SETTINGS_MAX_FRAME_SIZE        0x5
+
+/** Default window of HTTP/2 */
+#define DEFAULT_WINDOW_SIZE            65535
+
+static const char bridge_preface[] = "MRCP-BRIDGE/1.0\r\n\r\n";
+
+typedef struct remote_bridge_engine_t remote_bridge_engine_t;
+typedef struct remote_bridge_channel_t remote_bridge_channel_t;
+typedef struct remote_connection_t remote_connection_t;
+typedef struct remote_bridge_msg_t remote_bridge_msg_t;
+
+/** Declaration of engine methods */
+static apt_bool_t remote_bridge_engine_destroy(mrcp_engine_t *engine);
+static apt_bool_t remote_bridge_engine_open(mrcp_engine_t *engine);
+static apt_bool_t remote_bridge_engine_close(mrcp_engine_t *engine);
+static mrcp_engine_channel_t* remote_bridge_engine_channel_create(mrcp_engine_t *engine, apr_pool_t *pool);
+
+static const struct mrcp_engine_method_vtable_t engine_vtable = {
+	remote_bridge_engine_destroy,
+	remote_bridge_engine_open,
+	remote_bridge_engine_close,
+	remote_bridge_engine_channel_create
+};
+
+/** Declaration of channel methods */
+static apt_bool_t remote_bridge_channel_destroy(mrcp_engine_channel_t *channel);
+static apt_bool_t remote_bridge_channel_open(mrcp_engine_channel_t *channel);
+static apt_bool_t remote_bridge_channel_close(mrcp_engine_channel_t *channel);
+static apt_bool_t remote_bridge_channel_request_process(mrcp_engine_channel_t *channel, mrcp_message_t *request);
+
+static const struct mrcp_engine_channel_method_vtable_t channel_vtable = {
+	remote_bridge_channel_destroy,
+	remote_bridge_channel_open,
+	remote_bridge_channel_close,
+	remote_bridge_channel_request_process
+};
+
+/** Declaration of audio stream methods */
+#ifdef REMOTE_BRIDGE_SYNTHESIZER
+static apt_bool_t remote_bridge_stream_open(mpf_audio_stream_t *stream, mpf_codec_t *codec);
+static apt_bool_t remote_bridge_stream_read(mpf_audio_stream_t *stream, mpf_frame_t *frame);
+
+static const mpf_audio_stream_vtable_t audio_stream_vtable = {
+	NULL,
+	remote_bridge_stream_open,
+	NULL,
+	remote_bridge_stream_read,
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+#else
+static apt_bool_t remote_bridge_stream_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame);
+
+static const mpf_audio_stream_vtable_t audio_stream_vtable = {
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	remote_bridge_stream_write,
+	NULL
+};
+#endif
+
+/** Connection of the pool */
+struct remote_connection_t {
+	/** Back pointer to engine */
+	remote_bridge_engine_t *bridge;
+	/** Index in the pool (for logging) */
+	apr_size_t              index;
+	apr_socket_t           *sock;
+	apr_pollfd_t            sock_pfd;
+	/** Indicates whether new streams may be opened */
+	apt_bool_t              usable;
+	/** Table of channels by stream id */
+	apr_hash_t             *streams;
+	apr_uint32_t            next_stream_id;
+	/** Credits of DATA of the connection granted by the remote */
+	apr_int32_t             send_window;
+	/** Initial window of a stream granted by the remote */
+	apr_int32_t             peer_window;
+	/** Max payload of a frame the remote receives */
+	apr_size_t              peer_max_frame_size;
+	/** Received data not processed yet */
+	char                   *rx_buffer;
+	apr_size_t              rx_length;
+	apr_size_t              rx_capacity;
+	/** Data not sent yet */
+	char                   *tx_buffer;
+	apr_size_t              tx_offset;
+	apr_size_t              tx_length;
+	/** Parser of messages of the remote */
+	mrcp_parser_t          *parser;
+	apt_timer_t            *reconnect_timer;
+	apr_uint32_t            reconnect_delay;
+	apr_pool_t             *pool;
+};
+
+/** Declaration of remote bridge engine */
+struct remote_bridge_engine_t {
+	mrcp_engine_t                 *engine;
+	/** Task the connections are served by */
+	apt_poller_task_t             *task;
+	remote_connection_t           *connections;
+	apr_size_t                     connection_count;
+	apr_sockaddr_t                *sockaddr;
+	/** Frames batched in a DATA frame */
+	apr_size_t                     batch_frames;
+	/** Window of a stream granted to the remote */
+	apr_uint32_t                   window_size;
+	/** Max payload of a frame received */
+	apr_size_t                     max_frame_size;
+	/** Factory of the resource messages are parsed by */
+	mrcp_resource_factory_t       *resource_factory;
+	const apt_str_t               *resource_name;
+	apr_pool_t                    *pool;
+};
+
+/** Declaration of remote bridge channel */
+struct remote_bridge_channel_t {
+	remote_bridge_engine_t *bridge;
+	mrcp_engine_channel_t  *channel;
+
+	/* used by the task of the connections */
+	/** Connection the stream of the channel is multiplexed over */
+	remote_connection_t    *connection;
+	/** Stream id (0, if no stream is open) */
+	apr_uint32_t            stream_id;
+	/** Credits of DATA of the stream granted by the remote */
+	apr_int32_t             send_window;
+	/** Request the response of which is awaited */
+	mrcp_message_t         *request;
+	/** Request in progress */
+	mrcp_message_t         *active_request;
+
+	/** Audio frames (recognizer: media -> task, synthesizer: task -> media) */
+	apt_shm_ring_t         *audio_ring;
+	/** A message to flush audio or to grant window is in flight */
+	volatile apr_uint32_t   signal_pending;
+#ifdef REMOTE_BRIDGE_SYNTHESIZER
+	/** Size of the frames the audio is split into */
+	volatile apr_uint32_t   frame_size;
+	/** Tail of the latest DATA not making up a frame */
+	char                   *carry;
+	apr_size_t              carry_size;
+	/** Bytes played out, not granted back to the remote yet (media -> task) */
+	volatile apr_uint32_t   consumed;
+	/** Buffered audio is to be dropped (task -> media) */
+	volatile apr_uint32_t   discard;
+	/** Completion event held until the buffered audio is played out (task -> media) */
+	volatile void          *complete_event;
+#else
+	/** Frames written since the latest flush (media) */
+	apr_size_t              frame_count;
+	/** Frames dropped, as the remote did not keep up (media) */
+	apr_size_t              dropped;
+#endif
+};
+
+typedef enum {
+	REMOTE_BRIDGE_MSG_CONNECT,
+	REMOTE_BRIDGE_MSG_DISCONNECT,
+	REMOTE_BRIDGE_MSG_OPEN_CHANNEL,
+	REMOTE_BRIDGE_MSG_CLOSE_CHANNEL,
+	REMOTE_BRIDGE_MSG_REQUEST_PROCESS,
+	REMOTE_BRIDGE_MSG_AUDIO_FLUSH,
+	REMOTE_BRIDGE_MSG_WINDOW_UPDATE
+} remote_bridge_msg_type_e;
+
+/** Declaration of task message */
+struct remote_bridge_msg_t {
+	remote_bridge_msg_type_e  type;
+	remote_bridge_channel_t  *bridge_channel;
+	mrcp_message_t           *request;
+};
+
+static apt_bool_t remote_bridge_msg_signal(remote_bridge_engine_t *bridge, remote_bridge_msg_type_e type, remote_bridge_channel_t *bridge_channel, mrcp_message_t *request);
+static apt_bool_t remote_bridge_msg_process(apt_task_t *task, apt_task_msg_t *msg);
+static apt_bool_t remote_bridge_poller_signal_process(void *obj, const apr_pollfd_t *descriptor);
+static void remote_connection_reconnect_timer_proc(apt_timer_t *timer, void *obj);
+
+/** Declare this macro to set plugin version */
+MRCP_PLUGIN_VERSION_DECLARE
+
+/** Declare this macro to use log routine of the server, plugin is loaded from */
+MRCP_PLUGIN_LOGGER_IMPLEMENT
+
+/** Create remote bridge engine */
+MRCP_PLUGIN_DECLARE(mrcp_engine_t*) mrcp_plugin_create(apr_pool_t *pool)
+{
+	mrcp_resource_loader_t *resource_loader;
+	mrcp_resource_t *resource;
+	remote_bridge_engine_t *bridge = apr_palloc(pool,sizeof(remote_bridge_engine_t));
+	bridge->task = NULL;
+	bridge->connections = NULL;
+	bridge->connection_count = 0;
+	bridge->sockaddr = NULL;
+	bridge->batch_frames = REMOTE_BRIDGE_BATCH_FRAMES;
+	bridge->window_size = REMOTE_BRIDGE_WINDOW_SIZE;
+	bridge->max_frame_size = REMOTE_BRIDGE_MAX_FRAME_SIZE;
+	bridge->pool = pool;
+
+	/* messages of the remote are parsed by a factory of the plugin's own, no factory is passed to engines */
+	resource_loader = mrcp_resource_loader_create(FALSE,pool);
+	if(!resource_loader || mrcp_resource_load_by_id(resource_loader,REMOTE_BRIDGE_RESOURCE) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Load Resource of Remote Bridge");
+		return NULL;
+	}
+	bridge->resource_factory = mrcp_resource_factory_get(resource_loader);
+	resource = mrcp_resource_get(bridge->resource_factory,REMOTE_BRIDGE_RESOURCE);
+	if(!resource) {
+		return NULL;
+	}
+	bridge->resource_name = &resource->name;
+
+	/* create engine base */
+	bridge->engine = mrcp_engine_create(
+				REMOTE_BRIDGE_RESOURCE,    /* MRCP resource identifier */
+				bridge,                    /* object to associate */
+				&engine_vtable,            /* virtual methods table of engine */
+				pool);                     /* pool to allocate memory from */
+	return bridge->engine;
+}
+
+/** Get numeric engine param */
+static apr_size_t remote_bridge_param_get(const mrcp_engine_t *engine, const char *name, apr_size_t default_value)
+{
+	const char *value = mrcp_engine_param_get(engine,name);
+	if(value) {
+		apr_size_t number = (apr_size_t)atol(value);
+		if(number) {
+			return number;
+		}
+	}
+	return default_value;
+}
+
+/** Destroy engine */
+static apt_bool_t remote_bridge_engine_destroy(mrcp_engine_t *engine)
+{
+	remote_bridge_engine_t *bridge = engine->obj;
+	if(bridge->task) {
+		apt_poller_task_destroy(bridge->task);
+		bridge->task = NULL;
+	}
+	return TRUE;
+}
+
+/** Open engine */
+static apt_bool_t remote_bridge_engine_open(mrcp_engine_t *engine)
+{
+	remote_bridge_engine_t *bridge = engine->obj;
+	apt_task_t *task;
+	apt_task_vtable_t *vtable;
+	apt_task_msg_pool_t *msg_pool;
+	const char *address = mrcp_engine_param_get(engine,"address");
+	apr_port_t port = (apr_port_t)remote_bridge_param_get(engine,"port",0);
+	apr_size_t i;
+
+	if(!address || !port) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Address of Remote Engine [%s]",engine->id);
+		return mrcp_engine_open_respond(engine,FALSE);
+	}
+	if(apr_sockaddr_info_get(&bridge->sockaddr,address,APR_UNSPEC,port,0,bridge->pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Resolve Address of Remote Engine [%s] %s:%hu",engine->id,address,port);
+		return mrcp_engine_open_respond(engine,FALSE);
+	}
+	bridge->connection_count = remote_bridge_param_get(engine,"connections",REMOTE_BRIDGE_CONNECTIONS);
+	bridge->batch_frames = remote_bridge_param_get(engine,"batch-frames",REMOTE_BRIDGE_BATCH_FRAMES);
+	bridge->window_size = (apr_uint32_t)remote_bridge_param_get(engine,"window-size",REMOTE_BRIDGE_WINDOW_SIZE);
+	if(bridge->window_size > 0x7FFFFFFF) {
+		bridge->window_size = 0x7FFFFFFF;
+	}
+	bridge->max_frame_size = remote_bridge_param_get(engine,"max-frame-size",REMOTE_BRIDGE_MAX_FRAME_SIZE);
+	if(bridge->max_frame_size > 0xFFFFFF) {
+		bridge->max_frame_size = 0xFFFFFF;
+	}
+
+	if(!bridge->task) {
+		msg_pool = apt_task_msg_pool_create_dynamic(sizeof(remote_bridge_msg_t),bridge->pool);
+		bridge->task = apt_poller_task_create(
+						bridge->connection_count,
+						remote_bridge_poller_signal_process,
+						bridge,
+						msg_pool,
+						bridge->pool);
+		if(!bridge->task) {
+			return mrcp_engine_open_respond(engine,FALSE);
+		}
+		task = apt_poller_task_base_get(bridge->task);
+		if(task) {
+			apt_task_name_set(task,engine->id);
+		}
+		vtable = apt_poller_task_vtable_get(bridge->task);
+		if(vtable) {
+			vtable->process_msg = remote_bridge_msg_process;
+		}
+
+		bridge->connections = apr_pcalloc(bridge->pool,sizeof(remote_connection_t) * bridge->connection_count);
+		for(i=0; i<bridge->connection_count; i++) {
+			remote_connection_t *connection = &bridge->connections[i];
+			connection->bridge = bridge;
+			connection->index = i;
+			connection->pool = bridge->pool;
+			connection->streams = apr_hash_make(connection->pool);
+			connection->rx_capacity = FRAME_HEADER_SIZE + bridge->max_frame_size;
+			connection->rx_buffer = apr_palloc(connection->pool,connection->rx_capacity);
+			connection->tx_buffer = apr_palloc(connection->pool,REMOTE_BRIDGE_TX_BUFFER_SIZE);
+			connection->parser = mrcp_parser_create(bridge->resource_factory,connection->pool);
+			mrcp_parser_resource_set(connection->parser,bridge->resource_name);
+			connection->reconnect_timer = apt_poller_task_timer_create(
+											bridge->task,
+											remote_connection_reconnect_timer_proc,
+											connection,
+											connection->pool);
+			connection->reconnect_delay = REMOTE_BRIDGE_RECONNECT_DELAY;
+		}
+	}
+
+	apt_poller_task_start(bridge->task);
+	/* connections are set up by the task, channels are refused until one is up */
+	remote_bridge_msg_signal(bridge,REMOTE_BRIDGE_MSG_CONNECT,NULL,NULL);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Open Remote Bridge [%s] %s:%hu [%"APR_SIZE_T_FMT"] Connections",
+		engine->id,address,port,bridge->connection_count);
+	return mrcp_engine_open_respond(engine,TRUE);
+}
+
+/** Close engine */
+static apt_bool_t remote_bridge_engine_close(mrcp_engine_t *engine)
+{
+	remote_bridge_engine_t *bridge = engine->obj;
+	if(bridge->task) {
+		/* channels are closed by now, the connections are closed in the context of the task */
+		remote_bridge_msg_signal(bridge,REMOTE_BRIDGE_MSG_DISCONNECT,NULL,NULL);
+		apt_poller_task_terminate(bridge->task);
+	}
+	return mrcp_engine_close_respond(engine);
+}
+
+static mrcp_engine_channel_t* remote_bridge_engine_channel_create(mrcp_engine_t *engine, apr_pool_t *pool)
+{
+	mpf_stream_capabilities_t *capabilities;
+	mpf_termination_t *termination;
+	apr_size_t ring_capacity;
+	remote_bridge_engine_t *bridge = engine->obj;
+	remote_bridge_channel_t *bridge_channel = apr_palloc(pool,sizeof(remote_bridge_channel_t));
+	bridge_channel->bridge = bridge;
+	bridge_channel->connection = NULL;
+	bridge_channel->stream_id = 0;
+	bridge_channel->send_window = 0;
+	bridge_channel->request = NULL;
+	bridge_channel->active_request = NULL;
+	bridge_channel->signal_pending = 0;
+
+#ifdef REMOTE_BRIDGE_SYNTHESIZER
+	/* the window granted to the remote is held, framing overhead aside */
+	ring_capacity = 2 * bridge->window_size;
+	bridge_channel->frame_size = 0;
+	/* a frame of the highest sampling rate supported */
+	bridge_channel->carry = apr_palloc(pool,mpf_codec_linear_frame_size_calculate(16000,1));
+	bridge_channel->carry_size = 0;
+	bridge_channel->consumed = 0;
+	bridge_channel->discard = 0;
+	bridge_channel->complete_event = NULL;
+	capabilities = mpf_source_stream_capabilities_create(pool);
+#else
+	/* frames of a second or so are held, while the remote does not grant window */
+	ring_capacity = 64 * 1024;
+	bridge_channel->frame_count = 0;
+	bridge_channel->dropped = 0;
+	capabilities = mpf_sink_stream_capabilities_create(pool);
+#endif
+	bridge_channel->audio_ring = apt_shm_ring_create(apr_palloc(pool,apt_shm_ring_size_get(ring_capacity)),ring_capacity);
+
+	mpf_codec_capabilities_add(
+			&capabilities->codecs,
+			MPF_SAMPLE_RATE_8000 | MPF_SAMPLE_RATE_16000,
+			"LPCM");
+
+	/* create media termination */
+	termination = mrcp_engine_audio_termination_create(
+			bridge_channel,       /* object to associate */
+			&audio_stream_vtable, /* virtual methods table of audio stream */
+			capabilities,         /* stream capabilities */
+			pool);                /* pool to allocate memory from */
+
+	/* create engine channel base */
+	bridge_channel->channel = mrcp_engine_channel_create(
+			engine,               /* engine */
+			&channel_vtable,      /* virtual methods table of engine channel */
+			bridge_channel,       /* object to associate */
+			termination,          /* associated media termination */
+			pool);                /* pool to allocate memory from */
+	return bridge_channel->channel;
+}
+
+/** Destroy engine channel */
+static apt_bool_t remote_bridge_channel_destroy(mrcp_engine_channel_t *channel)
+{
+	/* the stream is closed by now */
+	return TRUE;
+}
+
+/** Open engine channel (asynchronous response MUST be sent)*/
+static apt_bool_t remote_bridge_channel_open(mrcp_engine_channel_t *channel)
+{
+	remote_bridge_channel_t *bridge_channel = channel->method_obj;
+	return remote_bridge_msg_signal(bridge_channel->bridge,REMOTE_BRIDGE_MSG_OPEN_CHANNEL,bridge_channel,NULL);
+}
+
+/** Close engine channel (asynchronous response MUST be sent)*/
+static apt_bool_t remote_bridge_channel_close(mrcp_engine_channel_t *channel)
+{
+	remote_bridge_channel_t *bridge_channel = channel->method_obj;
+	return remote_bridge_msg_signal(bridge_channel->bridge,REMOTE_BRIDGE_MSG_CLOSE_CHANNEL,bridge_channel,NULL);
+}
+
+/** Process MRCP channel request (asynchronous response MUST be sent)*/
+static apt_bool_t remote_bridge_channel_request_process(mrcp_engine_channel_t *channel, mrcp_message_t *request)
+{
+	remote_bridge_channel_t *bridge_channel = channel->method_obj;
+	return remote_bridge_msg_signal(bridge_channel->bridge,REMOTE_BRIDGE_MSG_REQUEST_PROCESS,bridge_channel,request);
+}
+
+#ifdef REMOTE_BRIDGE_SYNTHESIZER
+/** Callback is called from MPF engine context to perform any action before open */
+static apt_bool_t remote_bridge_stream_open(mpf_audio_stream_t *stream, mpf_codec_t *codec)
+{
+	remote_bridge_channel_t *bridge_channel = stream->obj;
+	const mpf_codec_descriptor_t *descriptor = stream->rx_descriptor;
+	if(descriptor) {
+		apr_atomic_set32(&bridge_channel->frame_size,
+			(apr_uint32_t)mpf_codec_linear_frame_size_calculate(descriptor->sampling_rate,descriptor->channel_count));
+	}
+	return TRUE;
+}
+
+/** Callback is called from MPF engine context to read/receive new frame */
+static apt_bool_t remote_bridge_stream_read(mpf_audio_stream_t *stream, mpf_frame_t *frame)
+{
+	remote_bridge_channel_t *bridge_channel = stream->obj;
+	const char *record;
+	apr_size_t size;
+	if(apr_atomic_read32(&bridge_channel->discard)) {
+		/* the speech is stopped, the buffered audio is not played out */
+		apr_atomic_set32(&bridge_channel->discard,0);
+		apt_shm_ring_discard(bridge_channel->audio_ring);
+	}
+
+	record = apt_shm_ring_peek(bridge_channel->audio_ring,&size);
+	if(record) {
+		if(size > frame->codec_frame.size) {
+			size = frame->codec_frame.size;
+		}
+		memcpy(frame->codec_frame.buffer,record,size);
+		frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+		apt_shm_ring_release(bridge_channel->audio_ring);
+
+		/* the played out audio is granted back to the remote in chunks of half a window */
+		if(apr_atomic_add32(&bridge_channel->consumed,(apr_uint32_t)size) + size >= bridge_channel->bridge->window_size / 2 &&
+			apr_atomic_cas32(&bridge_channel->signal_pending,1,0) == 0) {
+			remote_bridge_msg_signal(bridge_channel->bridge,REMOTE_BRIDGE_MSG_WINDOW_UPDATE,bridge_channel,NULL);
+		}
+		return TRUE;
+	}
+
+	if(bridge_channel->complete_event) {
+		/* the speech is played out, complete the request */
+		mrcp_message_t *message = (mrcp_message_t*)apr_atomic_xchgptr(&bridge_channel->complete_event,NULL);
+		if(message) {
+			mrcp_engine_channel_message_send(bridge_channel->channel,message);
+		}
+	}
+	return TRUE;
+}
+#else
+/** Callback is called from MPF engine context to write/send new frame */
+static apt_bool_t remote_bridge_stream_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame)
+{
+	remote_bridge_channel_t *bridge_channel = stream->obj;
+	if(!(frame->type & MEDIA_FRAME_TYPE_AUDIO) || !frame->codec_frame.size) {
+		return TRUE;
+	}
+
+	if(apt_shm_ring_write(bridge_channel->audio_ring,frame->codec_frame.buffer,frame->codec_frame.size,NULL,0) == FALSE) {
+		/* the remote does not grant window, rather drop the audio than stall the media processing */
+		if(bridge_channel->dropped++ == 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Drop Audio of Remote Stream [%s]: no window",bridge_channel->channel->id.buf);
+		}
+	}
+	else {
+		bridge_channel->dropped = 0;
+	}
+
+	if(++bridge_channel->frame_count >= bridge_channel->bridge->batch_frames) {
+		bridge_channel->frame_count = 0;
+		if(apr_atomic_cas32(&bridge_channel->signal_pending,1,0) == 0) {
+			remote_bridge_msg_signal(bridge_channel->bridge,REMOTE_BRIDGE_MSG_AUDIO_FLUSH,bridge_channel,NULL);
+		}
+	}
+	return TRUE;
+}
+#endif
+
+static apt_bool_t remote_bridge_msg_signal(remote_bridge_engine_t *bridge, remote_bridge_msg_type_e type, remote_bridge_channel_t *bridge_channel, mrcp_message_t *request)
+{
+	apt_task_t *task = apt_poller_task_base_get(bridge->task);
+	apt_task_msg_t *task_msg = apt_task_msg_get(task);
+	if(task_msg) {
+		remote_bridge_msg_t *msg = (remote_bridge_msg_t*)task_msg->data;
+		msg->type = type;
+		msg->bridge_channel = bridge_channel;
+		msg->request = request;
+		return apt_task_msg_signal(task,task_msg);
+	}
+	return FALSE;
+}
+
+
+/* ------------------ context of the task of the connections ------------------ */
+
+static APR_INLINE void frame_header_compose(char *buf, apr_size_t length, apr_byte_t type, apr_byte_t flags, apr_uint32_t stream_id)
+{
+	buf[0] = (char)((length >> 16) & 0xFF);
+	buf[1] = (char)((length >> 8) & 0xFF);
+	buf[2] = (char)(length & 0xFF);
+	buf[3] = (char)type;
+	buf[4] = (char)flags;
+	buf[5] = (char)((stream_id >> 24) & 0x7F);
+	buf[6] = (char)((stream_id >> 16) & 0xFF);
+	buf[7] = (char)((stream_id >> 8) & 0xFF);
+	buf[8] = (char)(stream_id & 0xFF);
+}
+
+static APR_INLINE apr_uint32_t uint32_get(const char *buf)
+{
+	const unsigned char *b = (const unsigned char*)buf;
+	return ((apr_uint32_t)b[0] << 24) | ((apr_uint32_t)b[1] << 16) | ((apr_uint32_t)b[2] << 8) | b[3];
+}
+
+static APR_INLINE void uint32_set(char *buf, apr_uint32_t value)
+{
+	buf[0] = (char)((value >> 24) & 0xFF);
+	buf[1] = (char)((value >> 16) & 0xFF);
+	buf[2] = (char)((value >> 8) & 0xFF);
+	buf[3] = (char)(value & 0xFF);
+}
+
+/** Get space for a frame of the payload size in the tx buffer */
+static char* remote_connection_frame_reserve(remote_connection_t *connection, apr_size_t payload_size)
+{
+	apr_size_t size = FRAME_HEADER_SIZE + payload_size;
+	if(connection->tx_length + size > REMOTE_BRIDGE_TX_BUFFER_SIZE) {
+		if(connection->tx_offset) {
+			/* scroll the pending data to the start of the buffer */
+			memmove(connection->tx_buffer,connection->tx_buffer + connection->tx_offset,connection->tx_length - connection->tx_offset);
+			connection->tx_length -= connection->tx_offset;
+			connection->tx_offset = 0;
+		}
+		if(connection->tx_length + size > REMOTE_BRIDGE_TX_BUFFER_SIZE) {
+			return NULL;
+		}
+	}
+	return connection->tx_buffer + connection->tx_length;
+}
+
+/** Queue frame to send */
+static apt_bool_t remote_connection_frame_send(remote_connection_t *connection, apr_byte_t type, apr_byte_t flags, apr_uint32_t stream_id, const char *payload, apr_size_t size)
+{
+	char *buf = remote_connection_frame_reserve(connection,size);
+	if(!buf) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Tx Buffer of Remote Connection [%"APR_SIZE_T_FMT"] Is Full",connection->index);
+		return FALSE;
+	}
+	frame_header_compose(buf,size,type,flags,stream_id);
+	if(size) {
+		memcpy(buf + FRAME_HEADER_SIZE,payload,size);
+	}
+	connection->tx_length += FRAME_HEADER_SIZE + size;
+	return TRUE;
+}
+
+/** Queue WINDOW_UPDATE */
+static APR_INLINE apt_bool_t remote_connection_window_update(remote_connection_t *connection, apr_uint32_t stream_id, apr_uint32_t increment)
+{
+	char payload[4];
+	uint32_set(payload,increment & 0x7FFFFFFF);
+	return remote_connection_frame_send(connection,FRAME_TYPE_WINDOW_UPDATE,0,stream_id,payload,sizeof(payload));
+}
+
+/** Poll the socket for writability while tx data is pending */
+static void remote_connection_pollout_set(remote_connection_t *connection)
+{
+	apr_int16_t reqevents = APR_POLLIN;
+	if(connection->tx_length > connection->tx_offset) {
+		reqevents |= APR_POLLOUT;
+	}
+	if(connection->sock_pfd.reqevents == reqevents) {
+		return;
+	}
+	apt_poller_task_descriptor_remove(connection->bridge->task,&connection->sock_pfd);
+	connection->sock_pfd.reqevents = reqevents;
+	apt_poller_task_descriptor_add(connection->bridge->task,&connection->sock_pfd);
+}
+
+static void remote_connection_close(remote_connection_t *connection);
+
+/** Send queued data, as much as the socket takes */
+static apt_bool_t remote_connection_flush(remote_connection_t *connection)
+{
+	apr_size_t length;
+	apr_status_t status;
+	if(!connection->sock) {
+		return FALSE;
+	}
+	while(connection->tx_length > connection->tx_offset) {
+		length = connection->tx_length - connection->tx_offset;
+		status = apr_socket_send(connection->sock,connection->tx_buffer + connection->tx_offset,&length);
+		connection->tx_offset += length;
+		if(status != APR_SUCCESS) {
+			if(APR_STATUS_IS_EAGAIN(status)) {
+				break;
+			}
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Send to Remote Connection [%"APR_SIZE_T_FMT"]",connection->index);
+			remote_connection_close(connection);
+			return FALSE;
+		}
+	}
+	if(connection->tx_offset == connection->tx_length) {
+		connection->tx_offset = connection->tx_length = 0;
+	}
+	remote_connection_pollout_set(connection);
+	return TRUE;
+}
+
+/** Send audio of the recognizer as the windows allow */
+static void remote_bridge_audio_send(remote_bridge_channel_t *bridge_channel)
+{
+#ifndef REMOTE_BRIDGE_SYNTHESIZER
+	remote_connection_t *connection = bridge_channel->connection;
+	apr_size_t max_size;
+	apr_size_t length;
+	apr_size_t size;
+	apr_size_t frames;
+	const char *record;
+	char *buf;
+	if(!connection || !connection->sock || !bridge_channel->stream_id) {
+		/* no stream, the frames are of no use */
+		while(apt_shm_ring_peek(bridge_channel->audio_ring,&size)) {
+			apt_shm_ring_release(bridge_channel->audio_ring);
+		}
+		return;
+	}
+
+	for(;;) {
+		max_size = connection->peer_max_frame_size;
+		if((apr_int32_t)max_size > bridge_channel->send_window) {
+			max_size = bridge_channel->send_window > 0 ? bridge_channel->send_window : 0;
+		}
+		if((apr_int32_t)max_size > connection->send_window) {
+			max_size = connection->send_window > 0 ? connection->send_window : 0;
+		}
+		record = apt_shm_ring_peek(bridge_channel->audio_ring,&size);
+		if(!record || size > max_size) {
+			/* the rest waits for WINDOW_UPDATE (or for the next flush) */
+			break;
+		}
+		buf = remote_connection_frame_reserve(connection,max_size);
+		if(!buf) {
+			break;
+		}
+
+		/* batch the frames into a single DATA frame */
+		length = 0;
+		frames = 0;
+		do {
+			memcpy(buf + FRAME_HEADER_SIZE + length,record,size);
+			length += size;
+			apt_shm_ring_release(bridge_channel->audio_ring);
+			frames++;
+			record = apt_shm_ring_peek(bridge_channel->audio_ring,&size);
+		}
+		while(record && length + size <= max_size);
+
+		frame_header_compose(buf,length,FRAME_TYPE_DATA,0,bridge_channel->stream_id);
+		connection->tx_length += FRAME_HEADER_SIZE + length;
+		bridge_channel->send_window -= (apr_int32_t)length;
+		connection->send_window -= (apr_int32_t)length;
+	}
+	remote_connection_flush(connection);
+#endif
+}
+
+/** Find the channel of the stream */
+static APR_INLINE remote_bridge_channel_t* remote_connection_stream_find(remote_connection_t *connection, apr_uint32_t stream_id)
+{
+	return apr_hash_get(connection->streams,&stream_id,sizeof(stream_id));
+}
+
+/** Complete the requests of the stream with failure */
+static void remote_bridge_channel_fail(remote_bridge_channel_t *bridge_channel)
+{
+	mrcp_message_t *message;
+	if(bridge_channel->request) {
+		message = mrcp_response_create(bridge_channel->request,bridge_channel->request->pool);
+		message->start_line.status_code = MRCP_STATUS_CODE_METHOD_FAILED;
+		mrcp_engine_channel_message_send(bridge_channel->channel,message);
+		bridge_channel->request = NULL;
+	}
+	if(bridge_channel->active_request) {
+#ifdef REMOTE_BRIDGE_SYNTHESIZER
+		mrcp_synth_header_t *synth_header;
+		message = mrcp_event_create(bridge_channel->active_request,SYNTHESIZER_SPEAK_COMPLETE,bridge_channel->active_request->pool);
+		synth_header = mrcp_resource_header_prepare(message);
+		if(synth_header) {
+			synth_header->completion_cause = SYNTHESIZER_COMPLETION_CAUSE_ERROR;
+			mrcp_resource_header_property_add(message,SYNTHESIZER_HEADER_COMPLETION_CAUSE);
+		}
+#else
+		mrcp_recog_header_t *recog_header;
+		message = mrcp_event_create(bridge_channel->active_request,RECOGNIZER_RECOGNITION_COMPLETE,bridge_channel->active_request->pool);
+		recog_header = mrcp_resource_header_prepare(message);
+		if(recog_header) {
+			recog_header->completion_cause = RECOGNIZER_COMPLETION_CAUSE_ERROR;
+			mrcp_resource_header_property_add(message,RECOGNIZER_HEADER_COMPLETION_CAUSE);
+		}
+#endif
+		message->start_line.request_state = MRCP_REQUEST_STATE_COMPLETE;
+		mrcp_engine_channel_message_send(bridge_channel->channel,message);
+		bridge_channel->active_request = NULL;
+	}
+}
+
+/** Detach the channel from its stream */
+static void remote_bridge_stream_remove(remote_bridge_channel_t *bridge_channel)
+{
+	remote_connection_t *connection = bridge_channel->connection;
+	if(connection && bridge_channel->stream_id) {
+		apr_hash_set(connection->streams,&bridge_channel->stream_id,sizeof(bridge_channel->stream_id),NULL);
+	}
+	bridge_channel->connection = NULL;
+	bridge_channel->stream_id = 0;
+}
+
+/** Close connection, fail its streams and schedule reconnect */
+static void remote_connection_close(remote_connection_t *connection)
+{
+	apr_hash_index_t *it;
+	void *val;
+	remote_bridge_channel_t *bridge_channel;
+	if(connection->sock) {
+		apt_poller_task_descriptor_remove(connection->bridge->task,&connection->sock_pfd);
+		apr_socket_close(connection->sock);
+		connection->sock = NULL;
+	}
+	connection->usable = FALSE;
+	connection->rx_length = 0;
+	connection->tx_offset = connection->tx_length = 0;
+
+	it = apr_hash_first(connection->pool,connection->streams);
+	for(; it; it = apr_hash_next(it)) {
+		apr_hash_this(it,NULL,NULL,&val);
+		bridge_channel = val;
+		bridge_channel->connection = NULL;
+		bridge_channel->stream_id = 0;
+		remote_bridge_channel_fail(bridge_channel);
+	}
+	apr_hash_clear(connection->streams);
+
+	if(connection->reconnect_timer && connection->bridge->engine->is_open == TRUE) {
+		apt_timer_set(connection->reconnect_timer,connection->reconnect_delay);
+		/* back off, while the remote is down */
+		connection->reconnect_delay *= 2;
+		if(connection->reconnect_delay > REMOTE_BRIDGE_RECONNECT_MAX) {
+			connection->reconnect_delay = REMOTE_BRIDGE_RECONNECT_MAX;
+		}
+	}
+}
+
+/** Connect to the remote */
+static apt_bool_t remote_connection_connect(remote_connection_t *connection)
+{
+	remote_bridge_engine_t *bridge = connection->bridge;
+	char settings[12];
+	if(connection->sock) {
+		return TRUE;
+	}
+	if(apr_socket_create(&connection->sock,bridge->sockaddr->family,SOCK_STREAM,APR_PROTO_TCP,connection->pool) != APR_SUCCESS) {
+		connection->sock = NULL;
+		return FALSE;
+	}
+	apr_socket_opt_set(connection->sock,APR_SO_NONBLOCK,0);
+	apr_socket_timeout_set(connection->sock,REMOTE_BRIDGE_CONNECT_TIMEOUT);
+	apr_socket_opt_set(connection->sock,APR_TCP_NODELAY,1);
+	if(apr_socket_connect(connection->sock,bridge->sockaddr) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Connect Remote Connection [%"APR_SIZE_T_FMT"] of [%s]",
+			connection->index,bridge->engine->id);
+		apr_socket_close(connection->sock);
+		connection->sock = NULL;
+		remote_connection_close(connection);
+		return FALSE;
+	}
+	apr_socket_opt_set(connection->sock,APR_SO_NONBLOCK,1);
+	apr_socket_timeout_set(connection->sock,0);
+
+	connection->sock_pfd.desc_type = APR_POLL_SOCKET;
+	connection->sock_pfd.reqevents = APR_POLLIN;
+	connection->sock_pfd.desc.s = connection->sock;
+	connection->sock_pfd.client_data = connection;
+	if(apt_poller_task_descriptor_add(bridge->task,&connection->sock_pfd) != TRUE) {
+		apr_socket_close(connection->sock);
+		connection->sock = NULL;
+		remote_connection_close(connection);
+		return FALSE;
+	}
+
+	connection->usable = TRUE;
+	connection->next_stream_id = 1;
+	connection->send_window = DEFAULT_WINDOW_SIZE;
+	connection->peer_window = DEFAULT_WINDOW_SIZE;
+	connection->peer_max_frame_size = 16384;
+	connection->reconnect_delay = REMOTE_BRIDGE_RECONNECT_DELAY;
+	connection->rx_length = 0;
+	connection->tx_offset = connection->tx_length = 0;
+
+	memcpy(connection->tx_buffer,bridge_preface,sizeof(bridge_preface) - 1);
+	connection->tx_length = sizeof(bridge_preface) - 1;
+	settings[0] = 0;
+	settings[1] = SETTINGS_INITIAL_WINDOW_SIZE;
+	uint32_set(settings + 2,bridge->window_size);
+	settings[6] = 0;
+	settings[7] = SETTINGS_MAX_FRAME_SIZE;
+	uint32_set(settings + 8,(apr_uint32_t)bridge->max_frame_size);
+	remote_connection_frame_send(connection,FRAME_TYPE_SETTINGS,0,0,settings,sizeof(settings));
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Connected Remote Connection [%"APR_SIZE_T_FMT"] of [%s]",connection->index,bridge->engine->id);
+	return remote_connection_flush(connection);
+}
+
+static void remote_connection_reconnect_timer_proc(apt_timer_t *timer, void *obj)
+{
+	remote_connection_t *connection = obj;
+	if(connection->bridge->engine->is_open == TRUE) {
+		remote_connection_connect(connection);
+	}
+}
+
+/** Open stream of the channel over the least loaded connection */
+static apt_bool_t remote_bridge_stream_open_process(remote_bridge_engine_t *bridge, remote_bridge_channel_t *bridge_channel)
+{
+	remote_connection_t *connection = NULL;
+	const mpf_codec_descriptor_t *descriptor;
+	char *headers;
+	apr_size_t i;
+	for(i=0; i<bridge->connection_count; i++) {
+		remote_connection_t *candidate = &bridge->connections[i];
+		if(candidate->sock && candidate->usable == TRUE &&
+			(!connection || apr_hash_count(candidate->streams) < apr_hash_count(connection->streams))) {
+			connection = candidate;
+		}
+	}
+	if(!connection) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Remote Connection Available [%s]",bridge->engine->id);
+		return FALSE;
+	}
+
+#ifdef REMOTE_BRIDGE_SYNTHESIZER
+	descriptor = mrcp_engine_source_stream_codec_get(bridge_channel->channel);
+#else
+	descriptor = mrcp_engine_sink_stream_codec_get(bridge_channel->channel);
+#endif
+	headers = apr_psprintf(bridge_channel->channel->pool,
+				"Resource: %s\r\nChannel-Identifier: %s\r\nSampling-Rate: %d\r\n",
+				bridge->resource_name->buf,
+				bridge_channel->channel->id.buf ? bridge_channel->channel->id.buf : "",
+				descriptor ? descriptor->sampling_rate : 8000);
+	if(remote_connection_frame_send(connection,FRAME_TYPE_HEADERS,FRAME_FLAG_END_HEADERS,connection->next_stream_id,headers,strlen(headers)) == FALSE) {
+		return FALSE;
+	}
+
+	bridge_channel->connection = connection;
+	bridge_channel->stream_id = connection->next_stream_id;
+	bridge_channel->send_window = connection->peer_window;
+	apr_hash_set(connection->streams,&bridge_channel->stream_id,sizeof(bridge_channel->stream_id),bridge_channel);
+	/* streams initiated by the client are odd */
+	connection->next_stream_id += 2;
+	if(connection->next_stream_id > 0x7FFFFFFF) {
+		/* ids are exhausted, new streams go over a new connection */
+		connection->usable = FALSE;
+	}
+	return remote_connection_flush(connection);
+}
+
+/** Close stream of the channel */
+static void remote_bridge_stream_close_process(remote_bridge_channel_t *bridge_channel)
+{
+	remote_connection_t *connection = bridge_channel->connection;
+	if(connection && connection->sock) {
+		remote_connection_frame_send(connection,FRAME_TYPE_DATA,FRAME_FLAG_END_STREAM,bridge_channel->stream_id,NULL,0);
+		remote_connection_flush(connection);
+	}
+	remote_bridge_stream_remove(bridge_channel);
+	/* no response is expected from the remote, once the stream is closed */
+	bridge_channel->request = NULL;
+	bridge_channel->active_request = NULL;
+#ifdef REMOTE_BRIDGE_SYNTHESIZER
+	bridge_channel->carry_size = 0;
+	apr_atomic_xchgptr(&bridge_channel->complete_event,NULL);
+#endif
+}
+
+/** Pass request to the remote */
+static void remote_bridge_request_process(remote_bridge_channel_t *bridge_channel, mrcp_message_t *request)
+{
+	remote_connection_t *connection = bridge_channel->connection;
+	apt_text_stream_t stream;
+	const apt_str_t *body;
+	apr_size_t head_size;
+	mrcp_message_t *response;
+	char *buf;
+
+	if(!connection || !connection->sock) {
+		response = mrcp_response_create(request,request->pool);
+		response->start_line.status_code = MRCP_STATUS_CODE_METHOD_FAILED;
+		mrcp_engine_channel_message_send(bridge_channel->channel,response);
+		return;
+	}
+
+	body = mrcp_message_body_flatten(request);
+	buf = remote_connection_frame_reserve(connection,MESSAGE_HEAD_SIZE + (body ? body->length : 0));
+	if(buf) {
+		apt_text_stream_init(&stream,buf + FRAME_HEADER_SIZE,MESSAGE_HEAD_SIZE);
+		if(mrcp_message_generate(NULL,request,&stream) == FALSE) {
+			buf = NULL;
+		}
+	}
+	if(!buf) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Pass Request to Remote "APT_SIDRES_FMT,MRCP_MESSAGE_SIDRES(request));
+		response = mrcp_response_create(request,request->pool);
+		response->start_line.status_code = MRCP_STATUS_CODE_METHOD_FAILED;
+		mrcp_engine_channel_message_send(bridge_channel->channel,response);
+		return;
+	}
+
+	head_size = stream.pos - stream.text.buf;
+	if(body && body->length) {
+		memmove(buf + FRAME_HEADER_SIZE + head_size,body->buf,body->length);
+		head_size += body->length;
+	}
+	frame_header_compose(buf,head_size,FRAME_TYPE_MESSAGE,0,bridge_channel->stream_id);
+	connection->tx_length += FRAME_HEADER_SIZE + head_size;
+	bridge_channel->request = request;
+#ifdef REMOTE_BRIDGE_SYNTHESIZER
+	if(request->start_line.method_id == SYNTHESIZER_STOP || request->start_line.method_id == SYNTHESIZER_BARGE_IN_OCCURRED) {
+		/* the audio of the speech to stop is not played out */
+		apr_atomic_set32(&bridge_channel->discard,1);
+		bridge_channel->carry_size = 0;
+	}
+#endif
+	remote_connection_flush(connection);
+}
+
+/** Process message of the remote */
+static void remote_bridge_message_process(remote_connection_t *connection, remote_bridge_channel_t *bridge_channel, char *data, apr_size_t size)
+{
+	apt_text_stream_t stream;
+	mrcp_message_t *message = NULL;
+	apt_text_stream_init(&stream,data,size);
+	if(mrcp_parser_run(connection->parser,&stream,&message) != APT_MESSAGE_STATUS_COMPLETE || !message) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Parse Message of Remote Stream [%u]",bridge_channel->stream_id);
+		/* start over with a parser in the initial state */
+		connection->parser = mrcp_parser_create(connection->bridge->resource_factory,connection->pool);
+		mrcp_parser_resource_set(connection->parser,connection->bridge->resource_name);
+		return;
+	}
+
+	if(message->start_line.message_type == MRCP_MESSAGE_TYPE_RESPONSE) {
+		if(bridge_channel->request && message->start_line.request_state == MRCP_REQUEST_STATE_INPROGRESS) {
+			bridge_channel->active_request = bridge_channel->request;
+		}
+		bridge_channel->request = NULL;
+	}
+	else if(message->start_line.message_type == MRCP_MESSAGE_TYPE_EVENT &&
+		message->start_line.request_state == MRCP_REQUEST_STATE_COMPLETE) {
+		bridge_channel->active_request = NULL;
+#ifdef REMOTE_BRIDGE_SYNTHESIZER
+		if(message->start_line.method_id == SYNTHESIZER_SPEAK_COMPLETE) {
+			/* complete once the speech received so far is played out */
+			apr_atomic_xchgptr(&bridge_channel->complete_event,message);
+			return;
+		}
+#endif
+	}
+	mrcp_engine_channel_message_send(bridge_channel->channel,message);
+}
+
+#ifdef REMOTE_BRIDGE_SYNTHESIZER
+/** Split DATA of the remote into frames of the synthesizer */
+static void remote_bridge_audio_receive(remote_bridge_channel_t *bridge_channel, const char *data, apr_size_t size)
+{
+	apr_size_t frame_size = apr_atomic_read32(&bridge_channel->frame_size);
+	apr_size_t part;
+	if(!frame_size) {
+		/* the stream is not open yet */
+		frame_size = mpf_codec_linear_frame_size_calculate(8000,1);
+	}
+	if(bridge_channel->carry_size) {
+		part = frame_size - bridge_channel->carry_size;
+		if(part > size) {
+			part = size;
+		}
+		memcpy(bridge_channel->carry + bridge_channel->carry_size,data,part);
+		bridge_channel->carry_size += part;
+		data += part;
+		size -= part;
+		if(bridge_channel->carry_size < frame_size) {
+			return;
+		}
+		apt_shm_ring_write(bridge_channel->audio_ring,bridge_channel->carry,frame_size,NULL,0);
+		bridge_channel->carry_size = 0;
+	}
+	while(size >= frame_size) {
+		if(apt_shm_ring_write(bridge_channel->audio_ring,data,frame_size,NULL,0) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Drop Audio of Remote Stream [%u]: window exceeded",bridge_channel->stream_id);
+			return;
+		}
+		data += frame_size;
+		size -= frame_size;
+	}
+	if(size) {
+		memcpy(bridge_channel->carry,data,size);
+		bridge_channel->carry_size = size;
+	}
+}
+#endif
+
+/** Process SETTINGS of the remote */
+static void remote_connection_settings_process(remote_connection_t *connection, const char *payload, apr_size_t size)
+{
+	apr_size_t pos;
+	apr_uint32_t value;
+	for(pos = 0; pos + 6 <= size; pos += 6) {
+		value = uint32_get(payload + pos + 2);
+		switch((((unsigned char)payload[pos]) << 8) | (unsigned char)payload[pos + 1]) {
+			case SETTINGS_INITIAL_WINDOW_SIZE:
+			{
+				apr_hash_index_t *it;
+				void *val;
+				apr_int32_t delta = (apr_int32_t)value - connection->peer_window;
+				connection->peer_window = (apr_int32_t)value;
+				/* the change applies to the open streams too */
+				for(it = apr_hash_first(connection->pool,connection->streams); it; it = apr_hash_next(it)) {
+					apr_hash_this(it,NULL,NULL,&val);
+					((remote_bridge_channel_t*)val)->send_window += delta;
+				}
+				break;
+			}
+			case SETTINGS_MAX_FRAME_SIZE:
+				if(value >= 16384 && value <= 0xFFFFFF) {
+					connection->peer_max_frame_size = value;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	remote_connection_frame_send(connection,FRAME_TYPE_SETTINGS,FRAME_FLAG_ACK,0,NULL,0);
+}
+
+/** Process frame of the remote, return FALSE on protocol error */
+static apt_bool_t remote_connection_frame_process(remote_connection_t *connection, apr_byte_t type, apr_byte_t flags, apr_uint32_t stream_id, char *payload, apr_size_t size)
+{
+	remote_bridge_channel_t *bridge_channel = NULL;
+	if(stream_id) {
+		bridge_channel = remote_connection_stream_find(connection,stream_id);
+	}
+
+	switch(type) {
+		case FRAME_TYPE_DATA:
+			if(size) {
+				/* the connection window is returned right away, the data is buffered per stream */
+				remote_connection_window_update(connection,0,(apr_uint32_t)size);
+			}
+			if(!bridge_channel) {
+				break;
+			}
+#ifdef REMOTE_BRIDGE_SYNTHESIZER
+			remote_bridge_audio_receive(bridge_channel,payload,size);
+#endif
+			break;
+		case FRAME_TYPE_MESSAGE:
+			if(bridge_channel) {
+				remote_bridge_message_process(connection,bridge_channel,payload,size);
+			}
+			break;
+		case FRAME_TYPE_WINDOW_UPDATE:
+			if(size != 4) {
+				return FALSE;
+			}
+			if(!stream_id) {
+				apr_hash_index_t *it;
+				void *val;
+				connection->send_window += (apr_int32_t)(uint32_get(payload) & 0x7FFFFFFF);
+				/* the streams stalled by the connection window resume */
+				for(it = apr_hash_first(connection->pool,connection->streams); it; it = apr_hash_next(it)) {
+					apr_hash_this(it,NULL,NULL,&val);
+					remote_bridge_audio_send(val);
+				}
+			}
+			else if(bridge_channel) {
+				bridge_channel->send_window += (apr_int32_t)(uint32_get(payload) & 0x7FFFFFFF);
+				remote_bridge_audio_send(bridge_channel);
+			}
+			break;
+		case FRAME_TYPE_RST_STREAM:
+			if(bridge_channel) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Remote Stream [%u] Reset [%u]",stream_id,size >= 4 ? uint32_get(payload) : 0);
+				remote_bridge_stream_remove(bridge_channel);
+				remote_bridge_channel_fail(bridge_channel);
+			}
+			break;
+		case FRAME_TYPE_SETTINGS:
+			if(!(flags & FRAME_FLAG_ACK)) {
+				remote_connection_settings_process(connection,payload,size);
+			}
+			break;
+		case FRAME_TYPE_PING:
+			if(!(flags & FRAME_FLAG_ACK)) {
+				remote_connection_frame_send(connection,FRAME_TYPE_PING,FRAME_FLAG_ACK,0,payload,size);
+			}
+			break;
+		case FRAME_TYPE_GOAWAY:
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Remote Connection [%"APR_SIZE_T_FMT"] Goes Away",connection->index);
+			/* the open streams are served to the end, new ones go over other connections */
+			connection->usable = FALSE;
+			if(!apr_hash_count(connection->streams)) {
+				remote_connection_close(connection);
+			}
+			break;
+		default:
+			/* unknown frames are ignored */
+			break;
+	}
+	return TRUE;
+}
+
+/** Receive and process frames of the remote */
+static void remote_connection_receive(remote_connection_t *connection)
+{
+	apr_size_t length;
+	apr_size_t offset;
+	apr_size_t size;
+	apr_status_t status;
+	const unsigned char *header;
+
+	for(;;) {
+		length = connection->rx_capacity - connection->rx_length;
+		status = apr_socket_recv(connection->sock,connection->rx_buffer + connection->rx_length,&length);
+		if(APR_STATUS_IS_EAGAIN(status)) {
+			break;
+		}
+		if(status != APR_SUCCESS || length == 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Remote Connection [%"APR_SIZE_T_FMT"] Disconnected",connection->index);
+			remote_connection_close(connection);
+			return;
+		}
+		connection->rx_length += length;
+
+		offset = 0;
+		while(connection->rx_length - offset >= FRAME_HEADER_SIZE) {
+			header = (const unsigned char*)connection->rx_buffer + offset;
+			size = ((apr_size_t)header[0] << 16) | ((apr_size_t)header[1] << 8) | header[2];
+			if(size > connection->bridge->max_frame_size) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Too Large Frame [%"APR_SIZE_T_FMT" bytes] of Remote Connection [%"APR_SIZE_T_FMT"]",
+					size,connection->index);
+				remote_connection_close(connection);
+				return;
+			}
+			if(connection->rx_length - offset < FRAME_HEADER_SIZE + size) {
+				break;
+			}
+			if(remote_connection_frame_process(
+					connection,
+					header[3],
+					header[4],
+					uint32_get((const char*)header + 5) & 0x7FFFFFFF,
+					connection->rx_buffer + offset + FRAME_HEADER_SIZE,
+					size) == FALSE) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Protocol Error of Remote Connection [%"APR_SIZE_T_FMT"]",connection->index);
+				remote_connection_close(connection);
+				return;
+			}
+			if(!connection->sock) {
+				/* closed by GOAWAY */
+				return;
+			}
+			offset += FRAME_HEADER_SIZE + size;
+		}
+		if(offset) {
+			/* scroll the partial frame to the start of the buffer */
+			memmove(connection->rx_buffer,connection->rx_buffer + offset,connection->rx_length - offset);
+			connection->rx_length -= offset;
+		}
+	}
+	remote_connection_flush(connection);
+}
+
+static apt_bool_t remote_bridge_poller_signal_process(void *obj, const apr_pollfd_t *descriptor)
+{
+	remote_connection_t *connection = descriptor->client_data;
+	if(!connection || !connection->sock) {
+		return FALSE;
+	}
+
+	if(descriptor->rtnevents & APR_POLLOUT) {
+		if(remote_connection_flush(connection) == FALSE) {
+			return TRUE;
+		}
+	}
+	if(descriptor->rtnevents & (APR_POLLIN | APR_POLLHUP | APR_POLLERR)) {
+		remote_connection_receive(connection);
+	}
+	return TRUE;
+}
+
+static apt_bool_t remote_bridge_msg_process(apt_task_t *task, apt_task_msg_t *task_msg)
+{
+	apt_poller_task_t *poller_task = apt_task_object_get(task);
+	remote_bridge_engine_t *bridge = apt_poller_task_object_get(poller_task);
+	remote_bridge_msg_t *msg = (remote_bridge_msg_t*)task_msg->data;
+	remote_bridge_channel_t *bridge_channel = msg->bridge_channel;
+	apr_size_t i;
+
+	switch(msg->type) {
+		case REMOTE_BRIDGE_MSG_CONNECT:
+			for(i=0; i<bridge->connection_count; i++) {
+				remote_connection_connect(&bridge->connections[i]);
+			}
+			break;
+		case REMOTE_BRIDGE_MSG_DISCONNECT:
+			for(i=0; i<bridge->connection_count; i++) {
+				remote_connection_t *connection = &bridge->connections[i];
+				if(connection->sock) {
+					remote_connection_frame_send(connection,FRAME_TYPE_GOAWAY,0,0,"\0\0\0\0\0\0\0\0",8);
+					remote_connection_flush(connection);
+				}
+				remote_connection_close(connection);
+				/* no reconnect, the engine is closed */
+				apt_timer_kill(connection->reconnect_timer);
+			}
+			break;
+		case REMOTE_BRIDGE_MSG_OPEN_CHANNEL:
+			mrcp_engine_channel_open_respond(bridge_channel->channel,remote_bridge_stream_open_process(bridge,bridge_channel));
+			break;
+		case REMOTE_BRIDGE_MSG_CLOSE_CHANNEL:
+			remote_bridge_stream_close_process(bridge_channel);
+			mrcp_engine_channel_close_respond(bridge_channel->channel);
+			break;
+		case REMOTE_BRIDGE_MSG_REQUEST_PROCESS:
+			remote_bridge_request_process(bridge_channel,msg->request);
+			break;
+		case REMOTE_BRIDGE_MSG_AUDIO_FLUSH:
+			apr_atomic_set32(&bridge_channel->signal_pending,0);
+			remote_bridge_audio_send(bridge_channel);
+			break;
+		case REMOTE_BRIDGE_MSG_WINDOW_UPDATE:
+#ifdef REMOTE_BRIDGE_SYNTHESIZER
+			apr_atomic_set32(&bridge_channel->signal_pending,0);
+			if(bridge_channel->connection && bridge_channel->connection->sock) {
+				apr_uint32_t increment = apr_atomic_xchg32(&bridge_channel->consumed,0);
+				if(increment) {
+					remote_connection_window_update(bridge_channel->connection,bridge_channel->stream_id,increment);
+					remote_connection_flush(bridge_channel->connection);
+				}
+			}
+#endif
+			break;
+	}
+	return TRUE;
+}
@@ -0,0 +1,576 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <ctype.h>
+#include <apr_time.h>
+#include <apr_atomic.h>
+#include <apr_thread_proc.h>
+#include "apt_test_suite.h"
+#include "apt_cyclic_queue.h"
+#include "apt_timer_queue.h"
+#include "apt_consumer_task.h"
+#include "apt_text_stream.h"
+#include "apt_string_table.h"
+#include "apt_log.h"
+
+#define DEFAULT_ITERATIONS 100000
+/* operations timed together, the clock has microsecond resolution */
+#define BENCH_BATCH_SIZE   64
+#define BENCH_QUEUE_SIZE   1024
+#define BENCH_TIMER_COUNT  10000
+#define BENCH_MSG_POOL_SIZE 256
+
+/** Benchmarked primitives */
+typedef enum {
+	BENCH_CYCLIC_QUEUE,
+	BENCH_TIMER_QUEUE,
+	BENCH_TASK_MSG,
+	BENCH_MSG_POOL,
+	BENCH_HEADER_PARSE,
+	BENCH_STRING_TABLE,
+	BENCH_UNIQUE_ID,
+
+	BENCH_COUNT
+} bench_type_e;
+
+static const char *bench_names[BENCH_COUNT] = {
+	"cyclic-queue",
+	"timer-queue",
+	"task-msg",
+	"msg-pool",
+	"header-parse",
+	"string-table",
+	"unique-id"
+};
+
+/** Latency samples of a benchmark */
+typedef struct {
+	/** Latency per operation of each sample (nsec) */
+	apr_uint64_t *samples;
+	apr_size_t    count;
+	apr_size_t    max_count;
+	/** Number of operations */
+	apr_uint64_t  op_count;
+	/** Time spent by the operations (usec) */
+	apr_time_t    elapsed_time;
+} bench_stat_t;
+
+/** Message of the round-trip benchmark */
+typedef struct {
+	/** Flag set by the task once the message is processed */
+	volatile apr_uint32_t *processed;
+} bench_msg_data_t;
+
+/** MRCP header block the parser is run on */
+static const char bench_header_block[] =
+	"Channel-Identifier: 32AECB23433801@speechrecog\r\n"
+	"Content-Type: application/srgs+xml\r\n"
+	"Content-Id: request1@form-level.store\r\n"
+	"Cancel-If-Queue: false\r\n"
+	"No-Input-Timeout: 5000\r\n"
+	"Recognition-Timeout: 10000\r\n"
+	"Confidence-Threshold: 0.5\r\n"
+	"Sensitivity-Level: 0.5\r\n"
+	"Speed-Vs-Accuracy: 0.5\r\n"
+	"Start-Input-Timers: true\r\n"
+	"Vendor-Specific-Parameters: com.example.param1=value1;com.example.param2=value2\r\n"
+	"Content-Length: 104\r\n"
+	"\r\n";
+
+/** Header names the string table is looked up by */
+static apt_str_table_item_t bench_table[] = {
+	{{"Active-Request-Id-List",22},0},
+	{{"Proxy-Sync-Id",13},0},
+	{{"Accept-Charset",14},0},
+	{{"Content-Type",12},0},
+	{{"Content-Id",10},0},
+	{{"Content-Base",12},0},
+	{{"Content-Encoding",16},0},
+	{{"Content-Location",16},0},
+	{{"Content-Length",14},0},
+	{{"Cache-Control",13},0},
+	{{"Logging-Tag",11},0},
+	{{"Vendor-Specific-Parameters",26},0},
+	{{"Accept",6},0},
+	{{"Fetch-Timeout",13},0},
+	{{"Set-Cookie",10},0},
+	{{"Set-Cookie2",11},0},
+	{{"Confidence-Threshold",20},0},
+	{{"Sensitivity-Level",17},0},
+	{{"Speed-Vs-Accuracy",17},0},
+	{{"N-Best-List-Length",18},0},
+	{{"No-Input-Timeout",16},0},
+	{{"Recognition-Timeout",19},0},
+	{{"Cancel-If-Queue",15},0},
+	{{"Start-Input-Timers",18},0}
+};
+
+#define BENCH_TABLE_SIZE (sizeof(bench_table) / sizeof(bench_table[0]))
+
+static void bench_stat_init(bench_stat_t *stat, apr_size_t max_count, apr_pool_t *pool)
+{
+	stat->samples = apr_palloc(pool,sizeof(apr_uint64_t) * max_count);
+	stat->count = 0;
+	stat->max_count = max_count;
+	stat->op_count = 0;
+	stat->elapsed_time = 0;
+}
+
+static APR_INLINE void bench_stat_add(bench_stat_t *stat, apr_time_t elapsed_time, apr_size_t op_count)
+{
+	if(!op_count) {
+		return;
+	}
+	if(stat->count < stat->max_count) {
+		stat->samples[stat->count++] = (apr_uint64_t)elapsed_time * 1000 / op_count;
+	}
+	stat->op_count += op_count;
+	stat->elapsed_time += elapsed_time;
+}
+
+static int bench_sample_compare(const void *p1, const void *p2)
+{
+	apr_uint64_t v1 = *(const apr_uint64_t*)p1;
+	apr_uint64_t v2 = *(const apr_uint64_t*)p2;
+	return v1 < v2 ? -1 : (v1 > v2 ? 1 : 0);
+}
+
+static void bench_stat_print(apt_test_suite_t *suite, const char *name, bench_stat_t *stat)
+{
+	apr_uint64_t p50 = 0;
+	apr_uint64_t p99 = 0;
+	apr_uint64_t max = 0;
+	double throughput;
+	if(stat->count) {
+		qsort(stat->samples,stat->count,sizeof(apr_uint64_t),bench_sample_compare);
+		p50 = stat->samples[stat->count / 2];
+		p99 = stat->samples[stat->count * 99 / 100];
+		max = stat->samples[stat->count - 1];
+	}
+	throughput = stat->elapsed_time ? (double)stat->op_count * APR_USEC_PER_SEC / stat->elapsed_time : 0.0;
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"[%-20s] %10.0f ops/s, latency %"APR_UINT64_T_FMT" / %"APR_UINT64_T_FMT" / %"APR_UINT64_T_FMT" nsec p50/p99/max",
+		name,
+		throughput,
+		p50,
+		p99,
+		max);
+	apt_test_result_add(suite,name,"throughput",throughput,"ops/s");
+	apt_test_result_add(suite,name,"p50",(double)p50,"ns");
+	apt_test_result_add(suite,name,"p99",(double)p99,"ns");
+}
+
+static apr_uint32_t bench_random(apr_uint32_t *seed, apr_uint32_t range)
+{
+	*seed = *seed * 1664525 + 1013904223;
+	return (*seed >> 8) % range;
+}
+
+/** Push and pop batches through a queue of fixed capacity */
+static apt_bool_t bench_cyclic_queue_run(apt_test_suite_t *suite, apr_size_t iterations, apr_pool_t *pool)
+{
+	apt_cyclic_queue_t *queue = apt_cyclic_queue_create_fixed(BENCH_QUEUE_SIZE);
+	bench_stat_t stat;
+	apr_size_t i;
+	apr_size_t j;
+	apr_size_t mismatch = 0;
+	if(!queue) {
+		return FALSE;
+	}
+
+	bench_stat_init(&stat,iterations / BENCH_BATCH_SIZE + 1,pool);
+	for(i=0; i<iterations; i+=BENCH_BATCH_SIZE) {
+		apr_time_t start_time = apr_time_now();
+		for(j=0; j<BENCH_BATCH_SIZE; j++) {
+			apt_cyclic_queue_push(queue,(void*)(bench_table + j % BENCH_TABLE_SIZE));
+		}
+		for(j=0; j<BENCH_BATCH_SIZE; j++) {
+			if(apt_cyclic_queue_pop(queue) != (void*)(bench_table + j % BENCH_TABLE_SIZE)) {
+				mismatch++;
+			}
+		}
+		bench_stat_add(&stat,apr_time_now() - start_time,2 * BENCH_BATCH_SIZE);
+	}
+	apt_cyclic_queue_destroy(queue);
+	bench_stat_print(suite,"cyclic-queue push/pop",&stat);
+	if(mismatch) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Order of Queue [%"APR_SIZE_T_FMT"]",mismatch);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void bench_timer_proc(apt_timer_t *timer, void *obj)
+{
+	apr_size_t *elapsed = obj;
+	(*elapsed)++;
+}
+
+/** Set, kill and advance timers at the scale of loaded server */
+static apt_bool_t bench_timer_queue_run(apt_test_suite_t *suite, apr_size_t iterations, apr_pool_t *pool)
+{
+	apt_timer_queue_t *queue = apt_timer_queue_create(pool);
+	apt_timer_t **timers;
+	bench_stat_t set_stat;
+	bench_stat_t kill_stat;
+	bench_stat_t advance_stat;
+	apr_size_t elapsed = 0;
+	apr_size_t rounds = iterations / BENCH_TIMER_COUNT + 1;
+	apr_uint32_t seed = 1;
+	apr_size_t round;
+	apr_size_t i;
+	apr_size_t j;
+	if(!queue) {
+		return FALSE;
+	}
+
+	timers = apr_palloc(pool,sizeof(apt_timer_t*) * BENCH_TIMER_COUNT);
+	for(i=0; i<BENCH_TIMER_COUNT; i++) {
+		timers[i] = apt_timer_create(queue,bench_timer_proc,&elapsed,pool);
+	}
+
+	bench_stat_init(&set_stat,rounds * BENCH_TIMER_COUNT / BENCH_BATCH_SIZE + 1,pool);
+	bench_stat_init(&kill_stat,rounds * BENCH_TIMER_COUNT / BENCH_BATCH_SIZE + 1,pool);
+	bench_stat_init(&advance_stat,rounds * 1000,pool);
+	for(round=0; round<rounds; round++) {
+		/* set all the timers within 60 sec */
+		for(i=0; i<BENCH_TIMER_COUNT; i+=BENCH_BATCH_SIZE) {
+			apr_size_t count = BENCH_TIMER_COUNT - i < BENCH_BATCH_SIZE ? BENCH_TIMER_COUNT - i : BENCH_BATCH_SIZE;
+			apr_uint32_t timeouts[BENCH_BATCH_SIZE];
+			apr_time_t start_time;
+			for(j=0; j<count; j++) {
+				timeouts[j] = 1 + bench_random(&seed,60000);
+			}
+			start_time = apr_time_now();
+			for(j=0; j<count; j++) {
+				apt_timer_set(timers[i + j],timeouts[j]);
+			}
+			bench_stat_add(&set_stat,apr_time_now() - start_time,count);
+		}
+		/* advance by a second in steps of 1 msec, as the task does */
+		for(i=0; i<1000; i++) {
+			apr_time_t start_time = apr_time_now();
+			apt_timer_queue_advance(queue,1);
+			bench_stat_add(&advance_stat,apr_time_now() - start_time,1);
+		}
+		/* kill the timers left (most of them, as requests complete before timeouts) */
+		for(i=0; i<BENCH_TIMER_COUNT; i+=BENCH_BATCH_SIZE) {
+			apr_size_t count = BENCH_TIMER_COUNT - i < BENCH_BATCH_SIZE ? BENCH_TIMER_COUNT - i : BENCH_BATCH_SIZE;
+			apr_time_t start_time = apr_time_now();
+			for(j=0; j<count; j++) {
+				apt_timer_kill(timers[i + j]);
+			}
+			bench_stat_add(&kill_stat,apr_time_now() - start_time,count);
+		}
+	}
+	bench_stat_print(suite,"timer set",&set_stat);
+	bench_stat_print(suite,"timer kill",&kill_stat);
+	bench_stat_print(suite,"timer advance 1 ms",&advance_stat);
+
+	if(apt_timer_queue_is_empty(queue) == FALSE || !elapsed) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected State of Timer Queue [%"APR_SIZE_T_FMT" elapsed]",elapsed);
+		apt_timer_queue_destroy(queue);
+		return FALSE;
+	}
+	apt_timer_queue_destroy(queue);
+	return TRUE;
+}
+
+static apt_bool_t bench_task_msg_process(apt_task_t *task, apt_task_msg_t *msg)
+{
+	bench_msg_data_t *data = (bench_msg_data_t*)msg->data;
+	apr_atomic_set32(data->processed,1);
+	return TRUE;
+}
+
+/** Round-trip of a message signalled to the task thread and processed there */
+static apt_bool_t bench_task_msg_run(apt_test_suite_t *suite, apr_size_t iterations, apr_pool_t *pool)
+{
+	apt_task_msg_pool_t *msg_pool = apt_task_msg_pool_create_static(sizeof(bench_msg_data_t),BENCH_MSG_POOL_SIZE,pool);
+	apt_consumer_task_t *consumer_task;
+	apt_task_t *task;
+	apt_task_vtable_t *vtable;
+	volatile apr_uint32_t processed;
+	bench_stat_t stat;
+	apr_size_t count = iterations / 10 + 1;
+	apr_size_t i;
+
+	consumer_task = apt_consumer_task_create(NULL,msg_pool,pool);
+	if(!consumer_task) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Consumer Task");
+		return FALSE;
+	}
+	task = apt_consumer_task_base_get(consumer_task);
+	vtable = apt_task_vtable_get(task);
+	if(vtable) {
+		vtable->process_msg = bench_task_msg_process;
+	}
+	if(apt_task_start(task) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Start Task");
+		apt_task_destroy(task);
+		return FALSE;
+	}
+
+	bench_stat_init(&stat,count,pool);
+	for(i=0; i<count; i++) {
+		apt_task_msg_t *msg = apt_task_msg_acquire(msg_pool);
+		bench_msg_data_t *data = (bench_msg_data_t*)msg->data;
+		apr_time_t start_time;
+		msg->type = TASK_MSG_USER;
+		data->processed = &processed;
+		apr_atomic_set32(&processed,0);
+
+		start_time = apr_time_now();
+		apt_task_msg_signal(task,msg);
+		while(!apr_atomic_read32(&processed)) {
+			apr_thread_yield();
+		}
+		bench_stat_add(&stat,apr_time_now() - start_time,1);
+	}
+
+	apt_task_terminate(task,TRUE);
+	apt_task_destroy(task);
+	bench_stat_print(suite,"task msg round-trip",&stat);
+	return TRUE;
+}
+
+/** Acquire and release batches of messages */
+static apt_bool_t bench_msg_pool_pass(apt_test_suite_t *suite, const char *name, apt_task_msg_pool_t *msg_pool, apr_size_t iterations, apr_pool_t *pool)
+{
+	apt_task_msg_t *msgs[BENCH_BATCH_SIZE];
+	bench_stat_t stat;
+	apr_size_t i;
+	apr_size_t j;
+
+	bench_stat_init(&stat,iterations / BENCH_BATCH_SIZE + 1,pool);
+	for(i=0; i<iterations; i+=BENCH_BATCH_SIZE) {
+		apr_time_t start_time = apr_time_now();
+		for(j=0; j<BENCH_BATCH_SIZE; j++) {
+			msgs[j] = apt_task_msg_acquire(msg_pool);
+		}
+		for(j=0; j<BENCH_BATCH_SIZE; j++) {
+			apt_task_msg_release(msgs[j]);
+		}
+		bench_stat_add(&stat,apr_time_now() - start_time,2 * BENCH_BATCH_SIZE);
+	}
+	bench_stat_print(suite,name,&stat);
+	return TRUE;
+}
+
+static apt_bool_t bench_msg_pool_run(apt_test_suite_t *suite, apr_size_t iterations, apr_pool_t *pool)
+{
+	apt_task_msg_pool_t *msg_pool;
+
+	msg_pool = apt_task_msg_pool_create_static(sizeof(bench_msg_data_t),BENCH_MSG_POOL_SIZE,pool);
+	bench_msg_pool_pass(suite,"msg-pool static",msg_pool,iterations,pool);
+	apt_task_msg_pool_destroy(msg_pool);
+
+	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(bench_msg_data_t),pool);
+	bench_msg_pool_pass(suite,"msg-pool dynamic",msg_pool,iterations,pool);
+	apt_task_msg_pool_destroy(msg_pool);
+	return TRUE;
+}
+
+/** Read the header fields of a typical request */
+static apt_bool_t bench_header_parse_run(apt_test_suite_t *suite, apr_size_t iterations, apr_pool_t *pool)
+{
+	char *buffer = apr_pstrmemdup(pool,bench_header_block,sizeof(bench_header_block) - 1);
+	apt_text_stream_t stream;
+	apt_pair_t pair;
+	bench_stat_t stat;
+	apr_size_t field_count = 0;
+	apr_size_t i;
+	apr_size_t j;
+
+	apt_text_stream_init(&stream,buffer,sizeof(bench_header_block) - 1);
+	bench_stat_init(&stat,iterations / BENCH_BATCH_SIZE + 1,pool);
+	for(i=0; i<iterations; i+=BENCH_BATCH_SIZE) {
+		apr_time_t start_time = apr_time_now();
+		field_count = 0;
+		for(j=0; j<BENCH_BATCH_SIZE; j++) {
+			apt_text_stream_reset(&stream);
+			while(apt_text_header_read(&stream,&pair) == TRUE && pair.name.length) {
+				field_count++;
+			}
+		}
+		bench_stat_add(&stat,apr_time_now() - start_time,field_count);
+	}
+	bench_stat_print(suite,"header field read",&stat);
+	if(field_count != 12 * BENCH_BATCH_SIZE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Header Fields [%"APR_SIZE_T_FMT"]",field_count / BENCH_BATCH_SIZE);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Choose the key characters of the table, the way strtablegen does */
+static void bench_table_keys_generate(apt_str_table_item_t *table, apr_size_t size)
+{
+	apr_size_t i;
+	apr_size_t j;
+	apr_size_t key;
+	for(i=0; i<size; i++) {
+		/* no key by default, the whole string is compared */
+		table[i].key = table[i].value.length;
+		for(key=0; key<table[i].value.length; key++) {
+			apt_bool_t unique = TRUE;
+			for(j=0; j<size && unique == TRUE; j++) {
+				if(j != i && table[j].value.length == table[i].value.length &&
+					tolower(table[j].value.buf[key]) == tolower(table[i].value.buf[key])) {
+					unique = FALSE;
+				}
+			}
+			if(unique == TRUE) {
+				table[i].key = key;
+				break;
+			}
+		}
+	}
+}
+
+/** Look up the header names the way the parser does, mixing the case */
+static apt_bool_t bench_string_table_run(apt_test_suite_t *suite, apr_size_t iterations, apr_pool_t *pool)
+{
+	apt_str_t values[BENCH_TABLE_SIZE + 1];
+	bench_stat_t stat;
+	apr_size_t mismatch = 0;
+	apr_size_t i;
+	apr_size_t j;
+
+	bench_table_keys_generate(bench_table,BENCH_TABLE_SIZE);
+	for(i=0; i<BENCH_TABLE_SIZE; i++) {
+		char *buf = apr_pstrmemdup(pool,bench_table[i].value.buf,bench_table[i].value.length);
+		if(i % 2) {
+			for(j=0; j<bench_table[i].value.length; j++) {
+				buf[j] = (char)tolower(buf[j]);
+			}
+		}
+		values[i].buf = buf;
+		values[i].length = bench_table[i].value.length;
+	}
+	/* unknown (vendor) header is also looked up */
+	apt_string_set(&values[BENCH_TABLE_SIZE],"X-Vendor-Header");
+
+	bench_stat_init(&stat,iterations / BENCH_BATCH_SIZE + 1,pool);
+	for(i=0; i<iterations; i+=BENCH_BATCH_SIZE) {
+		apr_time_t start_time = apr_time_now();
+		for(j=0; j<BENCH_BATCH_SIZE; j++) {
+			apr_size_t index = (i + j) % (BENCH_TABLE_SIZE + 1);
+			if(apt_string_table_id_find(bench_table,BENCH_TABLE_SIZE,&values[index]) != index) {
+				mismatch++;
+			}
+		}
+		bench_stat_add(&stat,apr_time_now() - start_time,BENCH_BATCH_SIZE);
+	}
+	bench_stat_print(suite,"string table id find",&stat);
+	if(mismatch) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Ids Found [%"APR_SIZE_T_FMT"]",mismatch);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Generate session identifiers, checking consecutive ones differ */
+static apt_bool_t bench_unique_id_run(apt_test_suite_t *suite, apr_size_t iterations, apr_pool_t *pool)
+{
+	apt_str_t ids[BENCH_BATCH_SIZE];
+	bench_stat_t stat;
+	apr_size_t mismatch = 0;
+	apr_size_t i;
+	apr_size_t j;
+	apr_pool_t *id_pool;
+
+	apr_pool_create(&id_pool,pool);
+	bench_stat_init(&stat,iterations / BENCH_BATCH_SIZE + 1,pool);
+	for(i=0; i<iterations; i+=BENCH_BATCH_SIZE) {
+		apr_time_t start_time = apr_time_now();
+		for(j=0; j<BENCH_BATCH_SIZE; j++) {
+			apt_unique_id_generate(&ids[j],16,id_pool);
+		}
+		bench_stat_add(&stat,apr_time_now() - start_time,BENCH_BATCH_SIZE);
+		for(j=1; j<BENCH_BATCH_SIZE; j++) {
+			if(ids[j].length != 16 || apt_string_compare(&ids[j],&ids[j-1]) == TRUE) {
+				mismatch++;
+			}
+		}
+		apr_pool_clear(id_pool);
+	}
+	bench_stat_print(suite,"unique id generate",&stat);
+	if(mismatch) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Ids Generated [%"APR_SIZE_T_FMT"]",mismatch);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t bench_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apr_size_t iterations = DEFAULT_ITERATIONS;
+	apt_bool_t status = TRUE;
+	apt_bool_t found = FALSE;
+	const char *name = NULL;
+	apr_pool_t *pool;
+	int type;
+
+	if(argc > 0 && strcasecmp(argv[0],"all") != 0) {
+		name = argv[0];
+	}
+	if(argc > 1) {
+		iterations = atol(argv[1]);
+	}
+	if(!iterations) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Arguments: [cyclic-queue|timer-queue|task-msg|msg-pool|header-parse|string-table|unique-id|all] [iterations]");
+		return FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run %"APR_SIZE_T_FMT" Iterations",iterations);
+	for(type=0; type<BENCH_COUNT; type++) {
+		apt_bool_t result = FALSE;
+		if(name && strcasecmp(name,bench_names[type]) != 0) {
+			continue;
+		}
+		found = TRUE;
+		apr_pool_create(&pool,suite->pool);
+		switch(type) {
+			case BENCH_CYCLIC_QUEUE: result = bench_cyclic_queue_run(suite,iterations,pool); break;
+			case BENCH_TIMER_QUEUE:  result = bench_timer_queue_run(suite,iterations,pool); break;
+			case BENCH_TASK_MSG:     result = bench_task_msg_run(suite,iterations,pool); break;
+			case BENCH_MSG_POOL:     result = bench_msg_pool_run(suite,iterations,pool); break;
+			case BENCH_HEADER_PARSE: result = bench_header_parse_run(suite,iterations,pool); break;
+			case BENCH_STRING_TABLE: result = bench_string_table_run(suite,iterations,pool); break;
+			case BENCH_UNIQUE_ID:    result = bench_unique_id_run(suite,iterations,pool); break;
+			default: break;
+		}
+		apr_pool_destroy(pool);
+		if(result == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Benchmark Failed [%s]",bench_names[type]);
+			status = FALSE;
+		}
+	}
+	if(found == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Such Benchmark [%s]",name);
+		return FALSE;
+	}
+	return status;
+}
+
+apt_test_suite_t* bench_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"bench",NULL,bench_test_run);
+	return suite;
+}
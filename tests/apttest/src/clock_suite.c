@@ -0,0 +1,211 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include <apr_thread_proc.h>
+#include <apr_atomic.h>
+#include "apt_test_suite.h"
+#include "apt_clock.h"
+#include "apt_consumer_task.h"
+#include "apt_log.h"
+
+/* recognizer-like timeout, which takes no real time to expire on the simulated clock */
+#define TIMER_TIMEOUT     30000
+#define SLEEP_INTERVAL    (5 * APR_USEC_PER_SEC)
+#define ADVANCE_INTERVAL  (100 * 1000)
+#define MAX_ADVANCE_COUNT 10000
+
+/** State of the test of timers */
+typedef struct {
+	apt_timer_t          *timer;
+	/** Time of the clock the timer is set at */
+	apr_time_t            set_time;
+	/** Time of the clock the timer is fired at */
+	apr_time_t            fire_time;
+	volatile apr_uint32_t fired;
+} clock_timer_test_t;
+
+static void* APR_THREAD_FUNC clock_sleep_thread_proc(apr_thread_t *thread, void *data)
+{
+	apr_time_t *wake_time = data;
+	apt_clock_sleep(SLEEP_INTERVAL);
+	*wake_time = apt_clock_now();
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+/** Sleep on the clock standing still, while another thread advances it */
+static apt_bool_t clock_sleep_test(apt_clock_t *clock, apr_pool_t *pool)
+{
+	apr_thread_t *thread;
+	apr_status_t rv;
+	apr_time_t start_time;
+	apr_time_t wake_time = 0;
+	apr_size_t i;
+	apt_bool_t status;
+
+	start_time = apt_clock_now();
+	if(apr_thread_create(&thread,NULL,clock_sleep_thread_proc,&wake_time,pool) != APR_SUCCESS) {
+		return FALSE;
+	}
+	/* the sleeper must not be woken up by real time */
+	apr_sleep(10000);
+	status = wake_time == 0 ? TRUE : FALSE;
+	for(i=0; i<SLEEP_INTERVAL / ADVANCE_INTERVAL; i++) {
+		apt_sim_clock_advance(clock,ADVANCE_INTERVAL);
+	}
+	apr_thread_join(&rv,thread);
+
+	if(wake_time != start_time + SLEEP_INTERVAL || apt_clock_now() != wake_time) {
+		status = FALSE;
+	}
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"Sleep on Simulated Clock [%s]",
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+static void clock_timer_proc(apt_timer_t *timer, void *obj)
+{
+	clock_timer_test_t *test = obj;
+	test->fire_time = apt_clock_now();
+	apr_atomic_set32(&test->fired,1);
+}
+
+static apt_bool_t clock_timer_msg_process(apt_task_t *task, apt_task_msg_t *msg)
+{
+	apt_consumer_task_t *consumer_task = apt_task_object_get(task);
+	clock_timer_test_t *test = apt_consumer_task_object_get(consumer_task);
+	test->set_time = apt_clock_now();
+	apt_timer_set(test->timer,TIMER_TIMEOUT);
+	return TRUE;
+}
+
+/** Fire the timer of a consumer task on the clock standing still */
+static apt_bool_t clock_timer_test(apt_clock_t *clock, apr_pool_t *pool)
+{
+	apt_consumer_task_t *consumer_task;
+	apt_task_t *task;
+	apt_task_vtable_t *vtable;
+	apt_task_msg_pool_t *msg_pool;
+	apt_task_msg_t *msg;
+	clock_timer_test_t *test;
+	apr_size_t i;
+	apt_bool_t status;
+
+	test = apr_palloc(pool,sizeof(clock_timer_test_t));
+	test->set_time = 0;
+	test->fire_time = 0;
+	test->fired = 0;
+
+	msg_pool = apt_task_msg_pool_create_dynamic(0,pool);
+	consumer_task = apt_consumer_task_create(test,msg_pool,pool);
+	if(!consumer_task) {
+		return FALSE;
+	}
+	task = apt_consumer_task_base_get(consumer_task);
+	vtable = apt_task_vtable_get(task);
+	if(vtable) {
+		vtable->process_msg = clock_timer_msg_process;
+	}
+	test->timer = apt_consumer_task_timer_create(consumer_task,clock_timer_proc,test,pool);
+	if(!test->timer) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Skip Timer on Simulated Clock [not supported]");
+		apt_task_destroy(task);
+		return TRUE;
+	}
+	if(apt_task_start(task) == FALSE) {
+		apt_task_destroy(task);
+		return FALSE;
+	}
+
+	msg = apt_task_msg_acquire(msg_pool);
+	msg->type = TASK_MSG_USER;
+	apt_task_msg_signal(task,msg);
+
+	for(i=0; i<MAX_ADVANCE_COUNT && !apr_atomic_read32(&test->fired); i++) {
+		/* let the task take the message and wait for the timer */
+		apr_sleep(1000);
+		apt_sim_clock_advance(clock,ADVANCE_INTERVAL);
+	}
+	apt_task_terminate(task,TRUE);
+	apt_task_destroy(task);
+
+	status = (apr_atomic_read32(&test->fired) && test->set_time &&
+		/* the clock may be advanced by a step, while the message setting the timer is processed */
+		test->fire_time - test->set_time >= (apr_time_t)TIMER_TIMEOUT * 1000 - ADVANCE_INTERVAL) ? TRUE : FALSE;
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"Fire Timer [%d msec] on Simulated Clock in [%"APR_SIZE_T_FMT"] steps [%s]",
+		TIMER_TIMEOUT,i,
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+/** Sleep on the clock running faster than real time */
+static apt_bool_t clock_rate_test(apr_pool_t *pool)
+{
+	apr_time_t start_time;
+	apr_time_t real_time;
+	apt_bool_t status;
+	apt_clock_t *clock = apt_sim_clock_create(1000,pool);
+	if(!clock) {
+		return FALSE;
+	}
+
+	apt_clock_set(clock);
+	real_time = apr_time_now();
+	start_time = apt_clock_now();
+	apt_clock_sleep(SLEEP_INTERVAL);
+	status = (apt_clock_now() - start_time >= SLEEP_INTERVAL &&
+		apr_time_now() - real_time < SLEEP_INTERVAL / 10) ? TRUE : FALSE;
+	apt_clock_set(NULL);
+	apt_sim_clock_destroy(clock);
+
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"Sleep on Scaled Clock [%s]",
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+static apt_bool_t clock_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_bool_t status = TRUE;
+	apt_clock_t *clock = apt_sim_clock_create(0,suite->pool);
+	if(!clock) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Simulated Clock");
+		return FALSE;
+	}
+
+	apt_clock_set(clock);
+	if(clock_sleep_test(clock,suite->pool) == FALSE) {
+		status = FALSE;
+	}
+	if(clock_timer_test(clock,suite->pool) == FALSE) {
+		status = FALSE;
+	}
+	apt_clock_set(NULL);
+	apt_sim_clock_destroy(clock);
+
+	if(clock_rate_test(suite->pool) == FALSE) {
+		status = FALSE;
+	}
+	return status;
+}
+
+apt_test_suite_t* clock_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"clock",NULL,clock_test_run);
+	return suite;
+}
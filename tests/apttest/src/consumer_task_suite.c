@@ -17,6 +17,7 @@
  */
 
 #include <apr_time.h>
+#include <apr_atomic.h>
 #include "apt_test_suite.h"
 #include "apt_consumer_task.h"
 #include "apt_log.h"
@@ -26,6 +27,20 @@ typedef struct {
 	int        number;
 } sample_msg_data_t;
 
+#define WORKER_COUNT      4
+#define AFFINITY_KEY_COUNT 16
+#define WORKER_MSG_COUNT  1000
+
+/** State of the test of workers */
+typedef struct {
+	/** Last number processed per affinity key */
+	int                   last_number[AFFINITY_KEY_COUNT];
+	/** Number of messages processed out of order */
+	volatile apr_uint32_t disorder_count;
+	/** Number of messages processed */
+	volatile apr_uint32_t processed_count;
+} workers_test_t;
+
 static void task_on_start_complete(apt_task_t *task)
 {
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"On Task Start");
@@ -43,6 +58,120 @@ static apt_bool_t task_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 	return TRUE;
 }
 
+static apr_size_t task_msg_affinity_get(apt_consumer_task_t *task, const apt_task_msg_t *msg)
+{
+	const sample_msg_data_t *data = (const sample_msg_data_t*)msg->data;
+	/* key 0 is reserved for the task thread */
+	return data->number % AFFINITY_KEY_COUNT + 1;
+}
+
+static apt_bool_t workers_task_msg_process(apt_task_t *task, apt_task_msg_t *msg)
+{
+	apt_consumer_task_t *consumer_task = apt_task_object_get(task);
+	workers_test_t *test = apt_consumer_task_object_get(consumer_task);
+	sample_msg_data_t *data = (sample_msg_data_t*)msg->data;
+	int key = data->number % AFFINITY_KEY_COUNT;
+
+	/* messages of the same key must be processed by the same worker in order */
+	if(data->number <= test->last_number[key]) {
+		apr_atomic_inc32(&test->disorder_count);
+	}
+	test->last_number[key] = data->number;
+	apr_atomic_inc32(&test->processed_count);
+	return TRUE;
+}
+
+/** Check statistics of the messages processed by the task */
+static apt_bool_t consumer_task_stat_verify(const apt_task_t *task, apr_uint32_t min_count)
+{
+	apt_task_stat_t stat;
+	apr_uint32_t count = 0;
+	apr_size_t i;
+	apt_task_stat_get(task,&stat);
+	for(i=0; i<APT_TASK_HISTOGRAM_SIZE; i++) {
+		count += stat.process_histogram[i];
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Task Statistics messages [%u] queued [%u] max queued [%u] max wait [%u usec]",
+		stat.msg_count,stat.queue_depth,stat.max_queue_depth,stat.max_wait_time);
+	/* core messages are accounted too */
+	if(stat.msg_count < min_count || count != stat.msg_count || stat.queue_depth || !stat.max_queue_depth) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Task Statistics");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t consumer_task_workers_test_run(apt_test_suite_t *suite)
+{
+	apt_consumer_task_t *consumer_task;
+	apt_task_t *task;
+	apt_task_vtable_t *vtable;
+	apt_task_msg_pool_t *msg_pool;
+	apt_task_msg_t *msg;
+	sample_msg_data_t *data;
+	workers_test_t *test;
+	apt_bool_t status = TRUE;
+	int i;
+
+	test = apr_palloc(suite->pool,sizeof(workers_test_t));
+	for(i=0; i<AFFINITY_KEY_COUNT; i++) {
+		test->last_number[i] = -1;
+	}
+	test->disorder_count = 0;
+	test->processed_count = 0;
+
+	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(sample_msg_data_t),suite->pool);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Create Consumer Task [%d workers]",WORKER_COUNT);
+	consumer_task = apt_consumer_task_create(test,msg_pool,suite->pool);
+	if(!consumer_task) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Consumer Task");
+		return FALSE;
+	}
+	if(apt_consumer_task_workers_set(consumer_task,WORKER_COUNT,task_msg_affinity_get) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Set Workers");
+		return FALSE;
+	}
+	task = apt_consumer_task_base_get(consumer_task);
+	vtable = apt_task_vtable_get(task);
+	if(vtable) {
+		vtable->process_msg = workers_task_msg_process;
+	}
+
+	if(apt_task_start(task) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Start Task");
+		apt_task_destroy(task);
+		return FALSE;
+	}
+
+	for(i=0; i<WORKER_MSG_COUNT; i++) {
+		msg = apt_task_msg_acquire(msg_pool);
+		msg->type = TASK_MSG_USER;
+		data = (sample_msg_data_t*) msg->data;
+
+		data->number = i;
+		data->timestamp = apr_time_now();
+		apt_task_msg_signal(task,msg);
+	}
+
+	/* workers drain their queues before the task terminates */
+	apt_task_terminate(task,TRUE);
+
+	if(test->processed_count != WORKER_MSG_COUNT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Processed [%u] of [%d] Messages",
+			test->processed_count,WORKER_MSG_COUNT);
+		status = FALSE;
+	}
+	if(test->disorder_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Processed [%u] Messages out of Order",test->disorder_count);
+		status = FALSE;
+	}
+	if(consumer_task_stat_verify(task,WORKER_MSG_COUNT) == FALSE) {
+		status = FALSE;
+	}
+	apt_task_destroy(task);
+	return status;
+}
 
 static apt_bool_t consumer_task_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
 {
@@ -92,7 +221,7 @@ static apt_bool_t consumer_task_test_run(apt_test_suite_t *suite, int argc, cons
 	apt_task_terminate(task,TRUE);
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Destroy Task");
 	apt_task_destroy(task);
-	return TRUE;
+	return consumer_task_workers_test_run(suite);
 }
 
 apt_test_suite_t* consumer_task_test_suite_create(apr_pool_t *pool)
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include "apt_test_suite.h"
+#include "apt_cpu_set.h"
+#include "apt_log.h"
+
+/** CPU set to parse and the CPUs expected in the set */
+typedef struct {
+	const char *str;
+	apt_bool_t  status;
+	apr_size_t  count;
+	int         first;
+	int         last;
+} cpu_set_sample_t;
+
+static const cpu_set_sample_t cpu_set_samples[] = {
+	{"0",           TRUE,  1,   0,   0},
+	{"0-3",         TRUE,  4,   0,   3},
+	{"0-3,8",       TRUE,  5,   0,   8},
+	{"2, 4-5\n",    TRUE,  3,   2,   5},
+	{"63-64",       TRUE,  2,   63,  64},
+	{"255",         TRUE,  1,   255, 255},
+	{"",            FALSE, 0,   0,   0},
+	{"3-1",         FALSE, 0,   0,   0},
+	{"1-",          FALSE, 0,   0,   0},
+	{"a",           FALSE, 0,   0,   0},
+	{"256",         FALSE, 0,   0,   0},
+	{"node:x",      FALSE, 0,   0,   0}
+};
+
+static apt_bool_t cpu_set_sample_check(const cpu_set_sample_t *sample, apr_pool_t *pool)
+{
+	apt_cpu_set_t cpu_set;
+	apt_bool_t status = apt_cpu_set_parse(&cpu_set,sample->str,pool);
+	if(status != sample->status) {
+		return FALSE;
+	}
+	if(status == FALSE) {
+		return TRUE;
+	}
+	if(apt_cpu_set_count_get(&cpu_set) != sample->count ||
+		apt_cpu_set_contains(&cpu_set,sample->first) == FALSE ||
+		apt_cpu_set_contains(&cpu_set,sample->last) == FALSE ||
+		apt_cpu_set_contains(&cpu_set,sample->last + 1) == TRUE) {
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t cpu_set_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+	for(i=0; i<sizeof(cpu_set_samples)/sizeof(cpu_set_samples[0]); i++) {
+		if(cpu_set_sample_check(&cpu_set_samples[i],suite->pool) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected CPU Set [%s]",cpu_set_samples[i].str);
+			status = FALSE;
+		}
+	}
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"Parse CPU Sets [%s]",
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+apt_test_suite_t* cpu_set_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"cpu-set",NULL,cpu_set_test_run);
+	return suite;
+}
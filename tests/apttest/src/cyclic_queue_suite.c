@@ -0,0 +1,131 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+
+#include "apt_test_suite.h"
+#include "apt_cyclic_queue.h"
+#include "apt_log.h"
+
+#define QUEUE_SIZE    100
+#define ROUND_COUNT   1000
+
+static apt_bool_t cyclic_queue_fixed_test(apr_size_t *items)
+{
+	apt_cyclic_queue_t *queue = apt_cyclic_queue_create_fixed(QUEUE_SIZE);
+	apr_size_t capacity = apt_cyclic_queue_capacity_get(queue);
+	apr_size_t next_push = 0;
+	apr_size_t next_pop = 0;
+	apr_size_t round;
+	apr_size_t i;
+	apt_cyclic_queue_push_status_e push_status = CYCLIC_QUEUE_PUSH_OK;
+	apt_bool_t status = TRUE;
+
+	if(capacity < QUEUE_SIZE || (capacity & (capacity - 1))) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Capacity [%"APR_SIZE_T_FMT"]",capacity);
+		status = FALSE;
+	}
+
+	/* fill the queue up and drain half of it, so that positions wrap around */
+	for(round=0; round<ROUND_COUNT && status == TRUE; round++) {
+		for(;;) {
+			push_status = apt_cyclic_queue_try_push(queue,&items[next_push % capacity]);
+			if(push_status == CYCLIC_QUEUE_PUSH_FULL) {
+				break;
+			}
+			next_push++;
+		}
+		if(apt_cyclic_queue_size_get(queue) != capacity) {
+			status = FALSE;
+			break;
+		}
+		for(i=0; i<capacity/2; i++) {
+			apr_size_t *item = apt_cyclic_queue_pop(queue);
+			if(item != &items[next_pop % capacity]) {
+				status = FALSE;
+				break;
+			}
+			next_pop++;
+		}
+	}
+
+	if(status == TRUE && apt_cyclic_queue_overload_count_get(queue) != ROUND_COUNT) {
+		status = FALSE;
+	}
+	apt_cyclic_queue_destroy(queue);
+
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,
+		"Fixed Queue [%"APR_SIZE_T_FMT"] Pushed [%"APR_SIZE_T_FMT"] Popped [%"APR_SIZE_T_FMT"]: %s",
+		capacity,next_push,next_pop,
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+static apt_bool_t cyclic_queue_growable_test(apr_size_t *items, apr_size_t count)
+{
+	apt_cyclic_queue_t *queue = apt_cyclic_queue_create(CYCLIC_QUEUE_DEFAULT_SIZE);
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+
+	/* offset positions first, so that the queue is resized while wrapped around */
+	for(i=0; i<CYCLIC_QUEUE_DEFAULT_SIZE/2; i++) {
+		apt_cyclic_queue_push(queue,&items[i]);
+		apt_cyclic_queue_pop(queue);
+	}
+	for(i=0; i<count; i++) {
+		if(apt_cyclic_queue_push(queue,&items[i]) == FALSE) {
+			status = FALSE;
+			break;
+		}
+	}
+	for(i=0; i<count && status == TRUE; i++) {
+		if(apt_cyclic_queue_pop(queue) != &items[i]) {
+			status = FALSE;
+		}
+	}
+	if(apt_cyclic_queue_is_empty(queue) == FALSE) {
+		status = FALSE;
+	}
+	apt_cyclic_queue_destroy(queue);
+
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,
+		"Growable Queue Pushed [%"APR_SIZE_T_FMT"]: %s",
+		count,
+		status == TRUE ? "OK" : "Out of Order");
+	return status;
+}
+
+static apt_bool_t cyclic_queue_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apr_size_t count = QUEUE_SIZE * 16;
+	apr_size_t *items = apr_palloc(suite->pool,sizeof(apr_size_t) * count);
+	apt_bool_t status = TRUE;
+
+	if(cyclic_queue_fixed_test(items) != TRUE) {
+		status = FALSE;
+	}
+	if(cyclic_queue_growable_test(items,count) != TRUE) {
+		status = FALSE;
+	}
+	return status;
+}
+
+apt_test_suite_t* cyclic_queue_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"cyclic-queue",NULL,cyclic_queue_test_run);
+	return suite;
+}
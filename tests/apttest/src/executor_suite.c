@@ -0,0 +1,156 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+
+#include <apr_thread_proc.h>
+#include <apr_atomic.h>
+#include "apt_test_suite.h"
+#include "apt_executor.h"
+#include "apt_log.h"
+
+#define THREAD_COUNT     4
+#define STRAND_COUNT     8
+#define PRODUCER_COUNT   2
+#define JOB_COUNT        100000
+#define STRAND_SIZE      64
+
+typedef struct executor_test_t executor_test_t;
+
+typedef struct {
+	executor_test_t       *test;
+	apt_executor_strand_t *strand;
+	/** Last job number processed per producer */
+	long                   last[PRODUCER_COUNT];
+	/** Number of jobs being run (must never exceed 1) */
+	volatile apr_uint32_t  active;
+} strand_test_t;
+
+struct executor_test_t {
+	strand_test_t          strands[STRAND_COUNT];
+	volatile apr_uint32_t  processed_count;
+	volatile apr_uint32_t  failure_count;
+};
+
+typedef struct {
+	executor_test_t       *test;
+	long                   id;
+} producer_t;
+
+static void job_handler(void *obj, void *arg)
+{
+	strand_test_t *strand = obj;
+	long number = (long)arg;
+	long producer = number % PRODUCER_COUNT;
+
+	/* jobs of a strand must run one at a time in order */
+	if(apr_atomic_inc32(&strand->active) != 0) {
+		apr_atomic_inc32(&strand->test->failure_count);
+	}
+	if(number <= strand->last[producer]) {
+		apr_atomic_inc32(&strand->test->failure_count);
+	}
+	strand->last[producer] = number;
+	apr_atomic_dec32(&strand->active);
+	apr_atomic_inc32(&strand->test->processed_count);
+}
+
+static void* APR_THREAD_FUNC producer_thread_proc(apr_thread_t *thread, void *data)
+{
+	producer_t *producer = data;
+	strand_test_t *strand;
+	long i;
+	for(i=0; i<JOB_COUNT; i++) {
+		strand = &producer->test->strands[i % STRAND_COUNT];
+		while(apt_executor_job_submit(strand->strand,job_handler,strand,
+				(void*)(i * PRODUCER_COUNT + producer->id)) == FALSE) {
+			apr_thread_yield();
+		}
+	}
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+static apt_bool_t executor_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_executor_t *executor;
+	executor_test_t *test;
+	producer_t producers[PRODUCER_COUNT];
+	apr_thread_t *threads[PRODUCER_COUNT];
+	apr_status_t rv;
+	apt_bool_t status = TRUE;
+	int i,j;
+
+	executor = apt_executor_create(THREAD_COUNT,suite->pool);
+	if(!executor) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Executor");
+		return FALSE;
+	}
+
+	test = apr_palloc(suite->pool,sizeof(executor_test_t));
+	test->processed_count = 0;
+	test->failure_count = 0;
+	for(i=0; i<STRAND_COUNT; i++) {
+		test->strands[i].test = test;
+		test->strands[i].active = 0;
+		for(j=0; j<PRODUCER_COUNT; j++) {
+			test->strands[i].last[j] = -1;
+		}
+		test->strands[i].strand = apt_executor_strand_create(executor,STRAND_SIZE,suite->pool);
+		if(!test->strands[i].strand) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Strand");
+			return FALSE;
+		}
+	}
+
+	apt_executor_start(executor);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Submit [%d] Jobs to [%d] Strands by [%d] Producers",
+		JOB_COUNT,STRAND_COUNT,PRODUCER_COUNT);
+	for(i=0; i<PRODUCER_COUNT; i++) {
+		producers[i].test = test;
+		producers[i].id = i;
+		if(apr_thread_create(&threads[i],NULL,producer_thread_proc,&producers[i],suite->pool) != APR_SUCCESS) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Producer Thread");
+			return FALSE;
+		}
+	}
+	for(i=0; i<PRODUCER_COUNT; i++) {
+		apr_thread_join(&rv,threads[i]);
+	}
+
+	/* destroy waits for pending jobs of the strand to complete */
+	for(i=0; i<STRAND_COUNT; i++) {
+		apt_executor_strand_destroy(test->strands[i].strand);
+	}
+	apt_executor_stop(executor);
+	apt_executor_destroy(executor);
+
+	if(test->processed_count != PRODUCER_COUNT * JOB_COUNT || test->failure_count) {
+		status = FALSE;
+	}
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,
+		"Processed [%u] Jobs, [%u] out of Order",
+		test->processed_count,
+		test->failure_count);
+	return status;
+}
+
+apt_test_suite_t* executor_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"executor",NULL,executor_test_run);
+	return suite;
+}
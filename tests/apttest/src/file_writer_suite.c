@@ -0,0 +1,159 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <apr_file_io.h>
+#include <apr_file_info.h>
+#include <apr_thread_proc.h>
+#include "apt_test_suite.h"
+#include "apt_file_writer.h"
+#include "apt_log.h"
+
+#define THREAD_COUNT 2
+#define BLOCK_SIZE   4096
+#define BLOCK_COUNT  4
+/* divides the block size, so that a frame is either written or dropped entirely */
+#define FRAME_SIZE   256
+/* not a multiple of the block size, the tail is written on close */
+#define FRAME_COUNT  1000
+
+static void frame_fill(apr_byte_t *frame, apr_size_t number)
+{
+	apr_size_t i;
+	for(i=0; i<FRAME_SIZE; i++) {
+		frame[i] = (apr_byte_t)(number + i);
+	}
+}
+
+/** Write frames as media processing does */
+static apt_bool_t file_writer_frames_write(apt_file_writer_t *writer)
+{
+	apr_byte_t frame[FRAME_SIZE];
+	apr_size_t i;
+	for(i=0; i<FRAME_COUNT; i++) {
+		frame_fill(frame,i);
+		while(apt_file_writer_write(writer,frame,FRAME_SIZE) == FALSE) {
+			if(apt_file_writer_is_open(writer) == FALSE) {
+				return FALSE;
+			}
+			/* the ring is full, wait for the executor to catch up */
+			apr_thread_yield();
+		}
+	}
+	return TRUE;
+}
+
+/** Read the file back and compare to the written frames */
+static apt_bool_t file_writer_frames_verify(const char *file_path, apr_pool_t *pool)
+{
+	apr_byte_t expected[FRAME_SIZE];
+	apr_byte_t frame[FRAME_SIZE];
+	apr_file_t *file;
+	apr_finfo_t finfo;
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+
+	if(apr_file_open(&file,file_path,APR_FOPEN_READ | APR_FOPEN_BINARY,APR_OS_DEFAULT,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open File [%s]",file_path);
+		return FALSE;
+	}
+	if(apr_file_info_get(&finfo,APR_FINFO_SIZE,file) != APR_SUCCESS || finfo.size != FRAME_SIZE * FRAME_COUNT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Size of File [%s]",file_path);
+		apr_file_close(file);
+		return FALSE;
+	}
+	for(i=0; i<FRAME_COUNT && status == TRUE; i++) {
+		frame_fill(expected,i);
+		if(apr_file_read_full(file,frame,FRAME_SIZE,NULL) != APR_SUCCESS ||
+			memcmp(frame,expected,FRAME_SIZE) != 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of Frame [%"APR_SIZE_T_FMT"] in File [%s]",i,file_path);
+			status = FALSE;
+		}
+	}
+	apr_file_close(file);
+	return status;
+}
+
+static apt_bool_t file_writer_test(apt_executor_t *executor, const char *dir_path, apr_pool_t *pool)
+{
+	char *file_path[2];
+	apt_bool_t status = TRUE;
+	int i;
+	apt_file_writer_t *writer = apt_file_writer_create(executor,BLOCK_SIZE,BLOCK_COUNT,FALSE,pool);
+	if(!writer) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create File Writer");
+		return FALSE;
+	}
+
+	/* the second open waits for the first file to be closed */
+	for(i=0; i<2; i++) {
+		apr_filepath_merge(&file_path[i],dir_path,i ? "apttest-writer-2.pcm" : "apttest-writer-1.pcm",APR_FILEPATH_NATIVE,pool);
+		if(apt_file_writer_open(writer,file_path[i],NULL) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open File [%s]",file_path[i]);
+			status = FALSE;
+			break;
+		}
+		if(file_writer_frames_write(writer) == FALSE) {
+			status = FALSE;
+		}
+		apt_file_writer_close(writer);
+	}
+	/* destroy waits for pending writes */
+	apt_file_writer_destroy(writer);
+
+	for(i=0; i<2 && status == TRUE; i++) {
+		status = file_writer_frames_verify(file_path[i],pool);
+		apr_file_remove(file_path[i],pool);
+	}
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"%s File Writer [%s]",
+		executor ? "Asynchronous" : "Synchronous",
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+static apt_bool_t file_writer_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_executor_t *executor;
+	const char *dir_path;
+	apt_bool_t status;
+
+	if(apr_temp_dir_get(&dir_path,suite->pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Get Temp Dir");
+		return FALSE;
+	}
+
+	status = file_writer_test(NULL,dir_path,suite->pool);
+
+	executor = apt_executor_create(THREAD_COUNT,suite->pool);
+	if(!executor) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Executor");
+		return FALSE;
+	}
+	apt_executor_start(executor);
+	if(file_writer_test(executor,dir_path,suite->pool) == FALSE) {
+		status = FALSE;
+	}
+	apt_executor_stop(executor);
+	apt_executor_destroy(executor);
+	return status;
+}
+
+apt_test_suite_t* file_writer_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"file-writer",NULL,file_writer_test_run);
+	return suite;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include "apt_test_suite.h"
+#include "apt_header_field.h"
+#include "apt_text_message.h"
+#include "apt_log.h"
+
+#define FIELD_COUNT 20
+
+/** Add header fields with identifiers, more than fit inline */
+static apt_bool_t header_section_index_test(apr_pool_t *pool)
+{
+	apt_header_section_t header;
+	apt_header_field_t *fields[FIELD_COUNT];
+	apt_header_field_t *duplicate;
+	apr_size_t i;
+
+	apt_header_section_init(&header);
+	apt_header_section_array_alloc(&header,FIELD_COUNT,pool);
+	for(i=0; i<FIELD_COUNT; i++) {
+		fields[i] = apt_header_section_field_alloc(&header,pool);
+		fields[i]->id = (i * 7) % FIELD_COUNT;
+		apt_string_set(&fields[i]->name,"Name");
+		if(apt_header_section_field_add(&header,fields[i]) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Add Header Field [%"APR_SIZE_T_FMT"]",i);
+			return FALSE;
+		}
+
+		/* the duplicate is rejected either by the inline array or by the built one */
+		duplicate = apt_header_field_alloc(pool);
+		duplicate->id = fields[i]->id;
+		if(apt_header_section_field_add(&header,duplicate) == TRUE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Duplicate Header Field Added [%"APR_SIZE_T_FMT"]",i);
+			return FALSE;
+		}
+
+		if(i == APT_HEADER_SECTION_INLINE_FIELD_COUNT - 1 && header.arr) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Array Is Built for Inline Header Fields");
+			return FALSE;
+		}
+	}
+	if(!header.arr) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Array Is Not Built");
+		return FALSE;
+	}
+
+	for(i=0; i<FIELD_COUNT; i++) {
+		if(apt_header_section_field_get(&header,fields[i]->id) != fields[i]) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of Header Field [%"APR_SIZE_T_FMT"]",i);
+			return FALSE;
+		}
+	}
+	apt_header_section_field_remove(&header,fields[0]);
+	apt_header_section_field_unset(&header,fields[1]);
+	if(apt_header_section_field_check(&header,fields[0]->id) == TRUE ||
+		apt_header_section_field_check(&header,fields[1]->id) == TRUE ||
+		apt_header_section_field_check(&header,FIELD_COUNT) == TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Removed Header Field Is Still Set");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Parse header section into inline storage and remove from the inline array */
+static apt_bool_t header_section_parse_test(apr_pool_t *pool)
+{
+	char buffer[] =
+		"Completion-Cause: 000 success\r\n"
+		"Content-Type: application/x-nlsml\r\n"
+		"Vendor-Specific-Parameters: a=b\r\n"
+		"\r\n";
+	apt_text_stream_t stream;
+	apt_header_section_t header;
+	apt_header_field_t *header_field;
+	apr_size_t count = 0;
+	apr_size_t id = 0;
+
+	apt_text_stream_init(&stream,buffer,sizeof(buffer) - 1);
+	apt_header_section_init(&header);
+	apt_header_section_array_alloc(&header,FIELD_COUNT,pool);
+	if(apt_header_section_parse(&header,&stream,pool) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Parse Header Section");
+		return FALSE;
+	}
+
+	for(header_field = APR_RING_FIRST(&header.ring);
+			header_field != APR_RING_SENTINEL(&header.ring, apt_header_field_t, link);
+				header_field = APR_RING_NEXT(header_field, link)) {
+		if(header_field != &header.inline_fields[count]) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Header Field Is Not Inline [%s]",header_field->name.buf);
+			return FALSE;
+		}
+		header_field->id = id++;
+		apt_header_section_field_set(&header,header_field);
+		count++;
+	}
+	/* the field of the empty line is given back */
+	if(count != 3 || header.inline_count != 3 || header.set_count != 3) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Header Fields [%"APR_SIZE_T_FMT"]",count);
+		return FALSE;
+	}
+
+	apt_header_section_field_remove(&header,&header.inline_fields[0]);
+	if(apt_header_section_field_get(&header,0) != NULL ||
+		apt_header_section_field_get(&header,2) != &header.inline_fields[2]) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of Inline Header Fields");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t header_section_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_bool_t status = header_section_index_test(suite->pool);
+	if(header_section_parse_test(suite->pool) == FALSE) {
+		status = FALSE;
+	}
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"Header Section [%s]",
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+apt_test_suite_t* header_section_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"header-section",NULL,header_section_test_run);
+	return suite;
+}
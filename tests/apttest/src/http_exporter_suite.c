@@ -0,0 +1,124 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <string.h>
+#include <apr_network_io.h>
+#include "apt_test_suite.h"
+#include "apt_http_exporter.h"
+#include "apt_log.h"
+
+#define EXPORTER_IP   "127.0.0.1"
+#define EXPORTER_PORT 18090
+#define RESPONSE_SIZE 4096
+
+static const char* http_exporter_render(void *obj, const char *path, apr_pool_t *pool)
+{
+	apr_size_t *requests = obj;
+	if(strcmp(path,"/metrics") != 0) {
+		return NULL;
+	}
+	(*requests)++;
+	return apr_psprintf(pool,"test_requests_total %"APR_SIZE_T_FMT"\n",*requests);
+}
+
+/** Send a request and receive the response until the exporter closes the connection */
+static apt_bool_t http_exporter_request(const char *request, char *response, apr_size_t size, apr_pool_t *pool)
+{
+	apr_sockaddr_t *sockaddr;
+	apr_socket_t *sock;
+	apr_size_t length;
+	apr_size_t received = 0;
+
+	if(apr_sockaddr_info_get(&sockaddr,EXPORTER_IP,APR_INET,EXPORTER_PORT,0,pool) != APR_SUCCESS ||
+		apr_socket_create(&sock,sockaddr->family,SOCK_STREAM,APR_PROTO_TCP,pool) != APR_SUCCESS) {
+		return FALSE;
+	}
+	apr_socket_timeout_set(sock,2 * APR_USEC_PER_SEC);
+	if(apr_socket_connect(sock,sockaddr) != APR_SUCCESS) {
+		apr_socket_close(sock);
+		return FALSE;
+	}
+	length = strlen(request);
+	if(apr_socket_send(sock,request,&length) != APR_SUCCESS) {
+		apr_socket_close(sock);
+		return FALSE;
+	}
+	do {
+		length = size - 1 - received;
+		if(!length || apr_socket_recv(sock,response + received,&length) != APR_SUCCESS) {
+			break;
+		}
+		received += length;
+	}
+	while(length);
+	response[received] = '\0';
+	apr_socket_close(sock);
+	return received ? TRUE : FALSE;
+}
+
+static apt_bool_t http_exporter_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	char response[RESPONSE_SIZE];
+	apr_size_t requests = 0;
+	apt_bool_t status = TRUE;
+	apt_http_exporter_t *exporter = apt_http_exporter_create(EXPORTER_IP,EXPORTER_PORT,"text/plain; version=0.0.4",
+		http_exporter_render,&requests,suite->pool);
+	if(!exporter) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create HTTP Exporter");
+		return FALSE;
+	}
+	if(apt_http_exporter_start(exporter) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Start HTTP Exporter");
+		return FALSE;
+	}
+
+	if(http_exporter_request("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n",response,sizeof(response),suite->pool) == FALSE ||
+		strncmp(response,"HTTP/1.0 200 OK\r\n",17) != 0 ||
+		!strstr(response,"Content-Type: text/plain; version=0.0.4\r\n") ||
+		!strstr(response,"\r\n\r\ntest_requests_total 1\n")) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Response to Metrics Request");
+		status = FALSE;
+	}
+	if(status == TRUE &&
+		(http_exporter_request("GET /unknown HTTP/1.1\r\n\r\n",response,sizeof(response),suite->pool) == FALSE ||
+		strncmp(response,"HTTP/1.0 404",12) != 0)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Path Not Rejected");
+		status = FALSE;
+	}
+	if(status == TRUE &&
+		(http_exporter_request("POST /metrics HTTP/1.1\r\n\r\n",response,sizeof(response),suite->pool) == FALSE ||
+		strncmp(response,"HTTP/1.0 405",12) != 0 || requests != 1)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unsupported Method Not Rejected");
+		status = FALSE;
+	}
+
+	apt_http_exporter_stop(exporter);
+	if(status == TRUE && http_exporter_request("GET /metrics HTTP/1.1\r\n\r\n",response,sizeof(response),suite->pool) == TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Request Served after Stop");
+		status = FALSE;
+	}
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"HTTP Exporter [%s]",
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+apt_test_suite_t* http_exporter_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"http-exporter",NULL,http_exporter_test_run);
+	return suite;
+}
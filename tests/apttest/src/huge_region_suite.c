@@ -0,0 +1,81 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include "apt_test_suite.h"
+#include "apt_huge_region.h"
+#include "apt_log.h"
+
+/* not a multiple of the alignment, so that allocations are rounded up */
+#define BLOCK_SIZE 1000
+
+static apt_bool_t huge_region_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_huge_region_t *region;
+	apr_byte_t *block;
+	apr_byte_t *prev = NULL;
+	apr_size_t count = 0;
+	apr_size_t size;
+	apr_size_t used;
+	apt_bool_t status = TRUE;
+
+	region = apt_huge_region_create(1,suite->pool);
+	if(!region) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Huge Page Region");
+		return FALSE;
+	}
+	apt_huge_region_stat_get(region,&size,&used);
+	if(size != APT_HUGE_PAGE_SIZE || used != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Size of Region [%"APR_SIZE_T_FMT"]",size);
+		status = FALSE;
+	}
+
+	while((block = apt_huge_region_alloc(region,BLOCK_SIZE)) != NULL) {
+		if(((apr_uintptr_t)block & 63) != 0 || (prev && block < prev + BLOCK_SIZE)) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Misaligned Block [%"APR_SIZE_T_FMT"]",count);
+			status = FALSE;
+			break;
+		}
+		/* the memory is writable in full */
+		memset(block,0xA5,BLOCK_SIZE);
+		prev = block;
+		count++;
+	}
+	apt_huge_region_stat_get(region,&size,&used);
+	if(count != APT_HUGE_PAGE_SIZE / 1024 || used != count * 1024) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Blocks [%"APR_SIZE_T_FMT"]",count);
+		status = FALSE;
+	}
+	if(apt_huge_region_alloc(region,1) != NULL) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Exhausted Region Is Expected to Fail");
+		status = FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"%s Page Region %"APR_SIZE_T_FMT" blocks [%s]",
+		apt_huge_region_backing_get(region) == APT_HUGE_REGION_HUGETLB ? "Huge" :
+		apt_huge_region_backing_get(region) == APT_HUGE_REGION_TRANSPARENT ? "Transparent Huge" : "Normal",
+		count,
+		status == TRUE ? "OK" : "Failed");
+	apt_huge_region_destroy(region);
+	return status;
+}
+
+apt_test_suite_t* huge_region_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"huge-region",NULL,huge_region_test_run);
+	return suite;
+}
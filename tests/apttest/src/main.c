@@ -22,6 +22,23 @@
 apt_test_suite_t* task_test_suite_create(apr_pool_t *pool);
 apt_test_suite_t* consumer_task_test_suite_create(apr_pool_t *pool);
 apt_test_suite_t* multipart_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* mpsc_queue_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* msg_pool_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* timer_queue_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* executor_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* cyclic_queue_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* file_writer_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* shard_table_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* cpu_set_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* http_exporter_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* pool_account_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* bench_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* nlsml_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* header_section_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* shm_ring_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* clock_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* huge_region_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* token_bucket_test_suite_create(apr_pool_t *pool);
 
 int main(int argc, const char * const *argv)
 {
@@ -48,6 +65,57 @@ int main(int argc, const char * const *argv)
 	test_suite = multipart_test_suite_create(pool);
 	apt_test_framework_suite_add(test_framework,test_suite);
 
+	test_suite = mpsc_queue_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = msg_pool_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = timer_queue_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = executor_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = cyclic_queue_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = file_writer_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = shard_table_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = cpu_set_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = http_exporter_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = pool_account_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = bench_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = nlsml_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = header_section_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = shm_ring_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = clock_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = huge_region_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = token_bucket_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
 	/* run tests */
 	apt_test_framework_run(test_framework,argc,argv);
 
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+#include <apr_thread_proc.h>
+#include "apt_test_suite.h"
+#include "apt_mpsc_queue.h"
+#include "apt_log.h"
+
+#define PRODUCER_COUNT   4
+#define MSG_COUNT        100000
+#define QUEUE_SIZE       64
+#define BATCH_SIZE       16
+
+typedef struct {
+	apt_mpsc_queue_t *queue;
+	apr_size_t        id;
+	apr_size_t        count;
+	apr_size_t        items[MSG_COUNT];
+	apr_size_t        last;
+} producer_t;
+
+static void* APR_THREAD_FUNC producer_thread_proc(apr_thread_t *thread, void *data)
+{
+	producer_t *producer = data;
+	apr_size_t i;
+	for(i=0; i<producer->count; i++) {
+		/* items are pushed by pointer, each producer has its own array */
+		while(apt_mpsc_queue_push(producer->queue,&producer->items[i]) == FALSE) {
+			apr_thread_yield();
+		}
+	}
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+static apt_bool_t mpsc_queue_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_mpsc_queue_t *queue;
+	producer_t *producers;
+	apr_thread_t *threads[PRODUCER_COUNT];
+	void *objs[BATCH_SIZE];
+	apr_size_t received = 0;
+	apr_size_t count;
+	apr_size_t i,j;
+	apt_bool_t status = TRUE;
+
+	queue = apt_mpsc_queue_create(QUEUE_SIZE);
+	producers = apr_palloc(suite->pool,sizeof(producer_t) * PRODUCER_COUNT);
+	for(i=0; i<PRODUCER_COUNT; i++) {
+		producers[i].queue = queue;
+		producers[i].id = i;
+		producers[i].count = MSG_COUNT;
+		producers[i].last = 0;
+		for(j=0; j<MSG_COUNT; j++) {
+			producers[i].items[j] = j + 1;
+		}
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Start [%d] Producers of [%d] Messages",PRODUCER_COUNT,MSG_COUNT);
+	for(i=0; i<PRODUCER_COUNT; i++) {
+		if(apr_thread_create(&threads[i],NULL,producer_thread_proc,&producers[i],suite->pool) != APR_SUCCESS) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Producer Thread");
+			return FALSE;
+		}
+	}
+
+	while(received < PRODUCER_COUNT * MSG_COUNT) {
+		count = apt_mpsc_queue_drain(queue,objs,BATCH_SIZE);
+		if(!count) {
+			apr_thread_yield();
+			continue;
+		}
+		for(i=0; i<count; i++) {
+			apr_size_t *item = objs[i];
+			producer_t *producer = NULL;
+			for(j=0; j<PRODUCER_COUNT; j++) {
+				if(item >= producers[j].items && item < producers[j].items + MSG_COUNT) {
+					producer = &producers[j];
+					break;
+				}
+			}
+			if(!producer || *item != producer->last + 1) {
+				/* messages of the same producer must be received in order */
+				status = FALSE;
+			}
+			else {
+				producer->last = *item;
+			}
+		}
+		received += count;
+	}
+
+	for(i=0; i<PRODUCER_COUNT; i++) {
+		apr_status_t rv;
+		apr_thread_join(&rv,threads[i]);
+	}
+
+	if(apt_mpsc_queue_is_empty(queue) == FALSE) {
+		status = FALSE;
+	}
+	apt_mpsc_queue_destroy(queue);
+
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,
+		"Received [%"APR_SIZE_T_FMT"] Messages: %s",
+		received,
+		status == TRUE ? "OK" : "Out of Order");
+	return status;
+}
+
+apt_test_suite_t* mpsc_queue_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"mpsc-queue",NULL,mpsc_queue_test_run);
+	return suite;
+}
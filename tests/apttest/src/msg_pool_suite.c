@@ -0,0 +1,104 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+#include <apr_thread_proc.h>
+#include "apt_test_suite.h"
+#include "apt_task_msg.h"
+#include "apt_log.h"
+
+#define THREAD_COUNT     4
+#define ITERATION_COUNT  100000
+#define MSG_POOL_SIZE    16
+#define MSG_BATCH_SIZE   8
+
+typedef struct {
+	apt_task_msg_pool_t *msg_pool;
+	apr_size_t           id;
+	apt_bool_t           status;
+} worker_t;
+
+static void* APR_THREAD_FUNC worker_thread_proc(apr_thread_t *thread, void *data)
+{
+	worker_t *worker = data;
+	apt_task_msg_t *msgs[MSG_BATCH_SIZE];
+	apr_size_t i,j;
+	apr_size_t count;
+	for(i=0; i<ITERATION_COUNT; i++) {
+		/* hold a varying number of messages, so that the slab is exhausted at times */
+		count = 1 + (i + worker->id) % MSG_BATCH_SIZE;
+		for(j=0; j<count; j++) {
+			msgs[j] = apt_task_msg_acquire(worker->msg_pool);
+			*(apr_size_t*)msgs[j]->data = worker->id * MSG_BATCH_SIZE + j;
+		}
+		for(j=0; j<count; j++) {
+			if(*(apr_size_t*)msgs[j]->data != worker->id * MSG_BATCH_SIZE + j) {
+				/* the message has been handed out twice */
+				worker->status = FALSE;
+			}
+			apt_task_msg_release(msgs[j]);
+		}
+	}
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+static apt_bool_t msg_pool_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_task_msg_pool_t *msg_pool;
+	worker_t workers[THREAD_COUNT];
+	apr_thread_t *threads[THREAD_COUNT];
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+
+	msg_pool = apt_task_msg_pool_create_static(sizeof(apr_size_t),MSG_POOL_SIZE,suite->pool);
+	if(!msg_pool) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Static Message Pool");
+		return FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Start [%d] Threads sharing [%d] Messages",THREAD_COUNT,MSG_POOL_SIZE);
+	for(i=0; i<THREAD_COUNT; i++) {
+		workers[i].msg_pool = msg_pool;
+		workers[i].id = i;
+		workers[i].status = TRUE;
+		if(apr_thread_create(&threads[i],NULL,worker_thread_proc,&workers[i],suite->pool) != APR_SUCCESS) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Worker Thread");
+			return FALSE;
+		}
+	}
+
+	for(i=0; i<THREAD_COUNT; i++) {
+		apr_status_t rv;
+		apr_thread_join(&rv,threads[i]);
+		if(workers[i].status == FALSE) {
+			status = FALSE;
+		}
+	}
+	apt_task_msg_pool_destroy(msg_pool);
+
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,
+		"Acquired and Released Messages: %s",
+		status == TRUE ? "OK" : "Shared Message Detected");
+	return status;
+}
+
+apt_test_suite_t* msg_pool_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"msg-pool",NULL,msg_pool_test_run);
+	return suite;
+}
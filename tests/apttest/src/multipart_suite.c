@@ -16,10 +16,26 @@
  * $Id$
  */
 
+#include <string.h>
 #include "apt_test_suite.h"
 #include "apt_multipart_content.h"
 #include "apt_log.h"
 
+#define PART_COUNT 2
+
+static const char *part_types[PART_COUNT] = {
+	"text/plain",
+	"application/ssml+xml"
+};
+
+static const char *part_bodies[PART_COUNT] = {
+	"This is the content of the first part",
+	"<?xml version=\"1.0\"?>\r\n"
+	"<speak version=\"1.0\"\r\n"
+	"<p> <s>You have 4 new messages.</s> </p>\r\n"
+	"</speak>"
+};
+
 static apt_str_t* multipart_content_generate(apt_test_suite_t *suite)
 {
 	apt_multipart_content_t *multipart = apt_multipart_content_create(1500,NULL,suite->pool);
@@ -27,17 +43,13 @@ static apt_str_t* multipart_content_generate(apt_test_suite_t *suite)
 	apt_str_t content;
 	apt_str_t *body;
 
-	apt_string_set(&content_type,"text/plain");
-	apt_string_set(&content,"This is the content of the first part");
-	apt_multipart_content_add2(multipart,&content_type,NULL,&content);
+	apr_size_t i;
 
-	apt_string_set(&content_type,"application/ssml+xml");
-	apt_string_set(&content,
-		"<?xml version=\"1.0\"?>\r\n"
-		"<speak version=\"1.0\"\r\n"
-		"<p> <s>You have 4 new messages.</s> </p>\r\n"
-		"</speak>");
-	apt_multipart_content_add2(multipart,&content_type,NULL,&content);
+	for(i=0; i<PART_COUNT; i++) {
+		apt_string_set(&content_type,part_types[i]);
+		apt_string_set(&content,part_bodies[i]);
+		apt_multipart_content_add2(multipart,&content_type,NULL,&content);
+	}
 
 	body = apt_multipart_content_finalize(multipart);
 	if(body) {
@@ -81,12 +93,119 @@ static apt_bool_t multipart_content_parse(apt_test_suite_t *suite, apt_str_t *bo
 }
 
 
+/** Generate the content by reference and compare to the copied one */
+static apt_bool_t multipart_content_vec_verify(apt_test_suite_t *suite, const apt_str_t *expected)
+{
+	apt_multipart_content_t *multipart = apt_multipart_content_create(1500,NULL,suite->pool);
+	const struct iovec *vec;
+	apr_size_t count;
+	apr_size_t length;
+	apr_size_t offset = 0;
+	apr_size_t i;
+	apt_str_t content_type;
+	apt_str_t content;
+
+	for(i=0; i<PART_COUNT; i++) {
+		apt_string_set(&content_type,part_types[i]);
+		apt_string_set(&content,part_bodies[i]);
+		apt_multipart_content_ref_add(multipart,&content_type,NULL,&content);
+	}
+	if(apt_multipart_content_vec_finalize(multipart,&vec,&count,&length) == FALSE || length != expected->length) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Generate Multipart Content by Reference");
+		return FALSE;
+	}
+	for(i=0; i<count; i++) {
+		if(offset + vec[i].iov_len > expected->length ||
+			memcmp(expected->buf + offset,vec[i].iov_base,vec[i].iov_len) != 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of Multipart Content Segment [%"APR_SIZE_T_FMT"]",i);
+			return FALSE;
+		}
+		offset += vec[i].iov_len;
+	}
+	/* the bodies are referred to, not copied */
+	if(count != 2 * PART_COUNT + 1 || vec[1].iov_base != part_bodies[0]) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Segments of Multipart Content [%"APR_SIZE_T_FMT"]",count);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Scan the content parts with no copies made */
+static apt_bool_t multipart_content_span_verify(apt_test_suite_t *suite, const apt_str_t *body)
+{
+	apt_multipart_content_t *multipart = apt_multipart_content_assign(body,NULL,suite->pool);
+	apt_content_span_t content_span;
+	apt_bool_t is_final = FALSE;
+	apr_size_t count = 0;
+
+	while(apt_multipart_content_span_get(multipart,&content_span,&is_final) == TRUE && is_final == FALSE) {
+		if(count >= PART_COUNT ||
+			content_span.body.buf < body->buf || content_span.body.buf > body->buf + body->length ||
+			content_span.body.length != strlen(part_bodies[count]) ||
+			memcmp(content_span.body.buf,part_bodies[count],content_span.body.length) != 0 ||
+			content_span.type.length != strlen(part_types[count]) ||
+			memcmp(content_span.type.buf,part_types[count],content_span.type.length) != 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of Content Part [%"APR_SIZE_T_FMT"]",count);
+			return FALSE;
+		}
+		count++;
+	}
+	if(is_final == FALSE || count != PART_COUNT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Content Parts [%"APR_SIZE_T_FMT"]",count);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Scan the content parts delimited by the boundary only */
+static apt_bool_t multipart_content_delimited_verify(apt_test_suite_t *suite)
+{
+	const char data[] =
+		"preamble\r\n"
+		"--break\r\n"
+		"Content-Type: text/plain\r\n"
+		"\r\n"
+		"first -- part\r\n"
+		"--break\r\n"
+		"content-type: text/uri-list\r\n"
+		"Content-Id: <second@example.com>\r\n"
+		"\r\n"
+		"session:second@example.com\r\n"
+		"--break--\r\n";
+	apt_str_t body = {(char*)data,sizeof(data) - 1};
+	apt_str_t boundary = {"break",5};
+	apt_multipart_content_t *multipart = apt_multipart_content_assign(&body,&boundary,suite->pool);
+	apt_content_span_t content_span;
+	apt_bool_t is_final = FALSE;
+
+	if(apt_multipart_content_span_get(multipart,&content_span,&is_final) == FALSE || is_final == TRUE ||
+		content_span.body.length != 13 || strncmp(content_span.body.buf,"first -- part",13) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of Delimited Content Part [1]");
+		return FALSE;
+	}
+	if(apt_multipart_content_span_get(multipart,&content_span,&is_final) == FALSE || is_final == TRUE ||
+		content_span.body.length != 26 || content_span.id.length != 20 || content_span.type.length != 13) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of Delimited Content Part [2]");
+		return FALSE;
+	}
+	if(apt_multipart_content_span_get(multipart,&content_span,&is_final) == FALSE || is_final == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Final Boundary");
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static apt_bool_t multipart_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
 {
 	apt_bool_t status = FALSE;
 	apt_str_t *body = multipart_content_generate(suite);
 	if(body) {
 		status = multipart_content_parse(suite,body);
+		if(multipart_content_vec_verify(suite,body) == FALSE ||
+			multipart_content_span_verify(suite,body) == FALSE ||
+			multipart_content_delimited_verify(suite) == FALSE) {
+			status = FALSE;
+		}
 	}
 	return status;
 }
@@ -0,0 +1,275 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <string.h>
+#include "apt_test_suite.h"
+#include "apt_nlsml_doc.h"
+#include "apt_nlsml_writer.h"
+#include "apt_log.h"
+
+#define MAX_INTERPRETATION_COUNT 8
+
+/** Interpretations collected by the scan */
+typedef struct {
+	nlsml_interpretation_span_t interpretations[MAX_INTERPRETATION_COUNT];
+	apr_size_t                  count;
+	/** Number of interpretations to take before the scan is stopped */
+	apr_size_t                  max_count;
+} nlsml_scan_test_t;
+
+static const char *nlsml_documents[] = {
+	/* N-best list */
+	"<?xml version=\"1.0\"?>\r\n"
+	"<result grammar=\"session:request1@form-level.store\">\r\n"
+	"  <interpretation grammar=\"session:request1@form-level.store\" confidence=\"0.80\">\r\n"
+	"    <instance>Boston</instance>\r\n"
+	"    <input mode=\"speech\" confidence=\"0.9\" timestamp-start=\"2000-04-03T00:00:00:00\">boston</input>\r\n"
+	"  </interpretation>\r\n"
+	"  <interpretation confidence=\"45\">\r\n"
+	"    <instance>Austin &amp; Houston &#x41;</instance>\r\n"
+	"    <input mode='dtmf'>austin</input>\r\n"
+	"  </interpretation>\r\n"
+	"  <interpretation>\r\n"
+	"    <instance/>\r\n"
+	"  </interpretation>\r\n"
+	"</result>\r\n",
+
+	/* namespaces, comments, nested markup of the instance */
+	"<?xml version=\"1.0\"?>\r\n"
+	"<!-- <result> in comment -->\r\n"
+	"<nlsml:result xmlns:nlsml=\"urn:ietf:params:xml:ns:mrcpv2\" xmlns:ex=\"http://example.com\" grammar=\"builtin:dtmf/digits\">\r\n"
+	"  <nlsml:interpretation confidence=\"1.0\">\r\n"
+	"    <nlsml:instance><ex:digits count=\"2\">12</ex:digits><ex:checked/></nlsml:instance>\r\n"
+	"    <nlsml:input mode=\"dtmf\">1 2</nlsml:input>\r\n"
+	"  </nlsml:interpretation>\r\n"
+	"</nlsml:result>\r\n",
+
+	/* CDATA section of the instance */
+	"<result>\r\n"
+	"  <interpretation grammar=\"a&gt;b\" confidence=\"0.5\">\r\n"
+	"    <instance><![CDATA[<not-a-tag/> & text]]></instance>\r\n"
+	"    <input>x</input>\r\n"
+	"  </interpretation>\r\n"
+	"</result>\r\n"
+};
+
+#define NLSML_DOCUMENT_COUNT (sizeof(nlsml_documents) / sizeof(nlsml_documents[0]))
+
+static const char *nlsml_malformed_documents[] = {
+	"<grammar><interpretation/></grammar>",
+	"<result><interpretation><instance>unterminated",
+	"<result><interpretation confidence=\"0.5></interpretation></result>",
+	""
+};
+
+#define NLSML_MALFORMED_DOCUMENT_COUNT (sizeof(nlsml_malformed_documents) / sizeof(nlsml_malformed_documents[0]))
+
+static apt_bool_t nlsml_interpretation_collect(void *obj, const nlsml_interpretation_span_t *interpretation)
+{
+	nlsml_scan_test_t *test = obj;
+	if(test->count < MAX_INTERPRETATION_COUNT) {
+		test->interpretations[test->count] = *interpretation;
+	}
+	test->count++;
+	return test->count < test->max_count ? TRUE : FALSE;
+}
+
+static apt_bool_t nlsml_str_equal(const apt_str_t *span, const char *value, apr_pool_t *pool)
+{
+	if(!value) {
+		return span->length ? FALSE : TRUE;
+	}
+	/* values of the document are decoded */
+	return strcmp(nlsml_span_text_generate(span,pool),value) == 0 ? TRUE : FALSE;
+}
+
+/** Compare the interpretation scanned to the one of the document */
+static apt_bool_t nlsml_interpretation_verify(const nlsml_interpretation_span_t *span, nlsml_interpretation_t *interpretation, apr_pool_t *pool)
+{
+	nlsml_instance_t *instance;
+	nlsml_input_t *input;
+	apr_size_t instance_count = 0;
+
+	if(span->confidence != nlsml_interpretation_confidence_get(interpretation) ||
+		nlsml_str_equal(&span->grammar,nlsml_interpretation_grammar_get(interpretation),pool) == FALSE) {
+		return FALSE;
+	}
+	for(instance = nlsml_interpretation_first_instance_get(interpretation); instance;
+			instance = nlsml_interpretation_next_instance_get(interpretation,instance)) {
+		const char *content = nlsml_instance_content_generate(instance,pool);
+		const apt_str_t *instance_span = &span->instances[instance_count];
+		/* text of the instance is decoded the same way, markup is only checked to be present */
+		if(!memchr(content,'<',strlen(content)) && !nlsml_str_equal(instance_span,content,pool)) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Instance Mismatch [%s] != [%s]",
+				nlsml_span_text_generate(instance_span,pool),content);
+			return FALSE;
+		}
+		if(memchr(content,'<',strlen(content)) && !memchr(instance_span->buf,'<',instance_span->length)) {
+			return FALSE;
+		}
+		instance_count++;
+	}
+	if(instance_count != span->instance_count) {
+		return FALSE;
+	}
+
+	input = nlsml_interpretation_input_get(interpretation);
+	if(!input) {
+		return span->input_present == FALSE ? TRUE : FALSE;
+	}
+	return (span->input_present == TRUE &&
+		span->input_confidence == nlsml_input_confidence_get(input) &&
+		nlsml_str_equal(&span->input_mode,nlsml_input_mode_get(input),pool) == TRUE &&
+		nlsml_str_equal(&span->input,nlsml_input_content_generate(input,pool),pool) == TRUE &&
+		nlsml_str_equal(&span->input_timestamp_start,nlsml_input_timestamp_start_get(input),pool) == TRUE &&
+		nlsml_str_equal(&span->input_timestamp_end,nlsml_input_timestamp_end_get(input),pool) == TRUE) ? TRUE : FALSE;
+}
+
+static apt_bool_t nlsml_document_test(const char *document, apr_pool_t *pool)
+{
+	nlsml_scan_test_t test;
+	nlsml_result_t *result;
+	nlsml_interpretation_t *interpretation;
+	apt_str_t grammar;
+	apr_size_t count = 0;
+
+	test.count = 0;
+	test.max_count = MAX_INTERPRETATION_COUNT;
+	if(nlsml_result_scan(document,strlen(document),&grammar,nlsml_interpretation_collect,&test) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Scan NLSML");
+		return FALSE;
+	}
+	result = nlsml_result_parse(document,strlen(document),pool);
+	if(!result) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Parse NLSML");
+		return FALSE;
+	}
+	if(nlsml_str_equal(&grammar,nlsml_result_grammar_get(result),pool) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Grammar Mismatch");
+		return FALSE;
+	}
+	for(interpretation = nlsml_first_interpretation_get(result); interpretation;
+			interpretation = nlsml_next_interpretation_get(result,interpretation)) {
+		if(count >= test.count || nlsml_interpretation_verify(&test.interpretations[count],interpretation,pool) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Interpretation [%"APR_SIZE_T_FMT"] Mismatch",count);
+			return FALSE;
+		}
+		count++;
+	}
+	if(count != test.count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Interpretation Count Mismatch [%"APR_SIZE_T_FMT"] != [%"APR_SIZE_T_FMT"]",test.count,count);
+		return FALSE;
+	}
+
+	/* the scan stops at the best interpretation on demand */
+	test.count = 0;
+	test.max_count = 1;
+	if(nlsml_result_scan(document,strlen(document),NULL,nlsml_interpretation_collect,&test) == FALSE || test.count != 1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Stop Scan");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Generate the results and parse them back */
+static apt_bool_t nlsml_generate_test(apr_pool_t *pool)
+{
+	const nlsml_interpretation_spec_t interpretations[] = {
+		{"session:request1@form-level.store", 0.97f, "Fish & \"Chips\" <large>", NULL, "fish and chips", "speech", 0.9f},
+		{NULL, 0.5f, NULL, "<order><item>fish</item></order>", "fish", "dtmf", NLSML_CONFIDENCE_NONE}
+	};
+	const nlsml_verification_spec_t incremental = {500, "cellular-phone", "male", "accepted", 0.85f};
+	const nlsml_voiceprint_spec_t voiceprint = {"john\"smith", &incremental, NULL};
+	nlsml_result_t *result;
+	nlsml_interpretation_t *interpretation;
+	nlsml_instance_t *instance;
+	apt_str_t body;
+
+	if(nlsml_recognition_result_generate("builtin:grammar/menu",interpretations,2,&body,pool) == FALSE ||
+		body.length != strlen(body.buf)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Generate NLSML");
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Generated NLSML\n%s",body.buf);
+	result = nlsml_result_parse(body.buf,body.length,pool);
+	if(!result || strcmp(nlsml_result_grammar_get(result),"builtin:grammar/menu") != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Parse Generated NLSML");
+		return FALSE;
+	}
+	interpretation = nlsml_first_interpretation_get(result);
+	instance = interpretation ? nlsml_interpretation_first_instance_get(interpretation) : NULL;
+	if(!instance || nlsml_interpretation_confidence_get(interpretation) != 0.97f ||
+		strcmp(nlsml_instance_content_generate(instance,pool),"Fish & \"Chips\" <large>") != 0 ||
+		strcmp(nlsml_input_content_generate(nlsml_interpretation_input_get(interpretation),pool),"fish and chips") != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of Generated Interpretation");
+		return FALSE;
+	}
+	interpretation = nlsml_next_interpretation_get(result,interpretation);
+	if(!interpretation || nlsml_interpretation_grammar_get(interpretation) ||
+		nlsml_document_test(body.buf,pool) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of Generated N-best List");
+		return FALSE;
+	}
+
+	if(nlsml_verification_result_generate(NULL,&voiceprint,1,&body,pool) == FALSE ||
+		body.length != strlen(body.buf) ||
+		!strstr(body.buf,"<voiceprint id=\"john&quot;smith\">") ||
+		!strstr(body.buf,"<verification-score>0.85</verification-score>")) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Generate Verification NLSML");
+		return FALSE;
+	}
+	result = nlsml_result_parse(body.buf,body.length,pool);
+	if(!result) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Parse Generated Verification NLSML");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t nlsml_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	nlsml_scan_test_t test;
+	apt_bool_t status = TRUE;
+	apr_size_t i;
+
+	for(i=0; i<NLSML_DOCUMENT_COUNT; i++) {
+		if(nlsml_document_test(nlsml_documents[i],suite->pool) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"NLSML Document [%"APR_SIZE_T_FMT"] Failed",i);
+			status = FALSE;
+		}
+	}
+	for(i=0; i<NLSML_MALFORMED_DOCUMENT_COUNT; i++) {
+		test.count = 0;
+		test.max_count = MAX_INTERPRETATION_COUNT;
+		if(nlsml_result_scan(nlsml_malformed_documents[i],strlen(nlsml_malformed_documents[i]),NULL,nlsml_interpretation_collect,&test) == TRUE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Malformed NLSML Document [%"APR_SIZE_T_FMT"] Accepted",i);
+			status = FALSE;
+		}
+	}
+	if(nlsml_generate_test(suite->pool) == FALSE) {
+		status = FALSE;
+	}
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"NLSML Scan and Generation [%s]",status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+apt_test_suite_t* nlsml_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"nlsml",NULL,nlsml_test_run);
+	return suite;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include "apt_test_suite.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+
+#define ALLOC_SIZE  1024
+#define ALLOC_COUNT 64
+
+static apt_bool_t pool_account_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_pool_account_stat_t stat;
+	apr_pool_t *pool;
+	apr_size_t initial_bytes;
+	apr_size_t bytes;
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+
+	apt_pool_accounting_set(TRUE);
+	pool = apt_pool_create();
+	if(!pool) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Pool");
+		return FALSE;
+	}
+	apt_pool_owner_set(pool,APT_POOL_OWNER_SESSION);
+	initial_bytes = apt_pool_bytes_get(pool);
+
+	/* the pool has to grow by more than it's asked for */
+	for(i=0; i<ALLOC_COUNT; i++) {
+		apr_palloc(pool,ALLOC_SIZE);
+	}
+	bytes = apt_pool_account_update(pool);
+	apt_pool_account_stat_get(APT_POOL_OWNER_SESSION,&stat);
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Pool Memory initial [%"APR_SIZE_T_FMT"] grown [%"APR_SIZE_T_FMT"] accounted [%"APR_SIZE_T_FMT"] peak [%"APR_SIZE_T_FMT"] bytes",
+		initial_bytes,bytes,stat.bytes,stat.peak_bytes);
+	if(!initial_bytes || bytes < initial_bytes + ALLOC_SIZE * ALLOC_COUNT ||
+		stat.pool_count != 1 || stat.bytes != bytes || stat.peak_bytes < bytes) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Accounting of Grown Pool");
+		status = FALSE;
+	}
+
+	/* the memory is reclaimed along with the pool, while the peak is kept */
+	apr_pool_destroy(pool);
+	apt_pool_account_stat_get(APT_POOL_OWNER_SESSION,&stat);
+	if(stat.pool_count || stat.bytes || stat.peak_bytes < bytes) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Accounting of Destroyed Pool");
+		status = FALSE;
+	}
+	apt_pool_accounting_set(FALSE);
+	return status;
+}
+
+apt_test_suite_t* pool_account_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"pool-account",NULL,pool_account_test_run);
+	return suite;
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <string.h>
+#include <apr_strings.h>
+#include <apr_thread_proc.h>
+#include "apt_test_suite.h"
+#include "apt_shard_table.h"
+#include "apt_log.h"
+
+#define SHARD_COUNT   4
+#define BUCKET_COUNT  8
+#define WRITER_COUNT  2
+#define READER_COUNT  2
+#define STABLE_COUNT  64
+#define KEY_COUNT     64
+#define ROUND_COUNT   2000
+
+typedef struct {
+	apt_shard_table_t *table;
+	apr_size_t         id;
+	apr_size_t         values[KEY_COUNT];
+	apt_bool_t         status;
+} worker_t;
+
+static apr_size_t stable_values[STABLE_COUNT];
+static volatile apt_bool_t writers_done;
+
+static apr_size_t key_make(char *key, const char *prefix, apr_size_t id, apr_size_t i)
+{
+	/* session id alike, 16 hex digits */
+	return apr_snprintf(key,APT_SHARD_TABLE_MAX_KEY_LENGTH,"%s%04"APR_SIZE_T_FMT"%010"APR_SIZE_T_FMT,prefix,id,i);
+}
+
+/** Add and remove own keys, so that entries get recycled under readers */
+static void* APR_THREAD_FUNC writer_thread_proc(apr_thread_t *thread, void *data)
+{
+	worker_t *writer = data;
+	char key[APT_SHARD_TABLE_MAX_KEY_LENGTH];
+	apr_size_t length;
+	apr_size_t round;
+	apr_size_t i;
+	for(round=0; round<ROUND_COUNT && writer->status == TRUE; round++) {
+		for(i=0; i<KEY_COUNT; i++) {
+			length = key_make(key,"w",writer->id,i);
+			apt_shard_table_set(writer->table,key,length,&writer->values[i]);
+		}
+		for(i=0; i<KEY_COUNT; i++) {
+			length = key_make(key,"w",writer->id,i);
+			if(apt_shard_table_get(writer->table,key,length) != &writer->values[i]) {
+				writer->status = FALSE;
+			}
+			apt_shard_table_set(writer->table,key,length,NULL);
+			if(apt_shard_table_get(writer->table,key,length) != NULL) {
+				writer->status = FALSE;
+			}
+		}
+	}
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+/** Look stable keys up, while the shards are being modified */
+static void* APR_THREAD_FUNC reader_thread_proc(apr_thread_t *thread, void *data)
+{
+	worker_t *reader = data;
+	char key[APT_SHARD_TABLE_MAX_KEY_LENGTH];
+	apr_size_t length;
+	apr_size_t i;
+	while(writers_done == FALSE && reader->status == TRUE) {
+		for(i=0; i<STABLE_COUNT; i++) {
+			length = key_make(key,"s",0,i);
+			if(apt_shard_table_get(reader->table,key,length) != &stable_values[i]) {
+				reader->status = FALSE;
+			}
+		}
+		length = key_make(key,"x",0,0);
+		if(apt_shard_table_get(reader->table,key,length) != NULL) {
+			reader->status = FALSE;
+		}
+	}
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+static apt_bool_t shard_table_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_shard_table_t *table;
+	worker_t workers[WRITER_COUNT + READER_COUNT];
+	apr_thread_t *threads[WRITER_COUNT + READER_COUNT];
+	char key[APT_SHARD_TABLE_MAX_KEY_LENGTH + 2];
+	apr_size_t length;
+	apr_size_t i;
+	apr_status_t rv;
+	apt_bool_t status = TRUE;
+
+	table = apt_shard_table_create(SHARD_COUNT,BUCKET_COUNT,suite->pool);
+	if(!table) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Shard Table");
+		return FALSE;
+	}
+	for(i=0; i<STABLE_COUNT; i++) {
+		length = key_make(key,"s",0,i);
+		apt_shard_table_set(table,key,length,&stable_values[i]);
+	}
+	memset(key,'k',sizeof(key));
+	if(apt_shard_table_set(table,key,sizeof(key),&stable_values[0]) == TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Too Long Key Is Expected to Be Rejected");
+		status = FALSE;
+	}
+
+	writers_done = FALSE;
+	for(i=0; i<WRITER_COUNT + READER_COUNT; i++) {
+		workers[i].table = table;
+		workers[i].id = i;
+		workers[i].status = TRUE;
+		if(apr_thread_create(&threads[i],NULL,i < WRITER_COUNT ? writer_thread_proc : reader_thread_proc,
+				&workers[i],suite->pool) != APR_SUCCESS) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Thread");
+			writers_done = TRUE;
+			while(i) {
+				apr_thread_join(&rv,threads[--i]);
+			}
+			apt_shard_table_destroy(table);
+			return FALSE;
+		}
+	}
+	for(i=0; i<WRITER_COUNT + READER_COUNT; i++) {
+		if(i == WRITER_COUNT) {
+			writers_done = TRUE;
+		}
+		apr_thread_join(&rv,threads[i]);
+		if(workers[i].status == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Lookup by %s [%"APR_SIZE_T_FMT"]",
+				i < WRITER_COUNT ? "Writer" : "Reader",i);
+			status = FALSE;
+		}
+	}
+
+	if(apt_shard_table_count_get(table) != STABLE_COUNT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Count [%"APR_SIZE_T_FMT"]",apt_shard_table_count_get(table));
+		status = FALSE;
+	}
+	apt_shard_table_destroy(table);
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"Shard Table [%s]",
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+apt_test_suite_t* shard_table_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"shard-table",NULL,shard_table_test_run);
+	return suite;
+}
@@ -0,0 +1,217 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include <stdlib.h>
+#include <signal.h>
+#include <apr_shm.h>
+#include <apr_thread_proc.h>
+#include "apt_test_suite.h"
+#include "apt_shm_ring.h"
+#include "apt_log.h"
+#if APR_HAS_FORK
+#include <unistd.h>
+#endif
+
+#define RING_CAPACITY 4096
+#define RECORD_COUNT  100000
+#define RECORD_MAX    300
+
+/** Size of the record of a sequence number, varying, so that records wrap around at any offset */
+static APR_INLINE apr_size_t record_size_get(apr_uint32_t number)
+{
+	return sizeof(apr_uint32_t) + (number * 7919) % RECORD_MAX;
+}
+
+/** Write the record of a sequence number, if there is space */
+static apt_bool_t record_write(apt_shm_ring_t *ring, apr_uint32_t number)
+{
+	apr_size_t size = record_size_get(number);
+	unsigned char *record = apt_shm_ring_reserve(ring,size);
+	if(!record) {
+		return FALSE;
+	}
+	memcpy(record,&number,sizeof(number));
+	memset(record + sizeof(number),(unsigned char)number,size - sizeof(number));
+	apt_shm_ring_commit(ring,size);
+	return TRUE;
+}
+
+/** Check the record of a sequence number */
+static apt_bool_t record_verify(const unsigned char *record, apr_size_t size, apr_uint32_t expected)
+{
+	apr_uint32_t number;
+	apr_size_t i;
+	memcpy(&number,record,sizeof(number));
+	if(number != expected || size != record_size_get(expected)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Record [%u] of [%"APR_SIZE_T_FMT"] bytes, Expected [%u]",number,size,expected);
+		return FALSE;
+	}
+	for(i=sizeof(number); i<size; i++) {
+		if(record[i] != (unsigned char)expected) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Corrupted Record [%u]",expected);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/** Fill the ring up and read it out in turn within the same thread */
+static apt_bool_t shm_ring_sequence_test(apr_pool_t *pool)
+{
+	void *mem = apr_palloc(pool,apt_shm_ring_size_get(RING_CAPACITY));
+	apt_shm_ring_t *ring = apt_shm_ring_create(mem,RING_CAPACITY);
+	apr_uint32_t written = 0;
+	apr_uint32_t read = 0;
+	apr_uint32_t count;
+	const unsigned char *record;
+	apr_size_t size;
+
+	if(apt_shm_ring_reserve(ring,RING_CAPACITY) != NULL) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Reserved Record Exceeding Half of Ring");
+		return FALSE;
+	}
+	while(read < RECORD_COUNT) {
+		while(written < RECORD_COUNT && record_write(ring,written) == TRUE) {
+			written++;
+		}
+		if(apt_shm_ring_count_get(ring) != written - read) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Records [%"APR_SIZE_T_FMT"]",apt_shm_ring_count_get(ring));
+			return FALSE;
+		}
+		/* read a half, so that the ring is filled up from another offset next time */
+		count = written < RECORD_COUNT ? (written - read + 1) / 2 : written - read;
+		while(count--) {
+			record = apt_shm_ring_peek(ring,&size);
+			if(!record || record_verify(record,size,read) == FALSE) {
+				return FALSE;
+			}
+			apt_shm_ring_release(ring);
+			read++;
+		}
+	}
+
+	record_write(ring,0);
+	apt_shm_ring_discard(ring);
+	if(apt_shm_ring_count_get(ring) != 0 || apt_shm_ring_peek(ring,&size) != NULL) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Ring Is Not Empty after Discard");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+#if APR_HAS_FORK
+/** Pass records from a forked process through shared memory, signalled by the doorbell */
+static apt_bool_t shm_ring_process_test(apr_pool_t *pool)
+{
+	apr_shm_t *shm;
+	apr_proc_t proc;
+	apr_exit_why_e why;
+	int exit_code;
+	char *mem;
+	apt_shm_ring_t *ring;
+	apt_doorbell_t *doorbell;
+	apr_uint32_t read = 0;
+	apr_uint32_t waits = 0;
+	const unsigned char *record;
+	apr_size_t size;
+	apt_bool_t status = TRUE;
+
+	if(apr_shm_create(&shm,apt_shm_ring_size_get(RING_CAPACITY) + apt_doorbell_size_get(),NULL,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Anonymous Shared Memory");
+		return FALSE;
+	}
+	mem = apr_shm_baseaddr_get(shm);
+	ring = apt_shm_ring_create(mem,RING_CAPACITY);
+	doorbell = apt_doorbell_create(mem + apt_shm_ring_size_get(RING_CAPACITY));
+	if(!doorbell) {
+		apr_shm_destroy(shm);
+		return FALSE;
+	}
+
+	if(apr_proc_fork(&proc,pool) == APR_INCHILD) {
+		apr_uint32_t written;
+		for(written = 0; written < RECORD_COUNT; written++) {
+			while(record_write(ring,written) == FALSE) {
+				/* the ring is full, wait for the consumer to catch up */
+				apr_thread_yield();
+			}
+			apt_doorbell_ring(doorbell);
+		}
+		_exit(0);
+	}
+
+	while(read < RECORD_COUNT) {
+		record = apt_shm_ring_peek(ring,&size);
+		if(!record) {
+			apt_doorbell_arm(doorbell);
+			if(apt_shm_ring_peek(ring,&size) != NULL) {
+				/* arrived meanwhile, no need to sleep */
+				apt_doorbell_wait(doorbell,0);
+				continue;
+			}
+			waits++;
+			if(apt_doorbell_wait(doorbell,5 * APR_USEC_PER_SEC) == FALSE) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Signal of Record [%u]",read);
+				status = FALSE;
+				break;
+			}
+			continue;
+		}
+		if(record_verify(record,size,read) == FALSE) {
+			status = FALSE;
+			break;
+		}
+		apt_shm_ring_release(ring);
+		read++;
+	}
+
+	if(status == FALSE) {
+		apr_proc_kill(&proc,SIGKILL);
+	}
+	apr_proc_wait(&proc,&exit_code,&why,APR_WAIT);
+	apt_doorbell_destroy(doorbell);
+	apr_shm_destroy(shm);
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,
+		"Received [%u] Records from Process, Slept [%u] Times: %s",
+		read,
+		waits,
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+#endif
+
+static apt_bool_t shm_ring_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_bool_t status = shm_ring_sequence_test(suite->pool);
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"Sequence of [%d] Records: %s",
+		RECORD_COUNT,
+		status == TRUE ? "OK" : "Failed");
+#if APR_HAS_FORK
+	if(shm_ring_process_test(suite->pool) == FALSE) {
+		status = FALSE;
+	}
+#endif
+	return status;
+}
+
+apt_test_suite_t* shm_ring_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"shm-ring",NULL,shm_ring_test_run);
+	return suite;
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+#include "apt_test_suite.h"
+#include "apt_timer_queue.h"
+#include "apt_log.h"
+
+#define TIMER_COUNT      2000
+#define ITERATION_COUNT  200000
+
+typedef struct timer_test_t timer_test_t;
+
+typedef struct {
+	timer_test_t *test;
+	apt_timer_t  *timer;
+	/** Expected time to elapse at (0 if not set) */
+	apr_uint64_t  expires;
+} test_timer_t;
+
+struct timer_test_t {
+	apt_timer_queue_t *queue;
+	test_timer_t       timers[TIMER_COUNT];
+	/** Time elapsed so far */
+	apr_uint64_t       now;
+	/** Time the last timer elapsed at */
+	apr_uint64_t       last;
+	apr_uint32_t       seed;
+	apr_size_t         elapsed;
+	apt_bool_t         status;
+};
+
+static apr_uint32_t random_get(timer_test_t *test, apr_uint32_t range)
+{
+	test->seed = test->seed * 1664525 + 1013904223;
+	return (test->seed >> 8) % range;
+}
+
+static apr_uint32_t timeout_get(timer_test_t *test)
+{
+	/* mostly short timers, but also ones cascaded from the upper levels */
+	switch(random_get(test,4)) {
+		case 0: return 1 + random_get(test,255);
+		case 1: return 1 + random_get(test,65535);
+		case 2: return 1 + random_get(test,1 << 20);
+		default: return 1 + random_get(test,2000);
+	}
+}
+
+static void timer_proc(apt_timer_t *timer, void *obj)
+{
+	test_timer_t *test_timer = obj;
+	timer_test_t *test = test_timer->test;
+	if(!test_timer->expires || test_timer->expires > test->now || test_timer->expires < test->last) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Timer Elapsed at [%"APR_UINT64_T_FMT"]",test_timer->expires);
+		test->status = FALSE;
+	}
+	test->last = test_timer->expires;
+	test->elapsed++;
+	test_timer->expires = 0;
+
+	if(random_get(test,4) == 0) {
+		/* set the timer again from within the callback */
+		apr_uint32_t timeout = timeout_get(test);
+		apt_timer_set(timer,timeout);
+		test_timer->expires = test->last + timeout;
+	}
+}
+
+static apt_bool_t timer_queue_check(timer_test_t *test)
+{
+	apr_size_t i;
+	apr_uint32_t timeout;
+	apr_uint64_t next = 0;
+	for(i=0; i<TIMER_COUNT; i++) {
+		test_timer_t *test_timer = &test->timers[i];
+		if(test_timer->expires) {
+			if(test_timer->expires <= test->now) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Timer Not Elapsed at [%"APR_UINT64_T_FMT"]",test_timer->expires);
+				return FALSE;
+			}
+			if(!next || test_timer->expires < next) {
+				next = test_timer->expires;
+			}
+		}
+	}
+
+	if(apt_timer_queue_timeout_get(test->queue,&timeout) == TRUE) {
+		/* the timeout may be shorter, but never longer than the nearest timer */
+		if(!next || !timeout || test->now + timeout > next) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Wrong Timeout [%u]",timeout);
+			return FALSE;
+		}
+	}
+	else if(next) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Timeout");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t timer_queue_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apr_size_t i;
+	timer_test_t *test = apr_palloc(suite->pool,sizeof(timer_test_t));
+	test->queue = apt_timer_queue_create(suite->pool);
+	test->now = 0;
+	test->last = 0;
+	test->seed = 1;
+	test->elapsed = 0;
+	test->status = TRUE;
+	for(i=0; i<TIMER_COUNT; i++) {
+		test->timers[i].test = test;
+		test->timers[i].timer = apt_timer_create(test->queue,timer_proc,&test->timers[i],suite->pool);
+		test->timers[i].expires = 0;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run [%d] Random Operations on [%d] Timers",ITERATION_COUNT,TIMER_COUNT);
+	for(i=0; i<ITERATION_COUNT && test->status == TRUE; i++) {
+		test_timer_t *test_timer = &test->timers[random_get(test,TIMER_COUNT)];
+		apr_uint32_t action = random_get(test,8);
+		if(action < 4) {
+			apr_uint32_t timeout = timeout_get(test);
+			apt_timer_set(test_timer->timer,timeout);
+			test_timer->expires = test->now + timeout;
+		}
+		else if(action < 5) {
+			if(apt_timer_kill(test_timer->timer) != (test_timer->expires ? TRUE : FALSE)) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Kill Result");
+				test->status = FALSE;
+			}
+			test_timer->expires = 0;
+		}
+		else {
+			/* advance by a tick, by a typical poll interval or by a long idle period */
+			apr_uint32_t elapsed_time = action < 7 ? 1 + random_get(test,50) : 1 + random_get(test,100000);
+			test->now += elapsed_time;
+			test->last = test->now - elapsed_time;
+			apt_timer_queue_advance(test->queue,elapsed_time);
+		}
+
+		if(timer_queue_check(test) == FALSE) {
+			test->status = FALSE;
+		}
+	}
+
+	apt_log(APT_LOG_MARK,test->status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,
+		"Elapsed [%"APR_SIZE_T_FMT"] Timers: %s",
+		test->elapsed,
+		test->status == TRUE ? "OK" : "Failed");
+	apt_timer_queue_destroy(test->queue);
+	return test->status;
+}
+
+apt_test_suite_t* timer_queue_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"timer-queue",NULL,timer_queue_test_run);
+	return suite;
+}
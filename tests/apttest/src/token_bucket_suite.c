@@ -0,0 +1,105 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include "apt_test_suite.h"
+#include "apt_token_bucket.h"
+#include "apt_clock.h"
+#include "apt_log.h"
+
+#define BUCKET_RATE  10
+#define BUCKET_BURST 3
+
+/** Take tokens until the bucket is empty */
+static apr_size_t token_bucket_drain(apt_token_bucket_t *bucket)
+{
+	apr_size_t count = 0;
+	while(apt_token_bucket_take(bucket) == TRUE && count <= BUCKET_RATE) {
+		count++;
+	}
+	return count;
+}
+
+/** Refill the bucket on the simulated clock standing still */
+static apt_bool_t token_bucket_test(apt_clock_t *clock, apr_pool_t *pool)
+{
+	apt_bool_t status = TRUE;
+	apr_size_t count;
+	apt_token_bucket_t *bucket = apt_token_bucket_create(BUCKET_RATE,BUCKET_BURST,pool);
+	if(!bucket) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Token Bucket");
+		return FALSE;
+	}
+
+	/* created full, the burst is taken at once */
+	count = token_bucket_drain(bucket);
+	if(count != BUCKET_BURST) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Burst [%"APR_SIZE_T_FMT"]",count);
+		status = FALSE;
+	}
+
+	/* a token per 1/rate sec, partial tokens are accumulated */
+	apt_sim_clock_advance(clock,APR_USEC_PER_SEC / BUCKET_RATE / 2);
+	if(apt_token_bucket_take(bucket) == TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Token Taken before Refilled");
+		status = FALSE;
+	}
+	apt_sim_clock_advance(clock,APR_USEC_PER_SEC / BUCKET_RATE / 2);
+	count = token_bucket_drain(bucket);
+	if(count != 1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Refill [%"APR_SIZE_T_FMT"]",count);
+		status = FALSE;
+	}
+
+	/* an idle bucket is refilled up to the burst only */
+	apt_sim_clock_advance(clock,10 * APR_USEC_PER_SEC);
+	if(apt_token_bucket_level_get(bucket) != BUCKET_BURST) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Level [%"APR_SIZE_T_FMT"]",apt_token_bucket_level_get(bucket));
+		status = FALSE;
+	}
+	apt_token_bucket_destroy(bucket);
+
+	if(apt_token_bucket_create(0,BUCKET_BURST,pool) != NULL) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Token Bucket of Zero Rate Created");
+		status = FALSE;
+	}
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"Token Bucket [%s]",
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+static apt_bool_t token_bucket_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_bool_t status;
+	apt_clock_t *clock = apt_sim_clock_create(0,suite->pool);
+	if(!clock) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Simulated Clock");
+		return FALSE;
+	}
+	apt_clock_set(clock);
+	status = token_bucket_test(clock,suite->pool);
+	apt_clock_set(NULL);
+	apt_sim_clock_destroy(clock);
+	return status;
+}
+
+apt_test_suite_t* token_bucket_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"token-bucket",NULL,token_bucket_test_run);
+	return suite;
+}
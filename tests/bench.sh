@@ -0,0 +1,189 @@
+#!/bin/sh
+#
+# Run the benchmark suites and compare the results against a baseline.
+#
+# USAGE: bench.sh [-d BUILD_DIR] [-s SRC_DIR] [-o RESULTS] [-b BASELINE]
+#                 [-n RUNS] [-c CPU] [-t THRESHOLD]
+#
+#   -d BUILD_DIR  directory the test programs are built in (default: .)
+#   -s SRC_DIR    directory of the sources of the tests (default: dir of this script)
+#   -o RESULTS    file to write the results to (default: bench-results.tsv)
+#   -b BASELINE   results of an earlier run to compare to (no comparison by default)
+#   -n RUNS       number of runs of every benchmark (default: 5)
+#   -c CPU        CPU to pin the benchmarks to (default: 1, none if empty)
+#   -t THRESHOLD  change in percent a result is considered significant above (default: 5)
+#
+# Every benchmark runs with fixed arguments and seeds, so that the runs differ
+# only in timing. The results are written as tab separated lines of
+# suite, name, metric, unit, median, min, max and number of runs.
+#
+# A change is reported, if the median moves by more than THRESHOLD percent
+# and the ranges (min to max) of the runs of the baseline and of the results
+# do not overlap. Values of units ending in "/s" are the higher the better,
+# the others are the lower the better.
+#
+# The exit status is 1, if a suite fails or a result regresses, 0 otherwise.
+#
+
+build_dir=.
+src_dir=`dirname "$0"`
+results=bench-results.tsv
+baseline=
+runs=5
+cpu=1
+threshold=5
+
+while getopts "d:s:o:b:n:c:t:" opt; do
+	case $opt in
+		d) build_dir=$OPTARG ;;
+		s) src_dir=$OPTARG ;;
+		o) results=$OPTARG ;;
+		b) baseline=$OPTARG ;;
+		n) runs=$OPTARG ;;
+		c) cpu=$OPTARG ;;
+		t) threshold=$OPTARG ;;
+		*) sed -n '5,14p' "$0"; exit 2 ;;
+	esac
+done
+
+build_dir=`cd "$build_dir" && pwd`
+src_dir=`cd "$src_dir" && pwd`
+
+# Benchmarks: program, directory to run in (data is looked up relative to it), suite and its arguments
+benchmarks="
+apttest  apttest  bench all 100000
+mpftest  mpftest  bench all 100 500 3
+mpftest  mpftest  g711 160 100000
+mpftest  mpftest  jitter all 60 1
+mrcptest mrcptest parse-bench 10000
+mrcptest mrcptest parse-bench 10000 lazy
+mrcptest mrcptest replay-bench 10000 v2
+rtsptest rtsptest parse-bench 10000 msg
+"
+
+pin=
+if test -n "$cpu"; then
+	if command -v taskset >/dev/null 2>&1 && taskset -c "$cpu" true >/dev/null 2>&1; then
+		pin="taskset -c $cpu"
+	else
+		echo "Cannot pin to CPU $cpu, the benchmarks are not pinned" >&2
+		cpu=
+	fi
+fi
+
+raw=`mktemp "${TMPDIR:-/tmp}/bench.XXXXXX"` || exit 2
+trap 'rm -f "$raw"' 0
+
+run=1
+while test $run -le $runs; do
+	echo "$benchmarks" | while read program dir suite args; do
+		test -n "$program" || continue
+		if test ! -x "$build_dir/$dir/$program"; then
+			echo "Missing $build_dir/$dir/$program, skip $suite" >&2
+			continue
+		fi
+		echo "Run $run/$runs: $program $suite $args" >&2
+		(cd "$src_dir/$dir" && $pin "$build_dir/$dir/$program" --results "$raw.$program" $suite $args >/dev/null 2>&1)
+		if ! grep "	status	" "$raw.$program" >/dev/null 2>&1; then
+			# the program failed before the suite completed
+			printf "%s\tsuite\tstatus\t0\tbool\n" "$suite" >> "$raw.$program"
+		fi
+		# the suites are named per program, the name of the program tells them apart
+		sed "s/^/$program:/" "$raw.$program" >> "$raw"
+		rm -f "$raw.$program"
+	done
+	run=`expr $run + 1`
+done
+
+{
+	echo "# suite	name	metric	unit	median	min	max	runs"
+	echo "# `date -u '+%Y-%m-%d %H:%M:%S'` `uname -n` cpu=${cpu:-none} runs=$runs"
+	awk -F '\t' '
+	{
+		key = $1 "\t" $2 "\t" $3 "\t" $5
+		if(!(key in count)) {
+			keys[++key_count] = key
+		}
+		values[key, ++count[key]] = $4
+	}
+	END {
+		for(k = 1; k <= key_count; k++) {
+			key = keys[k]
+			n = count[key]
+			# insertion sort of the runs of the result
+			for(i = 1; i <= n; i++) {
+				sorted[i] = values[key, i] + 0
+				for(j = i; j > 1 && sorted[j-1] > sorted[j]; j--) {
+					t = sorted[j]; sorted[j] = sorted[j-1]; sorted[j-1] = t
+				}
+			}
+			median = (n % 2) ? sorted[(n + 1) / 2] : (sorted[n / 2] + sorted[n / 2 + 1]) / 2
+			printf "%s\t%.3f\t%.3f\t%.3f\t%d\n", key, median, sorted[1], sorted[n], n
+		}
+	}' "$raw"
+} > "$results"
+echo "Results are written to $results" >&2
+
+if test -z "$baseline"; then
+	awk -F '\t' '!/^#/ && $4 == "bool" && $6 < 1 { print "FAILED " $1; failed = 1 } END { exit failed }' "$results"
+	exit $?
+fi
+if test ! -f "$baseline"; then
+	echo "No baseline $baseline to compare to, store one by bench.sh -o $baseline" >&2
+	exit 0
+fi
+
+awk -F '\t' -v threshold="$threshold" '
+/^#/ { next }
+FNR == NR {
+	key = $1 "\t" $2 "\t" $3
+	base_median[key] = $5; base_min[key] = $6; base_max[key] = $7
+	next
+}
+{
+	key = $1 "\t" $2 "\t" $3
+	if($4 == "bool") {
+		if($6 < 1) {
+			printf "FAILED      %s\n", $1
+			failed = 1
+		}
+		next
+	}
+	if(!(key in base_median)) {
+		printf "NEW         %-60s %12.3f %s\n", $1 " " $2 " " $3, $5, $4
+		next
+	}
+	seen[key] = 1
+	base = base_median[key]
+	if(base == 0) {
+		next
+	}
+	change = ($5 - base) * 100 / base
+	higher_better = ($4 ~ /\/s$/)
+	overlap = ($6 <= base_max[key] && $7 >= base_min[key])
+	verdict = "same"
+	if((change > threshold || change < -threshold) && !overlap) {
+		if((change > 0) == higher_better) {
+			verdict = "IMPROVED"
+		}
+		else {
+			verdict = "REGRESSED"
+			regressed++
+		}
+	}
+	printf "%-11s %-60s %12.3f -> %12.3f %s (%+.1f%%)\n", verdict, $1 " " $2 " " $3, base, $5, $4, change
+}
+END {
+	for(key in base_median) {
+		if(!(key in seen)) {
+			split(key, field, "\t")
+			if(field[3] != "status") {
+				printf "MISSING     %s\n", field[1] " " field[2] " " field[3]
+			}
+		}
+	}
+	if(regressed) {
+		printf "%d results regressed by more than %s%%\n", regressed, threshold
+	}
+	exit (failed || regressed) ? 1 : 0
+}' "$baseline" "$results"
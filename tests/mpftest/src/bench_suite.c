@@ -0,0 +1,579 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <apr_network_io.h>
+#include "apt_test_suite.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+#include "mpf_engine.h"
+#include "mpf_context.h"
+#include "mpf_termination.h"
+#include "mpf_termination_factory.h"
+#include "mpf_rtp_termination_factory.h"
+#include "mpf_file_termination_factory.h"
+#include "mpf_audio_file_descriptor.h"
+#include "mpf_audio_file_source.h"
+#include "mpf_rtp_descriptor.h"
+#include "mpf_stream.h"
+#include "mpf_codec_manager.h"
+
+#define DEFAULT_CONTEXT_COUNT 100
+#define DEFAULT_TICK_COUNT    500
+#define DEFAULT_LEG_COUNT     3
+
+#define BENCH_IP              "127.0.0.1"
+/* RTP of the contexts is sent by and to the feeder port */
+#define BENCH_FEEDER_PORT     6990
+#define BENCH_RTP_PORT_BASE   7000
+#define BENCH_SAMPLING_RATE   8000
+/* PCMU payload of 20 msec */
+#define BENCH_PTIME           20
+#define BENCH_PAYLOAD_SIZE    (BENCH_SAMPLING_RATE * BENCH_PTIME / 1000)
+#define RTP_HEADER_SIZE       12
+
+/** Topologies of benchmark contexts */
+typedef enum {
+	BENCH_TOPOLOGY_RTP_SINK,   /**< RTP receiver -> engine sink (decoding bridge) */
+	BENCH_TOPOLOGY_FILE_RTP,   /**< file reader -> RTP transmitter (encoding bridge) */
+	BENCH_TOPOLOGY_MIXER,      /**< K sources -> engine sink (mixer) */
+	BENCH_TOPOLOGY_MULTIPLIER, /**< source -> K engine sinks (multiplier) */
+
+	BENCH_TOPOLOGY_COUNT
+} bench_topology_e;
+
+static const char *bench_topology_names[BENCH_TOPOLOGY_COUNT] = {
+	"rtp-sink",
+	"file-rtp",
+	"mixer",
+	"multiplier"
+};
+
+/** Type of media processing object each topology is made of */
+static const char *bench_object_names[BENCH_TOPOLOGY_COUNT] = {
+	"bridge",
+	"bridge",
+	"mixer",
+	"multiplier"
+};
+
+/** Benchmark session (media context of a topology) */
+typedef struct {
+	apr_pool_t         *pool;
+	mpf_context_t      *context;
+	mpf_termination_t **terminations;
+	apr_size_t          termination_count;
+	/** Number of audio frames written to the sinks */
+	apr_size_t          frame_count;
+	/** Address RTP is fed to (RTP receiver only) */
+	apr_sockaddr_t     *rtp_addr;
+	apr_uint16_t        seq_num;
+	apr_uint32_t        timestamp;
+	apr_uint32_t        ssrc;
+} bench_session_t;
+
+/** Benchmark settings and shared objects */
+typedef struct {
+	bench_topology_e           topology;
+	apr_size_t                 context_count;
+	apr_size_t                 tick_count;
+	apr_size_t                 leg_count;
+
+	mpf_codec_manager_t       *codec_manager;
+	mpf_termination_factory_t *rtp_termination_factory;
+	mpf_termination_factory_t *file_termination_factory;
+	mpf_rtp_settings_t        *rtp_settings;
+	/** Socket RTP is sent from and to */
+	apr_socket_t              *feeder;
+	/** Audio read by the file readers (shared, not copied) */
+	apr_byte_t                *audio;
+	apr_size_t                 audio_size;
+	apr_pool_t                *pool;
+	/** Suite the results are added to */
+	apt_test_suite_t          *suite;
+} bench_t;
+
+static const mpf_termination_vtable_t dummy_termination_vtable = {
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+static apt_bool_t dummy_frame_read(mpf_audio_stream_t *stream, mpf_frame_t *frame)
+{
+	frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+	return TRUE;
+}
+
+static apt_bool_t dummy_frame_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame)
+{
+	bench_session_t *session = stream->obj;
+	if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO) {
+		session->frame_count++;
+	}
+	return TRUE;
+}
+
+static const mpf_audio_stream_vtable_t dummy_stream_vtable = {
+	NULL,
+	NULL,
+	NULL,
+	dummy_frame_read,
+	NULL,
+	NULL,
+	dummy_frame_write,
+	NULL
+};
+
+/** Create termination of linear PCM, as engine channels have */
+static mpf_termination_t* dummy_termination_create(bench_t *bench, bench_session_t *session, mpf_stream_direction_e direction)
+{
+	mpf_termination_t *termination;
+	mpf_audio_stream_t *stream = mpf_audio_stream_create(
+						session,
+						&dummy_stream_vtable,
+						mpf_stream_capabilities_create(direction,session->pool),
+						session->pool);
+	if(!stream) {
+		return NULL;
+	}
+	if(direction == STREAM_DIRECTION_RECEIVE) {
+		stream->rx_descriptor = mpf_codec_lpcm_descriptor_create(BENCH_SAMPLING_RATE,1,session->pool);
+	}
+	else {
+		stream->tx_descriptor = mpf_codec_lpcm_descriptor_create(BENCH_SAMPLING_RATE,1,session->pool);
+	}
+
+	termination = mpf_termination_base_create(NULL,session,&dummy_termination_vtable,stream,NULL,session->pool);
+	termination->codec_manager = bench->codec_manager;
+	return termination;
+}
+
+static mpf_rtp_media_descriptor_t* bench_rtp_media_create(mpf_stream_direction_e direction, apr_port_t port, apr_pool_t *pool)
+{
+	mpf_rtp_media_descriptor_t *media = mpf_rtp_media_descriptor_alloc(pool);
+	media->state = MPF_MEDIA_ENABLED;
+	media->direction = direction;
+	apt_string_set(&media->ip,BENCH_IP);
+	media->port = port;
+	return media;
+}
+
+/** Create RTP termination, the remote side of which is the feeder */
+static mpf_termination_t* bench_rtp_termination_create(bench_t *bench, bench_session_t *session, mpf_stream_direction_e direction, apr_port_t port)
+{
+	mpf_codec_descriptor_t *codec_descriptor;
+	mpf_rtp_termination_descriptor_t *descriptor;
+	mpf_termination_t *termination = mpf_termination_create(bench->rtp_termination_factory,session,session->pool);
+	if(!termination) {
+		return NULL;
+	}
+	termination->codec_manager = bench->codec_manager;
+
+	descriptor = mpf_rtp_termination_descriptor_alloc(session->pool);
+	descriptor->audio.settings = bench->rtp_settings;
+	descriptor->audio.local = bench_rtp_media_create(direction,port,session->pool);
+	descriptor->audio.remote = bench_rtp_media_create(
+		direction == STREAM_DIRECTION_RECEIVE ? STREAM_DIRECTION_SEND : STREAM_DIRECTION_RECEIVE,
+		BENCH_FEEDER_PORT,
+		session->pool);
+	mpf_codec_list_init(&descriptor->audio.remote->codec_list,1,session->pool);
+	codec_descriptor = mpf_codec_list_add(&descriptor->audio.remote->codec_list);
+	if(codec_descriptor) {
+		codec_descriptor->payload_type = 0;
+		apt_string_set(&codec_descriptor->name,"PCMU");
+		codec_descriptor->sampling_rate = BENCH_SAMPLING_RATE;
+		codec_descriptor->channel_count = 1;
+	}
+
+	if(mpf_termination_add(termination,descriptor) == FALSE || !termination->audio_stream) {
+		return NULL;
+	}
+	return termination;
+}
+
+/** Create file reader termination of the shared audio */
+static mpf_termination_t* bench_file_termination_create(bench_t *bench, bench_session_t *session)
+{
+	mpf_audio_file_descriptor_t *descriptor;
+	mpf_termination_t *termination = mpf_termination_create(bench->file_termination_factory,session,session->pool);
+	if(!termination) {
+		return NULL;
+	}
+	termination->codec_manager = bench->codec_manager;
+
+	descriptor = apr_palloc(session->pool,sizeof(mpf_audio_file_descriptor_t));
+	descriptor->mask = FILE_READER;
+	descriptor->read_handle = NULL;
+	descriptor->write_handle = NULL;
+	descriptor->max_write_size = 0;
+	descriptor->codec_descriptor = mpf_codec_lpcm_descriptor_create(BENCH_SAMPLING_RATE,1,session->pool);
+	descriptor->read_source = mpf_audio_file_source_create(bench->audio,bench->audio_size);
+	if(!descriptor->read_source) {
+		return NULL;
+	}
+	mpf_termination_add(termination,descriptor);
+	return termination;
+}
+
+static apt_bool_t bench_termination_add(bench_session_t *session, mpf_termination_t *termination)
+{
+	if(!termination) {
+		return FALSE;
+	}
+	session->terminations[session->termination_count++] = termination;
+	return mpf_context_termination_add(session->context,termination);
+}
+
+static bench_session_t* bench_session_create(bench_t *bench, mpf_context_factory_t *factory, apr_size_t index)
+{
+	apr_pool_t *pool = apt_pool_create();
+	apr_size_t capacity = 2;
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+	apr_port_t port = (apr_port_t)(BENCH_RTP_PORT_BASE + 2 * index);
+	bench_session_t *session = apr_palloc(pool,sizeof(bench_session_t));
+	session->pool = pool;
+	session->frame_count = 0;
+	session->rtp_addr = NULL;
+	session->seq_num = 0;
+	session->timestamp = 0;
+	session->ssrc = (apr_uint32_t)(0x1000 + index);
+	session->termination_count = 0;
+
+	if(bench->topology == BENCH_TOPOLOGY_MIXER || bench->topology == BENCH_TOPOLOGY_MULTIPLIER) {
+		capacity = bench->leg_count + 1;
+	}
+	session->terminations = apr_palloc(pool,sizeof(mpf_termination_t*) * capacity);
+	session->context = mpf_context_create(factory,NULL,session,capacity,pool);
+
+	switch(bench->topology) {
+		case BENCH_TOPOLOGY_RTP_SINK:
+			status = bench_termination_add(session,bench_rtp_termination_create(bench,session,STREAM_DIRECTION_RECEIVE,port)) &&
+				bench_termination_add(session,dummy_termination_create(bench,session,STREAM_DIRECTION_SEND));
+			if(status == TRUE &&
+				apr_sockaddr_info_get(&session->rtp_addr,BENCH_IP,APR_INET,port,0,pool) != APR_SUCCESS) {
+				status = FALSE;
+			}
+			break;
+		case BENCH_TOPOLOGY_FILE_RTP:
+			status = bench_termination_add(session,bench_file_termination_create(bench,session)) &&
+				bench_termination_add(session,bench_rtp_termination_create(bench,session,STREAM_DIRECTION_SEND,port));
+			break;
+		case BENCH_TOPOLOGY_MIXER:
+			for(i=0; i<bench->leg_count && status == TRUE; i++) {
+				status = bench_termination_add(session,dummy_termination_create(bench,session,STREAM_DIRECTION_RECEIVE));
+			}
+			if(status == TRUE) {
+				status = bench_termination_add(session,dummy_termination_create(bench,session,STREAM_DIRECTION_SEND));
+			}
+			break;
+		case BENCH_TOPOLOGY_MULTIPLIER:
+			status = bench_termination_add(session,dummy_termination_create(bench,session,STREAM_DIRECTION_RECEIVE));
+			for(i=0; i<bench->leg_count && status == TRUE; i++) {
+				status = bench_termination_add(session,dummy_termination_create(bench,session,STREAM_DIRECTION_SEND));
+			}
+			break;
+		default:
+			status = FALSE;
+			break;
+	}
+	if(status == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Context [%s] #%"APR_SIZE_T_FMT,
+			bench_topology_names[bench->topology],index);
+		mpf_context_destroy(session->context);
+		for(i=0; i<session->termination_count; i++) {
+			mpf_termination_destroy(session->terminations[i]);
+		}
+		apr_pool_destroy(pool);
+		return NULL;
+	}
+
+	/* the first termination is associated with each of the others */
+	for(i=1; i<session->termination_count; i++) {
+		mpf_context_association_add(session->context,session->terminations[0],session->terminations[i]);
+	}
+	mpf_context_topology_apply(session->context);
+	return session;
+}
+
+static void bench_session_destroy(bench_session_t *session)
+{
+	apr_size_t i;
+	for(i=0; i<session->termination_count; i++) {
+		mpf_termination_destroy(session->terminations[i]);
+	}
+	apr_pool_destroy(session->pool);
+}
+
+/** Send the next RTP packet to the receiver of the session */
+static void bench_rtp_feed(bench_t *bench, bench_session_t *session)
+{
+	apr_byte_t packet[RTP_HEADER_SIZE + BENCH_PAYLOAD_SIZE];
+	apr_size_t size = sizeof(packet);
+	apr_size_t i;
+	packet[0] = 0x80;
+	packet[1] = session->seq_num ? 0 : 0x80; /* PCMU, marker on the first packet */
+	packet[2] = (apr_byte_t)(session->seq_num >> 8);
+	packet[3] = (apr_byte_t)session->seq_num;
+	packet[4] = (apr_byte_t)(session->timestamp >> 24);
+	packet[5] = (apr_byte_t)(session->timestamp >> 16);
+	packet[6] = (apr_byte_t)(session->timestamp >> 8);
+	packet[7] = (apr_byte_t)session->timestamp;
+	packet[8] = (apr_byte_t)(session->ssrc >> 24);
+	packet[9] = (apr_byte_t)(session->ssrc >> 16);
+	packet[10] = (apr_byte_t)(session->ssrc >> 8);
+	packet[11] = (apr_byte_t)session->ssrc;
+	for(i=0; i<BENCH_PAYLOAD_SIZE; i++) {
+		packet[RTP_HEADER_SIZE + i] = (apr_byte_t)(session->seq_num + i * 7);
+	}
+	apr_socket_sendto(bench->feeder,session->rtp_addr,0,(const char*)packet,&size);
+	session->seq_num++;
+	session->timestamp += BENCH_PAYLOAD_SIZE;
+}
+
+/** Number of frames each object passes on every tick */
+static apr_size_t bench_object_frame_count(const bench_t *bench)
+{
+	if(bench->topology == BENCH_TOPOLOGY_MIXER || bench->topology == BENCH_TOPOLOGY_MULTIPLIER) {
+		return bench->leg_count;
+	}
+	return 1;
+}
+
+static apt_bool_t bench_run(bench_t *bench)
+{
+	mpf_context_factory_t *factory;
+	bench_session_t **sessions;
+	apr_size_t context_count = 0;
+	apr_size_t frame_count = 0;
+	apr_size_t expected_count;
+	apr_size_t pool_bytes = 0;
+	apr_size_t pool_bytes_grown = 0;
+	apr_size_t i;
+	apr_size_t tick;
+	apr_size_t ticks_per_packet = BENCH_PTIME / CODEC_FRAME_TIME_BASE;
+	apr_time_t start_time;
+	apr_time_t elapsed = 0;
+	apr_time_t max_elapsed = 0;
+	double usec_per_tick;
+	apt_bool_t status = TRUE;
+
+	factory = mpf_context_factory_create(bench->pool);
+	sessions = apr_palloc(bench->pool,sizeof(bench_session_t*) * bench->context_count);
+	for(i=0; i<bench->context_count; i++) {
+		sessions[context_count] = bench_session_create(bench,factory,i);
+		if(!sessions[context_count]) {
+			break;
+		}
+		context_count++;
+	}
+	if(!context_count) {
+		mpf_context_factory_destroy(factory);
+		return FALSE;
+	}
+
+	for(i=0; i<context_count; i++) {
+		pool_bytes += apt_pool_bytes_get(sessions[i]->pool);
+	}
+
+	/* freewheel: the ticks follow each other with no sleeping, feeding RTP is not timed */
+	for(tick=0; tick<bench->tick_count; tick++) {
+		apr_time_t tick_elapsed;
+		if(bench->topology == BENCH_TOPOLOGY_RTP_SINK && (!ticks_per_packet || tick % ticks_per_packet == 0)) {
+			for(i=0; i<context_count; i++) {
+				bench_rtp_feed(bench,sessions[i]);
+			}
+		}
+		start_time = apr_time_now();
+		mpf_context_factory_process(factory);
+		tick_elapsed = apr_time_now() - start_time;
+		elapsed += tick_elapsed;
+		if(tick_elapsed > max_elapsed) {
+			max_elapsed = tick_elapsed;
+		}
+	}
+
+	for(i=0; i<context_count; i++) {
+		frame_count += sessions[i]->frame_count;
+		pool_bytes_grown += apt_pool_bytes_get(sessions[i]->pool);
+	}
+	/* the pools grow by blocks, so the allocations per tick are averaged over the run */
+	pool_bytes_grown = pool_bytes_grown > pool_bytes ? pool_bytes_grown - pool_bytes : 0;
+
+	usec_per_tick = (double)elapsed / bench->tick_count;
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Benchmark [%s] %"APR_SIZE_T_FMT" Contexts x %"APR_SIZE_T_FMT" Ticks [%"APR_SIZE_T_FMT" frames to sinks]",
+		bench_topology_names[bench->topology],context_count,bench->tick_count,frame_count);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Tick: %.1f usec avg, %"APR_TIME_T_FMT" usec max, %.0f contexts/core",
+		usec_per_tick,
+		max_elapsed,
+		usec_per_tick > 0 ? context_count * CODEC_FRAME_TIME_BASE * 1000 / usec_per_tick : 0);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Object [%s]: %.1f ns/frame",
+		bench_object_names[bench->topology],
+		usec_per_tick * 1000 / (context_count * bench_object_frame_count(bench)));
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Allocations: %.1f pool bytes/tick [%"APR_SIZE_T_FMT" bytes held by %"APR_SIZE_T_FMT" contexts]",
+		(double)pool_bytes_grown / bench->tick_count,
+		pool_bytes + pool_bytes_grown,
+		context_count);
+	apt_test_result_add(bench->suite,bench_topology_names[bench->topology],"tick avg",usec_per_tick,"us");
+	apt_test_result_add(bench->suite,bench_topology_names[bench->topology],"tick max",(double)max_elapsed,"us");
+	apt_test_result_add(bench->suite,bench_topology_names[bench->topology],"frame",
+		usec_per_tick * 1000 / (context_count * bench_object_frame_count(bench)),"ns");
+	apt_test_result_add(bench->suite,bench_topology_names[bench->topology],"pool growth",
+		(double)pool_bytes_grown / bench->tick_count,"bytes");
+
+	mpf_context_factory_destroy(factory);
+	for(i=0; i<context_count; i++) {
+		bench_session_destroy(sessions[i]);
+	}
+
+	switch(bench->topology) {
+		case BENCH_TOPOLOGY_RTP_SINK:
+			/* allow for the playout delay of the jitter buffer and for lost packets */
+			expected_count = context_count * bench->tick_count / 2;
+			break;
+		case BENCH_TOPOLOGY_MIXER:
+			expected_count = context_count * bench->tick_count;
+			break;
+		case BENCH_TOPOLOGY_MULTIPLIER:
+			expected_count = context_count * bench->tick_count * bench->leg_count;
+			break;
+		default:
+			expected_count = 0;
+			break;
+	}
+	if(frame_count < expected_count || context_count < bench->context_count) {
+		status = FALSE;
+	}
+	return status;
+}
+
+static apt_bool_t bench_topology_find(const char *name, bench_topology_e *topology)
+{
+	int i;
+	for(i=0; i<BENCH_TOPOLOGY_COUNT; i++) {
+		if(strcasecmp(name,bench_topology_names[i]) == 0) {
+			*topology = (bench_topology_e)i;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static apt_bool_t bench_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	bench_t *bench;
+	mpf_rtp_config_t *rtp_config;
+	apr_sockaddr_t *feeder_addr;
+	bench_topology_e topology = BENCH_TOPOLOGY_RTP_SINK;
+	apt_bool_t all = TRUE;
+	apt_bool_t status = TRUE;
+	apr_size_t i;
+	int t;
+
+	bench = apr_palloc(suite->pool,sizeof(bench_t));
+	bench->pool = suite->pool;
+	bench->suite = suite;
+	bench->context_count = DEFAULT_CONTEXT_COUNT;
+	bench->tick_count = DEFAULT_TICK_COUNT;
+	bench->leg_count = DEFAULT_LEG_COUNT;
+	if(argc > 0 && strcasecmp(argv[0],"all") != 0) {
+		if(bench_topology_find(argv[0],&topology) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Arguments: [rtp-sink|file-rtp|mixer|multiplier|all] [context count] [tick count] [legs]");
+			return FALSE;
+		}
+		all = FALSE;
+	}
+	if(argc > 1) {
+		bench->context_count = atol(argv[1]);
+	}
+	if(argc > 2) {
+		bench->tick_count = atol(argv[2]);
+	}
+	if(argc > 3) {
+		bench->leg_count = atol(argv[3]);
+	}
+	if(!bench->context_count || !bench->tick_count || bench->leg_count < 2) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Arguments: [rtp-sink|file-rtp|mixer|multiplier|all] [context count] [tick count] [legs]");
+		return FALSE;
+	}
+
+	bench->codec_manager = mpf_engine_codec_manager_create(suite->pool);
+	if(!bench->codec_manager) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Codec Manager");
+		return FALSE;
+	}
+
+	rtp_config = mpf_rtp_config_alloc(suite->pool);
+	apt_string_set(&rtp_config->ip,BENCH_IP);
+	rtp_config->rtp_port_min = BENCH_RTP_PORT_BASE;
+	rtp_config->rtp_port_max = (apr_port_t)(BENCH_RTP_PORT_BASE + 2 * bench->context_count);
+	bench->rtp_termination_factory = mpf_rtp_termination_factory_create(rtp_config,suite->pool);
+	bench->file_termination_factory = mpf_file_termination_factory_create(suite->pool);
+
+	/* fixed playout delay, the media clock runs faster than the wall clock */
+	bench->rtp_settings = mpf_rtp_settings_alloc(suite->pool);
+	bench->rtp_settings->ptime = BENCH_PTIME;
+	bench->rtp_settings->jb_config.adaptive = 0;
+	bench->rtp_settings->jb_config.time_skew_detection = 0;
+	bench->rtp_settings->jb_config.min_playout_delay = 0;
+	bench->rtp_settings->jb_config.initial_playout_delay = BENCH_PTIME;
+	bench->rtp_settings->jb_config.max_playout_delay = 10 * BENCH_PTIME;
+	mpf_codec_manager_codec_list_load(bench->codec_manager,&bench->rtp_settings->codec_list,"PCMU",suite->pool);
+
+	/* the file readers never reach the end of the audio */
+	bench->audio_size = (bench->tick_count + 1) * BENCH_SAMPLING_RATE / 1000 * CODEC_FRAME_TIME_BASE * sizeof(apr_int16_t);
+	bench->audio = apr_palloc(suite->pool,bench->audio_size);
+	for(i=0; i<bench->audio_size; i++) {
+		bench->audio[i] = (apr_byte_t)(i * 397 >> 3);
+	}
+
+	if(apr_sockaddr_info_get(&feeder_addr,BENCH_IP,APR_INET,BENCH_FEEDER_PORT,0,suite->pool) != APR_SUCCESS ||
+		apr_socket_create(&bench->feeder,feeder_addr->family,SOCK_DGRAM,APR_PROTO_UDP,suite->pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create RTP Feeder");
+		return FALSE;
+	}
+	apr_socket_opt_set(bench->feeder,APR_SO_REUSEADDR,1);
+	if(apr_socket_bind(bench->feeder,feeder_addr) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Bind RTP Feeder %s:%d",BENCH_IP,BENCH_FEEDER_PORT);
+		apr_socket_close(bench->feeder);
+		return FALSE;
+	}
+
+	for(t=0; t<BENCH_TOPOLOGY_COUNT; t++) {
+		if(all == FALSE && t != topology) {
+			continue;
+		}
+		bench->topology = (bench_topology_e)t;
+		if(bench_run(bench) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Benchmark [%s] Failed",bench_topology_names[t]);
+			status = FALSE;
+		}
+	}
+
+	apr_socket_close(bench->feeder);
+	return status;
+}
+
+apt_test_suite_t* bench_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"bench",NULL,bench_test_run);
+	return suite;
+}
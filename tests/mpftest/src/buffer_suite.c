@@ -0,0 +1,179 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include <string.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_buffer.h"
+
+#define FRAME_SIZE     320
+/* a chunk is not a multiple of the frame size, frames span chunks */
+#define CHUNK_SIZE     1000
+#define CHUNK_COUNT    8
+/* keep two frames ahead */
+#define WATERMARK_SIZE (2 * FRAME_SIZE)
+/* holds a chunk and the watermark, but not two chunks */
+#define RING_CAPACITY  (CHUNK_SIZE + WATERMARK_SIZE)
+
+typedef struct buffer_producer_t buffer_producer_t;
+struct buffer_producer_t {
+	apr_size_t written;
+	apr_size_t requests;
+};
+
+static void chunk_fill(apr_byte_t *chunk, apr_size_t number)
+{
+	apr_size_t i;
+	for(i=0; i<CHUNK_SIZE; i++) {
+		chunk[i] = (apr_byte_t)(number * CHUNK_SIZE + i);
+	}
+}
+
+/** Write the next chunk, once requested, as a synthesizer engine does */
+static void buffer_on_watermark(mpf_buffer_t *buffer, void *obj)
+{
+	buffer_producer_t *producer = obj;
+	apr_byte_t chunk[CHUNK_SIZE];
+	producer->requests++;
+	if(producer->written < CHUNK_COUNT) {
+		chunk_fill(chunk,producer->written);
+		mpf_buffer_audio_write(buffer,chunk,CHUNK_SIZE);
+		producer->written++;
+	}
+}
+
+static apt_bool_t buffer_test(mpf_buffer_t *buffer, const char *name)
+{
+	buffer_producer_t producer;
+	apr_byte_t data[FRAME_SIZE];
+	apr_byte_t chunk[CHUNK_SIZE];
+	mpf_frame_t frame;
+	apr_size_t offset = 0;
+	apr_size_t frames = 0;
+	apt_bool_t status = TRUE;
+
+	producer.written = 0;
+	producer.requests = 0;
+	mpf_buffer_watermark_set(buffer,WATERMARK_SIZE,buffer_on_watermark,&producer);
+
+	/* the first chunk starts the stream, the rest is written on request */
+	buffer_on_watermark(buffer,&producer);
+	producer.requests = 0;
+
+	while(offset < CHUNK_SIZE * CHUNK_COUNT && status == TRUE) {
+		apr_size_t i;
+		frame.type = MEDIA_FRAME_TYPE_NONE;
+		frame.codec_frame.buffer = data;
+		frame.codec_frame.size = FRAME_SIZE;
+		mpf_buffer_frame_read(buffer,&frame);
+		frames++;
+		for(i=0; i<FRAME_SIZE && offset < CHUNK_SIZE * CHUNK_COUNT; i++, offset++) {
+			if(offset % CHUNK_SIZE == 0) {
+				chunk_fill(chunk,offset / CHUNK_SIZE);
+			}
+			if(data[i] != chunk[offset % CHUNK_SIZE]) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch at Offset %"APR_SIZE_T_FMT,offset);
+				status = FALSE;
+				break;
+			}
+		}
+		if(frames > 2 * CHUNK_SIZE * CHUNK_COUNT / FRAME_SIZE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Buffer Underrun, Producer Not Requested");
+			status = FALSE;
+		}
+	}
+
+	/* every chunk but the first is requested once, plus the request once the producer is done */
+	if(status == TRUE && producer.requests != CHUNK_COUNT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Requests %"APR_SIZE_T_FMT,producer.requests);
+		status = FALSE;
+	}
+	if(status == TRUE && mpf_buffer_get_size(buffer) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Buffer Not Drained");
+		status = FALSE;
+	}
+
+	mpf_buffer_destroy(buffer);
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"%s Buffer: Read %"APR_SIZE_T_FMT" Frames by %"APR_SIZE_T_FMT" Requests [%s]",
+		name,
+		frames,
+		producer.requests,
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+/** Check that a bounded buffer rejects a write beyond its capacity and restarts empty */
+static apt_bool_t buffer_bounded_test(apr_pool_t *pool)
+{
+	apr_byte_t data[FRAME_SIZE];
+	apr_byte_t chunk[CHUNK_SIZE];
+	mpf_frame_t frame;
+	apt_bool_t status = TRUE;
+	mpf_buffer_t *buffer = mpf_buffer_bounded_create(RING_CAPACITY,pool);
+	if(!buffer) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Bounded Buffer");
+		return FALSE;
+	}
+
+	chunk_fill(chunk,0);
+	if(mpf_buffer_audio_write(buffer,chunk,CHUNK_SIZE) == FALSE ||
+		mpf_buffer_audio_write(buffer,chunk,CHUNK_SIZE) == TRUE ||
+		mpf_buffer_get_size(buffer) != CHUNK_SIZE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Write beyond Capacity Not Rejected");
+		status = FALSE;
+	}
+
+	mpf_buffer_event_write(buffer,MEDIA_FRAME_TYPE_EVENT);
+	mpf_buffer_restart(buffer);
+	frame.type = MEDIA_FRAME_TYPE_NONE;
+	frame.codec_frame.buffer = data;
+	frame.codec_frame.size = FRAME_SIZE;
+	mpf_buffer_frame_read(buffer,&frame);
+	if(status == TRUE && (frame.type != MEDIA_FRAME_TYPE_NONE || mpf_buffer_get_size(buffer) != 0)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Data Left after Restart");
+		status = FALSE;
+	}
+	if(status == TRUE && mpf_buffer_space_get(buffer) < RING_CAPACITY) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Space Not Released after Restart");
+		status = FALSE;
+	}
+
+	mpf_buffer_destroy(buffer);
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"Bounded Buffer Backpressure [%s]",
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+static apt_bool_t buffer_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_bool_t status = buffer_test(mpf_buffer_create(suite->pool),"Unlimited");
+	if(buffer_test(mpf_buffer_bounded_create(RING_CAPACITY,suite->pool),"Bounded") == FALSE) {
+		status = FALSE;
+	}
+	if(buffer_bounded_test(suite->pool) == FALSE) {
+		status = FALSE;
+	}
+	return status;
+}
+
+apt_test_suite_t* buffer_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"buffer",NULL,buffer_test_run);
+	return suite;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include <math.h>
+#include <string.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_dtmf_generator.h"
+#include "mpf_codec_descriptor.h"
+
+#ifndef M_PI
+#	define M_PI 3.141592653589793238462643
+#endif
+
+#define TONE_MS     100
+#define SILENCE_MS  50
+#define DIGITS      "1#D"
+/* amplitude of single sine wave of the generator */
+#define AMPLITUDE   12288
+
+/** Frequency pairs of the digits above */
+static const double digit_freq[][2] = {
+	{697, 1209},  /* 1 */
+	{941, 1477},  /* # */
+	{941, 1633}   /* D */
+};
+
+/** Generate the digits and compare the tones to the dual sine waves */
+static apt_bool_t dtmf_generator_test(apr_uint16_t sampling_rate, apr_pool_t *pool)
+{
+	mpf_audio_stream_t *stream;
+	mpf_codec_descriptor_t *descriptor;
+	mpf_dtmf_generator_t *generator;
+	mpf_frame_t frame;
+	apr_size_t samples_per_frame = sampling_rate / 1000 * CODEC_FRAME_TIME_BASE;
+	apr_int16_t *samples;
+	apr_size_t digit = 0;
+	apr_size_t t = 0;
+	apr_size_t tone_frames = 0;
+	apr_size_t mismatches = 0;
+	apr_size_t i;
+	apt_bool_t in_tone = FALSE;
+	apt_bool_t status;
+
+	descriptor = apr_pcalloc(pool,sizeof(mpf_codec_descriptor_t));
+	descriptor->sampling_rate = sampling_rate;
+	descriptor->channel_count = 1;
+	stream = apr_pcalloc(pool,sizeof(mpf_audio_stream_t));
+	stream->rx_descriptor = descriptor;
+
+	generator = mpf_dtmf_generator_create_ex(stream,MPF_DTMF_GENERATOR_INBAND,TONE_MS,SILENCE_MS,pool);
+	if(!generator) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create DTMF Generator");
+		return FALSE;
+	}
+	mpf_dtmf_generator_enqueue(generator,DIGITS);
+
+	samples = apr_palloc(pool,samples_per_frame * sizeof(apr_int16_t));
+	while(mpf_dtmf_generator_sending(generator) == TRUE || in_tone == TRUE) {
+		frame.type = MEDIA_FRAME_TYPE_NONE;
+		frame.marker = MPF_MARKER_NONE;
+		frame.codec_frame.buffer = samples;
+		frame.codec_frame.size = samples_per_frame * sizeof(apr_int16_t);
+		if(mpf_dtmf_generator_put_frame(generator,&frame) == FALSE || !(frame.type & MEDIA_FRAME_TYPE_AUDIO)) {
+			if(in_tone == TRUE) {
+				/* the tone of the digit is over */
+				in_tone = FALSE;
+				digit++;
+			}
+			if(mpf_dtmf_generator_sending(generator) == FALSE) break;
+			continue;
+		}
+		if(in_tone == FALSE) {
+			in_tone = TRUE;
+			t = 0;
+		}
+		if(digit >= sizeof(digit_freq)/sizeof(digit_freq[0])) {
+			mismatches++;
+			break;
+		}
+		tone_frames++;
+		for(i=0; i<samples_per_frame; i++, t++) {
+			double expected = AMPLITUDE * (sin(2 * M_PI * digit_freq[digit][0] * t / sampling_rate) +
+				sin(2 * M_PI * digit_freq[digit][1] * t / sampling_rate));
+			if(fabs(samples[i] - expected) > 1.0) {
+				mismatches++;
+			}
+		}
+	}
+	mpf_dtmf_generator_destroy(generator);
+
+	status = (!mismatches && digit == sizeof(digit_freq)/sizeof(digit_freq[0]) &&
+		tone_frames == digit * TONE_MS / CODEC_FRAME_TIME_BASE) ? TRUE : FALSE;
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,
+		"Generate DTMF [%s] at [%hu Hz] digits [%"APR_SIZE_T_FMT"] frames [%"APR_SIZE_T_FMT"] mismatches [%"APR_SIZE_T_FMT"] [%s]",
+		DIGITS,sampling_rate,digit,tone_frames,mismatches,
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+static apt_bool_t dtmf_generator_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_bool_t status = TRUE;
+	/* the second run at 8 kHz takes the tables built by the first one */
+	static const apr_uint16_t sampling_rates[] = {8000, 16000, 8000};
+	apr_size_t i;
+	for(i=0; i<sizeof(sampling_rates)/sizeof(sampling_rates[0]); i++) {
+		if(dtmf_generator_test(sampling_rates[i],suite->pool) == FALSE) {
+			status = FALSE;
+		}
+	}
+	return status;
+}
+
+apt_test_suite_t* dtmf_generator_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"dtmf-generator",NULL,dtmf_generator_test_run);
+	return suite;
+}
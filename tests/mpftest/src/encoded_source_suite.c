@@ -0,0 +1,126 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <string.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_encoded_source.h"
+
+/* 10 msec of G.711 at 8 kHz */
+#define FRAME_SIZE    80
+#define FRAME_SAMPLES 80
+#define DEPTH         8
+
+static apt_bool_t encoded_frame_write(mpf_encoded_source_t *source, apr_uint32_t timestamp)
+{
+	apr_byte_t payload[FRAME_SIZE];
+	/* the payload is marked by the timestamp to check the order by */
+	memset(payload,(apr_byte_t)(timestamp / FRAME_SAMPLES),FRAME_SIZE);
+	return mpf_encoded_source_write(source,payload,FRAME_SIZE,timestamp);
+}
+
+/** Read frame, return the timestamp the payload is marked by, or -1 for silence */
+static int encoded_frame_read(mpf_audio_stream_t *stream)
+{
+	apr_byte_t buffer[FRAME_SIZE];
+	mpf_frame_t frame;
+	frame.type = MEDIA_FRAME_TYPE_NONE;
+	frame.marker = MPF_MARKER_NONE;
+	frame.codec_frame.buffer = buffer;
+	frame.codec_frame.size = FRAME_SIZE;
+	stream->vtable->read_frame(stream,&frame);
+	if((frame.type & MEDIA_FRAME_TYPE_AUDIO) == 0) {
+		return -1;
+	}
+	return buffer[0] * FRAME_SAMPLES;
+}
+
+static apt_bool_t encoded_source_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	/* timestamps expected to be played out, -1 for silence */
+	static const int expected[] = {0, FRAME_SAMPLES, -1, FRAME_SAMPLES * 3, FRAME_SAMPLES * 4, FRAME_SAMPLES * 100, -1};
+	mpf_codec_descriptor_t descriptor;
+	mpf_audio_stream_t *stream;
+	mpf_encoded_source_t *source;
+	mpf_encoded_source_stat_t stat;
+	int played[sizeof(expected) / sizeof(expected[0])];
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+
+	mpf_codec_descriptor_init(&descriptor);
+	apt_string_set(&descriptor.name,"PCMU");
+	descriptor.sampling_rate = 8000;
+	descriptor.channel_count = 1;
+	stream = mpf_encoded_source_create(&descriptor,DEPTH,suite->pool);
+	source = stream ? mpf_encoded_source_get(stream) : NULL;
+	if(!source) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Encoded Source");
+		return FALSE;
+	}
+	stream->vtable->open_rx(stream,NULL);
+
+	/* the third frame is missing */
+	encoded_frame_write(source,0);
+	encoded_frame_write(source,FRAME_SAMPLES);
+	encoded_frame_write(source,FRAME_SAMPLES * 3);
+	for(i=0; i<4; i++) {
+		played[i] = encoded_frame_read(stream);
+	}
+	/* the missing frame arrives late, then a new talk spurt far ahead */
+	encoded_frame_write(source,FRAME_SAMPLES * 2);
+	encoded_frame_write(source,FRAME_SAMPLES * 4);
+	played[4] = encoded_frame_read(stream);
+	encoded_frame_write(source,FRAME_SAMPLES * 100);
+	played[5] = encoded_frame_read(stream);
+	played[6] = encoded_frame_read(stream);
+
+	for(i=0; i<sizeof(expected) / sizeof(expected[0]); i++) {
+		if(played[i] != expected[i]) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Frame [%"APR_SIZE_T_FMT"] timestamp [%d] expected [%d]",
+				i,played[i],expected[i]);
+			status = FALSE;
+		}
+	}
+
+	/* the writer never waits for a full ring */
+	for(i=0; i<DEPTH; i++) {
+		encoded_frame_write(source,(apr_uint32_t)(FRAME_SAMPLES * (200 + i)));
+	}
+	if(encoded_frame_write(source,FRAME_SAMPLES * (200 + DEPTH)) == TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Frame Written to Full Ring");
+		status = FALSE;
+	}
+
+	mpf_encoded_source_stat_get(source,&stat);
+	if(stat.played != 5 || stat.late != 1 || stat.gaps != 2 || stat.resyncs != 1 || stat.overruns != 1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Stat played [%u] late [%u] gaps [%u] resyncs [%u] overruns [%u]",
+			stat.played,stat.late,stat.gaps,stat.resyncs,stat.overruns);
+		status = FALSE;
+	}
+	stream->vtable->close_rx(stream);
+
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"Play Out Encoded Frames [%s]",
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+apt_test_suite_t* encoded_source_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"encoded-source",NULL,encoded_source_test_run);
+	return suite;
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <string.h>
+#include <apr_file_io.h>
+#include <apr_file_info.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_audio_file_encoder.h"
+#include "mpf_g711_kernel.h"
+
+#define SAMPLING_RATE 8000
+#define FRAME_SAMPLES 160
+/* 2.02 sec, the last Opus packet is padded */
+#define FRAME_COUNT   101
+
+static APR_INLINE apr_uint32_t le32_get(const apr_byte_t *buf)
+{
+	return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((apr_uint32_t)buf[3] << 24);
+}
+
+static void frame_fill(apr_int16_t *frame, apr_size_t number)
+{
+	apr_size_t i;
+	for(i=0; i<FRAME_SAMPLES; i++) {
+		/* sawtooth over the whole range of samples */
+		frame[i] = (apr_int16_t)((number * FRAME_SAMPLES + i) * 397);
+	}
+}
+
+/** Read the whole file */
+static apr_byte_t* file_read(const char *file_path, apr_size_t *size, apr_pool_t *pool)
+{
+	apr_file_t *file;
+	apr_finfo_t finfo;
+	apr_byte_t *data;
+	if(apr_file_open(&file,file_path,APR_FOPEN_READ | APR_FOPEN_BINARY,APR_OS_DEFAULT,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	if(apr_file_info_get(&finfo,APR_FINFO_SIZE,file) != APR_SUCCESS) {
+		apr_file_close(file);
+		return NULL;
+	}
+	*size = (apr_size_t)finfo.size;
+	data = apr_palloc(pool,*size + 1);
+	if(apr_file_read_full(file,data,*size,NULL) != APR_SUCCESS) {
+		apr_file_close(file);
+		return NULL;
+	}
+	apr_file_close(file);
+	return data;
+}
+
+/** Check the content of the encoded file */
+static apt_bool_t encoder_file_verify(mpf_audio_file_format_e format, const apr_byte_t *data, apr_size_t size)
+{
+	const apr_size_t sample_count = FRAME_COUNT * FRAME_SAMPLES;
+	switch(format) {
+		case MPF_AUDIO_FILE_FORMAT_WAV:
+		{
+			apr_int16_t frame[FRAME_SAMPLES];
+			frame_fill(frame,0);
+			return (size == 44 + sample_count * 2 &&
+				memcmp(data,"RIFF",4) == 0 && le32_get(data + 4) == size - 8 &&
+				memcmp(data + 36,"data",4) == 0 && le32_get(data + 40) == sample_count * 2 &&
+				(apr_int16_t)(data[46] | (data[47] << 8)) == frame[1]) ? TRUE : FALSE;
+		}
+		case MPF_AUDIO_FILE_FORMAT_ULAW:
+		{
+			apr_int16_t frame[FRAME_SAMPLES];
+			apr_byte_t code[FRAME_SAMPLES];
+			frame_fill(frame,0);
+			mpf_g711_kernel_get(MPF_G711_KERNEL_SCALAR)->ulaw_encode(frame,code,FRAME_SAMPLES);
+			return (size == 58 + sample_count &&
+				le32_get(data + 46) == sample_count &&
+				memcmp(data + 50,"data",4) == 0 && le32_get(data + 54) == sample_count &&
+				memcmp(data + 58,code,FRAME_SAMPLES) == 0) ? TRUE : FALSE;
+		}
+		case MPF_AUDIO_FILE_FORMAT_OPUS:
+			/* BOS page of the identification header, EOS flag on the last page */
+			return (size > 28 + 8 && memcmp(data,"OggS",4) == 0 && data[5] == 0x02 &&
+				memcmp(data + 28,"OpusHead",8) == 0 && size < sample_count * 2) ? TRUE : FALSE;
+		default:
+			break;
+	}
+	return FALSE;
+}
+
+static apt_bool_t encoder_test(mpf_audio_file_format_e format, const char *dir_path, apr_pool_t *pool)
+{
+	apr_int16_t frame[FRAME_SAMPLES];
+	apt_file_writer_t *writer;
+	apt_file_encoder_t *encoder;
+	char *file_path;
+	apr_byte_t *data;
+	apr_size_t size;
+	apr_size_t i;
+	apt_bool_t status;
+
+	encoder = mpf_audio_file_encoder_create(format,SAMPLING_RATE);
+	if(!encoder) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Encoder [%s]",mpf_audio_file_format_ext_get(format));
+		return FALSE;
+	}
+	/* a small block size makes the encoder called many times */
+	writer = apt_file_writer_create(NULL,4096,2,FALSE,pool);
+	if(!writer) {
+		encoder->vtable->close(encoder,NULL);
+		return FALSE;
+	}
+	apr_filepath_merge(&file_path,dir_path,
+		apr_psprintf(pool,"mpftest-encoder-%d.%s",format,mpf_audio_file_format_ext_get(format)),
+		APR_FILEPATH_NATIVE,pool);
+	if(apt_file_writer_open(writer,file_path,encoder) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open File [%s]",file_path);
+		apt_file_writer_destroy(writer);
+		return FALSE;
+	}
+	for(i=0; i<FRAME_COUNT; i++) {
+		frame_fill(frame,i);
+		apt_file_writer_write(writer,frame,sizeof(frame));
+	}
+	apt_file_writer_close(writer);
+	apt_file_writer_destroy(writer);
+
+	status = FALSE;
+	data = file_read(file_path,&size,pool);
+	if(data) {
+		status = encoder_file_verify(format,data,size);
+	}
+	apr_file_remove(file_path,pool);
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"Encode [%s] %"APR_SIZE_T_FMT" bytes [%s]",
+		mpf_audio_file_format_ext_get(format),
+		data ? size : 0,
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+static apt_bool_t encoder_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	const char *dir_path;
+	apt_bool_t status = TRUE;
+	int format;
+
+	if(apr_temp_dir_get(&dir_path,suite->pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Get Temp Dir");
+		return FALSE;
+	}
+	if(mpf_audio_file_encoder_create(MPF_AUDIO_FILE_FORMAT_PCM,SAMPLING_RATE) != NULL) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"PCM is Expected to Be Written As Is");
+		status = FALSE;
+	}
+
+	for(format = MPF_AUDIO_FILE_FORMAT_WAV; format < MPF_AUDIO_FILE_FORMAT_COUNT; format++) {
+		if(mpf_audio_file_format_is_supported(format) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Skip Unsupported Format [%s]",mpf_audio_file_format_ext_get(format));
+			continue;
+		}
+		if(encoder_test(format,dir_path,suite->pool) == FALSE) {
+			status = FALSE;
+		}
+	}
+	return status;
+}
+
+apt_test_suite_t* encoder_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"encoder",NULL,encoder_test_run);
+	return suite;
+}
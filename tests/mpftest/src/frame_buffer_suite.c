@@ -0,0 +1,120 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <apr_thread_proc.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_frame_buffer.h"
+
+#define FRAME_SIZE  160
+#define FRAME_COUNT 20
+#define WRITE_COUNT 100000
+
+/** Write frames tagged by their number, retry once the buffer is full */
+static void* APR_THREAD_FUNC frame_buffer_producer_proc(apr_thread_t *thread, void *data)
+{
+	mpf_frame_buffer_t *buffer = data;
+	apr_uint32_t samples[FRAME_SIZE / sizeof(apr_uint32_t)];
+	mpf_frame_t frame;
+	apr_uint32_t i;
+
+	frame.type = MEDIA_FRAME_TYPE_AUDIO;
+	frame.marker = MPF_MARKER_NONE;
+	frame.codec_frame.buffer = samples;
+	frame.codec_frame.size = FRAME_SIZE;
+	for(i=1; i<=WRITE_COUNT; i++) {
+		samples[0] = i;
+		while(mpf_frame_buffer_write(buffer,&frame) == FALSE) {
+			apr_thread_yield();
+		}
+	}
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+static apt_bool_t frame_buffer_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	mpf_frame_buffer_t *buffer;
+	apr_thread_t *thread;
+	apr_status_t rv;
+	apr_uint32_t samples[FRAME_SIZE / sizeof(apr_uint32_t)];
+	mpf_frame_t frame;
+	apr_uint32_t last = 0;
+	apr_size_t overruns;
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+
+	buffer = mpf_frame_buffer_create(FRAME_SIZE,FRAME_COUNT,suite->pool);
+
+	/* a full buffer drops the frames and counts them */
+	samples[0] = 0;
+	frame.type = MEDIA_FRAME_TYPE_AUDIO;
+	frame.marker = MPF_MARKER_NONE;
+	frame.codec_frame.buffer = samples;
+	frame.codec_frame.size = FRAME_SIZE;
+	for(i=0; i<FRAME_COUNT + 2; i++) {
+		mpf_frame_buffer_write(buffer,&frame);
+	}
+	overruns = mpf_frame_buffer_overruns_get(buffer);
+	if(overruns != 2) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Overruns [%"APR_SIZE_T_FMT"]",overruns);
+		status = FALSE;
+	}
+	/* restart skips the written frames */
+	mpf_frame_buffer_restart(buffer);
+	frame.codec_frame.buffer = samples;
+	mpf_frame_buffer_read(buffer,&frame);
+	if(frame.type != MEDIA_FRAME_TYPE_NONE || mpf_frame_buffer_underruns_get(buffer) != 1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Frames Are Not Skipped on Restart");
+		status = FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Stream [%d] Frames through [%d] Frame Buffer",WRITE_COUNT,FRAME_COUNT);
+	if(apr_thread_create(&thread,NULL,frame_buffer_producer_proc,buffer,suite->pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Producer Thread");
+		return FALSE;
+	}
+	while(last < WRITE_COUNT) {
+		frame.codec_frame.buffer = samples;
+		frame.codec_frame.size = FRAME_SIZE;
+		mpf_frame_buffer_read(buffer,&frame);
+		if(frame.type == MEDIA_FRAME_TYPE_NONE) {
+			apr_thread_yield();
+			continue;
+		}
+		if(samples[0] != last + 1) {
+			/* frames must be read in order, none lost */
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Frame [%u] after [%u]",samples[0],last);
+			status = FALSE;
+			break;
+		}
+		last = samples[0];
+	}
+	apr_thread_join(&rv,thread);
+	mpf_frame_buffer_destroy(buffer);
+
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"Frame Buffer [%s]",
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+apt_test_suite_t* frame_buffer_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"frame-buffer",NULL,frame_buffer_test_run);
+	return suite;
+}
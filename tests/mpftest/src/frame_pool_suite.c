@@ -0,0 +1,80 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+
+#include <string.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_frame_pool.h"
+
+/* frames of 8 kHz and 16 kHz L16, 48 kHz stereo, and one too large to be pooled */
+static const apr_size_t frame_sizes[] = {320, 640, 3840, 100000};
+#define FRAME_SIZE_COUNT (sizeof(frame_sizes) / sizeof(frame_sizes[0]))
+#define APPLY_COUNT      100
+
+static apt_bool_t frame_pool_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	mpf_frame_pool_t *frame_pool;
+	void *buffers[FRAME_SIZE_COUNT];
+	void *first[FRAME_SIZE_COUNT];
+	apr_size_t block_count = 0;
+	apr_size_t i,j;
+	apt_bool_t status = TRUE;
+
+	frame_pool = mpf_frame_pool_create(suite->pool);
+	/* topology applied and destroyed over again */
+	for(j=0; j<APPLY_COUNT && status == TRUE; j++) {
+		for(i=0; i<FRAME_SIZE_COUNT; i++) {
+			buffers[i] = mpf_frame_pool_buffer_get(frame_pool,frame_sizes[i],suite->pool);
+			if(((apr_uintptr_t)buffers[i] % MPF_FRAME_POOL_ALIGNMENT) != 0) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unaligned Buffer of [%"APR_SIZE_T_FMT"] bytes",frame_sizes[i]);
+				status = FALSE;
+			}
+			/* the whole buffer is writable */
+			memset(buffers[i],(int)j,frame_sizes[i]);
+			if(j == 0) {
+				first[i] = buffers[i];
+			}
+			else if(i < FRAME_SIZE_COUNT - 1 && buffers[i] != first[i]) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Buffer of [%"APR_SIZE_T_FMT"] bytes Is Not Reused",frame_sizes[i]);
+				status = FALSE;
+			}
+		}
+		for(i=0; i<FRAME_SIZE_COUNT; i++) {
+			mpf_frame_pool_buffer_release(frame_pool,buffers[i]);
+		}
+		if(j == 0) {
+			block_count = mpf_frame_pool_buffer_count_get(frame_pool);
+		}
+	}
+
+	if(block_count != FRAME_SIZE_COUNT - 1 || mpf_frame_pool_buffer_count_get(frame_pool) != block_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Buffers [%"APR_SIZE_T_FMT"]",
+			mpf_frame_pool_buffer_count_get(frame_pool));
+		status = FALSE;
+	}
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"Frame Pool [%s]",
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+apt_test_suite_t* frame_pool_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"frame-pool",NULL,frame_pool_test_run);
+	return suite;
+}
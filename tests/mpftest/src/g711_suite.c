@@ -0,0 +1,176 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_g711_kernel.h"
+
+#define DEFAULT_FRAME_SAMPLES 160
+#define DEFAULT_ITERATIONS    100000
+/* the same samples are converted by every run */
+#define G711_SEED             1
+
+/** Conversion buffers shared by all kernels */
+typedef struct {
+	apr_int16_t *linear;
+	apr_byte_t  *code;
+	apr_int16_t *decoded;
+	apr_size_t   samples;
+} g711_bench_t;
+
+static apr_time_t g711_encode_run(g711_bench_t *bench, mpf_g711_encode_f encode, apr_size_t iterations)
+{
+	apr_size_t i;
+	apr_time_t start_time = apr_time_now();
+	for(i=0; i<iterations; i++) {
+		encode(bench->linear,bench->code,bench->samples);
+	}
+	return apr_time_now() - start_time;
+}
+
+static apr_time_t g711_decode_run(g711_bench_t *bench, mpf_g711_decode_f decode, apr_size_t iterations)
+{
+	apr_size_t i;
+	apr_time_t start_time = apr_time_now();
+	for(i=0; i<iterations; i++) {
+		decode(bench->code,bench->decoded,bench->samples);
+	}
+	return apr_time_now() - start_time;
+}
+
+/** Check kernel output is bit-exact to the scalar one over every input value */
+static apt_bool_t g711_kernel_verify(const mpf_g711_kernel_t *kernel, const mpf_g711_kernel_t *reference, apr_pool_t *pool)
+{
+	/* odd count exercises the scalar tail of vector kernels */
+	const apr_size_t count = 65536 + 7;
+	apr_int16_t *linear = apr_palloc(pool,sizeof(apr_int16_t) * count);
+	apr_int16_t *linear_out = apr_palloc(pool,sizeof(apr_int16_t) * count);
+	apr_int16_t *linear_ref = apr_palloc(pool,sizeof(apr_int16_t) * count);
+	apr_byte_t *code = apr_palloc(pool,count);
+	apr_byte_t *code_out = apr_palloc(pool,count);
+	apr_byte_t *code_ref = apr_palloc(pool,count);
+	apr_size_t i;
+
+	for(i=0; i<count; i++) {
+		linear[i] = (apr_int16_t)(i - 32768);
+		code[i] = (apr_byte_t)i;
+	}
+
+	kernel->ulaw_encode(linear,code_out,count);
+	reference->ulaw_encode(linear,code_ref,count);
+	if(memcmp(code_out,code_ref,count) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of [%s] u-law Encoder",kernel->name);
+		return FALSE;
+	}
+	kernel->alaw_encode(linear,code_out,count);
+	reference->alaw_encode(linear,code_ref,count);
+	if(memcmp(code_out,code_ref,count) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of [%s] A-law Encoder",kernel->name);
+		return FALSE;
+	}
+	kernel->ulaw_decode(code,linear_out,count);
+	reference->ulaw_decode(code,linear_ref,count);
+	if(memcmp(linear_out,linear_ref,sizeof(apr_int16_t) * count) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of [%s] u-law Decoder",kernel->name);
+		return FALSE;
+	}
+	kernel->alaw_decode(code,linear_out,count);
+	reference->alaw_decode(code,linear_ref,count);
+	if(memcmp(linear_out,linear_ref,sizeof(apr_int16_t) * count) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of [%s] A-law Decoder",kernel->name);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Add the time of conversion per frame to the results */
+static void g711_result_add(apt_test_suite_t *suite, const mpf_g711_kernel_t *kernel, const char *op, apr_time_t elapsed, apr_size_t iterations)
+{
+	apt_test_result_add(suite,apr_psprintf(suite->pool,"%s %s",kernel->name,op),"frame",(double)elapsed * 1000 / iterations,"ns");
+}
+
+static apt_bool_t g711_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	const mpf_g711_kernel_t *reference = mpf_g711_kernel_get(MPF_G711_KERNEL_SCALAR);
+	const mpf_g711_kernel_t *kernel;
+	apr_size_t iterations = DEFAULT_ITERATIONS;
+	apr_time_t elapsed[4];
+	apr_size_t i;
+	int type;
+	apt_bool_t status = TRUE;
+	g711_bench_t bench;
+
+	bench.samples = DEFAULT_FRAME_SAMPLES;
+	if(argc > 0) {
+		bench.samples = atol(argv[0]);
+	}
+	if(argc > 1) {
+		iterations = atol(argv[1]);
+	}
+	if(!bench.samples || !iterations) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Arguments: [samples per frame] [iterations]");
+		return FALSE;
+	}
+
+	bench.linear = apr_palloc(suite->pool,sizeof(apr_int16_t) * bench.samples);
+	bench.decoded = apr_palloc(suite->pool,sizeof(apr_int16_t) * bench.samples);
+	bench.code = apr_palloc(suite->pool,bench.samples);
+	srand(G711_SEED);
+	for(i=0; i<bench.samples; i++) {
+		/* speech-like spread over all segments */
+		bench.linear[i] = (apr_int16_t)((rand() & 0xFFFF) >> (rand() & 0x07));
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run %"APR_SIZE_T_FMT" Iterations of %"APR_SIZE_T_FMT" Samples",
+		iterations,bench.samples);
+	for(type=0; type<MPF_G711_KERNEL_COUNT; type++) {
+		kernel = mpf_g711_kernel_get((mpf_g711_kernel_e)type);
+		if(!kernel) {
+			continue;
+		}
+		if(g711_kernel_verify(kernel,reference,suite->pool) == FALSE) {
+			status = FALSE;
+			continue;
+		}
+		elapsed[0] = g711_encode_run(&bench,kernel->ulaw_encode,iterations);
+		elapsed[1] = g711_decode_run(&bench,kernel->ulaw_decode,iterations);
+		elapsed[2] = g711_encode_run(&bench,kernel->alaw_encode,iterations);
+		elapsed[3] = g711_decode_run(&bench,kernel->alaw_decode,iterations);
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,
+			"[%-6s] u-law enc %"APR_TIME_T_FMT" dec %"APR_TIME_T_FMT" A-law enc %"APR_TIME_T_FMT" dec %"APR_TIME_T_FMT" usec",
+			kernel->name,
+			elapsed[0],
+			elapsed[1],
+			elapsed[2],
+			elapsed[3]);
+		g711_result_add(suite,kernel,"u-law encode",elapsed[0],iterations);
+		g711_result_add(suite,kernel,"u-law decode",elapsed[1],iterations);
+		g711_result_add(suite,kernel,"A-law encode",elapsed[2],iterations);
+		g711_result_add(suite,kernel,"A-law decode",elapsed[3],iterations);
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Selected G.711 Kernel [%s]",mpf_g711_kernel_best_get()->name);
+	return status;
+}
+
+apt_test_suite_t* g711_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"g711",NULL,g711_test_run);
+	return suite;
+}
@@ -0,0 +1,494 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "apt_test_suite.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+#include "mpf_engine.h"
+#include "mpf_jitter_buffer.h"
+#include "mpf_named_event.h"
+#include "mpf_codec_manager.h"
+
+#define DEFAULT_DURATION      60 /* sec */
+#define DEFAULT_SEED          1
+
+#define SAMPLING_RATE         8000
+#define PTIME                 20 /* msec */
+#define FRAME_TIME            10 /* msec, CODEC_FRAME_TIME_BASE */
+#define FRAMES_PER_PACKET     (PTIME / FRAME_TIME)
+#define FRAME_SAMPLES         (SAMPLING_RATE * FRAME_TIME / 1000)
+/* PCMU */
+#define FRAME_SIZE            FRAME_SAMPLES
+#define BASE_DELAY            20000 /* usec, network delay with no jitter */
+
+#define DTMF_DURATION         100 /* msec */
+#define DTMF_END_COUNT        3   /* retransmissions of the end of event */
+
+/** Distribution of network delay variation */
+typedef enum {
+	JITTER_NONE,        /**< constant delay */
+	JITTER_UNIFORM,     /**< uniform within [0, jitter] */
+	JITTER_EXPONENTIAL, /**< exponential of mean jitter (long tail) */
+	JITTER_SPIKE        /**< delay spikes of jitter every few seconds, the packets held arrive at once */
+} jitter_distribution_e;
+
+/** Network impairment scenario */
+typedef struct {
+	const char           *name;
+	jitter_distribution_e distribution;
+	/** Scale of the delay variation (msec) */
+	apr_uint32_t          jitter;
+	/** Probability to enter a loss burst per packet (per mille) */
+	apr_uint32_t          loss_rate;
+	/** Mean length of a loss burst (packets) */
+	apr_uint32_t          loss_burst;
+	/** Probability of a packet to be delayed behind the next ones (per mille) */
+	apr_uint32_t          reorder_rate;
+	/** Clock skew of the sender (ppm, positive if the sender clock is faster) */
+	apr_int32_t           skew;
+	/** Interval of DTMF events (msec, 0 - none) */
+	apr_uint32_t          dtmf_interval;
+} jitter_scenario_t;
+
+/** Jitter buffer configuration under evaluation */
+typedef struct {
+	const char     *name;
+	mpf_jb_config_t config;
+} jitter_jb_profile_t;
+
+/** Synthetic RTP packet (audio or named event) */
+typedef struct {
+	/** Index of the packet in the order of sending */
+	apr_size_t              index;
+	/** Time the packet arrives at (usec) */
+	apr_time_t              arrival_time;
+	apr_uint32_t            ts;
+	apr_byte_t              marker;
+	/** Number of the first frame of audio packet */
+	apr_uint32_t            frame_number;
+	/** Whether the packet carries named event */
+	apt_bool_t              is_event;
+	mpf_named_event_frame_t event;
+} jitter_packet_t;
+
+/** Results of a run */
+typedef struct {
+	apr_size_t   packet_count;
+	apr_size_t   lost_count;
+	apr_size_t   late_count;
+	apr_size_t   early_count;
+	apr_size_t   frame_count;
+	apr_size_t   played_count;
+	apr_size_t   concealed_count;
+	apr_size_t   underrun_count;
+	apr_time_t   latency_sum;
+	apr_time_t   latency_max;
+	apr_size_t   dtmf_sent;
+	apr_size_t   dtmf_detected;
+	apr_uint32_t playout_delay;
+	/** Peak of the storage taken from the slab (bytes) */
+	apr_size_t   storage_peak;
+	/** Storage held by the jitter buffer after its destruction (bytes) */
+	apr_size_t   storage_left;
+} jitter_result_t;
+
+static const jitter_scenario_t jitter_scenarios[] = {
+	/* name           distribution        jitter loss  burst reorder skew  dtmf */
+	{"clean",         JITTER_NONE,        0,     0,    0,    0,      0,    0},
+	{"uniform-40",    JITTER_UNIFORM,     40,    0,    0,    0,      0,    0},
+	{"exponential-30",JITTER_EXPONENTIAL, 30,    0,    0,    0,      0,    0},
+	{"spikes-300",    JITTER_SPIKE,       300,   0,    0,    0,      0,    0},
+	{"loss-bursts",   JITTER_UNIFORM,     20,    20,   4,    0,      0,    0},
+	{"reorder",       JITTER_UNIFORM,     10,    0,    0,    50,     0,    0},
+	{"skew-fast",     JITTER_UNIFORM,     10,    0,    0,    0,      2000, 0},
+	{"skew-slow",     JITTER_UNIFORM,     10,    0,    0,    0,     -2000, 0},
+	{"dtmf",          JITTER_UNIFORM,     20,    10,   2,    0,      0,    1000}
+};
+
+#define JITTER_SCENARIO_COUNT (sizeof(jitter_scenarios) / sizeof(jitter_scenarios[0]))
+
+static const jitter_jb_profile_t jitter_jb_profiles[] = {
+	/* name            min  initial max  adaptive skew bypass */
+	{"fixed",         {0,   60,     200, 0,       0,   0}},
+	{"adaptive",      {20,  60,     400, 1,       0,   0}},
+	{"adaptive-skew", {20,  60,     400, 1,       1,   0}}
+};
+
+#define JITTER_JB_PROFILE_COUNT (sizeof(jitter_jb_profiles) / sizeof(jitter_jb_profiles[0]))
+
+/** Deterministic pseudo-random number within [0, 1) */
+static double jitter_random(apr_uint32_t *state)
+{
+	*state = *state * 1664525 + 1013904223;
+	return (double)(*state >> 8) / 16777216.0;
+}
+
+/** Delay variation of the packet sent at the specified time (usec) */
+static apr_time_t jitter_delay_get(const jitter_scenario_t *scenario, apr_time_t send_time, apr_uint32_t *state)
+{
+	double jitter = (double)scenario->jitter * 1000;
+	switch(scenario->distribution) {
+		case JITTER_UNIFORM:
+			return (apr_time_t)(jitter * jitter_random(state));
+		case JITTER_EXPONENTIAL:
+		{
+			double delay = -jitter * log(1.0 - jitter_random(state));
+			/* cut the tail off at 10 times the mean */
+			return (apr_time_t)(delay < 10 * jitter ? delay : 10 * jitter);
+		}
+		case JITTER_SPIKE:
+		{
+			/* every 5 sec the delay jumps up and decreases back as the held packets are flushed */
+			apr_time_t offset = send_time % (5 * APR_USEC_PER_SEC);
+			return offset < (apr_time_t)jitter ? (apr_time_t)jitter - offset : 0;
+		}
+		default:
+			break;
+	}
+	return 0;
+}
+
+static int jitter_packet_compare(const void *p1, const void *p2)
+{
+	const jitter_packet_t *packet1 = p1;
+	const jitter_packet_t *packet2 = p2;
+	if(packet1->arrival_time != packet2->arrival_time) {
+		return packet1->arrival_time < packet2->arrival_time ? -1 : 1;
+	}
+	return packet1->index < packet2->index ? -1 : 1;
+}
+
+/** Generate the stream as it arrives, lost packets are left out */
+static jitter_packet_t* jitter_stream_generate(
+						const jitter_scenario_t *scenario,
+						apr_size_t duration,
+						apr_uint32_t seed,
+						apr_time_t *frame_arrival_times,
+						jitter_result_t *result,
+						apr_size_t *count,
+						apr_pool_t *pool)
+{
+	apr_size_t audio_count = duration * 1000 / PTIME;
+	apr_size_t dtmf_packets = scenario->dtmf_interval ? DTMF_DURATION / PTIME + DTMF_END_COUNT - 1 : 0;
+	apr_size_t capacity = audio_count + (scenario->dtmf_interval ? (audio_count * PTIME / scenario->dtmf_interval + 1) * dtmf_packets : 0);
+	jitter_packet_t *packets = apr_palloc(pool,sizeof(jitter_packet_t) * capacity);
+	apr_uint32_t state = seed;
+	apt_bool_t loss_burst = FALSE;
+	apr_uint32_t dtmf_ts = 0;
+	apr_size_t dtmf_sent = 0;
+	apr_size_t i;
+	apr_size_t k;
+	apr_size_t packet_count = 0;
+	apr_size_t sent_count = 0;
+
+	for(i=0; i<audio_count; i++) {
+		/* the packet is sent, once its last frame is captured by the sender clock */
+		apr_time_t send_time = (apr_time_t)((double)((i + 1) * PTIME * 1000) * 1000000 / (1000000 + scenario->skew));
+		apr_uint32_t ts = (apr_uint32_t)(i * FRAMES_PER_PACKET * FRAME_SAMPLES);
+		apr_size_t event_count = 0;
+		jitter_packet_t *packet;
+
+		if(scenario->dtmf_interval && (i * PTIME) % scenario->dtmf_interval == 0 && i) {
+			/* a new event starts with this packet */
+			dtmf_ts = ts;
+			dtmf_sent = 0;
+			result->dtmf_sent++;
+		}
+		if(dtmf_sent < dtmf_packets && (i * PTIME) >= scenario->dtmf_interval) {
+			event_count = 1;
+		}
+
+		for(k=0; k<1 + event_count; k++) {
+			/* Gilbert model of loss bursts */
+			if(loss_burst == FALSE) {
+				if(scenario->loss_rate && jitter_random(&state) * 1000 < scenario->loss_rate) {
+					loss_burst = TRUE;
+				}
+			}
+			else if(jitter_random(&state) * scenario->loss_burst < 1.0) {
+				loss_burst = FALSE;
+			}
+
+			sent_count++;
+			if(k == 0) {
+				result->packet_count++;
+			}
+			if(loss_burst == TRUE) {
+				result->lost_count++;
+				continue;
+			}
+
+			packet = &packets[packet_count++];
+			packet->index = sent_count;
+			packet->arrival_time = send_time + BASE_DELAY + jitter_delay_get(scenario,send_time,&state);
+			if(scenario->reorder_rate && jitter_random(&state) * 1000 < scenario->reorder_rate) {
+				/* held behind the next packets */
+				packet->arrival_time += 2 * PTIME * 1000;
+			}
+			if(k == 0) {
+				packet->is_event = FALSE;
+				packet->ts = ts;
+				packet->marker = i == 0 ? 1 : 0;
+				packet->frame_number = (apr_uint32_t)(i * FRAMES_PER_PACKET);
+				frame_arrival_times[i * FRAMES_PER_PACKET] = packet->arrival_time;
+				frame_arrival_times[i * FRAMES_PER_PACKET + 1] = packet->arrival_time;
+			}
+			else {
+				apr_size_t update = dtmf_sent < DTMF_DURATION / PTIME ? dtmf_sent : DTMF_DURATION / PTIME - 1;
+				packet->is_event = TRUE;
+				packet->ts = dtmf_ts;
+				packet->marker = dtmf_sent == 0 ? 1 : 0;
+				packet->frame_number = 0;
+				memset(&packet->event,0,sizeof(packet->event));
+				packet->event.event_id = (apr_uint32_t)(result->dtmf_sent % 16);
+				packet->event.volume = 10;
+				packet->event.duration = (apr_uint32_t)((update + 1) * PTIME * SAMPLING_RATE / 1000);
+				packet->event.edge = dtmf_sent + 1 >= DTMF_DURATION / PTIME ? 1 : 0;
+			}
+		}
+		if(event_count) {
+			dtmf_sent++;
+		}
+	}
+
+	qsort(packets,packet_count,sizeof(jitter_packet_t),jitter_packet_compare);
+	*count = packet_count;
+	return packets;
+}
+
+/** Play the stream out of the jitter buffer */
+static apt_bool_t jitter_run(
+					const jitter_scenario_t *scenario,
+					const jitter_jb_profile_t *profile,
+					apr_size_t duration,
+					apr_uint32_t seed,
+					mpf_codec_t *codec,
+					mpf_codec_descriptor_t *descriptor,
+					jitter_result_t *result)
+{
+	apr_pool_t *pool = apt_pool_create();
+	mpf_jb_config_t jb_config = profile->config;
+	mpf_jb_slab_t *slab;
+	mpf_jitter_buffer_t *jb;
+	apr_size_t allocated;
+	apr_size_t used;
+	jitter_packet_t *packets;
+	apr_time_t *frame_arrival_times;
+	apr_size_t packet_count;
+	apr_size_t next = 0;
+	apr_size_t read_count;
+	apr_size_t n;
+	apr_byte_t payload[FRAMES_PER_PACKET * FRAME_SIZE];
+	apr_byte_t buffer[FRAME_SIZE];
+	mpf_frame_t frame;
+	apr_uint32_t last_played = 0;
+	apt_bool_t started = FALSE;
+
+	memset(result,0,sizeof(jitter_result_t));
+	result->frame_count = duration * 1000 / FRAME_TIME;
+	frame_arrival_times = apr_pcalloc(pool,sizeof(apr_time_t) * (result->frame_count + FRAMES_PER_PACKET));
+	packets = jitter_stream_generate(scenario,duration,seed,frame_arrival_times,result,&packet_count,pool);
+
+	slab = mpf_jb_slab_create(pool);
+	jb = mpf_jitter_buffer_create(&jb_config,descriptor,codec,slab,pool);
+	frame.codec_frame.buffer = buffer;
+	frame.codec_frame.size = FRAME_SIZE;
+
+	/* read for as long as the latest packets might be held */
+	read_count = result->frame_count + (jb_config.max_playout_delay + 2 * scenario->jitter + 1000) / FRAME_TIME;
+	for(n=0; n<read_count; n++) {
+		apr_time_t read_time = (apr_time_t)n * FRAME_TIME * 1000;
+		/* write everything arrived by the time of the read */
+		for(; next < packet_count && packets[next].arrival_time <= read_time; next++) {
+			jitter_packet_t *packet = &packets[next];
+			jb_result_t status;
+			if(packet->is_event == TRUE) {
+				status = mpf_jitter_buffer_event_write(jb,&packet->event,packet->ts,packet->marker);
+			}
+			else {
+				apr_size_t i;
+				memset(payload,0xFF,sizeof(payload));
+				for(i=0; i<FRAMES_PER_PACKET; i++) {
+					/* each frame is tagged by its number, counted from 1 */
+					apr_uint32_t number = packet->frame_number + (apr_uint32_t)i + 1;
+					memcpy(payload + i * FRAME_SIZE,&number,sizeof(number));
+				}
+				status = mpf_jitter_buffer_write(jb,payload,sizeof(payload),packet->ts,packet->marker);
+			}
+			if(status == JB_DISCARD_TOO_LATE) {
+				result->late_count++;
+			}
+			else if(status == JB_DISCARD_TOO_EARLY) {
+				result->early_count++;
+			}
+		}
+
+		frame.type = MEDIA_FRAME_TYPE_NONE;
+		frame.marker = MPF_MARKER_NONE;
+		frame.codec_frame.size = FRAME_SIZE;
+		mpf_jitter_buffer_read(jb,&frame);
+		mpf_jb_slab_stat_get(slab,&allocated,&used);
+		if(used > result->storage_peak) {
+			result->storage_peak = used;
+		}
+		if((frame.type & MEDIA_FRAME_TYPE_EVENT) == MEDIA_FRAME_TYPE_EVENT && frame.marker == MPF_MARKER_START_OF_EVENT) {
+			result->dtmf_detected++;
+		}
+		if((frame.type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO) {
+			apr_uint32_t number;
+			memcpy(&number,buffer,sizeof(number));
+			if(number > last_played && number <= result->frame_count) {
+				apr_time_t latency = read_time - frame_arrival_times[number - 1];
+				result->played_count++;
+				result->latency_sum += latency;
+				if(latency > result->latency_max) {
+					result->latency_max = latency;
+				}
+				last_played = number;
+			}
+			else {
+				/* the last frame repeated */
+				result->concealed_count++;
+			}
+			started = TRUE;
+		}
+		else if(started == TRUE && last_played < result->frame_count) {
+			result->underrun_count++;
+		}
+	}
+	result->playout_delay = mpf_jitter_buffer_playout_delay_get(jb);
+	mpf_jitter_buffer_destroy(jb);
+	mpf_jb_slab_stat_get(slab,&allocated,&result->storage_left);
+	apr_pool_destroy(pool);
+	return TRUE;
+}
+
+static void jitter_result_print(apt_test_suite_t *suite, const jitter_scenario_t *scenario, const jitter_jb_profile_t *profile, const jitter_result_t *result)
+{
+	apr_size_t discarded = result->late_count + result->early_count;
+	apr_size_t delivered = result->packet_count - result->lost_count;
+	const char *name = apr_psprintf(suite->pool,"%s %s",scenario->name,profile->name);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,
+		"[%s] %-13s latency %5.1f / %5.1f ms avg/max, discarded %4.1f%% (late %"APR_SIZE_T_FMT" early %"APR_SIZE_T_FMT"), "
+		"played %5.1f%%, underruns %"APR_SIZE_T_FMT", concealed %"APR_SIZE_T_FMT", delay %u ms, dtmf %"APR_SIZE_T_FMT"/%"APR_SIZE_T_FMT", "
+		"storage %"APR_SIZE_T_FMT"/%u bytes",
+		scenario->name,
+		profile->name,
+		result->played_count ? (double)result->latency_sum / result->played_count / 1000 : 0.0,
+		(double)result->latency_max / 1000,
+		delivered ? 100.0 * discarded / delivered : 0.0,
+		result->late_count,
+		result->early_count,
+		result->frame_count ? 100.0 * result->played_count / result->frame_count : 0.0,
+		result->underrun_count,
+		result->concealed_count,
+		result->playout_delay,
+		result->dtmf_detected,
+		result->dtmf_sent,
+		result->storage_peak,
+		profile->config.max_playout_delay / FRAME_TIME * FRAME_SIZE);
+
+	/* the quality of playout, the lower the better */
+	apt_test_result_add(suite,name,"latency avg",
+		result->played_count ? (double)result->latency_sum / result->played_count / 1000 : 0.0,"ms");
+	apt_test_result_add(suite,name,"latency max",(double)result->latency_max / 1000,"ms");
+	apt_test_result_add(suite,name,"discarded",delivered ? 100.0 * discarded / delivered : 0.0,"%");
+	apt_test_result_add(suite,name,"not played",
+		result->frame_count ? 100.0 - 100.0 * result->played_count / result->frame_count : 0.0,"%");
+	apt_test_result_add(suite,name,"underruns",(double)result->underrun_count,"frames");
+}
+
+static apt_bool_t jitter_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	const char *name = NULL;
+	apr_size_t duration = DEFAULT_DURATION;
+	apr_uint32_t seed = DEFAULT_SEED;
+	mpf_codec_manager_t *codec_manager;
+	mpf_codec_descriptor_t *descriptor;
+	mpf_codec_t *codec;
+	jitter_result_t result;
+	apt_bool_t status = TRUE;
+	apt_bool_t found = FALSE;
+	apr_size_t i;
+	apr_size_t j;
+
+	if(argc > 0 && strcasecmp(argv[0],"all") != 0) {
+		name = argv[0];
+	}
+	if(argc > 1) {
+		duration = atol(argv[1]);
+	}
+	if(argc > 2) {
+		seed = (apr_uint32_t)atol(argv[2]);
+	}
+	if(!duration) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Arguments: [scenario|all] [duration sec] [seed]");
+		return FALSE;
+	}
+
+	codec_manager = mpf_engine_codec_manager_create(suite->pool);
+	descriptor = mpf_codec_descriptor_create(suite->pool);
+	descriptor->payload_type = 0;
+	apt_string_set(&descriptor->name,"PCMU");
+	descriptor->sampling_rate = SAMPLING_RATE;
+	descriptor->channel_count = 1;
+	codec = codec_manager ? mpf_codec_manager_codec_get(codec_manager,descriptor,suite->pool) : NULL;
+	if(!codec) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Get Codec [PCMU]");
+		return FALSE;
+	}
+
+	for(i=0; i<JITTER_SCENARIO_COUNT; i++) {
+		const jitter_scenario_t *scenario = &jitter_scenarios[i];
+		if(name && strcasecmp(name,scenario->name) != 0) {
+			continue;
+		}
+		found = TRUE;
+		for(j=0; j<JITTER_JB_PROFILE_COUNT; j++) {
+			const jitter_jb_profile_t *profile = &jitter_jb_profiles[j];
+			jitter_run(scenario,profile,duration,seed,codec,descriptor,&result);
+			jitter_result_print(suite,scenario,profile,&result);
+
+			if(scenario->distribution == JITTER_NONE && !scenario->loss_rate && !scenario->skew &&
+				(result.late_count || result.early_count || result.played_count + FRAMES_PER_PACKET < result.frame_count)) {
+				/* nothing is to be lost with no impairment */
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Loss of Clean Stream [%s]",profile->name);
+				status = FALSE;
+			}
+			if(result.storage_left) {
+				/* every block is to be given back to the slab */
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Storage Left in Slab [%s] %"APR_SIZE_T_FMT" bytes",profile->name,result.storage_left);
+				status = FALSE;
+			}
+		}
+	}
+	if(found == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Such Scenario [%s]",name);
+		return FALSE;
+	}
+	return status;
+}
+
+apt_test_suite_t* jitter_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"jitter",NULL,jitter_test_run);
+	return suite;
+}
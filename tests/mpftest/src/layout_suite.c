@@ -0,0 +1,198 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include "apt_test_suite.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+#include "mpf_engine.h"
+#include "mpf_context.h"
+#include "mpf_termination.h"
+#include "mpf_stream.h"
+#include "mpf_codec_manager.h"
+
+#define DEFAULT_CONTEXT_COUNT 2000
+#define DEFAULT_TICK_COUNT    1000
+
+/** Benchmark session (context with source and sink terminations bridged together) */
+typedef struct {
+	apr_pool_t    *pool;
+	mpf_context_t *context;
+	apr_size_t     frame_count;
+} layout_session_t;
+
+static const mpf_termination_vtable_t dummy_termination_vtable = {
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+static apt_bool_t dummy_frame_read(mpf_audio_stream_t *stream, mpf_frame_t *frame)
+{
+	frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+	return TRUE;
+}
+
+static apt_bool_t dummy_frame_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame)
+{
+	layout_session_t *session = stream->obj;
+	session->frame_count++;
+	return TRUE;
+}
+
+static const mpf_audio_stream_vtable_t dummy_stream_vtable = {
+	NULL,
+	NULL,
+	NULL,
+	dummy_frame_read,
+	NULL,
+	NULL,
+	dummy_frame_write,
+	NULL
+};
+
+static mpf_codec_descriptor_t* pcmu_descriptor_create(apr_pool_t *pool)
+{
+	mpf_codec_descriptor_t *descriptor = mpf_codec_descriptor_create(pool);
+	descriptor->payload_type = 0;
+	descriptor->sampling_rate = 8000;
+	descriptor->channel_count = 1;
+	return descriptor;
+}
+
+static mpf_termination_t* dummy_termination_create(layout_session_t *session, mpf_stream_direction_e direction, const mpf_codec_manager_t *codec_manager)
+{
+	mpf_termination_t *termination;
+	mpf_audio_stream_t *stream = mpf_audio_stream_create(
+						session,
+						&dummy_stream_vtable,
+						mpf_stream_capabilities_create(direction,session->pool),
+						session->pool);
+	if(!stream) {
+		return NULL;
+	}
+	if(direction == STREAM_DIRECTION_RECEIVE) {
+		stream->rx_descriptor = pcmu_descriptor_create(session->pool);
+	}
+	else {
+		stream->tx_descriptor = pcmu_descriptor_create(session->pool);
+	}
+
+	termination = mpf_termination_base_create(NULL,session,&dummy_termination_vtable,stream,NULL,session->pool);
+	termination->codec_manager = codec_manager;
+	return termination;
+}
+
+static layout_session_t* layout_session_create(mpf_context_factory_t *factory, const mpf_codec_manager_t *codec_manager)
+{
+	mpf_termination_t *source;
+	mpf_termination_t *sink;
+	apr_pool_t *pool = apt_pool_create();
+	layout_session_t *session = apr_palloc(pool,sizeof(layout_session_t));
+	session->pool = pool;
+	session->frame_count = 0;
+	session->context = mpf_context_create(factory,NULL,session,2,pool);
+
+	source = dummy_termination_create(session,STREAM_DIRECTION_RECEIVE,codec_manager);
+	sink = dummy_termination_create(session,STREAM_DIRECTION_SEND,codec_manager);
+	if(!source || !sink) {
+		return NULL;
+	}
+	mpf_context_termination_add(session->context,source);
+	mpf_context_termination_add(session->context,sink);
+	mpf_context_association_add(session->context,source,sink);
+	mpf_context_topology_apply(session->context);
+	return session;
+}
+
+static apr_time_t layout_run(mpf_context_factory_t *factory, mpf_context_layout_e layout, apr_size_t tick_count)
+{
+	apr_size_t i;
+	apr_time_t start_time;
+	mpf_context_factory_layout_set(factory,layout);
+	/* warm up, the flat array is built on the first tick */
+	mpf_context_factory_process(factory);
+
+	start_time = apr_time_now();
+	for(i=0; i<tick_count; i++) {
+		mpf_context_factory_process(factory);
+	}
+	return apr_time_now() - start_time;
+}
+
+static apt_bool_t layout_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apr_size_t context_count = DEFAULT_CONTEXT_COUNT;
+	apr_size_t tick_count = DEFAULT_TICK_COUNT;
+	apr_size_t i;
+	apr_size_t frame_count = 0;
+	apr_time_t default_time;
+	apr_time_t flat_time;
+	mpf_codec_manager_t *codec_manager;
+	mpf_context_factory_t *factory;
+	layout_session_t **sessions;
+
+	if(argc > 0) {
+		context_count = atol(argv[0]);
+	}
+	if(argc > 1) {
+		tick_count = atol(argv[1]);
+	}
+	if(!context_count || !tick_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Arguments: [context count] [tick count]");
+		return FALSE;
+	}
+
+	codec_manager = mpf_engine_codec_manager_create(suite->pool);
+	factory = mpf_context_factory_create(suite->pool);
+	sessions = apr_palloc(suite->pool,sizeof(layout_session_t*) * context_count);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Create %"APR_SIZE_T_FMT" Media Contexts",context_count);
+	for(i=0; i<context_count; i++) {
+		sessions[i] = layout_session_create(factory,codec_manager);
+		if(!sessions[i]) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Media Context");
+			context_count = i;
+			break;
+		}
+	}
+
+	default_time = layout_run(factory,MPF_CONTEXT_LAYOUT_DEFAULT,tick_count);
+	flat_time = layout_run(factory,MPF_CONTEXT_LAYOUT_FLAT,tick_count);
+
+	for(i=0; i<context_count; i++) {
+		frame_count += sessions[i]->frame_count;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Processed %"APR_SIZE_T_FMT" Ticks of %"APR_SIZE_T_FMT" Contexts [%"APR_SIZE_T_FMT" frames]",
+		tick_count,context_count,frame_count);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Default Layout: %"APR_TIME_T_FMT" usec/tick",default_time / tick_count);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Flat Layout:    %"APR_TIME_T_FMT" usec/tick",flat_time / tick_count);
+
+	mpf_context_factory_destroy(factory);
+	for(i=0; i<context_count; i++) {
+		apr_pool_destroy(sessions[i]->pool);
+	}
+	return frame_count == context_count * (tick_count + 1) * 2 ? TRUE : FALSE;
+}
+
+apt_test_suite_t* layout_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"layout",NULL,layout_test_run);
+	return suite;
+}
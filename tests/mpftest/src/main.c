@@ -20,6 +20,18 @@
 #include "apt_log.h"
 
 apt_test_suite_t* mpf_suite_create(apr_pool_t *pool);
+apt_test_suite_t* layout_suite_create(apr_pool_t *pool);
+apt_test_suite_t* g711_suite_create(apr_pool_t *pool);
+apt_test_suite_t* encoder_suite_create(apr_pool_t *pool);
+apt_test_suite_t* buffer_suite_create(apr_pool_t *pool);
+apt_test_suite_t* frame_buffer_suite_create(apr_pool_t *pool);
+apt_test_suite_t* frame_pool_suite_create(apr_pool_t *pool);
+apt_test_suite_t* source_suite_create(apr_pool_t *pool);
+apt_test_suite_t* rtp_port_suite_create(apr_pool_t *pool);
+apt_test_suite_t* bench_suite_create(apr_pool_t *pool);
+apt_test_suite_t* jitter_suite_create(apr_pool_t *pool);
+apt_test_suite_t* encoded_source_suite_create(apr_pool_t *pool);
+apt_test_suite_t* dtmf_generator_suite_create(apr_pool_t *pool);
 
 int main(int argc, const char * const *argv)
 {
@@ -40,6 +52,42 @@ int main(int argc, const char * const *argv)
 	test_suite = mpf_suite_create(pool);
 	apt_test_framework_suite_add(test_framework,test_suite);
 
+	test_suite = layout_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = g711_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = encoder_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = buffer_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = frame_buffer_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = frame_pool_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = source_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = rtp_port_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = bench_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = jitter_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = encoded_source_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = dtmf_generator_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
 	/* run tests */
 	apt_test_framework_run(test_framework,argc,argv);
 
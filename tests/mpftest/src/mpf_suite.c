@@ -436,12 +436,13 @@ static mpf_audio_file_descriptor_t* mpf_file_reader_descriptor_create(const mpf_
 	mpf_audio_file_descriptor_t *descriptor = apr_palloc(session->pool,sizeof(mpf_audio_file_descriptor_t));
 	descriptor->mask = FILE_READER;
 	descriptor->read_handle = NULL;
+	descriptor->read_source = NULL;
 	descriptor->write_handle = NULL;
 	descriptor->codec_descriptor = mpf_codec_lpcm_descriptor_create(8000,1,session->pool);
 	if(file_path) {
 		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Open File [%s] for Reading",file_path);
-		descriptor->read_handle = fopen(file_path,"rb");
-		if(!descriptor->read_handle) {
+		descriptor->read_source = mpf_audio_file_source_open(file_path);
+		if(!descriptor->read_source) {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open File [%s]",file_path);
 		}
 	}
@@ -457,6 +458,7 @@ static mpf_audio_file_descriptor_t* mpf_file_writer_descriptor_create(const mpf_
 	descriptor->max_write_size = 500000; /* ~500Kb */
 	descriptor->write_handle = NULL;
 	descriptor->read_handle = NULL;
+	descriptor->read_source = NULL;
 	descriptor->codec_descriptor = mpf_codec_lpcm_descriptor_create(8000,1,session->pool);
 	if(file_path) {
 		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Open File [%s] for Writing",file_path);
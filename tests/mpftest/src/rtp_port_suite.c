@@ -0,0 +1,174 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <apr_time.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_rtp_port_allocator.h"
+#include "mpf_rtp_socket_pool.h"
+
+#define PORT_MIN 5000
+#define PORT_MAX 5010
+#define PORT_COUNT ((PORT_MAX - PORT_MIN) / 2)
+
+/* the range socket pool actually binds to */
+#define SOCKET_PORT_MIN  41000
+#define SOCKET_PORT_MAX  41020
+#define SOCKET_POOL_SIZE 2
+/* max time to wait for the refill thread (msec) */
+#define SOCKET_POOL_WAIT 2000
+
+static apt_bool_t rtp_port_allocator_test(apr_uint32_t quarantine, apr_pool_t *pool)
+{
+	apr_port_t ports[PORT_COUNT];
+	apr_port_t port;
+	apr_size_t i;
+	mpf_rtp_port_allocator_t *allocator = mpf_rtp_port_allocator_create(PORT_MIN,PORT_MAX,quarantine,pool);
+	if(!allocator) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create RTP Port Allocator");
+		return FALSE;
+	}
+
+	/* exhaust the range */
+	for(i=0; i<PORT_COUNT; i++) {
+		ports[i] = mpf_rtp_port_allocator_allocate(allocator);
+		if(ports[i] != PORT_MIN + 2 * i) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected RTP Port [%hu]",ports[i]);
+			return FALSE;
+		}
+	}
+	if(mpf_rtp_port_allocator_allocate(allocator) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"RTP Port Allocated from Exhausted Range");
+		return FALSE;
+	}
+
+	/* released ports are given out in the order of release */
+	mpf_rtp_port_allocator_release(allocator,ports[3]);
+	mpf_rtp_port_allocator_release(allocator,ports[1]);
+	if(mpf_rtp_port_allocator_release(allocator,ports[1]) == TRUE ||
+		mpf_rtp_port_allocator_release(allocator,PORT_MIN + 1) == TRUE ||
+		mpf_rtp_port_allocator_release(allocator,PORT_MAX) == TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid RTP Port Released");
+		return FALSE;
+	}
+	if(mpf_rtp_port_allocator_free_count_get(allocator) != 2) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Free RTP Ports");
+		return FALSE;
+	}
+	port = mpf_rtp_port_allocator_allocate(allocator);
+	if(port != ports[3]) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected RTP Port [%hu] Expected [%hu]",port,ports[3]);
+		return FALSE;
+	}
+
+	/* a port just released goes behind the ones released earlier */
+	mpf_rtp_port_allocator_release(allocator,port);
+	port = mpf_rtp_port_allocator_allocate(allocator);
+	if(port != ports[1]) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected RTP Port [%hu] Expected [%hu]",port,ports[1]);
+		return FALSE;
+	}
+
+	/* the only free port is reused, even if it is in quarantine */
+	port = mpf_rtp_port_allocator_allocate(allocator);
+	if(port != ports[3] || mpf_rtp_port_allocator_free_count_get(allocator) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected RTP Port [%hu] Expected [%hu]",port,ports[3]);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t rtp_socket_pool_test(apr_pool_t *parent)
+{
+	apt_str_t ip;
+	mpf_rtp_port_allocator_t *allocator;
+	mpf_rtp_socket_pool_t *socket_pool;
+	mpf_rtp_socket_pair_t *pair = NULL;
+	apr_port_t port;
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+	apr_pool_t *pool;
+
+	/* the refill thread is stopped, once the pool is destroyed */
+	apr_pool_create(&pool,parent);
+	apt_string_set(&ip,"127.0.0.1");
+	allocator = mpf_rtp_port_allocator_create(SOCKET_PORT_MIN,SOCKET_PORT_MAX,0,pool);
+	socket_pool = mpf_rtp_socket_pool_create(&ip,allocator,SOCKET_POOL_SIZE,pool);
+	if(!socket_pool) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create RTP Socket Pool");
+		apr_pool_destroy(pool);
+		return FALSE;
+	}
+
+	/* the first demand starts the refill thread */
+	for(i=0; i<SOCKET_POOL_WAIT / 10 && !pair; i++) {
+		pair = mpf_rtp_socket_pool_get(socket_pool);
+		if(!pair) {
+			apr_sleep(apr_time_from_msec(10));
+		}
+	}
+	if(!pair || !pair->rtp_socket || pair->port < SOCKET_PORT_MIN || pair->port >= SOCKET_PORT_MAX) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Pre-bound RTP Socket Pair");
+		apr_pool_destroy(pool);
+		return FALSE;
+	}
+
+	/* the port of the closed pair is released in background */
+	port = pair->port;
+	mpf_rtp_socket_pool_put(socket_pool,pair);
+	for(i=0; i<SOCKET_POOL_WAIT / 10; i++) {
+		/* only the ready pairs hold ports */
+		if(mpf_rtp_port_allocator_free_count_get(allocator) == (SOCKET_PORT_MAX - SOCKET_PORT_MIN) / 2 - SOCKET_POOL_SIZE) {
+			break;
+		}
+		apr_sleep(apr_time_from_msec(10));
+	}
+	if(i == SOCKET_POOL_WAIT / 10) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"RTP Port [%hu] Not Released by Socket Pool",port);
+		status = FALSE;
+	}
+	apr_pool_destroy(pool);
+	return status;
+}
+
+static apt_bool_t rtp_port_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_bool_t status = TRUE;
+	if(mpf_rtp_port_allocator_create(PORT_MIN,PORT_MIN+1,0,suite->pool) != NULL) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"RTP Port Allocator Created for Empty Range");
+		status = FALSE;
+	}
+	if(rtp_port_allocator_test(0,suite->pool) == FALSE) {
+		status = FALSE;
+	}
+	if(rtp_port_allocator_test(60000,suite->pool) == FALSE) {
+		status = FALSE;
+	}
+	if(rtp_socket_pool_test(suite->pool) == FALSE) {
+		status = FALSE;
+	}
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"RTP Port Allocator [%s]",
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+apt_test_suite_t* rtp_port_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"rtp-port",NULL,rtp_port_test_run);
+	return suite;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <string.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_audio_file_source.h"
+
+#define FRAME_SIZE  160
+/* the tail shorter than a frame is not served */
+#define DATA_SIZE   (FRAME_SIZE * 10 + FRAME_SIZE / 2)
+
+static apt_bool_t source_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apr_byte_t data[DATA_SIZE];
+	apr_byte_t own[FRAME_SIZE];
+	mpf_audio_file_source_t *source;
+	mpf_frame_t frame;
+	apr_size_t count = 0;
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+
+	for(i=0; i<DATA_SIZE; i++) {
+		data[i] = (apr_byte_t)i;
+	}
+	source = mpf_audio_file_source_create(data,DATA_SIZE);
+	if(!source) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Buffer Source");
+		return FALSE;
+	}
+
+	frame.codec_frame.size = FRAME_SIZE;
+	for(;;) {
+		/* the own buffer is given back on every read */
+		frame.type = MEDIA_FRAME_TYPE_NONE;
+		frame.codec_frame.buffer = own;
+		if(mpf_audio_file_source_frame_lend(source,&frame) == FALSE) {
+			break;
+		}
+		/* no copy, the frame is a slice of the buffer */
+		if(frame.codec_frame.buffer != data + count * FRAME_SIZE ||
+			(frame.type & MEDIA_FRAME_TYPE_AUDIO) == 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Slice [%"APR_SIZE_T_FMT"]",count);
+			status = FALSE;
+			break;
+		}
+		count++;
+	}
+	if(frame.codec_frame.buffer != own || frame.type != MEDIA_FRAME_TYPE_NONE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Frame Modified at the End of Source");
+		status = FALSE;
+	}
+	if(count != DATA_SIZE / FRAME_SIZE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Frames [%"APR_SIZE_T_FMT"]",count);
+		status = FALSE;
+	}
+	mpf_audio_file_source_close(source);
+
+	apt_log(APT_LOG_MARK,status == TRUE ? APT_PRIO_NOTICE : APT_PRIO_WARNING,"Lend %"APR_SIZE_T_FMT" Frames [%s]",
+		count,
+		status == TRUE ? "OK" : "Failed");
+	return status;
+}
+
+apt_test_suite_t* source_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"source",NULL,source_test_run);
+	return suite;
+}
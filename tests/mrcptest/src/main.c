@@ -20,6 +20,8 @@
 #include "apt_log.h"
 
 apt_test_suite_t* parse_gen_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* parse_bench_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* replay_bench_test_suite_create(apr_pool_t *pool);
 apt_test_suite_t* set_get_test_suite_create(apr_pool_t *pool);
 apt_test_suite_t* transparent_set_get_test_suite_create(apr_pool_t *pool);
 
@@ -45,6 +47,11 @@ int main(int argc, const char * const *argv)
 	apt_test_framework_suite_add(test_framework,test_suite);
 	test_suite = parse_gen_test_suite_create(pool);
 	apt_test_framework_suite_add(test_framework,test_suite);
+	test_suite = parse_bench_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = replay_bench_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
 
 	/* run tests */
 	apt_test_framework_run(test_framework,argc,argv);
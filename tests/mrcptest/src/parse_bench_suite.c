@@ -0,0 +1,252 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <apr_file_info.h>
+#include <apr_file_io.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "apt_text_scan.h"
+#include "mrcp_resource_loader.h"
+#include "mrcp_resource_factory.h"
+#include "mrcp_message.h"
+#include "mrcp_stream.h"
+
+#define DEFAULT_ITERATIONS 10000
+
+/** Messages (MRCPv2 test files) loaded in memory */
+typedef struct {
+	/** Concatenated content of the files */
+	char       *data;
+	/** Length of the content */
+	apr_size_t  length;
+	/** Working copy the parser runs on */
+	char       *stream_buffer;
+} parse_bench_t;
+
+/** Load all the files of the directory into a single buffer */
+static apt_bool_t parse_bench_load(parse_bench_t *bench, const char *dir_name, apr_pool_t *pool)
+{
+	apr_dir_t *dir;
+	apr_finfo_t finfo;
+	apr_size_t size = 0;
+
+	if(apr_dir_open(&dir,dir_name,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Cannot Open Directory [%s]",dir_name);
+		return FALSE;
+	}
+	bench->data = NULL;
+	bench->length = 0;
+	while(apr_dir_read(&finfo,APR_FINFO_DIRENT,dir) == APR_SUCCESS) {
+		apr_file_t *file;
+		char *file_path;
+		apr_finfo_t file_info;
+		apr_size_t length;
+		if(finfo.filetype != APR_REG || !finfo.name) {
+			continue;
+		}
+		apr_filepath_merge(&file_path,dir_name,finfo.name,APR_FILEPATH_NATIVE,pool);
+		if(apr_file_open(&file,file_path,APR_FOPEN_READ | APR_FOPEN_BINARY,APR_OS_DEFAULT,pool) != APR_SUCCESS) {
+			continue;
+		}
+		if(apr_file_info_get(&file_info,APR_FINFO_SIZE,file) == APR_SUCCESS && file_info.size > 0) {
+			length = (apr_size_t)file_info.size;
+			if(bench->length + length > size) {
+				char *data;
+				size = (bench->length + length) * 2;
+				data = apr_palloc(pool,size);
+				if(bench->length) {
+					memcpy(data,bench->data,bench->length);
+				}
+				bench->data = data;
+			}
+			if(apr_file_read_full(file,bench->data + bench->length,length,&length) == APR_SUCCESS) {
+				bench->length += length;
+			}
+		}
+		apr_file_close(file);
+	}
+	apr_dir_close(dir);
+
+	if(!bench->length) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Messages Loaded from [%s]",dir_name);
+		return FALSE;
+	}
+	bench->stream_buffer = apr_palloc(pool,bench->length + 1);
+	return TRUE;
+}
+
+/** Parse all the loaded messages, return the number of messages parsed */
+static apr_size_t parse_bench_pass(parse_bench_t *bench, mrcp_resource_factory_t *factory, apt_bool_t lazy, apr_pool_t *pool)
+{
+	apt_text_stream_t stream;
+	mrcp_parser_t *parser;
+	mrcp_message_t *message;
+	apt_message_status_e msg_status;
+	apr_size_t count = 0;
+
+	parser = mrcp_parser_create(factory,pool);
+	mrcp_parser_lazy_set(parser,lazy);
+
+	memcpy(bench->stream_buffer,bench->data,bench->length);
+	apt_text_stream_init(&stream,bench->stream_buffer,bench->length);
+	stream.text.length = bench->length;
+	bench->stream_buffer[bench->length] = '\0';
+	apt_text_stream_reset(&stream);
+	do {
+		msg_status = mrcp_parser_run(parser,&stream,&message);
+		if(msg_status == APT_MESSAGE_STATUS_COMPLETE) {
+			if(lazy == FALSE) {
+				/* decode header fields the same way the stack does on access */
+				mrcp_generic_header_get(message);
+				mrcp_resource_header_get(message);
+			}
+			count++;
+		}
+	}
+	while(apt_text_is_eos(&stream) == FALSE);
+	return count;
+}
+
+/** Check scanner output is identical to the scalar one, including every tail length */
+static apt_bool_t parse_bench_scanner_verify(const apt_text_scanner_t *scanner, const apt_text_scanner_t *reference)
+{
+	char data[256];
+	const char delimiters[] = {':', APT_TOKEN_CR, APT_TOKEN_LF};
+	apr_size_t offset;
+	apr_size_t length;
+	apr_size_t i;
+
+	for(i=0; i<sizeof(data); i++) {
+		/* sparse delimiters over printable chars and bytes with the high bit set */
+		data[i] = (rand() % 16) ? (char)(0x20 + rand() % 0xE0) : delimiters[rand() % 3];
+	}
+	for(offset=0; offset<32; offset++) {
+		for(length=0; offset + length <= sizeof(data); length++) {
+			const char *pos = data + offset;
+			const char *end = pos + length;
+			if(scanner->chr3_find(pos,end,':',APT_TOKEN_CR,APT_TOKEN_LF) !=
+				reference->chr3_find(pos,end,':',APT_TOKEN_CR,APT_TOKEN_LF) ||
+				scanner->chr3_find(pos,end,APT_TOKEN_CR,APT_TOKEN_LF,APT_TOKEN_LF) !=
+				reference->chr3_find(pos,end,APT_TOKEN_CR,APT_TOKEN_LF,APT_TOKEN_LF)) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of [%s] Scanner [offset %"APR_SIZE_T_FMT" length %"APR_SIZE_T_FMT"]",
+					scanner->name,offset,length);
+				return FALSE;
+			}
+		}
+	}
+	return TRUE;
+}
+
+static apt_bool_t parse_bench_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	const apt_text_scanner_t *reference = apt_text_scanner_get(APT_TEXT_SCANNER_SCALAR);
+	const apt_text_scanner_t *scanner;
+	mrcp_resource_factory_t *factory;
+	mrcp_resource_loader_t *resource_loader;
+	apr_size_t iterations = DEFAULT_ITERATIONS;
+	apr_size_t reference_count = 0;
+	apt_bool_t lazy = FALSE;
+	apt_bool_t status = TRUE;
+	apr_pool_t *pool;
+	parse_bench_t bench;
+	int type;
+
+	if(argc > 0) {
+		iterations = atol(argv[0]);
+	}
+	if(argc > 1 && strcasecmp(argv[1],"lazy") == 0) {
+		/* parse header field values on access only */
+		lazy = TRUE;
+	}
+	if(!iterations) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Arguments: [iterations] [lazy]");
+		return FALSE;
+	}
+
+	if(parse_bench_load(&bench,"v2",suite->pool) == FALSE) {
+		return FALSE;
+	}
+
+	resource_loader = mrcp_resource_loader_create(TRUE,suite->pool);
+	if(!resource_loader) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Resource Loader");
+		return FALSE;
+	}
+	factory = mrcp_resource_factory_get(resource_loader);
+	if(!factory) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Resource Factory");
+		return FALSE;
+	}
+	apr_pool_create(&pool,suite->pool);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run %"APR_SIZE_T_FMT" Iterations over %"APR_SIZE_T_FMT" bytes of MRCPv2 Messages",
+		iterations,bench.length);
+	for(type=0; type<APT_TEXT_SCANNER_COUNT; type++) {
+		apr_time_t start_time;
+		apr_time_t elapsed_time;
+		apr_size_t count = 0;
+		apr_size_t i;
+
+		scanner = apt_text_scanner_get((apt_text_scanner_e)type);
+		if(!scanner) {
+			continue;
+		}
+		if(parse_bench_scanner_verify(scanner,reference) == FALSE) {
+			status = FALSE;
+			continue;
+		}
+
+		apt_text_scanner_select(scanner);
+		start_time = apr_time_now();
+		for(i=0; i<iterations; i++) {
+			count = parse_bench_pass(&bench,factory,lazy,pool);
+			apr_pool_clear(pool);
+		}
+		elapsed_time = apr_time_now() - start_time;
+
+		if(!reference_count) {
+			reference_count = count;
+		}
+		else if(count != reference_count) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of [%s] Parsed Message Count %"APR_SIZE_T_FMT" != %"APR_SIZE_T_FMT,
+				scanner->name,count,reference_count);
+			status = FALSE;
+		}
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"[%-6s] %"APR_SIZE_T_FMT" messages per pass %"APR_TIME_T_FMT" usec %"APR_TIME_T_FMT" nsec/message",
+			scanner->name,
+			count,
+			elapsed_time,
+			count ? (elapsed_time * 1000) / (apr_time_t)(count * iterations) : 0);
+		apt_test_result_add(suite,apr_psprintf(pool,"%s%s",scanner->name,lazy == TRUE ? " lazy" : ""),"message",
+			count ? (double)elapsed_time * 1000 / (count * iterations) : 0.0,"ns");
+	}
+	/* restore the default */
+	apt_text_scanner_select(NULL);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Selected Text Scanner [%s]",apt_text_scanner_active_get()->name);
+
+	apr_pool_destroy(pool);
+	mrcp_resource_factory_destroy(factory);
+	return status;
+}
+
+apt_test_suite_t* parse_bench_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"parse-bench",NULL,parse_bench_test_run);
+	return suite;
+}
@@ -54,11 +54,47 @@ static apt_bool_t test_stream_generate(mrcp_generator_t *generator, mrcp_message
 	return TRUE;
 }
 
+/** Compare the message generated by start-line templates to the regular one */
+static apt_bool_t test_template_generate(mrcp_generator_t *generator, mrcp_message_t *message)
+{
+	char buffer[1000];
+	char template_buffer[1000];
+	apt_text_stream_t stream;
+	apt_text_stream_t template_stream;
+	int i;
+
+	apt_text_stream_init(&stream,buffer,sizeof(buffer)-1);
+	if(mrcp_message_generate(NULL,message,&stream) == FALSE) {
+		/* does not fit, nothing to compare to */
+		return TRUE;
+	}
+	stream.text.length = stream.pos - stream.text.buf;
+
+	/* the first run compiles the template, the second one uses it */
+	for(i=0; i<2; i++) {
+		apt_text_stream_init(&template_stream,template_buffer,sizeof(template_buffer)-1);
+		if(mrcp_generator_message_generate(generator,message,&template_stream) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Generate MRCP Message by Template");
+			return FALSE;
+		}
+		template_stream.text.length = template_stream.pos - template_stream.text.buf;
+		if(apt_string_compare(&stream.text,&template_stream.text) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of MRCP Message Generated by Template\n%.*s",
+				template_stream.text.length,template_stream.text.buf);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
 static apt_bool_t mrcp_message_handler(mrcp_generator_t *generator, mrcp_message_t *message, apt_message_status_e status)
 {
 	if(status == APT_MESSAGE_STATUS_COMPLETE) {
-		/* message is completely parsed */
+		/* message is completely parsed, decode lazily parsed header fields (if any) */
+		mrcp_generic_header_get(message);
+		mrcp_resource_header_get(message);
 		test_stream_generate(generator,message);
+		test_template_generate(generator,message);
 	}
 	return TRUE;
 }
@@ -87,7 +123,7 @@ static apt_bool_t resource_name_read(apr_file_t *file, mrcp_parser_t *parser)
 	return status;
 }
 
-static apt_bool_t test_file_process(apt_test_suite_t *suite, mrcp_resource_factory_t *factory, mrcp_version_e version, const char *file_path)
+static apt_bool_t test_file_process(apt_test_suite_t *suite, mrcp_resource_factory_t *factory, mrcp_version_e version, apt_bool_t lazy, const char *file_path)
 {
 	apr_file_t *file;
 	char buffer[500];
@@ -108,6 +144,7 @@ static apt_bool_t test_file_process(apt_test_suite_t *suite, mrcp_resource_facto
 
 	parser = mrcp_parser_create(factory,suite->pool);
 	generator = mrcp_generator_create(factory,suite->pool);
+	mrcp_parser_lazy_set(parser,lazy);
 
 	apt_string_reset(&resource_name);
 	if(version == MRCP_VERSION_1) {
@@ -148,7 +185,7 @@ static apt_bool_t test_file_process(apt_test_suite_t *suite, mrcp_resource_facto
 	return TRUE;
 }
 
-static apt_bool_t test_dir_process(apt_test_suite_t *suite, mrcp_resource_factory_t *factory, mrcp_version_e version)
+static apt_bool_t test_dir_process(apt_test_suite_t *suite, mrcp_resource_factory_t *factory, mrcp_version_e version, apt_bool_t lazy)
 {
 	apr_status_t rv;
 	apr_dir_t *dir;
@@ -170,7 +207,7 @@ static apt_bool_t test_dir_process(apt_test_suite_t *suite, mrcp_resource_factor
 				int ch;
 				char *file_path;
 				apr_filepath_merge(&file_path,dir_name,finfo.name,APR_FILEPATH_NATIVE,suite->pool);
-				test_file_process(suite,factory,version,file_path);
+				test_file_process(suite,factory,version,lazy,file_path);
 				printf("\nPress ENTER to continue\n");
 				do {ch = getchar(); } while ((ch != '\n') && (ch != EOF));
 			}
@@ -186,6 +223,12 @@ static apt_bool_t parse_gen_test_run(apt_test_suite_t *suite, int argc, const ch
 {
 	mrcp_resource_factory_t *factory;
 	mrcp_resource_loader_t *resource_loader;
+	apt_bool_t lazy = FALSE;
+	if(argc > 0 && strcasecmp(argv[0],"lazy") == 0) {
+		/* parse header field values on access only */
+		lazy = TRUE;
+	}
+
 	resource_loader = mrcp_resource_loader_create(TRUE,suite->pool);
 	if(!resource_loader) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Resource Loader");
@@ -198,8 +241,8 @@ static apt_bool_t parse_gen_test_run(apt_test_suite_t *suite, int argc, const ch
 		return FALSE;
 	}
 
-	test_dir_process(suite,factory,MRCP_VERSION_2);
-	test_dir_process(suite,factory,MRCP_VERSION_1);
+	test_dir_process(suite,factory,MRCP_VERSION_2,lazy);
+	test_dir_process(suite,factory,MRCP_VERSION_1,lazy);
 
 	mrcp_resource_factory_destroy(factory);
 	return TRUE;
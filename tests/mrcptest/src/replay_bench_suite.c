@@ -0,0 +1,342 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <apr_file_info.h>
+#include <apr_file_io.h>
+#include <apr_hash.h>
+#include <apr_strings.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mrcp_resource_loader.h"
+#include "mrcp_resource_factory.h"
+#include "mrcp_resource.h"
+#include "mrcp_message.h"
+#include "mrcp_stream.h"
+#include "mrcp_synth_state_machine.h"
+#include "mrcp_recog_state_machine.h"
+#include "mrcp_recorder_state_machine.h"
+#include "mrcp_verifier_state_machine.h"
+#include "mrcp_synth_resource.h"
+#include "mrcp_recog_resource.h"
+#include "mrcp_recorder_resource.h"
+#include "mrcp_verifier_resource.h"
+
+#define DEFAULT_ITERATIONS 10000
+
+/** Captured traffic loaded in memory */
+typedef struct {
+	/** Concatenated MRCPv2 messages */
+	char       *data;
+	/** Length of the content */
+	apr_size_t  length;
+	/** Working copy the parser runs on */
+	char       *stream_buffer;
+} replay_capture_t;
+
+/** Replay of a single pass over the capture */
+typedef struct {
+	/** Channels (state machines) by channel-identifier */
+	apr_hash_t         *channels;
+	/** Responses of the engine pending to be fed back to state machines */
+	apr_array_header_t *engine_responses;
+	/** Number of messages parsed */
+	apr_size_t          parsed;
+	/** Number of messages dispatched to the engine */
+	apr_size_t          to_engine;
+	/** Number of messages dispatched to the client */
+	apr_size_t          to_client;
+	/** Pool to allocate memory from */
+	apr_pool_t         *pool;
+} replay_pass_t;
+
+/** Load the capture file or all the files of the directory into a single buffer */
+static apt_bool_t replay_capture_load(replay_capture_t *capture, const char *path, apr_pool_t *pool)
+{
+	apr_dir_t *dir;
+	apr_finfo_t finfo;
+	apr_size_t size = 0;
+	apr_array_header_t *file_paths = apr_array_make(pool,8,sizeof(const char*));
+	int i;
+
+	if(apr_stat(&finfo,path,APR_FINFO_TYPE,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Cannot Open Capture [%s]",path);
+		return FALSE;
+	}
+	if(finfo.filetype == APR_DIR) {
+		if(apr_dir_open(&dir,path,pool) != APR_SUCCESS) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Cannot Open Directory [%s]",path);
+			return FALSE;
+		}
+		while(apr_dir_read(&finfo,APR_FINFO_DIRENT,dir) == APR_SUCCESS) {
+			char *file_path;
+			if(finfo.filetype != APR_REG || !finfo.name) {
+				continue;
+			}
+			apr_filepath_merge(&file_path,path,finfo.name,APR_FILEPATH_NATIVE,pool);
+			APR_ARRAY_PUSH(file_paths,const char*) = file_path;
+		}
+		apr_dir_close(dir);
+	}
+	else {
+		APR_ARRAY_PUSH(file_paths,const char*) = path;
+	}
+
+	capture->data = NULL;
+	capture->length = 0;
+	for(i=0; i<file_paths->nelts; i++) {
+		apr_file_t *file;
+		apr_finfo_t file_info;
+		apr_size_t length;
+		const char *file_path = APR_ARRAY_IDX(file_paths,i,const char*);
+		if(apr_file_open(&file,file_path,APR_FOPEN_READ | APR_FOPEN_BINARY,APR_OS_DEFAULT,pool) != APR_SUCCESS) {
+			continue;
+		}
+		if(apr_file_info_get(&file_info,APR_FINFO_SIZE,file) == APR_SUCCESS && file_info.size > 0) {
+			length = (apr_size_t)file_info.size;
+			if(capture->length + length > size) {
+				char *data;
+				size = (capture->length + length) * 2;
+				data = apr_palloc(pool,size);
+				if(capture->length) {
+					memcpy(data,capture->data,capture->length);
+				}
+				capture->data = data;
+			}
+			if(apr_file_read_full(file,capture->data + capture->length,length,&length) == APR_SUCCESS) {
+				capture->length += length;
+			}
+		}
+		apr_file_close(file);
+	}
+
+	if(!capture->length) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Messages Loaded from [%s]",path);
+		return FALSE;
+	}
+	capture->stream_buffer = apr_palloc(pool,capture->length + 1);
+	return TRUE;
+}
+
+/** Whether the request is completed by the engine asynchronously (by an event) */
+static apt_bool_t replay_request_is_lasting(const mrcp_message_t *request)
+{
+	switch(request->resource->id) {
+		case MRCP_SYNTHESIZER_RESOURCE:
+			return request->start_line.method_id == SYNTHESIZER_SPEAK;
+		case MRCP_RECOGNIZER_RESOURCE:
+			return request->start_line.method_id == RECOGNIZER_RECOGNIZE;
+		case MRCP_RECORDER_RESOURCE:
+			return request->start_line.method_id == RECORDER_RECORD;
+		case MRCP_VERIFIER_RESOURCE:
+			return (request->start_line.method_id == VERIFIER_VERIFY ||
+				request->start_line.method_id == VERIFIER_VERIFY_FROM_BUFFER);
+		default:
+			break;
+	}
+	return FALSE;
+}
+
+/** Dispatch message of state machine, the engine responds to requests at once */
+static apt_bool_t replay_on_dispatch(mrcp_state_machine_t *state_machine, mrcp_message_t *message)
+{
+	replay_pass_t *pass = state_machine->obj;
+	if(message->start_line.message_type == MRCP_MESSAGE_TYPE_REQUEST) {
+		mrcp_message_t *response = mrcp_response_create(message,message->pool);
+		if(replay_request_is_lasting(message) == TRUE) {
+			response->start_line.request_state = MRCP_REQUEST_STATE_INPROGRESS;
+		}
+		/* fed back once the update is over, as the engine responds from another context */
+		APR_ARRAY_PUSH(pass->engine_responses,mrcp_message_t*) = response;
+		pass->to_engine++;
+	}
+	else {
+		pass->to_client++;
+	}
+	return TRUE;
+}
+
+static apt_bool_t replay_on_deactivate(mrcp_state_machine_t *state_machine)
+{
+	return TRUE;
+}
+
+/** Get the state machine of the channel of the message, create it on the first message */
+static mrcp_state_machine_t* replay_state_machine_get(replay_pass_t *pass, const mrcp_message_t *message)
+{
+	mrcp_state_machine_t *state_machine;
+	const char *channel_id = apr_pstrcat(pass->pool,
+		message->channel_id.session_id.buf,"@",message->channel_id.resource_name.buf,NULL);
+	state_machine = apr_hash_get(pass->channels,channel_id,APR_HASH_KEY_STRING);
+	if(state_machine) {
+		return state_machine;
+	}
+
+	switch(message->resource->id) {
+		case MRCP_SYNTHESIZER_RESOURCE:
+			state_machine = mrcp_synth_state_machine_create(pass,MRCP_VERSION_2,pass->pool);
+			break;
+		case MRCP_RECOGNIZER_RESOURCE:
+			state_machine = mrcp_recog_state_machine_create(pass,MRCP_VERSION_2,pass->pool);
+			break;
+		case MRCP_RECORDER_RESOURCE:
+			state_machine = mrcp_recorder_state_machine_create(pass,MRCP_VERSION_2,pass->pool);
+			break;
+		case MRCP_VERIFIER_RESOURCE:
+			state_machine = mrcp_verifier_state_machine_create(pass,MRCP_VERSION_2,pass->pool);
+			break;
+		default:
+			return NULL;
+	}
+	state_machine->on_dispatch = replay_on_dispatch;
+	state_machine->on_deactivate = replay_on_deactivate;
+	apr_hash_set(pass->channels,channel_id,APR_HASH_KEY_STRING,state_machine);
+	return state_machine;
+}
+
+/** Feed the message to the state machine of its channel, as the server session does */
+static void replay_message_process(replay_pass_t *pass, mrcp_message_t *message)
+{
+	mrcp_state_machine_t *state_machine;
+	if(!message->resource) {
+		return;
+	}
+	if(message->start_line.message_type == MRCP_MESSAGE_TYPE_RESPONSE) {
+		/* responses are generated by the engine of the replay */
+		return;
+	}
+	state_machine = replay_state_machine_get(pass,message);
+	if(!state_machine) {
+		return;
+	}
+
+	mrcp_state_machine_update(state_machine,message);
+	while(pass->engine_responses->nelts) {
+		mrcp_message_t *response = *(mrcp_message_t**)apr_array_pop(pass->engine_responses);
+		mrcp_state_machine_update(state_machine,response);
+	}
+}
+
+/** Replay all the captured messages */
+static void replay_pass_run(replay_pass_t *pass, replay_capture_t *capture, mrcp_resource_factory_t *factory, apr_pool_t *pool)
+{
+	apt_text_stream_t stream;
+	mrcp_parser_t *parser;
+	mrcp_message_t *message;
+	apt_message_status_e msg_status;
+
+	pass->channels = apr_hash_make(pool);
+	pass->engine_responses = apr_array_make(pool,2,sizeof(mrcp_message_t*));
+	pass->parsed = 0;
+	pass->to_engine = 0;
+	pass->to_client = 0;
+	pass->pool = pool;
+
+	parser = mrcp_parser_create(factory,pool);
+	memcpy(capture->stream_buffer,capture->data,capture->length);
+	apt_text_stream_init(&stream,capture->stream_buffer,capture->length);
+	stream.text.length = capture->length;
+	capture->stream_buffer[capture->length] = '\0';
+	apt_text_stream_reset(&stream);
+	do {
+		msg_status = mrcp_parser_run(parser,&stream,&message);
+		if(msg_status == APT_MESSAGE_STATUS_COMPLETE) {
+			pass->parsed++;
+			replay_message_process(pass,message);
+		}
+		else if(msg_status == APT_MESSAGE_STATUS_INVALID) {
+			break;
+		}
+	}
+	while(apt_text_is_eos(&stream) == FALSE);
+}
+
+static apt_bool_t replay_bench_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	mrcp_resource_factory_t *factory;
+	mrcp_resource_loader_t *resource_loader;
+	apr_size_t iterations = DEFAULT_ITERATIONS;
+	const char *capture_path = "v2";
+	replay_capture_t capture;
+	replay_pass_t pass;
+	apr_time_t start_time;
+	apr_time_t elapsed_time;
+	apr_pool_t *pool;
+	apr_size_t i;
+
+	if(argc > 0) {
+		iterations = atol(argv[0]);
+	}
+	if(argc > 1) {
+		capture_path = argv[1];
+	}
+	if(!iterations) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Arguments: [iterations] [capture file or dir]");
+		return FALSE;
+	}
+
+	if(replay_capture_load(&capture,capture_path,suite->pool) == FALSE) {
+		return FALSE;
+	}
+
+	resource_loader = mrcp_resource_loader_create(TRUE,suite->pool);
+	if(!resource_loader) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Resource Loader");
+		return FALSE;
+	}
+	factory = mrcp_resource_factory_get(resource_loader);
+	if(!factory) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Resource Factory");
+		return FALSE;
+	}
+	apr_pool_create(&pool,suite->pool);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Replay %"APR_SIZE_T_FMT" Iterations over %"APR_SIZE_T_FMT" bytes of Captured MRCPv2 Traffic",
+		iterations,capture.length);
+	start_time = apr_time_now();
+	for(i=0; i<iterations; i++) {
+		replay_pass_run(&pass,&capture,factory,pool);
+#if APR_POOL_DEBUG
+		if(i == 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"%"APR_SIZE_T_FMT" bytes allocated per message",
+				pass.parsed ? apr_pool_num_bytes(pool,1) / pass.parsed : 0);
+		}
+#endif
+		apr_pool_clear(pool);
+	}
+	elapsed_time = apr_time_now() - start_time;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"%"APR_SIZE_T_FMT" messages per pass (%"APR_SIZE_T_FMT" to engine %"APR_SIZE_T_FMT" to client) %"APR_TIME_T_FMT" usec %"APR_TIME_T_FMT" messages/sec",
+		pass.parsed,
+		pass.to_engine,
+		pass.to_client,
+		elapsed_time,
+		elapsed_time ? (apr_time_t)(pass.parsed * iterations) * APR_USEC_PER_SEC / elapsed_time : 0);
+	apt_test_result_add(suite,"replay","throughput",
+		elapsed_time ? (double)(pass.parsed * iterations) * APR_USEC_PER_SEC / elapsed_time : 0.0,"msg/s");
+
+	apr_pool_destroy(pool);
+	mrcp_resource_factory_destroy(factory);
+	return pass.parsed ? TRUE : FALSE;
+}
+
+apt_test_suite_t* replay_bench_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"replay-bench",NULL,replay_bench_test_run);
+	return suite;
+}
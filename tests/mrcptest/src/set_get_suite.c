@@ -296,6 +296,75 @@ static apt_bool_t get_params_test_run(apt_test_suite_t *suite, mrcp_resource_fac
 	return TRUE;
 }
 
+/* Test SPEAK request inheriting the defaults of SET-PARAMS */
+static apt_bool_t inherit_test_run(apt_test_suite_t *suite, mrcp_resource_factory_t *factory)
+{
+	mrcp_message_t *defaults;
+	mrcp_message_t *update;
+	mrcp_message_t *message;
+	mrcp_message_header_t *properties;
+	mrcp_generic_header_t *generic_header;
+	mrcp_synth_header_t *synth_header;
+	apt_header_field_t *header_field;
+	const apt_header_field_t *default_header_field;
+	mrcp_resource_t *resource = mrcp_resource_get(factory,MRCP_SYNTHESIZER_RESOURCE);
+	if(!resource) {
+		return FALSE;
+	}
+
+	/* session defaults: Content-Type and Voice-Age */
+	defaults = speak_request_create(factory,suite->pool);
+	if(!defaults) {
+		return FALSE;
+	}
+	properties = mrcp_message_header_create(
+		mrcp_generic_header_vtable_get(MRCP_VERSION_2),
+		mrcp_synth_header_vtable_get(MRCP_VERSION_2),
+		suite->pool);
+	mrcp_header_fields_set(properties,&defaults->header,suite->pool);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Test Inherited SPEAK Request");
+	message = mrcp_request_create(resource,MRCP_VERSION_2,SYNTHESIZER_SPEAK,suite->pool);
+	synth_header = mrcp_resource_header_prepare(message);
+	if(!synth_header) {
+		return FALSE;
+	}
+	/* override Voice-Age */
+	synth_header->voice_param.age = SAMPLE_VOICE_AGE + 1;
+	mrcp_resource_header_property_add(message,SYNTHESIZER_HEADER_VOICE_AGE);
+	mrcp_header_fields_inherit(&message->header,properties,message->pool);
+
+	synth_header = mrcp_resource_header_get(message);
+	generic_header = mrcp_generic_header_get(message);
+	header_field = apt_header_section_field_get(&message->header.header_section,GENERIC_HEADER_CONTENT_TYPE);
+	default_header_field = apt_header_section_field_get(&properties->header_section,GENERIC_HEADER_CONTENT_TYPE);
+	if(!synth_header || synth_header->voice_param.age != SAMPLE_VOICE_AGE + 1 ||
+		!generic_header || !header_field || !default_header_field ||
+		header_field->value.buf != default_header_field->value.buf ||
+		apt_string_compare(&generic_header->content_type,&default_header_field->value) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Test Inherited Header");
+		return FALSE;
+	}
+
+	/* updated defaults leave the inherited value intact */
+	update = mrcp_request_create(resource,MRCP_VERSION_2,SYNTHESIZER_SET_PARAMS,suite->pool);
+	generic_header = mrcp_generic_header_prepare(update);
+	if(!generic_header) {
+		return FALSE;
+	}
+	apt_string_assign(&generic_header->content_type,"text/plain",update->pool);
+	mrcp_generic_header_property_add(update,GENERIC_HEADER_CONTENT_TYPE);
+	mrcp_header_fields_set(properties,&update->header,suite->pool);
+
+	generic_header = mrcp_generic_header_get(message);
+	if(strncasecmp(generic_header->content_type.buf,SAMPLE_CONTENT_TYPE,generic_header->content_type.length) != 0 ||
+		strncasecmp(header_field->value.buf,SAMPLE_CONTENT_TYPE,header_field->value.length) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Inherited Header Is Overwritten");
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static apt_bool_t set_get_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
 {
 	mrcp_resource_factory_t *factory;
@@ -314,6 +383,7 @@ static apt_bool_t set_get_test_run(apt_test_suite_t *suite, int argc, const char
 
 	speak_test_run(suite,factory);
 	get_params_test_run(suite,factory);
+	inherit_test_run(suite,factory);
 	
 	mrcp_resource_factory_destroy(factory);
 	return TRUE;
@@ -0,0 +1,229 @@
+/*
+ * Copyright 2008-2014 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <apr_file_info.h>
+#include <apr_file_io.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "rtsp_stream.h"
+
+#define DEFAULT_ITERATIONS 10000
+#define GENERATE_BUFFER_SIZE 4096
+
+/** Messages (RTSP test files) loaded in memory */
+typedef struct {
+	/** Concatenated content of the files */
+	char       *data;
+	/** Length of the content */
+	apr_size_t  length;
+	/** Working copy the parser runs on */
+	char       *stream_buffer;
+	/** Buffer messages are generated to */
+	char        generate_buffer[GENERATE_BUFFER_SIZE];
+} parse_bench_t;
+
+/** Result of a pass over the loaded messages */
+typedef struct {
+	/** Number of messages parsed */
+	apr_size_t parsed_count;
+	/** Number of messages, the CSeq header field of which is resolved */
+	apr_size_t resolved_count;
+	/** Number of bytes generated */
+	apr_size_t generated_size;
+} parse_bench_result_t;
+
+/** Load all the files of the directory into a single buffer */
+static apt_bool_t parse_bench_load(parse_bench_t *bench, const char *dir_name, apr_pool_t *pool)
+{
+	apr_dir_t *dir;
+	apr_finfo_t finfo;
+	apr_size_t size = 0;
+
+	if(apr_dir_open(&dir,dir_name,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Cannot Open Directory [%s]",dir_name);
+		return FALSE;
+	}
+	bench->data = NULL;
+	bench->length = 0;
+	while(apr_dir_read(&finfo,APR_FINFO_DIRENT,dir) == APR_SUCCESS) {
+		apr_file_t *file;
+		char *file_path;
+		apr_finfo_t file_info;
+		apr_size_t length;
+		if(finfo.filetype != APR_REG || !finfo.name) {
+			continue;
+		}
+		apr_filepath_merge(&file_path,dir_name,finfo.name,APR_FILEPATH_NATIVE,pool);
+		if(apr_file_open(&file,file_path,APR_FOPEN_READ | APR_FOPEN_BINARY,APR_OS_DEFAULT,pool) != APR_SUCCESS) {
+			continue;
+		}
+		if(apr_file_info_get(&file_info,APR_FINFO_SIZE,file) == APR_SUCCESS && file_info.size > 0) {
+			length = (apr_size_t)file_info.size;
+			if(bench->length + length > size) {
+				char *data;
+				size = (bench->length + length) * 2;
+				data = apr_palloc(pool,size);
+				if(bench->length) {
+					memcpy(data,bench->data,bench->length);
+				}
+				bench->data = data;
+			}
+			if(apr_file_read_full(file,bench->data + bench->length,length,&length) == APR_SUCCESS) {
+				bench->length += length;
+			}
+		}
+		apr_file_close(file);
+	}
+	apr_dir_close(dir);
+
+	if(!bench->length) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Messages Loaded from [%s]",dir_name);
+		return FALSE;
+	}
+	bench->stream_buffer = apr_palloc(pool,bench->length + 1);
+	return TRUE;
+}
+
+/** Generate message, return the number of bytes generated */
+static apr_size_t parse_bench_generate(parse_bench_t *bench, rtsp_generator_t *generator, rtsp_message_t *message)
+{
+	apt_text_stream_t stream;
+	apt_message_status_e status;
+	apr_size_t size = 0;
+	do {
+		apt_text_stream_init(&stream,bench->generate_buffer,sizeof(bench->generate_buffer)-1);
+		status = rtsp_generator_run(generator,message,&stream);
+		size += stream.pos - stream.text.buf;
+	}
+	while(status == APT_MESSAGE_STATUS_INCOMPLETE);
+	return status == APT_MESSAGE_STATUS_COMPLETE ? size : 0;
+}
+
+/** Parse all the loaded messages and optionally generate them back */
+static void parse_bench_pass(parse_bench_t *bench, apt_bool_t generate, parse_bench_result_t *result, apr_pool_t *pool)
+{
+	apt_text_stream_t stream;
+	rtsp_parser_t *parser;
+	rtsp_generator_t *generator;
+	rtsp_message_t *message;
+	apt_message_status_e msg_status;
+
+	parser = rtsp_parser_create(pool);
+	generator = rtsp_generator_create(pool);
+
+	memcpy(bench->stream_buffer,bench->data,bench->length);
+	apt_text_stream_init(&stream,bench->stream_buffer,bench->length);
+	stream.text.length = bench->length;
+	bench->stream_buffer[bench->length] = '\0';
+	apt_text_stream_reset(&stream);
+	do {
+		msg_status = rtsp_parser_run(parser,&stream,&message);
+		if(msg_status == APT_MESSAGE_STATUS_COMPLETE) {
+			result->parsed_count++;
+			if(rtsp_header_property_check(&message->header,RTSP_HEADER_FIELD_CSEQ) == TRUE) {
+				result->resolved_count++;
+			}
+			if(generate == TRUE) {
+				result->generated_size += parse_bench_generate(bench,generator,message);
+			}
+		}
+	}
+	while(apt_text_is_eos(&stream) == FALSE);
+}
+
+static apt_bool_t parse_bench_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apr_size_t iterations = DEFAULT_ITERATIONS;
+	const char *dir_name = "msg";
+	apt_bool_t status = TRUE;
+	apr_pool_t *pool;
+	parse_bench_t *bench;
+	parse_bench_result_t result;
+	apr_time_t parse_time = 0;
+	apr_time_t start_time;
+	apr_size_t count;
+	apr_size_t i;
+	int pass;
+
+	if(argc > 0) {
+		iterations = atol(argv[0]);
+	}
+	if(argc > 1) {
+		dir_name = argv[1];
+	}
+	if(!iterations) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Arguments: [iterations] [dir]");
+		return FALSE;
+	}
+
+	bench = apr_palloc(suite->pool,sizeof(parse_bench_t));
+	if(parse_bench_load(bench,dir_name,suite->pool) == FALSE) {
+		return FALSE;
+	}
+	apr_pool_create(&pool,suite->pool);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run %"APR_SIZE_T_FMT" Iterations over %"APR_SIZE_T_FMT" bytes of RTSP Messages",
+		iterations,bench->length);
+	/* parse only first, then parse and generate; the difference is the cost of generation */
+	for(pass=0; pass<2; pass++) {
+		apr_time_t elapsed_time;
+		memset(&result,0,sizeof(result));
+		start_time = apr_time_now();
+		for(i=0; i<iterations; i++) {
+			parse_bench_pass(bench,pass ? TRUE : FALSE,&result,pool);
+			apr_pool_clear(pool);
+		}
+		elapsed_time = apr_time_now() - start_time;
+
+		count = result.parsed_count / iterations;
+		if(!count || result.resolved_count != result.parsed_count) {
+			/* every test message carries CSeq, which must be resolved by the header lookup */
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Mismatch of Resolved CSeq %"APR_SIZE_T_FMT" != %"APR_SIZE_T_FMT" Parsed Messages",
+				result.resolved_count,result.parsed_count);
+			status = FALSE;
+			break;
+		}
+		if(!pass) {
+			parse_time = elapsed_time;
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"[parse] %"APR_SIZE_T_FMT" messages per pass %"APR_TIME_T_FMT" usec %"APR_TIME_T_FMT" nsec/message",
+				count,
+				elapsed_time,
+				(elapsed_time * 1000) / (apr_time_t)result.parsed_count);
+			apt_test_result_add(suite,"parse","message",(double)elapsed_time * 1000 / result.parsed_count,"ns");
+		}
+		else {
+			elapsed_time = elapsed_time > parse_time ? elapsed_time - parse_time : 0;
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"[generate] %"APR_SIZE_T_FMT" messages per pass %"APR_TIME_T_FMT" usec %"APR_TIME_T_FMT" nsec/message [%"APR_SIZE_T_FMT" bytes/message]",
+				count,
+				elapsed_time,
+				(elapsed_time * 1000) / (apr_time_t)result.parsed_count,
+				result.generated_size / result.parsed_count);
+			apt_test_result_add(suite,"generate","message",(double)elapsed_time * 1000 / result.parsed_count,"ns");
+		}
+	}
+
+	apr_pool_destroy(pool);
+	return status;
+}
+
+apt_test_suite_t* parse_bench_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"parse-bench",NULL,parse_bench_test_run);
+	return suite;
+}
@@ -18,6 +18,7 @@
 
 #include <stdio.h>
 #include <ctype.h>
+#include <string.h>
 #include "apt_pool.h"
 #include "apt_string_table.h"
 #include "apt_text_stream.h"
@@ -54,6 +55,61 @@ static apt_bool_t string_table_key_generate(apt_str_table_item_t table[], apr_si
 	return TRUE;
 }
 
+#define HASH_MAX_SLOTS   1024
+#define HASH_MAX_SEEDS   1000000
+
+static apt_bool_t string_table_hash_try(const apt_str_table_item_t table[], apr_size_t count, 
+										apr_uint32_t seed, apr_size_t mask, apr_byte_t slots[])
+{
+	size_t i;
+	apr_size_t slot;
+	memset(slots,0,mask+1);
+	for(i=0; i<count; i++) {
+		slot = apt_string_table_hash(seed,&table[i].value) & mask;
+		if(slots[slot]) {
+			/* collision */
+			return FALSE;
+		}
+		slots[slot] = (apr_byte_t)(i + 1);
+	}
+	return TRUE;
+}
+
+static apt_bool_t string_table_hash_generate(const apt_str_table_item_t table[], apr_size_t count, 
+											 apt_str_table_hash_t *hash, apr_byte_t slots[])
+{
+	apr_size_t size = 2;
+	apr_uint32_t seed;
+	/* start with the load factor of no more than 1/2 and double the slots until a seed is found */
+	while(size < count * 2) {
+		size <<= 1;
+	}
+	for(; size <= HASH_MAX_SLOTS; size <<= 1) {
+		for(seed=1; seed<=HASH_MAX_SEEDS; seed++) {
+			if(string_table_hash_try(table,count,seed,size-1,slots) == TRUE) {
+				hash->seed = seed;
+				hash->mask = size - 1;
+				hash->slots = slots;
+				return TRUE;
+			}
+		}
+	}
+	return FALSE;
+}
+
+static apt_bool_t string_table_hash_write(const apt_str_table_hash_t *hash, FILE *file)
+{
+	size_t i;
+	fprintf(file,"\r\nstatic const apr_byte_t string_table_hash_slots[%"APR_SIZE_T_FMT"] = {",hash->mask+1);
+	for(i=0; i<=hash->mask; i++) {
+		fprintf(file,"%s%d%s",(i % 16) ? "" : "\r\n\t",hash->slots[i],(i < hash->mask) ? "," : "");
+	}
+	fprintf(file,"\r\n};\r\n");
+	fprintf(file,"\r\nstatic const apt_str_table_hash_t string_table_hash = {%u,%"APR_SIZE_T_FMT",string_table_hash_slots};\r\n",
+		hash->seed,hash->mask);
+	return TRUE;
+}
+
 #define TEST_BUFFER_SIZE 2048
 static char parse_buffer[TEST_BUFFER_SIZE];
 
@@ -99,6 +155,8 @@ int main(int argc, char *argv[])
 {
 	apr_pool_t *pool = NULL;
 	apt_str_table_item_t table[100];
+	apt_str_table_hash_t hash;
+	apr_byte_t hash_slots[HASH_MAX_SLOTS];
 	size_t count;
 	FILE *file_in, *file_out;
 
@@ -134,6 +192,14 @@ int main(int argc, char *argv[])
 	/* dump string table to the file */
 	string_table_write(table,count,file_out);
 
+	/* generate and dump perfect hash of the string table */
+	if(string_table_hash_generate(table,count,&hash,hash_slots) == TRUE) {
+		string_table_hash_write(&hash,file_out);
+	}
+	else {
+		printf("cannot generate hash of the string table\n");
+	}
+
 	fclose(file_in);
 	if(file_out != stdout) {
 		fclose(file_out);